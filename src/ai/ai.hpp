@@ -24,5 +24,6 @@
 namespace ai {}
 
 #include "behavior-tree.hpp"
+#include "compiled-behavior-tree.hpp"
 
 #endif // ANTKEEPER_AI_HPP
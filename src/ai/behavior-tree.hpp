@@ -46,6 +46,9 @@ struct node
 {
 	/// Data type on which nodes operate.
 	typedef T context_type;
+	
+	/// Destroys a node. Children are not destroyed.
+	virtual ~node() = default;
 
 	/**
 	 * Executes a node's functionality and returns its status.
@@ -63,20 +66,23 @@ using leaf_node = node<T>;
 template <class T>
 struct decorator_node: node<T>
 {
-	node* child;
+	typedef typename node<T>::context_type context_type;
+	node<T>* child;
 };
 
 /// A node that can have one or more children.
 template <class T>
 struct composite_node: node<T>
 {
-	std::list<node*> children;
+	typedef typename node<T>::context_type context_type;
+	std::list<node<T>*> children;
 };
 
 /// Executes a function on a context and returns the status.
 template <class T>
 struct action: leaf_node<T>
 {
+	typedef typename leaf_node<T>::context_type context_type;
 	virtual status execute(context_type& context) const final;
 	typedef std::function<status(context_type&)> function_type;
 	function_type function;
@@ -86,8 +92,9 @@ struct action: leaf_node<T>
 template <class T>
 struct condition: leaf_node<T>
 {
+	typedef typename leaf_node<T>::context_type context_type;
 	virtual status execute(context_type& context) const final;
-	typedef std::function<status(const context_type&)> predicate_type;
+	typedef std::function<bool(const context_type&)> predicate_type;
 	predicate_type predicate;
 };
 
@@ -95,6 +102,7 @@ struct condition: leaf_node<T>
 template <class T>
 struct inverter: decorator_node<T>
 {
+	typedef typename decorator_node<T>::context_type context_type;
 	virtual status execute(context_type& context) const final;
 };
 
@@ -102,6 +110,7 @@ struct inverter: decorator_node<T>
 template <class T>
 struct repeater: decorator_node<T>
 {
+	typedef typename decorator_node<T>::context_type context_type;
 	virtual status execute(context_type& context) const final;
 	int n;
 };
@@ -110,6 +119,7 @@ struct repeater: decorator_node<T>
 template <class T>
 struct succeeder: decorator_node<T>
 {
+	typedef typename decorator_node<T>::context_type context_type;
 	virtual status execute(context_type& context) const final;
 };
 
@@ -117,6 +127,7 @@ struct succeeder: decorator_node<T>
 template <class T>
 struct sequence: composite_node<T>
 {
+	typedef typename composite_node<T>::context_type context_type;
 	virtual status execute(context_type& context) const final;
 };
 
@@ -124,6 +135,7 @@ struct sequence: composite_node<T>
 template <class T>
 struct selector: composite_node<T>
 {
+	typedef typename composite_node<T>::context_type context_type;
 	virtual status execute(context_type& context) const final;
 };
 
@@ -142,17 +154,17 @@ status condition<T>::execute(context_type& context) const
 template <class T>
 status inverter<T>::execute(context_type& context) const
 {
-	status child_status = child->execute(context);
+	status child_status = this->child->execute(context);
 	return (child_status == status::success) ? status::failure : (child_status == status::failure) ? status::success : child_status;
 }
 
 template <class T>
 status repeater<T>::execute(context_type& context) const
 {
-	status child_status;
+	status child_status = status::success;
 	for (int i = 0; i < n; ++i)
 	{
-		child_status = child->execute(context);
+		child_status = this->child->execute(context);
 		if (child_status == status::failure)
 			break;
 	}
@@ -162,14 +174,14 @@ status repeater<T>::execute(context_type& context) const
 template <class T>
 status succeeder<T>::execute(context_type& context) const
 {
-	child->execute(context);
+	this->child->execute(context);
 	return status::success;
 }
 
 template <class T>
 status sequence<T>::execute(context_type& context) const
 {
-	for (const node* child: children)
+	for (const node<T>* child: this->children)
 	{
 		status child_status = child->execute(context);
 		if (child_status != status::success)
@@ -181,7 +193,7 @@ status sequence<T>::execute(context_type& context) const
 template <class T>
 status selector<T>::execute(context_type& context) const
 {
-	for (const node* child: children)
+	for (const node<T>* child: this->children)
 	{
 		status child_status = child->execute(context);
 		if (child_status != status::failure)
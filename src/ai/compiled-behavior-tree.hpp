@@ -0,0 +1,281 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef ANTKEEPER_AI_COMPILED_BEHAVIOR_TREE_HPP
+#define ANTKEEPER_AI_COMPILED_BEHAVIOR_TREE_HPP
+
+#include "ai/behavior-tree.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+namespace ai {
+namespace bt {
+
+/**
+ * Behavior tree flattened into a contiguous array of instructions, which is executed without virtual calls or allocations.
+ *
+ * Instructions are stored in pre-order, so the subtree of the instruction at index `i` occupies the range `[i, end)`, its first child is at `i + 1`, and each following child begins at the end of the previous child.
+ *
+ * When a leaf returns `status::running`, its index is recorded in the caller's running state. On the next execution, sequences and selectors on the path to that leaf skip the children which precede it, resuming from the running node.
+ *
+ * @tparam T Data type on which nodes operate.
+ */
+template <class T>
+class compiled_tree
+{
+public:
+	/// Data type on which nodes operate.
+	typedef T context_type;
+	
+	/// Running state value which indicates no node is running.
+	static constexpr std::uint32_t npos = static_cast<std::uint32_t>(-1);
+	
+	/**
+	 * Compiles a behavior tree.
+	 *
+	 * @param root Root node of the behavior tree. The tree is not referenced after compilation.
+	 *
+	 * @exception std::invalid_argument The tree contains a node of unknown type, or a decorator without a child.
+	 */
+	explicit compiled_tree(const node<T>& root);
+	
+	/**
+	 * Executes the tree on a context and returns the status of the root node.
+	 *
+	 * @param context Context data on which the nodes will operate.
+	 * @param running Running state of the context, which should be initialized to `npos`. Updated with the index of the node left running, or `npos`.
+	 */
+	status execute(context_type& context, std::uint32_t& running) const;
+	
+	/// Returns the number of instructions in the compiled tree.
+	std::size_t size() const;
+	
+private:
+	enum class opcode: std::uint8_t
+	{
+		action,
+		condition,
+		inverter,
+		repeater,
+		succeeder,
+		sequence,
+		selector
+	};
+	
+	struct instruction
+	{
+		opcode op;
+		
+		/// Index past the last instruction of the subtree.
+		std::uint32_t end;
+		
+		/// Function index of actions and conditions, or repeat count of repeaters.
+		std::uint32_t operand;
+	};
+	
+	/// Appends the instructions of a subtree.
+	void compile(const node<T>& node);
+	
+	/**
+	 * Executes a subtree.
+	 *
+	 * @param index Index of the root instruction of the subtree.
+	 * @param context Context data.
+	 * @param resume Index of the node left running by the previous execution, or `npos`.
+	 * @param running Set to the index of the node left running.
+	 */
+	status run(std::uint32_t index, context_type& context, std::uint32_t resume, std::uint32_t& running) const;
+	
+	/// Returns the index of the first child of a composite instruction from which execution should begin.
+	std::uint32_t first_child(std::uint32_t index, std::uint32_t resume) const;
+	
+	std::vector<instruction> instructions;
+	std::vector<typename action<T>::function_type> actions;
+	std::vector<typename condition<T>::predicate_type> predicates;
+};
+
+template <class T>
+compiled_tree<T>::compiled_tree(const node<T>& root)
+{
+	compile(root);
+}
+
+template <class T>
+status compiled_tree<T>::execute(context_type& context, std::uint32_t& running) const
+{
+	const std::uint32_t resume = (running < instructions.size()) ? running : npos;
+	running = npos;
+	return run(0, context, resume, running);
+}
+
+template <class T>
+inline std::size_t compiled_tree<T>::size() const
+{
+	return instructions.size();
+}
+
+template <class T>
+void compiled_tree<T>::compile(const node<T>& node)
+{
+	const std::size_t index = instructions.size();
+	instructions.push_back({opcode::action, 0, 0});
+	
+	if (auto leaf = dynamic_cast<const action<T>*>(&node))
+	{
+		instructions[index].operand = static_cast<std::uint32_t>(actions.size());
+		actions.push_back(leaf->function);
+	}
+	else if (auto leaf = dynamic_cast<const condition<T>*>(&node))
+	{
+		instructions[index].op = opcode::condition;
+		instructions[index].operand = static_cast<std::uint32_t>(predicates.size());
+		predicates.push_back(leaf->predicate);
+	}
+	else if (auto decorator = dynamic_cast<const decorator_node<T>*>(&node))
+	{
+		if (!decorator->child)
+			throw std::invalid_argument("compiled_tree::compile(): Decorator node has no child.");
+		
+		if (dynamic_cast<const inverter<T>*>(&node))
+			instructions[index].op = opcode::inverter;
+		else if (auto repeat = dynamic_cast<const repeater<T>*>(&node))
+		{
+			instructions[index].op = opcode::repeater;
+			instructions[index].operand = static_cast<std::uint32_t>(std::max(repeat->n, 0));
+		}
+		else if (dynamic_cast<const succeeder<T>*>(&node))
+			instructions[index].op = opcode::succeeder;
+		else
+			throw std::invalid_argument("compiled_tree::compile(): Unknown decorator node type.");
+		
+		compile(*decorator->child);
+	}
+	else if (auto composite = dynamic_cast<const composite_node<T>*>(&node))
+	{
+		if (dynamic_cast<const sequence<T>*>(&node))
+			instructions[index].op = opcode::sequence;
+		else if (dynamic_cast<const selector<T>*>(&node))
+			instructions[index].op = opcode::selector;
+		else
+			throw std::invalid_argument("compiled_tree::compile(): Unknown composite node type.");
+		
+		for (const bt::node<T>* child: composite->children)
+			compile(*child);
+	}
+	else
+	{
+		throw std::invalid_argument("compiled_tree::compile(): Unknown node type.");
+	}
+	
+	instructions[index].end = static_cast<std::uint32_t>(instructions.size());
+}
+
+template <class T>
+status compiled_tree<T>::run(std::uint32_t index, context_type& context, std::uint32_t resume, std::uint32_t& running) const
+{
+	const instruction& current = instructions[index];
+	
+	switch (current.op)
+	{
+		case opcode::action:
+		{
+			const status action_status = actions[current.operand](context);
+			if (action_status == status::running)
+				running = index;
+			return action_status;
+		}
+		
+		case opcode::condition:
+			return (predicates[current.operand](context)) ? status::success : status::failure;
+		
+		case opcode::inverter:
+		{
+			const status child_status = run(index + 1, context, resume, running);
+			return (child_status == status::success) ? status::failure : (child_status == status::failure) ? status::success : child_status;
+		}
+		
+		case opcode::repeater:
+		{
+			status child_status = status::success;
+			for (std::uint32_t i = 0; i < current.operand; ++i)
+			{
+				child_status = run(index + 1, context, resume, running);
+				if (child_status == status::failure)
+					break;
+				resume = npos;
+			}
+			return child_status;
+		}
+		
+		case opcode::succeeder:
+			run(index + 1, context, resume, running);
+			return status::success;
+		
+		case opcode::sequence:
+		{
+			for (std::uint32_t child = first_child(index, resume); child < current.end; child = instructions[child].end)
+			{
+				const status child_status = run(child, context, resume, running);
+				if (child_status != status::success)
+					return child_status;
+				resume = npos;
+			}
+			return status::success;
+		}
+		
+		case opcode::selector:
+		{
+			for (std::uint32_t child = first_child(index, resume); child < current.end; child = instructions[child].end)
+			{
+				const status child_status = run(child, context, resume, running);
+				if (child_status != status::failure)
+					return child_status;
+				resume = npos;
+			}
+			return status::failure;
+		}
+	}
+	
+	return status::failure;
+}
+
+template <class T>
+std::uint32_t compiled_tree<T>::first_child(std::uint32_t index, std::uint32_t resume) const
+{
+	std::uint32_t child = index + 1;
+	
+	// Skip the children which precede the subtree containing the running node
+	if (resume > index && resume < instructions[index].end)
+	{
+		while (resume >= instructions[child].end)
+			child = instructions[child].end;
+	}
+	
+	return child;
+}
+
+} // namespace bt
+} // namespace ai
+
+#endif // ANTKEEPER_AI_COMPILED_BEHAVIOR_TREE_HPP
+
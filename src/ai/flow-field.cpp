@@ -0,0 +1,114 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "flow-field.hpp"
+#include <algorithm>
+#include <limits>
+
+namespace ai {
+
+flow_field::flow_field(const float3& goal):
+	goal(goal),
+	goal_node(navmesh::invalid_index),
+	built(false)
+{}
+
+void flow_field::build(const navmesh& navmesh)
+{
+	const std::size_t node_capacity = navmesh.get_node_capacity();
+	next_nodes.assign(node_capacity, navmesh::invalid_index);
+	costs.assign(node_capacity, std::numeric_limits<float>::infinity());
+	reached_clusters.assign(navmesh.get_cluster_count(), false);
+	built = true;
+	
+	goal_node = navmesh.find_node(goal);
+	if (goal_node == navmesh::invalid_index)
+		return;
+	
+	auto greater = [](const std::pair<float, std::uint32_t>& a, const std::pair<float, std::uint32_t>& b)
+	{
+		return a.first > b.first;
+	};
+	
+	// Sweep outward from the goal, pointing each node at the node from which it was reached
+	open.clear();
+	costs[goal_node] = 0.0f;
+	next_nodes[goal_node] = goal_node;
+	open.emplace_back(0.0f, goal_node);
+	while (!open.empty())
+	{
+		std::pop_heap(open.begin(), open.end(), greater);
+		const auto [current_cost, current] = open.back();
+		open.pop_back();
+		
+		// Skip nodes which have since been reached more cheaply
+		if (current_cost > costs[current])
+			continue;
+		reached_clusters[navmesh.get_cluster(current)] = true;
+		
+		const float3& current_position = navmesh.get_centroid(current);
+		for (std::uint32_t next: navmesh.get_neighbors(current))
+		{
+			if (next == navmesh::invalid_index)
+				continue;
+			
+			const float cost = current_cost + math::length(navmesh.get_centroid(next) - current_position);
+			if (cost < costs[next])
+			{
+				costs[next] = cost;
+				next_nodes[next] = current;
+				open.emplace_back(cost, next);
+				std::push_heap(open.begin(), open.end(), greater);
+			}
+		}
+	}
+}
+
+bool flow_field::is_stale(const navmesh& navmesh) const
+{
+	if (!built)
+		return true;
+	
+	// Fields whose goals were off the mesh may be reached by any new nodes
+	if (goal_node == navmesh::invalid_index)
+		return !navmesh.get_modified_clusters().empty();
+	
+	// Nodes added beside a reached cluster may have connected new regions to its nodes
+	auto reached = [&](std::uint32_t cluster)
+	{
+		return cluster < reached_clusters.size() && reached_clusters[cluster];
+	};
+	for (std::uint32_t cluster: navmesh.get_modified_clusters())
+	{
+		if (reached(cluster))
+			return true;
+		for (std::uint32_t neighbor: navmesh.get_cluster_neighbors(cluster))
+			if (reached(neighbor))
+				return true;
+	}
+	
+	return false;
+}
+
+float flow_field::get_cost(std::uint32_t node) const
+{
+	return (node < costs.size()) ? costs[node] : std::numeric_limits<float>::infinity();
+}
+
+} // namespace ai
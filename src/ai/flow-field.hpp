@@ -0,0 +1,110 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ANTKEEPER_AI_FLOW_FIELD_HPP
+#define ANTKEEPER_AI_FLOW_FIELD_HPP
+
+#include "ai/navmesh.hpp"
+#include "utility/fundamental-types.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace ai {
+
+/**
+ * Field of directions toward a shared goal over a navigation mesh, by which any number of agents may head to the goal without planning their own paths.
+ *
+ * The field is built by a single Dijkstra sweep outward from the goal node, which records for every reachable node the next node along its cheapest route to the goal. Agents which know their current node then look up their next node in constant time. The clusters reached by the sweep are recorded, so the field is only rebuilt when the navigation mesh is modified in or beside them.
+ */
+class flow_field
+{
+public:
+	/**
+	 * Creates a flow field toward a goal. The field is empty until built.
+	 *
+	 * @param goal Position toward which the field flows.
+	 */
+	explicit flow_field(const float3& goal);
+	
+	/**
+	 * Sweeps the navigation mesh outward from the node nearest the goal. Safe to call concurrently for different fields once the mesh has been updated.
+	 *
+	 * @param navmesh Navigation mesh over which the field is built.
+	 */
+	void build(const navmesh& navmesh);
+	
+	/**
+	 * Returns `true` if the field must be rebuilt following the most recent update of a navigation mesh, because it has never been built, because its goal was off the mesh and the mesh has been modified, or because nodes were added or removed in or beside a cluster it reached.
+	 *
+	 * @param navmesh Navigation mesh over which the field was built.
+	 */
+	bool is_stale(const navmesh& navmesh) const;
+	
+	/// Returns the position toward which the field flows.
+	const float3& get_goal() const;
+	
+	/// Returns the node nearest the goal, or `navmesh::invalid_index` if there is none.
+	std::uint32_t get_goal_node() const;
+	
+	/**
+	 * Returns the next node along the cheapest route from a node to the goal node.
+	 *
+	 * @param node Index of a node of the navigation mesh.
+	 * @return Index of the next node, the goal node itself if @p node is the goal node, or `navmesh::invalid_index` if the goal can't be reached from @p node.
+	 */
+	std::uint32_t get_next_node(std::uint32_t node) const;
+	
+	/// Returns the cost of the cheapest route from a node to the goal node, or infinity if the goal can't be reached.
+	float get_cost(std::uint32_t node) const;
+	
+private:
+	float3 goal;
+	std::uint32_t goal_node;
+	bool built;
+	
+	/// Next node toward the goal and cost to the goal of each node, indexed by node.
+	std::vector<std::uint32_t> next_nodes;
+	std::vector<float> costs;
+	
+	/// Flags of the clusters reached by the sweep, indexed by cluster.
+	std::vector<bool> reached_clusters;
+	
+	std::vector<std::pair<float, std::uint32_t>> open;
+};
+
+inline const float3& flow_field::get_goal() const
+{
+	return goal;
+}
+
+inline std::uint32_t flow_field::get_goal_node() const
+{
+	return goal_node;
+}
+
+inline std::uint32_t flow_field::get_next_node(std::uint32_t node) const
+{
+	return (node < next_nodes.size()) ? next_nodes[node] : navmesh::invalid_index;
+}
+
+} // namespace ai
+
+#endif // ANTKEEPER_AI_FLOW_FIELD_HPP
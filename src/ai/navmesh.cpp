@@ -0,0 +1,541 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ai/navmesh.hpp"
+#include "math/math.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace ai {
+
+namespace {
+
+/// Returns a hash of a position, quantized such that positions computed separately for bordering sections match.
+std::uint64_t hash_position(const float3& position)
+{
+	std::uint64_t hash = 0;
+	for (int i = 0; i < 3; ++i)
+	{
+		const std::uint64_t coordinate = static_cast<std::uint64_t>(static_cast<std::int64_t>(std::round(position[i] * 1024.0f)));
+		hash = (hash ^ coordinate) * 0x100000001b3ull;
+		hash ^= hash >> 29;
+	}
+	
+	return hash;
+}
+
+/// Returns a key of an edge by the positions of its endpoints, independent of their order.
+std::uint64_t get_edge_key(const float3& a, const float3& b)
+{
+	const std::uint64_t key = hash_position(a) ^ hash_position(b);
+	return (key) ? key : 1;
+}
+
+} // namespace
+
+navmesh::navmesh(float cluster_size):
+	cluster_size(cluster_size),
+	cell_scale(1.0f / cluster_size),
+	node_count(0),
+	modified(false)
+{}
+
+std::uint32_t navmesh::add_mesh(const geom::mesh& mesh)
+{
+	const std::uint32_t section = allocate_section();
+	
+	// Add a node for each triangular face
+	const std::vector<geom::mesh::face*>& faces = mesh.get_faces();
+	std::vector<std::uint32_t> face_nodes(faces.size(), invalid_index);
+	for (const geom::mesh::face* face: faces)
+	{
+		const geom::mesh::edge* edge = face->edge;
+		if (edge->next->next->next != edge)
+			continue;
+		
+		face_nodes[face->index] = add_node(section, edge->vertex->position, edge->next->vertex->position, edge->previous->vertex->position);
+	}
+	
+	// Connect nodes across the half-edges they share, and open boundary edges to other sections
+	for (const geom::mesh::face* face: faces)
+	{
+		const std::uint32_t node_index = face_nodes[face->index];
+		if (node_index == invalid_index)
+			continue;
+		
+		const geom::mesh::edge* edge = face->edge;
+		for (int i = 0; i < 3; ++i, edge = edge->next)
+		{
+			const geom::mesh::edge* symmetric = edge->symmetric;
+			if (symmetric && symmetric->face && face_nodes[symmetric->face->index] != invalid_index)
+				nodes[node_index].neighbors[i] = face_nodes[symmetric->face->index];
+			else
+				open_edge(node_index, i, edge->vertex->position, edge->next->vertex->position);
+		}
+	}
+	
+	return section;
+}
+
+std::uint32_t navmesh::add_triangles(const float* positions, std::size_t stride, const std::uint32_t* indices, std::size_t triangle_count)
+{
+	const std::uint32_t section = allocate_section();
+	auto get_position = [positions, stride](std::uint32_t index)
+	{
+		const float* position = positions + static_cast<std::size_t>(index) * stride;
+		return float3{position[0], position[1], position[2]};
+	};
+	
+	// Connect triangles across the edges they share, keyed by the indices of their vertices
+	std::unordered_map<std::uint64_t, std::pair<std::uint32_t, int>> edge_map;
+	edge_map.reserve(triangle_count * 3);
+	std::vector<std::uint32_t> triangle_nodes(triangle_count);
+	for (std::size_t i = 0; i < triangle_count; ++i)
+	{
+		const std::uint32_t* triangle = indices + i * 3;
+		const std::uint32_t node_index = add_node(section, get_position(triangle[0]), get_position(triangle[1]), get_position(triangle[2]));
+		triangle_nodes[i] = node_index;
+		
+		for (int j = 0; j < 3; ++j)
+		{
+			const std::uint32_t a = triangle[j];
+			const std::uint32_t b = triangle[(j + 1) % 3];
+			const std::uint64_t key = (static_cast<std::uint64_t>(std::min(a, b)) << 32) | std::max(a, b);
+			
+			if (auto it = edge_map.find(key); it != edge_map.end())
+			{
+				nodes[node_index].neighbors[j] = it->second.first;
+				nodes[it->second.first].neighbors[it->second.second] = node_index;
+				edge_map.erase(it);
+			}
+			else
+			{
+				edge_map.emplace(key, std::pair<std::uint32_t, int>(node_index, j));
+			}
+		}
+	}
+	
+	// Open the remaining edges to other sections
+	for (const auto& edge: edge_map)
+	{
+		const std::uint32_t a = static_cast<std::uint32_t>(edge.first >> 32);
+		const std::uint32_t b = static_cast<std::uint32_t>(edge.first);
+		open_edge(edge.second.first, edge.second.second, get_position(a), get_position(b));
+	}
+	
+	return section;
+}
+
+void navmesh::remove_section(std::uint32_t section)
+{
+	for (std::uint32_t node_index: sections[section])
+	{
+		node& node = nodes[node_index];
+		
+		for (int i = 0; i < 3; ++i)
+		{
+			const std::uint32_t neighbor_index = node.neighbors[i];
+			if (neighbor_index == invalid_index)
+			{
+				// Close edges which are still open
+				if (node.edge_keys[i])
+				{
+					auto it = open_edges.find(node.edge_keys[i]);
+					if (it != open_edges.end() && it->second.first == node_index)
+						open_edges.erase(it);
+				}
+				continue;
+			}
+			
+			// Reopen the edges of other sections which were welded to this section
+			struct node& neighbor = nodes[neighbor_index];
+			if (neighbor.section == section)
+				continue;
+			for (int j = 0; j < 3; ++j)
+			{
+				if (neighbor.neighbors[j] == node_index)
+				{
+					neighbor.neighbors[j] = invalid_index;
+					open_edges[neighbor.edge_keys[j]] = {neighbor_index, j};
+				}
+			}
+		}
+		
+		// Remove the node from its cluster
+		mark_modified(node.cluster);
+		std::vector<std::uint32_t>& cluster_nodes = clusters[node.cluster].nodes;
+		auto it = std::find(cluster_nodes.begin(), cluster_nodes.end(), node_index);
+		*it = cluster_nodes.back();
+		cluster_nodes.pop_back();
+		
+		node.section = invalid_index;
+		free_nodes.push_back(node_index);
+		--node_count;
+	}
+	
+	sections[section].clear();
+	free_sections.push_back(section);
+	modified = true;
+}
+
+void navmesh::update()
+{
+	// Report the clusters modified since the previous update
+	for (std::uint32_t cluster_index: modified_clusters)
+		cluster_flags[cluster_index] = false;
+	modified_clusters.swap(pending_modified_clusters);
+	pending_modified_clusters.clear();
+	cluster_flags.resize(clusters.size(), false);
+	for (std::uint32_t cluster_index: modified_clusters)
+	{
+		pending_cluster_flags[cluster_index] = false;
+		cluster_flags[cluster_index] = true;
+	}
+	
+	if (!modified)
+		return;
+	
+	// Rebuild the cluster graph from the connections between nodes of different clusters
+	for (std::uint32_t i = 0; i < static_cast<std::uint32_t>(clusters.size()); ++i)
+	{
+		cluster& cluster = clusters[i];
+		cluster.neighbors.clear();
+		
+		float3 center = {0.0f, 0.0f, 0.0f};
+		for (std::uint32_t node_index: cluster.nodes)
+		{
+			const node& node = nodes[node_index];
+			center += node.centroid;
+			
+			for (std::uint32_t neighbor_index: node.neighbors)
+			{
+				if (neighbor_index == invalid_index)
+					continue;
+				const std::uint32_t neighbor_cluster = nodes[neighbor_index].cluster;
+				if (neighbor_cluster != i && std::find(cluster.neighbors.begin(), cluster.neighbors.end(), neighbor_cluster) == cluster.neighbors.end())
+					cluster.neighbors.push_back(neighbor_cluster);
+			}
+		}
+		if (!cluster.nodes.empty())
+			cluster.center = center / static_cast<float>(cluster.nodes.size());
+	}
+	
+	{
+		std::lock_guard<std::mutex> lock(cache_mutex);
+		path_cache.clear();
+	}
+	
+	modified = false;
+}
+
+std::uint32_t navmesh::find_node(const float3& position) const
+{
+	std::uint32_t nearest = invalid_index;
+	float nearest_distance_squared = std::numeric_limits<float>::infinity();
+	
+	for (int z = -1; z <= 1; ++z)
+	for (int y = -1; y <= 1; ++y)
+	for (int x = -1; x <= 1; ++x)
+	{
+		const float3 offset = {static_cast<float>(x), static_cast<float>(y), static_cast<float>(z)};
+		auto it = cluster_map.find(get_cell_key(position + offset * cluster_size));
+		if (it == cluster_map.end())
+			continue;
+		
+		for (std::uint32_t node_index: clusters[it->second].nodes)
+		{
+			const float3 difference = nodes[node_index].centroid - position;
+			const float distance_squared = math::dot(difference, difference);
+			if (distance_squared < nearest_distance_squared)
+			{
+				nearest = node_index;
+				nearest_distance_squared = distance_squared;
+			}
+		}
+	}
+	
+	return nearest;
+}
+
+bool navmesh::find_path(const float3& start, const float3& goal, std::vector<float3>& path, search& search) const
+{
+	const std::uint32_t start_node = find_node(start);
+	const std::uint32_t goal_node = find_node(goal);
+	if (start_node == invalid_index || goal_node == invalid_index)
+		return false;
+	
+	auto node_position = [this](std::uint32_t node_index)
+	{
+		return nodes[node_index].centroid;
+	};
+	auto node_neighbors = [this](std::uint32_t node_index, const auto& visit)
+	{
+		for (std::uint32_t neighbor_index: nodes[node_index].neighbors)
+			if (neighbor_index != invalid_index)
+				visit(neighbor_index);
+	};
+	
+	bool found = false;
+	const std::uint32_t start_cluster = nodes[start_node].cluster;
+	const std::uint32_t goal_cluster = nodes[goal_node].cluster;
+	if (start_cluster != goal_cluster)
+	{
+		if (!find_cluster_path(start_cluster, goal_cluster, search))
+			return false;
+		
+		// Restrict the search between triangles to the corridor of clusters along the cluster path
+		if (search.corridor_stamps.size() < clusters.size())
+			search.corridor_stamps.resize(clusters.size(), 0);
+		if (++search.corridor_stamp == 0)
+		{
+			std::fill(search.corridor_stamps.begin(), search.corridor_stamps.end(), 0);
+			search.corridor_stamp = 1;
+		}
+		for (std::uint32_t cluster_index: search.cluster_path)
+			search.corridor_stamps[cluster_index] = search.corridor_stamp;
+		
+		found = find_route(search.nodes, nodes.size(), start_node, goal_node, node_position, node_neighbors,
+			[this, &search](std::uint32_t node_index)
+			{
+				return search.corridor_stamps[nodes[node_index].cluster] == search.corridor_stamp;
+			},
+			search.node_path);
+	}
+	
+	// Search without restriction within a single cluster, or where the corridor doesn't contain a route
+	if (!found)
+	{
+		found = find_route(search.nodes, nodes.size(), start_node, goal_node, node_position, node_neighbors,
+			[](std::uint32_t){return true;},
+			search.node_path);
+		if (!found)
+			return false;
+	}
+	
+	path.clear();
+	for (std::size_t i = 1; i < search.node_path.size(); ++i)
+		path.push_back(nodes[search.node_path[i]].centroid);
+	path.push_back(goal);
+	
+	return true;
+}
+
+std::uint32_t navmesh::add_node(std::uint32_t section, const float3& a, const float3& b, const float3& c)
+{
+	std::uint32_t node_index;
+	if (!free_nodes.empty())
+	{
+		node_index = free_nodes.back();
+		free_nodes.pop_back();
+	}
+	else
+	{
+		node_index = static_cast<std::uint32_t>(nodes.size());
+		nodes.emplace_back();
+	}
+	
+	node& node = nodes[node_index];
+	node.centroid = (a + b + c) / 3.0f;
+	node.neighbors = {invalid_index, invalid_index, invalid_index};
+	node.edge_keys = {0, 0, 0};
+	node.section = section;
+	
+	// Add the node to the cluster of its grid cell
+	auto [it, inserted] = cluster_map.try_emplace(get_cell_key(node.centroid), static_cast<std::uint32_t>(clusters.size()));
+	if (inserted)
+		clusters.emplace_back();
+	node.cluster = it->second;
+	clusters[node.cluster].nodes.push_back(node_index);
+	mark_modified(node.cluster);
+	
+	sections[section].push_back(node_index);
+	++node_count;
+	modified = true;
+	
+	return node_index;
+}
+
+void navmesh::open_edge(std::uint32_t node_index, int edge, const float3& a, const float3& b)
+{
+	const std::uint64_t key = get_edge_key(a, b);
+	nodes[node_index].edge_keys[edge] = key;
+	
+	auto it = open_edges.find(key);
+	if (it == open_edges.end())
+	{
+		open_edges.emplace(key, std::pair<std::uint32_t, int>(node_index, edge));
+		return;
+	}
+	
+	// Weld the edge to a matching edge of another section. Edges shared by more than two triangles of a section remain open.
+	const std::uint32_t other_index = it->second.first;
+	if (nodes[other_index].section == nodes[node_index].section)
+		return;
+	nodes[node_index].neighbors[edge] = other_index;
+	nodes[other_index].neighbors[it->second.second] = node_index;
+	open_edges.erase(it);
+}
+
+std::uint64_t navmesh::get_cell_key(const float3& position) const
+{
+	std::uint64_t key = 0;
+	for (int i = 0; i < 3; ++i)
+	{
+		const std::int64_t cell = static_cast<std::int64_t>(std::floor(position[i] * cell_scale)) + (1 << 20);
+		key |= (static_cast<std::uint64_t>(cell) & 0x1fffff) << (i * 21);
+	}
+	
+	return key;
+}
+
+void navmesh::mark_modified(std::uint32_t cluster)
+{
+	if (pending_cluster_flags.size() <= cluster)
+		pending_cluster_flags.resize(clusters.size(), false);
+	if (!pending_cluster_flags[cluster])
+	{
+		pending_cluster_flags[cluster] = true;
+		pending_modified_clusters.push_back(cluster);
+	}
+}
+
+std::uint32_t navmesh::allocate_section()
+{
+	if (!free_sections.empty())
+	{
+		const std::uint32_t section = free_sections.back();
+		free_sections.pop_back();
+		return section;
+	}
+	
+	sections.emplace_back();
+	return static_cast<std::uint32_t>(sections.size() - 1);
+}
+
+bool navmesh::find_cluster_path(std::uint32_t start, std::uint32_t goal, search& search) const
+{
+	const std::uint64_t key = (static_cast<std::uint64_t>(start) << 32) | goal;
+	{
+		std::lock_guard<std::mutex> lock(cache_mutex);
+		if (auto it = path_cache.find(key); it != path_cache.end())
+		{
+			search.cluster_path = it->second;
+			return !search.cluster_path.empty();
+		}
+	}
+	
+	const bool found = find_route(search.clusters, clusters.size(), start, goal,
+		[this](std::uint32_t cluster_index)
+		{
+			return clusters[cluster_index].center;
+		},
+		[this](std::uint32_t cluster_index, const auto& visit)
+		{
+			for (std::uint32_t neighbor_index: clusters[cluster_index].neighbors)
+				visit(neighbor_index);
+		},
+		[](std::uint32_t){return true;},
+		search.cluster_path);
+	if (!found)
+		search.cluster_path.clear();
+	
+	// Cache failures too, as disconnected regions would otherwise be searched exhaustively by every request
+	std::lock_guard<std::mutex> lock(cache_mutex);
+	path_cache.emplace(key, search.cluster_path);
+	
+	return found;
+}
+
+template <class Position, class Neighbors, class Allowed>
+bool navmesh::find_route(search::level& level, std::size_t count, std::uint32_t start, std::uint32_t goal, const Position& position, const Neighbors& neighbors, const Allowed& allowed, std::vector<std::uint32_t>& route)
+{
+	if (level.costs.size() < count)
+	{
+		level.costs.resize(count);
+		level.parents.resize(count);
+		level.stamps.resize(count, 0);
+		level.closed_stamps.resize(count, 0);
+	}
+	
+	// Stamp visited vertices rather than clearing the search state of every vertex
+	if (++level.stamp == 0)
+	{
+		std::fill(level.stamps.begin(), level.stamps.end(), 0);
+		std::fill(level.closed_stamps.begin(), level.closed_stamps.end(), 0);
+		level.stamp = 1;
+	}
+	const std::uint32_t stamp = level.stamp;
+	
+	auto greater = [](const std::pair<float, std::uint32_t>& a, const std::pair<float, std::uint32_t>& b)
+	{
+		return a.first > b.first;
+	};
+	
+	const float3 goal_position = position(goal);
+	level.open.clear();
+	level.costs[start] = 0.0f;
+	level.parents[start] = invalid_index;
+	level.stamps[start] = stamp;
+	level.open.emplace_back(math::length(position(start) - goal_position), start);
+	
+	while (!level.open.empty())
+	{
+		std::pop_heap(level.open.begin(), level.open.end(), greater);
+		const std::uint32_t current = level.open.back().second;
+		level.open.pop_back();
+		
+		if (level.closed_stamps[current] == stamp)
+			continue;
+		level.closed_stamps[current] = stamp;
+		
+		if (current == goal)
+		{
+			route.clear();
+			for (std::uint32_t i = goal; i != invalid_index; i = level.parents[i])
+				route.push_back(i);
+			std::reverse(route.begin(), route.end());
+			return true;
+		}
+		
+		const float3 current_position = position(current);
+		const float current_cost = level.costs[current];
+		neighbors(current,
+			[&](std::uint32_t next)
+			{
+				if (level.closed_stamps[next] == stamp || !allowed(next))
+					return;
+				
+				const float3 next_position = position(next);
+				const float cost = current_cost + math::length(next_position - current_position);
+				if (level.stamps[next] != stamp || cost < level.costs[next])
+				{
+					level.stamps[next] = stamp;
+					level.costs[next] = cost;
+					level.parents[next] = current;
+					level.open.emplace_back(cost + math::length(next_position - goal_position), next);
+					std::push_heap(level.open.begin(), level.open.end(), greater);
+				}
+			});
+	}
+	
+	return false;
+}
+
+} // namespace ai
@@ -0,0 +1,289 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ANTKEEPER_AI_NAVMESH_HPP
+#define ANTKEEPER_AI_NAVMESH_HPP
+
+#include "geom/mesh.hpp"
+#include "utility/fundamental-types.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace ai {
+
+/**
+ * Navigation mesh, whose nodes are walkable triangles connected across their shared edges, and over which paths are found by hierarchical A*.
+ *
+ * Triangles are added in sections, such as terrain patches or subterrain chunks, which may be replaced as their geometry changes. Triangles within a section are connected by their shared edges, and open edges are welded to open edges of other sections at the same positions. Nodes are grouped into clusters by the cells of a uniform grid, and paths are first found between clusters, then refined between triangles within the clusters along the cluster path. Cluster paths are cached until the mesh is modified, so ants heading between the same regions share most of their planning.
+ *
+ * The mesh may only be modified, and update() called, while no paths are being found. Once updated, paths may be found concurrently, each thread with its own search state.
+ */
+class navmesh
+{
+public:
+	/// Index of an invalid node, section, or cluster.
+	static constexpr std::uint32_t invalid_index = ~std::uint32_t(0);
+	
+	/// Reusable state of a path search. Threads which find paths concurrently must each use their own search state.
+	class search
+	{
+	private:
+		friend class navmesh;
+		
+		/// A* state over one level of the hierarchy.
+		struct level
+		{
+			std::vector<float> costs;
+			std::vector<std::uint32_t> parents;
+			std::vector<std::uint32_t> stamps;
+			std::vector<std::uint32_t> closed_stamps;
+			std::vector<std::pair<float, std::uint32_t>> open;
+			std::uint32_t stamp = 0;
+		};
+		
+		level nodes;
+		level clusters;
+		std::vector<std::uint32_t> corridor_stamps;
+		std::uint32_t corridor_stamp = 0;
+		std::vector<std::uint32_t> cluster_path;
+		std::vector<std::uint32_t> node_path;
+	};
+	
+	/**
+	 * Creates an empty navigation mesh.
+	 *
+	 * @param cluster_size Width of the grid cells by which nodes are clustered.
+	 */
+	explicit navmesh(float cluster_size);
+	
+	/**
+	 * Adds the triangles of a mesh as a new section, connecting triangles across the half-edges they share. Faces which aren't triangles are ignored.
+	 *
+	 * @param mesh Mesh to add.
+	 * @return Index of the section.
+	 */
+	std::uint32_t add_mesh(const geom::mesh& mesh);
+	
+	/**
+	 * Adds a list of indexed triangles as a new section, connecting triangles across the edges they share.
+	 *
+	 * @param positions Array of vertex positions, each three floats.
+	 * @param stride Number of floats between consecutive vertex positions.
+	 * @param indices Array of vertex indices, three per triangle.
+	 * @param triangle_count Number of triangles.
+	 * @return Index of the section.
+	 */
+	std::uint32_t add_triangles(const float* positions, std::size_t stride, const std::uint32_t* indices, std::size_t triangle_count);
+	
+	/**
+	 * Removes a section, reopening the edges of other sections which were welded to it.
+	 *
+	 * @param section Index of the section to remove.
+	 */
+	void remove_section(std::uint32_t section);
+	
+	/// Rebuilds the cluster graph and clears the path cache if the mesh has been modified. Must be called after modifying the mesh and before finding paths.
+	void update();
+	
+	/**
+	 * Finds the node whose centroid is nearest to a position, within the position's cluster cell and those bordering it.
+	 *
+	 * @param position Position near the mesh.
+	 * @return Index of the nearest node, or `invalid_index` if there are no nearby nodes.
+	 */
+	std::uint32_t find_node(const float3& position) const;
+	
+	/**
+	 * Finds a path between two positions on the mesh. Safe to call concurrently with different search states.
+	 *
+	 * @param start Position from which the path starts.
+	 * @param goal Position at which the path ends.
+	 * @param[out] path List of waypoints, replaced by the centroids of the triangles along the path followed by the goal.
+	 * @param search Search state.
+	 * @return `true` if a path was found, `false` otherwise.
+	 */
+	bool find_path(const float3& start, const float3& goal, std::vector<float3>& path, search& search) const;
+	
+	/// Returns the number of triangles in the mesh.
+	std::size_t get_node_count() const;
+	
+	/// Returns one more than the greatest node index in use, by which arrays indexed by node may be sized.
+	std::size_t get_node_capacity() const;
+	
+	/// Returns `true` if a node index refers to a node, `false` if it has been freed.
+	bool is_node(std::uint32_t node) const;
+	
+	/// Returns the centroid of a node's triangle.
+	const float3& get_centroid(std::uint32_t node) const;
+	
+	/// Returns the nodes across each edge of a node's triangle, or `invalid_index`.
+	const std::array<std::uint32_t, 3>& get_neighbors(std::uint32_t node) const;
+	
+	/// Returns the cluster of a node.
+	std::uint32_t get_cluster(std::uint32_t node) const;
+	
+	/// Returns the clusters connected to a cluster.
+	const std::vector<std::uint32_t>& get_cluster_neighbors(std::uint32_t cluster) const;
+	
+	/// Returns the number of clusters in the mesh.
+	std::size_t get_cluster_count() const;
+	
+	/// Returns the clusters whose nodes were added or removed before the most recent update(), from which data derived from the mesh may be invalidated.
+	const std::vector<std::uint32_t>& get_modified_clusters() const;
+	
+	/// Returns `true` if a cluster's nodes were added or removed before the most recent update().
+	bool is_cluster_modified(std::uint32_t cluster) const;
+	
+private:
+	/// Walkable triangle.
+	struct node
+	{
+		float3 centroid;
+		
+		/// Nodes across each edge of the triangle, or `invalid_index`.
+		std::array<std::uint32_t, 3> neighbors;
+		
+		/// Position keys of edges which are or were open to other sections, or `0`.
+		std::array<std::uint64_t, 3> edge_keys;
+		
+		std::uint32_t cluster;
+		std::uint32_t section;
+	};
+	
+	struct cluster
+	{
+		std::vector<std::uint32_t> nodes;
+		std::vector<std::uint32_t> neighbors;
+		float3 center;
+	};
+	
+	/// Allocates a node for a triangle of a section.
+	std::uint32_t add_node(std::uint32_t section, const float3& a, const float3& b, const float3& c);
+	
+	/// Welds an open edge of a node to a matching open edge of another section, or records it as open.
+	void open_edge(std::uint32_t node_index, int edge, const float3& a, const float3& b);
+	
+	/// Returns the key of the grid cell containing a position.
+	std::uint64_t get_cell_key(const float3& position) const;
+	
+	/// Allocates a section.
+	std::uint32_t allocate_section();
+	
+	/// Records the modification of a cluster, to be reported by the next update().
+	void mark_modified(std::uint32_t cluster);
+	
+	/// Finds the sequence of clusters between two clusters, using the path cache.
+	bool find_cluster_path(std::uint32_t start, std::uint32_t goal, search& search) const;
+	
+	/**
+	 * Finds the cheapest route between two vertices of a graph with A*, using straight-line distance as both the edge cost and the heuristic.
+	 *
+	 * @param level Search state of the graph's level of the hierarchy.
+	 * @param count Number of vertices in the graph.
+	 * @param start Index of the start vertex.
+	 * @param goal Index of the goal vertex.
+	 * @param position Function which returns the position of a vertex, with the signature `float3(std::uint32_t)`.
+	 * @param neighbors Function which visits the neighbors of a vertex, with the signature `void(std::uint32_t, const Visitor&)`, where a visitor has the signature `void(std::uint32_t)`.
+	 * @param allowed Function which returns `true` if a vertex may be entered, with the signature `bool(std::uint32_t)`.
+	 * @param[out] route Indices of the vertices along the route, from start to goal.
+	 * @return `true` if a route was found, `false` otherwise.
+	 */
+	template <class Position, class Neighbors, class Allowed>
+	static bool find_route(search::level& level, std::size_t count, std::uint32_t start, std::uint32_t goal, const Position& position, const Neighbors& neighbors, const Allowed& allowed, std::vector<std::uint32_t>& route);
+	
+	float cluster_size;
+	float cell_scale;
+	std::vector<node> nodes;
+	std::vector<std::uint32_t> free_nodes;
+	std::vector<std::vector<std::uint32_t>> sections;
+	std::vector<std::uint32_t> free_sections;
+	std::vector<cluster> clusters;
+	std::unordered_map<std::uint64_t, std::uint32_t> cluster_map;
+	std::unordered_map<std::uint64_t, std::pair<std::uint32_t, int>> open_edges;
+	std::size_t node_count;
+	bool modified;
+	
+	/// Clusters modified since the most recent update(), and those reported by it, each flagged per cluster.
+	std::vector<std::uint32_t> pending_modified_clusters;
+	std::vector<std::uint32_t> modified_clusters;
+	std::vector<bool> pending_cluster_flags;
+	std::vector<bool> cluster_flags;
+	
+	mutable std::mutex cache_mutex;
+	mutable std::unordered_map<std::uint64_t, std::vector<std::uint32_t>> path_cache;
+};
+
+inline std::size_t navmesh::get_node_count() const
+{
+	return node_count;
+}
+
+inline std::size_t navmesh::get_node_capacity() const
+{
+	return nodes.size();
+}
+
+inline bool navmesh::is_node(std::uint32_t node) const
+{
+	return node < nodes.size() && nodes[node].section != invalid_index;
+}
+
+inline const float3& navmesh::get_centroid(std::uint32_t node) const
+{
+	return nodes[node].centroid;
+}
+
+inline const std::array<std::uint32_t, 3>& navmesh::get_neighbors(std::uint32_t node) const
+{
+	return nodes[node].neighbors;
+}
+
+inline std::uint32_t navmesh::get_cluster(std::uint32_t node) const
+{
+	return nodes[node].cluster;
+}
+
+inline const std::vector<std::uint32_t>& navmesh::get_cluster_neighbors(std::uint32_t cluster) const
+{
+	return clusters[cluster].neighbors;
+}
+
+inline std::size_t navmesh::get_cluster_count() const
+{
+	return clusters.size();
+}
+
+inline const std::vector<std::uint32_t>& navmesh::get_modified_clusters() const
+{
+	return modified_clusters;
+}
+
+inline bool navmesh::is_cluster_modified(std::uint32_t cluster) const
+{
+	return cluster < cluster_flags.size() && cluster_flags[cluster];
+}
+
+} // namespace ai
+
+#endif // ANTKEEPER_AI_NAVMESH_HPP
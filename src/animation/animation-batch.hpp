@@ -0,0 +1,266 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ANTKEEPER_ANIMATION_BATCH_HPP
+#define ANTKEEPER_ANIMATION_BATCH_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+/**
+ * Abstract base class for batches of animations.
+ */
+class animation_batch_base
+{
+public:
+	virtual ~animation_batch_base() = default;
+	
+	/**
+	 * Advances the positions of all animations in the batch by @p dt.
+	 *
+	 * @param dt Delta time by which the animation positions will be advanced.
+	 */
+	virtual void advance(double dt) = 0;
+};
+
+/**
+ * Batch of two-state animations which share a value type and interpolator.
+ *
+ * Each animation interpolates from an initial state to a final state over its duration. Animation states are stored in contiguous arrays, and the interpolator is a template parameter rather than a function object, so that all animations of a batch are advanced by loops which can be inlined and vectorized. Animations are referred to by handles, which remain valid until their animations are removed.
+ *
+ * @tparam T Value type.
+ * @tparam S Scalar type of the interpolation factor.
+ * @tparam Interpolator Function which interpolates between two values, such as `math::lerp<T, S>` or an easing function.
+ */
+template <class T, class S, T (*Interpolator)(const T&, const T&, S)>
+class animation_batch: public animation_batch_base
+{
+public:
+	/// Value type.
+	typedef T value_type;
+	
+	/// Scalar type.
+	typedef S scalar_type;
+	
+	/// Animation handle type.
+	typedef std::uint32_t handle_type;
+	
+	/// @copydoc animation_batch_base::advance()
+	virtual void advance(double dt);
+	
+	/**
+	 * Adds an animation to the batch.
+	 *
+	 * @param state0 Initial state.
+	 * @param state1 Final state.
+	 * @param duration Duration of the animation.
+	 * @param looped `true` if the animation should loop once its final state has been reached.
+	 * @return Handle to the animation.
+	 */
+	handle_type insert(const value_type& state0, const value_type& state1, double duration, bool looped = false);
+	
+	/**
+	 * Removes an animation from the batch.
+	 *
+	 * @param handle Handle to the animation.
+	 */
+	void erase(handle_type handle);
+	
+	/// Removes all animations from the batch.
+	void clear();
+	
+	/**
+	 * Sets the position of an animation.
+	 *
+	 * @param handle Handle to the animation.
+	 * @param t Position in time to which the animation position will be set.
+	 */
+	void seek(handle_type handle, double t);
+	
+	/// Returns the interpolated value of an animation, as of the most recent advance.
+	const value_type& get_value(handle_type handle) const;
+	
+	/// Returns the current position in time of an animation.
+	double get_position(handle_type handle) const;
+	
+	/// Returns `true` if a non-looped animation has reached its final state.
+	bool is_finished(handle_type handle) const;
+	
+	/// Returns the number of animations in the batch.
+	std::size_t size() const;
+	
+private:
+	/// Returns the index of an animation in the state arrays.
+	std::size_t index(handle_type handle) const;
+	
+	// Animation states, in dense arrays
+	std::vector<value_type> states0;
+	std::vector<value_type> states1;
+	std::vector<value_type> values;
+	std::vector<double> positions;
+	std::vector<double> durations;
+	std::vector<std::uint8_t> looped;
+	
+	/// Handles of the animations in the state arrays.
+	std::vector<handle_type> handles;
+	
+	/// Indices of animations in the state arrays, indexed by handle.
+	std::vector<std::uint32_t> indices;
+	
+	/// Handles of removed animations, available for reuse.
+	std::vector<handle_type> free_handles;
+};
+
+template <class T, class S, T (*Interpolator)(const T&, const T&, S)>
+void animation_batch<T, S, Interpolator>::advance(double dt)
+{
+	const std::size_t count = positions.size();
+	
+	// Advance positions, wrapping looped animations and clamping others to their durations
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		const double position = positions[i] + dt;
+		const double wrapped = position - std::floor(position / durations[i]) * durations[i];
+		positions[i] = looped[i] ? wrapped : std::min(position, durations[i]);
+	}
+	
+	// Interpolate values
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		const scalar_type a = static_cast<scalar_type>(positions[i] / durations[i]);
+		values[i] = Interpolator(states0[i], states1[i], a);
+	}
+}
+
+template <class T, class S, T (*Interpolator)(const T&, const T&, S)>
+typename animation_batch<T, S, Interpolator>::handle_type animation_batch<T, S, Interpolator>::insert(const value_type& state0, const value_type& state1, double duration, bool looped)
+{
+	handle_type handle;
+	if (!free_handles.empty())
+	{
+		handle = free_handles.back();
+		free_handles.pop_back();
+	}
+	else
+	{
+		handle = static_cast<handle_type>(indices.size());
+		indices.push_back(0);
+	}
+	
+	indices[handle] = static_cast<std::uint32_t>(handles.size());
+	handles.push_back(handle);
+	states0.push_back(state0);
+	states1.push_back(state1);
+	values.push_back(state0);
+	positions.push_back(0.0);
+	
+	// Zero durations would produce non-finite interpolation factors
+	durations.push_back(std::max(duration, std::numeric_limits<double>::min()));
+	this->looped.push_back(looped);
+	
+	return handle;
+}
+
+template <class T, class S, T (*Interpolator)(const T&, const T&, S)>
+void animation_batch<T, S, Interpolator>::erase(handle_type handle)
+{
+	// Move the last animation into the place of the removed animation
+	const std::size_t i = index(handle);
+	const std::size_t last = handles.size() - 1;
+	if (i != last)
+	{
+		states0[i] = std::move(states0[last]);
+		states1[i] = std::move(states1[last]);
+		values[i] = std::move(values[last]);
+		positions[i] = positions[last];
+		durations[i] = durations[last];
+		looped[i] = looped[last];
+		handles[i] = handles[last];
+		indices[handles[i]] = static_cast<std::uint32_t>(i);
+	}
+	
+	states0.pop_back();
+	states1.pop_back();
+	values.pop_back();
+	positions.pop_back();
+	durations.pop_back();
+	looped.pop_back();
+	handles.pop_back();
+	
+	free_handles.push_back(handle);
+}
+
+template <class T, class S, T (*Interpolator)(const T&, const T&, S)>
+void animation_batch<T, S, Interpolator>::clear()
+{
+	states0.clear();
+	states1.clear();
+	values.clear();
+	positions.clear();
+	durations.clear();
+	looped.clear();
+	handles.clear();
+	indices.clear();
+	free_handles.clear();
+}
+
+template <class T, class S, T (*Interpolator)(const T&, const T&, S)>
+void animation_batch<T, S, Interpolator>::seek(handle_type handle, double t)
+{
+	const std::size_t i = index(handle);
+	positions[i] = t;
+	values[i] = Interpolator(states0[i], states1[i], static_cast<scalar_type>(t / durations[i]));
+}
+
+template <class T, class S, T (*Interpolator)(const T&, const T&, S)>
+inline const typename animation_batch<T, S, Interpolator>::value_type& animation_batch<T, S, Interpolator>::get_value(handle_type handle) const
+{
+	return values[index(handle)];
+}
+
+template <class T, class S, T (*Interpolator)(const T&, const T&, S)>
+inline double animation_batch<T, S, Interpolator>::get_position(handle_type handle) const
+{
+	return positions[index(handle)];
+}
+
+template <class T, class S, T (*Interpolator)(const T&, const T&, S)>
+inline bool animation_batch<T, S, Interpolator>::is_finished(handle_type handle) const
+{
+	const std::size_t i = index(handle);
+	return !looped[i] && positions[i] >= durations[i];
+}
+
+template <class T, class S, T (*Interpolator)(const T&, const T&, S)>
+inline std::size_t animation_batch<T, S, Interpolator>::size() const
+{
+	return handles.size();
+}
+
+template <class T, class S, T (*Interpolator)(const T&, const T&, S)>
+inline std::size_t animation_batch<T, S, Interpolator>::index(handle_type handle) const
+{
+	return indices[handle];
+}
+
+#endif // ANTKEEPER_ANIMATION_BATCH_HPP
@@ -21,11 +21,12 @@
 #define ANTKEEPER_ANIMATION_HPP
 
 #include <algorithm>
+#include <cstddef>
 #include <functional>
-#include <set>
+#include <list>
 #include <tuple>
 #include <type_traits>
-#include <unordered_map>
+#include <vector>
 
 /**
  * Abstract base class for animations.
@@ -140,6 +141,11 @@ inline int animation_base::get_loop_count() const
 	return loop_count;
 }
 
+/**
+ * Channel of keyframes, stored as contiguous arrays of keyframe times and values in order of increasing time.
+ *
+ * @tparam T Keyframe value type.
+ */
 template <typename T>
 class animation_channel
 {
@@ -157,14 +163,8 @@ public:
 	/// Creates an animation channel.
 	animation_channel();
 	
-	/// Creates an animation channel.
-	animation_channel(const animation_channel& other);
-	
-	/// Assigns the contents of another channel to this channel.
-	animation_channel& operator=(const animation_channel& other);
-	
 	/**
-	 * Adds a keyframe to the animation.
+	 * Adds a keyframe to the animation. Keyframes are appended in constant time if added in order of increasing time. If a keyframe already exists at the same time, the channel is left unchanged.
 	 *
 	 * @param k Keyframe to add.
 	 */
@@ -182,12 +182,15 @@ public:
 	void remove_keyframes();
 	
 	/**
-	 * Finds the keyframes to the left and right of @p position.
+	 * Finds the first keyframe after @p position.
+	 *
+	 * The hint is checked first, followed by the keyframe after it, so that positions which advance monotonically are found in amortized constant time. Other positions are found by binary search.
 	 *
 	 * @param position Position in time.
-	 * @return Array containing the the keyframes on the left and right of @p position.
+	 * @param hint Index returned by the previous search, such as for the previous frame of playback.
+	 * @return Index of the first keyframe after @p position, or the number of keyframes if no keyframe follows @p position.
 	 */
-	std::array<const keyframe*, 2> find_keyframes(double position) const;
+	std::size_t find_next_keyframe(double position, std::size_t hint = 0) const;
 	
 	/**
 	 * Finds all the keyframes on `[start, end)`.
@@ -204,23 +207,24 @@ public:
 	/// Returns the duration of the animation channel.
 	double get_duration() const;
 	
-private:
-	struct keyframe_compare
-	{
-		inline bool operator()(const keyframe& lhs, const keyframe& rhs) const
-		{
-			return std::get<0>(lhs) < std::get<0>(rhs);
-		}
-	};
+	/// Returns the number of keyframes in the channel.
+	std::size_t get_keyframe_count() const;
 	
+	/// Returns the times of the keyframes, in increasing order.
+	const std::vector<double>& get_times() const;
+	
+	/// Returns the values of the keyframes, in order of their times.
+	const std::vector<T>& get_values() const;
+	
+private:
 	int id;
-	std::set<keyframe, keyframe_compare> keyframes;
+	std::vector<double> times;
+	std::vector<T> values;
 };
 
 template <typename T>
 animation_channel<T>::animation_channel(int id):
-	id(id),
-	keyframes(keyframe_compare())
+	id(id)
 {}
 
 template <typename T>
@@ -228,68 +232,71 @@ animation_channel<T>::animation_channel():
 	animation_channel(-1)
 {}
 
-template <typename T>
-animation_channel<T>::animation_channel(const animation_channel& other):
-	id(other.id),
-	keyframes(other.keyframes)
-{}
-
-template <typename T>
-animation_channel<T>& animation_channel<T>::operator=(const animation_channel& other)
-{
-	id = other.id;
-	keyframes = other.keyframes;
-}
-
 template <typename T>
 void animation_channel<T>::insert_keyframe(const keyframe& k)
 {
-	keyframes.emplace(k);
+	const double time = std::get<0>(k);
+	
+	// Append keyframes which follow the last keyframe
+	if (times.empty() || time > times.back())
+	{
+		times.push_back(time);
+		values.push_back(std::get<1>(k));
+		return;
+	}
+	
+	auto it = std::lower_bound(times.begin(), times.end(), time);
+	if (*it == time)
+		return;
+	
+	const auto index = it - times.begin();
+	times.insert(it, time);
+	values.insert(values.begin() + index, std::get<1>(k));
 }
 
 template <typename T>
 void animation_channel<T>::remove_keyframes(double start, double end)
 {
-	auto lower_bound = keyframes.lower_bound({start, T()});
-	auto upper_bound = keyframes.upper_bound({end, T()});
-	keyframes.erase(lower_bound, upper_bound);
+	const auto first = std::lower_bound(times.begin(), times.end(), start) - times.begin();
+	const auto last = std::lower_bound(times.begin() + first, times.end(), end) - times.begin();
+	times.erase(times.begin() + first, times.begin() + last);
+	values.erase(values.begin() + first, values.begin() + last);
 }
 
 template <typename T>
 void animation_channel<T>::remove_keyframes()
 {
-	keyframes.clear();
+	times.clear();
+	values.clear();
 }
 
 template <typename T>
-std::array<const typename animation_channel<T>::keyframe*, 2> animation_channel<T>::find_keyframes(double position) const
+std::size_t animation_channel<T>::find_next_keyframe(double position, std::size_t hint) const
 {
-	// Find the following keyframe
-	auto upper_bound = keyframes.upper_bound({position, T()});
-	
-	// Find the preceding keyframe
-	auto lower_bound = upper_bound;
-	--lower_bound;
+	const std::size_t count = times.size();
 	
-	std::array<const keyframe*, 2> frames;
-	frames[0] = (lower_bound != keyframes.end()) ? &(*lower_bound) : nullptr;
-	frames[1] = (upper_bound != keyframes.end()) ? &(*upper_bound) : nullptr;
+	// Check the hint, then the keyframe after it
+	for (std::size_t i = hint; i <= count && i <= hint + 1; ++i)
+	{
+		if ((i == 0 || times[i - 1] <= position) && (i == count || position < times[i]))
+			return i;
+	}
 	
-	return frames;
+	return static_cast<std::size_t>(std::upper_bound(times.begin(), times.end(), position) - times.begin());
 }
 
 template <typename T>
 std::list<typename animation_channel<T>::keyframe> animation_channel<T>::find_keyframes(double start, double end) const
 {
 	std::list<keyframe> keyframe_list;
-
-	auto lower_bound = keyframes.lower_bound({start, T()});
-	auto upper_bound = keyframes.upper_bound({end, T()});
-	for (auto iterator = lower_bound; iterator != upper_bound; ++iterator)
+	
+	const auto first = std::lower_bound(times.begin(), times.end(), start) - times.begin();
+	const auto last = std::lower_bound(times.begin() + first, times.end(), end) - times.begin();
+	for (auto i = first; i != last; ++i)
 	{
-		keyframe_list.push_back(*iterator);
+		keyframe_list.emplace_back(times[i], values[i]);
 	}
-
+	
 	return keyframe_list;
 }
 
@@ -300,18 +307,33 @@ inline int animation_channel<T>::get_id() const
 }
 
 template <typename T>
-double animation_channel<T>::get_duration() const
+inline double animation_channel<T>::get_duration() const
 {
-	if (keyframes.empty())
-	{
-		return 0.0;
-	}
-	
-	return std::get<0>(*keyframes.rbegin());
+	return (times.empty()) ? 0.0 : times.back();
+}
+
+template <typename T>
+inline std::size_t animation_channel<T>::get_keyframe_count() const
+{
+	return times.size();
+}
+
+template <typename T>
+inline const std::vector<double>& animation_channel<T>::get_times() const
+{
+	return times;
+}
+
+template <typename T>
+inline const std::vector<T>& animation_channel<T>::get_values() const
+{
+	return values;
 }
 
 /**
  * Templated keyframe animation class.
+ *
+ * Channels are stored contiguously, each with a cursor at the keyframe following the current position, so that the keyframes of forward playback are found without searching.
  */
 template <typename T>
 class animation: public animation_base
@@ -333,7 +355,7 @@ public:
 	virtual void advance(double dt);
 	
 	/**
-	 * Adds a channel to the animation.
+	 * Adds a channel to the animation. Pointers to channels are invalidated when channels are added or removed.
 	 *
 	 * @param id ID of the channel.
 	 * @return Added or pre-existing channel.
@@ -360,7 +382,7 @@ public:
 	/**
 	 * Sets the callback that's executed on each frame of animation.
 	 *
-	 * @param callback Frame callback which receives the index of an animation channel and value of an interpolated frame.
+	 * @param callback Frame callback which receives the ID of an animation channel and value of an interpolated frame.
 	 */
 	void set_frame_callback(std::function<void(int, const T&)> callback);
 	
@@ -378,7 +400,14 @@ public:
 	virtual double get_duration() const;
 
 private:
-	std::unordered_map<int, channel> channels;
+	/// Returns the index of the channel with the specified ID, or the number of channels if no such channel exists.
+	std::size_t find_channel(int id) const;
+	
+	std::vector<channel> channels;
+	
+	/// Indices of the keyframes following the current position, one per channel.
+	std::vector<std::size_t> cursors;
+	
 	interpolator_type interpolator;
 	std::function<void(int, const T&)> frame_callback;
 };
@@ -409,28 +438,37 @@ void animation<T>::advance(double dt)
 		{
 			for (std::size_t i = 0; i < channels.size(); ++i)
 			{
-				auto frames = channels[i].find_keyframes(position);
+				const channel& channel = channels[i];
+				if (!channel.get_keyframe_count())
+					continue;
+				
+				// Advance the cursor of the channel to the keyframe following the current position
+				const std::size_t next = channel.find_next_keyframe(position, cursors[i]);
+				cursors[i] = next;
+				
+				const std::vector<double>& times = channel.get_times();
+				const std::vector<T>& values = channel.get_values();
 				
-				if (frames[0] != nullptr && frames[1] != nullptr)
+				if (next == 0)
 				{
-					// Calculate interpolated frame
-					double t0 = std::get<0>(*frames[0]);
-					double t1 = std::get<0>(*frames[1]);
-					double alpha = (position - t0) / (t1 - t0);
-					T frame = interpolator(std::get<1>(*frames[0]), std::get<1>(*frames[1]), alpha);
-					
-					// Pass frame to frame callback
-					frame_callback(static_cast<int>(i), frame);
+					// Pass first frame to frame callback
+					frame_callback(channel.get_id(), values.front());
 				}
-				else if (frames[0] != nullptr)
+				else if (next == times.size())
 				{
-					// Pass frame to frame callback
-					frame_callback(static_cast<int>(i), std::get<1>(*frames[0]));
+					// Pass last frame to frame callback
+					frame_callback(channel.get_id(), values.back());
 				}
-				else if (frames[1] != nullptr)
+				else
 				{
+					// Calculate interpolated frame
+					double t0 = times[next - 1];
+					double t1 = times[next];
+					double alpha = (position - t0) / (t1 - t0);
+					T frame = interpolator(values[next - 1], values[next], alpha);
+					
 					// Pass frame to frame callback
-					frame_callback(static_cast<int>(i), std::get<1>(*frames[1]));
+					frame_callback(channel.get_id(), frame);
 				}
 			}
 		}
@@ -461,12 +499,11 @@ void animation<T>::advance(double dt)
 			// Call frame callback for end frame
 			if (frame_callback != nullptr)
 			{
-				for (std::size_t i = 0; i < channels.size(); ++i)
+				for (const channel& channel: channels)
 				{
-					auto frames = channels[i].find_keyframes(channels[i].get_duration());
-					if (frames[0] != nullptr)
+					if (channel.get_keyframe_count())
 					{
-						frame_callback(static_cast<int>(i), std::get<1>(*frames[0]));
+						frame_callback(channel.get_id(), channel.get_values().back());
 					}
 				}
 			}
@@ -485,16 +522,26 @@ void animation<T>::advance(double dt)
 template <typename T>
 typename animation<T>::channel* animation<T>::add_channel(int id)
 {
-	return &(*channels.emplace(id, id).first).second;
+	const std::size_t index = find_channel(id);
+	if (index != channels.size())
+	{
+		return &channels[index];
+	}
+	
+	channels.emplace_back(id);
+	cursors.push_back(0);
+	
+	return &channels.back();
 }
 
 template <typename T>
 void animation<T>::remove_channel(int id)
 {
-	auto it = channels.find(id);
-	if (it != channels.end())
+	const std::size_t index = find_channel(id);
+	if (index != channels.size())
 	{
-		channels.erase(it);
+		channels.erase(channels.begin() + index);
+		cursors.erase(cursors.begin() + index);
 	}
 }
 
@@ -502,6 +549,7 @@ template <typename T>
 void animation<T>::remove_channels()
 {
 	channels.clear();
+	cursors.clear();
 }
 
 template <typename T>
@@ -519,25 +567,15 @@ void animation<T>::set_frame_callback(std::function<void(int, const T&)> callbac
 template <typename T>
 const typename animation<T>::channel* animation<T>::get_channel(int id) const
 {
-	auto it = channels.find(id);
-	if (it != channels.end())
-	{
-		return &it->second;
-	}
-	
-	return nullptr;
+	const std::size_t index = find_channel(id);
+	return (index != channels.size()) ? &channels[index] : nullptr;
 }
 
 template <typename T>
 typename animation<T>::channel* animation<T>::get_channel(int id)
 {
-	auto it = channels.find(id);
-	if (it != channels.end())
-	{
-		return &it->second;
-	}
-	
-	return nullptr;
+	const std::size_t index = find_channel(id);
+	return (index != channels.size()) ? &channels[index] : nullptr;
 }
 
 template <typename T>
@@ -545,12 +583,24 @@ double animation<T>::get_duration() const
 {
 	double duration = 0.0;
 	
-	for (auto it = channels.begin(); it != channels.end(); ++it)
+	for (const channel& channel: channels)
 	{
-		duration = std::max<double>(duration, it->second.get_duration());
+		duration = std::max<double>(duration, channel.get_duration());
 	}
 	
 	return duration;
 }
 
+template <typename T>
+std::size_t animation<T>::find_channel(int id) const
+{
+	std::size_t index = 0;
+	while (index < channels.size() && channels[index].get_id() != id)
+	{
+		++index;
+	}
+	
+	return index;
+}
+
 #endif // ANTKEEPER_ANIMATION_HPP
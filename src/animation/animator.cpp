@@ -19,6 +19,8 @@
 
 #include "animator.hpp"
 #include "animation/animation.hpp"
+#include "animation/animation-batch.hpp"
+#include <algorithm>
 
 void animator::animate(double dt)
 {
@@ -26,16 +28,24 @@ void animator::animate(double dt)
 	{
 		animation->advance(dt);
 	}
+	
+	for (animation_batch_base* batch: batches)
+	{
+		batch->advance(dt);
+	}
 }
 
 void animator::add_animation(animation_base* animation)
 {
-	animations.emplace(animation);
+	if (std::find(animations.begin(), animations.end(), animation) == animations.end())
+	{
+		animations.push_back(animation);
+	}
 }
 
 void animator::remove_animation(animation_base* animation)
 {
-	auto it = animations.find(animation);
+	auto it = std::find(animations.begin(), animations.end(), animation);
 	if (it != animations.end())
 	{
 		animations.erase(it);
@@ -46,3 +56,36 @@ void animator::remove_animations()
 {
 	animations.clear();
 }
+
+void animator::add_batch(animation_batch_base* batch)
+{
+	if (std::find(batches.begin(), batches.end(), batch) == batches.end())
+	{
+		batches.push_back(batch);
+	}
+}
+
+void animator::remove_batch(animation_batch_base* batch)
+{
+	auto it = std::find(batches.begin(), batches.end(), batch);
+	if (it != batches.end())
+	{
+		batches.erase(it);
+	}
+}
+
+void animator::remove_batches()
+{
+	batches.clear();
+}
+
+bool animator::is_animating() const
+{
+	for (const animation_base* animation: animations)
+	{
+		if (!animation->is_stopped() && !animation->is_paused())
+			return true;
+	}
+	
+	return !batches.empty();
+}
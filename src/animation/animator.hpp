@@ -20,10 +20,16 @@
 #ifndef ANTKEEPER_ANIMATOR_HPP
 #define ANTKEEPER_ANIMATOR_HPP
 
-#include <set>
+#include <vector>
 
 class animation_base;
+class animation_batch_base;
 
+/**
+ * Progresses animations and batches of animations.
+ *
+ * Many concurrent animations of the same value type and interpolator should be grouped into an animation_batch, which is advanced in a single loop rather than by a virtual call per animation.
+ */
 class animator
 {
 public:
@@ -38,8 +44,29 @@ public:
 	void remove_animation(animation_base* animation);
 	void remove_animations();
 	
+	/**
+	 * Adds a batch of animations, which will be advanced on each call to animate().
+	 *
+	 * @param batch Batch of animations.
+	 */
+	void add_batch(animation_batch_base* batch);
+	
+	/**
+	 * Removes a batch of animations.
+	 *
+	 * @param batch Batch of animations.
+	 */
+	void remove_batch(animation_batch_base* batch);
+	
+	/// Removes all batches of animations.
+	void remove_batches();
+	
+	/// Returns `true` if any animation is playing or any batch of animations has been added, `false` otherwise.
+	bool is_animating() const;
+	
 private:
-	std::set<animation_base*> animations;
+	std::vector<animation_base*> animations;
+	std::vector<animation_batch_base*> batches;
 };
 
 #endif // ANTKEEPER_ANIMATOR_HPP
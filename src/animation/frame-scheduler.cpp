@@ -19,13 +19,17 @@
 
 #include "frame-scheduler.hpp"
 #include <algorithm>
+#include <thread>
 
 frame_scheduler::frame_scheduler():
 	update_callback(nullptr),
 	render_callback(nullptr),
 	update_rate(60.0),
 	update_timestep(1.0 / update_rate),
-	max_frame_duration(update_timestep)
+	max_frame_duration(update_timestep),
+	max_updates_per_frame(0),
+	time_scale(1.0),
+	frame_rate_limit(0.0)
 {
 	reset();
 }
@@ -51,34 +55,107 @@ void frame_scheduler::set_max_frame_duration(double duration)
 	max_frame_duration = duration;
 }
 
+void frame_scheduler::set_max_updates_per_frame(std::size_t count)
+{
+	max_updates_per_frame = count;
+}
+
+void frame_scheduler::set_time_scale(double scale)
+{
+	time_scale = scale;
+}
+
+void frame_scheduler::set_frame_rate_limit(double frequency)
+{
+	frame_rate_limit = frequency;
+	frame_deadline = clock_type::now();
+}
+
 double frame_scheduler::get_frame_duration() const
 {
 	return frame_duration;
 }
 
+double frame_scheduler::get_time_until_update() const
+{
+	if (time_scale <= 0.0)
+		return update_timestep;
+	
+	const double elapsed = std::chrono::duration<double>(clock_type::now() - frame_start).count();
+	return std::max(0.0, (update_timestep - accumulator) / time_scale - elapsed);
+}
+
 void frame_scheduler::reset()
 {
 	elapsed_time = 0.0;
 	accumulator = 0.0;
-	frame_start = std::chrono::high_resolution_clock::now();
+	frame_start = clock_type::now();
 	frame_end = frame_start;
 	frame_duration = 0.0;
+	frame_deadline = frame_start;
+	dropped_update_count = 0;
+	catch_up_update_count = 0;
 }
 
 void frame_scheduler::tick()
 {
-	frame_end = std::chrono::high_resolution_clock::now();
+	frame_end = clock_type::now();
 	frame_duration = static_cast<double>(std::chrono::duration_cast<std::chrono::microseconds>(frame_end - frame_start).count()) / 1000000.0;
 	frame_start = frame_end;
 	
-	accumulator += std::min<double>(max_frame_duration, frame_duration);
+	// Clamp the simulated duration of the frame, dropping the updates it would have required
+	const double simulated_duration = frame_duration * time_scale;
+	accumulator += std::min<double>(max_frame_duration, simulated_duration);
+	if (simulated_duration > max_frame_duration)
+		dropped_update_count += static_cast<std::size_t>((simulated_duration - max_frame_duration) / update_timestep);
 
+	std::size_t update_count = 0;
 	while (accumulator >= update_timestep)
 	{
+		// Drop the remaining updates once the update limit is reached, rather than catching up in later frames
+		if (max_updates_per_frame && update_count == max_updates_per_frame)
+		{
+			const std::size_t dropped = static_cast<std::size_t>(accumulator / update_timestep);
+			accumulator -= static_cast<double>(dropped) * update_timestep;
+			dropped_update_count += dropped;
+			break;
+		}
+		
 		update_callback(elapsed_time, update_timestep);
 		elapsed_time += update_timestep;
 		accumulator -= update_timestep;
+		++update_count;
 	}
 	
+	if (update_count > 1)
+		catch_up_update_count += update_count - 1;
+	
 	render_callback(accumulator * update_rate);
+	
+	// Wait for the next frame to become due
+	if (frame_rate_limit > 0.0)
+	{
+		const auto frame_period = std::chrono::duration_cast<clock_type::duration>(std::chrono::duration<double>(1.0 / frame_rate_limit));
+		
+		// Advance the deadline by whole periods to avoid drift, restarting it if the frame overran
+		frame_deadline += frame_period;
+		const auto now = clock_type::now();
+		if (frame_deadline < now)
+			frame_deadline = now;
+		else
+			wait_until(frame_deadline);
+	}
+}
+
+void frame_scheduler::wait_until(clock_type::time_point time)
+{
+	// Sleep coarsely, leaving a margin for the wakeup latency of the OS scheduler
+	const auto margin = std::chrono::milliseconds(2);
+	const auto now = clock_type::now();
+	if (time - now > margin)
+		std::this_thread::sleep_for(time - now - margin);
+	
+	// Yield precisely up to the deadline
+	while (clock_type::now() < time)
+		std::this_thread::yield();
 }
@@ -21,6 +21,7 @@
 #define ANTKEEPER_FRAME_SCHEDULER_HPP
 
 #include <chrono>
+#include <cstddef>
 #include <functional>
 
 /**
@@ -60,11 +61,41 @@ public:
 	 * @param duration Maximum frame duration, in seconds..
 	 */
 	void set_max_frame_duration(double duration);
+	
+	/**
+	 * Sets the maximum number of updates per frame. Once reached, the remaining accumulated time is dropped rather than caught up in subsequent frames.
+	 *
+	 * @param count Maximum number of updates per frame, or `0` for no limit.
+	 */
+	void set_max_updates_per_frame(std::size_t count);
+	
+	/**
+	 * Sets the rate at which simulation time passes relative to real time.
+	 *
+	 * @param scale Time scale, where `1` is real time.
+	 */
+	void set_time_scale(double scale);
+	
+	/**
+	 * Limits the frame rate. Once a frame has been rendered, the scheduler sleeps, then yields, until the next frame is due.
+	 *
+	 * @param frequency Maximum number of frames per second, or `0` for no limit.
+	 */
+	void set_frame_rate_limit(double frequency);
 
 	/**
 	 * Returns the duration of the last frame, in seconds.
 	 */
 	double get_frame_duration() const;
+	
+	/// Returns the real time, in seconds, from now until enough time will have accumulated for the next update, or one update timestep if time is stopped.
+	double get_time_until_update() const;
+	
+	/// Returns the number of updates dropped since the last reset, either by the maximum frame duration or by the maximum number of updates per frame.
+	std::size_t get_dropped_update_count() const;
+	
+	/// Returns the number of updates performed since the last reset in excess of one per frame, to catch up to the update rate.
+	std::size_t get_catch_up_update_count() const;
 
 	/**
 	 * Resets the total elapsed time, frame duration, and internal timers.
@@ -77,17 +108,41 @@ public:
 	void tick();
 
 private:
+	typedef std::chrono::high_resolution_clock clock_type;
+	
+	/// Sleeps until shortly before a time point, then yields until it has passed.
+	static void wait_until(clock_type::time_point time);
+	
 	std::function<void(double, double)> update_callback;
 	std::function<void(double)> render_callback;
 	double update_rate;
 	double update_timestep;
 	double max_frame_duration;
+	std::size_t max_updates_per_frame;
+	double time_scale;
+	double frame_rate_limit;
 	double elapsed_time;
 	double accumulator;
 	std::chrono::high_resolution_clock::time_point frame_start;
 	std::chrono::high_resolution_clock::time_point frame_end;
 	double frame_duration;
+	
+	/// Time at which the next frame is due, if the frame rate is limited.
+	std::chrono::high_resolution_clock::time_point frame_deadline;
+	
+	std::size_t dropped_update_count;
+	std::size_t catch_up_update_count;
 };
 
+inline std::size_t frame_scheduler::get_dropped_update_count() const
+{
+	return dropped_update_count;
+}
+
+inline std::size_t frame_scheduler::get_catch_up_update_count() const
+{
+	return catch_up_update_count;
+}
+
 #endif // ANTKEEPER_FRAME_SCHEDULER_HPP
 
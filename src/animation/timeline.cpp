@@ -18,64 +18,105 @@
  */
 
 #include "timeline.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
 
-auto cue_compare = [](const typename timeline::cue& a, const typename timeline::cue& b)
+static bool cue_compare(const timeline::cue& a, const timeline::cue& b)
 {
 	return std::get<0>(a) < std::get<0>(b);
-};
+}
 
 timeline::timeline():
-	cues(cue_compare),
+	first_cue(0),
+	playhead(0),
 	position(0.0f),
-	autoremove(false)
+	autoremove(false),
+	dispatching(false),
+	deferred_clear(false)
 {}
 
 void timeline::advance(float dt)
 {
-	auto lower_bound = cues.lower_bound({position, nullptr});
-	auto upper_bound = cues.upper_bound({position + dt, nullptr});
-
-	for (auto iterator = lower_bound; iterator != upper_bound; ++iterator)
+	const float end = position + dt;
+	
+	// Trigger cues on [position, end)
+	dispatching = true;
+	const std::size_t triggered = playhead;
+	while (playhead < cues.size() && std::get<0>(cues[playhead]) < end)
 	{
-		std::get<1>(*iterator)();
+		std::get<1>(cues[playhead])();
+		++playhead;
 	}
-
-	if (autoremove && lower_bound != upper_bound)
+	dispatching = false;
+	
+	if (autoremove && playhead != triggered)
 	{
-		cues.erase(lower_bound, upper_bound);
+		// Retire triggered cues, erasing them once they make up half of the cues
+		first_cue = playhead;
+		if (first_cue > cues.size() / 2)
+		{
+			cues.erase(cues.begin(), cues.begin() + first_cue);
+			first_cue = 0;
+			playhead = 0;
+		}
 	}
-
-	position += dt;
+	
+	position = end;
+	
+	// Reposition the playhead if the timeline was advanced backward
+	if (dt < 0.0f)
+		playhead = lower_bound(position);
+	
+	apply_deferred();
 }
 
 void timeline::seek(float t)
 {
 	position = t;
+	playhead = lower_bound(position);
 }
 
 void timeline::add_cue(const cue& c)
 {
-	cues.emplace(c);
+	if (dispatching)
+	{
+		deferred_cues.push_back(c);
+		return;
+	}
+	
+	cues.insert(cues.begin() + upper_bound(std::get<0>(c)), c);
+	playhead = lower_bound(position);
 }
 
 void timeline::remove_cue(const cue& c)
 {
-	cues.erase(c);
+	const float t = std::get<0>(c);
+	remove_cues(t, std::nextafter(t, std::numeric_limits<float>::infinity()));
 }
 
 void timeline::remove_cues(float start, float end)
 {
-	auto lower_bound = cues.lower_bound({start, nullptr});
-	auto upper_bound = cues.upper_bound({end, nullptr});
-	cues.erase(lower_bound, upper_bound);
+	if (dispatching)
+	{
+		deferred_removals.emplace_back(start, end);
+		return;
+	}
+	
+	erase(lower_bound(start), lower_bound(end));
 }
 
 void timeline::add_sequence(const sequence& s)
 {
-	for (const cue& c: s)
+	if (dispatching)
 	{
-		add_cue(c);
+		deferred_cues.insert(deferred_cues.end(), s.begin(), s.end());
+		return;
 	}
+	
+	const std::size_t first = cues.size();
+	cues.insert(cues.end(), s.begin(), s.end());
+	merge(first);
 }
 
 void timeline::remove_sequence(const sequence& s)
@@ -88,7 +129,17 @@ void timeline::remove_sequence(const sequence& s)
 
 void timeline::clear()
 {
+	if (dispatching)
+	{
+		deferred_clear = true;
+		deferred_cues.clear();
+		deferred_removals.clear();
+		return;
+	}
+	
 	cues.clear();
+	first_cue = 0;
+	playhead = 0;
 }
 
 void timeline::set_autoremove(bool enabled)
@@ -98,15 +149,57 @@ void timeline::set_autoremove(bool enabled)
 
 typename timeline::sequence timeline::get_cues(float start, float end) const
 {
-	sequence s;
+	return sequence(cues.begin() + lower_bound(start), cues.begin() + lower_bound(end));
+}
 
-	auto lower_bound = cues.lower_bound({start, nullptr});
-	auto upper_bound = cues.upper_bound({end, nullptr});
-	for (auto iterator = lower_bound; iterator != upper_bound; ++iterator)
+std::size_t timeline::lower_bound(float t) const
+{
+	return std::lower_bound(cues.begin() + first_cue, cues.end(), cue{t, nullptr}, cue_compare) - cues.begin();
+}
+
+std::size_t timeline::upper_bound(float t) const
+{
+	return std::upper_bound(cues.begin() + first_cue, cues.end(), cue{t, nullptr}, cue_compare) - cues.begin();
+}
+
+void timeline::erase(std::size_t first, std::size_t last)
+{
+	if (first < last)
 	{
-		s.push_back(*iterator);
+		cues.erase(cues.begin() + first, cues.begin() + last);
+		playhead = lower_bound(position);
 	}
+}
 
-	return s;
+void timeline::merge(std::size_t first)
+{
+	// Sort the new cues once, then merge them after any existing cues of equal time
+	std::stable_sort(cues.begin() + first, cues.end(), cue_compare);
+	std::inplace_merge(cues.begin() + first_cue, cues.begin() + first, cues.end(), cue_compare);
+	playhead = lower_bound(position);
 }
 
+void timeline::apply_deferred()
+{
+	if (deferred_clear)
+	{
+		deferred_clear = false;
+		clear();
+	}
+	
+	for (const auto& [start, end]: deferred_removals)
+		erase(lower_bound(start), lower_bound(end));
+	deferred_removals.clear();
+	
+	if (!deferred_cues.empty())
+	{
+		// Delay cues which were scheduled before the new position until the next advance
+		for (cue& c: deferred_cues)
+			std::get<0>(c) = std::max(std::get<0>(c), position);
+		
+		const std::size_t first = cues.size();
+		cues.insert(cues.end(), std::make_move_iterator(deferred_cues.begin()), std::make_move_iterator(deferred_cues.end()));
+		deferred_cues.clear();
+		merge(first);
+	}
+}
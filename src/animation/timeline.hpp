@@ -20,12 +20,17 @@
 #ifndef ANTKEEPER_TIMELINE_HPP
 #define ANTKEEPER_TIMELINE_HPP
 
+#include <cstddef>
 #include <functional>
-#include <set>
 #include <tuple>
+#include <vector>
 
 /**
  * Timeline which executes cues (scheduled functions) when advanced over their respective positions in time.
+ *
+ * Cues are stored in a vector sorted by time, with cues of equal time in the order in which they were added, and a playhead index marks the first cue at or after the timeline position. Advancing the timeline triggers the cues between the playhead and the new position without allocating.
+ *
+ * Cues may add or remove cues while being triggered. Such changes are deferred until the advance completes, so cues added or removed by a triggered cue are neither triggered nor skipped by the same advance. Added cues scheduled before the new timeline position are delayed until the next advance.
  */
 class timeline
 {
@@ -34,7 +39,7 @@ public:
 	typedef std::tuple<float, std::function<void()>> cue;
 
 	/// List of cues.
-	typedef std::list<cue> sequence;
+	typedef std::vector<cue> sequence;
 
 	/**
 	 * Creates a timeline.
@@ -42,7 +47,7 @@ public:
 	timeline();
 
 	/**
-	 * Advances the timeline position (t) by @p dt, triggering any cues scheduled between `t` and `dt`. If autoremove is enabled, triggered cues will be removed.
+	 * Advances the timeline position (t) by @p dt, triggering any cues scheduled on `[t, t + dt)`. If autoremove is enabled, triggered cues will be removed.
 	 *
 	 * @param dt Delta time by which the timeline position will be advanced.
 	 */
@@ -63,7 +68,7 @@ public:
 	void add_cue(const cue& c);
 
 	/**
-	 * Removes a cue from the timeline. If there are multiple identical cues (same time and function), they will all be removed.
+	 * Removes a cue from the timeline. As function objects cannot be compared, all cues scheduled at the same time as the cue are removed.
 	 *
 	 * @param c Cue to remove.
 	 */
@@ -78,7 +83,7 @@ public:
 	void remove_cues(float start, float end);
 
 	/**
-	 * Adds a sequence of cues to the timeline.
+	 * Adds a sequence of cues to the timeline, sorting them once rather than inserting them one at a time.
 	 *
 	 * @param s Sequence of cues to add.
 	 */
@@ -88,6 +93,8 @@ public:
 	 * Removes a sequence of cues from the timeline.
 	 *
 	 * @param s Sequence of cues to remove.
+	 *
+	 * @see timeline::remove_cue()
 	 */
 	void remove_sequence(const sequence& s);
 
@@ -118,9 +125,44 @@ public:
 	sequence get_cues(float start, float end) const;
 
 private:
-	std::multiset<cue, std::function<bool(const cue&, const cue&)>> cues;
+	/// Returns the index of the first live cue at or after @p t.
+	std::size_t lower_bound(float t) const;
+	
+	/// Returns the index of the first live cue after @p t.
+	std::size_t upper_bound(float t) const;
+	
+	/// Removes the live cues on `[first, last)` and repositions the playhead.
+	void erase(std::size_t first, std::size_t last);
+	
+	/// Merges the cues on `[first, cues.size())`, sorted by time, into the preceding cues.
+	void merge(std::size_t first);
+	
+	/// Applies the changes deferred while cues were being triggered.
+	void apply_deferred();
+	
+	/// Cues sorted by time. If autoremove is enabled, triggered cues before `first_cue` are retained until they make up half of the vector, then erased at once.
+	std::vector<cue> cues;
+	
+	/// Index of the first cue which has not been autoremoved.
+	std::size_t first_cue;
+	
+	/// Index of the first cue at or after the timeline position.
+	std::size_t playhead;
+	
 	float position;
 	bool autoremove;
+	
+	/// `true` while cues are being triggered.
+	bool dispatching;
+	
+	/// Cues added while cues were being triggered.
+	std::vector<cue> deferred_cues;
+	
+	/// Ranges of time, on `[start, end)`, removed while cues were being triggered.
+	std::vector<std::tuple<float, float>> deferred_removals;
+	
+	/// `true` if the timeline was cleared while cues were being triggered.
+	bool deferred_clear;
 };
 
 inline float timeline::get_position() const
@@ -129,4 +171,3 @@ inline float timeline::get_position() const
 }
 
 #endif // ANTKEEPER_TIMELINE_HPP
-
@@ -19,22 +19,30 @@
 
 #include "animation/frame-scheduler.hpp"
 #include "application.hpp"
+#include "debug/allocation-tracker.hpp"
+#include "debug/counters.hpp"
+#include "debug/frame-recorder.hpp"
+#include "debug/gl-monitor.hpp"
+#include "debug/input-recorder.hpp"
 #include "debug/logger.hpp"
 #include "debug/performance-sampler.hpp"
+#include "debug/profiler.hpp"
 #include "event/event-dispatcher.hpp"
 #include "event/window-events.hpp"
 #include "input/scancode.hpp"
 #include "input/sdl-game-controller-tables.hpp"
 #include "input/sdl-scancode-table.hpp"
 #include "resources/image.hpp"
+#include "utility/job-system.hpp"
 #include <SDL2/SDL.h>
 #include <glad/glad.h>
 #include <stdexcept>
 #include <utility>
-#include <thread>
-#include <stb/stb_image_write.h>
-#include <iostream>
+#include <algorithm>
+#include <cmath>
 #include <iomanip>
+#include <sstream>
+#include <thread>
 
 application::application():
 	closed(false),
@@ -51,6 +59,18 @@ application::application():
 	viewport_dimensions({0, 0}),
 	mouse_position({0, 0}),
 	update_rate(60.0),
+	low_latency(false),
+	frame_throttling(false),
+	refresh_period(1.0 / 60.0),
+	frame_work_duration(0.0),
+	cpu_update_duration(0.0),
+	cpu_frame_duration(0.0),
+	frame_rendered(false),
+	idle(false),
+	idle_update_rate(10.0),
+	redraw_requested(true),
+	input_translated(false),
+	input_pending(false),
 	logger(nullptr),
 	sdl_window(nullptr),
 	sdl_gl_context(nullptr)
@@ -99,6 +119,10 @@ application::application():
 	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
 	SDL_GL_SetAttribute(SDL_GL_DOUBLEBUFFER, 1);
 	SDL_GL_SetAttribute(SDL_GL_DEPTH_SIZE, 24);
+	#if defined(DEBUG)
+		// Request a debug context, so that the driver reports performance warnings
+		SDL_GL_SetAttribute(SDL_GL_CONTEXT_FLAGS, SDL_GL_CONTEXT_DEBUG_FLAG);
+	#endif
 
 	// Get display dimensions
 	SDL_DisplayMode sdl_desktop_display_mode;
@@ -161,6 +185,17 @@ application::application():
 	{
 		logger->pop_task(EXIT_SUCCESS);
 	}
+	
+	// Monitor the driver for performance warnings and stalls
+	logger->push_task("Installing OpenGL debug message callback");
+	if (!debug::gl_monitor::install(logger, SDL_GL_GetProcAddress))
+	{
+		logger->pop_task(EXIT_FAILURE);
+	}
+	else
+	{
+		logger->pop_task(EXIT_SUCCESS);
+	}
 
 	// Set v-sync mode
 	int swap_interval = (vsync) ? 1 : 0;
@@ -221,11 +256,35 @@ application::application():
 	// Setup performance sampling
 	performance_sampler = new debug::performance_sampler();
 	performance_sampler->set_sample_size(15);
+	update_sampler = new debug::performance_sampler();
+	render_sampler = new debug::performance_sampler();
+	swap_sampler = new debug::performance_sampler();
+	input_latency_sampler = new debug::performance_sampler();
+	input_latency_sampler->set_sample_size(512);
+	
+	// Setup job system
+	job_system = new ::job_system();
+	
+	// Setup frame recorder
+	frame_recorder = new debug::frame_recorder(job_system);
+	
+	// Setup input recorder
+	input_recorder = new debug::input_recorder(event_dispatcher, keyboard, mouse);
 }
 
 application::~application()
 {
-	// Destroy the OpenGL context
+	// Save pending frames
+	delete frame_recorder;
+	
+	// Write the input recording
+	delete input_recorder;
+	
+	// Finish pending jobs and join worker threads
+	delete job_system;
+	
+	// Stop monitoring the driver, then destroy the OpenGL context
+	debug::gl_monitor::uninstall();
 	SDL_GL_DeleteContext(sdl_gl_context);
 	
 	// Destroy the SDL window
@@ -234,6 +293,9 @@ application::~application()
 	// Shutdown SDL
 	SDL_QuitSubSystem(SDL_INIT_VIDEO | SDL_INIT_JOYSTICK | SDL_INIT_GAMECONTROLLER);
 	SDL_Quit();
+	
+	// Write pending log messages and join the log writer thread
+	delete logger;
 }
 
 void application::close(int status)
@@ -268,13 +330,66 @@ int application::execute(bootloader_type bootloader)
 	frame_scheduler->reset();
 
 	// Schedule frames until closed
+	swap_time = std::chrono::high_resolution_clock::now();
 	while (!closed)
 	{
+		// In idle mode, block until an event arrives or an update is due, unless a redraw has been requested. Otherwise, start the frame as late as possible, so that input is sampled shortly before the swap.
+		if (idle && !redraw_requested.load(std::memory_order_relaxed))
+			wait_idle();
+		else if (low_latency && vsync)
+			delay_frame();
+		const auto frame_start = std::chrono::high_resolution_clock::now();
+		
 		// Tick frame scheduler
 		frame_scheduler->tick();
-
+		debug::allocation_tracker::end_frame();
+		debug::counters::end_frame();
+		
+		// Frames skipped in idle mode would skew frame timing statistics
+		if (!frame_rendered)
+			continue;
+		
 		// Sample frame duration
 		performance_sampler->sample(frame_scheduler->get_frame_duration());
+		
+		// Track the peak work duration of frames, decaying it so that it recovers from spikes
+		const double work_duration = std::chrono::duration<double>(swap_time - frame_start).count();
+		frame_work_duration = std::max(work_duration, frame_work_duration * 0.95);
+	}
+	
+	// Report frame timing statistics
+	for (timing_channel channel: {timing_channel::frame, timing_channel::update, timing_channel::render, timing_channel::swap})
+	{
+		const debug::performance_sampler* sampler = get_timing_sampler(channel);
+		if (!sampler->sample_count())
+			continue;
+		
+		std::ostringstream stream;
+		stream << std::fixed << std::setprecision(2);
+		stream << "Frame " << get_timing_channel_name(channel) << " time over " << sampler->sample_count() << " samples: ";
+		stream << "p50 " << sampler->streaming_percentile(0.5) * 1000.0 << " ms, ";
+		stream << "p95 " << sampler->streaming_percentile(0.95) * 1000.0 << " ms, ";
+		stream << "p99 " << sampler->streaming_percentile(0.99) * 1000.0 << " ms, ";
+		stream << "max " << sampler->max_duration() * 1000.0 << " ms";
+		logger->log(stream.str());
+	}
+	
+	// Report updates which were dropped or caught up
+	if (frame_scheduler->get_dropped_update_count() || frame_scheduler->get_catch_up_update_count())
+	{
+		logger->log("Dropped " + std::to_string(frame_scheduler->get_dropped_update_count()) + " updates and caught up " + std::to_string(frame_scheduler->get_catch_up_update_count()) + " updates");
+	}
+	
+	// Report input latency distribution
+	if (input_latency_sampler->size())
+	{
+		std::ostringstream stream;
+		stream << std::fixed << std::setprecision(2);
+		stream << "Input-to-swap latency over " << input_latency_sampler->size() << " frames: ";
+		stream << "p50 " << input_latency_sampler->percentile(0.5) * 1000.0 << " ms, ";
+		stream << "p95 " << input_latency_sampler->percentile(0.95) * 1000.0 << " ms, ";
+		stream << "p99 " << input_latency_sampler->percentile(0.99) * 1000.0 << " ms";
+		logger->log(stream.str());
 	}
 	
 	// Exit current state
@@ -303,6 +418,7 @@ void application::change_state(const application::state& next_state)
 	}
 	
 	current_state = next_state;
+	request_redraw();
 	
 	// Enter next state
 	if (current_state.enter)
@@ -352,27 +468,18 @@ std::shared_ptr<image> application::capture_frame() const
 
 	// Read pixel data from framebuffer into image
 	glReadBuffer(GL_BACK);
-	glReadPixels(0, 0, w, h, GL_RGB, GL_UNSIGNED_BYTE, frame->get_pixels());
+	{
+		debug::gl_stall_scope stall("glReadPixels");
+		glReadPixels(0, 0, w, h, GL_RGB, GL_UNSIGNED_BYTE, frame->get_pixels());
+	}
 	
 	return std::move(frame);
 }
 
 void application::save_frame(const std::string& path) const
 {
-	logger->push_task("Saving screenshot to \"" + path + "\"");
-	
-	auto frame = capture_frame();
-	
-	std::thread
-	(
-		[frame, path]
-		{
-			stbi_flip_vertically_on_write(1);
-			stbi_write_png(path.c_str(), frame->get_width(), frame->get_height(), frame->get_channels(), frame->get_pixels(), frame->get_width() * frame->get_channels());
-		}
-	).detach();
-	
-	logger->pop_task(EXIT_SUCCESS);
+	logger->log("Saving screenshot to \"" + path + "\"");
+	frame_recorder->save_frame(path);
 }
 
 void application::set_update_callback(const update_callback_type& callback)
@@ -388,7 +495,8 @@ void application::set_render_callback(const render_callback_type& callback)
 void application::set_update_rate(double frequency)
 {
 	update_rate = frequency;
-	frame_scheduler->set_update_rate(update_rate);
+	if (!idle)
+		frame_scheduler->set_update_rate(update_rate);
 }
 
 void application::set_title(const std::string& title)
@@ -461,6 +569,83 @@ void application::set_vsync(bool vsync)
 	}
 }
 
+void application::set_idle(bool idle)
+{
+	if (this->idle == idle)
+		return;
+	
+	this->idle = idle;
+	frame_scheduler->set_update_rate((idle) ? idle_update_rate : update_rate);
+	request_redraw();
+}
+
+void application::set_idle_update_rate(double frequency)
+{
+	idle_update_rate = frequency;
+	if (idle)
+		frame_scheduler->set_update_rate(idle_update_rate);
+}
+
+void application::request_redraw()
+{
+	redraw_requested.store(true, std::memory_order_relaxed);
+}
+
+void application::set_low_latency(bool enabled)
+{
+	low_latency = enabled;
+	
+	// Get the refresh period of the display which contains the window
+	refresh_period = 1.0 / 60.0;
+	SDL_DisplayMode sdl_display_mode;
+	if (SDL_GetWindowDisplayMode(sdl_window, &sdl_display_mode) == 0 && sdl_display_mode.refresh_rate > 0)
+		refresh_period = 1.0 / static_cast<double>(sdl_display_mode.refresh_rate);
+}
+
+void application::set_frame_throttling(bool enabled)
+{
+	frame_throttling = enabled;
+}
+
+const debug::performance_sampler* application::get_timing_sampler(timing_channel channel) const
+{
+	switch (channel)
+	{
+		case timing_channel::update:
+			return update_sampler;
+		case timing_channel::render:
+			return render_sampler;
+		case timing_channel::swap:
+			return swap_sampler;
+		default:
+			return performance_sampler;
+	}
+}
+
+void application::reset_timing_samplers()
+{
+	performance_sampler->reset();
+	update_sampler->reset();
+	render_sampler->reset();
+	swap_sampler->reset();
+	input_latency_sampler->reset();
+}
+
+const char* application::get_timing_channel_name(timing_channel channel)
+{
+	switch (channel)
+	{
+		case timing_channel::update:
+			return "update";
+		case timing_channel::render:
+			return "render";
+		case timing_channel::swap:
+			return "swap";
+		default:
+			return "frame";
+	}
+}
+
 void application::set_window_opacity(float opacity)
 {
 	SDL_SetWindowOpacity(sdl_window, opacity);
@@ -473,47 +658,123 @@ void application::swap_buffers()
 
 void application::update(double t, double dt)
 {
+	debug::profile_zone zone("application::update");
+	const auto update_start = std::chrono::high_resolution_clock::now();
+	
 	translate_sdl_events();
+	
+	// Queue replayed input, then dispatch input of this update
+	input_recorder->update();
 	event_dispatcher->update(t);
 	
-	if (update_callback)
+	// Redraw the frame following the dispatch of input, which may have changed what is on screen
+	if (input_translated || input_recorder->is_replaying())
 	{
-		update_callback(t, dt);
+		input_translated = false;
+		request_redraw();
 	}
 	
-	/*
-	static int frame =  0;
-	if (frame % 60 == 0)
+	if (update_callback)
 	{
-		std::cout << std::fixed;
-		std::cout << std::setprecision(2);
-		std::cout << performance_sampler->mean_frame_duration() * 1000.0 << "\n";
+		update_callback(t, dt);
 	}
-	++frame;
-	*/
+	
+	const double update_duration = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - update_start).count();
+	update_sampler->sample(update_duration);
+	cpu_update_duration += update_duration;
 }
 
 void application::render(double alpha)
 {
-	/*
-	std::cout << std::fixed;
-	std::cout << std::setprecision(2);
-	std::cout << performance_sampler->mean_frame_duration() * 1000.0 << std::endl;
-	*/
+	// In idle mode, skip rendering and swapping frames until a redraw is requested
+	const bool redraw = redraw_requested.exchange(false, std::memory_order_relaxed);
+	frame_rendered = redraw || !idle;
+	if (!frame_rendered)
+	{
+		cpu_update_duration = 0.0;
+		frame_recorder->poll();
+		return;
+	}
+	
+	const auto render_start = std::chrono::high_resolution_clock::now();
 	
 	if (render_callback)
 	{
 		render_callback(alpha);
 	}
 	
+	// Read back the frame before its buffers are swapped, if it is to be captured
+	frame_recorder->capture(rasterizer->get_default_framebuffer());
+	
+	const auto swap_start = std::chrono::high_resolution_clock::now();
 	SDL_GL_SwapWindow(sdl_window);
+	
+	// Wait for the GPU to finish the frame, limiting frames in flight
+	if (frame_throttling)
+		glFinish();
+	
+	swap_time = std::chrono::high_resolution_clock::now();
+	
+	// Encode captured frames which have finished reading back
+	frame_recorder->poll();
+	
+	const double render_duration = std::chrono::duration<double>(swap_start - render_start).count();
+	render_sampler->sample(render_duration);
+	cpu_frame_duration = cpu_update_duration + render_duration;
+	cpu_update_duration = 0.0;
+	swap_sampler->sample(std::chrono::duration<double>(swap_time - swap_start).count());
+	
+	// Sample the latency of the earliest input consumed by the frame
+	if (input_pending)
+	{
+		input_latency_sampler->sample(std::chrono::duration<double>(swap_time - input_time).count());
+		input_pending = false;
+	}
 }
 
 void application::translate_sdl_events()
 {
+	const auto poll_time = std::chrono::high_resolution_clock::now();
+	const Uint32 poll_ticks = SDL_GetTicks();
+	
+	// Stamps input with the time at which its event entered the SDL event queue
+	auto stamp_input = [&](Uint32 timestamp)
+	{
+		const auto time = poll_time - std::chrono::milliseconds(poll_ticks - std::min(poll_ticks, timestamp));
+		if (!input_pending || time < input_time)
+		{
+			input_time = time;
+			input_pending = true;
+		}
+		input_translated = true;
+	};
+	
+	// Ignore live input while replaying recorded input, so replayed updates see only the recorded events
+	const bool replaying = input_recorder->is_replaying();
+	
 	SDL_Event sdl_event;
 	while (SDL_PollEvent(&sdl_event))
 	{
+		if (replaying)
+		{
+			switch (sdl_event.type)
+			{
+				case SDL_KEYDOWN:
+				case SDL_KEYUP:
+				case SDL_MOUSEMOTION:
+				case SDL_MOUSEBUTTONDOWN:
+				case SDL_MOUSEBUTTONUP:
+				case SDL_MOUSEWHEEL:
+				case SDL_CONTROLLERBUTTONDOWN:
+				case SDL_CONTROLLERBUTTONUP:
+				case SDL_CONTROLLERAXISMOTION:
+					continue;
+				
+				default:
+					break;
+			}
+		}
+		
 		switch (sdl_event.type)
 		{
 			case SDL_KEYDOWN:
@@ -521,6 +782,8 @@ void application::translate_sdl_events()
 			{
 				if (sdl_event.key.repeat == 0)
 				{
+					stamp_input(sdl_event.key.timestamp);
+					
 					input::scancode scancode = input::scancode::unknown;
 					if (sdl_event.key.keysym.scancode <= SDL_SCANCODE_APP2)
 					{
@@ -537,24 +800,28 @@ void application::translate_sdl_events()
 
 			case SDL_MOUSEMOTION:
 			{
+				stamp_input(sdl_event.motion.timestamp);
 				mouse->move(sdl_event.motion.x, sdl_event.motion.y, sdl_event.motion.xrel, sdl_event.motion.yrel);
 				break;
 			}
 
 			case SDL_MOUSEBUTTONDOWN:
 			{
+				stamp_input(sdl_event.button.timestamp);
 				mouse->press(sdl_event.button.button, sdl_event.button.x, sdl_event.button.y);
 				break;
 			}
 			
 			case SDL_MOUSEBUTTONUP:
 			{
+				stamp_input(sdl_event.button.timestamp);
 				mouse->release(sdl_event.button.button, sdl_event.button.x, sdl_event.button.y);
 				break;
 			}
 			
 			case SDL_MOUSEWHEEL:
 			{
+				stamp_input(sdl_event.wheel.timestamp);
 				int direction = (sdl_event.wheel.direction == SDL_MOUSEWHEEL_FLIPPED) ? -1 : 1;
 				mouse->scroll(sdl_event.wheel.x * direction, sdl_event.wheel.y * direction);
 				break;
@@ -566,6 +833,7 @@ void application::translate_sdl_events()
 				{
 					if (auto it = game_controller_map.find(sdl_event.cdevice.which); it != game_controller_map.end())
 					{
+						stamp_input(sdl_event.cbutton.timestamp);
 						input::game_controller_button button = input::sdl_button_table[sdl_event.cbutton.button];
 						it->second->press(button);
 					}
@@ -579,6 +847,7 @@ void application::translate_sdl_events()
 				{
 					if (auto it = game_controller_map.find(sdl_event.cdevice.which); it != game_controller_map.end())
 					{
+						stamp_input(sdl_event.cbutton.timestamp);
 						input::game_controller_button button = input::sdl_button_table[sdl_event.cbutton.button];
 						it->second->release(button);
 					}
@@ -592,6 +861,7 @@ void application::translate_sdl_events()
 				{
 					if (auto it = game_controller_map.find(sdl_event.cdevice.which); it != game_controller_map.end())
 					{
+						stamp_input(sdl_event.caxis.timestamp);
 						input::game_controller_axis axis = input::sdl_axis_table[sdl_event.caxis.axis];
 						float value = sdl_event.caxis.value;
 						value /= (value < 0.0f) ? 32768.0f : 32767.0f;
@@ -657,6 +927,9 @@ void application::translate_sdl_events()
 
 			case SDL_WINDOWEVENT:
 			{
+				// Window contents may have been exposed, resized, or lost
+				request_redraw();
+				
 				if (sdl_event.window.event == SDL_WINDOWEVENT_RESIZED)
 				{
 					window_resized();
@@ -674,6 +947,33 @@ void application::translate_sdl_events()
 	}
 }
 
+void application::delay_frame()
+{
+	// Leave a margin for scheduling jitter and sleep overshoot
+	const double margin = 0.002;
+	
+	const double delay = refresh_period - frame_work_duration - margin;
+	if (delay > 0.0)
+	{
+		const auto wake_time = swap_time + std::chrono::duration_cast<std::chrono::high_resolution_clock::duration>(std::chrono::duration<double>(delay));
+		if (wake_time > std::chrono::high_resolution_clock::now())
+			std::this_thread::sleep_until(wake_time);
+	}
+}
+
+void application::wait_idle()
+{
+	// Wait no longer than one idle update period, so that updates continue even while time is stopped
+	const double timeout = std::min(frame_scheduler->get_time_until_update(), 1.0 / idle_update_rate);
+	const int timeout_ms = static_cast<int>(std::ceil(timeout * 1000.0));
+	if (timeout_ms <= 0)
+		return;
+	
+	// Translate arrived events immediately, so that the next wait blocks again. Their input is dispatched by the next update, which redraws the frame.
+	if (SDL_WaitEventTimeout(nullptr, timeout_ms))
+		translate_sdl_events();
+}
+
 void application::window_resized()
 {
 	// Update window size and viewport size
@@ -21,6 +21,8 @@
 #define ANTKEEPER_APPLICATION_HPP
 
 #include <array>
+#include <atomic>
+#include <chrono>
 #include <functional>
 #include <list>
 #include <memory>
@@ -36,9 +38,12 @@ typedef void* SDL_GLContext;
 class event_dispatcher;
 class frame_scheduler;
 class image;
+class job_system;
 
 namespace debug
 {
+	class frame_recorder;
+	class input_recorder;
 	class logger;
 	class performance_sampler;
 }
@@ -62,6 +67,22 @@ public:
 		std::function<void()> exit;
 	};
 	
+	/// Channels of frame timing statistics.
+	enum class timing_channel
+	{
+		/// Duration between the starts of consecutive frames.
+		frame,
+		
+		/// Duration of each update, including event translation and dispatch.
+		update,
+		
+		/// Duration of the render callback.
+		render,
+		
+		/// Duration of the buffer swap, including the frame throttling wait.
+		swap
+	};
+	
 	typedef std::function<int(application*)> bootloader_type;
 	typedef std::function<void(double, double)> update_callback_type;
 	typedef std::function<void(double)> render_callback_type;
@@ -114,7 +135,7 @@ public:
 	std::shared_ptr<image> capture_frame() const;
 	
 	/**
-	 * Saves a PNG screenshot of the most recently rendered frame.
+	 * Saves a PNG screenshot of the next rendered frame, which is read back and encoded asynchronously by the frame recorder.
 	 *
 	 * @param path File path to the where the screenshot should be saved.
 	 */
@@ -182,6 +203,44 @@ public:
 	 */
 	void set_vsync(bool vsync);
 	
+	/**
+	 * Enables or disables low-latency mode. In low-latency mode, each frame is delayed after the previous swap so that input is sampled as late as possible while still rendering before the next v-sync. Has no effect while v-sync is disabled, and is most effective with frame throttling enabled.
+	 *
+	 * @param enabled `true` if low-latency mode should be enabled, `false` otherwise.
+	 */
+	void set_low_latency(bool enabled);
+	
+	/**
+	 * Enables or disables frame throttling, in which the CPU waits for the GPU to finish each frame after swapping buffers, so that no frames are queued ahead of the display.
+	 *
+	 * @param enabled `true` if frames should be throttled, `false` otherwise.
+	 */
+	void set_frame_throttling(bool enabled);
+	
+	/**
+	 * Enables or disables idle mode, which should be enabled by menus and paused states. In idle mode, frames are only rendered once a redraw has been requested, updates are performed at the idle update rate, and the execution loop blocks waiting for events between updates, so that the CPU and GPU are mostly idle while nothing on screen changes.
+	 *
+	 * @param idle `true` if idle mode should be enabled, `false` otherwise.
+	 *
+	 * @see application::request_redraw()
+	 */
+	void set_idle(bool idle);
+	
+	/**
+	 * Sets the frequency with which the update callback should be called in idle mode.
+	 *
+	 * @param frequency Number of times per second the update callback should be called in idle mode.
+	 */
+	void set_idle_update_rate(double frequency);
+	
+	/**
+	 * Requests that the next frame be rendered in idle mode. Input and window events, state changes, and running animations request redraws automatically; systems and UI which otherwise change what is on screen should request them as well. May be called from any thread.
+	 */
+	void request_redraw();
+	
+	/// Returns `true` if idle mode is enabled, `false` otherwise.
+	bool is_idle() const;
+	
 	void set_window_opacity(float opacity);
 	
 	void swap_buffers();
@@ -215,6 +274,37 @@ public:
 	
 	/// Returns the application's event dispatcher.
 	event_dispatcher* get_event_dispatcher();
+	
+	/// Returns the job system shared by all subsystems.
+	job_system* get_job_system();
+	
+	/// Returns the frame recorder, which captures screenshots and recordings of rendered frames.
+	debug::frame_recorder* get_frame_recorder();
+	
+	/// Returns the input recorder, which records input events per update and replays them, during which live input is ignored.
+	debug::input_recorder* get_input_recorder();
+	
+	/**
+	 * Returns the sampler of a frame timing channel.
+	 *
+	 * @param channel Frame timing channel.
+	 */
+	const debug::performance_sampler* get_timing_sampler(timing_channel channel) const;
+	
+	/// Returns the name of a frame timing channel.
+	static const char* get_timing_channel_name(timing_channel channel);
+	
+	/// Resets the samplers of all frame timing channels and of input latency.
+	void reset_timing_samplers();
+	
+	/// Returns the CPU time taken by the most recently rendered frame, from the start of its first update to the start of its swap, excluding time spent waiting between updates, in seconds.
+	double get_cpu_frame_duration() const;
+	
+	/// Returns the frame scheduler which schedules update and render callbacks.
+	::frame_scheduler* get_frame_scheduler();
+	
+	/// Returns the sampler of input-to-swap latencies, measured from the time the earliest input event consumed by a frame entered the SDL event queue to the time that frame was swapped.
+	const debug::performance_sampler* get_input_latency_sampler() const;
 
 private:
 	void update(double t, double dt);
@@ -223,6 +313,12 @@ private:
 	void translate_sdl_events();
 	void window_resized();
 	
+	/// Sleeps until the latest time at which the next frame can start and still be swapped before the next v-sync.
+	void delay_frame();
+	
+	/// Blocks until an event arrives or the next update is due, then translates any arrived events.
+	void wait_idle();
+	
 	bool closed;
 	int exit_status;
 	application::state current_state;
@@ -247,6 +343,49 @@ private:
 	// Frame timing
 	frame_scheduler* frame_scheduler;
 	debug::performance_sampler* performance_sampler;
+	debug::performance_sampler* update_sampler;
+	debug::performance_sampler* render_sampler;
+	debug::performance_sampler* swap_sampler;
+	bool low_latency;
+	bool frame_throttling;
+	
+	/// Refresh period of the display, in seconds.
+	double refresh_period;
+	
+	/// CPU time taken by the updates of the current frame, and by the most recently rendered frame, in seconds.
+	double cpu_update_duration;
+	double cpu_frame_duration;
+	
+	/// Decaying peak duration of a frame from its start to the end of its swap, in seconds.
+	double frame_work_duration;
+	
+	/// `true` if the most recent frame was rendered and swapped, `false` if it was skipped in idle mode.
+	bool frame_rendered;
+	
+	// Idle mode
+	bool idle;
+	double idle_update_rate;
+	std::atomic<bool> redraw_requested;
+	
+	/// `true` if input was translated since the last update, so that the frame following its dispatch is redrawn.
+	bool input_translated;
+	
+	/// Time at which the most recent swap finished.
+	std::chrono::high_resolution_clock::time_point swap_time;
+	
+	// Input latency
+	debug::performance_sampler* input_latency_sampler;
+	std::chrono::high_resolution_clock::time_point input_time;
+	bool input_pending;
+	
+	// Jobs
+	job_system* job_system;
+	
+	// Frame capture
+	debug::frame_recorder* frame_recorder;
+	
+	// Input recording and replay
+	debug::input_recorder* input_recorder;
 	
 	// Events
 	event_dispatcher* event_dispatcher;
@@ -283,6 +422,16 @@ inline bool application::is_fullscreen() const
 	return fullscreen;
 }
 
+inline bool application::is_idle() const
+{
+	return idle;
+}
+
+inline double application::get_cpu_frame_duration() const
+{
+	return cpu_frame_duration;
+}
+
 inline gl::rasterizer* application::get_rasterizer()
 {
 	return rasterizer;
@@ -308,4 +457,29 @@ inline event_dispatcher* application::get_event_dispatcher()
 	return event_dispatcher;
 }
 
+inline job_system* application::get_job_system()
+{
+	return job_system;
+}
+
+inline debug::frame_recorder* application::get_frame_recorder()
+{
+	return frame_recorder;
+}
+
+inline debug::input_recorder* application::get_input_recorder()
+{
+	return input_recorder;
+}
+
+inline ::frame_scheduler* application::get_frame_scheduler()
+{
+	return frame_scheduler;
+}
+
+inline const debug::performance_sampler* application::get_input_latency_sampler() const
+{
+	return input_latency_sampler;
+}
+
 #endif // ANTKEEPER_APPLICATION_HPP
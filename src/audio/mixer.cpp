@@ -0,0 +1,526 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "audio/mixer.hpp"
+#include "audio/sound-wave.hpp"
+#include "math/math.hpp"
+#include <AL/al.h>
+#include <AL/alc.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <stdexcept>
+
+namespace audio {
+
+namespace {
+
+/// Interval between mixes, a small fraction of the duration of a voice's buffer queue.
+constexpr std::chrono::milliseconds mix_period(5);
+
+/// Factor by which the rank of sounds which already have voices is raised, so that sounds of similar rank don't trade voices every mix.
+constexpr float voice_hysteresis = 1.25f;
+
+} // namespace
+
+struct mixer::device
+{
+	ALCdevice* device;
+	ALCcontext* context;
+};
+
+mixer::mixer(std::size_t voice_count):
+	output(new device{nullptr, nullptr}),
+	pcm(buffer_frame_count * 2),
+	listener_position{0, 0, 0},
+	next_sound(1),
+	stopping(false),
+	sound_count(0),
+	audible_count(0),
+	underrun_count(0)
+{
+	// Open default audio device
+	output->device = alcOpenDevice(nullptr);
+	if (!output->device)
+		throw std::runtime_error("Failed to open audio device.");
+	
+	// Create audio context, which is current for the whole process and thereby for the mixer thread
+	output->context = alcCreateContext(output->device, nullptr);
+	if (!output->context || !alcMakeContextCurrent(output->context))
+	{
+		if (output->context)
+			alcDestroyContext(output->context);
+		alcCloseDevice(output->device);
+		throw std::runtime_error("Failed to create audio context.");
+	}
+	
+	alDistanceModel(AL_INVERSE_DISTANCE_CLAMPED);
+	
+	// Allocate voices, stopping short if the device supports fewer sources
+	voices.resize(voice_count);
+	std::size_t allocated_count = 0;
+	for (voice& voice: voices)
+	{
+		alGetError();
+		alGenSources(1, &voice.source);
+		if (alGetError() != AL_NO_ERROR)
+			break;
+		
+		alGenBuffers(static_cast<ALsizei>(buffer_count), voice.buffers.data());
+		if (alGetError() != AL_NO_ERROR)
+		{
+			alDeleteSources(1, &voice.source);
+			break;
+		}
+		
+		voice.queued_count = 0;
+		voice.sound = 0;
+		voice.draining = false;
+		++allocated_count;
+	}
+	voices.resize(allocated_count);
+	
+	if (voices.empty())
+	{
+		alcMakeContextCurrent(nullptr);
+		alcDestroyContext(output->context);
+		alcCloseDevice(output->device);
+		throw std::runtime_error("Failed to allocate audio voices.");
+	}
+	
+	thread = std::thread(&mixer::run, this);
+}
+
+mixer::~mixer()
+{
+	// Stop mixer thread
+	{
+		std::lock_guard<std::mutex> lock(command_mutex);
+		stopping = true;
+	}
+	wake_condition.notify_one();
+	thread.join();
+	
+	// Free voices
+	for (voice& voice: voices)
+	{
+		alSourceStop(voice.source);
+		alSourcei(voice.source, AL_BUFFER, 0);
+		alDeleteSources(1, &voice.source);
+		alDeleteBuffers(static_cast<ALsizei>(buffer_count), voice.buffers.data());
+	}
+	voices.clear();
+	
+	// Close audio device
+	alcMakeContextCurrent(nullptr);
+	alcDestroyContext(output->context);
+	alcCloseDevice(output->device);
+}
+
+sound_id mixer::play(const sound_wave* wave, const sound_parameters& parameters)
+{
+	const sound_id id = next_sound++;
+	
+	// Skip the null handle when handles wrap around
+	if (!next_sound)
+		next_sound = 1;
+	
+	recorded_commands.push_back({command::command_type::play, id, wave, parameters, {1, 0, 0, 0}});
+	
+	return id;
+}
+
+void mixer::update(sound_id sound, const sound_parameters& parameters)
+{
+	recorded_commands.push_back({command::command_type::update, sound, nullptr, parameters, {1, 0, 0, 0}});
+}
+
+void mixer::stop(sound_id sound)
+{
+	recorded_commands.push_back({command::command_type::stop, sound, nullptr, {}, {1, 0, 0, 0}});
+}
+
+void mixer::set_listener(const float3& position, const math::quaternion<float>& rotation)
+{
+	sound_parameters parameters = {};
+	parameters.position = position;
+	recorded_commands.push_back({command::command_type::listener, 0, nullptr, parameters, rotation});
+}
+
+void mixer::set_gain(float gain)
+{
+	sound_parameters parameters = {};
+	parameters.gain = gain;
+	recorded_commands.push_back({command::command_type::gain, 0, nullptr, parameters, {1, 0, 0, 0}});
+}
+
+void mixer::commit()
+{
+	if (recorded_commands.empty())
+		return;
+	
+	std::lock_guard<std::mutex> lock(command_mutex);
+	pending_commands.insert(pending_commands.end(), recorded_commands.begin(), recorded_commands.end());
+	recorded_commands.clear();
+}
+
+void mixer::run()
+{
+	auto last_mix_time = std::chrono::steady_clock::now();
+	
+	std::unique_lock<std::mutex> lock(command_mutex);
+	while (!stopping)
+	{
+		// Mix at a fixed period, independent of the frame loop
+		wake_condition.wait_for(lock, mix_period, [this]{return stopping;});
+		if (stopping)
+			break;
+		
+		// Take the commands published since the last mix, leaving the emptied vector to collect the next batch
+		executing_commands.swap(pending_commands);
+		lock.unlock();
+		
+		const auto mix_time = std::chrono::steady_clock::now();
+		mix(std::chrono::duration<double>(mix_time - last_mix_time).count());
+		last_mix_time = mix_time;
+		executing_commands.clear();
+		
+		lock.lock();
+	}
+}
+
+void mixer::mix(double dt)
+{
+	execute(executing_commands);
+	
+	// Refill the buffer queues of voices, freeing those whose sounds have finished
+	for (voice& voice: voices)
+	{
+		if (!voice.sound)
+			continue;
+		
+		auto it = sounds.find(voice.sound);
+		if (!service(voice, it->second))
+		{
+			unbind(voice);
+			sounds.erase(it);
+		}
+	}
+	
+	// Advance the playback position of virtual sounds, removing those which have finished
+	for (auto it = sounds.begin(); it != sounds.end();)
+	{
+		sound& sound = it->second;
+		if (sound.voice < 0)
+		{
+			const double frame_count = static_cast<double>(sound.wave->get_frame_count());
+			sound.cursor += dt * sound.wave->get_sample_rate() * sound.parameters.pitch;
+			if (sound.cursor >= frame_count)
+			{
+				if (!sound.parameters.looping || frame_count <= 0.0)
+				{
+					it = sounds.erase(it);
+					continue;
+				}
+				sound.cursor = std::fmod(sound.cursor, frame_count);
+			}
+		}
+		++it;
+	}
+	
+	assign_voices();
+	
+	// Update the source parameters of voices
+	std::size_t audible = 0;
+	for (voice& voice: voices)
+	{
+		if (voice.sound)
+		{
+			apply_parameters(voice, sounds.find(voice.sound)->second);
+			++audible;
+		}
+	}
+	
+	sound_count.store(sounds.size(), std::memory_order_relaxed);
+	audible_count.store(audible, std::memory_order_relaxed);
+}
+
+void mixer::execute(const std::vector<command>& commands)
+{
+	for (const command& command: commands)
+	{
+		switch (command.type)
+		{
+			case command::command_type::play:
+				if (command.wave)
+					sounds[command.sound] = {command.wave, command.parameters, 0.0, -1, 0.0f};
+				break;
+			
+			case command::command_type::update:
+				if (auto it = sounds.find(command.sound); it != sounds.end())
+					it->second.parameters = command.parameters;
+				break;
+			
+			case command::command_type::stop:
+				if (auto it = sounds.find(command.sound); it != sounds.end())
+				{
+					if (it->second.voice >= 0)
+						unbind(voices[it->second.voice]);
+					sounds.erase(it);
+				}
+				break;
+			
+			case command::command_type::listener:
+			{
+				listener_position = command.parameters.position;
+				const float3 forward = command.rotation * float3{0, 0, -1};
+				const float3 up = command.rotation * float3{0, 1, 0};
+				const float orientation[6] = {forward.x, forward.y, forward.z, up.x, up.y, up.z};
+				alListenerfv(AL_POSITION, listener_position.data());
+				alListenerfv(AL_ORIENTATION, orientation);
+				break;
+			}
+			
+			case command::command_type::gain:
+				alListenerf(AL_GAIN, command.parameters.gain);
+				break;
+		}
+	}
+}
+
+void mixer::assign_voices()
+{
+	// Rank audible sounds by their priority times their audibility at the listener
+	ranking.clear();
+	for (auto& [id, sound]: sounds)
+	{
+		const sound_parameters& parameters = sound.parameters;
+		
+		float audibility = parameters.gain;
+		if (parameters.spatial)
+		{
+			// Attenuate according to the inverse distance clamped model, culling sounds beyond their max distance
+			const float distance = math::length(parameters.position - listener_position);
+			if (distance >= parameters.max_distance)
+				audibility = 0.0f;
+			else
+				audibility *= parameters.reference_distance / std::max(distance, parameters.reference_distance);
+		}
+		
+		sound.score = audibility * parameters.priority;
+		if (sound.voice >= 0)
+			sound.score *= voice_hysteresis;
+		
+		if (sound.score > 0.0f)
+			ranking.emplace_back(id, &sound);
+	}
+	
+	// Move the highest ranked sounds to the front, and unrank the rest
+	const std::size_t audible_count = std::min(ranking.size(), voices.size());
+	if (audible_count < ranking.size())
+	{
+		std::nth_element(ranking.begin(), ranking.begin() + audible_count, ranking.end(),
+			[](const auto& a, const auto& b)
+			{
+				return a.second->score > b.second->score;
+			});
+		
+		for (std::size_t i = audible_count; i < ranking.size(); ++i)
+			ranking[i].second->score = 0.0f;
+	}
+	
+	// Free the voices of unranked sounds, which continue virtually
+	for (voice& voice: voices)
+	{
+		if (!voice.sound)
+			continue;
+		
+		sound& sound = sounds.find(voice.sound)->second;
+		if (sound.score <= 0.0f)
+		{
+			sound.cursor = unbind(voice);
+			sound.voice = -1;
+		}
+	}
+	
+	// Give free voices to ranked sounds without one
+	std::size_t free_index = 0;
+	for (std::size_t i = 0; i < audible_count; ++i)
+	{
+		auto& [id, sound] = ranking[i];
+		if (sound->voice >= 0)
+			continue;
+		
+		while (voices[free_index].sound)
+			++free_index;
+		bind(free_index, id, *sound);
+	}
+}
+
+void mixer::bind(std::size_t index, sound_id id, sound& sound)
+{
+	voice& voice = voices[index];
+	
+	// Reuse the voice's stream if it decodes the same sound wave
+	if (!voice.stream || &voice.stream->get_wave() != sound.wave)
+	{
+		try
+		{
+			voice.stream = std::make_unique<sound_stream>(*sound.wave);
+		}
+		catch (const std::exception&)
+		{
+			// Leave undecodable sounds to play out virtually
+			voice.stream.reset();
+			sound.parameters.priority = 0.0f;
+			return;
+		}
+	}
+	
+	if (!voice.stream->seek(static_cast<std::uint64_t>(sound.cursor)))
+		voice.stream->seek(0);
+	
+	voice.sound = id;
+	voice.queued_count = 0;
+	voice.draining = false;
+	sound.voice = static_cast<int>(index);
+	
+	// Fill buffer queue and start playback
+	for (ALuint buffer: voice.buffers)
+	{
+		if (!queue(voice, sound, buffer))
+			break;
+	}
+	apply_parameters(voice, sound);
+	alSourcePlay(voice.source);
+}
+
+double mixer::unbind(voice& voice)
+{
+	// Recover the playback position from the start frame of the oldest queued buffer
+	double cursor = static_cast<double>(voice.stream->get_cursor());
+	if (voice.queued_count)
+	{
+		ALint offset = 0;
+		alGetSourcei(voice.source, AL_SAMPLE_OFFSET, &offset);
+		cursor = static_cast<double>(voice.buffer_frames[0] + static_cast<std::uint64_t>(std::max<ALint>(offset, 0)));
+	}
+	
+	// Stop the source and detach its buffer queue
+	alSourceStop(voice.source);
+	alSourcei(voice.source, AL_BUFFER, 0);
+	
+	voice.sound = 0;
+	voice.queued_count = 0;
+	voice.draining = false;
+	
+	return cursor;
+}
+
+bool mixer::queue(voice& voice, const sound& sound, unsigned int buffer)
+{
+	const std::uint32_t channel_count = sound.wave->get_channel_count();
+	
+	// Decode the next chunk, wrapping around to the start of looping sounds so that no buffer spans the loop point
+	std::uint64_t start_frame = voice.stream->get_cursor();
+	std::size_t frame_count = voice.stream->read(pcm.data(), buffer_frame_count);
+	if (!frame_count && sound.parameters.looping && voice.stream->seek(0))
+	{
+		start_frame = 0;
+		frame_count = voice.stream->read(pcm.data(), buffer_frame_count);
+	}
+	
+	if (!frame_count)
+	{
+		voice.draining = true;
+		return false;
+	}
+	
+	alBufferData
+	(
+		buffer,
+		(channel_count == 2) ? AL_FORMAT_STEREO16 : AL_FORMAT_MONO16,
+		pcm.data(),
+		static_cast<ALsizei>(frame_count * channel_count * sizeof(std::int16_t)),
+		static_cast<ALsizei>(sound.wave->get_sample_rate())
+	);
+	alSourceQueueBuffers(voice.source, 1, &buffer);
+	voice.buffer_frames[voice.queued_count++] = start_frame;
+	
+	return true;
+}
+
+bool mixer::service(voice& voice, const sound& sound)
+{
+	// Unqueue played buffers and refill them with the next chunks
+	ALint processed_count = 0;
+	alGetSourcei(voice.source, AL_BUFFERS_PROCESSED, &processed_count);
+	for (; processed_count > 0; --processed_count)
+	{
+		ALuint buffer;
+		alSourceUnqueueBuffers(voice.source, 1, &buffer);
+		std::move(voice.buffer_frames.begin() + 1, voice.buffer_frames.begin() + voice.queued_count, voice.buffer_frames.begin());
+		--voice.queued_count;
+		
+		if (!voice.draining)
+			queue(voice, sound, buffer);
+	}
+	
+	ALint state;
+	alGetSourcei(voice.source, AL_SOURCE_STATE, &state);
+	if (state != AL_PLAYING)
+	{
+		// Sound has finished once its queue has played out
+		if (!voice.queued_count)
+			return false;
+		
+		// Queue ran dry before it could be refilled, so the source stopped on its own
+		alSourcePlay(voice.source);
+		underrun_count.fetch_add(1, std::memory_order_relaxed);
+	}
+	
+	return true;
+}
+
+void mixer::apply_parameters(voice& voice, const sound& sound) const
+{
+	const sound_parameters& parameters = sound.parameters;
+	
+	alSourcef(voice.source, AL_GAIN, parameters.gain);
+	alSourcef(voice.source, AL_PITCH, parameters.pitch);
+	
+	if (parameters.spatial)
+	{
+		alSourcei(voice.source, AL_SOURCE_RELATIVE, AL_FALSE);
+		alSourcefv(voice.source, AL_POSITION, parameters.position.data());
+		alSourcef(voice.source, AL_REFERENCE_DISTANCE, parameters.reference_distance);
+		alSourcef(voice.source, AL_MAX_DISTANCE, parameters.max_distance);
+		alSourcef(voice.source, AL_ROLLOFF_FACTOR, 1.0f);
+	}
+	else
+	{
+		// Play non-spatial sounds at the listener, without attenuation
+		const float origin[3] = {0.0f, 0.0f, 0.0f};
+		alSourcei(voice.source, AL_SOURCE_RELATIVE, AL_TRUE);
+		alSourcefv(voice.source, AL_POSITION, origin);
+		alSourcef(voice.source, AL_ROLLOFF_FACTOR, 0.0f);
+	}
+}
+
+} // namespace audio
@@ -0,0 +1,269 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ANTKEEPER_AUDIO_MIXER_HPP
+#define ANTKEEPER_AUDIO_MIXER_HPP
+
+#include "audio/sound-stream.hpp"
+#include "math/quaternion-type.hpp"
+#include "utility/fundamental-types.hpp"
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace audio {
+
+class sound_wave;
+
+/// Handle of a sound played by a mixer, where `0` is never a valid handle.
+typedef std::uint32_t sound_id;
+
+/// Playback parameters of a sound.
+struct sound_parameters
+{
+	/// Position of a spatial sound.
+	float3 position;
+	
+	/// Linear gain.
+	float gain;
+	
+	/// Playback rate multiplier.
+	float pitch;
+	
+	/// Importance of the sound when sounds compete for voices.
+	float priority;
+	
+	/// Distance within which a spatial sound is not attenuated.
+	float reference_distance;
+	
+	/// Distance beyond which a spatial sound is culled.
+	float max_distance;
+	
+	/// `true` if the sound is positioned in the world, `false` if it plays at the listener.
+	bool spatial;
+	
+	/// `true` if the sound repeats until stopped.
+	bool looping;
+};
+
+/**
+ * Plays sounds on a pool of OpenAL voices from a thread of its own.
+ *
+ * Sounds are decoded in small chunks into the buffer queue of their voice, which holds enough audio to carry playback through frame loop hitches. Every sound is ranked by its priority times its audibility at the listener, and only the highest ranked sounds are given voices. The others play virtually, advancing their playback position without decoding, and resume from it if they regain a voice.
+ *
+ * Commands are recorded by a single control thread and published to the mixer thread in batches by commit().
+ */
+class mixer
+{
+public:
+	/**
+	 * Opens the default audio device and starts the mixer thread.
+	 *
+	 * @param voice_count Maximum number of sounds heard at once.
+	 *
+	 * @exception std::runtime_error The audio device could not be opened, or the voices could not be allocated.
+	 */
+	explicit mixer(std::size_t voice_count = 32);
+	
+	/// Stops the mixer thread and closes the audio device.
+	~mixer();
+	
+	mixer(const mixer&) = delete;
+	mixer& operator=(const mixer&) = delete;
+	
+	/**
+	 * Starts playing a sound.
+	 *
+	 * @param wave Sound wave to play, which must outlive playback.
+	 * @param parameters Initial playback parameters.
+	 * @return Handle of the sound.
+	 */
+	sound_id play(const sound_wave* wave, const sound_parameters& parameters);
+	
+	/// Changes the playback parameters of a sound. Sounds which have finished are ignored.
+	void update(sound_id sound, const sound_parameters& parameters);
+	
+	/// Stops a sound. Sounds which have finished are ignored.
+	void stop(sound_id sound);
+	
+	/**
+	 * Moves the listener.
+	 *
+	 * @param position Position of the listener.
+	 * @param rotation Orientation of the listener, which faces along its negative z-axis.
+	 */
+	void set_listener(const float3& position, const math::quaternion<float>& rotation);
+	
+	/// Sets the linear gain applied to every sound.
+	void set_gain(float gain);
+	
+	/// Publishes the commands recorded since the last commit to the mixer thread.
+	void commit();
+	
+	/// Returns the number of voices.
+	std::size_t get_voice_count() const;
+	
+	/// Returns the number of sounds playing, both on voices and virtually, as of the most recent mix.
+	std::size_t get_sound_count() const;
+	
+	/// Returns the number of sounds playing on voices as of the most recent mix.
+	std::size_t get_audible_count() const;
+	
+	/// Returns the number of times a voice exhausted its buffer queue and had to be restarted.
+	std::size_t get_underrun_count() const;
+
+private:
+	struct device;
+	
+	struct command
+	{
+		enum class command_type
+		{
+			play,
+			update,
+			stop,
+			listener,
+			gain
+		};
+		
+		command_type type;
+		sound_id sound;
+		const sound_wave* wave;
+		sound_parameters parameters;
+		math::quaternion<float> rotation;
+	};
+	
+	struct sound
+	{
+		const sound_wave* wave;
+		sound_parameters parameters;
+		
+		/// Playback position of a virtual sound, in frames.
+		double cursor;
+		
+		/// Index of the voice on which the sound plays, or `-1` if it plays virtually.
+		int voice;
+		
+		float score;
+	};
+	
+	/// Number of buffers in the queue of each voice.
+	static constexpr std::size_t buffer_count = 4;
+	
+	/// Number of frames decoded into each buffer.
+	static constexpr std::size_t buffer_frame_count = 4096;
+	
+	struct voice
+	{
+		unsigned int source;
+		std::array<unsigned int, buffer_count> buffers;
+		
+		/// Start frames of the queued buffers, oldest first, from which the playback position is recovered.
+		std::array<std::uint64_t, buffer_count> buffer_frames;
+		std::size_t queued_count;
+		
+		std::unique_ptr<sound_stream> stream;
+		sound_id sound;
+		
+		/// `true` once a non-looping sound has been decoded to its end.
+		bool draining;
+	};
+	
+	/// Mixer thread loop.
+	void run();
+	
+	/// Applies commands, ranks sounds and services voices.
+	void mix(double dt);
+	
+	/// Applies a batch of commands published by commit().
+	void execute(const std::vector<command>& commands);
+	
+	/// Gives voices to the highest ranked sounds.
+	void assign_voices();
+	
+	/// Starts playing a sound on a free voice, from its playback position.
+	void bind(std::size_t index, sound_id id, sound& sound);
+	
+	/// Stops a voice and frees it, returning the playback position of its sound.
+	double unbind(voice& voice);
+	
+	/// Decodes the next chunk of a voice's sound into a buffer and queues it, returning `false` if the sound has ended.
+	bool queue(voice& voice, const sound& sound, unsigned int buffer);
+	
+	/// Refills the processed buffers of a voice and restarts it after an underrun, returning `false` once its sound has finished.
+	bool service(voice& voice, const sound& sound);
+	
+	/// Sets the source parameters of a voice.
+	void apply_parameters(voice& voice, const sound& sound) const;
+	
+	std::unique_ptr<device> output;
+	std::vector<voice> voices;
+	
+	// Mixer thread state
+	std::unordered_map<sound_id, sound> sounds;
+	std::vector<command> executing_commands;
+	std::vector<std::pair<sound_id, sound*>> ranking;
+	std::vector<std::int16_t> pcm;
+	float3 listener_position;
+	
+	// Control thread state
+	std::vector<command> recorded_commands;
+	sound_id next_sound;
+	
+	// Shared state
+	std::mutex command_mutex;
+	std::condition_variable wake_condition;
+	std::vector<command> pending_commands;
+	bool stopping;
+	std::atomic<std::size_t> sound_count;
+	std::atomic<std::size_t> audible_count;
+	std::atomic<std::size_t> underrun_count;
+	std::thread thread;
+};
+
+inline std::size_t mixer::get_voice_count() const
+{
+	return voices.size();
+}
+
+inline std::size_t mixer::get_sound_count() const
+{
+	return sound_count.load(std::memory_order_relaxed);
+}
+
+inline std::size_t mixer::get_audible_count() const
+{
+	return audible_count.load(std::memory_order_relaxed);
+}
+
+inline std::size_t mixer::get_underrun_count() const
+{
+	return underrun_count.load(std::memory_order_relaxed);
+}
+
+} // namespace audio
+
+#endif // ANTKEEPER_AUDIO_MIXER_HPP
@@ -0,0 +1,65 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "audio/sound-stream.hpp"
+#include "audio/sound-wave.hpp"
+#include <stdexcept>
+#include <dr_wav.h>
+
+namespace audio {
+
+struct sound_stream::decoder
+{
+	drwav wav;
+};
+
+sound_stream::sound_stream(const sound_wave& wave):
+	wave(wave),
+	state(new decoder()),
+	cursor(0)
+{
+	if (!drwav_init_memory(&state->wav, wave.get_data().data(), wave.get_data().size(), nullptr))
+		throw std::runtime_error("Failed to decode sound wave.");
+}
+
+sound_stream::~sound_stream()
+{
+	drwav_uninit(&state->wav);
+}
+
+bool sound_stream::seek(std::uint64_t frame)
+{
+	if (frame == cursor)
+		return true;
+	
+	if (!drwav_seek_to_pcm_frame(&state->wav, frame))
+		return false;
+	
+	cursor = frame;
+	return true;
+}
+
+std::size_t sound_stream::read(std::int16_t* pcm, std::size_t frame_count)
+{
+	const std::size_t read_count = static_cast<std::size_t>(drwav_read_pcm_frames_s16(&state->wav, frame_count, pcm));
+	cursor += read_count;
+	return read_count;
+}
+
+} // namespace audio
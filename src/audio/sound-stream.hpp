@@ -0,0 +1,94 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ANTKEEPER_AUDIO_SOUND_STREAM_HPP
+#define ANTKEEPER_AUDIO_SOUND_STREAM_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace audio {
+
+class sound_wave;
+
+/**
+ * Decodes a sound wave into 16-bit PCM in chunks, keeping only the decoder state between reads.
+ */
+class sound_stream
+{
+public:
+	/**
+	 * Opens a stream of a sound wave.
+	 *
+	 * @param wave Sound wave to decode, which must outlive the stream.
+	 *
+	 * @exception std::runtime_error The sound wave could not be decoded.
+	 */
+	explicit sound_stream(const sound_wave& wave);
+	
+	~sound_stream();
+	
+	sound_stream(const sound_stream&) = delete;
+	sound_stream& operator=(const sound_stream&) = delete;
+	
+	/**
+	 * Moves the stream to a frame.
+	 *
+	 * @param frame Index of the frame to read next.
+	 * @return `true` if the stream was moved, `false` otherwise.
+	 */
+	bool seek(std::uint64_t frame);
+	
+	/**
+	 * Decodes frames at the cursor and advances it.
+	 *
+	 * @param[out] pcm Interleaved samples of the decoded frames.
+	 * @param frame_count Maximum number of frames to decode.
+	 * @return Number of frames decoded, which is less than @p frame_count only at the end of the sound.
+	 */
+	std::size_t read(std::int16_t* pcm, std::size_t frame_count);
+	
+	/// Returns the index of the frame to be read next.
+	std::uint64_t get_cursor() const;
+	
+	/// Returns the sound wave being decoded.
+	const sound_wave& get_wave() const;
+
+private:
+	struct decoder;
+	
+	const sound_wave& wave;
+	std::unique_ptr<decoder> state;
+	std::uint64_t cursor;
+};
+
+inline std::uint64_t sound_stream::get_cursor() const
+{
+	return cursor;
+}
+
+inline const sound_wave& sound_stream::get_wave() const
+{
+	return wave;
+}
+
+} // namespace audio
+
+#endif // ANTKEEPER_AUDIO_SOUND_STREAM_HPP
@@ -0,0 +1,48 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "audio/sound-wave.hpp"
+#include <stdexcept>
+#include <string>
+
+// Compile the WAV decoder into this translation unit only
+#define DR_WAV_IMPLEMENTATION
+#include <dr_wav.h>
+
+namespace audio {
+
+sound_wave::sound_wave(const std::uint8_t* data, std::size_t size):
+	data(data, data + size)
+{
+	// Read the format from the WAV header
+	drwav wav;
+	if (!drwav_init_memory(&wav, this->data.data(), this->data.size(), nullptr))
+		throw std::runtime_error("Sound data is not a valid WAV file.");
+	channel_count = wav.channels;
+	sample_rate = wav.sampleRate;
+	frame_count = wav.totalPCMFrameCount;
+	drwav_uninit(&wav);
+	
+	if (channel_count != 1 && channel_count != 2)
+		throw std::runtime_error("Sound data has " + std::to_string(channel_count) + " channels, but only mono and stereo sounds are supported.");
+	if (!sample_rate)
+		throw std::runtime_error("Sound data has a sample rate of zero.");
+}
+
+} // namespace audio
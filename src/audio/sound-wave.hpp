@@ -0,0 +1,118 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ANTKEEPER_AUDIO_SOUND_WAVE_HPP
+#define ANTKEEPER_AUDIO_SOUND_WAVE_HPP
+
+#include "resources/resource-loader.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/// Audio playback.
+namespace audio {
+
+/**
+ * Encoded contents of a WAV file, which are decoded in chunks as they're played rather than all at once.
+ *
+ * @see audio::sound_stream
+ */
+class sound_wave
+{
+public:
+	/**
+	 * Creates a sound wave from WAV file data.
+	 *
+	 * @param data Contents of a WAV file, which are copied.
+	 * @param size Size of the WAV file, in bytes.
+	 *
+	 * @exception std::runtime_error The data is not a valid mono or stereo WAV file.
+	 */
+	sound_wave(const std::uint8_t* data, std::size_t size);
+	
+	/// Returns the contents of the WAV file.
+	const std::vector<std::uint8_t>& get_data() const;
+	
+	/// Returns the number of channels, which is either `1` or `2`.
+	std::uint32_t get_channel_count() const;
+	
+	/// Returns the number of frames per second.
+	std::uint32_t get_sample_rate() const;
+	
+	/// Returns the number of frames.
+	std::uint64_t get_frame_count() const;
+	
+	/// Returns the duration of the sound, in seconds.
+	double get_duration() const;
+
+private:
+	std::vector<std::uint8_t> data;
+	std::uint32_t channel_count;
+	std::uint32_t sample_rate;
+	std::uint64_t frame_count;
+};
+
+inline const std::vector<std::uint8_t>& sound_wave::get_data() const
+{
+	return data;
+}
+
+inline std::uint32_t sound_wave::get_channel_count() const
+{
+	return channel_count;
+}
+
+inline std::uint32_t sound_wave::get_sample_rate() const
+{
+	return sample_rate;
+}
+
+inline std::uint64_t sound_wave::get_frame_count() const
+{
+	return frame_count;
+}
+
+inline double sound_wave::get_duration() const
+{
+	return static_cast<double>(frame_count) / static_cast<double>(sample_rate);
+}
+
+} // namespace audio
+
+template <>
+struct resource_loader_traits<audio::sound_wave>
+{
+	static constexpr bool concurrent = true;
+};
+
+template <>
+struct resource_footprint<audio::sound_wave>
+{
+	static std::size_t cpu_size(const audio::sound_wave& resource)
+	{
+		return sizeof(audio::sound_wave) + resource.get_data().size();
+	}
+	
+	static std::size_t gpu_size(const audio::sound_wave& resource)
+	{
+		return 0;
+	}
+};
+
+#endif // ANTKEEPER_AUDIO_SOUND_WAVE_HPP
@@ -0,0 +1,405 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ANTKEEPER_COLOR_BATCH_HPP
+#define ANTKEEPER_COLOR_BATCH_HPP
+
+#include "math/batch.hpp"
+#include "acescg.hpp"
+#include "cct.hpp"
+#include "index.hpp"
+#include "srgb.hpp"
+#include "xyz.hpp"
+#include <cstddef>
+
+namespace color {
+
+/**
+ * @file batch.hpp
+ *
+ * Batch color conversions over structure-of-arrays (SoA) colors, built on the SIMD lanes of math/batch.hpp, so that `float` conversions process four elements at a time and `double` conversions two at a time where SIMD instructions are available.
+ */
+
+namespace index {
+
+/**
+ * Converts an array of B-V color indices to correlated color temperatures, like color::index::bv_to_cct().
+ *
+ * @param bv Array of B-V color indices.
+ * @param[out] t Array of correlated color temperatures, in Kelvin. May alias @p bv.
+ * @param n Number of elements.
+ */
+template <class T>
+void bv_to_cct_n(const T* bv, T* t, std::size_t n);
+
+} // namespace index
+
+namespace cct {
+
+/**
+ * Converts an array of correlated color temperatures to CIE XYZ colors of unit luminance, like color::cct::to_xyz().
+ *
+ * @param t Array of correlated color temperatures, in Kelvin.
+ * @param[out] xyz Array of CIE XYZ colors.
+ * @param n Number of elements.
+ */
+template <class T>
+void to_xyz_n(const T* t, const math::vector3_soa<T>& xyz, std::size_t n);
+
+} // namespace cct
+
+namespace xyz {
+
+/**
+ * Converts an array of CIE XYZ colors to ACEScg, like color::xyz::to_acescg().
+ *
+ * @param x Array of CIE XYZ colors.
+ * @param[out] r Array of ACEScg colors. May alias @p x.
+ * @param n Number of elements.
+ */
+template <class T>
+void to_acescg_n(const math::vector3_soa<T>& x, const math::vector3_soa<T>& r, std::size_t n);
+
+/**
+ * Converts an array of CIE XYZ colors to linear sRGB, like color::xyz::to_srgb().
+ *
+ * @param x Array of CIE XYZ colors.
+ * @param[out] r Array of linear sRGB colors. May alias @p x.
+ * @param n Number of elements.
+ */
+template <class T>
+void to_srgb_n(const math::vector3_soa<T>& x, const math::vector3_soa<T>& r, std::size_t n);
+
+} // namespace xyz
+
+namespace acescg {
+
+/**
+ * Converts an array of ACEScg colors to linear sRGB, like color::acescg::to_srgb().
+ *
+ * @param x Array of ACEScg colors.
+ * @param[out] r Array of linear sRGB colors. May alias @p x.
+ * @param n Number of elements.
+ */
+template <class T>
+void to_srgb_n(const math::vector3_soa<T>& x, const math::vector3_soa<T>& r, std::size_t n);
+
+/**
+ * Converts an array of ACEScg colors to CIE XYZ, like color::acescg::to_xyz().
+ *
+ * @param x Array of ACEScg colors.
+ * @param[out] r Array of CIE XYZ colors. May alias @p x.
+ * @param n Number of elements.
+ */
+template <class T>
+void to_xyz_n(const math::vector3_soa<T>& x, const math::vector3_soa<T>& r, std::size_t n);
+
+} // namespace acescg
+
+namespace srgb {
+
+/**
+ * Converts an array of linear sRGB colors to ACEScg, like color::srgb::to_acescg().
+ *
+ * @param x Array of linear sRGB colors.
+ * @param[out] r Array of ACEScg colors. May alias @p x.
+ * @param n Number of elements.
+ */
+template <class T>
+void to_acescg_n(const math::vector3_soa<T>& x, const math::vector3_soa<T>& r, std::size_t n);
+
+/**
+ * Converts an array of linear sRGB colors to CIE XYZ, like color::srgb::to_xyz().
+ *
+ * @param x Array of linear sRGB colors.
+ * @param[out] r Array of CIE XYZ colors. May alias @p x.
+ * @param n Number of elements.
+ */
+template <class T>
+void to_xyz_n(const math::vector3_soa<T>& x, const math::vector3_soa<T>& r, std::size_t n);
+
+/**
+ * Applies the sRGB EOTF to an array of values, like color::srgb::eotf().
+ *
+ * Evaluated one element at a time, as the power function has no SIMD instruction. Prefer eotf_fast_n() where an error of 1e-4 is acceptable.
+ *
+ * @param v Array of sRGB-encoded values.
+ * @param[out] l Array of linear values. May alias @p v.
+ * @param n Number of elements.
+ */
+template <class T>
+void eotf_n(const T* v, T* l, std::size_t n);
+
+/**
+ * Applies the inverse of the sRGB EOTF to an array of values, like color::srgb::eotf_inverse().
+ *
+ * Evaluated one element at a time, as the power function has no SIMD instruction. Prefer eotf_inverse_fast_n() where an error of 5e-5 is acceptable.
+ *
+ * @param l Array of linear values.
+ * @param[out] v Array of sRGB-encoded values. May alias @p l.
+ * @param n Number of elements.
+ */
+template <class T>
+void eotf_inverse_n(const T* l, T* v, std::size_t n);
+
+/**
+ * Approximates the sRGB EOTF on `[0, 1]` with a quartic polynomial, to within 1e-4.
+ *
+ * @param v sRGB-encoded value.
+ * @return Linear value.
+ */
+template <class T>
+T eotf_fast(T v);
+
+/**
+ * Approximates the inverse of the sRGB EOTF on `[0, 1]` with a polynomial in the square, fourth, and eighth roots, to within 5e-5.
+ *
+ * @param l Linear value.
+ * @return sRGB-encoded value.
+ */
+template <class T>
+T eotf_inverse_fast(T l);
+
+/**
+ * Approximates the sRGB EOTF of an array of values on `[0, 1]`, like eotf_fast().
+ *
+ * @param v Array of sRGB-encoded values.
+ * @param[out] l Array of linear values. May alias @p v.
+ * @param n Number of elements.
+ */
+template <class T>
+void eotf_fast_n(const T* v, T* l, std::size_t n);
+
+/**
+ * Approximates the inverse of the sRGB EOTF of an array of values on `[0, 1]`, like eotf_inverse_fast().
+ *
+ * @param l Array of linear values.
+ * @param[out] v Array of sRGB-encoded values. May alias @p l.
+ * @param n Number of elements.
+ */
+template <class T>
+void eotf_inverse_fast_n(const T* l, T* v, std::size_t n);
+
+} // namespace srgb
+
+/// @private
+namespace simd {
+
+using math::simd::scalar_lanes;
+
+/// Columns of the matrix of a linear color transformation, found by transforming the basis vectors.
+template <class T>
+struct linear_transform
+{
+	template <class Function>
+	explicit linear_transform(const Function& f):
+		columns
+		{
+			f(math::vector3<T>{T(1), T(0), T(0)}),
+			f(math::vector3<T>{T(0), T(1), T(0)}),
+			f(math::vector3<T>{T(0), T(0), T(1)})
+		}
+	{}
+	
+	math::vector3<T> columns[3];
+};
+
+/// Transforms an array of colors by the matrix of a linear color transformation.
+template <class T>
+void transform_n(const linear_transform<T>& m, const math::vector3_soa<T>& x, const math::vector3_soa<T>& r, std::size_t n)
+{
+	math::simd::dispatch_lanes<T>(n, [&](auto lanes, std::size_t i)
+	{
+		typedef decltype(lanes) L;
+		L c[3];
+		math::simd::load(x, i, c);
+		
+		L t[3];
+		for (std::size_t j = 0; j < 3; ++j)
+			t[j] = L::broadcast(m.columns[0][j]) * c[0] + L::broadcast(m.columns[1][j]) * c[1] + L::broadcast(m.columns[2][j]) * c[2];
+		
+		math::simd::store(r, i, t);
+	});
+}
+
+/// Approximates the sRGB EOTF of lanes.
+template <class L>
+inline L eotf_fast_lanes(L v)
+{
+	L p = L::broadcast(-0.0888065431574042);
+	p = p * v + L::broadcast(0.473327159258599);
+	p = p * v + L::broadcast(0.591798438516977);
+	p = p * v + L::broadcast(0.0222594411627523);
+	p = p * v + L::broadcast(0.00132589443378207);
+	
+	return L::select(v < L::broadcast(0.04045), v * L::broadcast(1.0 / 12.92), p);
+}
+
+/// Approximates the inverse of the sRGB EOTF of lanes.
+template <class L>
+inline L eotf_inverse_fast_lanes(L l)
+{
+	const L s2 = L::sqrt(l);
+	const L s4 = L::sqrt(s2);
+	const L s8 = L::sqrt(s4);
+	const L p = s2 * L::broadcast(0.642399174024704) + s4 * L::broadcast(0.712073669694491) - s8 * L::broadcast(0.336854994821905) - l * L::broadcast(0.0175751566544367);
+	
+	return L::select(L::broadcast(0.0031308) < l, p, l * L::broadcast(12.92));
+}
+
+} // namespace simd
+
+namespace index {
+
+template <class T>
+void bv_to_cct_n(const T* bv, T* t, std::size_t n)
+{
+	math::simd::dispatch_lanes<T>(n, [&](auto lanes, std::size_t i)
+	{
+		typedef decltype(lanes) L;
+		const L x = L::load(bv + i) * L::broadcast(0.92);
+		const L one = L::broadcast(1);
+		(L::broadcast(4600) * (one / (x + L::broadcast(1.7)) + one / (x + L::broadcast(0.62)))).store(t + i);
+	});
+}
+
+} // namespace index
+
+namespace cct {
+
+template <class T>
+void to_xyz_n(const T* t, const math::vector3_soa<T>& xyz, std::size_t n)
+{
+	math::simd::dispatch_lanes<T>(n, [&](auto lanes, std::size_t i)
+	{
+		typedef decltype(lanes) L;
+		const L one = L::broadcast(1);
+		const L k = L::load(t + i);
+		const L kk = k * k;
+		
+		// Approximate the Planckian locus in CIE 1960 UCS colorspace (Krystek's algorithm)
+		const L u = (L::broadcast(0.860117757) + L::broadcast(1.54118254e-4) * k + L::broadcast(1.28641212e-7) * kk) / (one + L::broadcast(8.42420235e-4) * k + L::broadcast(7.08145163e-7) * kk);
+		const L v = (L::broadcast(0.317398726) + L::broadcast(4.22806245e-5) * k + L::broadcast(4.20481691e-8) * kk) / (one - L::broadcast(2.89741816e-5) * k + L::broadcast(1.61456053e-7) * kk);
+		
+		// Convert UCS to xyY, then xyY of unit luminance to XYZ
+		const L inverse_denom = one / (L::broadcast(2) * u - L::broadcast(8) * v + L::broadcast(4));
+		const L x = L::broadcast(3) * u * inverse_denom;
+		const L y = L::broadcast(2) * v * inverse_denom;
+		
+		const L c[3] = {x / y, one, (one - x - y) / y};
+		math::simd::store(xyz, i, c);
+	});
+}
+
+} // namespace cct
+
+namespace xyz {
+
+template <class T>
+void to_acescg_n(const math::vector3_soa<T>& x, const math::vector3_soa<T>& r, std::size_t n)
+{
+	simd::transform_n(simd::linear_transform<T>([](const math::vector3<T>& c){return to_acescg(c);}), x, r, n);
+}
+
+template <class T>
+void to_srgb_n(const math::vector3_soa<T>& x, const math::vector3_soa<T>& r, std::size_t n)
+{
+	simd::transform_n(simd::linear_transform<T>([](const math::vector3<T>& c){return to_srgb(c);}), x, r, n);
+}
+
+} // namespace xyz
+
+namespace acescg {
+
+template <class T>
+void to_srgb_n(const math::vector3_soa<T>& x, const math::vector3_soa<T>& r, std::size_t n)
+{
+	simd::transform_n(simd::linear_transform<T>([](const math::vector3<T>& c){return to_srgb(c);}), x, r, n);
+}
+
+template <class T>
+void to_xyz_n(const math::vector3_soa<T>& x, const math::vector3_soa<T>& r, std::size_t n)
+{
+	simd::transform_n(simd::linear_transform<T>([](const math::vector3<T>& c){return to_xyz(c);}), x, r, n);
+}
+
+} // namespace acescg
+
+namespace srgb {
+
+template <class T>
+void to_acescg_n(const math::vector3_soa<T>& x, const math::vector3_soa<T>& r, std::size_t n)
+{
+	simd::transform_n(simd::linear_transform<T>([](const math::vector3<T>& c){return to_acescg(c);}), x, r, n);
+}
+
+template <class T>
+void to_xyz_n(const math::vector3_soa<T>& x, const math::vector3_soa<T>& r, std::size_t n)
+{
+	simd::transform_n(simd::linear_transform<T>([](const math::vector3<T>& c){return to_xyz(c);}), x, r, n);
+}
+
+template <class T>
+void eotf_n(const T* v, T* l, std::size_t n)
+{
+	for (std::size_t i = 0; i < n; ++i)
+		l[i] = eotf(v[i]);
+}
+
+template <class T>
+void eotf_inverse_n(const T* l, T* v, std::size_t n)
+{
+	for (std::size_t i = 0; i < n; ++i)
+		v[i] = eotf_inverse(l[i]);
+}
+
+template <class T>
+inline T eotf_fast(T v)
+{
+	return simd::eotf_fast_lanes(simd::scalar_lanes<T>{v}).value;
+}
+
+template <class T>
+inline T eotf_inverse_fast(T l)
+{
+	return simd::eotf_inverse_fast_lanes(simd::scalar_lanes<T>{l}).value;
+}
+
+template <class T>
+void eotf_fast_n(const T* v, T* l, std::size_t n)
+{
+	math::simd::dispatch_lanes<T>(n, [&](auto lanes, std::size_t i)
+	{
+		simd::eotf_fast_lanes(decltype(lanes)::load(v + i)).store(l + i);
+	});
+}
+
+template <class T>
+void eotf_inverse_fast_n(const T* l, T* v, std::size_t n)
+{
+	math::simd::dispatch_lanes<T>(n, [&](auto lanes, std::size_t i)
+	{
+		simd::eotf_inverse_fast_lanes(decltype(lanes)::load(l + i)).store(v + i);
+	});
+}
+
+} // namespace srgb
+} // namespace color
+
+#endif // ANTKEEPER_COLOR_BATCH_HPP
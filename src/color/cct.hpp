@@ -23,6 +23,9 @@
 #include "math/math.hpp"
 #include "ucs.hpp"
 #include "xyy.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <vector>
 
 namespace color {
 
@@ -58,6 +61,114 @@ math::vector3<T> to_xyy(T t);
 template <class T>
 math::vector3<T> to_xyz(T t);
 
+/**
+ * Lookup table of colors as functions of correlated color temperature, by which colors of many temperatures can be found with a single interpolated lookup each.
+ *
+ * Samples are spaced uniformly in reciprocal temperature (mireds), along which the Planckian locus varies nearly uniformly.
+ *
+ * @tparam T Scalar type.
+ */
+template <class T>
+class table
+{
+public:
+	/// Constructs an empty table.
+	table();
+	
+	/**
+	 * Samples a function of correlated color temperature.
+	 *
+	 * @param f Function which returns the color of a correlated color temperature, with the signature `math::vector3<T>(T)`.
+	 * @param min_temperature Lowest temperature of the table, in Kelvin.
+	 * @param max_temperature Highest temperature of the table, in Kelvin.
+	 * @param size Number of samples.
+	 */
+	template <class Function>
+	void generate(const Function& f, T min_temperature, T max_temperature, std::size_t size);
+	
+	/**
+	 * Linearly interpolates the color of a correlated color temperature.
+	 *
+	 * @param t Correlated color temperature, in Kelvin, clamped to the temperature range of the table.
+	 * @return Interpolated color.
+	 */
+	math::vector3<T> lookup(T t) const;
+	
+	/// Returns `true` if the temperature @p t lies within the temperature range of the table.
+	bool contains(T t) const;
+	
+	/// Returns the number of samples.
+	std::size_t get_size() const;
+	
+	/// Returns the sampled colors, in order of decreasing temperature.
+	const std::vector<math::vector3<T>>& get_data() const;
+	
+private:
+	T min_temperature;
+	T max_temperature;
+	T min_mired;
+	T mired_scale;
+	std::vector<math::vector3<T>> data;
+};
+
+template <class T>
+table<T>::table():
+	min_temperature(0),
+	max_temperature(0),
+	min_mired(0),
+	mired_scale(0)
+{}
+
+template <class T>
+template <class Function>
+void table<T>::generate(const Function& f, T min_temperature, T max_temperature, std::size_t size)
+{
+	size = std::max<std::size_t>(size, 2);
+	this->min_temperature = min_temperature;
+	this->max_temperature = max_temperature;
+	min_mired = T(1e6) / max_temperature;
+	const T max_mired = T(1e6) / min_temperature;
+	mired_scale = static_cast<T>(size - 1) / (max_mired - min_mired);
+	
+	data.resize(size);
+	for (std::size_t i = 0; i < size; ++i)
+	{
+		const T mired = min_mired + static_cast<T>(i) / mired_scale;
+		data[i] = f(T(1e6) / mired);
+	}
+}
+
+template <class T>
+math::vector3<T> table<T>::lookup(T t) const
+{
+	if (data.empty())
+		return {T(0), T(0), T(0)};
+	
+	const T mired = T(1e6) / std::min<T>(max_temperature, std::max<T>(min_temperature, t));
+	const T x = std::max<T>(T(0), (mired - min_mired) * mired_scale);
+	const std::size_t i = std::min<std::size_t>(static_cast<std::size_t>(x), data.size() - 2);
+	
+	return math::lerp(data[i], data[i + 1], x - static_cast<T>(i));
+}
+
+template <class T>
+inline bool table<T>::contains(T t) const
+{
+	return !data.empty() && t >= min_temperature && t <= max_temperature;
+}
+
+template <class T>
+inline std::size_t table<T>::get_size() const
+{
+	return data.size();
+}
+
+template <class T>
+inline const std::vector<math::vector3<T>>& table<T>::get_data() const
+{
+	return data;
+}
+
 template <class T>
 math::vector2<T> to_ucs(T t)
 {
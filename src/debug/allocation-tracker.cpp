@@ -0,0 +1,315 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "debug/allocation-tracker.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <iomanip>
+#include <new>
+#include <vector>
+
+#if defined(_MSC_VER)
+	#include <intrin.h>
+	#define ANTKEEPER_RETURN_ADDRESS() _ReturnAddress()
+#else
+	#define ANTKEEPER_RETURN_ADDRESS() __builtin_return_address(0)
+#endif
+
+namespace debug {
+
+namespace {
+
+thread_local allocation_tag current_tag = allocation_tag::untagged;
+
+#if defined(ANTKEEPER_ALLOCATION_TRACKING)
+
+/// Allocation counters of a single tag. Counters have static storage and are zero-initialized before any allocation is made.
+struct tag_counters
+{
+	std::atomic<std::uint64_t> live_bytes;
+	std::atomic<std::uint64_t> live_allocations;
+	std::atomic<std::uint64_t> frame_allocations;
+	std::atomic<std::uint64_t> frame_bytes;
+	std::atomic<std::uint64_t> previous_frame_allocations;
+	std::atomic<std::uint64_t> previous_frame_bytes;
+	std::atomic<std::uint64_t> total_allocations;
+};
+
+/// Allocation counters of a single call site, in an open-addressed table which is filled without allocating.
+struct call_site
+{
+	std::atomic<std::uintptr_t> address;
+	std::atomic<std::uint64_t> allocations;
+	std::atomic<std::uint64_t> bytes;
+};
+
+/// Header which precedes each tracked allocation, padded so that the allocation keeps the alignment of `malloc()`.
+struct alignas(std::max_align_t) allocation_header
+{
+	std::size_t size;
+	allocation_tag tag;
+};
+
+tag_counters counters[allocation_tag_count];
+call_site call_sites[allocation_tracker::call_site_capacity];
+
+/// Counts an allocation at a call site, unless the call site table is full.
+void record_call_site(std::uintptr_t address, std::size_t size)
+{
+	static_assert((allocation_tracker::call_site_capacity & (allocation_tracker::call_site_capacity - 1)) == 0);
+	
+	std::size_t slot = static_cast<std::size_t>((static_cast<std::uint64_t>(address) * 0x9e3779b97f4a7c15ull) >> 32) & (allocation_tracker::call_site_capacity - 1);
+	for (std::size_t i = 0; i < allocation_tracker::call_site_capacity; ++i)
+	{
+		call_site& site = call_sites[slot];
+		std::uintptr_t site_address = site.address.load(std::memory_order_relaxed);
+		if (!site_address && site.address.compare_exchange_strong(site_address, address, std::memory_order_relaxed))
+			site_address = address;
+		
+		if (site_address == address)
+		{
+			site.allocations.fetch_add(1, std::memory_order_relaxed);
+			site.bytes.fetch_add(size, std::memory_order_relaxed);
+			return;
+		}
+		
+		slot = (slot + 1) & (allocation_tracker::call_site_capacity - 1);
+	}
+}
+
+void* allocate(std::size_t size, void* return_address)
+{
+	void* block = std::malloc(sizeof(allocation_header) + size);
+	if (!block)
+		return nullptr;
+	
+	allocation_header* header = new (block) allocation_header{size, current_tag};
+	tag_counters& tag = counters[static_cast<std::size_t>(header->tag)];
+	tag.live_bytes.fetch_add(size, std::memory_order_relaxed);
+	tag.live_allocations.fetch_add(1, std::memory_order_relaxed);
+	tag.frame_allocations.fetch_add(1, std::memory_order_relaxed);
+	tag.frame_bytes.fetch_add(size, std::memory_order_relaxed);
+	tag.total_allocations.fetch_add(1, std::memory_order_relaxed);
+	record_call_site(reinterpret_cast<std::uintptr_t>(return_address), size);
+	
+	return header + 1;
+}
+
+void deallocate(void* pointer)
+{
+	if (!pointer)
+		return;
+	
+	allocation_header* header = static_cast<allocation_header*>(pointer) - 1;
+	tag_counters& tag = counters[static_cast<std::size_t>(header->tag)];
+	tag.live_bytes.fetch_sub(header->size, std::memory_order_relaxed);
+	tag.live_allocations.fetch_sub(1, std::memory_order_relaxed);
+	std::free(header);
+}
+
+#endif // ANTKEEPER_ALLOCATION_TRACKING
+
+} // namespace
+
+const char* get_allocation_tag_name(allocation_tag tag)
+{
+	static const char* names[allocation_tag_count] =
+	{
+		"untagged",
+		"renderer",
+		"terrain",
+		"subterrain",
+		"resources",
+		"ecs"
+	};
+	
+	return names[static_cast<std::size_t>(tag)];
+}
+
+allocation_scope::allocation_scope(allocation_tag tag):
+	previous_tag(current_tag)
+{
+	current_tag = tag;
+}
+
+allocation_scope::~allocation_scope()
+{
+	current_tag = previous_tag;
+}
+
+namespace allocation_tracker {
+
+bool is_enabled()
+{
+	#if defined(ANTKEEPER_ALLOCATION_TRACKING)
+		return true;
+	#else
+		return false;
+	#endif
+}
+
+void end_frame()
+{
+	#if defined(ANTKEEPER_ALLOCATION_TRACKING)
+		for (tag_counters& tag: counters)
+		{
+			tag.previous_frame_allocations.store(tag.frame_allocations.exchange(0, std::memory_order_relaxed), std::memory_order_relaxed);
+			tag.previous_frame_bytes.store(tag.frame_bytes.exchange(0, std::memory_order_relaxed), std::memory_order_relaxed);
+		}
+	#endif
+}
+
+tag_statistics get_tag_statistics(allocation_tag tag)
+{
+	tag_statistics statistics = {0, 0, 0, 0, 0};
+	
+	#if defined(ANTKEEPER_ALLOCATION_TRACKING)
+		const tag_counters& counters = debug::counters[static_cast<std::size_t>(tag)];
+		statistics.live_bytes = counters.live_bytes.load(std::memory_order_relaxed);
+		statistics.live_allocations = counters.live_allocations.load(std::memory_order_relaxed);
+		statistics.frame_allocations = counters.previous_frame_allocations.load(std::memory_order_relaxed);
+		statistics.frame_bytes = counters.previous_frame_bytes.load(std::memory_order_relaxed);
+		statistics.total_allocations = counters.total_allocations.load(std::memory_order_relaxed);
+	#endif
+	
+	return statistics;
+}
+
+std::size_t write_report(std::ostream& stream, std::size_t call_site_count)
+{
+	#if defined(ANTKEEPER_ALLOCATION_TRACKING)
+		// Write the counts of each tag, then their sums
+		tag_statistics sum = {0, 0, 0, 0, 0};
+		for (std::size_t i = 0; i < allocation_tag_count; ++i)
+		{
+			const tag_statistics statistics = get_tag_statistics(static_cast<allocation_tag>(i));
+			stream << get_allocation_tag_name(static_cast<allocation_tag>(i)) << ": ";
+			stream << statistics.live_bytes << " bytes live in " << statistics.live_allocations << " allocations, ";
+			stream << statistics.frame_allocations << " allocations (" << statistics.frame_bytes << " bytes) last frame, ";
+			stream << statistics.total_allocations << " total\n";
+			
+			sum.live_bytes += statistics.live_bytes;
+			sum.live_allocations += statistics.live_allocations;
+			sum.frame_allocations += statistics.frame_allocations;
+			sum.frame_bytes += statistics.frame_bytes;
+			sum.total_allocations += statistics.total_allocations;
+		}
+		stream << "all: " << sum.live_bytes << " bytes live in " << sum.live_allocations << " allocations, ";
+		stream << sum.frame_allocations << " allocations (" << sum.frame_bytes << " bytes) last frame, ";
+		stream << sum.total_allocations << " total\n";
+		
+		// Snapshot the call site table, as it may be modified while sorting
+		struct call_site_snapshot
+		{
+			std::uintptr_t address;
+			std::uint64_t allocations;
+			std::uint64_t bytes;
+		};
+		std::vector<call_site_snapshot> sites;
+		sites.reserve(call_site_capacity);
+		for (const call_site& site: call_sites)
+		{
+			const std::uintptr_t address = site.address.load(std::memory_order_relaxed);
+			if (address)
+				sites.push_back({address, site.allocations.load(std::memory_order_relaxed), site.bytes.load(std::memory_order_relaxed)});
+		}
+		
+		// Write the call sites which have allocated most often
+		call_site_count = std::min(call_site_count, sites.size());
+		std::partial_sort(sites.begin(), sites.begin() + call_site_count, sites.end(),
+			[](const call_site_snapshot& a, const call_site_snapshot& b)
+			{
+				return a.allocations > b.allocations;
+			});
+		for (std::size_t i = 0; i < call_site_count; ++i)
+		{
+			stream << "0x" << std::hex << sites[i].address << std::dec << ": ";
+			stream << sites[i].allocations << " allocations, " << sites[i].bytes << " bytes\n";
+		}
+		
+		return call_site_count;
+	#else
+		stream << "allocation tracking is disabled, configure with -DANTKEEPER_ALLOCATION_TRACKING=ON\n";
+		return 0;
+	#endif
+}
+
+} // namespace allocation_tracker
+} // namespace debug
+
+#if defined(ANTKEEPER_ALLOCATION_TRACKING)
+
+void* operator new(std::size_t size)
+{
+	void* pointer = debug::allocate(size, ANTKEEPER_RETURN_ADDRESS());
+	if (!pointer)
+		throw std::bad_alloc();
+	return pointer;
+}
+
+void* operator new[](std::size_t size)
+{
+	void* pointer = debug::allocate(size, ANTKEEPER_RETURN_ADDRESS());
+	if (!pointer)
+		throw std::bad_alloc();
+	return pointer;
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+	return debug::allocate(size, ANTKEEPER_RETURN_ADDRESS());
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+	return debug::allocate(size, ANTKEEPER_RETURN_ADDRESS());
+}
+
+void operator delete(void* pointer) noexcept
+{
+	debug::deallocate(pointer);
+}
+
+void operator delete[](void* pointer) noexcept
+{
+	debug::deallocate(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept
+{
+	debug::deallocate(pointer);
+}
+
+void operator delete[](void* pointer, std::size_t) noexcept
+{
+	debug::deallocate(pointer);
+}
+
+void operator delete(void* pointer, const std::nothrow_t&) noexcept
+{
+	debug::deallocate(pointer);
+}
+
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept
+{
+	debug::deallocate(pointer);
+}
+
+#endif // ANTKEEPER_ALLOCATION_TRACKING
@@ -0,0 +1,123 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ANTKEEPER_DEBUG_ALLOCATION_TRACKER_HPP
+#define ANTKEEPER_DEBUG_ALLOCATION_TRACKER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+namespace debug {
+
+/// Subsystem to which heap allocations are attributed.
+enum class allocation_tag: std::uint8_t
+{
+	/// Allocations made outside of any allocation scope.
+	untagged,
+	renderer,
+	terrain,
+	subterrain,
+	resources,
+	ecs
+};
+
+/// Number of allocation tags.
+constexpr std::size_t allocation_tag_count = 6;
+
+/// Returns the name of an allocation tag.
+const char* get_allocation_tag_name(allocation_tag tag);
+
+/**
+ * Scoped allocation tag. Heap allocations made by the constructing thread during the lifetime of the scope are attributed to its tag, and nested scopes override the tags of enclosing scopes.
+ *
+ * Allocations are only tracked if the executable was configured with the CMake option `ANTKEEPER_ALLOCATION_TRACKING`, otherwise scopes do nothing.
+ */
+class allocation_scope
+{
+public:
+	/**
+	 * Begins an allocation scope.
+	 *
+	 * @param tag Tag to which allocations will be attributed.
+	 */
+	explicit allocation_scope(allocation_tag tag);
+	
+	/// Ends the allocation scope, restoring the tag of the enclosing scope.
+	~allocation_scope();
+	
+	allocation_scope(const allocation_scope&) = delete;
+	allocation_scope& operator=(const allocation_scope&) = delete;
+
+private:
+	allocation_tag previous_tag;
+};
+
+/// Functions which query the allocation tracker, which replaces the global `operator new` and `operator delete` to count the heap allocations of each tag and call site.
+namespace allocation_tracker {
+
+/// Allocation counts of a single tag.
+struct tag_statistics
+{
+	/// Number of bytes allocated and not yet freed.
+	std::uint64_t live_bytes;
+	
+	/// Number of allocations not yet freed.
+	std::uint64_t live_allocations;
+	
+	/// Number of allocations made during the previous frame.
+	std::uint64_t frame_allocations;
+	
+	/// Number of bytes allocated during the previous frame.
+	std::uint64_t frame_bytes;
+	
+	/// Number of allocations made since startup.
+	std::uint64_t total_allocations;
+};
+
+/// Number of distinct call sites tracked. Allocations from further call sites are counted by tag only.
+constexpr std::size_t call_site_capacity = 4096;
+
+/// Returns `true` if the executable was built with allocation tracking.
+bool is_enabled();
+
+/// Ends the current frame, making its allocation counts available as those of the previous frame.
+void end_frame();
+
+/**
+ * Returns the allocation counts of a tag.
+ *
+ * @param tag Allocation tag.
+ * @return Allocation counts, or zero if allocation tracking is disabled.
+ */
+tag_statistics get_tag_statistics(allocation_tag tag);
+
+/**
+ * Writes the allocation counts of each tag, followed by the call sites which have allocated most often. Call sites are the return addresses of `operator new`, which may lie within inlined container code, and can be resolved with a debugger or `addr2line` after subtracting the load address of the executable.
+ *
+ * @param stream Output stream.
+ * @param call_site_count Maximum number of call sites to write.
+ * @return Number of call sites written.
+ */
+std::size_t write_report(std::ostream& stream, std::size_t call_site_count);
+
+} // namespace allocation_tracker
+} // namespace debug
+
+#endif // ANTKEEPER_DEBUG_ALLOCATION_TRACKER_HPP
@@ -20,7 +20,56 @@
 #include "console-commands.hpp"
 #include "application.hpp"
 #include "animation/timeline.hpp"
+#include "debug/allocation-tracker.hpp"
 #include "debug/cli.hpp"
+#include "debug/counters.hpp"
+#include "debug/draw.hpp"
+#include "debug/frame-recorder.hpp"
+#include "renderer/passes/material-pass.hpp"
+#include "renderer/passes/ui-pass.hpp"
+#include "renderer/pass-profiler.hpp"
+#include "debug/performance-sampler.hpp"
+#include "debug/profiler.hpp"
+#include "entity/components/atmosphere.hpp"
+#include "entity/components/behavior.hpp"
+#include "entity/components/blackbody.hpp"
+#include "entity/components/brush.hpp"
+#include "entity/components/camera-follow.hpp"
+#include "entity/components/cavity.hpp"
+#include "entity/components/celestial-body.hpp"
+#include "entity/components/collision.hpp"
+#include "entity/components/copy-rotation.hpp"
+#include "entity/components/copy-scale.hpp"
+#include "entity/components/copy-transform.hpp"
+#include "entity/components/copy-translation.hpp"
+#include "entity/components/diffuse-reflector.hpp"
+#include "entity/components/genome.hpp"
+#include "entity/components/light.hpp"
+#include "entity/components/locomotion.hpp"
+#include "entity/components/marker.hpp"
+#include "entity/components/model.hpp"
+#include "entity/components/name.hpp"
+#include "entity/components/nest.hpp"
+#include "entity/components/observer.hpp"
+#include "entity/components/orbit.hpp"
+#include "entity/components/parent.hpp"
+#include "entity/components/proteome.hpp"
+#include "entity/components/snap.hpp"
+#include "entity/components/terrain.hpp"
+#include "entity/components/tool.hpp"
+#include "entity/components/trackable.hpp"
+#include "entity/components/transform.hpp"
+#include "entity/commands.hpp"
+#include "entity/name-index.hpp"
+#include "entity/snapshot.hpp"
+#include "entity/systems/subterrain.hpp"
+#include "resources/resource-manager.hpp"
+#include "utility/paths.hpp"
+#include "utility/timestamp.hpp"
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <unordered_set>
 
 namespace debug {
 namespace cc {
@@ -52,5 +101,361 @@ std::string cue(game::context* ctx, float t, std::string command)
 	return std::string("command \"" + command + "\" will execute in " + std::to_string(t) + " seconds");
 }
 
+/// Formats the batching statistics of a material pass.
+/// Accumulates the number of components in the pool of a component type and the bytes they occupy, including any heap data they own.
+template <class T>
+static void format_pool(std::ostream& stream, const entity::registry& registry, const char* name, std::size_t heap_size, std::size_t& total_count, std::size_t& total_size)
+{
+	const std::size_t count = registry.size<T>();
+	const std::size_t size = count * sizeof(T) + heap_size;
+	
+	if (count)
+		stream << name << ": " << count << " x " << sizeof(T) << " B, " << size / 1024.0 << " KiB\n";
+	
+	total_count += count;
+	total_size += size;
+}
+
+static std::string format_batching(const std::string& name, const material_pass* pass)
+{
+	if (!pass)
+		return std::string();
+	
+	const material_pass::batch_statistics& stats = pass->get_batch_statistics();
+	return name + ": " + std::to_string(stats.operation_count) + " operations in " + std::to_string(stats.draw_count) + " draws, " + std::to_string(stats.batched_operation_count) + " operations merged into " + std::to_string(stats.batch_count) + " instanced draws, " + std::to_string(stats.merged_operation_count) + " operations merged into " + std::to_string(stats.multi_draw_count) + " multi-draws\n";
+}
+
+std::string batching(game::context* ctx)
+{
+	return
+		format_batching("surface", ctx->surface_material_pass) +
+		format_batching("underground", ctx->underground_material_pass) +
+		"ui: " + std::to_string(ctx->ui_pass->get_element_count()) + " elements in " + std::to_string(ctx->ui_pass->get_draw_count()) + " draws\n";
+}
+
+std::string gpu_profile(game::context* ctx, int enabled)
+{
+	ctx->pass_profiler->set_enabled(enabled != 0);
+	return std::string("GPU pass profiling ") + ((enabled) ? "enabled" : "disabled");
+}
+
+std::string gpu_times(game::context* ctx)
+{
+	const pass_profiler* profiler = ctx->pass_profiler;
+	if (!profiler->is_enabled())
+		return std::string("GPU pass profiling disabled");
+	
+	std::ostringstream stream;
+	stream << std::fixed << std::setprecision(3);
+	
+	double total = 0.0;
+	for (const auto& timing: profiler->get_timings())
+	{
+		stream << timing.first << ": " << timing.second.mean_duration * 1000.0 << " ms\n";
+		total += timing.second.mean_duration;
+	}
+	stream << "total: " << total * 1000.0 << " ms\n";
+	
+	return stream.str();
+}
+
+std::string latency(game::context* ctx)
+{
+	const debug::performance_sampler* sampler = ctx->app->get_input_latency_sampler();
+	if (!sampler->size())
+		return std::string("no input latency samples");
+	
+	std::ostringstream stream;
+	stream << std::fixed << std::setprecision(3);
+	stream << "frames: " << sampler->size() << "\n";
+	stream << "mean: " << sampler->mean_frame_duration() * 1000.0 << " ms\n";
+	for (double p: {0.5, 0.95, 0.99})
+		stream << "p" << static_cast<int>(p * 100.0) << ": " << sampler->percentile(p) * 1000.0 << " ms\n";
+	stream << "max: " << sampler->percentile(1.0) * 1000.0 << " ms\n";
+	
+	return stream.str();
+}
+
+std::string frame_stats(game::context* ctx)
+{
+	std::ostringstream stream;
+	stream << std::fixed << std::setprecision(3);
+	
+	for (application::timing_channel channel: {application::timing_channel::frame, application::timing_channel::update, application::timing_channel::render, application::timing_channel::swap})
+	{
+		const debug::performance_sampler* sampler = ctx->app->get_timing_sampler(channel);
+		stream << application::get_timing_channel_name(channel) << ": ";
+		stream << "n " << sampler->sample_count();
+		stream << ", mean " << sampler->streaming_mean() * 1000.0;
+		stream << ", p50 " << sampler->streaming_percentile(0.5) * 1000.0;
+		stream << ", p95 " << sampler->streaming_percentile(0.95) * 1000.0;
+		stream << ", p99 " << sampler->streaming_percentile(0.99) * 1000.0;
+		stream << ", max " << sampler->max_duration() * 1000.0 << " ms\n";
+	}
+	
+	return stream.str();
+}
+
+std::string frame_csv(game::context* ctx, std::string path)
+{
+	std::ofstream stream(path);
+	if (!stream)
+		return std::string("failed to open \"" + path + "\"");
+	
+	stream << "channel,lower_ms,upper_ms,count\n";
+	for (application::timing_channel channel: {application::timing_channel::frame, application::timing_channel::update, application::timing_channel::render, application::timing_channel::swap})
+		ctx->app->get_timing_sampler(channel)->write_csv(stream, application::get_timing_channel_name(channel));
+	
+	return std::string("wrote frame timing histograms to \"" + path + "\"");
+}
+
+std::string record(game::context* ctx, std::string format)
+{
+	debug::frame_recorder* recorder = ctx->app->get_frame_recorder();
+	
+	if (format == "stop")
+	{
+		if (!recorder->is_recording())
+			return std::string("not recording");
+		
+		recorder->stop_recording();
+		return std::string("recorded " + std::to_string(recorder->get_recorded_frame_count()) + " frames");
+	}
+	
+	if (format != "png" && format != "raw")
+		return std::string("unknown frame format \"" + format + "\"");
+	
+	const std::string directory = ctx->screenshots_path + "recording-" + timestamp() + "/";
+	if (!path_exists(directory) && !create_directory(directory))
+		return std::string("failed to create \"" + directory + "\"");
+	
+	recorder->start_recording(directory, (format == "png") ? debug::frame_format::png : debug::frame_format::raw);
+	return std::string("recording frames to \"" + directory + "\"");
+}
+
+std::string trace(std::string path)
+{
+	std::ofstream stream(path);
+	if (!stream)
+		return std::string("failed to open \"" + path + "\"");
+	
+	const std::size_t event_count = debug::profiler::write_chrome_trace(stream);
+	return std::string("wrote " + std::to_string(event_count) + " profiling events to \"" + path + "\"");
+}
+
+std::string stats()
+{
+	const std::vector<debug::counters::sample> samples = debug::counters::get_samples();
+	if (samples.empty())
+		return std::string("no counters registered");
+	
+	std::ostringstream stream;
+	stream << std::fixed << std::setprecision(1);
+	for (const debug::counters::sample& sample: samples)
+		stream << sample.name << ((sample.gauge) ? " (gauge)" : "") << ": " << sample.value << ", mean " << sample.mean << ", max " << sample.max << "\n";
+	
+	return stream.str();
+}
+
+std::string allocations()
+{
+	std::ostringstream stream;
+	debug::allocation_tracker::write_report(stream, 16);
+	return stream.str();
+}
+
+std::string draw(std::string layer, int enabled)
+{
+	#if defined(DEBUG)
+		const std::uint32_t layers = debug::draw::find_layer(layer);
+		if (!layers)
+			return "unknown debug draw layer \"" + layer + "\"";
+		
+		if (enabled)
+			debug::draw::set_layers(debug::draw::get_layers() | layers);
+		else
+			debug::draw::set_layers(debug::draw::get_layers() & ~layers);
+		
+		return "debug draw " + layer + ((enabled) ? " enabled" : " disabled");
+	#else
+		return "debug draw is disabled in release builds";
+	#endif
+}
+
+std::string find(game::context* ctx, std::string pattern)
+{
+	const entity::name_index& index = entity::command::get_name_index(*ctx->entity_registry);
+	
+	std::string result;
+	for (entity::id eid: index.match(pattern))
+		result += index.get_name(eid) + ": " + std::to_string(static_cast<std::underlying_type_t<entity::id>>(eid)) + "\n";
+	
+	return (result.empty()) ? std::string("no entities match \"" + pattern + "\"") : result;
+}
+
+std::string resource(game::context* ctx, std::string command)
+{
+	if (command == "graph")
+	{
+		std::string result;
+		for (const auto& [name, dependencies]: ctx->resource_manager->get_dependencies())
+		{
+			if (dependencies.empty())
+				continue;
+			
+			result += name + " ->";
+			for (const std::string& dependency: dependencies)
+				result += " " + dependency;
+			result += "\n";
+		}
+		
+		return (result.empty()) ? std::string("no resource dependencies recorded") : result;
+	}
+	
+	if (command != "stats")
+		return std::string("usage: resource stats|graph");
+	
+	std::ostringstream stream;
+	stream << std::fixed << std::setprecision(2);
+	
+	auto print_usage = [&stream](const std::string& name, const resource_usage& usage)
+	{
+		stream << name << ": " << usage.count << " resources, " << usage.cpu_size / 1048576.0 << " MiB CPU, " << usage.gpu_size / 1048576.0 << " MiB GPU\n";
+	};
+	
+	for (const auto& type_usage: ctx->resource_manager->get_usage_by_type())
+		print_usage(type_usage.first, type_usage.second);
+	print_usage("total", ctx->resource_manager->get_usage());
+	
+	return stream.str();
+}
+
+std::string save(game::context* ctx, std::string path)
+{
+	std::ofstream stream(path, std::ios::binary);
+	if (!stream)
+		return std::string("failed to open \"" + path + "\"");
+	
+	try
+	{
+		entity::save_snapshot(*ctx->entity_registry, stream, ctx->subterrain_system->get_dug_cavities());
+	}
+	catch (const std::exception& e)
+	{
+		return std::string("failed to save \"" + path + "\": " + e.what());
+	}
+	
+	return std::string("saved snapshot to \"" + path + "\"");
+}
+
+std::string load(game::context* ctx, std::string path)
+{
+	std::ifstream stream(path, std::ios::binary);
+	if (!stream)
+		return std::string("failed to open \"" + path + "\"");
+	
+	try
+	{
+		ctx->entity_registry->clear();
+		entity::snapshot_loader loader(*ctx->entity_registry, stream);
+		while (loader.load_next());
+	}
+	catch (const std::exception& e)
+	{
+		return std::string("failed to load \"" + path + "\": " + e.what());
+	}
+	
+	return std::string("loaded snapshot from \"" + path + "\"");
+}
+
+std::string pools(game::context* ctx)
+{
+	entity::registry& registry = *ctx->entity_registry;
+	
+	// Sum the heap data owned by the components of bulky types. Shared data is counted once.
+	std::size_t genome_heap_size = 0;
+	std::unordered_set<const void*> shared_chromosomes;
+	registry.view<entity::component::genome>().each
+	(
+		[&](entity::id entity_id, const auto& genome)
+		{
+			genome_heap_size += genome.chromosomes.capacity() * sizeof(genetics::chromosome);
+			for (const genetics::chromosome& chromosome: genome.chromosomes)
+			{
+				if (chromosome->empty() || !shared_chromosomes.insert(&chromosome.get()).second)
+					continue;
+				
+				genome_heap_size += sizeof(genetics::packed_sequence) + chromosome->get_words().capacity() * sizeof(genetics::packed_sequence::word_type);
+			}
+		}
+	);
+	
+	std::size_t proteome_heap_size = 0;
+	std::unordered_set<const void*> shared_proteins;
+	registry.view<entity::component::proteome>().each
+	(
+		[&](entity::id entity_id, const auto& proteome)
+		{
+			if (!proteome.proteins || !shared_proteins.insert(proteome.proteins.get()).second)
+				return;
+			
+			proteome_heap_size += proteome.proteins->capacity() * sizeof(std::string);
+			for (const std::string& protein: *proteome.proteins)
+				proteome_heap_size += protein.capacity();
+		}
+	);
+	
+	std::size_t name_heap_size = 0;
+	registry.view<entity::component::name>().each
+	(
+		[&](entity::id entity_id, const auto& name)
+		{
+			name_heap_size += name.id.capacity();
+		}
+	);
+	
+	std::ostringstream stream;
+	stream << std::fixed << std::setprecision(2);
+	std::size_t total_count = 0;
+	std::size_t total_size = 0;
+	
+	#define FORMAT_POOL(type, heap_size) format_pool<entity::component::type>(stream, registry, #type, heap_size, total_count, total_size)
+	FORMAT_POOL(atmosphere, 0);
+	FORMAT_POOL(behavior, 0);
+	FORMAT_POOL(blackbody, 0);
+	FORMAT_POOL(brush, 0);
+	FORMAT_POOL(camera_follow, 0);
+	FORMAT_POOL(cavity, 0);
+	FORMAT_POOL(celestial_body, 0);
+	FORMAT_POOL(collision, 0);
+	FORMAT_POOL(copy_rotation, 0);
+	FORMAT_POOL(copy_scale, 0);
+	FORMAT_POOL(copy_transform, 0);
+	FORMAT_POOL(copy_translation, 0);
+	FORMAT_POOL(diffuse_reflector, 0);
+	FORMAT_POOL(genome, genome_heap_size);
+	FORMAT_POOL(light, 0);
+	FORMAT_POOL(locomotion, 0);
+	FORMAT_POOL(marker, 0);
+	FORMAT_POOL(model, 0);
+	FORMAT_POOL(name, name_heap_size);
+	FORMAT_POOL(nest, 0);
+	FORMAT_POOL(observer, 0);
+	FORMAT_POOL(orbit, 0);
+	FORMAT_POOL(parent, 0);
+	FORMAT_POOL(proteome, proteome_heap_size);
+	FORMAT_POOL(snap, 0);
+	FORMAT_POOL(terrain, 0);
+	FORMAT_POOL(tool, 0);
+	FORMAT_POOL(trackable, 0);
+	FORMAT_POOL(transform, 0);
+	#undef FORMAT_POOL
+	
+	stream << "total: " << total_count << " components, " << total_size / 1024.0 << " KiB\n";
+	stream << "interned chromosomes: " << genetics::chromosome::get_interned_count();
+	
+	return stream.str();
+}
+
 } // namespace cc
 } // namespace debug
@@ -36,6 +36,54 @@ std::string scrot(game::context* ctx);
 
 std::string cue(game::context* ctx, float t, std::string command);
 
+/// Returns the draw call batching statistics of the material passes and the UI pass.
+std::string batching(game::context* ctx);
+
+/// Enables or disables measuring the GPU time of each render pass.
+std::string gpu_profile(game::context* ctx, int enabled);
+
+/// Returns the mean GPU time of each render pass, aggregated by pass name.
+std::string gpu_times(game::context* ctx);
+
+/// Returns the distribution of input-to-swap latencies of recent frames.
+std::string latency(game::context* ctx);
+
+/// Returns the streaming percentiles of each frame timing channel.
+std::string frame_stats(game::context* ctx);
+
+/// Writes the frame timing histograms of each channel to a CSV file, for comparison between builds.
+std::string frame_csv(game::context* ctx, std::string path);
+
+/// Starts capturing every frame into a new directory of screenshots, as `png` or `raw` files, or stops capturing with `stop`.
+std::string record(game::context* ctx, std::string format);
+
+/// Writes the recorded CPU profiling zones to a Chrome trace file.
+std::string trace(std::string path);
+
+/// Returns the value of each named counter and gauge during the previous frame, with its mean and maximum over recent frames.
+std::string stats();
+
+/// Returns the heap allocations of each subsystem tag during the previous frame and still live, followed by the call sites which have allocated most often. Requires a build configured with `ANTKEEPER_ALLOCATION_TRACKING`.
+std::string allocations();
+
+/// Enables or disables a debug draw layer, named `hyperoctree`, `mesh_accelerator`, `shadow_cascades`, `terrain_patches`, `shadow_atlas`, or `all`. Requires a debug build.
+std::string draw(std::string layer, int enabled);
+
+/// Lists the IDs of all entities with names which match a glob pattern.
+std::string find(game::context* ctx, std::string pattern);
+
+/// Inspects the resource manager. `resource stats` returns the number of cached resources and the memory they occupy, by resource type, and `resource graph` returns the recorded dependencies of each resource.
+std::string resource(game::context* ctx, std::string command);
+
+/// Returns the number of components in the pool of each component type and the bytes they occupy, including the heap data they own. Data shared between components, such as proteins, is counted once.
+std::string pools(game::context* ctx);
+
+/// Writes a binary snapshot of the entity registry and dug cavities to a file.
+std::string save(game::context* ctx, std::string path);
+
+/// Replaces all entities with those of a binary snapshot file.
+std::string load(game::context* ctx, std::string path);
+
 } // namespace cc
 } // namespace debug
 
@@ -0,0 +1,187 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "debug/counters.hpp"
+#include "debug/profiler.hpp"
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <mutex>
+
+namespace debug {
+
+struct counter_slot
+{
+	const char* name;
+	bool gauge;
+	
+	/// Count of the current frame for counters, or current value for gauges.
+	std::atomic<std::int64_t> value;
+	
+	/// Sample of the previous frame.
+	std::int64_t last_value;
+};
+
+namespace {
+
+/// Samples of all statistics at the end of a frame.
+struct frame_samples
+{
+	std::uint64_t time;
+	std::array<std::int64_t, counters::capacity> values;
+};
+
+// Slots are registered under a mutex, but published by an atomic count so they can be read without it. The last slot is reserved for overflowing names.
+std::mutex slots_mutex;
+std::array<counter_slot, counters::capacity + 1> slots;
+std::atomic<std::size_t> slot_count(0);
+
+// Sample history, guarded by the history mutex
+std::mutex history_mutex;
+std::vector<frame_samples> history;
+std::size_t history_head = 0;
+
+/// Finds or registers the slot of a statistic.
+std::atomic<std::int64_t>* register_slot(const char* name, bool gauge)
+{
+	std::lock_guard<std::mutex> lock(slots_mutex);
+	
+	const std::size_t count = slot_count.load(std::memory_order_relaxed);
+	for (std::size_t i = 0; i < count; ++i)
+		if (!std::strcmp(slots[i].name, name))
+			return &slots[i].value;
+	
+	if (count == counters::capacity)
+	{
+		slots[counters::capacity].name = "overflow";
+		return &slots[counters::capacity].value;
+	}
+	
+	counter_slot& slot = slots[count];
+	slot.name = name;
+	slot.gauge = gauge;
+	slot.value.store(0, std::memory_order_relaxed);
+	slot.last_value = 0;
+	slot_count.store(count + 1, std::memory_order_release);
+	
+	return &slot.value;
+}
+
+} // namespace
+
+counter::counter(const char* name):
+	value(register_slot(name, false))
+{}
+
+void counter::add(std::int64_t count)
+{
+	value->fetch_add(count, std::memory_order_relaxed);
+}
+
+gauge::gauge(const char* name):
+	value(register_slot(name, true))
+{}
+
+void gauge::set(std::int64_t value)
+{
+	this->value->store(value, std::memory_order_relaxed);
+}
+
+void gauge::add(std::int64_t delta)
+{
+	value->fetch_add(delta, std::memory_order_relaxed);
+}
+
+namespace counters {
+
+void end_frame()
+{
+	const std::size_t count = slot_count.load(std::memory_order_acquire);
+	
+	std::lock_guard<std::mutex> lock(history_mutex);
+	if (history.size() < history_capacity)
+		history.emplace_back();
+	frame_samples& frame = history[history_head % history_capacity];
+	history_head = (history_head + 1) % history_capacity;
+	
+	frame.time = profiler::get_time();
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		counter_slot& slot = slots[i];
+		slot.last_value = (slot.gauge) ? slot.value.load(std::memory_order_relaxed) : slot.value.exchange(0, std::memory_order_relaxed);
+		frame.values[i] = slot.last_value;
+	}
+}
+
+std::vector<sample> get_samples()
+{
+	const std::size_t count = slot_count.load(std::memory_order_acquire);
+	std::vector<sample> samples(count);
+	
+	std::lock_guard<std::mutex> lock(history_mutex);
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		std::int64_t sum = 0;
+		std::int64_t max = 0;
+		for (const frame_samples& frame: history)
+		{
+			sum += frame.values[i];
+			max = (&frame == &history.front()) ? frame.values[i] : std::max(max, frame.values[i]);
+		}
+		
+		samples[i].name = slots[i].name;
+		samples[i].gauge = slots[i].gauge;
+		samples[i].value = slots[i].last_value;
+		samples[i].mean = (history.empty()) ? 0.0 : static_cast<double>(sum) / static_cast<double>(history.size());
+		samples[i].max = max;
+	}
+	
+	return samples;
+}
+
+std::size_t write_chrome_trace_events(std::ostream& stream, std::size_t event_count)
+{
+	const std::size_t count = slot_count.load(std::memory_order_acquire);
+	std::size_t written = 0;
+	
+	std::lock_guard<std::mutex> lock(history_mutex);
+	
+	// Write frames from oldest to newest, as one counter event per statistic, with microsecond timestamps. Statistics registered after a frame was sampled report zero for that frame.
+	const std::size_t first = (history.size() < history_capacity) ? 0 : history_head;
+	for (std::size_t j = 0; j < history.size(); ++j)
+	{
+		const frame_samples& frame = history[(first + j) % history.size()];
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			if (event_count + written)
+				stream << ',';
+			stream << "\n{\"name\":\"" << slots[i].name << "\",\"ph\":\"C\",\"pid\":0";
+			stream << ",\"ts\":" << static_cast<double>(frame.time) * 1e-3;
+			stream << ",\"args\":{\"value\":" << frame.values[i] << "}}";
+			
+			++written;
+		}
+	}
+	
+	return written;
+}
+
+} // namespace counters
+} // namespace debug
@@ -0,0 +1,130 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef ANTKEEPER_DEBUG_COUNTERS_HPP
+#define ANTKEEPER_DEBUG_COUNTERS_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+namespace debug {
+
+/// Statistic slot shared by every counter or gauge registered with the same name.
+struct counter_slot;
+
+/**
+ * Named counter of events per frame, such as draw calls. Counts are accumulated from any thread without locking, then aggregated into the count of the previous frame by debug::counters::end_frame().
+ *
+ * Counters are cheap to increment but not to construct, as construction looks up the name, so they are intended to be declared `static`:
+ *
+ * @code{.cpp}
+ * static debug::counter draw_calls("gl.draw_calls");
+ * draw_calls.add();
+ * @endcode
+ */
+class counter
+{
+public:
+	/**
+	 * Registers a counter, or finds the counter already registered with the same name.
+	 *
+	 * @param name Name of the counter. Only the pointer is recorded, so the string must have static storage duration.
+	 */
+	explicit counter(const char* name);
+	
+	/// Adds to the count of the current frame.
+	void add(std::int64_t count = 1);
+
+private:
+	std::atomic<std::int64_t>* value;
+};
+
+/**
+ * Named gauge of a quantity which persists across frames, such as the number of active terrain patches. Gauges are set or adjusted from any thread without locking, and sampled at the end of each frame.
+ */
+class gauge
+{
+public:
+	/**
+	 * Registers a gauge, or finds the gauge already registered with the same name.
+	 *
+	 * @param name Name of the gauge. Only the pointer is recorded, so the string must have static storage duration.
+	 */
+	explicit gauge(const char* name);
+	
+	/// Sets the value of the gauge.
+	void set(std::int64_t value);
+	
+	/// Adds to the value of the gauge, which may be negative.
+	void add(std::int64_t delta);
+
+private:
+	std::atomic<std::int64_t>* value;
+};
+
+/// Functions which aggregate and query counters and gauges.
+namespace counters {
+
+/// Maximum number of distinct counters and gauges. Further names share a single overflow slot named `overflow`.
+constexpr std::size_t capacity = 128;
+
+/// Number of frames of samples kept for the Chrome trace.
+constexpr std::size_t history_capacity = 1024;
+
+/// Value of a counter or gauge at the end of the previous frame.
+struct sample
+{
+	const char* name;
+	
+	/// `true` if the statistic is a gauge, `false` if it's a counter.
+	bool gauge;
+	
+	/// Count of the previous frame for counters, or value at the end of the previous frame for gauges.
+	std::int64_t value;
+	
+	/// Mean count per frame over the sample history for counters, or mean value for gauges.
+	double mean;
+	
+	/// Maximum over the sample history.
+	std::int64_t max;
+};
+
+/// Ends the current frame, moving the counts of the frame into those of the previous frame and sampling all statistics into the history. Should be called once per frame, by a single thread.
+void end_frame();
+
+/// Returns the samples of every statistic at the end of the previous frame, in order of registration.
+std::vector<sample> get_samples();
+
+/**
+ * Writes the sample history of every statistic as Chrome trace counter events, following other trace events.
+ *
+ * @param stream Output stream.
+ * @param event_count Number of events already written, which determines whether the first event must be preceded by a separator.
+ * @return Number of events written.
+ */
+std::size_t write_chrome_trace_events(std::ostream& stream, std::size_t event_count);
+
+} // namespace counters
+} // namespace debug
+
+#endif // ANTKEEPER_DEBUG_COUNTERS_HPP
@@ -23,9 +23,13 @@
 /// Debugging functions and classes
 namespace debug {}
 
+#include "allocation-tracker.hpp"
 #include "ansi-codes.hpp"
 #include "cli.hpp"
+#include "counters.hpp"
 #include "logger.hpp"
 #include "performance-sampler.hpp"
+#include "profiler.hpp"
+#include "startup-profiler.hpp"
 
 #endif // ANTKEEPER_DEBUG_HPP
@@ -0,0 +1,230 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "debug/draw.hpp"
+#include "math/math.hpp"
+#include <atomic>
+#include <cmath>
+#include <mutex>
+
+namespace debug {
+namespace draw {
+
+/// Names of the layers, in order of their bits.
+static constexpr const char* layer_names[] =
+{
+	"hyperoctree",
+	"mesh_accelerator",
+	"shadow_cascades",
+	"terrain_patches",
+	"shadow_atlas"
+};
+
+static constexpr std::size_t layer_count = sizeof(layer_names) / sizeof(layer_names[0]);
+
+const char* get_layer_name(layer layer)
+{
+	for (std::size_t i = 0; i < layer_count; ++i)
+	{
+		if (layer == (1u << i))
+			return layer_names[i];
+	}
+	
+	return nullptr;
+}
+
+std::uint32_t find_layer(std::string_view name)
+{
+	if (name == "all")
+		return (1u << layer_count) - 1;
+	
+	for (std::size_t i = 0; i < layer_count; ++i)
+	{
+		if (name == layer_names[i])
+			return 1u << i;
+	}
+	
+	return 0;
+}
+
+#if defined(DEBUG)
+
+static std::atomic<std::uint32_t> enabled_layers{0};
+
+/// Primitives submitted since the previous call to end_frame(), guarded by pending_mutex.
+static frame pending_frame;
+static std::mutex pending_mutex;
+
+/// Primitives of the frame being drawn.
+static frame drawn_frame;
+
+/// Pairs of corners of a box, indexed by bits of their x, y, and z coordinates, which share an edge.
+static constexpr std::uint8_t box_edges[12][2] =
+{
+	{0, 1}, {2, 3}, {4, 5}, {6, 7},
+	{0, 2}, {1, 3}, {4, 6}, {5, 7},
+	{0, 4}, {1, 5}, {2, 6}, {3, 7}
+};
+
+/// Number of line segments per circle of a sphere.
+static constexpr std::size_t circle_segment_count = 24;
+
+/// Draws the edges of a box given its corners, indexed as in box_edges.
+static void box_corners(const float3 (&corners)[8], const float4& color)
+{
+	std::lock_guard<std::mutex> lock(pending_mutex);
+	for (const auto& edge: box_edges)
+	{
+		pending_frame.lines.push_back({corners[edge[0]], color});
+		pending_frame.lines.push_back({corners[edge[1]], color});
+	}
+}
+
+void set_layers(std::uint32_t layers)
+{
+	enabled_layers.store(layers, std::memory_order_relaxed);
+}
+
+std::uint32_t get_layers()
+{
+	return enabled_layers.load(std::memory_order_relaxed);
+}
+
+bool is_enabled(std::uint32_t layers)
+{
+	return enabled_layers.load(std::memory_order_relaxed) & layers;
+}
+
+void line(const float3& a, const float3& b, const float4& color)
+{
+	std::lock_guard<std::mutex> lock(pending_mutex);
+	pending_frame.lines.push_back({a, color});
+	pending_frame.lines.push_back({b, color});
+}
+
+void box(const geom::aabb<float>& bounds, const float4& color)
+{
+	float3 corners[8];
+	for (std::size_t i = 0; i < 8; ++i)
+	{
+		corners[i] =
+		{
+			(i & 1) ? bounds.max_point.x : bounds.min_point.x,
+			(i & 2) ? bounds.max_point.y : bounds.min_point.y,
+			(i & 4) ? bounds.max_point.z : bounds.min_point.z
+		};
+	}
+	
+	box_corners(corners, color);
+}
+
+void box(const geom::aabb<float>& bounds, const math::transform<float>& transform, const float4& color)
+{
+	float3 corners[8];
+	for (std::size_t i = 0; i < 8; ++i)
+	{
+		corners[i] = transform * float3
+		{
+			(i & 1) ? bounds.max_point.x : bounds.min_point.x,
+			(i & 2) ? bounds.max_point.y : bounds.min_point.y,
+			(i & 4) ? bounds.max_point.z : bounds.min_point.z
+		};
+	}
+	
+	box_corners(corners, color);
+}
+
+void sphere(const float3& center, float radius, const float4& color)
+{
+	std::lock_guard<std::mutex> lock(pending_mutex);
+	
+	// Draw a circle about each axis
+	for (std::size_t axis = 0; axis < 3; ++axis)
+	{
+		const std::size_t u = (axis + 1) % 3;
+		const std::size_t v = (axis + 2) % 3;
+		
+		float3 previous = center;
+		previous[u] += radius;
+		for (std::size_t i = 1; i <= circle_segment_count; ++i)
+		{
+			const float angle = math::two_pi<float> * static_cast<float>(i) / static_cast<float>(circle_segment_count);
+			float3 point = center;
+			point[u] += std::cos(angle) * radius;
+			point[v] += std::sin(angle) * radius;
+			
+			pending_frame.lines.push_back({previous, color});
+			pending_frame.lines.push_back({point, color});
+			previous = point;
+		}
+	}
+}
+
+void frustum(const float4x4& view_projection, const float4& color)
+{
+	// Unproject the corners of the clip volume
+	const float4x4 inverse_view_projection = math::inverse(view_projection);
+	float3 corners[8];
+	for (std::size_t i = 0; i < 8; ++i)
+	{
+		const float4 clip =
+		{
+			(i & 1) ? 1.0f : -1.0f,
+			(i & 2) ? 1.0f : -1.0f,
+			(i & 4) ? 1.0f : 0.0f,
+			1.0f
+		};
+		
+		const float4 world = inverse_view_projection * clip;
+		corners[i] = float3{world.x, world.y, world.z} / world.w;
+	}
+	
+	box_corners(corners, color);
+}
+
+void text(const float3& position, std::string_view text, const float4& color)
+{
+	std::lock_guard<std::mutex> lock(pending_mutex);
+	pending_frame.labels.push_back({position, color, std::string(text)});
+}
+
+void end_frame()
+{
+	// Swap rather than move, so that the capacity of both frames is reused
+	drawn_frame.lines.clear();
+	drawn_frame.labels.clear();
+	
+	std::lock_guard<std::mutex> lock(pending_mutex);
+	std::swap(pending_frame, drawn_frame);
+}
+
+#endif // DEBUG
+
+const frame& get_frame()
+{
+	#if defined(DEBUG)
+		return drawn_frame;
+	#else
+		static const frame empty_frame;
+		return empty_frame;
+	#endif
+}
+
+} // namespace draw
+} // namespace debug
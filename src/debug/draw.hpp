@@ -0,0 +1,193 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ANTKEEPER_DEBUG_DRAW_HPP
+#define ANTKEEPER_DEBUG_DRAW_HPP
+
+#include "geom/aabb.hpp"
+#include "geom/hyperoctree.hpp"
+#include "geom/morton.hpp"
+#include "math/transform-type.hpp"
+#include "utility/fundamental-types.hpp"
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace debug {
+
+/**
+ * Immediate-mode debug drawing of lines, boxes, spheres, frustums, and text labels.
+ *
+ * Primitives may be submitted from any thread, in world space, and are accumulated until the end of the frame, when end_frame() moves them into the frame drawn by debug_draw_pass. Primitives are therefore drawn for exactly one frame, and should be submitted by code which runs once per frame, such as render passes or upload functions, rather than by fixed-timestep updates, which may run several times or not at all between frames.
+ *
+ * Primitives are only accumulated in debug builds. In release builds every function is an empty inline function and is_enabled() is `constexpr false`, so that submissions, and the work guarded by is_enabled(), compile to nothing.
+ */
+namespace draw {
+
+/// Groups of primitives which can be toggled individually.
+enum layer: std::uint32_t
+{
+	/// Nodes of hyperoctrees.
+	hyperoctree_nodes = 1 << 0,
+	
+	/// Leaf cells of mesh accelerators.
+	mesh_accelerator_cells = 1 << 1,
+	
+	/// Light clip volumes of shadow map cascades.
+	shadow_cascades = 1 << 2,
+	
+	/// Bounds and levels of detail of visible terrain patches.
+	terrain_patches = 1 << 3,
+	
+	/// Light clip volumes of the shadow atlas tiles of spot and point lights.
+	shadow_atlas = 1 << 4
+};
+
+/// Line vertex, with a world-space position.
+struct line_vertex
+{
+	float3 position;
+	float4 color;
+};
+
+/// Text label, anchored at a world-space position.
+struct label
+{
+	float3 position;
+	float4 color;
+	std::string text;
+};
+
+/// Primitives of a single frame.
+struct frame
+{
+	/// Pairs of line endpoints.
+	std::vector<line_vertex> lines;
+	
+	std::vector<label> labels;
+};
+
+/**
+ * Returns the name of a layer, as accepted by find_layer().
+ *
+ * @param layer Layer.
+ * @return Name of the layer, or `nullptr` if @p layer is not a single layer.
+ */
+const char* get_layer_name(layer layer);
+
+/**
+ * Finds a layer by name.
+ *
+ * @param name Name of a layer.
+ * @return Layer, or `0` if no layer has the name.
+ */
+std::uint32_t find_layer(std::string_view name);
+
+#if defined(DEBUG)
+
+/// Enables or disables layers. All layers are disabled by default.
+void set_layers(std::uint32_t layers);
+
+/// Returns the bitmask of enabled layers.
+std::uint32_t get_layers();
+
+/// Returns `true` if any of the given layers are enabled.
+bool is_enabled(std::uint32_t layers);
+
+/// Draws a line segment.
+void line(const float3& a, const float3& b, const float4& color);
+
+/// Draws the edges of an axis-aligned box.
+void box(const geom::aabb<float>& bounds, const float4& color);
+
+/// Draws the edges of a box, given its bounds in a local space and the transform from local space to world space.
+void box(const geom::aabb<float>& bounds, const math::transform<float>& transform, const float4& color);
+
+/// Draws a sphere as three orthogonal circles.
+void sphere(const float3& center, float radius, const float4& color);
+
+/**
+ * Draws the edges of the clip volume of a view-projection matrix.
+ *
+ * @param view_projection Matrix which transforms world space into clip space, with depth on `[0, 1]`.
+ * @param color Line color.
+ */
+void frustum(const float4x4& view_projection, const float4& color);
+
+/// Draws a text label, which faces the screen at a constant size.
+void text(const float3& position, std::string_view text, const float4& color);
+
+/**
+ * Ends the frame, replacing the drawn frame with the primitives submitted since the previous call. Should be called once per frame, by the thread which renders debug_draw_pass, before it renders.
+ */
+void end_frame();
+
+#else
+
+inline void set_layers(std::uint32_t layers) {}
+inline std::uint32_t get_layers() { return 0; }
+inline constexpr bool is_enabled(std::uint32_t layers) { return false; }
+inline void line(const float3& a, const float3& b, const float4& color) {}
+inline void box(const geom::aabb<float>& bounds, const float4& color) {}
+inline void box(const geom::aabb<float>& bounds, const math::transform<float>& transform, const float4& color) {}
+inline void sphere(const float3& center, float radius, const float4& color) {}
+inline void frustum(const float4x4& view_projection, const float4& color) {}
+inline void text(const float3& position, std::string_view text, const float4& color) {}
+inline void end_frame() {}
+
+#endif // DEBUG
+
+/// Returns the primitives of the drawn frame, which are always empty in release builds. Valid until the next call to end_frame().
+const frame& get_frame();
+
+/**
+ * Draws the nodes of an octree, if the hyperoctree nodes layer is enabled, with leaf nodes brighter than interior nodes.
+ *
+ * @param octree Octree of any depth and storage.
+ * @param bounds World-space bounds of the root node.
+ * @param color Color of leaf nodes.
+ */
+template <std::size_t D, class T, geom::hyperoctree_storage S>
+void octree(const geom::hyperoctree<3, D, T, S>& octree, const geom::aabb<float>& bounds, const float4& color)
+{
+	if (!is_enabled(hyperoctree_nodes))
+		return;
+	
+	typedef geom::hyperoctree<3, D, T, S> octree_type;
+	const float4 interior_color = {color.x, color.y, color.z, color.w * 0.25f};
+	for (auto it = octree.begin(); it != octree.end(); ++it)
+	{
+		const typename octree_type::node_type node = *it;
+		const T depth = octree_type::depth(node);
+		
+		// Locate the node within the root bounds by its Morton code
+		std::uint64_t x, y, z;
+		geom::morton::decode<std::uint64_t>(static_cast<std::uint64_t>(octree_type::location(node)), x, y, z);
+		const float3 size = (bounds.max_point - bounds.min_point) / static_cast<float>(std::uint64_t(1) << depth);
+		const float3 min_point = bounds.min_point + size * float3{static_cast<float>(x), static_cast<float>(y), static_cast<float>(z)};
+		
+		box({min_point, min_point + size}, octree.is_leaf(node) ? color : interior_color);
+	}
+}
+
+} // namespace draw
+} // namespace debug
+
+#endif // ANTKEEPER_DEBUG_DRAW_HPP
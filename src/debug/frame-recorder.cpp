@@ -0,0 +1,176 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "debug/frame-recorder.hpp"
+#include "gl/framebuffer.hpp"
+#include "gl/readback-buffer.hpp"
+#include <stb/stb_image_write.h>
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <sstream>
+
+namespace debug {
+
+frame_recorder::frame_recorder(job_system* jobs):
+	jobs(jobs),
+	pending_encodes(0),
+	max_pending_encodes(8),
+	ring_index(0),
+	recording(false),
+	recording_format(frame_format::png),
+	recorded_frame_count(0)
+{
+	for (slot& slot: ring)
+	{
+		slot.buffer = new gl::readback_buffer();
+		slot.format = frame_format::png;
+	}
+}
+
+frame_recorder::~frame_recorder()
+{
+	for (slot& slot: ring)
+		if (slot.buffer->is_pending())
+			encode(slot);
+	jobs->wait(encode_counter);
+	
+	for (slot& slot: ring)
+		delete slot.buffer;
+}
+
+void frame_recorder::save_frame(const std::string& path)
+{
+	screenshot_paths.push_back(path);
+}
+
+void frame_recorder::start_recording(const std::string& directory, frame_format format)
+{
+	recording = true;
+	recording_directory = directory;
+	recording_format = format;
+	recorded_frame_count = 0;
+}
+
+void frame_recorder::stop_recording()
+{
+	recording = false;
+}
+
+void frame_recorder::set_max_pending_encodes(std::size_t count)
+{
+	max_pending_encodes = std::max<std::size_t>(count, 1);
+}
+
+void frame_recorder::capture(const gl::framebuffer& framebuffer)
+{
+	if (recording)
+	{
+		std::ostringstream stream;
+		stream << recording_directory << "frame-" << std::setw(6) << std::setfill('0') << recorded_frame_count;
+		stream << ((recording_format == frame_format::png) ? ".png" : ".ppm");
+		read(framebuffer, stream.str(), recording_format);
+		++recorded_frame_count;
+	}
+	
+	if (!screenshot_paths.empty())
+	{
+		read(framebuffer, screenshot_paths.front(), frame_format::png);
+		screenshot_paths.pop_front();
+	}
+}
+
+void frame_recorder::poll()
+{
+	// Encode completed readbacks in the order in which they were read
+	for (std::size_t i = 0; i < ring_size; ++i)
+	{
+		slot& slot = ring[(ring_index + i) % ring_size];
+		if (slot.buffer->is_ready())
+			encode(slot);
+	}
+}
+
+void frame_recorder::read(const gl::framebuffer& framebuffer, const std::string& path, frame_format format)
+{
+	slot& slot = ring[ring_index];
+	ring_index = (ring_index + 1) % ring_size;
+	
+	// Encode the oldest readback if it hasn't completed yet, which stalls only if the GPU is more than a ring behind
+	if (slot.buffer->is_pending())
+		encode(slot);
+	
+	slot.path = path;
+	slot.format = format;
+	slot.buffer->read_color(framebuffer);
+}
+
+void frame_recorder::encode(slot& slot)
+{
+	// Wait for encoding to catch up if too many frames are in flight
+	if (pending_encodes.load(std::memory_order_acquire) >= max_pending_encodes)
+		jobs->wait(encode_counter);
+	
+	// Copy pixels out of the mapped buffer, so that it can be reused immediately
+	const std::array<int, 2> dimensions = slot.buffer->get_dimensions();
+	auto pixels = std::make_shared<std::vector<unsigned char>>(static_cast<std::size_t>(dimensions[0]) * static_cast<std::size_t>(dimensions[1]) * 3);
+	const void* mapped_pixels = slot.buffer->map();
+	if (mapped_pixels)
+		std::memcpy(pixels->data(), mapped_pixels, pixels->size());
+	slot.buffer->unmap();
+	
+	if (!mapped_pixels)
+		return;
+	
+	pending_encodes.fetch_add(1, std::memory_order_relaxed);
+	const std::string path = slot.path;
+	const frame_format format = slot.format;
+	std::atomic<std::size_t>* pending_encodes = &this->pending_encodes;
+	jobs->submit
+	(
+		[path, format, dimensions, pixels, pending_encodes]()
+		{
+			write(path, format, dimensions[0], dimensions[1], *pixels);
+			pending_encodes->fetch_sub(1, std::memory_order_release);
+		},
+		&encode_counter
+	);
+}
+
+void frame_recorder::write(const std::string& path, frame_format format, int width, int height, const std::vector<unsigned char>& pixels)
+{
+	const std::size_t row_size = static_cast<std::size_t>(width) * 3;
+	
+	if (format == frame_format::png)
+	{
+		stbi_flip_vertically_on_write(1);
+		stbi_write_png(path.c_str(), width, height, 3, pixels.data(), static_cast<int>(row_size));
+		return;
+	}
+	
+	// Write rows from top to bottom
+	std::ofstream stream(path, std::ios::binary);
+	stream << "P6\n" << width << " " << height << "\n255\n";
+	for (int y = height - 1; y >= 0; --y)
+		stream.write(reinterpret_cast<const char*>(pixels.data() + row_size * static_cast<std::size_t>(y)), row_size);
+}
+
+} // namespace debug
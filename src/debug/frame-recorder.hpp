@@ -0,0 +1,153 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ANTKEEPER_DEBUG_FRAME_RECORDER_HPP
+#define ANTKEEPER_DEBUG_FRAME_RECORDER_HPP
+
+#include "utility/job-system.hpp"
+#include <atomic>
+#include <cstdlib>
+#include <deque>
+#include <string>
+#include <vector>
+
+namespace gl
+{
+	class framebuffer;
+	class readback_buffer;
+}
+
+namespace debug {
+
+/// Enumerates the file formats of captured frames.
+enum class frame_format
+{
+	// PNG, compressed
+	png,
+	
+	// Binary PPM, an uncompressed header followed by raw 8-bit RGB rows from top to bottom
+	raw
+};
+
+/**
+ * Captures rendered frames to disk without stalling the pipeline.
+ *
+ * Frames are read back into a ring of pixel pack buffers and mapped a few frames later, once the GPU has finished copying them, or when their buffer is next needed. Mapped pixels are copied out and encoded by jobs, so that neither the readback nor the encoding blocks the rendering thread. In recording mode, every frame is captured into a numbered file. Encoding jobs in flight are capped, past which the rendering thread waits for encoding to catch up rather than drop frames or grow memory without bound.
+ */
+class frame_recorder
+{
+public:
+	/// Number of pixel pack buffers in the readback ring, and the number of frames after which a readback is mapped at the latest.
+	static constexpr std::size_t ring_size = 3;
+	
+	/**
+	 * Creates a frame recorder.
+	 *
+	 * @param jobs Job system on which frames are encoded.
+	 */
+	explicit frame_recorder(job_system* jobs);
+	
+	/// Maps all pending readbacks and waits for their encoding to finish.
+	~frame_recorder();
+	
+	/**
+	 * Queues a PNG capture of the next frame.
+	 *
+	 * @param path Path to the file to which the frame will be saved.
+	 */
+	void save_frame(const std::string& path);
+	
+	/**
+	 * Starts capturing every frame.
+	 *
+	 * @param directory Path to the directory, with a trailing separator, into which frames will be saved as `frame-000000.png`, `frame-000001.png`, etc.
+	 * @param format File format of the frames.
+	 */
+	void start_recording(const std::string& directory, frame_format format);
+	
+	/// Stops capturing every frame. Pending frames are still saved.
+	void stop_recording();
+	
+	/**
+	 * Sets the maximum number of frames being encoded at once.
+	 *
+	 * @param count Maximum number of encoding jobs in flight.
+	 */
+	void set_max_pending_encodes(std::size_t count);
+	
+	/**
+	 * Begins reading back a completed frame, if one has been requested. Must be called by the thread which owns the OpenGL context, before the frame's buffers are swapped.
+	 *
+	 * @param framebuffer Framebuffer containing the frame.
+	 */
+	void capture(const gl::framebuffer& framebuffer);
+	
+	/// Maps the readbacks which have completed and submits them for encoding. Must be called by the thread which owns the OpenGL context.
+	void poll();
+	
+	/// Returns `true` if every frame is being captured.
+	bool is_recording() const;
+	
+	/// Returns the number of frames captured since recording was last started.
+	std::size_t get_recorded_frame_count() const;
+
+private:
+	/// Readback of a single frame, and the file to which it will be saved.
+	struct slot
+	{
+		gl::readback_buffer* buffer;
+		std::string path;
+		frame_format format;
+	};
+	
+	/// Begins reading a frame back into the next slot of the ring.
+	void read(const gl::framebuffer& framebuffer, const std::string& path, frame_format format);
+	
+	/// Maps the pending readback of a slot, copies its pixels, and submits them for encoding.
+	void encode(slot& slot);
+	
+	/// Saves pixels, in rows from bottom to top, to a file.
+	static void write(const std::string& path, frame_format format, int width, int height, const std::vector<unsigned char>& pixels);
+	
+	job_system* jobs;
+	job_system::counter encode_counter;
+	std::atomic<std::size_t> pending_encodes;
+	std::size_t max_pending_encodes;
+	slot ring[ring_size];
+	std::size_t ring_index;
+	std::deque<std::string> screenshot_paths;
+	bool recording;
+	std::string recording_directory;
+	frame_format recording_format;
+	std::size_t recorded_frame_count;
+};
+
+inline bool frame_recorder::is_recording() const
+{
+	return recording;
+}
+
+inline std::size_t frame_recorder::get_recorded_frame_count() const
+{
+	return recorded_frame_count;
+}
+
+} // namespace debug
+
+#endif // ANTKEEPER_DEBUG_FRAME_RECORDER_HPP
@@ -0,0 +1,225 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "debug/gl-monitor.hpp"
+#include "debug/counters.hpp"
+#include "debug/logger.hpp"
+#include <glad/glad.h>
+#include <atomic>
+#include <cstring>
+#include <iomanip>
+#include <mutex>
+#include <sstream>
+#include <string>
+
+// KHR_debug enums, which may be absent from the loader's headers
+#ifndef GL_DEBUG_OUTPUT
+	#define GL_DEBUG_OUTPUT 0x92E0
+#endif
+#ifndef GL_DEBUG_TYPE_ERROR
+	#define GL_DEBUG_TYPE_ERROR 0x824C
+	#define GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR 0x824D
+	#define GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR 0x824E
+	#define GL_DEBUG_TYPE_PERFORMANCE 0x8250
+#endif
+#ifndef GL_DEBUG_SEVERITY_HIGH
+	#define GL_DEBUG_SEVERITY_HIGH 0x9146
+	#define GL_DEBUG_SEVERITY_MEDIUM 0x9147
+	#define GL_DEBUG_SEVERITY_LOW 0x9148
+	#define GL_DEBUG_SEVERITY_NOTIFICATION 0x826B
+#endif
+
+namespace debug {
+
+/// KHR_debug message callback, declared here as the loader may have been generated without `GLDEBUGPROC`.
+typedef void (APIENTRY *debug_message_callback_type)(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar* message, const void* user_param);
+typedef void (APIENTRY *debug_message_callback_function)(debug_message_callback_type callback, const void* user_param);
+typedef void (APIENTRY *debug_message_control_function)(GLenum source, GLenum type, GLenum severity, GLsizei count, const GLuint* ids, GLboolean enabled);
+
+static std::atomic<logger*> monitor_logger{nullptr};
+static std::atomic<std::int64_t> stall_threshold_ns{1000000};
+static debug_message_callback_function debug_message_callback = nullptr;
+
+/// Reports at most a number of messages per one-second window, counting the rest.
+static std::mutex report_mutex;
+static std::size_t rate_limit = 4;
+static std::chrono::steady_clock::time_point window_start;
+static std::size_t window_report_count = 0;
+static std::size_t suppressed_report_count = 0;
+
+/**
+ * Reports a message to the logger of the monitor, unless the rate limit has been reached.
+ *
+ * @param text Message text.
+ * @param error `true` if the message should be logged as an error, `false` for a warning.
+ */
+static void report(const std::string& text, bool error)
+{
+	logger* log = monitor_logger.load(std::memory_order_acquire);
+	if (!log)
+		return;
+	
+	std::size_t suppressed = 0;
+	{
+		std::lock_guard<std::mutex> lock(report_mutex);
+		
+		const auto now = std::chrono::steady_clock::now();
+		if (now - window_start >= std::chrono::seconds(1))
+		{
+			window_start = now;
+			window_report_count = 0;
+			suppressed = suppressed_report_count;
+			suppressed_report_count = 0;
+		}
+		
+		if (window_report_count >= rate_limit)
+		{
+			++suppressed_report_count;
+			return;
+		}
+		++window_report_count;
+	}
+	
+	if (suppressed)
+		log->warning("Suppressed " + std::to_string(suppressed) + " OpenGL warnings");
+	
+	if (error)
+		log->error(text);
+	else
+		log->warning(text);
+}
+
+static void APIENTRY handle_debug_message(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar* message, const void* user_param)
+{
+	static debug::counter performance_warnings("gl.performance_warnings");
+	static debug::counter errors("gl.errors");
+	
+	const char* type_name;
+	bool error = false;
+	switch (type)
+	{
+		case GL_DEBUG_TYPE_PERFORMANCE:
+			performance_warnings.add();
+			type_name = "performance";
+			break;
+		
+		case GL_DEBUG_TYPE_ERROR:
+			errors.add();
+			type_name = "error";
+			error = true;
+			break;
+		
+		case GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR:
+			type_name = "undefined behavior";
+			break;
+		
+		default:
+			type_name = "deprecated behavior";
+			break;
+	}
+	
+	const std::size_t message_length = (length < 0) ? std::strlen(message) : static_cast<std::size_t>(length);
+	report("OpenGL " + std::string(type_name) + " message " + std::to_string(id) + ": " + std::string(message, message_length), error);
+}
+
+gl_stall_scope::gl_stall_scope(const char* call):
+	call(call),
+	start(std::chrono::steady_clock::now())
+{}
+
+gl_stall_scope::~gl_stall_scope()
+{
+	const std::int64_t duration = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+	if (duration < stall_threshold_ns.load(std::memory_order_relaxed))
+		return;
+	
+	static debug::counter stalls("gl.stalls");
+	static debug::counter stall_us("gl.stall_us");
+	stalls.add();
+	stall_us.add(duration / 1000);
+	
+	std::ostringstream stream;
+	stream << "OpenGL stall: " << call << " took " << std::fixed << std::setprecision(2) << static_cast<double>(duration) / 1000000.0 << " ms";
+	report(stream.str(), false);
+}
+
+namespace gl_monitor {
+
+bool install(logger* logger, void* (*get_proc_address)(const char*))
+{
+	monitor_logger.store(logger, std::memory_order_release);
+	
+	// Check for KHR_debug, which is core since OpenGL 4.3
+	bool supported = false;
+	GLint extension_count = 0;
+	glGetIntegerv(GL_NUM_EXTENSIONS, &extension_count);
+	for (GLint i = 0; i < extension_count && !supported; ++i)
+	{
+		const char* name = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, static_cast<GLuint>(i)));
+		supported = (name && !std::strcmp(name, "GL_KHR_debug"));
+	}
+	
+	debug_message_callback = reinterpret_cast<debug_message_callback_function>(get_proc_address("glDebugMessageCallback"));
+	auto debug_message_control = reinterpret_cast<debug_message_control_function>(get_proc_address("glDebugMessageControl"));
+	if (!supported || !debug_message_callback || !debug_message_control)
+	{
+		debug_message_callback = nullptr;
+		return false;
+	}
+	
+	// Enable only performance, error, deprecated, and undefined behavior messages, excluding notifications, which some drivers emit for every buffer allocation
+	debug_message_control(GL_DONT_CARE, GL_DONT_CARE, GL_DONT_CARE, 0, nullptr, GL_FALSE);
+	const GLenum types[] = {GL_DEBUG_TYPE_PERFORMANCE, GL_DEBUG_TYPE_ERROR, GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR, GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR};
+	const GLenum severities[] = {GL_DEBUG_SEVERITY_HIGH, GL_DEBUG_SEVERITY_MEDIUM, GL_DEBUG_SEVERITY_LOW};
+	for (GLenum type: types)
+		for (GLenum severity: severities)
+			debug_message_control(GL_DONT_CARE, type, severity, 0, nullptr, GL_TRUE);
+	
+	// Messages may be emitted asynchronously by driver threads, which the rate limiter and logger tolerate
+	debug_message_callback(handle_debug_message, nullptr);
+	glEnable(GL_DEBUG_OUTPUT);
+	
+	return true;
+}
+
+void uninstall()
+{
+	if (debug_message_callback)
+	{
+		glDisable(GL_DEBUG_OUTPUT);
+		debug_message_callback(nullptr, nullptr);
+		debug_message_callback = nullptr;
+	}
+	
+	monitor_logger.store(nullptr, std::memory_order_release);
+}
+
+void set_stall_threshold(double seconds)
+{
+	stall_threshold_ns.store(static_cast<std::int64_t>(seconds * 1e9), std::memory_order_relaxed);
+}
+
+void set_rate_limit(std::size_t count)
+{
+	std::lock_guard<std::mutex> lock(report_mutex);
+	rate_limit = count;
+}
+
+} // namespace gl_monitor
+} // namespace debug
@@ -0,0 +1,97 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ANTKEEPER_DEBUG_GL_MONITOR_HPP
+#define ANTKEEPER_DEBUG_GL_MONITOR_HPP
+
+#include <chrono>
+#include <cstddef>
+
+namespace debug {
+
+class logger;
+
+/**
+ * Scoped timer of an OpenGL call which may implicitly synchronize the CPU with the GPU, such as a read back of pixels or an update of a buffer which is still in use. Calls which take longer than the stall threshold of the GL monitor are counted by the `gl.stalls` counter, with their durations accumulated by the `gl.stall_us` counter, and reported to the logger of the GL monitor, subject to its rate limit.
+ *
+ * @code{.cpp}
+ * {
+ *     debug::gl_stall_scope stall("glReadPixels");
+ *     glReadPixels(0, 0, w, h, GL_RGB, GL_UNSIGNED_BYTE, pixels);
+ * }
+ * @endcode
+ */
+class gl_stall_scope
+{
+public:
+	/**
+	 * Begins timing a call.
+	 *
+	 * @param call Name of the call. Only the pointer is recorded, so the string must have static storage duration.
+	 */
+	explicit gl_stall_scope(const char* call);
+	
+	/// Ends timing the call, reporting it if it stalled.
+	~gl_stall_scope();
+	
+	gl_stall_scope(const gl_stall_scope&) = delete;
+	gl_stall_scope& operator=(const gl_stall_scope&) = delete;
+
+private:
+	const char* call;
+	std::chrono::steady_clock::time_point start;
+};
+
+/**
+ * Functions which monitor the OpenGL driver for performance warnings and stalls.
+ *
+ * Performance, error, and undefined behavior messages of the `KHR_debug` extension are counted by the `gl.performance_warnings` and `gl.errors` counters and reported to a logger. Both driver messages and the stalls of gl_stall_scope are rate limited, so that a warning repeated every frame doesn't flood the log; messages in excess of the rate limit are counted, then summarized once the limit allows.
+ */
+namespace gl_monitor {
+
+/**
+ * Installs a `KHR_debug` message callback into the current OpenGL context, enabling only the message types of interest. Must be called by the thread which owns the OpenGL context. Messages are only guaranteed to be emitted by debug contexts, though many drivers emit performance warnings in any context.
+ *
+ * @param logger Logger to which messages and stalls are reported, which must outlive the monitor.
+ * @param get_proc_address Function which returns the address of an OpenGL function, as the loader may have been generated without `KHR_debug`.
+ * @return `true` if the callback was installed, `false` if the context doesn't support `KHR_debug`. Stalls are reported either way.
+ */
+bool install(logger* logger, void* (*get_proc_address)(const char*));
+
+/// Removes the message callback and stops reporting stalls. Must be called by the thread which owns the OpenGL context, before it is destroyed.
+void uninstall();
+
+/**
+ * Sets the duration beyond which a call timed by gl_stall_scope is reported as a stall.
+ *
+ * @param seconds Stall threshold, in seconds. The default is one millisecond.
+ */
+void set_stall_threshold(double seconds);
+
+/**
+ * Sets the maximum number of messages and stalls reported per second.
+ *
+ * @param count Maximum reports per second. The default is `4`.
+ */
+void set_rate_limit(std::size_t count);
+
+} // namespace gl_monitor
+} // namespace debug
+
+#endif // ANTKEEPER_DEBUG_GL_MONITOR_HPP
@@ -0,0 +1,283 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "debug/input-recorder.hpp"
+#include "event/event-dispatcher.hpp"
+#include "input/keyboard.hpp"
+#include "input/mouse.hpp"
+#include <fstream>
+#include <stdexcept>
+
+namespace debug {
+
+/// Signature of input recordings, "AKIR" in little-endian byte order.
+static constexpr std::uint32_t recording_signature = 0x52494B41;
+
+/// Version of the input recording format. Changing the layout of records requires incrementing the version.
+static constexpr std::uint32_t recording_version = 1;
+
+input_recorder::input_recorder(::event_dispatcher* event_dispatcher, input::keyboard* keyboard, input::mouse* mouse):
+	event_dispatcher(event_dispatcher),
+	keyboard(keyboard),
+	mouse(mouse),
+	recording(false),
+	replaying(false),
+	seed(0),
+	update_index(0),
+	replay_position(0)
+{
+	controller.set_event_dispatcher(event_dispatcher);
+}
+
+input_recorder::~input_recorder()
+{
+	if (recording)
+	{
+		try
+		{
+			stop_recording();
+		}
+		catch (const std::exception&)
+		{}
+	}
+}
+
+void input_recorder::start_recording(const std::string& path, std::uint64_t seed)
+{
+	if (replaying || recording)
+		return;
+	
+	recording_path = path;
+	this->seed = seed;
+	update_index = 0;
+	records.clear();
+	recording = true;
+	subscribe();
+}
+
+void input_recorder::stop_recording()
+{
+	if (!recording)
+		return;
+	
+	unsubscribe();
+	recording = false;
+	
+	std::ofstream stream(recording_path, std::ios::binary);
+	auto write = [&stream](const auto& value)
+	{
+		stream.write(reinterpret_cast<const char*>(&value), sizeof(value));
+	};
+	
+	write(recording_signature);
+	write(recording_version);
+	write(seed);
+	write(static_cast<std::uint64_t>(records.size()));
+	for (const input_record& record: records)
+	{
+		write(record.update_index);
+		write(record.type);
+		for (std::int32_t parameter: record.parameters)
+			write(parameter);
+		write(record.value);
+	}
+	
+	if (!stream)
+		throw std::runtime_error("Failed to write input recording \"" + recording_path + "\"");
+}
+
+void input_recorder::start_replay(const std::string& path)
+{
+	if (recording)
+		return;
+	
+	std::ifstream stream(path, std::ios::binary);
+	if (!stream)
+		throw std::runtime_error("Failed to open input recording \"" + path + "\"");
+	
+	auto read = [&stream](auto& value)
+	{
+		if (!stream.read(reinterpret_cast<char*>(&value), sizeof(value)))
+			throw std::runtime_error("Input recording truncated");
+	};
+	
+	std::uint32_t signature = 0;
+	std::uint32_t version = 0;
+	std::uint64_t count = 0;
+	read(signature);
+	read(version);
+	if (signature != recording_signature)
+		throw std::runtime_error("Invalid input recording signature");
+	if (version != recording_version)
+		throw std::runtime_error("Unsupported input recording version " + std::to_string(version));
+	read(seed);
+	read(count);
+	
+	records.resize(static_cast<std::size_t>(count));
+	for (input_record& record: records)
+	{
+		read(record.update_index);
+		read(record.type);
+		for (std::int32_t& parameter: record.parameters)
+			read(parameter);
+		read(record.value);
+		
+		if (record.type > record_type::game_controller_button_released)
+			throw std::runtime_error("Invalid input record type");
+	}
+	
+	update_index = 0;
+	replay_position = 0;
+	replaying = true;
+}
+
+void input_recorder::stop_replay()
+{
+	replaying = false;
+}
+
+void input_recorder::update()
+{
+	if (!recording && !replaying)
+		return;
+	
+	++update_index;
+	
+	// Queue the events of this update, to be dispatched by the following event dispatcher update
+	if (replaying)
+	{
+		while (replay_position < records.size() && records[replay_position].update_index <= update_index)
+			replay(records[replay_position++]);
+	}
+}
+
+void input_recorder::handle_event(const key_pressed_event& event)
+{
+	record(record_type::key_pressed, static_cast<std::int32_t>(event.scancode));
+}
+
+void input_recorder::handle_event(const key_released_event& event)
+{
+	record(record_type::key_released, static_cast<std::int32_t>(event.scancode));
+}
+
+void input_recorder::handle_event(const mouse_moved_event& event)
+{
+	record(record_type::mouse_moved, event.x, event.y, event.dx, event.dy);
+}
+
+void input_recorder::handle_event(const mouse_wheel_scrolled_event& event)
+{
+	record(record_type::mouse_wheel_scrolled, event.x, event.y);
+}
+
+void input_recorder::handle_event(const mouse_button_pressed_event& event)
+{
+	record(record_type::mouse_button_pressed, event.button, event.x, event.y);
+}
+
+void input_recorder::handle_event(const mouse_button_released_event& event)
+{
+	record(record_type::mouse_button_released, event.button, event.x, event.y);
+}
+
+void input_recorder::handle_event(const game_controller_axis_moved_event& event)
+{
+	record(record_type::game_controller_axis_moved, static_cast<std::int32_t>(event.axis), 0, 0, 0, event.value);
+}
+
+void input_recorder::handle_event(const game_controller_button_pressed_event& event)
+{
+	record(record_type::game_controller_button_pressed, static_cast<std::int32_t>(event.button));
+}
+
+void input_recorder::handle_event(const game_controller_button_released_event& event)
+{
+	record(record_type::game_controller_button_released, static_cast<std::int32_t>(event.button));
+}
+
+void input_recorder::record(record_type type, std::int32_t a, std::int32_t b, std::int32_t c, std::int32_t d, float value)
+{
+	if (recording)
+		records.push_back({update_index, type, {a, b, c, d}, value});
+}
+
+void input_recorder::replay(const input_record& record)
+{
+	const std::int32_t* p = record.parameters;
+	switch (record.type)
+	{
+		case record_type::key_pressed:
+			keyboard->press(static_cast<input::scancode>(p[0]));
+			break;
+		case record_type::key_released:
+			keyboard->release(static_cast<input::scancode>(p[0]));
+			break;
+		case record_type::mouse_moved:
+			mouse->move(p[0], p[1], p[2], p[3]);
+			break;
+		case record_type::mouse_wheel_scrolled:
+			mouse->scroll(p[0], p[1]);
+			break;
+		case record_type::mouse_button_pressed:
+			mouse->press(p[0], p[1], p[2]);
+			break;
+		case record_type::mouse_button_released:
+			mouse->release(p[0], p[1], p[2]);
+			break;
+		case record_type::game_controller_axis_moved:
+			controller.move(static_cast<input::game_controller_axis>(p[0]), record.value);
+			break;
+		case record_type::game_controller_button_pressed:
+			controller.press(static_cast<input::game_controller_button>(p[0]));
+			break;
+		case record_type::game_controller_button_released:
+			controller.release(static_cast<input::game_controller_button>(p[0]));
+			break;
+	}
+}
+
+void input_recorder::subscribe()
+{
+	event_dispatcher->subscribe<key_pressed_event>(this);
+	event_dispatcher->subscribe<key_released_event>(this);
+	event_dispatcher->subscribe<mouse_moved_event>(this);
+	event_dispatcher->subscribe<mouse_wheel_scrolled_event>(this);
+	event_dispatcher->subscribe<mouse_button_pressed_event>(this);
+	event_dispatcher->subscribe<mouse_button_released_event>(this);
+	event_dispatcher->subscribe<game_controller_axis_moved_event>(this);
+	event_dispatcher->subscribe<game_controller_button_pressed_event>(this);
+	event_dispatcher->subscribe<game_controller_button_released_event>(this);
+}
+
+void input_recorder::unsubscribe()
+{
+	event_dispatcher->unsubscribe<key_pressed_event>(this);
+	event_dispatcher->unsubscribe<key_released_event>(this);
+	event_dispatcher->unsubscribe<mouse_moved_event>(this);
+	event_dispatcher->unsubscribe<mouse_wheel_scrolled_event>(this);
+	event_dispatcher->unsubscribe<mouse_button_pressed_event>(this);
+	event_dispatcher->unsubscribe<mouse_button_released_event>(this);
+	event_dispatcher->unsubscribe<game_controller_axis_moved_event>(this);
+	event_dispatcher->unsubscribe<game_controller_button_pressed_event>(this);
+	event_dispatcher->unsubscribe<game_controller_button_released_event>(this);
+}
+
+} // namespace debug
@@ -0,0 +1,214 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef ANTKEEPER_DEBUG_INPUT_RECORDER_HPP
+#define ANTKEEPER_DEBUG_INPUT_RECORDER_HPP
+
+#include "event/event-handler.hpp"
+#include "event/input-events.hpp"
+#include "input/game-controller.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class event_dispatcher;
+
+namespace input
+{
+	class keyboard;
+	class mouse;
+}
+
+namespace debug {
+
+/**
+ * Records the input events dispatched during each fixed-timestep update, and replays them into the same updates of a later session.
+ *
+ * Events are recorded with the index of the update during which they were dispatched, counted from the start of the recording, along with the seed of the random engines. A replay started at the same point of startup, with the same seed, queues each recorded event onto the application's keyboard and mouse, or onto a virtual game controller, immediately before the event dispatcher is updated. As updates have a fixed timestep, the replayed session reproduces the simulation of the recorded session update for update, however its frame rate differs, which makes replays suitable as benchmarks of real play sessions.
+ *
+ * Live input must be ignored while replaying, and recording while replaying is not supported.
+ */
+class input_recorder:
+	public event_handler<key_pressed_event>,
+	public event_handler<key_released_event>,
+	public event_handler<mouse_moved_event>,
+	public event_handler<mouse_wheel_scrolled_event>,
+	public event_handler<mouse_button_pressed_event>,
+	public event_handler<mouse_button_released_event>,
+	public event_handler<game_controller_axis_moved_event>,
+	public event_handler<game_controller_button_pressed_event>,
+	public event_handler<game_controller_button_released_event>
+{
+public:
+	/**
+	 * Creates an input recorder.
+	 *
+	 * @param event_dispatcher Event dispatcher whose input events are recorded, and into which events are replayed.
+	 * @param keyboard Keyboard onto which key events are replayed.
+	 * @param mouse Mouse onto which mouse events are replayed.
+	 */
+	input_recorder(::event_dispatcher* event_dispatcher, input::keyboard* keyboard, input::mouse* mouse);
+	
+	/// Writes the recording in progress, if any.
+	~input_recorder();
+	
+	/**
+	 * Starts recording input events. The recording is written when recording stops, or when the recorder is destroyed.
+	 *
+	 * @param path Path to the file to which the recording will be written.
+	 * @param seed Seed of the random engines, stored in the recording.
+	 */
+	void start_recording(const std::string& path, std::uint64_t seed);
+	
+	/**
+	 * Stops recording and writes the recorded events.
+	 *
+	 * @exception std::runtime_error Failed to write the recording.
+	 */
+	void stop_recording();
+	
+	/**
+	 * Loads a recording and starts replaying it from the next update.
+	 *
+	 * @param path Path to a recording file.
+	 *
+	 * @exception std::runtime_error Failed to read the recording.
+	 */
+	void start_replay(const std::string& path);
+	
+	/// Stops replaying.
+	void stop_replay();
+	
+	/**
+	 * Advances to the next update, queuing the events recorded during it if replaying. Must be called once per update, before the event dispatcher is updated.
+	 */
+	void update();
+	
+	/// Returns `true` if input events are being recorded.
+	bool is_recording() const;
+	
+	/// Returns `true` if a recording is being replayed.
+	bool is_replaying() const;
+	
+	/// Returns `true` if a replay has queued all of its events.
+	bool is_replay_finished() const;
+	
+	/// Returns the seed of the random engines stored in the recording being replayed or recorded.
+	std::uint64_t get_seed() const;
+	
+	/// Returns the index of the current update, counted from the start of the recording or replay.
+	std::uint64_t get_update_index() const;
+	
+	/// Returns the number of events recorded, or of the recording being replayed.
+	std::size_t get_event_count() const;
+
+private:
+	enum class record_type: std::uint8_t
+	{
+		key_pressed,
+		key_released,
+		mouse_moved,
+		mouse_wheel_scrolled,
+		mouse_button_pressed,
+		mouse_button_released,
+		game_controller_axis_moved,
+		game_controller_button_pressed,
+		game_controller_button_released
+	};
+	
+	/// Recorded input event, with its parameters packed into integers or an axis value.
+	struct input_record
+	{
+		std::uint64_t update_index;
+		record_type type;
+		std::int32_t parameters[4];
+		float value;
+	};
+	
+	virtual void handle_event(const key_pressed_event& event);
+	virtual void handle_event(const key_released_event& event);
+	virtual void handle_event(const mouse_moved_event& event);
+	virtual void handle_event(const mouse_wheel_scrolled_event& event);
+	virtual void handle_event(const mouse_button_pressed_event& event);
+	virtual void handle_event(const mouse_button_released_event& event);
+	virtual void handle_event(const game_controller_axis_moved_event& event);
+	virtual void handle_event(const game_controller_button_pressed_event& event);
+	virtual void handle_event(const game_controller_button_released_event& event);
+	
+	/// Records an event of the current update.
+	void record(record_type type, std::int32_t a, std::int32_t b = 0, std::int32_t c = 0, std::int32_t d = 0, float value = 0.0f);
+	
+	/// Queues a recorded event onto its device.
+	void replay(const input_record& record);
+	
+	void subscribe();
+	void unsubscribe();
+	
+	::event_dispatcher* event_dispatcher;
+	input::keyboard* keyboard;
+	input::mouse* mouse;
+	
+	/// Virtual controller onto which controller events are replayed, as recorded controllers may not be connected.
+	input::game_controller controller;
+	
+	bool recording;
+	bool replaying;
+	std::string recording_path;
+	std::uint64_t seed;
+	std::uint64_t update_index;
+	std::vector<input_record> records;
+	
+	/// Index of the next record to replay.
+	std::size_t replay_position;
+};
+
+inline bool input_recorder::is_recording() const
+{
+	return recording;
+}
+
+inline bool input_recorder::is_replaying() const
+{
+	return replaying;
+}
+
+inline bool input_recorder::is_replay_finished() const
+{
+	return replaying && replay_position == records.size();
+}
+
+inline std::uint64_t input_recorder::get_seed() const
+{
+	return seed;
+}
+
+inline std::uint64_t input_recorder::get_update_index() const
+{
+	return update_index;
+}
+
+inline std::size_t input_recorder::get_event_count() const
+{
+	return records.size();
+}
+
+} // namespace debug
+
+#endif // ANTKEEPER_DEBUG_INPUT_RECORDER_HPP
@@ -0,0 +1,135 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "debug/log-sink.hpp"
+#include <algorithm>
+#include <cstdio>
+
+namespace debug {
+
+const char* get_log_level_name(log_level level)
+{
+	switch (level)
+	{
+		case log_level::info:
+			return "info";
+		case log_level::success:
+			return "success";
+		case log_level::warning:
+			return "warning";
+		case log_level::error:
+			return "error";
+	}
+	
+	return "unknown";
+}
+
+/// Returns the time of a log record in microseconds since the epoch.
+static std::int64_t record_microseconds(const log_record& record)
+{
+	return std::chrono::duration_cast<std::chrono::microseconds>(record.time.time_since_epoch()).count();
+}
+
+void log_sink::flush()
+{}
+
+json_log_sink::json_log_sink(std::ostream& stream):
+	stream(stream)
+{}
+
+void json_log_sink::write(const log_record& record)
+{
+	stream << "{\"time\":" << record_microseconds(record);
+	stream << ",\"thread\":" << record.thread;
+	stream << ",\"level\":\"" << get_log_level_name(record.level) << '\"';
+	stream << ",\"depth\":" << record.depth;
+	stream << ",\"text\":\"";
+	
+	// Escape text
+	for (char c: record.text)
+	{
+		switch (c)
+		{
+			case '\"':
+				stream << "\\\"";
+				break;
+			case '\\':
+				stream << "\\\\";
+				break;
+			case '\n':
+				stream << "\\n";
+				break;
+			case '\r':
+				stream << "\\r";
+				break;
+			case '\t':
+				stream << "\\t";
+				break;
+			default:
+				if (static_cast<unsigned char>(c) < 0x20)
+				{
+					char escape[7];
+					std::snprintf(escape, sizeof(escape), "\\u%04x", static_cast<unsigned int>(static_cast<unsigned char>(c)));
+					stream << escape;
+				}
+				else
+				{
+					stream << c;
+				}
+				break;
+		}
+	}
+	
+	stream << "\"}\n";
+}
+
+void json_log_sink::flush()
+{
+	stream.flush();
+}
+
+binary_log_sink::binary_log_sink(std::ostream& stream):
+	stream(stream)
+{
+	stream.write("AKLG", 4);
+	stream.write(reinterpret_cast<const char*>(&version), sizeof(version));
+}
+
+void binary_log_sink::write(const log_record& record)
+{
+	const std::uint64_t time = static_cast<std::uint64_t>(record_microseconds(record));
+	const std::uint64_t thread = static_cast<std::uint64_t>(record.thread);
+	const std::uint8_t level = static_cast<std::uint8_t>(record.level);
+	const std::uint8_t depth = static_cast<std::uint8_t>(std::min<std::size_t>(record.depth, 255));
+	const std::uint32_t length = static_cast<std::uint32_t>(record.text.size());
+	
+	stream.write(reinterpret_cast<const char*>(&time), sizeof(time));
+	stream.write(reinterpret_cast<const char*>(&thread), sizeof(thread));
+	stream.write(reinterpret_cast<const char*>(&level), sizeof(level));
+	stream.write(reinterpret_cast<const char*>(&depth), sizeof(depth));
+	stream.write(reinterpret_cast<const char*>(&length), sizeof(length));
+	stream.write(record.text.data(), length);
+}
+
+void binary_log_sink::flush()
+{
+	stream.flush();
+}
+
+} // namespace debug
@@ -0,0 +1,134 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ANTKEEPER_DEBUG_LOG_SINK_HPP
+#define ANTKEEPER_DEBUG_LOG_SINK_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+namespace debug {
+
+/// Severity of a log message, in increasing order.
+enum class log_level: std::uint8_t
+{
+	info,
+	success,
+	warning,
+	error
+};
+
+/**
+ * Returns the name of a log level.
+ *
+ * @param level Log level.
+ * @return Lowercase name of the log level.
+ */
+const char* get_log_level_name(log_level level);
+
+/// Unformatted log message.
+struct log_record
+{
+	/// Time at which the message was logged.
+	std::chrono::system_clock::time_point time;
+	
+	/// Hash of the ID of the thread which logged the message.
+	std::size_t thread;
+	
+	/// Severity of the message.
+	log_level level;
+	
+	/// Number of tasks in progress when the message was logged.
+	std::size_t depth;
+	
+	/// Message text, without prefixes, postfixes, timestamp, or indentation.
+	std::string text;
+};
+
+/**
+ * Abstract base class for structured log outputs. Sinks are written by the logger's writer thread only.
+ */
+class log_sink
+{
+public:
+	/// Destroys a log sink.
+	virtual ~log_sink() = default;
+	
+	/**
+	 * Writes a log record.
+	 *
+	 * @param record Log record to write.
+	 */
+	virtual void write(const log_record& record) = 0;
+	
+	/// Flushes written records, once per batch of records.
+	virtual void flush();
+};
+
+/**
+ * Writes log records to an output stream as JSON lines, one object per record, of the form `{"time":<microseconds since epoch>,"thread":<thread hash>,"level":"<level>","depth":<depth>,"text":"<text>"}`.
+ */
+class json_log_sink: public log_sink
+{
+public:
+	/**
+	 * Creates a JSON log sink.
+	 *
+	 * @param stream Output stream to which JSON lines will be written.
+	 */
+	explicit json_log_sink(std::ostream& stream);
+	
+	virtual void write(const log_record& record);
+	virtual void flush();
+
+private:
+	std::ostream& stream;
+};
+
+/**
+ * Writes log records to a binary output stream in host byte order.
+ *
+ * The stream begins with the four bytes `AKLG` followed by a `std::uint32_t` format version. Each record is then written as a `std::uint64_t` time in microseconds since the epoch, a `std::uint64_t` thread hash, a `std::uint8_t` level, a `std::uint8_t` task depth, a `std::uint32_t` text length in bytes, and the text without a terminator.
+ */
+class binary_log_sink: public log_sink
+{
+public:
+	/// Version of the binary log format.
+	static constexpr std::uint32_t version = 1;
+	
+	/**
+	 * Creates a binary log sink and writes the format header.
+	 *
+	 * @param stream Binary output stream to which records will be written.
+	 */
+	explicit binary_log_sink(std::ostream& stream);
+	
+	virtual void write(const log_record& record);
+	virtual void flush();
+
+private:
+	std::ostream& stream;
+};
+
+} // namespace debug
+
+#endif // ANTKEEPER_DEBUG_LOG_SINK_HPP
@@ -19,11 +19,19 @@
 
 #include "logger.hpp"
 #include "utility/timestamp.hpp"
+#include <algorithm>
+#include <functional>
 #include <iostream>
 
 namespace debug {
 
 logger::logger():
+	min_level(log_level::info),
+	task_depth(0),
+	queued_records(nullptr),
+	queued_count(0),
+	written_count(0),
+	running(true),
 	os(&std::cout),
 	auto_newline(true),
 	timestamp_enabled(true),
@@ -35,119 +43,152 @@ logger::logger():
 	error_prefix(std::string()),
 	error_postfix(std::string()),
 	success_prefix(std::string()),
-	success_postfix(std::string())
+	success_postfix(std::string()),
+	history_size(0),
+	history_capacity(default_history_capacity),
+	writer(&logger::write_records, this)
 {}
 
 logger::~logger()
-{}
+{
+	// Stop the writer thread, which writes all remaining records before exiting
+	{
+		std::lock_guard<std::mutex> lock(queue_mutex);
+		running = false;
+	}
+	wake_condition.notify_one();
+	writer.join();
+}
 
 void logger::redirect(std::ostream* stream)
 {
+	flush();
+	
+	std::lock_guard<std::mutex> lock(output_mutex);
 	os = stream;
 }
 
 void logger::log(const std::string& text)
 {
-	if (os)
-	{
-		std::string message = "";
-		
-		// Prepend timestamp
-		if (timestamp_enabled)
-		{
-			message += timestamp();
-			message += ": ";
-		}
-		
-		// Prepend indentation
-		for (std::size_t i = 0; i < tasks.size(); ++i)
-			message += indent;
-		
-		// Append text
-		message += (log_prefix + text + log_postfix);
-		
-		// Append newline
-		if (auto_newline)
-			message += "\n";
-		
-		// Add message to log history
-		history += message;
-		
-		// Output message
-		(*os) << message;
-		
-		// Flush output stream
-		os->flush();
-	}
+	post(log_level::info, text);
 }
 
 void logger::warning(const std::string& text)
 {
-	log(warning_prefix + text + warning_postfix);
+	post(log_level::warning, text);
 }
 
 void logger::error(const std::string& text)
 {
-	log(error_prefix + text + error_postfix);
+	post(log_level::error, text);
 }
 
 void logger::success(const std::string& text)
 {
-	log(success_prefix + text + success_postfix);
+	post(log_level::success, text);
+}
+
+void logger::flush()
+{
+	const std::size_t target = queued_count.load(std::memory_order_acquire);
+	
+	std::unique_lock<std::mutex> lock(queue_mutex);
+	written_condition.wait(lock, [&]{return written_count >= target;});
+}
+
+void logger::set_min_level(log_level level)
+{
+	min_level.store(level, std::memory_order_relaxed);
+}
+
+void logger::add_sink(log_sink* sink)
+{
+	std::lock_guard<std::mutex> lock(output_mutex);
+	sinks.push_back(sink);
+}
+
+void logger::remove_sink(log_sink* sink)
+{
+	flush();
+	
+	std::lock_guard<std::mutex> lock(output_mutex);
+	sinks.erase(std::remove(sinks.begin(), sinks.end(), sink), sinks.end());
+}
+
+void logger::set_history_capacity(std::size_t capacity)
+{
+	std::lock_guard<std::mutex> lock(output_mutex);
+	history_capacity = capacity;
+	while (history_size > history_capacity)
+	{
+		history_size -= history.front().size();
+		history.pop_front();
+	}
 }
 
 void logger::set_auto_newline(bool enabled)
 {
+	std::lock_guard<std::mutex> lock(output_mutex);
 	auto_newline = enabled;
 }
 
 void logger::set_timestamp(bool enabled)
 {
+	std::lock_guard<std::mutex> lock(output_mutex);
 	timestamp_enabled = enabled;
 }
 
 void logger::set_indent(const std::string& indent)
 {
+	std::lock_guard<std::mutex> lock(output_mutex);
 	this->indent = indent;
 }
 
 void logger::set_log_prefix(const std::string& prefix)
 {
+	std::lock_guard<std::mutex> lock(output_mutex);
 	log_prefix = prefix;
 }
 
 void logger::set_log_postfix(const std::string& postfix)
 {
+	std::lock_guard<std::mutex> lock(output_mutex);
 	log_postfix = postfix;
 }
 
 void logger::set_warning_prefix(const std::string& prefix)
 {
+	std::lock_guard<std::mutex> lock(output_mutex);
 	warning_prefix = prefix;
 }
 
 void logger::set_warning_postfix(const std::string& postfix)
 {
+	std::lock_guard<std::mutex> lock(output_mutex);
 	warning_postfix = postfix;
 }
 
 void logger::set_error_prefix(const std::string& prefix)
 {
+	std::lock_guard<std::mutex> lock(output_mutex);
 	error_prefix = prefix;
 }
 
 void logger::set_error_postfix(const std::string& postfix)
 {
+	std::lock_guard<std::mutex> lock(output_mutex);
 	error_postfix = postfix;
 }
 
 void logger::set_success_prefix(const std::string& prefix)
 {
+	std::lock_guard<std::mutex> lock(output_mutex);
 	success_prefix = prefix;
 }
 
 void logger::set_success_postfix(const std::string& postfix)
 {
+	std::lock_guard<std::mutex> lock(output_mutex);
 	success_postfix = postfix;
 }
 
@@ -160,6 +201,7 @@ void logger::push_task(const std::string& description)
 	log(message);
 	
 	tasks.push(description);
+	task_depth.store(tasks.size(), std::memory_order_relaxed);
 }
 
 void logger::pop_task(int status)
@@ -172,6 +214,7 @@ void logger::pop_task(int status)
 	std::string message = tasks.top() + "... ";
 	
 	tasks.pop();
+	task_depth.store(tasks.size(), std::memory_order_relaxed);
 	
 	if (status == EXIT_SUCCESS)
 	{
@@ -191,4 +234,173 @@ void logger::pop_task(int status)
 	}
 }
 
+std::string logger::get_history()
+{
+	flush();
+	
+	std::lock_guard<std::mutex> lock(output_mutex);
+	std::string text;
+	text.reserve(history_size);
+	for (const std::string& message: history)
+		text += message;
+	return text;
+}
+
+void logger::post(log_level level, const std::string& text)
+{
+	// Discard messages below the minimum level before allocating
+	if (level < min_level.load(std::memory_order_relaxed))
+		return;
+	
+	queued_record* node = new queued_record
+	{
+		nullptr,
+		{
+			std::chrono::system_clock::now(),
+			std::hash<std::thread::id>()(std::this_thread::get_id()),
+			level,
+			task_depth.load(std::memory_order_relaxed),
+			text
+		}
+	};
+	
+	// Push record onto the queue stack. Only the writer thread pops, and it pops the entire stack at once, so the stack is not subject to the ABA problem
+	queued_record* head = queued_records.load(std::memory_order_relaxed);
+	do
+	{
+		node->next = head;
+	}
+	while (!queued_records.compare_exchange_weak(head, node, std::memory_order_release, std::memory_order_relaxed));
+	queued_count.fetch_add(1, std::memory_order_release);
+	
+	// Wake the writer thread if the queue was empty. The writer checks the queue while holding the queue mutex, so acquiring it here ensures the writer is either already awake or waiting to be notified.
+	if (!head)
+	{
+		{
+			std::lock_guard<std::mutex> lock(queue_mutex);
+		}
+		wake_condition.notify_one();
+	}
+}
+
+void logger::write_records()
+{
+	std::unique_lock<std::mutex> lock(queue_mutex);
+	for (;;)
+	{
+		wake_condition.wait(lock, [this]{return !running || queued_records.load(std::memory_order_relaxed);});
+		
+		queued_record* records = queued_records.exchange(nullptr, std::memory_order_acquire);
+		if (!records)
+		{
+			if (!running)
+				break;
+			continue;
+		}
+		
+		// Write records without holding the queue mutex, so that logging threads aren't blocked by I/O
+		lock.unlock();
+		const std::size_t count = write_batch(records);
+		lock.lock();
+		
+		written_count += count;
+		written_condition.notify_all();
+	}
+}
+
+std::size_t logger::write_batch(queued_record* records)
+{
+	// Reverse the stack into the order in which records were logged
+	queued_record* reversed = nullptr;
+	while (records)
+	{
+		queued_record* next = records->next;
+		records->next = reversed;
+		reversed = records;
+		records = next;
+	}
+	
+	std::lock_guard<std::mutex> lock(output_mutex);
+	
+	std::size_t count = 0;
+	while (reversed)
+	{
+		const log_record& record = reversed->record;
+		
+		std::string message = format(record);
+		if (os)
+			(*os) << message;
+		append_history(std::move(message));
+		
+		for (log_sink* sink: sinks)
+			sink->write(record);
+		
+		queued_record* next = reversed->next;
+		delete reversed;
+		reversed = next;
+		++count;
+	}
+	
+	// Flush outputs once per batch
+	if (os)
+		os->flush();
+	for (log_sink* sink: sinks)
+		sink->flush();
+	
+	return count;
+}
+
+std::string logger::format(const log_record& record) const
+{
+	std::string message = "";
+	
+	// Prepend timestamp
+	if (timestamp_enabled)
+	{
+		message += timestamp(record.time);
+		message += ": ";
+	}
+	
+	// Prepend indentation
+	for (std::size_t i = 0; i < record.depth; ++i)
+		message += indent;
+	
+	// Append text, wrapped in the prefix and postfix of its level
+	message += log_prefix;
+	switch (record.level)
+	{
+		case log_level::warning:
+			message += warning_prefix + record.text + warning_postfix;
+			break;
+		case log_level::error:
+			message += error_prefix + record.text + error_postfix;
+			break;
+		case log_level::success:
+			message += success_prefix + record.text + success_postfix;
+			break;
+		default:
+			message += record.text;
+			break;
+	}
+	message += log_postfix;
+	
+	// Append newline
+	if (auto_newline)
+		message += "\n";
+	
+	return message;
+}
+
+void logger::append_history(std::string&& message)
+{
+	history_size += message.size();
+	history.push_back(std::move(message));
+	
+	while (history_size > history_capacity && !history.empty())
+	{
+		history_size -= history.front().size();
+		history.pop_front();
+	}
+}
+
 } // namespace debug
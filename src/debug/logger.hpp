@@ -20,31 +20,46 @@
 #ifndef ANTKEEPER_DEBUG_LOGGER_HPP
 #define ANTKEEPER_DEBUG_LOGGER_HPP
 
-#include <list>
+#include "debug/log-sink.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
 #include <ostream>
 #include <stack>
 #include <string>
+#include <thread>
+#include <vector>
 
 namespace debug {
 
 /**
- * Logs formatted debug messages to an output stream.
+ * Logs formatted debug messages to an output stream and to structured log sinks.
+ *
+ * Messages may be logged from any thread. Each message is pushed onto a lock-free queue as an unformatted log record, then formatted and written by a background writer thread, so that logging threads neither wait on I/O nor contend for a lock. Messages below the minimum log level are discarded before any formatting or allocation. Formatted messages are kept in a history ring, capped in size, so that long sessions don't grow memory.
+ *
+ * Tasks must be pushed and popped by a single thread. Messages from all threads are indented by the number of tasks in progress when they were logged.
  */
 class logger
 {
 public:
-	/// Creates a logger.
+	/// Default capacity of the log history, in bytes.
+	static constexpr std::size_t default_history_capacity = 256 * 1024;
+	
+	/// Creates a logger and starts its writer thread.
 	logger();
 	
-	/// Destroys a logger.
+	/// Writes all logged messages, then joins the writer thread.
 	~logger();
 
 	/**
-	 * Redirects log output to the specified output stream.
+	 * Redirects log output to the specified output stream, once all previously logged messages have been written to the current stream.
 	 *
-	 * @param stream Output stream to which log text will be written.
+	 * @param stream Output stream to which log text will be written, or `nullptr` to disable text output.
 	 */
 	void redirect(std::ostream* stream);
+	
 	/**
 	 * Outputs text to the log.
 	 */
@@ -53,6 +68,39 @@ public:
 	void warning(const std::string& text);
 	void error(const std::string& text);
 	void success(const std::string& text);
+	
+	/**
+	 * Blocks until all messages logged before the call have been written to the output stream and sinks.
+	 */
+	void flush();
+	
+	/**
+	 * Sets the minimum severity of logged messages. Messages of lower severity are discarded.
+	 *
+	 * @param level Minimum log level.
+	 */
+	void set_min_level(log_level level);
+	
+	/**
+	 * Adds a structured sink, to which log records are written in addition to the output stream. The sink must outlive the logger or be removed first.
+	 *
+	 * @param sink Log sink to add.
+	 */
+	void add_sink(log_sink* sink);
+	
+	/**
+	 * Removes a structured sink, once all previously logged messages have been written to it.
+	 *
+	 * @param sink Log sink to remove.
+	 */
+	void remove_sink(log_sink* sink);
+	
+	/**
+	 * Sets the capacity of the log history. Once exceeded, the oldest messages are discarded from the history.
+	 *
+	 * @param capacity History capacity, in bytes.
+	 */
+	void set_history_capacity(std::size_t capacity);
 
 	/**
 	 * Enables or disables automatic appending of newlines to log messages.
@@ -98,10 +146,60 @@ public:
 	 */
 	void pop_task(int status);
 	
-	const std::string& get_history() const;
+	/// Returns the minimum severity of logged messages.
+	log_level get_min_level() const;
+	
+	/**
+	 * Returns the log history, once all previously logged messages have been written.
+	 *
+	 * @return Most recent formatted messages, up to the history capacity.
+	 */
+	std::string get_history();
 
 private:
+	/// Log record in the intrusive queue stack.
+	struct queued_record
+	{
+		queued_record* next;
+		log_record record;
+	};
+	
+	/// Pushes a record onto the queue, waking the writer thread if the queue was empty.
+	void post(log_level level, const std::string& text);
+	
+	/// Formats and writes queued records until the logger is destroyed.
+	void write_records();
+	
+	/// Formats and writes a stack of queued records, in the order in which they were logged, then frees them.
+	std::size_t write_batch(queued_record* records);
+	
+	/// Formats a log record as text.
+	std::string format(const log_record& record) const;
+	
+	/// Appends a formatted message to the history, discarding the oldest messages while the capacity is exceeded.
+	void append_history(std::string&& message);
+	
+	std::atomic<log_level> min_level;
+	std::atomic<std::size_t> task_depth;
+	std::stack<std::string> tasks;
+	
+	/// Most recently queued record, which links to the records queued before it.
+	std::atomic<queued_record*> queued_records;
+	
+	/// Number of records queued since construction.
+	std::atomic<std::size_t> queued_count;
+	
+	/// Guards the wake and flush conditions, but not the queue itself.
+	std::mutex queue_mutex;
+	std::condition_variable wake_condition;
+	std::condition_variable written_condition;
+	std::size_t written_count;
+	bool running;
+	
+	/// Guards the output stream, sinks, formatting options, and history, which are used by the writer thread.
+	std::mutex output_mutex;
 	std::ostream* os;
+	std::vector<log_sink*> sinks;
 	bool auto_newline;
 	bool timestamp_enabled;
 	std::string indent;
@@ -112,17 +210,20 @@ private:
 	std::string error_prefix;
 	std::string error_postfix;
 	std::string success_prefix;
-	std::string success_postfix;	
-	std::stack<std::string> tasks;
-	std::string history;
+	std::string success_postfix;
+	std::deque<std::string> history;
+	std::size_t history_size;
+	std::size_t history_capacity;
+	
+	/// Writer thread, started last.
+	std::thread writer;
 };
 
-inline const std::string& logger::get_history() const
+inline log_level logger::get_min_level() const
 {
-	return history;
+	return min_level.load(std::memory_order_relaxed);
 }
 
 } // namespace debug
 
 #endif // ANTKEEPER_DEBUG_LOGGER_HPP
-
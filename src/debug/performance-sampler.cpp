@@ -19,14 +19,20 @@
 
 #include "performance-sampler.hpp"
 #include <algorithm>
+#include <cmath>
 #include <numeric>
 
 namespace debug {
 
 performance_sampler::performance_sampler():
 	sample_size(1),
-	sample_index(0)
-{}
+	sample_index(0),
+	count(0),
+	sum(0.0),
+	max(0.0)
+{
+	histogram.fill(0);
+}
 
 void performance_sampler::sample(double duration)
 {
@@ -39,12 +45,21 @@ void performance_sampler::sample(double duration)
 		samples[sample_index] = duration;
 		sample_index = (sample_index + 1) % samples.size();
 	}
+	
+	++histogram[bucket_index(duration)];
+	++count;
+	sum += duration;
+	max = std::max(max, duration);
 }
 
 void performance_sampler::reset()
 {
 	samples.clear();
 	sample_index = 0;
+	histogram.fill(0);
+	count = 0;
+	sum = 0.0;
+	max = 0.0;
 }
 
 void performance_sampler::set_sample_size(std::size_t size)
@@ -62,5 +77,82 @@ double performance_sampler::mean_frame_duration() const
 	return std::accumulate(samples.begin(), samples.end(), 0.0) / static_cast<double>(samples.size());
 }
 
+double performance_sampler::percentile(double p) const
+{
+	if (samples.empty())
+		return 0.0;
+	
+	std::vector<double> sorted = samples;
+	const std::size_t index = std::min(sorted.size() - 1, static_cast<std::size_t>(std::clamp(p, 0.0, 1.0) * static_cast<double>(sorted.size() - 1) + 0.5));
+	std::nth_element(sorted.begin(), sorted.begin() + index, sorted.end());
+	
+	return sorted[index];
+}
+
+std::size_t performance_sampler::size() const
+{
+	return samples.size();
+}
+
+double performance_sampler::streaming_percentile(double p) const
+{
+	if (!count)
+		return 0.0;
+	if (p >= 1.0)
+		return max;
+	
+	// Find the bucket containing the sample of the percentile's rank
+	const std::uint64_t rank = std::max<std::uint64_t>(1, static_cast<std::uint64_t>(std::ceil(std::max(p, 0.0) * static_cast<double>(count))));
+	std::uint64_t cumulative = 0;
+	std::size_t index = 0;
+	for (; index < histogram_size - 1; ++index)
+	{
+		cumulative += histogram[index];
+		if (cumulative >= rank)
+			break;
+	}
+	
+	// Estimate the percentile as the geometric center of its bucket
+	const double upper = bucket_lower_bound(index + 1);
+	const double center = (index) ? std::sqrt(bucket_lower_bound(index) * upper) : upper * 0.5;
+	
+	return std::min(center, max);
+}
+
+double performance_sampler::streaming_mean() const
+{
+	return (count) ? sum / static_cast<double>(count) : 0.0;
+}
+
+double performance_sampler::bucket_lower_bound(std::size_t index)
+{
+	if (!index)
+		return 0.0;
+	return histogram_min * std::exp2(static_cast<double>(index - 1) / static_cast<double>(buckets_per_octave));
+}
+
+std::size_t performance_sampler::bucket_index(double duration)
+{
+	if (!(duration >= histogram_min))
+		return 0;
+	
+	const double octaves = std::log2(duration / histogram_min);
+	return std::min(histogram_size - 1, static_cast<std::size_t>(octaves * static_cast<double>(buckets_per_octave)) + 1);
+}
+
+void performance_sampler::write_csv(std::ostream& stream, const std::string& channel) const
+{
+	for (std::size_t i = 0; i < histogram_size; ++i)
+	{
+		if (!histogram[i])
+			continue;
+		
+		stream << channel << ',' << bucket_lower_bound(i) * 1000.0 << ',';
+		if (i + 1 < histogram_size)
+			stream << bucket_lower_bound(i + 1) * 1000.0;
+		stream << ',' << histogram[i] << '\n';
+	}
+}
+
 } // namespace debug
 
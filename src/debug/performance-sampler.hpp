@@ -20,17 +20,33 @@
 #ifndef ANTKEEPER_DEBUG_PERFORMANCE_SAMPLER_HPP
 #define ANTKEEPER_DEBUG_PERFORMANCE_SAMPLER_HPP
 
+#include <array>
+#include <cstdint>
 #include <cstdlib>
+#include <ostream>
+#include <string>
 #include <vector>
 
 namespace debug {
 
 /**
- * Measures a rolling mean frame duration.
+ * Measures a rolling mean frame duration, or the rolling distribution of any other duration.
+ *
+ * In addition to the rolling sample, every duration since the last reset is counted in a logarithmic histogram, from which streaming percentiles are estimated in constant memory. Histogram buckets span 1/16 of an octave each, so estimates are within about 4.4% of the true percentile.
  */
 class performance_sampler
 {
 public:
+	/// Number of histogram buckets.
+	static constexpr std::size_t histogram_size = 384;
+	
+	/// Number of histogram buckets per doubling of duration.
+	static constexpr std::size_t buckets_per_octave = 16;
+	
+	/// Upper bound of the first histogram bucket, in seconds. Shorter durations are counted in the first bucket, and durations beyond the last bucket in the last.
+	static constexpr double histogram_min = 0.00001;
+	
+
 	/// Creates a performance sampler.
 	performance_sampler();
 
@@ -57,13 +73,85 @@ public:
 	 * Returns the mean frame duration.
 	 */
 	double mean_frame_duration() const;
+	
+	/**
+	 * Returns a percentile of the sampled durations.
+	 *
+	 * @param p Percentile, on `[0, 1]`.
+	 *
+	 * @return Sampled duration below which the fraction @p p of the sampled durations lie, or `0` if no durations have been sampled.
+	 */
+	double percentile(double p) const;
+	
+	/// Returns the number of sampled durations.
+	std::size_t size() const;
+	
+	/**
+	 * Estimates a percentile of all durations since the last reset from the histogram.
+	 *
+	 * @param p Percentile, on `[0, 1]`.
+	 *
+	 * @return Geometric center of the histogram bucket containing the percentile, clamped to the maximum duration, or `0` if no durations have been sampled.
+	 */
+	double streaming_percentile(double p) const;
+	
+	/// Returns the mean of all durations since the last reset.
+	double streaming_mean() const;
+	
+	/// Returns the maximum duration since the last reset.
+	double max_duration() const;
+	
+	/// Returns the number of durations since the last reset.
+	std::uint64_t sample_count() const;
+	
+	/// Returns the histogram of all durations since the last reset.
+	const std::array<std::uint64_t, histogram_size>& get_histogram() const;
+	
+	/**
+	 * Returns the lower bound of a histogram bucket.
+	 *
+	 * @param index Index of a histogram bucket.
+	 *
+	 * @return Lower bound of the bucket, in seconds. The lower bound of the first bucket is `0`.
+	 */
+	static double bucket_lower_bound(std::size_t index);
+	
+	/**
+	 * Writes the non-empty histogram buckets as CSV rows of `channel,lower_ms,upper_ms,count`, without a header.
+	 *
+	 * @param stream Output stream.
+	 * @param channel Name of the channel in the first column.
+	 */
+	void write_csv(std::ostream& stream, const std::string& channel) const;
 
 private:
+	/// Returns the index of the histogram bucket of a duration.
+	static std::size_t bucket_index(double duration);
+	
 	std::vector<double> samples;
 	std::size_t sample_size;
 	std::size_t sample_index;
+	std::array<std::uint64_t, histogram_size> histogram;
+	std::uint64_t count;
+	double sum;
+	double max;
 };
 
+inline double performance_sampler::max_duration() const
+{
+	return max;
+}
+
+inline std::uint64_t performance_sampler::sample_count() const
+{
+	return count;
+}
+
+inline const std::array<std::uint64_t, performance_sampler::histogram_size>& performance_sampler::get_histogram() const
+{
+	return histogram;
+}
+
 } // namespace debug
 
 #endif // ANTKEEPER_DEBUG_PERFORMANCE_SAMPLER_HPP
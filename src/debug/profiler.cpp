@@ -0,0 +1,205 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "debug/profiler.hpp"
+#include "debug/counters.hpp"
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace debug {
+
+namespace {
+
+/// Completed profiling zone.
+struct profile_event
+{
+	const char* name;
+	std::uint64_t begin;
+	std::uint64_t end;
+	std::uint32_t depth;
+};
+
+/// Ring buffer of the events recorded by a single thread.
+struct thread_buffer
+{
+	std::uint32_t thread_id;
+	std::uint32_t depth;
+	std::vector<profile_event> events;
+	std::size_t head;
+	std::size_t count;
+	std::mutex mutex;
+};
+
+std::atomic<bool> enabled(true);
+const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+
+// Thread buffers are never freed, so events of exited threads can still be written
+std::mutex buffers_mutex;
+std::vector<std::unique_ptr<thread_buffer>> buffers;
+thread_local thread_buffer* local_buffer = nullptr;
+
+/// Returns the number of nanoseconds since the profiler epoch.
+inline std::uint64_t timestamp()
+{
+	return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count());
+}
+
+/// Returns the ring buffer of the calling thread, registering it on first use.
+thread_buffer* get_thread_buffer()
+{
+	if (!local_buffer)
+	{
+		std::unique_ptr<thread_buffer> buffer = std::make_unique<thread_buffer>();
+		buffer->depth = 0;
+		buffer->events.resize(profiler::ring_buffer_capacity);
+		buffer->head = 0;
+		buffer->count = 0;
+		
+		std::lock_guard<std::mutex> lock(buffers_mutex);
+		buffer->thread_id = static_cast<std::uint32_t>(buffers.size());
+		local_buffer = buffer.get();
+		buffers.push_back(std::move(buffer));
+	}
+	
+	return local_buffer;
+}
+
+/// Writes a string as a JSON string literal.
+void write_json_string(std::ostream& stream, const char* string)
+{
+	stream << '"';
+	for (const char* c = string; *c; ++c)
+	{
+		if (*c == '"' || *c == '\\')
+			stream << '\\';
+		stream << *c;
+	}
+	stream << '"';
+}
+
+} // namespace
+
+profile_zone::profile_zone(const char* name):
+	name(nullptr),
+	begin(0)
+{
+	if (enabled.load(std::memory_order_relaxed))
+	{
+		this->name = name;
+		++get_thread_buffer()->depth;
+		begin = timestamp();
+	}
+}
+
+profile_zone::~profile_zone()
+{
+	if (!name)
+		return;
+	
+	const std::uint64_t end = timestamp();
+	thread_buffer* buffer = get_thread_buffer();
+	--buffer->depth;
+	
+	std::lock_guard<std::mutex> lock(buffer->mutex);
+	buffer->events[buffer->head] = {name, begin, end, buffer->depth};
+	buffer->head = (buffer->head + 1) % buffer->events.size();
+	if (buffer->count < buffer->events.size())
+		++buffer->count;
+}
+
+namespace profiler {
+
+void set_enabled(bool enabled)
+{
+	debug::enabled.store(enabled, std::memory_order_relaxed);
+}
+
+bool is_enabled()
+{
+	return debug::enabled.load(std::memory_order_relaxed);
+}
+
+void clear()
+{
+	std::lock_guard<std::mutex> lock(buffers_mutex);
+	for (const std::unique_ptr<thread_buffer>& buffer: buffers)
+	{
+		std::lock_guard<std::mutex> buffer_lock(buffer->mutex);
+		buffer->head = 0;
+		buffer->count = 0;
+	}
+}
+
+std::uint64_t get_time()
+{
+	return timestamp();
+}
+
+std::size_t write_chrome_trace(std::ostream& stream)
+{
+	std::size_t event_count = 0;
+	
+	// Write timestamps with fixed precision, as they grow large over long sessions
+	const std::ios_base::fmtflags flags = stream.flags();
+	const std::streamsize precision = stream.precision();
+	stream << std::fixed << std::setprecision(3);
+	
+	stream << "{\"traceEvents\":[";
+	
+	std::lock_guard<std::mutex> lock(buffers_mutex);
+	for (const std::unique_ptr<thread_buffer>& buffer: buffers)
+	{
+		std::lock_guard<std::mutex> buffer_lock(buffer->mutex);
+		
+		// Write events from oldest to newest as complete events, with microsecond timestamps
+		const std::size_t capacity = buffer->events.size();
+		const std::size_t first = (buffer->head + capacity - buffer->count) % capacity;
+		for (std::size_t i = 0; i < buffer->count; ++i)
+		{
+			const profile_event& event = buffer->events[(first + i) % capacity];
+			
+			if (event_count)
+				stream << ',';
+			stream << "\n{\"name\":";
+			write_json_string(stream, event.name);
+			stream << ",\"ph\":\"X\",\"pid\":0,\"tid\":" << buffer->thread_id;
+			stream << ",\"ts\":" << static_cast<double>(event.begin) * 1e-3;
+			stream << ",\"dur\":" << static_cast<double>(event.end - event.begin) * 1e-3;
+			stream << ",\"args\":{\"depth\":" << event.depth << "}}";
+			
+			++event_count;
+		}
+	}
+	
+	event_count += counters::write_chrome_trace_events(stream, event_count);
+	
+	stream << "\n],\"displayTimeUnit\":\"ms\"}\n";
+	
+	stream.flags(flags);
+	stream.precision(precision);
+	
+	return event_count;
+}
+
+} // namespace profiler
+} // namespace debug
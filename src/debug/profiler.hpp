@@ -0,0 +1,89 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ANTKEEPER_DEBUG_PROFILER_HPP
+#define ANTKEEPER_DEBUG_PROFILER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+namespace debug {
+
+/**
+ * Scoped CPU profiling zone. Records the time between its construction and destruction, along with its thread and nesting depth, into a per-thread ring buffer.
+ *
+ * @see debug::profiler::write_chrome_trace()
+ */
+class profile_zone
+{
+public:
+	/**
+	 * Begins a profiling zone.
+	 *
+	 * @param name Name of the zone. Only the pointer is recorded, so the string must outlive the profiler's events.
+	 */
+	explicit profile_zone(const char* name);
+	
+	/// Ends the profiling zone.
+	~profile_zone();
+	
+	profile_zone(const profile_zone&) = delete;
+	profile_zone& operator=(const profile_zone&) = delete;
+
+private:
+	const char* name;
+	std::uint64_t begin;
+};
+
+/// Functions which control the CPU profiler.
+namespace profiler {
+
+/// Number of events each thread's ring buffer holds before the oldest events are overwritten.
+constexpr std::size_t ring_buffer_capacity = 65536;
+
+/**
+ * Enables or disables recording of profiling zones.
+ *
+ * @param enabled `true` if zones should be recorded, `false` otherwise.
+ */
+void set_enabled(bool enabled);
+
+/// Returns `true` if profiling zones are being recorded.
+bool is_enabled();
+
+/// Discards all recorded events.
+void clear();
+
+/// Returns the number of nanoseconds since the profiler epoch, the time base of trace events.
+std::uint64_t get_time();
+
+/**
+ * Writes the recorded events of all threads in the Chrome trace event format, which can be viewed with `chrome://tracing` or Perfetto, followed by the per-frame samples of all counters and gauges.
+ *
+ * @param stream Output stream.
+ * @return Number of events written.
+ */
+std::size_t write_chrome_trace(std::ostream& stream);
+
+} // namespace profiler
+} // namespace debug
+
+#endif // ANTKEEPER_DEBUG_PROFILER_HPP
+
@@ -0,0 +1,250 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "debug/startup-profiler.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <mutex>
+#include <sstream>
+#include <vector>
+
+namespace debug {
+
+namespace {
+
+/// Completed startup phase.
+struct phase_record
+{
+	const char* name;
+	std::uint32_t depth;
+	std::uint64_t begin;
+	std::uint64_t end;
+};
+
+/// Loaded resource.
+struct resource_record
+{
+	std::string name;
+	std::string type;
+	double duration;
+	std::size_t size;
+};
+
+/// Shader program builds of one kind.
+struct shader_record
+{
+	std::size_t count{0};
+	double duration{0.0};
+};
+
+std::atomic<bool> recording(false);
+std::mutex records_mutex;
+std::chrono::steady_clock::time_point epoch;
+std::uint64_t end_time = 0;
+std::vector<phase_record> phases;
+std::vector<resource_record> resources;
+shader_record compiled_shaders;
+shader_record cached_shaders;
+thread_local std::uint32_t phase_depth = 0;
+
+/// Returns the number of nanoseconds since recording began.
+inline std::uint64_t timestamp()
+{
+	return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count());
+}
+
+/// Returns the duration of startup, in seconds.
+double get_startup_duration()
+{
+	return static_cast<double>((recording.load(std::memory_order_relaxed)) ? timestamp() : end_time) * 1e-9;
+}
+
+/// Writes a string as a JSON string literal.
+void write_json_string(std::ostream& stream, const std::string& string)
+{
+	stream << '"';
+	for (char c: string)
+	{
+		if (c == '"' || c == '\\')
+			stream << '\\';
+		stream << c;
+	}
+	stream << '"';
+}
+
+} // namespace
+
+startup_phase::startup_phase(const char* name):
+	name(name),
+	begin(0)
+{
+	if (recording.load(std::memory_order_relaxed))
+	{
+		begin = timestamp();
+		++phase_depth;
+	}
+}
+
+startup_phase::~startup_phase()
+{
+	if (!begin)
+		return;
+	
+	const std::uint64_t end = timestamp();
+	--phase_depth;
+	
+	// Discard phases which end after recording has stopped
+	if (!recording.load(std::memory_order_relaxed))
+		return;
+	
+	std::lock_guard<std::mutex> lock(records_mutex);
+	phases.push_back({name, phase_depth, begin, end});
+}
+
+namespace startup_profiler {
+
+void begin()
+{
+	std::lock_guard<std::mutex> lock(records_mutex);
+	phases.clear();
+	resources.clear();
+	compiled_shaders = {};
+	cached_shaders = {};
+	end_time = 0;
+	epoch = std::chrono::steady_clock::now();
+	recording.store(true, std::memory_order_relaxed);
+}
+
+void end()
+{
+	std::lock_guard<std::mutex> lock(records_mutex);
+	if (recording.load(std::memory_order_relaxed))
+	{
+		end_time = timestamp();
+		recording.store(false, std::memory_order_relaxed);
+	}
+}
+
+bool is_recording()
+{
+	return recording.load(std::memory_order_relaxed);
+}
+
+void record_resource(const std::string& name, const std::string& type, double duration, std::size_t size)
+{
+	if (!recording.load(std::memory_order_relaxed))
+		return;
+	
+	std::lock_guard<std::mutex> lock(records_mutex);
+	resources.push_back({name, type, duration, size});
+}
+
+void record_shader_program(double duration, bool cached)
+{
+	if (!recording.load(std::memory_order_relaxed))
+		return;
+	
+	std::lock_guard<std::mutex> lock(records_mutex);
+	shader_record& record = (cached) ? cached_shaders : compiled_shaders;
+	++record.count;
+	record.duration += duration;
+}
+
+std::string get_report(std::size_t count)
+{
+	std::lock_guard<std::mutex> lock(records_mutex);
+	
+	std::ostringstream stream;
+	stream << std::fixed << std::setprecision(2);
+	stream << "startup: " << get_startup_duration() * 1000.0 << " ms\n";
+	
+	// List slowest phases
+	std::vector<const phase_record*> sorted_phases;
+	for (const phase_record& phase: phases)
+		sorted_phases.push_back(&phase);
+	std::sort(sorted_phases.begin(), sorted_phases.end(), [](const phase_record* a, const phase_record* b){return a->end - a->begin > b->end - b->begin;});
+	stream << "slowest phases:\n";
+	for (std::size_t i = 0; i < std::min(count, sorted_phases.size()); ++i)
+		stream << "  " << std::setw(10) << static_cast<double>(sorted_phases[i]->end - sorted_phases[i]->begin) * 1e-6 << " ms  " << sorted_phases[i]->name << "\n";
+	
+	// List slowest resources
+	std::vector<const resource_record*> sorted_resources;
+	std::size_t bytes_read = 0;
+	for (const resource_record& resource: resources)
+	{
+		sorted_resources.push_back(&resource);
+		bytes_read += resource.size;
+	}
+	std::sort(sorted_resources.begin(), sorted_resources.end(), [](const resource_record* a, const resource_record* b){return a->duration > b->duration;});
+	stream << "slowest resources:\n";
+	for (std::size_t i = 0; i < std::min(count, sorted_resources.size()); ++i)
+		stream << "  " << std::setw(10) << sorted_resources[i]->duration * 1000.0 << " ms  " << sorted_resources[i]->name << " (" << sorted_resources[i]->type << ", " << sorted_resources[i]->size / 1024.0 << " KiB)\n";
+	
+	stream << "resources: " << resources.size() << " loaded, " << bytes_read / 1048576.0 << " MiB read\n";
+	stream << "shader programs: " << compiled_shaders.count << " compiled in " << compiled_shaders.duration * 1000.0 << " ms, " << cached_shaders.count << " loaded from cache in " << cached_shaders.duration * 1000.0 << " ms\n";
+	
+	return stream.str();
+}
+
+void write_json(std::ostream& stream)
+{
+	std::lock_guard<std::mutex> lock(records_mutex);
+	
+	const std::ios_base::fmtflags flags = stream.flags();
+	const std::streamsize precision = stream.precision();
+	stream << std::fixed << std::setprecision(3);
+	
+	// Write phases in the order in which they began, as nested phases are recorded before their parents
+	std::vector<phase_record> ordered_phases = phases;
+	std::stable_sort(ordered_phases.begin(), ordered_phases.end(), [](const phase_record& a, const phase_record& b){return a.begin < b.begin;});
+	
+	// Write times in milliseconds
+	stream << "{\"duration\":" << get_startup_duration() * 1000.0 << ",\n\"phases\":[";
+	for (std::size_t i = 0; i < ordered_phases.size(); ++i)
+	{
+		const phase_record& phase = ordered_phases[i];
+		stream << ((i) ? ",\n" : "\n") << "{\"name\":";
+		write_json_string(stream, phase.name);
+		stream << ",\"depth\":" << phase.depth;
+		stream << ",\"begin\":" << static_cast<double>(phase.begin) * 1e-6;
+		stream << ",\"duration\":" << static_cast<double>(phase.end - phase.begin) * 1e-6 << "}";
+	}
+	stream << "\n],\n\"resources\":[";
+	for (std::size_t i = 0; i < resources.size(); ++i)
+	{
+		const resource_record& resource = resources[i];
+		stream << ((i) ? ",\n" : "\n") << "{\"name\":";
+		write_json_string(stream, resource.name);
+		stream << ",\"type\":";
+		write_json_string(stream, resource.type);
+		stream << ",\"duration\":" << resource.duration * 1000.0;
+		stream << ",\"size\":" << resource.size << "}";
+	}
+	stream << "\n],\n\"shader_programs\":{";
+	stream << "\"compiled\":{\"count\":" << compiled_shaders.count << ",\"duration\":" << compiled_shaders.duration * 1000.0 << "},";
+	stream << "\"cached\":{\"count\":" << cached_shaders.count << ",\"duration\":" << cached_shaders.duration * 1000.0 << "}}}\n";
+	
+	stream.flags(flags);
+	stream.precision(precision);
+}
+
+} // namespace startup_profiler
+} // namespace debug
@@ -0,0 +1,101 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ANTKEEPER_DEBUG_STARTUP_PROFILER_HPP
+#define ANTKEEPER_DEBUG_STARTUP_PROFILER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+namespace debug {
+
+/**
+ * Scoped startup phase. Records the time between its construction and destruction while the startup profiler is recording. Phases may be nested, but must begin and end on the same thread.
+ */
+class startup_phase
+{
+public:
+	/**
+	 * Begins a startup phase.
+	 *
+	 * @param name Name of the phase. Only the pointer is recorded, so the string must outlive the recorded startup.
+	 */
+	explicit startup_phase(const char* name);
+	
+	/// Ends the startup phase.
+	~startup_phase();
+	
+	startup_phase(const startup_phase&) = delete;
+	startup_phase& operator=(const startup_phase&) = delete;
+
+private:
+	const char* name;
+	std::uint64_t begin;
+};
+
+/// Functions which control the startup profiler, which times the phases of startup and the resources and shader programs loaded during them.
+namespace startup_profiler {
+
+/// Discards any recorded startup and begins recording.
+void begin();
+
+/// Stops recording.
+void end();
+
+/// Returns `true` if startup is being recorded.
+bool is_recording();
+
+/**
+ * Records the load of a resource. Safe to call from any thread.
+ *
+ * @param name Name of the resource.
+ * @param type Name of the resource type.
+ * @param duration Time taken to read and parse the resource, including the loads of its dependencies, in seconds.
+ * @param size Size of the resource file, in bytes.
+ */
+void record_resource(const std::string& name, const std::string& type, double duration, std::size_t size);
+
+/**
+ * Records the build of a shader program.
+ *
+ * @param duration Time taken to build the shader program, in seconds.
+ * @param cached `true` if the program was loaded from the shader cache, `false` if it was compiled and linked.
+ */
+void record_shader_program(double duration, bool cached);
+
+/**
+ * Returns a summary of the recorded startup: its duration, its slowest phases and resources, the number of bytes read, and the number of shader programs compiled.
+ *
+ * @param count Number of the slowest phases and resources to list.
+ */
+std::string get_report(std::size_t count = 10);
+
+/**
+ * Writes all recorded phases, resources, and shader program builds as JSON.
+ *
+ * @param stream Output stream.
+ */
+void write_json(std::ostream& stream);
+
+} // namespace startup_profiler
+} // namespace debug
+
+#endif // ANTKEEPER_DEBUG_STARTUP_PROFILER_HPP
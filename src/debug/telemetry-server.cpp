@@ -0,0 +1,323 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "debug/telemetry-server.hpp"
+#include "debug/cli.hpp"
+#include "debug/counters.hpp"
+#include <sstream>
+#include <stdexcept>
+
+#if defined(_WIN32)
+	#include <winsock2.h>
+	#include <ws2tcpip.h>
+#else
+	#include <arpa/inet.h>
+	#include <cerrno>
+	#include <fcntl.h>
+	#include <netinet/in.h>
+	#include <sys/socket.h>
+	#include <unistd.h>
+#endif
+
+namespace debug {
+
+namespace {
+
+#if defined(_WIN32)
+	constexpr std::intptr_t invalid_socket = static_cast<std::intptr_t>(INVALID_SOCKET);
+	
+	inline void close_socket(std::intptr_t socket)
+	{
+		::closesocket(static_cast<SOCKET>(socket));
+	}
+	
+	inline bool would_block()
+	{
+		return WSAGetLastError() == WSAEWOULDBLOCK;
+	}
+	
+	inline bool set_nonblocking(std::intptr_t socket)
+	{
+		u_long mode = 1;
+		return ::ioctlsocket(static_cast<SOCKET>(socket), FIONBIO, &mode) == 0;
+	}
+#else
+	constexpr std::intptr_t invalid_socket = -1;
+	
+	inline void close_socket(std::intptr_t socket)
+	{
+		::close(static_cast<int>(socket));
+	}
+	
+	inline bool would_block()
+	{
+		return errno == EAGAIN || errno == EWOULDBLOCK;
+	}
+	
+	inline bool set_nonblocking(std::intptr_t socket)
+	{
+		const int flags = ::fcntl(static_cast<int>(socket), F_GETFL, 0);
+		return flags != -1 && ::fcntl(static_cast<int>(socket), F_SETFL, flags | O_NONBLOCK) != -1;
+	}
+#endif
+
+/// Writes a string as a JSON string literal.
+void write_json_string(std::ostream& stream, const std::string& string)
+{
+	stream << '"';
+	for (char c: string)
+	{
+		if (c == '"' || c == '\\')
+			stream << '\\' << c;
+		else if (c == '\n')
+			stream << "\\n";
+		else if (static_cast<unsigned char>(c) < 0x20)
+			stream << ' ';
+		else
+			stream << c;
+	}
+	stream << '"';
+}
+
+} // namespace
+
+telemetry_server::telemetry_server(std::uint16_t port):
+	listen_socket(invalid_socket),
+	cli(nullptr),
+	report_interval(std::chrono::seconds(1)),
+	start_time(std::chrono::steady_clock::now()),
+	last_report_time(start_time)
+{
+	#if defined(_WIN32)
+		WSADATA wsa_data;
+		if (WSAStartup(MAKEWORD(2, 2), &wsa_data) != 0)
+			throw std::runtime_error("Failed to initialize Winsock");
+	#endif
+	
+	listen_socket = static_cast<socket_type>(::socket(AF_INET, SOCK_STREAM, IPPROTO_TCP));
+	if (listen_socket == invalid_socket)
+	{
+		#if defined(_WIN32)
+			WSACleanup();
+		#endif
+		throw std::runtime_error("Failed to create telemetry socket");
+	}
+	
+	// Allow the port to be reused immediately when restarting soak tests
+	int reuse = 1;
+	::setsockopt(listen_socket, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&reuse), sizeof(reuse));
+	
+	// Listen on the loopback interface only, as commands are accepted without authentication
+	sockaddr_in address = {};
+	address.sin_family = AF_INET;
+	address.sin_port = htons(port);
+	address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	
+	if (::bind(listen_socket, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 ||
+		::listen(listen_socket, 4) != 0 ||
+		!set_nonblocking(listen_socket))
+	{
+		close_socket(listen_socket);
+		#if defined(_WIN32)
+			WSACleanup();
+		#endif
+		throw std::runtime_error("Failed to listen for telemetry clients on port " + std::to_string(port));
+	}
+}
+
+telemetry_server::~telemetry_server()
+{
+	for (const client& client: clients)
+		close_socket(client.socket);
+	close_socket(listen_socket);
+	
+	#if defined(_WIN32)
+		WSACleanup();
+	#endif
+}
+
+void telemetry_server::update()
+{
+	// Accept pending connections
+	for (;;)
+	{
+		const socket_type socket = static_cast<socket_type>(::accept(listen_socket, nullptr, nullptr));
+		if (socket == invalid_socket)
+			break;
+		
+		#if defined(SO_NOSIGPIPE)
+			// Sends to disconnected clients must fail rather than raise SIGPIPE
+			int no_sigpipe = 1;
+			::setsockopt(socket, SOL_SOCKET, SO_NOSIGPIPE, &no_sigpipe, sizeof(no_sigpipe));
+		#endif
+		
+		if (!set_nonblocking(socket))
+		{
+			close_socket(socket);
+			continue;
+		}
+		clients.push_back({socket, std::string()});
+	}
+	
+	// Interpret received command lines, disconnecting closed clients
+	for (std::size_t i = 0; i < clients.size();)
+	{
+		if (!receive(clients[i]))
+		{
+			close_socket(clients[i].socket);
+			clients[i] = std::move(clients.back());
+			clients.pop_back();
+			continue;
+		}
+		++i;
+	}
+	
+	// Send a report to all clients once the report interval has elapsed
+	const auto now = std::chrono::steady_clock::now();
+	if (clients.empty() || now - last_report_time < report_interval)
+		return;
+	last_report_time = now;
+	
+	std::ostringstream stream;
+	write_report(stream);
+	const std::string report = stream.str();
+	
+	for (std::size_t i = 0; i < clients.size();)
+	{
+		if (!send(clients[i], report))
+		{
+			close_socket(clients[i].socket);
+			clients[i] = std::move(clients.back());
+			clients.pop_back();
+			continue;
+		}
+		++i;
+	}
+}
+
+void telemetry_server::set_cli(const debug::cli* cli)
+{
+	this->cli = cli;
+}
+
+void telemetry_server::set_report_interval(double interval)
+{
+	report_interval = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(interval));
+}
+
+void telemetry_server::set_report_callback(const report_callback_type& callback)
+{
+	report_callback = callback;
+}
+
+bool telemetry_server::receive(client& client)
+{
+	char buffer[1024];
+	for (;;)
+	{
+		#if defined(_WIN32)
+			const int size = ::recv(static_cast<SOCKET>(client.socket), buffer, sizeof(buffer), 0);
+		#else
+			const ssize_t size = ::recv(static_cast<int>(client.socket), buffer, sizeof(buffer), 0);
+		#endif
+		
+		if (size == 0)
+			return false;
+		if (size < 0)
+			return would_block();
+		
+		client.pending_line.append(buffer, static_cast<std::size_t>(size));
+		
+		// Interpret each complete line
+		std::size_t begin = 0;
+		for (std::size_t end = client.pending_line.find('\n'); end != std::string::npos; end = client.pending_line.find('\n', begin))
+		{
+			std::string line = client.pending_line.substr(begin, end - begin);
+			begin = end + 1;
+			if (!line.empty() && line.back() == '\r')
+				line.pop_back();
+			if (line.empty() || !cli)
+				continue;
+			
+			std::ostringstream response;
+			response << "{\"command\":";
+			write_json_string(response, line);
+			response << ",\"result\":";
+			write_json_string(response, cli->interpret(line));
+			response << "}\n";
+			
+			if (!send(client, response.str()))
+				return false;
+		}
+		client.pending_line.erase(0, begin);
+		
+		// Disconnect clients which send overlong lines
+		if (client.pending_line.size() > 4096)
+			return false;
+	}
+}
+
+bool telemetry_server::send(client& client, const std::string& message)
+{
+	std::size_t offset = 0;
+	while (offset < message.size())
+	{
+		#if defined(_WIN32)
+			const int size = ::send(static_cast<SOCKET>(client.socket), message.data() + offset, static_cast<int>(message.size() - offset), 0);
+		#elif defined(MSG_NOSIGNAL)
+			const ssize_t size = ::send(static_cast<int>(client.socket), message.data() + offset, message.size() - offset, MSG_NOSIGNAL);
+		#else
+			const ssize_t size = ::send(static_cast<int>(client.socket), message.data() + offset, message.size() - offset, 0);
+		#endif
+		
+		// Partial messages can't be resumed without buffering, so clients which fall behind are dropped
+		if (size <= 0)
+			return false;
+		offset += static_cast<std::size_t>(size);
+	}
+	
+	return true;
+}
+
+void telemetry_server::write_report(std::ostream& stream) const
+{
+	const double time = std::chrono::duration<double>(last_report_time - start_time).count();
+	stream << "{\"time\":" << time;
+	
+	stream << ",\"counters\":{";
+	bool first = true;
+	for (const counters::sample& sample: counters::get_samples())
+	{
+		if (!first)
+			stream << ',';
+		first = false;
+		
+		write_json_string(stream, sample.name);
+		stream << ':' << sample.value;
+	}
+	stream << '}';
+	
+	if (report_callback)
+		report_callback(stream);
+	
+	stream << "}\n";
+}
+
+} // namespace debug
@@ -0,0 +1,129 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef ANTKEEPER_DEBUG_TELEMETRY_SERVER_HPP
+#define ANTKEEPER_DEBUG_TELEMETRY_SERVER_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace debug {
+
+class cli;
+
+/**
+ * TCP server on the loopback interface which streams telemetry to external dashboards as JSON lines, and accepts command lines from them.
+ *
+ * At each report interval, every connected client receives one JSON object terminated by a newline, with the report time, the per-frame samples of all counters and gauges, and any fields written by the report callback. Each newline-terminated line received from a client is interpreted by the CLI, and answered with a JSON object holding the command and its result.
+ *
+ * Sockets are nonblocking and serviced only by update(), so commands run on the updating thread. Only clients which keep up with the stream are served; a client whose sends would block is disconnected. The server is optional, and costs nothing unless constructed.
+ */
+class telemetry_server
+{
+public:
+	/// Callback which writes additional report fields, each preceded by a comma, such as `,"frame":{...}`.
+	typedef std::function<void(std::ostream&)> report_callback_type;
+	
+	/**
+	 * Opens a listening socket on the loopback interface.
+	 *
+	 * @param port TCP port on which to listen.
+	 *
+	 * @exception std::runtime_error Failed to open the listening socket.
+	 */
+	explicit telemetry_server(std::uint16_t port);
+	
+	/// Disconnects all clients and closes the listening socket.
+	~telemetry_server();
+	
+	telemetry_server(const telemetry_server&) = delete;
+	telemetry_server& operator=(const telemetry_server&) = delete;
+	
+	/**
+	 * Accepts pending connections, interprets the command lines received from clients, then sends a report to all clients if the report interval has elapsed since the last report.
+	 */
+	void update();
+	
+	/**
+	 * Sets the CLI by which received command lines are interpreted.
+	 *
+	 * @param cli CLI, or `nullptr` to ignore received command lines.
+	 */
+	void set_cli(const debug::cli* cli);
+	
+	/**
+	 * Sets the interval between reports.
+	 *
+	 * @param interval Time between reports, in seconds.
+	 */
+	void set_report_interval(double interval);
+	
+	/**
+	 * Sets the callback which writes additional fields into each report.
+	 *
+	 * @param callback Report callback.
+	 */
+	void set_report_callback(const report_callback_type& callback);
+	
+	/// Returns the number of connected clients.
+	std::size_t get_client_count() const;
+
+private:
+	/// Native socket handle, wide enough for both POSIX file descriptors and Winsock sockets.
+	typedef std::intptr_t socket_type;
+	
+	struct client
+	{
+		socket_type socket;
+		
+		/// Received bytes which don't yet form a complete line.
+		std::string pending_line;
+	};
+	
+	/// Receives from a client and interprets its complete lines. Returns `false` if the client has disconnected.
+	bool receive(client& client);
+	
+	/// Sends a message to a client in full. Returns `false` if the send failed or would have blocked.
+	bool send(client& client, const std::string& message);
+	
+	/// Writes a report, terminated by a newline.
+	void write_report(std::ostream& stream) const;
+	
+	socket_type listen_socket;
+	std::vector<client> clients;
+	const debug::cli* cli;
+	report_callback_type report_callback;
+	std::chrono::steady_clock::duration report_interval;
+	std::chrono::steady_clock::time_point start_time;
+	std::chrono::steady_clock::time_point last_report_time;
+};
+
+inline std::size_t telemetry_server::get_client_count() const
+{
+	return clients.size();
+}
+
+} // namespace debug
+
+#endif // ANTKEEPER_DEBUG_TELEMETRY_SERVER_HPP
@@ -26,6 +26,7 @@
 #include "entity/components/celestial-body.hpp"
 #include "entity/components/terrain.hpp"
 #include "entity/components/name.hpp"
+#include "entity/name-index.hpp"
 #include <limits>
 
 namespace entity {
@@ -168,17 +169,27 @@ void rename(entity::registry& registry, entity::id eid, const std::string& name)
 	registry.assign_or_replace<component::name>(eid, name);
 }
 
-entity::id find(entity::registry& registry, const std::string& name)
+entity::id find(entity::registry& registry, std::string_view name)
 {
-	auto view = registry.view<component::name>();
+	return get_name_index(registry).find(name);
+}
 
-	for (auto eid: view)
-	{
-		if (view.get(eid).id == name)
-			return eid;
-	}
-	
-	return entt::null;
+entity::id find(entity::registry& registry, string_id name_id)
+{
+	return get_name_index(registry).find(name_id);
+}
+
+std::vector<entity::id> find_all(entity::registry& registry, const std::string& pattern)
+{
+	return get_name_index(registry).match(pattern);
+}
+
+const name_index& get_name_index(entity::registry& registry)
+{
+	// Create the index on first use, so names assigned before then are indexed too
+	if (const name_index* index = registry.try_ctx<name_index>())
+		return *index;
+	return registry.set<name_index>(registry);
 }
 
 entity::id create(entity::registry& registry)
@@ -193,5 +204,17 @@ entity::id create(entity::registry& registry, const std::string& name)
 	return eid;
 }
 
+void create_n(entity::registry& registry, const entity::archetype& archetype, std::size_t count, std::vector<entity::id>& entities)
+{
+	const std::size_t first = entities.size();
+	entities.resize(first + count);
+	
+	// Create all entity IDs at once, recycling released IDs first
+	registry.create(entities.begin() + first, entities.end());
+	
+	for (std::size_t i = first; i < entities.size(); ++i)
+		archetype.assign(registry, entities[i]);
+}
+
 } // namespace command
 } // namespace entity
@@ -22,11 +22,18 @@
 
 #include "entity/id.hpp"
 #include "entity/registry.hpp"
+#include "entity/archetype.hpp"
 #include "utility/fundamental-types.hpp"
 #include "math/transform-type.hpp"
+#include "utility/string-id.hpp"
+#include <string>
+#include <string_view>
+#include <vector>
 
 namespace entity {
 
+class name_index;
+
 /// Commands which operate on entity::id components
 namespace command {
 
@@ -43,10 +50,46 @@ math::transform<float> get_world_transform(entity::registry& registry, entity::i
 void parent(entity::registry& registry, entity::id child, entity::id parent);
 
 void rename(entity::registry& registry, entity::id eid, const std::string& name);
-entity::id find(entity::registry& registry, const std::string& name);
+
+/**
+ * Finds an entity by name, in constant time.
+ *
+ * @return ID of an entity with the given name, or `entt::null` if no such entity exists.
+ */
+entity::id find(entity::registry& registry, std::string_view name);
+
+/**
+ * Finds an entity by the ID of its name, in constant time and without hashing.
+ *
+ * @return ID of an entity with the given name, or `entt::null` if no such entity exists.
+ */
+entity::id find(entity::registry& registry, string_id name_id);
+
+/**
+ * Finds all entities with names which match a glob pattern.
+ *
+ * @see entity::name_index::match()
+ */
+std::vector<entity::id> find_all(entity::registry& registry, const std::string& pattern);
+
+/// Returns the name index of a registry, creating it on first use.
+const name_index& get_name_index(entity::registry& registry);
+
 entity::id create(entity::registry& registry);
 entity::id create(entity::registry& registry, const std::string& name);
 
+/**
+ * Creates a batch of entities from an archetype.
+ *
+ * Entity IDs are created with a single range creation, then each entity is assigned the components of the archetype. Systems which defer their construction handlers, such as the proteome system, process the whole batch in their next update.
+ *
+ * @param registry Registry in which the entities are created.
+ * @param archetype Archetype from which the entities are created.
+ * @param count Number of entities to create.
+ * @param[out] entities Vector to which the IDs of the created entities are appended.
+ */
+void create_n(entity::registry& registry, const entity::archetype& archetype, std::size_t count, std::vector<entity::id>& entities);
+
 } // namespace command
 } // namespace entity
 
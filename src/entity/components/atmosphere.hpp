@@ -21,6 +21,8 @@
 #define ANTKEEPER_ENTITY_COMPONENT_ATMOSPHERE_HPP
 
 #include "utility/fundamental-types.hpp"
+#include "physics/atmosphere.hpp"
+#include <memory>
 
 namespace entity {
 namespace component {
@@ -54,6 +56,15 @@ struct atmosphere
 	
 	/// (Dependent) Mie scattering coefficients at sea level.
 	double3 mie_scattering;
+	
+	/// (Dependent) Scattering parameters of the atmosphere, from which its tables are integrated.
+	physics::atmosphere::scattering_parameters scattering_parameters;
+	
+	/// (Dependent) Table of Rayleigh and Mie optical depths between points in the atmosphere and the exosphere, or `nullptr` if the atmosphere has no celestial body.
+	std::shared_ptr<const physics::atmosphere::optical_depth_table<float>> optical_depth_table;
+	
+	/// (Dependent) Table of multiple scattering contributions, or `nullptr` if the atmosphere has no celestial body.
+	std::shared_ptr<const physics::atmosphere::multiple_scattering_table<float>> multiple_scattering_table;
 };
 
 } // namespace component
@@ -21,13 +21,23 @@
 #define ANTKEEPER_ENTITY_COMPONENT_BEHAVIOR_HPP
 
 #include "entity/ebt.hpp"
+#include <cstdint>
 
 namespace entity {
 namespace component {
 
 struct behavior
 {
-	const ebt::node* behavior_tree;
+	const ebt::compiled_tree* behavior_tree;
+	
+	/// Index of the node left running by the previous execution, or `ebt::compiled_tree::npos`.
+	std::uint32_t running_node;
+	
+	/// Number of ticks between evaluations of the behavior tree. `0` and `1` both evaluate every tick.
+	std::uint32_t interval;
+	
+	/// Number of ticks since the behavior tree was last evaluated.
+	std::uint32_t elapsed_ticks;
 };
 
 } // namespace component
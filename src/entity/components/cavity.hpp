@@ -21,6 +21,7 @@
 #define ANTKEEPER_ENTITY_COMPONENT_CAVITY_HPP
 
 #include "math/math.hpp"
+#include "utility/fundamental-types.hpp"
 
 namespace entity {
 namespace component {
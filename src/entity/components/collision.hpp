@@ -23,6 +23,7 @@
 #include "geom/aabb.hpp"
 #include "geom/mesh.hpp"
 #include "geom/mesh-accelerator.hpp"
+#include <memory>
 
 namespace entity {
 namespace component {
@@ -31,7 +32,9 @@ struct collision
 {
 	geom::mesh* mesh;
 	geom::aabb<float> bounds;
-	geom::mesh_accelerator mesh_accelerator;
+	
+	/// Accelerator of the mesh, shared by every collision component with the same mesh and immutable, so that copying the component does not copy its octree.
+	std::shared_ptr<const geom::mesh_accelerator> mesh_accelerator;
 };
 
 } // namespace component
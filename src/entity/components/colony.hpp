@@ -0,0 +1,46 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef ANTKEEPER_ENTITY_COMPONENT_COLONY_HPP
+#define ANTKEEPER_ENTITY_COMPONENT_COLONY_HPP
+
+#include <cstdint>
+#include <vector>
+
+namespace entity {
+namespace component {
+
+/// Aggregate state of a colony, which stands in for the members of the colony which are simulated coarsely.
+struct colony
+{
+	/// Number of coarsely simulated members performing each task, indexed by task.
+	std::vector<std::uint32_t> task_counts;
+	
+	/// Rate at which each coarsely simulated member performing a task adds food to the colony's store, or consumes it if negative, in units per second, indexed by task.
+	std::vector<float> food_rates;
+	
+	/// Food in the colony's store.
+	double food;
+};
+
+} // namespace component
+} // namespace entity
+
+#endif // ANTKEEPER_ENTITY_COMPONENT_COLONY_HPP
@@ -20,7 +20,7 @@
 #ifndef ANTKEEPER_ENTITY_COMPONENT_GENOME_HPP
 #define ANTKEEPER_ENTITY_COMPONENT_GENOME_HPP
 
-#include <string>
+#include "genetics/chromosome.hpp"
 #include <vector>
 
 namespace entity {
@@ -39,9 +39,9 @@ struct genome
 	/**
 	 * Set of DNA base sequences for every chromosomes in the genome.
 	 *
-	 * A DNA base sequence is a string of IUPAC DNA base symbols. Homologous chromosomes should be stored consecutively, such that in a diploid organism, a chromosome with an even index is homologous to the following chromosome.
+	 * A DNA base sequence is a packed sequence of IUPAC DNA base symbols. Chromosomes share interned sequences, so that siblings and clones with the same alleles don't copy them, and chromosomes are copied on write by genetics::population. Homologous chromosomes should be stored consecutively, such that in a diploid organism, a chromosome with an even index is homologous to the following chromosome.
 	 */
-	std::vector<std::string> chromosomes;
+	std::vector<genetics::chromosome> chromosomes;
 };
 
 } // namespace component
@@ -22,14 +22,47 @@
 
 #include "geom/mesh.hpp"
 #include "utility/fundamental-types.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
 
 namespace entity {
 namespace component {
 
 struct locomotion
 {
+	/// Face of the surface mesh to which the entity is attached, or `nullptr` if the entity moves freely. The surface mesh must be in the same space as the entity's local transform.
 	const geom::mesh::face* triangle;
+	
+	/// Barycentric coordinates of the entity on its face.
 	float3 barycentric_position;
+	
+	/// Position to which the entity should move.
+	float3 goal;
+	
+	/// Speed at which the entity moves along its path, in units per second.
+	float speed;
+	
+	/// Radius within which the entity keeps clear of other entities, or `0` to disable avoidance.
+	float radius;
+	
+	/// Velocity at which the entity moved during the most recent update, by which other entities anticipate its motion.
+	float3 velocity;
+	
+	/// Set to plan a path to the goal. Cleared once the request has been queued.
+	bool path_requested;
+	
+	/// Waypoints of the planned path, empty if there is no path to follow.
+	std::vector<float3> path;
+	
+	/// Index of the next waypoint to reach.
+	std::size_t waypoint;
+	
+	/// Index of the locomotion system's flow field to follow toward its goal, or `~0` to follow the planned path instead. Reset to `~0` once the goal has been reached.
+	std::uint32_t flow_field;
+	
+	/// Navigation mesh node from which the entity is following its flow field, or `~0` if it must be located.
+	std::uint32_t node;
 };
 
 } // namespace component
@@ -0,0 +1,39 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef ANTKEEPER_ENTITY_COMPONENT_N_BODY_HPP
+#define ANTKEEPER_ENTITY_COMPONENT_N_BODY_HPP
+
+namespace entity {
+namespace component {
+
+/**
+ * Integrates an orbiting body's state under the gravity of its parent and of every other n-body, rather than solving its orbit from its elements. The elements of the body's orbit only seed its initial state. All n-bodies must share the same parent.
+ */
+struct n_body
+{
+	/// Gravitational parameter (GM) of the body, in cubic meters per square day, or `0` if the body is a test particle which doesn't perturb other bodies.
+	double gm;
+};
+
+} // namespace component
+} // namespace entity
+
+#endif // ANTKEEPER_ENTITY_COMPONENT_N_BODY_HPP
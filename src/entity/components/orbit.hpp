@@ -22,6 +22,7 @@
 
 #include "physics/orbit/elements.hpp"
 #include "physics/orbit/state.hpp"
+#include "physics/frame.hpp"
 
 namespace entity {
 namespace component {
@@ -29,7 +30,14 @@ namespace component {
 struct orbit
 {
 	physics::orbit::elements<double> elements;
+	
+	/// Mean motion (n), in radians per day, by which the mean anomaly advances from its value at universal time zero.
+	double mean_motion;
+	
 	physics::orbit::state<double> state;
+	
+	/// (Dependent) Frame which transforms coordinates from perifocal space to the parent inertial space, updated whenever the component is constructed or replaced.
+	physics::frame<double> perifocal_to_inertial;
 };
 
 } // namespace component
@@ -20,6 +20,7 @@
 #ifndef ANTKEEPER_ENTITY_COMPONENT_PROTEOME_HPP
 #define ANTKEEPER_ENTITY_COMPONENT_PROTEOME_HPP
 
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -29,8 +30,8 @@ namespace component {
 /// Set of all proteins that can be expressed by an organism.
 struct proteome
 {
-	/// Set of amino acid sequences of every protein in the proteome.
-	std::vector<std::string> proteins;
+	/// Set of amino acid sequences of every protein in the proteome. Immutable, and shared by the proteomes of organisms which express the same proteins.
+	std::shared_ptr<const std::vector<std::string>> proteins;
 };
 
 } // namespace component
@@ -0,0 +1,46 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef ANTKEEPER_ENTITY_COMPONENT_SIMULATION_LOD_HPP
+#define ANTKEEPER_ENTITY_COMPONENT_SIMULATION_LOD_HPP
+
+#include "entity/id.hpp"
+#include <cstdint>
+
+namespace entity {
+namespace component {
+
+/// Allows an entity to be simulated coarsely, as part of the aggregate of its colony, while no observer is watching it.
+struct simulation_lod
+{
+	/// Colony whose aggregate represents the entity while it is simulated coarsely, or `entt::null`.
+	entity::id colony_eid;
+	
+	/// Task performed by the entity, by which it is counted in its colony's aggregate.
+	std::uint8_t task;
+	
+	/// `true` while the entity is simulated coarsely, and its behavior and locomotion components are held by the simulation LOD system.
+	bool coarse;
+};
+
+} // namespace component
+} // namespace entity
+
+#endif // ANTKEEPER_ENTITY_COMPONENT_SIMULATION_LOD_HPP
@@ -0,0 +1,49 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ANTKEEPER_ENTITY_COMPONENT_SOUND_SOURCE_HPP
+#define ANTKEEPER_ENTITY_COMPONENT_SOUND_SOURCE_HPP
+
+#include "audio/mixer.hpp"
+
+namespace entity {
+namespace component {
+
+/// Sound which plays at the world position of an entity.
+struct sound_source
+{
+	const audio::sound_wave* wave;
+	float gain;
+	float pitch;
+	
+	/// Importance of the sound when sounds compete for voices.
+	float priority;
+	
+	float reference_distance;
+	float max_distance;
+	bool looping;
+	
+	/// Handle of the playing sound, or `0` to start playing it on the next update.
+	audio::sound_id sound;
+};
+
+} // namespace component
+} // namespace entity
+
+#endif // ANTKEEPER_ENTITY_COMPONENT_SOUND_SOURCE_HPP
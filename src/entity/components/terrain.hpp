@@ -21,6 +21,8 @@
 #define ANTKEEPER_ENTITY_COMPONENT_TERRAIN_HPP
 
 #include "renderer/material.hpp"
+#include <cstddef>
+#include <cstdint>
 #include <functional>
 
 namespace entity {
@@ -31,6 +33,16 @@ struct terrain
 	/// Function object which returns elevation (in meters) given latitude (radians) and longitude (radians).
 	std::function<double(double, double)> elevation;
 	
+	/**
+	 * Function object which fills an array of elevations (in meters) given arrays of latitudes (radians) and longitudes (radians), in the order of latitudes, longitudes, elevations, and count.
+	 *
+	 * If set, terrain patches are generated with a single call per patch rather than one call to `elevation` per vertex, allowing the elevations of a patch to be evaluated in vectorized loops.
+	 */
+	std::function<void(const double*, const double*, double*, std::size_t)> batch_elevation;
+	
+	/// Seed which identifies the elevation functions and body radius of the terrain, by which its patches are cached, or `0` if its patches must not be cached.
+	std::uint64_t seed;
+	
 	/// Maximum level of detail (maximum quadtree depth level)
 	std::size_t max_lod;
 	
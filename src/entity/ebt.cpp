@@ -19,6 +19,7 @@
 
 #include "entity/ebt.hpp"
 #include "entity/components/transform.hpp"
+#include "pheromone-field.hpp"
 #include <iostream>
 
 namespace entity {
@@ -44,6 +45,40 @@ status warp_to(context& context, float x, float y, float z)
 	return status::success;
 }
 
+status deposit_pheromone(context& context, std::size_t channel, float amount)
+{
+	if (!context.pheromones)
+		return status::failure;
+	
+	const auto& transform = context.registry->get<component::transform>(context.entity_id);
+	context.pheromones->deposit(channel, transform.world.translation, amount);
+	return status::success;
+}
+
+status sense_pheromone(context& context, std::size_t channel, float threshold)
+{
+	if (!context.pheromones)
+		return status::failure;
+	
+	const auto& transform = context.registry->get<component::transform>(context.entity_id);
+	return (context.pheromones->sample(channel, transform.world.translation) >= threshold) ? status::success : status::failure;
+}
+
+status follow_pheromone(context& context, std::size_t channel, float distance)
+{
+	if (!context.pheromones)
+		return status::failure;
+	
+	auto& transform = context.registry->get<component::transform>(context.entity_id);
+	const float3 gradient = context.pheromones->sample_gradient(channel, transform.world.translation);
+	const float length = math::length(gradient);
+	if (length <= 0.0f)
+		return status::failure;
+	
+	transform.local.translation += gradient * (distance / length);
+	return status::success;
+}
+
 bool is_carrying_food(const context& context)
 {
 	return false;
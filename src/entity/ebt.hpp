@@ -21,8 +21,12 @@
 #define ANTKEEPER_ENTITY_EBT_HPP
 
 #include "ai/behavior-tree.hpp"
+#include "ai/compiled-behavior-tree.hpp"
 #include "entity/id.hpp"
 #include "entity/registry.hpp"
+#include <cstddef>
+
+class pheromone_field;
 
 namespace entity {
 
@@ -36,6 +40,9 @@ struct context
 {
 	entity::registry* registry;
 	entity::id entity_id;
+	
+	/// Pheromone field sampled and marked by behavior trees, or `nullptr`.
+	pheromone_field* pheromones;
 };
 
 typedef ai::bt::status status;
@@ -50,12 +57,22 @@ typedef ai::bt::repeater<context> repeater;
 typedef ai::bt::succeeder<context> succeeder;
 typedef ai::bt::sequence<context> sequence;
 typedef ai::bt::selector<context> selector;
+typedef ai::bt::compiled_tree<context> compiled_tree;
 
 // Actions
 status print(context& context, const std::string& text);
 status print_eid(context& context);
 status warp_to(context& context, float x, float y, float z);
 
+/// Deposits pheromones at the entity's position, failing if there is no pheromone field.
+status deposit_pheromone(context& context, std::size_t channel, float amount);
+
+/// Succeeds if the concentration of a pheromone at the entity's position reaches a threshold, and fails otherwise.
+status sense_pheromone(context& context, std::size_t channel, float threshold);
+
+/// Moves the entity a distance up the gradient of a pheromone, failing if there is no gradient to follow.
+status follow_pheromone(context& context, std::size_t channel, float distance);
+
 // Conditions
 bool is_carrying_food(const context& context);
 
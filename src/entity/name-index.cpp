@@ -0,0 +1,167 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "entity/name-index.hpp"
+
+namespace entity {
+
+name_index::name_index(entity::registry& registry)
+{
+	registry.view<component::name>().each
+	(
+		[&](entity::id eid, auto& name)
+		{
+			insert(eid, name.id);
+		}
+	);
+	
+	registry.on_construct<component::name>().connect<&name_index::on_name_construct>(this);
+	registry.on_replace<component::name>().connect<&name_index::on_name_replace>(this);
+	registry.on_destroy<component::name>().connect<&name_index::on_name_destroy>(this);
+}
+
+entity::id name_index::find(std::string_view name) const
+{
+	// Names which were never interned may share the ID of another name
+	if (entity::id eid = find(make_string_id(name)); eid != entt::null && names.at(eid) == name)
+		return eid;
+	return entt::null;
+}
+
+entity::id name_index::find(string_id name_id) const
+{
+	if (auto it = entities.find(name_id); it != entities.end())
+		return it->second;
+	return entt::null;
+}
+
+std::vector<entity::id> name_index::match(const std::string& pattern) const
+{
+	std::vector<entity::id> matches;
+	
+	// Patterns without wildcards are exact lookups
+	if (pattern.find_first_of("*?") == std::string::npos)
+	{
+		auto range = entities.equal_range(make_string_id(pattern));
+		for (auto it = range.first; it != range.second; ++it)
+		{
+			if (names.at(it->second) == pattern)
+				matches.push_back(it->second);
+		}
+		return matches;
+	}
+	
+	for (const auto& [eid, name]: names)
+	{
+		if (glob(pattern, name))
+			matches.push_back(eid);
+	}
+	
+	return matches;
+}
+
+const std::string& name_index::get_name(entity::id eid) const
+{
+	static const std::string empty;
+	if (auto it = names.find(eid); it != names.end())
+		return it->second;
+	return empty;
+}
+
+bool name_index::glob(const std::string& pattern, const std::string& string)
+{
+	std::size_t p = 0;
+	std::size_t s = 0;
+	std::size_t star = std::string::npos;
+	std::size_t resume = 0;
+	
+	while (s < string.size())
+	{
+		if (p < pattern.size() && (pattern[p] == '?' || pattern[p] == string[s]))
+		{
+			++p;
+			++s;
+		}
+		else if (p < pattern.size() && pattern[p] == '*')
+		{
+			// Initially match an empty sequence, then backtrack to here on mismatch
+			star = p++;
+			resume = s;
+		}
+		else if (star != std::string::npos)
+		{
+			p = star + 1;
+			s = ++resume;
+		}
+		else
+		{
+			return false;
+		}
+	}
+	
+	// Trailing stars match the empty sequence
+	while (p < pattern.size() && pattern[p] == '*')
+		++p;
+	
+	return p == pattern.size();
+}
+
+void name_index::insert(entity::id eid, const std::string& name)
+{
+	entities.emplace(intern_string(name), eid);
+	names[eid] = name;
+}
+
+void name_index::erase(entity::id eid)
+{
+	auto name_it = names.find(eid);
+	if (name_it == names.end())
+		return;
+	
+	auto range = entities.equal_range(make_string_id(name_it->second));
+	for (auto it = range.first; it != range.second; ++it)
+	{
+		if (it->second == eid)
+		{
+			entities.erase(it);
+			break;
+		}
+	}
+	
+	names.erase(name_it);
+}
+
+void name_index::on_name_construct(entity::registry& registry, entity::id eid, component::name& name)
+{
+	insert(eid, name.id);
+}
+
+void name_index::on_name_replace(entity::registry& registry, entity::id eid, component::name& name)
+{
+	erase(eid);
+	insert(eid, name.id);
+}
+
+void name_index::on_name_destroy(entity::registry& registry, entity::id eid)
+{
+	erase(eid);
+}
+
+} // namespace entity
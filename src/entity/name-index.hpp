@@ -0,0 +1,102 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef ANTKEEPER_ENTITY_NAME_INDEX_HPP
+#define ANTKEEPER_ENTITY_NAME_INDEX_HPP
+
+#include "entity/components/name.hpp"
+#include "entity/id.hpp"
+#include "entity/registry.hpp"
+#include "utility/string-id.hpp"
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace entity {
+
+/**
+ * Hash index of entity names, kept up to date through the construct, replace, and destroy signals of the name component.
+ *
+ * Names are interned, and entities are indexed by the IDs of their names, so that entities can be found by IDs computed at compile time, e.g. `find("planet"_sid)`.
+ */
+class name_index
+{
+public:
+	/**
+	 * Creates a name index, indexes all existing names, and connects to the name component signals of a registry.
+	 *
+	 * @param registry Registry of which entity names should be indexed.
+	 */
+	explicit name_index(entity::registry& registry);
+	
+	name_index(const name_index&) = delete;
+	name_index& operator=(const name_index&) = delete;
+	
+	/**
+	 * Finds an entity by name.
+	 *
+	 * @param name Name of the entity.
+	 * @return ID of an entity with the given name, or `entt::null` if no such entity exists.
+	 */
+	entity::id find(std::string_view name) const;
+	
+	/**
+	 * Finds an entity by the ID of its name.
+	 *
+	 * @param name_id ID of the name of the entity.
+	 * @return ID of an entity with the given name, or `entt::null` if no such entity exists.
+	 */
+	entity::id find(string_id name_id) const;
+	
+	/**
+	 * Finds all entities with names which match a glob pattern, in which `*` matches any sequence of characters and `?` matches any single character.
+	 *
+	 * @param pattern Glob pattern.
+	 * @return IDs of all matching entities.
+	 */
+	std::vector<entity::id> match(const std::string& pattern) const;
+	
+	/// Returns the name of an entity, or an empty string if the entity is unnamed.
+	const std::string& get_name(entity::id eid) const;
+	
+	/**
+	 * Returns `true` if a string matches a glob pattern.
+	 *
+	 * @see name_index::match()
+	 */
+	static bool glob(const std::string& pattern, const std::string& string);
+	
+private:
+	void insert(entity::id eid, const std::string& name);
+	void erase(entity::id eid);
+	
+	void on_name_construct(entity::registry& registry, entity::id eid, component::name& name);
+	void on_name_replace(entity::registry& registry, entity::id eid, component::name& name);
+	void on_name_destroy(entity::registry& registry, entity::id eid);
+	
+	std::unordered_multimap<string_id, entity::id> entities;
+	std::unordered_map<entity::id, std::string> names;
+};
+
+} // namespace entity
+
+#endif // ANTKEEPER_ENTITY_NAME_INDEX_HPP
+
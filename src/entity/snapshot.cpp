@@ -0,0 +1,246 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "entity/snapshot.hpp"
+#include "entity/components/brush.hpp"
+#include "entity/components/celestial-body.hpp"
+#include "entity/components/marker.hpp"
+#include "entity/components/name.hpp"
+#include "entity/components/orbit.hpp"
+#include "entity/components/parent.hpp"
+#include "entity/components/snap.hpp"
+#include "entity/components/trackable.hpp"
+#include "entity/components/transform.hpp"
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <type_traits>
+
+namespace entity {
+
+/// Components serialized into snapshots, in the order of their sections. Changing this list requires incrementing the snapshot version.
+typedef std::tuple
+<
+	component::transform,
+	component::parent,
+	component::name,
+	component::celestial_body,
+	component::orbit,
+	component::marker,
+	component::brush,
+	component::trackable,
+	component::snap,
+	component::cavity
+> snapshot_components;
+
+/// Snapshot file signature, "AKSS" in little-endian order.
+static constexpr std::uint32_t snapshot_signature = 0x53534b41;
+
+/// Number of snapshot sections: entities, destroyed entities, component blocks, and dug cavities.
+static constexpr std::size_t snapshot_section_count = 2 + std::tuple_size<snapshot_components>::value + 1;
+
+/// Writes trivially-copyable values and components to a binary stream.
+class output_archive
+{
+public:
+	explicit output_archive(std::ostream& stream):
+		stream(stream)
+	{}
+	
+	template <class T>
+	void operator()(const T& value)
+	{
+		write(value);
+	}
+	
+	template <class T>
+	void operator()(entity::id entity_id, const T& component)
+	{
+		write(entity_id);
+		write(component);
+	}
+	
+	template <class T>
+	void write(const T& value)
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "Snapshot components must be trivially copyable or have a dedicated overload.");
+		stream.write(reinterpret_cast<const char*>(&value), sizeof(T));
+	}
+	
+	void write(const component::name& name)
+	{
+		write(static_cast<std::uint32_t>(name.id.size()));
+		stream.write(name.id.data(), name.id.size());
+	}
+
+private:
+	std::ostream& stream;
+};
+
+/// Reads trivially-copyable values and components from a binary stream.
+class input_archive
+{
+public:
+	explicit input_archive(std::istream& stream):
+		stream(stream)
+	{}
+	
+	template <class T>
+	void operator()(T& value)
+	{
+		read(value);
+	}
+	
+	template <class T>
+	void operator()(entity::id& entity_id, T& component)
+	{
+		read(entity_id);
+		read(component);
+	}
+	
+	template <class T>
+	void read(T& value)
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "Snapshot components must be trivially copyable or have a dedicated overload.");
+		if (!stream.read(reinterpret_cast<char*>(&value), sizeof(T)))
+			throw std::runtime_error("Truncated snapshot");
+	}
+	
+	void read(component::name& name)
+	{
+		std::uint32_t size = 0;
+		read(size);
+		name.id.resize(size);
+		if (!stream.read(&name.id[0], size))
+			throw std::runtime_error("Truncated snapshot");
+	}
+
+private:
+	std::istream& stream;
+};
+
+template <std::size_t... I>
+static void save_components(const decltype(std::declval<const entity::registry&>().snapshot())& snapshot, output_archive& archive, std::index_sequence<I...>)
+{
+	snapshot.template component<std::tuple_element_t<I, snapshot_components>...>(archive);
+}
+
+/// Loads the block of the component with the given index.
+template <std::size_t I = 0, class Loader>
+static void load_component(Loader& loader, input_archive& archive, std::size_t index)
+{
+	if constexpr (I < std::tuple_size<snapshot_components>::value)
+	{
+		if (index == I)
+			loader.template component<std::tuple_element_t<I, snapshot_components>>(archive);
+		else
+			load_component<I + 1>(loader, archive, index);
+	}
+}
+
+void save_snapshot(const entity::registry& registry, std::ostream& stream, const std::vector<component::cavity>& cavities)
+{
+	output_archive archive(stream);
+	
+	// Write header
+	archive.write(snapshot_signature);
+	archive.write(snapshot_version);
+	archive.write(static_cast<std::uint32_t>(snapshot_section_count));
+	
+	// Write entities and component blocks
+	const auto snapshot = registry.snapshot();
+	snapshot.entities(archive);
+	snapshot.destroyed(archive);
+	save_components(snapshot, archive, std::make_index_sequence<std::tuple_size<snapshot_components>::value>{});
+	
+	// Write dug cavities
+	archive.write(static_cast<std::uint64_t>(cavities.size()));
+	for (const component::cavity& cavity: cavities)
+		archive.write(cavity);
+	
+	if (!stream)
+		throw std::runtime_error("Failed to write snapshot");
+}
+
+snapshot_loader::snapshot_loader(entity::registry& registry, std::istream& stream):
+	registry(registry),
+	stream(stream),
+	loader(registry.loader()),
+	section_count(0),
+	loaded_section_count(0)
+{
+	input_archive archive(stream);
+	
+	std::uint32_t signature = 0;
+	std::uint32_t version = 0;
+	std::uint32_t sections = 0;
+	archive.read(signature);
+	archive.read(version);
+	archive.read(sections);
+	
+	if (signature != snapshot_signature)
+		throw std::runtime_error("Invalid snapshot signature");
+	if (version != snapshot_version)
+		throw std::runtime_error("Unsupported snapshot version " + std::to_string(version));
+	if (sections != snapshot_section_count)
+		throw std::runtime_error("Invalid snapshot section count");
+	
+	section_count = sections;
+}
+
+bool snapshot_loader::load_next()
+{
+	if (loaded_section_count >= section_count)
+		return false;
+	
+	input_archive archive(stream);
+	const std::size_t section = loaded_section_count;
+	
+	if (section == 0)
+	{
+		loader.entities(archive);
+	}
+	else if (section == 1)
+	{
+		loader.destroyed(archive);
+	}
+	else if (section < section_count - 1)
+	{
+		load_component(loader, archive, section - 2);
+	}
+	else
+	{
+		// Recreate dug cavities, to be dug again by the subterrain system
+		std::uint64_t count = 0;
+		archive.read(count);
+		for (std::uint64_t i = 0; i < count; ++i)
+		{
+			component::cavity cavity;
+			archive.read(cavity);
+			registry.assign<component::cavity>(registry.create(), cavity);
+		}
+		
+		// Destroy entities which were left without components
+		loader.orphans();
+	}
+	
+	return (++loaded_section_count < section_count);
+}
+
+} // namespace entity
@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ANTKEEPER_ENTITY_SNAPSHOT_HPP
+#define ANTKEEPER_ENTITY_SNAPSHOT_HPP
+
+#include "entity/registry.hpp"
+#include "entity/components/cavity.hpp"
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <utility>
+#include <vector>
+
+namespace entity {
+
+/// Version of the binary snapshot format, incremented whenever the set of serialized components or their layouts change.
+constexpr std::uint32_t snapshot_version = 2;
+
+/**
+ * Writes a binary snapshot of a registry.
+ *
+ * A snapshot consists of a header followed by sections: the entities of the registry, its destroyed entities, one contiguous block per serializable component type, and a list of dug cavities. Only components without references to resources or other runtime objects are serialized; the components of an entity which refer to resources, such as models, should be restored from its archetype.
+ *
+ * @param registry Registry to save.
+ * @param stream Binary output stream.
+ * @param cavities Cavities dug into the subterrain isosurface, such as those returned by system::subterrain::get_dug_cavities(), which are restored as cavity components to be dug again.
+ *
+ * @exception std::runtime_error Failed to write the snapshot.
+ */
+void save_snapshot(const entity::registry& registry, std::ostream& stream, const std::vector<component::cavity>& cavities);
+
+/**
+ * Loads a binary snapshot into an empty registry, one section at a time, so that loading can be spread over several frames.
+ */
+class snapshot_loader
+{
+public:
+	/**
+	 * Reads and validates the header of a snapshot.
+	 *
+	 * @param registry Empty registry into which the snapshot is loaded.
+	 * @param stream Binary input stream, which must remain valid until the snapshot has been loaded.
+	 *
+	 * @exception std::runtime_error Invalid snapshot or unsupported snapshot version.
+	 */
+	snapshot_loader(entity::registry& registry, std::istream& stream);
+	
+	/**
+	 * Loads the next section of the snapshot.
+	 *
+	 * @return `true` if sections remain to be loaded, `false` once the snapshot has been loaded.
+	 *
+	 * @exception std::runtime_error Truncated snapshot.
+	 */
+	bool load_next();
+	
+	/// Returns the total number of sections in the snapshot.
+	std::size_t get_section_count() const;
+	
+	/// Returns the number of sections loaded so far.
+	std::size_t get_loaded_section_count() const;
+
+private:
+	entity::registry& registry;
+	std::istream& stream;
+	decltype(std::declval<entity::registry&>().loader()) loader;
+	std::size_t section_count;
+	std::size_t loaded_section_count;
+};
+
+inline std::size_t snapshot_loader::get_section_count() const
+{
+	return section_count;
+}
+
+inline std::size_t snapshot_loader::get_loaded_section_count() const
+{
+	return loaded_section_count;
+}
+
+} // namespace entity
+
+#endif // ANTKEEPER_ENTITY_SNAPSHOT_HPP
@@ -21,7 +21,6 @@
 #include "astro/apparent-size.hpp"
 #include "entity/components/blackbody.hpp"
 #include "entity/components/transform.hpp"
-#include "geom/intersection.hpp"
 #include "color/color.hpp"
 #include "physics/orbit/orbit.hpp"
 #include "physics/time/ut1.hpp"
@@ -39,7 +38,7 @@ template <class T>
 math::vector3<T> transmittance(T depth_r, T depth_m, T depth_o, const math::vector3<T>& beta_r, const math::vector3<T>& beta_m)
 {
 	math::vector3<T> transmittance_r = beta_r * depth_r;
-	math::vector3<T> transmittance_m = beta_m * 1.1 * depth_m;
+	math::vector3<T> transmittance_m = beta_m * physics::atmosphere::mie_extinction_ratio<T> * depth_m;
 	math::vector3<T> transmittance_o = {0, 0, 0};
 	
 	math::vector3<T> t = transmittance_r + transmittance_m + transmittance_o;
@@ -78,6 +77,10 @@ astronomy::astronomy(entity::registry& registry):
 	
 	registry.on_construct<entity::component::celestial_body>().connect<&astronomy::on_celestial_body_construct>(this);
 	registry.on_replace<entity::component::celestial_body>().connect<&astronomy::on_celestial_body_replace>(this);
+	
+	// Track orbiting bodies in non-owning groups, which don't reorder the pools into which the reference body and orbit pointers point
+	registry.group<>(entt::get<entity::component::celestial_body, entity::component::orbit, entity::component::transform>);
+	registry.group<>(entt::get<entity::component::celestial_body, entity::component::orbit, entity::component::blackbody>);
 }
 
 void astronomy::update(double t, double dt)
@@ -105,7 +108,7 @@ void astronomy::update(double t, double dt)
 	inertial_to_topocentric = inertial_to_bcbf * bcbf_to_topocentric;
 	
 	// Set the transform component translations of orbiting bodies to their topocentric positions
-	registry.view<component::celestial_body, component::orbit, component::transform>().each(
+	registry.group<>(entt::get<component::celestial_body, component::orbit, component::transform>).each(
 	[&](entity::id entity_id, const auto& celestial_body, const auto& orbit, auto& transform)
 	{
 		// Transform Cartesian position vector (r) from inertial space to topocentric space
@@ -116,7 +119,7 @@ void astronomy::update(double t, double dt)
 	});
 	
 	// Update blackbody lighting
-	registry.view<component::celestial_body, component::orbit, component::blackbody>().each(
+	registry.group<>(entt::get<component::celestial_body, component::orbit, component::blackbody>).each(
 	[&](entity::id entity_id, const auto& celestial_body, const auto& orbit, const auto& blackbody)
 	{
 		// Calculate blackbody inertial basis
@@ -137,31 +140,17 @@ void astronomy::update(double t, double dt)
 		// Init atmospheric transmittance
 		double3 atmospheric_transmittance = {1.0, 1.0, 1.0};
 		
-		// Get atmosphere component of reference body (if any)
-		if (reference_atmosphere)
+		// Look up atmospheric transmittance between the observer and the blackbody, if the reference body has an atmosphere
+		if (reference_atmosphere && reference_atmosphere->optical_depth_table)
 		{
-			// Altitude of observer in meters	
-			geom::ray<double> sample_ray;
-			sample_ray.origin = {0, reference_body->radius + observer_location[0], 0};
-			sample_ray.direction = math::normalize(blackbody_position_topocentric);
-			
-			geom::sphere<double> exosphere;
-			exosphere.center = {0, 0, 0};
-			exosphere.radius = reference_body->radius + reference_atmosphere->exosphere_altitude;
+			const double cos_zenith = math::normalize(blackbody_position_topocentric).y;
+			const float2 optical_depth = reference_atmosphere->optical_depth_table->lookup(static_cast<float>(observer_location[0]), static_cast<float>(cos_zenith));
 			
-			auto intersection_result = geom::ray_sphere_intersection(sample_ray, exosphere);
+			double optical_depth_r = static_cast<double>(optical_depth.x);
+			double optical_depth_k = static_cast<double>(optical_depth.y);
+			double optical_depth_o = 0.0;
 			
-			if (std::get<0>(intersection_result))
-			{
-				double3 sample_start = sample_ray.origin;
-				double3 sample_end = sample_ray.extrapolate(std::get<2>(intersection_result));
-				
-				double optical_depth_r = physics::atmosphere::optical_depth(sample_start, sample_end, reference_body->radius, reference_atmosphere->rayleigh_scale_height, 32);
-				double optical_depth_k = physics::atmosphere::optical_depth(sample_start, sample_end, reference_body->radius, reference_atmosphere->mie_scale_height, 32);
-				double optical_depth_o = 0.0;
-				
-				atmospheric_transmittance = transmittance(optical_depth_r, optical_depth_k, optical_depth_o, reference_atmosphere->rayleigh_scattering, reference_atmosphere->mie_scattering);
-			}
+			atmospheric_transmittance = transmittance(optical_depth_r, optical_depth_k, optical_depth_o, reference_atmosphere->rayleigh_scattering, reference_atmosphere->mie_scattering);
 		}
 		
 		if (sun_light != nullptr)
@@ -196,6 +185,8 @@ void astronomy::update(double t, double dt)
 				
 				double blackbody_angular_radius = std::asin((celestial_body.radius * 2.0) / (blackbody_distance * 2.0));
 				this->sky_pass->set_sun_angular_radius(static_cast<float>(blackbody_angular_radius));
+				
+				update_sky_view(math::normalize(blackbody_position_topocentric).y);
 			}
 		}
 	});
@@ -223,10 +214,43 @@ void astronomy::update(double t, double dt)
 			sky_pass->set_scattering_coefficients(math::type_cast<float>(reference_atmosphere->rayleigh_scattering), math::type_cast<float>(reference_atmosphere->mie_scattering));
 			sky_pass->set_mie_anisotropy(reference_atmosphere->mie_anisotropy);
 			sky_pass->set_atmosphere_radii(reference_body->radius, reference_body->radius + reference_atmosphere->exosphere_altitude);
+			sky_pass->set_optical_depth_table(reference_atmosphere->optical_depth_table);
+			sky_pass->set_multiple_scattering_table(reference_atmosphere->multiple_scattering_table);
 		}
 	}
 }
 
+void astronomy::update_sky_view(double cos_sun_zenith)
+{
+	if (!reference_atmosphere || !reference_atmosphere->optical_depth_table || !reference_atmosphere->multiple_scattering_table)
+		return;
+	
+	if (sky_view_table &&
+		sky_view_multiple_scattering_table == reference_atmosphere->multiple_scattering_table &&
+		std::abs(sky_view_table->get_cos_sun_zenith() - cos_sun_zenith) < sky_view_cos_zenith_tolerance &&
+		std::abs(sky_view_table->get_altitude() - observer_location[0]) < sky_view_altitude_tolerance)
+	{
+		return;
+	}
+	
+	auto table = std::make_shared<physics::atmosphere::sky_view_table<float>>();
+	table->generate
+	(
+		reference_atmosphere->scattering_parameters,
+		*reference_atmosphere->optical_depth_table,
+		*reference_atmosphere->multiple_scattering_table,
+		observer_location[0],
+		cos_sun_zenith,
+		sky_view_table_rows,
+		sky_view_table_columns
+	);
+	
+	sky_view_table = std::move(table);
+	sky_view_multiple_scattering_table = reference_atmosphere->multiple_scattering_table;
+	
+	sky_pass->set_sky_view_table(sky_view_table);
+}
+
 void astronomy::set_universal_time(double time)
 {
 	universal_time = time;
@@ -29,12 +29,17 @@
 #include "entity/components/atmosphere.hpp"
 #include "entity/components/celestial-body.hpp"
 #include "entity/components/orbit.hpp"
+#include "physics/atmosphere.hpp"
+#include <cstddef>
+#include <memory>
 
 namespace entity {
 namespace system {
 
 /**
  * Calculates apparent properties of celestial bodies relative to an observer.
+ *
+ * Orbiting bodies are iterated through non-owning groups of celestial bodies and orbits with transforms, and with blackbodies, created with the system, which keep packed lists of their entities.
  */
 class astronomy:
 	public updatable
@@ -87,6 +92,13 @@ private:
 	void on_celestial_body_replace(entity::registry& registry, entity::id entity_id, entity::component::celestial_body& celestial_body);
 	
 	void update_bcbf_to_topocentric();
+	
+	/**
+	 * Regenerates the sky view table of the reference atmosphere and uploads it to the sky pass, if the sun's elevation, the observer's altitude, or the atmosphere's tables have changed beyond tolerance since it was last generated.
+	 *
+	 * @param cos_sun_zenith Cosine of the angle between the sun direction and the observer's zenith.
+	 */
+	void update_sky_view(double cos_sun_zenith);
 
 	double universal_time;
 	double time_scale;
@@ -106,6 +118,24 @@ private:
 	
 	scene::directional_light* sun_light;
 	sky_pass* sky_pass;
+	
+	/// Sky view table of the reference atmosphere, as seen by the observer.
+	std::shared_ptr<const physics::atmosphere::sky_view_table<float>> sky_view_table;
+	
+	/// Multiple scattering table from which the sky view table was generated.
+	std::shared_ptr<const physics::atmosphere::multiple_scattering_table<float>> sky_view_multiple_scattering_table;
+	
+	/// Change in the cosine of the sun zenith angle beyond which the sky view table is regenerated.
+	static constexpr double sky_view_cos_zenith_tolerance = 1e-3;
+	
+	/// Change in observer altitude beyond which the sky view table is regenerated, in meters.
+	static constexpr double sky_view_altitude_tolerance = 1.0;
+	
+	/// Number of elevation samples in the sky view table.
+	static constexpr std::size_t sky_view_table_rows = 48;
+	
+	/// Number of azimuth samples in the sky view table.
+	static constexpr std::size_t sky_view_table_columns = 64;
 };
 
 } // namespace system
@@ -19,6 +19,7 @@
 
 #include "entity/systems/atmosphere.hpp"
 #include "physics/atmosphere.hpp"
+#include <memory>
 
 namespace entity {
 namespace system {
@@ -28,8 +29,14 @@ atmosphere::atmosphere(entity::registry& registry):
 	rgb_wavelengths_nm{0, 0, 0},
 	rgb_wavelengths_m{0, 0, 0}
 {
+	// Atmosphere coefficients are updated from component callbacks only
+	declare_writes<>();
+	
 	registry.on_construct<entity::component::atmosphere>().connect<&atmosphere::on_atmosphere_construct>(this);
 	registry.on_replace<entity::component::atmosphere>().connect<&atmosphere::on_atmosphere_replace>(this);
+	
+	registry.on_construct<entity::component::celestial_body>().connect<&atmosphere::on_celestial_body_construct>(this);
+	registry.on_replace<entity::component::celestial_body>().connect<&atmosphere::on_celestial_body_replace>(this);
 }
 
 void atmosphere::update(double t, double dt)
@@ -70,6 +77,50 @@ void atmosphere::update_coefficients(entity::id entity_id)
 		mie_scattering,
 		mie_scattering
 	};
+	
+	// Abort if entity has no celestial body component
+	atmosphere.optical_depth_table = nullptr;
+	atmosphere.multiple_scattering_table = nullptr;
+	if (!registry.has<component::celestial_body>(entity_id))
+		return;
+	
+	// Get celestial body component of the entity
+	const component::celestial_body& celestial_body = registry.get<component::celestial_body>(entity_id);
+	
+	// Integrate optical depth table
+	auto optical_depth_table = std::make_shared<physics::atmosphere::optical_depth_table<float>>();
+	optical_depth_table->generate
+	(
+		celestial_body.radius,
+		atmosphere.exosphere_altitude,
+		atmosphere.rayleigh_scale_height,
+		atmosphere.mie_scale_height,
+		optical_depth_table_rows,
+		optical_depth_table_columns
+	);
+	
+	// Gather scattering parameters
+	physics::atmosphere::scattering_parameters& scattering_parameters = atmosphere.scattering_parameters;
+	scattering_parameters.radius = celestial_body.radius;
+	scattering_parameters.exosphere_altitude = atmosphere.exosphere_altitude;
+	scattering_parameters.rayleigh_scale_height = atmosphere.rayleigh_scale_height;
+	scattering_parameters.mie_scale_height = atmosphere.mie_scale_height;
+	scattering_parameters.rayleigh_scattering = atmosphere.rayleigh_scattering;
+	scattering_parameters.mie_scattering = atmosphere.mie_scattering;
+	scattering_parameters.mie_anisotropy = atmosphere.mie_anisotropy;
+	
+	// Integrate multiple scattering table, attenuating sunlight by the optical depth table
+	auto multiple_scattering_table = std::make_shared<physics::atmosphere::multiple_scattering_table<float>>();
+	multiple_scattering_table->generate
+	(
+		scattering_parameters,
+		*optical_depth_table,
+		multiple_scattering_table_rows,
+		multiple_scattering_table_columns
+	);
+	
+	atmosphere.optical_depth_table = std::move(optical_depth_table);
+	atmosphere.multiple_scattering_table = std::move(multiple_scattering_table);
 }
 
 void atmosphere::on_atmosphere_construct(entity::registry& registry, entity::id entity_id, entity::component::atmosphere& atmosphere)
@@ -82,5 +133,15 @@ void atmosphere::on_atmosphere_replace(entity::registry& registry, entity::id en
 	update_coefficients(entity_id);
 }
 
+void atmosphere::on_celestial_body_construct(entity::registry& registry, entity::id entity_id, entity::component::celestial_body& celestial_body)
+{
+	update_coefficients(entity_id);
+}
+
+void atmosphere::on_celestial_body_replace(entity::registry& registry, entity::id entity_id, entity::component::celestial_body& celestial_body)
+{
+	update_coefficients(entity_id);
+}
+
 } // namespace system
 } // namespace entity
@@ -24,12 +24,16 @@
 #include "entity/id.hpp"
 #include "utility/fundamental-types.hpp"
 #include "entity/components/atmosphere.hpp"
+#include "entity/components/celestial-body.hpp"
+#include <cstddef>
 
 namespace entity {
 namespace system {
 
 /**
  * Updates variables related to atmospheric scattering.
+ *
+ * Whenever an atmosphere or the celestial body to which it belongs changes, its scattering coefficients are recalculated and tables of its optical depths and multiple scattering contributions are integrated, so that transmittance and sky luminance can be looked up by the CPU and, as textures, by the sky shader.
  */
 class atmosphere:
 	public updatable
@@ -51,6 +55,20 @@ private:
 	
 	void on_atmosphere_construct(entity::registry& registry, entity::id entity_id, entity::component::atmosphere& atmosphere);
 	void on_atmosphere_replace(entity::registry& registry, entity::id entity_id, entity::component::atmosphere& atmosphere);
+	void on_celestial_body_construct(entity::registry& registry, entity::id entity_id, entity::component::celestial_body& celestial_body);
+	void on_celestial_body_replace(entity::registry& registry, entity::id entity_id, entity::component::celestial_body& celestial_body);
+	
+	/// Number of altitude samples in optical depth tables.
+	static constexpr std::size_t optical_depth_table_rows = 64;
+	
+	/// Number of zenith angle samples in optical depth tables.
+	static constexpr std::size_t optical_depth_table_columns = 256;
+	
+	/// Number of altitude samples in multiple scattering tables.
+	static constexpr std::size_t multiple_scattering_table_rows = 16;
+	
+	/// Number of sun zenith angle samples in multiple scattering tables.
+	static constexpr std::size_t multiple_scattering_table_columns = 32;
 	
 	double3 rgb_wavelengths_nm;
 	double3 rgb_wavelengths_m;
@@ -19,29 +19,125 @@
 
 #include "entity/systems/behavior.hpp"
 #include "entity/components/behavior.hpp"
+#include "entity/components/observer.hpp"
+#include "entity/components/transform.hpp"
 #include "entity/id.hpp"
+#include "utility/job-system.hpp"
+#include <algorithm>
 
 namespace entity {
 namespace system {
 
 behavior::behavior(entity::registry& registry):
-	updatable(registry)
+	updatable(registry),
+	jobs(nullptr),
+	evaluation_budget(0),
+	priority_distance(0.0f),
+	pheromones(nullptr)
 {}
 
 void behavior::update(double t, double dt)
 {
-	ebt::context context;
-	context.registry = &registry;
-
-	registry.view<component::behavior>().each(
-		[&](entity::id entity_id, auto& behavior)
+	auto view = registry.view<component::behavior>();
+	
+	// Find the observer camera, from which distances are measured
+	const scene::camera* camera = nullptr;
+	if (evaluation_budget && priority_distance > 0.0f)
+	{
+		registry.view<component::observer>().each
+		(
+			[&](entity::id entity_id, auto& observer)
+			{
+				if (!camera)
+					camera = observer.camera;
+			}
+		);
+	}
+	
+	// Gather due entities
+	entities.clear();
+	candidates.clear();
+	for (entity::id entity_id: view)
+	{
+		component::behavior& behavior = view.get(entity_id);
+		if (!behavior.behavior_tree)
+			continue;
+		
+		const std::uint32_t interval = std::max<std::uint32_t>(behavior.interval, 1);
+		if (++behavior.elapsed_ticks < interval)
+			continue;
+		
+		if (!evaluation_budget)
 		{
-			if (behavior.behavior_tree)
+			entities.push_back(entity_id);
+			continue;
+		}
+		
+		float priority = static_cast<float>(behavior.elapsed_ticks) / static_cast<float>(interval);
+		if (camera)
+		{
+			if (const component::transform* transform = registry.try_get<component::transform>(entity_id))
 			{
-				context.entity_id = entity_id;
-				behavior.behavior_tree->execute(context);
+				const float distance = math::length(transform->world.translation - camera->get_translation());
+				priority /= 1.0f + distance / priority_distance;
 			}
-		});
+		}
+		
+		candidates.emplace_back(priority, entity_id);
+	}
+	
+	// Select the highest-priority due entities within the budget
+	if (evaluation_budget)
+	{
+		auto by_priority = [](const auto& a, const auto& b){return a.first > b.first;};
+		if (candidates.size() > evaluation_budget)
+			std::nth_element(candidates.begin(), candidates.begin() + evaluation_budget, candidates.end(), by_priority);
+		
+		const std::size_t count = std::min(candidates.size(), evaluation_budget);
+		for (std::size_t i = 0; i < count; ++i)
+			entities.push_back(candidates[i].second);
+	}
+	
+	auto evaluate = [this, &view](std::size_t first, std::size_t last)
+	{
+		ebt::context context;
+		context.registry = &registry;
+		context.pheromones = pheromones;
+		
+		for (std::size_t i = first; i < last; ++i)
+		{
+			component::behavior& behavior = view.get(entities[i]);
+			behavior.elapsed_ticks = 0;
+			
+			context.entity_id = entities[i];
+			behavior.behavior_tree->execute(context, behavior.running_node);
+		}
+	};
+	
+	if (jobs)
+		jobs->parallel_for(0, entities.size(), 64, evaluate);
+	else
+		evaluate(0, entities.size());
+}
+
+void behavior::set_job_system(job_system* jobs)
+{
+	this->jobs = jobs;
+}
+
+void behavior::set_evaluation_budget(std::size_t budget)
+{
+	evaluation_budget = budget;
+}
+
+void behavior::set_priority_distance(float distance)
+{
+	priority_distance = distance;
+}
+
+void behavior::set_pheromone_field(pheromone_field* field)
+{
+	pheromones = field;
 }
 
 } // namespace system
@@ -21,18 +21,76 @@
 #define ANTKEEPER_ENTITY_SYSTEM_BEHAVIOR_HPP
 
 #include "entity/systems/updatable.hpp"
+#include "entity/id.hpp"
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+class job_system;
+class pheromone_field;
 
 namespace entity {
 namespace system {
 
+/**
+ * Executes the compiled behavior trees of entities.
+ *
+ * Each entity is due for evaluation once its tick interval has elapsed. If an evaluation budget is set, only that many due entities are evaluated per update, in order of priority. An entity's priority grows with the number of ticks it is overdue, and is scaled down with its distance from the observer camera. Skipped entities therefore gain priority each tick until they are evaluated, so all entities are serviced round-robin while nearby entities are serviced more often.
+ *
+ * Entities are evaluated in parallel if a job system has been set, so behavior tree functions may only modify their own entity's existing components.
+ */
 class behavior:
 	public updatable
 {
 public:
 	behavior(entity::registry& registry);
 	virtual void update(double t, double dt);
+	
+	/**
+	 * Sets the job system on which entities are evaluated in parallel.
+	 *
+	 * @param jobs Job system, or `nullptr` to evaluate all entities on the calling thread.
+	 */
+	void set_job_system(job_system* jobs);
+	
+	/**
+	 * Sets the maximum number of behavior trees evaluated per update.
+	 *
+	 * @param budget Maximum number of evaluations per update, or `0` to evaluate all due entities.
+	 */
+	void set_evaluation_budget(std::size_t budget);
+	
+	/**
+	 * Sets the distance from the observer camera at which an entity's priority is halved.
+	 *
+	 * @param distance Half-priority distance, or `0` to disregard distance.
+	 */
+	void set_priority_distance(float distance);
+	
+	/**
+	 * Sets the pheromone field which behavior trees sample and mark.
+	 *
+	 * @param field Pheromone field, or `nullptr`.
+	 */
+	void set_pheromone_field(pheromone_field* field);
+	
+	/// Returns the number of behavior trees evaluated by the most recent update.
+	std::size_t get_evaluation_count() const;
+	
+private:
+	job_system* jobs;
+	std::size_t evaluation_budget;
+	float priority_distance;
+	pheromone_field* pheromones;
+	std::vector<entity::id> entities;
+	std::vector<std::pair<float, entity::id>> candidates;
 };
 
+inline std::size_t behavior::get_evaluation_count() const
+{
+	return entities.size();
+}
+
 } // namespace system
 } // namespace entity
 
@@ -31,9 +31,11 @@ blackbody::blackbody(entity::registry& registry):
 	rgb_wavelengths_nm{0, 0, 0},
 	rgb_wavelengths_m{0, 0, 0}
 {
-	// Construct a range of sample wavelengths in the visible spectrum
-	visible_wavelengths_nm.resize(780 - 280);
-	std::iota(visible_wavelengths_nm.begin(), visible_wavelengths_nm.end(), 280);
+	// Tabulate luminous efficacies from red dwarfs to O-type stars
+	luminous_efficacy_table.generate(&blackbody::integrate_luminous_efficacy, 1000.0, 40000.0, 512);
+	
+	// Luminous intensities are updated from component callbacks only
+	declare_writes<>();
 	
 	registry.on_construct<entity::component::blackbody>().connect<&blackbody::on_blackbody_construct>(this);
 	registry.on_replace<entity::component::blackbody>().connect<&blackbody::on_blackbody_replace>(this);
@@ -51,6 +53,28 @@ void blackbody::set_rgb_wavelengths(const double3& wavelengths)
 	rgb_wavelengths_m = wavelengths * 1e-9;
 }
 
+double3 blackbody::integrate_luminous_efficacy(double temperature)
+{
+	// Construct a lambda function which calculates the ACEScg luminous exitance of a given wavelength
+	auto rgb_luminous_exitance = [temperature](double wavelength_nm) -> double3
+	{
+		// Convert wavelength from nanometers to meters
+		const double wavelength_m = wavelength_nm * 1e-9;
+		
+		// Calculate the spectral exitance of the wavelength
+		const double spectral_exitance = physics::light::blackbody::spectral_exitance<double>(temperature, wavelength_m);
+		
+		// Calculate the ACEScg color of the wavelength using CIE color matching functions
+		double3 spectral_color = color::xyz::to_acescg(color::xyz::match(wavelength_nm));
+		
+		// Scale the spectral color by spectral exitance
+		return spectral_color * spectral_exitance * 1e-9 * physics::light::max_luminous_efficacy<double>;
+	};
+	
+	// Integrate the ACEScg luminous exitance over wavelengths in the visible spectrum, with 16 Gauss-Legendre nodes on each of 8 intervals, and divide by the radiant exitance
+	return math::quadrature::gauss<16>(rgb_luminous_exitance, 280.0, 780.0, 8) / physics::light::blackbody::radiant_exitance<double>(temperature);
+}
+
 void blackbody::update_luminous_intensity(entity::id entity_id)
 {
 	// Abort if entity has no blackbody component
@@ -73,24 +97,11 @@ void blackbody::update_luminous_intensity(entity::id entity_id)
 	// Calculate (spherical) surface area of the celestial body
 	const double surface_area = 4.0 * math::pi<double> * celestial_body.radius * celestial_body.radius;
 	
-	// Construct a lambda function which calculates the blackbody's RGB luminous intensity of a given wavelength
-	auto rgb_luminous_intensity = [blackbody, surface_area](double wavelength_nm) -> double3
-	{
-		// Convert wavelength from nanometers to meters
-		const double wavelength_m = wavelength_nm * 1e-9;
-		
-		// Calculate the spectral intensity of the wavelength
-		const double spectral_intensity = physics::light::blackbody::spectral_intensity<double>(blackbody.temperature, surface_area, wavelength_m);
-		
-		// Calculate the ACEScg color of the wavelength using CIE color matching functions
-		double3 spectral_color = color::xyz::to_acescg(color::xyz::match(wavelength_nm));
-		
-		// Scale the spectral color by spectral intensity
-		return spectral_color * spectral_intensity * 1e-9 * physics::light::max_luminous_efficacy<double>;
-	};
+	// Look up the luminous efficacy of the blackbody, integrating temperatures outside the table
+	const double3 luminous_efficacy = luminous_efficacy_table.contains(blackbody.temperature) ? luminous_efficacy_table.lookup(blackbody.temperature) : integrate_luminous_efficacy(blackbody.temperature);
 	
-	// Integrate the blackbody RGB luminous intensity over wavelengths in the visible spectrum
-	blackbody.luminous_intensity = math::quadrature::simpson(rgb_luminous_intensity, visible_wavelengths_nm.begin(), visible_wavelengths_nm.end());
+	// Scale the luminous efficacy by the radiant intensity of the blackbody
+	blackbody.luminous_intensity = luminous_efficacy * physics::light::blackbody::radiant_intensity<double>(blackbody.temperature, surface_area);
 }
 
 void blackbody::on_blackbody_construct(entity::registry& registry, entity::id entity_id, entity::component::blackbody& blackbody)
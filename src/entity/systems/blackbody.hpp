@@ -25,13 +25,15 @@
 #include "utility/fundamental-types.hpp"
 #include "entity/components/blackbody.hpp"
 #include "entity/components/celestial-body.hpp"
-#include <vector>
+#include "color/cct.hpp"
 
 namespace entity {
 namespace system {
 
 /**
  * Calculates the RGB luminous intensity of blackbody radiators.
+ *
+ * The luminous efficacy of blackbody radiation, as an ACEScg color, is tabulated once over common stellar temperatures, so that the luminous intensity of a blackbody is found by a single table lookup. The spectra of temperatures outside the table are integrated when their components change.
  */
 class blackbody:
 	public updatable
@@ -49,6 +51,14 @@ public:
 	void set_rgb_wavelengths(const double3& wavelengths);
 	
 private:
+	/**
+	 * Integrates the luminous efficacy of blackbody radiation over the visible spectrum.
+	 *
+	 * @param temperature Blackbody temperature, in Kelvin.
+	 * @return ACEScg luminous efficacy, in lumens per watt.
+	 */
+	static double3 integrate_luminous_efficacy(double temperature);
+	
 	void update_luminous_intensity(entity::id entity_id);
 	
 	void on_blackbody_construct(entity::registry& registry, entity::id entity_id, entity::component::blackbody& blackbody);
@@ -59,7 +69,9 @@ private:
 	
 	double3 rgb_wavelengths_nm;
 	double3 rgb_wavelengths_m;
-	std::vector<double> visible_wavelengths_nm;
+	
+	/// Table of ACEScg luminous efficacies of blackbody temperatures.
+	color::cct::table<double> luminous_efficacy_table;
 };
 
 } // namespace system
@@ -17,31 +17,361 @@
  * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+
 #include "collision.hpp"
 #include "entity/components/transform.hpp"
+#include "debug/draw.hpp"
+#include "geom/intersection.hpp"
+#include "geom/morton.hpp"
+#include "math/math.hpp"
+#include "utility/job-system.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <utility>
 
 namespace entity {
 namespace system {
 
 collision::collision(entity::registry& registry):
-	updatable(registry)
+	updatable(registry),
+	jobs(nullptr),
+	build_budget(256),
+	async_build_threshold(4096)
 {
+	declare_reads<component::transform>();
+	declare_writes<component::collision>();
+	
 	registry.on_construct<component::collision>().connect<&collision::on_collision_construct>(this);
 	registry.on_replace<component::collision>().connect<&collision::on_collision_replace>(this);
 	registry.on_destroy<component::collision>().connect<&collision::on_collision_destroy>(this);
 }
 
+collision::~collision()
+{
+	// Jobs reference their builds, so they must complete first
+	for (const auto& build: builds)
+	{
+		if (build->jobs)
+		{
+			try
+			{
+				build->jobs->wait(build->counter);
+			}
+			catch (...) {}
+		}
+	}
+}
+
 void collision::update(double t, double dt)
-{}
+{
+	// Swap in completed accelerators, progressing one time-sliced build per update
+	bool stepped = false;
+	for (auto it = builds.begin(); it != builds.end();)
+	{
+		accelerator_build& build = **it;
+		
+		if (build.jobs)
+		{
+			if (!build.counter.is_done())
+			{
+				++it;
+				continue;
+			}
+		}
+		else if (!build.stale)
+		{
+			if (stepped || !build.builder->step(build_budget))
+			{
+				stepped = true;
+				++it;
+				continue;
+			}
+			
+			stepped = true;
+			build.builder->finish(*build.accelerator);
+		}
+		
+		if (!build.stale)
+			install_accelerator(*build.mesh, build.accelerator);
+		it = builds.erase(it);
+	}
+	
+	// Update the bounds of moved collision components. Leaves which moved within their enlarged bounds are left in place.
+	registry.view<component::transform, component::collision>().each
+	(
+		[&](entity::id entity_id, auto& transform, auto& collision)
+		{
+			if (auto it = proxies.find(entity_id); it != proxies.end())
+				broadphase.update(it->second, geom::aabb<float>::transform(collision.bounds, transform.local));
+		}
+	);
+}
+
+void collision::draw_accelerators() const
+{
+	if (!debug::draw::is_enabled(debug::draw::mesh_accelerator_cells))
+		return;
+	
+	registry.view<component::collision>().each
+	(
+		[&](entity::id entity_id, const auto& collision)
+		{
+			if (!collision.mesh_accelerator)
+				return;
+			
+			math::transform<float> transform = math::identity_transform<float>;
+			if (const component::transform* component = registry.try_get<component::transform>(entity_id))
+				transform = component->local;
+			
+			// Fade deeper cells, so that the leaves of coarse regions stand out
+			collision.mesh_accelerator->visit_leaves
+			(
+				[&](const geom::aabb<float>& bounds, std::size_t depth)
+				{
+					const float alpha = std::max(0.25f, 1.0f - static_cast<float>(depth) / 32.0f);
+					debug::draw::box(bounds, transform, float4{0.2f, 1.0f, 1.0f, alpha});
+				}
+			);
+		}
+	);
+}
+
+std::optional<collision::ray_query_result> collision::query_nearest(const geom::ray<float>& ray) const
+{
+	std::optional<ray_query_result> nearest;
+	
+	broadphase.query
+	(
+		ray,
+		std::numeric_limits<float>::infinity(),
+		[&](entity::id entity_id, float t) -> float
+		{
+			const component::collision& collision = registry.get<component::collision>(entity_id);
+			
+			// Transform ray into local space of collision component
+			math::transform<float> transform = math::identity_transform<float>;
+			if (const component::transform* component = registry.try_get<component::transform>(entity_id))
+				transform = component->local;
+			
+			const math::transform<float> inverse_transform = math::inverse(transform);
+			const float3 origin = inverse_transform * ray.origin;
+			const float3 direction = math::normalize(math::conjugate(transform.rotation) * ray.direction);
+			const geom::ray<float> transformed_ray = {origin, direction};
+			
+			// Local-space AABB test
+			if (!std::get<0>(geom::ray_aabb_intersection(transformed_ray, collision.bounds)))
+				return (nearest) ? nearest->t : std::numeric_limits<float>::infinity();
+			
+			// Narrow phase mesh test
+			if (!collision.mesh_accelerator)
+				return (nearest) ? nearest->t : std::numeric_limits<float>::infinity();
+			if (auto mesh_result = collision.mesh_accelerator->query_nearest(transformed_ray))
+			{
+				// Convert local hit distance to world distance
+				const float3 local_hit = transformed_ray.extrapolate(mesh_result->t);
+				const float world_t = math::length(transform * local_hit - ray.origin);
+				
+				if (!nearest || world_t < nearest->t)
+					nearest = ray_query_result{entity_id, world_t};
+			}
+			
+			return (nearest) ? nearest->t : std::numeric_limits<float>::infinity();
+		}
+	);
+	
+	return nearest;
+}
+
+void collision::query_nearest(const std::vector<geom::ray<float>>& rays, std::vector<std::optional<ray_query_result>>& results) const
+{
+	results.resize(rays.size());
+	
+	// Sort rays by the Morton code of their origin cell
+	std::vector<std::uint32_t> cells[3];
+	for (int j = 0; j < 3; ++j)
+	{
+		cells[j].resize(rays.size());
+		for (std::size_t i = 0; i < rays.size(); ++i)
+			cells[j][i] = static_cast<std::uint32_t>(static_cast<std::int32_t>(std::floor(rays[i].origin[j] / batch_cell_size))) & 0x3ff;
+	}
+	std::vector<std::uint32_t> codes(rays.size());
+	geom::morton::encode_n(cells[0].data(), cells[1].data(), cells[2].data(), codes.data(), rays.size());
+	std::vector<std::pair<std::uint32_t, std::size_t>> order(rays.size());
+	for (std::size_t i = 0; i < rays.size(); ++i)
+		order[i] = {codes[i], i};
+	std::sort(order.begin(), order.end());
+	
+	auto resolve = [&](std::size_t first, std::size_t last)
+	{
+		for (std::size_t i = first; i < last; ++i)
+		{
+			const std::size_t index = order[i].second;
+			results[index] = query_nearest(rays[index]);
+		}
+	};
+	
+	if (jobs)
+		jobs->parallel_for(0, order.size(), 32, resolve);
+	else
+		resolve(0, order.size());
+}
+
+void collision::query(const geom::aabb<float>& bounds, std::vector<entity::id>& entities) const
+{
+	broadphase.query(bounds, [&](entity::id entity_id){entities.push_back(entity_id);});
+}
+
+void collision::query(const geom::sphere<float>& bounds, std::vector<entity::id>& entities) const
+{
+	broadphase.query(bounds, [&](entity::id entity_id){entities.push_back(entity_id);});
+}
+
+void collision::set_job_system(job_system* jobs)
+{
+	this->jobs = jobs;
+}
+
+geom::aabb<float> collision::get_world_bounds(entity::id entity_id, const component::collision& collision) const
+{
+	if (const component::transform* transform = registry.try_get<component::transform>(entity_id))
+		return geom::aabb<float>::transform(collision.bounds, transform->local);
+	return collision.bounds;
+}
+
+std::shared_ptr<const geom::mesh_accelerator> collision::acquire_accelerator(const geom::mesh& mesh)
+{
+	std::weak_ptr<const geom::mesh_accelerator>& cached = accelerators[&mesh];
+	if (std::shared_ptr<const geom::mesh_accelerator> accelerator = cached.lock())
+		return accelerator;
+	
+	for (const auto& build: builds)
+		if (build->mesh == &mesh && !build->stale)
+			return nullptr;
+	
+	if (mesh.get_faces().size() > async_build_threshold)
+	{
+		start_build(mesh);
+		return nullptr;
+	}
+	
+	auto accelerator = std::make_shared<geom::mesh_accelerator>();
+	accelerator->build(mesh);
+	cached = accelerator;
+	
+	return accelerator;
+}
+
+void collision::rebuild_accelerator(const geom::mesh& mesh)
+{
+	// Discard builds of the mesh as it was
+	for (const auto& build: builds)
+		if (build->mesh == &mesh)
+			build->stale = true;
+	
+	start_build(mesh);
+}
+
+void collision::refit_accelerator(const geom::mesh& mesh, const std::vector<geom::mesh::face*>& moved_faces)
+{
+	auto it = accelerators.find(&mesh);
+	if (it == accelerators.end())
+		return;
+	std::shared_ptr<const geom::mesh_accelerator> current = it->second.lock();
+	if (!current)
+		return;
+	
+	auto accelerator = std::make_shared<geom::mesh_accelerator>(*current);
+	accelerator->refit(moved_faces);
+	install_accelerator(mesh, accelerator);
+	
+	// Restart pending builds, which copied the vertices before they moved
+	for (const auto& build: builds)
+	{
+		if (build->mesh == &mesh && !build->stale)
+		{
+			rebuild_accelerator(mesh);
+			break;
+		}
+	}
+}
+
+void collision::set_build_budget(std::size_t node_count)
+{
+	build_budget = std::max<std::size_t>(node_count, 1);
+}
+
+void collision::set_async_build_threshold(std::size_t triangle_count)
+{
+	async_build_threshold = triangle_count;
+}
+
+void collision::start_build(const geom::mesh& mesh)
+{
+	auto build = std::make_unique<accelerator_build>();
+	build->mesh = &mesh;
+	build->builder = std::make_unique<geom::mesh_accelerator::builder>(mesh);
+	build->accelerator = std::make_shared<geom::mesh_accelerator>();
+	build->jobs = (jobs && jobs->get_thread_count()) ? jobs : nullptr;
+	build->stale = false;
+	
+	if (build->jobs)
+	{
+		accelerator_build* job_build = build.get();
+		build->jobs->submit
+		(
+			[job_build]()
+			{
+				job_build->builder->finish(*job_build->accelerator);
+			},
+			&build->counter
+		);
+	}
+	
+	builds.push_back(std::move(build));
+}
+
+void collision::install_accelerator(const geom::mesh& mesh, const std::shared_ptr<const geom::mesh_accelerator>& accelerator)
+{
+	accelerators[&mesh] = accelerator;
+	
+	registry.view<component::collision>().each
+	(
+		[&](entity::id entity_id, auto& collision)
+		{
+			if (collision.mesh == &mesh)
+				collision.mesh_accelerator = accelerator;
+		}
+	);
+}
 
 void collision::on_collision_construct(entity::registry& registry, entity::id entity_id, component::collision& collision)
-{}
+{
+	if (!collision.mesh_accelerator && collision.mesh)
+		collision.mesh_accelerator = acquire_accelerator(*collision.mesh);
+	
+	proxies[entity_id] = broadphase.insert(get_world_bounds(entity_id, collision), entity_id);
+}
 
 void collision::on_collision_replace(entity::registry& registry, entity::id entity_id, component::collision& collision)
-{}
+{
+	if (!collision.mesh_accelerator && collision.mesh)
+		collision.mesh_accelerator = acquire_accelerator(*collision.mesh);
+	
+	if (auto it = proxies.find(entity_id); it != proxies.end())
+		broadphase.update(it->second, get_world_bounds(entity_id, collision));
+	else
+		proxies[entity_id] = broadphase.insert(get_world_bounds(entity_id, collision), entity_id);
+}
 
 void collision::on_collision_destroy(entity::registry& registry, entity::id entity_id)
-{}
+{
+	if (auto it = proxies.find(entity_id); it != proxies.end())
+	{
+		broadphase.remove(it->second);
+		proxies.erase(it);
+	}
+}
 
 } // namespace system
 } // namespace entity
@@ -17,29 +17,174 @@
  * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+
 #ifndef ANTKEEPER_ENTITY_SYSTEM_COLLISION_HPP
 #define ANTKEEPER_ENTITY_SYSTEM_COLLISION_HPP
 
 #include "entity/systems/updatable.hpp"
 #include "entity/id.hpp"
 #include "entity/components/collision.hpp"
+#include "geom/aabb-tree.hpp"
+#include "geom/ray.hpp"
+#include "geom/sphere.hpp"
+#include "utility/job-system.hpp"
+#include <memory>
+#include <optional>
+#include <unordered_map>
+#include <vector>
 
 namespace entity {
 namespace system {
 
 /**
  * Maintains a spatially partitioned set of collision meshes. The set of collision meshes isnot owned by the collision system, so it can be accessed by other systems as well.
+ *
+ * The world-space bounds of each collision component are kept in a dynamic AABB tree, which is updated incrementally through the collision component signals and as transforms change. Collision meshes are positioned by the local transform of their entity.
+ *
+ * Collision components constructed without a mesh accelerator are given the accelerator of their mesh, which is built once and shared by every collision component with the same mesh, so that repeated props neither rebuild nor duplicate it. Accelerators of large meshes are built asynchronously, on the job system if it has worker threads or time-sliced across updates otherwise, and swapped into the collision components of their mesh by the update in which they complete. Until then, the components keep their previous accelerator, or are skipped by narrow phase queries if they have none.
  */
 class collision: public updatable
 {
 public:
+	/// Result of a ray query.
+	struct ray_query_result
+	{
+		/// Entity whose collision mesh was hit.
+		entity::id entity_id;
+		
+		/// Distance along the ray to the hit.
+		float t;
+	};
+	
 	collision(entity::registry& registry);
+	
+	/// Waits for pending accelerator builds.
+	~collision();
+	
 	virtual void update(double t, double dt);
+	
+	/**
+	 * Finds the nearest intersection between a world-space ray and a collision mesh.
+	 *
+	 * @param ray World-space ray. The direction must be normalized.
+	 * @return Nearest ray hit, or `std::nullopt` if no collision mesh was hit.
+	 */
+	std::optional<ray_query_result> query_nearest(const geom::ray<float>& ray) const;
+	
+	/**
+	 * Finds the nearest intersections of a batch of world-space rays with the collision meshes.
+	 *
+	 * Rays are sorted by the Morton code of the cell containing their origin, so that rays which traverse the same parts of the tree and meshes are resolved together, then resolved in parallel if a job system has been set.
+	 *
+	 * @param rays World-space rays. Directions must be normalized.
+	 * @param[out] results Nearest ray hit of each ray, or `std::nullopt` if a ray hit no collision mesh. Resized to the number of rays.
+	 */
+	void query_nearest(const std::vector<geom::ray<float>>& rays, std::vector<std::optional<ray_query_result>>& results) const;
+	
+	/**
+	 * Finds all entities whose collision bounds may intersect an AABB.
+	 *
+	 * @param bounds World-space AABB.
+	 * @param[out] entities Vector to which the IDs of intersected entities will be appended.
+	 */
+	void query(const geom::aabb<float>& bounds, std::vector<entity::id>& entities) const;
+	
+	/**
+	 * Finds all entities whose collision bounds may intersect a sphere.
+	 *
+	 * @param bounds World-space sphere.
+	 * @param[out] entities Vector to which the IDs of intersected entities will be appended.
+	 */
+	void query(const geom::sphere<float>& bounds, std::vector<entity::id>& entities) const;
+	
+	/**
+	 * Sets the job system on which batched ray queries are resolved in parallel.
+	 *
+	 * @param jobs Job system, or `nullptr` to resolve batches on the calling thread.
+	 */
+	void set_job_system(job_system* jobs);
+	
+	/**
+	 * Rebuilds the accelerator of an edited mesh asynchronously. The collision components of the mesh keep querying the previous accelerator until the new one replaces it. Vertex positions are copied when the build starts, so the mesh may be edited further meanwhile, though later edits require another rebuild or refit.
+	 *
+	 * @param mesh Edited mesh. Its collision bounds are not updated.
+	 */
+	void rebuild_accelerator(const geom::mesh& mesh);
+	
+	/**
+	 * Refits the accelerator of a mesh to vertices moved by a small local edit, which is much faster than a rebuild. A copy of the accelerator is refit and replaces it immediately, so queries in flight keep the previous one. The topology of the mesh must not have changed.
+	 *
+	 * @param mesh Edited mesh. Its collision bounds are not updated.
+	 * @param moved_faces Faces with moved vertices.
+	 */
+	void refit_accelerator(const geom::mesh& mesh, const std::vector<geom::mesh::face*>& moved_faces);
+	
+	/**
+	 * Sets the number of nodes by which a time-sliced accelerator build progresses per update.
+	 *
+	 * @param node_count Nodes processed per update. The default is `256`.
+	 */
+	void set_build_budget(std::size_t node_count);
+	
+	/**
+	 * Sets the number of triangles beyond which the accelerators of new meshes are built asynchronously.
+	 *
+	 * @param triangle_count Triangle count threshold. The default is `4096`.
+	 */
+	void set_async_build_threshold(std::size_t triangle_count);
+	
+	/**
+	 * Draws the leaf cells of the mesh accelerators of all collision components with debug::draw, if the mesh accelerator cells layer is enabled. Should be called once per frame, while the system is not updating.
+	 */
+	void draw_accelerators() const;
+	
+	/// Edge length of the cells by which batched rays are sorted.
+	static constexpr float batch_cell_size = 16.0f;
 
-private:	
+private:
+	/// Returns the world-space bounds of a collision component.
+	geom::aabb<float> get_world_bounds(entity::id entity_id, const component::collision& collision) const;
+	
+	/// Accelerator build in progress.
+	struct accelerator_build
+	{
+		const geom::mesh* mesh;
+		std::unique_ptr<geom::mesh_accelerator::builder> builder;
+		std::shared_ptr<geom::mesh_accelerator> accelerator;
+		
+		/// Job system on which the build runs, or `nullptr` if it is time-sliced.
+		job_system* jobs;
+		job_system::counter counter;
+		
+		/// `true` if the mesh was edited after the build started, in which case the result is discarded.
+		bool stale;
+	};
+	
+	/// Returns the shared accelerator of a mesh, building it if no collision component references it, or `nullptr` if it is being built asynchronously.
+	std::shared_ptr<const geom::mesh_accelerator> acquire_accelerator(const geom::mesh& mesh);
+	
+	/// Starts an asynchronous build of the accelerator of a mesh.
+	void start_build(const geom::mesh& mesh);
+	
+	/// Caches the accelerator of a mesh, and gives it to every collision component of the mesh.
+	void install_accelerator(const geom::mesh& mesh, const std::shared_ptr<const geom::mesh_accelerator>& accelerator);
+	
 	void on_collision_construct(entity::registry& registry, entity::id entity_id, entity::component::collision& collision);
 	void on_collision_replace(entity::registry& registry, entity::id entity_id, entity::component::collision& collision);
 	void on_collision_destroy(entity::registry& registry, entity::id entity_id);
+	
+	job_system* jobs;
+	geom::aabb_tree<entity::id> broadphase;
+	std::unordered_map<entity::id, geom::aabb_tree<entity::id>::proxy_type> proxies;
+	
+	/// Accelerators of the meshes of collision components, keyed by mesh. Accelerators are freed with the last collision component which references them, and rebuilt if their mesh is used again.
+	std::unordered_map<const geom::mesh*, std::weak_ptr<const geom::mesh_accelerator>> accelerators;
+	
+	/// Accelerator builds in progress, in the order in which they started.
+	std::vector<std::unique_ptr<accelerator_build>> builds;
+	
+	std::size_t build_budget;
+	std::size_t async_build_threshold;
 };
 
 } // namespace system
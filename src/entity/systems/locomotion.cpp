@@ -22,20 +22,409 @@
 #include "entity/components/locomotion.hpp"
 #include "entity/components/transform.hpp"
 #include "entity/id.hpp"
+#include "geom/mesh-functions.hpp"
+#include "geom/quadtree.hpp"
+#include "utility/job-system.hpp"
+#include <algorithm>
 
 namespace entity {
 namespace system {
 
 locomotion::locomotion(entity::registry& registry):
-	updatable(registry)
-{}
+	updatable(registry),
+	jobs(nullptr),
+	navmesh(nullptr),
+	path_budget(256),
+	terrain_depth(0),
+	avoidance_radius(2.0f),
+	avoidance_time_horizon(2.0f),
+	neighbor_grid(avoidance_radius)
+{
+	declare_writes<component::transform, component::locomotion>();
+	
+	// Own the locomotion pool in a group with transforms, so that entities are iterated over packed arrays
+	registry.group<component::locomotion>(entt::get<component::transform>);
+}
 
 void locomotion::update(double t, double dt)
 {
-	registry.view<component::transform, component::locomotion>().each(
-		[&](entity::id entity_id, auto& transform, auto& locomotion)
+	// Remove the sections of terrain patches released since the previous update
+	{
+		std::lock_guard<std::mutex> lock(patch_mutex);
+		if (navmesh)
+			for (std::uint32_t section: released_sections)
+				navmesh->remove_section(section);
+		released_sections.clear();
+	}
+	if (navmesh)
+		navmesh->update();
+	
+	// Rebuild flow fields which reach the modified regions of the navigation mesh, in parallel
+	stale_flow_fields.clear();
+	if (navmesh)
+		for (const std::unique_ptr<ai::flow_field>& field: flow_fields)
+			if (field && field->is_stale(*navmesh))
+				stale_flow_fields.push_back(field.get());
+	if (!stale_flow_fields.empty())
+	{
+		auto build = [&](std::size_t first, std::size_t last)
+		{
+			for (std::size_t i = first; i < last; ++i)
+				stale_flow_fields[i]->build(*navmesh);
+		};
+		
+		if (jobs)
+			jobs->parallel_for(0, stale_flow_fields.size(), 1, build);
+		else
+			build(0, stale_flow_fields.size());
+	}
+	
+	auto view = registry.group<component::locomotion>(entt::get<component::transform>);
+	
+	// Queue new path requests
+	for (entity::id entity_id: view)
+	{
+		component::locomotion& locomotion = view.get<component::locomotion>(entity_id);
+		if (locomotion.path_requested)
+		{
+			locomotion.path_requested = false;
+			request_queue.push_back(entity_id);
+		}
+	}
+	
+	// Dequeue the oldest requests within the budget, skipping entities which have since been destroyed
+	requests.clear();
+	while (!request_queue.empty() && (!path_budget || requests.size() < path_budget))
+	{
+		const entity::id entity_id = request_queue.front();
+		request_queue.pop_front();
+		if (registry.valid(entity_id) && view.contains(entity_id))
+			requests.push_back(entity_id);
+	}
+	
+	// Plan paths in parallel, with one search state per subrange
+	if (navmesh && !requests.empty())
+	{
+		const std::size_t range_count = std::min(requests.size(), (jobs) ? jobs->get_thread_count() + 1 : 1);
+		const std::size_t grain = (requests.size() + range_count - 1) / range_count;
+		if (searches.size() < range_count)
+			searches.resize(range_count);
+		
+		auto plan = [&](std::size_t first, std::size_t last)
+		{
+			ai::navmesh::search& search = searches[first / grain];
+			for (std::size_t i = first; i < last; ++i)
+			{
+				const component::transform& transform = view.get<component::transform>(requests[i]);
+				component::locomotion& locomotion = view.get<component::locomotion>(requests[i]);
+				
+				if (!navmesh->find_path(transform.world.translation, locomotion.goal, locomotion.path, search))
+					locomotion.path.clear();
+				locomotion.waypoint = 0;
+			}
+		};
+		
+		if (jobs)
+			jobs->parallel_for(0, requests.size(), grain, plan);
+		else
+			plan(0, requests.size());
+	}
+	
+	// Gather entities before they move
+	agents.clear();
+	agent_positions.clear();
+	agent_velocities.clear();
+	agent_radii.clear();
+	agent_speeds.clear();
+	view.each(
+		[&](entity::id entity_id, auto& locomotion, auto& transform)
+		{
+			agents.push_back(entity_id);
+			agent_positions.push_back(transform.local.translation);
+			agent_velocities.push_back(locomotion.velocity);
+			agent_radii.push_back(locomotion.radius);
+			agent_speeds.push_back(locomotion.speed);
+		});
+	neighbor_grid.build(agent_positions.data(), agent_positions.size(), jobs);
+	
+	// Move entities along their paths
+	const float time_step = static_cast<float>(dt);
+	view.each(
+		[&](entity::id entity_id, auto& locomotion, auto& transform)
+		{
+			if (locomotion.flow_field != ai::navmesh::invalid_index)
+			{
+				follow_flow_field(transform, locomotion, time_step);
+				return;
+			}
+			
+			if (locomotion.waypoint >= locomotion.path.size())
+				return;
+			
+			float3 position = transform.local.translation;
+			float distance = locomotion.speed * time_step;
+			while (distance > 0.0f && locomotion.waypoint < locomotion.path.size())
+			{
+				const float3 difference = locomotion.path[locomotion.waypoint] - position;
+				const float length = math::length(difference);
+				if (length <= distance)
+				{
+					position = locomotion.path[locomotion.waypoint];
+					distance -= length;
+					++locomotion.waypoint;
+				}
+				else
+				{
+					position += difference * (distance / length);
+					distance = 0.0f;
+				}
+			}
+			transform.local.translation = position;
+			
+			// Forget paths once their goals have been reached
+			if (locomotion.waypoint >= locomotion.path.size())
+			{
+				locomotion.path.clear();
+				locomotion.waypoint = 0;
+			}
+		});
+	
+	if (time_step <= 0.0f || agents.empty())
+		return;
+	
+	// Derive preferred velocities from the steps taken
+	preferred_velocities.resize(agents.size());
+	for (std::size_t i = 0; i < agents.size(); ++i)
+		preferred_velocities[i] = (view.get<component::transform>(agents[i]).local.translation - agent_positions[i]) / time_step;
+	
+	// Avoid neighbors in parallel, then retake the steps at the avoiding velocities
+	avoided_velocities.resize(agents.size());
+	auto avoid_range = [&](std::size_t first, std::size_t last)
+	{
+		for (std::size_t i = first; i < last; ++i)
+			avoided_velocities[i] = avoid(i, time_step);
+	};
+	if (jobs)
+		jobs->parallel_for(0, agents.size(), 256, avoid_range);
+	else
+		avoid_range(0, agents.size());
+	
+	for (std::size_t i = 0; i < agents.size(); ++i)
+	{
+		component::transform& transform = view.get<component::transform>(agents[i]);
+		component::locomotion& locomotion = view.get<component::locomotion>(agents[i]);
+		locomotion.velocity = avoided_velocities[i];
+		
+		// Walk entities which are attached to surfaces across their meshes, rather than moving them through space
+		if (locomotion.triangle)
+			transform.local.translation = geom::walk_triangle_mesh(locomotion.triangle, locomotion.barycentric_position, avoided_velocities[i] * time_step);
+		else
+			transform.local.translation = agent_positions[i] + avoided_velocities[i] * time_step;
+	}
+}
+
+float3 locomotion::avoid(std::size_t agent, float time_step) const
+{
+	const float3& preferred_velocity = preferred_velocities[agent];
+	const float radius = agent_radii[agent];
+	if (avoidance_radius <= 0.0f || radius <= 0.0f)
+		return preferred_velocity;
+	
+	const float3& position = agent_positions[agent];
+	float3 velocity = preferred_velocity;
+	neighbor_grid.query(position, avoidance_radius,
+		[&](std::uint32_t neighbor, const float3& neighbor_position)
 		{
+			if (neighbor == agent)
+				return;
+			
+			const float3 relative_position = neighbor_position - position;
+			const float3 relative_velocity = preferred_velocity - agent_velocities[neighbor];
+			const float combined_radius = radius + agent_radii[neighbor];
+			const float distance = math::length(relative_position);
+			
+			// Separate entities which already overlap within a single step
+			if (distance < combined_radius)
+			{
+				if (distance > 0.0f)
+					velocity -= relative_position * ((combined_radius - distance) / (distance * time_step) * 0.5f);
+				return;
+			}
+			
+			// Find the time and separation of the closest approach, assuming the neighbor keeps its velocity
+			const float speed_squared = math::dot(relative_velocity, relative_velocity);
+			if (speed_squared <= 0.0f)
+				return;
+			const float approach_time = math::dot(relative_position, relative_velocity) / speed_squared;
+			if (approach_time <= 0.0f || approach_time > avoidance_time_horizon)
+				return;
+			const float3 separation = relative_position - relative_velocity * approach_time;
+			const float separation_distance = math::length(separation);
+			if (separation_distance >= combined_radius)
+				return;
+			
+			// Take half of the velocity change which would keep clear of the neighbor, sidestepping head-on approaches
+			float3 direction;
+			if (separation_distance > 1e-6f)
+				direction = separation / -separation_distance;
+			else
+			{
+				direction = math::cross(relative_velocity, float3{0.0f, 1.0f, 0.0f});
+				const float direction_length = math::length(direction);
+				if (direction_length <= 0.0f)
+					return;
+				direction = direction / direction_length;
+			}
+			velocity += direction * ((combined_radius - separation_distance) / approach_time * 0.5f);
 		});
+	
+	// Keep to the entity's own speed
+	const float speed = math::length(velocity);
+	const float max_speed = std::max(agent_speeds[agent], math::length(preferred_velocity));
+	if (speed > max_speed && speed > 0.0f)
+		velocity *= max_speed / speed;
+	
+	return velocity;
+}
+
+std::uint32_t locomotion::add_flow_field(const float3& goal)
+{
+	std::uint32_t index;
+	if (!free_flow_fields.empty())
+	{
+		index = free_flow_fields.back();
+		free_flow_fields.pop_back();
+	}
+	else
+	{
+		index = static_cast<std::uint32_t>(flow_fields.size());
+		flow_fields.emplace_back();
+	}
+	
+	flow_fields[index] = std::make_unique<ai::flow_field>(goal);
+	return index;
+}
+
+void locomotion::remove_flow_field(std::uint32_t index)
+{
+	if (index >= flow_fields.size() || !flow_fields[index])
+		return;
+	
+	flow_fields[index].reset();
+	free_flow_fields.push_back(index);
+}
+
+void locomotion::follow_flow_field(component::transform& transform, component::locomotion& locomotion, float time_step)
+{
+	const ai::flow_field* field = get_flow_field(locomotion.flow_field);
+	if (!field || !navmesh)
+	{
+		locomotion.flow_field = ai::navmesh::invalid_index;
+		return;
+	}
+	
+	// Locate entities which have no node, or whose node's cluster was modified and may have been freed or reused
+	if (!navmesh->is_node(locomotion.node) || navmesh->is_cluster_modified(navmesh->get_cluster(locomotion.node)))
+	{
+		locomotion.node = navmesh->find_node(transform.world.translation);
+		if (locomotion.node == ai::navmesh::invalid_index)
+			return;
+	}
+	
+	// Head for the centroid of the next node, or for the goal from the goal node
+	float3 position = transform.local.translation;
+	float distance = locomotion.speed * time_step;
+	while (distance > 0.0f)
+	{
+		const std::uint32_t next_node = field->get_next_node(locomotion.node);
+		if (next_node == ai::navmesh::invalid_index)
+			break;
+		
+		const float3& target = (next_node == locomotion.node) ? field->get_goal() : navmesh->get_centroid(next_node);
+		const float3 difference = target - position;
+		const float length = math::length(difference);
+		if (length <= distance)
+		{
+			position = target;
+			distance -= length;
+			
+			// Stop following the field once its goal has been reached
+			if (next_node == locomotion.node)
+			{
+				locomotion.flow_field = ai::navmesh::invalid_index;
+				break;
+			}
+			locomotion.node = next_node;
+		}
+		else
+		{
+			position += difference * (distance / length);
+			distance = 0.0f;
+		}
+	}
+	transform.local.translation = position;
+}
+
+void locomotion::set_job_system(job_system* jobs)
+{
+	this->jobs = jobs;
+}
+
+void locomotion::set_navmesh(ai::navmesh* navmesh)
+{
+	this->navmesh = navmesh;
+}
+
+void locomotion::set_path_budget(std::size_t budget)
+{
+	path_budget = budget;
+}
+
+void locomotion::set_terrain_depth(std::size_t depth)
+{
+	terrain_depth = depth;
+}
+
+void locomotion::set_avoidance_radius(float radius)
+{
+	avoidance_radius = radius;
+	if (radius > 0.0f)
+		neighbor_grid = geom::hash_grid(radius);
+}
+
+void locomotion::set_avoidance_time_horizon(float horizon)
+{
+	avoidance_time_horizon = horizon;
+}
+
+void locomotion::patch_uploaded(const terrain::patch_geometry& geometry)
+{
+	if (!navmesh || geom::linear_quadtree64::depth(geometry.key.node) != terrain_depth)
+		return;
+	
+	// Move the patch vertices from the patch origin into the world space of the navigation mesh
+	std::vector<float3> positions(geometry.vertex_count);
+	const float3 origin = math::type_cast<float>(geometry.origin);
+	const float* v = geometry.vertex_data;
+	for (std::size_t i = 0; i < geometry.vertex_count; ++i, v += geometry.vertex_size)
+		positions[i] = float3{v[0], v[1], v[2]} + origin;
+	
+	const std::uint32_t section = navmesh->add_triangles(positions.data()->data(), 3, geometry.indices->data(), geometry.indices->size() / 3);
+	
+	std::lock_guard<std::mutex> lock(patch_mutex);
+	patch_sections[{geometry.key.terrain_eid, geometry.key.face_index, geometry.key.node}] = section;
+}
+
+void locomotion::patch_released(const terrain::patch_key& key)
+{
+	std::lock_guard<std::mutex> lock(patch_mutex);
+	auto it = patch_sections.find({key.terrain_eid, key.face_index, key.node});
+	if (it == patch_sections.end())
+		return;
+	
+	// The navigation mesh may be in use while the terrain system updates, so sections are removed by the next update
+	released_sections.push_back(it->second);
+	patch_sections.erase(it);
 }
 
 } // namespace system
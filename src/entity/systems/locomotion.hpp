@@ -21,18 +21,187 @@
 #define ANTKEEPER_ENTITY_SYSTEM_LOCOMOTION_HPP
 
 #include "entity/systems/updatable.hpp"
+#include "entity/systems/terrain.hpp"
+#include "entity/id.hpp"
+#include "ai/navmesh.hpp"
+#include "ai/flow-field.hpp"
+#include "geom/hash-grid.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <vector>
+
+class job_system;
 
 namespace entity {
+namespace component {
+
+struct transform;
+struct locomotion;
+
+} // namespace component
+
 namespace system {
 
+/**
+ * Plans paths over a navigation mesh for entities with locomotion components, and moves them along their paths.
+ *
+ * Path requests are queued, and up to the path budget of the oldest requests are planned per update, in parallel if a job system has been set. Entities heading to shared goals, such as a nest entrance or food source, may instead follow flow fields, which cost one sweep of the navigation mesh per goal rather than one search per entity. Flow fields are rebuilt, in parallel, only when the navigation mesh is modified near the regions they reach.
+ *
+ * Each update, a spatial hash of the positions of the entities is rebuilt. Once entities have taken their steps, those with nonzero radii adjust their velocities to avoid predicted collisions with their neighbors, in the manner of reciprocal velocity obstacles: each entity takes half of the correction needed to keep clear of each neighbor, expecting the neighbor to take the other half. The spatial hash remains valid until the next update, for neighbor queries by other systems.
+ *
+ * Entities whose locomotion components are attached to faces of a surface mesh, such as ants on terrain or tunnel walls, take their final steps by walking across the faces of the mesh, from face to adjacent face, so they stay on the surface without any ray casts. Their paths and avoidance are planned as for other entities.
+ *
+ * The system owns the group of locomotion components with transforms, which keeps locomotion components packed in the order of their entities' transforms. No other group may own locomotion or transform components.
+ *
+ * Terrain patches at the navigation depth are added to the navigation mesh as they are uploaded, and removed as they are released.
+ */
 class locomotion:
-	public updatable
+	public updatable,
+	public terrain::patch_listener
 {
 public:
 	locomotion(entity::registry& registry);
 	virtual void update(double t, double dt);
+	
+	/**
+	 * Sets the job system on which paths are planned in parallel.
+	 *
+	 * @param jobs Job system, or `nullptr` to plan paths on the updating thread.
+	 */
+	void set_job_system(job_system* jobs);
+	
+	/**
+	 * Sets the navigation mesh over which paths are planned. Must be set before any terrain patches are uploaded.
+	 *
+	 * @param navmesh Navigation mesh, or `nullptr` to disable path planning.
+	 */
+	void set_navmesh(ai::navmesh* navmesh);
+	
+	/**
+	 * Sets the maximum number of paths planned per update.
+	 *
+	 * @param budget Maximum number of paths per update, or `0` to plan all queued paths.
+	 */
+	void set_path_budget(std::size_t budget);
+	
+	/**
+	 * Sets the quadtree depth of the terrain patches which are added to the navigation mesh. Patches of other depths overlap them at different levels of detail, and are ignored.
+	 *
+	 * @param depth Quadtree depth of navigable terrain patches.
+	 */
+	void set_terrain_depth(std::size_t depth);
+	
+	/**
+	 * Sets the radius within which entities look for neighbors to avoid, which is also the cell size of the spatial hash.
+	 *
+	 * @param radius Neighbor query radius, or `0` to disable avoidance.
+	 */
+	void set_avoidance_radius(float radius);
+	
+	/**
+	 * Sets how far ahead entities anticipate collisions with their neighbors.
+	 *
+	 * @param horizon Time horizon, in seconds.
+	 */
+	void set_avoidance_time_horizon(float horizon);
+	
+	/// Returns the spatial hash of the positions of the entities with locomotion components at the start of the most recent update.
+	const geom::hash_grid& get_neighbor_grid() const;
+	
+	/// Returns the entity of a point of the neighbor grid.
+	entity::id get_neighbor(std::uint32_t index) const;
+	
+	/// Returns the number of path requests which have yet to be planned.
+	std::size_t get_queued_path_count() const;
+	
+	/**
+	 * Adds a flow field toward a goal, to be built by the next update.
+	 *
+	 * @param goal Position toward which the field flows.
+	 * @return Index of the flow field, by which locomotion components follow it.
+	 */
+	std::uint32_t add_flow_field(const float3& goal);
+	
+	/**
+	 * Removes a flow field. Entities which were following it stop.
+	 *
+	 * @param index Index of the flow field.
+	 */
+	void remove_flow_field(std::uint32_t index);
+	
+	/// Returns a flow field, or `nullptr` if the index doesn't refer to one.
+	const ai::flow_field* get_flow_field(std::uint32_t index) const;
+	
+	virtual void patch_uploaded(const terrain::patch_geometry& geometry);
+	virtual void patch_released(const terrain::patch_key& key);
+	
+private:
+	/// Moves an entity along its flow field by the distance it covers in a time step.
+	void follow_flow_field(component::transform& transform, component::locomotion& locomotion, float time_step);
+	
+	/// Adjusts the preferred velocity of an agent to avoid predicted collisions with its neighbors. Safe to call concurrently for different agents.
+	float3 avoid(std::size_t agent, float time_step) const;
+	
+	typedef std::tuple<entity::id, std::uint8_t, std::uint64_t> patch_map_key;
+	
+	job_system* jobs;
+	ai::navmesh* navmesh;
+	std::size_t path_budget;
+	std::size_t terrain_depth;
+	
+	std::deque<entity::id> request_queue;
+	std::vector<entity::id> requests;
+	std::vector<ai::navmesh::search> searches;
+	
+	/// Flow fields, indexed by flow field index, with `nullptr` in the slots of removed fields.
+	std::vector<std::unique_ptr<ai::flow_field>> flow_fields;
+	std::vector<std::uint32_t> free_flow_fields;
+	std::vector<ai::flow_field*> stale_flow_fields;
+	
+	float avoidance_radius;
+	float avoidance_time_horizon;
+	geom::hash_grid neighbor_grid;
+	
+	/// Entities with locomotion components, with their positions before and velocities preferred by the current update, and their velocities and radii from the previous update.
+	std::vector<entity::id> agents;
+	std::vector<float3> agent_positions;
+	std::vector<float3> preferred_velocities;
+	std::vector<float3> agent_velocities;
+	std::vector<float> agent_radii;
+	std::vector<float> agent_speeds;
+	std::vector<float3> avoided_velocities;
+	
+	/// Navigation mesh sections of terrain patches, and sections of released patches awaiting removal, guarded by the patch mutex as patches are released while the terrain system updates.
+	std::mutex patch_mutex;
+	std::map<patch_map_key, std::uint32_t> patch_sections;
+	std::vector<std::uint32_t> released_sections;
 };
 
+inline std::size_t locomotion::get_queued_path_count() const
+{
+	return request_queue.size();
+}
+
+inline const geom::hash_grid& locomotion::get_neighbor_grid() const
+{
+	return neighbor_grid;
+}
+
+inline entity::id locomotion::get_neighbor(std::uint32_t index) const
+{
+	return agents[index];
+}
+
+inline const ai::flow_field* locomotion::get_flow_field(std::uint32_t index) const
+{
+	return (index < flow_fields.size()) ? flow_fields[index].get() : nullptr;
+}
+
 } // namespace system
 } // namespace entity
 
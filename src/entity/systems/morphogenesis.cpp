@@ -18,17 +18,320 @@
  */
 
 #include "entity/systems/morphogenesis.hpp"
-#include "entity/id.hpp"
+#include "entity/components/model.hpp"
+#include "renderer/model.hpp"
+#include "renderer/material.hpp"
+#include "renderer/material-property.hpp"
+#include "renderer/vertex-attributes.hpp"
+#include "gl/vertex-array.hpp"
+#include "gl/vertex-buffer.hpp"
+#include "gl/drawing-mode.hpp"
+#include "gl/vertex-attribute-type.hpp"
+#include "utility/fnv1a.hpp"
+#include <algorithm>
 
 namespace entity {
 namespace system {
 
 morphogenesis::morphogenesis(entity::registry& registry):
-	updatable(registry)
-{}
+	updatable(registry),
+	base_material(nullptr),
+	jobs(nullptr)
+{
+	declare_reads<entity::component::proteome>();
+	declare_writes<entity::component::model>();
+	
+	registry.on_construct<entity::component::proteome>().connect<&morphogenesis::on_proteome_construct>(this);
+	registry.on_replace<entity::component::proteome>().connect<&morphogenesis::on_proteome_replace>(this);
+	registry.on_destroy<entity::component::proteome>().connect<&morphogenesis::on_proteome_destroy>(this);
+}
+
+morphogenesis::~morphogenesis()
+{
+	if (jobs)
+		jobs->wait(generation_counter);
+	
+	for (auto& element: phenotypes)
+		free_phenotype(element.second);
+}
 
 void morphogenesis::update(double t, double dt)
-{}
+{
+	if (pending_entities.empty() || !generator)
+		return;
+	
+	// Discard repeated changes and destroyed proteomes
+	std::sort(pending_entities.begin(), pending_entities.end());
+	pending_entities.erase(std::unique(pending_entities.begin(), pending_entities.end()), pending_entities.end());
+	
+	for (entity::id entity_id: pending_entities)
+	{
+		if (!registry.valid(entity_id) || !registry.has<entity::component::proteome>(entity_id))
+			continue;
+		
+		const std::vector<std::string>& proteins = *registry.get<entity::component::proteome>(entity_id).proteins;
+		
+		// Skip entities whose phenotype is unchanged
+		auto it = entity_phenotypes.find(entity_id);
+		if (it != entity_phenotypes.end() && it->second->proteins == proteins)
+			continue;
+		
+		release(entity_id);
+		
+		phenotype* phenotype = acquire(proteins);
+		++phenotype->reference_count;
+		entity_phenotypes[entity_id] = phenotype;
+		
+		if (phenotype->model)
+		{
+			entity::component::model component;
+			component.render_model = phenotype->model;
+			component.instance_count = 0;
+			component.layers = 1;
+			registry.assign_or_replace<entity::component::model>(entity_id, component);
+		}
+		else
+		{
+			phenotype->waiting_entities.push_back(entity_id);
+		}
+	}
+	
+	pending_entities.clear();
+}
+
+void morphogenesis::set_generator(const generator_type& generator)
+{
+	this->generator = generator;
+}
+
+void morphogenesis::set_material(::material* material)
+{
+	base_material = material;
+}
+
+void morphogenesis::set_job_system(job_system* jobs)
+{
+	if (this->jobs)
+		this->jobs->wait(generation_counter);
+	
+	this->jobs = jobs;
+}
+
+void morphogenesis::upload_models()
+{
+	// Create the models of generated phenotypes and assign them to the entities awaiting them
+	auto generated_end = std::partition
+	(
+		generating_phenotypes.begin(),
+		generating_phenotypes.end(),
+		[](const phenotype* phenotype)
+		{
+			return !phenotype->generated.load(std::memory_order_acquire);
+		}
+	);
+	
+	for (auto it = generated_end; it != generating_phenotypes.end(); ++it)
+	{
+		phenotype* phenotype = *it;
+		create_model(phenotype);
+		
+		entity::component::model component;
+		component.render_model = phenotype->model;
+		component.instance_count = 0;
+		component.layers = 1;
+		
+		for (entity::id entity_id: phenotype->waiting_entities)
+		{
+			// Skip entities which have since been released or moved to another phenotype
+			auto entity_it = entity_phenotypes.find(entity_id);
+			if (entity_it == entity_phenotypes.end() || entity_it->second != phenotype || !registry.valid(entity_id))
+				continue;
+			
+			registry.assign_or_replace<entity::component::model>(entity_id, component);
+		}
+		phenotype->waiting_entities.clear();
+	}
+	generating_phenotypes.erase(generated_end, generating_phenotypes.end());
+	
+	// Free unreferenced phenotypes, once their generation has completed. Phenotypes released more than once since the previous upload are listed more than once.
+	std::sort(released_phenotypes.begin(), released_phenotypes.end());
+	released_phenotypes.erase(std::unique(released_phenotypes.begin(), released_phenotypes.end()), released_phenotypes.end());
+	auto released_end = std::partition
+	(
+		released_phenotypes.begin(),
+		released_phenotypes.end(),
+		[](const phenotype* phenotype)
+		{
+			return phenotype->reference_count || !phenotype->generated.load(std::memory_order_acquire);
+		}
+	);
+	
+	for (auto it = released_end; it != released_phenotypes.end(); ++it)
+	{
+		phenotype* phenotype = *it;
+		
+		auto range = phenotypes.equal_range(phenotype->hash);
+		for (auto element = range.first; element != range.second; ++element)
+		{
+			if (element->second == phenotype)
+			{
+				phenotypes.erase(element);
+				break;
+			}
+		}
+		
+		free_phenotype(phenotype);
+	}
+	released_phenotypes.erase(released_end, released_phenotypes.end());
+	
+	// Drop phenotypes which have since been referenced again
+	released_phenotypes.erase
+	(
+		std::remove_if
+		(
+			released_phenotypes.begin(),
+			released_phenotypes.end(),
+			[](const phenotype* phenotype)
+			{
+				return phenotype->reference_count != 0;
+			}
+		),
+		released_phenotypes.end()
+	);
+}
+
+std::size_t morphogenesis::get_phenotype_count() const
+{
+	return phenotypes.size();
+}
+
+void morphogenesis::on_proteome_construct(entity::registry& registry, entity::id entity_id, entity::component::proteome& proteome)
+{
+	pending_entities.push_back(entity_id);
+}
+
+void morphogenesis::on_proteome_replace(entity::registry& registry, entity::id entity_id, entity::component::proteome& proteome)
+{
+	pending_entities.push_back(entity_id);
+}
+
+void morphogenesis::on_proteome_destroy(entity::registry& registry, entity::id entity_id)
+{
+	release(entity_id);
+}
+
+std::uint64_t morphogenesis::hash(const std::vector<std::string>& proteins)
+{
+	std::uint64_t hash = fnv1a64_offset_basis;
+	for (const std::string& protein: proteins)
+	{
+		// Hash the length of each protein, so that the boundaries between proteins contribute to the hash
+		const std::uint64_t length = protein.size();
+		hash = fnv1a64(reinterpret_cast<const char*>(&length), sizeof(length), hash);
+		hash = fnv1a64(protein, hash);
+	}
+	return hash;
+}
+
+morphogenesis::phenotype* morphogenesis::acquire(const std::vector<std::string>& proteins)
+{
+	const std::uint64_t key = hash(proteins);
+	
+	// Find cached phenotype, comparing proteins in case of hash collisions
+	auto range = phenotypes.equal_range(key);
+	for (auto it = range.first; it != range.second; ++it)
+		if (it->second->proteins == proteins)
+			return it->second;
+	
+	phenotype* phenotype = new morphogenesis::phenotype();
+	phenotype->hash = key;
+	phenotype->proteins = proteins;
+	phenotype->generated.store(false, std::memory_order_relaxed);
+	phenotype->model = nullptr;
+	phenotype->material = nullptr;
+	phenotype->reference_count = 0;
+	phenotypes.emplace(key, phenotype);
+	generating_phenotypes.push_back(phenotype);
+	
+	// Generate morphology
+	auto generate = [generator = this->generator, phenotype]()
+	{
+		generator(phenotype->proteins, phenotype->generated_morphology);
+		phenotype->generated.store(true, std::memory_order_release);
+	};
+	
+	if (jobs)
+		jobs->submit(generate, &generation_counter);
+	else
+		generate();
+	
+	return phenotype;
+}
+
+void morphogenesis::release(entity::id entity_id)
+{
+	auto it = entity_phenotypes.find(entity_id);
+	if (it == entity_phenotypes.end())
+		return;
+	
+	phenotype* phenotype = it->second;
+	entity_phenotypes.erase(it);
+	
+	// Remove the shared model from the entity, as it may be freed before the entity's next phenotype is uploaded
+	if (phenotype->model && registry.valid(entity_id) && registry.has<entity::component::model>(entity_id) && registry.get<entity::component::model>(entity_id).render_model == phenotype->model)
+		registry.remove<entity::component::model>(entity_id);
+	
+	if (!--phenotype->reference_count)
+		released_phenotypes.push_back(phenotype);
+}
+
+void morphogenesis::create_model(phenotype* phenotype)
+{
+	const morphology& morphology = phenotype->generated_morphology;
+	const std::size_t vertex_stride = sizeof(float) * vertex_size;
+	const std::size_t vertex_count = morphology.vertex_data.size() / vertex_size;
+	
+	// Copy the base material and add the morphology's properties
+	if (base_material)
+	{
+		phenotype->material = new material();
+		*phenotype->material = *base_material;
+		for (const auto& property: morphology.material_properties)
+			phenotype->material->add_property<float4>(property.first)->set_value(property.second);
+		phenotype->material->update_tweens();
+	}
+	
+	phenotype->model = new model();
+	
+	// Resize model VBO and upload vertex data
+	gl::vertex_buffer* vbo = phenotype->model->get_vertex_buffer();
+	vbo->resize(vertex_count * vertex_stride, morphology.vertex_data.data());
+	
+	// Bind vertex attributes to model VAO
+	gl::vertex_array* vao = phenotype->model->get_vertex_array();
+	vao->bind_attribute(VERTEX_POSITION_LOCATION, *vbo, 3, gl::vertex_attribute_type::float_32, vertex_stride, 0);
+	vao->bind_attribute(VERTEX_NORMAL_LOCATION, *vbo, 3, gl::vertex_attribute_type::float_32, vertex_stride, sizeof(float) * 3);
+	
+	// Create model group
+	model_group* group = phenotype->model->add_group("morphology");
+	group->set_material(phenotype->material);
+	group->set_drawing_mode(gl::drawing_mode::triangles);
+	group->set_start_index(0);
+	group->set_index_count(vertex_count);
+	
+	// Set model bounds
+	phenotype->model->set_bounds(morphology.bounds);
+	
+	// Free the morphology, now that it resides on the GPU
+	phenotype->generated_morphology = morphogenesis::morphology();
+}
+
+void morphogenesis::free_phenotype(phenotype* phenotype)
+{
+	delete phenotype->model;
+	delete phenotype->material;
+	delete phenotype;
+}
 
 } // namespace system
 } // namespace entity
@@ -21,6 +21,22 @@
 #define ANTKEEPER_ENTITY_SYSTEM_MORPHOGENESIS_HPP
 
 #include "entity/systems/updatable.hpp"
+#include "entity/components/proteome.hpp"
+#include "entity/id.hpp"
+#include "geom/aabb.hpp"
+#include "utility/fundamental-types.hpp"
+#include "utility/job-system.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+class model;
+class material;
 
 namespace entity {
 namespace system {
@@ -36,22 +52,137 @@ namespace system {
  * 4. For each point, evaluate morphogenic genes to determine type, direction, and color of the next cell.
  * 5. Create new cells given the output of step 4.
  * 6. Go to step 2 and repeat.
+ *
+ * Phenotypes are content-addressed by the hash of their proteomes. Constructed and replaced proteomes are queued, then matched against the phenotype cache by the next update. The morphology of each unique proteome is generated once, on a worker if a job system has been set, then uploaded by upload_models() into a single model shared by every entity with that proteome. As the system may be updated on any thread, it makes no OpenGL calls while updating.
  */
 class morphogenesis:
 	public updatable
 {
 public:
+	/// Morphology generated from a proteome.
+	struct morphology
+	{
+		/// Interleaved vertex positions and normals of a triangle list.
+		std::vector<float> vertex_data;
+		
+		/// Bounds of the vertex positions.
+		geom::aabb<float> bounds;
+		
+		/// Properties added to the phenotype's copy of the base material.
+		std::vector<std::pair<std::string, float4>> material_properties;
+	};
+	
+	/// Function which generates a morphology from the proteins of a proteome. Called concurrently if a job system has been set, so must be thread-safe, and must not throw.
+	typedef std::function<void(const std::vector<std::string>&, morphology&)> generator_type;
+	
+	/// Number of floats per vertex of a morphology.
+	static constexpr std::size_t vertex_size = 6;
+	
 	morphogenesis(entity::registry& registry);
+	~morphogenesis();
 	
 	/**
-	 * Scales then adds the timestep `dt` to the current time, then recalculates the positions of morphogenesising bodies.
+	 * Matches the proteomes constructed or replaced since the previous update against the phenotype cache, and submits the generation of uncached phenotypes.
 	 *
 	 * @param t Time, in seconds.
 	 * @param dt Delta time, in seconds.
 	 */
 	virtual void update(double t, double dt);
 	
+	/**
+	 * Sets the function by which morphologies are generated. Proteomes are ignored until a generator has been set.
+	 *
+	 * @param generator Morphology generator.
+	 */
+	void set_generator(const generator_type& generator);
+	
+	/**
+	 * Sets the material from which the material of each phenotype is copied.
+	 *
+	 * @param material Base material, or `nullptr`.
+	 */
+	void set_material(::material* material);
+	
+	/**
+	 * Sets the job system on which morphologies are generated.
+	 *
+	 * @param jobs Job system, or `nullptr` to generate morphologies on the updating thread.
+	 */
+	void set_job_system(job_system* jobs);
+	
+	/**
+	 * Creates the models of generated phenotypes and assigns them to the entities awaiting them, then frees the models of unreferenced phenotypes. Must be called by the thread which owns the OpenGL context, while the system is not updating.
+	 */
+	void upload_models();
+	
+	/// Returns the number of cached phenotypes.
+	std::size_t get_phenotype_count() const;
+	
 private:
+	/// Morphology and model shared by every entity with the same proteome.
+	struct phenotype
+	{
+		/// Hash of the proteins.
+		std::uint64_t hash;
+		
+		/// Proteins from which the morphology is generated, compared on hash collisions.
+		std::vector<std::string> proteins;
+		
+		/// Generated morphology, freed once uploaded.
+		morphogenesis::morphology generated_morphology;
+		
+		/// `true` once the morphology has been generated.
+		std::atomic<bool> generated;
+		
+		/// Shared model, or `nullptr` until uploaded.
+		::model* model;
+		::material* material;
+		
+		/// Number of entities with this phenotype.
+		std::size_t reference_count;
+		
+		/// Entities to which the model will be assigned once uploaded.
+		std::vector<entity::id> waiting_entities;
+	};
+	
+	void on_proteome_construct(entity::registry& registry, entity::id entity_id, entity::component::proteome& proteome);
+	void on_proteome_replace(entity::registry& registry, entity::id entity_id, entity::component::proteome& proteome);
+	void on_proteome_destroy(entity::registry& registry, entity::id entity_id);
+	
+	/// Hashes the proteins of a proteome.
+	static std::uint64_t hash(const std::vector<std::string>& proteins);
+	
+	/// Returns the cached phenotype of a set of proteins, creating it and submitting its generation if necessary.
+	phenotype* acquire(const std::vector<std::string>& proteins);
+	
+	/// Dissociates an entity from its phenotype, removing the phenotype's model from the entity.
+	void release(entity::id entity_id);
+	
+	/// Creates the shared model of a generated phenotype.
+	void create_model(phenotype* phenotype);
+	
+	/// Frees a phenotype and its model.
+	void free_phenotype(phenotype* phenotype);
+	
+	generator_type generator;
+	::material* base_material;
+	job_system* jobs;
+	job_system::counter generation_counter;
+	
+	/// Cached phenotypes, keyed by the hashes of their proteins.
+	std::unordered_multimap<std::uint64_t, phenotype*> phenotypes;
+	
+	/// Phenotype of each entity.
+	std::unordered_map<entity::id, phenotype*> entity_phenotypes;
+	
+	/// Phenotypes whose models have yet to be uploaded.
+	std::vector<phenotype*> generating_phenotypes;
+	
+	/// Phenotypes which have lost their last reference, freed by upload_models() unless referenced again.
+	std::vector<phenotype*> released_phenotypes;
+	
+	/// Entities whose proteomes were constructed or replaced since the previous update.
+	std::vector<entity::id> pending_entities;
 };
 
 } // namespace system
@@ -26,49 +26,154 @@ namespace system {
 
 nest::nest(entity::registry& registry, ::resource_manager* resource_manager):
 	updatable(registry),
-	resource_manager(resource_manager)
+	resource_manager(resource_manager),
+	jobs(nullptr),
+	subterrain_system(nullptr)
 {
+	declare_writes<>();
+	
 	registry.on_construct<component::nest>().connect<&nest::on_nest_construct>(this);
 	registry.on_destroy<component::nest>().connect<&nest::on_nest_destroy>(this);
 }
 
 nest::~nest()
-{}
+{
+	// Wait for pending generations, which reference their generation state
+	for (auto& pending: generations)
+		if (jobs)
+			jobs->wait(pending.second->counter);
+}
 
 void nest::update(double t, double dt)
-{}
+{
+	for (auto it = generations.begin(); it != generations.end();)
+	{
+		generation& generation = *it->second;
+		if (!generation.counter.is_done())
+		{
+			++it;
+			continue;
+		}
+		
+		// Rethrows any exception thrown while generating
+		if (jobs)
+			jobs->wait(generation.counter);
+		
+		// Dig the nest in a single batch, then publish it
+		if (subterrain_system)
+			subterrain_system->edit(generation.edits);
+		nests[it->first] = std::move(generation.nest);
+		
+		it = generations.erase(it);
+	}
+}
 
-void nest::on_nest_construct(entity::registry& registry, entity::id entity_id, component::nest& component)
+void nest::set_job_system(job_system* jobs)
+{
+	this->jobs = jobs;
+}
+
+void nest::set_subterrain_system(subterrain* subterrain)
+{
+	subterrain_system = subterrain;
+}
+
+const ::nest* nest::get_nest(entity::id entity_id) const
 {
-	/*
-	// Allocate a nest
-	::nest* nest = new ::nest();
+	auto it = nests.find(entity_id);
+	return (it != nests.end()) ? it->second.get() : nullptr;
+}
 
+std::unique_ptr<::nest> nest::create_nest(const component::nest& component)
+{
+	std::unique_ptr<::nest> nest = std::make_unique<::nest>();
+	
 	// Setup initial nest parameters
 	nest->set_tunnel_radius(1.15f);
-	nest::shaft* central_shaft = nest->get_central_shaft();
-	central_shaft->chirality = -1.0f;
+	::nest::shaft* central_shaft = nest->get_central_shaft();
+	central_shaft->chirality = component.helix_chirality;
 	central_shaft->rotation = math::radians(0.0f);
-	central_shaft->depth = {0.0f, 100.0f};
+	central_shaft->depth = {0.0f, component.helix_pitch * component.helix_turns};
 	central_shaft->current_depth = 0.0f;
-	central_shaft->radius = {0.0f, 5.0f};
-	central_shaft->pitch = {4.0f, 8.0f};
-	central_shaft->translation = {{{0.0f, 0.0f}, {20.0f, 11.0f}}};
-	for (std::size_t i = 0; i < 4; ++i)
+	central_shaft->radius = {0.0f, component.helix_radius};
+	central_shaft->pitch = {component.helix_pitch * 0.5f, component.helix_pitch};
+	central_shaft->translation = {{{0.0f, 0.0f}, {0.0f, 0.0f}}};
+	
+	// Add a chamber every three turns of the shaft
+	for (float turns = 3.0f; nest->get_shaft_depth(*central_shaft, turns) < central_shaft->depth[1]; turns += 3.0f)
 	{
-		nest::chamber chamber;
+		::nest::chamber chamber;
 		chamber.shaft = central_shaft;
-		chamber.depth = (i + 1) * 23.0f;
+		chamber.depth = nest->get_shaft_depth(*central_shaft, turns);
 		chamber.rotation = math::radians(0.0f);
+		chamber.sector_angle = math::two_pi<float>;
 		chamber.inner_radius = 4.0f;
 		chamber.outer_radius = 10.0f;
 		central_shaft->chambers.push_back(chamber);
 	}
-	*/
+	
+	return nest;
+}
+
+void nest::generate(generation& generation)
+{
+	const ::nest& nest = *generation.nest;
+	const ::nest::shaft& shaft = *nest.get_central_shaft();
+	const float tunnel_radius = nest.get_tunnel_radius();
+	std::vector<subterrain_edit>& edits = generation.edits;
+	
+	// Carve each chamber as a ring around a central column, before the shaft so that the shaft passes through the columns
+	for (const ::nest::chamber& chamber: shaft.chambers)
+	{
+		const float depth_factor = (chamber.depth - shaft.depth[0]) / (shaft.depth[1] - shaft.depth[0]);
+		const float3 center =
+		{
+			math::lerp<float>(shaft.translation[0][0], shaft.translation[1][0], depth_factor),
+			-chamber.depth,
+			math::lerp<float>(shaft.translation[0][1], shaft.translation[1][1], depth_factor)
+		};
+		edits.push_back({subterrain_edit::shape_type::cylinder, subterrain_edit::operation_type::carve, center, center, chamber.outer_radius, tunnel_radius});
+		edits.push_back({subterrain_edit::shape_type::cylinder, subterrain_edit::operation_type::fill, center, center, chamber.inner_radius, tunnel_radius});
+	}
+	
+	// Carve the shaft as a chain of capsules along its helix
+	std::vector<float3> points;
+	nest.sample_shaft(shaft, tunnel_radius, points);
+	for (std::size_t i = 1; i < points.size(); ++i)
+		edits.push_back({subterrain_edit::shape_type::capsule, subterrain_edit::operation_type::carve, points[i - 1], points[i], tunnel_radius, 0.0f});
+}
+
+void nest::on_nest_construct(entity::registry& registry, entity::id entity_id, component::nest& component)
+{
+	std::unique_ptr<generation> pending = std::make_unique<generation>();
+	pending->nest = create_nest(component);
+	
+	if (jobs)
+	{
+		generation* state = pending.get();
+		jobs->submit([state](){generate(*state);}, &state->counter);
+	}
+	else
+	{
+		generate(*pending);
+	}
+	
+	generations[entity_id] = std::move(pending);
 }
 
 void nest::on_nest_destroy(entity::registry& registry, entity::id entity_id)
-{}
+{
+	auto it = generations.find(entity_id);
+	if (it != generations.end())
+	{
+		// Discard the pending generation once its job has completed
+		if (jobs && !it->second->counter.is_done())
+			jobs->wait(it->second->counter);
+		generations.erase(it);
+	}
+	
+	nests.erase(entity_id);
+}
 
 } // namespace system
 } // namespace entity
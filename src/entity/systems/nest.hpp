@@ -21,7 +21,12 @@
 #define ANTKEEPER_ENTITY_SYSTEM_NEST_HPP
 
 #include "entity/systems/updatable.hpp"
+#include "entity/systems/subterrain.hpp"
 #include "entity/components/nest.hpp"
+#include "utility/job-system.hpp"
+#include <memory>
+#include <unordered_map>
+#include <vector>
 
 class nest;
 class resource_manager;
@@ -29,22 +34,68 @@ class resource_manager;
 namespace entity {
 namespace system {
 
+/**
+ * Generates the nests of entities with nest components.
+ *
+ * When a nest component is constructed, the nest's shaft and chambers are laid out from its helix parameters and converted into subterrain edits on a worker thread, so creating a colony doesn't block the frame. Once generation completes, the next update applies the edits to the subterrain system in a single batch, which marches the chambers and tunnels of the nest into chunk meshes, and publishes the nest.
+ */
 class nest: public updatable
 {
 public:
 	nest(entity::registry& registry, ::resource_manager* resource_manager);
 	~nest();
 	virtual void update(double t, double dt);
+	
+	/**
+	 * Sets the job system on which nests are generated.
+	 *
+	 * @param jobs Job system, or `nullptr` to generate nests on the thread which constructs their components.
+	 */
+	void set_job_system(job_system* jobs);
+	
+	/**
+	 * Sets the subterrain system into which nests are dug.
+	 *
+	 * As nest edits are applied while this system updates, the subterrain system must not be updated concurrently with it.
+	 *
+	 * @param subterrain Subterrain system, or `nullptr` to generate nests without digging them.
+	 */
+	void set_subterrain_system(subterrain* subterrain);
+	
+	/**
+	 * Returns the generated nest of an entity.
+	 *
+	 * @param entity_id ID of an entity with a nest component.
+	 * @return Generated nest, or `nullptr` if the entity's nest has not finished generating.
+	 */
+	const ::nest* get_nest(entity::id entity_id) const;
 
 private:
-	resource_manager* resource_manager;
-
+	/// Nest being generated on a worker thread.
+	struct generation
+	{
+		job_system::counter counter;
+		std::unique_ptr<::nest> nest;
+		std::vector<subterrain_edit> edits;
+	};
+	
+	/// Lays out a nest from the parameters of its component.
+	static std::unique_ptr<::nest> create_nest(const component::nest& component);
+	
+	/// Converts the shaft and chambers of a nest into subterrain edits. Safe to call concurrently for different nests.
+	static void generate(generation& generation);
+	
 	void on_nest_construct(entity::registry& registry, entity::id entity_id, entity::component::nest& component);
 	void on_nest_destroy(entity::registry& registry, entity::id entity_id);
+	
+	resource_manager* resource_manager;
+	job_system* jobs;
+	subterrain* subterrain_system;
+	std::unordered_map<entity::id, std::unique_ptr<generation>> generations;
+	std::unordered_map<entity::id, std::unique_ptr<::nest>> nests;
 };
 
 } // namespace system
 } // namespace entity
 
 #endif // ANTKEEPER_ENTITY_SYSTEM_NEST_HPP
-
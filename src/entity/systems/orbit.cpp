@@ -19,8 +19,12 @@
 
 #include "entity/systems/orbit.hpp"
 #include "entity/components/orbit.hpp"
+#include "entity/components/n-body.hpp"
 #include "entity/id.hpp"
 #include "physics/orbit/orbit.hpp"
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
 
 namespace entity {
 namespace system {
@@ -29,59 +33,94 @@ orbit::orbit(entity::registry& registry):
 	updatable(registry),
 	universal_time(0.0),
 	time_scale(1.0),
-	ke_iterations(10),
-	ke_tolerance(1e-6)
-{}
+	ke_iterations(4),
+	ephemeris_step(1.0),
+	ephemeris_sample_count(257),
+	ephemeris_job_in_flight(false),
+	jobs(nullptr),
+	n_body_dirty(true),
+	n_body_reseed(true),
+	n_body_step(1.0 / 24.0),
+	n_body_max_substeps(256)
+{
+	declare_reads<component::n_body>();
+	declare_writes<component::orbit>();
+	
+	registry.on_construct<entity::component::orbit>().connect<&orbit::on_orbit_construct>(this);
+	registry.on_replace<entity::component::orbit>().connect<&orbit::on_orbit_replace>(this);
+	registry.on_destroy<entity::component::orbit>().connect<&orbit::on_orbit_destroy>(this);
+	registry.on_construct<entity::component::n_body>().connect<&orbit::on_n_body_construct>(this);
+	registry.on_destroy<entity::component::n_body>().connect<&orbit::on_n_body_destroy>(this);
+}
+
+orbit::~orbit()
+{
+	// The ephemeris job references the system
+	wait_for_ephemeris_job();
+}
 
 void orbit::update(double t, double dt)
 {
 	// Add scaled timestep to current time
-	set_universal_time(universal_time + dt * time_scale);
+	const double scaled_dt = dt * time_scale;
+	universal_time += scaled_dt;
+	
+	// Integrate n-bodies, then add and remove n-bodies which have changed since the last update
+	if (!n_body_reseed)
+		n_body_system.integrate(scaled_dt, n_body_step, n_body_max_substeps);
+	if (n_body_dirty || n_body_reseed)
+		update_n_body_system();
+	for (std::size_t i = 0; i < n_body_ids.size(); ++i)
+		registry.get<component::orbit>(n_body_ids[i]).state = n_body_system.get_state(i);
 	
-	// Update the orbital state of orbiting bodies
-	registry.view<component::orbit>().each(
-	[&](entity::id entity_id, auto& orbit)
+	if (!snapshot)
+		update_snapshot();
+	
+	collect_ephemeris();
+	
+	// Switch to the pending ephemeris window once the current time enters it
+	if (!ephemeris.contains(universal_time) && !ephemeris_job_in_flight && pending_snapshot == snapshot && pending_ephemeris.contains(universal_time))
+		std::swap(ephemeris, pending_ephemeris);
+	
+	const std::size_t n = snapshot->entity_ids.size();
+	if (ephemeris.contains(universal_time))
 	{
-		// Calculate semi-minor axis (b)
-		const double b = physics::orbit::derive_semiminor_axis(orbit.elements.a, orbit.elements.e);
-		
-		// Solve Kepler's equation for eccentric anomaly (E)
-		const double ea = physics::orbit::kepler_ea(orbit.elements.e, orbit.elements.ta, ke_iterations, ke_tolerance);
-		
-		// Calculate radial distance and true anomaly (nu)
-		const double xv = orbit.elements.a * (std::cos(ea) - orbit.elements.e);
-		const double yv = b * std::sin(ea);
-		const double distance = std::sqrt(xv * xv + yv * yv);
-		const double ta = std::atan2(yv, xv);
-		
-		// Calculate Cartesian position (r) in perifocal space
-		const math::vector3<double> r_perifocal = math::quaternion<double>::rotate_z(ta) * math::vector3<double>{distance, 0, 0};
-		
-		/// @TODO Calculate Cartesian velocity (v) in perifocal space
-		//const math::vector3<double> v_perifocal = ...
-		
-		// Construct perifocal to inertial reference frame
-		const physics::frame<double> perifocal_to_inertial = physics::orbit::inertial::to_perifocal
-		(
-			{0, 0, 0},
-			orbit.elements.raan,
-			orbit.elements.i,
-			orbit.elements.w
-		).inverse();
-		
-		// Transform orbital state vectors from perifocal space to the parent inertial space
-		const math::vector3<double> r_inertial = perifocal_to_inertial.transform(r_perifocal);
-		//const math::vector3<double> v_inertial = perifocal_frame.transform(v_perifocal);
+		// Interpolate orbital states from the ephemeris
+		for (std::size_t i = 0; i < n; ++i)
+			registry.get<component::orbit>(snapshot->entity_ids[i]).state = ephemeris.interpolate(i, universal_time);
+	}
+	else
+	{
+		// Solve exact orbital states until an ephemeris window containing the current time has been generated
+		exact_states.resize(n);
+		solve(*snapshot, universal_time, 0.0, 1, exact_buffers, exact_states.data());
+		for (std::size_t i = 0; i < n; ++i)
+			registry.get<component::orbit>(snapshot->entity_ids[i]).state = exact_states[i];
+	}
+	
+	if (!ephemeris_job_in_flight)
+	{
+		// Determine the next ephemeris window: the window adjacent to the current window in the direction of time, or the window which contains the current time
+		double next_start;
+		if (ephemeris.contains(universal_time))
+		{
+			const double span = ephemeris.get_end() - ephemeris.get_start();
+			next_start = ephemeris.get_start() + ((time_scale < 0.0) ? -span : span);
+		}
+		else
+		{
+			next_start = get_window_start(universal_time);
+		}
 		
-		// Update orbital state of component
-		orbit.state.r = r_inertial;
-		//orbit.state.v = v_inertial;
-	});
+		if (pending_snapshot != snapshot || !pending_ephemeris.get_sample_count() || pending_ephemeris.get_start() != next_start)
+			request_ephemeris(next_start);
+	}
 }
 
 void orbit::set_universal_time(double time)
 {
 	universal_time = time;
+	n_body_reseed = true;
 }
 
 void orbit::set_time_scale(double scale)
@@ -89,5 +128,231 @@ void orbit::set_time_scale(double scale)
 	time_scale = scale;
 }
 
+void orbit::set_job_system(job_system* jobs)
+{
+	wait_for_ephemeris_job();
+	this->jobs = jobs;
+}
+
+void orbit::set_ephemeris_sampling(double step, std::size_t sample_count)
+{
+	// The ephemeris job reads the sampling of its window
+	wait_for_ephemeris_job();
+	
+	ephemeris_step = step;
+	ephemeris_sample_count = std::max<std::size_t>(sample_count, 2);
+	
+	ephemeris.clear();
+	pending_ephemeris.clear();
+}
+
+void orbit::set_n_body_step(double step, std::size_t max_substeps)
+{
+	n_body_step = step;
+	n_body_max_substeps = std::max<std::size_t>(max_substeps, 1);
+}
+
+void orbit::set_n_body_softening(double length)
+{
+	n_body_system.set_softening(length);
+}
+
+void orbit::solve(const orbit_snapshot& snapshot, double start, double step, std::size_t sample_count, kepler_buffers& buffers, physics::orbit::state<double>* states) const
+{
+	const std::size_t n = snapshot.orbits.size() * sample_count;
+	buffers.eccentricities.resize(n);
+	buffers.mean_anomalies.resize(n);
+	buffers.eccentric_anomalies.resize(n);
+	buffers.sin_eccentric_anomalies.resize(n);
+	buffers.cos_eccentric_anomalies.resize(n);
+	
+	// Advance mean anomalies (M) to the sample times
+	for (std::size_t i = 0; i < snapshot.orbits.size(); ++i)
+	{
+		const component::orbit& orbit = snapshot.orbits[i];
+		for (std::size_t j = 0; j < sample_count; ++j)
+		{
+			const std::size_t k = i * sample_count + j;
+			buffers.eccentricities[k] = orbit.elements.e;
+			buffers.mean_anomalies[k] = orbit.elements.ta + orbit.mean_motion * (start + step * static_cast<double>(j));
+		}
+	}
+	
+	// Solve Kepler's equation for eccentric anomalies (E)
+	physics::orbit::kepler_ea_n
+	(
+		buffers.eccentricities.data(),
+		buffers.mean_anomalies.data(),
+		buffers.eccentric_anomalies.data(),
+		buffers.sin_eccentric_anomalies.data(),
+		buffers.cos_eccentric_anomalies.data(),
+		n,
+		ke_iterations
+	);
+	
+	for (std::size_t i = 0; i < snapshot.orbits.size(); ++i)
+	{
+		const component::orbit& orbit = snapshot.orbits[i];
+		const double a = orbit.elements.a;
+		const double e = orbit.elements.e;
+		
+		// Calculate semi-minor axis (b)
+		const double b = physics::orbit::derive_semiminor_axis(a, e);
+		
+		for (std::size_t j = 0; j < sample_count; ++j)
+		{
+			const std::size_t k = i * sample_count + j;
+			const double sin_ea = buffers.sin_eccentric_anomalies[k];
+			const double cos_ea = buffers.cos_eccentric_anomalies[k];
+			
+			// Calculate Cartesian position (r) in perifocal space
+			const math::vector3<double> r_perifocal = {a * (cos_ea - e), b * sin_ea, 0.0};
+			
+			// Calculate Cartesian velocity (v) in perifocal space, from the rate of change of E
+			const double ea_rate = orbit.mean_motion / (1.0 - e * cos_ea);
+			const math::vector3<double> v_perifocal = {-a * sin_ea * ea_rate, b * cos_ea * ea_rate, 0.0};
+			
+			// Transform orbital state vectors from perifocal space to the parent inertial space
+			states[k].r = orbit.perifocal_to_inertial.transform(r_perifocal);
+			states[k].v = orbit.perifocal_to_inertial.rotation * v_perifocal;
+		}
+	}
+}
+
+void orbit::update_snapshot()
+{
+	std::shared_ptr<orbit_snapshot> new_snapshot = std::make_shared<orbit_snapshot>();
+	registry.view<component::orbit>(entt::exclude<component::n_body>).each(
+	[&](entity::id entity_id, const auto& orbit)
+	{
+		new_snapshot->entity_ids.push_back(entity_id);
+		new_snapshot->orbits.push_back(orbit);
+	});
+	
+	snapshot = new_snapshot;
+	ephemeris.clear();
+}
+
+void orbit::request_ephemeris(double start)
+{
+	pending_snapshot = snapshot;
+	ephemeris_job_in_flight = true;
+	
+	auto job = [this, start, step = ephemeris_step, sample_count = ephemeris_sample_count, job_snapshot = pending_snapshot]()
+	{
+		pending_ephemeris.resize(start, step, job_snapshot->orbits.size(), sample_count);
+		solve(*job_snapshot, start, step, sample_count, ephemeris_buffers, pending_ephemeris.get_states());
+	};
+	
+	if (jobs && jobs->get_thread_count())
+		jobs->submit(job, &ephemeris_counter);
+	else
+		job();
+}
+
+void orbit::collect_ephemeris()
+{
+	if (ephemeris_job_in_flight && ephemeris_counter.is_done())
+		wait_for_ephemeris_job();
+}
+
+void orbit::wait_for_ephemeris_job()
+{
+	if (jobs)
+		jobs->wait(ephemeris_counter);
+	ephemeris_job_in_flight = false;
+}
+
+double orbit::get_window_start(double t) const
+{
+	const double span = ephemeris_step * static_cast<double>(ephemeris_sample_count - 1);
+	return std::floor(t / span) * span;
+}
+
+void orbit::update_n_body_system()
+{
+	// Keep the integrated states of bodies already in the system, unless they're to be reseeded
+	std::unordered_map<entity::id, physics::orbit::state<double>> integrated_states;
+	if (!n_body_reseed)
+		for (std::size_t i = 0; i < n_body_ids.size(); ++i)
+			integrated_states[n_body_ids[i]] = n_body_system.get_state(i);
+	
+	n_body_system.clear();
+	n_body_ids.clear();
+	
+	// Seed the states of new bodies from their orbital elements at the current time
+	orbit_snapshot seeds;
+	registry.view<component::orbit, component::n_body>().each(
+	[&](entity::id entity_id, const auto& orbit, const auto& n_body)
+	{
+		if (integrated_states.find(entity_id) == integrated_states.end())
+		{
+			seeds.entity_ids.push_back(entity_id);
+			seeds.orbits.push_back(orbit);
+		}
+	});
+	exact_states.resize(seeds.orbits.size());
+	solve(seeds, universal_time, 0.0, 1, exact_buffers, exact_states.data());
+	for (std::size_t i = 0; i < seeds.entity_ids.size(); ++i)
+		integrated_states[seeds.entity_ids[i]] = exact_states[i];
+	
+	registry.view<component::orbit, component::n_body>().each(
+	[&](entity::id entity_id, const auto& orbit, const auto& n_body)
+	{
+		// Derive the gravitational parameter of the parent from the orbit's mean motion and semi-major axis, so unperturbed bodies follow their orbits
+		const double a = orbit.elements.a;
+		const double central_gm = orbit.mean_motion * orbit.mean_motion * a * a * a;
+		
+		n_body_system.add(integrated_states[entity_id], central_gm, n_body.gm);
+		n_body_ids.push_back(entity_id);
+	});
+	
+	n_body_dirty = false;
+	n_body_reseed = false;
+}
+
+void orbit::update_perifocal_frame(entity::component::orbit& orbit)
+{
+	// Construct perifocal to inertial reference frame
+	orbit.perifocal_to_inertial = physics::orbit::inertial::to_perifocal
+	(
+		{0, 0, 0},
+		orbit.elements.raan,
+		orbit.elements.i,
+		orbit.elements.w
+	).inverse();
+}
+
+void orbit::on_orbit_construct(entity::registry& registry, entity::id entity_id, entity::component::orbit& orbit)
+{
+	update_perifocal_frame(orbit);
+	snapshot.reset();
+	n_body_dirty = true;
+}
+
+void orbit::on_orbit_replace(entity::registry& registry, entity::id entity_id, entity::component::orbit& orbit)
+{
+	update_perifocal_frame(orbit);
+	snapshot.reset();
+}
+
+void orbit::on_orbit_destroy(entity::registry& registry, entity::id entity_id)
+{
+	snapshot.reset();
+	n_body_dirty = true;
+}
+
+void orbit::on_n_body_construct(entity::registry& registry, entity::id entity_id, entity::component::n_body& n_body)
+{
+	snapshot.reset();
+	n_body_dirty = true;
+}
+
+void orbit::on_n_body_destroy(entity::registry& registry, entity::id entity_id)
+{
+	snapshot.reset();
+	n_body_dirty = true;
+}
+
 } // namespace system
 } // namespace entity
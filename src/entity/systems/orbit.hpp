@@ -21,19 +21,34 @@
 #define ANTKEEPER_ENTITY_SYSTEM_SOLAR_HPP
 
 #include "entity/systems/updatable.hpp"
+#include "entity/components/orbit.hpp"
+#include "entity/components/n-body.hpp"
+#include "entity/id.hpp"
+#include "physics/orbit/ephemeris.hpp"
+#include "physics/orbit/n-body.hpp"
 #include "utility/fundamental-types.hpp"
+#include "utility/job-system.hpp"
+#include <memory>
+#include <vector>
 
 namespace entity {
 namespace system {
 
 /**
  * Updates the Cartesian position and velocity of orbiting bodies given their Keplerian orbital elements and the current time.
+ *
+ * Kepler's equation is solved for all orbits at once, over arrays of their eccentricities and mean anomalies. The perifocal frame of an orbit depends only on its orientation elements, and is cached in its component whenever the component is constructed or replaced.
+ *
+ * Orbital states are interpolated from an ephemeris, which tabulates the states of all orbits over a window of universal time. Once the current time enters a window, the adjacent window in the direction of the time scale is generated in advance, on a worker thread if a job system has been set. Orbits are solved exactly only while no window containing the current time is available, such as after seeking to a new time. Orbital elements are read when the ephemeris is generated, so changes to them take effect only once their components are replaced.
+ *
+ * Orbiting bodies which also have an n-body component, such as the members of an asteroid swarm or the moons of a multi-moon system, are instead integrated together with a symplectic leapfrog integrator, under the gravity of their parent and of one another. Their states are seeded from their orbital elements whenever they join the n-body system or the universal time is set, then integrated in substeps, so high time scales don't destabilize them.
  */
 class orbit:
 	public updatable
 {
 public:
 	orbit(entity::registry& registry);
+	~orbit();
 	
 	/**
 	 * Scales then adds the timestep `dt` to the current time, then recalculates the positions of orbiting bodies.
@@ -57,11 +72,136 @@ public:
 	 */
 	void set_time_scale(double scale);
 	
+	/**
+	 * Sets the job system on which the ephemeris is generated.
+	 *
+	 * @param jobs Job system, or `nullptr` to generate the ephemeris on the updating thread.
+	 */
+	void set_job_system(job_system* jobs);
+	
+	/**
+	 * Sets the sampling of the ephemeris. The sampling interval should be small relative to the shortest orbital period; interpolation error falls with the fourth power of the interval.
+	 *
+	 * @param step Time between ephemeris samples, in days.
+	 * @param sample_count Number of samples per ephemeris window, at least two.
+	 */
+	void set_ephemeris_sampling(double step, std::size_t sample_count);
+	
+	/**
+	 * Sets the substepping of n-body integration.
+	 *
+	 * @param step Maximum duration of an integration substep, in days. Should be small relative to the shortest orbital period of the n-bodies; shorter steps are more accurate.
+	 * @param max_substeps Maximum number of substeps per update, beyond which substeps lengthen, so that high time scales lose accuracy rather than stall the update.
+	 */
+	void set_n_body_step(double step, std::size_t max_substeps);
+	
+	/**
+	 * Sets the softening length of n-body gravity, which limits accelerations during close encounters.
+	 *
+	 * @param length Softening length, in meters.
+	 */
+	void set_n_body_softening(double length);
+	
 private:
+	typedef physics::orbit::ephemeris<double> ephemeris_type;
+	
+	/// Orbits from which an ephemeris is generated, copied from their components.
+	struct orbit_snapshot
+	{
+		std::vector<entity::id> entity_ids;
+		std::vector<entity::component::orbit> orbits;
+	};
+	
+	/// Arrays over which Kepler's equations are solved.
+	struct kepler_buffers
+	{
+		std::vector<double> eccentricities;
+		std::vector<double> mean_anomalies;
+		std::vector<double> eccentric_anomalies;
+		std::vector<double> sin_eccentric_anomalies;
+		std::vector<double> cos_eccentric_anomalies;
+	};
+	
+	/**
+	 * Solves the orbital states of a snapshot of orbits at uniformly-spaced times.
+	 *
+	 * @param snapshot Snapshot of orbits.
+	 * @param start Time of the first sample, in days.
+	 * @param step Time between samples, in days.
+	 * @param sample_count Number of samples per orbit.
+	 * @param buffers Buffers over which Kepler's equations are solved.
+	 * @param[out] states Orbital states of all samples, in rows of samples per orbit.
+	 */
+	void solve(const orbit_snapshot& snapshot, double start, double step, std::size_t sample_count, kepler_buffers& buffers, physics::orbit::state<double>* states) const;
+	
+	/// Copies the orbits of all entities into a new snapshot, and discards ephemerides of the previous snapshot.
+	void update_snapshot();
+	
+	/// Submits a job which generates the pending ephemeris window starting at the time @p start.
+	void request_ephemeris(double start);
+	
+	/// Collects the pending ephemeris window, if it has been generated.
+	void collect_ephemeris();
+	
+	/// Waits for the pending ephemeris job to complete.
+	void wait_for_ephemeris_job();
+	
+	/// Returns the time of the first sample of the ephemeris window which contains the time @p t.
+	double get_window_start(double t) const;
+	
+	/// Rebuilds the n-body system from the n-body components, keeping the integrated states of bodies already in the system and seeding the states of new bodies from their orbital elements.
+	void update_n_body_system();
+	
+	void update_perifocal_frame(entity::component::orbit& orbit);
+	
+	void on_orbit_construct(entity::registry& registry, entity::id entity_id, entity::component::orbit& orbit);
+	void on_orbit_replace(entity::registry& registry, entity::id entity_id, entity::component::orbit& orbit);
+	void on_orbit_destroy(entity::registry& registry, entity::id entity_id);
+	void on_n_body_construct(entity::registry& registry, entity::id entity_id, entity::component::n_body& n_body);
+	void on_n_body_destroy(entity::registry& registry, entity::id entity_id);
+	
 	double universal_time;
 	double time_scale;
+	
+	/// Number of iterations by which Kepler's equation is solved.
 	std::size_t ke_iterations;
-	double ke_tolerance;
+	
+	/// Snapshot of the current orbits, shared with the pending ephemeris job, or `nullptr` if orbits have changed since the snapshot was taken.
+	std::shared_ptr<const orbit_snapshot> snapshot;
+	
+	double ephemeris_step;
+	std::size_t ephemeris_sample_count;
+	
+	/// Ephemeris window from which orbital states are currently interpolated.
+	ephemeris_type ephemeris;
+	
+	/// Ephemeris window generated in advance, and the snapshot from which it was generated.
+	ephemeris_type pending_ephemeris;
+	std::shared_ptr<const orbit_snapshot> pending_snapshot;
+	
+	/// `true` while the pending ephemeris is being generated.
+	bool ephemeris_job_in_flight;
+	
+	job_system* jobs;
+	job_system::counter ephemeris_counter;
+	
+	/// Buffers used to solve exact orbital states on the updating thread, and ephemerides by the ephemeris job.
+	kepler_buffers exact_buffers;
+	kepler_buffers ephemeris_buffers;
+	std::vector<physics::orbit::state<double>> exact_states;
+	
+	/// N-body system, and the entity IDs of its bodies in the order they were added.
+	physics::orbit::n_body<double> n_body_system;
+	std::vector<entity::id> n_body_ids;
+	
+	/// `true` if n-bodies have been added or removed since the n-body system was built.
+	bool n_body_dirty;
+	
+	/// `true` if the states of n-bodies must be seeded from their orbital elements, as the universal time has been set.
+	bool n_body_reseed;
+	
+	double n_body_step;
+	std::size_t n_body_max_substeps;
 };
 
 } // namespace system
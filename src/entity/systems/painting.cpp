@@ -34,6 +34,7 @@
 #include "gl/vertex-attribute-type.hpp"
 #include "renderer/vertex-attributes.hpp"
 #include "geom/mesh-functions.hpp"
+#include <algorithm>
 #include <limits>
 
 namespace entity {
@@ -44,7 +45,8 @@ painting::painting(entity::registry& registry, ::event_dispatcher* event_dispatc
 	event_dispatcher(event_dispatcher),
 	resource_manager(resource_manager),
 	scene_collection(nullptr),
-	is_painting(false)
+	is_painting(false),
+	next_baked_stroke(0)
 {
 	event_dispatcher->subscribe<tool_pressed_event>(this);
 	event_dispatcher->subscribe<tool_released_event>(this);
@@ -67,11 +69,10 @@ painting::painting(entity::registry& registry, ::event_dispatcher* event_dispatc
 	
 	// Setup stroke vbo and vao
 	stroke_vbo = stroke_model->get_vertex_buffer();
-	stroke_vbo->repurpose(sizeof(float) * vertex_size * vertex_count, nullptr, gl::buffer_usage::dynamic_draw);
-	stroke_model->get_vertex_array()->bind_attribute(VERTEX_POSITION_LOCATION, *stroke_vbo, 4, gl::vertex_attribute_type::float_32, vertex_stride, 0);
-	stroke_model->get_vertex_array()->bind_attribute(VERTEX_NORMAL_LOCATION, *stroke_vbo, 3, gl::vertex_attribute_type::float_32, vertex_stride, sizeof(float) * 4);
-	stroke_model->get_vertex_array()->bind_attribute(VERTEX_TEXCOORD_LOCATION, *stroke_vbo, 2, gl::vertex_attribute_type::float_32, vertex_stride, sizeof(float) * 7);
-	stroke_model->get_vertex_array()->bind_attribute(VERTEX_TANGENT_LOCATION, *stroke_vbo, 4, gl::vertex_attribute_type::float_32, vertex_stride, sizeof(float) * 9);
+	stroke_stream = new gl::streaming_buffer(stroke_vbo, sizeof(float) * vertex_size * vertex_count);
+	stroke_vertex_data.resize(vertex_size * vertex_count);
+	stroke_region_segments.assign(stroke_stream->get_region_count(), 0);
+	bind_stroke_attributes(stroke_model, *stroke_vbo);
 	
 	// Create stroke model instance
 	stroke_model_instance = new scene::model_instance();
@@ -92,6 +93,16 @@ painting::~painting()
 {
 	event_dispatcher->unsubscribe<tool_pressed_event>(this);
 	event_dispatcher->unsubscribe<tool_released_event>(this);
+	
+	delete stroke_stream;
+	
+	for (baked_stroke& stroke: baked_strokes)
+	{
+		if (scene_collection)
+			scene_collection->remove_object(stroke.model_instance);
+		delete stroke.model_instance;
+		delete stroke.model;
+	}
 }
 
 void painting::update(double t, double dt)
@@ -110,6 +121,10 @@ void painting::update(double t, double dt)
 			float segment_length_squared = math::dot(segment_difference, segment_difference);
 			if (segment_length_squared >= min_stroke_length_squared)
 			{
+				// Bake the stream once full, allowing the stroke to continue
+				if (current_stroke_segment >= max_stroke_segments)
+					bake_stroke();
+				
 				float segment_length = std::sqrt(segment_length_squared);
 				
 				float3 segment_forward = segment_difference / segment_length;
@@ -141,7 +156,7 @@ void painting::update(double t, double dt)
 				
 				// Adjust c and d
 				bool mitered = false;
-				if (midstroke)
+				if (midstroke && current_stroke_segment > 0)
 				{
 					float angle = std::acos(math::dot(math::normalize(p2 - p1), math::normalize(p1 - p0)));
 					if (angle < max_miter_angle)
@@ -232,18 +247,32 @@ void painting::update(double t, double dt)
 					*(v++) = tangents[i].w;
 				}
 				
-				std::size_t segment_size = sizeof(float) * vertex_size * 6;
+				// Update the CPU copy of the stroke
+				const std::size_t segment_float_count = vertex_size * 6;
+				const int first_dirty_segment = (mitered) ? current_stroke_segment - 1 : current_stroke_segment;
 				if (mitered)
 				{
-					stroke_vbo->update((current_stroke_segment - 1) * segment_size, segment_size * 2, &vertex_data[0]);
+					std::copy(vertex_data, vertex_data + segment_float_count * 2, stroke_vertex_data.begin() + (current_stroke_segment - 1) * segment_float_count);
 				}
 				else
 				{
-					stroke_vbo->update(current_stroke_segment * segment_size, segment_size, &vertex_data[vertex_size * 6]);
+					std::copy(vertex_data + segment_float_count, vertex_data + segment_float_count * 2, stroke_vertex_data.begin() + current_stroke_segment * segment_float_count);
 				}
 				
 				++current_stroke_segment;
 				
+				// Invalidate the rewritten segments in every region
+				for (int& region_segments: stroke_region_segments)
+					region_segments = std::min(region_segments, first_dirty_segment);
+				
+				// Bring the next region up to date, writing only the segments it lacks
+				const std::size_t region = stroke_stream->next_region();
+				const std::size_t segment_size = sizeof(float) * segment_float_count;
+				const int first_segment = stroke_region_segments[region];
+				stroke_stream->write(first_segment * segment_size, (current_stroke_segment - first_segment) * segment_size, &stroke_vertex_data[first_segment * segment_float_count]);
+				stroke_region_segments[region] = current_stroke_segment;
+				
+				stroke_model_group->set_start_index(stroke_stream->get_region_offset() / vertex_stride);
 				stroke_model_group->set_index_count(current_stroke_segment * 6);
 				
 				// Update stroke bounds
@@ -270,6 +299,59 @@ void painting::set_scene(scene::collection* collection)
 {
 	this->scene_collection = collection;
 	scene_collection->add_object(stroke_model_instance);
+	for (const baked_stroke& stroke: baked_strokes)
+		scene_collection->add_object(stroke.model_instance);
+}
+
+void painting::bind_stroke_attributes(model* model, const gl::vertex_buffer& vbo) const
+{
+	gl::vertex_array* vao = model->get_vertex_array();
+	vao->bind_attribute(VERTEX_POSITION_LOCATION, vbo, 4, gl::vertex_attribute_type::float_32, vertex_stride, 0);
+	vao->bind_attribute(VERTEX_NORMAL_LOCATION, vbo, 3, gl::vertex_attribute_type::float_32, vertex_stride, sizeof(float) * 4);
+	vao->bind_attribute(VERTEX_TEXCOORD_LOCATION, vbo, 2, gl::vertex_attribute_type::float_32, vertex_stride, sizeof(float) * 7);
+	vao->bind_attribute(VERTEX_TANGENT_LOCATION, vbo, 4, gl::vertex_attribute_type::float_32, vertex_stride, sizeof(float) * 9);
+}
+
+void painting::bake_stroke()
+{
+	// Allocate a baked stroke model, or overwrite the oldest once the ring is full
+	if (baked_strokes.size() < max_baked_strokes)
+	{
+		baked_stroke stroke;
+		stroke.model = new model();
+		bind_stroke_attributes(stroke.model, *stroke.model->get_vertex_buffer());
+		model_group* group = stroke.model->add_group();
+		group->set_material(stroke_model_group->get_material());
+		group->set_drawing_mode(stroke_model_group->get_drawing_mode());
+		group->set_start_index(0);
+		stroke.model_instance = new scene::model_instance();
+		baked_strokes.push_back(stroke);
+		if (scene_collection)
+			scene_collection->add_object(stroke.model_instance);
+	}
+	baked_stroke& stroke = baked_strokes[next_baked_stroke];
+	next_baked_stroke = (next_baked_stroke + 1) % max_baked_strokes;
+	
+	// Copy the streamed segments into the baked stroke model
+	const std::size_t vertex_count = static_cast<std::size_t>(current_stroke_segment) * 6;
+	stroke.model->get_vertex_buffer()->resize(vertex_count * vertex_stride, stroke_vertex_data.data());
+	(*stroke.model->get_groups())[0]->set_index_count(vertex_count);
+	stroke.model->set_bounds(stroke_model->get_bounds());
+	
+	// Rebind the model to update the bounds of the model instance
+	stroke.model_instance->set_model(stroke.model);
+	stroke.model_instance->update_tweens();
+	
+	// Empty the stream
+	current_stroke_segment = 0;
+	std::fill(stroke_region_segments.begin(), stroke_region_segments.end(), 0);
+	stroke_model_group->set_index_count(0);
+	stroke_bounds_min.x = std::numeric_limits<float>::infinity();
+	stroke_bounds_min.y = std::numeric_limits<float>::infinity();
+	stroke_bounds_min.z = std::numeric_limits<float>::infinity();
+	stroke_bounds_max.x = -std::numeric_limits<float>::infinity();
+	stroke_bounds_max.y = -std::numeric_limits<float>::infinity();
+	stroke_bounds_max.z = -std::numeric_limits<float>::infinity();
 }
 
 void painting::handle_event(const tool_pressed_event& event)
@@ -336,7 +418,11 @@ std::optional<std::tuple<float3, float3>> painting::cast_ray(const float3& posit
 			}
 
 			// Narrow phase mesh test
-			auto mesh_result = collision.mesh_accelerator.query_nearest(transformed_ray);
+			if (!collision.mesh_accelerator)
+			{
+				return;
+			}
+			auto mesh_result = collision.mesh_accelerator->query_nearest(transformed_ray);
 			if (mesh_result)
 			{
 				if (mesh_result->t < min_distance)
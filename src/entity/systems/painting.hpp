@@ -28,6 +28,7 @@
 #include "scene/collection.hpp"
 #include "scene/model-instance.hpp"
 #include "gl/vertex-buffer.hpp"
+#include "gl/streaming-buffer.hpp"
 #include <vector>
 #include <optional>
 
@@ -40,6 +41,11 @@ class model_group;
 namespace entity {
 namespace system {
 
+/**
+ * Paints decal strokes onto collision meshes with brush tools.
+ *
+ * Segments of the current stroke are streamed into a ring of regions of a single VBO. Once the stream is full, its segments are baked into a static stroke model and the stream restarts, so that strokes are unbounded in length. Baked stroke models are themselves kept in a ring, the oldest of which is overwritten once the ring is full.
+ */
 class painting: public updatable,
 	public event_handler<tool_pressed_event>,
 	public event_handler<tool_released_event>
@@ -57,6 +63,12 @@ private:
 	
 	std::optional<std::tuple<float3, float3>> cast_ray(const float3& position) const;
 	
+	/// Binds the stroke vertex attributes of a VBO to a stroke model's VAO.
+	void bind_stroke_attributes(model* model, const gl::vertex_buffer& vbo) const;
+	
+	/// Copies the streamed segments into a static baked stroke model, then empties the stream.
+	void bake_stroke();
+	
 	event_dispatcher* event_dispatcher;
 	resource_manager* resource_manager;
 	scene::collection* scene_collection;
@@ -85,9 +97,30 @@ private:
 	model* stroke_model;
 	model_group* stroke_model_group;
 	gl::vertex_buffer* stroke_vbo;
+	
+	/// Ring of regions in the stroke VBO, each holding a copy of the stroke, so that segments can be rewritten while previous copies are drawn.
+	gl::streaming_buffer* stroke_stream;
+	
+	/// Vertex data of the current stroke, from which stale regions are brought up to date.
+	std::vector<float> stroke_vertex_data;
+	
+	/// Number of segments up to which each stroke region is up to date.
+	std::vector<int> stroke_region_segments;
 	bool midstroke;
 	
 	scene::model_instance* stroke_model_instance;
+	
+	/// Static model into which full stroke streams are baked.
+	struct baked_stroke
+	{
+		model* model;
+		scene::model_instance* model_instance;
+	};
+	
+	/// Maximum number of baked stroke models, beyond which the oldest is overwritten.
+	static constexpr std::size_t max_baked_strokes = 16;
+	std::vector<baked_stroke> baked_strokes;
+	std::size_t next_baked_stroke;
 };
 
 } // namespace system
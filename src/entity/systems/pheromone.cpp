@@ -0,0 +1,73 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "entity/systems/pheromone.hpp"
+#include "entity/components/marker.hpp"
+#include "entity/components/transform.hpp"
+#include "entity/id.hpp"
+#include "pheromone-field.hpp"
+
+namespace entity {
+namespace system {
+
+pheromone::pheromone(entity::registry& registry):
+	updatable(registry),
+	field(nullptr),
+	deposit_rate(1.0f)
+{
+	declare_reads<component::marker, component::transform>();
+}
+
+void pheromone::update(double t, double dt)
+{
+	if (!field)
+		return;
+	
+	// Gather the positions of markers by channel, then deposit each channel in a single batch
+	marker_positions.resize(field->get_channel_count());
+	for (std::vector<float3>& positions: marker_positions)
+		positions.clear();
+	
+	registry.view<component::marker, component::transform>().each(
+		[&](entity::id entity_id, const auto& marker, const auto& transform)
+		{
+			if (marker.color >= 0 && static_cast<std::size_t>(marker.color) < marker_positions.size())
+				marker_positions[marker.color].push_back(transform.world.translation);
+		});
+	
+	const float amount = deposit_rate * static_cast<float>(dt);
+	for (std::size_t channel = 0; channel < marker_positions.size(); ++channel)
+		if (!marker_positions[channel].empty())
+			field->deposit(channel, marker_positions[channel].data(), marker_positions[channel].size(), amount);
+	
+	field->update(static_cast<float>(dt));
+}
+
+void pheromone::set_field(pheromone_field* field)
+{
+	this->field = field;
+}
+
+void pheromone::set_deposit_rate(float rate)
+{
+	deposit_rate = rate;
+}
+
+} // namespace system
+} // namespace entity
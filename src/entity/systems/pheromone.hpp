@@ -0,0 +1,68 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ANTKEEPER_ENTITY_SYSTEM_PHEROMONE_HPP
+#define ANTKEEPER_ENTITY_SYSTEM_PHEROMONE_HPP
+
+#include "entity/systems/updatable.hpp"
+#include "utility/fundamental-types.hpp"
+#include <vector>
+
+class pheromone_field;
+
+namespace entity {
+namespace system {
+
+/**
+ * Deposits pheromones at the positions of marker entities, into the channel given by each marker's color, then diffuses and evaporates the pheromone field.
+ *
+ * Behavior trees may sample the field and deposit into it while it is not updating.
+ */
+class pheromone: public updatable
+{
+public:
+	pheromone(entity::registry& registry);
+	virtual void update(double t, double dt);
+	
+	/**
+	 * Sets the pheromone field which is updated by the system.
+	 *
+	 * @param field Pheromone field, or `nullptr` to disable pheromones.
+	 */
+	void set_field(pheromone_field* field);
+	
+	/**
+	 * Sets the concentration deposited by each marker.
+	 *
+	 * @param rate Concentration deposited per second.
+	 */
+	void set_deposit_rate(float rate);
+
+private:
+	pheromone_field* field;
+	float deposit_rate;
+	
+	/// Positions of the markers of each channel, reused across updates.
+	std::vector<std::vector<float3>> marker_positions;
+};
+
+} // namespace system
+} // namespace entity
+
+#endif // ANTKEEPER_ENTITY_SYSTEM_PHEROMONE_HPP
@@ -19,55 +19,173 @@
 
 #include "entity/systems/proteome.hpp"
 #include "entity/components/proteome.hpp"
+#include "genetics/chromosome.hpp"
 #include "genetics/sequence.hpp"
+#include "genetics/packed-sequence.hpp"
 #include "genetics/standard-code.hpp"
+#include "utility/job-system.hpp"
+#include <algorithm>
+#include <iterator>
 
 namespace entity {
 namespace system {
 
 proteome::proteome(entity::registry& registry):
-	updatable(registry)
+	updatable(registry),
+	jobs(nullptr),
+	cache_capacity(0)
 {
+	declare_reads<entity::component::genome>();
+	declare_writes<entity::component::proteome>();
+	
 	registry.on_construct<entity::component::genome>().connect<&proteome::on_genome_construct>(this);
 	registry.on_replace<entity::component::genome>().connect<&proteome::on_genome_replace>(this);
 }
 
 void proteome::update(double t, double dt)
-{}
+{
+	if (pending_entities.empty())
+		return;
+	
+	// Discard repeated changes and destroyed genomes
+	std::sort(pending_entities.begin(), pending_entities.end());
+	pending_entities.erase(std::unique(pending_entities.begin(), pending_entities.end()), pending_entities.end());
+	pending_entities.erase
+	(
+		std::remove_if
+		(
+			pending_entities.begin(),
+			pending_entities.end(),
+			[this](entity::id entity_id)
+			{
+				return !registry.valid(entity_id) || !registry.has<entity::component::genome>(entity_id);
+			}
+		),
+		pending_entities.end()
+	);
+	
+	// Collect the distinct chromosomes of the batch which are not cached
+	chromosomes.clear();
+	chromosome_indices.clear();
+	for (entity::id entity_id: pending_entities)
+	{
+		for (const genetics::chromosome& chromosome: registry.get<entity::component::genome>(entity_id).chromosomes)
+		{
+			if (cache_capacity && cache.count(chromosome))
+				continue;
+			
+			if (chromosome_indices.emplace(&chromosome, chromosomes.size()).second)
+				chromosomes.push_back(&chromosome);
+		}
+	}
+	
+	// Translate the collected chromosomes
+	chromosome_proteins.clear();
+	chromosome_proteins.resize(chromosomes.size());
+	auto translate_chromosomes = [this](std::size_t first, std::size_t last)
+	{
+		for (std::size_t i = first; i < last; ++i)
+			translate(chromosomes[i]->get(), chromosome_proteins[i]);
+	};
+	if (jobs)
+		jobs->parallel_for(0, chromosomes.size(), 1, translate_chromosomes);
+	else
+		translate_chromosomes(0, chromosomes.size());
+	
+	// Assemble the proteome of each genome from the proteins of its chromosomes
+	for (entity::id entity_id: pending_entities)
+	{
+		const entity::component::genome& genome = registry.get<entity::component::genome>(entity_id);
+		
+		// Find the proteins of each chromosome, in the batch or in the cache
+		chromosome_protein_lists.clear();
+		std::size_t protein_count = 0;
+		for (const genetics::chromosome& chromosome: genome.chromosomes)
+		{
+			const std::vector<std::string>* proteins;
+			if (auto it = chromosome_indices.find(&chromosome); it != chromosome_indices.end())
+				proteins = &chromosome_proteins[it->second];
+			else
+				proteins = &cache.find(chromosome)->second;
+			
+			chromosome_protein_lists.push_back(proteins);
+			protein_count += proteins->size();
+		}
+		
+		// Share the proteins of genomes with the same chromosome proteins
+		std::shared_ptr<const std::vector<std::string>>& assembled_proteins = assembled_proteomes[chromosome_protein_lists];
+		if (!assembled_proteins)
+		{
+			auto proteins = std::make_shared<std::vector<std::string>>();
+			proteins->reserve(protein_count);
+			for (const std::vector<std::string>* list: chromosome_protein_lists)
+				proteins->insert(proteins->end(), list->begin(), list->end());
+			assembled_proteins = std::move(proteins);
+		}
+		
+		entity::component::proteome proteome_component;
+		proteome_component.proteins = assembled_proteins;
+		
+		registry.assign_or_replace<entity::component::proteome>(entity_id, std::move(proteome_component));
+	}
+	
+	// Release the keys of the assembled proteomes before the proteins they point to are moved into the cache
+	assembled_proteomes.clear();
+	
+	// Cache the translated chromosomes
+	if (cache_capacity)
+	{
+		if (cache.size() + chromosomes.size() > cache_capacity)
+			cache.clear();
+		
+		for (std::size_t i = 0; i < chromosomes.size() && cache.size() < cache_capacity; ++i)
+			cache.emplace(*chromosomes[i], std::move(chromosome_proteins[i]));
+	}
+	
+	pending_entities.clear();
+}
+
+void proteome::set_job_system(job_system* jobs)
+{
+	this->jobs = jobs;
+}
+
+void proteome::set_cache_capacity(std::size_t capacity)
+{
+	cache_capacity = capacity;
+	if (!capacity)
+		cache.clear();
+}
 
 void proteome::on_genome_construct(entity::registry& registry, entity::id entity_id, entity::component::genome& genome)
 {
-	on_genome_replace(registry, entity_id, genome);
+	pending_entities.push_back(entity_id);
 }
 
 void proteome::on_genome_replace(entity::registry& registry, entity::id entity_id, entity::component::genome& genome)
 {
-	// Allocate a proteome component
-	entity::component::proteome proteome_component;
+	pending_entities.push_back(entity_id);
+}
+
+void proteome::translate(const genetics::packed_sequence& chromosome, std::vector<std::string>& proteins)
+{
+	// Find the first ORF in the chromosome
+	auto orf = genetics::sequence::find_orf(chromosome.begin(), chromosome.end(), genetics::standard_code);
 	
-	// For each chromosome in the genome
-	for (const std::string& chromosome: genome.chromosomes)
+	// While the ORF is valid
+	while (orf.start != chromosome.end())
 	{
-		// Find the first ORF in the chromosome
-		auto orf = genetics::sequence::find_orf(chromosome.begin(), chromosome.end(), genetics::standard_code);
+		// Translate the base sequence into an amino acid sequence (protein)
+		std::string protein;
+		protein.reserve((orf.stop - orf.start) / 3);
+		genetics::sequence::translate(orf.start, orf.stop, std::back_inserter(protein), genetics::standard_code);
 		
-		// While the ORF is valid
-		while (orf.start != chromosome.end())
-		{
-			// Translate the base sequence into an amino acid sequence (protein)
-			std::string protein;
-			genetics::sequence::translate(orf.start, orf.stop, std::back_inserter(protein), genetics::standard_code);
-			
-			// Append protein to the proteome
-			proteome_component.proteins.push_back(protein);
-			
-			// Find the next ORF
-			orf = genetics::sequence::find_orf(orf.stop, chromosome.end(), genetics::standard_code);
-		}
+		// Append protein to the chromosome's proteins
+		proteins.push_back(std::move(protein));
+		
+		// Find the next ORF
+		orf = genetics::sequence::find_orf(orf.stop, chromosome.end(), genetics::standard_code);
 	}
-	
-	// Assign or replace the entity's proteome component
-	registry.assign_or_replace<entity::component::proteome>(entity_id, proteome_component);
 }
 
 } // namespace system
@@ -23,12 +23,24 @@
 #include "entity/systems/updatable.hpp"
 #include "entity/components/genome.hpp"
 #include "entity/id.hpp"
+#include "genetics/chromosome.hpp"
+#include "genetics/packed-sequence.hpp"
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class job_system;
 
 namespace entity {
 namespace system {
 
 /**
  * Generates proteomes for every genome.
+ *
+ * Constructed and replaced genomes are queued, then their proteomes are generated by the next update in a single batch. Each distinct chromosome of the batch is translated once, in parallel if a job system has been set. Interned chromosomes are found by their cached hashes and compared by reference, so that chromosomes shared by siblings are not read again. Translated chromosomes may be cached across updates, so that siblings which share alleles are not translated again. Genomes of the batch whose chromosomes translate to the same proteins share a single proteome.
  */
 class proteome:
 	public updatable
@@ -37,16 +49,71 @@ public:
 	proteome(entity::registry& registry);
 	
 	/**
-	 * Scales then adds the timestep `dt` to the current time, then recalculates the positions of proteomeing bodies.
+	 * Generates the proteomes of the genomes constructed or replaced since the previous update.
 	 *
 	 * @param t Time, in seconds.
 	 * @param dt Delta time, in seconds.
 	 */
 	virtual void update(double t, double dt);
 	
+	/**
+	 * Sets the job system on which chromosomes are translated in parallel.
+	 *
+	 * @param jobs Job system, or `nullptr` to translate chromosomes on the updating thread.
+	 */
+	void set_job_system(job_system* jobs);
+	
+	/**
+	 * Sets the maximum number of translated chromosomes kept in the cache. Once exceeded, the cache is cleared.
+	 *
+	 * @param capacity Cache capacity, or `0` to disable the cache.
+	 */
+	void set_cache_capacity(std::size_t capacity);
+	
 private:
 	void on_genome_construct(entity::registry& registry, entity::id entity_id, entity::component::genome& genome);
 	void on_genome_replace(entity::registry& registry, entity::id entity_id, entity::component::genome& genome);
+	
+	/// Hashes chromosomes by value.
+	struct chromosome_hash
+	{
+		std::size_t operator()(const genetics::chromosome* chromosome) const
+		{
+			return chromosome->hash();
+		}
+	};
+	
+	/// Compares chromosomes by value.
+	struct chromosome_equal
+	{
+		bool operator()(const genetics::chromosome* a, const genetics::chromosome* b) const
+		{
+			return *a == *b;
+		}
+	};
+	
+	/// Translates every ORF of a chromosome into a protein.
+	static void translate(const genetics::packed_sequence& chromosome, std::vector<std::string>& proteins);
+	
+	job_system* jobs;
+	std::size_t cache_capacity;
+	
+	/// Proteins of translated chromosomes.
+	std::unordered_map<genetics::chromosome, std::vector<std::string>> cache;
+	
+	/// Entities whose genomes were constructed or replaced since the previous update.
+	std::vector<entity::id> pending_entities;
+	
+	/// Distinct chromosomes of the batch which were not found in the cache, and their proteins.
+	std::vector<const genetics::chromosome*> chromosomes;
+	std::vector<std::vector<std::string>> chromosome_proteins;
+	std::unordered_map<const genetics::chromosome*, std::size_t, chromosome_hash, chromosome_equal> chromosome_indices;
+	
+	/// Proteins of each chromosome of the genome being assembled.
+	std::vector<const std::vector<std::string>*> chromosome_protein_lists;
+	
+	/// Proteins of the proteomes assembled during the batch, keyed by the proteins of their chromosomes.
+	std::map<std::vector<const std::vector<std::string>*>, std::shared_ptr<const std::vector<std::string>>> assembled_proteomes;
 };
 
 } // namespace system
@@ -24,6 +24,7 @@
 #include "scene/directional-light.hpp"
 #include "scene/ambient-light.hpp"
 #include "scene/spot-light.hpp"
+#include <cstring>
 #include <iostream>
 
 namespace entity {
@@ -45,44 +46,19 @@ render::render(entity::registry& registry):
 void render::update(double t, double dt)
 {
 	// Update model instance transforms
-	registry.view<component::transform, component::model>().each
-	(
-		[this](entity::id entity_id, auto& transform, auto& model)
-		{
-			scene::model_instance* instance = model_instances[entity_id];
-
-			instance->set_transform(transform.world);
-			if (transform.warp)
-			{
-				instance->get_transform_tween().update();
-				instance->update_tweens();
-				transform.warp = false;
-			}
-		}
-	);
+	sync_transforms(model_instances);
 	
 	// Update light transforms
-	registry.view<component::transform, component::light>().each
-	(
-		[this](entity::id entity_id, auto& transform, auto& light)
-		{
-			scene::light* light_object = lights[entity_id];
-
-			light_object->set_transform(transform.world);
-			if (transform.warp)
-			{
-				light_object->get_transform_tween().update();
-				light_object->update_tweens();
-				transform.warp = false;
-			}
-		}
-	);
+	sync_transforms(lights);
 }
 
 void render::draw(double alpha)
 {
 	if (renderer)
 	{
+		// Interpolate the transforms of all scene objects once for every layer
+		scene::object_base::get_transform_store().interpolate(static_cast<float>(alpha));
+		
 		for (const scene::collection* collection: layers)
 		{
 			renderer->render(alpha, *collection);
@@ -107,38 +83,85 @@ void render::set_renderer(::renderer* renderer)
 
 scene::model_instance* render::get_model_instance(entity::id entity_id)
 {
-	if (auto it = model_instances.find(entity_id); it != model_instances.end())
-		return it->second;
+	if (auto it = model_instance_indices.find(entity_id); it != model_instance_indices.end())
+		return static_cast<scene::model_instance*>(model_instances[it->second].object);
 	return nullptr;
 }
 
 scene::light* render::get_light(entity::id entity_id)
 {
-	if (auto it = lights.find(entity_id); it != lights.end())
-		return it->second;
+	if (auto it = light_indices.find(entity_id); it != light_indices.end())
+		return static_cast<scene::light*>(lights[it->second].object);
 	return nullptr;
 }
 
+void render::sync_transforms(std::vector<synced_object>& objects)
+{
+	for (synced_object& synced_object: objects)
+	{
+		component::transform* transform = registry.try_get<component::transform>(synced_object.entity_id);
+		if (!transform)
+			continue;
+		
+		// Skip objects whose world transform is unchanged since the last sync
+		if (synced_object.synced && !transform->warp && !std::memcmp(&synced_object.world, &transform->world, sizeof(transform->world)))
+			continue;
+		
+		synced_object.object->set_transform(transform->world);
+		synced_object.world = transform->world;
+		synced_object.synced = true;
+		
+		if (transform->warp)
+		{
+			synced_object.object->update_tweens();
+			transform->warp = false;
+		}
+	}
+}
+
+scene::object_base* render::remove_synced_object(std::vector<synced_object>& objects, std::unordered_map<entity::id, std::size_t>& indices, entity::id entity_id)
+{
+	auto it = indices.find(entity_id);
+	if (it == indices.end())
+		return nullptr;
+	
+	const std::size_t index = it->second;
+	scene::object_base* object = objects[index].object;
+	indices.erase(it);
+	
+	// Move the last object into the vacated slot
+	if (index != objects.size() - 1)
+	{
+		objects[index] = objects.back();
+		indices[objects[index].entity_id] = index;
+	}
+	objects.pop_back();
+	
+	return object;
+}
+
 void render::update_model_and_materials(entity::id entity_id, component::model& model)
 {
-	if (auto model_it = model_instances.find(entity_id); model_it != model_instances.end())
+	if (scene::model_instance* model_instance = get_model_instance(entity_id))
 	{
-		model_it->second->set_model(model.render_model);
-		model_it->second->set_instanced((model.instance_count > 0), model.instance_count);
+		model_instance->set_model(model.render_model);
+		model_instance->set_instanced((model.instance_count > 0), model.instance_count);
 		
 		for (auto material_it = model.materials.begin(); material_it != model.materials.end(); ++material_it)
 		{
-			model_it->second->set_material(material_it->first, material_it->second);
+			model_instance->set_material(material_it->first, material_it->second);
 		}
 		
-		// Add model instance to its specified layers
+		// Add model instance to its specified layers and remove it from all others
 		for (std::size_t i = 0; i < std::min<std::size_t>(layers.size(), (sizeof(model.layers) << 3)); ++i)
 		{
-			layers[i]->remove_object(model_it->second);
-			
-			if ((model.layers >> i) & 1)
+			const bool included = (model.layers >> i) & 1;
+			if (included != layers[i]->contains(model_instance))
 			{
-				layers[i]->add_object(model_it->second);
+				if (included)
+					layers[i]->add_object(model_instance);
+				else
+					layers[i]->remove_object(model_instance);
 			}
 		}
 	}
@@ -146,10 +169,8 @@ void render::update_model_and_materials(entity::id entity_id, component::model&
 
 void render::update_light(entity::id entity_id, entity::component::light& component)
 {
-	if (auto light_it = lights.find(entity_id); light_it != lights.end())
+	if (scene::light* light = get_light(entity_id))
 	{
-		scene::light* light = light_it->second;
-		
 		light->set_color(component.color);
 		light->set_intensity(component.intensity);
 		
@@ -179,7 +200,12 @@ void render::update_light(entity::id entity_id, entity::component::light& compon
 void render::on_model_construct(entity::registry& registry, entity::id entity_id, component::model& model)
 {
 	scene::model_instance* model_instance = new scene::model_instance();	
-	model_instances[entity_id] = model_instance;
+	
+	// Pick IDs are offset by one, as zero is reserved for unpickable geometry
+	model_instance->set_pick_id(static_cast<std::uint32_t>(entity_id) + 1);
+	
+	model_instance_indices[entity_id] = model_instances.size();
+	model_instances.push_back({entity_id, model_instance, {}, false});
 	update_model_and_materials(entity_id, model);
 }
 
@@ -190,15 +216,12 @@ void render::on_model_replace(entity::registry& registry, entity::id entity_id,
 
 void render::on_model_destroy(entity::registry& registry, entity::id entity_id)
 {
-	if (auto it = model_instances.find(entity_id); it != model_instances.end())
+	if (scene::object_base* model_instance = remove_synced_object(model_instances, model_instance_indices, entity_id))
 	{
-		scene::model_instance* model_instance = it->second;
-		
 		// Remove model instance from all layers
 		for (scene::collection* layer: layers)
 			layer->remove_object(model_instance);
 
-		model_instances.erase(it);
 		delete model_instance;
 	}
 }
@@ -231,7 +254,8 @@ void render::on_light_construct(entity::registry& registry, entity::id entity_id
 	
 	if (light)
 	{
-		lights[entity_id] = light;
+		light_indices[entity_id] = lights.size();
+		lights.push_back({entity_id, light, {}, false});
 		for (scene::collection* layer: layers)
 			layer->add_object(light);
 		
@@ -246,14 +270,11 @@ void render::on_light_replace(entity::registry& registry, entity::id entity_id,
 
 void render::on_light_destroy(entity::registry& registry, entity::id entity_id)
 {
-	if (auto it = lights.find(entity_id); it != lights.end())
+	if (scene::object_base* light = remove_synced_object(lights, light_indices, entity_id))
 	{
-		scene::light* light = it->second;
-		
 		for (scene::collection* layer: layers)
 			layer->remove_object(light);
 		
-		lights.erase(it);
 		delete light;
 	}
 }
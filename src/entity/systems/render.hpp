@@ -27,6 +27,7 @@
 #include "entity/components/model.hpp"
 #include "entity/components/light.hpp"
 #include "entity/id.hpp"
+#include <cstddef>
 #include <unordered_map>
 #include <vector>
 
@@ -52,7 +53,30 @@ public:
 	scene::model_instance* get_model_instance(entity::id entity_id);
 	scene::light* get_light(entity::id entity_id);
 
-private:	
+private:
+	/// Scene object which follows the world transform of an entity.
+	struct synced_object
+	{
+		entity::id entity_id;
+		scene::object_base* object;
+		
+		/// World transform at the time of the last sync.
+		math::transform<float> world;
+		
+		/// `false` if the object has not yet been synced.
+		bool synced;
+	};
+	
+	/**
+	 * Syncs the transforms of scene objects whose entity's world transform has changed since the last sync.
+	 *
+	 * @param objects Dense array of synced objects.
+	 */
+	void sync_transforms(std::vector<synced_object>& objects);
+	
+	/// Removes a synced object from a dense array, moving the last object into its place.
+	static scene::object_base* remove_synced_object(std::vector<synced_object>& objects, std::unordered_map<entity::id, std::size_t>& indices, entity::id entity_id);
+	
 	void update_model_and_materials(entity::id entity_id, entity::component::model& model);
 	void update_light(entity::id entity_id, entity::component::light& component);
 	
@@ -66,8 +90,10 @@ private:
 	
 	renderer* renderer;
 	std::vector<scene::collection*> layers;
-	std::unordered_map<entity::id, scene::model_instance*> model_instances;
-	std::unordered_map<entity::id, scene::light*> lights;
+	std::vector<synced_object> model_instances;
+	std::unordered_map<entity::id, std::size_t> model_instance_indices;
+	std::vector<synced_object> lights;
+	std::unordered_map<entity::id, std::size_t> light_indices;
 };
 
 } // namespace system
@@ -18,43 +18,265 @@
  */
 
 #include "samara.hpp"
-#include "entity/components/transform.hpp"
-#include "entity/components/samara.hpp"
-#include "entity/id.hpp"
+#include "renderer/model.hpp"
+#include "renderer/vertex-attributes.hpp"
+#include "gl/vertex-array.hpp"
+#include "gl/vertex-buffer.hpp"
+#include "gl/vertex-attribute-type.hpp"
+#include "math/batch.hpp"
 #include "math/math.hpp"
-#include "utility/fundamental-types.hpp"
+#include <algorithm>
+#include <cmath>
 
 namespace entity {
 namespace system {
 
+/// Speed at which samaras fall along their directions, in units per second.
+static constexpr float fall_speed = 20.0f;
+
+/// Rate at which samaras spin, in radians per second.
+static constexpr float spin_rate = math::two_pi<float> * 6.0f;
+
+/// Angle by which samaras are tilted from the horizontal, 20 degrees in radians.
+static constexpr float tilt_angle = math::pi<float> / 9.0f;
+
 samara::samara(entity::registry& registry):
-	updatable(registry)
-{}
+	updatable(registry),
+	rng(math::thread_random_engine().split()),
+	zone_radius(200.0f),
+	zone_min_height(100.0f),
+	zone_max_height(150.0f),
+	instances_updated(false),
+	samara_model(nullptr),
+	instanced_model(nullptr),
+	model_instance(nullptr),
+	scene_collection(nullptr)
+{
+	// Samaras are not entities, so the system may update alongside any other
+	declare_writes<>();
+}
+
+samara::~samara()
+{
+	if (model_instance)
+	{
+		if (scene_collection)
+			scene_collection->remove_object(model_instance);
+		delete model_instance;
+	}
+	delete instanced_model;
+}
 
 void samara::update(double t, double dt)
 {
-	registry.view<component::samara, component::transform>().each(
-		[&](entity::id entity_id, auto& samara, auto& transform)
+	const std::size_t count = get_samara_count();
+	if (!count)
+		return;
+	
+	// Rotation after spinning, `yaw * tilt * flip`, is linear in the yaw half-angle's cosine and sine, with constant `tilt * flip` per chirality
+	const math::quaternion<float> right_handed = math::angle_axis(tilt_angle, float3{1, 0, 0});
+	const math::quaternion<float> left_handed = right_handed * math::angle_axis(math::pi<float>, float3{0, 0, -1});
+	
+	const float step = static_cast<float>(dt);
+	const float half_step_angle = spin_rate * step * 0.5f;
+	const float step_cos = std::cos(half_step_angle);
+	const float step_sin = std::sin(half_step_angle);
+	
+	const math::vector3_soa<float> positions{position_x.data(), position_y.data(), position_z.data()};
+	const math::vector3_soa<float> directions{direction_x.data(), direction_y.data(), direction_z.data()};
+	instances.resize(count);
+	
+	math::simd::dispatch_lanes<float>(count,
+		[&](auto lanes, std::size_t i)
 		{
-			samara.angle += samara.chirality * math::radians(360.0f * 6.0f) * dt;
-
-			transform.local.translation += samara.direction * 20.0f * (float)dt;
-			transform.local.rotation =
-				math::angle_axis(samara.angle, float3{0, 1, 0}) *
-				math::angle_axis(math::radians(20.0f), float3{1, 0, 0}) *
-				((samara.chirality < 0.0f) ? math::angle_axis(math::radians(180.0f), float3{0, 0, -1}) : math::quaternion<float>{1, 0, 0, 0});
-
-			if (transform.local.translation.y < 0.0f)
+			typedef decltype(lanes) L;
+			
+			// Fall along the direction
+			L p[3];
+			L d[3];
+			math::simd::load(positions, i, p);
+			math::simd::load(directions, i, d);
+			const L distance = L::broadcast(fall_speed * step);
+			for (int c = 0; c < 3; ++c)
+				p[c] = p[c] + d[c] * distance;
+			math::simd::store(positions, i, p);
+			
+			// Spin by the chirality-signed step angle, then renormalize away rounding drift
+			const L chirality_lanes = L::load(chirality.data() + i);
+			const L rotate_sin = L::broadcast(step_sin) * chirality_lanes;
+			const L rotate_cos = L::broadcast(step_cos);
+			const L old_cos = L::load(spin_cos.data() + i);
+			const L old_sin = L::load(spin_sin.data() + i);
+			L cos_lanes = old_cos * rotate_cos - old_sin * rotate_sin;
+			L sin_lanes = old_sin * rotate_cos + old_cos * rotate_sin;
+			const L correction = L::broadcast(1.5f) - L::broadcast(0.5f) * (cos_lanes * cos_lanes + sin_lanes * sin_lanes);
+			cos_lanes = cos_lanes * correction;
+			sin_lanes = sin_lanes * correction;
+			cos_lanes.store(spin_cos.data() + i);
+			sin_lanes.store(spin_sin.data() + i);
+			
+			// Compose the yaw quaternion (c, 0, s, 0) with the constant rotation of the chirality
+			const auto left = chirality_lanes < L::broadcast(0.0f);
+			const L cw = L::select(left, L::broadcast(left_handed.w), L::broadcast(right_handed.w));
+			const L cx = L::select(left, L::broadcast(left_handed.x), L::broadcast(right_handed.x));
+			const L cy = L::select(left, L::broadcast(left_handed.y), L::broadcast(right_handed.y));
+			const L cz = L::select(left, L::broadcast(left_handed.z), L::broadcast(right_handed.z));
+			L q[4];
+			q[0] = cos_lanes * cw - sin_lanes * cy;
+			q[1] = cos_lanes * cx + sin_lanes * cz;
+			q[2] = cos_lanes * cy + sin_lanes * cw;
+			q[3] = cos_lanes * cz - sin_lanes * cx;
+			
+			// Interleave lanes into instances
+			float lane_values[7][L::width];
+			for (int c = 0; c < 3; ++c)
+				p[c].store(lane_values[c]);
+			for (int c = 0; c < 4; ++c)
+				q[c].store(lane_values[3 + c]);
+			for (std::size_t j = 0; j < L::width; ++j)
 			{
-				const float zone = 200.0f;
-				transform.local.translation.x = math::random(-zone, zone);
-				transform.local.translation.y = math::random(100.0f, 150.0f);
-				transform.local.translation.z = math::random(-zone, zone);
-				transform.warp = true;
-
-				samara.chirality = (math::random(0.0f, 1.0f) < 0.5f) ? -1.0f : 1.0f;
+				samara_instance& instance = instances[i + j];
+				instance.position = {lane_values[0][j], lane_values[1][j], lane_values[2][j]};
+				for (int c = 0; c < 4; ++c)
+					instance.rotation[c] = lane_values[3 + c][j];
 			}
 		});
+	
+	// Respawn samaras which have reached the ground
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		if (position_y[i] < 0.0f)
+		{
+			spawn(i, zone_min_height, zone_max_height);
+			instances[i].position = {position_x[i], position_y[i], position_z[i]};
+		}
+	}
+	
+	instances_updated = true;
+}
+
+void samara::set_samara_count(std::size_t count)
+{
+	const std::size_t old_count = get_samara_count();
+	
+	position_x.resize(count);
+	position_y.resize(count);
+	position_z.resize(count);
+	direction_x.resize(count);
+	direction_y.resize(count);
+	direction_z.resize(count);
+	spin_cos.resize(count);
+	spin_sin.resize(count);
+	chirality.resize(count);
+	
+	// Spread new samaras over the full height of their fall
+	for (std::size_t i = old_count; i < count; ++i)
+		spawn(i, 0.0f, zone_max_height);
+}
+
+void samara::set_zone(float radius, float min_height, float max_height)
+{
+	zone_radius = radius;
+	zone_min_height = min_height;
+	zone_max_height = max_height;
+}
+
+void samara::set_samara_model(::model* model)
+{
+	samara_model = model;
+}
+
+void samara::set_scene(scene::collection* collection)
+{
+	if (model_instance)
+	{
+		if (scene_collection)
+			scene_collection->remove_object(model_instance);
+		if (collection)
+			collection->add_object(model_instance);
+	}
+	
+	scene_collection = collection;
+}
+
+void samara::upload_instances()
+{
+	if (!instances_updated || !samara_model)
+		return;
+	instances_updated = false;
+	
+	const std::size_t size = instances.size() * sizeof(samara_instance);
+	if (!instanced_model)
+	{
+		instanced_model = new model();
+		
+		// Bind the vertex attributes of the samara model, followed by the per-instance attributes
+		const gl::vertex_array* source_vao = samara_model->get_vertex_array();
+		gl::vertex_buffer* vbo = instanced_model->get_vertex_buffer();
+		vbo->resize(size, instances.data());
+		gl::vertex_array* vao = instanced_model->get_vertex_array();
+		for (const auto& attribute: source_vao->get_attributes())
+		{
+			const gl::vertex_array::attribute_binding& binding = attribute.second;
+			vao->bind_attribute(attribute.first, *binding.buffer, binding.size, binding.type, binding.stride, binding.offset, binding.normalized);
+		}
+		if (source_vao->get_element_buffer())
+			vao->bind_elements(*source_vao->get_element_buffer());
+		vao->bind_attribute(VERTEX_INSTANCE_POSITION_LOCATION, *vbo, 3, gl::vertex_attribute_type::float_32, sizeof(samara_instance), 0);
+		vao->bind_attribute(VERTEX_INSTANCE_ROTATION_LOCATION, *vbo, 4, gl::vertex_attribute_type::float_32, sizeof(samara_instance), sizeof(float3));
+		vao->set_attribute_divisor(VERTEX_INSTANCE_POSITION_LOCATION, 1);
+		vao->set_attribute_divisor(VERTEX_INSTANCE_ROTATION_LOCATION, 1);
+		
+		// Copy the model groups of the samara model
+		for (const model_group* source_group: *samara_model->get_groups())
+		{
+			model_group* group = instanced_model->add_group(source_group->get_name());
+			group->set_material(const_cast<::material*>(source_group->get_material()));
+			group->set_drawing_mode(source_group->get_drawing_mode());
+			group->set_start_index(source_group->get_start_index());
+			group->set_index_count(source_group->get_index_count());
+			if (source_group->is_indexed())
+				group->set_element_type(source_group->get_element_type());
+		}
+		
+		// Conservatively bound the zone in which samaras fall, in any orientation
+		const geom::aabb<float>& model_bounds = samara_model->get_bounds();
+		const float model_radius = std::max(math::length(model_bounds.min_point), math::length(model_bounds.max_point));
+		instanced_model->set_bounds({{-zone_radius - model_radius, -model_radius, -zone_radius - model_radius}, {zone_radius + model_radius, zone_max_height + model_radius, zone_radius + model_radius}});
+		
+		model_instance = new scene::model_instance(instanced_model);
+		if (scene_collection)
+			scene_collection->add_object(model_instance);
+	}
+	else
+	{
+		gl::vertex_buffer* vbo = instanced_model->get_vertex_buffer();
+		if (vbo->get_size() == size)
+			vbo->update(0, size, instances.data());
+		else
+			vbo->resize(size, instances.data());
+	}
+	
+	model_instance->set_active(!instances.empty());
+	model_instance->set_instanced(true, instances.size());
+}
+
+void samara::spawn(std::size_t index, float min_height, float max_height)
+{
+	position_x[index] = rng.uniform(-zone_radius, zone_radius);
+	position_y[index] = rng.uniform(min_height, max_height);
+	position_z[index] = rng.uniform(-zone_radius, zone_radius);
+	
+	// Drift slightly from vertical
+	const float3 direction = math::normalize(float3{rng.uniform(-0.25f, 0.25f), -1.0f, rng.uniform(-0.25f, 0.25f)});
+	direction_x[index] = direction.x;
+	direction_y[index] = direction.y;
+	direction_z[index] = direction.z;
+	
+	const float half_angle = rng.uniform(0.0f, math::pi<float>);
+	spin_cos[index] = std::cos(half_angle);
+	spin_sin[index] = std::sin(half_angle);
+	chirality[index] = (rng.uniform(0.0f, 1.0f) < 0.5f) ? -1.0f : 1.0f;
 }
 
 } // namespace system
@@ -21,19 +21,114 @@
 #define ANTKEEPER_ENTITY_SYSTEM_SAMARA_HPP
 
 #include "entity/systems/updatable.hpp"
+#include "math/random.hpp"
+#include "scene/collection.hpp"
+#include "scene/model-instance.hpp"
+#include "utility/fundamental-types.hpp"
+#include <cstddef>
+#include <vector>
+
+class model;
 
 namespace entity {
 namespace system {
 
+/**
+ * Simulates and draws falling samaras as ambient particles.
+ *
+ * Samaras are not entities. Their state is held in contiguous structure-of-arrays buffers and advanced with SIMD batch kernels: each samara falls along its own direction while spinning about the vertical axis, and its spin is advanced by rotating the sine and cosine of its half-angle rather than by rebuilding quaternions from angles. Samaras which reach the ground are respawned above the zone.
+ *
+ * All samaras are drawn by a single instanced draw of the samara model. Instances are stored as a position followed by a rotation quaternion, bound to @ref VERTEX_INSTANCE_POSITION_LOCATION and @ref VERTEX_INSTANCE_ROTATION_LOCATION, by which the samara vertex shader should rotate and place each instance. As the system may be updated on any thread, it makes no OpenGL calls while updating.
+ */
 class samara: public updatable
 {
 public:
 	samara(entity::registry& registry);
+	~samara();
 	virtual void update(double t, double dt);
+	
+	/**
+	 * Sets the number of samaras, spawning new samaras at random heights throughout the zone.
+	 *
+	 * @param count Number of samaras.
+	 */
+	void set_samara_count(std::size_t count);
+	
+	/**
+	 * Sets the region in which samaras fall.
+	 *
+	 * @param radius Half-width of the square zone, centered on the origin, over which samaras are spawned.
+	 * @param min_height Minimum height at which samaras respawn.
+	 * @param max_height Maximum height at which samaras respawn.
+	 */
+	void set_zone(float radius, float min_height, float max_height);
+	
+	/**
+	 * Sets the model of which samara instances are drawn. Must be set before upload_instances() is first called.
+	 */
+	void set_samara_model(::model* model);
+	
+	void set_scene(scene::collection* collection);
+	
+	/**
+	 * Uploads the samara instances of the most recent update to the GPU, creating the instanced model if necessary. Must be called once per frame, by the thread which owns the OpenGL context, while the system is not updating.
+	 */
+	void upload_instances();
+	
+	/// Returns the number of samaras.
+	std::size_t get_samara_count() const;
+	
+private:
+	/// Samara instance, as stored in the instance buffer.
+	struct samara_instance
+	{
+		float3 position;
+		
+		/// Rotation quaternion, in the order w, x, y, z.
+		float rotation[4];
+	};
+	
+	/// Places a samara at a random position in the zone, with a random direction and chirality.
+	void spawn(std::size_t index, float min_height, float max_height);
+	
+	/// Random engine by which samaras are respawned, split from that of the constructing thread so that respawns are reproducible regardless of which thread updates the system.
+	math::random_engine rng;
+	
+	float zone_radius;
+	float zone_min_height;
+	float zone_max_height;
+	
+	/// Positions and unit fall directions of samaras.
+	std::vector<float> position_x;
+	std::vector<float> position_y;
+	std::vector<float> position_z;
+	std::vector<float> direction_x;
+	std::vector<float> direction_y;
+	std::vector<float> direction_z;
+	
+	/// Cosines and sines of the half-angles by which samaras have spun about the vertical axis.
+	std::vector<float> spin_cos;
+	std::vector<float> spin_sin;
+	
+	/// Chiralities of samaras, `-1` or `1`.
+	std::vector<float> chirality;
+	
+	/// Instances of the most recent update.
+	std::vector<samara_instance> instances;
+	bool instances_updated;
+	
+	::model* samara_model;
+	::model* instanced_model;
+	scene::model_instance* model_instance;
+	scene::collection* scene_collection;
 };
 
+inline std::size_t samara::get_samara_count() const
+{
+	return chirality.size();
+}
+
 } // namespace system
 } // namespace entity
 
 #endif // ANTKEEPER_ENTITY_SYSTEM_SAMARA_HPP
-
@@ -0,0 +1,160 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "entity/systems/scheduler.hpp"
+#include "debug/allocation-tracker.hpp"
+#include "debug/profiler.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+namespace entity {
+namespace system {
+
+scheduler::scheduler(job_system* jobs):
+	jobs(jobs),
+	t(0.0),
+	dt(0.0)
+{}
+
+void scheduler::add_system(updatable* system, const char* name)
+{
+	const std::size_t index = nodes.size();
+	nodes.push_back({system, name, {}, 0});
+	remaining_predecessors.reset(new std::atomic<std::size_t>[nodes.size()]);
+	
+	// Order after all conflicting systems which were added before
+	for (std::size_t i = 0; i < index; ++i)
+	{
+		if (conflicts(*nodes[i].system, *system))
+			add_edge(i, index);
+	}
+}
+
+void scheduler::add_dependency(const updatable* before, const updatable* after)
+{
+	const std::size_t before_index = find_node(before);
+	const std::size_t after_index = find_node(after);
+	
+	// Only forward edges are allowed, which keeps the task graph acyclic
+	if (before_index >= after_index)
+		throw std::invalid_argument("System dependency contradicts schedule order");
+	
+	add_edge(before_index, after_index);
+}
+
+void scheduler::update(double t, double dt)
+{
+	if (nodes.empty())
+		return;
+	
+	this->t = t;
+	this->dt = dt;
+	
+	for (std::size_t i = 0; i < nodes.size(); ++i)
+		remaining_predecessors[i].store(nodes[i].predecessor_count, std::memory_order_relaxed);
+	
+	// Submit systems without predecessors, then execute jobs until all systems have completed
+	job_system::counter counter;
+	for (std::size_t i = 0; i < nodes.size(); ++i)
+	{
+		if (!nodes[i].predecessor_count)
+			submit(i, &counter);
+	}
+	
+	jobs->wait(counter);
+}
+
+std::size_t scheduler::find_node(const updatable* system) const
+{
+	for (std::size_t i = 0; i < nodes.size(); ++i)
+	{
+		if (nodes[i].system == system)
+			return i;
+	}
+	
+	throw std::invalid_argument("System has not been added to the scheduler");
+}
+
+bool scheduler::conflicts(const updatable& a, const updatable& b)
+{
+	if (!a.has_declared_access() || !b.has_declared_access())
+		return true;
+	
+	auto intersects = [](const std::vector<std::type_index>& x, const std::vector<std::type_index>& y)
+	{
+		for (const std::type_index& type: x)
+			if (std::find(y.begin(), y.end(), type) != y.end())
+				return true;
+		return false;
+	};
+	
+	return
+		intersects(a.get_writes(), b.get_writes()) ||
+		intersects(a.get_writes(), b.get_reads()) ||
+		intersects(a.get_reads(), b.get_writes());
+}
+
+void scheduler::add_edge(std::size_t before, std::size_t after)
+{
+	std::vector<std::size_t>& successors = nodes[before].successors;
+	if (std::find(successors.begin(), successors.end(), after) != successors.end())
+		return;
+	
+	successors.push_back(after);
+	++nodes[after].predecessor_count;
+}
+
+void scheduler::submit(std::size_t index, job_system::counter* counter)
+{
+	jobs->submit
+	(
+		[this, index, counter]
+		{
+			const node& current = nodes[index];
+			
+			// Release successors even if the system throws, so the update can complete
+			try
+			{
+				debug::profile_zone zone(current.name);
+				debug::allocation_scope allocation_scope(debug::allocation_tag::ecs);
+				current.system->update(t, dt);
+			}
+			catch (...)
+			{
+				release(index, counter);
+				throw;
+			}
+			
+			release(index, counter);
+		},
+		counter
+	);
+}
+
+void scheduler::release(std::size_t index, job_system::counter* counter)
+{
+	for (std::size_t successor: nodes[index].successors)
+	{
+		if (remaining_predecessors[successor].fetch_sub(1, std::memory_order_acq_rel) == 1)
+			submit(successor, counter);
+	}
+}
+
+} // namespace system
+} // namespace entity
@@ -0,0 +1,120 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ANTKEEPER_ENTITY_SYSTEM_SCHEDULER_HPP
+#define ANTKEEPER_ENTITY_SYSTEM_SCHEDULER_HPP
+
+#include "entity/systems/updatable.hpp"
+#include "utility/job-system.hpp"
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace entity {
+namespace system {
+
+/**
+ * Updates systems concurrently as jobs of a job system, according to a task graph derived from their component access.
+ *
+ * Systems are ordered as they were added, except where two systems can be proven not to conflict: a system runs after every previously-added system which writes a component it reads or writes, or which reads a component it writes. Systems which have not declared their component access conflict with every other system. Additional ordering constraints can be added explicitly.
+ *
+ * @see entity::system::updatable::has_declared_access()
+ */
+class scheduler
+{
+public:
+	/**
+	 * Creates a scheduler.
+	 *
+	 * @param jobs Job system on which systems are updated.
+	 */
+	explicit scheduler(job_system* jobs);
+	
+	scheduler(const scheduler&) = delete;
+	scheduler& operator=(const scheduler&) = delete;
+	
+	/**
+	 * Adds a system to the end of the schedule.
+	 *
+	 * @param system System to add.
+	 * @param name Name of the system's profiling zone. Must outlive the scheduler.
+	 */
+	void add_system(updatable* system, const char* name);
+	
+	/**
+	 * Constrains a system to update after another.
+	 *
+	 * @param before System which should update first.
+	 * @param after System which should update after @p before.
+	 */
+	void add_dependency(const updatable* before, const updatable* after);
+	
+	/**
+	 * Updates all systems, returning once every system has been updated. The calling thread executes jobs while waiting. The first exception thrown by a system is rethrown on the calling thread.
+	 *
+	 * @param t Total elapsed time, in seconds.
+	 * @param dt Delta time, in seconds.
+	 */
+	void update(double t, double dt);
+	
+	/// Returns the job system on which systems are updated.
+	job_system* get_job_system() const;
+
+private:
+	struct node
+	{
+		updatable* system;
+		const char* name;
+		std::vector<std::size_t> successors;
+		std::size_t predecessor_count;
+	};
+	
+	/// Returns the index of the node of a system.
+	std::size_t find_node(const updatable* system) const;
+	
+	/// Returns `true` if two systems cannot safely update concurrently.
+	static bool conflicts(const updatable& a, const updatable& b);
+	
+	/// Adds an edge to the task graph, ignoring duplicates.
+	void add_edge(std::size_t before, std::size_t after);
+	
+	/// Submits a job which updates the system of a node and releases its successors.
+	void submit(std::size_t index, job_system::counter* counter);
+	
+	/// Submits the successors of a node whose predecessors have all completed.
+	void release(std::size_t index, job_system::counter* counter);
+	
+	job_system* jobs;
+	std::vector<node> nodes;
+	std::unique_ptr<std::atomic<std::size_t>[]> remaining_predecessors;
+	double t;
+	double dt;
+};
+
+inline job_system* scheduler::get_job_system() const
+{
+	return jobs;
+}
+
+} // namespace system
+} // namespace entity
+
+#endif // ANTKEEPER_ENTITY_SYSTEM_SCHEDULER_HPP
+
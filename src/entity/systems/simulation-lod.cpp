@@ -0,0 +1,211 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "entity/systems/simulation-lod.hpp"
+#include "entity/components/colony.hpp"
+#include "entity/components/observer.hpp"
+#include "entity/components/simulation-lod.hpp"
+#include "entity/components/transform.hpp"
+#include "geom/sphere.hpp"
+#include "ai/navmesh.hpp"
+#include <algorithm>
+
+namespace entity {
+namespace system {
+
+simulation_lod::simulation_lod(entity::registry& registry):
+	updatable(registry),
+	materialize_distance(64.0f),
+	aggregate_distance(96.0f),
+	view_margin(4.0f),
+	coarse_interval(10),
+	elapsed_ticks(0),
+	elapsed_time(0.0)
+{
+	declare_reads<component::observer, component::transform>();
+	declare_writes<component::simulation_lod, component::colony, component::behavior, component::locomotion>();
+	
+	registry.on_destroy<component::simulation_lod>().connect<&simulation_lod::on_simulation_lod_destroy>(this);
+}
+
+simulation_lod::~simulation_lod()
+{
+	registry.on_destroy<component::simulation_lod>().disconnect<&simulation_lod::on_simulation_lod_destroy>(this);
+}
+
+void simulation_lod::update(double t, double dt)
+{
+	// Gather the cameras of observers
+	cameras.clear();
+	registry.view<component::observer>().each
+	(
+		[&](entity::id entity_id, auto& observer)
+		{
+			if (observer.camera && observer.camera->is_active())
+				cameras.push_back(observer.camera);
+		}
+	);
+	
+	// Find entities which must switch between full and coarse simulation, as components can't be removed while iterating
+	switched_entities.clear();
+	registry.view<component::simulation_lod, component::transform>().each
+	(
+		[&](entity::id entity_id, auto& lod, auto& transform)
+		{
+			const float3& position = transform.world.translation;
+			if (lod.coarse)
+			{
+				if (cameras.empty() || is_watched(position, materialize_distance, view_margin))
+					switched_entities.push_back(entity_id);
+			}
+			else if (!cameras.empty() && !is_watched(position, aggregate_distance, view_margin * 2.0f))
+			{
+				switched_entities.push_back(entity_id);
+			}
+		}
+	);
+	
+	for (entity::id entity_id: switched_entities)
+	{
+		component::simulation_lod& lod = registry.get<component::simulation_lod>(entity_id);
+		if (lod.coarse)
+			materialize(entity_id, lod);
+		else
+			aggregate(entity_id, lod);
+	}
+	
+	// Step the coarse model at a low tick rate
+	elapsed_time += dt;
+	if (++elapsed_ticks >= std::max<std::uint32_t>(coarse_interval, 1))
+	{
+		step_colonies(elapsed_time);
+		elapsed_ticks = 0;
+		elapsed_time = 0.0;
+	}
+}
+
+bool simulation_lod::is_watched(const float3& point, float distance, float margin) const
+{
+	const geom::sphere<float> bounds = {point, margin};
+	for (const scene::camera* camera: cameras)
+	{
+		const float3 difference = point - camera->get_translation();
+		if (math::dot(difference, difference) <= distance * distance && camera->get_view_frustum().get_bounds().intersects(bounds))
+			return true;
+	}
+	
+	return false;
+}
+
+void simulation_lod::aggregate(entity::id entity_id, component::simulation_lod& lod)
+{
+	stash& stash = stashes[entity_id];
+	if (const component::behavior* behavior = registry.try_get<component::behavior>(entity_id))
+	{
+		stash.behavior = *behavior;
+		registry.remove<component::behavior>(entity_id);
+	}
+	if (const component::locomotion* locomotion = registry.try_get<component::locomotion>(entity_id))
+	{
+		stash.locomotion = *locomotion;
+		registry.remove<component::locomotion>(entity_id);
+	}
+	
+	count_task(lod, 1);
+	lod.coarse = true;
+}
+
+void simulation_lod::materialize(entity::id entity_id, component::simulation_lod& lod)
+{
+	auto it = stashes.find(entity_id);
+	if (it != stashes.end())
+	{
+		// Derive the evaluation phase of the behavior tree from the entity ID, so that it doesn't depend on the order in which entities are rematerialized
+		if (it->second.behavior)
+		{
+			component::behavior& behavior = *it->second.behavior;
+			const std::uint32_t interval = std::max<std::uint32_t>(behavior.interval, 1);
+			behavior.running_node = ebt::compiled_tree::npos;
+			behavior.elapsed_ticks = (static_cast<std::uint32_t>(entity_id) * 2654435761u) % interval;
+			registry.assign<component::behavior>(entity_id, behavior);
+		}
+		
+		// Replan interrupted paths from where the entity was aggregated
+		if (it->second.locomotion)
+		{
+			component::locomotion& locomotion = *it->second.locomotion;
+			locomotion.path_requested = locomotion.path_requested || locomotion.waypoint < locomotion.path.size();
+			locomotion.path.clear();
+			locomotion.waypoint = 0;
+			locomotion.velocity = {0.0f, 0.0f, 0.0f};
+			locomotion.node = ai::navmesh::invalid_index;
+			registry.assign<component::locomotion>(entity_id, std::move(locomotion));
+		}
+		
+		stashes.erase(it);
+	}
+	
+	count_task(lod, -1);
+	lod.coarse = false;
+}
+
+void simulation_lod::count_task(const component::simulation_lod& lod, int count)
+{
+	if (lod.colony_eid == entt::null || !registry.valid(lod.colony_eid))
+		return;
+	component::colony* colony = registry.try_get<component::colony>(lod.colony_eid);
+	if (!colony)
+		return;
+	
+	if (colony->task_counts.size() <= lod.task)
+		colony->task_counts.resize(lod.task + 1, 0);
+	std::uint32_t& task_count = colony->task_counts[lod.task];
+	task_count = (count < 0 && task_count < static_cast<std::uint32_t>(-count)) ? 0 : task_count + count;
+}
+
+void simulation_lod::step_colonies(double dt)
+{
+	registry.view<component::colony>().each
+	(
+		[&](entity::id entity_id, auto& colony)
+		{
+			double food_flow = 0.0;
+			const std::size_t task_count = std::min(colony.task_counts.size(), colony.food_rates.size());
+			for (std::size_t i = 0; i < task_count; ++i)
+				food_flow += static_cast<double>(colony.task_counts[i]) * static_cast<double>(colony.food_rates[i]);
+			
+			colony.food = std::max(0.0, colony.food + food_flow * dt);
+		}
+	);
+}
+
+void simulation_lod::on_simulation_lod_destroy(entity::registry& registry, entity::id entity_id)
+{
+	// Forget the stashed components of destroyed entities, and remove them from their colonies' task counts
+	const component::simulation_lod& lod = registry.get<component::simulation_lod>(entity_id);
+	if (lod.coarse)
+	{
+		stashes.erase(entity_id);
+		count_task(lod, -1);
+	}
+}
+
+} // namespace system
+} // namespace entity
@@ -0,0 +1,134 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef ANTKEEPER_ENTITY_SYSTEM_SIMULATION_LOD_HPP
+#define ANTKEEPER_ENTITY_SYSTEM_SIMULATION_LOD_HPP
+
+#include "entity/systems/updatable.hpp"
+#include "entity/components/behavior.hpp"
+#include "entity/components/locomotion.hpp"
+#include "entity/id.hpp"
+#include "scene/camera.hpp"
+#include "utility/fundamental-types.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+namespace entity {
+
+namespace component {
+
+struct simulation_lod;
+
+} // namespace component
+
+namespace system {
+
+/**
+ * Switches entities with simulation LOD components between full and coarse simulation, depending on whether any observer is watching them.
+ *
+ * An entity is watched while it lies within a distance of an observer camera and within that camera's view frustum, widened by a margin. Unwatched entities are aggregated: their behavior and locomotion components are removed from the registry and held by this system, so the behavior and locomotion systems skip them, and they are counted by task in the aggregate of their colony. Every few ticks, a coarse model advances each colony from its task counts alone, such as by the food flows of its foragers and nurses. Entities are aggregated beyond a greater distance and with a wider margin than those at which they are rematerialized, so that entities near the thresholds don't switch back and forth.
+ *
+ * Rematerialized entities resume from where they were aggregated, with their components restored. Their behavior trees restart with evaluation phases derived from their entity IDs, so rematerializing many entities at once doesn't evaluate them all in the same tick, and entities which were following paths plan new paths to their goals. If no observer has a camera, every entity is simulated fully.
+ */
+class simulation_lod:
+	public updatable
+{
+public:
+	simulation_lod(entity::registry& registry);
+	~simulation_lod();
+	virtual void update(double t, double dt);
+	
+	/**
+	 * Sets the distance from an observer camera within which aggregated entities are rematerialized.
+	 *
+	 * @param distance Rematerialization distance.
+	 */
+	void set_materialize_distance(float distance);
+	
+	/**
+	 * Sets the distance from every observer camera beyond which entities are aggregated. Should be greater than the rematerialization distance.
+	 *
+	 * @param distance Aggregation distance.
+	 */
+	void set_aggregate_distance(float distance);
+	
+	/**
+	 * Sets the margin by which view frustums are widened when testing whether entities are watched. Entities are aggregated only once they are outside of the frustums widened by twice the margin.
+	 *
+	 * @param margin View frustum margin.
+	 */
+	void set_view_margin(float margin);
+	
+	/**
+	 * Sets the number of ticks between steps of the coarse colony model.
+	 *
+	 * @param interval Number of ticks per coarse step. `0` and `1` both step every tick.
+	 */
+	void set_coarse_interval(std::uint32_t interval);
+	
+	/// Returns the number of entities currently simulated coarsely.
+	std::size_t get_coarse_count() const;
+	
+private:
+	/// Components of an aggregated entity, held until it is rematerialized.
+	struct stash
+	{
+		std::optional<component::behavior> behavior;
+		std::optional<component::locomotion> locomotion;
+	};
+	
+	/// Returns `true` if a point lies within a distance of an observer camera and within its view frustum widened by a margin.
+	bool is_watched(const float3& point, float distance, float margin) const;
+	
+	void aggregate(entity::id entity_id, component::simulation_lod& lod);
+	void materialize(entity::id entity_id, component::simulation_lod& lod);
+	
+	/// Adds a number of members to the task count of a colony.
+	void count_task(const component::simulation_lod& lod, int count);
+	
+	/// Steps the coarse model of each colony.
+	void step_colonies(double dt);
+	
+	void on_simulation_lod_destroy(entity::registry& registry, entity::id entity_id);
+	
+	float materialize_distance;
+	float aggregate_distance;
+	float view_margin;
+	std::uint32_t coarse_interval;
+	std::uint32_t elapsed_ticks;
+	double elapsed_time;
+	
+	std::vector<const scene::camera*> cameras;
+	std::vector<entity::id> switched_entities;
+	std::unordered_map<entity::id, stash> stashes;
+};
+
+inline std::size_t simulation_lod::get_coarse_count() const
+{
+	return stashes.size();
+}
+
+} // namespace system
+} // namespace entity
+
+#endif // ANTKEEPER_ENTITY_SYSTEM_SIMULATION_LOD_HPP
@@ -18,7 +18,7 @@
  */
 
 #include "snapping.hpp"
-#include "entity/components/collision.hpp"
+#include "entity/systems/collision.hpp"
 #include "entity/components/snap.hpp"
 #include "entity/components/transform.hpp"
 #include "entity/id.hpp"
@@ -28,65 +28,58 @@ namespace entity {
 namespace system {
 
 snapping::snapping(entity::registry& registry):
-	updatable(registry)
+	updatable(registry),
+	collision_system(nullptr)
 {}
 
 void snapping::update(double t, double dt)
 {
+	if (!collision_system)
+		return;
+	
+	// Gather pending snap rays
+	entities.clear();
+	rays.clear();
 	registry.view<component::transform, component::snap>().each(
 		[&](entity::id entity_id, auto& snap_transform, auto& snap)
 		{
-			bool intersection = false;
-			float a = std::numeric_limits<float>::infinity();
-			float3 pick;
-			
 			geom::ray<float> snap_ray = snap.ray;
 			if (snap.relative)
 			{
 				snap_ray.origin += snap_transform.local.translation;
 				snap_ray.direction = snap_transform.local.rotation * snap_ray.direction;
 			}
-
-			this->registry.view<component::transform, component::collision>().each(
-				[&](entity::id entity_id, auto& collision_transform, auto& collision)
-				{
-					// Transform ray into local space of collision component
-					math::transform<float> inverse_transform = math::inverse(collision_transform.local);
-					float3 origin = inverse_transform * snap_ray.origin;
-					float3 direction = math::normalize(math::conjugate(collision_transform.local.rotation) * snap_ray.direction);
-					geom::ray<float> transformed_ray = {origin, direction};
-
-					// Broad phase AABB test
-					auto aabb_result = geom::ray_aabb_intersection(transformed_ray, collision.bounds);
-					if (!std::get<0>(aabb_result))
-					{
-						return;
-					}
-
-					// Narrow phase mesh test
-					auto mesh_result = collision.mesh_accelerator.query_nearest(transformed_ray);
-					if (mesh_result)
-					{
-						intersection = true;
-						if (mesh_result->t < a)
-						{
-							a = mesh_result->t;
-							pick = snap_ray.extrapolate(a);
-						}
-					}
-				});
-
-			if (intersection)
-			{
-				snap_transform.local.translation = pick;
-				snap_transform.warp = snap.warp;
-				
-				if (snap.autoremove)
-				{
-					this->registry.remove<component::snap>(entity_id);
-				}
-			}
+			snap_ray.direction = math::normalize(snap_ray.direction);
+			
+			entities.push_back(entity_id);
+			rays.push_back(snap_ray);
 		});
+	
+	if (rays.empty())
+		return;
+	
+	// Resolve all snap rays as one batch
+	collision_system->query_nearest(rays, results);
+	
+	// Write back results
+	for (std::size_t i = 0; i < entities.size(); ++i)
+	{
+		if (!results[i])
+			continue;
+		
+		const component::snap& snap = registry.get<component::snap>(entities[i]);
+		component::transform& snap_transform = registry.get<component::transform>(entities[i]);
+		snap_transform.local.translation = rays[i].extrapolate(results[i]->t);
+		snap_transform.warp = snap.warp;
+		
+		if (snap.autoremove)
+			registry.remove<component::snap>(entities[i]);
+	}
+}
+
+void snapping::set_collision_system(const collision* collision_system)
+{
+	this->collision_system = collision_system;
 }
 
 } // namespace system
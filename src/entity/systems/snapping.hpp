@@ -21,16 +21,33 @@
 #define ANTKEEPER_ENTITY_SYSTEM_SNAPPING_HPP
 
 #include "entity/systems/updatable.hpp"
+#include "entity/systems/collision.hpp"
+#include "entity/id.hpp"
+#include "geom/ray.hpp"
+#include <optional>
+#include <vector>
 
 namespace entity {
 namespace system {
 
+/**
+ * Moves entities with snap components to the nearest collision mesh intersection of their snap rays. All pending snap rays are resolved as one batch.
+ */
 class snapping:
 	public updatable
 {
 public:
 	snapping(entity::registry& registry);
 	virtual void update(double t, double dt);
+	
+	/// Sets the collision system against which snap rays are cast.
+	void set_collision_system(const collision* collision_system);
+	
+private:
+	const collision* collision_system;
+	std::vector<entity::id> entities;
+	std::vector<geom::ray<float>> rays;
+	std::vector<std::optional<collision::ray_query_result>> results;
 };
 
 } // namespace system
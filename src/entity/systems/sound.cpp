@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "entity/systems/sound.hpp"
+#include "entity/components/sound-source.hpp"
+#include "entity/components/transform.hpp"
+#include "audio/mixer.hpp"
+
+namespace entity {
+namespace system {
+
+sound::sound(entity::registry& registry):
+	updatable(registry),
+	mixer(nullptr),
+	listener(nullptr)
+{
+	declare_reads<component::transform>();
+	declare_writes<component::sound_source>();
+	
+	registry.on_destroy<component::sound_source>().connect<&sound::on_sound_source_destroy>(this);
+}
+
+void sound::update(double t, double dt)
+{
+	if (!mixer)
+		return;
+	
+	if (listener)
+		mixer->set_listener(listener->get_translation(), listener->get_rotation());
+	
+	// Start new sound sources and move playing ones to their world positions
+	registry.view<component::transform, component::sound_source>().each(
+		[&](entity::id entity_id, const auto& transform, auto& source)
+		{
+			if (!source.wave)
+				return;
+			
+			audio::sound_parameters parameters;
+			parameters.position = transform.world.translation;
+			parameters.gain = source.gain;
+			parameters.pitch = source.pitch;
+			parameters.priority = source.priority;
+			parameters.reference_distance = source.reference_distance;
+			parameters.max_distance = source.max_distance;
+			parameters.spatial = true;
+			parameters.looping = source.looping;
+			
+			if (!source.sound)
+				source.sound = mixer->play(source.wave, parameters);
+			else
+				mixer->update(source.sound, parameters);
+		});
+	
+	mixer->commit();
+}
+
+void sound::set_mixer(audio::mixer* mixer)
+{
+	this->mixer = mixer;
+}
+
+void sound::set_listener(const scene::object_base* listener)
+{
+	this->listener = listener;
+}
+
+void sound::on_sound_source_destroy(entity::registry& registry, entity::id entity_id)
+{
+	const component::sound_source& source = registry.get<component::sound_source>(entity_id);
+	if (mixer && source.sound)
+		mixer->stop(source.sound);
+}
+
+} // namespace system
+} // namespace entity
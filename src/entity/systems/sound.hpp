@@ -0,0 +1,63 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ANTKEEPER_ENTITY_SYSTEM_SOUND_HPP
+#define ANTKEEPER_ENTITY_SYSTEM_SOUND_HPP
+
+#include "entity/systems/updatable.hpp"
+#include "entity/id.hpp"
+#include "scene/object.hpp"
+
+namespace audio { class mixer; }
+
+namespace entity {
+namespace system {
+
+/**
+ * Plays the sound sources of entities, passing their world positions to the mixer in a single batch per update.
+ *
+ * Must be updated on the thread which records mixer commands, after the transforms of sound sources and the listener have been resolved.
+ */
+class sound: public updatable
+{
+public:
+	sound(entity::registry& registry);
+	virtual void update(double t, double dt);
+	
+	/**
+	 * Sets the mixer which plays sounds.
+	 *
+	 * @param mixer Mixer, or `nullptr` to disable sound.
+	 */
+	void set_mixer(audio::mixer* mixer);
+	
+	/// Sets the scene object at which sounds are heard.
+	void set_listener(const scene::object_base* listener);
+
+private:
+	void on_sound_source_destroy(entity::registry& registry, entity::id entity_id);
+	
+	audio::mixer* mixer;
+	const scene::object_base* listener;
+};
+
+} // namespace system
+} // namespace entity
+
+#endif // ANTKEEPER_ENTITY_SYSTEM_SOUND_HPP
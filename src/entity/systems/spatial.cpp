@@ -17,43 +17,194 @@
  * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+
 #include "spatial.hpp"
-#include "entity/components/parent.hpp"
-#include "entity/components/transform.hpp"
+#include "math/batch.hpp"
+#include "utility/job-system.hpp"
+#include <algorithm>
+#include <cstring>
+#include <unordered_map>
 
 namespace entity {
 namespace system {
 
 spatial::spatial(entity::registry& registry):
-	updatable(registry)
-{}
+	updatable(registry),
+	jobs(nullptr),
+	hierarchy_changed(true)
+{
+	declare_reads<component::parent>();
+	declare_writes<component::transform>();
+	
+	registry.on_construct<component::transform>().connect<&spatial::on_transform_construct>(this);
+	registry.on_destroy<component::transform>().connect<&spatial::on_transform_destroy>(this);
+	registry.on_construct<component::parent>().connect<&spatial::on_parent_construct>(this);
+	registry.on_replace<component::parent>().connect<&spatial::on_parent_replace>(this);
+	registry.on_destroy<component::parent>().connect<&spatial::on_parent_destroy>(this);
+}
 
 void spatial::update(double t, double dt)
 {
-	/// @TODO: sort transforms by parent, for more multi-level hierarchies
+	// Force recomputation of all world transforms after the hierarchy has been rebuilt
+	const bool force = hierarchy_changed;
+	if (hierarchy_changed)
+	{
+		rebuild_hierarchy();
+		hierarchy_changed = false;
+	}
 	
-	// Process parent transforms first
-	registry.view<component::transform>().each(
+	// Process depth levels in order, as each level depends on the world transforms of the previous level
+	for (std::size_t i = 1; i < level_offsets.size(); ++i)
+	{
+		const std::size_t first = level_offsets[i - 1];
+		const std::size_t last = level_offsets[i];
+		
+		if (jobs)
+			jobs->parallel_for(first, last, 256, [this, force](std::size_t first, std::size_t last){propagate(first, last, force);});
+		else
+			propagate(first, last, force);
+	}
+}
+
+void spatial::set_job_system(job_system* jobs)
+{
+	this->jobs = jobs;
+}
+
+void spatial::rebuild_hierarchy()
+{
+	// Find the hierarchy depth of each transform
+	auto transforms_view = registry.view<component::transform>();
+	const std::size_t max_depth = transforms_view.size();
+	std::unordered_map<entity::id, std::size_t> depths;
+	std::vector<std::pair<std::size_t, entity::id>> entities;
+	transforms_view.each
+	(
 		[&](entity::id entity_id, auto& transform)
 		{
-			if (!this->registry.has<component::parent>(entity_id))
+			std::size_t depth = 0;
+			entity::id ancestor = entity_id;
+			
+			// Walk up the hierarchy until a root, or an ancestor of known depth, is found. Cyclic hierarchies are cut off at the number of transforms.
+			while (depth < max_depth && registry.has<component::parent>(ancestor))
 			{
-				transform.world = transform.local;
+				ancestor = registry.get<component::parent>(ancestor).parent;
+				if (!registry.valid(ancestor) || !registry.has<component::transform>(ancestor))
+					break;
+				
+				++depth;
+				if (auto it = depths.find(ancestor); it != depths.end())
+				{
+					depth += it->second;
+					break;
+				}
 			}
-		});
+			
+			depths[entity_id] = depth;
+			entities.emplace_back(depth, entity_id);
+		}
+	);
 	
-	// Process child transforms second
-	registry.view<component::transform>().each(
-		[&](entity::id entity_id, auto& transform)
+	std::stable_sort(entities.begin(), entities.end(), [](const auto& a, const auto& b){return a.first < b.first;});
+	
+	// Build depth-sorted node array
+	std::unordered_map<entity::id, std::size_t> indices;
+	hierarchy.clear();
+	level_offsets.clear();
+	for (const auto& [depth, entity_id]: entities)
+	{
+		while (level_offsets.size() <= depth)
+			level_offsets.push_back(hierarchy.size());
+		
+		std::size_t parent_index = npos;
+		if (depth)
 		{
-			if (this->registry.has<component::parent>(entity_id))
-			{
-				entity::id parent = this->registry.get<component::parent>(entity_id).parent;
-				const component::transform& parent_transform = this->registry.get<component::transform>(parent);
-				transform.world = parent_transform.world * transform.local;
-				transform.warp = parent_transform.warp;
-			}
-		});
+			if (auto it = indices.find(registry.get<component::parent>(entity_id).parent); it != indices.end())
+				parent_index = it->second;
+		}
+		
+		indices[entity_id] = hierarchy.size();
+		hierarchy.push_back({&registry.get<component::transform>(entity_id), parent_index, {}, false});
+	}
+	level_offsets.push_back(hierarchy.size());
+}
+
+void spatial::propagate(std::size_t first, std::size_t last, bool force)
+{
+	// Dirty child nodes, whose world transforms are composed in a single batch. Each thread keeps its own buffers, reused across updates.
+	thread_local std::vector<std::size_t> batch_indices;
+	thread_local math::transform_soa_buffer<float> parent_batch;
+	thread_local math::transform_soa_buffer<float> local_batch;
+	batch_indices.clear();
+	
+	for (std::size_t i = first; i < last; ++i)
+	{
+		node& current = hierarchy[i];
+		component::transform& transform = *current.transform;
+		
+		const node* parent = (current.parent_index != npos) ? &hierarchy[current.parent_index] : nullptr;
+		
+		// Only recompute if the local transform or the parent's world transform has changed
+		current.dirty = force || (parent && parent->dirty) || std::memcmp(&current.local, &transform.local, sizeof(transform.local));
+		if (!current.dirty)
+			continue;
+		
+		current.local = transform.local;
+		if (parent)
+		{
+			batch_indices.push_back(i);
+			transform.warp = parent->transform->warp;
+		}
+		else
+		{
+			transform.world = transform.local;
+		}
+	}
+	
+	if (batch_indices.empty())
+		return;
+	
+	// Gather parent world and child local transforms into SoA buffers
+	const std::size_t n = batch_indices.size();
+	parent_batch.resize(n);
+	local_batch.resize(n);
+	for (std::size_t k = 0; k < n; ++k)
+	{
+		const node& current = hierarchy[batch_indices[k]];
+		parent_batch.set(k, hierarchy[current.parent_index].transform->world);
+		local_batch.set(k, current.local);
+	}
+	
+	// Compose world transforms in place, then scatter them back into the transform components
+	const math::transform_soa<float> locals = local_batch.view();
+	math::transform_compose_n(parent_batch.view(), locals, locals, n);
+	for (std::size_t k = 0; k < n; ++k)
+		hierarchy[batch_indices[k]].transform->world = local_batch.get(k);
+}
+
+void spatial::on_transform_construct(entity::registry& registry, entity::id entity_id, component::transform& transform)
+{
+	hierarchy_changed = true;
+}
+
+void spatial::on_transform_destroy(entity::registry& registry, entity::id entity_id)
+{
+	hierarchy_changed = true;
+}
+
+void spatial::on_parent_construct(entity::registry& registry, entity::id entity_id, component::parent& parent)
+{
+	hierarchy_changed = true;
+}
+
+void spatial::on_parent_replace(entity::registry& registry, entity::id entity_id, component::parent& parent)
+{
+	hierarchy_changed = true;
+}
+
+void spatial::on_parent_destroy(entity::registry& registry, entity::id entity_id)
+{
+	hierarchy_changed = true;
 }
 
 } // namespace system
@@ -17,23 +17,83 @@
  * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+
 #ifndef ANTKEEPER_ENTITY_SYSTEM_SPATIAL_HPP
 #define ANTKEEPER_ENTITY_SYSTEM_SPATIAL_HPP
 
 #include "entity/systems/updatable.hpp"
+#include "entity/components/parent.hpp"
+#include "entity/components/transform.hpp"
+#include "entity/id.hpp"
+#include <cstddef>
+#include <vector>
+
+class job_system;
 
 namespace entity {
 namespace system {
 
+/**
+ * Propagates local transforms through the entity hierarchy into world transforms.
+ *
+ * Transforms are kept in a contiguous array sorted by hierarchy depth, so parents are always processed before their children, regardless of hierarchy depth. World transforms are only recomputed for entities whose local transform changed since the last update, or whose parent's world transform was recomputed. Each depth level is processed in parallel if a job system has been set. Within each range of a level, the world transforms of dirty children are gathered and composed as a single SoA batch with math::transform_compose_n().
+ */
 class spatial:
 	public updatable
 {
 public:
 	spatial(entity::registry& registry);
 	virtual void update(double t, double dt);
+	
+	/**
+	 * Sets the job system on which depth levels are processed in parallel.
+	 *
+	 * @param jobs Job system, or `nullptr` to process all transforms on the calling thread.
+	 */
+	void set_job_system(job_system* jobs);
+	
+private:
+	struct node
+	{
+		/// Transform component of the entity. Pointers are refreshed whenever a transform component is constructed or destroyed.
+		component::transform* transform;
+		
+		/// Index of the parent node, or `npos` if the entity is a root.
+		std::size_t parent_index;
+		
+		/// Local transform at the time of the last world transform computation.
+		math::transform<float> local;
+		
+		/// `true` if the world transform was recomputed during the current update.
+		bool dirty;
+	};
+	
+	static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+	
+	/// Sorts all transforms by hierarchy depth.
+	void rebuild_hierarchy();
+	
+	/**
+	 * Recomputes the world transforms of the nodes `[first, last)` which are dirty.
+	 *
+	 * @param force `true` if all world transforms should be recomputed.
+	 */
+	void propagate(std::size_t first, std::size_t last, bool force);
+	
+	void on_transform_construct(entity::registry& registry, entity::id entity_id, component::transform& transform);
+	void on_transform_destroy(entity::registry& registry, entity::id entity_id);
+	void on_parent_construct(entity::registry& registry, entity::id entity_id, component::parent& parent);
+	void on_parent_replace(entity::registry& registry, entity::id entity_id, component::parent& parent);
+	void on_parent_destroy(entity::registry& registry, entity::id entity_id);
+	
+	job_system* jobs;
+	std::vector<node> hierarchy;
+	std::vector<std::size_t> level_offsets;
+	bool hierarchy_changed;
 };
 
 } // namespace system
 } // namespace entity
 
 #endif // ANTKEEPER_ENTITY_SYSTEM_SPATIAL_HPP
+
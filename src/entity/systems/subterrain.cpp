@@ -23,212 +23,224 @@
 #include "entity/id.hpp"
 #include "renderer/model.hpp"
 #include "renderer/material.hpp"
-#include "geom/mesh-functions.hpp"
 #include "renderer/vertex-attributes.hpp"
 #include "gl/vertex-attribute-type.hpp"
 #include "gl/drawing-mode.hpp"
 #include "gl/vertex-buffer.hpp"
+#include "gl/vertex-packing.hpp"
 #include "resources/resource-manager.hpp"
-#include "geom/marching-cubes.hpp"
+#include "ai/navmesh.hpp"
+#include "debug/allocation-tracker.hpp"
+#include "debug/counters.hpp"
 #include "geom/intersection.hpp"
+#include "geom/marching-cubes.hpp"
+#include "geom/mesh-functions.hpp"
+#include "geom/morton.hpp"
+#include "geom/sdf.hpp"
+#include "math/batch.hpp"
 #include "utility/fundamental-types.hpp"
+#include "utility/job-system.hpp"
+#include <algorithm>
 #include <array>
-#include <limits>
+#include <cmath>
+#include <cstring>
+#include <memory>
 
 namespace entity {
 namespace system {
 
 /**
- * An octree containing cubes for the marching cubes algorithm.
+ * Sparse signed distance field, sampled at the points of a cubic lattice and stored in bricks of 8^3 quantized distances.
+ *
+ * Bricks are keyed by the Morton codes of their brick coordinates. Lattice points in bricks which don't exist are solid, and bricks whose lattice points all share a distance are stored without their distances, so only bricks near the isosurface hold distances.
  */
-struct cube_tree
+struct brick_map
 {
 public:
-	cube_tree(const geom::aabb<float>& bounds, int max_depth);
-	~cube_tree();
-
-	const bool is_leaf() const;
-	const geom::aabb<float>& get_bounds() const;
-
-	/// Subdivides all nodes intersecting with a region to the max depth.
-	void subdivide_max(const geom::aabb<float>& region);
-
-	/// Fills a list with all leaf nodes that intersect with a region.
-	void query_leaves(std::list<cube_tree*>& nodes, const geom::aabb<float>& region);
-	void visit_leaves(const geom::aabb<float>& region, const std::function<void(cube_tree&)>& f);
-
-	/// Counts then number of nodes in the octree.
-	std::size_t size() const;
-
-	cube_tree* children[8];
-	float3 corners[8];
-	float distances[8];
-	const int max_depth;
-	const int depth;
-	const geom::aabb<float> bounds;
-
+	/// Number of lattice points along each axis of a brick, as a power of two.
+	static constexpr int brick_size_exponent = 3;
+	static constexpr std::uint32_t brick_size = 1 << brick_size_exponent;
+	static constexpr std::uint32_t brick_mask = brick_size - 1;
+	static constexpr std::size_t brick_volume = brick_size * brick_size * brick_size;
+	
+	/// Quantized distance of lattice points which have not been dug.
+	static constexpr std::int8_t solid = -127;
+	
+	/**
+	 * Creates an empty distance field, in which every lattice point is solid.
+	 *
+	 * @param resolution Distance between adjacent lattice points. Distances are quantized in steps of 1/32 of the resolution and clamped to within about four lattice points of the isosurface, beyond which marching cubes is unaffected by them.
+	 */
+	explicit brick_map(float resolution);
+	
+	/// Returns the distance of a quantized distance.
+	float dequantize(std::int8_t distance) const;
+	
+	/**
+	 * Copies the quantized distances of a box of lattice points into a dense array, with x varying fastest.
+	 *
+	 * @param min Coordinates of the lattice point at the minimum corner of the box.
+	 * @param size Number of lattice points along each axis of the box.
+	 * @param[out] distances Array of `size[0] * size[1] * size[2]` quantized distances.
+	 */
+	void gather(const std::uint32_t min[3], const std::uint32_t size[3], std::int8_t* distances) const;
+	
+	/**
+	 * Modifies the distances of a list of bricks.
+	 *
+	 * Missing bricks are created as solid before being modified, and bricks which are left entirely solid are removed.
+	 *
+	 * @param keys Keys of the bricks to modify, each unique.
+	 * @param jobs Job system on which the bricks are modified in parallel, or `nullptr` to modify them on the calling thread.
+	 * @param function Function which modifies the dequantized distances of a brick, with x varying fastest, and the signature `void(std::size_t index, const std::uint32_t brick_min[3], float* distances)`, where `index` is the index of the brick's key and `brick_min` are the coordinates of its minimum lattice point. Called concurrently for different bricks.
+	 */
+	template <class Function>
+	void edit(const std::vector<std::uint64_t>& keys, job_system* jobs, const Function& function);
+	
 private:
-	cube_tree(const geom::aabb<float>& bounds, int max_depth, int depth);
-	void subdivide();
+	struct brick
+	{
+		/// Quantized distances of the brick's lattice points, with x varying fastest, or `nullptr` if they all equal `uniform`.
+		std::unique_ptr<std::int8_t[]> distances;
+		std::int8_t uniform;
+	};
+	
+	std::int8_t quantize(float distance) const;
+	
+	std::unordered_map<std::uint64_t, brick> bricks;
+	float quantization_scale;
 };
 
-cube_tree::cube_tree(const geom::aabb<float>& bounds, int max_depth):
-	cube_tree(bounds, max_depth, 0)
+brick_map::brick_map(float resolution):
+	quantization_scale(32.0f / resolution)
 {}
 
-cube_tree::cube_tree(const geom::aabb<float>& bounds, int max_depth, int depth):
-	bounds(bounds),
-	max_depth(max_depth),
-	depth(depth)
-{
-	corners[0] = {bounds.min_point.x, bounds.min_point.y, bounds.min_point.z};
-	corners[1] = {bounds.max_point.x, bounds.min_point.y, bounds.min_point.z};
-	corners[2] = {bounds.max_point.x, bounds.max_point.y, bounds.min_point.z};
-	corners[3] = {bounds.min_point.x, bounds.max_point.y, bounds.min_point.z};
-	corners[4] = {bounds.min_point.x, bounds.min_point.y, bounds.max_point.z};
-	corners[5] = {bounds.max_point.x, bounds.min_point.y, bounds.max_point.z};
-	corners[6] = {bounds.max_point.x, bounds.max_point.y, bounds.max_point.z};
-	corners[7] = {bounds.min_point.x, bounds.max_point.y, bounds.max_point.z};
-
-	for (int i = 0; i < 8; ++i)
-	{
-		children[i] = nullptr;
-		distances[i] = -std::numeric_limits<float>::infinity();
-
-		// For outside normals
-		//distances[i] = std::numeric_limits<float>::infinity();
-	}
-}
-
-cube_tree::~cube_tree()
+inline std::int8_t brick_map::quantize(float distance) const
 {
-	for (cube_tree* child: children)
-		delete child;
+	return static_cast<std::int8_t>(std::clamp(std::round(distance * quantization_scale), -127.0f, 127.0f));
 }
 
-void cube_tree::subdivide_max(const geom::aabb<float>& region)
+inline float brick_map::dequantize(std::int8_t distance) const
 {
-	if (depth != max_depth && aabb_aabb_intersection(bounds, region))
-	{
-		if (is_leaf())
-			subdivide();
-
-		for (cube_tree* child: children)
-			child->subdivide_max(region);
-	}
+	return static_cast<float>(distance) / quantization_scale;
 }
 
-void cube_tree::query_leaves(std::list<cube_tree*>& nodes, const geom::aabb<float>& region)
+void brick_map::gather(const std::uint32_t min[3], const std::uint32_t size[3], std::int8_t* distances) const
 {
-	if (aabb_aabb_intersection(bounds, region))
+	const std::uint32_t max[3] = {min[0] + size[0] - 1, min[1] + size[1] - 1, min[2] + size[2] - 1};
+	
+	// Lattice points outside of any brick are solid
+	std::fill_n(distances, static_cast<std::size_t>(size[0]) * size[1] * size[2], solid);
+	
+	// Copy rows of distances from each brick overlapping the box
+	for (std::uint32_t bz = min[2] >> brick_size_exponent; bz <= max[2] >> brick_size_exponent; ++bz)
+	for (std::uint32_t by = min[1] >> brick_size_exponent; by <= max[1] >> brick_size_exponent; ++by)
+	for (std::uint32_t bx = min[0] >> brick_size_exponent; bx <= max[0] >> brick_size_exponent; ++bx)
 	{
-		if (is_leaf())
+		auto it = bricks.find(geom::morton::encode<std::uint64_t>(bx, by, bz));
+		if (it == bricks.end())
+			continue;
+		const brick& brick = it->second;
+		
+		const std::uint32_t brick_min[3] = {bx << brick_size_exponent, by << brick_size_exponent, bz << brick_size_exponent};
+		std::uint32_t lo[3];
+		std::uint32_t hi[3];
+		for (int i = 0; i < 3; ++i)
 		{
-			nodes.push_back(this);
+			lo[i] = std::max(min[i], brick_min[i]);
+			hi[i] = std::min(max[i], brick_min[i] + brick_mask);
 		}
-		else
+		const std::size_t row_size = hi[0] - lo[0] + 1;
+		
+		for (std::uint32_t z = lo[2]; z <= hi[2]; ++z)
+		for (std::uint32_t y = lo[1]; y <= hi[1]; ++y)
 		{
-			for (cube_tree* child: children)
-				child->query_leaves(nodes, region);
+			std::int8_t* row = distances + (static_cast<std::size_t>(z - min[2]) * size[1] + (y - min[1])) * size[0] + (lo[0] - min[0]);
+			if (brick.distances)
+				std::copy_n(brick.distances.get() + ((z & brick_mask) * brick_size + (y & brick_mask)) * brick_size + (lo[0] & brick_mask), row_size, row);
+			else
+				std::fill_n(row, row_size, brick.uniform);
 		}
 	}
 }
 
-void cube_tree::visit_leaves(const geom::aabb<float>& region, const std::function<void(cube_tree&)>& f)
+template <class Function>
+void brick_map::edit(const std::vector<std::uint64_t>& keys, job_system* jobs, const Function& function)
 {
-	if (aabb_aabb_intersection(bounds, region))
+	// Create missing bricks beforehand, as the brick table can't be modified concurrently
+	std::vector<brick*> edited_bricks(keys.size());
+	for (std::size_t i = 0; i < keys.size(); ++i)
+		edited_bricks[i] = &bricks.try_emplace(keys[i], brick_map::brick{nullptr, solid}).first->second;
+	
+	auto edit_bricks = [&](std::size_t first, std::size_t last)
 	{
-		if (is_leaf())
-		{
-			f(*this);
-		}
-		else
+		float distances[brick_volume];
+		std::int8_t quantized_distances[brick_volume];
+		
+		for (std::size_t i = first; i < last; ++i)
 		{
-			for (cube_tree* child: children)
-				child->visit_leaves(region, f);
+			brick& brick = *edited_bricks[i];
+			
+			std::uint64_t brick_coordinates[3];
+			geom::morton::decode<std::uint64_t>(keys[i], brick_coordinates[0], brick_coordinates[1], brick_coordinates[2]);
+			const std::uint32_t brick_min[3] =
+			{
+				static_cast<std::uint32_t>(brick_coordinates[0]) << brick_size_exponent,
+				static_cast<std::uint32_t>(brick_coordinates[1]) << brick_size_exponent,
+				static_cast<std::uint32_t>(brick_coordinates[2]) << brick_size_exponent
+			};
+			
+			if (brick.distances)
+				std::transform(brick.distances.get(), brick.distances.get() + brick_volume, distances, [this](std::int8_t distance){return dequantize(distance);});
+			else
+				std::fill_n(distances, brick_volume, dequantize(brick.uniform));
+			
+			function(i, brick_min, distances);
+			
+			std::transform(distances, distances + brick_volume, quantized_distances, [this](float distance){return quantize(distance);});
+			
+			// Release the distances of bricks which have become uniform, such as those within large cavities
+			if (std::all_of(quantized_distances + 1, quantized_distances + brick_volume, [first = quantized_distances[0]](std::int8_t distance){return distance == first;}))
+			{
+				brick.uniform = quantized_distances[0];
+				brick.distances.reset();
+			}
+			else
+			{
+				if (!brick.distances)
+					brick.distances.reset(new std::int8_t[brick_volume]);
+				std::copy_n(quantized_distances, brick_volume, brick.distances.get());
+			}
 		}
-	}
-}
-
-std::size_t cube_tree::size() const
-{
-	std::size_t node_count = 1;
-	if (!is_leaf())
-	{
-		for (cube_tree* child: children)
-			node_count += child->size();
-	}
-
-	return node_count;
-}
-
-inline const bool cube_tree::is_leaf() const
-{
-	return (children[0] == nullptr);
-}
-
-inline const geom::aabb<float>& cube_tree::get_bounds() const
-{
-	return bounds;
-}
-
-void cube_tree::subdivide()
-{
-	const float3 center = (bounds.min_point + bounds.max_point) * 0.5f;
-
-	for (int i = 0; i < 8; ++i)
+	};
+	if (jobs)
+		jobs->parallel_for(0, keys.size(), 16, edit_bricks);
+	else
+		edit_bricks(0, keys.size());
+	
+	// Remove bricks which are entirely solid, as lattice points outside of any brick are solid
+	for (std::uint64_t key: keys)
 	{
-		geom::aabb<float> child_bounds;
-		for (int j = 0; j < 3; ++j)
-		{
-			child_bounds.min_point[j] = std::min<float>(corners[i][j], center[j]);
-			child_bounds.max_point[j] = std::max<float>(corners[i][j], center[j]);
-		}
-
-		children[i] = new cube_tree(child_bounds, max_depth, depth + 1);
+		auto it = bricks.find(key);
+		if (!it->second.distances && it->second.uniform == solid)
+			bricks.erase(it);
 	}
 }
 
 subterrain::subterrain(entity::registry& registry, ::resource_manager* resource_manager):
 	updatable(registry),
-	resource_manager(resource_manager)
+	resource_manager(resource_manager),
+	jobs(nullptr),
+	navmesh(nullptr),
+	collection(nullptr)
 {
 
 	// Load subterrain materials
 	subterrain_inside_material = resource_manager->load<material>("subterrain-inside.mtl");
-	subterrain_inside_material = resource_manager->load<material>("subterrain-outside.mtl");
-
-	// Allocate subterrain model
-	subterrain_model = new model();
-
-	// Create inside model group
-	subterrain_inside_group = subterrain_model->add_group("inside");
-	subterrain_inside_group->set_material(resource_manager->load<material>("subterrain-inside.mtl"));
-	subterrain_inside_group->set_drawing_mode(gl::drawing_mode::triangles);
-	subterrain_inside_group->set_start_index(0);
-	subterrain_inside_group->set_index_count(0);
+	subterrain_outside_material = resource_manager->load<material>("subterrain-outside.mtl");
 
-	// Create outside model group
-	subterrain_outside_group = subterrain_model->add_group("outside");
-	subterrain_outside_group->set_material(resource_manager->load<material>("subterrain-outside.mtl"));
-	subterrain_outside_group->set_drawing_mode(gl::drawing_mode::triangles);
-	subterrain_outside_group->set_start_index(0);
-	subterrain_outside_group->set_index_count(0);
-
-	// Determine vertex size (position, normal, barycentric)
-	subterrain_model_vertex_size = 3 + 3 + 3;
-	subterrain_model_vertex_stride = subterrain_model_vertex_size * sizeof(float);
-	
-	// Bind vertex attributes
-	gl::vertex_buffer* vbo = subterrain_model->get_vertex_buffer();
-	gl::vertex_array* vao = subterrain_model->get_vertex_array();
-	std::size_t offset = 0;
-	vao->bind_attribute(VERTEX_POSITION_LOCATION, *vbo, 3, gl::vertex_attribute_type::float_32, subterrain_model_vertex_stride, 0);
-	offset += 3;
-	vao->bind_attribute(VERTEX_NORMAL_LOCATION, *vbo, 3, gl::vertex_attribute_type::float_32, subterrain_model_vertex_stride, sizeof(float) * offset);
-	offset += 3;
-	vao->bind_attribute(VERTEX_BARYCENTRIC_LOCATION, *vbo, 3, gl::vertex_attribute_type::float_32, subterrain_model_vertex_stride, sizeof(float) * offset);
-	offset += 3;
+	// Determine vertex stride (float position, packed 10:10:10:2 normal, and 8-bit barycentric coordinates padded to four bytes)
+	subterrain_model_vertex_stride = sizeof(float) * 3 + sizeof(std::uint32_t) + sizeof(std::uint8_t) * 4;
 
 	// Calculate adjusted bounds to fit isosurface resolution
 	//isosurface_resolution = 0.325f;
@@ -241,58 +253,75 @@ subterrain::subterrain(entity::registry& registry, ::resource_manager* resource_
 	subterrain_bounds.min_point = float3{-0.5f, -1.0f, -0.5f} * adjusted_volume_size;
 	subterrain_bounds.max_point = float3{ 0.5f,  0.0f,  0.5f} * adjusted_volume_size;
 	
-	// Set subterrain model bounds
-	subterrain_model->set_bounds(subterrain_bounds);
-
-	// Allocate cube tree
-	cube_tree = new entity::system::cube_tree(subterrain_bounds, octree_depth);
-
-	// Allocate mesh
-	subterrain_mesh = new geom::mesh();
-
-	first_run = true;
+	// Allocate distance field
+	distance_field = new entity::system::brick_map(isosurface_resolution);
+	cell_count = 1u << octree_depth;
+	
+	// Determine number of cubes along each axis of a chunk
+	chunk_cell_count = 1u << std::min(octree_depth, chunk_size_exponent);
 }
 
 subterrain::~subterrain()
 {
-	delete subterrain_model;
-	delete subterrain_mesh;
-}
-
-void subterrain::update(double t, double dt)
-{
-	if (first_run)
+	for (auto& chunk: chunks)
 	{
-		first_run = false;
-		//auto subterrain_entity = registry.create();
-		//registry.assign<component::model>(subterrain_entity, subterrain_model);
-		
-		subterrain_model_instance = new scene::model_instance(subterrain_model);
-		collection->add_object(subterrain_model_instance);
+		if (collection)
+			collection->remove_object(chunk.second->model_instance);
+		delete chunk.second->model_instance;
+		delete chunk.second->model;
+		delete chunk.second;
 	}
 
-	bool digging = false;
+	delete distance_field;
+}
 
+void subterrain::update(double t, double dt)
+{
+	debug::allocation_scope allocation_scope(debug::allocation_tag::subterrain);
+	
+	// Carve every new cavity in a single batch of edits
+	std::vector<subterrain_edit> edits;
 	registry.view<component::cavity>().each(
-		[this, &digging](entity::id entity_id, auto& cavity)
+		[&](entity::id entity_id, auto& cavity)
 		{
-			this->dig(cavity.position, cavity.radius);
+			edits.push_back({subterrain_edit::shape_type::sphere, subterrain_edit::operation_type::carve, cavity.position, cavity.position, cavity.radius, 0.0f});
+			this->dug_cavities.push_back(cavity);
 			this->registry.destroy(entity_id);
-
-			digging = true;
 		});
+	if (!edits.empty())
+		edit(edits);
+
+	if (dirty_chunks.empty())
+		return;
 	
-	if (digging)
+	// Regenerate chunks which were generated by a previous update but not yet uploaded
+	dirty_chunks.insert(chunk_keys.begin(), chunk_keys.end());
+
+	// Collect chunks modified by digging
+	chunk_keys.assign(dirty_chunks.begin(), dirty_chunks.end());
+	dirty_chunks.clear();
+	if (chunk_buffer_pool.size() < chunk_keys.size())
+		chunk_buffer_pool.resize(chunk_keys.size());
+
+	// March each chunk into its own buffers
+	auto generate = [this](std::size_t first, std::size_t last)
 	{
-		
-		//std::cout << "regenerating subterrain mesh...\n";
-		regenerate_subterrain_mesh();
-		//std::cout << "regenerating subterrain mesh... done\n";
+		debug::allocation_scope allocation_scope(debug::allocation_tag::subterrain);
+		for (std::size_t i = first; i < last; ++i)
+			generate_chunk(chunk_keys[i], chunk_buffer_pool[i]);
+	};
+	if (jobs)
+		jobs->parallel_for(0, chunk_keys.size(), 1, generate);
+	else
+		generate(0, chunk_keys.size());
+}
 
-		//std::cout << "regenerating subterrain model...\n";
-		regenerate_subterrain_model();
-		//std::cout << "regenerating subterrain model... done\n";
-	}
+void subterrain::upload_chunks()
+{
+	debug::allocation_scope allocation_scope(debug::allocation_tag::subterrain);
+	for (std::size_t i = 0; i < chunk_keys.size(); ++i)
+		upload_chunk(chunk_keys[i], chunk_buffer_pool[i]);
+	chunk_keys.clear();
 }
 
 void subterrain::set_scene(scene::collection* collection)
@@ -300,76 +329,274 @@ void subterrain::set_scene(scene::collection* collection)
 	this->collection = collection;
 }
 
-void subterrain::regenerate_subterrain_mesh()
+void subterrain::set_job_system(job_system* jobs)
 {
-	delete subterrain_mesh;
-	subterrain_mesh = new geom::mesh();
-	subterrain_vertices.clear();
-	subterrain_triangles.clear();
-	subterrain_vertex_map.clear();
-
-	//std::cout << "marching...\n";
-	merged = 0;
-	march(cube_tree);
-	//std::cout << "merged " << merged << " vertices\n";
-	//std::cout << "marching...done\n";
-
-	//std::cout << "vertex count: " << subterrain_vertices.size() << std::endl;
-	//std::cout << "triangle count: " << subterrain_triangles.size() << std::endl;
-
-	//std::cout << "creating mesh...\n";
-	create_triangle_mesh(*subterrain_mesh, subterrain_vertices, subterrain_triangles);
-	//std::cout << "creating mesh... done\n";
+	this->jobs = jobs;
 }
 
-void subterrain::march(entity::system::cube_tree* node)
+void subterrain::set_navmesh(ai::navmesh* navmesh)
 {
-	if (!node->is_leaf())
+	this->navmesh = navmesh;
+}
+
+geom::aabb<float> subterrain::get_chunk_bounds(std::uint64_t chunk_key) const
+{
+	std::uint64_t chunk[3];
+	geom::morton::decode<std::uint64_t>(chunk_key, chunk[0], chunk[1], chunk[2]);
+	
+	geom::aabb<float> bounds;
+	const float chunk_size = static_cast<float>(chunk_cell_count) * isosurface_resolution;
+	for (int i = 0; i < 3; ++i)
 	{
-		for (entity::system::cube_tree* child: node->children)
-			march(child);
-		return;
+		bounds.min_point[i] = subterrain_bounds.min_point[i] + static_cast<float>(chunk[i]) * chunk_size;
+		bounds.max_point[i] = bounds.min_point[i] + chunk_size;
 	}
-	else if (node->depth != node->max_depth)
+	
+	return bounds;
+}
+
+subterrain::subterrain_chunk* subterrain::create_chunk(const geom::aabb<float>& bounds)
+{
+	subterrain_chunk* chunk = new subterrain_chunk();
+	chunk->navmesh_section = ai::navmesh::invalid_index;
+
+	// Allocate chunk model
+	chunk->model = new model();
+
+	// Create inside model group
+	chunk->inside_group = chunk->model->add_group("inside");
+	chunk->inside_group->set_material(subterrain_inside_material);
+	chunk->inside_group->set_drawing_mode(gl::drawing_mode::triangles);
+	chunk->inside_group->set_start_index(0);
+	chunk->inside_group->set_index_count(0);
+
+	// Create outside model group
+	chunk->outside_group = chunk->model->add_group("outside");
+	chunk->outside_group->set_material(subterrain_outside_material);
+	chunk->outside_group->set_drawing_mode(gl::drawing_mode::triangles);
+	chunk->outside_group->set_start_index(0);
+	chunk->outside_group->set_index_count(0);
+
+	// Bind vertex attributes
+	gl::vertex_buffer* vbo = chunk->model->get_vertex_buffer();
+	gl::vertex_array* vao = chunk->model->get_vertex_array();
+	std::size_t offset = 0;
+	vao->bind_attribute(VERTEX_POSITION_LOCATION, *vbo, 3, gl::vertex_attribute_type::float_32, subterrain_model_vertex_stride, offset);
+	offset += sizeof(float) * 3;
+	vao->bind_attribute(VERTEX_NORMAL_LOCATION, *vbo, 4, gl::vertex_attribute_type::int_2_10_10_10_rev, subterrain_model_vertex_stride, offset, true);
+	offset += sizeof(std::uint32_t);
+	vao->bind_attribute(VERTEX_BARYCENTRIC_LOCATION, *vbo, 3, gl::vertex_attribute_type::uint_8, subterrain_model_vertex_stride, offset, true);
+
+	// Set chunk model bounds
+	chunk->model->set_bounds(bounds);
+
+	// Add chunk model instance to the scene
+	chunk->model_instance = new scene::model_instance(chunk->model);
+	if (collection)
+		collection->add_object(chunk->model_instance);
+
+	return chunk;
+}
+
+void subterrain::generate_chunk(std::uint64_t chunk_key, chunk_buffers& buffers) const
+{
+	buffers.vertices.clear();
+	buffers.triangles.clear();
+	buffers.border_triangles.clear();
+	buffers.vertex_map.clear();
+
+	// Determine the cubes of the chunk, and the cubes bordering it, which share the vertices on the chunk's faces
+	std::uint64_t chunk[3];
+	geom::morton::decode<std::uint64_t>(chunk_key, chunk[0], chunk[1], chunk[2]);
+	std::uint32_t chunk_min[3];
+	std::uint32_t cell_min[3];
+	std::uint32_t cell_max[3];
+	std::uint32_t lattice_size[3];
+	for (int i = 0; i < 3; ++i)
 	{
-		return;
+		chunk_min[i] = static_cast<std::uint32_t>(chunk[i]) * chunk_cell_count;
+		cell_min[i] = (chunk_min[i]) ? chunk_min[i] - 1 : 0;
+		cell_max[i] = std::min(chunk_min[i] + chunk_cell_count + 1, cell_count);
+		lattice_size[i] = cell_max[i] - cell_min[i] + 1;
+	}
+
+	// Gather the distances of the lattice points at the corners of those cubes, brick by brick
+	buffers.distances.resize(static_cast<std::size_t>(lattice_size[0]) * lattice_size[1] * lattice_size[2]);
+	distance_field->gather(cell_min, lattice_size, buffers.distances.data());
+	
+	// Offsets of the corners of a cube in the gathered distances, in the corner order of marching cubes
+	const std::size_t row_stride = lattice_size[0];
+	const std::size_t slice_stride = row_stride * lattice_size[1];
+	std::size_t corner_offsets[8];
+	for (int i = 0; i < 8; ++i)
+	{
+		corner_offsets[i] =
+			static_cast<std::size_t>(geom::mc::unit_cube[i][0]) +
+			static_cast<std::size_t>(geom::mc::unit_cube[i][1]) * row_stride +
+			static_cast<std::size_t>(geom::mc::unit_cube[i][2]) * slice_stride;
+	}
+
+	std::uint32_t cell[3];
+	for (cell[2] = cell_min[2]; cell[2] < cell_max[2]; ++cell[2])
+	for (cell[1] = cell_min[1]; cell[1] < cell_max[1]; ++cell[1])
+	for (cell[0] = cell_min[0]; cell[0] < cell_max[0]; ++cell[0])
+	{
+		const std::int8_t* corner_distances = buffers.distances.data() +
+			(cell[2] - cell_min[2]) * slice_stride +
+			(cell[1] - cell_min[1]) * row_stride +
+			(cell[0] - cell_min[0]);
+		
+		// Skip cubes which the isosurface doesn't cross
+		int negative_count = 0;
+		for (std::size_t offset: corner_offsets)
+			negative_count += (corner_distances[offset] < 0);
+		if (negative_count == 0 || negative_count == 8)
+			continue;
+		
+		float distances[8];
+		for (int i = 0; i < 8; ++i)
+			distances[i] = distance_field->dequantize(corner_distances[corner_offsets[i]]);
+		
+		// Cubes outside of the chunk only contribute to vertex normals
+		bool inside = true;
+		for (int i = 0; i < 3; ++i)
+			inside = inside && cell[i] >= chunk_min[i] && cell[i] < chunk_min[i] + chunk_cell_count;
+
+		march(cell, distances, buffers, (inside) ? buffers.triangles : buffers.border_triangles);
 	}
 
-	// Get node bounds
-	const geom::aabb<float>& bounds = node->get_bounds();
+	// Calculate vertex normals from the area-weighted normals of all adjacent faces
+	buffers.normals.assign(buffers.vertices.size(), float3{0, 0, 0});
+	if (!buffers.vertices.empty())
+	{
+		const float3& origin = buffers.vertices.front();
+		for (const auto* triangles: {&buffers.triangles, &buffers.border_triangles})
+			geom::accumulate_vertex_normals(buffers.normals.data(), &origin.x, &origin.y, &origin.z, 3, triangles->data()->data(), triangles->size());
+	}
+
+	// Pack normals once per welded vertex rather than once per triangle corner
+	std::vector<std::uint32_t>& packed_normals = buffers.packed_normals;
+	packed_normals.resize(buffers.normals.size());
+	for (std::size_t i = 0; i < buffers.normals.size(); ++i)
+	{
+		const float3 n = math::normalize(buffers.normals[i]);
+		packed_normals[i] = gl::pack_snorm_2_10_10_10(n.x, n.y, n.z, 0.0f);
+	}
+	
+	static const std::uint8_t barycentric_coords[3][4] =
+	{
+		{255, 0, 0, 0},
+		{0, 255, 0, 0},
+		{0, 0, 255, 0}
+	};
 
+	buffers.vertex_data.resize(subterrain_model_vertex_stride * buffers.triangles.size() * 3);
+	std::uint8_t* v = buffers.vertex_data.data();
+	for (const auto& triangle: buffers.triangles)
+	{
+		for (std::size_t j = 0; j < 3; ++j)
+		{
+			std::memcpy(v, &buffers.vertices[triangle[j]], sizeof(float) * 3);
+			std::memcpy(v + sizeof(float) * 3, &packed_normals[triangle[j]], sizeof(std::uint32_t));
+			std::memcpy(v + sizeof(float) * 3 + sizeof(std::uint32_t), barycentric_coords[j], 4);
+			v += subterrain_model_vertex_stride;
+		}
+	}
+}
+
+void subterrain::upload_chunk(std::uint64_t chunk_key, const chunk_buffers& buffers)
+{
+	// Find or create chunk
+	subterrain_chunk* chunk;
+	if (auto it = chunks.find(chunk_key); it != chunks.end())
+	{
+		chunk = it->second;
+	}
+	else
+	{
+		chunk = create_chunk(get_chunk_bounds(chunk_key));
+		chunks[chunk_key] = chunk;
+	}
+
+	// Resize chunk VBO and upload vertex data
+	gl::vertex_buffer* vbo = chunk->model->get_vertex_buffer();
+	vbo->resize(buffers.triangles.size() * 3 * subterrain_model_vertex_stride, buffers.vertex_data.data());
+
+	// Track the triangles of all chunks, by the change in this chunk's triangles
+	static debug::gauge triangle_gauge("subterrain.triangles");
+	triangle_gauge.add(static_cast<std::int64_t>(buffers.triangles.size()) - static_cast<std::int64_t>(chunk->inside_group->get_index_count() / 3));
+	
+	// Update model groups
+	chunk->inside_group->set_index_count(buffers.triangles.size() * 3);
+	chunk->outside_group->set_index_count(buffers.triangles.size() * 3);
+
+	// Hide chunks without surface
+	chunk->model_instance->set_active(!buffers.triangles.empty());
+	
+	// Replace the chunk's triangles in the navigation mesh, as the surface along tunnel walls is walkable
+	if (navmesh)
+	{
+		if (chunk->navmesh_section != ai::navmesh::invalid_index)
+			navmesh->remove_section(chunk->navmesh_section);
+		chunk->navmesh_section = ai::navmesh::invalid_index;
+		if (!buffers.triangles.empty())
+			chunk->navmesh_section = navmesh->add_triangles(buffers.vertices.data()->data(), 3, buffers.triangles.data()->data(), buffers.triangles.size());
+	}
+}
+
+void subterrain::march(const std::uint32_t cell[3], const float distances[8], chunk_buffers& buffers, std::vector<std::array<std::uint32_t, 3>>& triangles) const
+{
+	// Determine corner positions of the cube
+	float corners[8 * 3];
+	for (int i = 0; i < 8; ++i)
+		for (int j = 0; j < 3; ++j)
+			corners[i * 3 + j] = subterrain_bounds.min_point[j] + static_cast<float>(cell[j] + static_cast<std::uint32_t>(geom::mc::unit_cube[i][j])) * isosurface_resolution;
+	
 	// Polygonize cube
 	float vertex_buffer[12 * 3];
 	std::uint_fast8_t vertex_count;
 	std::int_fast8_t triangle_buffer[5 * 3];
 	std::uint_fast8_t triangle_count;
-	const float* corners = &node->corners[0][0];
-	const float* distances = &node->distances[0];
-	geom::mc::polygonize(vertex_buffer, &vertex_count, triangle_buffer, &triangle_count, corners, distances);
+	std::uint_fast8_t vertex_edges[12];
+	geom::mc::polygonize(vertex_buffer, &vertex_count, triangle_buffer, &triangle_count, corners, distances, vertex_edges);
 
-	// Remap local vertex buffer indices (0-11) to mesh vertex indices
-	std::uint_fast32_t vertex_remap[12];
+	// Lattice coordinates of the cube's minimum corner
+	const std::uint64_t cube_lattice[3] = {cell[0], cell[1], cell[2]};
+
+	// Remap local vertex buffer indices (0-11) to chunk vertex indices, welding vertices shared with previously marched cubes
+	std::uint32_t vertex_remap[12];
 	for (int i = 0; i < vertex_count; ++i)
 	{
-		const float3& vertex = reinterpret_cast<const float3&>(vertex_buffer[i * 3]);
+		// Find the lower corner and axis of the vertex's edge
+		const std::uint_fast8_t* edge = geom::mc::edge_vertices[vertex_edges[i]];
+		const float* a = geom::mc::unit_cube[edge[0]];
+		const float* b = geom::mc::unit_cube[edge[1]];
+		std::uint64_t lattice[3];
+		std::uint64_t axis = 0;
+		for (int j = 0; j < 3; ++j)
+		{
+			lattice[j] = cube_lattice[j] + static_cast<std::uint64_t>(std::min(a[j], b[j]));
+			if (a[j] != b[j])
+				axis = j;
+		}
+		const std::uint64_t key = (geom::morton::encode<std::uint64_t>(lattice[0], lattice[1], lattice[2]) << 2) | axis;
 
-		if (auto it = subterrain_vertex_map.find(vertex); it != subterrain_vertex_map.end())
+		if (auto it = buffers.vertex_map.find(key); it != buffers.vertex_map.end())
 		{
 			vertex_remap[i] = it->second;
-			++merged;
 		}
 		else
 		{
-			vertex_remap[i] = subterrain_vertices.size();
-			subterrain_vertex_map[vertex] = subterrain_vertices.size();
-			subterrain_vertices.push_back(vertex);
+			vertex_remap[i] = static_cast<std::uint32_t>(buffers.vertices.size());
+			buffers.vertex_map[key] = buffers.vertices.size();
+			buffers.vertices.push_back(reinterpret_cast<const float3&>(vertex_buffer[i * 3]));
 		}
 	}
 
 	// Add triangles
 	for (std::uint_fast32_t i = 0; i < triangle_count; ++i)
 	{
-		subterrain_triangles.push_back(
+		triangles.push_back(
 			{
 				vertex_remap[triangle_buffer[i * 3]],
 				vertex_remap[triangle_buffer[i * 3 + 1]],
@@ -378,108 +605,246 @@ void subterrain::march(entity::system::cube_tree* node)
 	}
 }
 
-void subterrain::regenerate_subterrain_model()
+void subterrain::edit(const std::vector<subterrain_edit>& edits)
 {
-	float3* face_normals = new float3[subterrain_mesh->get_faces().size()];
-	calculate_face_normals(face_normals, *subterrain_mesh);
-
-	static const float3 barycentric_coords[3] =
+	// Find the bricks near each edit, and mark the chunks they affect for regeneration
+	std::unordered_map<std::uint64_t, std::vector<std::uint32_t>> brick_edits;
+	for (std::uint32_t i = 0; i < static_cast<std::uint32_t>(edits.size()); ++i)
 	{
-		float3{1, 0, 0},
-		float3{0, 1, 0},
-		float3{0, 0, 1}
-	};
-
-	float* vertex_data = new float[subterrain_model_vertex_size * subterrain_mesh->get_faces().size() * 3];
-	float* v = vertex_data;
-	for (std::size_t i = 0; i < subterrain_mesh->get_faces().size(); ++i)
+		const subterrain_edit& edit = edits[i];
+		
+		// Find the bounds of the edit's primitive
+		float3 min = edit.a;
+		float3 max = (edit.shape == subterrain_edit::shape_type::capsule) ? edit.b : edit.a;
+		const float3 extents =
+		{
+			edit.radius,
+			(edit.shape == subterrain_edit::shape_type::cylinder) ? edit.half_height : edit.radius,
+			edit.radius
+		};
+		for (int j = 0; j < 3; ++j)
+		{
+			if (min[j] > max[j])
+				std::swap(min[j], max[j]);
+			min[j] -= extents[j];
+			max[j] += extents[j];
+		}
+		const geom::aabb<float> bounds = {min, max};
+		
+		std::uint32_t lattice_min[3];
+		std::uint32_t lattice_max[3];
+		if (!get_lattice_bounds(bounds, lattice_min, lattice_max))
+			continue;
+		
+		for (std::uint32_t z = lattice_min[2] >> brick_map::brick_size_exponent; z <= lattice_max[2] >> brick_map::brick_size_exponent; ++z)
+			for (std::uint32_t y = lattice_min[1] >> brick_map::brick_size_exponent; y <= lattice_max[1] >> brick_map::brick_size_exponent; ++y)
+				for (std::uint32_t x = lattice_min[0] >> brick_map::brick_size_exponent; x <= lattice_max[0] >> brick_map::brick_size_exponent; ++x)
+					brick_edits[geom::morton::encode<std::uint64_t>(x, y, z)].push_back(i);
+		
+		mark_dirty_chunks(lattice_min, lattice_max);
+	}
+	
+	if (brick_edits.empty())
+		return;
+	
+	std::vector<std::uint64_t> brick_keys;
+	std::vector<const std::vector<std::uint32_t>*> brick_edit_lists;
+	brick_keys.reserve(brick_edits.size());
+	brick_edit_lists.reserve(brick_edits.size());
+	for (const auto& brick_edit: brick_edits)
 	{
-		geom::mesh::face* face = subterrain_mesh->get_faces()[i];
-		geom::mesh::edge* ab = face->edge;
-		geom::mesh::edge* bc = face->edge->next;
-		geom::mesh::edge* ca = face->edge->previous;
-		geom::mesh::vertex* a = ab->vertex;
-		geom::mesh::vertex* b = bc->vertex;
-		geom::mesh::vertex* c = ca->vertex;
-		geom::mesh::vertex* vertices[3] = {a, b, c};
-
-		for (std::size_t j = 0; j < 3; ++j)
+		brick_keys.push_back(brick_edit.first);
+		brick_edit_lists.push_back(&brick_edit.second);
+	}
+	
+	// Evaluate the primitives of the edits which overlap each brick over all of its lattice points at once
+	distance_field->edit(brick_keys, jobs,
+		[&](std::size_t index, const std::uint32_t brick_min[3], float* distances)
 		{
-			geom::mesh::vertex* vertex = vertices[j];
-
-			float3 n = {0, 0, 0};
-			geom::mesh::edge* start = vertex->edge;
-			geom::mesh::edge* edge = start;
-			do
+			constexpr std::size_t n = brick_map::brick_volume;
+			float x[n];
+			float y[n];
+			float z[n];
+			float d[n];
+			
+			for (std::uint32_t k = 0, i = 0; k < brick_map::brick_size; ++k)
+				for (std::uint32_t j = 0; j < brick_map::brick_size; ++j)
+					for (std::uint32_t l = 0; l < brick_map::brick_size; ++l, ++i)
+					{
+						x[i] = subterrain_bounds.min_point.x + static_cast<float>(brick_min[0] + l) * isosurface_resolution;
+						y[i] = subterrain_bounds.min_point.y + static_cast<float>(brick_min[1] + j) * isosurface_resolution;
+						z[i] = subterrain_bounds.min_point.z + static_cast<float>(brick_min[2] + k) * isosurface_resolution;
+					}
+			const math::vector3_soa<const float> points = {x, y, z};
+			
+			for (std::uint32_t edit_index: *brick_edit_lists[index])
 			{
-				if (edge->face)
+				const subterrain_edit& edit = edits[edit_index];
+				switch (edit.shape)
 				{
-					n += face_normals[edge->face->index];
+					case subterrain_edit::shape_type::sphere:
+						geom::sdf::sphere_n(points, edit.a, edit.radius, d, n);
+						break;
+					
+					case subterrain_edit::shape_type::capsule:
+						geom::sdf::capsule_n(points, edit.a, edit.b, edit.radius, d, n);
+						break;
+					
+					case subterrain_edit::shape_type::cylinder:
+						geom::sdf::cylinder_n(points, edit.a, edit.radius, edit.half_height, d, n);
+						break;
 				}
-
-				edge = edge->previous->symmetric;
+				
+				// Distances are positive in cavities and negative in the solid
+				if (edit.operation == subterrain_edit::operation_type::carve)
+					geom::sdf::op_difference_n(d, distances, n);
+				else
+					geom::sdf::op_union_n(d, distances, n);
 			}
-			while (edge != start);
-			n = math::normalize(n);
+		});
+}
 
-			//float3 n = reinterpret_cast<const float3&>(face_normals[i * 3]);
+float subterrain::get_distance(const float3& point) const
+{
+	return sample(point, nullptr);
+}
 
-			*(v++) = vertex->position[0];
-			*(v++) = vertex->position[1];
-			*(v++) = vertex->position[2];
+float3 subterrain::get_gradient(const float3& point) const
+{
+	float3 gradient;
+	sample(point, &gradient);
+	
+	const float length = math::length(gradient);
+	return (length > 0.0f) ? gradient / length : float3{0.0f, 0.0f, 0.0f};
+}
 
-			*(v++) = n[0];
-			*(v++) = n[1];
-			*(v++) = n[2];
+float3 subterrain::get_closest_point(const float3& point) const
+{
+	float3 gradient;
+	const float distance = sample(point, &gradient);
+	
+	const float length = math::length(gradient);
+	return (length > 0.0f) ? point - gradient * (distance / length) : point;
+}
 
-			*(v++) = barycentric_coords[j][0];
-			*(v++) = barycentric_coords[j][1];
-			*(v++) = barycentric_coords[j][2];
+std::optional<float> subterrain::trace_ray(const geom::ray<float>& ray, float max_distance) const
+{
+	const auto [hit, t_enter, t_exit] = geom::ray_aabb_intersection(ray, subterrain_bounds);
+	if (!hit)
+		return std::nullopt;
+	
+	float t = std::max(0.0f, t_enter);
+	const float t_max = std::min(t_exit, max_distance);
+	if (t > t_max)
+		return std::nullopt;
+	
+	// Step by at least a fraction of the lattice resolution, so grazing rays make progress
+	const float min_step = isosurface_resolution * 0.125f;
+	const float epsilon = isosurface_resolution * 0.01f;
+	constexpr std::size_t max_steps = 256;
+	
+	float previous_t = t;
+	float previous_distance = 0.0f;
+	for (std::size_t i = 0; i < max_steps && t <= t_max; ++i)
+	{
+		const float distance = sample(ray.extrapolate(t), nullptr);
+		if (distance <= epsilon)
+		{
+			// Interpolate within the last step if it overshot the isosurface
+			if (i && distance < 0.0f)
+				t = previous_t + (t - previous_t) * previous_distance / (previous_distance - distance);
+			return (t <= t_max) ? std::optional<float>(t) : std::nullopt;
 		}
+		
+		previous_t = t;
+		previous_distance = distance;
+		t += std::max(distance, min_step);
 	}
-
-	// Resized VBO and upload vertex data
-	gl::vertex_buffer* vbo = subterrain_model->get_vertex_buffer();
-	vbo->resize(subterrain_mesh->get_faces().size() * 3 * subterrain_model_vertex_stride, vertex_data);
-
-	// Deallocate vertex data
-	delete[] face_normals;
-	delete[] vertex_data;
-
-	// Update model groups
-	subterrain_inside_group->set_index_count(subterrain_mesh->get_faces().size() * 3);
-	subterrain_outside_group->set_index_count(subterrain_mesh->get_faces().size() * 3);
+	
+	return std::nullopt;
 }
 
-void subterrain::dig(const float3& position, float radius)
+float subterrain::sample(const float3& point, float3* gradient) const
 {
-	// Construct region containing the cavity sphere
-	geom::aabb<float> region = {position, position};
+	// Find the cube containing the point, and the point's position within it
+	std::uint32_t cell[3];
+	float3 f;
 	for (int i = 0; i < 3; ++i)
 	{
-		region.min_point[i] -= radius + isosurface_resolution;
-		region.max_point[i] += radius + isosurface_resolution;
+		const float coordinate = (point[i] - subterrain_bounds.min_point[i]) / isosurface_resolution;
+		if (!(coordinate >= 0.0f && coordinate <= static_cast<float>(cell_count)))
+		{
+			if (gradient)
+				*gradient = {0.0f, 0.0f, 0.0f};
+			return distance_field->dequantize(brick_map::solid);
+		}
+		
+		cell[i] = std::min(static_cast<std::uint32_t>(coordinate), cell_count - 1);
+		f[i] = coordinate - static_cast<float>(cell[i]);
 	}
-
-	// Subdivide the octree to the maximum depth within the region
-	cube_tree->subdivide_max(region);
-
-	// Query all octree leaf nodes within the region
-	std::list<entity::system::cube_tree*> nodes;
-	cube_tree->visit_leaves(region,
-		[&position, radius](entity::system::cube_tree& node)
+	
+	// Gather and dequantize the distances of the cube's corners, with x varying fastest
+	static const std::uint32_t size[3] = {2, 2, 2};
+	std::int8_t quantized_distances[8];
+	distance_field->gather(cell, size, quantized_distances);
+	float d[8];
+	for (int i = 0; i < 8; ++i)
+		d[i] = distance_field->dequantize(quantized_distances[i]);
+	
+	// Interpolate along x, then y, then z
+	const float d00 = d[0] + (d[1] - d[0]) * f.x;
+	const float d10 = d[2] + (d[3] - d[2]) * f.x;
+	const float d01 = d[4] + (d[5] - d[4]) * f.x;
+	const float d11 = d[6] + (d[7] - d[6]) * f.x;
+	const float d0 = d00 + (d10 - d00) * f.y;
+	const float d1 = d01 + (d11 - d01) * f.y;
+	
+	if (gradient)
+	{
+		const float dx0 = (d[1] - d[0]) + ((d[3] - d[2]) - (d[1] - d[0])) * f.y;
+		const float dx1 = (d[5] - d[4]) + ((d[7] - d[6]) - (d[5] - d[4])) * f.y;
+		*gradient = float3
 		{
-			for (int i = 0; i < 8; ++i)
-			{
-				// For outside normals (also set node initial distance to +infinity)
-				//float distance = math::length(node->corners[i] - position) - radius;
-				// if (distance < node->distances[i])
+			dx0 + (dx1 - dx0) * f.z,
+			(d10 - d00) + ((d11 - d01) - (d10 - d00)) * f.z,
+			d1 - d0
+		} / isosurface_resolution;
+	}
+	
+	return d0 + (d1 - d0) * f.z;
+}
 
-				float distance = radius - math::length(node.corners[i] - position);
-				if (distance > node.distances[i])
-					node.distances[i] = distance;
-			}
-		});
+bool subterrain::get_lattice_bounds(const geom::aabb<float>& bounds, std::uint32_t lattice_min[3], std::uint32_t lattice_max[3]) const
+{
+	// Include a margin of one lattice point, as the distances of lattice points just outside of the region may change
+	for (int i = 0; i < 3; ++i)
+	{
+		const float min = (bounds.min_point[i] - isosurface_resolution - subterrain_bounds.min_point[i]) / isosurface_resolution;
+		const float max = (bounds.max_point[i] + isosurface_resolution - subterrain_bounds.min_point[i]) / isosurface_resolution;
+		if (max < 0.0f || min > static_cast<float>(cell_count))
+			return false;
+		
+		lattice_min[i] = static_cast<std::uint32_t>(std::max(0.0f, std::floor(min)));
+		lattice_max[i] = static_cast<std::uint32_t>(std::min(static_cast<float>(cell_count), std::ceil(max)));
+	}
+	
+	return true;
+}
+
+void subterrain::mark_dirty_chunks(const std::uint32_t lattice_min[3], const std::uint32_t lattice_max[3])
+{
+	// Include the chunks whose border cubes contribute to vertex normals near the modified lattice points
+	std::uint32_t chunk_min[3];
+	std::uint32_t chunk_max[3];
+	for (int i = 0; i < 3; ++i)
+	{
+		chunk_min[i] = ((lattice_min[i] > 1) ? lattice_min[i] - 2 : 0) / chunk_cell_count;
+		chunk_max[i] = std::min(lattice_max[i] + 1, cell_count - 1) / chunk_cell_count;
+	}
+	for (std::uint32_t z = chunk_min[2]; z <= chunk_max[2]; ++z)
+		for (std::uint32_t y = chunk_min[1]; y <= chunk_max[1]; ++y)
+			for (std::uint32_t x = chunk_min[0]; x <= chunk_max[0]; ++x)
+				dirty_chunks.insert(geom::morton::encode<std::uint64_t>(x, y, z));
 }
 
 } // namespace system
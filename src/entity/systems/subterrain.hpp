@@ -21,14 +21,22 @@
 #define ANTKEEPER_ENTITY_SYSTEM_SUBTERRAIN_HPP
 
 #include "entity/systems/updatable.hpp"
-#include "geom/mesh.hpp"
+#include "entity/components/cavity.hpp"
 #include "geom/aabb.hpp"
+#include "geom/ray.hpp"
 #include "scene/collection.hpp"
 #include "scene/model-instance.hpp"
 #include "utility/fundamental-types.hpp"
+#include <array>
+#include <cstdint>
+#include <optional>
 #include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 class resource_manager;
+class job_system;
+namespace ai { class navmesh; }
 class model;
 class model_group;
 class material;
@@ -36,56 +44,49 @@ class material;
 namespace entity {
 namespace system {
 
-struct cube_tree;
+struct brick_map;
 
-template <std::int64_t Mantissa, std::int64_t Exponent>
-struct epsilon
+/// Signed distance field primitive which carves or fills a region of the subterrain volume.
+struct subterrain_edit
 {
-	static const double value;
-};
-
-template <std::int64_t Mantissa, std::int64_t Exponent>
-const double epsilon<Mantissa, Exponent>::value = static_cast<double>(Mantissa) * std::pow(10.0, Exponent);
-
-typedef epsilon<1, -5> epsilon_1en5;
-
-template <class Epsilon, class T, std::size_t N>
-struct vector_hasher
-{
-	typedef math::vector<T, N> vector_type;
-
-	std::size_t operator()(const vector_type& v) const noexcept
+	enum class shape_type
 	{
-		static const T inverse_epsilon = T(1) / Epsilon::value;
-
-		std::size_t hash = 0;
-		for (std::size_t i = 0; i < N; ++i)
-		{
-			std::int64_t j = static_cast<std::int64_t>(v[i] * inverse_epsilon);
-			hash ^= std::hash<std::int64_t>()(j) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
-		}
-
-		return hash;
-	}
-};
-
-template <class Epsilon, class T, std::size_t N>
-struct vector_equals
-{
-	typedef math::vector<T, N> vector_type;
-
-	bool operator()(const vector_type& a, const vector_type& b) const noexcept
+		/// Sphere centered on `a`.
+		sphere,
+		
+		/// Capsule around the segment from `a` to `b`.
+		capsule,
+		
+		/// Cylinder aligned with the y-axis, centered on `a`, and extending `half_height` above and below it.
+		cylinder
+	};
+	
+	enum class operation_type
 	{
-		for (std::size_t i = 0; i < N; ++i)
-		{
-			if (std::fabs(b[i] - a[i]) >= Epsilon::value)
-				return false;
-		}
-
-		return true;
-	}
+		/// Removes the primitive's volume from the solid.
+		carve,
+		
+		/// Adds the primitive's volume to the solid.
+		fill
+	};
+	
+	shape_type shape;
+	operation_type operation;
+	float3 a;
+	float3 b;
+	float radius;
+	float half_height;
 };
 
+/**
+ * Carves cavities into a marching cubes isosurface.
+ *
+ * The isosurface is extracted from a sparse signed distance field, which holds quantized distances only in bricks of lattice points near the surface. It is divided into chunks of cubes, each with its own model. The field is modified by batches of edits, whose primitives are evaluated over each affected brick at once, using SIMD instructions and in parallel on the job system. Digging re-marches and re-uploads only the chunks near each cavity, so the cost of digging depends on the size of the cavity rather than the size of the nest. Modified chunks are marched in parallel if a job system has been set, each into its own buffers, then uploaded by upload_chunks(). As the system may be updated on any thread, it makes no OpenGL calls while updating.
+ *
+ * Collision and picking query the distance field directly, by trilinear interpolation of the lattice points around each query point, so digging never requires a collision structure to be rebuilt. Queries must not be made while the distance field is being edited.
+ *
+ * Polygonization runs on the CPU, as GPU marching cubes would require compute shaders, shader storage buffers, and indirect draws, none of which are available in the OpenGL 3.3 core context targeted by the renderer.
+ */
 class subterrain: public updatable
 {
 public:
@@ -94,41 +95,185 @@ public:
 	virtual void update(double t, double dt);
 	
 	void set_scene(scene::collection* collection);
+	
+	/**
+	 * Sets the job system on which modified chunks are marched in parallel.
+	 *
+	 * @param jobs Job system, or `nullptr` to march chunks on the updating thread.
+	 */
+	void set_job_system(job_system* jobs);
+	
+	/**
+	 * Sets the navigation mesh to which the triangles of each chunk are added as they are uploaded, replacing the chunk's previous triangles.
+	 *
+	 * @param navmesh Navigation mesh, or `nullptr`.
+	 */
+	void set_navmesh(ai::navmesh* navmesh);
+	
+	/**
+	 * Carves or fills the distance field with a batch of signed distance field primitives, and marks the chunks they modify for regeneration by the next update. Must not be called while the system is updating.
+	 *
+	 * @param edits Edits to apply, in order. Later edits are applied on top of earlier edits, so a fill may be carved again by an edit which follows it.
+	 */
+	void edit(const std::vector<subterrain_edit>& edits);
+	
+	/**
+	 * Uploads the chunks regenerated by the most recent update to the GPU, creating their models if necessary. Must be called by the thread which owns the OpenGL context, while the system is not updating.
+	 */
+	void upload_chunks();
+	
+	/**
+	 * Returns the signed distance from a point to the isosurface, interpolated from the distance field. Distances are positive in cavities and negative in the solid, and are clamped to within about four lattice points of the isosurface. Points outside of the subterrain bounds are solid.
+	 *
+	 * @param point Point to query.
+	 * @return Signed distance to the isosurface.
+	 */
+	float get_distance(const float3& point) const;
+	
+	/**
+	 * Returns the normalized gradient of the distance field at a point, which points away from the solid and matches the surface normal near the isosurface.
+	 *
+	 * @param point Point to query.
+	 * @return Normalized gradient, or a zero vector where the distance field is flat, such as deep within the solid.
+	 */
+	float3 get_gradient(const float3& point) const;
+	
+	/**
+	 * Finds the point on the isosurface closest to a point within a few lattice points of it, by stepping down the gradient by the point's distance.
+	 *
+	 * @param point Point to query.
+	 * @return Closest point on the isosurface, or @p point itself where the distance field is flat.
+	 */
+	float3 get_closest_point(const float3& point) const;
+	
+	/**
+	 * Finds the first intersection of a ray with the solid, by sphere tracing the distance field from where the ray enters the subterrain bounds.
+	 *
+	 * @param ray Ray to trace, with a normalized direction.
+	 * @param max_distance Distance along the ray beyond which intersections are ignored.
+	 * @return Distance along the ray to the intersection, or `std::nullopt` if the ray doesn't hit the solid within the maximum distance. Rays which start within the solid hit it where they enter the bounds.
+	 */
+	std::optional<float> trace_ray(const geom::ray<float>& ray, float max_distance) const;
+	
+	/// Returns every cavity dug so far, in the order in which they were dug, from which the isosurface can be reproduced by digging them again.
+	const std::vector<component::cavity>& get_dug_cavities() const;
 
 private:
-	void regenerate_subterrain_mesh();
-	void march(cube_tree* node);
-	void regenerate_subterrain_model();
-	void dig(const float3&position, float radius);
-	float distance(const cube_tree& node, const float3& sample) const;
+	/// Isosurface chunk, with its own model covering a cube of cubes.
+	struct subterrain_chunk
+	{
+		model* model;
+		model_group* inside_group;
+		model_group* outside_group;
+		scene::model_instance* model_instance;
+		
+		/// Navigation mesh section of the chunk's triangles.
+		std::uint32_t navmesh_section;
+	};
+	
+	/// Buffers into which a single chunk is marched, reused across updates.
+	struct chunk_buffers
+	{
+		std::vector<float3> vertices;
+		std::vector<float3> normals;
+		std::vector<std::uint32_t> packed_normals;
+		std::vector<std::array<std::uint32_t, 3>> triangles;
+		std::vector<std::array<std::uint32_t, 3>> border_triangles;
+		std::vector<std::uint8_t> vertex_data;
+		
+		/// Quantized distances of the lattice points of the chunk's cubes and bordering cubes, with x varying fastest.
+		std::vector<std::int8_t> distances;
+		
+		/// Map from lattice edge keys to the indices of the vertices on them, by which vertices shared between cubes are welded.
+		std::unordered_map<std::uint64_t, std::uint_fast32_t> vertex_map;
+	};
+	
+	/// Marches the cubes of a chunk and fills its buffers with interleaved vertex data. Safe to call concurrently for different chunks.
+	void generate_chunk(std::uint64_t chunk_key, chunk_buffers& buffers) const;
+	
+	/// Uploads the generated vertex data of a chunk to its model, creating the chunk if necessary.
+	void upload_chunk(std::uint64_t chunk_key, const chunk_buffers& buffers);
+	
+	/**
+	 * Polygonizes a cube.
+	 *
+	 * Vertices are welded by the lattice edges on which they lie, each keyed by the Morton code of the edge's lower lattice point and the axis along which it extends.
+	 *
+	 * @param cell Lattice coordinates of the cube's minimum corner.
+	 * @param distances Distances of the cube's corners.
+	 * @param buffers Chunk buffers into which vertices are welded.
+	 * @param triangles List of triangles to which the cube's triangles will be added.
+	 */
+	void march(const std::uint32_t cell[3], const float distances[8], chunk_buffers& buffers, std::vector<std::array<std::uint32_t, 3>>& triangles) const;
+	
+	/**
+	 * Interpolates the distance field at a point.
+	 *
+	 * @param point Point to query.
+	 * @param[out] gradient Unnormalized gradient of the distance field at the point, or `nullptr`.
+	 * @return Signed distance to the isosurface.
+	 */
+	float sample(const float3& point, float3* gradient) const;
+	
+	/// Returns the bounds of a chunk.
+	geom::aabb<float> get_chunk_bounds(std::uint64_t chunk_key) const;
+	
+	/// Allocates the model and model instance of a chunk.
+	subterrain_chunk* create_chunk(const geom::aabb<float>& bounds);
+	
+	/**
+	 * Finds the box of lattice points which overlap a region.
+	 *
+	 * @param bounds Region of the isosurface.
+	 * @param[out] lattice_min Coordinates of the lattice point at the minimum corner of the box.
+	 * @param[out] lattice_max Coordinates of the lattice point at the maximum corner of the box, inclusive.
+	 * @return `true` if the region overlaps the lattice, `false` otherwise.
+	 */
+	bool get_lattice_bounds(const geom::aabb<float>& bounds, std::uint32_t lattice_min[3], std::uint32_t lattice_max[3]) const;
+	
+	/// Marks the chunks affected by modifying a box of lattice points for regeneration.
+	void mark_dirty_chunks(const std::uint32_t lattice_min[3], const std::uint32_t lattice_max[3]);
 
 	resource_manager* resource_manager;
-	geom::mesh* subterrain_mesh;
-	model* subterrain_model;
 	material* subterrain_inside_material;
 	material* subterrain_outside_material;
-	model_group* subterrain_inside_group;
-	model_group* subterrain_outside_group;
-	int subterrain_model_vertex_size;
 	int subterrain_model_vertex_stride;
 	geom::aabb<float> subterrain_bounds;
-	cube_tree* cube_tree;
-	std::vector<float3> subterrain_vertices;
-	std::vector<std::array<std::uint_fast32_t, 3>> subterrain_triangles;
+	brick_map* distance_field;
 	float isosurface_resolution;
-	bool first_run;
-	int merged;
-
-	std::unordered_map<
-		float3,
-		std::uint_fast32_t,
-		vector_hasher<epsilon_1en5, float, 3>,
-		vector_equals<epsilon_1en5, float, 3>> subterrain_vertex_map;
+	
+	/// Number of cubes along each axis of the isosurface.
+	std::uint32_t cell_count;
+	
+	/// Number of cubes along each axis of a chunk.
+	std::uint32_t chunk_cell_count;
+	
+	/// Maximum number of cubes along each axis of a chunk, as a power of two.
+	static constexpr int chunk_size_exponent = 5;
+	
+	/// Chunks, keyed by the Morton codes of their chunk coordinates.
+	std::unordered_map<std::uint64_t, subterrain_chunk*> chunks;
+	
+	/// Keys of the chunks which must be regenerated.
+	std::unordered_set<std::uint64_t> dirty_chunks;
+	
+	job_system* jobs;
+	ai::navmesh* navmesh;
+	
+	/// Keys of the regenerated chunks awaiting upload, in the order of their buffers in the chunk buffer pool.
+	std::vector<std::uint64_t> chunk_keys;
+	std::vector<chunk_buffers> chunk_buffer_pool;
 	
 	scene::collection* collection;
-	scene::model_instance* subterrain_model_instance;
+	
+	std::vector<component::cavity> dug_cavities;
 };
 
+inline const std::vector<component::cavity>& subterrain::get_dug_cavities() const
+{
+	return dug_cavities;
+}
+
 } // namespace system
 } // namespace entity
 
@@ -21,16 +21,24 @@
 #include "entity/components/celestial-body.hpp"
 #include "entity/components/observer.hpp"
 #include "entity/components/terrain.hpp"
-#include "geom/meshes/grid.hpp"
+#include "debug/allocation-tracker.hpp"
+#include "debug/counters.hpp"
+#include "debug/draw.hpp"
 #include "geom/mesh-functions.hpp"
 #include "geom/morton.hpp"
 #include "geom/quadtree.hpp"
 #include "geom/spherical.hpp"
+#include "geom/vertex-cache.hpp"
+#include "geom/sphere.hpp"
 #include "gl/vertex-attribute-type.hpp"
+#include "gl/element-array-type.hpp"
 #include "math/constants.hpp"
 #include "math/quaternion-operators.hpp"
+#include "renderer/material-flags.hpp"
 #include "renderer/vertex-attributes.hpp"
+#include "resources/terrain-patch-cache.hpp"
 #include "utility/fundamental-types.hpp"
+#include <algorithm>
 #include <functional>
 #include <iostream>
 
@@ -40,12 +48,20 @@ namespace system {
 terrain::terrain(entity::registry& registry):
 	updatable(registry),
 	patch_subdivisions(0),
-	patch_base_mesh(nullptr),
+	patch_cells(0),
+	patch_index_buffer(nullptr),
 	patch_vertex_size(0),
 	patch_vertex_count(0),
-	patch_vertex_data(nullptr),
 	patch_scene_collection(nullptr),
-	max_error(0.0)
+	max_error(0.0),
+	jobs(nullptr),
+	patch_jobs_in_flight(0),
+	patch_upload_budget(4),
+	patch_memory_budget(256 * 1024 * 1024),
+	patch_cache(nullptr),
+	lod_hysteresis(0.25),
+	uploaded_patch_count(0),
+	update_count(0)
 {
 	// Build set of quaternions to rotate quadtree cube coordinates into BCBF space according to face index
 	face_rotations[0] = math::quaternion<double>::identity();                       // +x
@@ -68,10 +84,19 @@ terrain::terrain(entity::registry& registry):
 }
 
 terrain::~terrain()
-{}
+{
+	wait_for_patch_jobs();
+	
+	for (terrain_patch* patch: patch_pool)
+		free_patch(patch);
+	
+	delete patch_index_buffer;
+}
 
 void terrain::update(double t, double dt)
 {
+	debug::allocation_scope allocation_scope(debug::allocation_tag::terrain);
+	
 	// Refine the level of detail of each terrain quadsphere
 	registry.view<component::terrain, component::celestial_body>().each(
 	[&](entity::id terrain_eid, const auto& terrain_component, const auto& terrain_body)
@@ -79,7 +104,8 @@ void terrain::update(double t, double dt)
 		// Retrieve terrain quadsphere
 		terrain_quadsphere* quadsphere = terrain_quadspheres[terrain_eid];
 		
-		// For each observer
+		// Collect observers
+		observer_views.clear();
 		this->registry.view<component::observer>().each(
 		[&](entity::id observer_eid, const auto& observer)
 		{
@@ -88,109 +114,104 @@ void terrain::update(double t, double dt)
 				!this->registry.has<component::terrain>(observer.reference_body_eid))
 				return;
 			
-			// Get celestial body and terrain component of observer reference body
-			const auto& reference_celestial_body = this->registry.get<component::celestial_body>(observer.reference_body_eid);
-			const auto& reference_terrain = this->registry.get<component::terrain>(observer.reference_body_eid);
-			
 			// Calculate reference BCBF-space position of observer.
 			//double3 observer_spherical = {reference_celestial_body.radius + observer.elevation, observer.latitude, observer.longitude};
 			double3 observer_spherical = {observer.elevation, observer.latitude, observer.longitude};
 			double3 observer_cartesian = geom::spherical::to_cartesian(observer_spherical);
 			
-			observer_cartesian = math::type_cast<double>(observer.camera->get_translation());
+			observer_cartesian = observer.camera->get_world_translation();
 			
 			/// @TODO Transform observer position into BCBF space of terrain body (use orbit component?)
 			
-			// For each terrain quadsphere face
-			for (int i = 0; i < 6; ++i)
+			observer_views.push_back({observer_cartesian, static_cast<double>(observer.camera->get_fov()), observer.camera});
+		});
+		
+		// Without observers, keep the current level of detail
+		if (observer_views.empty())
+			return;
+		
+		// For each terrain quadsphere face
+		for (std::uint8_t i = 0; i < 6; ++i)
+		{
+			terrain_quadsphere_face& quadsphere_face = quadsphere->faces[i];
+			quadtree_type& quadtree = quadsphere_face.quadtree;
+			quadsphere_face.errors.clear();
+			
+			// Collect the leaves of the previous update
+			refinement_stack.clear();
+			quadtree.for_each_leaf([this](quadtree_node_type node) { refinement_stack.push_back(node); });
+			
+			// Merge sibling leaves whose parent has fallen below the merge threshold
+			const double merge_error = max_error * (1.0 - lod_hysteresis);
+			for (std::size_t j = 0; j < refinement_stack.size(); ++j)
 			{
-				terrain_quadsphere_face& quadsphere_face = quadsphere->faces[i];
-
-				// Get the quadsphere faces's quadtree
-				quadtree_type& quadtree = quadsphere_face.quadtree;
+				const quadtree_node_type node = refinement_stack[j];
+				
+				// Evaluate each parent once, from the leaf of its first child
+				if (node == quadtree_type::root || node != quadtree_type::child(quadtree_type::parent(node), 0))
+					continue;
 				
-				// Clear quadsphere face quadtree
-				quadtree.clear();
+				const quadtree_node_type parent = quadtree_type::parent(node);
 				
-				// For each node in the face quadtree
-				for (auto node_it = quadtree.begin(); node_it != quadtree.end(); ++node_it)
+				// Only merge parents whose children are all leaves
+				bool mergeable = true;
+				for (quadtree_type::node_type k = 1; k < 4 && mergeable; ++k)
+					mergeable = quadtree.is_leaf(quadtree_type::child(parent, k));
+				if (!mergeable)
+					continue;
+				
+				const float parent_error = node_error(i, parent, terrain_body.radius);
+				if (parent_error < merge_error)
 				{
-					quadtree_node_type node = *node_it;
-					
-					// Skip non leaf nodes
-					if (!quadtree.is_leaf(node))
-						continue;
-					
-					// Extract node depth
-					quadtree_type::node_type node_depth = quadtree_type::depth(node);
-					
-					// Skip nodes at max depth level
-					if (node_depth >= terrain_component.max_lod)
-						continue;
-					
-					// Extract node location from Morton location code
-					quadtree_type::node_type node_location = quadtree_type::location(node);
-					quadtree_type::node_type node_location_x;
-					quadtree_type::node_type node_location_y;
-					geom::morton::decode(node_location, node_location_x, node_location_y);
-					
-
-					
-					const double nodes_per_axis = std::exp2(node_depth);
-					const double node_width = 2.0 / nodes_per_axis;
-					
-					// Determine node center on front face of unit BCBF cube.
-					double3 center;
-					center.y = -(nodes_per_axis * 0.5 * node_width) + node_width * 0.5;
-					center.z = center.y;
-					center.y += static_cast<double>(node_location_x) * node_width;
-					center.z += static_cast<double>(node_location_y) * node_width;
-					center.x = 1.0;
-					
-					// Rotate node center according to cube face
-					/// @TODO Rather than rotating every center, "unrotate" observer position 6 times
-					center = face_rotations[i] * center;
-					
-					// Project node center onto unit sphere
-					double xx = center.x * center.x;
-					double yy = center.y * center.y;
-					double zz = center.z * center.z;
-					center.x *= std::sqrt(std::max(0.0, 1.0 - yy * 0.5 - zz * 0.5 + yy * zz / 3.0));
-					center.y *= std::sqrt(std::max(0.0, 1.0 - xx * 0.5 - zz * 0.5 + xx * zz / 3.0));
-					center.z *= std::sqrt(std::max(0.0, 1.0 - xx * 0.5 - yy * 0.5 + xx * yy / 3.0));
-					
-					// Scale node center by body radius
-					center *= terrain_body.radius;
-					center.y -= terrain_body.radius;
-					//center *= 50.0;
-					
-					const double horizontal_fov = observer.camera->get_fov();
-					const double horizontal_resolution = 1920.0;
-					const double distance = math::length(center - observer_cartesian);
-					const double geometric_error = static_cast<double>(524288.0 / std::exp2(node_depth));
-					const double screen_error = screen_space_error(horizontal_fov, horizontal_resolution, distance, geometric_error);
-					
-					if (screen_error > max_error)
-					{
-						//std::cout << screen_error << std::endl;
-						quadtree.insert(quadtree_type::child(node, 0));
-					}
+					refinement_nodes.push_back(node);
+					quadsphere_face.errors[parent] = parent_error;
 				}
 			}
-		});
+			
+			// Erase merged sibling groups at once, ahead of the split pass which depends on the merged leaves
+			quadtree.erase(refinement_nodes.begin(), refinement_nodes.end());
+			refinement_nodes.clear();
+			
+			// Split leaves which exceed the maximum tolerable error, including the leaves they split into
+			refinement_stack.clear();
+			quadtree.for_each_leaf([this](quadtree_node_type node) { refinement_stack.push_back(node); });
+			while (!refinement_stack.empty())
+			{
+				const quadtree_node_type node = refinement_stack.back();
+				refinement_stack.pop_back();
+				
+				// Merged parents have already been evaluated
+				auto error_it = quadsphere_face.errors.find(node);
+				const float screen_error = (error_it != quadsphere_face.errors.end()) ? error_it->second : node_error(i, node, terrain_body.radius);
+				
+				// Record screen-space error, by which patch requests are prioritized
+				quadsphere_face.errors[node] = screen_error;
+				
+				// Skip nodes at max depth level
+				if (quadtree_type::depth(node) >= terrain_component.max_lod)
+					continue;
+				
+				if (screen_error > max_error)
+				{
+					refinement_nodes.push_back(quadtree_type::child(node, 0));
+					for (quadtree_type::node_type k = 0; k < 4; ++k)
+						refinement_stack.push_back(quadtree_type::child(node, k));
+				}
+			}
+			
+			// Insert split sibling groups at once
+			quadtree.insert(refinement_nodes.begin(), refinement_nodes.end());
+			refinement_nodes.clear();
+		}
 	});
 	
-	// Handle meshes and models for each terrain patch
-	registry.view<component::terrain, component::celestial_body>().each(
-	[&](entity::id terrain_eid, const auto& terrain_component, const auto& terrain_body)
+	// Request patches for new quadtree nodes
+	for (auto& quadsphere: terrain_quadspheres)
 	{
-		// Retrieve terrain quadsphere
-		terrain_quadsphere* quadsphere = terrain_quadspheres[terrain_eid];
-		
 		// For each terrain quadsphere face
-		for (int i = 0; i < 6; ++i)
+		for (std::uint8_t i = 0; i < 6; ++i)
 		{
-			terrain_quadsphere_face& quadsphere_face = quadsphere->faces[i];
+			terrain_quadsphere_face& quadsphere_face = quadsphere.second->faces[i];
 			const quadtree_type& quadtree = quadsphere_face.quadtree;
 
 			// For each quadtree node
@@ -198,88 +219,567 @@ void terrain::update(double t, double dt)
 			{
 				quadtree_node_type node = *node_it;
 				
-				// Look up cached patch for this node
-				auto patch_it = quadsphere_face.patches.find(node);
+				// Skip nodes which already have a cached or requested patch
+				if (quadsphere_face.patches.find(node) != quadsphere_face.patches.end())
+					continue;
 				
-				// If there is no cached patch instance for this node
-				if (patch_it == quadsphere_face.patches.end())
+				// Construct a terrain patch, or reuse the model of a pooled patch, to be generated by a patch job
+				terrain_patch* patch;
+				if (!patch_pool.empty())
 				{
-					// Construct a terrain patch
-					terrain_patch* patch = new terrain_patch();
-					
-					// Generate a patch mesh
-					patch->mesh = generate_patch_mesh(i, *node_it, terrain_body.radius, terrain_component.elevation);
-					//patch->mesh = generate_patch_mesh(i, *node_it, 50.0, terrain_component.elevation);
-					
-					// Generate a patch model
-					patch->model = generate_patch_model(*patch->mesh, terrain_component.patch_material);
-					
-					// Construct patch model instance
-					patch->model_instance = new scene::model_instance(patch->model);
-
-					
-					// Cache the terrain patch
-					quadsphere_face.patches[node] = patch;
-					
-					// Add patch model instance to the patch scene collection
-					if (patch_scene_collection)
-						patch_scene_collection->add_object(patch->model_instance);
+					patch = patch_pool.back();
+					patch_pool.pop_back();
 				}
+				else
+				{
+					patch = new terrain_patch();
+					patch->model = nullptr;
+					patch->model_instance = nullptr;
+					patch->material = nullptr;
+				}
+				patch->morph_property = nullptr;
+				patch->uploaded = false;
+				patch->last_visible = update_count;
+				patch->error = 0.0f;
+				patch->morph = 0.0f;
+				patch->terrain_eid = quadsphere.first;
+				patch->face_index = i;
+				patch->node = node;
+				patch->vertex_data = nullptr;
+				
+				// Cache the terrain patch and request its generation
+				quadsphere_face.patches[node] = patch;
+				patch_requests.push_back(patch);
 			}
+		}
+	}
+	
+	dispatch_patch_requests();
+	
+	// Show the patches of uploaded nodes
+	for (auto& quadsphere: terrain_quadspheres)
+	{
+		for (int i = 0; i < 6; ++i)
+		{
+			terrain_quadsphere_face& quadsphere_face = quadsphere.second->faces[i];
 			
-			// For each terrain pach
+			// Deactivate all uploaded patches
 			for (auto patch_it = quadsphere_face.patches.begin(); patch_it != quadsphere_face.patches.end(); ++patch_it)
 			{
-				quadtree_node_type node = patch_it->first;
-				
-				// Set patch model instance active if its node is a leaf node, otherwise deactivate it
-				bool active = (quadtree.contains(node) && quadtree.is_leaf(node));
-				patch_it->second->model_instance->set_active(active);
+				if (patch_it->second->uploaded)
+					patch_it->second->model_instance->set_active(false);
 			}
+			
+			// Activate patches of leaf nodes, or of their nearest uploaded ancestors
+			update_patch_visibility(quadsphere_face, quadtree_type::root);
 		}
-	});
+	}
+	
+	static debug::gauge uploaded_patches("terrain.uploaded_patches");
+	static debug::gauge pending_patches("terrain.patch_requests");
+	uploaded_patches.set(static_cast<std::int64_t>(uploaded_patch_count));
+	pending_patches.set(static_cast<std::int64_t>(patch_requests.size()));
+	
+	evict_patches();
+	
+	++update_count;
 }
 
-void terrain::set_patch_subdivisions(std::uint8_t n)
+void terrain::upload_patches()
 {
-	patch_subdivisions = n;
+	std::vector<terrain_patch*> uploads;
+	{
+		std::lock_guard<std::mutex> lock(generated_patches_mutex);
+		
+		// Select the generated patches of the highest screen-space error
+		const std::size_t count = std::min(patch_upload_budget, generated_patches.size());
+		std::partial_sort
+		(
+			generated_patches.begin(),
+			generated_patches.begin() + count,
+			generated_patches.end(),
+			[](const terrain_patch* a, const terrain_patch* b)
+			{
+				return a->error > b->error;
+			}
+		);
+		
+		uploads.assign(generated_patches.begin(), generated_patches.begin() + count);
+		generated_patches.erase(generated_patches.begin(), generated_patches.begin() + count);
+	}
+	
+	for (terrain_patch* patch: uploads)
+	{
+		const component::terrain* terrain_component = registry.try_get<component::terrain>(patch->terrain_eid);
+		material* terrain_material = (terrain_component) ? terrain_component->patch_material : nullptr;
+		
+		// Generate a patch model, reusing the model of a recycled patch
+		patch->model = generate_patch_model(*patch, terrain_material, patch->model);
+		
+		if (patch->model_instance)
+		{
+			// Rebind the recycled model to update the bounds of the model instance
+			patch->model_instance->set_model(patch->model);
+		}
+		else
+		{
+			// Construct patch model instance, which will be activated by the next update
+			patch->model_instance = new scene::model_instance(patch->model);
+			patch->model_instance->set_active(false);
+			
+			// Add patch model instance to the patch scene collection
+			if (patch_scene_collection)
+				patch_scene_collection->add_object(patch->model_instance);
+		}
+		
+		// Place the patch model instance at the patch origin, where it remains however the observer moves
+		patch->model_instance->set_origin(patch->origin);
+		
+		// Override the terrain material with a copy which carries the patch morph factor
+		if (terrain_material)
+		{
+			if (!patch->material)
+				patch->material = new material();
+			*patch->material = *terrain_material;
+			
+			// Morphed vertex positions can't be reproduced by the depth pre-pass of the material pass
+			patch->material->set_flags(patch->material->get_flags() | MATERIAL_FLAG_NO_DEPTH_PREPASS);
+			patch->morph_property = patch->material->add_property<float>("morph");
+			patch->morph_property->set_value(patch->morph);
+			patch->material->update_tweens();
+			patch->model_instance->set_material(0, patch->material);
+		}
+		
+		patch->uploaded = true;
+		++uploaded_patch_count;
+		
+		if (!listeners.empty())
+		{
+			patch_geometry geometry;
+			geometry.key = {patch->terrain_eid, patch->face_index, patch->node};
+			geometry.vertex_data = patch->vertex_data;
+			geometry.vertex_size = patch_vertex_size;
+			geometry.vertex_count = patch_vertex_count;
+			geometry.indices = &patch_normal_indices;
+			geometry.bounds = &patch->bounds;
+			geometry.origin = patch->origin;
+			geometry.model_instance = patch->model_instance;
+			for (patch_listener* listener: listeners)
+				listener->patch_uploaded(geometry);
+		}
+		
+		delete[] patch->vertex_data;
+		patch->vertex_data = nullptr;
+	}
 	
-	// Rebuid patch base mesh
+	// Free pooled patches in excess of the pool capacity
+	while (patch_pool.size() > max_pooled_patches)
 	{
-		delete patch_base_mesh;
-		patch_base_mesh = geom::meshes::grid_xy(2.0f, patch_subdivisions, patch_subdivisions);
+		free_patch(patch_pool.back());
+		patch_pool.pop_back();
+	}
+	
+	if (debug::draw::is_enabled(debug::draw::terrain_patches))
+		draw_patches();
+}
+
+void terrain::dispatch_patch_requests()
+{
+	// Update request priorities, discarding requests for nodes which have left their quadtrees
+	for (std::size_t i = 0; i < patch_requests.size();)
+	{
+		terrain_patch* patch = patch_requests[i];
+		terrain_quadsphere_face& face = terrain_quadspheres[patch->terrain_eid]->faces[patch->face_index];
 		
-		// Convert quads to triangle fans
-		for (std::size_t i = 0; i < patch_base_mesh->get_faces().size(); ++i)
+		if (!face.quadtree.contains(patch->node))
 		{
-			geom::mesh::face* face = patch_base_mesh->get_faces()[i];
+			face.patches.erase(patch->node);
+			recycle_patch(patch);
 			
-			std::size_t edge_count = 1;
-			for (geom::mesh::edge* edge = face->edge->next; edge != face->edge; edge = edge->next)
-				++edge_count;
+			patch_requests[i] = patch_requests.back();
+			patch_requests.pop_back();
+			continue;
+		}
+		
+		// Nodes without a recorded error were not evaluated, and are treated as invisible
+		auto error_it = face.errors.find(patch->node);
+		patch->error = (error_it != face.errors.end()) ? error_it->second : -1.0f;
+		++i;
+	}
+	
+	// Determine number of patch jobs which can be submitted
+	std::size_t count = patch_requests.size();
+	if (jobs)
+	{
+		const std::size_t max_jobs = std::max<std::size_t>(1, jobs->get_thread_count()) * 2;
+		const std::size_t in_flight = patch_jobs_in_flight.load();
+		count = std::min(count, (in_flight < max_jobs) ? max_jobs - in_flight : 0);
+	}
+	
+	// Defer requests for nodes which are not visible to any observer
+	count = std::min<std::size_t>(count, std::count_if(patch_requests.begin(), patch_requests.end(), [](const terrain_patch* patch) { return patch->error >= 0.0f; }));
+	
+	// Select the requests of the highest screen-space error
+	std::partial_sort
+	(
+		patch_requests.begin(),
+		patch_requests.begin() + count,
+		patch_requests.end(),
+		[](const terrain_patch* a, const terrain_patch* b)
+		{
+			return a->error > b->error;
+		}
+	);
+	
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		terrain_patch* patch = patch_requests[i];
+		const double body_radius = registry.get<component::celestial_body>(patch->terrain_eid).radius;
+		const component::terrain* terrain_component = &registry.get<component::terrain>(patch->terrain_eid);
+		
+		auto job = [this, patch, body_radius, terrain_component]()
+		{
+			generate_patch(patch, body_radius, *terrain_component);
 			
-			if (edge_count > 3)
 			{
-				geom::poke_face(*patch_base_mesh, face->index);
-				--i;
+				std::lock_guard<std::mutex> lock(generated_patches_mutex);
+				generated_patches.push_back(patch);
+			}
+			
+			--patch_jobs_in_flight;
+		};
+		
+		++patch_jobs_in_flight;
+		if (jobs)
+			jobs->submit(job, &patch_counter);
+		else
+			job();
+	}
+	
+	patch_requests.erase(patch_requests.begin(), patch_requests.begin() + count);
+}
+
+void terrain::update_patch_visibility(terrain_quadsphere_face& face, quadtree_node_type node)
+{
+	auto patch_it = face.patches.find(node);
+	terrain_patch* patch = (patch_it != face.patches.end() && patch_it->second->uploaded) ? patch_it->second : nullptr;
+	
+	if (!face.quadtree.is_leaf(node))
+	{
+		// Check if all children have been uploaded
+		bool children_uploaded = true;
+		for (quadtree_type::node_type i = 0; i < 4 && children_uploaded; ++i)
+		{
+			auto child_it = face.patches.find(quadtree_type::child(node, i));
+			children_uploaded = (child_it != face.patches.end() && child_it->second->uploaded);
+		}
+		
+		// Defer to children once they can replace this node, or if this node has nothing to show
+		if (children_uploaded || !patch)
+		{
+			for (quadtree_type::node_type i = 0; i < 4; ++i)
+				update_patch_visibility(face, quadtree_type::child(node, i));
+			return;
+		}
+	}
+	
+	if (patch)
+	{
+		static debug::counter visible_patches("terrain.visible_patches");
+		visible_patches.add();
+		
+		patch->model_instance->set_active(true);
+		patch->last_visible = update_count;
+		
+		// Stitch edges which border coarser patches
+		const index_range& range = patch_index_ranges[patch_stitch_mask(face, node)];
+		model_group* patch_model_group = patch->model->get_group("terrain");
+		patch_model_group->set_start_index(range.start);
+		patch_model_group->set_index_count(range.count);
+		
+		// Morph toward the parent geometry as the error approaches that at which the node was split, and at which it will be merged. Nodes without a recorded error are interior nodes standing in for their children, and are drawn unmorphed.
+		auto error_it = face.errors.find(node);
+		if (quadtree_type::depth(node) && error_it != face.errors.end() && max_error > 0.0)
+			patch->morph = static_cast<float>(std::max(0.0, std::min(1.0, 2.0 - 2.0 * static_cast<double>(error_it->second) / max_error)));
+		else
+			patch->morph = 0.0f;
+		
+		if (patch->morph_property)
+			patch->morph_property->set_value(patch->morph);
+	}
+}
+
+std::uint8_t terrain::patch_stitch_mask(const terrain_quadsphere_face& face, quadtree_node_type node)
+{
+	const quadtree_type::node_type depth = quadtree_type::depth(node);
+	if (!depth)
+		return 0;
+	
+	quadtree_type::node_type location_x;
+	quadtree_type::node_type location_y;
+	geom::morton::decode(quadtree_type::location(node), location_x, location_y);
+	const quadtree_type::node_type nodes_per_axis = quadtree_type::node_type(1) << depth;
+	
+	// Neighbors of the same depth which are not in the quadtree are covered by coarser patches. Edges on the boundary of the face are not stitched.
+	auto coarser = [&](quadtree_type::node_type x, quadtree_type::node_type y) -> bool
+	{
+		return !face.quadtree.contains(quadtree_type::node(depth, geom::morton::encode(x, y)));
+	};
+	
+	std::uint8_t mask = 0;
+	if (location_x > 0 && coarser(location_x - 1, location_y))
+		mask |= 1;
+	if (location_x + 1 < nodes_per_axis && coarser(location_x + 1, location_y))
+		mask |= 2;
+	if (location_y > 0 && coarser(location_x, location_y - 1))
+		mask |= 4;
+	if (location_y + 1 < nodes_per_axis && coarser(location_x, location_y + 1))
+		mask |= 8;
+	
+	return mask;
+}
+
+void terrain::evict_patches()
+{
+	// Approximate the memory of each patch by the size of its vertex data
+	const std::size_t patch_size = patch_vertex_count * patch_vertex_stride;
+	if (!patch_size || uploaded_patch_count * patch_size <= patch_memory_budget)
+		return;
+	
+	const std::size_t budget_count = patch_memory_budget / patch_size;
+	const std::size_t excess_count = uploaded_patch_count - budget_count;
+	
+	// Collect uploaded patches whose nodes have left their quadtrees
+	std::vector<terrain_patch*> candidates;
+	for (auto& quadsphere: terrain_quadspheres)
+	{
+		for (int i = 0; i < 6; ++i)
+		{
+			terrain_quadsphere_face& quadsphere_face = quadsphere.second->faces[i];
+			for (auto patch_it = quadsphere_face.patches.begin(); patch_it != quadsphere_face.patches.end(); ++patch_it)
+			{
+				terrain_patch* patch = patch_it->second;
+				if (patch->uploaded && !quadsphere_face.quadtree.contains(patch->node))
+					candidates.push_back(patch);
 			}
 		}
 	}
 	
-	// Transform patch base mesh coordinates to match the front face of a BCBF cube
-	const math::quaternion<float> xy_to_zy = math::quaternion<float>::rotate_y(-math::half_pi<float>);
-	for (geom::mesh::vertex* vertex: patch_base_mesh->get_vertices())
+	// Select the least recently visible candidates
+	const std::size_t eviction_count = std::min(excess_count, candidates.size());
+	std::nth_element
+	(
+		candidates.begin(),
+		candidates.begin() + eviction_count,
+		candidates.end(),
+		[](const terrain_patch* a, const terrain_patch* b)
+		{
+			return a->last_visible < b->last_visible;
+		}
+	);
+	
+	for (std::size_t i = 0; i < eviction_count; ++i)
+	{
+		terrain_patch* patch = candidates[i];
+		terrain_quadspheres[patch->terrain_eid]->faces[patch->face_index].patches.erase(patch->node);
+		recycle_patch(patch);
+	}
+}
+
+void terrain::recycle_patch(terrain_patch* patch)
+{
+	if (patch->uploaded)
+	{
+		// Keep the model instance in the scene, inactive, until it is reused or freed
+		patch->model_instance->set_active(false);
+		patch->uploaded = false;
+		--uploaded_patch_count;
+		
+		for (patch_listener* listener: listeners)
+			listener->patch_released({patch->terrain_eid, patch->face_index, patch->node});
+	}
+	
+	delete[] patch->vertex_data;
+	patch->vertex_data = nullptr;
+	
+	patch_pool.push_back(patch);
+}
+
+void terrain::wait_for_patch_jobs()
+{
+	if (jobs)
+		jobs->wait(patch_counter);
+}
+
+void terrain::free_patch(terrain_patch* patch)
+{
+	if (patch->uploaded)
+		for (patch_listener* listener: listeners)
+			listener->patch_released({patch->terrain_eid, patch->face_index, patch->node});
+	
+	if (patch->model_instance && patch_scene_collection)
+		patch_scene_collection->remove_object(patch->model_instance);
+	
+	delete patch->model_instance;
+	delete patch->model;
+	delete patch->material;
+	delete[] patch->vertex_data;
+	delete patch;
+}
+
+void terrain::add_patch_listener(patch_listener* listener)
+{
+	listeners.push_back(listener);
+}
+
+void terrain::set_patch_subdivisions(std::uint8_t n)
+{
+	// Patch jobs read the number of patch cells
+	wait_for_patch_jobs();
+	
+	patch_subdivisions = n;
+	
+	// Round the number of cells per patch axis up to an even number, so that every other vertex lies on the grid of the parent patch
+	patch_cells = static_cast<std::size_t>(patch_subdivisions) + 1;
+	patch_cells += patch_cells % 2;
+	
+	// Recalculate number of unique vertices per patch (cell corners and cell centers)
+	patch_vertex_count = (patch_cells + 1) * (patch_cells + 1) + patch_cells * patch_cells;
+	
+	generate_patch_indices();
+}
+
+void terrain::generate_patch_indices()
+{
+	const std::size_t n = patch_cells;
+	const std::size_t corner_count = (n + 1) * (n + 1);
+	
+	// Grid coordinates of patch vertices
+	auto corner = [n](std::size_t i, std::size_t j) -> std::uint32_t
+	{
+		return static_cast<std::uint32_t>(i * (n + 1) + j);
+	};
+	auto center = [n, corner_count](std::size_t i, std::size_t j) -> std::uint32_t
+	{
+		return static_cast<std::uint32_t>(corner_count + i * n + j);
+	};
+	auto coordinates = [n, corner_count](std::uint32_t index) -> double2
+	{
+		if (index < corner_count)
+			return {static_cast<double>(index / (n + 1)), static_cast<double>(index % (n + 1))};
+		index -= static_cast<std::uint32_t>(corner_count);
+		return {static_cast<double>(index / n) + 0.5, static_cast<double>(index % n) + 0.5};
+	};
+	
+	// Returns `true` if a vertex is an odd vertex on a stitched edge
+	auto stitched = [n, corner_count](std::uint32_t index, std::uint8_t mask) -> bool
+	{
+		if (index >= corner_count)
+			return false;
+		const std::size_t i = index / (n + 1);
+		const std::size_t j = index % (n + 1);
+		return ((mask & 1) && i == 0 && j % 2) ||
+			((mask & 2) && i == n && j % 2) ||
+			((mask & 4) && j == 0 && i % 2) ||
+			((mask & 8) && j == n && i % 2);
+	};
+	
+	std::vector<std::uint32_t> indices;
+	
+	// Appends a triangle, counterclockwise as seen from outside the quadsphere
+	auto add_triangle = [&](std::uint32_t a, std::uint32_t b, std::uint32_t c)
 	{
-		vertex->position = xy_to_zy * vertex->position;
-		vertex->position.x = 1.0f;
+		const double2 pa = coordinates(a);
+		const double2 pb = coordinates(b);
+		const double2 pc = coordinates(c);
+		const double cross = (pb.x - pa.x) * (pc.y - pa.y) - (pb.y - pa.y) * (pc.x - pa.x);
+		if (cross < 0.0)
+			std::swap(b, c);
+		
+		indices.push_back(a);
+		indices.push_back(b);
+		indices.push_back(c);
+	};
+	
+	for (std::uint8_t mask = 0; mask < 16; ++mask)
+	{
+		patch_index_ranges[mask].start = indices.size();
+		
+		// Fan the four corners of each cell around the cell center, omitting triangles which touch odd vertices of stitched edges
+		for (std::size_t i = 0; i < n; ++i)
+		{
+			for (std::size_t j = 0; j < n; ++j)
+			{
+				const std::uint32_t a = corner(i, j);
+				const std::uint32_t b = corner(i + 1, j);
+				const std::uint32_t c = corner(i, j + 1);
+				const std::uint32_t d = corner(i + 1, j + 1);
+				const std::uint32_t e = center(i, j);
+				const std::uint32_t triangles[4][3] = {{a, b, e}, {b, d, e}, {d, c, e}, {c, a, e}};
+				
+				for (const auto& triangle: triangles)
+				{
+					if (!stitched(triangle[0], mask) && !stitched(triangle[1], mask))
+						add_triangle(triangle[0], triangle[1], triangle[2]);
+				}
+			}
+		}
+		
+		// Span each pair of cells along stitched edges with the edge of the coarser neighbor
+		for (std::uint8_t edge = 0; edge < 4; ++edge)
+		{
+			if (!(mask & (1 << edge)))
+				continue;
+			
+			for (std::size_t k = 0; k < n; k += 2)
+			{
+				std::uint32_t a0, a2, e0, e1, m;
+				switch (edge)
+				{
+					case 0:
+						a0 = corner(0, k); a2 = corner(0, k + 2);
+						e0 = center(0, k); e1 = center(0, k + 1);
+						m = corner(1, k + 1);
+						break;
+					case 1:
+						a0 = corner(n, k); a2 = corner(n, k + 2);
+						e0 = center(n - 1, k); e1 = center(n - 1, k + 1);
+						m = corner(n - 1, k + 1);
+						break;
+					case 2:
+						a0 = corner(k, 0); a2 = corner(k + 2, 0);
+						e0 = center(k, 0); e1 = center(k + 1, 0);
+						m = corner(k + 1, 1);
+						break;
+					default:
+						a0 = corner(k, n); a2 = corner(k + 2, n);
+						e0 = center(k, n - 1); e1 = center(k + 1, n - 1);
+						m = corner(k + 1, n - 1);
+						break;
+				}
+				
+				add_triangle(e0, a0, a2);
+				add_triangle(e0, a2, e1);
+				add_triangle(e0, e1, m);
+			}
+		}
+		
+		patch_index_ranges[mask].count = indices.size() - patch_index_ranges[mask].start;
+		
+		// Reorder the triangles of the range for the vertex cache. Vertices keep their order, as their grid coordinates are derived from their indices.
+		geom::optimize_vertex_cache(indices.data() + patch_index_ranges[mask].start, patch_index_ranges[mask].count, patch_vertex_count);
 	}
 	
-	// Recalculate number of vertices per patch
-	patch_vertex_count = patch_base_mesh->get_faces().size() * 3;
+	// Keep the unstitched triangles, from which patch vertex normals are calculated
+	const index_range& unstitched = patch_index_ranges[0];
+	patch_normal_indices.assign(indices.begin() + unstitched.start, indices.begin() + unstitched.start + unstitched.count);
 	
-	// Resize patch vertex data buffer
-	delete[] patch_vertex_data;
-	patch_vertex_data = new float[patch_vertex_count * patch_vertex_size];
+	// Upload indices to the shared patch index buffer
+	const std::size_t size = indices.size() * sizeof(std::uint32_t);
+	if (!patch_index_buffer)
+		patch_index_buffer = new gl::vertex_buffer(size, indices.data());
+	else
+		patch_index_buffer->resize(size, indices.data());
 }
 
 void terrain::set_patch_scene_collection(scene::collection* collection)
@@ -292,6 +792,33 @@ void terrain::set_max_error(double error)
 	max_error = error;
 }
 
+void terrain::set_lod_hysteresis(double hysteresis)
+{
+	lod_hysteresis = hysteresis;
+}
+
+void terrain::set_job_system(job_system* jobs)
+{
+	wait_for_patch_jobs();
+	this->jobs = jobs;
+}
+
+void terrain::set_patch_upload_budget(std::size_t budget)
+{
+	patch_upload_budget = budget;
+}
+
+void terrain::set_patch_memory_budget(std::size_t budget)
+{
+	patch_memory_budget = budget;
+}
+
+void terrain::set_patch_cache(::terrain_patch_cache* cache)
+{
+	wait_for_patch_jobs();
+	patch_cache = cache;
+}
+
 void terrain::on_terrain_construct(entity::registry& registry, entity::id entity_id, component::terrain& component)
 {
 	terrain_quadsphere* quadsphere = new terrain_quadsphere();
@@ -307,6 +834,17 @@ void terrain::on_terrain_destroy(entity::registry& registry, entity::id entity_i
 	{
 		terrain_quadsphere* quadsphere = quadsphere_it->second;
 		
+		// Wait for patch jobs which may reference the terrain's patches or elevation functions
+		wait_for_patch_jobs();
+		
+		// Discard pending requests and uploads of the terrain's patches
+		auto belongs_to_terrain = [entity_id](const terrain_patch* patch)
+		{
+			return patch->terrain_eid == entity_id;
+		};
+		patch_requests.erase(std::remove_if(patch_requests.begin(), patch_requests.end(), belongs_to_terrain), patch_requests.end());
+		generated_patches.erase(std::remove_if(generated_patches.begin(), generated_patches.end(), belongs_to_terrain), generated_patches.end());
+		
 		// For each terrain quadsphere face
 		for (int i = 0; i < 6; ++i)
 		{
@@ -314,28 +852,21 @@ void terrain::on_terrain_destroy(entity::registry& registry, entity::id entity_i
 			
 			for (auto patch_it = quadsphere_face.patches.begin(); patch_it != quadsphere_face.patches.end(); ++patch_it)
 			{
-				terrain_patch* patch = patch_it->second;
-				
-				if (patch_scene_collection)
-					patch_scene_collection->remove_object(patch->model_instance);
-				
-				delete patch->model_instance;
-				delete patch->model;
-				delete patch->mesh;
-				
-				delete patch;
+				if (patch_it->second->uploaded)
+					--uploaded_patch_count;
+				free_patch(patch_it->second);
 			}
 		}
 		
 		// Free terrain quadsphere
 		delete quadsphere;
+		
+		// Remove terrain quadsphere from the map
+		terrain_quadspheres.erase(quadsphere_it);
 	}
-	
-	// Remove terrain quadsphere from the map
-	terrain_quadspheres.erase(quadsphere_it);
 }
 
-geom::mesh* terrain::generate_patch_mesh(std::uint8_t face_index, quadtree_node_type node, double body_radius, const std::function<double(double, double)>& elevation) const
+void terrain::generate_patch_positions(std::uint8_t face_index, quadtree_node_type node, double body_radius, const component::terrain& terrain_component, float3* positions, double3& origin) const
 {
 	// Extract node depth
 	const quadtree_type::node_type depth = quadtree_type::depth(node);
@@ -348,66 +879,368 @@ geom::mesh* terrain::generate_patch_mesh(std::uint8_t face_index, quadtree_node_
 	
 	const double nodes_per_axis = std::exp2(depth);
 	
-	const double scale_yz = 1.0 / nodes_per_axis;
-	
 	const double node_width = 2.0 / nodes_per_axis;
 	
-	// Determine vertex offset according to node location
-	double offset_y = -(nodes_per_axis * 0.5 * node_width) + node_width * 0.5;
-	double offset_z = offset_y;
-	offset_y += static_cast<double>(location_x) * node_width;
-	offset_z += static_cast<double>(location_y) * node_width;
+	// Determine the cube coordinates of the node's minimum corner according to node location
+	const double offset_y = -1.0 + static_cast<double>(location_x) * node_width;
+	const double offset_z = -1.0 + static_cast<double>(location_y) * node_width;
+	
+	const std::size_t n = patch_cells;
+	const double cell_width = node_width / static_cast<double>(n);
 	
-	// Copy base mesh
-	geom::mesh* patch_mesh = new geom::mesh(*patch_base_mesh);
+	std::vector<double3> directions(patch_vertex_count);
+	std::vector<double> latitudes(patch_vertex_count);
+	std::vector<double> longitudes(patch_vertex_count);
+	std::vector<double> elevations(patch_vertex_count);
 	
-	// Modify patch mesh vertex positions
-	for (geom::mesh::vertex* v: patch_mesh->get_vertices())
+	auto project = [&](std::size_t index, double grid_y, double grid_z)
 	{
-		double3 position = math::type_cast<double>(v->position);
-		
-		// Offset and scale vertex position
-		position.y *= scale_yz;
-		position.z *= scale_yz;
-		position.y += offset_y;
-		position.z += offset_z;
-
-		// Rotate according to cube face
-		position = face_rotations[face_index] * position;
-		
-		// Project onto unit sphere
-		//position = math::normalize(position);
-		
-		// Cartesian Spherical Cube projection (KSC)
-		/// @see https://catlikecoding.com/unity/tutorials/cube-sphere/
-		/// @see https://core.ac.uk/download/pdf/228552506.pdf
-		double xx = position.x * position.x;
-		double yy = position.y * position.y;
-		double zz = position.z * position.z;
-		position.x *= std::sqrt(std::max(0.0, 1.0 - yy * 0.5 - zz * 0.5 + yy * zz / 3.0));
-		position.y *= std::sqrt(std::max(0.0, 1.0 - xx * 0.5 - zz * 0.5 + xx * zz / 3.0));
-		position.z *= std::sqrt(std::max(0.0, 1.0 - xx * 0.5 - yy * 0.5 + xx * yy / 3.0));
+		const double3 position = project_face_point(face_index, offset_y + grid_y * cell_width, offset_z + grid_z * cell_width);
 		
 		// Calculate latitude and longitude of vertex position
-		const double latitude = std::atan2(position.z, std::sqrt(position.x * position.x + position.y * position.y));
-		const double longitude = std::atan2(position.y, position.x);
-		
-		// Look up elevation at latitude and longitude and use to calculate radial distance
-		const double radial_distance = body_radius + elevation(latitude, longitude);
-		
-		// Scale vertex position by radial distance
-		position *= radial_distance;
+		directions[index] = position;
+		latitudes[index] = std::atan2(position.z, std::sqrt(position.x * position.x + position.y * position.y));
+		longitudes[index] = std::atan2(position.y, position.x);
+	};
+	
+	// Cell corners
+	std::size_t index = 0;
+	for (std::size_t i = 0; i <= n; ++i)
+		for (std::size_t j = 0; j <= n; ++j)
+			project(index++, static_cast<double>(i), static_cast<double>(j));
+	
+	// Cell centers
+	for (std::size_t i = 0; i < n; ++i)
+		for (std::size_t j = 0; j < n; ++j)
+			project(index++, static_cast<double>(i) + 0.5, static_cast<double>(j) + 0.5);
+	
+	// Look up elevations at the latitudes and longitudes of all vertices
+	if (terrain_component.batch_elevation)
+	{
+		terrain_component.batch_elevation(latitudes.data(), longitudes.data(), elevations.data(), patch_vertex_count);
+	}
+	else if (terrain_component.elevation)
+	{
+		for (std::size_t i = 0; i < patch_vertex_count; ++i)
+			elevations[i] = terrain_component.elevation(latitudes[i], longitudes[i]);
+	}
+	else
+	{
+		std::fill(elevations.begin(), elevations.end(), 0.0);
+	}
+	
+	// Scale vertex positions by radial distance
+	auto scale = [&](std::size_t i) -> double3
+	{
+		double3 position = directions[i] * (body_radius + elevations[i]);
 		position.y -= body_radius;
+		return position;
+	};
+	
+	// Position vertices relative to the central cell corner, as patch cells are rounded to an even number
+	origin = scale((n / 2) * (n + 1) + n / 2);
+	for (std::size_t i = 0; i < patch_vertex_count; ++i)
+		positions[i] = math::type_cast<float>(scale(i) - origin);
+}
+
+void terrain::generate_patch(terrain_patch* patch, double body_radius, const component::terrain& terrain_component) const
+{
+	patch->vertex_data = new float[patch_vertex_count * patch_vertex_size];
+	
+	// Load cached patches
+	const terrain_patch_cache::key cache_key = {terrain_component.seed, patch->face_index, patch->node, patch_subdivisions};
+	const bool cacheable = (patch_cache && terrain_component.seed);
+	if (cacheable && patch_cache->load(cache_key, patch->vertex_data, patch_vertex_size, patch_vertex_count, patch->bounds, patch->origin))
+	{
+		store_patch_elevations(patch, body_radius);
+		return;
+	}
+	
+	// Generate patch vertex positions
+	std::vector<float3> positions(patch_vertex_count);
+	generate_patch_positions(patch->face_index, patch->node, body_radius, terrain_component, positions.data(), patch->origin);
+	
+	// Generate interleaved vertex data
+	generate_patch_vertices(positions.data(), patch->vertex_data);
+	
+	// Calculate patch bounds
+	patch->bounds = {positions[0], positions[0]};
+	for (const float3& position: positions)
+	{
+		for (int i = 0; i < 3; ++i)
+		{
+			patch->bounds.min_point[i] = std::min(patch->bounds.min_point[i], position[i]);
+			patch->bounds.max_point[i] = std::max(patch->bounds.max_point[i], position[i]);
+		}
+	}
+	
+	// Store generated patches from the patch job, off of the updating thread
+	if (cacheable)
+		patch_cache->store(cache_key, patch->vertex_data, patch_vertex_size, patch_vertex_count, patch->bounds, patch->origin);
+	
+	store_patch_elevations(patch, body_radius);
+}
+
+void terrain::store_patch_elevations(terrain_patch* patch, double body_radius) const
+{
+	// Vertex positions are relative to the patch origin, which is offset by the body radius along the y-axis
+	patch->elevations.resize(patch_vertex_count);
+	for (std::size_t i = 0; i < patch_vertex_count; ++i)
+	{
+		const float* position = patch->vertex_data + i * patch_vertex_size;
+		const double3 bcbf_position =
+		{
+			static_cast<double>(position[0]) + patch->origin.x,
+			static_cast<double>(position[1]) + patch->origin.y + body_radius,
+			static_cast<double>(position[2]) + patch->origin.z
+		};
+		patch->elevations[i] = static_cast<float>(math::length(bcbf_position) - body_radius);
+	}
+}
+
+double3 terrain::project_face_point(std::uint8_t face_index, double u, double v) const
+{
+	// Rotate the point on the front face of the cube according to the cube face
+	double3 position = face_rotations[face_index] * double3{1.0, u, v};
+	
+	// Cartesian Spherical Cube projection (KSC)
+	/// @see https://catlikecoding.com/unity/tutorials/cube-sphere/
+	/// @see https://core.ac.uk/download/pdf/228552506.pdf
+	const double xx = position.x * position.x;
+	const double yy = position.y * position.y;
+	const double zz = position.z * position.z;
+	position.x *= std::sqrt(std::max(0.0, 1.0 - yy * 0.5 - zz * 0.5 + yy * zz / 3.0));
+	position.y *= std::sqrt(std::max(0.0, 1.0 - xx * 0.5 - zz * 0.5 + xx * zz / 3.0));
+	position.z *= std::sqrt(std::max(0.0, 1.0 - xx * 0.5 - yy * 0.5 + xx * yy / 3.0));
+	
+	return position;
+}
+
+std::uint8_t terrain::unproject_face_point(const double3& direction, double& u, double& v) const
+{
+	// Select the face of the dominant axis, in the order of +x, -x, +y, -y, +z, -z
+	const double3 magnitude = {std::abs(direction.x), std::abs(direction.y), std::abs(direction.z)};
+	std::uint8_t face_index;
+	if (magnitude.x >= magnitude.y && magnitude.x >= magnitude.z)
+		face_index = (direction.x >= 0.0) ? 0 : 1;
+	else if (magnitude.y >= magnitude.z)
+		face_index = (direction.y >= 0.0) ? 2 : 3;
+	else
+		face_index = (direction.z >= 0.0) ? 4 : 5;
+	
+	// Rotate the direction onto the front face. The projection commutes with face rotations, as they only permute and negate axes.
+	const double3 front = math::conjugate(face_rotations[face_index]) * direction;
+	
+	// Invert the projection of the front face, on which y = u * sqrt(1/2 - v^2/6) and z = v * sqrt(1/2 - u^2/6), by solving a quadratic in v^2
+	const double yy = front.y * front.y;
+	const double zz = front.z * front.z;
+	const double b = 9.0 - 6.0 * yy + 6.0 * zz;
+	const double vv = std::max(0.0, (b - std::sqrt(std::max(0.0, b * b - 216.0 * zz))) / 6.0);
+	const double uu = 6.0 * yy / (3.0 - vv);
+	u = std::copysign(std::min(1.0, std::sqrt(uu)), front.y);
+	v = std::copysign(std::min(1.0, std::sqrt(vv)), front.z);
+	
+	return face_index;
+}
+
+bool terrain::sample_patches(const terrain_quadsphere& quadsphere, std::size_t max_lod, double body_radius, const double3& direction, surface_sample& sample) const
+{
+	double u;
+	double v;
+	const std::uint8_t face_index = unproject_face_point(direction, u, v);
+	const terrain_quadsphere_face& face = quadsphere.faces[face_index];
+	
+	// Find the finest uploaded patch containing the point. Ancestors of resident patches may have been evicted, so every depth is searched.
+	const terrain_patch* patch = nullptr;
+	double node_x = 0.0;
+	double node_y = 0.0;
+	const std::size_t max_depth = std::min<std::size_t>(max_lod, quadtree_type::max_depth);
+	for (std::size_t depth = 0; depth <= max_depth; ++depth)
+	{
+		const double nodes_per_axis = std::exp2(static_cast<double>(depth));
+		const double x = std::min((u + 1.0) * 0.5 * nodes_per_axis, nodes_per_axis - 0.5);
+		const double y = std::min((v + 1.0) * 0.5 * nodes_per_axis, nodes_per_axis - 0.5);
+		const quadtree_node_type location = geom::morton::encode<quadtree_node_type>(static_cast<quadtree_node_type>(x), static_cast<quadtree_node_type>(y));
+		const quadtree_node_type node = quadtree_type::node(static_cast<quadtree_node_type>(depth), location);
 		
-		v->position = math::type_cast<float>(position);
+		auto patch_it = face.patches.find(node);
+		if (patch_it != face.patches.end() && patch_it->second->uploaded && !patch_it->second->elevations.empty())
+		{
+			patch = patch_it->second;
+			node_x = x;
+			node_y = y;
+		}
 	}
 	
-	return patch_mesh;
+	if (!patch)
+		return false;
+	
+	// Locate the point within the cells of the patch
+	const std::size_t n = patch_cells;
+	const double grid_x = (node_x - std::floor(node_x)) * static_cast<double>(n);
+	const double grid_y = (node_y - std::floor(node_y)) * static_cast<double>(n);
+	const std::size_t i = std::min(static_cast<std::size_t>(grid_x), n - 1);
+	const std::size_t j = std::min(static_cast<std::size_t>(grid_y), n - 1);
+	const double s = grid_x - static_cast<double>(i);
+	const double t = grid_y - static_cast<double>(j);
+	
+	// Select the triangle of the cell fan whose edge is nearest to the point. Vertices are given by their offsets from the cell's minimum corner, with the cell center at (0.5, 0.5).
+	const std::size_t corner_count = (n + 1) * (n + 1);
+	std::size_t a_i, a_j, b_i, b_j;
+	if (t <= s && t <= 1.0 - s)
+	{
+		a_i = 0; a_j = 0; b_i = 1; b_j = 0;
+	}
+	else if (s >= t && s >= 1.0 - t)
+	{
+		a_i = 1; a_j = 0; b_i = 1; b_j = 1;
+	}
+	else if (t >= s && t >= 1.0 - s)
+	{
+		a_i = 1; a_j = 1; b_i = 0; b_j = 1;
+	}
+	else
+	{
+		a_i = 0; a_j = 1; b_i = 0; b_j = 0;
+	}
+	
+	const double2 pa = {static_cast<double>(a_i), static_cast<double>(a_j)};
+	const double2 pb = {static_cast<double>(b_i), static_cast<double>(b_j)};
+	const double2 pc = {0.5, 0.5};
+	const double ha = patch->elevations[(i + a_i) * (n + 1) + (j + a_j)];
+	const double hb = patch->elevations[(i + b_i) * (n + 1) + (j + b_j)];
+	const double hc = patch->elevations[corner_count + i * n + j];
+	
+	// Interpolate the elevations of the triangle by the barycentric coordinates of the point
+	const double denominator = (pb.y - pc.y) * (pa.x - pc.x) + (pc.x - pb.x) * (pa.y - pc.y);
+	const double wa = ((pb.y - pc.y) * (s - pc.x) + (pc.x - pb.x) * (t - pc.y)) / denominator;
+	const double wb = ((pc.y - pa.y) * (s - pc.x) + (pa.x - pc.x) * (t - pc.y)) / denominator;
+	const double wc = 1.0 - wa - wb;
+	sample.elevation = wa * ha + wb * hb + wc * hc;
+	
+	// Find the normal of the triangle from the BCBF positions of its vertices
+	const double depth = static_cast<double>(quadtree_type::depth(patch->node));
+	const double node_width = 2.0 / std::exp2(depth);
+	const double cell_width = node_width / static_cast<double>(n);
+	const double offset_u = -1.0 + std::floor(node_x) * node_width + static_cast<double>(i) * cell_width;
+	const double offset_v = -1.0 + std::floor(node_y) * node_width + static_cast<double>(j) * cell_width;
+	auto vertex = [&](const double2& p, double elevation) -> double3
+	{
+		return project_face_point(face_index, offset_u + p.x * cell_width, offset_v + p.y * cell_width) * (body_radius + elevation);
+	};
+	const double3 va = vertex(pa, ha);
+	const double3 vb = vertex(pb, hb);
+	const double3 vc = vertex(pc, hc);
+	double3 normal = math::normalize(math::cross(vb - va, vc - va));
+	if (math::dot(normal, direction) < 0.0)
+		normal = -normal;
+	sample.normal = normal;
+	
+	return true;
+}
+
+terrain::surface_sample terrain::sample_surface(entity::id terrain_eid, double latitude, double longitude) const
+{
+	surface_sample sample;
+	sample_surface(terrain_eid, &latitude, &longitude, &sample, 1);
+	return sample;
+}
+
+void terrain::sample_surface(entity::id terrain_eid, const double* latitudes, const double* longitudes, surface_sample* samples, std::size_t count) const
+{
+	auto direction = [](double latitude, double longitude) -> double3
+	{
+		const double cos_latitude = std::cos(latitude);
+		return {cos_latitude * std::cos(longitude), cos_latitude * std::sin(longitude), std::sin(latitude)};
+	};
+	
+	const component::terrain* terrain_component = registry.try_get<component::terrain>(terrain_eid);
+	const component::celestial_body* body = registry.try_get<component::celestial_body>(terrain_eid);
+	auto quadsphere_it = terrain_quadspheres.find(terrain_eid);
+	if (!terrain_component || !body || quadsphere_it == terrain_quadspheres.end())
+	{
+		for (std::size_t i = 0; i < count; ++i)
+			samples[i] = {0.0, direction(latitudes[i], longitudes[i])};
+		return;
+	}
+	
+	// Sample resident patches, collecting the points outside of them
+	std::vector<std::size_t> misses;
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		if (!sample_patches(*quadsphere_it->second, terrain_component->max_lod, body->radius, direction(latitudes[i], longitudes[i]), samples[i]))
+			misses.push_back(i);
+	}
+	
+	if (misses.empty())
+		return;
+	
+	// Evaluate the elevation function at each missed point and at points north and east of it, from which normals are found by finite differences of about half a meter
+	const double step = 0.5 / body->radius;
+	const std::size_t miss_count = misses.size();
+	std::vector<double> miss_latitudes(miss_count * 3);
+	std::vector<double> miss_longitudes(miss_count * 3);
+	std::vector<double> miss_elevations(miss_count * 3, 0.0);
+	for (std::size_t k = 0; k < miss_count; ++k)
+	{
+		const std::size_t i = misses[k];
+		miss_latitudes[k * 3] = latitudes[i];
+		miss_longitudes[k * 3] = longitudes[i];
+		miss_latitudes[k * 3 + 1] = latitudes[i] + step;
+		miss_longitudes[k * 3 + 1] = longitudes[i];
+		miss_latitudes[k * 3 + 2] = latitudes[i];
+		miss_longitudes[k * 3 + 2] = longitudes[i] + step;
+	}
+	
+	if (terrain_component->batch_elevation)
+	{
+		terrain_component->batch_elevation(miss_latitudes.data(), miss_longitudes.data(), miss_elevations.data(), miss_count * 3);
+	}
+	else if (terrain_component->elevation)
+	{
+		for (std::size_t k = 0; k < miss_count * 3; ++k)
+			miss_elevations[k] = terrain_component->elevation(miss_latitudes[k], miss_longitudes[k]);
+	}
+	
+	for (std::size_t k = 0; k < miss_count; ++k)
+	{
+		const std::size_t i = misses[k];
+		const double3 up = direction(miss_latitudes[k * 3], miss_longitudes[k * 3]);
+		const double3 position = up * (body->radius + miss_elevations[k * 3]);
+		const double3 north = direction(miss_latitudes[k * 3 + 1], miss_longitudes[k * 3 + 1]) * (body->radius + miss_elevations[k * 3 + 1]);
+		const double3 east = direction(miss_latitudes[k * 3 + 2], miss_longitudes[k * 3 + 2]) * (body->radius + miss_elevations[k * 3 + 2]);
+		
+		// Fall back to the radial normal where differences degenerate, as at the poles
+		double3 normal = math::cross(east - position, north - position);
+		const double length = math::length(normal);
+		normal = (length > 0.0) ? normal / length : up;
+		if (math::dot(normal, up) < 0.0)
+			normal = -normal;
+		
+		samples[i] = {miss_elevations[k * 3], normal};
+	}
+}
+
+double terrain::get_elevation(entity::id terrain_eid, double latitude, double longitude) const
+{
+	return sample_surface(terrain_eid, latitude, longitude).elevation;
 }
 
-model* terrain::generate_patch_model(const geom::mesh& patch_mesh, material* patch_material) const
+void terrain::generate_patch_vertices(const float3* positions, float* vertex_data) const
 {
-	// Barycentric coordinates
+	const std::size_t n = patch_cells;
+	const std::size_t corner_count = (n + 1) * (n + 1);
+	
+	auto corner = [&](std::size_t i, std::size_t j) -> const float3&
+	{
+		return positions[i * (n + 1) + j];
+	};
+	
+	// Calculate smooth vertex normals from the faces of the unstitched grid
+	std::vector<float3> normals(patch_vertex_count);
+	geom::calculate_vertex_normals(normals.data(), patch_vertex_count, &positions[0].x, &positions[0].y, &positions[0].z, 3, patch_normal_indices.data(), patch_normal_indices.size() / 3);
+	
+	// Barycentric coordinates, alternating between neighboring cell corners, with cell centers opposite
 	static const float3 barycentric[3] =
 	{
 		{1, 0, 0},
@@ -416,65 +1249,101 @@ model* terrain::generate_patch_model(const geom::mesh& patch_mesh, material* pat
 	};
 	
 	// Fill vertex data buffer
-	float* v = patch_vertex_data;
-	for (const geom::mesh::face* face: patch_mesh.get_faces())
+	float* v = vertex_data;
+	for (std::size_t index = 0; index < patch_vertex_count; ++index)
 	{
-		const geom::mesh::vertex* a = face->edge->vertex;
-		const geom::mesh::vertex* b = face->edge->next->vertex;
-		const geom::mesh::vertex* c = face->edge->previous->vertex;
-		const geom::mesh::vertex* face_vertices[] = {a, b, c};
-		
-		// Calculate facted normal
-		float3 normal = math::normalize(math::cross(b->position - a->position, c->position - a->position));
-		
-		for (std::size_t i = 0; i < 3; ++i)
+		// Determine vertex morph target, the vertex's position on the surface of the parent patch
+		float3 target;
+		std::size_t barycentric_index;
+		if (index < corner_count)
 		{
-			const geom::mesh::vertex* vertex = face_vertices[i];
-			
-			// Vertex position
-			const float3& position = vertex->position;
-			*(v++) = position.x;
-			*(v++) = position.y;
-			*(v++) = position.z;
-			
-			// Vertex UV coordinates (latitude, longitude)
-			const float latitude = std::atan2(position.z, std::sqrt(position.x * position.x + position.y * position.y));
-			const float longitude = std::atan2(position.y, position.x);
-			*(v++) = latitude;
-			*(v++) = longitude;
+			const std::size_t i = index / (n + 1);
+			const std::size_t j = index % (n + 1);
 			
-			// Vertex normal
-			*(v++) = normal.x;
-			*(v++) = normal.y;
-			*(v++) = normal.z;
+			// Vertices which lie on the parent grid, or at the centers of parent cells, are shared with the parent. Odd vertices along parent cell edges lie midway between parent vertices.
+			if (i % 2 && !(j % 2))
+				target = (corner(i - 1, j) + corner(i + 1, j)) * 0.5f;
+			else if (!(i % 2) && j % 2)
+				target = (corner(i, j - 1) + corner(i, j + 1)) * 0.5f;
+			else
+				target = positions[index];
 			
-			/// @TODO Vertex tangent
-			*(v++) = 0.0f;
-			*(v++) = 0.0f;
-			*(v++) = 0.0f;
-			*(v++) = 0.0f;
+			barycentric_index = (i + j) % 2;
+		}
+		else
+		{
+			const std::size_t i = (index - corner_count) / n;
+			const std::size_t j = (index - corner_count) % n;
 			
-			// Vertex barycentric coordinates
-			*(v++) = barycentric[i].x;
-			*(v++) = barycentric[i].y;
-			*(v++) = barycentric[i].z;
+			// Cell centers lie midway along the parent edge between the nearest parent corner and the parent cell center
+			target = (corner(i + i % 2, j + j % 2) + corner(i - i % 2 + 1, j - j % 2 + 1)) * 0.5f;
 			
-			// Vertex morph target (LOD transition)
-			*(v++) = 0.0f;
-			*(v++) = 0.0f;
-			*(v++) = 0.0f;
+			barycentric_index = 2;
 		}
+		
+		// Vertex position
+		const float3& position = positions[index];
+		*(v++) = position.x;
+		*(v++) = position.y;
+		*(v++) = position.z;
+		
+		// Vertex UV coordinates (latitude, longitude)
+		const float latitude = std::atan2(position.z, std::sqrt(position.x * position.x + position.y * position.y));
+		const float longitude = std::atan2(position.y, position.x);
+		*(v++) = latitude;
+		*(v++) = longitude;
+		
+		// Vertex normal
+		const float3& normal = normals[index];
+		*(v++) = normal.x;
+		*(v++) = normal.y;
+		*(v++) = normal.z;
+		
+		/// @TODO Vertex tangent
+		*(v++) = 0.0f;
+		*(v++) = 0.0f;
+		*(v++) = 0.0f;
+		*(v++) = 0.0f;
+		
+		// Vertex barycentric coordinates
+		*(v++) = barycentric[barycentric_index].x;
+		*(v++) = barycentric[barycentric_index].y;
+		*(v++) = barycentric[barycentric_index].z;
+		
+		// Vertex morph target (LOD transition)
+		*(v++) = target.x;
+		*(v++) = target.y;
+		*(v++) = target.z;
 	}
+}
+
+model* terrain::generate_patch_model(const terrain_patch& patch, material* patch_material, model* patch_model) const
+{
+	const std::size_t size = patch_vertex_count * patch_vertex_stride;
 	
-	// Get triangle count of patch mesh
-	std::size_t patch_triangle_count = patch_mesh.get_faces().size();
+	// Reuse a recycled patch model
+	if (patch_model)
+	{
+		// Replace vertex data, in place if the size is unchanged
+		gl::vertex_buffer* vbo = patch_model->get_vertex_buffer();
+		if (vbo->get_size() == size)
+			vbo->update(0, size, patch.vertex_data);
+		else
+			vbo->resize(size, patch.vertex_data);
+		
+		model_group* patch_model_group = patch_model->get_group("terrain");
+		patch_model_group->set_material(patch_material);
+		patch_model->set_bounds(patch.bounds);
+		
+		return patch_model;
+	}
 	
 	// Allocate patch model
-	model* patch_model = new model();
-
+	patch_model = new model();
+	
 	// Resize model VBO and upload vertex data
 	gl::vertex_buffer* vbo = patch_model->get_vertex_buffer();
-	vbo->resize(patch_triangle_count * 3 * patch_vertex_stride, patch_vertex_data);
+	vbo->resize(size, patch.vertex_data);
 	
 	// Bind vertex attributes to model VAO
 	gl::vertex_array* vao = patch_model->get_vertex_array();
@@ -492,20 +1361,111 @@ model* terrain::generate_patch_model(const geom::mesh& patch_mesh, material* pat
 	vao->bind_attribute(VERTEX_TARGET_LOCATION, *vbo, 3, gl::vertex_attribute_type::float_32, patch_vertex_stride, sizeof(float) * offset);
 	offset += 3;
 	
-	// Create model group
+	// Bind shared patch index buffer to model VAO
+	vao->bind_elements(*patch_index_buffer);
+	
+	// Create model group, initially unstitched
 	model_group* patch_model_group = patch_model->add_group("terrain");
 	patch_model_group->set_material(patch_material);
 	patch_model_group->set_drawing_mode(gl::drawing_mode::triangles);
-	patch_model_group->set_start_index(0);
-	patch_model_group->set_index_count(patch_triangle_count * 3);
+	patch_model_group->set_element_type(gl::element_array_type::uint_32);
+	patch_model_group->set_start_index(patch_index_ranges[0].start);
+	patch_model_group->set_index_count(patch_index_ranges[0].count);
 	
-	// Calculate model bounds
-	geom::aabb<float> bounds = geom::calculate_bounds(patch_mesh);
-	patch_model->set_bounds(bounds);
+	// Set model bounds
+	patch_model->set_bounds(patch.bounds);
 	
 	return patch_model;
 }
 
+float terrain::node_error(std::uint8_t face_index, quadtree_node_type node, double body_radius) const
+{
+	// Extract node depth
+	quadtree_type::node_type node_depth = quadtree_type::depth(node);
+	
+	// Extract node location from Morton location code
+	quadtree_type::node_type node_location = quadtree_type::location(node);
+	quadtree_type::node_type node_location_x;
+	quadtree_type::node_type node_location_y;
+	geom::morton::decode(node_location, node_location_x, node_location_y);
+	
+	const double nodes_per_axis = std::exp2(node_depth);
+	const double node_width = 2.0 / nodes_per_axis;
+	
+	// Determine node center on front face of unit BCBF cube.
+	double3 center;
+	center.y = -(nodes_per_axis * 0.5 * node_width) + node_width * 0.5;
+	center.z = center.y;
+	center.y += static_cast<double>(node_location_x) * node_width;
+	center.z += static_cast<double>(node_location_y) * node_width;
+	center.x = 1.0;
+	
+	// Rotate node center according to cube face
+	/// @TODO Rather than rotating every center, "unrotate" observer position 6 times
+	center = face_rotations[face_index] * center;
+	
+	// Project node center onto unit sphere
+	double xx = center.x * center.x;
+	double yy = center.y * center.y;
+	double zz = center.z * center.z;
+	center.x *= std::sqrt(std::max(0.0, 1.0 - yy * 0.5 - zz * 0.5 + yy * zz / 3.0));
+	center.y *= std::sqrt(std::max(0.0, 1.0 - xx * 0.5 - zz * 0.5 + xx * zz / 3.0));
+	center.z *= std::sqrt(std::max(0.0, 1.0 - xx * 0.5 - yy * 0.5 + xx * yy / 3.0));
+	
+	// Scale node center by body radius
+	center *= body_radius;
+	center.y -= body_radius;
+	
+	const double horizontal_resolution = 1920.0;
+	const double geometric_error = static_cast<double>(524288.0 / std::exp2(node_depth));
+	
+	// Bound the node by its half-diagonal on the cube, which projection onto the sphere only shrinks, padded by its geometric error to account for elevation
+	const double bounding_radius = node_width * std::sqrt(2.0) * 0.5 * body_radius + geometric_error;
+	const geom::sphere<float> bounding_sphere(math::type_cast<float>(center), static_cast<float>(bounding_radius));
+	const double3 body_center = {0.0, -body_radius, 0.0};
+	
+	// Take the greatest error as seen by any observer to which the node is visible
+	double error = -1.0;
+	for (const observer_view& view: observer_views)
+	{
+		if (below_horizon(center, bounding_radius, body_center, body_radius, view.position))
+			continue;
+		if (!view.camera->get_view_frustum().get_bounds().intersects(bounding_sphere))
+			continue;
+		
+		const double distance = math::length(center - view.position);
+		error = std::max(error, screen_space_error(view.horizontal_fov, horizontal_resolution, distance, geometric_error));
+	}
+	
+	return static_cast<float>(error);
+}
+
+bool terrain::below_horizon(const double3& center, double radius, const double3& body_center, double body_radius, const double3& observer)
+{
+	const double3 observer_direction = observer - body_center;
+	const double observer_distance = math::length(observer_direction);
+	
+	// Observers below the surface see no horizon
+	if (observer_distance <= body_radius)
+		return false;
+	
+	const double3 target_direction = center - body_center;
+	const double target_distance = math::length(target_direction);
+	
+	// Spheres which contain the body center are never hidden
+	if (radius >= target_distance)
+		return false;
+	
+	// Angle between the observer and the sphere center, less the angular radius of the sphere
+	const double cosine = math::dot(observer_direction, target_direction) / (observer_distance * target_distance);
+	const double angle = std::acos(std::max(-1.0, std::min(1.0, cosine))) - std::asin(radius / target_distance);
+	
+	// Greatest angle at which a point at the sphere's farthest distance from the body center remains above the observer's horizon
+	const double horizon_angle = std::acos(body_radius / observer_distance) + std::acos(std::min(1.0, body_radius / (target_distance + radius)));
+	
+	return angle > horizon_angle;
+}
+
 double terrain::screen_space_error(double horizontal_fov, double horizontal_resolution, double distance, double geometric_error)
 {
 	// Calculate view frustum width at given distance
@@ -514,5 +1474,38 @@ double terrain::screen_space_error(double horizontal_fov, double horizontal_reso
 	return (geometric_error * horizontal_resolution) / frustum_width;
 }
 
+void terrain::draw_patches() const
+{
+	// Colors of successive depths, repeating every six depths
+	static const float4 depth_colors[6] =
+	{
+		{1.0f, 0.2f, 0.2f, 1.0f},
+		{1.0f, 0.6f, 0.2f, 1.0f},
+		{1.0f, 1.0f, 0.2f, 1.0f},
+		{0.2f, 1.0f, 0.2f, 1.0f},
+		{0.2f, 0.6f, 1.0f, 1.0f},
+		{0.8f, 0.2f, 1.0f, 1.0f}
+	};
+	
+	for (const auto& [terrain_eid, quadsphere]: terrain_quadspheres)
+	{
+		for (const terrain_quadsphere_face& face: quadsphere->faces)
+		{
+			for (const auto& [node, patch]: face.patches)
+			{
+				if (!patch->model_instance || !patch->model_instance->is_active())
+					continue;
+				
+				const std::size_t depth = static_cast<std::size_t>(quadtree_type::depth(node));
+				const float4& color = depth_colors[depth % 6];
+				const float3 origin = math::type_cast<float>(patch->origin);
+				const geom::aabb<float> bounds = {patch->bounds.min_point + origin, patch->bounds.max_point + origin};
+				debug::draw::box(bounds, color);
+				debug::draw::text((bounds.min_point + bounds.max_point) * 0.5f, std::to_string(depth), color);
+			}
+		}
+	}
+}
+
 } // namespace system
 } // namespace entity
@@ -25,30 +25,93 @@
 #include "entity/id.hpp"
 #include "math/quaternion-type.hpp"
 #include "geom/quadtree.hpp"
-#include "geom/mesh.hpp"
+#include "geom/aabb.hpp"
 #include "utility/fundamental-types.hpp"
 #include "renderer/model.hpp"
 #include "renderer/material.hpp"
+#include "renderer/material-property.hpp"
+#include "gl/vertex-buffer.hpp"
 #include "scene/model-instance.hpp"
 #include "scene/collection.hpp"
+#include "scene/camera.hpp"
+#include "utility/job-system.hpp"
+#include <atomic>
+#include <mutex>
 #include <unordered_map>
+#include <vector>
+
+class terrain_patch_cache;
 
 namespace entity {
 namespace system {
 
 /**
  * Generates and manages terrain with LOD based on distance to observers.
+ *
+ * Patch vertex data is generated by jobs, in order of the screen-space error of their quadtree nodes, and uploaded to the GPU by upload_patches(). Until all four children of a node have been uploaded, the patch of the node itself remains visible. Terrain elevation functions are evaluated concurrently if a job system has been set, and must therefore be thread-safe. The batch elevation function of a terrain is preferred over its per-vertex elevation function if both are set.
+ *
+ * Each patch stores only its unique grid vertices, which are drawn with a single index buffer shared by all patches. The index buffer contains sixteen variants of the patch grid, one for each combination of patch edges stitched to a coarser neighbor on the same quadsphere face.
+ *
+ * If a patch cache has been set, the vertex data of patches of terrains with nonzero seeds is loaded from the cache by the patch jobs, and stored in it by the jobs which generate patches which weren't cached, so that revisited regions and relaunches stream patches from disk rather than reevaluating elevations.
+ *
+ * The morph target of each patch vertex is its position on the surface of the patch's parent. Patch materials are copied per patch with an additional `morph` float property, on `[0, 1]`, by which a vertex shader should blend vertex positions toward their morph targets, so that patches converge on the geometry of their parents before merging and emerge from it after splitting.
  */
 class terrain: public updatable
 {
 public:
+	/// Identifies a terrain patch by its terrain, quadsphere face, and quadtree node.
+	struct patch_key
+	{
+		entity::id terrain_eid;
+		std::uint8_t face_index;
+		geom::linear_quadtree64::node_type node;
+	};
+	
+	/// Geometry of an uploaded terrain patch, valid only for the duration of patch_listener::patch_uploaded().
+	struct patch_geometry
+	{
+		patch_key key;
+		
+		/// Interleaved vertex data, with positions relative to the patch origin at offset `0` and normals at offset `5` of each vertex.
+		const float* vertex_data;
+		
+		/// Number of floats per vertex.
+		std::size_t vertex_size;
+		std::size_t vertex_count;
+		
+		/// Indices of the unstitched patch triangles.
+		const std::vector<std::uint32_t>* indices;
+		
+		/// Bounds of the patch vertices, relative to the patch origin.
+		const geom::aabb<float>* bounds;
+		
+		/// Double-precision origin of the patch. Vertex positions are relative to it, and it is the origin of the patch model instance.
+		double3 origin;
+		
+		/// Model instance of the patch, active whenever the patch is visible. Remains valid until the patch is released.
+		const scene::model_instance* model_instance;
+	};
+	
+	/// Receives terrain patch residency events, allowing other systems to attach content to terrain patches.
+	class patch_listener
+	{
+	public:
+		virtual ~patch_listener() = default;
+		
+		/// Called by upload_patches() once a patch has been uploaded.
+		virtual void patch_uploaded(const patch_geometry& geometry) = 0;
+		
+		/// Called once an uploaded patch has been evicted or freed. Called while the terrain system is updating, or from its destructor.
+		virtual void patch_released(const patch_key& key) = 0;
+	};
+	
 	terrain(entity::registry& registry);
 	~terrain();
 	
 	virtual void update(double t, double dt);
 	
 	/**
-	 * Sets the number of subdivisions for a patch. Zero subdivisions results in a single quad, one subdivison results in four quads, etc.
+	 * Sets the number of subdivisions for a patch. Zero subdivisions results in a single quad, one subdivison results in four quads, etc. The number of quads per patch axis is rounded up to an even number, so that every other patch vertex lies on the grid of the patch's parent. Should be set before any patches have been generated.
 	 *
 	 * @param n Number of subdivisions.
 	 */
@@ -67,18 +130,138 @@ public:
 	 * @param error Maximum tolerable screen-space error.
 	 */
 	void set_max_error(double error);
+	
+	/**
+	 * Sets the level of detail hysteresis. Quadtree nodes are split once their screen-space error exceeds the maximum tolerable error, and merged once the error of their parent falls below `max_error * (1 - hysteresis)`, so that nodes near the threshold don't split and merge repeatedly.
+	 *
+	 * @param hysteresis Fraction of the maximum tolerable error, on `[0, 1]`.
+	 */
+	void set_lod_hysteresis(double hysteresis);
+	
+	/**
+	 * Sets the job system on which terrain patches are generated.
+	 *
+	 * @param jobs Job system, or `nullptr` to generate patches on the updating thread.
+	 */
+	void set_job_system(job_system* jobs);
+	
+	/**
+	 * Sets the maximum number of terrain patches uploaded by each call to upload_patches().
+	 *
+	 * @param budget Patch upload budget.
+	 */
+	void set_patch_upload_budget(std::size_t budget);
+	
+	/**
+	 * Sets the memory budget of cached terrain patches. The memory of a patch is approximated by the size of its vertex data. Once the budget is exceeded, the least recently visible patches whose nodes are no longer in their quadtrees are evicted, and their models and model instances returned to a pool for reuse by new patches.
+	 *
+	 * @param budget Patch memory budget, in bytes.
+	 */
+	void set_patch_memory_budget(std::size_t budget);
+	
+	/**
+	 * Sets the on-disk cache from which generated patches are loaded, and in which they are stored. Patches generated before the cache was set are not stored.
+	 *
+	 * @param cache Terrain patch cache, or `nullptr` to always generate patches.
+	 */
+	void set_patch_cache(::terrain_patch_cache* cache);
+	
+	/**
+	 * Uploads generated terrain patches to the GPU, in order of screen-space error, up to the patch upload budget. Must be called once per frame, by the thread which owns the OpenGL context, while the system is not updating.
+	 */
+	void upload_patches();
+	
+	/**
+	 * Adds a listener which receives terrain patch residency events.
+	 *
+	 * @param listener Patch listener.
+	 */
+	void add_patch_listener(patch_listener* listener);
+	
+	/// Returns the maximum tolerable screen-space error.
+	double get_max_error() const;
+	
+	/// Elevation and normal of a terrain surface.
+	struct surface_sample
+	{
+		/// Elevation above the body radius, in meters.
+		double elevation;
+		
+		/// Outward unit normal of the surface, in the BCBF space of the terrain body.
+		double3 normal;
+	};
+	
+	/**
+	 * Samples the surface of a terrain at a latitude and longitude.
+	 *
+	 * The surface is interpolated over the triangles of the finest uploaded patch containing the point, so that samples agree with the unmorphed geometry of the patch and cost a handful of hash lookups rather than an evaluation of the elevation function. Where no patch containing the point has been uploaded, the elevation function of the terrain is evaluated instead, and the normal found by finite differences. May be called concurrently by systems which update while the terrain system is not updating.
+	 *
+	 * @param terrain_eid Entity ID of a terrain with a celestial body.
+	 * @param latitude Latitude, in radians.
+	 * @param longitude Longitude, in radians.
+	 * @return Surface sample, with zero elevation and a radial normal if the entity is not a terrain.
+	 */
+	surface_sample sample_surface(entity::id terrain_eid, double latitude, double longitude) const;
+	
+	/**
+	 * Samples the surface of a terrain at many points, as by sample_surface(). The elevations of points without an uploaded patch are evaluated by a single call to the batch elevation function of the terrain, if it has one.
+	 *
+	 * @param terrain_eid Entity ID of a terrain with a celestial body.
+	 * @param latitudes Latitudes of the points, in radians.
+	 * @param longitudes Longitudes of the points, in radians.
+	 * @param[out] samples Surface sample of each point.
+	 * @param count Number of points.
+	 */
+	void sample_surface(entity::id terrain_eid, const double* latitudes, const double* longitudes, surface_sample* samples, std::size_t count) const;
+	
+	/// Returns the elevation of a terrain at a latitude and longitude, as sampled by sample_surface().
+	double get_elevation(entity::id terrain_eid, double latitude, double longitude) const;
 
 private:
-	typedef geom::quadtree64 quadtree_type;
+	typedef geom::linear_quadtree64 quadtree_type;
 	typedef quadtree_type::node_type quadtree_node_type;
 	
 	struct terrain_patch
 	{
-		geom::mesh* mesh;
 		model* model;
 		scene::model_instance* model_instance;
 		float error;
+		
+		/// Blend factor between the patch geometry and its morph targets.
 		float morph;
+		
+		/// Copy of the terrain material, with a `morph` property, assigned to the patch model instance.
+		::material* material;
+		
+		/// `morph` property of the patch material, or `nullptr` if the terrain has no material.
+		material_property<float>* morph_property;
+		
+		/// Bounds of the patch vertices, relative to the patch origin.
+		geom::aabb<float> bounds;
+		
+		/// Double-precision origin of the patch, relative to which its vertices are positioned.
+		double3 origin;
+		
+		/// Entity ID of the terrain to which the patch belongs.
+		entity::id terrain_eid;
+		
+		/// Index of the quadsphere face to which the patch belongs.
+		std::uint8_t face_index;
+		
+		/// Quadtree node of the patch.
+		quadtree_node_type node;
+		
+		/// Interleaved vertex data generated by the patch job, freed once uploaded.
+		float* vertex_data;
+		
+		/// Elevations of the patch vertices, in the order of the vertex data, which are kept once the vertex data is freed for surface queries.
+		std::vector<float> elevations;
+		
+		/// `true` if the patch model has been uploaded for the patch's current node.
+		bool uploaded;
+		
+		/// Update count at which the patch was last visible.
+		std::size_t last_visible;
 	};
 	
 	/// Single face of a terrain quadsphere
@@ -89,6 +272,17 @@ private:
 		
 		/// Map linking quadtree nodes to terrain patches
 		std::unordered_map<quadtree_node_type, terrain_patch*> patches;
+		
+		/// Screen-space errors of quadtree nodes, as of the most recent refinement
+		std::unordered_map<quadtree_node_type, float> errors;
+	};
+	
+	/// Position and field of view of an observer, in the BCBF space of a terrain body.
+	struct observer_view
+	{
+		double3 position;
+		double horizontal_fov;
+		const scene::camera* camera;
 	};
 	
 	/// A terrain quadsphere with six faces.
@@ -101,36 +295,169 @@ private:
 	
 	static double screen_space_error(double horizontal_fov, double horizontal_resolution, double distance, double geometric_error);
 	
+	/**
+	 * Returns the greatest screen-space error of a quadtree node as seen by the collected observers, ignoring observers for which the node's bounding sphere is below the horizon or outside the view frustum.
+	 *
+	 * @return Screen-space error, or `-1` if the node is not visible to any observer.
+	 */
+	float node_error(std::uint8_t face_index, quadtree_node_type node, double body_radius) const;
+	
+	/**
+	 * Returns `true` if a sphere is entirely hidden below the horizon of an observer, with the body as the occluder. Terrain is assumed not to fall below the body radius.
+	 *
+	 * @param center Center of the sphere.
+	 * @param radius Radius of the sphere.
+	 * @param body_center Center of the occluding body.
+	 * @param body_radius Radius of the occluding body.
+	 * @param observer Position of the observer.
+	 */
+	static bool below_horizon(const double3& center, double radius, const double3& body_center, double body_radius, const double3& observer);
+	
 	void on_terrain_construct(entity::registry& registry, entity::id entity_id, entity::component::terrain& component);
 	void on_terrain_destroy(entity::registry& registry, entity::id entity_id);
 	
 	/**
-	 * Generates a mesh for a terrain patch given the patch's quadtree node
+	 * Generates the positions of the unique grid vertices of a terrain patch given the patch's quadtree node: `(n + 1)^2` cell corners, in rows of `n + 1`, followed by `n^2` cell centers, in rows of `n`, where `n` is the number of cells per patch axis.
+	 *
+	 * Positions are relative to the central cell corner of the patch, so that they remain precise in single precision however far the patch lies from the observer.
+	 *
+	 * @param[out] origin Double-precision position of the central cell corner of the patch.
+	 */
+	void generate_patch_positions(std::uint8_t face_index, quadtree_node_type node, double body_radius, const component::terrain& terrain_component, float3* positions, double3& origin) const;
+	
+	/**
+	 * Fills a buffer with the interleaved vertex data of a patch, given the positions of its grid vertices.
+	 */
+	void generate_patch_vertices(const float3* positions, float* vertex_data) const;
+	
+	/**
+	 * Generates the vertex data and bounds of a terrain patch, or loads them from the patch cache. Safe to call from any thread.
+	 */
+	void generate_patch(terrain_patch* patch, double body_radius, const component::terrain& terrain_component) const;
+	
+	/**
+	 * Generates a model for a terrain patch given the patch's vertex data.
+	 *
+	 * @param patch_model Recycled patch model to reuse, or `nullptr` to allocate a new model.
 	 */
-	geom::mesh* generate_patch_mesh(std::uint8_t face_index, quadtree_node_type node, double body_radius, const std::function<double(double, double)>& elevation) const;
+	model* generate_patch_model(const terrain_patch& patch, material* patch_material, model* patch_model) const;
+	
+	/// Discards requests for nodes which are no longer in their quadtrees, then submits patch jobs for the requests of the highest screen-space error.
+	void dispatch_patch_requests();
+	
+	/// Activates the patches of a node or of its descendants, preferring descendants only once all of a node's children have been uploaded, and updates the stitching and morph factors of activated patches.
+	void update_patch_visibility(terrain_quadsphere_face& face, quadtree_node_type node);
 	
 	/**
-	 * Generates a model for a terrain patch given the patch's mesh.
+	 * Returns the edges of a patch which border coarser patches on the same quadsphere face.
+	 *
+	 * @return Bit mask of stitched edges, in the order of -y, +y, -z, +z in the cube space of the face.
 	 */
-	model* generate_patch_model(const geom::mesh& patch_mesh, material* patch_material) const;
+	static std::uint8_t patch_stitch_mask(const terrain_quadsphere_face& face, quadtree_node_type node);
+	
+	/// Rebuilds the shared patch index buffer and its stitching variants.
+	void generate_patch_indices();
 	
+	/// Evicts the least recently visible patches while the patch memory budget is exceeded.
+	void evict_patches();
 	
+	/// Releases the vertex data of a patch and returns it to the patch pool.
+	void recycle_patch(terrain_patch* patch);
+	
+	/// Waits for all submitted patch jobs to complete.
+	void wait_for_patch_jobs();
+	
+	/// Removes a patch from the scene and frees it.
+	void free_patch(terrain_patch* patch);
+	
+	/// Extracts the elevations of the vertices of a patch from its vertex data.
+	void store_patch_elevations(terrain_patch* patch, double body_radius) const;
+	
+	/**
+	 * Projects a point on a face of the unit cube onto the unit sphere.
+	 *
+	 * @param face_index Index of a quadsphere face.
+	 * @param u,v Coordinates of the point on the face, on `[-1, 1]`, along the axes of the quadtree locations of the face.
+	 * @return Direction of the point.
+	 */
+	double3 project_face_point(std::uint8_t face_index, double u, double v) const;
+	
+	/**
+	 * Finds the quadsphere face of a direction and its coordinates on the face, inverting project_face_point().
+	 *
+	 * @param direction Unit direction.
+	 * @param[out] u,v Coordinates of the direction on the face, on `[-1, 1]`.
+	 * @return Index of the quadsphere face.
+	 */
+	std::uint8_t unproject_face_point(const double3& direction, double& u, double& v) const;
+	
+	/**
+	 * Samples the surface of the finest uploaded patch containing a point of a terrain quadsphere.
+	 *
+	 * @return `true` if an uploaded patch contains the point, `false` otherwise.
+	 */
+	bool sample_patches(const terrain_quadsphere& quadsphere, std::size_t max_lod, double body_radius, const double3& direction, surface_sample& sample) const;
+	
+	/// Draws the bounds of visible patches with debug::draw, colored and labeled by depth.
+	void draw_patches() const;
 	
-	/// @TODO horizon culling
 	
 	std::uint8_t patch_subdivisions;
+	std::size_t patch_cells;
 	std::size_t patch_vertex_size;
 	std::size_t patch_vertex_stride;
 	std::size_t patch_vertex_count;
-	float* patch_vertex_data;
 	math::quaternion<double> face_rotations[6];
-	geom::mesh* patch_base_mesh;
+	
+	/// Range of the shared patch index buffer.
+	struct index_range
+	{
+		std::size_t start;
+		std::size_t count;
+	};
+	
+	/// Index buffer shared by all patch models.
+	gl::vertex_buffer* patch_index_buffer;
+	
+	/// Ranges of the stitching variants in the shared patch index buffer, indexed by stitch mask.
+	index_range patch_index_ranges[16];
+	
+	/// Indices of the unstitched patch triangles, from which vertex normals are calculated.
+	std::vector<std::uint32_t> patch_normal_indices;
+	
 	scene::collection* patch_scene_collection;
 	double max_error;
+	double lod_hysteresis;
+	std::vector<observer_view> observer_views;
+	std::vector<quadtree_node_type> refinement_stack;
+	std::vector<quadtree_node_type> refinement_nodes;
 	
 	std::unordered_map<entity::id, terrain_quadsphere*> terrain_quadspheres;
+	
+	job_system* jobs;
+	job_system::counter patch_counter;
+	std::atomic<std::size_t> patch_jobs_in_flight;
+	std::vector<terrain_patch*> patch_requests;
+	std::mutex generated_patches_mutex;
+	std::vector<terrain_patch*> generated_patches;
+	std::size_t patch_upload_budget;
+	std::size_t patch_memory_budget;
+	::terrain_patch_cache* patch_cache;
+	std::size_t uploaded_patch_count;
+	std::size_t update_count;
+	
+	/// Maximum number of recycled patches kept for reuse.
+	static constexpr std::size_t max_pooled_patches = 32;
+	std::vector<terrain_patch*> patch_pool;
+	
+	std::vector<patch_listener*> listeners;
 };
 
+inline double terrain::get_max_error() const
+{
+	return max_error;
+}
+
 } // namespace system
 } // namespace entity
 
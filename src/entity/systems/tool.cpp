@@ -18,7 +18,8 @@
  */
 
 #include "tool.hpp"
-#include "entity/components/collision.hpp"
+#include "entity/systems/collision.hpp"
+#include "renderer/passes/picking-pass.hpp"
 #include "entity/components/tool.hpp"
 #include "entity/components/transform.hpp"
 #include "event/event-dispatcher.hpp"
@@ -36,6 +37,9 @@ namespace system {
 tool::tool(entity::registry& registry, ::event_dispatcher* event_dispatcher):
 	updatable(registry),
 	event_dispatcher(event_dispatcher),
+	collision_system(nullptr),
+	picking_pass(nullptr),
+	picked_entity(entt::null),
 	camera(nullptr),
 	orbit_cam(orbit_cam),
 	viewport{0, 0, 0, 0},
@@ -111,39 +115,38 @@ void tool::update(double t, double dt)
 	float3 pick_direction = math::normalize(pick_far - pick_near);
 	geom::ray<float> picking_ray = {pick_near, pick_direction};
 
-	float a = std::numeric_limits<float>::infinity();
-	bool intersection = false;
 	float3 pick;
 
-	// Cast ray from cursor to collision components to find closest intersection
-	registry.view<component::transform, component::collision>().each(
-		[&](entity::id entity_id, auto& transform, auto& collision)
+	if (picking_pass)
+	{
+		// Pick the geometry under the cursor on the GPU, using the most recent result to have been read back
+		picking_pass->set_pick_point({mouse_position[0], viewport[3] - mouse_position[1]}, viewport);
+		if (picking_pass->has_pick_result())
 		{
-			math::transform<float> inverse_transform = math::inverse(transform.local);
-			float3 origin = inverse_transform * pick_origin;
-			float3 direction = math::normalize(math::conjugate(transform.local.rotation) * pick_direction);
-			geom::ray<float> transformed_ray = {origin, direction};
-
-			// Broad phase AABB test
-			auto aabb_result = geom::ray_aabb_intersection(transformed_ray, collision.bounds);
-			if (!std::get<0>(aabb_result))
-			{
-				return;
-			}
-
-			// Narrow phase mesh test
-			auto mesh_result = collision.mesh_accelerator.query_nearest(transformed_ray);
-			if (mesh_result)
+			const ::picking_pass::pick_result& result = picking_pass->get_pick_result();
+			if (result.hit)
 			{
-				intersection = true;
-				if (mesh_result->t < a)
-				{
-					a = mesh_result->t;
-					pick = picking_ray.extrapolate(a);
-					pick_spring.x1 = pick;
-				}
+				pick = result.position;
+				pick_spring.x1 = pick;
 			}
-		});
+			
+			// Pick IDs are entity IDs offset by one
+			picked_entity = (result.id) ? static_cast<entity::id>(result.id - 1) : entt::null;
+			if (picked_entity != entt::null && !registry.valid(picked_entity))
+				picked_entity = entt::null;
+		}
+	}
+	else if (collision_system)
+	{
+		// Cast ray from cursor to collision components to find closest intersection
+		picked_entity = entt::null;
+		if (auto result = collision_system->query_nearest(picking_ray))
+		{
+			pick = picking_ray.extrapolate(result->t);
+			pick_spring.x1 = pick;
+			picked_entity = result->entity_id;
+		}
+	}
 	
 	const float3& camera_position = camera->get_translation();
 	float3 pick_planar_position = float3{pick.x, 0, pick.z};
@@ -250,6 +253,16 @@ void tool::set_sun_direction(const float3& direction)
 	sun_direction = direction;
 }
 
+void tool::set_collision_system(const collision* collision_system)
+{
+	this->collision_system = collision_system;
+}
+
+void tool::set_picking_pass(::picking_pass* pass)
+{
+	picking_pass = pass;
+}
+
 void tool::set_active_tool(entity::id entity_id)
 {
 	if (active_tool == entity_id)
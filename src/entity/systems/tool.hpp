@@ -32,10 +32,13 @@
 
 class orbit_cam;
 class event_dispatcher;
+class picking_pass;
 
 namespace entity {
 namespace system {
 
+class collision;
+
 class tool:
 	public updatable,
 	public event_handler<mouse_moved_event>,
@@ -52,17 +55,33 @@ public:
 	void set_pick(bool enabled);
 	void set_sun_direction(const float3& direction);
 	
+	/// Sets the collision system against which the cursor is picked.
+	void set_collision_system(const collision* collision_system);
+	
+	/**
+	 * Sets the picking pass by which the cursor is picked, in place of ray casts against the collision system. Picks lag the cursor by the latency of the picking pass readbacks.
+	 *
+	 * @param pass Picking pass, or `nullptr` to pick against the collision system.
+	 */
+	void set_picking_pass(::picking_pass* pass);
+	
 	void set_active_tool(entity::id entity_id);
 	
 	void set_tool_active(bool active);
 	
 	entity::id get_active_tool() const;
 	
+	/// Returns the entity under the cursor, as of the most recent pick, or `entt::null` if no entity was picked.
+	entity::id get_picked_entity() const;
+	
 private:
 	virtual void handle_event(const mouse_moved_event& event);
 	virtual void handle_event(const window_resized_event& event);
 
 	event_dispatcher* event_dispatcher;
+	const collision* collision_system;
+	::picking_pass* picking_pass;
+	entity::id picked_entity;
 	const scene::camera* camera;
 	const orbit_cam* orbit_cam;
 	float4 viewport;
@@ -88,6 +107,11 @@ inline entity::id tool::get_active_tool() const
 	return active_tool;
 }
 
+inline entity::id tool::get_picked_entity() const
+{
+	return picked_entity;
+}
+
 } // namespace system
 } // namespace entity
 
@@ -27,8 +27,14 @@
 #include "math/math.hpp"
 #include "renderer/material.hpp"
 #include "renderer/model.hpp"
+#include "renderer/vertex-attributes.hpp"
+#include "gl/vertex-array.hpp"
+#include "gl/vertex-buffer.hpp"
+#include "gl/vertex-attribute-type.hpp"
 #include "utility/fundamental-types.hpp"
 #include "entity/commands.hpp"
+#include <algorithm>
+#include <limits>
 
 namespace entity {
 namespace system {
@@ -37,26 +43,21 @@ tracking::tracking(entity::registry& registry, ::event_dispatcher* event_dispatc
 	updatable(registry),
 	event_dispatcher(event_dispatcher),
 	resource_manager(resource_manager),
-	scene_collection(nullptr)
+	scene_collection(nullptr),
+	instances_updated(false),
+	instanced_model(nullptr),
+	model_instance(nullptr)
 {
-	registry.on_construct<component::trackable>().connect<&tracking::on_component_construct>(this);
-	registry.on_destroy<component::trackable>().connect<&tracking::on_component_destroy>(this);
+	declare_reads<component::trackable, component::transform, component::marker>();
 	
-	// Load paint ball model
-	paint_ball_model = resource_manager->load<model>("paint-ball.mdl");
+	// Keep tracked entities packed in the order of the group
+	registry.group<component::trackable>(entt::get<component::transform, component::marker>);
 	
 	// Load tracker model
 	tracker_model = resource_manager->load<model>("tracker.mdl");
 	
-	// Load paint ball materials
-	paint_ball_materials = new material*[7];
-	paint_ball_materials[0] = resource_manager->load<material>("paint-ball-yellow.mtl");
-	paint_ball_materials[1] = resource_manager->load<material>("paint-ball-green.mtl");
-	paint_ball_materials[2] = resource_manager->load<material>("paint-ball-blue.mtl");
-	paint_ball_materials[3] = resource_manager->load<material>("paint-ball-purple.mtl");
-	paint_ball_materials[4] = resource_manager->load<material>("paint-ball-pink.mtl");
-	paint_ball_materials[5] = resource_manager->load<material>("paint-ball-red.mtl");
-	paint_ball_materials[6] = resource_manager->load<material>("paint-ball-orange.mtl");
+	// Load paint ball material, which selects the paint color of each instance from a palette
+	paint_ball_material = resource_manager->load<material>("paint-ball-palette.mtl");
 	
 	event_dispatcher->subscribe<tool_pressed_event>(this);
 	event_dispatcher->subscribe<tool_released_event>(this);
@@ -67,87 +68,142 @@ tracking::~tracking()
 	event_dispatcher->unsubscribe<tool_pressed_event>(this);
 	event_dispatcher->unsubscribe<tool_released_event>(this);
 	
-	for (auto it = trackers.begin(); it != trackers.end(); ++it)
+	if (model_instance)
 	{
-		delete it->second;
+		if (scene_collection)
+			scene_collection->remove_object(model_instance);
+		delete model_instance;
 	}
-	
-	delete[] paint_ball_materials;
+	delete instanced_model;
 }
 
-
 void tracking::update(double t, double dt)
 {
-	for (auto it = trackers.begin(); it != trackers.end(); ++it)
-	{
-		const component::transform& transform = registry.get<component::transform>(it->first);
-		
-		// Project world coordinates to screen coordinates
-		
-		// Update billboard position
-		it->second->set_translation(transform.world.translation);
-		if (transform.warp)
+	auto group = registry.group<component::trackable>(entt::get<component::transform, component::marker>);
+	
+	// Copy the positions and colors of tracked entities into instances, in the order of the group
+	instances.resize(group.size());
+	const float inf = std::numeric_limits<float>::infinity();
+	instance_bounds = {{inf, inf, inf}, {-inf, -inf, -inf}};
+	std::size_t i = 0;
+	group.each
+	(
+		[&](entity::id entity_id, const auto& trackable, const auto& transform, const auto& marker)
 		{
-			it->second->update_tweens();
+			tracker_instance& instance = instances[i++];
+			instance.position = transform.world.translation;
+			instance.color = static_cast<float>(std::max(0, marker.color - 1));
+			
+			for (int j = 0; j < 3; ++j)
+			{
+				instance_bounds.min_point[j] = std::min(instance_bounds.min_point[j], instance.position[j]);
+				instance_bounds.max_point[j] = std::max(instance_bounds.max_point[j], instance.position[j]);
+			}
 		}
-	}
+	);
+	
+	instances_updated = true;
 }
 
 void tracking::set_scene(scene::collection* collection)
 {
+	if (model_instance)
+	{
+		if (scene_collection)
+			scene_collection->remove_object(model_instance);
+		if (collection)
+			collection->add_object(model_instance);
+	}
+	
 	this->scene_collection = collection;
 }
 
-void tracking::on_component_construct(entity::registry& registry, entity::id entity_id, component::trackable& component)
+void tracking::upload_instances()
 {
-
-}
-
-void tracking::on_component_destroy(entity::registry& registry, entity::id entity_id)
-{
-	if (auto it = trackers.find(entity_id); it != trackers.end())
+	if (!instances_updated || !tracker_model)
+		return;
+	instances_updated = false;
+	
+	const std::size_t size = instances.size() * sizeof(tracker_instance);
+	if (!instanced_model)
 	{
-		// Remove model instance from all layers
-		/*
-		for (std::size_t i = 0; i < layers.size(); ++i)
+		// Skip creating the instanced model until there is a tracker to draw
+		if (instances.empty())
+			return;
+		
+		instanced_model = new model();
+		
+		// Bind the vertex attributes of the tracker model, followed by the per-instance attributes
+		const gl::vertex_array* source_vao = tracker_model->get_vertex_array();
+		gl::vertex_buffer* vbo = instanced_model->get_vertex_buffer();
+		vbo->resize(size, instances.data());
+		gl::vertex_array* vao = instanced_model->get_vertex_array();
+		for (const auto& attribute: source_vao->get_attributes())
+		{
+			const gl::vertex_array::attribute_binding& binding = attribute.second;
+			vao->bind_attribute(attribute.first, *binding.buffer, binding.size, binding.type, binding.stride, binding.offset, binding.normalized);
+		}
+		if (source_vao->get_element_buffer())
+			vao->bind_elements(*source_vao->get_element_buffer());
+		vao->bind_attribute(VERTEX_INSTANCE_POSITION_LOCATION, *vbo, 3, gl::vertex_attribute_type::float_32, sizeof(tracker_instance), 0);
+		vao->bind_attribute(VERTEX_INSTANCE_COLOR_LOCATION, *vbo, 1, gl::vertex_attribute_type::float_32, sizeof(tracker_instance), sizeof(float3));
+		vao->set_attribute_divisor(VERTEX_INSTANCE_POSITION_LOCATION, 1);
+		vao->set_attribute_divisor(VERTEX_INSTANCE_COLOR_LOCATION, 1);
+		
+		// Copy the model groups of the tracker model, drawing paint balls of all colors with the palette material
+		for (const model_group* source_group: *tracker_model->get_groups())
 		{
-			layers[i]->remove_object(it->second);
+			model_group* group = instanced_model->add_group(source_group->get_name());
+			::material* group_material = const_cast<::material*>(source_group->get_material());
+			if (source_group->get_name() == "paint-ball" && paint_ball_material)
+				group_material = paint_ball_material;
+			group->set_material(group_material);
+			group->set_drawing_mode(source_group->get_drawing_mode());
+			group->set_start_index(source_group->get_start_index());
+			group->set_index_count(source_group->get_index_count());
+			if (source_group->is_indexed())
+				group->set_element_type(source_group->get_element_type());
 		}
-		*/
 		
-		delete it->second;
-		trackers.erase(it);
+		model_instance = new scene::model_instance(instanced_model);
+		if (scene_collection)
+			scene_collection->add_object(model_instance);
+	}
+	else
+	{
+		gl::vertex_buffer* vbo = instanced_model->get_vertex_buffer();
+		if (vbo->get_size() == size)
+			vbo->update(0, size, instances.data());
+		else
+			vbo->resize(size, instances.data());
+	}
+	
+	// Bound the trackers by the bounds of the tracker model about each tracked position
+	if (!instances.empty())
+	{
+		const geom::aabb<float>& model_bounds = tracker_model->get_bounds();
+		instanced_model->set_bounds({instance_bounds.min_point + model_bounds.min_point, instance_bounds.max_point + model_bounds.max_point});
+		model_instance->update_bounds();
 	}
+	
+	model_instance->set_active(!instances.empty());
+	model_instance->set_instanced(true, instances.size());
 }
 
 void tracking::handle_event(const tool_pressed_event& event)
 {
 	if (registry.has<component::marker>(event.entity_id))
 	{
-		math::transform<float> transform = command::get_world_transform(registry, event.entity_id);
-		
-		int marker_index = registry.get<component::marker>(event.entity_id).color;
-		
+		const int marker_index = registry.get<component::marker>(event.entity_id).color;
 		if (marker_index > 0)
 		{
-			const float tracker_scale = 1.0f;
-			
-			// Create tracker model instance
-			scene::model_instance* instance = new scene::model_instance();
-			instance->set_model(tracker_model);
-			instance->set_translation(transform.translation);
-			instance->set_scale(float3{tracker_scale, tracker_scale, tracker_scale});
-			
-			// Set tracker paint ball material
-			const model_group* paint_ball_model_group = tracker_model->get_group("paint-ball");
-			if (paint_ball_model_group != nullptr)
-			{
-				instance->set_material(paint_ball_model_group->get_index(), paint_ball_materials[marker_index - 1]);
-			}
-
-			instance->update_tweens();
+			// Create a tracked entity at the tool, which is drawn as a tracker by the next update
+			const math::transform<float> transform = command::get_world_transform(registry, event.entity_id);
 			
-			scene_collection->add_object(instance);
+			entity::id tracker_eid = registry.create();
+			registry.assign<component::transform>(tracker_eid, component::transform{transform, transform, true});
+			registry.assign<component::marker>(tracker_eid, component::marker{marker_index});
+			registry.assign<component::trackable>(tracker_eid, component::trackable{0.0f});
 		}
 	}
 }
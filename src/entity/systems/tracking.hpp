@@ -25,9 +25,11 @@
 #include "entity/id.hpp"
 #include "event/event-handler.hpp"
 #include "game/events/tool-events.hpp"
-#include <unordered_map>
+#include "geom/aabb.hpp"
 #include "scene/collection.hpp"
 #include "scene/model-instance.hpp"
+#include "utility/fundamental-types.hpp"
+#include <vector>
 
 class material;
 class event_dispatcher;
@@ -37,6 +39,13 @@ class model;
 namespace entity {
 namespace system {
 
+/**
+ * Marks tagged entities with trackers.
+ *
+ * Entities with trackable, transform, and marker components are tracked. Trackers are stored densely, in the order of a group of the tracked entities: each update copies the world positions and marker colors of the group into an array of instances, without looking up components by entity. All trackers are drawn by a single instanced draw of the tracker model, whose paint ball group is drawn with a palette material. Instances are stored as a position, bound to @ref VERTEX_INSTANCE_POSITION_LOCATION, followed by the index of a marker color, bound to @ref VERTEX_INSTANCE_COLOR_LOCATION, by which the shaders of the tracker model should place each instance and select its paint color. As the system may be updated on any thread, it makes no OpenGL calls while updating.
+ *
+ * Pressing the marker tool with a paint color creates a tracked entity at the tool.
+ */
 class tracking: public updatable,
 	public event_handler<tool_pressed_event>,
 	public event_handler<tool_released_event>
@@ -49,9 +58,24 @@ public:
 	void set_scene(scene::collection* collection);
 	void set_viewport(const float4& viewport);
 	
+	/**
+	 * Uploads the tracker instances of the most recent update to the GPU, creating the instanced model if necessary. Must be called once per frame, by the thread which owns the OpenGL context, while the system is not updating.
+	 */
+	void upload_instances();
+	
+	/// Returns the number of trackers.
+	std::size_t get_tracker_count() const;
+	
 private:
-	void on_component_construct(entity::registry& registry, entity::id entity_id, entity::component::trackable& component);
-	void on_component_destroy(entity::registry& registry, entity::id entity_id);
+	/// Tracker instance, as stored in the instance buffer.
+	struct tracker_instance
+	{
+		float3 position;
+		
+		/// Index of the marker color, starting at `0` for the first paint color.
+		float color;
+	};
+	
 	virtual void handle_event(const tool_pressed_event& event);
 	virtual void handle_event(const tool_released_event& event);
 	
@@ -59,11 +83,22 @@ private:
 	resource_manager* resource_manager;
 	scene::collection* scene_collection;
 	model* tracker_model;
-	model* paint_ball_model;
-	material** paint_ball_materials;
-	std::unordered_map<entity::id, scene::model_instance*> trackers;
+	material* paint_ball_material;
+	
+	/// Instances of the most recent update, in the order of the group of tracked entities.
+	std::vector<tracker_instance> instances;
+	geom::aabb<float> instance_bounds;
+	bool instances_updated;
+	
+	model* instanced_model;
+	scene::model_instance* model_instance;
 };
 
+inline std::size_t tracking::get_tracker_count() const
+{
+	return instances.size();
+}
+
 } // namespace system
 } // namespace entity
 
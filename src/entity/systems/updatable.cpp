@@ -23,7 +23,8 @@ namespace entity {
 namespace system {
 
 updatable::updatable(entity::registry& registry):
-	registry(registry)
+	registry(registry),
+	declared_access(false)
 {}
 
 } // namespace system
@@ -21,6 +21,8 @@
 #define ANTKEEPER_ENTITY_SYSTEM_UPDATABLE_HPP
 
 #include "entity/registry.hpp"
+#include <typeindex>
+#include <vector>
 
 namespace entity {
 namespace system {
@@ -47,11 +49,77 @@ public:
 	 */
 	virtual void update(double t, double dt) = 0;
 	
+	/// Returns the component types read by the system's update() function.
+	const std::vector<std::type_index>& get_reads() const;
+	
+	/// Returns the component types written by the system's update() function.
+	const std::vector<std::type_index>& get_writes() const;
+	
+	/**
+	 * Returns `true` if the system has declared which components it accesses. Systems which have not declared their component access are assumed to access the entire registry.
+	 *
+	 * @see entity::system::scheduler
+	 */
+	bool has_declared_access() const;
+	
 protected:
+	/**
+	 * Declares component types read by the system's update() function. May be called with no types to declare that the system accesses no other components.
+	 *
+	 * @tparam Components Component types read by the system.
+	 */
+	template <class... Components>
+	void declare_reads();
+	
+	/**
+	 * Declares component types written by the system's update() function. May be called with no types to declare that the system accesses no other components.
+	 *
+	 * @tparam Components Component types written by the system.
+	 */
+	template <class... Components>
+	void declare_writes();
+	
 	/// Registry on which the system operate
 	entity::registry& registry;
+
+private:
+	std::vector<std::type_index> reads;
+	std::vector<std::type_index> writes;
+	bool declared_access;
 };
 
+inline const std::vector<std::type_index>& updatable::get_reads() const
+{
+	return reads;
+}
+
+inline const std::vector<std::type_index>& updatable::get_writes() const
+{
+	return writes;
+}
+
+inline bool updatable::has_declared_access() const
+{
+	return declared_access;
+}
+
+template <class... Components>
+void updatable::declare_reads()
+{
+	// Create component pools up front, as pool creation is unsafe while systems update concurrently
+	(registry.view<Components>(), ...);
+	(reads.push_back(std::type_index(typeid(Components))), ...);
+	declared_access = true;
+}
+
+template <class... Components>
+void updatable::declare_writes()
+{
+	(registry.view<Components>(), ...);
+	(writes.push_back(std::type_index(typeid(Components))), ...);
+	declared_access = true;
+}
+
 } // namespace system
 } // namespace entity
 
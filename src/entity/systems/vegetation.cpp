@@ -18,50 +18,109 @@
  */
 
 #include "vegetation.hpp"
-#include "entity/components/model.hpp"
-#include "entity/components/transform.hpp"
-#include "scene/model-instance.hpp"
-#include "scene/lod-group.hpp"
-#include "scene/collection.hpp"
-#include "renderer/material.hpp"
-#include "geom/aabb.hpp"
-#include "utility/fundamental-types.hpp"
+#include "renderer/model.hpp"
+#include "renderer/vertex-attributes.hpp"
+#include "gl/vertex-array.hpp"
+#include "gl/vertex-buffer.hpp"
+#include "gl/vertex-attribute-type.hpp"
+#include "math/vector-functions.hpp"
+#include <algorithm>
 #include <cmath>
+#include <limits>
 
 namespace entity {
 namespace system {
 
+/// Range of the random scales of vegetation instances.
+static constexpr float min_instance_scale = 0.75f;
+static constexpr float max_instance_scale = 1.25f;
+
+/// Returns the next value of a SplitMix64 sequence.
+static inline std::uint64_t splitmix64(std::uint64_t& state)
+{
+	std::uint64_t z = (state += 0x9e3779b97f4a7c15ull);
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+	return z ^ (z >> 31);
+}
+
+/// Returns a random float on `[0, 1)`.
+static inline float random_unit(std::uint64_t& state)
+{
+	return static_cast<float>(splitmix64(state) >> 40) * (1.0f / 16777216.0f);
+}
+
 vegetation::vegetation(entity::registry& registry):
 	updatable(registry),
-	terrain_patch_size(1.0f),
-	vegetation_patch_size(1.0f),
-	vegetation_patch_columns(1),
-	vegetation_patch_rows(1),
+	vegetation_patch_subdivisions(0),
 	vegetation_density(1.0f),
-	vegetation_model(nullptr)
-{
-	registry.on_construct<component::terrain>().connect<&vegetation::on_terrain_construct>(this);
-	registry.on_destroy<component::terrain>().connect<&vegetation::on_terrain_destroy>(this);
-}
+	max_patch_instances(65536),
+	vegetation_model(nullptr),
+	scene_collection(nullptr),
+	camera(nullptr),
+	fade_start(50.0f),
+	fade_end(100.0f),
+	jobs(nullptr)
+{}
 
 vegetation::~vegetation()
-{}
+{
+	if (jobs)
+		jobs->wait(scatter_counter);
+	
+	for (auto& entry: patch_vegetations)
+		released_vegetations.push_back(entry.second);
+	patch_vegetations.clear();
+	
+	for (patch_vegetation* vegetation: released_vegetations)
+	{
+		release(*vegetation);
+		delete vegetation;
+	}
+	
+	for (auto& pooled: model_pool)
+	{
+		if (scene_collection)
+			scene_collection->remove_object(pooled.second);
+		delete pooled.second;
+		delete pooled.first;
+	}
+}
 
 void vegetation::update(double t, double dt)
-{}
-
-void vegetation::set_terrain_patch_size(float size)
 {
-	terrain_patch_size = size;
-	vegetation_patch_size = terrain_patch_size / static_cast<float>(vegetation_patch_columns);
+	if (!camera)
+		return;
+	
+	const double3 camera_translation = camera->get_world_translation();
+	const float fade_range = std::max(fade_end - fade_start, 1e-6f);
+	
+	// Thin vegetation patches with their distance from the camera
+	for (auto& entry: patch_vegetations)
+	{
+		// Vegetation patches are written by scatter jobs until uploaded
+		if (!entry.second->uploaded)
+			continue;
+		
+		const float3 camera_position = math::type_cast<float>(camera_translation - entry.second->origin);
+		
+		for (vegetation_patch& patch: entry.second->patches)
+		{
+			// Find distance to the closest point of the vegetation patch bounds
+			float3 closest;
+			for (int i = 0; i < 3; ++i)
+				closest[i] = std::max(patch.bounds.min_point[i], std::min(camera_position[i], patch.bounds.max_point[i]));
+			const float distance = math::length(closest - camera_position);
+			
+			const float fade = std::max(0.0f, std::min(1.0f, 1.0f - (distance - fade_start) / fade_range));
+			patch.visible_count = static_cast<std::size_t>(std::ceil(fade * static_cast<float>(patch.instance_count)));
+		}
+	}
 }
 
 void vegetation::set_vegetation_patch_resolution(int subdivisions)
 {
-	// Determine number of vegetation patch columns and rows per terrain patch
-	vegetation_patch_columns = static_cast<int>(std::pow(2, subdivisions));
-	vegetation_patch_rows = vegetation_patch_columns;
-	vegetation_patch_size = terrain_patch_size / static_cast<float>(vegetation_patch_columns);
+	vegetation_patch_subdivisions = std::max(0, subdivisions);
 }
 
 void vegetation::set_vegetation_density(float density)
@@ -69,6 +128,11 @@ void vegetation::set_vegetation_density(float density)
 	vegetation_density = density;
 }
 
+void vegetation::set_max_patch_instances(std::size_t count)
+{
+	max_patch_instances = count;
+}
+
 void vegetation::set_vegetation_model(::model* model)
 {
 	vegetation_model = model;
@@ -79,11 +143,366 @@ void vegetation::set_scene(scene::collection* collection)
 	this->scene_collection = collection;
 }
 
-void vegetation::on_terrain_construct(entity::registry& registry, entity::id entity_id, component::terrain& component)
-{}
+void vegetation::set_camera(const scene::camera* camera)
+{
+	this->camera = camera;
+}
 
-void vegetation::on_terrain_destroy(entity::registry& registry, entity::id entity_id)
-{}
+void vegetation::set_fade_distances(float start, float end)
+{
+	fade_start = start;
+	fade_end = end;
+}
+
+void vegetation::set_job_system(job_system* jobs)
+{
+	if (this->jobs)
+		this->jobs->wait(scatter_counter);
+	
+	this->jobs = jobs;
+}
+
+void vegetation::patch_uploaded(const terrain::patch_geometry& geometry)
+{
+	if (!vegetation_model || vegetation_density <= 0.0f)
+		return;
+	
+	const patch_map_key key = {geometry.key.terrain_eid, geometry.key.face_index, geometry.key.node};
+	if (patch_vegetations.count(key))
+		return;
+	
+	// Share a copy of the terrain patch indices between scatter jobs
+	if (!patch_indices || *patch_indices != *geometry.indices)
+		patch_indices = std::make_shared<const std::vector<std::uint32_t>>(*geometry.indices);
+	
+	// Copy the positions and normals of the terrain patch vertices, as its vertex data is freed once uploaded
+	patch_vegetation* vegetation = new patch_vegetation();
+	vegetation->terrain_instance = geometry.model_instance;
+	vegetation->origin = geometry.origin;
+	vegetation->positions.resize(geometry.vertex_count);
+	vegetation->normals.resize(geometry.vertex_count);
+	const float* v = geometry.vertex_data;
+	for (std::size_t i = 0; i < geometry.vertex_count; ++i, v += geometry.vertex_size)
+	{
+		vegetation->positions[i] = {v[0], v[1], v[2]};
+		vegetation->normals[i] = {v[5], v[6], v[7]};
+	}
+	vegetation->indices = patch_indices;
+	vegetation->face_index = geometry.key.face_index;
+	vegetation->node = geometry.key.node;
+	vegetation->scattered = false;
+	vegetation->uploaded = false;
+	patch_vegetations[key] = vegetation;
+	
+	if (jobs)
+	{
+		jobs->submit
+		(
+			[this, vegetation]()
+			{
+				scatter(*vegetation);
+				vegetation->scattered.store(true, std::memory_order_release);
+			},
+			&scatter_counter
+		);
+	}
+	else
+	{
+		scatter(*vegetation);
+		vegetation->scattered = true;
+	}
+}
+
+void vegetation::patch_released(const terrain::patch_key& key)
+{
+	auto it = patch_vegetations.find({key.terrain_eid, key.face_index, key.node});
+	if (it == patch_vegetations.end())
+		return;
+	
+	// Hide the vegetation until it can be released by the thread which owns the OpenGL context
+	patch_vegetation* vegetation = it->second;
+	for (vegetation_patch& patch: vegetation->patches)
+		if (patch.model_instance)
+			patch.model_instance->set_active(false);
+	
+	released_vegetations.push_back(vegetation);
+	patch_vegetations.erase(it);
+}
+
+void vegetation::upload_patches()
+{
+	// Free the vegetation of released terrain patches once their scatter jobs have completed
+	for (std::size_t i = 0; i < released_vegetations.size();)
+	{
+		patch_vegetation* vegetation = released_vegetations[i];
+		if (vegetation->scattered.load(std::memory_order_acquire))
+		{
+			release(*vegetation);
+			delete vegetation;
+			released_vegetations[i] = released_vegetations.back();
+			released_vegetations.pop_back();
+		}
+		else
+		{
+			++i;
+		}
+	}
+	
+	for (auto& entry: patch_vegetations)
+	{
+		patch_vegetation& vegetation = *entry.second;
+		
+		if (!vegetation.uploaded)
+		{
+			if (!vegetation.scattered.load(std::memory_order_acquire))
+				continue;
+			upload(vegetation);
+		}
+		
+		// Draw the unfaded instances of vegetation patches on visible terrain patches
+		const bool terrain_visible = vegetation.terrain_instance->is_active();
+		for (vegetation_patch& patch: vegetation.patches)
+		{
+			if (!patch.model_instance)
+				continue;
+			
+			const std::size_t count = (camera) ? patch.visible_count : patch.instance_count;
+			patch.model_instance->set_active(terrain_visible && count);
+			if (count)
+				patch.model_instance->set_instanced(true, count);
+		}
+	}
+}
+
+void vegetation::scatter(patch_vegetation& vegetation) const
+{
+	const std::vector<float3>& positions = vegetation.positions;
+	const std::vector<float3>& normals = vegetation.normals;
+	const std::vector<std::uint32_t>& indices = *vegetation.indices;
+	const std::size_t triangle_count = indices.size() / 3;
+	
+	// Recover the number of cells per patch axis, n, from the number of patch vertices, (n + 1)^2 + n^2
+	const std::size_t vertex_count = positions.size();
+	const std::size_t cells = static_cast<std::size_t>(std::round((std::sqrt(static_cast<double>(2 * vertex_count - 1)) - 1.0) * 0.5));
+	const std::size_t corner_count = (cells + 1) * (cells + 1);
+	
+	// Divide the terrain patch into vegetation patches no smaller than a patch cell
+	const std::size_t columns = std::max<std::size_t>(1, std::min<std::size_t>(std::size_t(1) << std::min(vegetation_patch_subdivisions, 16), cells));
+	
+	// Calculate triangle areas, skipping patches too coarse to be scattered
+	std::vector<float> areas(triangle_count);
+	double expected_count = 0.0;
+	for (std::size_t i = 0; i < triangle_count; ++i)
+	{
+		const float3& a = positions[indices[i * 3]];
+		const float3& b = positions[indices[i * 3 + 1]];
+		const float3& c = positions[indices[i * 3 + 2]];
+		areas[i] = math::length(math::cross(b - a, c - a)) * 0.5f;
+		expected_count += static_cast<double>(areas[i]) * vegetation_density;
+	}
+	
+	vegetation.patches.resize(columns * columns);
+	for (vegetation_patch& patch: vegetation.patches)
+	{
+		patch.instance_count = 0;
+		patch.visible_count = 0;
+		patch.model = nullptr;
+		patch.model_instance = nullptr;
+	}
+	
+	// Seed the scatter with the face and node of the terrain patch
+	std::uint64_t state = vegetation.node * 0x9e3779b97f4a7c15ull + vegetation.face_index;
+	splitmix64(state);
+	
+	if (expected_count <= static_cast<double>(max_patch_instances) && cells)
+	{
+		for (std::size_t i = 0; i < triangle_count; ++i)
+		{
+			const std::uint32_t i0 = indices[i * 3];
+			const std::uint32_t i1 = indices[i * 3 + 1];
+			const std::uint32_t i2 = indices[i * 3 + 2];
+			
+			// Assign the triangle to the vegetation patch of its cell, identified by the cell center vertex
+			const std::size_t center = std::max(i0, std::max(i1, i2));
+			std::size_t cell_row = 0;
+			std::size_t cell_column = 0;
+			if (center >= corner_count)
+			{
+				cell_row = (center - corner_count) / cells;
+				cell_column = (center - corner_count) % cells;
+			}
+			vegetation_patch& patch = vegetation.patches[(cell_row * columns / cells) * columns + cell_column * columns / cells];
+			
+			// Stochastically round the expected number of instances on the triangle
+			const float expected = areas[i] * vegetation_density;
+			const std::size_t count = static_cast<std::size_t>(expected + random_unit(state));
+			
+			for (std::size_t j = 0; j < count; ++j)
+			{
+				// Uniformly sample the triangle
+				const float r = std::sqrt(random_unit(state));
+				const float s = random_unit(state);
+				const float u = 1.0f - r;
+				const float v = r * (1.0f - s);
+				const float w = r * s;
+				
+				const float3 position = positions[i0] * u + positions[i1] * v + positions[i2] * w;
+				float3 normal = normals[i0] * u + normals[i1] * v + normals[i2] * w;
+				const float length = math::length(normal);
+				normal = (length > 0.0f) ? normal / length : float3{0.0f, 0.0f, 1.0f};
+				const float scale = min_instance_scale + (max_instance_scale - min_instance_scale) * random_unit(state);
+				
+				vegetation_instance instance;
+				instance.position = position;
+				for (int k = 0; k < 3; ++k)
+					instance.normal_scale[k] = static_cast<std::int8_t>(std::round(normal[k] * 127.0f));
+				instance.normal_scale[3] = static_cast<std::int8_t>(std::min(127.0f, std::round(scale * 64.0f)));
+				patch.instances.push_back(instance);
+			}
+		}
+	}
+	
+	// Conservatively bound vegetation instances in any orientation
+	float model_radius = 0.0f;
+	if (vegetation_model)
+	{
+		const geom::aabb<float>& model_bounds = vegetation_model->get_bounds();
+		model_radius = std::max(math::length(model_bounds.min_point), math::length(model_bounds.max_point)) * max_instance_scale;
+	}
+	
+	for (vegetation_patch& patch: vegetation.patches)
+	{
+		// Shuffle instances, so that any prefix is a uniform thinning of the patch
+		for (std::size_t i = patch.instances.size(); i > 1; --i)
+			std::swap(patch.instances[i - 1], patch.instances[splitmix64(state) % i]);
+		
+		patch.instance_count = patch.instances.size();
+		patch.visible_count = patch.instance_count;
+		
+		patch.bounds.min_point = {std::numeric_limits<float>::infinity(), std::numeric_limits<float>::infinity(), std::numeric_limits<float>::infinity()};
+		patch.bounds.max_point = -patch.bounds.min_point;
+		for (const vegetation_instance& instance: patch.instances)
+		{
+			for (int i = 0; i < 3; ++i)
+			{
+				patch.bounds.min_point[i] = std::min(patch.bounds.min_point[i], instance.position[i] - model_radius);
+				patch.bounds.max_point[i] = std::max(patch.bounds.max_point[i], instance.position[i] + model_radius);
+			}
+		}
+	}
+	
+	// Free the terrain patch vertices
+	std::vector<float3>().swap(vegetation.positions);
+	std::vector<float3>().swap(vegetation.normals);
+	vegetation.indices.reset();
+}
+
+void vegetation::upload(patch_vegetation& vegetation)
+{
+	const gl::vertex_array* source_vao = vegetation_model->get_vertex_array();
+	const std::vector<model_group*>* source_groups = vegetation_model->get_groups();
+	
+	for (vegetation_patch& patch: vegetation.patches)
+	{
+		if (!patch.instance_count)
+			continue;
+		
+		const std::size_t size = patch.instances.size() * sizeof(vegetation_instance);
+		
+		if (!model_pool.empty())
+		{
+			// Reuse a pooled vegetation patch model
+			patch.model = model_pool.back().first;
+			patch.model_instance = model_pool.back().second;
+			model_pool.pop_back();
+			
+			gl::vertex_buffer* vbo = patch.model->get_vertex_buffer();
+			if (vbo->get_size() == size)
+				vbo->update(0, size, patch.instances.data());
+			else
+				vbo->resize(size, patch.instances.data());
+			
+			// Rebind the model to update the bounds of the model instance
+			patch.model->set_bounds(patch.bounds);
+			patch.model_instance->set_model(patch.model);
+		}
+		else
+		{
+			patch.model = new model();
+			
+			// Upload instances to the model VBO
+			gl::vertex_buffer* vbo = patch.model->get_vertex_buffer();
+			vbo->resize(size, patch.instances.data());
+			
+			// Bind the vertex attributes of the vegetation model, followed by the per-instance attributes
+			gl::vertex_array* vao = patch.model->get_vertex_array();
+			for (const auto& attribute: source_vao->get_attributes())
+			{
+				const gl::vertex_array::attribute_binding& binding = attribute.second;
+				vao->bind_attribute(attribute.first, *binding.buffer, binding.size, binding.type, binding.stride, binding.offset, binding.normalized);
+			}
+			if (source_vao->get_element_buffer())
+				vao->bind_elements(*source_vao->get_element_buffer());
+			vao->bind_attribute(VERTEX_INSTANCE_POSITION_LOCATION, *vbo, 3, gl::vertex_attribute_type::float_32, sizeof(vegetation_instance), 0);
+			vao->bind_attribute(VERTEX_INSTANCE_NORMAL_LOCATION, *vbo, 4, gl::vertex_attribute_type::int_8, sizeof(vegetation_instance), sizeof(float3));
+			vao->set_attribute_divisor(VERTEX_INSTANCE_POSITION_LOCATION, 1);
+			vao->set_attribute_divisor(VERTEX_INSTANCE_NORMAL_LOCATION, 1);
+			
+			// Copy the model groups of the vegetation model
+			for (const model_group* source_group: *source_groups)
+			{
+				model_group* group = patch.model->add_group(source_group->get_name());
+				group->set_material(const_cast<::material*>(source_group->get_material()));
+				group->set_drawing_mode(source_group->get_drawing_mode());
+				group->set_start_index(source_group->get_start_index());
+				group->set_index_count(source_group->get_index_count());
+				if (source_group->is_indexed())
+					group->set_element_type(source_group->get_element_type());
+			}
+			
+			patch.model->set_bounds(patch.bounds);
+			patch.model_instance = new scene::model_instance(patch.model);
+			patch.model_instance->set_static(true);
+			if (scene_collection)
+				scene_collection->add_object(patch.model_instance);
+		}
+		
+		patch.model_instance->set_origin(vegetation.origin);
+		patch.model_instance->set_active(false);
+		patch.model_instance->set_instanced(true, patch.instance_count);
+		
+		// Free the uploaded instances
+		std::vector<vegetation_instance>().swap(patch.instances);
+	}
+	
+	vegetation.uploaded = true;
+}
+
+void vegetation::release(patch_vegetation& vegetation)
+{
+	for (vegetation_patch& patch: vegetation.patches)
+	{
+		if (!patch.model)
+			continue;
+		
+		// Keep pooled model instances in the scene, inactive, until they are reused or freed
+		patch.model_instance->set_active(false);
+		if (model_pool.size() < max_pooled_models)
+		{
+			model_pool.push_back({patch.model, patch.model_instance});
+		}
+		else
+		{
+			if (scene_collection)
+				scene_collection->remove_object(patch.model_instance);
+			delete patch.model_instance;
+			delete patch.model;
+		}
+		
+		patch.model = nullptr;
+		patch.model_instance = nullptr;
+	}
+}
 
 } // namespace system
 } // namespace entity
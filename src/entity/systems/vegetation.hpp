@@ -21,9 +21,20 @@
 #define ANTKEEPER_ENTITY_SYSTEM_VEGETATION_HPP
 
 #include "entity/systems/updatable.hpp"
-#include "entity/components/terrain.hpp"
+#include "entity/systems/terrain.hpp"
 #include "entity/id.hpp"
+#include "geom/aabb.hpp"
 #include "scene/collection.hpp"
+#include "scene/camera.hpp"
+#include "scene/model-instance.hpp"
+#include "utility/fundamental-types.hpp"
+#include "utility/job-system.hpp"
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <tuple>
+#include <vector>
 
 class model;
 
@@ -31,9 +42,15 @@ namespace entity {
 namespace system {
 
 /**
- * Places vegetation patches on terrain.
+ * Scatters vegetation instances on terrain patches.
+ *
+ * Vegetation follows the residency of terrain patches: once a terrain patch has been uploaded, its surface is scattered with instances of the vegetation model by a job, and once the patch is released, its vegetation is released with it. Scattering is seeded by the quadsphere face and quadtree node of the patch, so the same patch always receives the same vegetation.
+ *
+ * Each terrain patch is divided into vegetation patches, each of which draws all of its instances with a single instanced draw. Instances are stored in a compact 16-byte format, a position followed by a normal and scale as signed bytes, bound to @ref VERTEX_INSTANCE_POSITION_LOCATION and @ref VERTEX_INSTANCE_NORMAL_LOCATION, from which the vegetation vertex shader should orient each instance about its normal, with a yaw hashed from its position. Instances are shuffled, so that drawing a prefix of a vegetation patch's instances thins it uniformly; the number of instances drawn falls off with the distance between the vegetation patch and the camera.
+ *
+ * As the system may be updated on any thread, it makes no OpenGL calls while updating.
  */
-class vegetation: public updatable
+class vegetation: public updatable, public terrain::patch_listener
 {
 public:
 	vegetation(entity::registry& registry);
@@ -41,40 +58,158 @@ public:
 	virtual void update(double t, double dt);
 	
 	/**
-	 * Sets the terrain patch size.
+	 * Sets the vegetation patch size.
 	 *
-	 * @param size Size of the terrain patch.
+	 * @param subdivisions Number of times a terrain patch should be subdivided into vegetation patches. Vegetation patches are no smaller than a terrain patch cell.
 	 */
-	void set_terrain_patch_size(float size);
+	void set_vegetation_patch_resolution(int subdivisions);
 	
 	/**
-	 * Sets the vegetation patch size.
+	 * Sets the vegetation density.
 	 *
-	 * @param subdivisions Number of times a terrain patch should be subdivided into vegetation patches.
+	 * @param density Number of vegetation instances per square unit of terrain surface.
 	 */
-	void set_vegetation_patch_resolution(int subdivisions);
-	
 	void set_vegetation_density(float density);
 	
+	/**
+	 * Sets the maximum number of vegetation instances scattered on a single terrain patch. Coarse terrain patches which would exceed this number receive no vegetation, as they are only visible from beyond the fade distance.
+	 *
+	 * @param count Maximum number of instances per terrain patch.
+	 */
+	void set_max_patch_instances(std::size_t count);
+	
+	/**
+	 * Sets the model of which vegetation instances are drawn. Should be set before any terrain patches have been uploaded.
+	 */
 	void set_vegetation_model(::model* model);
 	
 	void set_scene(scene::collection* collection);
+	
+	/**
+	 * Sets the camera from which vegetation fade distances are measured.
+	 */
+	void set_camera(const scene::camera* camera);
+	
+	/**
+	 * Sets the distances over which vegetation density fades out.
+	 *
+	 * @param start Distance up to which all instances of a vegetation patch are drawn.
+	 * @param end Distance beyond which no instances of a vegetation patch are drawn.
+	 */
+	void set_fade_distances(float start, float end);
+	
+	/**
+	 * Sets the job system on which terrain patches are scattered.
+	 *
+	 * @param jobs Job system, or `nullptr` to scatter terrain patches as they are uploaded.
+	 */
+	void set_job_system(job_system* jobs);
+	
+	/**
+	 * Uploads the vegetation of scattered terrain patches to the GPU, frees the vegetation of released terrain patches, and updates the visibility of vegetation patches. Must be called once per frame, by the thread which owns the OpenGL context, after terrain patches have been uploaded.
+	 */
+	void upload_patches();
+	
+	virtual void patch_uploaded(const terrain::patch_geometry& geometry);
+	virtual void patch_released(const terrain::patch_key& key);
+	
+	/// Returns the vegetation density, in instances per square unit of terrain surface.
+	float get_vegetation_density() const;
 
 private:
-	void on_terrain_construct(entity::registry& registry, entity::id entity_id, entity::component::terrain& component);
-	void on_terrain_destroy(entity::registry& registry, entity::id entity_id);
-
-	float terrain_patch_size;
-	float vegetation_patch_size;
-	int vegetation_patch_columns;
-	int vegetation_patch_rows;
+	/// Vegetation instance, as stored in instance buffers.
+	struct vegetation_instance
+	{
+		float3 position;
+		
+		/// Normal on `[-127, 127]`, followed by scale in units of `1/64`.
+		std::int8_t normal_scale[4];
+	};
+	
+	/// Subdivision of a terrain patch, drawn with a single instanced draw.
+	struct vegetation_patch
+	{
+		/// Bounds of the instances, relative to the origin of the terrain patch.
+		geom::aabb<float> bounds;
+		
+		/// Shuffled instances, freed once uploaded.
+		std::vector<vegetation_instance> instances;
+		std::size_t instance_count;
+		
+		/// Number of instances drawn, as of the most recent update.
+		std::size_t visible_count;
+		
+		model* model;
+		scene::model_instance* model_instance;
+	};
+	
+	/// Vegetation of a terrain patch.
+	struct patch_vegetation
+	{
+		/// Model instance of the terrain patch, which is active whenever the patch is visible.
+		const scene::model_instance* terrain_instance;
+		
+		/// Double-precision origin of the terrain patch, relative to which instances are positioned.
+		double3 origin;
+		
+		/// Positions and normals of the terrain patch vertices, relative to the patch origin, freed once scattered.
+		std::vector<float3> positions;
+		std::vector<float3> normals;
+		std::shared_ptr<const std::vector<std::uint32_t>> indices;
+		std::uint8_t face_index;
+		std::uint64_t node;
+		
+		std::vector<vegetation_patch> patches;
+		
+		/// `true` once the scatter job of the patch has completed.
+		std::atomic<bool> scattered;
+		
+		/// `true` once the vegetation patches have been uploaded.
+		bool uploaded;
+	};
+	
+	typedef std::tuple<entity::id, std::uint8_t, std::uint64_t> patch_map_key;
+	
+	/// Scatters vegetation instances over the triangles of a terrain patch. Safe to call concurrently for different patches.
+	void scatter(patch_vegetation& vegetation) const;
+	
+	/// Uploads each vegetation patch of a scattered terrain patch, reusing pooled models.
+	void upload(patch_vegetation& vegetation);
+	
+	/// Removes the vegetation patches of a terrain patch from the scene and returns their models to the pool.
+	void release(patch_vegetation& vegetation);
+	
+	int vegetation_patch_subdivisions;
 	float vegetation_density;
+	std::size_t max_patch_instances;
 	model* vegetation_model;
 	scene::collection* scene_collection;
+	const scene::camera* camera;
+	float fade_start;
+	float fade_end;
+	
+	job_system* jobs;
+	job_system::counter scatter_counter;
+	
+	/// Shared copy of the terrain patch indices, replaced if the terrain patch indices change.
+	std::shared_ptr<const std::vector<std::uint32_t>> patch_indices;
+	
+	std::map<patch_map_key, patch_vegetation*> patch_vegetations;
+	
+	/// Vegetation of released terrain patches, freed once scattered.
+	std::vector<patch_vegetation*> released_vegetations;
+	
+	/// Maximum number of vegetation patch models kept for reuse.
+	static constexpr std::size_t max_pooled_models = 64;
+	std::vector<std::pair<model*, scene::model_instance*>> model_pool;
 };
 
+inline float vegetation::get_vegetation_density() const
+{
+	return vegetation_density;
+}
+
 } // namespace system
 } // namespace entity
 
 #endif // ANTKEEPER_ENTITY_SYSTEM_VEGETATION_HPP
-
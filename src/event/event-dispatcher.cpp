@@ -18,8 +18,12 @@
  */
 
 #include "event-dispatcher.hpp"
+#include "debug/counters.hpp"
+#include <algorithm>
 
-event_dispatcher::event_dispatcher()
+event_dispatcher::event_dispatcher():
+	posted_events(nullptr),
+	schedule_sequence(0)
 {}
 
 event_dispatcher::~event_dispatcher()
@@ -30,52 +34,70 @@ event_dispatcher::~event_dispatcher()
 void event_dispatcher::update(double time)
 {
 	// Process pending subscriptions
-	for (auto it = to_subscribe.begin(); it != to_subscribe.end(); ++it)
+	for (const auto& [type_id, handler]: to_subscribe)
 	{
-		handler_map[std::get<0>(*it)].push_back(std::get<1>(*it));
+		if (type_id >= handlers.size())
+			handlers.resize(type_id + 1);
+		handlers[type_id].push_back(handler);
 	}
 	to_subscribe.clear();
 
 	// Process pending unsubscriptions
-	for (auto it = to_unsubscribe.begin(); it != to_unsubscribe.end(); ++it)
+	for (const auto& [type_id, handler]: to_unsubscribe)
 	{
-		handler_map[std::get<0>(*it)].remove(std::get<1>(*it));
+		if (type_id < handlers.size())
+		{
+			std::vector<event_handler_base*>& type_handlers = handlers[type_id];
+			type_handlers.erase(std::remove(type_handlers.begin(), type_handlers.end(), handler), type_handlers.end());
+		}
 	}
 	to_unsubscribe.clear();
 
+	// Queue events posted by other threads since the last update
+	queue_posted_events();
+
 	// Dispatch queued events
 	flush();
 
-	// For each scheduled event
-	for (auto event = scheduled_events.begin(); event != scheduled_events.end();)
+	// Dispatch due scheduled events, in order of time
+	while (!scheduled_events.empty() && time >= scheduled_events.front().time)
 	{
-		// If the event is due
-		if (time >= event->first)
-		{
-			// Dispatch event
-			dispatch(*(event->second));
-
-			// Delete event
-			delete event->second;
-			event = scheduled_events.erase(event);
-		}
-		else
-		{
-			break;
-		}
+		std::pop_heap(scheduled_events.begin(), scheduled_events.end(), later);
+		const stored_event event = scheduled_events.back().event;
+		scheduled_events.pop_back();
+		
+		dispatch(*event.event);
+		release(event);
 	}
+	
+	static debug::gauge scheduled_gauge("events.scheduled");
+	scheduled_gauge.set(static_cast<std::int64_t>(scheduled_events.size()));
+}
+
+void event_dispatcher::post(const event_base& event)
+{
+	// Push event onto the posted event stack. Only the updating thread pops, and it pops the entire stack at once, so the stack is not subject to the ABA problem
+	posted_event* node = new posted_event{posted_events.load(std::memory_order_relaxed), event.clone()};
+	while (!posted_events.compare_exchange_weak(node->next, node, std::memory_order_release, std::memory_order_relaxed));
+}
+
+void event_dispatcher::schedule(const event_base& event, double time)
+{
+	scheduled_events.push_back({time, schedule_sequence++, store(event)});
+	std::push_heap(scheduled_events.begin(), scheduled_events.end(), later);
 }
 
 void event_dispatcher::flush()
 {
-	// For each event in the queue
-	for (auto event = queued_events.begin(); event != queued_events.end(); ++event)
+	static debug::counter queued_counter("events.queued");
+	
+	// Dispatch queued events, including events queued by handlers during the flush
+	for (std::size_t i = 0; i < queued_events.size(); ++i)
 	{
-		// Dispatch event
-		dispatch(**event);
-
-		// Delete event
-		delete (*event);
+		queued_counter.add();
+		const stored_event event = queued_events[i];
+		dispatch(*event.event);
+		release(event);
 	}
 
 	// Clear event queue
@@ -84,24 +106,82 @@ void event_dispatcher::flush()
 
 void event_dispatcher::clear()
 {
-	// For each event in the queue
-	for (auto event = queued_events.begin(); event != queued_events.end(); ++event)
+	// Move posted events into the queue, to be released along with queued events
+	queue_posted_events();
+	
+	// Release queued events
+	for (const stored_event& event: queued_events)
+		release(event);
+	queued_events.clear();
+
+	// Release scheduled events
+	for (const scheduled_event& event: scheduled_events)
+		release(event.event);
+	scheduled_events.clear();
+}
+
+void event_dispatcher::queue_posted_events()
+{
+	posted_event* node = posted_events.exchange(nullptr, std::memory_order_acquire);
+	if (!node)
+		return;
+	
+	// Reverse the stack into the order in which events were posted
+	posted_event* reversed = nullptr;
+	while (node)
 	{
-		// Delete event
-		delete (*event);
+		posted_event* next = node->next;
+		node->next = reversed;
+		reversed = node;
+		node = next;
 	}
+	
+	// Queue posted events, which were heap-allocated by their posting threads
+	while (reversed)
+	{
+		posted_event* next = reversed->next;
+		queued_events.push_back({reversed->event, nullptr});
+		delete reversed;
+		reversed = next;
+	}
+}
 
-	// Clear event queue
-	queued_events.clear();
-
-	// For each scheduled event
-	for (auto event = scheduled_events.begin(); event != scheduled_events.end(); ++event)
+event_dispatcher::stored_event event_dispatcher::store(const event_base& event)
+{
+	// Allocate a block of slots if the pool is exhausted
+	if (free_slots.empty())
+	{
+		slot_blocks.emplace_back(new event_slot[event_slots_per_block]);
+		event_slot* block = slot_blocks.back().get();
+		for (std::size_t i = event_slots_per_block; i > 0; --i)
+			free_slots.push_back(block + i - 1);
+	}
+	
+	// Copy event into a slot, or onto the heap if it is too large
+	event_slot* slot = free_slots.back();
+	if (event_base* copy = event.clone_into(slot->data, event_slot_size))
 	{
-		// Delete event
-		delete event->second;
+		free_slots.pop_back();
+		return {copy, slot};
 	}
+	
+	return {event.clone(), nullptr};
+}
 
-	// Clear scheduled events
-	scheduled_events.clear();
+void event_dispatcher::release(const stored_event& event)
+{
+	if (event.slot)
+	{
+		event.event->~event_base();
+		free_slots.push_back(event.slot);
+	}
+	else
+	{
+		delete event.event;
+	}
 }
 
+bool event_dispatcher::later(const scheduled_event& a, const scheduled_event& b)
+{
+	return (a.time > b.time) || (a.time == b.time && a.sequence > b.sequence);
+}
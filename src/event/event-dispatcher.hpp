@@ -22,12 +22,19 @@
 
 #include "event.hpp"
 #include "event-handler.hpp"
+#include <atomic>
+#include <cstddef>
 #include <cstdlib>
-#include <list>
-#include <map>
+#include <memory>
+#include <utility>
+#include <vector>
 
 /**
  * Queues events and dispatches them to event handlers.
+ *
+ * Events may be posted from any thread with post(), which is lock-free. Posted events are delivered on the thread which updates the dispatcher, at the start of the next update(), along with events queued by that thread.
+ *
+ * Queued and scheduled events are copied into fixed-size slots of a pool which grows as needed and is reused once the events have been dispatched, so that queueing and dispatching events do not allocate in steady state. Events which do not fit in a slot are heap-allocated. Handlers are listed by event type ID, and scheduled events are kept in a binary heap ordered by time.
  */
 class event_dispatcher
 {
@@ -39,7 +46,7 @@ public:
 	~event_dispatcher();
 
 	/**
-	 * Processes all pending subscriptions and unsubscriptions, dispatches queued events, then dispatches due scheduled events.
+	 * Processes all pending subscriptions and unsubscriptions, queues posted events, dispatches queued events, then dispatches due scheduled events.
 	 *
 	 * @param time The current time.
 	 */
@@ -69,7 +76,14 @@ public:
 	void queue(const event_base& event);
 
 	/**
-	 * Schedules an event to be dispatched at a specific time.
+	 * Posts an event from any thread, to be queued by the next update(). Events posted by the same thread are dispatched in the order in which they were posted. Unlike all other member functions, this function may be called concurrently.
+	 *
+	 * @param event Event to post.
+	 */
+	void post(const event_base& event);
+
+	/**
+	 * Schedules an event to be dispatched at a specific time. Events scheduled for the same time are dispatched in the order in which they were scheduled.
 	 *
 	 * @param event Event to schedule.
 	 * @param time Time that the event should be dispatched.
@@ -88,51 +102,104 @@ public:
 	 */
 	void flush();
 
-	/// Removes all queued and scheduled events from the queue without notifying handlers.
+	/// Removes all posted, queued, and scheduled events from the queue without notifying handlers.
 	void clear();
 
 private:
-	std::list<std::tuple<std::size_t, event_handler_base*>> to_subscribe;
-	std::list<std::tuple<std::size_t, event_handler_base*>> to_unsubscribe;
-	std::map<std::size_t, std::list<event_handler_base*>> handler_map;
-	std::list<event_base*> queued_events;
-	std::multimap<double, event_base*> scheduled_events;
+	/// Size of a pooled event slot, in bytes.
+	static constexpr std::size_t event_slot_size = 128;
+	
+	/// Number of slots allocated at once when the pool is exhausted.
+	static constexpr std::size_t event_slots_per_block = 64;
+	
+	/// Storage of a single pooled event.
+	struct alignas(std::max_align_t) event_slot
+	{
+		unsigned char data[event_slot_size];
+	};
+	
+	/// Event copied into the pool, or onto the heap if it does not fit in a slot.
+	struct stored_event
+	{
+		event_base* event;
+		
+		/// Slot in which the event was constructed, or `nullptr` if the event was heap-allocated.
+		event_slot* slot;
+	};
+	
+	/// Scheduled event, ordered by time then by the order in which it was scheduled.
+	struct scheduled_event
+	{
+		double time;
+		std::size_t sequence;
+		stored_event event;
+	};
+	
+	/// Event posted by another thread, in an intrusive stack.
+	struct posted_event
+	{
+		posted_event* next;
+		event_base* event;
+	};
+	
+	/// Moves posted events into the event queue, in the order in which they were posted.
+	void queue_posted_events();
+	
+	/// Copies an event into the pool.
+	stored_event store(const event_base& event);
+	
+	/// Destroys a stored event and returns its slot to the pool.
+	void release(const stored_event& event);
+	
+	/// Returns `true` if scheduled event @p a is due after scheduled event @p b, such that the heap is a min-heap.
+	static bool later(const scheduled_event& a, const scheduled_event& b);
+	
+	std::vector<std::pair<std::size_t, event_handler_base*>> to_subscribe;
+	std::vector<std::pair<std::size_t, event_handler_base*>> to_unsubscribe;
+	
+	/// Subscribed handlers, indexed by event type ID.
+	std::vector<std::vector<event_handler_base*>> handlers;
+	
+	/// Most recently posted event, which links to the events posted before it.
+	std::atomic<posted_event*> posted_events;
+	
+	std::vector<stored_event> queued_events;
+	std::vector<scheduled_event> scheduled_events;
+	std::size_t schedule_sequence;
+	
+	std::vector<std::unique_ptr<event_slot[]>> slot_blocks;
+	std::vector<event_slot*> free_slots;
 };
 
 template <typename T>
 void event_dispatcher::subscribe(event_handler<T>* handler)
 {
-	to_subscribe.push_back(std::make_tuple(handler->get_handled_event_type_id(), handler));
+	to_subscribe.emplace_back(handler->get_handled_event_type_id(), handler);
 }
 
 template <typename T>
 void event_dispatcher::unsubscribe(event_handler<T>* handler)
 {
-	to_unsubscribe.push_back(std::make_tuple(handler->get_handled_event_type_id(), handler));
+	to_unsubscribe.emplace_back(handler->get_handled_event_type_id(), handler);
 }
 
 inline void event_dispatcher::queue(const event_base& event)
 {
-	queued_events.push_back(event.clone());
-}
-
-inline void event_dispatcher::schedule(const event_base& event, double time)
-{
-	scheduled_events.insert(std::pair<double, event_base*>(time, event.clone()));
+	queued_events.push_back(store(event));
 }
 
 inline void event_dispatcher::dispatch(const event_base& event)
 {
 	// Get list of handlers for this type of event
-	const std::list<event_handler_base*>& handlers = handler_map[event.get_event_type_id()];
-
-	// For each handler
-	for (auto handler = handlers.begin(); handler != handlers.end(); ++handler)
+	const std::size_t type_id = event.get_event_type_id();
+	if (type_id >= handlers.size())
+		return;
+	
+	// Pass event to each handler
+	for (event_handler_base* handler: handlers[type_id])
 	{
-		// Pass event to the handler
-		(*handler)->route_event(event);
+		handler->route_event(event);
 	}
 }
 
 #endif // ANTKEEPER_EVENT_DISPATCHER_HPP
-
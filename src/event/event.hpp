@@ -21,7 +21,9 @@
 #define ANTKEEPER_EVENT_HPP
 
 #include <atomic>
+#include <cstddef>
 #include <cstdlib>
+#include <new>
 
 /**
  * Abstract base class for events.
@@ -41,6 +43,16 @@ public:
 	 * @return Newly allocated copy of this event.
 	 */
 	virtual event_base* clone() const = 0;
+	
+	/**
+	 * Constructs a copy of this event in preallocated storage, if it fits.
+	 *
+	 * @param storage Storage aligned to `alignof(std::max_align_t)`.
+	 * @param size Size of the storage, in bytes.
+	 *
+	 * @return Copy of this event, which must be destroyed by calling its destructor, or `nullptr` if the event does not fit in the storage.
+	 */
+	virtual event_base* clone_into(void* storage, std::size_t size) const = 0;
 
 protected:
 	/// Returns then increments the next available event type ID.
@@ -73,6 +85,9 @@ public:
 	
 	/// @copydoc event_base::clone() const
 	virtual event_base* clone() const = 0;
+	
+	/// @copydoc event_base::clone_into(void*, std::size_t) const
+	virtual event_base* clone_into(void* storage, std::size_t size) const final;
 };
 
 template <typename T>
@@ -84,5 +99,14 @@ inline const std::size_t event<T>::get_event_type_id() const
 	return event_type_id;
 }
 
+template <typename T>
+event_base* event<T>::clone_into(void* storage, std::size_t size) const
+{
+	if (sizeof(T) > size || alignof(T) > alignof(std::max_align_t))
+		return nullptr;
+	
+	return new (storage) T(static_cast<const T&>(*this));
+}
+
 #endif // ANTKEEPER_EVENT_HPP
 
@@ -0,0 +1,65 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "game/asset-manifest.hpp"
+#include "game/context.hpp"
+#include "debug/logger.hpp"
+
+namespace game {
+
+asset_manifest& asset_manifest::add(const asset_manifest& other)
+{
+	requests.insert(requests.end(), other.requests.begin(), other.requests.end());
+	return *this;
+}
+
+void asset_manifest::prefetch(::resource_manager* resource_manager)
+{
+	releases.reserve(releases.size() + requests.size());
+	for (const request_function& request: requests)
+		releases.push_back(request(resource_manager));
+	requests.clear();
+}
+
+void asset_manifest::release(::resource_manager* resource_manager)
+{
+	for (const release_function& release: releases)
+		release(resource_manager);
+	releases.clear();
+}
+
+void prefetch_assets(game::context* ctx, const asset_manifest& manifest)
+{
+	if (!ctx->prefetched_assets)
+		ctx->prefetched_assets = new asset_manifest();
+	
+	// Keep the references of the prefetch along with those of earlier prefetches, until they're released together
+	ctx->logger->log("Prefetching " + std::to_string(manifest.size()) + " assets");
+	ctx->prefetched_assets->add(manifest);
+	ctx->prefetched_assets->prefetch(ctx->resource_manager);
+}
+
+void release_prefetched_assets(game::context* ctx)
+{
+	if (ctx->prefetched_assets)
+		ctx->prefetched_assets->release(ctx->resource_manager);
+}
+
+} // namespace game
@@ -0,0 +1,131 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef ANTKEEPER_GAME_ASSET_MANIFEST_HPP
+#define ANTKEEPER_GAME_ASSET_MANIFEST_HPP
+
+#include "resources/resource-manager.hpp"
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace game {
+
+struct context;
+
+/**
+ * List of the assets which a game state loads on entry, which can be prefetched by the preceding state so that the transition doesn't wait for them.
+ *
+ * Prefetching requests every asset asynchronously, so that assets whose loaders are concurrent are read and parsed by worker threads while the preceding state runs. Each request holds a reference to its asset until the manifest is released, by which time the state has loaded the asset itself, from the resource cache.
+ */
+class asset_manifest
+{
+public:
+	/**
+	 * Adds an asset to the manifest.
+	 *
+	 * @tparam T Resource type.
+	 * @param name Path to the asset, relative to the search paths.
+	 * @return Reference to this manifest.
+	 */
+	template <class T>
+	asset_manifest& add(const std::string& name);
+	
+	/**
+	 * Adds the assets of another manifest to this manifest.
+	 *
+	 * @param other Manifest whose assets are to be added.
+	 * @return Reference to this manifest.
+	 */
+	asset_manifest& add(const asset_manifest& other);
+	
+	/**
+	 * Requests all assets of the manifest which haven't been requested yet asynchronously, emptying the manifest.
+	 *
+	 * @param resource_manager Resource manager by which assets are requested.
+	 */
+	void prefetch(::resource_manager* resource_manager);
+	
+	/**
+	 * Releases the references held by prefetched assets, waiting for requests still in flight.
+	 *
+	 * @param resource_manager Resource manager by which assets were requested.
+	 */
+	void release(::resource_manager* resource_manager);
+	
+	/// Returns the number of assets in the manifest which haven't been requested yet.
+	std::size_t size() const;
+
+private:
+	/// Function which releases the reference held by a prefetched asset.
+	typedef std::function<void(::resource_manager*)> release_function;
+	
+	/// Function which requests an asset and returns the function which releases it.
+	typedef std::function<release_function(::resource_manager*)> request_function;
+	
+	std::vector<request_function> requests;
+	std::vector<release_function> releases;
+};
+
+template <class T>
+asset_manifest& asset_manifest::add(const std::string& name)
+{
+	requests.push_back
+	(
+		[name](::resource_manager* resource_manager) -> release_function
+		{
+			resource_future<T> future = resource_manager->load_async<T>(name);
+			return [name, future](::resource_manager* resource_manager)
+			{
+				// Wait for the request by loading the asset, then drop the references of both the load and the request
+				if (!future.is_ready() && resource_manager->load<T>(name))
+					resource_manager->unload(name);
+				if (future.get())
+					resource_manager->unload(name);
+			};
+		}
+	);
+	
+	return *this;
+}
+
+inline std::size_t asset_manifest::size() const
+{
+	return requests.size();
+}
+
+/**
+ * Prefetches the assets of the state likely to follow the current game state, adding them to the assets already prefetched.
+ *
+ * @param ctx Game context.
+ * @param manifest Manifest of the assets to prefetch.
+ */
+void prefetch_assets(game::context* ctx, const asset_manifest& manifest);
+
+/**
+ * Releases all prefetched assets. Called by each game state once it has entered, as it then holds its own references to the assets prefetched for it.
+ *
+ * @param ctx Game context.
+ */
+void release_prefetched_assets(game::context* ctx);
+
+} // namespace game
+
+#endif // ANTKEEPER_GAME_ASSET_MANIFEST_HPP
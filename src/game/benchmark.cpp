@@ -0,0 +1,263 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "game/benchmark.hpp"
+#include "game/context.hpp"
+#include "application.hpp"
+#include "animation/frame-scheduler.hpp"
+#include "animation/orbit-cam.hpp"
+#include "debug/logger.hpp"
+#include "debug/performance-sampler.hpp"
+#include "entity/systems/camera.hpp"
+#include "math/math.hpp"
+#include "renderer/pass-profiler.hpp"
+#include "resources/string-table.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+
+namespace game {
+
+namespace {
+
+/// Writes the streaming statistics of a sampler as a JSON object, in milliseconds.
+void write_json_statistics(std::ostream& stream, const debug::performance_sampler& sampler)
+{
+	stream << "{\"count\":" << sampler.sample_count();
+	stream << ",\"mean\":" << sampler.streaming_mean() * 1000.0;
+	stream << ",\"p50\":" << sampler.streaming_percentile(0.5) * 1000.0;
+	stream << ",\"p95\":" << sampler.streaming_percentile(0.95) * 1000.0;
+	stream << ",\"p99\":" << sampler.streaming_percentile(0.99) * 1000.0;
+	stream << ",\"max\":" << sampler.max_duration() * 1000.0 << "}";
+}
+
+/// Writes a JSON string, escaping quotes and backslashes.
+void write_json_string(std::ostream& stream, const std::string& string)
+{
+	stream << '"';
+	for (char c: string)
+	{
+		if (c == '"' || c == '\\')
+			stream << '\\';
+		stream << c;
+	}
+	stream << '"';
+}
+
+} // namespace
+
+benchmark::benchmark(game::context* ctx, const std::string& scenario, std::size_t frame_count, const std::string& report_path):
+	ctx(ctx),
+	scenario(scenario),
+	frame_count(frame_count),
+	report_path(report_path),
+	camera_path(default_camera_path()),
+	frame_index(0),
+	started(false),
+	start_time(-1.0),
+	elapsed_time(0.0),
+	finished(false)
+{}
+
+void benchmark::set_camera_path(const std::vector<keyframe>& path)
+{
+	camera_path = (path.empty()) ? default_camera_path() : path;
+}
+
+std::vector<benchmark::keyframe> benchmark::read_camera_path(const string_table& table)
+{
+	std::vector<keyframe> path;
+	path.reserve(table.size());
+	
+	for (std::size_t i = 0; i < table.size(); ++i)
+	{
+		const string_table_row row = table[i];
+		if (row.size() < 4)
+			continue;
+		
+		// Parse cells, skipping rows with non-numeric cells
+		double values[4];
+		bool numeric = true;
+		for (std::size_t j = 0; j < 4 && numeric; ++j)
+		{
+			const std::string cell(row[j]);
+			char* end = nullptr;
+			values[j] = std::strtod(cell.c_str(), &end);
+			numeric = (end != cell.c_str());
+		}
+		if (!numeric)
+			continue;
+		
+		path.push_back
+		({
+			values[0],
+			math::radians(static_cast<float>(values[1])),
+			math::radians(static_cast<float>(values[2])),
+			static_cast<float>(values[3])
+		});
+	}
+	
+	return path;
+}
+
+std::vector<benchmark::keyframe> benchmark::default_camera_path()
+{
+	return
+	{
+		{0.0, math::radians(0.0f), math::radians(30.0f), 0.5f},
+		{10.0, math::radians(90.0f), math::radians(10.0f), 0.1f},
+		{20.0, math::radians(180.0f), math::radians(60.0f), 0.9f},
+		{30.0, math::radians(270.0f), math::radians(20.0f), 0.3f},
+		{40.0, math::radians(360.0f), math::radians(30.0f), 0.5f}
+	};
+}
+
+void benchmark::update(double t, double dt)
+{
+	if (finished)
+		return;
+	
+	if (start_time < 0.0)
+		start_time = t;
+	elapsed_time = t - start_time;
+	
+	// Place the camera on the path directly, bypassing its springs
+	const keyframe key = evaluate(elapsed_time);
+	orbit_cam* camera = ctx->camera_system->get_orbit_cam();
+	camera->set_azimuth(key.azimuth);
+	camera->set_target_azimuth(key.azimuth);
+	camera->set_elevation(key.elevation);
+	camera->set_target_elevation(key.elevation);
+	camera->set_zoom(key.zoom);
+	camera->set_target_zoom(key.zoom);
+}
+
+void benchmark::frame()
+{
+	if (finished)
+		return;
+	
+	++frame_index;
+	if (!started)
+	{
+		if (frame_index >= warmup_frame_count)
+			start();
+	}
+	else if (frame_index >= warmup_frame_count + frame_count)
+	{
+		finish();
+	}
+}
+
+benchmark::keyframe benchmark::evaluate(double time) const
+{
+	if (camera_path.size() == 1 || camera_path.back().time <= camera_path.front().time)
+		return camera_path.front();
+	
+	// Loop the path
+	const double duration = camera_path.back().time - camera_path.front().time;
+	time = camera_path.front().time + std::fmod(std::max(0.0, time), duration);
+	
+	// Find the keyframes surrounding the time
+	auto next = std::upper_bound(camera_path.begin(), camera_path.end(), time, [](double time, const keyframe& key){return time < key.time;});
+	if (next == camera_path.end())
+		return camera_path.back();
+	if (next == camera_path.begin())
+		return camera_path.front();
+	auto previous = next - 1;
+	
+	const float a = static_cast<float>((time - previous->time) / (next->time - previous->time));
+	return
+	{
+		time,
+		math::lerp(previous->azimuth, next->azimuth, a),
+		math::lerp(previous->elevation, next->elevation, a),
+		math::lerp(previous->zoom, next->zoom, a)
+	};
+}
+
+void benchmark::start()
+{
+	ctx->logger->log("Benchmarking \"" + scenario + "\" for " + std::to_string(frame_count) + " frames");
+	
+	ctx->app->reset_timing_samplers();
+	
+	// Restart GPU pass profiling
+	ctx->pass_profiler->set_enabled(false);
+	ctx->pass_profiler->set_enabled(true);
+	
+	started = true;
+}
+
+void benchmark::finish()
+{
+	finished = true;
+	
+	std::ofstream stream(report_path);
+	if (stream)
+	{
+		write_report(stream);
+		ctx->logger->log("Wrote benchmark report \"" + report_path + "\"");
+	}
+	else
+	{
+		ctx->logger->error("Failed to write benchmark report \"" + report_path + "\"");
+	}
+	
+	ctx->app->close(EXIT_SUCCESS);
+}
+
+void benchmark::write_report(std::ostream& stream) const
+{
+	stream << std::fixed << std::setprecision(3);
+	
+	stream << "{\"scenario\":";
+	write_json_string(stream, scenario);
+	stream << ",\n\"frames\":" << frame_count;
+	stream << ",\n\"dropped_updates\":" << ctx->app->get_frame_scheduler()->get_dropped_update_count();
+	
+	// Write frame timing channels, in milliseconds
+	stream << ",\n\"channels\":{";
+	bool first = true;
+	for (application::timing_channel channel: {application::timing_channel::frame, application::timing_channel::update, application::timing_channel::render, application::timing_channel::swap})
+	{
+		stream << ((first) ? "\n" : ",\n");
+		write_json_string(stream, application::get_timing_channel_name(channel));
+		stream << ':';
+		write_json_statistics(stream, *ctx->app->get_timing_sampler(channel));
+		first = false;
+	}
+	stream << "},\n\"passes\":{";
+	
+	// Write GPU pass timings, in milliseconds
+	first = true;
+	for (const auto& sampler: ctx->pass_profiler->get_samplers())
+	{
+		stream << ((first) ? "\n" : ",\n");
+		write_json_string(stream, sampler.first);
+		stream << ':';
+		write_json_statistics(stream, sampler.second);
+		first = false;
+	}
+	stream << "}}\n";
+}
+
+} // namespace game
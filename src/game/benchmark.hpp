@@ -0,0 +1,143 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ANTKEEPER_GAME_BENCHMARK_HPP
+#define ANTKEEPER_GAME_BENCHMARK_HPP
+
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <vector>
+
+class string_table;
+
+namespace game {
+
+struct context;
+
+/**
+ * Drives the orbit camera along a scripted path for a fixed number of frames, then writes a JSON report of frame timings and GPU pass timings and closes the application.
+ *
+ * The camera path is evaluated at the simulation time elapsed since the benchmark started, so every run visits the same views in the same updates regardless of frame rate. Sampling begins after a number of warm-up frames, so that the report excludes the cost of entering the benchmarked game state.
+ */
+class benchmark
+{
+public:
+	/// Keyframe of a camera path.
+	struct keyframe
+	{
+		/// Simulation time of the keyframe, in seconds.
+		double time;
+		
+		/// Azimuth of the orbit camera, in radians.
+		float azimuth;
+		
+		/// Elevation of the orbit camera, in radians.
+		float elevation;
+		
+		/// Zoom factor of the orbit camera, on `[0, 1]`.
+		float zoom;
+	};
+	
+	/// Number of frames rendered before sampling begins.
+	static constexpr std::size_t warmup_frame_count = 120;
+	
+	/**
+	 * Creates a benchmark.
+	 *
+	 * @param ctx Game context.
+	 * @param scenario Name of the benchmarked game state.
+	 * @param frame_count Number of frames to sample.
+	 * @param report_path Path to the file to which the JSON report will be written.
+	 */
+	benchmark(game::context* ctx, const std::string& scenario, std::size_t frame_count, const std::string& report_path);
+	
+	/**
+	 * Sets the camera path. The path loops once its last keyframe has been reached.
+	 *
+	 * @param path Keyframes, in order of time.
+	 */
+	void set_camera_path(const std::vector<keyframe>& path);
+	
+	/**
+	 * Reads a camera path from a string table with rows of `time,azimuth,elevation,zoom`, with angles in degrees. Rows which don't begin with a number, such as headers, are skipped.
+	 *
+	 * @param table String table.
+	 * @return Keyframes of the camera path.
+	 */
+	static std::vector<keyframe> read_camera_path(const string_table& table);
+	
+	/// Returns the default camera path, a full orbit which sweeps through elevations and zoom factors.
+	static std::vector<keyframe> default_camera_path();
+	
+	/**
+	 * Positions the orbit camera on the camera path. Should be called at the start of every update, before the camera system is updated.
+	 *
+	 * @param t Total elapsed time, in seconds.
+	 * @param dt Delta time, in seconds.
+	 */
+	void update(double t, double dt);
+	
+	/// Counts a rendered frame, beginning sampling once warmed up and finishing once all frames have been sampled. Should be called once per frame, after rendering.
+	void frame();
+	
+	/// Returns the name of the benchmarked game state.
+	const std::string& get_scenario() const;
+	
+	/// Returns `true` once all frames have been sampled.
+	bool is_finished() const;
+
+private:
+	/// Returns the keyframe interpolated at a time on the camera path.
+	keyframe evaluate(double time) const;
+	
+	/// Resets frame timing statistics and enables GPU pass profiling.
+	void start();
+	
+	/// Writes the report and closes the application.
+	void finish();
+	
+	/// Writes the JSON report of the sampled frames.
+	void write_report(std::ostream& stream) const;
+	
+	game::context* ctx;
+	std::string scenario;
+	std::size_t frame_count;
+	std::string report_path;
+	std::vector<keyframe> camera_path;
+	std::size_t frame_index;
+	bool started;
+	double start_time;
+	double elapsed_time;
+	bool finished;
+};
+
+inline const std::string& benchmark::get_scenario() const
+{
+	return scenario;
+}
+
+inline bool benchmark::is_finished() const
+{
+	return finished;
+}
+
+} // namespace game
+
+#endif // ANTKEEPER_GAME_BENCHMARK_HPP
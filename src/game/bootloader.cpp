@@ -20,12 +20,22 @@
 #include "animation/animation.hpp"
 #include "animation/animator.hpp"
 #include "animation/ease.hpp"
+#include "animation/frame-scheduler.hpp"
 #include "animation/screen-transition.hpp"
 #include "animation/timeline.hpp"
 #include "application.hpp"
 #include "debug/cli.hpp"
 #include "debug/console-commands.hpp"
+#include "debug/draw.hpp"
+#include "debug/gl-monitor.hpp"
+#include "debug/input-recorder.hpp"
 #include "debug/logger.hpp"
+#include "debug/performance-sampler.hpp"
+#include "debug/profiler.hpp"
+#include "debug/startup-profiler.hpp"
+#include "debug/telemetry-server.hpp"
+#include "game/benchmark.hpp"
+#include "game/quality-governor.hpp"
 #include "game/context.hpp"
 #include "gl/framebuffer.hpp"
 #include "gl/pixel-format.hpp"
@@ -41,18 +51,33 @@
 #include "renderer/material-property.hpp"
 #include "renderer/passes/bloom-pass.hpp"
 #include "renderer/passes/clear-pass.hpp"
+#include "renderer/passes/debug-draw-pass.hpp"
 #include "renderer/passes/final-pass.hpp"
 #include "renderer/passes/material-pass.hpp"
+#include "renderer/passes/occlusion-pass.hpp"
 #include "renderer/passes/outline-pass.hpp"
+#include "renderer/passes/picking-pass.hpp"
+#include "renderer/passes/shadow-atlas-pass.hpp"
 #include "renderer/passes/shadow-map-pass.hpp"
 #include "renderer/passes/sky-pass.hpp"
+#include "renderer/passes/temporal-upsample-pass.hpp"
+#include "renderer/passes/ui-pass.hpp"
 #include "renderer/simple-render-pass.hpp"
 #include "renderer/vertex-attributes.hpp"
 #include "renderer/compositor.hpp"
+#include "renderer/pass-profiler.hpp"
+#include "renderer/resolution-scaler.hpp"
 #include "renderer/renderer.hpp"
+#include "renderer/shader-cache.hpp"
+#include "renderer/texture-streamer.hpp"
+#include "audio/mixer.hpp"
+#include "type/typeface.hpp"
+#include "type/font.hpp"
+#include "type/text-cache.hpp"
 #include "resources/config-file.hpp"
 #include "resources/resource-manager.hpp"
 #include "resources/resource-manager.hpp"
+#include "resources/terrain-patch-cache.hpp"
 #include "scene/scene.hpp"
 #include "game/states/loading.hpp"
 #include "entity/systems/behavior.hpp"
@@ -65,6 +90,7 @@
 #include "entity/systems/snapping.hpp"
 #include "entity/systems/render.hpp"
 #include "entity/systems/samara.hpp"
+#include "entity/systems/sound.hpp"
 #include "entity/systems/subterrain.hpp"
 #include "entity/systems/terrain.hpp"
 #include "entity/systems/tool.hpp"
@@ -78,6 +104,10 @@
 #include "entity/systems/atmosphere.hpp"
 #include "entity/systems/orbit.hpp"
 #include "entity/systems/proteome.hpp"
+#include "entity/systems/pheromone.hpp"
+#include "ai/navmesh.hpp"
+#include "entity/systems/scheduler.hpp"
+#include "entity/systems/simulation-lod.hpp"
 #include "entity/components/marker.hpp"
 #include "entity/commands.hpp"
 #include "utility/paths.hpp"
@@ -88,15 +118,18 @@
 #include "input/game-controller.hpp"
 #include "input/mouse.hpp"
 #include "input/keyboard.hpp"
-#include "pheromone-matrix.hpp"
+#include "math/random.hpp"
+#include "pheromone-field.hpp"
 #include "configuration.hpp"
 #include "input/scancode.hpp"
+#include <algorithm>
 #include <cxxopts.hpp>
 #include <dirent.h>
 #include <entt/entt.hpp>
 #include <filesystem>
 #include <functional>
 #include <string>
+#include <utility>
 #include <vector>
 #include "utility/timestamp.hpp"
 
@@ -110,8 +143,10 @@ static void setup_window(game::context* ctx);
 static void setup_rendering(game::context* ctx);
 static void setup_scenes(game::context* ctx);
 static void setup_animation(game::context* ctx);
+static void setup_audio(game::context* ctx);
 static void setup_entities(game::context* ctx);
 static void setup_systems(game::context* ctx);
+static void setup_quality(game::context* ctx);
 static void setup_controls(game::context* ctx);
 static void setup_cli(game::context* ctx);
 static void setup_callbacks(game::context* ctx);
@@ -121,6 +156,9 @@ int bootloader(application* app, int argc, char** argv)
 	// Get application logger
 	debug::logger* logger = app->get_logger();
 	
+	// Time startup until the loading state exits
+	debug::startup_profiler::begin();
+	
 	logger->push_task("Running application bootloader");
 	
 	// Allocate game context
@@ -132,18 +170,30 @@ int bootloader(application* app, int argc, char** argv)
 	try
 	{
 		parse_options(ctx, argc, argv);
-		setup_resources(ctx);
-		load_config(ctx);
-		load_strings(ctx);
-		setup_window(ctx);
-		setup_rendering(ctx);
-		setup_scenes(ctx);
-		setup_animation(ctx);
-		setup_entities(ctx);
-		setup_systems(ctx);
-		setup_controls(ctx);
-		setup_cli(ctx);
-		setup_callbacks(ctx);
+		
+		// Run setup phases in order, timing each for the startup report
+		const std::pair<const char*, void (*)(game::context*)> phases[] =
+		{
+			{"setup_resources", setup_resources},
+			{"load_config", load_config},
+			{"load_strings", load_strings},
+			{"setup_window", setup_window},
+			{"setup_rendering", setup_rendering},
+			{"setup_scenes", setup_scenes},
+			{"setup_animation", setup_animation},
+			{"setup_audio", setup_audio},
+			{"setup_entities", setup_entities},
+			{"setup_systems", setup_systems},
+			{"setup_quality", setup_quality},
+			{"setup_controls", setup_controls},
+			{"setup_cli", setup_cli},
+			{"setup_callbacks", setup_callbacks}
+		};
+		for (const auto& [name, phase]: phases)
+		{
+			debug::startup_phase zone(name);
+			phase(ctx);
+		}
 	}
 	catch (const std::exception& e)
 	{
@@ -176,12 +226,20 @@ void parse_options(game::context* ctx, int argc, char** argv)
 		cxxopts::Options options("Antkeeper", "Ant colony simulation game");
 		options.add_options()
 			("b,biome", "Selects the biome to load", cxxopts::value<std::string>())
+			("benchmark", "Benchmarks a game state (nuptial-flight, forage, or brood) with v-sync disabled", cxxopts::value<std::string>())
+			("benchmark-frames", "Sets the number of frames to benchmark", cxxopts::value<int>())
+			("benchmark-path", "Sets the camera path resource of the benchmark", cxxopts::value<std::string>())
+			("benchmark-report", "Sets the file to which the JSON benchmark report is written", cxxopts::value<std::string>())
 			("c,continue", "Continues from the last save")
 			("d,data", "Sets the data package path", cxxopts::value<std::string>())
 			("f,fullscreen", "Starts in fullscreen mode")
 			("n,new-game", "Starts a new game")
 			("q,quick-start", "Skips to the main menu")
 			("r,reset", "Restores all settings to default")
+			("record-input", "Records input events and the random seed to a file, for replay", cxxopts::value<std::string>())
+			("replay-input", "Replays the input events and random seed of a recording, ignoring live input", cxxopts::value<std::string>())
+			("seed", "Seeds the random number generators, so that simulations are reproducible", cxxopts::value<std::uint64_t>())
+			("s,startup-report", "Writes a JSON report of startup timings to a file", cxxopts::value<std::string>())
 			("v,vsync", "Enables or disables v-sync", cxxopts::value<int>())
 			("w,windowed", "Starts in windowed mode");
 		auto result = options.parse(argc, argv);
@@ -190,6 +248,22 @@ void parse_options(game::context* ctx, int argc, char** argv)
 		if (result.count("biome"))
 			ctx->option_biome = result["biome"].as<std::string>();
 		
+		// --benchmark
+		if (result.count("benchmark"))
+			ctx->option_benchmark = result["benchmark"].as<std::string>();
+		
+		// --benchmark-frames
+		if (result.count("benchmark-frames"))
+			ctx->option_benchmark_frames = result["benchmark-frames"].as<int>();
+		
+		// --benchmark-path
+		if (result.count("benchmark-path"))
+			ctx->option_benchmark_path = result["benchmark-path"].as<std::string>();
+		
+		// --benchmark-report
+		if (result.count("benchmark-report"))
+			ctx->option_benchmark_report = result["benchmark-report"].as<std::string>();
+		
 		// --continue
 		if (result.count("continue"))
 			ctx->option_continue = true;
@@ -214,6 +288,22 @@ void parse_options(game::context* ctx, int argc, char** argv)
 		if (result.count("reset"))
 			ctx->option_reset = true;
 		
+		// --record-input
+		if (result.count("record-input"))
+			ctx->option_record_input = result["record-input"].as<std::string>();
+		
+		// --replay-input
+		if (result.count("replay-input"))
+			ctx->option_replay_input = result["replay-input"].as<std::string>();
+		
+		// --seed
+		if (result.count("seed"))
+			ctx->option_seed = result["seed"].as<std::uint64_t>();
+		
+		// --startup-report
+		if (result.count("startup-report"))
+			ctx->option_startup_report = result["startup-report"].as<std::string>();
+		
 		// --vsync
 		if (result.count("vsync"))
 			ctx->option_vsync = (result["vsync"].as<int>()) ? true : false;
@@ -229,6 +319,33 @@ void parse_options(game::context* ctx, int argc, char** argv)
 		return;
 	}
 	
+	// Replay recorded input with the seed of its recording, so the replayed session reproduces the recorded one
+	debug::input_recorder* input_recorder = ctx->app->get_input_recorder();
+	if (ctx->option_replay_input)
+	{
+		try
+		{
+			input_recorder->start_replay(*ctx->option_replay_input);
+			ctx->option_seed = input_recorder->get_seed();
+			logger->log("Replaying " + std::to_string(input_recorder->get_event_count()) + " input events from \"" + *ctx->option_replay_input + "\"");
+		}
+		catch (const std::exception& e)
+		{
+			logger->warning(e.what());
+		}
+	}
+	
+	// Seed random engines before any systems derive their streams from them
+	const std::uint64_t seed = ctx->option_seed.value_or(math::random_engine::default_seed);
+	math::seed_random(seed);
+	logger->log("Random seed is " + std::to_string(seed));
+	
+	if (ctx->option_record_input && !input_recorder->is_replaying())
+	{
+		input_recorder->start_recording(*ctx->option_record_input, seed);
+		logger->log("Recording input events to \"" + *ctx->option_record_input + "\"");
+	}
+	
 	logger->pop_task(EXIT_SUCCESS);
 }
 
@@ -238,6 +355,7 @@ void setup_resources(game::context* ctx)
 	
 	// Setup resource manager
 	ctx->resource_manager = new resource_manager(logger);
+	ctx->resource_manager->set_job_system(ctx->app->get_job_system());
 	
 	// Determine application name
 	std::string application_name;
@@ -253,6 +371,9 @@ void setup_resources(game::context* ctx)
 	ctx->mods_path = ctx->config_path + "mods/";
 	ctx->saves_path = ctx->config_path + "saves/";
 	ctx->screenshots_path = ctx->config_path + "screenshots/";
+	ctx->shader_cache_path = ctx->config_path + "shader-cache/";
+	ctx->terrain_cache_path = ctx->config_path + "terrain-cache/";
+	ctx->resource_manifest_path = ctx->config_path + "resource-dependencies.csv";
 	
 	// Log resource paths
 	logger->log("Detected data path as \"" + ctx->data_path + "\"");
@@ -264,6 +385,8 @@ void setup_resources(game::context* ctx)
 	config_paths.push_back(ctx->mods_path);
 	config_paths.push_back(ctx->saves_path);
 	config_paths.push_back(ctx->screenshots_path);
+	config_paths.push_back(ctx->shader_cache_path);
+	config_paths.push_back(ctx->terrain_cache_path);
 	for (const std::string& path: config_paths)
 	{
 		if (!path_exists(path))
@@ -280,12 +403,16 @@ void setup_resources(game::context* ctx)
 		}
 	}
 	
+	// Cache linked shader programs, skipping shader compilation on subsequent launches
+	ctx->shader_cache = new shader_cache(ctx->shader_cache_path);
+	ctx->resource_manager->set_shader_cache(ctx->shader_cache);
+	
 	// Redirect logger output to log file on non-debug builds
 	#if defined(NDEBUG)
 		std::string log_filename = config_path + "log.txt";
 		ctx->log_filestream.open(log_filename.c_str());
 		ctx->log_filestream << logger->get_history();
-		logger->redirect(&log_filestream);
+		logger->redirect(&ctx->log_filestream);
 	#endif
 	
 	// Scan for mods
@@ -353,6 +480,10 @@ void setup_resources(game::context* ctx)
 	ctx->resource_manager->include("/biomes/");
 	ctx->resource_manager->include("/traits/");
 	ctx->resource_manager->include("/");
+	
+	// Read resource dependencies recorded by the previous launch, by which they are prefetched in parallel
+	if (ctx->resource_manager->read_dependency_manifest(ctx->resource_manifest_path))
+		logger->log("Read resource dependency manifest \"" + ctx->resource_manifest_path + "\"");
 }
 
 void load_config(game::context* ctx)
@@ -368,6 +499,21 @@ void load_config(game::context* ctx)
 		return;
 	}
 	
+	// Discard log messages below the configured level
+	if (ctx->config->has("log_level"))
+		logger->set_min_level(static_cast<debug::log_level>(std::clamp(ctx->config->get<int>("log_level"), 0, 3)));
+	
+	// Write structured log records to a JSON lines file
+	if (ctx->config->has("log_json") && ctx->config->get<int>("log_json") != 0)
+	{
+		ctx->log_json_filestream.open((ctx->config_path + "log.json").c_str());
+		if (ctx->log_json_filestream)
+		{
+			ctx->log_json_sink = new debug::json_log_sink(ctx->log_json_filestream);
+			logger->add_sink(ctx->log_json_sink);
+		}
+	}
+	
 	logger->pop_task(EXIT_SUCCESS);
 }
 
@@ -382,10 +528,14 @@ void load_strings(game::context* ctx)
 	
 	ctx->language_code = ctx->config->get<std::string>("language");
 	ctx->language_index = -1;
-	for (int i = 2; i < (*ctx->string_table)[0].size(); ++i)
+	if (!ctx->string_table->empty())
 	{
-		if ((*ctx->string_table)[0][i] == ctx->language_code)
-			ctx->language_index = i;
+		const string_table_row header = (*ctx->string_table)[0];
+		for (int i = 2; i < header.size(); ++i)
+		{
+			if (header[i] == ctx->language_code)
+				ctx->language_index = i;
+		}
 	}
 	
 	logger->log("lang index: " + std::to_string(ctx->language_index));
@@ -434,10 +584,38 @@ void setup_window(game::context* ctx)
 		vsync = (ctx->option_vsync.value() != 0);
 	else if (config->has("vsync"))
 		vsync = (config->get<int>("vsync") != 0);
+	
+	// Benchmarks measure unthrottled frame times
+	if (ctx->option_benchmark.has_value())
+		vsync = false;
+	
 	app->set_vsync(vsync);
 	
+	// Set frame pacing
+	::frame_scheduler* frame_scheduler = app->get_frame_scheduler();
+	if (config->has("max_updates_per_frame"))
+		frame_scheduler->set_max_updates_per_frame(static_cast<std::size_t>(std::max(0, config->get<int>("max_updates_per_frame"))));
+	if (config->has("time_scale"))
+		frame_scheduler->set_time_scale(config->get<float>("time_scale"));
+	if (config->has("frame_rate_limit") && !ctx->option_benchmark.has_value())
+		frame_scheduler->set_frame_rate_limit(config->get<float>("frame_rate_limit"));
+	
+	// Set low-latency mode and frame throttling
+	if (config->has("low_latency"))
+		app->set_low_latency(config->get<int>("low_latency") != 0);
+	if (config->has("frame_throttling"))
+		app->set_frame_throttling(config->get<int>("frame_throttling") != 0);
+	if (config->has("idle_update_rate"))
+		app->set_idle_update_rate(config->get<float>("idle_update_rate"));
+	
+	// Set GL stall reporting, with the threshold in milliseconds
+	if (config->has("gl_stall_threshold"))
+		debug::gl_monitor::set_stall_threshold(config->get<double>("gl_stall_threshold") / 1000.0);
+	if (config->has("gl_warning_rate_limit"))
+		debug::gl_monitor::set_rate_limit(static_cast<std::size_t>(std::max(0, config->get<int>("gl_warning_rate_limit"))));
+	
 	// Set title
-	app->set_title((*ctx->strings)["title"]);
+	app->set_title(std::string((*ctx->strings)["title"]));
 	
 	logger->pop_task(EXIT_SUCCESS);
 }
@@ -450,6 +628,15 @@ void setup_rendering(game::context* ctx)
 	// Get rasterizer from application
 	ctx->rasterizer = ctx->app->get_rasterizer();
 	
+	// Create texture streamer before any textures are loaded, which streams the mip levels of compressed textures within a memory budget given in MiB
+	ctx->texture_streamer = nullptr;
+	if (ctx->config->has("texture_memory_budget"))
+	{
+		ctx->texture_streamer = new texture_streamer();
+		ctx->texture_streamer->set_memory_budget(static_cast<std::size_t>(ctx->config->get<int>("texture_memory_budget")) * 1024 * 1024);
+		ctx->resource_manager->set_texture_streamer(ctx->texture_streamer);
+	}
+	
 	// Get default framebuffer
 	const gl::framebuffer& default_framebuffer = ctx->rasterizer->get_default_framebuffer();
 	const auto& viewport_dimensions = default_framebuffer.get_dimensions();
@@ -481,6 +668,19 @@ void setup_rendering(game::context* ctx)
 	ctx->shadow_map_framebuffer = new gl::framebuffer(shadow_map_resolution, shadow_map_resolution);
 	ctx->shadow_map_framebuffer->attach(gl::framebuffer_attachment_type::depth, ctx->shadow_map_depth_texture);
 	
+	// Create shadow atlas framebuffer, shared by the shadows of point and spot lights
+	int shadow_atlas_resolution = 2048;
+	if (ctx->config->has("shadow_atlas_resolution"))
+	{
+		shadow_atlas_resolution = ctx->config->get<int>("shadow_atlas_resolution");
+	}
+	ctx->shadow_atlas_depth_texture = new gl::texture_2d(shadow_atlas_resolution, shadow_atlas_resolution, gl::pixel_type::float_32, gl::pixel_format::d);
+	ctx->shadow_atlas_depth_texture->set_wrapping(gl::texture_wrapping::extend, gl::texture_wrapping::extend);
+	ctx->shadow_atlas_depth_texture->set_filters(gl::texture_min_filter::linear, gl::texture_mag_filter::linear);
+	ctx->shadow_atlas_depth_texture->set_max_anisotropy(0.0f);
+	ctx->shadow_atlas_framebuffer = new gl::framebuffer(shadow_atlas_resolution, shadow_atlas_resolution);
+	ctx->shadow_atlas_framebuffer->attach(gl::framebuffer_attachment_type::depth, ctx->shadow_atlas_depth_texture);
+	
 	// Create bloom pingpong framebuffers (16F color, no depth)
 	int bloom_width = viewport_dimensions[0] >> 1;
 	int bloom_height = viewport_dimensions[1] >> 1;
@@ -497,85 +697,226 @@ void setup_rendering(game::context* ctx)
 	// Load fallback material
 	ctx->fallback_material = ctx->resource_manager->load<material>("fallback.mtl");
 	
+	// Create pass profiler, which measures the GPU time of each render pass when enabled
+	ctx->pass_profiler = new pass_profiler();
+	
+	// Create resolution scaler, which scales the HDR framebuffer to hold a target GPU frame time, measured by the pass profiler
+	if (ctx->config->has("dynamic_resolution_target_frame_time"))
+	{
+		ctx->resolution_scaler = new resolution_scaler(ctx->framebuffer_hdr);
+		ctx->resolution_scaler->set_target_frame_duration(ctx->config->get<float>("dynamic_resolution_target_frame_time") / 1000.0);
+		if (ctx->config->has("dynamic_resolution_scale_range"))
+		{
+			const float2 range = ctx->config->get<float2>("dynamic_resolution_scale_range");
+			ctx->resolution_scaler->set_scale_range(range.x, range.y);
+		}
+		ctx->pass_profiler->set_enabled(true);
+	}
+	
+	// Render the HDR framebuffer below the output resolution and upsample it temporally, at a fixed scale unless it is scaled dynamically
+	const bool temporal_upsampling = ctx->config->has("temporal_upsampling") && ctx->config->get<int>("temporal_upsampling") != 0;
+	if (temporal_upsampling && !ctx->resolution_scaler)
+	{
+		const float scale = (ctx->config->has("temporal_upsampling_scale")) ? ctx->config->get<float>("temporal_upsampling_scale") : 0.6f;
+		ctx->resolution_scaler = new resolution_scaler(ctx->framebuffer_hdr);
+		ctx->resolution_scaler->set_scale_range(scale, scale);
+	}
+	
 	// Setup common render passes
 	{
 		ctx->common_bloom_pass = new bloom_pass(ctx->rasterizer, ctx->framebuffer_bloom, ctx->resource_manager);
+		ctx->common_bloom_pass->set_name("bloom");
 		ctx->common_bloom_pass->set_source_texture(ctx->framebuffer_hdr_color);
 		ctx->common_bloom_pass->set_brightness_threshold(1.0f);
 		ctx->common_bloom_pass->set_blur_iterations(5);
+		if (ctx->config->has("bloom_mode") && ctx->config->get<std::string>("bloom_mode") == "blur")
+			ctx->common_bloom_pass->set_mode(bloom_mode::blur);
+		if (ctx->config->has("bloom_mip_count"))
+			ctx->common_bloom_pass->set_mip_count(ctx->config->get<int>("bloom_mip_count"));
 		
 		ctx->common_final_pass = new ::final_pass(ctx->rasterizer, &ctx->rasterizer->get_default_framebuffer(), ctx->resource_manager);
+		ctx->common_final_pass->set_name("final");
 		ctx->common_final_pass->set_color_texture(ctx->framebuffer_hdr_color);
 		ctx->common_final_pass->set_bloom_texture(ctx->bloom_texture);
 		ctx->common_final_pass->set_blue_noise_texture(blue_noise_map);
+		
+		::color_grading grading;
+		if (ctx->config->has("color_grading_exposure_bias"))
+			grading.exposure_bias = ctx->config->get<float>("color_grading_exposure_bias");
+		if (ctx->config->has("color_grading_contrast"))
+			grading.contrast = ctx->config->get<float>("color_grading_contrast");
+		if (ctx->config->has("color_grading_saturation"))
+			grading.saturation = ctx->config->get<float>("color_grading_saturation");
+		ctx->common_final_pass->set_color_grading(grading);
+		
+		if (temporal_upsampling)
+		{
+			ctx->common_temporal_upsample_pass = new temporal_upsample_pass(ctx->rasterizer, ctx->framebuffer_hdr, ctx->resource_manager);
+			ctx->common_temporal_upsample_pass->set_name("temporal_upsample");
+			ctx->common_temporal_upsample_pass->set_final_pass(ctx->common_final_pass);
+			if (!ctx->common_temporal_upsample_pass->is_valid())
+			{
+				delete ctx->common_temporal_upsample_pass;
+				ctx->common_temporal_upsample_pass = nullptr;
+			}
+		}
 	}
 	
 	// Setup UI compositor
 	{
 		ctx->ui_clear_pass = new clear_pass(ctx->rasterizer, &ctx->rasterizer->get_default_framebuffer());
+		ctx->ui_clear_pass->set_name("ui_clear");
 		ctx->ui_clear_pass->set_cleared_buffers(false, true, false);
 		ctx->ui_clear_pass->set_clear_depth(0.0f);
 		
-		ctx->ui_material_pass = new material_pass(ctx->rasterizer, &ctx->rasterizer->get_default_framebuffer(), ctx->resource_manager);
-		ctx->ui_material_pass->set_fallback_material(ctx->fallback_material);
+		ctx->ui_pass = new ::ui_pass(ctx->rasterizer, &ctx->rasterizer->get_default_framebuffer(), ctx->resource_manager);
+		ctx->ui_pass->set_texture_streamer(ctx->texture_streamer);
+		ctx->ui_pass->set_name("ui");
 		
 		ctx->ui_compositor = new compositor();
+		ctx->ui_compositor->set_profiler(ctx->pass_profiler);
 		ctx->ui_compositor->add_pass(ctx->ui_clear_pass);
-		ctx->ui_compositor->add_pass(ctx->ui_material_pass);
+		ctx->ui_compositor->add_pass(ctx->ui_pass);
+	}
+	
+	// Load UI font, whose glyphs are rasterized into its atlas as text is laid out
+	ctx->ui_font = nullptr;
+	ctx->ui_text_material = nullptr;
+	ctx->text_cache = new type::text_cache();
+	if (ctx->config->has("ui_font"))
+	{
+		type::typeface* typeface = ctx->resource_manager->load<type::typeface>(ctx->config->get<std::string>("ui_font"));
+		if (typeface)
+		{
+			float font_size = 32.0f;
+			if (ctx->config->has("ui_font_size"))
+				font_size = ctx->config->get<float>("ui_font_size");
+			
+			ctx->ui_font = new type::font(*typeface, font_size);
+			
+			ctx->ui_text_material = new material();
+			ctx->ui_text_material->set_shader_program(ctx->resource_manager->load<gl::shader_program>("ui-element-text.glsl"));
+			ctx->ui_text_material->set_flags(MATERIAL_FLAG_TRANSLUCENT);
+			ctx->ui_text_material->add_property<const gl::texture_2d*>("atlas")->set_value(ctx->ui_font->get_texture());
+			ctx->ui_text_material->add_property<float4>("tint")->set_value(float4{1, 1, 1, 1});
+			ctx->ui_text_material->update_tweens();
+		}
 	}
 	
 	// Setup underground compositor
 	{
+		// Nest interiors are lit by several lamps, which cast shadows into the shadow atlas
+		ctx->underground_shadow_atlas_pass = new shadow_atlas_pass(ctx->rasterizer, ctx->shadow_atlas_framebuffer, ctx->resource_manager);
+		ctx->underground_shadow_atlas_pass->set_name("shadow_atlas");
+		if (ctx->config->has("shadow_atlas_update_budget"))
+			ctx->underground_shadow_atlas_pass->set_update_budget(static_cast<std::size_t>(std::max(1, ctx->config->get<int>("shadow_atlas_update_budget"))));
+		
 		ctx->underground_clear_pass = new clear_pass(ctx->rasterizer, ctx->framebuffer_hdr);
+		ctx->underground_clear_pass->set_name("clear");
 		ctx->underground_clear_pass->set_cleared_buffers(true, true, false);
 		ctx->underground_clear_pass->set_clear_color({1, 0, 1, 0});
 		ctx->underground_clear_pass->set_clear_depth(0.0f);
 		
 		ctx->underground_material_pass = new material_pass(ctx->rasterizer, ctx->framebuffer_hdr, ctx->resource_manager);
 		ctx->underground_material_pass->set_fallback_material(ctx->fallback_material);
+		ctx->underground_material_pass->set_texture_streamer(ctx->texture_streamer);
+		ctx->underground_material_pass->set_name("material");
+		if (ctx->config->has("underground_depth_prepass"))
+			ctx->underground_material_pass->set_depth_prepass(ctx->config->get<int>("underground_depth_prepass") != 0);
+		if (ctx->config->has("weighted_blended_oit"))
+			ctx->underground_material_pass->set_weighted_blended_oit(ctx->config->get<int>("weighted_blended_oit") != 0);
+		ctx->underground_material_pass->set_shadow_atlas(ctx->underground_shadow_atlas_pass, ctx->shadow_atlas_depth_texture);
 		ctx->app->get_event_dispatcher()->subscribe<mouse_moved_event>(ctx->underground_material_pass);
 		
+		// Tunnel walls hide most of the nest, so the underground camera is occlusion culled
+		ctx->underground_occlusion_pass = new occlusion_pass(ctx->rasterizer, ctx->framebuffer_hdr);
+		ctx->underground_occlusion_pass->set_name("occlusion");
+		ctx->underground_occlusion_pass->set_job_system(ctx->app->get_job_system());
+		
 		ctx->underground_compositor = new compositor();
+		ctx->underground_compositor->set_profiler(ctx->pass_profiler);
+		ctx->underground_compositor->add_pass(ctx->underground_shadow_atlas_pass);
 		ctx->underground_compositor->add_pass(ctx->underground_clear_pass);
 		ctx->underground_compositor->add_pass(ctx->underground_material_pass);
+		ctx->underground_compositor->add_pass(ctx->underground_occlusion_pass);
 		ctx->underground_compositor->add_pass(ctx->common_bloom_pass);
+		if (ctx->common_temporal_upsample_pass)
+			ctx->underground_compositor->add_pass(ctx->common_temporal_upsample_pass);
 		ctx->underground_compositor->add_pass(ctx->common_final_pass);
 	}
 	
 	// Setup surface compositor
 	{
-		ctx->surface_shadow_map_clear_pass = new clear_pass(ctx->rasterizer, ctx->shadow_map_framebuffer);
-		ctx->surface_shadow_map_clear_pass->set_cleared_buffers(false, true, false);
-		ctx->surface_shadow_map_clear_pass->set_clear_depth(1.0f);
-		
 		ctx->surface_shadow_map_pass = new shadow_map_pass(ctx->rasterizer, ctx->shadow_map_framebuffer, ctx->resource_manager);
 		ctx->surface_shadow_map_pass->set_split_scheme_weight(0.75f);
+		ctx->surface_shadow_map_pass->set_name("shadow_map");
+		
+		// Cache far shadow cascades, updating cascade n every (n + 1)th frame
+		if (ctx->config->has("shadow_cascade_caching") && ctx->config->get<int>("shadow_cascade_caching") != 0)
+		{
+			for (std::size_t i = 1; i < 4; ++i)
+				ctx->surface_shadow_map_pass->set_cascade_update_interval(i, static_cast<unsigned int>(i + 1));
+		}
 		
 		ctx->surface_clear_pass = new clear_pass(ctx->rasterizer, ctx->framebuffer_hdr);
+		ctx->surface_clear_pass->set_name("clear");
 		ctx->surface_clear_pass->set_cleared_buffers(true, true, true);
 		ctx->surface_clear_pass->set_clear_depth(0.0f);
 		
 		ctx->surface_sky_pass = new sky_pass(ctx->rasterizer, ctx->framebuffer_hdr, ctx->resource_manager);
+		ctx->surface_sky_pass->set_name("sky");
 		ctx->app->get_event_dispatcher()->subscribe<mouse_moved_event>(ctx->surface_sky_pass);
 		
 		ctx->surface_material_pass = new material_pass(ctx->rasterizer, ctx->framebuffer_hdr, ctx->resource_manager);
 		ctx->surface_material_pass->set_fallback_material(ctx->fallback_material);
+		ctx->surface_material_pass->set_texture_streamer(ctx->texture_streamer);
+		ctx->surface_material_pass->set_name("material");
+		if (ctx->config->has("surface_depth_prepass"))
+			ctx->surface_material_pass->set_depth_prepass(ctx->config->get<int>("surface_depth_prepass") != 0);
+		if (ctx->config->has("weighted_blended_oit"))
+			ctx->surface_material_pass->set_weighted_blended_oit(ctx->config->get<int>("weighted_blended_oit") != 0);
 		ctx->surface_material_pass->shadow_map_pass = ctx->surface_shadow_map_pass;
-		ctx->surface_material_pass->shadow_map = ctx->shadow_map_depth_texture;
+		ctx->surface_material_pass->set_shadow_map(ctx->shadow_map_depth_texture);
 		ctx->app->get_event_dispatcher()->subscribe<mouse_moved_event>(ctx->surface_material_pass);
 		
 		ctx->surface_outline_pass = new outline_pass(ctx->rasterizer, ctx->framebuffer_hdr, ctx->resource_manager);
+		ctx->surface_outline_pass->set_name("outline");
 		ctx->surface_outline_pass->set_outline_width(0.25f);
 		ctx->surface_outline_pass->set_outline_color(float4{1.0f, 1.0f, 1.0f, 1.0f});
+		if (ctx->config->has("outline_mode") && ctx->config->get<std::string>("outline_mode") == "jump_flood")
+			ctx->surface_outline_pass->set_mode(outline_mode::jump_flood);
+		if (ctx->config->has("outline_pixel_width"))
+			ctx->surface_outline_pass->set_outline_pixel_width(ctx->config->get<float>("outline_pixel_width"));
+		
+		// Pick the cursor on the GPU rather than by ray casts against collision meshes
+		if (ctx->config->has("gpu_picking") && ctx->config->get<int>("gpu_picking") != 0)
+		{
+			ctx->surface_picking_pass = new picking_pass(ctx->rasterizer, ctx->resource_manager);
+			ctx->surface_picking_pass->set_name("picking");
+		}
+		
+		// Draw debug primitives over the surface scene in debug builds only
+		ctx->surface_debug_draw_pass = nullptr;
+		#if defined(DEBUG)
+			ctx->surface_debug_draw_pass = new debug_draw_pass(ctx->rasterizer, ctx->framebuffer_hdr, ctx->resource_manager);
+			ctx->surface_debug_draw_pass->set_name("debug_draw");
+			ctx->surface_debug_draw_pass->set_font(ctx->ui_font);
+		#endif
 		
 		ctx->surface_compositor = new compositor();
-		ctx->surface_compositor->add_pass(ctx->surface_shadow_map_clear_pass);
+		ctx->surface_compositor->set_profiler(ctx->pass_profiler);
 		ctx->surface_compositor->add_pass(ctx->surface_shadow_map_pass);
 		ctx->surface_compositor->add_pass(ctx->surface_clear_pass);
 		ctx->surface_compositor->add_pass(ctx->surface_sky_pass);
 		ctx->surface_compositor->add_pass(ctx->surface_material_pass);
 		//ctx->surface_compositor->add_pass(ctx->surface_outline_pass);
+		if (ctx->surface_debug_draw_pass)
+			ctx->surface_compositor->add_pass(ctx->surface_debug_draw_pass);
+		if (ctx->surface_picking_pass)
+			ctx->surface_compositor->add_pass(ctx->surface_picking_pass);
 		ctx->surface_compositor->add_pass(ctx->common_bloom_pass);
+		if (ctx->common_temporal_upsample_pass)
+			ctx->surface_compositor->add_pass(ctx->common_temporal_upsample_pass);
 		ctx->surface_compositor->add_pass(ctx->common_final_pass);
 	}
 	
@@ -616,6 +957,12 @@ void setup_rendering(game::context* ctx)
 	// Create renderer
 	ctx->renderer = new renderer();
 	ctx->renderer->set_billboard_vao(ctx->billboard_vao);
+	ctx->renderer->set_job_system(ctx->app->get_job_system());
+	if (ctx->config->has("animation_lod_distances"))
+	{
+		const float2 distances = ctx->config->get<float2>("animation_lod_distances");
+		ctx->renderer->set_animation_lod_distances(distances.x, distances.y);
+	}
 	
 	logger->pop_task(EXIT_SUCCESS);
 }
@@ -643,6 +990,7 @@ void setup_scenes(game::context* ctx)
 	ctx->underground_camera->set_compositor(ctx->underground_compositor);
 	ctx->underground_camera->set_composite_index(0);
 	ctx->underground_camera->set_active(false);
+	ctx->renderer->set_occlusion_buffer(ctx->underground_camera, &ctx->underground_occlusion_pass->get_occlusion_buffer());
 	
 	// Setup surface camera
 	ctx->surface_camera = new scene::camera();
@@ -688,6 +1036,7 @@ void setup_scenes(game::context* ctx)
 	// Setup underground scene
 	{
 		ctx->underground_scene = new scene::collection();
+		ctx->underground_scene->set_spatial_indexing(true);
 		
 		ctx->underground_ambient_light = new scene::ambient_light();
 		ctx->underground_ambient_light->set_color({1, 1, 1});
@@ -708,6 +1057,7 @@ void setup_scenes(game::context* ctx)
 	// Setup surface scene
 	{
 		ctx->surface_scene = new scene::collection();
+		ctx->surface_scene->set_spatial_indexing(true);
 		
 		ctx->lens_spot_light = new scene::spot_light();
 		ctx->lens_spot_light->set_color({1, 1, 1});
@@ -769,7 +1119,34 @@ void setup_animation(game::context* ctx)
 	ctx->surface_material_pass->set_focal_point_tween(ctx->focal_point_tween);
 	ctx->underground_material_pass->set_time_tween(ctx->time_tween);
 	ctx->underground_material_pass->set_focal_point_tween(ctx->focal_point_tween);
-	ctx->ui_material_pass->set_time_tween(ctx->time_tween);
+	ctx->ui_pass->set_time_tween(ctx->time_tween);
+}
+
+void setup_audio(game::context* ctx)
+{
+	debug::logger* logger = ctx->logger;
+	logger->push_task("Setting up audio");
+	
+	// Open audio device and start the mixer thread, continuing without sound on failure
+	std::size_t voice_count = 32;
+	if (ctx->config->has("audio_voice_count"))
+		voice_count = static_cast<std::size_t>(std::max(1, ctx->config->get<int>("audio_voice_count")));
+	try
+	{
+		ctx->mixer = new audio::mixer(voice_count);
+	}
+	catch (const std::exception& e)
+	{
+		logger->warning(e.what());
+		logger->pop_task(EXIT_FAILURE);
+		return;
+	}
+	
+	if (ctx->config->has("audio_gain"))
+		ctx->mixer->set_gain(ctx->config->get<float>("audio_gain"));
+	ctx->mixer->commit();
+	
+	logger->pop_task(EXIT_SUCCESS);
 }
 
 void setup_entities(game::context* ctx)
@@ -803,14 +1180,34 @@ void setup_systems(game::context* ctx)
 	ctx->terrain_system->set_patch_subdivisions(30);
 	ctx->terrain_system->set_patch_scene_collection(ctx->surface_scene);
 	ctx->terrain_system->set_max_error(200.0);
+	ctx->terrain_system->set_job_system(ctx->app->get_job_system());
+	if (ctx->config->has("terrain_upload_budget"))
+		ctx->terrain_system->set_patch_upload_budget(static_cast<std::size_t>(std::max<int>(0, ctx->config->get<int>("terrain_upload_budget"))));
+	if (ctx->config->has("terrain_patch_memory"))
+		ctx->terrain_system->set_patch_memory_budget(static_cast<std::size_t>(std::max<int>(0, ctx->config->get<int>("terrain_patch_memory"))) * 1024 * 1024);
+	
+	// Cache generated terrain patches on disk, streaming revisited patches rather than regenerating them
+	ctx->terrain_patch_cache = nullptr;
+	if (ctx->config->has("terrain_patch_cache") && ctx->config->get<int>("terrain_patch_cache") != 0)
+	{
+		ctx->terrain_patch_cache = new terrain_patch_cache(ctx->terrain_cache_path);
+		ctx->terrain_system->set_patch_cache(ctx->terrain_patch_cache);
+	}
 	
 	// Setup vegetation system
-	//ctx->vegetation_system = new entity::system::vegetation(*ctx->entity_registry);
-	//ctx->vegetation_system->set_terrain_patch_size(TERRAIN_PATCH_SIZE);
-	//ctx->vegetation_system->set_vegetation_patch_resolution(VEGETATION_PATCH_RESOLUTION);
-	//ctx->vegetation_system->set_vegetation_density(1.0f);
-	//ctx->vegetation_system->set_vegetation_model(ctx->resource_manager->load<model>("grass-tuft.mdl"));
-	//ctx->vegetation_system->set_scene(ctx->surface_scene);
+	ctx->vegetation_system = new entity::system::vegetation(*ctx->entity_registry);
+	ctx->vegetation_system->set_vegetation_patch_resolution(1);
+	ctx->vegetation_system->set_vegetation_density((ctx->config->has("vegetation_density")) ? ctx->config->get<float>("vegetation_density") : 1.0f);
+	ctx->vegetation_system->set_vegetation_model(ctx->resource_manager->load<model>("grass-tuft.mdl"));
+	ctx->vegetation_system->set_scene(ctx->surface_scene);
+	ctx->vegetation_system->set_camera(ctx->surface_camera);
+	ctx->vegetation_system->set_job_system(ctx->app->get_job_system());
+	if (ctx->config->has("vegetation_fade_distances"))
+	{
+		const float2 fade_distances = ctx->config->get<float2>("vegetation_fade_distances");
+		ctx->vegetation_system->set_fade_distances(fade_distances[0], fade_distances[1]);
+	}
+	ctx->terrain_system->add_patch_listener(ctx->vegetation_system);
 	
 	// Setup camera system
 	ctx->camera_system = new entity::system::camera(*ctx->entity_registry);
@@ -827,37 +1224,83 @@ void setup_systems(game::context* ctx)
 	// Setup subterrain system
 	ctx->subterrain_system = new entity::system::subterrain(*ctx->entity_registry, ctx->resource_manager);
 	ctx->subterrain_system->set_scene(ctx->underground_scene);
+	ctx->subterrain_system->set_job_system(ctx->app->get_job_system());
 	
 	// Setup nest system
 	ctx->nest_system = new entity::system::nest(*ctx->entity_registry, ctx->resource_manager);
+	ctx->nest_system->set_job_system(ctx->app->get_job_system());
+	ctx->nest_system->set_subterrain_system(ctx->subterrain_system);
 	
 	// Setup collision system
 	ctx->collision_system = new entity::system::collision(*ctx->entity_registry);
+	ctx->collision_system->set_job_system(ctx->app->get_job_system());
+	ctx->tool_system->set_collision_system(ctx->collision_system);
+	ctx->tool_system->set_picking_pass(ctx->surface_picking_pass);
 	
 	// Setup samara system
 	ctx->samara_system = new entity::system::samara(*ctx->entity_registry);
+	if (ctx->config->has("samara_count"))
+	{
+		ctx->samara_system->set_samara_model(ctx->resource_manager->load<model>("samara.mdl"));
+		ctx->samara_system->set_scene(ctx->surface_scene);
+		ctx->samara_system->set_samara_count(static_cast<std::size_t>(std::max<int>(0, ctx->config->get<int>("samara_count"))));
+	}
 	
 	// Setup snapping system
 	ctx->snapping_system = new entity::system::snapping(*ctx->entity_registry);
+	ctx->snapping_system->set_collision_system(ctx->collision_system);
 	
 	// Setup behavior system
 	ctx->behavior_system = new entity::system::behavior(*ctx->entity_registry);
+	ctx->behavior_system->set_job_system(ctx->app->get_job_system());
+	if (ctx->config->has("behavior_budget"))
+		ctx->behavior_system->set_evaluation_budget(static_cast<std::size_t>(std::max<int>(0, ctx->config->get<int>("behavior_budget"))));
+	if (ctx->config->has("behavior_priority_distance"))
+		ctx->behavior_system->set_priority_distance(ctx->config->get<float>("behavior_priority_distance"));
+	
+	// Setup simulation LOD system, which aggregates unwatched colony members
+	ctx->simulation_lod_system = new entity::system::simulation_lod(*ctx->entity_registry);
+	if (ctx->config->has("simulation_materialize_distance"))
+		ctx->simulation_lod_system->set_materialize_distance(ctx->config->get<float>("simulation_materialize_distance"));
+	if (ctx->config->has("simulation_aggregate_distance"))
+		ctx->simulation_lod_system->set_aggregate_distance(ctx->config->get<float>("simulation_aggregate_distance"));
+	if (ctx->config->has("simulation_coarse_interval"))
+		ctx->simulation_lod_system->set_coarse_interval(static_cast<std::uint32_t>(std::max<int>(0, ctx->config->get<int>("simulation_coarse_interval"))));
+	
+	// Setup navigation mesh, over terrain patches and tunnel walls
+	ctx->navmesh = new ai::navmesh(8.0f);
+	ctx->subterrain_system->set_navmesh(ctx->navmesh);
 	
 	// Setup locomotion system
 	ctx->locomotion_system = new entity::system::locomotion(*ctx->entity_registry);
+	ctx->locomotion_system->set_job_system(ctx->app->get_job_system());
+	ctx->locomotion_system->set_navmesh(ctx->navmesh);
+	if (ctx->config->has("path_budget"))
+		ctx->locomotion_system->set_path_budget(static_cast<std::size_t>(std::max<int>(0, ctx->config->get<int>("path_budget"))));
+	if (ctx->config->has("navigation_terrain_depth"))
+		ctx->locomotion_system->set_terrain_depth(static_cast<std::size_t>(std::max<int>(0, ctx->config->get<int>("navigation_terrain_depth"))));
+	if (ctx->config->has("avoidance_radius"))
+		ctx->locomotion_system->set_avoidance_radius(ctx->config->get<float>("avoidance_radius"));
+	if (ctx->config->has("avoidance_time_horizon"))
+		ctx->locomotion_system->set_avoidance_time_horizon(ctx->config->get<float>("avoidance_time_horizon"));
+	ctx->terrain_system->add_patch_listener(ctx->locomotion_system);
+	
+	// Setup pheromone field over the surface, with recruitment and trail channels
+	ctx->pheromones = new pheromone_field(float3{-128.0f, 0.0f, -128.0f}, 1.0f, {256, 1, 256}, 2);
+	ctx->pheromones->set_job_system(ctx->app->get_job_system());
+	ctx->pheromones->set_diffusion_rate(0, 2.0f);
+	ctx->pheromones->set_evaporation_rate(0, 0.2f);
+	ctx->pheromones->set_diffusion_rate(1, 0.25f);
+	ctx->pheromones->set_evaporation_rate(1, 0.02f);
+	ctx->behavior_system->set_pheromone_field(ctx->pheromones);
 	
 	// Setup pheromone system
-	ctx->pheromones = new pheromone_matrix();
-	ctx->pheromones->rows = 256;
-	ctx->pheromones->columns = 256;
-	ctx->pheromones->buffers = new float*[2];
-	ctx->pheromones->buffers[0] = new float[ctx->pheromones->rows * ctx->pheromones->columns];
-	ctx->pheromones->buffers[1] = new float[ctx->pheromones->rows * ctx->pheromones->columns];
-	ctx->pheromones->current = 0;
-	//diffuse(ctx->pheromones);
+	ctx->pheromone_system = new entity::system::pheromone(*ctx->entity_registry);
+	ctx->pheromone_system->set_field(ctx->pheromones);
 	
 	// Setup spatial system
 	ctx->spatial_system = new entity::system::spatial(*ctx->entity_registry);
+	ctx->spatial_system->set_job_system(ctx->app->get_job_system());
 	
 	// Setup constraint system
 	ctx->constraint_system = new entity::system::constraint(*ctx->entity_registry);
@@ -872,6 +1315,7 @@ void setup_systems(game::context* ctx)
 	
 	// Setup solar system
 	ctx->orbit_system = new entity::system::orbit(*ctx->entity_registry);
+	ctx->orbit_system->set_job_system(ctx->app->get_job_system());
 	
 	// Setup blackbody system
 	ctx->blackbody_system = new entity::system::blackbody(*ctx->entity_registry);
@@ -887,6 +1331,9 @@ void setup_systems(game::context* ctx)
 	
 	// Setup proteome system
 	ctx->proteome_system = new entity::system::proteome(*ctx->entity_registry);
+	ctx->proteome_system->set_job_system(ctx->app->get_job_system());
+	if (ctx->config->has("proteome_cache_capacity"))
+		ctx->proteome_system->set_cache_capacity(static_cast<std::size_t>(std::max<int>(0, ctx->config->get<int>("proteome_cache_capacity"))));
 	
 	// Set time scale
 	float time_scale = 60.0f;
@@ -927,6 +1374,159 @@ void setup_systems(game::context* ctx)
 	ctx->ui_system->set_tool_menu_control(ctx->control_system->get_tool_menu_control());
 	event_dispatcher->subscribe<mouse_moved_event>(ctx->ui_system);
 	event_dispatcher->subscribe<window_resized_event>(ctx->ui_system);
+	
+	// Setup sound system
+	ctx->sound_system = new entity::system::sound(*ctx->entity_registry);
+	ctx->sound_system->set_mixer(ctx->mixer);
+	ctx->sound_system->set_listener(ctx->surface_camera);
+	
+	// Setup system scheduler, which updates independent systems concurrently
+	ctx->system_scheduler = new entity::system::scheduler(ctx->app->get_job_system());
+	
+	entity::system::scheduler* scheduler = ctx->system_scheduler;
+	scheduler->add_system(ctx->control_system, "control");
+	scheduler->add_system(ctx->terrain_system, "terrain");
+	scheduler->add_system(ctx->vegetation_system, "vegetation");
+	scheduler->add_system(ctx->snapping_system, "snapping");
+	scheduler->add_system(ctx->nest_system, "nest");
+	scheduler->add_system(ctx->subterrain_system, "subterrain");
+	scheduler->add_system(ctx->collision_system, "collision");
+	scheduler->add_system(ctx->samara_system, "samara");
+	scheduler->add_system(ctx->pheromone_system, "pheromone");
+	scheduler->add_system(ctx->simulation_lod_system, "simulation lod");
+	scheduler->add_system(ctx->behavior_system, "behavior");
+	scheduler->add_system(ctx->locomotion_system, "locomotion");
+	scheduler->add_system(ctx->camera_system, "camera");
+	scheduler->add_system(ctx->tool_system, "tool");
+	scheduler->add_system(ctx->orbit_system, "orbit");
+	scheduler->add_system(ctx->blackbody_system, "blackbody");
+	scheduler->add_system(ctx->atmosphere_system, "atmosphere");
+	scheduler->add_system(ctx->astronomy_system, "astronomy");
+	scheduler->add_system(ctx->spatial_system, "spatial");
+	scheduler->add_system(ctx->constraint_system, "constraint");
+	scheduler->add_system(ctx->tracking_system, "tracking");
+	scheduler->add_system(ctx->painting_system, "painting");
+	scheduler->add_system(ctx->proteome_system, "proteome");
+	
+	// World transforms must be resolved before constraints are applied
+	scheduler->add_dependency(ctx->orbit_system, ctx->astronomy_system);
+	scheduler->add_dependency(ctx->spatial_system, ctx->constraint_system);
+	
+	// Terrain patches are released, and the camera moved, before vegetation is faded
+	scheduler->add_dependency(ctx->terrain_system, ctx->vegetation_system);
+	scheduler->add_dependency(ctx->camera_system, ctx->vegetation_system);
+	
+	// Nests are dug before the subterrain marches modified chunks
+	scheduler->add_dependency(ctx->nest_system, ctx->subterrain_system);
+	
+	// Entities switch simulation detail before they are evaluated and moved
+	scheduler->add_dependency(ctx->simulation_lod_system, ctx->behavior_system);
+	scheduler->add_dependency(ctx->simulation_lod_system, ctx->locomotion_system);
+}
+
+void setup_quality(game::context* ctx)
+{
+	// Govern quality only if a target frame time is configured, and never while benchmarking, as changes would skew the measurements
+	ctx->quality_governor = nullptr;
+	if (!ctx->config->has("quality_target_frame_time") || ctx->option_benchmark.has_value())
+		return;
+	
+	debug::logger* logger = ctx->logger;
+	logger->push_task("Setting up quality governor");
+	
+	game::quality_governor* governor = new game::quality_governor();
+	governor->set_target_frame_duration(ctx->config->get<float>("quality_target_frame_time") / 1000.0);
+	if (ctx->config->has("quality_headroom"))
+		governor->set_headroom(ctx->config->get<float>("quality_headroom"));
+	
+	using processor = game::quality_governor::processor;
+	
+	// Bloom: fewer blur iterations, or fewer levels of the dual-filter mip chain
+	if (ctx->config->has("bloom_mode") && ctx->config->get<std::string>("bloom_mode") == "blur")
+	{
+		governor->add_knob("quality.bloom", 0, processor::gpu, 0, 2, [ctx](int level)
+		{
+			ctx->common_bloom_pass->set_blur_iterations(5 >> (2 - level));
+		});
+	}
+	else
+	{
+		const int mip_count = (ctx->config->has("bloom_mip_count")) ? ctx->config->get<int>("bloom_mip_count") : 6;
+		governor->add_knob("quality.bloom", 0, processor::gpu, 0, 2, [ctx, mip_count](int level)
+		{
+			ctx->common_bloom_pass->set_mip_count(std::max(2, mip_count - (2 - level)));
+		});
+	}
+	
+	// Shadows: refresh far cascades less often, starting from the configured caching
+	const bool shadow_cascade_caching = ctx->config->has("shadow_cascade_caching") && ctx->config->get<int>("shadow_cascade_caching") != 0;
+	governor->add_knob("quality.shadow_refresh", 1, processor::gpu | processor::cpu, 0, (shadow_cascade_caching) ? 1 : 2, [ctx](int level)
+	{
+		static constexpr unsigned int intervals[3][4] = {{1, 2, 4, 8}, {1, 2, 3, 4}, {1, 1, 1, 1}};
+		for (std::size_t i = 1; i < 4; ++i)
+			ctx->surface_shadow_map_pass->set_cascade_update_interval(i, intervals[level][i]);
+	});
+	
+	// Shadows: re-render fewer shadow atlas tiles per frame, down to one point light every three frames
+	const int shadow_atlas_budget = (ctx->config->has("shadow_atlas_update_budget")) ? std::max(2, ctx->config->get<int>("shadow_atlas_update_budget")) : 6;
+	governor->add_knob("quality.shadow_atlas_budget", 1, processor::gpu | processor::cpu, 0, 2, [ctx, shadow_atlas_budget](int level)
+	{
+		const int budgets[3] = {2, std::max(2, shadow_atlas_budget / 2), shadow_atlas_budget};
+		ctx->underground_shadow_atlas_pass->set_update_budget(static_cast<std::size_t>(budgets[level]));
+	});
+	
+	// Animation: skin distant models at reduced rates nearer to the camera
+	if (ctx->config->has("animation_lod_distances"))
+	{
+		const float2 distances = ctx->config->get<float2>("animation_lod_distances");
+		governor->add_knob("quality.animation_lod", 2, processor::cpu, 0, 2, [ctx, distances](int level)
+		{
+			const float scale = 1.0f / static_cast<float>(1 << (2 - level));
+			ctx->renderer->set_animation_lod_distances(distances.x * scale, distances.y * scale);
+		});
+	}
+	
+	// Vegetation: scatter fewer instances on newly uploaded terrain patches
+	const float vegetation_density = ctx->vegetation_system->get_vegetation_density();
+	governor->add_knob("quality.vegetation_density", 3, processor::gpu | processor::cpu, 0, 3, [ctx, vegetation_density](int level)
+	{
+		ctx->vegetation_system->set_vegetation_density(vegetation_density * static_cast<float>(level + 1) / 4.0f);
+	});
+	
+	// Behavior: evaluate fewer behavior trees per update, if evaluation is budgeted
+	if (ctx->config->has("behavior_budget") && ctx->config->get<int>("behavior_budget") > 0)
+	{
+		const std::size_t behavior_budget = static_cast<std::size_t>(ctx->config->get<int>("behavior_budget"));
+		governor->add_knob("quality.behavior_budget", 4, processor::cpu, 0, 2, [ctx, behavior_budget](int level)
+		{
+			ctx->behavior_system->set_evaluation_budget(std::max<std::size_t>(1, behavior_budget >> (2 - level)));
+		});
+	}
+	
+	// Terrain: tolerate greater screen-space error, subdividing fewer patches
+	const double terrain_max_error = ctx->terrain_system->get_max_error();
+	governor->add_knob("quality.terrain_error", 5, processor::gpu | processor::cpu, 0, 2, [ctx, terrain_max_error](int level)
+	{
+		ctx->terrain_system->set_max_error(terrain_max_error * static_cast<double>(1 << (2 - level)));
+	});
+	
+	// Resolution: render the HDR framebuffer at a reduced fixed scale, unless it's already scaled dynamically or temporally upsampled at a configured scale
+	if (!ctx->resolution_scaler)
+	{
+		ctx->resolution_scaler = new resolution_scaler(ctx->framebuffer_hdr);
+		governor->add_knob("quality.resolution", 6, processor::gpu, 0, 4, [ctx](int level)
+		{
+			const float scale = 0.5f + 0.125f * static_cast<float>(level);
+			ctx->resolution_scaler->set_scale_range(scale, scale);
+		});
+	}
+	
+	// Measure GPU frame times
+	ctx->pass_profiler->set_enabled(true);
+	
+	ctx->quality_governor = governor;
+	
+	logger->pop_task(EXIT_SUCCESS);
 }
 
 void setup_controls(game::context* ctx)
@@ -1240,9 +1840,80 @@ void setup_cli(game::context* ctx)
 	ctx->cli->register_command("exit", std::function<std::string()>(std::bind(&debug::cc::exit, ctx)));
 	ctx->cli->register_command("scrot", std::function<std::string()>(std::bind(&debug::cc::scrot, ctx)));
 	ctx->cli->register_command("cue", std::function<std::string(float, std::string)>(std::bind(&debug::cc::cue, ctx, std::placeholders::_1, std::placeholders::_2)));
+	ctx->cli->register_command("batching", std::function<std::string()>(std::bind(&debug::cc::batching, ctx)));
+	ctx->cli->register_command("gpu_profile", std::function<std::string(int)>(std::bind(&debug::cc::gpu_profile, ctx, std::placeholders::_1)));
+	ctx->cli->register_command("gpu_times", std::function<std::string()>(std::bind(&debug::cc::gpu_times, ctx)));
+	ctx->cli->register_command("latency", std::function<std::string()>(std::bind(&debug::cc::latency, ctx)));
+	ctx->cli->register_command("frame_stats", std::function<std::string()>(std::bind(&debug::cc::frame_stats, ctx)));
+	ctx->cli->register_command("frame_csv", std::function<std::string(std::string)>(std::bind(&debug::cc::frame_csv, ctx, std::placeholders::_1)));
+	ctx->cli->register_command("record", std::function<std::string(std::string)>(std::bind(&debug::cc::record, ctx, std::placeholders::_1)));
+	ctx->cli->register_command("trace", debug::cc::trace);
+	ctx->cli->register_command("stats", debug::cc::stats);
+	ctx->cli->register_command("allocations", debug::cc::allocations);
+	ctx->cli->register_command("find", std::function<std::string(std::string)>(std::bind(&debug::cc::find, ctx, std::placeholders::_1)));
+	ctx->cli->register_command("resource", std::function<std::string(std::string)>(std::bind(&debug::cc::resource, ctx, std::placeholders::_1)));
+	ctx->cli->register_command("draw", std::function<std::string(std::string, int)>(debug::cc::draw));
+	ctx->cli->register_command("pools", std::function<std::string()>(std::bind(&debug::cc::pools, ctx)));
+	ctx->cli->register_command("save", std::function<std::string(std::string)>(std::bind(&debug::cc::save, ctx, std::placeholders::_1)));
+	ctx->cli->register_command("load", std::function<std::string(std::string)>(std::bind(&debug::cc::load, ctx, std::placeholders::_1)));
 	//std::string cmd = "cue 20 exit";
 	//logger->log(cmd);
 	//logger->log(cli.interpret(cmd));
+	
+	// Stream telemetry to external dashboards if a telemetry port is configured, continuing without telemetry on failure
+	ctx->telemetry_server = nullptr;
+	if (ctx->config->has("telemetry_port"))
+	{
+		const int port = ctx->config->get<int>("telemetry_port");
+		try
+		{
+			ctx->telemetry_server = new debug::telemetry_server(static_cast<std::uint16_t>(port));
+		}
+		catch (const std::exception& e)
+		{
+			ctx->logger->warning(e.what());
+			return;
+		}
+		
+		ctx->telemetry_server->set_cli(ctx->cli);
+		if (ctx->config->has("telemetry_interval"))
+			ctx->telemetry_server->set_report_interval(ctx->config->get<float>("telemetry_interval"));
+		
+		// Report frame time percentiles and per-pass GPU times alongside the counters
+		ctx->telemetry_server->set_report_callback
+		(
+			[ctx](std::ostream& stream)
+			{
+				stream << ",\"frame\":{";
+				bool first = true;
+				for (application::timing_channel channel: {application::timing_channel::frame, application::timing_channel::update, application::timing_channel::render, application::timing_channel::swap})
+				{
+					const debug::performance_sampler* sampler = ctx->app->get_timing_sampler(channel);
+					stream << ((first) ? "" : ",") << '"' << application::get_timing_channel_name(channel) << "\":{";
+					stream << "\"p50\":" << sampler->streaming_percentile(0.5) * 1000.0;
+					stream << ",\"p95\":" << sampler->streaming_percentile(0.95) * 1000.0;
+					stream << ",\"p99\":" << sampler->streaming_percentile(0.99) * 1000.0;
+					stream << ",\"max\":" << sampler->max_duration() * 1000.0 << '}';
+					first = false;
+				}
+				stream << '}';
+				
+				if (ctx->pass_profiler->is_enabled())
+				{
+					stream << ",\"gpu\":{";
+					first = true;
+					for (const auto& [name, timing]: ctx->pass_profiler->get_timings())
+					{
+						stream << ((first) ? "" : ",") << '"' << name << "\":" << timing.mean_duration * 1000.0;
+						first = false;
+					}
+					stream << '}';
+				}
+			}
+		);
+		
+		ctx->logger->log("Streaming telemetry on port " + std::to_string(port));
+	}
 }
 
 void setup_callbacks(game::context* ctx)
@@ -1252,8 +1923,16 @@ void setup_callbacks(game::context* ctx)
 	(
 		[ctx](double t, double dt)
 		{
+			// Complete asynchronous resource requests, within a budget of two milliseconds
+			ctx->resource_manager->update(0.002);
+			
 			// Update tweens
+			scene::object_base::get_transform_store().update();
 			ctx->time_tween->update();
+			
+			// Drive the camera along the benchmark path
+			if (ctx->benchmark)
+				ctx->benchmark->update(t, dt);
 			ctx->surface_sky_pass->update_tweens();
 			ctx->surface_scene->update_tweens();
 			ctx->underground_scene->update_tweens();
@@ -1265,28 +1944,11 @@ void setup_callbacks(game::context* ctx)
 						
 			ctx->timeline->advance(dt);
 			
-			ctx->control_system->update(t, dt);
-			ctx->terrain_system->update(t, dt);
-			//ctx->vegetation_system->update(t, dt);
-			ctx->snapping_system->update(t, dt);
-			ctx->nest_system->update(t, dt);
-			ctx->subterrain_system->update(t, dt);
-			ctx->collision_system->update(t, dt);
-			ctx->samara_system->update(t, dt);
-			ctx->behavior_system->update(t, dt);
-			ctx->locomotion_system->update(t, dt);
-			ctx->camera_system->update(t, dt);
-			ctx->tool_system->update(t, dt);
+			// Update systems, concurrently where their component access allows
+			ctx->system_scheduler->update(t, dt);
 			
-			ctx->orbit_system->update(t, dt);
-			ctx->blackbody_system->update(t, dt);
-			ctx->atmosphere_system->update(t, dt);
-			ctx->astronomy_system->update(t, dt);
-			ctx->spatial_system->update(t, dt);
-			ctx->constraint_system->update(t, dt);
-			ctx->tracking_system->update(t, dt);
-			ctx->painting_system->update(t, dt);
-			ctx->proteome_system->update(t, dt);
+			// Pass sound source positions to the mixer thread once their transforms have been resolved
+			ctx->sound_system->update(t, dt);
 			
 			//(*ctx->focal_point_tween)[1] = ctx->orbit_cam->get_focal_point();
 			
@@ -1298,21 +1960,80 @@ void setup_callbacks(game::context* ctx)
 			ctx->flashlight_spot_light->look_at(xf.translation, xf.translation + xf.rotation * float3{0, 0, 1}, {0, 0, -1});
 			
 			ctx->ui_system->update(dt);
-			ctx->render_system->update(t, dt);
+			
+			// Render system updates scene objects and is updated last, on the main thread
+			{
+				debug::profile_zone zone("render");
+				ctx->render_system->update(t, dt);
+			}
+			
+			// Redraw while animations play in idle mode, including the frame on which they end
+			const bool animating = ctx->animator->is_animating();
 			ctx->animator->animate(dt);
+			if (animating || ctx->animator->is_animating())
+				ctx->app->request_redraw();
 			
 			ctx->application_controls->update();
 			ctx->menu_controls->update();
 			ctx->camera_controls->update();
+			
+			if (ctx->telemetry_server)
+				ctx->telemetry_server->update();
+			
+			// Return to live input once all recorded input has been replayed
+			debug::input_recorder* input_recorder = ctx->app->get_input_recorder();
+			if (input_recorder->is_replay_finished())
+			{
+				input_recorder->stop_replay();
+				ctx->logger->log("Finished replaying input after " + std::to_string(input_recorder->get_update_index()) + " updates");
+			}
 		}
 	);
 	
 	// Set render callback
 	ctx->app->set_render_callback
 	(
-		[ctx](double alpha)
+		[ctx, measured_frame_count = std::size_t(0)](double alpha) mutable
 		{
+			ctx->pass_profiler->begin_frame();
+			
+			// Rescale the HDR framebuffer and govern quality once per newly measured frame
+			if (ctx->pass_profiler->get_measured_frame_count() != measured_frame_count)
+			{
+				measured_frame_count = ctx->pass_profiler->get_measured_frame_count();
+				if (ctx->resolution_scaler)
+					ctx->resolution_scaler->update(ctx->pass_profiler->get_frame_duration());
+				if (ctx->quality_governor)
+					ctx->quality_governor->update(ctx->app->get_cpu_frame_duration(), ctx->pass_profiler->get_frame_duration());
+			}
+			
+			// Jitter the scene cameras for temporal upsampling
+			if (ctx->common_temporal_upsample_pass)
+			{
+				ctx->common_temporal_upsample_pass->jitter(*ctx->surface_camera);
+				ctx->common_temporal_upsample_pass->jitter(*ctx->underground_camera);
+			}
+			
+			ctx->terrain_system->upload_patches();
+			ctx->vegetation_system->upload_patches();
+			ctx->samara_system->upload_instances();
+			ctx->tracking_system->upload_instances();
+			ctx->subterrain_system->upload_chunks();
+			if (ctx->ui_font)
+				ctx->ui_font->upload();
+			
+			// Draw the debug primitives submitted since the previous frame. Primitives submitted while rendering, such as shadow cascades, are drawn by the next frame.
+			ctx->collision_system->draw_accelerators();
+			debug::draw::end_frame();
+			
 			ctx->render_system->draw(alpha);
+			
+			// Stream texture levels according to the materials drawn this frame
+			if (ctx->texture_streamer)
+				ctx->texture_streamer->update();
+			
+			if (ctx->benchmark)
+				ctx->benchmark->frame();
 		}
 	);
 }
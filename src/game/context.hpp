@@ -37,10 +37,12 @@
 #include "input/event-router.hpp"
 #include "animation/tween.hpp"
 #include "scene/scene.hpp"
+#include <cstdint>
 #include <optional>
 #include <entt/entt.hpp>
 #include <fstream>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 
 // Forward declarations
@@ -50,28 +52,51 @@ class bloom_pass;
 class clear_pass;
 class compositor;
 class config_file;
+class debug_draw_pass;
 class final_pass;
 class material;
 class material_pass;
+class occlusion_pass;
 class orbit_cam;
-class pheromone_matrix;
+class pass_profiler;
+class pheromone_field;
+class resolution_scaler;
 class resource_manager;
 class screen_transition;
+class shader_cache;
+class shadow_atlas_pass;
 class shadow_map_pass;
 class simple_render_pass;
 class sky_pass;
+class temporal_upsample_pass;
+class terrain_patch_cache;
+class texture_streamer;
 class timeline;
+class ui_pass;
 class renderer;
 class outline_pass;
+class picking_pass;
 
 struct biome;
 template <typename T> class animation;
 template <typename T> class material_property;
 
+namespace ai
+{
+	class navmesh;
+}
+
+namespace audio
+{
+	class mixer;
+}
+
 namespace debug
 {
 	class cli;
+	class json_log_sink;
 	class logger;
+	class telemetry_server;
 }
 
 namespace entity
@@ -98,20 +123,36 @@ namespace entity
 		class snapping;
 		class camera;
 		class nest;
+		class pheromone;
 		class render;
 		class samara;
 		class proteome;
+		class scheduler;
+		class simulation_lod;
+		class sound;
 	}
 }
 
+namespace type
+{
+	class font;
+	class text_cache;
+}
+
 namespace game {
 
+class asset_manifest;
+class benchmark;
+class quality_governor;
+
 /// Structure containing the state of a game.
 struct context
 {
 	application* app;
 	debug::logger* logger;
 	std::ofstream log_filestream;
+	std::ofstream log_json_filestream;
+	debug::json_log_sink* log_json_sink;
 	
 	// Command-line options
 	std::optional<std::string> option_biome;
@@ -123,6 +164,14 @@ struct context
 	std::optional<bool> option_reset;
 	std::optional<int> option_vsync;
 	std::optional<bool> option_windowed;
+	std::optional<std::string> option_startup_report;
+	std::optional<std::uint64_t> option_seed;
+	std::optional<std::string> option_record_input;
+	std::optional<std::string> option_replay_input;
+	std::optional<std::string> option_benchmark;
+	std::optional<int> option_benchmark_frames;
+	std::optional<std::string> option_benchmark_path;
+	std::optional<std::string> option_benchmark_report;
 	
 	// Paths
 	std::string data_path;
@@ -130,6 +179,9 @@ struct context
 	std::string mods_path;
 	std::string saves_path;
 	std::string screenshots_path;
+	std::string shader_cache_path;
+	std::string terrain_cache_path;
+	std::string resource_manifest_path;
 	std::string data_package_path;
 	
 	// Config
@@ -137,17 +189,26 @@ struct context
 	
 	// Resources
 	resource_manager* resource_manager;
+	shader_cache* shader_cache;
+	terrain_patch_cache* terrain_patch_cache;
 	
 	// Localization
 	std::string language_code;
 	int language_index;
 	string_table* string_table;
 	string_table_map string_table_map;
-	std::unordered_map<std::string, std::string>* strings;
+	std::unordered_map<std::string_view, std::string_view>* strings;
+	
+	// Text
+	type::font* ui_font;
+	material* ui_text_material;
+	type::text_cache* text_cache;
 	
 	// Framebuffers
 	gl::framebuffer* shadow_map_framebuffer;
 	gl::texture_2d* shadow_map_depth_texture;
+	gl::framebuffer* shadow_atlas_framebuffer;
+	gl::texture_2d* shadow_atlas_depth_texture;
 	gl::framebuffer* framebuffer_hdr;
 	gl::texture_2d* framebuffer_hdr_color;
 	gl::texture_2d* framebuffer_hdr_depth;
@@ -165,24 +226,41 @@ struct context
 	
 	// Compositing
 	clear_pass* ui_clear_pass;
-	material_pass* ui_material_pass;
+	::ui_pass* ui_pass;
 	compositor* ui_compositor;
 	
 	bloom_pass* common_bloom_pass;
+	temporal_upsample_pass* common_temporal_upsample_pass;
 	final_pass* common_final_pass;
 	
+	shadow_atlas_pass* underground_shadow_atlas_pass;
 	clear_pass* underground_clear_pass;
 	material_pass* underground_material_pass;
+	occlusion_pass* underground_occlusion_pass;
 	compositor* underground_compositor;
 	
-	clear_pass* surface_shadow_map_clear_pass;
 	shadow_map_pass* surface_shadow_map_pass;
 	clear_pass* surface_clear_pass;
 	sky_pass* surface_sky_pass;
 	material_pass* surface_material_pass;
 	outline_pass* surface_outline_pass;
+	picking_pass* surface_picking_pass;
+	
+	/// Debug draw pass of the surface scene, or `nullptr` in release builds.
+	debug_draw_pass* surface_debug_draw_pass;
+	
 	compositor* surface_compositor;
 	
+	pass_profiler* pass_profiler;
+	resolution_scaler* resolution_scaler;
+	texture_streamer* texture_streamer;
+	
+	/// Quality governor, or `nullptr` if quality isn't governed.
+	game::quality_governor* quality_governor;
+	
+	// Benchmarking
+	game::benchmark* benchmark;
+	
 	// Scene utilities
 	scene::collection* active_scene;
 	geom::aabb<float> no_cull;
@@ -217,6 +295,9 @@ struct context
 	animation<float>* equip_tool_animation;
 	animation<float>* unequip_tool_animation;
 	
+	// Audio
+	audio::mixer* mixer;
+	
 	// Controls
 	input::event_router* input_event_router;
 	input::mapper* input_mapper;
@@ -248,9 +329,11 @@ struct context
 	entity::system::control* control_system;
 	entity::system::locomotion* locomotion_system;
 	entity::system::nest* nest_system;
+	entity::system::pheromone* pheromone_system;
 	entity::system::snapping* snapping_system;
 	entity::system::render* render_system;
 	entity::system::samara* samara_system;
+	entity::system::simulation_lod* simulation_lod_system;
 	entity::system::subterrain* subterrain_system;
 	entity::system::terrain* terrain_system;
 	entity::system::tool* tool_system;
@@ -264,16 +347,25 @@ struct context
 	entity::system::astronomy* astronomy_system;
 	entity::system::orbit* orbit_system;
 	entity::system::proteome* proteome_system;
+	entity::system::sound* sound_system;
+	entity::system::scheduler* system_scheduler;
 	std::unordered_map<std::string, entity::id> named_entities;
 	
 	// Game
 	biome* biome;
 	
+	/// Assets prefetched for the next game state, or `nullptr` if none have been prefetched.
+	game::asset_manifest* prefetched_assets;
+	
 	// Debug
 	debug::cli* cli;
 	
+	/// Telemetry server, or `nullptr` if telemetry is disabled.
+	debug::telemetry_server* telemetry_server;
+	
 	// Misc
-	pheromone_matrix* pheromones;
+	pheromone_field* pheromones;
+	ai::navmesh* navmesh;
 };
 
 } // namespace game
@@ -0,0 +1,141 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "game/quality-governor.hpp"
+#include <algorithm>
+
+namespace game {
+
+quality_governor::quality_governor():
+	target_duration(1.0 / 60.0),
+	headroom(0.2),
+	base_raise_period(120),
+	raise_period(base_raise_period),
+	smoothed_cpu_duration(0.0),
+	smoothed_gpu_duration(0.0),
+	frames_since_change(0),
+	frames_with_headroom(0),
+	last_change_raised(false)
+{}
+
+void quality_governor::add_knob(const char* name, int priority, unsigned int processors, int min_level, int max_level, const std::function<void(int)>& apply)
+{
+	knob k{name, priority, processors, min_level, std::max(min_level, max_level), std::max(min_level, max_level), apply, debug::gauge(name)};
+	k.gauge.set(k.level);
+	
+	// Keep knobs sorted by priority, after knobs of equal priority
+	auto it = std::upper_bound(knobs.begin(), knobs.end(), priority, [](int priority, const knob& k){return priority < k.priority;});
+	knobs.insert(it, std::move(k));
+}
+
+void quality_governor::set_target_frame_duration(double duration)
+{
+	target_duration = duration;
+}
+
+void quality_governor::set_headroom(double headroom)
+{
+	this->headroom = headroom;
+}
+
+void quality_governor::set_raise_period(std::size_t frames)
+{
+	base_raise_period = frames;
+	raise_period = frames;
+}
+
+void quality_governor::update(double cpu_duration, double gpu_duration)
+{
+	// Smooth measured durations, restarting once the previous change has settled
+	++frames_since_change;
+	if (frames_since_change <= 2)
+	{
+		// Discard measurements of frames rendered before the change
+		smoothed_cpu_duration = 0.0;
+		smoothed_gpu_duration = 0.0;
+		return;
+	}
+	smoothed_cpu_duration = (smoothed_cpu_duration > 0.0) ? smoothed_cpu_duration + (cpu_duration - smoothed_cpu_duration) * 0.125 : cpu_duration;
+	smoothed_gpu_duration = (smoothed_gpu_duration > 0.0) ? smoothed_gpu_duration + (gpu_duration - smoothed_gpu_duration) * 0.125 : gpu_duration;
+	
+	if (frames_since_change < settle_frames)
+		return;
+	
+	// A raise which has held for a raise period didn't overrun the budget
+	if (last_change_raised && frames_since_change >= raise_period)
+		last_change_raised = false;
+	
+	unsigned int over_budget = 0;
+	if (smoothed_cpu_duration > target_duration)
+		over_budget |= processor::cpu;
+	if (smoothed_gpu_duration > target_duration)
+		over_budget |= processor::gpu;
+	
+	if (over_budget)
+	{
+		frames_with_headroom = 0;
+		
+		// Lower the least important knob which relieves an over-budget processor
+		auto it = std::find_if(knobs.begin(), knobs.end(), [over_budget](const knob& k){return (k.processors & over_budget) && k.level > k.min_level;});
+		if (it == knobs.end())
+			return;
+		
+		// Back off from raising again if the previous raise overran the budget
+		if (last_change_raised)
+			raise_period = std::min(raise_period * 2, base_raise_period * 16);
+		
+		set_level(*it, it->level - 1);
+		last_change_raised = false;
+	}
+	else if (std::max(smoothed_cpu_duration, smoothed_gpu_duration) < target_duration * (1.0 - headroom))
+	{
+		// Raise the most important knob below its maximum, once headroom has been sustained
+		if (++frames_with_headroom < raise_period)
+			return;
+		frames_with_headroom = 0;
+		
+		auto it = std::find_if(knobs.rbegin(), knobs.rend(), [](const knob& k){return k.level < k.max_level;});
+		if (it == knobs.rend())
+		{
+			// Every knob is at its maximum, and the budget holds
+			raise_period = base_raise_period;
+			return;
+		}
+		
+		set_level(*it, it->level + 1);
+		last_change_raised = true;
+	}
+	else
+	{
+		frames_with_headroom = 0;
+	}
+}
+
+void quality_governor::set_level(knob& k, int level)
+{
+	k.level = level;
+	k.apply(level);
+	k.gauge.set(level);
+	
+	frames_since_change = 0;
+	smoothed_cpu_duration = 0.0;
+	smoothed_gpu_duration = 0.0;
+}
+
+} // namespace game
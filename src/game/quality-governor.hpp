@@ -0,0 +1,146 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ANTKEEPER_GAME_QUALITY_GOVERNOR_HPP
+#define ANTKEEPER_GAME_QUALITY_GOVERNOR_HPP
+
+#include "debug/counters.hpp"
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+namespace game {
+
+/**
+ * Adjusts quality knobs of the renderer and simulation to hold a target frame duration.
+ *
+ * Each knob has a range of integer quality levels, a priority, and the processors whose time it affects. CPU and GPU frame durations are smoothed, then compared to the target. While either is over budget, the knob with the lowest priority which affects that processor is lowered by one level. While both are under budget by more than the headroom for a raise period, the knob with the highest priority below its maximum level is raised by one level. Changes are spaced by a settling period, which exceeds the latency of GPU timer queries, and the raise period doubles whenever a raise is followed by a lowering, so that knobs don't oscillate around the target. The level of each knob is published as a gauge.
+ */
+class quality_governor
+{
+public:
+	/// Processors whose frame time a knob affects.
+	enum processor: unsigned int
+	{
+		cpu = 1,
+		gpu = 2
+	};
+	
+	/// Quality knob.
+	struct knob
+	{
+		/// Name of the knob, which is also the name of its gauge.
+		const char* name;
+		
+		/// Knobs with lower priorities are lowered first and raised last.
+		int priority;
+		
+		/// Bit mask of the processors whose frame time the knob affects.
+		unsigned int processors;
+		
+		/// Minimum quality level.
+		int min_level;
+		
+		/// Maximum quality level, at which the knob is initially set.
+		int max_level;
+		
+		/// Current quality level.
+		int level;
+		
+		/// Function which applies a quality level.
+		std::function<void(int)> apply;
+		
+		/// Gauge of the current quality level.
+		debug::gauge gauge;
+	};
+	
+	/// Number of measured frames to wait after a change before changing a knob again.
+	static constexpr std::size_t settle_frames = 16;
+	
+	/// Creates a quality governor.
+	quality_governor();
+	
+	/**
+	 * Adds a knob, which is assumed to be set at its maximum quality level.
+	 *
+	 * @param name Name of the knob, which is also the name of its gauge. Only the pointer is recorded, so the string must have static storage duration.
+	 * @param priority Knobs with lower priorities are lowered first and raised last.
+	 * @param processors Bit mask of the processors whose frame time the knob affects.
+	 * @param min_level Minimum quality level.
+	 * @param max_level Maximum quality level.
+	 * @param apply Function which applies a quality level.
+	 */
+	void add_knob(const char* name, int priority, unsigned int processors, int min_level, int max_level, const std::function<void(int)>& apply);
+	
+	/**
+	 * Sets the target frame duration of both the CPU and GPU.
+	 *
+	 * @param duration Target duration, in seconds.
+	 */
+	void set_target_frame_duration(double duration);
+	
+	/**
+	 * Sets the fraction of the target frame duration which must remain unused before a knob is raised.
+	 *
+	 * @param headroom Fraction of the target duration, on `[0, 1)`.
+	 */
+	void set_headroom(double headroom);
+	
+	/**
+	 * Sets the minimum number of consecutive measured frames with headroom before a knob is raised.
+	 *
+	 * @param frames Number of measured frames.
+	 */
+	void set_raise_period(std::size_t frames);
+	
+	/**
+	 * Adjusts the knobs given the measured durations of a frame. Must be called between frames, by the thread which applies the knobs.
+	 *
+	 * @param cpu_duration Measured CPU frame duration, in seconds.
+	 * @param gpu_duration Measured GPU frame duration, in seconds, or `0` if the GPU time isn't measured.
+	 */
+	void update(double cpu_duration, double gpu_duration);
+	
+	/// Returns the knobs, in order of priority.
+	const std::vector<knob>& get_knobs() const;
+
+private:
+	/// Sets the level of a knob and restarts the settling period.
+	void set_level(knob& k, int level);
+	
+	std::vector<knob> knobs;
+	double target_duration;
+	double headroom;
+	std::size_t base_raise_period;
+	std::size_t raise_period;
+	double smoothed_cpu_duration;
+	double smoothed_gpu_duration;
+	std::size_t frames_since_change;
+	std::size_t frames_with_headroom;
+	bool last_change_raised;
+};
+
+inline const std::vector<quality_governor::knob>& quality_governor::get_knobs() const
+{
+	return knobs;
+}
+
+} // namespace game
+
+#endif // ANTKEEPER_GAME_QUALITY_GOVERNOR_HPP
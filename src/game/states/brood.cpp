@@ -36,6 +36,14 @@ namespace game {
 namespace state {
 namespace brood {
 
+asset_manifest manifest(game::context* ctx)
+{
+	asset_manifest assets;
+	assets.add<entity::archetype>("ant-larva.ent");
+	assets.add<entity::archetype>("ant-cocoon.ent");
+	return assets;
+}
+
 void enter(game::context* ctx)
 {
 	// Switch to underground camera
@@ -87,6 +95,9 @@ void enter(game::context* ctx)
 	
 	// Start fade in
 	ctx->fade_transition->transition(1.0f, true, ease<float>::in_quad);
+	
+	// Release prefetched assets, which are now referenced by the state
+	release_prefetched_assets(ctx);
 }
 
 void exit(game::context* ctx)
@@ -21,6 +21,7 @@
 #define ANTKEEPER_GAME_STATE_BROOD_HPP
 
 #include "game/context.hpp"
+#include "game/asset-manifest.hpp"
 
 namespace game {
 namespace state {
@@ -28,6 +29,9 @@ namespace state {
 /// Brood game state functions.
 namespace brood {
 
+/// Returns the manifest of the assets which the state loads on entry.
+asset_manifest manifest(game::context* ctx);
+
 void enter(game::context* ctx);
 void exit(game::context* ctx);
 
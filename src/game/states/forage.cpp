@@ -30,11 +30,22 @@
 #include "animation/screen-transition.hpp"
 #include "animation/ease.hpp"
 #include "resources/resource-manager.hpp"
+#include "utility/fnv1a.hpp"
+#include <algorithm>
 
 namespace game {
 namespace state {
 namespace forage {
 
+asset_manifest manifest(game::context* ctx)
+{
+	asset_manifest assets;
+	assets.add<material>("desert-terrain.mtl");
+	assets.add<entity::archetype>("ant-larva.ent");
+	assets.add<entity::archetype>("ant-cocoon.ent");
+	return assets;
+}
+
 void enter(game::context* ctx)
 {
 	// Switch to surface camera
@@ -42,16 +53,21 @@ void enter(game::context* ctx)
 	ctx->surface_camera->set_active(true);
 	
 	// Find planet EID by name
-	auto planet_eid = entity::command::find(*ctx->entity_registry, "planet");
+	auto planet_eid = entity::command::find(*ctx->entity_registry, "planet"_sid);
 	
 	// Create biome terrain component
 	entity::component::terrain biome_terrain;
+	biome_terrain.seed = "desert-terrain"_fnv1a64;
 	biome_terrain.max_lod = 18;
 	biome_terrain.patch_material = ctx->resource_manager->load<material>("desert-terrain.mtl");
 	biome_terrain.elevation = [](double, double) -> double
 	{
 		return 0.0;
 	};
+	biome_terrain.batch_elevation = [](const double*, const double*, double* elevations, std::size_t count)
+	{
+		std::fill(elevations, elevations + count, 0.0);
+	};
 	
 	// Replace planet terrain component with biome terrain component
 	ctx->entity_registry->replace<entity::component::terrain>(planet_eid, biome_terrain);
@@ -112,6 +128,9 @@ void enter(game::context* ctx)
 	
 	// Start fade in
 	ctx->fade_transition->transition(1.0f, true, ease<float>::in_quad);
+	
+	// Release prefetched assets, which are now referenced by the state
+	release_prefetched_assets(ctx);
 }
 
 void exit(game::context* ctx)
@@ -21,6 +21,7 @@
 #include "application.hpp"
 #include "astro/illuminance.hpp"
 #include "color/color.hpp"
+#include "debug/startup-profiler.hpp"
 #include "entity/components/atmosphere.hpp"
 #include "entity/components/blackbody.hpp"
 #include "entity/components/celestial-body.hpp"
@@ -30,6 +31,9 @@
 #include "entity/systems/astronomy.hpp"
 #include "entity/systems/orbit.hpp"
 #include "entity/commands.hpp"
+#include "game/benchmark.hpp"
+#include "game/states/brood.hpp"
+#include "game/states/forage.hpp"
 #include "game/states/nuptial-flight.hpp"
 #include "game/states/splash.hpp"
 #include "geom/spherical.hpp"
@@ -44,8 +48,12 @@
 #include "renderer/passes/shadow-map-pass.hpp"
 #include "renderer/vertex-attributes.hpp"
 #include "resources/resource-manager.hpp"
+#include "resources/star-catalog.hpp"
+#include "utility/fnv1a.hpp"
 #include "scene/ambient-light.hpp"
 #include "scene/directional-light.hpp"
+#include <algorithm>
+#include <fstream>
 
 namespace game {
 namespace state {
@@ -69,8 +77,36 @@ static void extrasolar_heliogenesis(game::context* ctx);
 /// Creates an ant colony
 static void colonigenesis(game::context* ctx);
 
+/**
+ * Creates the benchmark requested on the command line and returns the game state it benchmarks.
+ *
+ * @return Benchmarked game state, or a state without an enter function if the scenario is unknown.
+ */
+static application::state setup_benchmark(game::context* ctx);
+
+/// Returns the name of the star catalog resource, preferring the cooked binary star catalog over the CSV star catalog.
+static std::string get_star_catalog_name(game::context* ctx);
+
+/// Returns the manifest of the game state which will follow the loading state, or of the splash state's successor if the splash screen follows it.
+static asset_manifest get_next_state_manifest(game::context* ctx);
+
+asset_manifest manifest(game::context* ctx)
+{
+	// The star catalog is requested asynchronously by cosmogenesis(), and released once the stars have been built
+	asset_manifest assets;
+	assets.add<model>("sky-dome.mdl");
+	assets.add<model>("moon.mdl");
+	assets.add<material>("fixed-star.mtl");
+	return assets;
+}
+
 void enter(game::context* ctx)
 {
+	// Prefetch the assets of this state and of the next state on worker threads while the universe is created
+	asset_manifest assets = manifest(ctx);
+	assets.add(get_next_state_manifest(ctx));
+	prefetch_assets(ctx, assets);
+	
 	// Create universe
 	ctx->logger->push_task("Creating the universe");
 	try
@@ -86,7 +122,11 @@ void enter(game::context* ctx)
 	
 	// Determine next game state
 	application::state next_state;
-	if (ctx->option_quick_start.has_value())
+	if (ctx->option_benchmark.has_value())
+	{
+		next_state = setup_benchmark(ctx);
+	}
+	else if (ctx->option_quick_start.has_value())
 	{
 		next_state.name = "nuptial flight";
 		next_state.enter = std::bind(game::state::nuptial_flight::enter, ctx);
@@ -104,10 +144,98 @@ void enter(game::context* ctx)
 }
 
 void exit(game::context* ctx)
-{}
+{
+	// Record the dependencies of the resources loaded during boot, to be prefetched by the next launch
+	if (!ctx->resource_manager->write_dependency_manifest(ctx->resource_manifest_path))
+		ctx->logger->warning("Failed to write resource dependency manifest \"" + ctx->resource_manifest_path + "\"");
+	
+	// Stop timing startup and report it
+	debug::startup_profiler::end();
+	ctx->logger->log(debug::startup_profiler::get_report());
+	if (ctx->option_startup_report.has_value())
+	{
+		std::ofstream stream(ctx->option_startup_report.value());
+		if (stream)
+			debug::startup_profiler::write_json(stream);
+		else
+			ctx->logger->warning("Failed to write startup report \"" + ctx->option_startup_report.value() + "\"");
+	}
+}
+
+asset_manifest get_next_state_manifest(game::context* ctx)
+{
+	// Mirror the choice of the next state made by enter()
+	if (ctx->option_benchmark.has_value())
+	{
+		const std::string& scenario = ctx->option_benchmark.value();
+		if (scenario == "nuptial-flight")
+			return game::state::nuptial_flight::manifest(ctx);
+		if (scenario == "forage")
+			return game::state::forage::manifest(ctx);
+		if (scenario == "brood")
+			return game::state::brood::manifest(ctx);
+		return asset_manifest();
+	}
+	
+	if (ctx->option_quick_start.has_value())
+		return game::state::nuptial_flight::manifest(ctx);
+	
+	// The splash screen prefetches the assets of its own successor while it's shown
+	return game::state::splash::manifest(ctx);
+}
+
+application::state setup_benchmark(game::context* ctx)
+{
+	const std::string& scenario = ctx->option_benchmark.value();
+	
+	application::state state;
+	state.name = scenario;
+	if (scenario == "nuptial-flight")
+	{
+		state.enter = std::bind(game::state::nuptial_flight::enter, ctx);
+		state.exit = std::bind(game::state::nuptial_flight::exit, ctx);
+	}
+	else if (scenario == "forage")
+	{
+		state.enter = std::bind(game::state::forage::enter, ctx);
+		state.exit = std::bind(game::state::forage::exit, ctx);
+	}
+	else if (scenario == "brood")
+	{
+		state.enter = std::bind(game::state::brood::enter, ctx);
+		state.exit = std::bind(game::state::brood::exit, ctx);
+	}
+	else
+	{
+		ctx->logger->error("Unknown benchmark scenario \"" + scenario + "\"");
+		ctx->app->close(EXIT_FAILURE);
+		return state;
+	}
+	
+	const int frame_count = std::max(1, ctx->option_benchmark_frames.value_or(1000));
+	const std::string report_path = ctx->option_benchmark_report.value_or("benchmark-" + scenario + ".json");
+	ctx->benchmark = new game::benchmark(ctx, scenario, static_cast<std::size_t>(frame_count), report_path);
+	
+	// Load camera path
+	if (ctx->option_benchmark_path.has_value())
+	{
+		const string_table* camera_path = ctx->resource_manager->load<string_table>(ctx->option_benchmark_path.value());
+		if (camera_path)
+			ctx->benchmark->set_camera_path(game::benchmark::read_camera_path(*camera_path));
+		else
+			ctx->logger->warning("Failed to load benchmark camera path \"" + ctx->option_benchmark_path.value() + "\"");
+	}
+	
+	return state;
+}
 
 void cosmogenesis(game::context* ctx)
 {
+	debug::startup_phase phase("cosmogenesis");
+	
+	// Parse the star catalog on a worker thread while the solar system is created
+	ctx->resource_manager->load_async<star_catalog>(get_star_catalog_name(ctx));
+	
 	// Init time
 	const double time = 0.0;
 	ctx->astronomy_system->set_universal_time(time);
@@ -181,6 +309,8 @@ void cosmogenesis(game::context* ctx)
 
 void heliogenesis(game::context* ctx)
 {
+	debug::startup_phase phase("heliogenesis");
+	
 	// Create solar entity
 	auto sun_eid = entity::command::create(*ctx->entity_registry, "sun");
 	
@@ -200,6 +330,7 @@ void heliogenesis(game::context* ctx)
 	orbit.elements.raan = math::radians(0.0);
 	orbit.elements.w = math::radians(0.0);
 	orbit.elements.ta = math::radians(0.0);
+	orbit.mean_motion = 0.0;
 	ctx->entity_registry->assign<entity::component::orbit>(sun_eid, orbit);
 	
 	// Assign solar blackbody component
@@ -233,6 +364,8 @@ void heliogenesis(game::context* ctx)
 
 void planetogenesis(game::context* ctx)
 {
+	debug::startup_phase phase("planetogenesis");
+	
 	// Create planetary entity
 	auto planet_eid = entity::command::create(*ctx->entity_registry, "planet");
 	
@@ -253,6 +386,7 @@ void planetogenesis(game::context* ctx)
 	const double longitude_periapsis = math::radians(102.93768193);
 	orbit.elements.w = longitude_periapsis - orbit.elements.raan;
 	orbit.elements.ta = math::radians(100.46457166) - longitude_periapsis;
+	orbit.mean_motion = math::radians(360.0 / 365.256363004);
 	ctx->entity_registry->assign<entity::component::orbit>(planet_eid, orbit);
 	
 	// Assign planetary terrain component
@@ -262,6 +396,11 @@ void planetogenesis(game::context* ctx)
 		//return math::random<double>(0.0, 1.0);
 		return 0.0;
 	};
+	terrain.batch_elevation = [](const double*, const double*, double* elevations, std::size_t count)
+	{
+		std::fill(elevations, elevations + count, 0.0);
+	};
+	terrain.seed = "planet"_fnv1a64;
 	terrain.max_lod = 0;
 	terrain.patch_material = nullptr;
 	ctx->entity_registry->assign<entity::component::terrain>(planet_eid, terrain);
@@ -292,6 +431,8 @@ void planetogenesis(game::context* ctx)
 
 void selenogenesis(game::context* ctx)
 {
+	debug::startup_phase phase("selenogenesis");
+	
 	// Create lunar entity
 	auto moon_eid = entity::command::create(*ctx->entity_registry, "moon");
 	
@@ -301,91 +442,32 @@ void selenogenesis(game::context* ctx)
 
 void extrasolar_heliogenesis(game::context* ctx)
 {
+	debug::startup_phase phase("extrasolar_heliogenesis");
+	
 	// Load star catalog
-	string_table* star_catalog = ctx->resource_manager->load<string_table>("stars.csv");
+	const std::string star_catalog_name = get_star_catalog_name(ctx);
+	const star_catalog* catalog = ctx->resource_manager->load<star_catalog>(star_catalog_name);
 	
-	// Allocate star catalog vertex data
 	std::size_t star_count = 0;
-	if (star_catalog->size() > 0)
-		star_count = star_catalog->size() - 1;
-	std::size_t star_vertex_size = 6;
-	std::size_t star_vertex_stride = star_vertex_size * sizeof(float);
-	float* star_vertex_data = new float[star_count * star_vertex_size];
-	float* star_vertex = star_vertex_data;
-	
-	// Build star catalog vertex data
-	for (std::size_t i = 1; i < star_catalog->size(); ++i)
-	{
-		const string_table_row& catalog_row = (*star_catalog)[i];
-		
-		double ra = 0.0;
-		double dec = 0.0;
-		double vmag = 0.0;
-		double bv_color = 0.0;
-		
-		// Parse star catalog entry
-		try
-		{
-			ra = std::stod(catalog_row[1]);
-			dec = std::stod(catalog_row[2]);
-			vmag = std::stod(catalog_row[3]);
-			bv_color = std::stod(catalog_row[4]);
-		}
-		catch (const std::exception& e)
-		{
-			continue;
-		}
-		
-		// Convert right ascension and declination from degrees to radians
-		ra = math::wrap_radians(math::radians(ra));
-		dec = math::wrap_radians(math::radians(dec));
-		
-		// Transform spherical equatorial coordinates to rectangular equatorial coordinates
-		double3 position_bci = geom::spherical::to_cartesian(double3{1.0, dec, ra});
-		
-		// Transform coordinates from equatorial space to inertial space
-		physics::frame<double> bci_to_inertial = physics::orbit::inertial::to_bci({0, 0, 0}, 0.0, math::radians(23.4393)).inverse();
-		double3 position_inertial = bci_to_inertial * position_bci;
-		
-		// Convert color index to color temperature
-		double cct = color::index::bv_to_cct(bv_color);
-		
-		// Calculate XYZ color from color temperature
-		double3 color_xyz = color::cct::to_xyz(cct);
-		
-		// Transform XYZ color to ACEScg colorspace
-		double3 color_acescg = color::xyz::to_acescg(color_xyz);
-		
-		// Convert apparent magnitude to irradiance (W/m^2)
-		double vmag_irradiance = std::pow(10.0, 0.4 * (-vmag - 19.0 + 0.4));
-		
-		// Convert irradiance to illuminance
-		double vmag_illuminance = vmag_irradiance * (683.0 * 0.14);
-		
-		// Scale color by illuminance
-		double3 scaled_color = color_acescg * vmag_illuminance;
-		
-		// Build vertex
-		*(star_vertex++) = static_cast<float>(position_inertial.x);
-		*(star_vertex++) = static_cast<float>(position_inertial.y);
-		*(star_vertex++) = static_cast<float>(position_inertial.z);
-		*(star_vertex++) = static_cast<float>(scaled_color.x);
-		*(star_vertex++) = static_cast<float>(scaled_color.y);
-		*(star_vertex++) = static_cast<float>(scaled_color.z);
-	}
-	
-	// Unload star catalog
-	ctx->resource_manager->unload("stars.csv");
+	std::size_t star_vertex_stride = star_catalog::vertex_size * sizeof(float);
 	
 	// Allocate stars model
 	model* stars_model = new model();
 	
 	// Resize model VBO and upload vertex data
 	gl::vertex_buffer* vbo = stars_model->get_vertex_buffer();
-	vbo->resize(star_count * star_vertex_stride, star_vertex_data);
+	if (catalog)
+	{
+		star_count = catalog->size();
+		vbo->resize(star_count * star_vertex_stride, catalog->vertex_data.data());
+	}
 	
-	// Free star catalog vertex data
-	delete[] star_vertex_data;
+	// Keep the tiles of the stars, which are in the vertex order of the catalog
+	std::shared_ptr<const star_tiling> tiling = (catalog) ? std::make_shared<const star_tiling>(catalog->tiling) : nullptr;
+	
+	// Unload star catalog, releasing the references of both its asynchronous request and its synchronous load
+	ctx->resource_manager->unload(star_catalog_name);
+	ctx->resource_manager->unload(star_catalog_name);
 	
 	// Bind vertex attributes to model VAO
 	gl::vertex_array* vao = stars_model->get_vertex_array();
@@ -406,10 +488,18 @@ void extrasolar_heliogenesis(game::context* ctx)
 	
 	// Pass stars model to sky pass
 	ctx->surface_sky_pass->set_stars_model(stars_model);
+	ctx->surface_sky_pass->set_star_tiling(tiling);
+}
+
+std::string get_star_catalog_name(game::context* ctx)
+{
+	return (ctx->resource_manager->exists("stars.bin")) ? "stars.bin" : "stars.csv";
 }
 
 void colonigenesis(game::context* ctx)
 {
+	debug::startup_phase phase("colonigenesis");
+	
 	// Create queen entity
 	auto queen_eid = entity::command::create(*ctx->entity_registry, "queen");
 	
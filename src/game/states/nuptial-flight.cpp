@@ -29,6 +29,7 @@
 #include "entity/components/terrain.hpp"
 #include "entity/commands.hpp"
 #include "renderer/material-property.hpp"
+#include "renderer/model.hpp"
 #include "animation/screen-transition.hpp"
 #include "animation/ease.hpp"
 #include "resources/config-file.hpp"
@@ -38,6 +39,16 @@ namespace game {
 namespace state {
 namespace nuptial_flight {
 
+asset_manifest manifest(game::context* ctx)
+{
+	asset_manifest assets;
+	assets.add<model>("cloud-plane.mdl");
+	assets.add<entity::archetype>("ant-forewing.ent");
+	assets.add<entity::archetype>("ant-round-eye.ent");
+	assets.add<entity::archetype>("orb-ring.ent");
+	return assets;
+}
+
 void enter(game::context* ctx)
 {
 	// Switch to surface camera
@@ -45,7 +56,7 @@ void enter(game::context* ctx)
 	ctx->surface_camera->set_active(true);
 	
 	// Find planet EID by name
-	auto planet_eid = entity::command::find(*ctx->entity_registry, "planet");
+	auto planet_eid = entity::command::find(*ctx->entity_registry, "planet"_sid);
 	
 	// Remove terrain component from planet (if any)
 	if (ctx->entity_registry->has<entity::component::terrain>(planet_eid))
@@ -114,6 +125,9 @@ void enter(game::context* ctx)
 	// Start fade in from white
 	ctx->fade_transition_color->set_value({1, 1, 1});
 	ctx->fade_transition->transition(2.0f, true, ease<float>::in_quad);
+	
+	// Release prefetched assets, which are now referenced by the state
+	release_prefetched_assets(ctx);
 }
 
 void exit(game::context* ctx)
@@ -28,8 +28,18 @@ namespace game {
 namespace state {
 namespace splash {
 
+asset_manifest manifest(game::context* ctx)
+{
+	// The splash billboard is created by the bootloader
+	return asset_manifest();
+}
+
 void enter(game::context* ctx)
 {
+	// Release the assets prefetched by the loading state, then prefetch the assets of the state which follows the splash screen while it's shown
+	release_prefetched_assets(ctx);
+	prefetch_assets(ctx, game::state::brood::manifest(ctx));
+	
 	// Add splash billboard to UI scene
 	ctx->ui_scene->add_object(ctx->splash_billboard);
 	
@@ -41,9 +51,16 @@ void enter(game::context* ctx)
 	// Start fade in
 	ctx->fade_transition->transition(splash_fade_in_duration, true, ease<float>::in_quad);
 	
+	// Idle while the splash screen hangs, as nothing on screen changes
+	auto hang = [ctx]()
+	{
+		ctx->app->set_idle(true);
+	};
+	
 	// Crate fade out function
 	auto fade_out = [ctx, splash_fade_out_duration]()
 	{
+		ctx->app->set_idle(false);
 		ctx->fade_transition->transition(splash_fade_out_duration, false, ease<float>::out_quad);
 	};
 	
@@ -63,6 +80,7 @@ void enter(game::context* ctx)
 	float t = timeline->get_position();
 	timeline::sequence splash_sequence =
 	{
+		{t + splash_fade_in_duration, hang},
 		{t + splash_fade_in_duration + splash_hang_duration, fade_out},
 		{t + splash_fade_in_duration + splash_hang_duration + splash_fade_out_duration, change_state}
 	};
@@ -96,6 +114,9 @@ void enter(game::context* ctx)
 
 void exit(game::context* ctx)
 {
+	// Leave idle mode, in case the splash screen was skipped while hanging
+	ctx->app->set_idle(false);
+	
 	// Disable splash skipper
 	ctx->input_listener->set_enabled(false);
 	ctx->input_listener->set_callback(nullptr);
@@ -0,0 +1,141 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "chromosome.hpp"
+#include <algorithm>
+#include <mutex>
+#include <unordered_map>
+
+namespace genetics {
+
+/// Process-wide pool of interned sequences, keyed by hash.
+struct intern_pool
+{
+	std::mutex mutex;
+	std::unordered_multimap<std::size_t, std::weak_ptr<void>> buffers;
+	
+	/// Number of entries at which expired entries are next swept.
+	std::size_t sweep_size = 1024;
+	
+	/// Erases the entries of buffers which have been released. Must be called with the mutex locked.
+	void sweep()
+	{
+		for (auto it = buffers.begin(); it != buffers.end();)
+			it = (it->second.expired()) ? buffers.erase(it) : std::next(it);
+		sweep_size = std::max<std::size_t>(1024, buffers.size() * 2);
+	}
+};
+
+static intern_pool& get_pool()
+{
+	static intern_pool pool;
+	return pool;
+}
+
+chromosome::chromosome()
+{}
+
+chromosome::chromosome(packed_sequence sequence):
+	data(intern(std::move(sequence)))
+{}
+
+const packed_sequence& chromosome::get() const
+{
+	static const packed_sequence empty;
+	return (data) ? data->sequence : empty;
+}
+
+packed_sequence& chromosome::edit()
+{
+	if (!data)
+		data = std::make_shared<buffer>(buffer{packed_sequence(), 0, false});
+	else if (data->interned || data.use_count() > 1)
+		data = std::make_shared<buffer>(buffer{data->sequence, 0, false});
+	
+	return data->sequence;
+}
+
+void chromosome::intern()
+{
+	if (!data || data->interned)
+		return;
+	
+	// Take the sequence of a buffer no other chromosome refers to, rather than copying it
+	data = intern((data.use_count() == 1) ? std::move(data->sequence) : packed_sequence(data->sequence));
+}
+
+std::size_t chromosome::hash() const
+{
+	return (data && data->interned) ? data->hash : get().hash();
+}
+
+bool chromosome::operator==(const chromosome& other) const
+{
+	if (data == other.data)
+		return true;
+	
+	// Distinct interned buffers hold distinct sequences
+	if (is_interned() && other.is_interned())
+		return false;
+	
+	return get() == other.get();
+}
+
+std::size_t chromosome::get_interned_count()
+{
+	intern_pool& pool = get_pool();
+	std::lock_guard<std::mutex> lock(pool.mutex);
+	pool.sweep();
+	return pool.buffers.size();
+}
+
+std::shared_ptr<chromosome::buffer> chromosome::intern(packed_sequence&& sequence)
+{
+	const std::size_t hash = sequence.hash();
+	
+	intern_pool& pool = get_pool();
+	std::lock_guard<std::mutex> lock(pool.mutex);
+	
+	// Share the buffer of an equal sequence, erasing released buffers of the same hash
+	auto [first, last] = pool.buffers.equal_range(hash);
+	while (first != last)
+	{
+		std::shared_ptr<buffer> existing = std::static_pointer_cast<buffer>(first->second.lock());
+		if (!existing)
+		{
+			first = pool.buffers.erase(first);
+			continue;
+		}
+		
+		if (existing->sequence == sequence)
+			return existing;
+		++first;
+	}
+	
+	// Amortize the sweeping of buffers released without a lookup of their hashes
+	if (pool.buffers.size() >= pool.sweep_size)
+		pool.sweep();
+	
+	auto interned = std::make_shared<buffer>(buffer{std::move(sequence), hash, true});
+	pool.buffers.emplace(hash, std::static_pointer_cast<void>(interned));
+	
+	return interned;
+}
+
+} // namespace genetics
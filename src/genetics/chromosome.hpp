@@ -0,0 +1,133 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ANTKEEPER_GENETICS_CHROMOSOME_HPP
+#define ANTKEEPER_GENETICS_CHROMOSOME_HPP
+
+#include "packed-sequence.hpp"
+#include <cstddef>
+#include <functional>
+#include <memory>
+
+namespace genetics {
+
+/**
+ * Reference-counted, copy-on-write handle to the packed sequence of a chromosome.
+ *
+ * Copying a chromosome copies a reference to its sequence. Sequences are interned in a process-wide pool keyed by their hashes, so that all interned chromosomes with equal sequences share a single buffer, and the memory of a population is proportional to its number of distinct alleles. Interned sequences are immutable: edit() gives a chromosome a private copy of its sequence, which should be interned again once modified. Interned chromosomes carry the hashes of their sequences, and are compared by reference before they are compared by value.
+ *
+ * Interning may be called from any thread. A chromosome must not be edited while another thread copies it.
+ */
+class chromosome
+{
+public:
+	/// Creates a chromosome with an empty sequence.
+	chromosome();
+	
+	/**
+	 * Creates an interned chromosome.
+	 *
+	 * @param sequence Packed sequence of the chromosome.
+	 */
+	explicit chromosome(packed_sequence sequence);
+	
+	/// Returns the sequence of the chromosome.
+	const packed_sequence& get() const;
+	
+	/// @copydoc chromosome::get()
+	const packed_sequence& operator*() const;
+	
+	/// @copydoc chromosome::get()
+	const packed_sequence* operator->() const;
+	
+	/// Returns the sequence of the chromosome for modification, first copying it unless the chromosome already holds the only reference to a sequence which isn't interned.
+	packed_sequence& edit();
+	
+	/// Interns the sequence of the chromosome, sharing the buffer of an equal interned sequence if there is one.
+	void intern();
+	
+	/// Returns `true` if the sequence of the chromosome is interned.
+	bool is_interned() const;
+	
+	/// Returns the hash of the sequence, which is cached if the sequence is interned.
+	std::size_t hash() const;
+	
+	/// Returns `true` if two chromosomes share a buffer or have equal sequences.
+	bool operator==(const chromosome& other) const;
+	bool operator!=(const chromosome& other) const;
+	
+	/// Returns the number of distinct interned sequences which are referred to by chromosomes.
+	static std::size_t get_interned_count();
+	
+private:
+	struct buffer;
+	
+	/// Interns a sequence, returning the shared buffer of an equal sequence if there is one.
+	static std::shared_ptr<buffer> intern(packed_sequence&& sequence);
+	
+	std::shared_ptr<buffer> data;
+};
+
+/// Shared buffer of a chromosome.
+struct chromosome::buffer
+{
+	packed_sequence sequence;
+	
+	/// Hash of the sequence, if it's interned.
+	std::size_t hash;
+	
+	/// `true` if the sequence is interned, and therefore immutable.
+	bool interned;
+};
+
+inline const packed_sequence& chromosome::operator*() const
+{
+	return get();
+}
+
+inline const packed_sequence* chromosome::operator->() const
+{
+	return &get();
+}
+
+inline bool chromosome::is_interned() const
+{
+	return data && data->interned;
+}
+
+inline bool chromosome::operator!=(const chromosome& other) const
+{
+	return !(*this == other);
+}
+
+} // namespace genetics
+
+namespace std
+{
+	template <>
+	struct hash<genetics::chromosome>
+	{
+		std::size_t operator()(const genetics::chromosome& c) const
+		{
+			return c.hash();
+		}
+	};
+}
+
+#endif // ANTKEEPER_GENETICS_CHROMOSOME_HPP
@@ -62,7 +62,7 @@ static inline int codon_index(char base1, char base2, char base3)
 	return (i << 4) | (j << 2) | k;
 }
 
-inline char translate(char base1, char base2, char base3, const char* aas)
+char translate(char base1, char base2, char base3, const char* aas)
 {
 	int index = codon_index(base1, base2, base3);
 	if (index < 0)
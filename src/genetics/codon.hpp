@@ -20,23 +20,99 @@
 #ifndef ANTKEEPER_GENETICS_CODON_HPP
 #define ANTKEEPER_GENETICS_CODON_HPP
 
+#include <cstdint>
+
 namespace genetics {
 
 /// Functions and structures related to triplets of IUPAC base symbols.
 namespace codon {
 
+/**
+ * Returns the two-bit code of a nucleobase, in ACGT order, matching the codes of genetics::packed_sequence.
+ *
+ * @param base IUPAC code of nucleobase, either `U`, `T`, `C`, `A`, or `G`.
+ * @return Code of the nucleobase, or `-1` if a non-standard nucleobase was supplied.
+ */
+constexpr int base_code(char base)
+{
+	switch (base)
+	{
+		case 'A':
+			return 0;
+		case 'C':
+			return 1;
+		case 'G':
+			return 2;
+		case 'T':
+		case 'U':
+			return 3;
+		default:
+			return -1;
+	}
+}
+
+/**
+ * Returns the index of a codon in the lookup tables of a codon::table. The code of the first base occupies the lowest two bits, so that the index of a codon in a packed sequence is the six bits at its position.
+ *
+ * @param base1 IUPAC code of first nucleobase, either `U`, `T`, `C`, `A`, or `G`.
+ * @param base2 IUPAC code of second nucleobase, either `U`, `T`, `C`, `A`, or `G`.
+ * @param base3 IUPAC code of third nucleobase, either `U`, `T`, `C`, `A`, or `G`.
+ * @return Index of the codon, or `-1` if a non-standard nucleobase was supplied.
+ */
+constexpr int index(char base1, char base2, char base3)
+{
+	const int i = base_code(base1);
+	const int j = base_code(base2);
+	const int k = base_code(base3);
+	return (i < 0 || j < 0 || k < 0) ? -1 : i | (j << 2) | (k << 4);
+}
+
 /**
  * Table for translating codons to amino acids.
  *
+ * The amino acid strings are decoded at construction, which happens at compile time for constexpr tables such as genetics::standard_code, into lookup tables and start and stop codon bit masks indexed by codon::index().
+ *
  * @see https://www.ncbi.nlm.nih.gov/Taxonomy/Utils/wprintgc.cgi
  */
 struct table
 {
+	/**
+	 * Creates a codon table.
+	 *
+	 * @param aas String of 64 IUPAC amino acid base symbols, in TCAG order.
+	 * @param starts String of 64 IUPAC amino acid base symbols, in TCAG order, where symbols other than `-` and `*` indicate a start codon and its amino acid.
+	 */
+	constexpr table(const char* aas, const char* starts);
+	
+	/// Translates a codon into an amino acid, or `-` if the codon contains non-standard nucleobases.
+	constexpr char translate(char base1, char base2, char base3) const;
+	
+	/// Translates a codon into an amino acid using the start codon string, as the first codon of an open reading frame is translated.
+	constexpr char translate_start(char base1, char base2, char base3) const;
+	
+	/// Returns `true` if a codon is a start codon.
+	constexpr bool is_start(char base1, char base2, char base3) const;
+	
+	/// Returns `true` if a codon is a stop codon.
+	constexpr bool is_stop(char base1, char base2, char base3) const;
+	
 	/// String of 64 IUPAC amino acid base symbols, in TCAG order.
 	const char* aas;
 	
 	/// String of 64 IUPAC amino acid base symbols, in TCAG order, where symbols other than `-` and `*` indicate a start codon and its amino acid.
 	const char* starts;
+	
+	/// Amino acids of codons, indexed by codon::index().
+	char aa_lut[64];
+	
+	/// Symbols of the start codon string, indexed by codon::index().
+	char start_lut[64];
+	
+	/// Bit mask of start codons, indexed by codon::index().
+	std::uint64_t start_mask;
+	
+	/// Bit mask of stop codons, indexed by codon::index().
+	std::uint64_t stop_mask;
 };
 
 /**
@@ -72,6 +148,54 @@ bool is_stop(char base1, char base2, char base3, const char* aas);
  */
 char translate(char base1, char base2, char base3, const char* aas);
 
+constexpr table::table(const char* aas, const char* starts):
+	aas(aas),
+	starts(starts),
+	aa_lut{},
+	start_lut{},
+	start_mask(0),
+	stop_mask(0)
+{
+	// Position of each base code, in ACGT order, in TCAG order
+	constexpr int tcag[4] = {2, 1, 3, 0};
+	
+	for (int i = 0; i < 64; ++i)
+	{
+		const int j = (tcag[i & 3] << 4) | (tcag[(i >> 2) & 3] << 2) | tcag[i >> 4];
+		
+		aa_lut[i] = aas[j];
+		start_lut[i] = starts[j];
+		if (starts[j] != '-' && starts[j] != '*')
+			start_mask |= std::uint64_t(1) << i;
+		if (aas[j] == '*')
+			stop_mask |= std::uint64_t(1) << i;
+	}
+}
+
+constexpr char table::translate(char base1, char base2, char base3) const
+{
+	const int i = index(base1, base2, base3);
+	return (i < 0) ? '-' : aa_lut[i];
+}
+
+constexpr char table::translate_start(char base1, char base2, char base3) const
+{
+	const int i = index(base1, base2, base3);
+	return (i < 0) ? '-' : start_lut[i];
+}
+
+constexpr bool table::is_start(char base1, char base2, char base3) const
+{
+	const int i = index(base1, base2, base3);
+	return (i >= 0) && ((start_mask >> i) & 1);
+}
+
+constexpr bool table::is_stop(char base1, char base2, char base3) const
+{
+	const int i = index(base1, base2, base3);
+	return (i >= 0) && ((stop_mask >> i) & 1);
+}
+
 } // namspace codon
 } // namespace genetics
 
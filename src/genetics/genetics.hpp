@@ -25,8 +25,11 @@ namespace genetics {}
 
 #include "amino-acid.hpp"
 #include "base.hpp"
+#include "chromosome.hpp"
 #include "codon.hpp"
 #include "matrix.hpp"
+#include "packed-sequence.hpp"
+#include "population.hpp"
 #include "protein.hpp"
 #include "sequence.hpp"
 #include "standard-code.hpp"
@@ -0,0 +1,477 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "packed-sequence.hpp"
+#include "base.hpp"
+#include <algorithm>
+
+namespace genetics {
+
+/// Symbols of the two-bit codes of each alphabet.
+static constexpr char code_symbols[2][4] =
+{
+	{'A', 'C', 'G', 'T'},
+	{'A', 'C', 'G', 'U'}
+};
+
+/// Returns the first side-table entry at or after position @p i.
+static inline std::vector<packed_sequence::ambiguity>::const_iterator find_ambiguity(const std::vector<packed_sequence::ambiguity>& ambiguities, std::size_t i)
+{
+	return std::lower_bound
+	(
+		ambiguities.begin(),
+		ambiguities.end(),
+		i,
+		[](const packed_sequence::ambiguity& entry, std::size_t i)
+		{
+			return entry.first < i;
+		}
+	);
+}
+
+packed_sequence::packed_sequence(alphabet alphabet):
+	length(0),
+	symbol_alphabet(alphabet)
+{}
+
+packed_sequence::packed_sequence(const std::string& symbols, alphabet alphabet):
+	packed_sequence(symbols.begin(), symbols.end(), alphabet)
+{}
+
+char packed_sequence::get(std::size_t i) const
+{
+	if (!ambiguities.empty())
+	{
+		auto it = find_ambiguity(ambiguities, i);
+		if (it != ambiguities.end() && it->first == i)
+			return it->second;
+	}
+	
+	const word_type code = (words[i / bases_per_word] >> ((i % bases_per_word) * 2)) & 3;
+	return code_symbols[static_cast<std::size_t>(symbol_alphabet)][code];
+}
+
+void packed_sequence::set(std::size_t i, char symbol)
+{
+	const int code = encode(symbol);
+	auto it = ambiguities.begin() + (find_ambiguity(ambiguities, i) - ambiguities.cbegin());
+	const bool found = (it != ambiguities.end() && it->first == i);
+	
+	if (code >= 0)
+	{
+		if (found)
+			ambiguities.erase(it);
+		set_code(i, static_cast<word_type>(code));
+	}
+	else
+	{
+		// Store degenerate symbols in the side-table, with a placeholder code of zero
+		if (found)
+			it->second = symbol;
+		else
+			ambiguities.insert(it, {i, symbol});
+		set_code(i, 0);
+	}
+}
+
+void packed_sequence::push_back(char symbol)
+{
+	if (length % bases_per_word == 0)
+		words.push_back(0);
+	++length;
+	set(length - 1, symbol);
+}
+
+void packed_sequence::resize(std::size_t size)
+{
+	words.resize((size + bases_per_word - 1) / bases_per_word, 0);
+	length = size;
+	trim();
+	
+	ambiguities.erase(ambiguities.begin() + (find_ambiguity(ambiguities, size) - ambiguities.cbegin()), ambiguities.end());
+}
+
+void packed_sequence::clear()
+{
+	words.clear();
+	length = 0;
+	ambiguities.clear();
+}
+
+void packed_sequence::swap_range(packed_sequence& other, std::size_t first, std::size_t last)
+{
+	if (first >= last)
+		return;
+	
+	// Exchange the bits of the range, masking partial words at either end
+	const std::size_t first_word = first / bases_per_word;
+	const std::size_t last_word = (last - 1) / bases_per_word;
+	for (std::size_t w = first_word; w <= last_word; ++w)
+	{
+		word_type mask = ~word_type(0);
+		if (w == first_word)
+			mask &= ~word_type(0) << ((first % bases_per_word) * 2);
+		if (w == last_word && last % bases_per_word)
+			mask &= ~(~word_type(0) << ((last % bases_per_word) * 2));
+		
+		const word_type difference = (words[w] ^ other.words[w]) & mask;
+		words[w] ^= difference;
+		other.words[w] ^= difference;
+	}
+	
+	// Exchange the side-table entries of the range
+	if (ambiguities.empty() && other.ambiguities.empty())
+		return;
+	
+	auto exchange = [first, last](const std::vector<ambiguity>& a, const std::vector<ambiguity>& b)
+	{
+		std::vector<ambiguity> result(a.begin(), find_ambiguity(a, first));
+		result.insert(result.end(), find_ambiguity(b, first), find_ambiguity(b, last));
+		result.insert(result.end(), find_ambiguity(a, last), a.end());
+		return result;
+	};
+	
+	std::vector<ambiguity> a = exchange(ambiguities, other.ambiguities);
+	other.ambiguities = exchange(other.ambiguities, ambiguities);
+	ambiguities = std::move(a);
+}
+
+void packed_sequence::complement()
+{
+	// Inverting a code yields the code of its complement
+	for (word_type& word: words)
+		word = ~word;
+	trim();
+	
+	// Complement degenerate symbols, and restore their placeholder codes
+	for (ambiguity& entry: ambiguities)
+	{
+		entry.second = base::dna::complement(entry.second);
+		set_code(entry.first, 0);
+	}
+}
+
+std::string packed_sequence::to_string() const
+{
+	std::string symbols(length, 'A');
+	for (std::size_t i = 0; i < length; ++i)
+	{
+		const word_type code = (words[i / bases_per_word] >> ((i % bases_per_word) * 2)) & 3;
+		symbols[i] = code_symbols[static_cast<std::size_t>(symbol_alphabet)][code];
+	}
+	for (const ambiguity& entry: ambiguities)
+		symbols[entry.first] = entry.second;
+	
+	return symbols;
+}
+
+bool packed_sequence::operator==(const packed_sequence& other) const
+{
+	return length == other.length &&
+		symbol_alphabet == other.symbol_alphabet &&
+		words == other.words &&
+		ambiguities == other.ambiguities;
+}
+
+std::size_t packed_sequence::hash() const
+{
+	// Mix each word into the hash with the 64-bit finalizer of MurmurHash3
+	auto mix = [](std::uint64_t h, std::uint64_t x)
+	{
+		h ^= x + 0x9e3779b97f4a7c15 + (h << 6) + (h >> 2);
+		h ^= h >> 33;
+		h *= 0xff51afd7ed558ccd;
+		h ^= h >> 33;
+		return h;
+	};
+	
+	std::uint64_t h = mix(length, static_cast<std::uint64_t>(symbol_alphabet));
+	for (word_type word: words)
+		h = mix(h, word);
+	for (const ambiguity& entry: ambiguities)
+		h = mix(h, (static_cast<std::uint64_t>(entry.first) << 8) | static_cast<unsigned char>(entry.second));
+	
+	return static_cast<std::size_t>(h);
+}
+
+int packed_sequence::encode(char symbol)
+{
+	switch (symbol)
+	{
+		case 'A':
+			return 0;
+		case 'C':
+			return 1;
+		case 'G':
+			return 2;
+		case 'T':
+		case 'U':
+			return 3;
+		default:
+			return -1;
+	}
+}
+
+void packed_sequence::set_code(std::size_t i, word_type code)
+{
+	const std::size_t shift = (i % bases_per_word) * 2;
+	word_type& word = words[i / bases_per_word];
+	word = (word & ~(word_type(3) << shift)) | (code << shift);
+}
+
+void packed_sequence::trim()
+{
+	if (length % bases_per_word)
+		words.back() &= ~(~word_type(0) << ((length % bases_per_word) * 2));
+}
+
+namespace sequence {
+
+/// Returns the index of the lowest set bit of a nonzero word.
+static inline std::size_t lowest_bit(std::uint64_t bits)
+{
+	static constexpr std::uint64_t de_bruijn = 0x03f79d71b4cb0a89;
+	static constexpr unsigned char indices[64] =
+	{
+		 0,  1, 48,  2, 57, 49, 28,  3, 61, 58, 50, 42, 38, 29, 17,  4,
+		62, 55, 59, 36, 53, 51, 43, 22, 45, 39, 33, 30, 24, 18, 12,  5,
+		63, 47, 56, 27, 60, 41, 37, 16, 54, 35, 52, 21, 44, 32, 23, 11,
+		46, 26, 40, 15, 34, 20, 31, 10, 25, 14, 19,  9, 13,  8,  7,  6
+	};
+	
+	return indices[((bits & (~bits + 1)) * de_bruijn) >> 58];
+}
+
+/// Returns the index of the lowest nonzero two-bit lane of a word.
+static inline std::size_t lowest_lane(packed_sequence::word_type lanes)
+{
+	return lowest_bit(lanes) / 2;
+}
+
+std::size_t search(const packed_sequence& s, const std::string& pattern, std::size_t stride)
+{
+	typedef packed_sequence::word_type word_type;
+	static constexpr word_type low_bits = 0x5555555555555555;
+	static constexpr std::size_t lanes = packed_sequence::bases_per_word;
+	
+	const std::size_t n = s.size();
+	const std::size_t m = pattern.size();
+	if (!m)
+		return 0;
+	if (m > n)
+		return n;
+	
+	// Collect the codes matched by each symbol of the pattern, as a bit mask of codes
+	std::vector<unsigned char> matches(m, 0);
+	for (std::size_t j = 0; j < m; ++j)
+	{
+		for (int code = 0; code < 4; ++code)
+			if (base::compare(pattern[j], "ACGT"[code]))
+				matches[j] |= 1 << code;
+		
+		// No base matches the pattern
+		if (!matches[j])
+			return n;
+	}
+	
+	const std::vector<packed_sequence::ambiguity>& ambiguities = s.get_ambiguities();
+	auto ambiguity = ambiguities.begin();
+	
+	const std::size_t last_candidate = n - m;
+	for (std::size_t block = 0; block <= last_candidate; block += lanes)
+	{
+		// Mark the lanes of candidate positions
+		word_type candidates = 0;
+		const std::size_t block_end = std::min(block + lanes, last_candidate + 1);
+		for (std::size_t i = (block + stride - 1) / stride * stride; i < block_end; i += stride)
+			candidates |= word_type(1) << ((i - block) * 2);
+		if (!candidates)
+			continue;
+		
+		// Test candidates overlapping degenerate symbols one at a time
+		while (ambiguity != ambiguities.end() && ambiguity->first < block)
+			++ambiguity;
+		if (ambiguity != ambiguities.end() && ambiguity->first < block_end + m - 1)
+		{
+			for (; candidates; candidates &= candidates - 1)
+			{
+				const std::size_t i = block + lowest_lane(candidates);
+				std::size_t j = 0;
+				while (j < m && base::compare(s.get(i + j), pattern[j]))
+					++j;
+				if (j == m)
+					return i;
+			}
+			
+			continue;
+		}
+		
+		// Test all candidates of the block against each symbol of the pattern
+		for (std::size_t j = 0; j < m && candidates; ++j)
+		{
+			if (matches[j] == 0b1111)
+				continue;
+			
+			const word_type window = s.get_window(block + j);
+			word_type matched = 0;
+			for (int code = 0; code < 4; ++code)
+			{
+				if (matches[j] & (1 << code))
+				{
+					// Lanes equal to the code have both bits clear
+					const word_type x = window ^ (low_bits * static_cast<word_type>(code));
+					matched |= ~(x | (x >> 1)) & low_bits;
+				}
+			}
+			
+			candidates &= matched;
+		}
+		
+		if (candidates)
+			return block + lowest_lane(candidates);
+	}
+	
+	return n;
+}
+
+/**
+ * Finds the first position on `[first, last]` at which a codon of a set begins.
+ *
+ * @param s Packed sequence to scan.
+ * @param first,last Range of positions at which codons may begin.
+ * @param codons Bit mask of codons, indexed by codon::index().
+ * @param frame Remainder of the positions modulo three, or `3` to scan all reading frames.
+ * @return Position of the first codon in the set, or `last + 1` if there is none.
+ */
+static std::size_t find_codon(const packed_sequence& s, std::size_t first, std::size_t last, std::uint64_t codons, std::size_t frame)
+{
+	typedef packed_sequence::word_type word_type;
+	static constexpr word_type low_bits = 0x5555555555555555;
+	static constexpr std::size_t lanes = packed_sequence::bases_per_word;
+	
+	// Lanes of each reading frame, relative to the first lane of a block
+	static constexpr word_type frame_lanes[3] =
+	{
+		0x1041041041041041,
+		0x4104104104104104,
+		0x0410410410410410
+	};
+	
+	const std::vector<packed_sequence::ambiguity>& ambiguities = s.get_ambiguities();
+	auto ambiguity = ambiguities.begin();
+	
+	for (std::size_t block = first; block <= last; block += lanes)
+	{
+		// Mark the lanes of positions on [block, last] in the reading frame
+		const std::size_t count = std::min(lanes, last - block + 1);
+		word_type candidates = (count < lanes) ? low_bits & ~(~word_type(0) << (count * 2)) : low_bits;
+		if (frame < 3)
+			candidates &= frame_lanes[(frame + 3 - block % 3) % 3];
+		
+		// Exclude the lanes of codons containing degenerate symbols
+		while (ambiguity != ambiguities.end() && ambiguity->first < block)
+			++ambiguity;
+		for (auto it = ambiguity; it != ambiguities.end() && it->first < block + lanes + 2; ++it)
+		{
+			const std::size_t lane = it->first - block;
+			for (std::size_t i = (lane < 2) ? 0 : lane - 2; i <= lane && i < lanes; ++i)
+				candidates &= ~(word_type(1) << (i * 2));
+		}
+		
+		if (!candidates)
+			continue;
+		
+		// Test the codons at all positions of the block against each codon of the set
+		const word_type windows[3] = {s.get_window(block), s.get_window(block + 1), s.get_window(block + 2)};
+		word_type matched = 0;
+		for (std::uint64_t remaining = codons; remaining; remaining &= remaining - 1)
+		{
+			const std::size_t codon = lowest_bit(remaining);
+			
+			word_type lanes_matched = low_bits;
+			for (std::size_t j = 0; j < 3; ++j)
+			{
+				// Lanes equal to the code have both bits clear
+				const word_type x = windows[j] ^ (low_bits * static_cast<word_type>((codon >> (j * 2)) & 3));
+				lanes_matched &= ~(x | (x >> 1));
+			}
+			
+			matched |= lanes_matched;
+		}
+		
+		candidates &= matched;
+		if (candidates)
+			return block + lowest_lane(candidates);
+	}
+	
+	return last + 1;
+}
+
+orf<packed_sequence::const_iterator> find_orf(packed_sequence::const_iterator first, packed_sequence::const_iterator last, const codon::table& table)
+{
+	if (last - first < 3)
+		return {last, last};
+	
+	const packed_sequence& s = *first.get_sequence();
+	const std::size_t last_codon = last.get_position() - 3;
+	
+	// Find the first start codon in any reading frame
+	const std::size_t start = find_codon(s, first.get_position(), last_codon, table.start_mask, 3);
+	if (start > last_codon)
+		return {last, last};
+	
+	// Find the first stop codon in the reading frame of the start codon
+	const std::size_t stop = find_codon(s, start + 3, last_codon, table.stop_mask, start % 3);
+	if (stop > last_codon)
+		return {last, last};
+	
+	return {packed_sequence::const_iterator(&s, start), packed_sequence::const_iterator(&s, stop)};
+}
+
+packed_sequence transcribe(const packed_sequence& s)
+{
+	packed_sequence result = s;
+	result.set_alphabet((s.get_alphabet() == packed_sequence::alphabet::dna) ? packed_sequence::alphabet::rna : packed_sequence::alphabet::dna);
+	return result;
+}
+
+namespace dna
+{
+	packed_sequence complement(const packed_sequence& s)
+	{
+		packed_sequence result = s;
+		result.complement();
+		result.set_alphabet(packed_sequence::alphabet::dna);
+		return result;
+	}
+}
+
+namespace rna
+{
+	packed_sequence complement(const packed_sequence& s)
+	{
+		packed_sequence result = s;
+		result.complement();
+		result.set_alphabet(packed_sequence::alphabet::rna);
+		return result;
+	}
+}
+
+} // namespace sequence
+} // namespace genetics
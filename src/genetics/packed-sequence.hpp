@@ -0,0 +1,746 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ANTKEEPER_GENETICS_PACKED_SEQUENCE_HPP
+#define ANTKEEPER_GENETICS_PACKED_SEQUENCE_HPP
+
+#include "sequence.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace genetics {
+
+/**
+ * Sequence of IUPAC degenerate base symbols, packed at two bits per base.
+ *
+ * Unambiguous bases are stored as two-bit codes, 32 bases per 64-bit word, in the order of `A`, `C`, `G`, and `T` or `U`, such that the complement of a base is its code inverted. Degenerate symbols are stored in a side-table sorted by position, which is expected to be small or empty, with placeholder codes of zero in their words. Whether the code `3` decodes to `T` or `U` is determined by the alphabet of the sequence, so transcription between DNA and RNA does not touch the bases.
+ *
+ * Iterators dereference to base symbols, so the iterator-based algorithms of genetics::sequence operate on packed sequences. Word-parallel overloads of the bulk algorithms are declared in genetics::sequence below.
+ */
+class packed_sequence
+{
+public:
+	/// Alphabet of a sequence.
+	enum class alphabet: unsigned char
+	{
+		/// Code `3` decodes to `T`.
+		dna,
+		
+		/// Code `3` decodes to `U`.
+		rna
+	};
+	
+	/// Word in which bases are packed.
+	typedef std::uint64_t word_type;
+	
+	/// Number of bases packed into each word.
+	static constexpr std::size_t bases_per_word = 32;
+	
+	/// Entry of the side-table of degenerate base symbols.
+	typedef std::pair<std::size_t, char> ambiguity;
+	
+	class reference;
+	class iterator;
+	class const_iterator;
+	
+	/**
+	 * Creates an empty sequence.
+	 *
+	 * @param alphabet Alphabet of the sequence.
+	 */
+	explicit packed_sequence(alphabet alphabet = alphabet::dna);
+	
+	/**
+	 * Creates a sequence from a string of IUPAC degenerate base symbols.
+	 *
+	 * @param symbols String of IUPAC degenerate base symbols.
+	 * @param alphabet Alphabet of the sequence.
+	 */
+	explicit packed_sequence(const std::string& symbols, alphabet alphabet = alphabet::dna);
+	
+	/**
+	 * Creates a sequence from a range of IUPAC degenerate base symbols.
+	 *
+	 * @param first,last Range of IUPAC degenerate base symbols.
+	 * @param alphabet Alphabet of the sequence.
+	 */
+	template <class InputIt>
+	packed_sequence(InputIt first, InputIt last, alphabet alphabet = alphabet::dna);
+	
+	/// Returns the symbol of the base at position @p i.
+	char get(std::size_t i) const;
+	
+	/**
+	 * Sets the base at position @p i.
+	 *
+	 * @param i Position of the base.
+	 * @param symbol IUPAC degenerate base symbol.
+	 */
+	void set(std::size_t i, char symbol);
+	
+	/// Appends a base symbol to the end of the sequence.
+	void push_back(char symbol);
+	
+	/**
+	 * Changes the number of bases in the sequence. New bases are `A`.
+	 *
+	 * @param size Number of bases.
+	 */
+	void resize(std::size_t size);
+	
+	/// Removes all bases from the sequence.
+	void clear();
+	
+	/**
+	 * Exchanges the bases on `[first, last)` with the bases at the same positions in another sequence, one word at a time.
+	 *
+	 * @param other Sequence with which to exchange bases. Must contain at least @p last bases.
+	 * @param first,last Range of positions to exchange.
+	 */
+	void swap_range(packed_sequence& other, std::size_t first, std::size_t last);
+	
+	/// Replaces each base with its complement, one word at a time.
+	void complement();
+	
+	/// Sets the alphabet by which code `3` is decoded.
+	void set_alphabet(alphabet alphabet);
+	
+	/// Returns the sequence as a string of IUPAC degenerate base symbols.
+	std::string to_string() const;
+	
+	/// Returns the number of bases in the sequence.
+	std::size_t size() const;
+	
+	/// Returns `true` if the sequence contains no bases.
+	bool empty() const;
+	
+	/// Returns the alphabet of the sequence.
+	alphabet get_alphabet() const;
+	
+	/// Returns the words into which bases are packed. Bits beyond the last base are zero.
+	const std::vector<word_type>& get_words() const;
+	
+	/// Returns the side-table of degenerate base symbols, sorted by position.
+	const std::vector<ambiguity>& get_ambiguities() const;
+	
+	/**
+	 * Returns the codes of the 32 bases starting at position @p i, with the code of the base at @p i in the lowest two bits. Codes beyond the last base are zero.
+	 *
+	 * @param i Position of the first base.
+	 */
+	word_type get_window(std::size_t i) const;
+	
+	reference operator[](std::size_t i);
+	char operator[](std::size_t i) const;
+	
+	iterator begin();
+	iterator end();
+	const_iterator begin() const;
+	const_iterator end() const;
+	const_iterator cbegin() const;
+	const_iterator cend() const;
+	
+	bool operator==(const packed_sequence& other) const;
+	bool operator!=(const packed_sequence& other) const;
+	
+	/// Returns a hash of the bases and alphabet of the sequence, computed one word at a time.
+	std::size_t hash() const;
+	
+	/// Returns the code of an unambiguous base symbol, or `-1` if the symbol is degenerate.
+	static int encode(char symbol);
+	
+private:
+	/// Sets the code of the base at position @p i.
+	void set_code(std::size_t i, word_type code);
+	
+	/// Clears the bits of the last word beyond the last base.
+	void trim();
+	
+	std::vector<word_type> words;
+	std::size_t length;
+	alphabet symbol_alphabet;
+	std::vector<ambiguity> ambiguities;
+};
+
+/// Proxy reference to a base of a packed sequence.
+class packed_sequence::reference
+{
+public:
+	reference(packed_sequence* sequence, std::size_t i);
+	operator char() const;
+	reference& operator=(char symbol);
+	reference& operator=(const reference& other);
+	
+private:
+	packed_sequence* sequence;
+	std::size_t i;
+};
+
+/// Random access iterator over the base symbols of a packed sequence.
+class packed_sequence::const_iterator
+{
+public:
+	typedef std::random_access_iterator_tag iterator_category;
+	typedef char value_type;
+	typedef std::ptrdiff_t difference_type;
+	typedef const char* pointer;
+	typedef char reference;
+	
+	const_iterator();
+	const_iterator(const packed_sequence* sequence, std::size_t i);
+	
+	char operator*() const;
+	char operator[](difference_type n) const;
+	const_iterator& operator++();
+	const_iterator operator++(int);
+	const_iterator& operator--();
+	const_iterator operator--(int);
+	const_iterator& operator+=(difference_type n);
+	const_iterator& operator-=(difference_type n);
+	const_iterator operator+(difference_type n) const;
+	const_iterator operator-(difference_type n) const;
+	difference_type operator-(const const_iterator& other) const;
+	bool operator==(const const_iterator& other) const;
+	bool operator!=(const const_iterator& other) const;
+	bool operator<(const const_iterator& other) const;
+	
+	/// Returns the position of the iterator in its sequence.
+	std::size_t get_position() const;
+	
+	/// Returns the sequence of the iterator.
+	const packed_sequence* get_sequence() const;
+	
+private:
+	const packed_sequence* sequence;
+	std::size_t i;
+};
+
+/// Random access iterator over the bases of a packed sequence, which dereferences to proxy references.
+class packed_sequence::iterator
+{
+public:
+	typedef std::random_access_iterator_tag iterator_category;
+	typedef char value_type;
+	typedef std::ptrdiff_t difference_type;
+	typedef void pointer;
+	typedef packed_sequence::reference reference;
+	
+	iterator();
+	iterator(packed_sequence* sequence, std::size_t i);
+	operator const_iterator() const;
+	
+	reference operator*() const;
+	reference operator[](difference_type n) const;
+	iterator& operator++();
+	iterator operator++(int);
+	iterator& operator--();
+	iterator operator--(int);
+	iterator& operator+=(difference_type n);
+	iterator& operator-=(difference_type n);
+	iterator operator+(difference_type n) const;
+	iterator operator-(difference_type n) const;
+	difference_type operator-(const iterator& other) const;
+	bool operator==(const iterator& other) const;
+	bool operator!=(const iterator& other) const;
+	bool operator<(const iterator& other) const;
+	
+	/// Returns the position of the iterator in its sequence.
+	std::size_t get_position() const;
+	
+private:
+	packed_sequence* sequence;
+	std::size_t i;
+};
+
+namespace sequence {
+
+/**
+ * Exchanges bases between two packed sequences, starting at a random offset, one word at a time.
+ *
+ * @param a First sequence.
+ * @param b Second sequence, with at least as many bases as @p a.
+ * @param g Uniform random bit generator.
+ * @return Position at which the crossover starts.
+ */
+template <class URBG>
+std::size_t crossover(packed_sequence& a, packed_sequence& b, URBG&& g);
+
+/**
+ * Exchanges bases between two packed sequences multiple times, starting at a random offset each time.
+ *
+ * @param a First sequence.
+ * @param b Second sequence, with at least as many bases as @p a.
+ * @param count Number of times to crossover.
+ * @param g Uniform random bit generator.
+ */
+template <class Size, class URBG>
+void crossover_n(packed_sequence& a, packed_sequence& b, Size count, URBG&& g);
+
+/**
+ * Searches a packed sequence for a pattern matching a search string of IUPAC degenerate base symbols, testing 32 candidate positions per word for each base of the pattern.
+ *
+ * @param s Packed sequence to search.
+ * @param pattern Search string of IUPAC degenerate base symbols.
+ * @param stride Distance between consecutive candidate positions.
+ * @return Position of the first subsequence matching @p pattern, or the size of @p s if no such occurrence is found.
+ */
+std::size_t search(const packed_sequence& s, const std::string& pattern, std::size_t stride = 1);
+
+/**
+ * Searches a packed sequence for an open reading frame (ORF), testing the codons at 32 consecutive positions, and therefore in all three reading frames, per word for each start or stop codon of the table. Codons containing degenerate symbols are neither start nor stop codons.
+ *
+ * @param first,last Range of the packed sequence to search.
+ * @param table Genetic code translation table.
+ * @return First ORF in the sequence, or `{last, last}` if no ORF was found.
+ */
+orf<packed_sequence::const_iterator> find_orf(packed_sequence::const_iterator first, packed_sequence::const_iterator last, const codon::table& table);
+
+/**
+ * Translates a sequence of packed codons into amino acids, using the six bits of each codon as its index in the lookup tables of the codon table.
+ *
+ * @param first,last Open reading frame.
+ * @param d_first Beginning of destination range.
+ * @param table Genetic code translation table.
+ * @return Output iterator to the element past the last element translated.
+ */
+template <class OutputIt>
+OutputIt translate(packed_sequence::const_iterator first, packed_sequence::const_iterator last, OutputIt d_first, const codon::table& table);
+
+/**
+ * Transcribes a packed sequence between DNA and RNA. As only the alphabet of the sequence changes, no bases are processed.
+ *
+ * @param s Packed sequence to transcribe.
+ * @return Transcribed sequence.
+ */
+packed_sequence transcribe(const packed_sequence& s);
+
+namespace dna
+{
+	/**
+	 * Generates the complement of a packed sequence of IUPAC degenerate DNA base symbols, inverting 32 bases per word.
+	 *
+	 * @param s Packed sequence to complement.
+	 * @return Complementary sequence.
+	 */
+	packed_sequence complement(const packed_sequence& s);
+}
+
+namespace rna
+{
+	/**
+	 * Generates the complement of a packed sequence of IUPAC degenerate RNA base symbols, inverting 32 bases per word.
+	 *
+	 * @param s Packed sequence to complement.
+	 * @return Complementary sequence.
+	 */
+	packed_sequence complement(const packed_sequence& s);
+}
+
+} // namespace sequence
+
+template <class InputIt>
+packed_sequence::packed_sequence(InputIt first, InputIt last, alphabet alphabet):
+	length(0),
+	symbol_alphabet(alphabet)
+{
+	for (; first != last; ++first)
+		push_back(*first);
+}
+
+inline void packed_sequence::set_alphabet(alphabet alphabet)
+{
+	symbol_alphabet = alphabet;
+}
+
+inline std::size_t packed_sequence::size() const
+{
+	return length;
+}
+
+inline bool packed_sequence::empty() const
+{
+	return !length;
+}
+
+inline packed_sequence::alphabet packed_sequence::get_alphabet() const
+{
+	return symbol_alphabet;
+}
+
+inline const std::vector<packed_sequence::word_type>& packed_sequence::get_words() const
+{
+	return words;
+}
+
+inline const std::vector<packed_sequence::ambiguity>& packed_sequence::get_ambiguities() const
+{
+	return ambiguities;
+}
+
+inline packed_sequence::word_type packed_sequence::get_window(std::size_t i) const
+{
+	const std::size_t w = i / bases_per_word;
+	const std::size_t shift = (i % bases_per_word) * 2;
+	
+	word_type window = (w < words.size()) ? words[w] >> shift : 0;
+	if (shift && w + 1 < words.size())
+		window |= words[w + 1] << (64 - shift);
+	
+	return window;
+}
+
+inline packed_sequence::reference packed_sequence::operator[](std::size_t i)
+{
+	return {this, i};
+}
+
+inline char packed_sequence::operator[](std::size_t i) const
+{
+	return get(i);
+}
+
+inline packed_sequence::iterator packed_sequence::begin()
+{
+	return {this, 0};
+}
+
+inline packed_sequence::iterator packed_sequence::end()
+{
+	return {this, length};
+}
+
+inline packed_sequence::const_iterator packed_sequence::begin() const
+{
+	return {this, 0};
+}
+
+inline packed_sequence::const_iterator packed_sequence::end() const
+{
+	return {this, length};
+}
+
+inline packed_sequence::const_iterator packed_sequence::cbegin() const
+{
+	return {this, 0};
+}
+
+inline packed_sequence::const_iterator packed_sequence::cend() const
+{
+	return {this, length};
+}
+
+inline bool packed_sequence::operator!=(const packed_sequence& other) const
+{
+	return !(*this == other);
+}
+
+inline packed_sequence::reference::reference(packed_sequence* sequence, std::size_t i):
+	sequence(sequence),
+	i(i)
+{}
+
+inline packed_sequence::reference::operator char() const
+{
+	return sequence->get(i);
+}
+
+inline packed_sequence::reference& packed_sequence::reference::operator=(char symbol)
+{
+	sequence->set(i, symbol);
+	return *this;
+}
+
+inline packed_sequence::reference& packed_sequence::reference::operator=(const reference& other)
+{
+	sequence->set(i, static_cast<char>(other));
+	return *this;
+}
+
+inline packed_sequence::const_iterator::const_iterator():
+	sequence(nullptr),
+	i(0)
+{}
+
+inline packed_sequence::const_iterator::const_iterator(const packed_sequence* sequence, std::size_t i):
+	sequence(sequence),
+	i(i)
+{}
+
+inline char packed_sequence::const_iterator::operator*() const
+{
+	return sequence->get(i);
+}
+
+inline char packed_sequence::const_iterator::operator[](difference_type n) const
+{
+	return sequence->get(i + n);
+}
+
+inline packed_sequence::const_iterator& packed_sequence::const_iterator::operator++()
+{
+	++i;
+	return *this;
+}
+
+inline packed_sequence::const_iterator packed_sequence::const_iterator::operator++(int)
+{
+	const_iterator it = *this;
+	++i;
+	return it;
+}
+
+inline packed_sequence::const_iterator& packed_sequence::const_iterator::operator--()
+{
+	--i;
+	return *this;
+}
+
+inline packed_sequence::const_iterator packed_sequence::const_iterator::operator--(int)
+{
+	const_iterator it = *this;
+	--i;
+	return it;
+}
+
+inline packed_sequence::const_iterator& packed_sequence::const_iterator::operator+=(difference_type n)
+{
+	i += n;
+	return *this;
+}
+
+inline packed_sequence::const_iterator& packed_sequence::const_iterator::operator-=(difference_type n)
+{
+	i -= n;
+	return *this;
+}
+
+inline packed_sequence::const_iterator packed_sequence::const_iterator::operator+(difference_type n) const
+{
+	return {sequence, i + n};
+}
+
+inline packed_sequence::const_iterator packed_sequence::const_iterator::operator-(difference_type n) const
+{
+	return {sequence, i - n};
+}
+
+inline packed_sequence::const_iterator::difference_type packed_sequence::const_iterator::operator-(const const_iterator& other) const
+{
+	return static_cast<difference_type>(i) - static_cast<difference_type>(other.i);
+}
+
+inline bool packed_sequence::const_iterator::operator==(const const_iterator& other) const
+{
+	return i == other.i;
+}
+
+inline bool packed_sequence::const_iterator::operator!=(const const_iterator& other) const
+{
+	return i != other.i;
+}
+
+inline bool packed_sequence::const_iterator::operator<(const const_iterator& other) const
+{
+	return i < other.i;
+}
+
+inline std::size_t packed_sequence::const_iterator::get_position() const
+{
+	return i;
+}
+
+inline const packed_sequence* packed_sequence::const_iterator::get_sequence() const
+{
+	return sequence;
+}
+
+inline packed_sequence::iterator::iterator():
+	sequence(nullptr),
+	i(0)
+{}
+
+inline packed_sequence::iterator::iterator(packed_sequence* sequence, std::size_t i):
+	sequence(sequence),
+	i(i)
+{}
+
+inline packed_sequence::iterator::operator const_iterator() const
+{
+	return {sequence, i};
+}
+
+inline packed_sequence::reference packed_sequence::iterator::operator*() const
+{
+	return {sequence, i};
+}
+
+inline packed_sequence::reference packed_sequence::iterator::operator[](difference_type n) const
+{
+	return {sequence, i + n};
+}
+
+inline packed_sequence::iterator& packed_sequence::iterator::operator++()
+{
+	++i;
+	return *this;
+}
+
+inline packed_sequence::iterator packed_sequence::iterator::operator++(int)
+{
+	iterator it = *this;
+	++i;
+	return it;
+}
+
+inline packed_sequence::iterator& packed_sequence::iterator::operator--()
+{
+	--i;
+	return *this;
+}
+
+inline packed_sequence::iterator packed_sequence::iterator::operator--(int)
+{
+	iterator it = *this;
+	--i;
+	return it;
+}
+
+inline packed_sequence::iterator& packed_sequence::iterator::operator+=(difference_type n)
+{
+	i += n;
+	return *this;
+}
+
+inline packed_sequence::iterator& packed_sequence::iterator::operator-=(difference_type n)
+{
+	i -= n;
+	return *this;
+}
+
+inline packed_sequence::iterator packed_sequence::iterator::operator+(difference_type n) const
+{
+	return {sequence, i + n};
+}
+
+inline packed_sequence::iterator packed_sequence::iterator::operator-(difference_type n) const
+{
+	return {sequence, i - n};
+}
+
+inline packed_sequence::iterator::difference_type packed_sequence::iterator::operator-(const iterator& other) const
+{
+	return static_cast<difference_type>(i) - static_cast<difference_type>(other.i);
+}
+
+inline bool packed_sequence::iterator::operator==(const iterator& other) const
+{
+	return i == other.i;
+}
+
+inline bool packed_sequence::iterator::operator!=(const iterator& other) const
+{
+	return i != other.i;
+}
+
+inline bool packed_sequence::iterator::operator<(const iterator& other) const
+{
+	return i < other.i;
+}
+
+inline std::size_t packed_sequence::iterator::get_position() const
+{
+	return i;
+}
+
+namespace sequence {
+
+template <class URBG>
+std::size_t crossover(packed_sequence& a, packed_sequence& b, URBG&& g)
+{
+	std::uniform_int_distribution<std::size_t> distribution(0, a.size() - 1);
+	const std::size_t pos = distribution(g);
+	a.swap_range(b, pos, a.size());
+	return pos;
+}
+
+template <class Size, class URBG>
+void crossover_n(packed_sequence& a, packed_sequence& b, Size count, URBG&& g)
+{
+	std::uniform_int_distribution<std::size_t> distribution(0, a.size() - 1);
+	
+	while (count)
+	{
+		a.swap_range(b, distribution(g), a.size());
+		--count;
+	}
+}
+
+template <class OutputIt>
+OutputIt translate(packed_sequence::const_iterator first, packed_sequence::const_iterator last, OutputIt d_first, const codon::table& table)
+{
+	if (last - first < 3)
+		return d_first;
+	
+	const packed_sequence& s = *first.get_sequence();
+	const std::size_t start = first.get_position();
+	const std::size_t end = start + static_cast<std::size_t>(last - first) / 3 * 3;
+	
+	const std::vector<packed_sequence::ambiguity>& ambiguities = s.get_ambiguities();
+	auto ambiguity = ambiguities.begin();
+	
+	for (std::size_t i = start; i < end; i += 3)
+	{
+		// Codons containing degenerate symbols can't be translated
+		while (ambiguity != ambiguities.end() && ambiguity->first < i)
+			++ambiguity;
+		if (ambiguity != ambiguities.end() && ambiguity->first < i + 3)
+		{
+			*(d_first++) = '-';
+			continue;
+		}
+		
+		const std::size_t index = static_cast<std::size_t>(s.get_window(i) & 63);
+		*(d_first++) = (i == start) ? table.start_lut[index] : table.aa_lut[index];
+	}
+	
+	return d_first;
+}
+
+} // namespace sequence
+} // namespace genetics
+
+namespace std
+{
+	template <>
+	struct hash<genetics::packed_sequence>
+	{
+		std::size_t operator()(const genetics::packed_sequence& s) const
+		{
+			return s.hash();
+		}
+	};
+}
+
+#endif // ANTKEEPER_GENETICS_PACKED_SEQUENCE_HPP
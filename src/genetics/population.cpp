@@ -0,0 +1,202 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "population.hpp"
+#include "math/random.hpp"
+#include "utility/job-system.hpp"
+#include <atomic>
+#include <cmath>
+#include <limits>
+
+namespace genetics {
+namespace population {
+
+/// Returns the random stream of the element of a batch at @p index.
+static inline math::random_engine stream(std::uint64_t seed, std::size_t index)
+{
+	return math::random_engine(seed + static_cast<std::uint64_t>(index) * 0xd1b54a32d192ed03ull);
+}
+
+void crossover(const chromosome_pair* pairs, std::size_t count, std::size_t crossovers, std::uint64_t seed, job_system* jobs)
+{
+	auto recombine = [=](std::size_t first, std::size_t last)
+	{
+		for (std::size_t i = first; i < last; ++i)
+		{
+			packed_sequence& a = *pairs[i].first;
+			packed_sequence& b = *pairs[i].second;
+			const std::size_t size = a.size();
+			if (!size)
+				continue;
+			
+			math::random_engine engine = stream(seed, i);
+			for (std::size_t j = 0; j < crossovers; ++j)
+				a.swap_range(b, static_cast<std::size_t>(engine() % size), size);
+		}
+	};
+	
+	if (jobs)
+		jobs->parallel_for(0, count, 16, recombine);
+	else
+		recombine(0, count);
+}
+
+void crossover(chromosome* chromosomes, std::size_t count, std::size_t crossovers, std::uint64_t seed, job_system* jobs)
+{
+	auto recombine = [=](std::size_t first, std::size_t last)
+	{
+		for (std::size_t i = first; i < last; ++i)
+		{
+			chromosome& a = chromosomes[i * 2];
+			chromosome& b = chromosomes[i * 2 + 1];
+			const std::size_t size = a->size();
+			if (!size || a == b)
+				continue;
+			
+			packed_sequence& edited_a = a.edit();
+			packed_sequence& edited_b = b.edit();
+			math::random_engine engine = stream(seed, i);
+			for (std::size_t j = 0; j < crossovers; ++j)
+				edited_a.swap_range(edited_b, static_cast<std::size_t>(engine() % size), size);
+			
+			a.intern();
+			b.intern();
+		}
+	};
+	
+	if (jobs)
+		jobs->parallel_for(0, count, 16, recombine);
+	else
+		recombine(0, count);
+}
+
+/**
+ * Substitutes bases of a sequence, obtaining the sequence for modification only once its first base is mutated.
+ *
+ * @param sequence Sequence to mutate.
+ * @param edit Function which returns the sequence for modification. The sequence passed as @p sequence may be released by it.
+ * @param rate Probability of each base being mutated, on `(0, 1]`.
+ * @param log_survival Logarithm of the probability of a base not being mutated.
+ * @param engine Random stream of the sequence.
+ * @return Number of mutated bases.
+ */
+template <class Edit>
+static std::size_t mutate_sequence(const packed_sequence& sequence, Edit&& edit, double rate, double log_survival, math::random_engine& engine)
+{
+	const std::size_t size = sequence.size();
+	packed_sequence* mutated = nullptr;
+	std::size_t count = 0;
+	
+	for (std::size_t position = 0; ; ++position)
+	{
+		// Skip to the next mutated base
+		if (rate < 1.0)
+		{
+			const double u = engine.uniform<double>(std::numeric_limits<double>::min(), 1.0);
+			const double skip = std::floor(std::log(u) / log_survival);
+			if (skip >= static_cast<double>(size - position))
+				break;
+			position += static_cast<std::size_t>(skip);
+		}
+		else if (position >= size)
+		{
+			break;
+		}
+		
+		if (!mutated)
+			mutated = &edit();
+		
+		// Substitute one of the other bases
+		const std::uint64_t bits = engine();
+		const int code = packed_sequence::encode(mutated->get(position));
+		const int mutated_code = (code < 0) ? static_cast<int>(bits & 3) : code ^ static_cast<int>(1 + bits % 3);
+		mutated->set(position, "ACGT"[mutated_code]);
+		++count;
+	}
+	
+	return count;
+}
+
+std::size_t mutate(packed_sequence* const* chromosomes, std::size_t count, double rate, std::uint64_t seed, job_system* jobs)
+{
+	if (rate <= 0.0)
+		return 0;
+	
+	// Gaps between mutations are geometrically distributed, with a mean of 1 / rate
+	const double log_survival = std::log1p(-std::min(rate, 1.0));
+	
+	std::atomic<std::size_t> mutation_count{0};
+	auto mutate_chromosomes = [&](std::size_t first, std::size_t last)
+	{
+		std::size_t local_count = 0;
+		for (std::size_t i = first; i < last; ++i)
+		{
+			packed_sequence& chromosome = *chromosomes[i];
+			math::random_engine engine = stream(seed, i);
+			local_count += mutate_sequence(chromosome, [&]() -> packed_sequence& {return chromosome;}, rate, log_survival, engine);
+		}
+		
+		mutation_count += local_count;
+	};
+	
+	if (jobs)
+		jobs->parallel_for(0, count, 16, mutate_chromosomes);
+	else
+		mutate_chromosomes(0, count);
+	
+	return mutation_count;
+}
+
+std::size_t mutate(chromosome* chromosomes, std::size_t count, double rate, std::uint64_t seed, job_system* jobs)
+{
+	if (rate <= 0.0)
+		return 0;
+	
+	const double log_survival = std::log1p(-std::min(rate, 1.0));
+	
+	std::atomic<std::size_t> mutation_count{0};
+	auto mutate_chromosomes = [&](std::size_t first, std::size_t last)
+	{
+		std::size_t local_count = 0;
+		for (std::size_t i = first; i < last; ++i)
+		{
+			chromosome& c = chromosomes[i];
+			math::random_engine engine = stream(seed, i);
+			
+			// Copy the shared sequence once it's first mutated, then intern the mutated sequence
+			if (const std::size_t mutations = mutate_sequence(*c, [&]() -> packed_sequence& {return c.edit();}, rate, log_survival, engine))
+			{
+				c.intern();
+				local_count += mutations;
+			}
+		}
+		
+		mutation_count += local_count;
+	};
+	
+	if (jobs)
+		jobs->parallel_for(0, count, 16, mutate_chromosomes);
+	else
+		mutate_chromosomes(0, count);
+	
+	return mutation_count;
+}
+
+} // namespace population
+} // namespace genetics
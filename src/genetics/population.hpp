@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ANTKEEPER_GENETICS_POPULATION_HPP
+#define ANTKEEPER_GENETICS_POPULATION_HPP
+
+#include "chromosome.hpp"
+#include "packed-sequence.hpp"
+#include <cstddef>
+#include <cstdint>
+
+class job_system;
+
+namespace genetics {
+
+/**
+ * Genetic operators applied to the chromosomes of a whole population at once.
+ *
+ * Chromosomes are processed in parallel if a job system is given. Operators on shared chromosomes copy only the sequences they change, then intern them again. Each chromosome or pair of chromosomes draws from its own random stream, seeded from the seed of the batch and its index in the batch, so that the results of a batch depend only on its seed and not on the number of threads.
+ */
+namespace population {
+
+/// Pair of homologous chromosomes.
+struct chromosome_pair
+{
+	packed_sequence* first;
+	packed_sequence* second;
+};
+
+/**
+ * Recombines pairs of homologous chromosomes, exchanging the bases after each of a number of random crossover points, one word at a time.
+ *
+ * @param pairs Array of chromosome pairs. The second chromosome of each pair must contain at least as many bases as the first.
+ * @param count Number of chromosome pairs.
+ * @param crossovers Number of crossover points per pair.
+ * @param seed Seed of the random streams of the batch.
+ * @param jobs Job system on which pairs are recombined, or `nullptr` to recombine pairs on the calling thread.
+ */
+void crossover(const chromosome_pair* pairs, std::size_t count, std::size_t crossovers, std::uint64_t seed, job_system* jobs = nullptr);
+
+/**
+ * Recombines pairs of homologous shared chromosomes. Pairs whose chromosomes are equal are unchanged by recombination, and are neither copied nor drawn from.
+ *
+ * @param chromosomes Array of chromosomes, in which homologous chromosomes are stored consecutively, as in a diploid genome. The second chromosome of each pair must contain at least as many bases as the first.
+ * @param count Number of chromosome pairs.
+ * @param crossovers Number of crossover points per pair.
+ * @param seed Seed of the random streams of the batch.
+ * @param jobs Job system on which pairs are recombined, or `nullptr` to recombine pairs on the calling thread.
+ */
+void crossover(chromosome* chromosomes, std::size_t count, std::size_t crossovers, std::uint64_t seed, job_system* jobs = nullptr);
+
+/**
+ * Substitutes bases of chromosomes, each base with a given probability. Rather than testing each base, the distance to the next mutated base is drawn from a geometric distribution, so the cost of a chromosome is proportional to its number of mutations. Mutated bases are replaced by one of the three other bases, and degenerate symbols by any of the four bases, with equal probability.
+ *
+ * @param chromosomes Array of pointers to chromosomes.
+ * @param count Number of chromosomes.
+ * @param rate Probability of each base being mutated, on `[0, 1]`.
+ * @param seed Seed of the random streams of the batch.
+ * @param jobs Job system on which chromosomes are mutated, or `nullptr` to mutate chromosomes on the calling thread.
+ * @return Number of mutated bases.
+ */
+std::size_t mutate(packed_sequence* const* chromosomes, std::size_t count, double rate, std::uint64_t seed, job_system* jobs = nullptr);
+
+/**
+ * Substitutes bases of shared chromosomes, each base with a given probability. Only chromosomes with at least one mutation are copied, and the same seed mutates the same bases as the overload for packed sequences.
+ *
+ * @param chromosomes Array of chromosomes.
+ * @param count Number of chromosomes.
+ * @param rate Probability of each base being mutated, on `[0, 1]`.
+ * @param seed Seed of the random streams of the batch.
+ * @param jobs Job system on which chromosomes are mutated, or `nullptr` to mutate chromosomes on the calling thread.
+ * @return Number of mutated bases.
+ */
+std::size_t mutate(chromosome* chromosomes, std::size_t count, double rate, std::uint64_t seed, job_system* jobs = nullptr);
+
+} // namespace population
+} // namespace genetics
+
+#endif // ANTKEEPER_GENETICS_POPULATION_HPP
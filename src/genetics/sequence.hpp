@@ -212,7 +212,7 @@ orf<ForwardIt> find_orf(ForwardIt first, ForwardIt last, const codon::table& tab
 		
 		do
 		{
-			if (codon::is_start(*first, *second, *third, table.starts))
+			if (table.is_start(*first, *second, *third))
 			{
 				result.start = first;
 				distance -= 3;
@@ -233,7 +233,7 @@ orf<ForwardIt> find_orf(ForwardIt first, ForwardIt last, const codon::table& tab
 		second = ++third;
 		++third;
 		
-		if (codon::is_stop(*first, *second, *third, table.aas))
+		if (table.is_stop(*first, *second, *third))
 		{
 			result.stop = first;
 			return result;
@@ -321,7 +321,7 @@ OutputIt translate(InputIt first, InputIt last, OutputIt d_first, const codon::t
 		InputIt third = second;
 		++third;
 		
-		*(d_first++) = codon::translate(*first, *second, *third, table.starts);
+		*(d_first++) = table.translate_start(*first, *second, *third);
 		
 		for (length -= 3; length >= 3; length -= 3)
 		{
@@ -329,7 +329,7 @@ OutputIt translate(InputIt first, InputIt last, OutputIt d_first, const codon::t
 			second = ++third;
 			++third;
 			
-			*(d_first++) = codon::translate(*first, *second, *third, table.aas);
+			*(d_first++) = table.translate(*first, *second, *third);
 		}
 	}
 	
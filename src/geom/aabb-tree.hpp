@@ -0,0 +1,532 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef ANTKEEPER_GEOM_AABB_TREE_HPP
+#define ANTKEEPER_GEOM_AABB_TREE_HPP
+
+#include "geom/aabb.hpp"
+#include "geom/convex-hull.hpp"
+#include "geom/intersection.hpp"
+#include "geom/packed-hull.hpp"
+#include "geom/ray.hpp"
+#include "geom/sphere.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace geom {
+
+/**
+ * Dynamic AABB tree, for broad phase queries over a set of moving objects.
+ *
+ * Leaves store bounds enlarged by a margin, so objects which move within their enlarged bounds do not need to be reinserted. Leaves are inserted next to the sibling which minimizes the increase in surface area of the tree.
+ *
+ * @tparam T Value type stored in leaves.
+ */
+template <class T>
+class aabb_tree
+{
+public:
+	/// Value type stored in leaves.
+	typedef T value_type;
+	
+	/// Identifies a leaf in the tree.
+	typedef std::uint32_t proxy_type;
+	
+	/// Proxy value which identifies no leaf.
+	static constexpr proxy_type null_proxy = static_cast<proxy_type>(-1);
+	
+	/**
+	 * Creates an empty AABB tree.
+	 *
+	 * @param margin Distance by which leaf bounds are enlarged on each side.
+	 */
+	explicit aabb_tree(float margin = 0.1f);
+	
+	/**
+	 * Inserts a leaf.
+	 *
+	 * @param bounds Bounds of the leaf.
+	 * @param value Value of the leaf.
+	 * @return Proxy which identifies the leaf.
+	 */
+	proxy_type insert(const aabb<float>& bounds, const value_type& value);
+	
+	/**
+	 * Removes a leaf.
+	 *
+	 * @param proxy Proxy of the leaf to remove.
+	 */
+	void remove(proxy_type proxy);
+	
+	/**
+	 * Updates the bounds of a leaf, reinserting it if the bounds are no longer contained in its enlarged bounds.
+	 *
+	 * @param proxy Proxy of the leaf.
+	 * @param bounds New bounds of the leaf.
+	 * @return `true` if the leaf was reinserted, `false` otherwise.
+	 */
+	bool update(proxy_type proxy, const aabb<float>& bounds);
+	
+	/// Removes all leaves.
+	void clear();
+	
+	/**
+	 * Calls a function with the value of each leaf whose enlarged bounds intersect an AABB.
+	 *
+	 * @param bounds Query AABB.
+	 * @param function Function with the signature `void(const value_type&)`.
+	 */
+	template <class Function>
+	void query(const aabb<float>& bounds, Function&& function) const;
+	
+	/**
+	 * Calls a function with the value of each leaf whose enlarged bounds intersect a sphere.
+	 *
+	 * @param bounds Query sphere.
+	 * @param function Function with the signature `void(const value_type&)`.
+	 */
+	template <class Function>
+	void query(const sphere<float>& bounds, Function&& function) const;
+	
+	/**
+	 * Calls a function with the value of each leaf whose enlarged bounds intersect a convex hull. Subtrees are not tested against planes of the hull which they lie entirely inside of, and subtrees which lie entirely inside of the hull are reported without further tests.
+	 *
+	 * @param hull Query convex hull.
+	 * @param function Function with the signature `void(const value_type&)`.
+	 */
+	template <class Function>
+	void query(const convex_hull<float>& hull, Function&& function) const;
+	
+	/**
+	 * Calls a function with the value of each leaf whose enlarged bounds intersect a packed convex hull, as query(const convex_hull<float>&, Function&&) but without repacking the planes of the hull.
+	 *
+	 * @param hull Query packed hull.
+	 * @param function Function with the signature `void(const value_type&)`.
+	 */
+	template <class Function>
+	void query(const packed_hull<float>& hull, Function&& function) const;
+	
+	/**
+	 * Calls a function with the value of each leaf whose enlarged bounds are intersected by a ray within a maximum distance.
+	 *
+	 * @param ray Query ray.
+	 * @param max_t Maximum distance along the ray.
+	 * @param function Function with the signature `float(const value_type& value, float t)`, where `t` is the distance at which the ray enters the leaf bounds. The function returns the new maximum distance, which allows nearest-hit queries to prune leaves beyond the nearest hit found so far.
+	 */
+	template <class Function>
+	void query(const ray<float>& ray, float max_t, Function&& function) const;
+	
+	/// Returns the value of a leaf.
+	const value_type& get_value(proxy_type proxy) const;
+	
+	/// Returns the enlarged bounds of a leaf.
+	const aabb<float>& get_bounds(proxy_type proxy) const;
+	
+	/// Returns the number of leaves in the tree.
+	std::size_t size() const;
+	
+private:
+	struct node
+	{
+		aabb<float> bounds;
+		value_type value;
+		proxy_type parent;
+		proxy_type children[2];
+		
+		bool is_leaf() const;
+	};
+	
+	/// Returns the surface area of an AABB.
+	static float area(const aabb<float>& bounds);
+	
+	/// Returns the union of two AABBs.
+	static aabb<float> merge(const aabb<float>& a, const aabb<float>& b);
+	
+	proxy_type allocate_node();
+	void free_node(proxy_type index);
+	void insert_leaf(proxy_type leaf);
+	void remove_leaf(proxy_type leaf);
+	
+	/// Recomputes the bounds of a node and its ancestors.
+	void refit(proxy_type index);
+	
+	template <class Test, class Function>
+	void traverse(Test&& test, Function&& function) const;
+	
+	std::vector<node> nodes;
+	proxy_type root;
+	proxy_type free_list;
+	std::size_t leaf_count;
+	float margin;
+};
+
+template <class T>
+aabb_tree<T>::aabb_tree(float margin):
+	root(null_proxy),
+	free_list(null_proxy),
+	leaf_count(0),
+	margin(margin)
+{}
+
+template <class T>
+typename aabb_tree<T>::proxy_type aabb_tree<T>::insert(const aabb<float>& bounds, const value_type& value)
+{
+	const proxy_type leaf = allocate_node();
+	const typename aabb<float>::vector_type enlargement = {margin, margin, margin};
+	nodes[leaf].bounds = {bounds.min_point - enlargement, bounds.max_point + enlargement};
+	nodes[leaf].value = value;
+	
+	insert_leaf(leaf);
+	++leaf_count;
+	
+	return leaf;
+}
+
+template <class T>
+void aabb_tree<T>::remove(proxy_type proxy)
+{
+	remove_leaf(proxy);
+	free_node(proxy);
+	--leaf_count;
+}
+
+template <class T>
+bool aabb_tree<T>::update(proxy_type proxy, const aabb<float>& bounds)
+{
+	if (nodes[proxy].bounds.contains(bounds))
+		return false;
+	
+	remove_leaf(proxy);
+	const typename aabb<float>::vector_type enlargement = {margin, margin, margin};
+	nodes[proxy].bounds = {bounds.min_point - enlargement, bounds.max_point + enlargement};
+	insert_leaf(proxy);
+	
+	return true;
+}
+
+template <class T>
+void aabb_tree<T>::clear()
+{
+	nodes.clear();
+	root = null_proxy;
+	free_list = null_proxy;
+	leaf_count = 0;
+}
+
+template <class T>
+template <class Function>
+void aabb_tree<T>::query(const aabb<float>& bounds, Function&& function) const
+{
+	traverse
+	(
+		[&bounds](const aabb<float>& node_bounds){return node_bounds.intersects(bounds);},
+		[&function](const value_type& value){function(value);}
+	);
+}
+
+template <class T>
+template <class Function>
+void aabb_tree<T>::query(const sphere<float>& bounds, Function&& function) const
+{
+	traverse
+	(
+		[&bounds](const aabb<float>& node_bounds){return node_bounds.intersects(bounds);},
+		[&function](const value_type& value){function(value);}
+	);
+}
+
+template <class T>
+template <class Function>
+void aabb_tree<T>::query(const convex_hull<float>& hull, Function&& function) const
+{
+	if (root == null_proxy)
+		return;
+	
+	query(packed_hull<float>(hull), function);
+}
+
+template <class T>
+template <class Function>
+void aabb_tree<T>::query(const packed_hull<float>& hull, Function&& function) const
+{
+	if (root == null_proxy)
+		return;
+	
+	// Planes beyond the width of the mask are tested against every node
+	const bool unmasked = hull.get_plane_count() > packed_hull<float>::mask_width;
+	
+	// Each node is paired with the mask of planes which its parent's bounds straddle
+	std::vector<std::pair<proxy_type, std::uint32_t>> stack;
+	stack.reserve(64);
+	stack.emplace_back(root, hull.get_full_mask());
+	
+	while (!stack.empty())
+	{
+		const node& current = nodes[stack.back().first];
+		std::uint32_t mask = stack.back().second;
+		stack.pop_back();
+		
+		// Descendants lie inside of the planes cleared from the mask too, so subtrees inside of every plane are reported without further tests
+		if ((mask || unmasked) && classify(hull, current.bounds, mask) == containment::outside)
+			continue;
+		
+		if (current.is_leaf())
+			function(current.value);
+		else
+		{
+			stack.emplace_back(current.children[0], mask);
+			stack.emplace_back(current.children[1], mask);
+		}
+	}
+}
+
+template <class T>
+template <class Function>
+void aabb_tree<T>::query(const ray<float>& ray, float max_t, Function&& function) const
+{
+	if (root == null_proxy)
+		return;
+	
+	std::vector<proxy_type> stack;
+	stack.reserve(64);
+	stack.push_back(root);
+	
+	while (!stack.empty())
+	{
+		const node& current = nodes[stack.back()];
+		stack.pop_back();
+		
+		auto [hit, t0, t1] = ray_aabb_intersection(ray, current.bounds);
+		if (!hit || t0 > max_t)
+			continue;
+		
+		if (current.is_leaf())
+			max_t = std::min(max_t, function(current.value, std::max(t0, 0.0f)));
+		else
+		{
+			stack.push_back(current.children[0]);
+			stack.push_back(current.children[1]);
+		}
+	}
+}
+
+template <class T>
+inline const typename aabb_tree<T>::value_type& aabb_tree<T>::get_value(proxy_type proxy) const
+{
+	return nodes[proxy].value;
+}
+
+template <class T>
+inline const aabb<float>& aabb_tree<T>::get_bounds(proxy_type proxy) const
+{
+	return nodes[proxy].bounds;
+}
+
+template <class T>
+inline std::size_t aabb_tree<T>::size() const
+{
+	return leaf_count;
+}
+
+template <class T>
+inline bool aabb_tree<T>::node::is_leaf() const
+{
+	return children[0] == null_proxy;
+}
+
+template <class T>
+inline float aabb_tree<T>::area(const aabb<float>& bounds)
+{
+	const typename aabb<float>::vector_type d = bounds.max_point - bounds.min_point;
+	return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+}
+
+template <class T>
+inline aabb<float> aabb_tree<T>::merge(const aabb<float>& a, const aabb<float>& b)
+{
+	return
+	{
+		{std::min(a.min_point.x, b.min_point.x), std::min(a.min_point.y, b.min_point.y), std::min(a.min_point.z, b.min_point.z)},
+		{std::max(a.max_point.x, b.max_point.x), std::max(a.max_point.y, b.max_point.y), std::max(a.max_point.z, b.max_point.z)}
+	};
+}
+
+template <class T>
+typename aabb_tree<T>::proxy_type aabb_tree<T>::allocate_node()
+{
+	proxy_type index;
+	if (free_list != null_proxy)
+	{
+		index = free_list;
+		free_list = nodes[index].parent;
+	}
+	else
+	{
+		index = static_cast<proxy_type>(nodes.size());
+		nodes.emplace_back();
+	}
+	
+	nodes[index].parent = null_proxy;
+	nodes[index].children[0] = null_proxy;
+	nodes[index].children[1] = null_proxy;
+	
+	return index;
+}
+
+template <class T>
+void aabb_tree<T>::free_node(proxy_type index)
+{
+	// Free nodes are linked through their parent index
+	nodes[index].parent = free_list;
+	free_list = index;
+}
+
+template <class T>
+void aabb_tree<T>::insert_leaf(proxy_type leaf)
+{
+	if (root == null_proxy)
+	{
+		root = leaf;
+		nodes[leaf].parent = null_proxy;
+		return;
+	}
+	
+	const aabb<float> leaf_bounds = nodes[leaf].bounds;
+	
+	// Descend towards the sibling which minimizes the increase in surface area
+	proxy_type sibling = root;
+	while (!nodes[sibling].is_leaf())
+	{
+		const node& current = nodes[sibling];
+		const float combined_area = area(merge(current.bounds, leaf_bounds));
+		
+		// Cost of pairing the leaf with this node
+		const float cost = 2.0f * combined_area;
+		
+		// Minimum cost of pushing the leaf further down the tree
+		const float inheritance_cost = 2.0f * (combined_area - area(current.bounds));
+		
+		float child_costs[2];
+		for (int i = 0; i < 2; ++i)
+		{
+			const node& child = nodes[current.children[i]];
+			const float merged_area = area(merge(child.bounds, leaf_bounds));
+			child_costs[i] = ((child.is_leaf()) ? merged_area : merged_area - area(child.bounds)) + inheritance_cost;
+		}
+		
+		if (cost < child_costs[0] && cost < child_costs[1])
+			break;
+		
+		sibling = current.children[(child_costs[0] <= child_costs[1]) ? 0 : 1];
+	}
+	
+	// Create a new parent for the sibling and the leaf
+	const proxy_type old_parent = nodes[sibling].parent;
+	const proxy_type new_parent = allocate_node();
+	nodes[new_parent].parent = old_parent;
+	nodes[new_parent].bounds = merge(leaf_bounds, nodes[sibling].bounds);
+	nodes[new_parent].children[0] = sibling;
+	nodes[new_parent].children[1] = leaf;
+	nodes[sibling].parent = new_parent;
+	nodes[leaf].parent = new_parent;
+	
+	if (old_parent == null_proxy)
+		root = new_parent;
+	else
+		nodes[old_parent].children[(nodes[old_parent].children[0] == sibling) ? 0 : 1] = new_parent;
+	
+	refit(old_parent);
+}
+
+template <class T>
+void aabb_tree<T>::remove_leaf(proxy_type leaf)
+{
+	if (leaf == root)
+	{
+		root = null_proxy;
+		return;
+	}
+	
+	// Replace the parent with the sibling
+	const proxy_type parent = nodes[leaf].parent;
+	const proxy_type grandparent = nodes[parent].parent;
+	const proxy_type sibling = nodes[parent].children[(nodes[parent].children[0] == leaf) ? 1 : 0];
+	
+	if (grandparent == null_proxy)
+	{
+		root = sibling;
+		nodes[sibling].parent = null_proxy;
+	}
+	else
+	{
+		nodes[grandparent].children[(nodes[grandparent].children[0] == parent) ? 0 : 1] = sibling;
+		nodes[sibling].parent = grandparent;
+		refit(grandparent);
+	}
+	
+	free_node(parent);
+}
+
+template <class T>
+void aabb_tree<T>::refit(proxy_type index)
+{
+	while (index != null_proxy)
+	{
+		node& current = nodes[index];
+		current.bounds = merge(nodes[current.children[0]].bounds, nodes[current.children[1]].bounds);
+		index = current.parent;
+	}
+}
+
+template <class T>
+template <class Test, class Function>
+void aabb_tree<T>::traverse(Test&& test, Function&& function) const
+{
+	if (root == null_proxy)
+		return;
+	
+	std::vector<proxy_type> stack;
+	stack.reserve(64);
+	stack.push_back(root);
+	
+	while (!stack.empty())
+	{
+		const node& current = nodes[stack.back()];
+		stack.pop_back();
+		
+		if (!test(current.bounds))
+			continue;
+		
+		if (current.is_leaf())
+			function(current.value);
+		else
+		{
+			stack.push_back(current.children[0]);
+			stack.push_back(current.children[1]);
+		}
+	}
+}
+
+} // namespace geom
+
+#endif // ANTKEEPER_GEOM_AABB_TREE_HPP
+
@@ -18,98 +18,473 @@
  */
 
 #include "csg.hpp"
-#include <tuple>
+#include "geom/aabb.hpp"
+#include "math/math.hpp"
+#include <algorithm>
+#include <limits>
+#include <utility>
 
 namespace geom {
 namespace csg {
 
-enum class polygon_classification
+/// Distance from a plane within which vertices are considered to lie on it.
+static constexpr float epsilon = 1e-5f;
+
+/// Bit flags of the sides of a partition on which the vertices of a polygon lie.
+enum: unsigned
+{
+	coplanar_side = 0,
+	front_side = 1,
+	back_side = 2,
+	spanning_sides = front_side | back_side
+};
+
+/// Scratch buffers reused by polygon splits.
+struct split_buffers
 {
-	coplanar,
-	front,
-	back,
-	spanning
+	std::vector<std::uint32_t> front_indices;
+	std::vector<std::uint32_t> back_indices;
 };
 
+static inline unsigned classify_distance(float distance)
+{
+	return (distance > epsilon) ? front_side : (distance < -epsilon) ? back_side : coplanar_side;
+}
+
 /**
  * Classifies a polygon relative to a partitioning plane.
  *
- * @param partition Partitioning plane relative to which the polygon should be classified.
+ * @param solid Solid containing the polygon.
  * @param poly Polygon to be classified.
- * @return Classification of the polygon, relative to the plane.
+ * @param partition Partitioning plane relative to which the polygon should be classified.
+ * @return Bit mask of the sides of the partition on which the vertices of the polygon lie.
  */
-static polygon_classification classify_polygon(const plane& partition, const polygon& poly)
+static unsigned classify_polygon(const solid& solid, const polygon& poly, const plane& partition)
 {
-	for (const float3& vertex: poly.vertices)
-	{
-		
-	}
-
-	return polygon_classification::coplanar;
+	unsigned sides = coplanar_side;
+	for (std::uint32_t i = poly.first_index; i < poly.first_index + poly.index_count; ++i)
+		sides |= classify_distance(math::dot(partition.normal, solid.vertices[solid.indices[i]]) - partition.distance);
+	return sides;
 }
 
 /**
- * Splits a polygon along a partitioning plane.
+ * Splits a polygon which spans a partitioning plane. The vertices and indices of the fragments are appended to the solid.
  *
+ * @param solid Solid containing the polygon.
  * @param poly Polygon to split.
  * @param partition Partitioning plane along which the polygon should be split.
- * @return List of polygons which were formed by splitting the specified polygon along the partitioning plane, along with their respective classifications relative to the partition.
+ * @param buffers Scratch buffers.
+ * @param[out] front Fragment in front of the partition.
+ * @param[out] back Fragment behind the partition.
+ * @return Bit mask of the non-degenerate fragments which were formed.
  */
-std::list<std::tuple<polygon, polygon_classification>> split_polygon(const polygon& poly, const plane& partition)
+static unsigned split_polygon(solid& solid, const polygon& poly, const plane& partition, split_buffers& buffers, polygon& front, polygon& back)
 {
-	return {};
+	buffers.front_indices.clear();
+	buffers.back_indices.clear();
+	
+	const std::uint32_t end = poly.first_index + poly.index_count;
+	for (std::uint32_t k = poly.first_index; k < end; ++k)
+	{
+		const std::uint32_t i = solid.indices[k];
+		const std::uint32_t j = solid.indices[(k + 1 < end) ? k + 1 : poly.first_index];
+		
+		// Copy vertices, as splitting the edge may reallocate the vertex array
+		const float3 vi = solid.vertices[i];
+		const float3 vj = solid.vertices[j];
+		const float di = math::dot(partition.normal, vi) - partition.distance;
+		const float dj = math::dot(partition.normal, vj) - partition.distance;
+		const unsigned ti = classify_distance(di);
+		const unsigned tj = classify_distance(dj);
+		
+		if (ti != back_side)
+			buffers.front_indices.push_back(i);
+		if (ti != front_side)
+			buffers.back_indices.push_back(i);
+		
+		if ((ti | tj) == spanning_sides)
+		{
+			const std::uint32_t index = static_cast<std::uint32_t>(solid.vertices.size());
+			solid.vertices.push_back(vi + (vj - vi) * (di / (di - dj)));
+			buffers.front_indices.push_back(index);
+			buffers.back_indices.push_back(index);
+		}
+	}
+	
+	unsigned fragments = 0;
+	if (buffers.front_indices.size() >= 3)
+	{
+		front = poly;
+		front.first_index = static_cast<std::uint32_t>(solid.indices.size());
+		front.index_count = static_cast<std::uint32_t>(buffers.front_indices.size());
+		solid.indices.insert(solid.indices.end(), buffers.front_indices.begin(), buffers.front_indices.end());
+		fragments |= front_side;
+	}
+	if (buffers.back_indices.size() >= 3)
+	{
+		back = poly;
+		back.first_index = static_cast<std::uint32_t>(solid.indices.size());
+		back.index_count = static_cast<std::uint32_t>(buffers.back_indices.size());
+		solid.indices.insert(solid.indices.end(), buffers.back_indices.begin(), buffers.back_indices.end());
+		fragments |= back_side;
+	}
+	
+	return fragments;
 }
 
+/// Calculates the bounds of the vertices of a solid.
+static geom::aabb<float> calculate_bounds(const solid& solid)
+{
+	const float inf = std::numeric_limits<float>::infinity();
+	geom::aabb<float> bounds = {{inf, inf, inf}, {-inf, -inf, -inf}};
+	for (const float3& vertex: solid.vertices)
+	{
+		for (int i = 0; i < 3; ++i)
+		{
+			bounds.min_point[i] = std::min(bounds.min_point[i], vertex[i]);
+			bounds.max_point[i] = std::max(bounds.max_point[i], vertex[i]);
+		}
+	}
+	return bounds;
+}
 
-bsp_tree::bsp_tree(const std::list<polygon>& polygons):
-	front(nullptr),
-	back(nullptr)
+/// Returns `true` if two bounding boxes overlap or touch.
+static bool overlap(const geom::aabb<float>& a, const geom::aabb<float>& b)
 {
-	//partition = polygons.front();
+	for (int i = 0; i < 3; ++i)
+	{
+		if (a.min_point[i] > b.max_point[i] + epsilon || b.min_point[i] > a.max_point[i] + epsilon)
+			return false;
+	}
+	return true;
+}
 
-	std::list<polygon> front_polygons;
-	std::list<polygon> back_polygons;
+/**
+ * Appends the polygons of a solid to another solid, copying only the vertices which the polygons reference.
+ *
+ * @param result Solid to which polygons should be appended.
+ * @param solid Solid containing the polygons to append.
+ * @param remap Scratch buffer for vertex indices.
+ */
+static void append(geom::csg::solid& result, const geom::csg::solid& solid, std::vector<std::uint32_t>& remap)
+{
+	const std::uint32_t null_index = ~std::uint32_t(0);
+	remap.assign(solid.vertices.size(), null_index);
+	
+	for (const polygon& poly: solid.polygons)
+	{
+		polygon copy = poly;
+		copy.first_index = static_cast<std::uint32_t>(result.indices.size());
+		for (std::uint32_t i = poly.first_index; i < poly.first_index + poly.index_count; ++i)
+		{
+			std::uint32_t& index = remap[solid.indices[i]];
+			if (index == null_index)
+			{
+				index = static_cast<std::uint32_t>(result.vertices.size());
+				result.vertices.push_back(solid.vertices[solid.indices[i]]);
+			}
+			result.indices.push_back(index);
+		}
+		result.polygons.push_back(copy);
+	}
+}
 
-	// Classify all polygons relative to this node's partitioning plane
-	for (const polygon& p: polygons)
+/**
+ * Merges solids into their union, by clipping the polygons of each solid to the BSP trees of all others. Of coincident polygons facing the same way, only those of the first solid are kept.
+ *
+ * @param operands Solids to be merged.
+ * @param count Number of solids.
+ * @param inverted_count Number of leading solids which are inverted before merging.
+ * @return Union of the solids.
+ */
+static solid merge(const solid* const* operands, std::size_t count, std::size_t inverted_count)
+{
+	std::vector<bsp_tree> trees(count);
+	std::vector<geom::aabb<float>> bounds(count);
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		trees[i].build(*operands[i]);
+		if (i < inverted_count)
+			trees[i].invert();
+		bounds[i] = calculate_bounds(*operands[i]);
+	}
+	
+	solid result;
+	solid fragments;
+	std::vector<std::uint32_t> remap;
+	for (std::size_t i = 0; i < count; ++i)
 	{
-		polygon_classification classification = classify_polygon(partition, p);
-		switch (classification)
+		fragments = *operands[i];
+		if (i < inverted_count)
+			fragments.invert();
+		
+		for (std::size_t j = 0; j < count && !fragments.polygons.empty(); ++j)
 		{
-			case polygon_classification::coplanar:
-				coplanar_polygons.push_back(p);
-				break;
+			if (j == i)
+				continue;
+			
+			if (!overlap(bounds[i], bounds[j]))
+			{
+				// Disjoint solids don't clip each other, unless inverted, in which case they contain everything outside their bounds
+				if (j < inverted_count)
+					fragments.polygons.clear();
+				continue;
+			}
+			
+			trees[j].clip(fragments, i < j);
+		}
+		
+		append(result, fragments, remap);
+	}
+	
+	return result;
+}
+
+void solid::add_polygon(const float3* positions, std::size_t count, void* shared)
+{
+	if (count < 3)
+		return;
+	
+	// Calculate plane normal and centroid with Newell's method
+	float3 normal = {0.0f, 0.0f, 0.0f};
+	float3 centroid = {0.0f, 0.0f, 0.0f};
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		const float3& a = positions[i];
+		const float3& b = positions[(i + 1) % count];
+		normal[0] += (a[1] - b[1]) * (a[2] + b[2]);
+		normal[1] += (a[2] - b[2]) * (a[0] + b[0]);
+		normal[2] += (a[0] - b[0]) * (a[1] + b[1]);
+		centroid += a;
+	}
+	
+	// Discard degenerate polygons
+	const float length = math::length(normal);
+	if (length <= 0.0f)
+		return;
+	normal /= length;
+	centroid /= static_cast<float>(count);
+	
+	polygon poly;
+	poly.first_index = static_cast<std::uint32_t>(indices.size());
+	poly.index_count = static_cast<std::uint32_t>(count);
+	poly.support = {normal, math::dot(normal, centroid)};
+	poly.shared = shared;
+	
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		indices.push_back(static_cast<std::uint32_t>(vertices.size()));
+		vertices.push_back(positions[i]);
+	}
+	polygons.push_back(poly);
+}
 
-			case polygon_classification::front:
-				front_polygons.push_back(p);
-				break;
+void solid::invert()
+{
+	for (polygon& poly: polygons)
+	{
+		std::reverse(indices.begin() + poly.first_index, indices.begin() + poly.first_index + poly.index_count);
+		poly.support.normal = -poly.support.normal;
+		poly.support.distance = -poly.support.distance;
+	}
+}
+
+void solid::clear()
+{
+	vertices.clear();
+	indices.clear();
+	polygons.clear();
+}
+
+bsp_tree::bsp_tree()
+{}
 
-			case polygon_classification::back:
-				back_polygons.push_back(p);
-				break;
+bsp_tree::bsp_tree(const solid& solid)
+{
+	build(solid);
+}
 
-			case polygon_classification::spanning:
-				break;
+void bsp_tree::build(const geom::csg::solid& solid)
+{
+	nodes.clear();
+	if (solid.polygons.empty())
+		return;
+	
+	// Polygons are split within a copy of the solid, to which the polygons of each subtree are appended as a contiguous range
+	geom::csg::solid work = solid;
+	split_buffers buffers;
+	std::vector<polygon> front_polygons;
+	std::vector<polygon> back_polygons;
+	
+	struct subtree
+	{
+		std::uint32_t node;
+		std::size_t begin;
+		std::size_t end;
+	};
+	std::vector<subtree> stack;
+	
+	// The partition of each node is the plane of the first polygon of its subtree
+	nodes.push_back({work.polygons.front().support, null_node, null_node});
+	stack.push_back({0, 0, work.polygons.size()});
+	
+	while (!stack.empty())
+	{
+		const subtree s = stack.back();
+		stack.pop_back();
+		const plane partition = nodes[s.node].partition;
+		
+		// Classify all polygons relative to this node's partitioning plane. Coplanar polygons belong to this node, including the polygon which defines the partition.
+		front_polygons.clear();
+		back_polygons.clear();
+		for (std::size_t i = s.begin + 1; i < s.end; ++i)
+		{
+			const polygon poly = work.polygons[i];
+			const unsigned sides = classify_polygon(work, poly, partition);
+			if (sides == front_side)
+			{
+				front_polygons.push_back(poly);
+			}
+			else if (sides == back_side)
+			{
+				back_polygons.push_back(poly);
+			}
+			else if (sides == spanning_sides)
+			{
+				polygon front;
+				polygon back;
+				const unsigned fragments = split_polygon(work, poly, partition, buffers, front, back);
+				if (fragments & front_side)
+					front_polygons.push_back(front);
+				if (fragments & back_side)
+					back_polygons.push_back(back);
+			}
+		}
+		
+		// Make subtrees containing all polygons in front of and behind this node's plane
+		for (std::vector<polygon>* polygons: {&front_polygons, &back_polygons})
+		{
+			if (polygons->empty())
+				continue;
+			
+			const std::uint32_t child = static_cast<std::uint32_t>(nodes.size());
+			nodes.push_back({polygons->front().support, null_node, null_node});
+			if (polygons == &front_polygons)
+				nodes[s.node].front = child;
+			else
+				nodes[s.node].back = child;
+			
+			const std::size_t begin = work.polygons.size();
+			work.polygons.insert(work.polygons.end(), polygons->begin(), polygons->end());
+			stack.push_back({child, begin, work.polygons.size()});
 		}
 	}
+}
 
-	if (!front_polygons.empty())
+void bsp_tree::invert()
+{
+	for (node& n: nodes)
 	{
-		// Make subtree containing all polygons in front of this node's plane
-		front = new bsp_tree(front_polygons);
+		n.partition.normal = -n.partition.normal;
+		n.partition.distance = -n.partition.distance;
+		std::swap(n.front, n.back);
 	}
+}
 
-	if (!back_polygons.empty())
+void bsp_tree::clip(geom::csg::solid& solid, bool keep_coplanar) const
+{
+	if (nodes.empty())
+		return;
+	
+	split_buffers buffers;
+	std::vector<polygon> kept;
+	std::vector<std::pair<std::uint32_t, polygon>> stack;
+	kept.reserve(solid.polygons.size());
+	
+	for (const polygon& poly: solid.polygons)
 	{
-		// Make subtree containing all polygons behind this node's plane
-		back = new bsp_tree(back_polygons);
+		stack.emplace_back(0, poly);
+		while (!stack.empty())
+		{
+			const std::uint32_t index = stack.back().first;
+			const polygon p = stack.back().second;
+			stack.pop_back();
+			
+			const node& n = nodes[index];
+			polygon front = p;
+			polygon back = p;
+			unsigned sides = classify_polygon(solid, p, n.partition);
+			if (sides == coplanar_side)
+			{
+				sides = (keep_coplanar && math::dot(n.partition.normal, p.support.normal) > 0.0f) ? front_side : back_side;
+			}
+			else if (sides == spanning_sides)
+			{
+				sides = split_polygon(solid, p, n.partition, buffers, front, back);
+			}
+			
+			// Polygons in front of a leaf are outside of the solid, while polygons behind a leaf are inside of it
+			if (sides & front_side)
+			{
+				if (n.front != null_node)
+					stack.emplace_back(n.front, front);
+				else
+					kept.push_back(front);
+			}
+			if ((sides & back_side) && n.back != null_node)
+			{
+				stack.emplace_back(n.back, back);
+			}
+		}
 	}
+	
+	solid.polygons.swap(kept);
+}
+
+solid op_union(const solid& a, const solid& b)
+{
+	const solid* operands[] = {&a, &b};
+	return merge(operands, 2, 0);
+}
+
+solid op_difference(const solid& a, const solid& b)
+{
+	// a - b = ~(~a | b)
+	const solid* operands[] = {&a, &b};
+	solid result = merge(operands, 2, 1);
+	result.invert();
+	return result;
+}
+
+solid op_intersect(const solid& a, const solid& b)
+{
+	// a & b = ~(~a | ~b)
+	const solid* operands[] = {&a, &b};
+	solid result = merge(operands, 2, 2);
+	result.invert();
+	return result;
+}
+
+solid op_union(const std::vector<solid>& solids)
+{
+	std::vector<const solid*> operands;
+	operands.reserve(solids.size());
+	for (const solid& s: solids)
+		operands.push_back(&s);
+	return merge(operands.data(), operands.size(), 0);
 }
 
-bsp_tree::~bsp_tree()
+solid op_difference(const solid& a, const std::vector<solid>& b)
 {
-	delete front;
-	delete back;
+	// a - (b0 | b1 | ...) = ~(~a | b0 | b1 | ...)
+	std::vector<const solid*> operands;
+	operands.reserve(b.size() + 1);
+	operands.push_back(&a);
+	for (const solid& s: b)
+		operands.push_back(&s);
+	solid result = merge(operands.data(), operands.size(), 1);
+	result.invert();
+	return result;
 }
 
 } // namespace csg
@@ -21,68 +21,168 @@
 #define ANTKEEPER_GEOM_CSG_HPP
 
 #include "utility/fundamental-types.hpp"
-#include <list>
+#include <cstdint>
+#include <vector>
 
 namespace geom {
 
 /// Constructive solid geometry (CSG)
 namespace csg {
 
+/**
+ * Plane, defined by the points `p` for which `dot(normal, p) == distance`.
+ */
 struct plane
 {
 	float3 normal;
 	float distance;
 };
 
+/**
+ * Convex polygon, whose vertices are a range of the indices of a solid.
+ */
 struct polygon
 {
-	std::list<float3> vertices;
+	/// Offset of the first vertex index of the polygon.
+	std::uint32_t first_index;
+	
+	/// Number of vertices of the polygon.
+	std::uint32_t index_count;
+	
+	/// Plane in which the polygon lies.
+	plane support;
+	
+	/// User data, copied to every fragment into which the polygon is split.
 	void* shared;
 };
 
 /**
- * 3D solid represented by a collection of polygons.
+ * 3D solid represented by a collection of convex polygons, stored in flat arrays. Polygons split by CSG operations append their new vertices and indices, so no memory is allocated per polygon.
  */
-typedef std::list<polygon> solid;
+struct solid
+{
+	/// Vertex positions.
+	std::vector<float3> vertices;
+	
+	/// Vertex indices of all polygons.
+	std::vector<std::uint32_t> indices;
+	
+	/// Polygons, each referencing a range of the vertex indices.
+	std::vector<polygon> polygons;
+	
+	/**
+	 * Adds a convex polygon to the solid. The supporting plane of the polygon is calculated with Newell's method, and faces the side from which the vertices appear counterclockwise.
+	 *
+	 * @param positions Array of polygon vertex positions.
+	 * @param count Number of polygon vertices.
+	 * @param shared User data of the polygon.
+	 */
+	void add_polygon(const float3* positions, std::size_t count, void* shared = nullptr);
+	
+	/// Turns the solid inside out, by reversing the winding and supporting plane of each polygon.
+	void invert();
+	
+	/// Removes all vertices and polygons from the solid, keeping their memory.
+	void clear();
+};
 
 /**
- * BSP tree node.
+ * BSP tree of the partitioning planes of a solid. Nodes are allocated from a single arena and reference their children by index.
+ *
+ * A point is inside the solid if it lies behind a node without a back child.
  */
 class bsp_tree
 {
 public:
+	/// Constructs an empty BSP tree.
+	bsp_tree();
+	
 	/**
-	 * Recursively constructs a BSP tree from a collection of polygons.
+	 * Constructs a BSP tree from the polygons of a solid.
 	 *
-	 * @param polygons Collection of polygons from which to create the BSP tree.
+	 * @param solid Solid from which to create the BSP tree.
 	 */
-	explicit bsp_tree(const std::list<polygon>& polygons);
-
+	explicit bsp_tree(const solid& solid);
+	
 	/**
-	 * Destroys a BSP tree.
+	 * Rebuilds the BSP tree from the polygons of a solid, reusing the node arena.
+	 *
+	 * @param solid Solid from which to create the BSP tree.
+	 */
+	void build(const solid& solid);
+	
+	/// Inverts the tree, such that it partitions the complement of its solid.
+	void invert();
+	
+	/**
+	 * Removes the parts of the polygons of a solid which lie inside the solid of this tree. Split polygons append their fragments to the vertex and index arrays of the clipped solid.
+	 *
+	 * @param solid Solid to be clipped.
+	 * @param keep_coplanar If `true`, polygons coplanar with and facing the same way as a partition are treated as being in front of it. Otherwise all coplanar polygons are treated as being behind their partitions.
 	 */
-	~bsp_tree();
+	void clip(solid& solid, bool keep_coplanar) const;
+	
+	/// Returns `true` if the tree has no nodes.
+	bool empty() const;
 
 private:
-	/// Partition which separates the front and back polygons.
-	plane partition;
-
-	/// Set of polygons which are coplanar with the partition.
-	std::list<polygon> coplanar_polygons;
-
-	/// Subtree containing all polygons in front of the partition.
-	bsp_tree* front;
-
-	/// Subtree containing all polygons behind the partition.
-	bsp_tree* back;
+	/// Index of a missing child node.
+	static constexpr std::uint32_t null_node = ~std::uint32_t(0);
+	
+	struct node
+	{
+		/// Partition which separates the front and back subtrees.
+		plane partition;
+		
+		/// Index of the subtree containing all polygons in front of the partition.
+		std::uint32_t front;
+		
+		/// Index of the subtree containing all polygons behind the partition.
+		std::uint32_t back;
+	};
+	
+	/// Arena of nodes, the first of which is the root.
+	std::vector<node> nodes;
 };
 
+inline bool bsp_tree::empty() const
+{
+	return nodes.empty();
+}
+
+/**
+ * Returns the union of two solids.
+ */
 solid op_union(const solid& a, const solid& b);
+
+/**
+ * Returns the difference of two solids.
+ */
 solid op_difference(const solid& a, const solid& b);
+
+/**
+ * Returns the intersection of two solids.
+ */
 solid op_intersect(const solid& a, const solid& b);
 
+/**
+ * Returns the union of many solids. The BSP tree of each solid is built only once, and solids whose bounds are disjoint are not clipped against each other.
+ *
+ * @param solids Solids to be merged.
+ * @return Union of the solids.
+ */
+solid op_union(const std::vector<solid>& solids);
+
+/**
+ * Subtracts many solids from a solid, with a single BSP tree built per solid.
+ *
+ * @param a Solid from which to subtract.
+ * @param b Solids to be subtracted.
+ * @return Difference of @p a and the union of the solids of @p b.
+ */
+solid op_difference(const solid& a, const std::vector<solid>& b);
+
 } // namespace csg
 } // namespace geom
 
 #endif // ANTKEEPER_GEOM_CSG_HPP
-
@@ -24,6 +24,7 @@
 namespace geom {}
 
 #include "aabb.hpp"
+#include "aabb-tree.hpp"
 #include "bounding-volume.hpp"
 #include "convex-hull.hpp"
 #include "cartesian.hpp"
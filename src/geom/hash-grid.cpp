@@ -0,0 +1,108 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "geom/hash-grid.hpp"
+#include "utility/job-system.hpp"
+#include <algorithm>
+
+namespace geom {
+
+hash_grid::hash_grid(float cell_size, std::size_t bucket_count):
+	cell_size(cell_size),
+	inverse_cell_size(1.0f / cell_size)
+{
+	std::uint32_t rounded_count = 1;
+	while (rounded_count < bucket_count)
+		rounded_count <<= 1;
+	bucket_mask = rounded_count - 1;
+	bucket_offsets.assign(rounded_count + 1, 0);
+}
+
+void hash_grid::build(const float3* positions, std::size_t count, job_system* jobs)
+{
+	const std::size_t bucket_count = bucket_mask + 1;
+	
+	point_buckets.resize(count);
+	sorted_indices.resize(count);
+	sorted_positions.resize(count);
+	sorted_keys.resize(count);
+	
+	// Split the points into one range per thread, each with its own bucket counts
+	const std::size_t range_count = std::max<std::size_t>(1, std::min(count / 1024, (jobs) ? jobs->get_thread_count() + 1 : 1));
+	const std::size_t grain = (count + range_count - 1) / range_count;
+	range_offsets.assign(range_count * bucket_count, 0);
+	
+	auto run = [&](auto&& function)
+	{
+		if (jobs && range_count > 1)
+			jobs->parallel_for(0, count, grain, function);
+		else
+			function(0, count);
+	};
+	
+	// Hash and count the points of each range
+	run
+	(
+		[&](std::size_t first, std::size_t last)
+		{
+			std::uint32_t* counts = range_offsets.data() + (first / grain) * bucket_count;
+			for (std::size_t i = first; i < last; ++i)
+			{
+				const float3& position = positions[i];
+				const std::uint32_t bucket = get_bucket(get_cell(position.x), get_cell(position.y), get_cell(position.z));
+				point_buckets[i] = bucket;
+				++counts[bucket];
+			}
+		}
+	);
+	
+	// Prefix sum the counts, bucket-major then range, into the offset of each range within each bucket
+	std::uint32_t offset = 0;
+	for (std::size_t bucket = 0; bucket < bucket_count; ++bucket)
+	{
+		bucket_offsets[bucket] = offset;
+		for (std::size_t range = 0; range < range_count; ++range)
+		{
+			std::uint32_t& range_offset = range_offsets[range * bucket_count + bucket];
+			const std::uint32_t range_bucket_count = range_offset;
+			range_offset = offset;
+			offset += range_bucket_count;
+		}
+	}
+	bucket_offsets[bucket_count] = offset;
+	
+	// Scatter the points of each range into their buckets
+	run
+	(
+		[&](std::size_t first, std::size_t last)
+		{
+			std::uint32_t* offsets = range_offsets.data() + (first / grain) * bucket_count;
+			for (std::size_t i = first; i < last; ++i)
+			{
+				const float3& position = positions[i];
+				const std::uint32_t j = offsets[point_buckets[i]]++;
+				sorted_indices[j] = static_cast<std::uint32_t>(i);
+				sorted_positions[j] = position;
+				sorted_keys[j] = get_cell_key(get_cell(position.x), get_cell(position.y), get_cell(position.z));
+			}
+		}
+	);
+}
+
+} // namespace geom
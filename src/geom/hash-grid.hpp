@@ -0,0 +1,165 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ANTKEEPER_GEOM_HASH_GRID_HPP
+#define ANTKEEPER_GEOM_HASH_GRID_HPP
+
+#include "utility/fundamental-types.hpp"
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class job_system;
+
+namespace geom {
+
+/**
+ * Uniform grid spatial hash over a set of points, rebuilt from scratch whenever the points move, for radius queries over large numbers of moving agents.
+ *
+ * Points are hashed by their cells into a fixed table of buckets, then counting sorted by bucket, so each bucket's points lie contiguously and a rebuild costs O(n) with no per-cell allocations. Each sorted point keeps the key of its cell, so cells which share a bucket are told apart during queries. Rebuilds may be split across a job system, with each range counting and scattering its own points.
+ */
+class hash_grid
+{
+public:
+	/**
+	 * Creates an empty hash grid.
+	 *
+	 * @param cell_size Width of the grid cells, ideally the most common query radius.
+	 * @param bucket_count Number of buckets in the hash table, rounded up to a power of two.
+	 */
+	explicit hash_grid(float cell_size, std::size_t bucket_count = 4096);
+	
+	/**
+	 * Replaces the points of the grid.
+	 *
+	 * @param positions Array of point positions.
+	 * @param count Number of points.
+	 * @param jobs Job system on which to rebuild in parallel, or `nullptr`.
+	 */
+	void build(const float3* positions, std::size_t count, job_system* jobs = nullptr);
+	
+	/**
+	 * Calls a function with each point within a radius of a position.
+	 *
+	 * @param center Center of the query sphere.
+	 * @param radius Radius of the query sphere.
+	 * @param function Function with the signature `void(std::uint32_t index, const float3& position)`, where `index` is the index of the point in the array from which the grid was built.
+	 */
+	template <class Function>
+	void query(const float3& center, float radius, Function&& function) const;
+	
+	/// Returns the width of the grid cells.
+	float get_cell_size() const;
+	
+	/// Returns the number of points in the grid.
+	std::size_t size() const;
+	
+private:
+	/// Returns the coordinate of the cell containing a coordinate along one axis.
+	std::int32_t get_cell(float x) const;
+	
+	/// Packs cell coordinates into a key, 21 bits per axis.
+	static std::uint64_t get_cell_key(std::int32_t x, std::int32_t y, std::int32_t z);
+	
+	/// Returns the bucket of a cell.
+	std::uint32_t get_bucket(std::int32_t x, std::int32_t y, std::int32_t z) const;
+	
+	float cell_size;
+	float inverse_cell_size;
+	std::uint32_t bucket_mask;
+	
+	/// Offsets of the first point of each bucket in the sorted arrays, followed by the point count.
+	std::vector<std::uint32_t> bucket_offsets;
+	
+	/// Point indices, positions, and cell keys, sorted by bucket.
+	std::vector<std::uint32_t> sorted_indices;
+	std::vector<float3> sorted_positions;
+	std::vector<std::uint64_t> sorted_keys;
+	
+	/// Bucket of each unsorted point, and per-range bucket counts which become per-range scatter offsets.
+	std::vector<std::uint32_t> point_buckets;
+	std::vector<std::uint32_t> range_offsets;
+};
+
+template <class Function>
+void hash_grid::query(const float3& center, float radius, Function&& function) const
+{
+	if (sorted_indices.empty())
+		return;
+	
+	const float radius_squared = radius * radius;
+	const std::int32_t min_x = get_cell(center.x - radius), max_x = get_cell(center.x + radius);
+	const std::int32_t min_y = get_cell(center.y - radius), max_y = get_cell(center.y + radius);
+	const std::int32_t min_z = get_cell(center.z - radius), max_z = get_cell(center.z + radius);
+	
+	for (std::int32_t z = min_z; z <= max_z; ++z)
+	{
+		for (std::int32_t y = min_y; y <= max_y; ++y)
+		{
+			for (std::int32_t x = min_x; x <= max_x; ++x)
+			{
+				const std::uint64_t key = get_cell_key(x, y, z);
+				const std::uint32_t bucket = get_bucket(x, y, z);
+				const std::uint32_t last = bucket_offsets[bucket + 1];
+				for (std::uint32_t i = bucket_offsets[bucket]; i < last; ++i)
+				{
+					if (sorted_keys[i] != key)
+						continue;
+					
+					const float3& position = sorted_positions[i];
+					const float3 difference = position - center;
+					if (math::dot(difference, difference) <= radius_squared)
+						function(sorted_indices[i], position);
+				}
+			}
+		}
+	}
+}
+
+inline float hash_grid::get_cell_size() const
+{
+	return cell_size;
+}
+
+inline std::size_t hash_grid::size() const
+{
+	return sorted_indices.size();
+}
+
+inline std::int32_t hash_grid::get_cell(float x) const
+{
+	return static_cast<std::int32_t>(std::floor(x * inverse_cell_size));
+}
+
+inline std::uint64_t hash_grid::get_cell_key(std::int32_t x, std::int32_t y, std::int32_t z)
+{
+	constexpr std::uint64_t mask = (std::uint64_t(1) << 21) - 1;
+	return (static_cast<std::uint64_t>(x) & mask) | ((static_cast<std::uint64_t>(y) & mask) << 21) | ((static_cast<std::uint64_t>(z) & mask) << 42);
+}
+
+inline std::uint32_t hash_grid::get_bucket(std::int32_t x, std::int32_t y, std::int32_t z) const
+{
+	const std::uint32_t hash = (static_cast<std::uint32_t>(x) * 73856093u) ^ (static_cast<std::uint32_t>(y) * 19349663u) ^ (static_cast<std::uint32_t>(z) * 83492791u);
+	return hash & bucket_mask;
+}
+
+} // namespace geom
+
+#endif // ANTKEEPER_GEOM_HASH_GRID_HPP
@@ -20,16 +20,29 @@
 #ifndef ANTKEEPER_GEOM_HYPEROCTREE_HPP
 #define ANTKEEPER_GEOM_HYPEROCTREE_HPP
 
+#include <algorithm>
 #include <cstdint>
 #include <limits>
 #include <type_traits>
 #include <unordered_set>
-#include <stack>
+#include <vector>
 
 namespace geom {
 
+/// Node storage of a hyperoctree.
+enum class hyperoctree_storage
+{
+	/// Nodes are stored in a hash set, with constant-time insertion, erasure, and lookup.
+	hashed,
+	
+	/**
+	 * Nodes are stored in a sorted contiguous array. Because the node encoding places the location above the depth, numerical order is z-order with parents before their children, so z-order iteration is a linear scan. Lookup takes logarithmic time, while insertion and erasure take linear time, and are best done in bulk.
+	 */
+	linear
+};
+
 /**
- * Hashed linear hyperoctree.
+ * Linear hyperoctree, with nodes identified by their depth and Morton code location.
  *
  * @see http://codervil.blogspot.com/2015/10/octree-node-identifiers.html
  * @see https://geidav.wordpress.com/2014/08/18/advanced-octrees-2-node-representations/
@@ -60,8 +73,9 @@ namespace geom {
  * @see https://oeis.org/A178420
  *
  * @tparam T Integer node type.
+ * @tparam S Node storage.
  */
-template <std::size_t N, std::size_t D, class T>
+template <std::size_t N, std::size_t D, class T, hyperoctree_storage S = hyperoctree_storage::hashed>
 class hyperoctree
 {
 private:
@@ -98,9 +112,20 @@ public:
 	
 	/// Root node which is always guaranteed to exist.
 	static constexpr node_type root = 0;
-
+	
+	/// Maximum number of pending nodes during a depth-first traversal: the unvisited siblings at each depth, plus the current node.
+	static constexpr std::size_t traversal_capacity = max_depth * siblings_per_node + 1;
+	
+	/// Node storage.
+	static constexpr hyperoctree_storage storage = S;
+	
+private:
+	/// Node container type.
+	typedef typename std::conditional<S == hyperoctree_storage::linear, std::vector<node_type>, std::unordered_set<node_type>>::type container_type;
+	
+public:
 	/**
-	 * Accesses nodes in their internal hashmap order.
+	 * Accesses nodes in their internal storage order, which is z-order for linear storage.
 	 */
 	struct unordered_iterator
 	{
@@ -113,29 +138,31 @@ public:
 		inline node_type operator*() const { return *this->set_iterator; };
 	private:
 		friend class hyperoctree;
-		inline explicit unordered_iterator(const typename std::unordered_set<node_type>::const_iterator& it): set_iterator(it) {};
-		typename std::unordered_set<node_type>::const_iterator set_iterator;
+		inline explicit unordered_iterator(const typename container_type::const_iterator& it): set_iterator(it) {};
+		typename container_type::const_iterator set_iterator;
 	};
 
 	/**
-	 * Accesses nodes in z-order.
-	 *
-	 * @TODO Can this be implemented without a stack?
+	 * Accesses the nodes of a hashed hyperoctree in z-order, by depth-first traversal with a fixed-capacity stack.
 	 */
-	struct iterator
+	struct stack_iterator
 	{
-		inline iterator(const iterator& other): hyperoctree(other.hyperoctree), stack(other.stack) {};
-		inline iterator& operator=(const iterator& other) { this->hyperoctree = other.hyperoctree; this->stack = other.stack; return *this; };
-		iterator& operator++();
-		inline bool operator==(const iterator& other) const { return **this == *other; };
-		inline bool operator!=(const iterator& other) const { return **this != *other; };
-		inline node_type operator*() const { return stack.top(); };
+		inline stack_iterator(const stack_iterator& other): tree(other.tree), stack_size(other.stack_size) { std::copy(other.stack, other.stack + other.stack_size, stack); };
+		inline stack_iterator& operator=(const stack_iterator& other) { this->tree = other.tree; this->stack_size = other.stack_size; std::copy(other.stack, other.stack + other.stack_size, stack); return *this; };
+		stack_iterator& operator++();
+		inline bool operator==(const stack_iterator& other) const { return **this == *other; };
+		inline bool operator!=(const stack_iterator& other) const { return **this != *other; };
+		inline node_type operator*() const { return stack[stack_size - 1]; };
 	private:
 		friend class hyperoctree;
-		inline explicit iterator(const hyperoctree* hyperoctree, node_type node): hyperoctree(hyperoctree), stack({node}) {};
-		const hyperoctree* hyperoctree;
-		std::stack<node_type> stack;
+		inline explicit stack_iterator(const hyperoctree* tree, node_type node): tree(tree), stack{node}, stack_size(1) {};
+		const hyperoctree* tree;
+		node_type stack[traversal_capacity];
+		std::size_t stack_size;
 	};
+	
+	/// Z-order iterator, which for linear storage is the storage order itself.
+	typedef typename std::conditional<S == hyperoctree_storage::linear, unordered_iterator, stack_iterator>::type iterator;
 
 	/**
 	 * Returns the depth of a node.
@@ -229,6 +256,15 @@ public:
 	 * @param node Node to insert.
 	 */
 	void insert(node_type node);
+	
+	/**
+	 * Inserts a range of nodes, as if by inserting each node. Linear storage is merged and sorted only once.
+	 *
+	 * @param first Iterator to the first node to insert.
+	 * @param last Iterator past the last node to insert.
+	 */
+	template <class InputIt>
+	void insert(InputIt first, InputIt last);
 
 	/**
 	 * Erases a node along with its siblings and descendants. Note: The root node is persistent and cannot be erased.
@@ -236,6 +272,15 @@ public:
 	 * @param node Node to erase.
 	 */
 	void erase(node_type node);
+	
+	/**
+	 * Erases a range of nodes, as if by erasing each node. Linear storage is compacted only once.
+	 *
+	 * @param first Iterator to the first node to erase.
+	 * @param last Iterator past the last node to erase.
+	 */
+	template <class InputIt>
+	void erase(InputIt first, InputIt last);
 
 	/**
 	 * Erases all nodes except the root.
@@ -250,6 +295,31 @@ public:
 
 	/// Returns the number of nodes in the hyperoctree.
 	std::size_t size() const;
+	
+	/**
+	 * Visits nodes depth-first in z-order, without allocating.
+	 *
+	 * @param visitor Function object with the signature `bool(node_type)`, called on each visited node. The children of a node are only visited if the visitor returns `true`.
+	 */
+	template <class Visitor>
+	void visit(Visitor visitor) const;
+	
+	/**
+	 * Calls a function on each leaf node in z-order, without allocating.
+	 *
+	 * @param function Function object with the signature `void(node_type)`, called on each leaf.
+	 * @param predicate Function object with the signature `bool(node_type)`. Nodes for which the predicate returns `false` are pruned along with their descendants.
+	 */
+	template <class Function, class Predicate>
+	void for_each_leaf(Function function, Predicate predicate) const;
+	
+	/**
+	 * Calls a function on each leaf node in z-order, without allocating.
+	 *
+	 * @param function Function object with the signature `void(node_type)`, called on each leaf.
+	 */
+	template <class Function>
+	void for_each_leaf(Function function) const;
 
 private:
 	/// Compile-time pow()
@@ -257,72 +327,80 @@ private:
 
 	/// Count leading zeros
 	static T clz(T x);
+	
+	/// Returns `true` if a node is a strict descendant of another node.
+	static bool is_descendant(node_type node, node_type ancestor);
+	
+	/// Appends a node, its siblings, and the sibling groups of its ancestors to a list, stopping at the first ancestor which is already contained.
+	void expand(node_type node, std::vector<node_type>& expanded) const;
+	
+	/// Returns the range of linear storage occupied by the strict descendants of a node.
+	std::pair<typename container_type::iterator, typename container_type::iterator> descendants(node_type node);
 
-	std::unordered_set<node_type> nodes;
+	container_type nodes;
 };
 
-template <std::size_t N, std::size_t D, class T>
-typename hyperoctree<N, D, T>::iterator& hyperoctree<N, D, T>::iterator::operator++()
+template <std::size_t N, std::size_t D, class T, hyperoctree_storage S>
+typename hyperoctree<N, D, T, S>::stack_iterator& hyperoctree<N, D, T, S>::stack_iterator::operator++()
 {
 	// Get next node from top of stack
-	node_type node = stack.top();
-	stack.pop();
+	node_type node = stack[--stack_size];
 
 	// If the node has children
-	if (!hyperoctree->is_leaf(node))
+	if (!tree->is_leaf(node))
 	{
-		// Push first child onto the stack
+		// Push children in reverse order, so that the first child is on top
 		for (T i = 0; i < children_per_node; ++i)
-			stack.push(child(node, siblings_per_node - i));
+			stack[stack_size++] = child(node, siblings_per_node - i);
 	}
 
-	if (stack.empty())
-		stack.push(std::numeric_limits<T>::max());
+	if (!stack_size)
+		stack[stack_size++] = std::numeric_limits<T>::max();
 
 	return *this;
 }
 
-template <std::size_t N, std::size_t D, class T>
-constexpr T hyperoctree<N, D, T>::ceil_log2(T n)
+template <std::size_t N, std::size_t D, class T, hyperoctree_storage S>
+constexpr T hyperoctree<N, D, T, S>::ceil_log2(T n)
 {
 	return (n <= 1) ? 0 : ceil_log2((n + 1) / 2) + 1;
 }
 
-template <std::size_t N, std::size_t D, class T>
-inline T hyperoctree<N, D, T>::depth(node_type node)
+template <std::size_t N, std::size_t D, class T, hyperoctree_storage S>
+inline T hyperoctree<N, D, T, S>::depth(node_type node)
 {
 	// Extract depth using a bit mask
 	constexpr T mask = pow(2, depth_bits) - 1;
 	return node & mask;
 }
 
-template <std::size_t N, std::size_t D, class T>
-inline T hyperoctree<N, D, T>::location(node_type node)
+template <std::size_t N, std::size_t D, class T, hyperoctree_storage S>
+inline T hyperoctree<N, D, T, S>::location(node_type node)
 {
 	return node >> ((node_bits - 1) - depth(node) * N);
 }
 
-template <std::size_t N, std::size_t D, class T>
-inline typename hyperoctree<N, D, T>::node_type hyperoctree<N, D, T>::node(T depth, T location)
+template <std::size_t N, std::size_t D, class T, hyperoctree_storage S>
+inline typename hyperoctree<N, D, T, S>::node_type hyperoctree<N, D, T, S>::node(T depth, T location)
 {
 	return (location << ((node_bits - 1) - depth * N)) | depth;
 }
 
-template <std::size_t N, std::size_t D, class T>
-inline typename hyperoctree<N, D, T>::node_type hyperoctree<N, D, T>::ancestor(node_type node, T depth)
+template <std::size_t N, std::size_t D, class T, hyperoctree_storage S>
+inline typename hyperoctree<N, D, T, S>::node_type hyperoctree<N, D, T, S>::ancestor(node_type node, T depth)
 {
 	const T mask = std::numeric_limits<T>::max() << ((node_bits - 1) - depth * N);
     return (node & mask) | depth;
 }
 
-template <std::size_t N, std::size_t D, class T>
-inline typename hyperoctree<N, D, T>::node_type hyperoctree<N, D, T>::parent(node_type node)
+template <std::size_t N, std::size_t D, class T, hyperoctree_storage S>
+inline typename hyperoctree<N, D, T, S>::node_type hyperoctree<N, D, T, S>::parent(node_type node)
 {
 	return ancestor(node, depth(node) - 1);
 }
 
-template <std::size_t N, std::size_t D, class T>
-inline typename hyperoctree<N, D, T>::node_type hyperoctree<N, D, T>::sibling(node_type node, T n)
+template <std::size_t N, std::size_t D, class T, hyperoctree_storage S>
+inline typename hyperoctree<N, D, T, S>::node_type hyperoctree<N, D, T, S>::sibling(node_type node, T n)
 {
 	constexpr T mask = (1 << N) - 1;
 	
@@ -332,14 +410,14 @@ inline typename hyperoctree<N, D, T>::node_type hyperoctree<N, D, T>::sibling(no
 	return hyperoctree::node(depth, (location & (~mask)) | ((location + n) & mask));
 }
 
-template <std::size_t N, std::size_t D, class T>
-inline typename hyperoctree<N, D, T>::node_type hyperoctree<N, D, T>::child(node_type node, T n)
+template <std::size_t N, std::size_t D, class T, hyperoctree_storage S>
+inline typename hyperoctree<N, D, T, S>::node_type hyperoctree<N, D, T, S>::child(node_type node, T n)
 {
 	return sibling(node + 1, n);
 }
 
-template <std::size_t N, std::size_t D, class T>
-inline typename hyperoctree<N, D, T>::node_type hyperoctree<N, D, T>::common_ancestor(node_type a, node_type b)
+template <std::size_t N, std::size_t D, class T, hyperoctree_storage S>
+inline typename hyperoctree<N, D, T, S>::node_type hyperoctree<N, D, T, S>::common_ancestor(node_type a, node_type b)
 {
 	T bits = std::min<T>(depth(a), depth(b)) * N;
 	T marker = (T(1) << (node_bits - 1)) >> bits;
@@ -347,117 +425,219 @@ inline typename hyperoctree<N, D, T>::node_type hyperoctree<N, D, T>::common_anc
 	return ancestor(a, depth);
 }
 
-template <std::size_t N, std::size_t D, class T>
-inline hyperoctree<N, D, T>::hyperoctree():
+template <std::size_t N, std::size_t D, class T, hyperoctree_storage S>
+inline hyperoctree<N, D, T, S>::hyperoctree():
 	nodes({0})
 {}
 
-template <std::size_t N, std::size_t D, class T>
-void hyperoctree<N, D, T>::insert(node_type node)
+template <std::size_t N, std::size_t D, class T, hyperoctree_storage S>
+void hyperoctree<N, D, T, S>::insert(node_type node)
 {
-	if (contains(node))
-		return;
-	
-	// Insert node
-	nodes.emplace(node);
+	if constexpr (S == hyperoctree_storage::linear)
+	{
+		insert(&node, &node + 1);
+	}
+	else
+	{
+		if (contains(node))
+			return;
+		
+		// Insert node
+		nodes.emplace(node);
 
-	// Insert siblings
-	for (T i = 1; i < children_per_node; ++i)
-		nodes.emplace(sibling(node, i));
-	
-	// Insert parent as necessary
-	node_type parent = hyperoctree::parent(node);
-	if (!contains(parent))
-		insert(parent);
+		// Insert siblings
+		for (T i = 1; i < children_per_node; ++i)
+			nodes.emplace(sibling(node, i));
+		
+		// Insert parent as necessary
+		node_type parent = hyperoctree::parent(node);
+		if (!contains(parent))
+			insert(parent);
+	}
+}
+
+template <std::size_t N, std::size_t D, class T, hyperoctree_storage S>
+template <class InputIt>
+void hyperoctree<N, D, T, S>::insert(InputIt first, InputIt last)
+{
+	if constexpr (S == hyperoctree_storage::linear)
+	{
+		// Collect the missing nodes and their sibling groups
+		std::vector<node_type> expanded;
+		for (; first != last; ++first)
+			expand(*first, expanded);
+		if (expanded.empty())
+			return;
+		
+		std::sort(expanded.begin(), expanded.end());
+		expanded.erase(std::unique(expanded.begin(), expanded.end()), expanded.end());
+		
+		// Merge the new nodes into sorted storage
+		const std::size_t size = nodes.size();
+		nodes.insert(nodes.end(), expanded.begin(), expanded.end());
+		std::inplace_merge(nodes.begin(), nodes.begin() + size, nodes.end());
+	}
+	else
+	{
+		for (; first != last; ++first)
+			insert(*first);
+	}
 }
 
-template <std::size_t N, std::size_t D, class T>
-void hyperoctree<N, D, T>::erase(node_type node)
+template <std::size_t N, std::size_t D, class T, hyperoctree_storage S>
+void hyperoctree<N, D, T, S>::erase(node_type node)
 {
 	// Don't erase the root!
 	if (node == root)
 		return;
 	
-	for (T i = 0; i < children_per_node; ++i)
+	if constexpr (S == hyperoctree_storage::linear)
 	{
-		// Erase node
-		nodes.erase(node);
-
-		// Erase descendants
-		if (!is_leaf(node))
+		// The node, its siblings, and their descendants are the strict descendants of the parent, which are contiguous in z-order
+		auto range = descendants(parent(node));
+		nodes.erase(range.first, range.second);
+	}
+	else
+	{
+		for (T i = 0; i < children_per_node; ++i)
 		{
-			for (T j = 0; j < children_per_node; ++j)
-				erase(child(node, j));
+			const node_type sibling = hyperoctree::sibling(node, i);
+			
+			// Erase sibling
+			nodes.erase(sibling);
+
+			// Erase descendants, which are erased along with their siblings
+			if (!is_leaf(sibling))
+				erase(child(sibling, 0));
 		}
+	}
+}
 
-		// Go to next sibling
-		if (i < siblings_per_node)
-			node = sibling(node, i);
+template <std::size_t N, std::size_t D, class T, hyperoctree_storage S>
+template <class InputIt>
+void hyperoctree<N, D, T, S>::erase(InputIt first, InputIt last)
+{
+	if constexpr (S == hyperoctree_storage::linear)
+	{
+		// Collect the parents of the sibling groups to erase, outermost first
+		std::vector<node_type> parents;
+		for (; first != last; ++first)
+		{
+			if (*first != root && contains(*first))
+				parents.push_back(parent(*first));
+		}
+		if (parents.empty())
+			return;
+		std::sort(parents.begin(), parents.end());
+		
+		// Remove the descendants of each parent in a single compaction pass, skipping parents nested within an already visited parent
+		auto output = nodes.begin();
+		auto input = nodes.begin();
+		node_type erased = root;
+		bool erasing = false;
+		for (node_type parent: parents)
+		{
+			if (erasing && (parent == erased || is_descendant(parent, erased)))
+				continue;
+			
+			auto range = descendants(parent);
+			output = std::move(input, range.first, output);
+			input = range.second;
+			erased = parent;
+			erasing = true;
+		}
+		output = std::move(input, nodes.end(), output);
+		nodes.erase(output, nodes.end());
+	}
+	else
+	{
+		for (; first != last; ++first)
+		{
+			if (contains(*first))
+				erase(*first);
+		}
 	}
 }
 
-template <std::size_t N, std::size_t D, class T>
-void hyperoctree<N, D, T>::clear()
+template <std::size_t N, std::size_t D, class T, hyperoctree_storage S>
+void hyperoctree<N, D, T, S>::clear()
 {
 	nodes = {0};
 }
 
-template <std::size_t N, std::size_t D, class T>
-inline bool hyperoctree<N, D, T>::contains(node_type node) const
+template <std::size_t N, std::size_t D, class T, hyperoctree_storage S>
+inline bool hyperoctree<N, D, T, S>::contains(node_type node) const
 {
-	return (nodes.find(node) != nodes.end());
+	if constexpr (S == hyperoctree_storage::linear)
+		return std::binary_search(nodes.begin(), nodes.end(), node);
+	else
+		return (nodes.find(node) != nodes.end());
 }
 
-template <std::size_t N, std::size_t D, class T>
-inline bool hyperoctree<N, D, T>::is_leaf(node_type node) const
+template <std::size_t N, std::size_t D, class T, hyperoctree_storage S>
+inline bool hyperoctree<N, D, T, S>::is_leaf(node_type node) const
 {
 	return !contains(child(node, 0));
 }
 
-template <std::size_t N, std::size_t D, class T>
-inline std::size_t hyperoctree<N, D, T>::size() const
+template <std::size_t N, std::size_t D, class T, hyperoctree_storage S>
+inline std::size_t hyperoctree<N, D, T, S>::size() const
 {
 	return nodes.size();
 }
 
-template <std::size_t N, std::size_t D, class T>
-typename hyperoctree<N, D, T>::iterator hyperoctree<N, D, T>::begin() const
+template <std::size_t N, std::size_t D, class T, hyperoctree_storage S>
+typename hyperoctree<N, D, T, S>::iterator hyperoctree<N, D, T, S>::begin() const
 {
-	return iterator(this, hyperoctree::root);
+	if constexpr (S == hyperoctree_storage::linear)
+		return iterator(nodes.begin());
+	else
+		return iterator(this, hyperoctree::root);
 }
 
-template <std::size_t N, std::size_t D, class T>
-typename hyperoctree<N, D, T>::iterator hyperoctree<N, D, T>::end() const
+template <std::size_t N, std::size_t D, class T, hyperoctree_storage S>
+typename hyperoctree<N, D, T, S>::iterator hyperoctree<N, D, T, S>::end() const
 {
-	return iterator(this, std::numeric_limits<T>::max());
+	if constexpr (S == hyperoctree_storage::linear)
+		return iterator(nodes.end());
+	else
+		return iterator(this, std::numeric_limits<T>::max());
 }
 
-template <std::size_t N, std::size_t D, class T>
-typename hyperoctree<N, D, T>::iterator hyperoctree<N, D, T>::find(node_type node) const
+template <std::size_t N, std::size_t D, class T, hyperoctree_storage S>
+typename hyperoctree<N, D, T, S>::iterator hyperoctree<N, D, T, S>::find(node_type node) const
 {
-	return contains(node) ? iterator(node) : end();
+	if constexpr (S == hyperoctree_storage::linear)
+	{
+		auto it = std::lower_bound(nodes.begin(), nodes.end(), node);
+		return (it != nodes.end() && *it == node) ? iterator(it) : end();
+	}
+	else
+	{
+		return contains(node) ? iterator(this, node) : end();
+	}
 }
 
-template <std::size_t N, std::size_t D, class T>
-typename hyperoctree<N, D, T>::unordered_iterator hyperoctree<N, D, T>::unordered_begin() const
+template <std::size_t N, std::size_t D, class T, hyperoctree_storage S>
+typename hyperoctree<N, D, T, S>::unordered_iterator hyperoctree<N, D, T, S>::unordered_begin() const
 {
 	return unordered_iterator(nodes.begin());
 }
 
-template <std::size_t N, std::size_t D, class T>
-typename hyperoctree<N, D, T>::unordered_iterator hyperoctree<N, D, T>::unordered_end() const
+template <std::size_t N, std::size_t D, class T, hyperoctree_storage S>
+typename hyperoctree<N, D, T, S>::unordered_iterator hyperoctree<N, D, T, S>::unordered_end() const
 {
 	return unordered_iterator(nodes.end());
 }
 
-template <std::size_t N, std::size_t D, class T>
-constexpr T hyperoctree<N, D, T>::pow(T x, T exponent)
+template <std::size_t N, std::size_t D, class T, hyperoctree_storage S>
+constexpr T hyperoctree<N, D, T, S>::pow(T x, T exponent)
 {
 	return (exponent == 0) ? 1 : x * pow(x, exponent - 1);
 }
 
-template <std::size_t N, std::size_t D, class T>
-T hyperoctree<N, D, T>::clz(T x)
+template <std::size_t N, std::size_t D, class T, hyperoctree_storage S>
+T hyperoctree<N, D, T, S>::clz(T x)
 {
 	if (!x)
 		return sizeof(T) * 8;
@@ -477,6 +657,89 @@ T hyperoctree<N, D, T>::clz(T x)
 	#endif
 }
 
+template <std::size_t N, std::size_t D, class T, hyperoctree_storage S>
+template <class Visitor>
+void hyperoctree<N, D, T, S>::visit(Visitor visitor) const
+{
+	node_type stack[traversal_capacity];
+	std::size_t stack_size = 0;
+	stack[stack_size++] = root;
+	
+	while (stack_size)
+	{
+		const node_type node = stack[--stack_size];
+		
+		if (visitor(node) && !is_leaf(node))
+		{
+			// Push children in reverse order, so that the first child is visited first
+			for (T i = 0; i < children_per_node; ++i)
+				stack[stack_size++] = child(node, siblings_per_node - i);
+		}
+	}
+}
+
+template <std::size_t N, std::size_t D, class T, hyperoctree_storage S>
+template <class Function, class Predicate>
+void hyperoctree<N, D, T, S>::for_each_leaf(Function function, Predicate predicate) const
+{
+	node_type stack[traversal_capacity];
+	std::size_t stack_size = 0;
+	stack[stack_size++] = root;
+	
+	while (stack_size)
+	{
+		const node_type node = stack[--stack_size];
+		
+		// Prune node and its descendants
+		if (!predicate(node))
+			continue;
+		
+		if (is_leaf(node))
+		{
+			function(node);
+		}
+		else
+		{
+			for (T i = 0; i < children_per_node; ++i)
+				stack[stack_size++] = child(node, siblings_per_node - i);
+		}
+	}
+}
+
+template <std::size_t N, std::size_t D, class T, hyperoctree_storage S>
+template <class Function>
+inline void hyperoctree<N, D, T, S>::for_each_leaf(Function function) const
+{
+	for_each_leaf(function, [](node_type) { return true; });
+}
+
+template <std::size_t N, std::size_t D, class T, hyperoctree_storage S>
+inline bool hyperoctree<N, D, T, S>::is_descendant(node_type node, node_type ancestor)
+{
+	const T ancestor_depth = depth(ancestor);
+	return depth(node) > ancestor_depth && hyperoctree::ancestor(node, ancestor_depth) == ancestor;
+}
+
+template <std::size_t N, std::size_t D, class T, hyperoctree_storage S>
+void hyperoctree<N, D, T, S>::expand(node_type node, std::vector<node_type>& expanded) const
+{
+	while (node != root && !contains(node))
+	{
+		for (T i = 0; i < children_per_node; ++i)
+			expanded.push_back(sibling(node, i));
+		node = parent(node);
+	}
+}
+
+template <std::size_t N, std::size_t D, class T, hyperoctree_storage S>
+std::pair<typename hyperoctree<N, D, T, S>::container_type::iterator, typename hyperoctree<N, D, T, S>::container_type::iterator> hyperoctree<N, D, T, S>::descendants(node_type node)
+{
+	// Descendants immediately follow their ancestor in z-order
+	auto first = std::upper_bound(nodes.begin(), nodes.end(), node);
+	auto last = std::partition_point(first, nodes.end(), [node](node_type x){ return is_descendant(x, node); });
+	return {first, last};
+}
+
 } // namespace geom
 
 #endif // ANTKEEPER_GEOM_HYPEROCTREE_HPP
@@ -18,10 +18,257 @@
  */
 
 #include "intersection.hpp"
+#include <algorithm>
 #include <limits>
 
+#if defined(__AVX__)
+	#define ANTKEEPER_GEOM_AVX
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#define ANTKEEPER_GEOM_SSE
+#endif
+#if defined(ANTKEEPER_GEOM_AVX) || defined(ANTKEEPER_GEOM_SSE)
+	#include <immintrin.h>
+#endif
+
 namespace geom {
 
+namespace {
+
+/// Packet lane types, kept in their own namespace so that their operators do not hide the vector operators.
+namespace simd {
+
+/**
+ * Single lane of a packet, for targets without SIMD instructions and packet remainders.
+ *
+ * The packet kernels are written once against this interface, which is also implemented by the SSE and AVX lane types.
+ */
+struct scalar_lanes
+{
+	typedef bool mask_type;
+	static constexpr std::size_t width = 1;
+	
+	static inline scalar_lanes load(const float* x) { return {*x}; }
+	static inline scalar_lanes broadcast(float x) { return {x}; }
+	static inline scalar_lanes select(mask_type mask, scalar_lanes a, scalar_lanes b) { return (mask) ? a : b; }
+	static inline scalar_lanes min(scalar_lanes a, scalar_lanes b) { return {std::min<float>(a.value, b.value)}; }
+	static inline scalar_lanes max(scalar_lanes a, scalar_lanes b) { return {std::max<float>(a.value, b.value)}; }
+	static inline unsigned int bits(mask_type mask) { return mask; }
+	inline void store(float* x) const { *x = value; }
+	
+	float value;
+};
+
+inline scalar_lanes operator+(scalar_lanes a, scalar_lanes b) { return {a.value + b.value}; }
+inline scalar_lanes operator-(scalar_lanes a, scalar_lanes b) { return {a.value - b.value}; }
+inline scalar_lanes operator*(scalar_lanes a, scalar_lanes b) { return {a.value * b.value}; }
+inline scalar_lanes operator/(scalar_lanes a, scalar_lanes b) { return {a.value / b.value}; }
+inline bool operator<(scalar_lanes a, scalar_lanes b) { return a.value < b.value; }
+inline bool operator<=(scalar_lanes a, scalar_lanes b) { return a.value <= b.value; }
+inline bool operator>(scalar_lanes a, scalar_lanes b) { return a.value > b.value; }
+inline bool operator>=(scalar_lanes a, scalar_lanes b) { return a.value >= b.value; }
+inline bool operator!=(scalar_lanes a, scalar_lanes b) { return a.value != b.value; }
+
+#if defined(ANTKEEPER_GEOM_SSE)
+/// Four lanes of a packet, processed with SSE instructions.
+struct sse_lanes
+{
+	typedef sse_lanes mask_type;
+	static constexpr std::size_t width = 4;
+	
+	static inline sse_lanes load(const float* x) { return {_mm_loadu_ps(x)}; }
+	static inline sse_lanes broadcast(float x) { return {_mm_set1_ps(x)}; }
+	static inline sse_lanes select(mask_type mask, sse_lanes a, sse_lanes b) { return {_mm_or_ps(_mm_and_ps(mask.value, a.value), _mm_andnot_ps(mask.value, b.value))}; }
+	static inline sse_lanes min(sse_lanes a, sse_lanes b) { return {_mm_min_ps(a.value, b.value)}; }
+	static inline sse_lanes max(sse_lanes a, sse_lanes b) { return {_mm_max_ps(a.value, b.value)}; }
+	static inline unsigned int bits(mask_type mask) { return static_cast<unsigned int>(_mm_movemask_ps(mask.value)); }
+	inline void store(float* x) const { _mm_storeu_ps(x, value); }
+	
+	__m128 value;
+};
+
+inline sse_lanes operator+(sse_lanes a, sse_lanes b) { return {_mm_add_ps(a.value, b.value)}; }
+inline sse_lanes operator-(sse_lanes a, sse_lanes b) { return {_mm_sub_ps(a.value, b.value)}; }
+inline sse_lanes operator*(sse_lanes a, sse_lanes b) { return {_mm_mul_ps(a.value, b.value)}; }
+inline sse_lanes operator/(sse_lanes a, sse_lanes b) { return {_mm_div_ps(a.value, b.value)}; }
+inline sse_lanes operator<(sse_lanes a, sse_lanes b) { return {_mm_cmplt_ps(a.value, b.value)}; }
+inline sse_lanes operator<=(sse_lanes a, sse_lanes b) { return {_mm_cmple_ps(a.value, b.value)}; }
+inline sse_lanes operator>(sse_lanes a, sse_lanes b) { return {_mm_cmpgt_ps(a.value, b.value)}; }
+inline sse_lanes operator>=(sse_lanes a, sse_lanes b) { return {_mm_cmpge_ps(a.value, b.value)}; }
+inline sse_lanes operator!=(sse_lanes a, sse_lanes b) { return {_mm_cmpneq_ps(a.value, b.value)}; }
+inline sse_lanes operator&(sse_lanes a, sse_lanes b) { return {_mm_and_ps(a.value, b.value)}; }
+#endif
+
+#if defined(ANTKEEPER_GEOM_AVX)
+/// Eight lanes of a packet, processed with AVX instructions.
+struct avx_lanes
+{
+	typedef avx_lanes mask_type;
+	static constexpr std::size_t width = 8;
+	
+	static inline avx_lanes load(const float* x) { return {_mm256_loadu_ps(x)}; }
+	static inline avx_lanes broadcast(float x) { return {_mm256_set1_ps(x)}; }
+	static inline avx_lanes select(mask_type mask, avx_lanes a, avx_lanes b) { return {_mm256_blendv_ps(b.value, a.value, mask.value)}; }
+	static inline avx_lanes min(avx_lanes a, avx_lanes b) { return {_mm256_min_ps(a.value, b.value)}; }
+	static inline avx_lanes max(avx_lanes a, avx_lanes b) { return {_mm256_max_ps(a.value, b.value)}; }
+	static inline unsigned int bits(mask_type mask) { return static_cast<unsigned int>(_mm256_movemask_ps(mask.value)); }
+	inline void store(float* x) const { _mm256_storeu_ps(x, value); }
+	
+	__m256 value;
+};
+
+inline avx_lanes operator+(avx_lanes a, avx_lanes b) { return {_mm256_add_ps(a.value, b.value)}; }
+inline avx_lanes operator-(avx_lanes a, avx_lanes b) { return {_mm256_sub_ps(a.value, b.value)}; }
+inline avx_lanes operator*(avx_lanes a, avx_lanes b) { return {_mm256_mul_ps(a.value, b.value)}; }
+inline avx_lanes operator/(avx_lanes a, avx_lanes b) { return {_mm256_div_ps(a.value, b.value)}; }
+inline avx_lanes operator<(avx_lanes a, avx_lanes b) { return {_mm256_cmp_ps(a.value, b.value, _CMP_LT_OQ)}; }
+inline avx_lanes operator<=(avx_lanes a, avx_lanes b) { return {_mm256_cmp_ps(a.value, b.value, _CMP_LE_OQ)}; }
+inline avx_lanes operator>(avx_lanes a, avx_lanes b) { return {_mm256_cmp_ps(a.value, b.value, _CMP_GT_OQ)}; }
+inline avx_lanes operator>=(avx_lanes a, avx_lanes b) { return {_mm256_cmp_ps(a.value, b.value, _CMP_GE_OQ)}; }
+inline avx_lanes operator!=(avx_lanes a, avx_lanes b) { return {_mm256_cmp_ps(a.value, b.value, _CMP_NEQ_UQ)}; }
+inline avx_lanes operator&(avx_lanes a, avx_lanes b) { return {_mm256_and_ps(a.value, b.value)}; }
+#endif
+
+/**
+ * Invokes a packet kernel on consecutive groups of lanes, using the widest lane type available for each group.
+ *
+ * @tparam N Number of lanes in the packet.
+ * @param kernel Generic function object with the signature `unsigned int(L, std::size_t)`, where `L` is a lane type and the second argument is the index of the first lane in the group. Returns a bit mask of the group's lanes.
+ * @return Bit mask of all lanes in the packet.
+ */
+template <std::size_t N, class Kernel>
+unsigned int dispatch_lanes(Kernel kernel)
+{
+	unsigned int mask = 0;
+	std::size_t i = 0;
+	
+	#if defined(ANTKEEPER_GEOM_AVX)
+	for (; i + avx_lanes::width <= N; i += avx_lanes::width)
+		mask |= kernel(avx_lanes{}, i) << i;
+	#endif
+	
+	#if defined(ANTKEEPER_GEOM_SSE)
+	for (; i + sse_lanes::width <= N; i += sse_lanes::width)
+		mask |= kernel(sse_lanes{}, i) << i;
+	#endif
+	
+	for (; i < N; ++i)
+		mask |= kernel(scalar_lanes{}, i) << i;
+	
+	return mask;
+}
+
+/// Tests a ray against lanes `[i, i + L::width)` of a triangle packet, with the same criteria as the single triangle test.
+template <class L, std::size_t N>
+unsigned int intersect_triangle_lanes(const ray<float>& ray, const triangle_packet<N>& packet, std::size_t i, float* t)
+{
+	const L dx = L::broadcast(ray.direction.x);
+	const L dy = L::broadcast(ray.direction.y);
+	const L dz = L::broadcast(ray.direction.z);
+	
+	const L e1x = L::load(&packet.edge10[0][i]);
+	const L e1y = L::load(&packet.edge10[1][i]);
+	const L e1z = L::load(&packet.edge10[2][i]);
+	const L e2x = L::load(&packet.edge20[0][i]);
+	const L e2y = L::load(&packet.edge20[1][i]);
+	const L e2z = L::load(&packet.edge20[2][i]);
+	
+	// Calculate determinant
+	const L pvx = dy * e2z - dz * e2y;
+	const L pvy = dz * e2x - dx * e2z;
+	const L pvz = dx * e2y - dy * e2x;
+	const L det = e1x * pvx + e1y * pvy + e1z * pvz;
+	const L inverse_det = L::broadcast(1.0f) / det;
+	
+	// Calculate u
+	const L tvx = L::broadcast(ray.origin.x) - L::load(&packet.vertex[0][i]);
+	const L tvy = L::broadcast(ray.origin.y) - L::load(&packet.vertex[1][i]);
+	const L tvz = L::broadcast(ray.origin.z) - L::load(&packet.vertex[2][i]);
+	const L u = (tvx * pvx + tvy * pvy + tvz * pvz) * inverse_det;
+	
+	// Calculate v
+	const L qvx = tvy * e1z - tvz * e1y;
+	const L qvy = tvz * e1x - tvx * e1z;
+	const L qvz = tvx * e1y - tvy * e1x;
+	const L v = (dx * qvx + dy * qvy + dz * qvz) * inverse_det;
+	
+	// Calculate t
+	const L distance = (e2x * qvx + e2y * qvy + e2z * qvz) * inverse_det;
+	
+	const L zero = L::broadcast(0.0f);
+	const L one = L::broadcast(1.0f);
+	const typename L::mask_type mask = (det != zero) & (u >= zero) & (u <= one) & (v >= zero) & (u + v <= one) & (distance > zero);
+	
+	L::select(mask, distance, L::broadcast(std::numeric_limits<float>::infinity())).store(t + i);
+	return L::bits(mask);
+}
+
+/// Tests a ray against lanes `[i, i + L::width)` of an AABB packet.
+template <class L, std::size_t N>
+unsigned int intersect_aabb_lanes(const ray<float>& ray, const aabb_packet<N>& packet, std::size_t i, float* t)
+{
+	L t0 = L::broadcast(-std::numeric_limits<float>::infinity());
+	L t1 = L::broadcast(std::numeric_limits<float>::infinity());
+	
+	for (std::size_t j = 0; j < 3; ++j)
+	{
+		const L origin = L::broadcast(ray.origin[j]);
+		const L inverse_direction = L::broadcast(1.0f / ray.direction[j]);
+		const L tmin = (L::load(&packet.min_point[j][i]) - origin) * inverse_direction;
+		const L tmax = (L::load(&packet.max_point[j][i]) - origin) * inverse_direction;
+		
+		t0 = L::max(t0, L::min(tmin, tmax));
+		t1 = L::min(t1, L::max(tmin, tmax));
+	}
+	
+	t0.store(t + i);
+	return L::bits((t0 <= t1) & (t1 >= L::broadcast(0.0f)));
+}
+
+/// Tests lanes `[i, i + L::width)` of a ray packet against an AABB.
+template <class L, std::size_t N>
+unsigned int intersect_ray_lanes(const ray_packet<N>& packet, const aabb<float>& aabb, std::size_t i, float* t)
+{
+	L t0 = L::broadcast(-std::numeric_limits<float>::infinity());
+	L t1 = L::broadcast(std::numeric_limits<float>::infinity());
+	
+	for (std::size_t j = 0; j < 3; ++j)
+	{
+		const L origin = L::load(&packet.origin[j][i]);
+		const L inverse_direction = L::broadcast(1.0f) / L::load(&packet.direction[j][i]);
+		const L tmin = (L::broadcast(aabb.min_point[j]) - origin) * inverse_direction;
+		const L tmax = (L::broadcast(aabb.max_point[j]) - origin) * inverse_direction;
+		
+		t0 = L::max(t0, L::min(tmin, tmax));
+		t1 = L::min(t1, L::max(tmin, tmax));
+	}
+	
+	t0.store(t + i);
+	return L::bits((t0 <= t1) & (t1 >= L::broadcast(0.0f)));
+}
+
+} // namespace simd
+
+template <std::size_t N>
+inline unsigned int ray_triangle_packet_intersection(const ray<float>& ray, const triangle_packet<N>& packet, float* t)
+{
+	return simd::dispatch_lanes<N>([&](auto lanes, std::size_t i) { return simd::intersect_triangle_lanes<decltype(lanes)>(ray, packet, i, t); });
+}
+
+template <std::size_t N>
+inline unsigned int ray_aabb_packet_intersection(const ray<float>& ray, const aabb_packet<N>& packet, float* t)
+{
+	return simd::dispatch_lanes<N>([&](auto lanes, std::size_t i) { return simd::intersect_aabb_lanes<decltype(lanes)>(ray, packet, i, t); });
+}
+
+template <std::size_t N>
+inline unsigned int ray_packet_aabb_intersection(const ray_packet<N>& packet, const aabb<float>& aabb, float* t)
+{
+	return simd::dispatch_lanes<N>([&](auto lanes, std::size_t i) { return simd::intersect_ray_lanes<decltype(lanes)>(packet, aabb, i, t); });
+}
+
+} // namespace
+
 std::tuple<bool, float> ray_plane_intersection(const ray<float>& ray, const plane<float>& plane)
 {
 	float denom = math::dot(ray.direction, plane.normal);
@@ -126,31 +373,50 @@ std::tuple<bool, float, float, std::size_t, std::size_t> ray_mesh_intersection(c
 	std::size_t index0 = triangles.size();
 	std::size_t index1 = triangles.size();
 
-	for (std::size_t i = 0; i < triangles.size(); ++i)
+	// Test triangles in packets, leaving unused lanes of the last packet degenerate
+	constexpr std::size_t packet_size = 8;
+	for (std::size_t first = 0; first < triangles.size(); first += packet_size)
 	{
-		const mesh::face* triangle = triangles[i];
-
-		const float3& a = reinterpret_cast<const float3&>(triangle->edge->vertex->position);
-		const float3& b = reinterpret_cast<const float3&>(triangle->edge->next->vertex->position);
-		const float3& c = reinterpret_cast<const float3&>(triangle->edge->previous->vertex->position);
-
-		auto result = ray_triangle_intersection(ray, a, b, c);
-
-		if (std::get<0>(result))
+		const std::size_t count = std::min<std::size_t>(packet_size, triangles.size() - first);
+		
+		triangle_packet<packet_size> packet = {};
+		for (std::size_t j = 0; j < count; ++j)
 		{
-			intersection = true;
-			float t = std::get<1>(result);
-
-			if (t < t0)
+			const mesh::face* triangle = triangles[first + j];
+			
+			const float3& a = reinterpret_cast<const float3&>(triangle->edge->vertex->position);
+			const float3& b = reinterpret_cast<const float3&>(triangle->edge->next->vertex->position);
+			const float3& c = reinterpret_cast<const float3&>(triangle->edge->previous->vertex->position);
+			
+			for (std::size_t k = 0; k < 3; ++k)
 			{
-				t0 = t;
-				index0 = i;
+				packet.vertex[k][j] = a[k];
+				packet.edge10[k][j] = b[k] - a[k];
+				packet.edge20[k][j] = c[k] - a[k];
+			}
+		}
+		
+		float t[packet_size];
+		unsigned int mask = ray_triangle_intersection(ray, packet, t);
+		if (!mask)
+			continue;
+		intersection = true;
+		
+		for (std::size_t j = 0; j < count; ++j)
+		{
+			if (!(mask & (1u << j)))
+				continue;
+			
+			if (t[j] < t0)
+			{
+				t0 = t[j];
+				index0 = first + j;
 			}
 
-			if (t > t1)
+			if (t[j] > t1)
 			{
-				t1 = t;
-				index1 = i;
+				t1 = t[j];
+				index1 = first + j;
 			}
 		}
 	}
@@ -158,6 +424,36 @@ std::tuple<bool, float, float, std::size_t, std::size_t> ray_mesh_intersection(c
 	return std::make_tuple(intersection, t0, t1, index0, index1);
 }
 
+unsigned int ray_triangle_intersection(const ray<float>& ray, const triangle_packet<4>& packet, float* t)
+{
+	return ray_triangle_packet_intersection(ray, packet, t);
+}
+
+unsigned int ray_triangle_intersection(const ray<float>& ray, const triangle_packet<8>& packet, float* t)
+{
+	return ray_triangle_packet_intersection(ray, packet, t);
+}
+
+unsigned int ray_aabb_intersection(const ray<float>& ray, const aabb_packet<4>& packet, float* t)
+{
+	return ray_aabb_packet_intersection(ray, packet, t);
+}
+
+unsigned int ray_aabb_intersection(const ray<float>& ray, const aabb_packet<8>& packet, float* t)
+{
+	return ray_aabb_packet_intersection(ray, packet, t);
+}
+
+unsigned int ray_aabb_intersection(const ray_packet<4>& packet, const aabb<float>& aabb, float* t)
+{
+	return ray_packet_aabb_intersection(packet, aabb, t);
+}
+
+unsigned int ray_aabb_intersection(const ray_packet<8>& packet, const aabb<float>& aabb, float* t)
+{
+	return ray_packet_aabb_intersection(packet, aabb, t);
+}
+
 bool aabb_aabb_intersection(const aabb<float>& a, const aabb<float>& b)
 {
 	if (a.max_point.x < b.min_point.x || a.min_point.x > b.max_point.x)
@@ -45,6 +45,84 @@ std::tuple<bool, float, float> ray_aabb_intersection(const ray<float>& ray, cons
 
 std::tuple<bool, float, float, std::size_t, std::size_t> ray_mesh_intersection(const ray<float>& ray, const mesh& mesh);
 
+/**
+ * Packet of triangles in structure-of-arrays form, with each triangle described by a vertex and the two edges which originate from it. Lanes with zero-length edges never intersect.
+ *
+ * @tparam N Number of triangles in the packet.
+ */
+template <std::size_t N>
+struct triangle_packet
+{
+	float vertex[3][N];
+	float edge10[3][N];
+	float edge20[3][N];
+};
+
+/**
+ * Packet of AABBs in structure-of-arrays form.
+ *
+ * @tparam N Number of AABBs in the packet.
+ */
+template <std::size_t N>
+struct aabb_packet
+{
+	float min_point[3][N];
+	float max_point[3][N];
+};
+
+/**
+ * Packet of rays in structure-of-arrays form.
+ *
+ * @tparam N Number of rays in the packet.
+ */
+template <std::size_t N>
+struct ray_packet
+{
+	float origin[3][N];
+	float direction[3][N];
+};
+
+/**
+ * Tests for intersection between a ray and each triangle in a packet.
+ *
+ * Packets are tested with SSE or AVX instructions when the target supports them, and one lane at a time otherwise.
+ *
+ * @param ray Ray to test for intersection.
+ * @param packet Triangles to test for intersection.
+ * @param[out] t Distance along the ray to the intersection with each triangle, or infinity for triangles which are not intersected.
+ * @return Bit mask with bit `i` set if the ray intersects triangle `i`.
+ */
+/// @{
+unsigned int ray_triangle_intersection(const ray<float>& ray, const triangle_packet<4>& packet, float* t);
+unsigned int ray_triangle_intersection(const ray<float>& ray, const triangle_packet<8>& packet, float* t);
+/// @}
+
+/**
+ * Tests for intersection between a ray and each AABB in a packet.
+ *
+ * @param ray Ray to test for intersection.
+ * @param packet AABBs to test for intersection.
+ * @param[out] t Distance along the ray at which each AABB is entered, which is negative if the ray originates inside of it.
+ * @return Bit mask with bit `i` set if the ray intersects AABB `i`.
+ */
+/// @{
+unsigned int ray_aabb_intersection(const ray<float>& ray, const aabb_packet<4>& packet, float* t);
+unsigned int ray_aabb_intersection(const ray<float>& ray, const aabb_packet<8>& packet, float* t);
+/// @}
+
+/**
+ * Tests for intersection between each ray in a packet and an AABB.
+ *
+ * @param packet Rays to test for intersection.
+ * @param aabb AABB to test for intersection.
+ * @param[out] t Distance along each ray at which the AABB is entered, which is negative if the ray originates inside of it.
+ * @return Bit mask with bit `i` set if ray `i` intersects the AABB.
+ */
+/// @{
+unsigned int ray_aabb_intersection(const ray_packet<4>& packet, const aabb<float>& aabb, float* t);
+unsigned int ray_aabb_intersection(const ray_packet<8>& packet, const aabb<float>& aabb, float* t);
+/// @}
+
 /**
  * Ray-sphere intersection test.
  */
@@ -23,22 +23,6 @@
 namespace geom {
 namespace mc {
 
-static constexpr std::uint_fast8_t vertex_table[12][2] =
-{
-	{0, 1},
-	{1, 2},
-	{2, 3},
-	{3, 0},
-	{4, 5},
-	{5, 6},
-	{6, 7},
-	{7, 4},
-	{0, 4},
-	{1, 5},
-	{2, 6},
-	{3, 7}
-};
-
 static constexpr std::uint_fast16_t edge_table[256] =
 {
 	0x000, 0x109, 0x203, 0x30a, 0x406, 0x50f, 0x605, 0x70c,
@@ -335,7 +319,7 @@ static constexpr std::int_fast8_t triangle_table[256][16] =
 	{-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}
 };
 
-void polygonize(float* vertices, std::uint_fast8_t* vertex_count, std::int_fast8_t* triangles, std::uint_fast8_t* triangle_count, const float* corners, const float* distances)
+void polygonize(float* vertices, std::uint_fast8_t* vertex_count, std::int_fast8_t* triangles, std::uint_fast8_t* triangle_count, const float* corners, const float* distances, std::uint_fast8_t* vertex_edges)
 {
 	*vertex_count = 0;
 	*triangle_count = 0;
@@ -361,8 +345,8 @@ void polygonize(float* vertices, std::uint_fast8_t* vertex_count, std::int_fast8
 		if (edge_flags & (1 << i))
 		{
 			// Find the two vertices which make up edge ab
-			std::uint_fast8_t a = vertex_table[i][0];
-			std::uint_fast8_t b = vertex_table[i][1];
+			std::uint_fast8_t a = edge_vertices[i][0];
+			std::uint_fast8_t b = edge_vertices[i][1];
 			const float* v_a = corners + a * 3;
 			const float* v_b = corners + b * 3;
 			float f_a = distances[a];
@@ -401,6 +385,9 @@ void polygonize(float* vertices, std::uint_fast8_t* vertex_count, std::int_fast8
 			*(vertices++) = vertex_buffer[++index];
 			*(vertices++) = vertex_buffer[++index];
 			vertex_remap[indices[i]] = (*vertex_count)++;
+			
+			if (vertex_edges)
+				*(vertex_edges++) = indices[i];
 		}
 	}
 	
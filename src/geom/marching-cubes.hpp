@@ -34,8 +34,9 @@ namespace mc {
  * @param[out] vertex_count Number of generated vertices.
  * @param[out] triangles Array which can hold 5 at least triangles (15 ints).
  * @param[out] triangle_count Number of generated triangles. The maximum number triangles generated for a single cell is 5.
+ * @param[out] vertex_edges Optional array which can hold at least 12 cell edge indices, into which the index of the cell edge on which each generated vertex lies is stored. Edge `i` connects the corners `a` and `b` given by `edge_vertices[i]`.
  */
-void polygonize(float* vertices, std::uint_fast8_t* vertex_count, std::int_fast8_t* triangles, std::uint_fast8_t* triangle_count, const float* corners, const float* distances);
+void polygonize(float* vertices, std::uint_fast8_t* vertex_count, std::int_fast8_t* triangles, std::uint_fast8_t* triangle_count, const float* corners, const float* distances, std::uint_fast8_t* vertex_edges = nullptr);
 
 /**
  * Vertices of a unit cube.
@@ -52,6 +53,25 @@ constexpr float unit_cube[8][3] =
 	{0, 1, 1}
 };
 
+/**
+ * Corner indices of the twelve edges of a cell.
+ */
+constexpr std::uint_fast8_t edge_vertices[12][2] =
+{
+	{0, 1},
+	{1, 2},
+	{2, 3},
+	{3, 0},
+	{4, 5},
+	{5, 6},
+	{6, 7},
+	{7, 4},
+	{0, 4},
+	{1, 5},
+	{2, 6},
+	{3, 7}
+};
+
 } // namespace mc
 } // namespace geom
 
@@ -18,163 +18,467 @@
  */
 
 #include "geom/mesh-accelerator.hpp"
-#include "geom/mesh-functions.hpp"
-#include "geom/morton.hpp"
-#include <bitset>
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <numeric>
 
 namespace geom {
 
+namespace {
+
+/// Surface area of a box, as used by the surface area heuristic.
+inline float half_area(const float3& min_point, const float3& max_point)
+{
+	const float3 extent = max_point - min_point;
+	return extent.x * extent.y + extent.y * extent.z + extent.z * extent.x;
+}
+
+/// Grows a box to contain a point.
+inline void extend(float3& min_point, float3& max_point, const float3& point)
+{
+	for (int i = 0; i < 3; ++i)
+	{
+		min_point[i] = std::min<float>(min_point[i], point[i]);
+		max_point[i] = std::max<float>(max_point[i], point[i]);
+	}
+}
+
+} // namespace
+
 mesh_accelerator::mesh_accelerator()
 {}
 
 void mesh_accelerator::build(const mesh& mesh)
 {
-	// Clear octree and face map
-	octree.clear();
-	face_map.clear();
-
-	// Calculate mesh dimensions
-	aabb<float> bounds = calculate_bounds(mesh);
-	float3 mesh_dimensions = bounds.max_point - bounds.min_point;
-	center_offset = mesh_dimensions * 0.5f - (bounds.min_point + bounds.max_point) * 0.5f;
+	builder(mesh).finish(*this);
+}
 
-	// Calculate node dimensions at each octree depth
-	for (auto i = 0; i <= octree32::max_depth; ++i)
+void mesh_accelerator::refit()
+{
+	for (std::uint32_t lane = 0; lane < faces.size(); ++lane)
 	{
-		node_dimensions[i] = mesh_dimensions * static_cast<float>((1.0f / std::pow(2, i)));
+		if (const mesh::face* face = faces[lane])
+		{
+			pack
+			(
+				lane,
+				reinterpret_cast<const float3&>(face->edge->vertex->position),
+				reinterpret_cast<const float3&>(face->edge->next->vertex->position),
+				reinterpret_cast<const float3&>(face->edge->previous->vertex->position)
+			);
+		}
 	}
-
-	// Add faces to octree
-	for (mesh::face* face: mesh.get_faces())
+	
+	// Children follow their parents, so nodes are fit bottom-up in reverse order
+	for (std::size_t i = nodes.size(); i--;)
 	{
-		// Calculate face bounds
-		float3 min_point = reinterpret_cast<const float3&>(face->edge->vertex->position);
-		float3 max_point = min_point;
-		mesh::edge* edge = face->edge;
-		do
+		node& node = nodes[i];
+		if (node.count)
 		{
-			const auto& position = edge->vertex->position;
-			for (int i = 0; i < 3; ++i)
-			{
-				min_point[i] = std::min<float>(min_point[i], position[i]);
-				max_point[i] = std::max<float>(max_point[i], position[i]);
-			}
-
-			edge = edge->next;
+			fit_leaf(node);
+		}
+		else
+		{
+			const mesh_accelerator::node& left = nodes[node.offset];
+			const mesh_accelerator::node& right = nodes[node.offset + 1];
+			node.min_point = left.min_point;
+			node.max_point = left.max_point;
+			extend(node.min_point, node.max_point, right.min_point);
+			extend(node.min_point, node.max_point, right.max_point);
 		}
-		while (edge != face->edge);
-
-		// 1. Find max depth node of aabb min
-		// 2. Find max depth node of aabb max
-		// 3. Find common ancestor of the two nodes--that's the containing node.
-		octree32::node_type min_node = find_node(min_point);
-		octree32::node_type max_node = find_node(max_point);
-		octree32::node_type containing_node = octree32::common_ancestor(min_node, max_node);
-
-		// Insert containing node into octree
-		octree.insert(containing_node);
-
-		// Add face to face map
-		face_map[containing_node].push_back(face);
 	}
 }
 
-std::optional<mesh_accelerator::ray_query_result> mesh_accelerator::query_nearest(const ray<float>& ray) const
+void mesh_accelerator::refit(const std::vector<mesh::face*>& moved_faces)
 {
-	ray_query_result result;
-	result.t = std::numeric_limits<float>::infinity();
-	result.face = nullptr;
-
-	query_nearest_recursive(result.t, result.face, octree.root, ray);
+	// Repack the moved faces, collecting the leaves which contain them
+	std::vector<std::uint32_t> leaves;
+	for (const mesh::face* face: moved_faces)
+	{
+		if (face->index >= face_lanes.size())
+			continue;
+		const std::uint32_t lane = face_lanes[face->index];
+		if (lane == std::numeric_limits<std::uint32_t>::max())
+			continue;
+		
+		pack
+		(
+			lane,
+			reinterpret_cast<const float3&>(face->edge->vertex->position),
+			reinterpret_cast<const float3&>(face->edge->next->vertex->position),
+			reinterpret_cast<const float3&>(face->edge->previous->vertex->position)
+		);
+		leaves.push_back(packet_leaves[lane / packet_size]);
+	}
+	std::sort(leaves.begin(), leaves.end());
+	leaves.erase(std::unique(leaves.begin(), leaves.end()), leaves.end());
+	
+	// Fit each leaf, then its ancestors until their bounds no longer change
+	for (std::uint32_t index: leaves)
+	{
+		fit_leaf(nodes[index]);
+		
+		while (index)
+		{
+			index = parents[index];
+			node& node = nodes[index];
+			
+			float3 min_point = nodes[node.offset].min_point;
+			float3 max_point = nodes[node.offset].max_point;
+			extend(min_point, max_point, nodes[node.offset + 1].min_point);
+			extend(min_point, max_point, nodes[node.offset + 1].max_point);
+			if (!std::memcmp(&min_point, &node.min_point, sizeof(float3)) && !std::memcmp(&max_point, &node.max_point, sizeof(float3)))
+				break;
+			
+			node.min_point = min_point;
+			node.max_point = max_point;
+		}
+	}
+}
 
-	if (result.face)
-		return std::optional{result};
-	return std::nullopt;
+void mesh_accelerator::pack(std::uint32_t lane, const float3& a, const float3& b, const float3& c)
+{
+	triangle_packet<packet_size>& packet = packets[lane / packet_size];
+	const std::uint32_t j = lane % packet_size;
+	
+	for (int k = 0; k < 3; ++k)
+	{
+		packet.vertex[k][j] = a[k];
+		packet.edge10[k][j] = b[k] - a[k];
+		packet.edge20[k][j] = c[k] - a[k];
+	}
 }
 
-void mesh_accelerator::query_nearest_recursive(float& nearest_t, geom::mesh::face*& nearest_face, octree32::node_type node, const ray<float>& ray) const
+void mesh_accelerator::fit_leaf(node& leaf) const
 {
-	// Get node bounds
-	const aabb<float> node_bounds = get_node_bounds(node);
+	leaf.min_point = float3{1.0f, 1.0f, 1.0f} * std::numeric_limits<float>::infinity();
+	leaf.max_point = -leaf.min_point;
+	
+	const std::uint32_t packet_count = (leaf.count + packet_size - 1) / packet_size;
+	for (std::uint32_t i = leaf.offset; i < leaf.offset + packet_count; ++i)
+	{
+		const triangle_packet<packet_size>& packet = packets[i];
+		for (std::uint32_t j = 0; j < packet_size; ++j)
+		{
+			if (!faces[i * packet_size + j])
+				continue;
+			
+			const float3 a = {packet.vertex[0][j], packet.vertex[1][j], packet.vertex[2][j]};
+			extend(leaf.min_point, leaf.max_point, a);
+			extend(leaf.min_point, leaf.max_point, a + float3{packet.edge10[0][j], packet.edge10[1][j], packet.edge10[2][j]});
+			extend(leaf.min_point, leaf.max_point, a + float3{packet.edge20[0][j], packet.edge20[1][j], packet.edge20[2][j]});
+		}
+	}
+}
 
-	// Test for intersection with node bounds
-	auto aabb_intersection = ray_aabb_intersection(ray, node_bounds);
+mesh_accelerator::builder::builder(const mesh& mesh):
+	faces(mesh.get_faces())
+{
+	const std::uint32_t triangle_count = static_cast<std::uint32_t>(faces.size());
+	if (!triangle_count)
+		return;
+	
+	// Copy triangle vertices, and calculate triangle bounds and centroids
+	vertices.resize(triangle_count * 3);
+	triangle_min_points.resize(triangle_count);
+	triangle_max_points.resize(triangle_count);
+	centroids.resize(triangle_count);
+	for (std::uint32_t i = 0; i < triangle_count; ++i)
+	{
+		const mesh::face* face = faces[i];
+		const float3& a = vertices[i * 3] = reinterpret_cast<const float3&>(face->edge->vertex->position);
+		const float3& b = vertices[i * 3 + 1] = reinterpret_cast<const float3&>(face->edge->next->vertex->position);
+		const float3& c = vertices[i * 3 + 2] = reinterpret_cast<const float3&>(face->edge->previous->vertex->position);
+		
+		triangle_min_points[i] = a;
+		triangle_max_points[i] = a;
+		extend(triangle_min_points[i], triangle_max_points[i], b);
+		extend(triangle_min_points[i], triangle_max_points[i], c);
+		centroids[i] = (a + b + c) * (1.0f / 3.0f);
+	}
+	
+	indices.resize(triangle_count);
+	std::iota(indices.begin(), indices.end(), 0);
+	
+	// Build hierarchy from the root, splitting nodes from an explicit stack of (node, depth) pairs
+	nodes.reserve(triangle_count * 2);
+	parents.reserve(triangle_count * 2);
+	nodes.push_back({float3{}, 0, float3{}, triangle_count});
+	parents.push_back(0);
+	stack.push_back({0, 1});
+}
 
-	// If ray passed through this node
-	if (std::get<0>(aabb_intersection))
+bool mesh_accelerator::builder::step(std::size_t node_count)
+{
+	for (; node_count && !stack.empty(); --node_count)
 	{
-		// Test all triangles in the node
-		if (auto it = face_map.find(node); it != face_map.end())
+		const auto [node_index, depth] = stack.back();
+		stack.pop_back();
+		
+		const std::uint32_t first = nodes[node_index].offset;
+		const std::uint32_t count = nodes[node_index].count;
+		
+		// Calculate node bounds and centroid bounds
+		float3 min_point = triangle_min_points[indices[first]];
+		float3 max_point = triangle_max_points[indices[first]];
+		float3 centroid_min = centroids[indices[first]];
+		float3 centroid_max = centroid_min;
+		for (std::uint32_t i = first; i < first + count; ++i)
 		{
-			const std::list<mesh::face*>& faces = it->second;
-
-			for (mesh::face* face: faces)
+			extend(min_point, max_point, triangle_min_points[indices[i]]);
+			extend(min_point, max_point, triangle_max_points[indices[i]]);
+			extend(centroid_min, centroid_max, centroids[indices[i]]);
+		}
+		nodes[node_index].min_point = min_point;
+		nodes[node_index].max_point = max_point;
+		
+		if (count <= max_leaf_size || depth >= max_depth)
+			continue;
+		
+		// Find the split plane of least cost, between bins of triangle centroids
+		float best_cost = std::numeric_limits<float>::infinity();
+		int best_axis = -1;
+		std::size_t best_split = 0;
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			const float extent = centroid_max[axis] - centroid_min[axis];
+			if (extent <= 0.0f)
+				continue;
+			const float bin_scale = static_cast<float>(bin_count) / extent;
+			
+			// Bin triangles by centroid
+			std::uint32_t bin_counts[bin_count] = {0};
+			float3 bin_min_points[bin_count];
+			float3 bin_max_points[bin_count];
+			for (std::size_t j = 0; j < bin_count; ++j)
+			{
+				bin_min_points[j] = float3{1.0f, 1.0f, 1.0f} * std::numeric_limits<float>::infinity();
+				bin_max_points[j] = -bin_min_points[j];
+			}
+			for (std::uint32_t i = first; i < first + count; ++i)
+			{
+				const std::uint32_t index = indices[i];
+				const std::size_t bin = std::min<std::size_t>(bin_count - 1, static_cast<std::size_t>((centroids[index][axis] - centroid_min[axis]) * bin_scale));
+				++bin_counts[bin];
+				extend(bin_min_points[bin], bin_max_points[bin], triangle_min_points[index]);
+				extend(bin_min_points[bin], bin_max_points[bin], triangle_max_points[index]);
+			}
+			
+			// Sweep from the right to accumulate the cost of the right side of each split
+			float right_costs[bin_count];
+			float3 right_min = bin_min_points[bin_count - 1];
+			float3 right_max = bin_max_points[bin_count - 1];
+			std::uint32_t right_count = 0;
+			for (std::size_t j = bin_count - 1; j > 0; --j)
+			{
+				right_count += bin_counts[j];
+				extend(right_min, right_max, bin_min_points[j]);
+				extend(right_min, right_max, bin_max_points[j]);
+				right_costs[j] = (right_count) ? half_area(right_min, right_max) * static_cast<float>(right_count) : 0.0f;
+			}
+			
+			// Sweep from the left, combining with the right side costs
+			float3 left_min = bin_min_points[0];
+			float3 left_max = bin_max_points[0];
+			std::uint32_t left_count = 0;
+			for (std::size_t j = 0; j < bin_count - 1; ++j)
 			{
-				// Get triangle coordinates
-				const float3& a = reinterpret_cast<const float3&>(face->edge->vertex->position);
-				const float3& b = reinterpret_cast<const float3&>(face->edge->next->vertex->position);
-				const float3& c = reinterpret_cast<const float3&>(face->edge->previous->vertex->position);
-
-				// Test for intersection with triangle
-				auto triangle_intersection = ray_triangle_intersection(ray, a, b, c);
-				if (std::get<0>(triangle_intersection))
+				left_count += bin_counts[j];
+				extend(left_min, left_max, bin_min_points[j]);
+				extend(left_min, left_max, bin_max_points[j]);
+				if (!left_count || left_count == count)
+					continue;
+				
+				const float cost = half_area(left_min, left_max) * static_cast<float>(left_count) + right_costs[j + 1];
+				if (cost < best_cost)
 				{
-					float t = std::get<1>(triangle_intersection);
-					if (t < nearest_t)
-					{
-						nearest_t = t;
-						nearest_face = face;
-					}
+					best_cost = cost;
+					best_axis = axis;
+					best_split = j + 1;
 				}
 			}
 		}
+		
+		// Keep node as a leaf if no split is cheaper than intersecting all of its triangles
+		if (best_axis < 0 || best_cost >= half_area(min_point, max_point) * static_cast<float>(count))
+			continue;
+		
+		// Partition triangles about the split plane
+		const float bin_scale = static_cast<float>(bin_count) / (centroid_max[best_axis] - centroid_min[best_axis]);
+		auto middle = std::partition(indices.begin() + first, indices.begin() + first + count,
+			[&](std::uint32_t index)
+			{
+				const std::size_t bin = std::min<std::size_t>(bin_count - 1, static_cast<std::size_t>((centroids[index][best_axis] - centroid_min[best_axis]) * bin_scale));
+				return bin < best_split;
+			});
+		const std::uint32_t left_count = static_cast<std::uint32_t>(middle - indices.begin()) - first;
+		
+		// Allocate children consecutively
+		const std::uint32_t left_index = static_cast<std::uint32_t>(nodes.size());
+		nodes.push_back({float3{}, first, float3{}, left_count});
+		nodes.push_back({float3{}, first + left_count, float3{}, count - left_count});
+		nodes[node_index].offset = left_index;
+		nodes[node_index].count = 0;
+		parents.push_back(node_index);
+		parents.push_back(node_index);
+		
+		stack.push_back({left_index, depth + 1});
+		stack.push_back({left_index + 1, depth + 1});
+	}
+	
+	return stack.empty();
+}
 
-		// Test all child nodes
-		if (!octree.is_leaf(node))
+void mesh_accelerator::builder::finish(mesh_accelerator& accelerator)
+{
+	while (!step(std::numeric_limits<std::size_t>::max()));
+	
+	accelerator.nodes = std::move(nodes);
+	accelerator.parents = std::move(parents);
+	accelerator.packets.clear();
+	accelerator.faces.clear();
+	accelerator.packet_leaves.clear();
+	accelerator.face_lanes.clear();
+	
+	std::size_t face_index_count = 0;
+	for (const mesh::face* face: faces)
+		face_index_count = std::max<std::size_t>(face_index_count, face->index + 1);
+	accelerator.face_lanes.resize(face_index_count, std::numeric_limits<std::uint32_t>::max());
+	
+	// Pack the triangles of each leaf, leaving unused lanes degenerate
+	for (std::uint32_t leaf_index = 0; leaf_index < accelerator.nodes.size(); ++leaf_index)
+	{
+		node& leaf = accelerator.nodes[leaf_index];
+		if (!leaf.count)
+			continue;
+		
+		const std::uint32_t first = leaf.offset;
+		leaf.offset = static_cast<std::uint32_t>(accelerator.packets.size());
+		
+		for (std::uint32_t i = 0; i < leaf.count; i += packet_size)
 		{
-			for (int i = 0; i < 8; ++i)
-				query_nearest_recursive(nearest_t, nearest_face, octree.child(node, i), ray);
+			accelerator.packets.emplace_back();
+			accelerator.packet_leaves.push_back(leaf_index);
+			
+			for (std::uint32_t j = 0; j < packet_size; ++j)
+			{
+				if (i + j >= leaf.count)
+				{
+					accelerator.faces.push_back(nullptr);
+					continue;
+				}
+				
+				const std::uint32_t index = indices[first + i + j];
+				const std::uint32_t lane = static_cast<std::uint32_t>(accelerator.faces.size());
+				accelerator.faces.push_back(faces[index]);
+				accelerator.face_lanes[faces[index]->index] = lane;
+				accelerator.pack(lane, vertices[index * 3], vertices[index * 3 + 1], vertices[index * 3 + 2]);
+			}
 		}
 	}
+	
+	faces.clear();
+	vertices.clear();
+	triangle_min_points.clear();
+	triangle_max_points.clear();
+	centroids.clear();
+	indices.clear();
 }
 
-aabb<float> mesh_accelerator::get_node_bounds(octree32::node_type node) const
+std::optional<mesh_accelerator::ray_query_result> mesh_accelerator::query_nearest(const ray<float>& ray) const
 {
-	// Decode Morton location of node
-	std::uint32_t x, y, z;
-	morton::decode(octree32::location(node), x, y, z);
-	float3 node_location = float3{static_cast<float>(x), static_cast<float>(y), static_cast<float>(z)};
-
-	// Get node dimensions at node depth
-	const float3& dimensions = node_dimensions[octree32::depth(node)];
-
-	// Calculate AABB
-	float3 min_point = (node_location * dimensions) - center_offset;
-	return aabb<float>{min_point, min_point + dimensions};
+	if (nodes.empty())
+		return std::nullopt;
+	
+	const float3 inverse_direction = {1.0f / ray.direction.x, 1.0f / ray.direction.y, 1.0f / ray.direction.z};
+	
+	float nearest_t = std::numeric_limits<float>::infinity();
+	std::uint32_t nearest_index = std::numeric_limits<std::uint32_t>::max();
+	
+	// Stack of far children, and the distances at which they are entered
+	std::pair<std::uint32_t, float> stack[max_depth];
+	std::size_t stack_size = 0;
+	
+	if (intersect_node(nodes[0], ray.origin, inverse_direction, nearest_t) == std::numeric_limits<float>::infinity())
+		return std::nullopt;
+	
+	std::uint32_t node_index = 0;
+	for (;;)
+	{
+		const node& node = nodes[node_index];
+		
+		if (node.count)
+		{
+			// Test the triangle packets of the leaf
+			const std::uint32_t packet_count = (node.count + packet_size - 1) / packet_size;
+			for (std::uint32_t i = node.offset; i < node.offset + packet_count; ++i)
+			{
+				float t[packet_size];
+				const unsigned int mask = ray_triangle_intersection(ray, packets[i], t);
+				
+				for (std::uint32_t j = 0; j < packet_size; ++j)
+				{
+					if ((mask & (1u << j)) && t[j] < nearest_t)
+					{
+						nearest_t = t[j];
+						nearest_index = i * packet_size + j;
+					}
+				}
+			}
+		}
+		else
+		{
+			// Visit the nearer child first, deferring the farther child
+			std::uint32_t near_index = node.offset;
+			std::uint32_t far_index = node.offset + 1;
+			float near_t = intersect_node(nodes[near_index], ray.origin, inverse_direction, nearest_t);
+			float far_t = intersect_node(nodes[far_index], ray.origin, inverse_direction, nearest_t);
+			if (far_t < near_t)
+			{
+				std::swap(near_index, far_index);
+				std::swap(near_t, far_t);
+			}
+			
+			if (near_t != std::numeric_limits<float>::infinity())
+			{
+				if (far_t != std::numeric_limits<float>::infinity())
+					stack[stack_size++] = {far_index, far_t};
+				
+				node_index = near_index;
+				continue;
+			}
+		}
+		
+		// Pop the next deferred node which may still contain a nearer intersection
+		while (stack_size && stack[stack_size - 1].second >= nearest_t)
+			--stack_size;
+		if (!stack_size)
+			break;
+		node_index = stack[--stack_size].first;
+	}
+	
+	if (nearest_index == std::numeric_limits<std::uint32_t>::max())
+		return std::nullopt;
+	
+	return ray_query_result{nearest_t, faces[nearest_index]};
 }
 
-octree32::node_type mesh_accelerator::find_node(const float3& point) const
+float mesh_accelerator::intersect_node(const node& node, const float3& origin, const float3& inverse_direction, float max_t)
 {
-	// Transform point to octree space
-	float3 transformed_point = (point + center_offset);
-
-	// Account for floating-point tolerance
-	const float epsilon = 0.00001f;
-	transformed_point.x = std::max<float>(0.0f, std::min<float>(node_dimensions[0].x - epsilon, transformed_point.x));
-	transformed_point.y = std::max<float>(0.0f, std::min<float>(node_dimensions[0].y - epsilon, transformed_point.y));
-	transformed_point.z = std::max<float>(0.0f, std::min<float>(node_dimensions[0].z - epsilon, transformed_point.z));
-
-	// Transform point to max-depth node space
-	transformed_point = transformed_point / node_dimensions[octree32::max_depth];
-
-	// Encode transformed point as a Morton location code
-	std::uint32_t location = morton::encode(
-		static_cast<std::uint32_t>(transformed_point.x),
-		static_cast<std::uint32_t>(transformed_point.y),
-		static_cast<std::uint32_t>(transformed_point.z));
-	
-	// Return max depth node at the determined location
-	return octree32::node(octree32::max_depth, location);
+	float t0 = 0.0f;
+	float t1 = max_t;
+	
+	for (int i = 0; i < 3; ++i)
+	{
+		const float tmin = (node.min_point[i] - origin[i]) * inverse_direction[i];
+		const float tmax = (node.max_point[i] - origin[i]) * inverse_direction[i];
+		
+		t0 = std::max<float>(t0, std::min<float>(tmin, tmax));
+		t1 = std::min<float>(t1, std::max<float>(tmin, tmax));
+	}
+	
+	return (t0 <= t1) ? t0 : std::numeric_limits<float>::infinity();
 }
 
 } // namespace geom
@@ -21,18 +21,23 @@
 #define ANTKEEPER_GEOM_MESH_ACCELERATOR_HPP
 
 #include "geom/mesh.hpp"
-#include "geom/octree.hpp"
 #include "geom/aabb.hpp"
 #include "geom/intersection.hpp"
+#include "geom/ray.hpp"
 #include "utility/fundamental-types.hpp"
-#include <list>
+#include <cstdint>
 #include <optional>
-#include <unordered_map>
+#include <utility>
+#include <vector>
 
 namespace geom {
 
 /**
  * Acceleration structure for querying mesh geometry.
+ *
+ * Triangles are organized into a flat bounding volume hierarchy, built with the binned surface area heuristic. Triangle vertex data is copied into packets in leaf order at build time, so ray queries read neither the half-edge structure nor scattered memory, and test the triangles of a leaf together.
+ *
+ * Builds may be time-sliced or moved off the calling thread with mesh_accelerator::builder. After vertices are moved without changing the topology of the mesh, the hierarchy can be refit to the new positions rather than rebuilt. Refitting is much faster than building, but query performance degrades as vertices move further from the positions the hierarchy was built for.
  */
 class mesh_accelerator
 {
@@ -43,12 +48,26 @@ public:
 		geom::mesh::face* face;
 	};
 
+	class builder;
+
 	mesh_accelerator();
 
 	/**
 	 * Builds the acceleration structure.
 	 */
 	void build(const mesh& mesh);
+	
+	/**
+	 * Refits the hierarchy to the current vertex positions of all faces. The topology of the mesh must not have changed since the build.
+	 */
+	void refit();
+	
+	/**
+	 * Refits the hierarchy to the current vertex positions of some faces, updating only the nodes which contain them. The topology of the mesh must not have changed since the build.
+	 *
+	 * @param moved_faces Faces with moved vertices.
+	 */
+	void refit(const std::vector<mesh::face*>& moved_faces);
 
 	/**
 	 * Finds the first intersection between a ray and a triangle in the mesh.
@@ -58,20 +77,161 @@ public:
 	 */
 	std::optional<ray_query_result> query_nearest(const ray<float>& ray) const;
 	
+	/**
+	 * Visits the leaf cells of the hierarchy.
+	 *
+	 * @param visitor Function object with the signature `void(const geom::aabb<float>&, std::size_t)`, called with the bounds and depth of each leaf.
+	 */
+	template <class Visitor>
+	void visit_leaves(Visitor visitor) const;
+	
 private:
-	aabb<float> get_node_bounds(octree32::node_type node) const;
-
-	void query_nearest_recursive(float& nearest_t, geom::mesh::face*& nearest_face, octree32::node_type node, const ray<float>& ray) const;
+	/**
+	 * BVH node. Leaf nodes reference a range of triangles, and internal nodes reference their two children, which are stored consecutively.
+	 */
+	struct node
+	{
+		float3 min_point;
+		
+		/// Index of the first triangle packet of a leaf node, or index of the first child of an internal node.
+		std::uint32_t offset;
+		
+		float3 max_point;
+		
+		/// Number of triangles in a leaf node, or `0` for an internal node.
+		std::uint32_t count;
+	};
+	
+	/// Number of triangles in a triangle packet.
+	static constexpr std::uint32_t packet_size = 4;
+	
+	/// Maximum number of triangles in a leaf node, unless a leaf cannot be split.
+	static constexpr std::uint32_t max_leaf_size = packet_size;
+	
+	/// Number of bins along each axis in which split planes are evaluated.
+	static constexpr std::size_t bin_count = 16;
+	
+	/// Maximum depth of the hierarchy, which bounds the traversal stack.
+	static constexpr std::size_t max_depth = 64;
+	
+	/**
+	 * Calculates the distance at which a ray enters a node.
+	 *
+	 * @param node Node to test.
+	 * @param origin Ray origin.
+	 * @param inverse_direction Reciprocal of the ray direction.
+	 * @param max_t Distance beyond which intersections are ignored.
+	 * @return Distance to the node, or infinity if the ray misses the node within @p max_t.
+	 */
+	static float intersect_node(const node& node, const float3& origin, const float3& inverse_direction, float max_t);
+	
+	/// Writes the vertices of a triangle into a packet lane.
+	void pack(std::uint32_t lane, const float3& a, const float3& b, const float3& c);
+	
+	/// Recalculates the bounds of a leaf node from its packets.
+	void fit_leaf(node& leaf) const;
+	
+	std::vector<node> nodes;
+	std::vector<triangle_packet<packet_size>> packets;
+	
+	/// Face of each packet lane, or `nullptr` for unused lanes.
+	std::vector<mesh::face*> faces;
+	
+	/// Parent of each node, with the root as its own parent.
+	std::vector<std::uint32_t> parents;
+	
+	/// Leaf node of each packet.
+	std::vector<std::uint32_t> packet_leaves;
+	
+	/// Packet lane of each face, indexed by face index.
+	std::vector<std::uint32_t> face_lanes;
+};
 
-	/// Returns the max-depth node in which the point is located
-	octree32::node_type find_node(const float3& point) const;
+/**
+ * Builds a mesh accelerator incrementally, splitting a bounded number of nodes per step.
+ *
+ * Triangle positions are copied from the mesh on construction, so the mesh may be edited while a builder runs on another thread. Faces are referenced by query results, and must outlive the built accelerator.
+ */
+class mesh_accelerator::builder
+{
+public:
+	/**
+	 * Prepares to build the accelerator of a mesh.
+	 *
+	 * @param mesh Mesh to accelerate.
+	 */
+	explicit builder(const mesh& mesh);
+	
+	/**
+	 * Splits nodes of the hierarchy.
+	 *
+	 * @param node_count Maximum number of nodes to process.
+	 * @return `true` if the hierarchy is complete, `false` otherwise.
+	 */
+	bool step(std::size_t node_count);
+	
+	/// Returns `true` if the hierarchy is complete.
+	bool is_done() const;
+	
+	/**
+	 * Completes the hierarchy, then packs the triangles of its leaves into an accelerator. The builder is left empty.
+	 *
+	 * @param[out] accelerator Accelerator to replace with the built one.
+	 */
+	void finish(mesh_accelerator& accelerator);
 
-	octree32 octree;
-	float3 node_dimensions[octree32::max_depth + 1];
-	float3 center_offset;
-	std::unordered_map<octree32::node_type, std::list<mesh::face*>> face_map;
+private:
+	std::vector<mesh::face*> faces;
+	
+	/// Vertex positions, three per triangle.
+	std::vector<float3> vertices;
+	
+	std::vector<float3> triangle_min_points;
+	std::vector<float3> triangle_max_points;
+	std::vector<float3> centroids;
+	
+	/// Triangle indices, partitioned in place as nodes are split.
+	std::vector<std::uint32_t> indices;
+	
+	std::vector<node> nodes;
+	std::vector<std::uint32_t> parents;
+	
+	/// Nodes yet to be processed, and their depths.
+	std::vector<std::pair<std::uint32_t, std::size_t>> stack;
 };
 
+inline bool mesh_accelerator::builder::is_done() const
+{
+	return stack.empty();
+}
+
+template <class Visitor>
+void mesh_accelerator::visit_leaves(Visitor visitor) const
+{
+	if (nodes.empty())
+		return;
+	
+	std::pair<std::uint32_t, std::size_t> stack[max_depth + 1];
+	std::size_t stack_size = 0;
+	stack[stack_size++] = {0, 0};
+	
+	while (stack_size)
+	{
+		const auto [index, depth] = stack[--stack_size];
+		const node& node = nodes[index];
+		
+		if (node.count)
+		{
+			visitor(geom::aabb<float>{node.min_point, node.max_point}, depth);
+		}
+		else
+		{
+			stack[stack_size++] = {node.offset + 1, depth + 1};
+			stack[stack_size++] = {node.offset, depth + 1};
+		}
+	}
+}
+
 } // namespace geom
 
 #endif // ANTKEEPER_GEOM_MESH_ACCELERATOR_HPP
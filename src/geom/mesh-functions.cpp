@@ -19,6 +19,7 @@
 
 #include "mesh-functions.hpp"
 #include "math/math.hpp"
+#include "utility/job-system.hpp"
 #include <unordered_map>
 
 namespace geom {
@@ -34,10 +35,14 @@ struct edge_hasher
 
 void create_triangle_mesh(mesh& mesh, const std::vector<float3>& vertices, const std::vector<std::array<std::uint_fast32_t, 3>>& triangles)
 {
+	// Reserve storage, assuming each edge is shared by two triangles
+	mesh.reserve(mesh.get_vertices().size() + vertices.size(), mesh.get_edges().size() + triangles.size() * 3 / 2, mesh.get_faces().size() + triangles.size());
+	
 	for (const auto& vertex: vertices)
 		mesh.add_vertex(vertex);
 
 	std::unordered_map<std::array<std::size_t, 2>, geom::mesh::edge*, edge_hasher> edge_map;
+	edge_map.reserve(triangles.size() * 3);
 	const std::vector<mesh::vertex*>& mesh_vertices = mesh.get_vertices();
 	std::vector<geom::mesh::edge*> loop(3);
 
@@ -72,21 +77,138 @@ void create_triangle_mesh(mesh& mesh, const std::vector<float3>& vertices, const
 	}
 }
 
-void calculate_face_normals(float3* normals, const mesh& mesh)
+namespace {
+
+/// Number of elements processed by each job of the parallel mesh functions.
+constexpr std::size_t parallel_grain = 4096;
+
+/// Number of triangles whose normals are computed together by accumulate_vertex_normals().
+constexpr std::size_t normal_block_size = 64;
+
+/// Calls a function over subranges of a range, in parallel if a job system is given.
+template <class Function>
+void for_each_range(job_system* jobs, std::size_t count, const Function& function)
+{
+	if (jobs && count > parallel_grain)
+		jobs->parallel_for(0, count, parallel_grain, function);
+	else
+		function(0, count);
+}
+
+} // namespace
+
+void calculate_face_normals(float3* normals, const mesh& mesh, job_system* jobs)
 {
 	const std::vector<mesh::face*>& faces = mesh.get_faces();
 
-	for (std::size_t i = 0; i < faces.size(); ++i)
-	{
-		const mesh::face& face = *(faces[i]);
-		const float3& a = face.edge->vertex->position;
-		const float3& b = face.edge->next->vertex->position;
-		const float3& c = face.edge->previous->vertex->position;
+	for_each_range(jobs, faces.size(),
+		[&](std::size_t first, std::size_t last)
+		{
+			for (std::size_t i = first; i < last; ++i)
+			{
+				const mesh::face& face = *(faces[i]);
+				const float3& a = face.edge->vertex->position;
+				const float3& b = face.edge->next->vertex->position;
+				const float3& c = face.edge->previous->vertex->position;
+
+				normals[i] = math::normalize(math::cross(b - a, c - a));
+			}
+		});
+}
 
-		normals[i] = math::normalize(math::cross(b - a, c - a));
+void accumulate_vertex_normals(float3* normals, const float* x, const float* y, const float* z, std::size_t stride, const std::uint32_t* indices, std::size_t triangle_count)
+{
+	float ex[2][normal_block_size];
+	float ey[2][normal_block_size];
+	float ez[2][normal_block_size];
+	float nx[normal_block_size];
+	float ny[normal_block_size];
+	float nz[normal_block_size];
+	
+	for (std::size_t first = 0; first < triangle_count; first += normal_block_size)
+	{
+		const std::size_t count = std::min(normal_block_size, triangle_count - first);
+		const std::uint32_t* block_indices = indices + first * 3;
+		
+		// Gather triangle edges
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			const std::size_t a = block_indices[i * 3] * stride;
+			const std::size_t b = block_indices[i * 3 + 1] * stride;
+			const std::size_t c = block_indices[i * 3 + 2] * stride;
+			
+			ex[0][i] = x[b] - x[a];
+			ey[0][i] = y[b] - y[a];
+			ez[0][i] = z[b] - z[a];
+			ex[1][i] = x[c] - x[a];
+			ey[1][i] = y[c] - y[a];
+			ez[1][i] = z[c] - z[a];
+		}
+		
+		// Calculate face normals, with lengths of twice the triangle areas
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			nx[i] = ey[0][i] * ez[1][i] - ez[0][i] * ey[1][i];
+			ny[i] = ez[0][i] * ex[1][i] - ex[0][i] * ez[1][i];
+			nz[i] = ex[0][i] * ey[1][i] - ey[0][i] * ex[1][i];
+		}
+		
+		// Scatter face normals to vertices
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			const float3 normal = {nx[i], ny[i], nz[i]};
+			normals[block_indices[i * 3]] += normal;
+			normals[block_indices[i * 3 + 1]] += normal;
+			normals[block_indices[i * 3 + 2]] += normal;
+		}
 	}
 }
 
+void calculate_vertex_normals(float3* normals, std::size_t vertex_count, const float* x, const float* y, const float* z, std::size_t stride, const std::uint32_t* indices, std::size_t triangle_count, job_system* jobs)
+{
+	// Partition triangles, one partition per thread
+	std::size_t partition_count = 1;
+	if (jobs)
+		partition_count = std::max<std::size_t>(1, std::min(jobs->get_thread_count() + 1, triangle_count / parallel_grain));
+	
+	// Accumulate face normals, with the first partition accumulating into the output and the others into their own buffers
+	std::fill(normals, normals + vertex_count, float3{0.0f, 0.0f, 0.0f});
+	std::vector<float3> partial_normals((partition_count - 1) * vertex_count, float3{0.0f, 0.0f, 0.0f});
+	const std::size_t partition_size = (triangle_count + partition_count - 1) / partition_count;
+	auto accumulate = [&](std::size_t first, std::size_t last)
+	{
+		for (std::size_t i = first; i < last; ++i)
+		{
+			const std::size_t first_triangle = i * partition_size;
+			const std::size_t last_triangle = std::min(triangle_count, first_triangle + partition_size);
+			if (first_triangle >= last_triangle)
+				continue;
+			
+			float3* partition_normals = (i) ? partial_normals.data() + (i - 1) * vertex_count : normals;
+			accumulate_vertex_normals(partition_normals, x, y, z, stride, indices + first_triangle * 3, last_triangle - first_triangle);
+		}
+	};
+	if (partition_count > 1)
+		jobs->parallel_for(0, partition_count, 1, accumulate);
+	else
+		accumulate(0, 1);
+	
+	// Sum partitions and normalize
+	for_each_range((partition_count > 1) ? jobs : nullptr, vertex_count,
+		[&](std::size_t first, std::size_t last)
+		{
+			for (std::size_t i = first; i < last; ++i)
+			{
+				float3 normal = normals[i];
+				for (std::size_t j = 1; j < partition_count; ++j)
+					normal += partial_normals[(j - 1) * vertex_count + i];
+				
+				const float length = math::length(normal);
+				normals[i] = (length > 0.0f) ? normal / length : float3{0.0f, 0.0f, 0.0f};
+			}
+		});
+}
+
 float3 calculate_face_normal(const mesh::face& face)
 {
 	const float3& a = face.edge->vertex->position;
@@ -95,70 +217,73 @@ float3 calculate_face_normal(const mesh::face& face)
 	return math::normalize(math::cross(b - a, c - a));
 }
 
-void calculate_vertex_tangents(float4* tangents, const float2* texcoords, const float3* normals, const mesh& mesh)
+void calculate_vertex_tangents(float4* tangents, const float2* texcoords, const float3* normals, const mesh& mesh, job_system* jobs)
 {
 	const std::vector<mesh::face*>& faces = mesh.get_faces();
 	const std::vector<mesh::vertex*>& vertices = mesh.get_vertices();
 	
-	// Allocate tangent and bitangent buffers
-	float3* tangent_buffer = new float3[vertices.size()];
-	float3* bitangent_buffer = new float3[vertices.size()];
-	for (std::size_t i = 0; i < vertices.size(); ++i)
-	{
-		tangent_buffer[i] = {0.0f, 0.0f, 0.0f};
-		bitangent_buffer[i] = {0.0f, 0.0f, 0.0f};
-	}
+	// Calculate faceted tangents and bitangents
+	std::vector<float3> face_tangents(faces.size());
+	std::vector<float3> face_bitangents(faces.size());
+	for_each_range(jobs, faces.size(),
+		[&](std::size_t first, std::size_t last)
+		{
+			for (std::size_t i = first; i < last; ++i)
+			{
+				const mesh::face& face = *(faces[i]);
+				std::size_t ia = face.edge->vertex->index;
+				std::size_t ib = face.edge->next->vertex->index;
+				std::size_t ic = face.edge->previous->vertex->index;
+				const float3& a = vertices[ia]->position;
+				const float3& b = vertices[ib]->position;
+				const float3& c = vertices[ic]->position;
+				const float2& uva = texcoords[ia];
+				const float2& uvb = texcoords[ib];
+				const float2& uvc = texcoords[ic];
+
+				float3 ba = b - a;
+				float3 ca = c - a;
+				float2 uvba = uvb - uva;
+				float2 uvca = uvc - uva;
+				
+				float f = 1.0f / (uvba.x * uvca.y - uvca.x * uvba.y);
+				face_tangents[i] = (ba * uvca.y - ca * uvba.y) * f;
+				face_bitangents[i] = (ba * -uvca.x + ca * uvba.x) * f;
+			}
+		});
 	
 	// Accumulate tangents and bitangents
+	std::vector<float3> tangent_buffer(vertices.size(), float3{0.0f, 0.0f, 0.0f});
+	std::vector<float3> bitangent_buffer(vertices.size(), float3{0.0f, 0.0f, 0.0f});
 	for (std::size_t i = 0; i < faces.size(); ++i)
 	{
 		const mesh::face& face = *(faces[i]);
-		std::size_t ia = face.edge->vertex->index;
-		std::size_t ib = face.edge->next->vertex->index;
-		std::size_t ic = face.edge->previous->vertex->index;
-		const float3& a = vertices[ia]->position;
-		const float3& b = vertices[ib]->position;
-		const float3& c = vertices[ic]->position;
-		const float2& uva = texcoords[ia];
-		const float2& uvb = texcoords[ib];
-		const float2& uvc = texcoords[ic];
-
-		float3 ba = b - a;
-		float3 ca = c - a;
-		float2 uvba = uvb - uva;
-		float2 uvca = uvc - uva;
-		
-		float f = 1.0f / (uvba.x * uvca.y - uvca.x * uvba.y);
-		float3 tangent = (ba * uvca.y - ca * uvba.y) * f;
-		float3 bitangent = (ba * -uvca.x + ca * uvba.x) * f;
-		
-		tangent_buffer[ia] += tangent;
-		tangent_buffer[ib] += tangent;
-		tangent_buffer[ic] += tangent;
-		bitangent_buffer[ia] += bitangent;
-		bitangent_buffer[ib] += bitangent;
-		bitangent_buffer[ic] += bitangent;
+		for (std::size_t index: {face.edge->vertex->index, face.edge->next->vertex->index, face.edge->previous->vertex->index})
+		{
+			tangent_buffer[index] += face_tangents[i];
+			bitangent_buffer[index] += face_bitangents[i];
+		}
 	}
 	
 	// Orthogonalize tangents
-	for (std::size_t i = 0; i < vertices.size(); ++i)
-	{
-		const float3& n = normals[i];
-		const float3& t = tangent_buffer[i];
-		const float3& b = bitangent_buffer[i];
-		
-		// Gram-Schmidt orthogonalize tangent
-		float3 tangent = math::normalize(t - n * math::dot(n, t));
-		
-		// Calculate bitangent sign
-		float bitangent_sign = (math::dot(math::cross(n, t), b) < 0.0f) ? -1.0f : 1.0f;
-		
-		tangents[i] = {tangent.x, tangent.y, tangent.z, bitangent_sign};
-	}
-	
-	// Free faceted tangents and bitangents
-	delete[] tangent_buffer;
-	delete[] bitangent_buffer;
+	for_each_range(jobs, vertices.size(),
+		[&](std::size_t first, std::size_t last)
+		{
+			for (std::size_t i = first; i < last; ++i)
+			{
+				const float3& n = normals[i];
+				const float3& t = tangent_buffer[i];
+				const float3& b = bitangent_buffer[i];
+				
+				// Gram-Schmidt orthogonalize tangent
+				float3 tangent = math::normalize(t - n * math::dot(n, t));
+				
+				// Calculate bitangent sign
+				float bitangent_sign = (math::dot(math::cross(n, t), b) < 0.0f) ? -1.0f : 1.0f;
+				
+				tangents[i] = {tangent.x, tangent.y, tangent.z, bitangent_sign};
+			}
+		});
 }
 
 aabb<float> calculate_bounds(const mesh& mesh)
@@ -234,4 +359,107 @@ mesh::vertex* poke_face(mesh& mesh, std::size_t index)
 	return nullptr;
 }
 
+float3 barycentric_to_cartesian(const mesh::face& face, const float3& barycentric)
+{
+	const mesh::edge* edge = face.edge;
+	return edge->vertex->position * barycentric[0] +
+		edge->next->vertex->position * barycentric[1] +
+		edge->previous->vertex->position * barycentric[2];
+}
+
+float3 walk_triangle_mesh(const mesh::face*& face, float3& barycentric, float3 displacement, std::size_t max_crossings)
+{
+	// Index of the barycentric coordinate held at zero while sliding along a boundary edge, or `3` if not sliding
+	std::size_t sliding = 3;
+	
+	for (std::size_t crossings = 0; ; ++crossings)
+	{
+		const mesh::edge* edges[3] = {face->edge, face->edge->next, face->edge->previous};
+		const float3& a = edges[0]->vertex->position;
+		const float3 ab = edges[1]->vertex->position - a;
+		const float3 ac = edges[2]->vertex->position - a;
+		
+		// Project the displacement onto the plane of the face
+		const float3 cross = math::cross(ab, ac);
+		const float cross_length = math::length(cross);
+		if (cross_length <= 0.0f)
+			break;
+		const float3 normal = cross / cross_length;
+		displacement -= normal * math::dot(displacement, normal);
+		
+		// Find the change in barycentric coordinates over the displacement
+		const float d00 = math::dot(ab, ab);
+		const float d01 = math::dot(ab, ac);
+		const float d11 = math::dot(ac, ac);
+		const float d20 = math::dot(displacement, ab);
+		const float d21 = math::dot(displacement, ac);
+		const float denominator = d00 * d11 - d01 * d01;
+		float3 delta;
+		delta[1] = (d11 * d20 - d01 * d21) / denominator;
+		delta[2] = (d00 * d21 - d01 * d20) / denominator;
+		delta[0] = -delta[1] - delta[2];
+		if (sliding < 3)
+		{
+			delta[(sliding + 1) % 3] += delta[sliding];
+			delta[sliding] = 0.0f;
+		}
+		
+		// Find the first coordinate to reach zero, at which the point leaves the face
+		float t = 1.0f;
+		std::size_t exit = 3;
+		for (std::size_t i = 0; i < 3; ++i)
+		{
+			if (delta[i] < 0.0f && barycentric[i] + delta[i] < 0.0f)
+			{
+				const float t_i = std::max(0.0f, -barycentric[i] / delta[i]);
+				if (t_i < t)
+				{
+					t = t_i;
+					exit = i;
+				}
+			}
+		}
+		
+		barycentric += delta * t;
+		if (exit == 3 || crossings == max_crossings)
+			break;
+		barycentric[exit] = 0.0f;
+		displacement *= 1.0f - t;
+		
+		// The edge opposite the exit corner starts at the corner after it
+		const mesh::edge* edge = edges[(exit + 1) % 3];
+		const mesh::edge* symmetric = edge->symmetric;
+		if (!symmetric || !symmetric->face)
+		{
+			// Slide along the boundary edge
+			const float3 direction = math::normalize(edge->next->vertex->position - edge->vertex->position);
+			displacement = direction * math::dot(displacement, direction);
+			sliding = exit;
+			continue;
+		}
+		
+		// Fold the rest of the displacement about the edge into the plane of the adjacent face
+		const mesh::face* next_face = symmetric->face;
+		const float3 direction = math::normalize(edge->next->vertex->position - edge->vertex->position);
+		const float3 next_normal = calculate_face_normal(*next_face);
+		displacement = direction * math::dot(displacement, direction) +
+			math::cross(next_normal, direction) * math::dot(displacement, math::cross(normal, direction));
+		
+		// Transfer the coordinates of the edge, which are reversed on the adjacent face
+		const float start_weight = barycentric[(exit + 1) % 3];
+		const float end_weight = barycentric[(exit + 2) % 3];
+		std::size_t k = 0;
+		for (const mesh::edge* next_edge = next_face->edge; next_edge != symmetric; next_edge = next_edge->next)
+			++k;
+		barycentric[k] = end_weight;
+		barycentric[(k + 1) % 3] = start_weight;
+		barycentric[(k + 2) % 3] = 0.0f;
+		
+		face = next_face;
+		sliding = 3;
+	}
+	
+	return barycentric_to_cartesian(*face, barycentric);
+}
+
 } // namespace geom
@@ -24,8 +24,11 @@
 #include "geom/mesh.hpp"
 #include "utility/fundamental-types.hpp"
 #include <array>
+#include <cstdint>
 #include <vector>
 
+class job_system;
+
 namespace geom {
 
 /**
@@ -42,8 +45,41 @@ void create_triangle_mesh(mesh& mesh, const std::vector<float3>& vertices, const
  * Calculates normals for each face.
  *
  * @param[out] Array in which faceted normals will be stored.
+ * @param jobs Job system over which faces are partitioned, or `nullptr` to calculate normals on the calling thread.
+ */
+void calculate_face_normals(float3* normals, const mesh& mesh, job_system* jobs = nullptr);
+
+/**
+ * Adds the area-weighted normals of indexed triangles to the normals of their vertices, without normalizing.
+ *
+ * Triangles are processed in blocks, the cross products of which are computed in structure-of-arrays form so that they vectorize.
+ *
+ * @param[in,out] normals Vertex normals to which face normals are added.
+ * @param x Array of vertex x-coordinates.
+ * @param y Array of vertex y-coordinates.
+ * @param z Array of vertex z-coordinates.
+ * @param stride Number of floats between the coordinates of consecutive vertices: `1` for separate coordinate arrays, or `3` for an array of `float3`.
+ * @param indices Array of three vertex indices per triangle.
+ * @param triangle_count Number of triangles.
+ */
+void accumulate_vertex_normals(float3* normals, const float* x, const float* y, const float* z, std::size_t stride, const std::uint32_t* indices, std::size_t triangle_count);
+
+/**
+ * Calculates area-weighted vertex normals of indexed triangles. Vertices without any triangle of nonzero area have zero normals.
+ *
+ * @param[out] normals Array in which vertex normals will be stored.
+ * @param vertex_count Number of vertices.
+ * @param x Array of vertex x-coordinates.
+ * @param y Array of vertex y-coordinates.
+ * @param z Array of vertex z-coordinates.
+ * @param stride Number of floats between the coordinates of consecutive vertices.
+ * @param indices Array of three vertex indices per triangle.
+ * @param triangle_count Number of triangles.
+ * @param jobs Job system over which triangles are partitioned, each partition accumulating into its own buffer, or `nullptr` to calculate normals on the calling thread.
+ *
+ * @see accumulate_vertex_normals()
  */
-void calculate_face_normals(float3* normals, const mesh& mesh);
+void calculate_vertex_normals(float3* normals, std::size_t vertex_count, const float* x, const float* y, const float* z, std::size_t stride, const std::uint32_t* indices, std::size_t triangle_count, job_system* jobs = nullptr);
 
 float3 calculate_face_normal(const mesh::face& face);
 
@@ -53,8 +89,9 @@ float3 calculate_face_normal(const mesh::face& face);
  * @param[out] tangents Array in which vertex tangents will be stored. A bitangent sign is stored in each tangent vector's fourth component.
  * @param[in] texcoords Array containing vertex texture coordinates.
  * @param[in] normals Array containing vertex normals.
+ * @param jobs Job system over which faces and vertices are partitioned, or `nullptr` to calculate tangents on the calling thread.
  */
-void calculate_vertex_tangents(float4* tangents, const float2* texcoords, const float3* normals, const mesh& mesh);
+void calculate_vertex_tangents(float4* tangents, const float2* texcoords, const float3* normals, const mesh& mesh, job_system* jobs = nullptr);
 
 /**
  * Calculates the AABB bounds of a mesh.
@@ -70,6 +107,28 @@ aabb<float> calculate_bounds(const mesh& mesh);
  */
 mesh::vertex* poke_face(mesh& mesh, std::size_t index);
 
+/**
+ * Returns the position of a point on a triangle, given its barycentric coordinates.
+ *
+ * @param face Triangle face.
+ * @param barycentric Barycentric coordinates of the point, with respect to the vertices at which the first, second, and third edges of the face start.
+ * @return Position of the point.
+ */
+float3 barycentric_to_cartesian(const mesh::face& face, const float3& barycentric);
+
+/**
+ * Moves a point across the surface of a triangle mesh by following the adjacency of its faces, without any spatial queries.
+ *
+ * The displacement is projected onto the plane of the point's face. Each time the point reaches an edge, it crosses into the face on the other side, and the rest of the displacement is folded about the edge into the plane of that face, so that the distance covered along the surface is kept. At boundary edges, the point slides along the edge instead. To rebind a point to a remeshed surface, walk from any face near it, such as a face around a welded vertex of its former face, toward its former position.
+ *
+ * @param[in,out] face Face on which the point lies, updated to the face on which it comes to rest.
+ * @param[in,out] barycentric Barycentric coordinates of the point on its face.
+ * @param displacement Displacement of the point.
+ * @param max_crossings Maximum number of edges the point may cross, which bounds the cost of a single step on degenerate meshes.
+ * @return Position at which the point comes to rest.
+ */
+float3 walk_triangle_mesh(const mesh::face*& face, float3& barycentric, float3 displacement, std::size_t max_crossings = 64);
+
 } // namespace geom
 
 #endif // ANTKEEPER_GEOM_MESH_FUNCTIONS_HPP
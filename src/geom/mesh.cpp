@@ -34,6 +34,9 @@ mesh::~mesh()
 
 mesh& mesh::operator=(const mesh& other)
 {
+	if (this == &other)
+		return *this;
+	
 	// Clear the mesh
 	clear();
 	
@@ -41,22 +44,24 @@ mesh& mesh::operator=(const mesh& other)
 	vertices.resize(other.vertices.size());
 	edges.resize(other.edges.size());
 	faces.resize(other.faces.size());
+	reserve(vertices.size(), edges.size(), faces.size());
 	
 	// Allocate vertices
 	for (std::size_t i = 0; i < vertices.size(); ++i)
-		vertices[i] = new vertex();
+		vertices[i] = vertex_pool.allocate();
 	
 	// Allocate edges
 	for (std::size_t i = 0; i < edges.size(); ++i)
 	{
-		edges[i] = new edge();
-		edges[i]->symmetric = new edge();
+		edge_pair* pair = edge_pool.allocate();
+		edges[i] = &pair->edge;
+		edges[i]->symmetric = &pair->symmetric;
 		edges[i]->symmetric->symmetric = edges[i];
 	}
 	
 	// Allocate faces
 	for (std::size_t i = 0; i < faces.size(); ++i)
-		faces[i] = new face();
+		faces[i] = face_pool.allocate();
 	
 	// Copy vertices
 	for (std::size_t i = 0; i < vertices.size(); ++i)
@@ -122,29 +127,30 @@ mesh& mesh::operator=(const mesh& other)
 
 void mesh::clear()
 {
-	// Deallocate vertices
-	for (mesh::vertex* vertex: vertices)
-		delete vertex;
-
-	// Deallocate edges
-	for (mesh::edge* edge: edges)
-	{
-		delete edge->symmetric;
-		delete edge;
-	}
-
-	// Deallocate faces
-	for (mesh::face* face: faces)
-		delete face;
+	// Deallocate all elements at once, keeping pool blocks for reuse
+	vertex_pool.clear();
+	edge_pool.clear();
+	face_pool.clear();
 	
 	vertices.clear();
 	edges.clear();
 	faces.clear();
 }
 
+void mesh::reserve(std::size_t vertex_count, std::size_t edge_count, std::size_t face_count)
+{
+	vertices.reserve(vertex_count);
+	edges.reserve(edge_count);
+	faces.reserve(face_count);
+	
+	vertex_pool.reserve(vertex_count - std::min(vertex_count, vertices.size()));
+	edge_pool.reserve(edge_count - std::min(edge_count, edges.size()));
+	face_pool.reserve(face_count - std::min(face_count, faces.size()));
+}
+
 mesh::vertex* mesh::add_vertex(const float3& position)
 {
-	mesh::vertex* vertex = new mesh::vertex();
+	mesh::vertex* vertex = vertex_pool.allocate();
 	vertex->edge = nullptr;
 	vertex->position = position;
 	vertex->index = vertices.size();
@@ -155,8 +161,9 @@ mesh::vertex* mesh::add_vertex(const float3& position)
 
 mesh::edge* mesh::add_edge(mesh::vertex* a, mesh::vertex* b)
 {
-	mesh::edge* ab = new mesh::edge();
-	mesh::edge* ba = new mesh::edge();
+	edge_pair* pair = edge_pool.allocate();
+	mesh::edge* ab = &pair->edge;
+	mesh::edge* ba = &pair->symmetric;
 
 	ab->vertex = a;
 	ab->face = nullptr;
@@ -242,7 +249,7 @@ mesh::face* mesh::add_face(const loop& loop)
 	}
 
 	// Create face
-	mesh::face* face = new mesh::face();
+	mesh::face* face = face_pool.allocate();
 	face->edge = loop[0];
 	face->index = faces.size();
 
@@ -279,7 +286,7 @@ void mesh::remove_face(mesh::face* face)
 	faces.erase(faces.begin() + face->index);
 
 	// Deallocate face
-	delete face;
+	face_pool.deallocate(face);
 }
 
 void mesh::remove_edge(mesh::edge* edge)
@@ -309,6 +316,9 @@ void mesh::remove_edge(mesh::edge* edge)
 	b_in->next = b_out;
 	b_out->previous = b_in;
 
+	// Find the pair of half-edges, which may be given by either half
+	edge_pair* pair = get_pair(edges[edge->index]);
+	
 	// Adjust indices of edges after this edge
 	for (std::size_t i = edge->index + 1; i < edges.size(); ++i)
 	{
@@ -320,8 +330,7 @@ void mesh::remove_edge(mesh::edge* edge)
 	edges.erase(edges.begin() + edge->index);
 
 	// Deallocate edge
-	delete edge->symmetric;
-	delete edge;
+	edge_pool.deallocate(pair);
 }
 
 void mesh::remove_vertex(mesh::vertex* vertex)
@@ -357,7 +366,7 @@ void mesh::remove_vertex(mesh::vertex* vertex)
 	vertices.erase(vertices.begin() + vertex->index);
 
 	// Deallocate vertex
-	delete vertex;
+	vertex_pool.deallocate(vertex);
 }
 
 mesh::edge* mesh::find_free_incident(mesh::vertex* vertex) const
@@ -20,6 +20,8 @@
 #ifndef ANTKEEPER_GEOM_MESH_HPP
 #define ANTKEEPER_GEOM_MESH_HPP
 
+#include <algorithm>
+#include <memory>
 #include <vector>
 #include "utility/fundamental-types.hpp"
 
@@ -28,6 +30,8 @@ namespace geom {
 /**
  * Half-edge mesh.
  *
+ * Vertices, edges, and faces are allocated from chunked pools, in which they keep stable addresses in contiguous blocks. The two halves of an edge are allocated together, and the slots of removed elements are recycled. Clearing a mesh keeps its blocks for reuse, and copying a mesh reserves a single block per pool.
+ *
  * @see http://kaba.hilvi.org/homepage/blog/halfedge/halfedge.htm
  */
 class mesh
@@ -56,6 +60,15 @@ public:
 	
 	/// Removes all vertices, edges, and faces from the mesh.
 	void clear();
+	
+	/**
+	 * Reserves storage, so that vertices, edges, and faces can be added up to the given totals without further allocations.
+	 *
+	 * @param vertex_count Total number of vertices.
+	 * @param edge_count Total number of edges, each of which consists of two half-edges.
+	 * @param face_count Total number of faces.
+	 */
+	void reserve(std::size_t vertex_count, std::size_t edge_count, std::size_t face_count);
 
 	/**
 	 * Adds a vertex to the mesh. This vertex initially has a null edge.
@@ -169,15 +182,133 @@ public:
 	};
 
 private:
+	/**
+	 * Chunked storage of elements at stable addresses, which recycles the slots of deallocated elements.
+	 *
+	 * @tparam T Element type.
+	 */
+	template <class T>
+	class pool
+	{
+	public:
+		/// Returns a value-initialized element.
+		T* allocate();
+		
+		/// Returns an element to the pool.
+		void deallocate(T* element);
+		
+		/// Ensures that at least @p count elements can be allocated without allocating a new block.
+		void reserve(std::size_t count);
+		
+		/// Deallocates all elements, keeping the allocated blocks.
+		void clear();
+		
+	private:
+		/// Minimum number of elements in a block.
+		static constexpr std::size_t min_block_size = 256;
+		
+		std::vector<std::unique_ptr<T[]>> blocks;
+		std::vector<std::size_t> block_sizes;
+		std::vector<T*> free_list;
+		
+		/// Index of the block from which elements are currently allocated.
+		std::size_t block_index = 0;
+		
+		/// Number of elements allocated from the current block.
+		std::size_t block_offset = 0;
+	};
+	
+	/// Both halves of an edge, with the half stored in the edges vector first.
+	struct edge_pair
+	{
+		mesh::edge edge;
+		mesh::edge symmetric;
+	};
+	
 	mesh::edge* find_free_incident(mesh::vertex* vertex) const;
 	mesh::edge* find_free_incident(mesh::edge* start_edge, mesh::edge* end_edge) const;
 	bool make_adjacent(mesh::edge* in_edge, mesh::edge* out_edge);
+	
+	/// Returns the pair to which a half-edge stored in the edges vector belongs.
+	static edge_pair* get_pair(mesh::edge* edge);
 
 	std::vector<mesh::vertex*> vertices;
 	std::vector<mesh::edge*> edges;
 	std::vector<mesh::face*> faces;
+	
+	pool<mesh::vertex> vertex_pool;
+	pool<edge_pair> edge_pool;
+	pool<mesh::face> face_pool;
 };
 
+template <class T>
+T* mesh::pool<T>::allocate()
+{
+	T* element;
+	
+	if (!free_list.empty())
+	{
+		// Recycle a deallocated element
+		element = free_list.back();
+		free_list.pop_back();
+	}
+	else
+	{
+		// Advance to the next block with free elements, allocating one if necessary
+		while (block_index < blocks.size() && block_offset == block_sizes[block_index])
+		{
+			++block_index;
+			block_offset = 0;
+		}
+		if (block_index == blocks.size())
+		{
+			const std::size_t size = std::max<std::size_t>(min_block_size, (block_sizes.empty()) ? 0 : block_sizes.back() * 2);
+			blocks.emplace_back(new T[size]);
+			block_sizes.push_back(size);
+		}
+		
+		element = &blocks[block_index][block_offset++];
+	}
+	
+	*element = T();
+	return element;
+}
+
+template <class T>
+inline void mesh::pool<T>::deallocate(T* element)
+{
+	free_list.push_back(element);
+}
+
+template <class T>
+void mesh::pool<T>::reserve(std::size_t count)
+{
+	// Count free elements in the current and following blocks
+	std::size_t available = free_list.size();
+	for (std::size_t i = block_index; i < blocks.size() && available < count; ++i)
+		available += block_sizes[i] - ((i == block_index) ? block_offset : 0);
+	
+	if (available < count)
+	{
+		const std::size_t size = std::max<std::size_t>(min_block_size, count - available);
+		blocks.emplace_back(new T[size]);
+		block_sizes.push_back(size);
+	}
+}
+
+template <class T>
+inline void mesh::pool<T>::clear()
+{
+	free_list.clear();
+	block_index = 0;
+	block_offset = 0;
+}
+
+inline mesh::edge_pair* mesh::get_pair(mesh::edge* edge)
+{
+	return reinterpret_cast<edge_pair*>(edge);
+}
+
 inline const std::vector<mesh::vertex*>& mesh::get_vertices() const
 {
 	return vertices;
@@ -0,0 +1,176 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "geom/morton.hpp"
+
+#if !defined(ANTKEEPER_GEOM_MORTON_BMI2) && (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+	#include <immintrin.h>
+	#define ANTKEEPER_GEOM_MORTON_RUNTIME_BMI2
+#endif
+
+namespace geom {
+namespace morton {
+
+#if defined(ANTKEEPER_GEOM_MORTON_RUNTIME_BMI2)
+
+/// Returns `true` if the CPU supports BMI2, detected once.
+static bool has_bmi2()
+{
+	static const bool supported = __builtin_cpu_supports("bmi2");
+	return supported;
+}
+
+/// Batch kernels compiled for BMI2, called only if the CPU supports it.
+/// @{
+__attribute__((target("bmi2"))) static void encode_bmi2(const std::uint32_t* x, const std::uint32_t* y, std::uint32_t* codes, std::size_t count)
+{
+	for (std::size_t i = 0; i < count; ++i)
+		codes[i] = _pdep_u32(x[i], detail::mask2<std::uint32_t>) | _pdep_u32(y[i], detail::mask2<std::uint32_t> << 1);
+}
+
+__attribute__((target("bmi2"))) static void encode_bmi2(const std::uint64_t* x, const std::uint64_t* y, std::uint64_t* codes, std::size_t count)
+{
+	for (std::size_t i = 0; i < count; ++i)
+		codes[i] = _pdep_u64(x[i], detail::mask2<std::uint64_t>) | _pdep_u64(y[i], detail::mask2<std::uint64_t> << 1);
+}
+
+__attribute__((target("bmi2"))) static void encode_bmi2(const std::uint32_t* x, const std::uint32_t* y, const std::uint32_t* z, std::uint32_t* codes, std::size_t count)
+{
+	for (std::size_t i = 0; i < count; ++i)
+		codes[i] = _pdep_u32(x[i], detail::mask3<std::uint32_t>) | _pdep_u32(y[i], detail::mask3<std::uint32_t> << 1) | _pdep_u32(z[i], detail::mask3<std::uint32_t> << 2);
+}
+
+__attribute__((target("bmi2"))) static void encode_bmi2(const std::uint64_t* x, const std::uint64_t* y, const std::uint64_t* z, std::uint64_t* codes, std::size_t count)
+{
+	for (std::size_t i = 0; i < count; ++i)
+		codes[i] = _pdep_u64(x[i], detail::mask3<std::uint64_t>) | _pdep_u64(y[i], detail::mask3<std::uint64_t> << 1) | _pdep_u64(z[i], detail::mask3<std::uint64_t> << 2);
+}
+
+__attribute__((target("bmi2"))) static void decode_bmi2(const std::uint32_t* codes, std::uint32_t* x, std::uint32_t* y, std::size_t count)
+{
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		x[i] = _pext_u32(codes[i], detail::mask2<std::uint32_t>);
+		y[i] = _pext_u32(codes[i], detail::mask2<std::uint32_t> << 1);
+	}
+}
+
+__attribute__((target("bmi2"))) static void decode_bmi2(const std::uint64_t* codes, std::uint64_t* x, std::uint64_t* y, std::size_t count)
+{
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		x[i] = _pext_u64(codes[i], detail::mask2<std::uint64_t>);
+		y[i] = _pext_u64(codes[i], detail::mask2<std::uint64_t> << 1);
+	}
+}
+
+__attribute__((target("bmi2"))) static void decode_bmi2(const std::uint32_t* codes, std::uint32_t* x, std::uint32_t* y, std::uint32_t* z, std::size_t count)
+{
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		x[i] = _pext_u32(codes[i], detail::mask3<std::uint32_t>);
+		y[i] = _pext_u32(codes[i], detail::mask3<std::uint32_t> << 1);
+		z[i] = _pext_u32(codes[i], detail::mask3<std::uint32_t> << 2);
+	}
+}
+
+__attribute__((target("bmi2"))) static void decode_bmi2(const std::uint64_t* codes, std::uint64_t* x, std::uint64_t* y, std::uint64_t* z, std::size_t count)
+{
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		x[i] = _pext_u64(codes[i], detail::mask3<std::uint64_t>);
+		y[i] = _pext_u64(codes[i], detail::mask3<std::uint64_t> << 1);
+		z[i] = _pext_u64(codes[i], detail::mask3<std::uint64_t> << 2);
+	}
+}
+/// @}
+
+#define ANTKEEPER_GEOM_MORTON_DISPATCH(kernel, ...) \
+	if (has_bmi2()) \
+	{ \
+		kernel(__VA_ARGS__); \
+		return; \
+	}
+
+#else
+
+#define ANTKEEPER_GEOM_MORTON_DISPATCH(kernel, ...)
+
+#endif
+
+void encode_n(const std::uint32_t* x, const std::uint32_t* y, std::uint32_t* codes, std::size_t count)
+{
+	ANTKEEPER_GEOM_MORTON_DISPATCH(encode_bmi2, x, y, codes, count)
+	for (std::size_t i = 0; i < count; ++i)
+		codes[i] = encode<std::uint32_t>(x[i], y[i]);
+}
+
+void encode_n(const std::uint64_t* x, const std::uint64_t* y, std::uint64_t* codes, std::size_t count)
+{
+	ANTKEEPER_GEOM_MORTON_DISPATCH(encode_bmi2, x, y, codes, count)
+	for (std::size_t i = 0; i < count; ++i)
+		codes[i] = encode<std::uint64_t>(x[i], y[i]);
+}
+
+void encode_n(const std::uint32_t* x, const std::uint32_t* y, const std::uint32_t* z, std::uint32_t* codes, std::size_t count)
+{
+	ANTKEEPER_GEOM_MORTON_DISPATCH(encode_bmi2, x, y, z, codes, count)
+	for (std::size_t i = 0; i < count; ++i)
+		codes[i] = encode<std::uint32_t>(x[i], y[i], z[i]);
+}
+
+void encode_n(const std::uint64_t* x, const std::uint64_t* y, const std::uint64_t* z, std::uint64_t* codes, std::size_t count)
+{
+	ANTKEEPER_GEOM_MORTON_DISPATCH(encode_bmi2, x, y, z, codes, count)
+	for (std::size_t i = 0; i < count; ++i)
+		codes[i] = encode<std::uint64_t>(x[i], y[i], z[i]);
+}
+
+void decode_n(const std::uint32_t* codes, std::uint32_t* x, std::uint32_t* y, std::size_t count)
+{
+	ANTKEEPER_GEOM_MORTON_DISPATCH(decode_bmi2, codes, x, y, count)
+	for (std::size_t i = 0; i < count; ++i)
+		decode<std::uint32_t>(codes[i], x[i], y[i]);
+}
+
+void decode_n(const std::uint64_t* codes, std::uint64_t* x, std::uint64_t* y, std::size_t count)
+{
+	ANTKEEPER_GEOM_MORTON_DISPATCH(decode_bmi2, codes, x, y, count)
+	for (std::size_t i = 0; i < count; ++i)
+		decode<std::uint64_t>(codes[i], x[i], y[i]);
+}
+
+void decode_n(const std::uint32_t* codes, std::uint32_t* x, std::uint32_t* y, std::uint32_t* z, std::size_t count)
+{
+	ANTKEEPER_GEOM_MORTON_DISPATCH(decode_bmi2, codes, x, y, z, count)
+	for (std::size_t i = 0; i < count; ++i)
+		decode<std::uint32_t>(codes[i], x[i], y[i], z[i]);
+}
+
+void decode_n(const std::uint64_t* codes, std::uint64_t* x, std::uint64_t* y, std::uint64_t* z, std::size_t count)
+{
+	ANTKEEPER_GEOM_MORTON_DISPATCH(decode_bmi2, codes, x, y, z, count)
+	for (std::size_t i = 0; i < count; ++i)
+		decode<std::uint64_t>(codes[i], x[i], y[i], z[i]);
+}
+
+#undef ANTKEEPER_GEOM_MORTON_DISPATCH
+
+} // namespace morton
+} // namespace geom
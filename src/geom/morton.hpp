@@ -21,11 +21,22 @@
 #define ANTKEEPER_GEOM_MORTON_HPP
 
 #include <array>
+#include <cstddef>
+#include <cstdint>
 #include <cstdlib>
 
+#if defined(__BMI2__)
+	#include <immintrin.h>
+	#define ANTKEEPER_GEOM_MORTON_BMI2
+#endif
+
 namespace geom {
 
-/// Morton location code encoding and decoding functions.
+/**
+ * Morton location code encoding and decoding functions.
+ *
+ * 32- and 64-bit codes are encoded and decoded with the `pdep` and `pext` instructions when BMI2 is enabled at compile time. Otherwise, they are encoded with 256-entry lookup tables, which spread a byte of a coordinate per lookup, and decoded with shifts and masks, which outperform lookup tables for decoding. The batched functions additionally detect BMI2 at runtime.
+ */
 namespace morton {
 
 /**
@@ -70,73 +81,192 @@ void decode(T code, T& x, T& y);
 template <typename T>
 void decode(T code, T& x, T& y, T& z);
 
+/**
+ * Encodes arrays of 2D coordinates as Morton location codes, using BMI2 if the CPU supports it.
+ *
+ * @param[in] x Array of x-coordinates.
+ * @param[in] y Array of y-coordinates.
+ * @param[out] codes Array of Morton location codes.
+ * @param[in] count Number of coordinates.
+ */
+/// @{
+void encode_n(const std::uint32_t* x, const std::uint32_t* y, std::uint32_t* codes, std::size_t count);
+void encode_n(const std::uint64_t* x, const std::uint64_t* y, std::uint64_t* codes, std::size_t count);
+/// @}
+
+/**
+ * Encodes arrays of 3D coordinates as Morton location codes, using BMI2 if the CPU supports it.
+ *
+ * @param[in] x Array of x-coordinates.
+ * @param[in] y Array of y-coordinates.
+ * @param[in] z Array of z-coordinates.
+ * @param[out] codes Array of Morton location codes.
+ * @param[in] count Number of coordinates.
+ */
+/// @{
+void encode_n(const std::uint32_t* x, const std::uint32_t* y, const std::uint32_t* z, std::uint32_t* codes, std::size_t count);
+void encode_n(const std::uint64_t* x, const std::uint64_t* y, const std::uint64_t* z, std::uint64_t* codes, std::size_t count);
+/// @}
+
+/**
+ * Decodes arrays of 2D coordinates from Morton location codes, using BMI2 if the CPU supports it.
+ *
+ * @param[in] codes Array of Morton location codes.
+ * @param[out] x Array of decoded x-coordinates.
+ * @param[out] y Array of decoded y-coordinates.
+ * @param[in] count Number of codes.
+ */
+/// @{
+void decode_n(const std::uint32_t* codes, std::uint32_t* x, std::uint32_t* y, std::size_t count);
+void decode_n(const std::uint64_t* codes, std::uint64_t* x, std::uint64_t* y, std::size_t count);
+/// @}
+
+/**
+ * Decodes arrays of 3D coordinates from Morton location codes, using BMI2 if the CPU supports it.
+ *
+ * @param[in] codes Array of Morton location codes.
+ * @param[out] x Array of decoded x-coordinates.
+ * @param[out] y Array of decoded y-coordinates.
+ * @param[out] z Array of decoded z-coordinates.
+ * @param[in] count Number of codes.
+ */
+/// @{
+void decode_n(const std::uint32_t* codes, std::uint32_t* x, std::uint32_t* y, std::uint32_t* z, std::size_t count);
+void decode_n(const std::uint64_t* codes, std::uint64_t* x, std::uint64_t* y, std::uint64_t* z, std::size_t count);
+/// @}
+
+namespace detail {
+
+/// Masks of the bits of the x-coordinate in 2D and 3D Morton location codes. The bits of the other coordinates are the same masks shifted left by one and two bits.
+template <typename T> constexpr T mask2 = static_cast<T>(0x5555555555555555);
+template <typename T> constexpr T mask3 = static_cast<T>(0x1249249249249249 & (~std::uint64_t(0) >> (64 - (sizeof(T) * 8 / 3) * 3)));
+
+/// Builds a table which spreads the bits of a byte so that consecutive bits are separated by a stride.
+template <typename E, std::size_t Stride>
+constexpr std::array<E, 256> make_spread_table()
+{
+	std::array<E, 256> table{};
+	for (std::size_t i = 0; i < 256; ++i)
+	{
+		E value = 0;
+		for (std::size_t bit = 0; bit < 8; ++bit)
+			if ((i >> bit) & 1)
+				value |= static_cast<E>(E(1) << (bit * Stride));
+		table[i] = value;
+	}
+	return table;
+}
+
+/// Spreads a byte to every second bit.
+inline constexpr std::array<std::uint16_t, 256> spread2_table = make_spread_table<std::uint16_t, 2>();
+
+/// Spreads a byte to every third bit.
+inline constexpr std::array<std::uint32_t, 256> spread3_table = make_spread_table<std::uint32_t, 3>();
+
+/// Spreads the low bits of a coordinate, one byte per lookup, so that consecutive bits are separated by a stride.
+template <typename T, std::size_t Stride, class Table>
+inline T spread(T x, const Table& table)
+{
+	constexpr std::size_t bits = sizeof(T) * 8 / Stride;
+	x &= static_cast<T>(~std::uint64_t(0) >> (64 - bits));
+	
+	T result = 0;
+	for (std::size_t shift = 0; shift < bits; shift += 8)
+		result |= static_cast<T>(static_cast<T>(table[(x >> shift) & 0xff]) << (shift * Stride));
+	return result;
+}
+
+} // namespace detail
+
 template <typename T>
 T encode(T x, T y)
 {
-	auto expand = [](T x) -> T
+	#if defined(ANTKEEPER_GEOM_MORTON_BMI2)
+		if constexpr (sizeof(T) == 4)
+			return static_cast<T>(_pdep_u32(x, detail::mask2<std::uint32_t>) | _pdep_u32(y, detail::mask2<std::uint32_t> << 1));
+		else if constexpr (sizeof(T) == 8)
+			return static_cast<T>(_pdep_u64(x, detail::mask2<std::uint64_t>) | _pdep_u64(y, detail::mask2<std::uint64_t> << 1));
+	#endif
+	
+	if constexpr (sizeof(T) >= 4)
 	{
-		x &= (1 << (sizeof(T) << 2)) - 1;
-		
-		if constexpr(sizeof(T) >= 8)
-			x = (x ^ (x << 16)) & T(0x0000ffff0000ffff);
-		if constexpr(sizeof(T) >= 4)
-			x = (x ^ (x <<  8)) & T(0x00ff00ff00ff00ff);
-		if constexpr(sizeof(T) >= 2)
-			x = (x ^ (x <<  4)) & T(0x0f0f0f0f0f0f0f0f);
-		
-		x = (x ^ (x << 2)) & T(0x3333333333333333);
-		x = (x ^ (x << 1)) & T(0x5555555555555555);
+		return detail::spread<T, 2>(x, detail::spread2_table) | (detail::spread<T, 2>(y, detail::spread2_table) << 1);
+	}
+	else
+	{
+		auto expand = [](T x) -> T
+		{
+			x &= (T(1) << (sizeof(T) << 2)) - 1;
+			
+			if constexpr(sizeof(T) >= 2)
+				x = (x ^ (x << 4)) & T(0x0f0f0f0f0f0f0f0f);
+			
+			x = (x ^ (x << 2)) & T(0x3333333333333333);
+			x = (x ^ (x << 1)) & T(0x5555555555555555);
+			
+			return x;
+		};
 		
-		return x;
-	};
-	
-	return expand(x) | (expand(y) << 1);
+		return expand(x) | (expand(y) << 1);
+	}
 }
 
 template <typename T>
 T encode(T x, T y, T z)
 {
-	auto expand = [](T x) -> T
+	#if defined(ANTKEEPER_GEOM_MORTON_BMI2)
+		if constexpr (sizeof(T) == 4)
+			return static_cast<T>(_pdep_u32(x, detail::mask3<std::uint32_t>) | _pdep_u32(y, detail::mask3<std::uint32_t> << 1) | _pdep_u32(z, detail::mask3<std::uint32_t> << 2));
+		else if constexpr (sizeof(T) == 8)
+			return static_cast<T>(_pdep_u64(x, detail::mask3<std::uint64_t>) | _pdep_u64(y, detail::mask3<std::uint64_t> << 1) | _pdep_u64(z, detail::mask3<std::uint64_t> << 2));
+	#endif
+	
+	if constexpr (sizeof(T) >= 4)
 	{
-		if constexpr(sizeof(T) == 1)
-		{
-			x &=               0x3;
-			x = (x | x << 2) & 0x9;
-		}
-		else if constexpr(sizeof(T) == 2)
-		{
-			x &=               0x001f;
-			x = (x | x << 8) & 0x100f;
-			x = (x | x << 4) & 0x10c3;
-			x = (x | x << 2) & 0x1249;
-		}
-		else if constexpr(sizeof(T) == 4)
-		{
-			x &=                0x00003ff;
-			x = (x | x << 16) & 0x30000ff;
-			x = (x | x <<  8) & 0x300f00f;
-			x = (x | x <<  4) & 0x30c30c3;
-			x = (x | x <<  2) & 0x9249249;
-		}
-		else if constexpr(sizeof(T) == 8)
+		return detail::spread<T, 3>(x, detail::spread3_table) | (detail::spread<T, 3>(y, detail::spread3_table) << 1) | (detail::spread<T, 3>(z, detail::spread3_table) << 2);
+	}
+	else
+	{
+		auto expand = [](T x) -> T
 		{
-			x &=                0x00000000001fffff;
-			x = (x | x << 32) & 0x001f00000000ffff;
-			x = (x | x << 16) & 0x001f0000ff0000ff;
-			x = (x | x <<  8) & 0x100f00f00f00f00f;
-			x = (x | x <<  4) & 0x10c30c30c30c30c3;
-			x = (x | x <<  2) & 0x1249249249249249;
-		}
-
-		return x;
-	};
-	
-	return expand(x) | (expand(y) << 1) | (expand(z) << 2);
+			if constexpr(sizeof(T) == 1)
+			{
+				x &=               0x3;
+				x = (x | x << 2) & 0x9;
+			}
+			else if constexpr(sizeof(T) == 2)
+			{
+				x &=               0x001f;
+				x = (x | x << 8) & 0x100f;
+				x = (x | x << 4) & 0x10c3;
+				x = (x | x << 2) & 0x1249;
+			}
+			
+			return x;
+		};
+		
+		return expand(x) | (expand(y) << 1) | (expand(z) << 2);
+	}
 }
 
 template <typename T>
 void decode(T code, T& x, T& y)
 {
+	#if defined(ANTKEEPER_GEOM_MORTON_BMI2)
+		if constexpr (sizeof(T) == 4)
+		{
+			x = static_cast<T>(_pext_u32(code, detail::mask2<std::uint32_t>));
+			y = static_cast<T>(_pext_u32(code, detail::mask2<std::uint32_t> << 1));
+			return;
+		}
+		else if constexpr (sizeof(T) == 8)
+		{
+			x = static_cast<T>(_pext_u64(code, detail::mask2<std::uint64_t>));
+			y = static_cast<T>(_pext_u64(code, detail::mask2<std::uint64_t> << 1));
+			return;
+		}
+	#endif
+	
 	auto compress = [](T x) -> T
 	{
 		x &= T(0x5555555555555555);
@@ -161,6 +291,23 @@ void decode(T code, T& x, T& y)
 template <typename T>
 void decode(T code, T& x, T& y, T& z)
 {
+	#if defined(ANTKEEPER_GEOM_MORTON_BMI2)
+		if constexpr (sizeof(T) == 4)
+		{
+			x = static_cast<T>(_pext_u32(code, detail::mask3<std::uint32_t>));
+			y = static_cast<T>(_pext_u32(code, detail::mask3<std::uint32_t> << 1));
+			z = static_cast<T>(_pext_u32(code, detail::mask3<std::uint32_t> << 2));
+			return;
+		}
+		else if constexpr (sizeof(T) == 8)
+		{
+			x = static_cast<T>(_pext_u64(code, detail::mask3<std::uint64_t>));
+			y = static_cast<T>(_pext_u64(code, detail::mask3<std::uint64_t> << 1));
+			z = static_cast<T>(_pext_u64(code, detail::mask3<std::uint64_t> << 2));
+			return;
+		}
+	#endif
+	
 	auto compress = [](T x) -> T
 	{
 		if constexpr(sizeof(T) == 1)
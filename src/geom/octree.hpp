@@ -25,8 +25,8 @@
 namespace geom {
 
 /// An octree, or 3-dimensional hyperoctree.
-template <std::size_t D, class T>
-using octree = hyperoctree<3, D, T>;
+template <std::size_t D, class T, hyperoctree_storage S = hyperoctree_storage::hashed>
+using octree = hyperoctree<3, D, T, S>;
 
 /// Octree with an 8-bit node type (2 depth levels).
 typedef octree<1, std::uint8_t> octree8;
@@ -40,6 +40,12 @@ typedef octree<8, std::uint32_t> octree32;
 /// Octree with a 64-bit node type (19 depth levels).
 typedef octree<18, std::uint64_t> octree64;
 
+/// Octree with a 32-bit node type and linear storage.
+typedef octree<8, std::uint32_t, hyperoctree_storage::linear> linear_octree32;
+
+/// Octree with a 64-bit node type and linear storage.
+typedef octree<18, std::uint64_t, hyperoctree_storage::linear> linear_octree64;
+
 } // namespace geom
 
 #endif // ANTKEEPER_GEOM_OCTREE_HPP
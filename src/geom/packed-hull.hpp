@@ -0,0 +1,276 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ANTKEEPER_GEOM_PACKED_HULL_HPP
+#define ANTKEEPER_GEOM_PACKED_HULL_HPP
+
+#include "geom/aabb.hpp"
+#include "geom/bounding-volume.hpp"
+#include "geom/convex-hull.hpp"
+#include "geom/plane.hpp"
+#include "geom/sphere.hpp"
+#include "math/batch.hpp"
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace geom {
+
+/// Result of classifying a bounding volume against a convex hull.
+enum class containment
+{
+	/// The volume lies entirely outside of at least one plane of the hull.
+	outside,
+	
+	/// The volume straddles at least one plane of the hull, and may intersect it.
+	intersecting,
+	
+	/// The volume lies entirely inside of the hull.
+	inside
+};
+
+/**
+ * Planes of a convex hull, transposed to structure-of-arrays form so that bounding volumes are tested against four planes at a time with SIMD instructions.
+ *
+ * Planes are padded to a multiple of four with planes which every volume lies inside of. Besides the plane normals and distances, the absolute values of the normals are stored, by which the projected radius of a box is found without branching on the signs of the normals.
+ *
+ * @tparam T Scalar type.
+ */
+template <class T>
+class packed_hull
+{
+public:
+	/// Number of planes which may be skipped by a plane mask. Further planes are tested against every volume.
+	static constexpr std::size_t mask_width = 32;
+	
+	/// Creates a packed hull with no planes, inside of which every volume lies.
+	packed_hull() = default;
+	
+	/// Packs the planes of a convex hull.
+	explicit packed_hull(const convex_hull<T>& hull);
+	
+	/// Replaces the planes of the packed hull with the planes of a convex hull.
+	void set_planes(const std::vector<plane<T>>& planes);
+	
+	/// Returns the mask with a bit set for each maskable plane, with which hierarchical classification starts.
+	std::uint32_t get_full_mask() const;
+	
+	/// Returns the number of planes, excluding padding.
+	std::size_t get_plane_count() const;
+	
+	/// Returns the number of planes, including padding.
+	std::size_t get_padded_plane_count() const;
+	
+	/// Plane components, with consecutive planes in consecutive elements.
+	/// @{
+	std::vector<T> normal_x;
+	std::vector<T> normal_y;
+	std::vector<T> normal_z;
+	std::vector<T> abs_normal_x;
+	std::vector<T> abs_normal_y;
+	std::vector<T> abs_normal_z;
+	std::vector<T> distance;
+	/// @}
+	
+private:
+	std::size_t plane_count{0};
+};
+
+/**
+ * Classifies a volume, given by its center, the extents of its box, and the radius of its sphere, against the planes of a packed hull which are set in a plane mask, four planes at a time. Planes which the volume lies entirely inside of are cleared from the mask, so that the volumes which it contains, such as the children of a node in a bounding volume hierarchy, need not test them again.
+ *
+ * @param hull Packed hull.
+ * @param center Center of the volume.
+ * @param extents Half-widths of the box of the volume along each axis, or zero for spheres.
+ * @param radius Radius of the sphere of the volume, or zero for boxes.
+ * @param[in,out] plane_mask Mask of the planes to test, with the planes the volume lies entirely inside of cleared.
+ * @return Classification of the volume.
+ */
+template <class T>
+containment classify(const packed_hull<T>& hull, const math::vector<T, 3>& center, const math::vector<T, 3>& extents, T radius, std::uint32_t& plane_mask);
+
+/**
+ * Classifies a sphere against the planes of a packed hull which are set in a plane mask.
+ *
+ * @see classify(const packed_hull<T>&, const math::vector<T, 3>&, const math::vector<T, 3>&, T, std::uint32_t&)
+ */
+template <class T>
+containment classify(const packed_hull<T>& hull, const sphere<T>& sphere, std::uint32_t& plane_mask);
+
+/**
+ * Classifies an axis-aligned bounding box against the planes of a packed hull which are set in a plane mask.
+ *
+ * @see classify(const packed_hull<T>&, const math::vector<T, 3>&, const math::vector<T, 3>&, T, std::uint32_t&)
+ */
+template <class T>
+containment classify(const packed_hull<T>& hull, const aabb<T>& aabb, std::uint32_t& plane_mask);
+
+/// Classifies a sphere against all planes of a packed hull.
+template <class T>
+containment classify(const packed_hull<T>& hull, const sphere<T>& sphere);
+
+/// Classifies an axis-aligned bounding box against all planes of a packed hull.
+template <class T>
+containment classify(const packed_hull<T>& hull, const aabb<T>& aabb);
+
+/**
+ * Classifies a bounding volume against all planes of a packed hull, dispatching on its type once rather than through virtual intersection tests. Convex hulls can't be classified by their planes, so they are reported as intersecting.
+ */
+template <class T>
+containment classify(const packed_hull<T>& hull, const bounding_volume<T>& volume);
+
+template <class T>
+packed_hull<T>::packed_hull(const convex_hull<T>& hull)
+{
+	set_planes(hull.planes);
+}
+
+template <class T>
+void packed_hull<T>::set_planes(const std::vector<plane<T>>& planes)
+{
+	plane_count = planes.size();
+	const std::size_t padded_count = (plane_count + 3) & ~std::size_t(3);
+	
+	// Padding planes have zero normals and distances which place every volume inside of them
+	normal_x.assign(padded_count, T(0));
+	normal_y.assign(padded_count, T(0));
+	normal_z.assign(padded_count, T(0));
+	abs_normal_x.assign(padded_count, T(0));
+	abs_normal_y.assign(padded_count, T(0));
+	abs_normal_z.assign(padded_count, T(0));
+	distance.assign(padded_count, std::numeric_limits<T>::max());
+	
+	for (std::size_t i = 0; i < plane_count; ++i)
+	{
+		const plane<T>& plane = planes[i];
+		normal_x[i] = plane.normal.x;
+		normal_y[i] = plane.normal.y;
+		normal_z[i] = plane.normal.z;
+		abs_normal_x[i] = std::abs(plane.normal.x);
+		abs_normal_y[i] = std::abs(plane.normal.y);
+		abs_normal_z[i] = std::abs(plane.normal.z);
+		distance[i] = plane.distance;
+	}
+}
+
+template <class T>
+inline std::uint32_t packed_hull<T>::get_full_mask() const
+{
+	return (plane_count >= mask_width) ? ~std::uint32_t(0) : (std::uint32_t(1) << plane_count) - 1;
+}
+
+template <class T>
+inline std::size_t packed_hull<T>::get_plane_count() const
+{
+	return plane_count;
+}
+
+template <class T>
+inline std::size_t packed_hull<T>::get_padded_plane_count() const
+{
+	return normal_x.size();
+}
+
+template <class T>
+containment classify(const packed_hull<T>& hull, const math::vector<T, 3>& center, const math::vector<T, 3>& extents, T radius, std::uint32_t& plane_mask)
+{
+	typedef typename math::simd::widest_lanes<T>::type L;
+	constexpr std::size_t width = L::width;
+	constexpr unsigned lane_mask = (1u << width) - 1;
+	
+	const L cx = L::broadcast(center.x);
+	const L cy = L::broadcast(center.y);
+	const L cz = L::broadcast(center.z);
+	const L ex = L::broadcast(extents.x);
+	const L ey = L::broadcast(extents.y);
+	const L ez = L::broadcast(extents.z);
+	const L r = L::broadcast(radius);
+	
+	bool straddling = false;
+	const std::size_t plane_count = hull.get_padded_plane_count();
+	for (std::size_t i = 0; i < plane_count; i += width)
+	{
+		// Skip groups of planes which enclosing volumes lie entirely inside of
+		const bool maskable = i < packed_hull<T>::mask_width;
+		const unsigned group_mask = (maskable) ? (plane_mask >> i) & lane_mask : lane_mask;
+		if (!group_mask)
+			continue;
+		
+		// Signed distances of the center, and radii of the volume projected onto the plane normals
+		const L d = L::load(hull.normal_x.data() + i) * cx + L::load(hull.normal_y.data() + i) * cy + L::load(hull.normal_z.data() + i) * cz + L::load(hull.distance.data() + i);
+		const L projected_radius = L::load(hull.abs_normal_x.data() + i) * ex + L::load(hull.abs_normal_y.data() + i) * ey + L::load(hull.abs_normal_z.data() + i) * ez + r;
+		
+		if (L::bits(d + projected_radius < L::broadcast(T(0))) & group_mask)
+			return containment::outside;
+		
+		const unsigned straddled = L::bits(d - projected_radius < L::broadcast(T(0))) & group_mask;
+		if (maskable)
+			plane_mask &= ~(static_cast<std::uint32_t>(group_mask & ~straddled) << i);
+		else if (straddled)
+			straddling = true;
+	}
+	
+	return (plane_mask || straddling) ? containment::intersecting : containment::inside;
+}
+
+template <class T>
+inline containment classify(const packed_hull<T>& hull, const sphere<T>& sphere, std::uint32_t& plane_mask)
+{
+	return classify(hull, sphere.center, math::vector<T, 3>{T(0), T(0), T(0)}, sphere.radius, plane_mask);
+}
+
+template <class T>
+inline containment classify(const packed_hull<T>& hull, const aabb<T>& aabb, std::uint32_t& plane_mask)
+{
+	return classify(hull, (aabb.min_point + aabb.max_point) * T(0.5), (aabb.max_point - aabb.min_point) * T(0.5), T(0), plane_mask);
+}
+
+template <class T>
+inline containment classify(const packed_hull<T>& hull, const sphere<T>& sphere)
+{
+	std::uint32_t plane_mask = hull.get_full_mask();
+	return classify(hull, sphere, plane_mask);
+}
+
+template <class T>
+inline containment classify(const packed_hull<T>& hull, const aabb<T>& aabb)
+{
+	std::uint32_t plane_mask = hull.get_full_mask();
+	return classify(hull, aabb, plane_mask);
+}
+
+template <class T>
+containment classify(const packed_hull<T>& hull, const bounding_volume<T>& volume)
+{
+	switch (volume.get_bounding_volume_type())
+	{
+		case bounding_volume_type::sphere:
+			return classify(hull, static_cast<const sphere<T>&>(volume));
+		case bounding_volume_type::aabb:
+			return classify(hull, static_cast<const aabb<T>&>(volume));
+		default:
+			return containment::intersecting;
+	}
+}
+
+} // namespace geom
+
+#endif // ANTKEEPER_GEOM_PACKED_HULL_HPP
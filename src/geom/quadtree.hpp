@@ -25,8 +25,8 @@
 namespace geom {
 
 /// A quadtree, or 2-dimensional hyperoctree.
-template <std::size_t D, class T>
-using quadtree = hyperoctree<2, D, T>;
+template <std::size_t D, class T, hyperoctree_storage S = hyperoctree_storage::hashed>
+using quadtree = hyperoctree<2, D, T, S>;
 
 /// Quadtree with an 8-bit node type (2 depth levels).
 typedef quadtree<1, std::uint8_t> quadtree8;
@@ -40,6 +40,12 @@ typedef quadtree<12, std::uint32_t> quadtree32;
 /// Quadtree with a 64-bit node type (29 depth levels).
 typedef quadtree<28, std::uint64_t> quadtree64;
 
+/// Quadtree with a 32-bit node type and linear storage.
+typedef quadtree<12, std::uint32_t, hyperoctree_storage::linear> linear_quadtree32;
+
+/// Quadtree with a 64-bit node type and linear storage.
+typedef quadtree<28, std::uint64_t, hyperoctree_storage::linear> linear_quadtree64;
+
 } // namespace geom
 
 #endif // ANTKEEPER_GEOM_QUADTREE_HPP
@@ -21,7 +21,9 @@
 #define ANTKEEPER_GEOM_SDF_HPP
 
 #include "utility/fundamental-types.hpp"
+#include "math/batch.hpp"
 #include <algorithm>
+#include <cstddef>
 
 namespace geom {
 
@@ -65,6 +67,123 @@ inline float op_round(float d, float r)
     return d - r;
 }
 
+/**
+ * Evaluates the signed distance to a sphere at an array of points, using SIMD instructions where available.
+ *
+ * @param p Array of points.
+ * @param center Center of the sphere.
+ * @param r Radius of the sphere.
+ * @param[out] d Array of signed distances.
+ * @param n Number of points.
+ */
+inline void sphere_n(const math::vector3_soa<const float>& p, const float3& center, float r, float* d, std::size_t n)
+{
+	math::simd::dispatch_lanes<float>(n, [&](auto lanes, std::size_t i)
+	{
+		typedef decltype(lanes) L;
+		const L x = L::load(p.x + i) - L::broadcast(center.x);
+		const L y = L::load(p.y + i) - L::broadcast(center.y);
+		const L z = L::load(p.z + i) - L::broadcast(center.z);
+		(L::sqrt(x * x + y * y + z * z) - L::broadcast(r)).store(d + i);
+	});
+}
+
+/**
+ * Evaluates the signed distance to a capsule at an array of points, using SIMD instructions where available.
+ *
+ * @param p Array of points.
+ * @param a First endpoint of the capsule's segment.
+ * @param b Second endpoint of the capsule's segment.
+ * @param r Radius of the capsule.
+ * @param[out] d Array of signed distances.
+ * @param n Number of points.
+ */
+inline void capsule_n(const math::vector3_soa<const float>& p, const float3& a, const float3& b, float r, float* d, std::size_t n)
+{
+	const float3 ba = b - a;
+	const float length_squared = math::dot(ba, ba);
+	const float inverse_length_squared = (length_squared > 0.0f) ? 1.0f / length_squared : 0.0f;
+	
+	math::simd::dispatch_lanes<float>(n, [&](auto lanes, std::size_t i)
+	{
+		typedef decltype(lanes) L;
+		const L bax = L::broadcast(ba.x);
+		const L bay = L::broadcast(ba.y);
+		const L baz = L::broadcast(ba.z);
+		const L pax = L::load(p.x + i) - L::broadcast(a.x);
+		const L pay = L::load(p.y + i) - L::broadcast(a.y);
+		const L paz = L::load(p.z + i) - L::broadcast(a.z);
+		
+		// Project onto the segment, clamped to its endpoints
+		const L h = L::max(L::min((pax * bax + pay * bay + paz * baz) * L::broadcast(inverse_length_squared), L::broadcast(1.0f)), L::broadcast(0.0f));
+		
+		const L x = pax - bax * h;
+		const L y = pay - bay * h;
+		const L z = paz - baz * h;
+		(L::sqrt(x * x + y * y + z * z) - L::broadcast(r)).store(d + i);
+	});
+}
+
+/**
+ * Evaluates the signed distance to a cylinder aligned with the y-axis at an array of points, like cylinder(), using SIMD instructions where available.
+ *
+ * @param p Array of points.
+ * @param center Center of the cylinder.
+ * @param r Radius of the cylinder.
+ * @param h Half of the height of the cylinder.
+ * @param[out] d Array of signed distances.
+ * @param n Number of points.
+ */
+inline void cylinder_n(const math::vector3_soa<const float>& p, const float3& center, float r, float h, float* d, std::size_t n)
+{
+	math::simd::dispatch_lanes<float>(n, [&](auto lanes, std::size_t i)
+	{
+		typedef decltype(lanes) L;
+		const L zero = L::broadcast(0.0f);
+		const L x = L::load(p.x + i) - L::broadcast(center.x);
+		const L y = L::load(p.y + i) - L::broadcast(center.y);
+		const L z = L::load(p.z + i) - L::broadcast(center.z);
+		
+		const L dx = L::sqrt(x * x + z * z) - L::broadcast(r);
+		const L dy = L::max(y, -y) - L::broadcast(h);
+		const L mx = L::max(dx, zero);
+		const L my = L::max(dy, zero);
+		(L::min(L::max(dx, dy), zero) + L::sqrt(mx * mx + my * my)).store(d + i);
+	});
+}
+
+/**
+ * Unites arrays of signed distances in place, `b[i] = op_union(a[i], b[i])`.
+ *
+ * @param a Array of signed distances.
+ * @param[in,out] b Array of signed distances, which receives the union.
+ * @param n Number of signed distances.
+ */
+inline void op_union_n(const float* a, float* b, std::size_t n)
+{
+	math::simd::dispatch_lanes<float>(n, [&](auto lanes, std::size_t i)
+	{
+		typedef decltype(lanes) L;
+		L::min(L::load(a + i), L::load(b + i)).store(b + i);
+	});
+}
+
+/**
+ * Subtracts arrays of signed distances in place, `b[i] = op_difference(a[i], b[i])`.
+ *
+ * @param a Array of signed distances to subtract.
+ * @param[in,out] b Array of signed distances, which receives the difference.
+ * @param n Number of signed distances.
+ */
+inline void op_difference_n(const float* a, float* b, std::size_t n)
+{
+	math::simd::dispatch_lanes<float>(n, [&](auto lanes, std::size_t i)
+	{
+		typedef decltype(lanes) L;
+		L::max(-L::load(a + i), L::load(b + i)).store(b + i);
+	});
+}
+
 } // namespace sdf
 } // namespace geom
 
@@ -0,0 +1,158 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "geom/vertex-cache.hpp"
+#include <algorithm>
+#include <vector>
+
+namespace geom {
+
+void optimize_vertex_cache(std::uint32_t* indices, std::size_t index_count, std::size_t vertex_count, std::size_t cache_size)
+{
+	const std::size_t triangle_count = index_count / 3;
+	if (triangle_count < 2)
+		return;
+	
+	// Build lists of the triangles adjacent to each vertex
+	std::vector<std::uint32_t> adjacency_offsets(vertex_count + 1, 0);
+	for (std::size_t i = 0; i < triangle_count * 3; ++i)
+		++adjacency_offsets[indices[i] + 1];
+	for (std::size_t i = 0; i < vertex_count; ++i)
+		adjacency_offsets[i + 1] += adjacency_offsets[i];
+	std::vector<std::uint32_t> adjacency(triangle_count * 3);
+	{
+		std::vector<std::uint32_t> cursors(adjacency_offsets.begin(), adjacency_offsets.end() - 1);
+		for (std::size_t i = 0; i < triangle_count * 3; ++i)
+			adjacency[cursors[indices[i]]++] = static_cast<std::uint32_t>(i / 3);
+	}
+	
+	// Number of unemitted triangles which reference each vertex
+	std::vector<std::uint32_t> live_counts(vertex_count);
+	for (std::size_t i = 0; i < vertex_count; ++i)
+		live_counts[i] = adjacency_offsets[i + 1] - adjacency_offsets[i];
+	
+	// Time at which each vertex last entered the cache. Timestamps start beyond the cache size, so that no vertex begins in the cache.
+	std::vector<std::size_t> cache_times(vertex_count, 0);
+	std::size_t timestamp = cache_size + 1;
+	
+	std::vector<bool> emitted(triangle_count, false);
+	std::vector<std::uint32_t> dead_end_stack;
+	std::vector<std::uint32_t> candidates;
+	std::vector<std::uint32_t> output;
+	output.reserve(triangle_count * 3);
+	std::size_t cursor = 0;
+	
+	std::size_t fan = indices[0];
+	while (fan < vertex_count)
+	{
+		// Emit the unemitted triangles around the fanning vertex
+		candidates.clear();
+		for (std::uint32_t i = adjacency_offsets[fan]; i < adjacency_offsets[fan + 1]; ++i)
+		{
+			const std::uint32_t triangle = adjacency[i];
+			if (emitted[triangle])
+				continue;
+			
+			for (std::size_t j = 0; j < 3; ++j)
+			{
+				const std::uint32_t vertex = indices[triangle * 3 + j];
+				output.push_back(vertex);
+				dead_end_stack.push_back(vertex);
+				candidates.push_back(vertex);
+				--live_counts[vertex];
+				if (timestamp - cache_times[vertex] > cache_size)
+					cache_times[vertex] = timestamp++;
+			}
+			emitted[triangle] = true;
+		}
+		
+		// Choose the candidate which will remain in the cache longest while its remaining triangles are emitted
+		std::size_t next = vertex_count;
+		std::size_t best_priority = 0;
+		bool found = false;
+		for (std::uint32_t vertex: candidates)
+		{
+			if (!live_counts[vertex])
+				continue;
+			
+			std::size_t priority = 0;
+			if (timestamp - cache_times[vertex] + 2 * live_counts[vertex] <= cache_size)
+				priority = timestamp - cache_times[vertex];
+			if (!found || priority > best_priority)
+			{
+				best_priority = priority;
+				next = vertex;
+				found = true;
+			}
+		}
+		
+		// At a dead end, continue from a recently used vertex, or else from the next vertex in input order
+		if (!found)
+		{
+			while (!dead_end_stack.empty() && !found)
+			{
+				const std::uint32_t vertex = dead_end_stack.back();
+				dead_end_stack.pop_back();
+				if (live_counts[vertex])
+				{
+					next = vertex;
+					found = true;
+				}
+			}
+			while (!found && cursor < vertex_count)
+			{
+				if (live_counts[cursor])
+				{
+					next = cursor;
+					found = true;
+				}
+				++cursor;
+			}
+		}
+		
+		fan = next;
+	}
+	
+	std::copy(output.begin(), output.end(), indices);
+}
+
+float calculate_acmr(const std::uint32_t* indices, std::size_t index_count, std::size_t vertex_count, std::size_t cache_size)
+{
+	const std::size_t triangle_count = index_count / 3;
+	if (!triangle_count)
+		return 0.0f;
+	
+	// Simulate a FIFO cache, in which a vertex is cached if it entered the cache within the last `cache_size` misses
+	std::vector<std::size_t> cache_times(vertex_count, 0);
+	std::size_t timestamp = cache_size + 1;
+	std::size_t miss_count = 0;
+	for (std::size_t i = 0; i < triangle_count * 3; ++i)
+	{
+		const std::uint32_t vertex = indices[i];
+		if (timestamp - cache_times[vertex] > cache_size)
+		{
+			cache_times[vertex] = timestamp++;
+			++miss_count;
+		}
+	}
+	
+	return static_cast<float>(miss_count) / static_cast<float>(triangle_count);
+}
+
+} // namespace geom
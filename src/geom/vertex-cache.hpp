@@ -0,0 +1,51 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ANTKEEPER_GEOM_VERTEX_CACHE_HPP
+#define ANTKEEPER_GEOM_VERTEX_CACHE_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+namespace geom {
+
+/**
+ * Reorders the triangles of an indexed triangle list for the post-transform vertex cache, using the Tipsify algorithm of Sander, Nehab, and Barczak (2007). Triangles are emitted in fans around vertices chosen to remain in the cache, so that each vertex is shaded as few times as possible. The vertices of each triangle keep their order, which preserves its winding.
+ *
+ * @param[in,out] indices Triangle indices, three per triangle.
+ * @param index_count Number of indices.
+ * @param vertex_count One more than the greatest index.
+ * @param cache_size Number of vertices in the targeted FIFO cache.
+ */
+void optimize_vertex_cache(std::uint32_t* indices, std::size_t index_count, std::size_t vertex_count, std::size_t cache_size = 16);
+
+/**
+ * Calculates the average cache miss ratio of an indexed triangle list, which is the number of vertices shaded per triangle when drawn through a FIFO vertex cache. It ranges from `0.5` for a well-ordered regular grid to `3.0` for a cache which never hits.
+ *
+ * @param indices Triangle indices, three per triangle.
+ * @param index_count Number of indices.
+ * @param vertex_count One more than the greatest index.
+ * @param cache_size Number of vertices in the simulated FIFO cache.
+ * @return Average number of cache misses per triangle.
+ */
+float calculate_acmr(const std::uint32_t* indices, std::size_t index_count, std::size_t vertex_count, std::size_t cache_size = 16);
+
+} // namespace geom
+
+#endif // ANTKEEPER_GEOM_VERTEX_CACHE_HPP
@@ -0,0 +1,47 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ANTKEEPER_GL_BLEND_FACTOR_HPP
+#define ANTKEEPER_GL_BLEND_FACTOR_HPP
+
+namespace gl {
+
+enum class blend_factor
+{
+	zero,
+	one,
+	src_color,
+	one_minus_src_color,
+	dst_color,
+	one_minus_dst_color,
+	src_alpha,
+	one_minus_src_alpha,
+	dst_alpha,
+	one_minus_dst_alpha,
+	constant_color,
+	one_minus_constant_color,
+	constant_alpha,
+	one_minus_constant_alpha,
+	src_alpha_saturate
+};
+
+} // namespace gl
+
+#endif // ANTKEEPER_GL_BLEND_FACTOR_HPP
+
@@ -17,23 +17,24 @@
  * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
  */
 
-#ifndef ANTKEEPER_ENTITY_COMPONENT_SAMARA_HPP
-#define ANTKEEPER_ENTITY_COMPONENT_SAMARA_HPP
+#ifndef ANTKEEPER_GL_COMPARISON_FUNCTION_HPP
+#define ANTKEEPER_GL_COMPARISON_FUNCTION_HPP
 
-#include "utility/fundamental-types.hpp"
+namespace gl {
 
-namespace entity {
-namespace component {
-
-struct samara
+enum class comparison_function
 {
-	float3 direction;
-	float angle;
-	float chirality;
+	never,
+	less,
+	equal,
+	less_equal,
+	greater,
+	not_equal,
+	greater_equal,
+	always
 };
 
-} // namespace component
-} // namespace entity
+} // namespace gl
 
-#endif // ANTKEEPER_ENTITY_COMPONENT_SAMARA_HPP
+#endif // ANTKEEPER_GL_COMPARISON_FUNCTION_HPP
 
@@ -0,0 +1,42 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ANTKEEPER_GL_COMPRESSED_FORMAT_HPP
+#define ANTKEEPER_GL_COMPRESSED_FORMAT_HPP
+
+namespace gl {
+
+/// Block-compressed texture formats.
+enum class compressed_format
+{
+	bc1, ///< BC1 (DXT1), RGBA with 1-bit alpha, 4x4 blocks of 8 bytes
+	bc3, ///< BC3 (DXT5), RGBA, 4x4 blocks of 16 bytes
+	bc4, ///< BC4 (RGTC1), red, 4x4 blocks of 8 bytes
+	bc5, ///< BC5 (RGTC2), red, green, 4x4 blocks of 16 bytes
+	bc6h, ///< BC6H (BPTC), unsigned float RGB, 4x4 blocks of 16 bytes
+	bc7, ///< BC7 (BPTC), RGBA, 4x4 blocks of 16 bytes
+	astc_4x4, ///< ASTC, RGBA, 4x4 blocks of 16 bytes
+	astc_5x5, ///< ASTC, RGBA, 5x5 blocks of 16 bytes
+	astc_6x6, ///< ASTC, RGBA, 6x6 blocks of 16 bytes
+	astc_8x8 ///< ASTC, RGBA, 8x8 blocks of 16 bytes
+};
+
+} // namespace gl
+
+#endif // ANTKEEPER_GL_COMPRESSED_FORMAT_HPP
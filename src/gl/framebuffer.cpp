@@ -33,7 +33,7 @@ static constexpr GLenum attachment_lut[] =
 framebuffer::framebuffer(int width, int height):
 	gl_framebuffer_id(0),
 	dimensions({width, height}),
-	color_attachment(nullptr),
+	color_attachments{},
 	depth_attachment(nullptr),
 	stencil_attachment(nullptr)
 {
@@ -43,7 +43,7 @@ framebuffer::framebuffer(int width, int height):
 framebuffer::framebuffer():
 	gl_framebuffer_id(0),
 	dimensions({0, 0}),
-	color_attachment(nullptr),
+	color_attachments{},
 	depth_attachment(nullptr),
 	stencil_attachment(nullptr)
 {}
@@ -61,29 +61,41 @@ void framebuffer::resize(const std::array<int, 2>& dimensions)
 	this->dimensions = dimensions;
 }
 
-void framebuffer::attach(framebuffer_attachment_type attachment_type, texture_2d* texture)
+void framebuffer::attach(framebuffer_attachment_type attachment_type, texture_2d* texture, std::size_t color_index)
 {
 	glBindFramebuffer(GL_FRAMEBUFFER, gl_framebuffer_id);
 	
 	GLenum gl_attachment = attachment_lut[static_cast<std::size_t>(attachment_type)];
+	if (attachment_type == framebuffer_attachment_type::color)
+		gl_attachment += static_cast<GLenum>(color_index);
 	glFramebufferTexture2D(GL_FRAMEBUFFER, gl_attachment, GL_TEXTURE_2D, texture->gl_texture_id, 0);
 	
 	if (attachment_type == framebuffer_attachment_type::color)
-		color_attachment = texture;
+		color_attachments[color_index] = texture;
 	else if (attachment_type == framebuffer_attachment_type::depth)
 		depth_attachment = texture;
 	else if (attachment_type == framebuffer_attachment_type::stencil)
 		stencil_attachment = texture;
 	
-	if (!color_attachment)
+	// Draw to each color attachment, from the fragment shader output of the same location
+	GLenum draw_buffers[max_color_attachments];
+	GLsizei draw_buffer_count = 0;
+	for (std::size_t i = 0; i < max_color_attachments; ++i)
+	{
+		draw_buffers[i] = (color_attachments[i]) ? GL_COLOR_ATTACHMENT0 + static_cast<GLenum>(i) : GL_NONE;
+		if (color_attachments[i])
+			draw_buffer_count = static_cast<GLsizei>(i + 1);
+	}
+	
+	if (!draw_buffer_count)
 	{
 		glDrawBuffer(GL_NONE);
 		glReadBuffer(GL_NONE);
 	}
 	else
 	{
-		glDrawBuffer(GL_COLOR_ATTACHMENT0);
-		glReadBuffer(GL_COLOR_ATTACHMENT0);
+		glDrawBuffers(draw_buffer_count, draw_buffers);
+		glReadBuffer((color_attachments[0]) ? GL_COLOR_ATTACHMENT0 : GL_NONE);
 	}
 	
 	glBindFramebuffer(GL_FRAMEBUFFER, 0);
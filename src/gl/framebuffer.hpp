@@ -21,6 +21,7 @@
 #define ANTKEEPER_GL_FRAMEBUFFER_HPP
 
 #include <array>
+#include <cstddef>
 
 namespace gl {
 
@@ -56,28 +57,36 @@ public:
 	/**
 	 * Attaches a color, depth, or stencil texture to the framebuffer.
 	 *
+	 * Fragment shader outputs are written to the color attachments according to their locations, so a framebuffer with several color attachments can be rendered to in a single pass.
+	 *
 	 * @param attachment_type Type of attachment.
+	 * @param texture Texture to attach.
+	 * @param color_index Index of the color attachment, less than `max_color_attachments`. Ignored for depth and stencil attachments.
 	 */
-	void attach(framebuffer_attachment_type attachment_type, texture_2d* texture);
+	void attach(framebuffer_attachment_type attachment_type, texture_2d* texture, std::size_t color_index = 0);
 	
 	/// Returns the dimensions of the framebuffer, in pixels.
 	const std::array<int, 2>& get_dimensions() const;
 	
-	const texture_2d* get_color_attachment() const;
-	texture_2d* get_color_attachment();
+	const texture_2d* get_color_attachment(std::size_t index = 0) const;
+	texture_2d* get_color_attachment(std::size_t index = 0);
 	const texture_2d* get_depth_attachment() const;
 	texture_2d* get_depth_attachment();
 	const texture_2d* get_stencil_attachment() const;
 	texture_2d* get_stencil_attachment();
+	
+	/// Maximum number of color attachments, which is the minimum value of `GL_MAX_DRAW_BUFFERS` and `GL_MAX_COLOR_ATTACHMENTS` guaranteed by OpenGL 3.3.
+	static constexpr std::size_t max_color_attachments = 8;
 
 private:
 	friend class rasterizer;
+	friend class readback_buffer;
 	
 	framebuffer();
 
 	unsigned int gl_framebuffer_id;
 	std::array<int, 2> dimensions;
-	texture_2d* color_attachment;
+	std::array<texture_2d*, max_color_attachments> color_attachments;
 	texture_2d* depth_attachment;
 	texture_2d* stencil_attachment;
 };
@@ -87,14 +96,14 @@ inline const std::array<int, 2>& framebuffer::get_dimensions() const
 	return dimensions;
 }
 
-inline const texture_2d* framebuffer::get_color_attachment() const
+inline const texture_2d* framebuffer::get_color_attachment(std::size_t index) const
 {
-	return color_attachment;
+	return color_attachments[index];
 }
 
-inline texture_2d* framebuffer::get_color_attachment()
+inline texture_2d* framebuffer::get_color_attachment(std::size_t index)
 {
-	return color_attachment;
+	return color_attachments[index];
 }
 
 inline const texture_2d* framebuffer::get_depth_attachment() const
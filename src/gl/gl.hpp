@@ -23,23 +23,31 @@
 /// Graphics library (GL) is a cross-platform GPU interface.
 namespace gl {}
 
+#include "blend-factor.hpp"
 #include "buffer-usage.hpp"
 #include "color-space.hpp"
+#include "comparison-function.hpp"
+#include "compressed-format.hpp"
+#include "cull-face.hpp"
 #include "drawing-mode.hpp"
 #include "element-array-type.hpp"
 #include "framebuffer.hpp"
 #include "pixel-format.hpp"
 #include "pixel-type.hpp"
 #include "rasterizer.hpp"
+#include "render-state.hpp"
 #include "shader-input.hpp"
 #include "shader-object.hpp"
 #include "shader-program.hpp"
 #include "shader-stage.hpp"
 #include "shader-variable-type.hpp"
+#include "stencil-operation.hpp"
 #include "texture-2d.hpp"
 #include "texture-cube.hpp"
 #include "texture-filter.hpp"
 #include "texture-wrapping.hpp"
+#include "timer-query.hpp"
+#include "uniform-buffer.hpp"
 #include "vertex-array.hpp"
 #include "vertex-attribute-type.hpp"
 #include "vertex-buffer.hpp"
@@ -0,0 +1,106 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gl/pixel-conversion.hpp"
+#include <cstring>
+
+namespace gl {
+
+static inline std::uint32_t float_bits(float x)
+{
+	std::uint32_t bits;
+	std::memcpy(&bits, &x, sizeof(bits));
+	return bits;
+}
+
+static inline float bits_float(std::uint32_t bits)
+{
+	float x;
+	std::memcpy(&x, &bits, sizeof(x));
+	return x;
+}
+
+std::uint16_t float_to_half(float x)
+{
+	/// @see https://gist.github.com/rygorous/2156668
+	std::uint32_t f = float_bits(x);
+	const std::uint32_t sign = f & 0x80000000u;
+	f ^= sign;
+	
+	std::uint32_t h;
+	if (f >= (127u + 16u) << 23)
+	{
+		// Infinities, NaNs, and values which round to infinity
+		h = (f > 255u << 23) ? 0x7e00u : 0x7c00u;
+	}
+	else if (f < 113u << 23)
+	{
+		// Subnormals and zero, rounded by the floating-point addition of a magic number
+		const float magic = bits_float(((127u - 15u) + (23u - 10u) + 1u) << 23);
+		h = float_bits(bits_float(f) + magic) - float_bits(magic);
+	}
+	else
+	{
+		// Normals, rebiased and rounded to nearest even
+		const std::uint32_t odd = (f >> 13) & 1u;
+		f += ((15u - 127u) << 23) + 0xfffu + odd;
+		h = f >> 13;
+	}
+	
+	return static_cast<std::uint16_t>(h | (sign >> 16));
+}
+
+void float_to_half(const float* source, std::uint16_t* destination, std::size_t count)
+{
+	for (std::size_t i = 0; i < count; ++i)
+		destination[i] = float_to_half(source[i]);
+}
+
+/// Converts a float to an unsigned float with a 5-bit exponent, by truncating the mantissa of its half-precision equivalent with rounding.
+static inline std::uint32_t float_to_ufloat(float x, unsigned int mantissa_bits)
+{
+	const std::uint32_t infinity = 0x1fu << mantissa_bits;
+	
+	// NaNs remain NaNs, while negative values and zero are clamped to zero
+	if (x != x)
+		return infinity | 1u;
+	if (!(x > 0.0f))
+		return 0u;
+	
+	// Unsigned floats share the exponent bias of half-precision floats
+	const std::uint32_t h = float_to_half(x);
+	if (h >= 0x7c00u)
+		return infinity;
+	
+	const unsigned int shift = 10u - mantissa_bits;
+	return (h + (1u << (shift - 1u)) - 1u + ((h >> shift) & 1u)) >> shift;
+}
+
+void float_to_ufloat_11_11_10(const float* source, std::uint32_t* destination, std::size_t count)
+{
+	for (std::size_t i = 0; i < count; ++i, source += 3)
+	{
+		destination[i] =
+			float_to_ufloat(source[0], 6) |
+			(float_to_ufloat(source[1], 6) << 11) |
+			(float_to_ufloat(source[2], 5) << 22);
+	}
+}
+
+} // namespace gl
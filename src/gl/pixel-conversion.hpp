@@ -0,0 +1,56 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ANTKEEPER_GL_PIXEL_CONVERSION_HPP
+#define ANTKEEPER_GL_PIXEL_CONVERSION_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+namespace gl {
+
+/**
+ * Converts a single-precision float to a half-precision float, rounding to nearest even. Values beyond the range of half-precision floats become infinities.
+ *
+ * @param x Single-precision float.
+ * @return Bits of the half-precision float.
+ */
+std::uint16_t float_to_half(float x);
+
+/**
+ * Converts single-precision floats to half-precision floats, for upload as gl::pixel_type::float_16 pixels. Safe to call from any thread.
+ *
+ * @param source Single-precision floats.
+ * @param destination Buffer of @p count half-precision floats.
+ * @param count Number of floats to convert.
+ */
+void float_to_half(const float* source, std::uint16_t* destination, std::size_t count);
+
+/**
+ * Packs single-precision RGB pixels into unsigned 11-bit red and green and 10-bit blue floats, for upload as gl::pixel_type::ufloat_11_11_10 pixels. Negative values are clamped to zero. Safe to call from any thread.
+ *
+ * @param source Single-precision RGB pixels.
+ * @param destination Buffer of @p count packed pixels.
+ * @param count Number of pixels to convert.
+ */
+void float_to_ufloat_11_11_10(const float* source, std::uint32_t* destination, std::size_t count);
+
+} // namespace gl
+
+#endif // ANTKEEPER_GL_PIXEL_CONVERSION_HPP
@@ -31,7 +31,10 @@ enum class pixel_type
 	int_32,
 	uint_32,
 	float_16,
-	float_32
+	float_32,
+	
+	/// Unsigned 11-bit red and green and 10-bit blue floats, packed into 32 bits per pixel. Only valid with the rgb pixel format.
+	ufloat_11_11_10
 };
 
 } // namespace gl
@@ -20,11 +20,20 @@
 #include "gl/rasterizer.hpp"
 #include "gl/framebuffer.hpp"
 #include "gl/shader-program.hpp"
+#include "gl/uniform-buffer.hpp"
 #include "gl/vertex-array.hpp"
+#include "debug/counters.hpp"
 #include <glad/glad.h>
 
 namespace gl {
 
+/// Returns the counter of draw calls, of which multi-draws count as one.
+static debug::counter& draw_call_counter()
+{
+	static debug::counter counter("gl.draw_calls");
+	return counter;
+}
+
 static constexpr GLenum drawing_mode_lut[] =
 {
 	GL_POINTS,
@@ -47,6 +56,59 @@ static constexpr GLenum element_array_type_lut[] =
 	GL_UNSIGNED_INT
 };
 
+static constexpr GLenum comparison_function_lut[] =
+{
+	GL_NEVER,
+	GL_LESS,
+	GL_EQUAL,
+	GL_LEQUAL,
+	GL_GREATER,
+	GL_NOTEQUAL,
+	GL_GEQUAL,
+	GL_ALWAYS
+};
+
+static constexpr GLenum blend_factor_lut[] =
+{
+	GL_ZERO,
+	GL_ONE,
+	GL_SRC_COLOR,
+	GL_ONE_MINUS_SRC_COLOR,
+	GL_DST_COLOR,
+	GL_ONE_MINUS_DST_COLOR,
+	GL_SRC_ALPHA,
+	GL_ONE_MINUS_SRC_ALPHA,
+	GL_DST_ALPHA,
+	GL_ONE_MINUS_DST_ALPHA,
+	GL_CONSTANT_COLOR,
+	GL_ONE_MINUS_CONSTANT_COLOR,
+	GL_CONSTANT_ALPHA,
+	GL_ONE_MINUS_CONSTANT_ALPHA,
+	GL_SRC_ALPHA_SATURATE
+};
+
+static constexpr GLenum cull_face_lut[] =
+{
+	GL_FRONT,
+	GL_BACK,
+	GL_FRONT_AND_BACK
+};
+
+static constexpr GLenum stencil_operation_lut[] =
+{
+	GL_KEEP,
+	GL_ZERO,
+	GL_REPLACE,
+	GL_INCR,
+	GL_INCR_WRAP,
+	GL_DECR,
+	GL_DECR_WRAP,
+	GL_INVERT
+};
+
+/// Enables or disables an OpenGL capability.
+static void set_capability(GLenum capability, bool enabled);
+
 rasterizer::rasterizer():
 	bound_vao(nullptr),
 	bound_shader_program(nullptr)
@@ -62,6 +124,9 @@ rasterizer::rasterizer():
 	
 	// Bind default framebuffer
 	bound_framebuffer = default_framebuffer;
+	
+	// Synchronize OpenGL state with the render state cache
+	apply_render_state(current_state, true);
 }
 
 rasterizer::~rasterizer()
@@ -114,6 +179,90 @@ void rasterizer::set_viewport(int x, int y, int width, int height)
 	glViewport(x, y, static_cast<GLsizei>(width), static_cast<GLsizei>(height));
 }
 
+void rasterizer::set_scissor(int x, int y, int width, int height)
+{
+	glScissor(x, y, static_cast<GLsizei>(width), static_cast<GLsizei>(height));
+}
+
+void rasterizer::set_render_state(const render_state& state)
+{
+	apply_render_state(state, false);
+}
+
+void rasterizer::apply_render_state(const render_state& state, bool force)
+{
+	render_state& current = current_state;
+	
+	// Blending
+	if (force || state.blend_enabled != current.blend_enabled)
+		set_capability(GL_BLEND, state.blend_enabled);
+	if (force || state.blend_source != current.blend_source || state.blend_destination != current.blend_destination ||
+		state.blend_separate_alpha != current.blend_separate_alpha ||
+		(state.blend_separate_alpha && (state.blend_source_alpha != current.blend_source_alpha || state.blend_destination_alpha != current.blend_destination_alpha)))
+	{
+		if (state.blend_separate_alpha)
+		{
+			glBlendFuncSeparate
+			(
+				blend_factor_lut[static_cast<std::size_t>(state.blend_source)],
+				blend_factor_lut[static_cast<std::size_t>(state.blend_destination)],
+				blend_factor_lut[static_cast<std::size_t>(state.blend_source_alpha)],
+				blend_factor_lut[static_cast<std::size_t>(state.blend_destination_alpha)]
+			);
+		}
+		else
+		{
+			glBlendFunc(blend_factor_lut[static_cast<std::size_t>(state.blend_source)], blend_factor_lut[static_cast<std::size_t>(state.blend_destination)]);
+		}
+	}
+	
+	// Depth testing and writing
+	if (force || state.depth_test_enabled != current.depth_test_enabled)
+		set_capability(GL_DEPTH_TEST, state.depth_test_enabled);
+	if (force || state.depth_function != current.depth_function)
+		glDepthFunc(comparison_function_lut[static_cast<std::size_t>(state.depth_function)]);
+	if (force || state.depth_write_enabled != current.depth_write_enabled)
+		glDepthMask((state.depth_write_enabled) ? GL_TRUE : GL_FALSE);
+	if (force || state.depth_range_near != current.depth_range_near || state.depth_range_far != current.depth_range_far)
+		glDepthRange(state.depth_range_near, state.depth_range_far);
+	
+	// Face culling
+	if (force || state.cull_enabled != current.cull_enabled)
+		set_capability(GL_CULL_FACE, state.cull_enabled);
+	if (force || state.culled_face != current.culled_face)
+		glCullFace(cull_face_lut[static_cast<std::size_t>(state.culled_face)]);
+	
+	// Stencil testing and writing
+	if (force || state.stencil_test_enabled != current.stencil_test_enabled)
+		set_capability(GL_STENCIL_TEST, state.stencil_test_enabled);
+	if (force || state.stencil_function != current.stencil_function || state.stencil_reference != current.stencil_reference || state.stencil_read_mask != current.stencil_read_mask)
+		glStencilFunc(comparison_function_lut[static_cast<std::size_t>(state.stencil_function)], static_cast<GLint>(state.stencil_reference), static_cast<GLuint>(state.stencil_read_mask));
+	if (force || state.stencil_write_mask != current.stencil_write_mask)
+		glStencilMask(static_cast<GLuint>(state.stencil_write_mask));
+	if (force || state.stencil_fail != current.stencil_fail || state.stencil_depth_fail != current.stencil_depth_fail || state.stencil_pass != current.stencil_pass)
+	{
+		glStencilOp
+		(
+			stencil_operation_lut[static_cast<std::size_t>(state.stencil_fail)],
+			stencil_operation_lut[static_cast<std::size_t>(state.stencil_depth_fail)],
+			stencil_operation_lut[static_cast<std::size_t>(state.stencil_pass)]
+		);
+	}
+	
+	// Color writing
+	if (force || state.color_write_enabled != current.color_write_enabled)
+	{
+		const GLboolean mask = (state.color_write_enabled) ? GL_TRUE : GL_FALSE;
+		glColorMask(mask, mask, mask, mask);
+	}
+	
+	// Scissor testing
+	if (force || state.scissor_test_enabled != current.scissor_test_enabled)
+		set_capability(GL_SCISSOR_TEST, state.scissor_test_enabled);
+	
+	current = state;
+}
+
 void rasterizer::use_program(const shader_program& program)
 {
 	if (bound_shader_program != &program)
@@ -123,6 +272,16 @@ void rasterizer::use_program(const shader_program& program)
 	}
 }
 
+void rasterizer::bind_uniform_buffer(const uniform_buffer& buffer, unsigned int binding)
+{
+	glBindBufferBase(GL_UNIFORM_BUFFER, static_cast<GLuint>(binding), buffer.gl_buffer_id);
+}
+
+void rasterizer::bind_uniform_buffer_range(const uniform_buffer& buffer, unsigned int binding, std::size_t offset, std::size_t size)
+{
+	glBindBufferRange(GL_UNIFORM_BUFFER, static_cast<GLuint>(binding), buffer.gl_buffer_id, static_cast<GLintptr>(offset), static_cast<GLsizeiptr>(size));
+}
+
 void rasterizer::draw_arrays(const vertex_array& vao, drawing_mode mode, std::size_t offset, std::size_t count)
 {
 	GLenum gl_mode = drawing_mode_lut[static_cast<std::size_t>(mode)];
@@ -133,6 +292,7 @@ void rasterizer::draw_arrays(const vertex_array& vao, drawing_mode mode, std::si
 		bound_vao = &vao;
 	}
 
+	draw_call_counter().add();
 	glDrawArrays(gl_mode, static_cast<GLint>(offset), static_cast<GLsizei>(count));
 }
 
@@ -146,6 +306,7 @@ void rasterizer::draw_arrays_instanced(const vertex_array& vao, drawing_mode mod
 		bound_vao = &vao;
 	}
 
+	draw_call_counter().add();
 	glDrawArraysInstanced(gl_mode, static_cast<GLint>(offset), static_cast<GLsizei>(count), static_cast<GLsizei>(instance_count));
 }
 
@@ -160,7 +321,76 @@ void rasterizer::draw_elements(const vertex_array& vao, drawing_mode mode, std::
 		bound_vao = &vao;
 	}
 
+	draw_call_counter().add();
 	glDrawElements(gl_mode, static_cast<GLsizei>(count), gl_type, (const GLvoid*)offset);
 }
 
+void rasterizer::draw_elements_instanced(const vertex_array& vao, drawing_mode mode, std::size_t offset, std::size_t count, element_array_type type, std::size_t instance_count)
+{
+	GLenum gl_mode = drawing_mode_lut[static_cast<std::size_t>(mode)];
+	GLenum gl_type = element_array_type_lut[static_cast<std::size_t>(type)];
+
+	if (bound_vao != &vao)
+	{
+		glBindVertexArray(vao.gl_array_id);
+		bound_vao = &vao;
+	}
+
+	draw_call_counter().add();
+	glDrawElementsInstanced(gl_mode, static_cast<GLsizei>(count), gl_type, (const GLvoid*)offset, static_cast<GLsizei>(instance_count));
+}
+
+void rasterizer::multi_draw_arrays(const vertex_array& vao, drawing_mode mode, const std::size_t* offsets, const std::size_t* counts, std::size_t draw_count)
+{
+	GLenum gl_mode = drawing_mode_lut[static_cast<std::size_t>(mode)];
+	
+	multi_draw_firsts.resize(draw_count);
+	multi_draw_counts.resize(draw_count);
+	for (std::size_t i = 0; i < draw_count; ++i)
+	{
+		multi_draw_firsts[i] = static_cast<GLint>(offsets[i]);
+		multi_draw_counts[i] = static_cast<GLsizei>(counts[i]);
+	}
+	
+	if (bound_vao != &vao)
+	{
+		glBindVertexArray(vao.gl_array_id);
+		bound_vao = &vao;
+	}
+	
+	draw_call_counter().add();
+	glMultiDrawArrays(gl_mode, multi_draw_firsts.data(), multi_draw_counts.data(), static_cast<GLsizei>(draw_count));
+}
+
+void rasterizer::multi_draw_elements(const vertex_array& vao, drawing_mode mode, const std::size_t* offsets, const std::size_t* counts, element_array_type type, std::size_t draw_count)
+{
+	GLenum gl_mode = drawing_mode_lut[static_cast<std::size_t>(mode)];
+	GLenum gl_type = element_array_type_lut[static_cast<std::size_t>(type)];
+	
+	multi_draw_counts.resize(draw_count);
+	multi_draw_indices.resize(draw_count);
+	for (std::size_t i = 0; i < draw_count; ++i)
+	{
+		multi_draw_counts[i] = static_cast<GLsizei>(counts[i]);
+		multi_draw_indices[i] = (const GLvoid*)offsets[i];
+	}
+	
+	if (bound_vao != &vao)
+	{
+		glBindVertexArray(vao.gl_array_id);
+		bound_vao = &vao;
+	}
+	
+	draw_call_counter().add();
+	glMultiDrawElements(gl_mode, multi_draw_counts.data(), gl_type, multi_draw_indices.data(), static_cast<GLsizei>(draw_count));
+}
+
+void set_capability(GLenum capability, bool enabled)
+{
+	if (enabled)
+		glEnable(capability);
+	else
+		glDisable(capability);
+}
+
 } // namespace gl
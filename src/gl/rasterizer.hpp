@@ -20,13 +20,16 @@
 #ifndef ANTKEEPER_GL_RASTERIZER_HPP
 #define ANTKEEPER_GL_RASTERIZER_HPP
 
+#include "gl/render-state.hpp"
 #include <cstdlib>
+#include <vector>
 
 namespace gl {
 
 class framebuffer;
 class vertex_array;
 class shader_program;
+class uniform_buffer;
 enum class drawing_mode;
 enum class element_array_type;
 
@@ -99,12 +102,54 @@ public:
 	 */
 	void set_viewport(int x, int y, int width, int height);
 	
+	/**
+	 * Sets the scissor box, which limits drawing and clearing while scissor testing is enabled.
+	 *
+	 * @param x X-coordinate of the scissor box.
+	 * @param y Y-coordinate of the scissor box.
+	 * @param width Width of the scissor box.
+	 * @param height Height of the scissor box.
+	 */
+	void set_scissor(int x, int y, int width, int height);
+	
+	/**
+	 * Sets the fixed-function render state. Only the state which differs from the current render state is changed.
+	 *
+	 * @param state Render state to apply.
+	 */
+	void set_render_state(const render_state& state);
+	
+	/// Returns the current render state.
+	const render_state& get_render_state() const;
+	
 	/**
 	 * Binds a shader program.
 	 *
 	 * @param program Shader program to bind.
 	 */
 	void use_program(const shader_program& program);
+	
+	/**
+	 * Binds a uniform buffer to an indexed uniform buffer binding point.
+	 *
+	 * @param buffer Uniform buffer to bind.
+	 * @param binding Index of the uniform buffer binding point.
+	 *
+	 * @see gl::shader_program::bind_uniform_block()
+	 */
+	void bind_uniform_buffer(const uniform_buffer& buffer, unsigned int binding);
+	
+	/**
+	 * Binds a range of a uniform buffer to an indexed uniform buffer binding point.
+	 *
+	 * @param buffer Uniform buffer to bind.
+	 * @param binding Index of the uniform buffer binding point.
+	 * @param offset Offset of the range, in bytes. Must be a multiple of gl::uniform_buffer::get_offset_alignment().
+	 * @param size Size of the range, in bytes.
+	 *
+	 * @see gl::shader_program::bind_uniform_block()
+	 */
+	void bind_uniform_buffer_range(const uniform_buffer& buffer, unsigned int binding, std::size_t offset, std::size_t size);
 
 	/**
 	 *
@@ -117,6 +162,31 @@ public:
 	 *
 	 */
 	void draw_elements(const vertex_array& vao, drawing_mode mode, std::size_t offset, std::size_t count, element_array_type type);
+	
+	void draw_elements_instanced(const vertex_array& vao, drawing_mode mode, std::size_t offset, std::size_t count, element_array_type type, std::size_t instance_count);
+	
+	/**
+	 * Draws multiple ranges of vertices of a vertex array with a single draw call.
+	 *
+	 * @param vao Vertex array.
+	 * @param mode Drawing mode.
+	 * @param offsets Index of the first vertex of each range.
+	 * @param counts Number of vertices in each range.
+	 * @param draw_count Number of ranges.
+	 */
+	void multi_draw_arrays(const vertex_array& vao, drawing_mode mode, const std::size_t* offsets, const std::size_t* counts, std::size_t draw_count);
+	
+	/**
+	 * Draws multiple ranges of the element buffer bound to a vertex array with a single draw call.
+	 *
+	 * @param vao Vertex array.
+	 * @param mode Drawing mode.
+	 * @param offsets Byte offset of each range into the element buffer.
+	 * @param counts Number of elements in each range.
+	 * @param type Element type.
+	 * @param draw_count Number of ranges.
+	 */
+	void multi_draw_elements(const vertex_array& vao, drawing_mode mode, const std::size_t* offsets, const std::size_t* counts, element_array_type type, std::size_t draw_count);
 
 	/**
 	 * Returns the default framebuffer associated with the OpenGL context of a window.
@@ -124,10 +194,24 @@ public:
 	const framebuffer& get_default_framebuffer() const;
 
 private:
+	/**
+	 * Applies a render state.
+	 *
+	 * @param state Render state to apply.
+	 * @param force If `true`, all state will be applied, otherwise only state which differs from the current render state.
+	 */
+	void apply_render_state(const render_state& state, bool force);
+	
 	framebuffer* default_framebuffer;
 	const framebuffer* bound_framebuffer;
 	const vertex_array* bound_vao;
 	const shader_program* bound_shader_program;
+	render_state current_state;
+	
+	/// Ranges of the most recent multi-draw call, converted to the types expected by OpenGL.
+	std::vector<int> multi_draw_firsts;
+	std::vector<int> multi_draw_counts;
+	std::vector<const void*> multi_draw_indices;
 };
 
 inline const framebuffer& rasterizer::get_default_framebuffer() const
@@ -135,6 +219,11 @@ inline const framebuffer& rasterizer::get_default_framebuffer() const
 	return *default_framebuffer;
 }
 
+inline const render_state& rasterizer::get_render_state() const
+{
+	return current_state;
+}
+
 } // namespace gl
 
 #endif // ANTKEEPER_GL_RASTERIZER_HPP
@@ -0,0 +1,139 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gl/readback-buffer.hpp"
+#include "gl/framebuffer.hpp"
+#include "debug/gl-monitor.hpp"
+#include <glad/glad.h>
+
+namespace gl {
+
+readback_buffer::readback_buffer():
+	gl_buffer_id(0),
+	gl_sync(nullptr),
+	size(0),
+	dimensions({0, 0})
+{
+	glGenBuffers(1, &gl_buffer_id);
+}
+
+readback_buffer::~readback_buffer()
+{
+	if (gl_sync)
+		glDeleteSync(static_cast<GLsync>(gl_sync));
+	glDeleteBuffers(1, &gl_buffer_id);
+}
+
+void readback_buffer::read_depth(const framebuffer& framebuffer)
+{
+	reserve(framebuffer, sizeof(float));
+	
+	// Read from the framebuffer, then restore the previous read framebuffer
+	GLint previous_framebuffer = 0;
+	glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &previous_framebuffer);
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer.gl_framebuffer_id);
+	glReadPixels(0, 0, dimensions[0], dimensions[1], GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, static_cast<GLuint>(previous_framebuffer));
+	
+	fence();
+}
+
+void readback_buffer::read_color(const framebuffer& framebuffer, bool alpha)
+{
+	reserve(framebuffer, (alpha) ? 4 : 3);
+	
+	// Read tightly-packed rows from the framebuffer, then restore the previous read framebuffer and pack alignment
+	GLint previous_framebuffer = 0;
+	GLint previous_alignment = 4;
+	glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &previous_framebuffer);
+	glGetIntegerv(GL_PACK_ALIGNMENT, &previous_alignment);
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer.gl_framebuffer_id);
+	glReadBuffer((framebuffer.gl_framebuffer_id) ? GL_COLOR_ATTACHMENT0 : GL_BACK);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(0, 0, dimensions[0], dimensions[1], (alpha) ? GL_RGBA : GL_RGB, GL_UNSIGNED_BYTE, nullptr);
+	glPixelStorei(GL_PACK_ALIGNMENT, previous_alignment);
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, static_cast<GLuint>(previous_framebuffer));
+	
+	fence();
+}
+
+void readback_buffer::reserve(const framebuffer& framebuffer, std::size_t pixel_size)
+{
+	if (gl_sync)
+	{
+		glDeleteSync(static_cast<GLsync>(gl_sync));
+		gl_sync = nullptr;
+	}
+	
+	dimensions = framebuffer.get_dimensions();
+	const std::size_t required_size = static_cast<std::size_t>(dimensions[0]) * static_cast<std::size_t>(dimensions[1]) * pixel_size;
+	
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, gl_buffer_id);
+	if (size != required_size)
+	{
+		size = required_size;
+		glBufferData(GL_PIXEL_PACK_BUFFER, size, nullptr, GL_STREAM_READ);
+	}
+}
+
+void readback_buffer::fence()
+{
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	gl_sync = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+bool readback_buffer::is_ready() const
+{
+	if (!gl_sync)
+		return false;
+	
+	GLint status = GL_UNSIGNALED;
+	glGetSynciv(static_cast<GLsync>(gl_sync), GL_SYNC_STATUS, 1, nullptr, &status);
+	
+	return (status == GL_SIGNALED);
+}
+
+const void* readback_buffer::map()
+{
+	if (gl_sync)
+	{
+		glDeleteSync(static_cast<GLsync>(gl_sync));
+		gl_sync = nullptr;
+	}
+	
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, gl_buffer_id);
+	const void* pixels;
+	{
+		// Waits for the transfer if it hasn't finished
+		debug::gl_stall_scope stall("glMapBufferRange");
+		pixels = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, size, GL_MAP_READ_BIT);
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	
+	return pixels;
+}
+
+void readback_buffer::unmap()
+{
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, gl_buffer_id);
+	glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
+} // namespace gl
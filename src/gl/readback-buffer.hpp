@@ -0,0 +1,106 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ANTKEEPER_GL_READBACK_BUFFER_HPP
+#define ANTKEEPER_GL_READBACK_BUFFER_HPP
+
+#include <array>
+#include <cstdlib>
+
+namespace gl {
+
+class framebuffer;
+
+/**
+ * Pixel pack buffer into which framebuffer contents are read back asynchronously.
+ *
+ * A readback is complete once the GPU has copied the pixels into the buffer, which is signaled by a fence rather than waited upon, so that the contents of a framebuffer can be mapped one or more frames after they were read without stalling the pipeline.
+ */
+class readback_buffer
+{
+public:
+	/// Creates a readback buffer.
+	readback_buffer();
+	
+	/// Destroys a readback buffer.
+	~readback_buffer();
+	
+	readback_buffer(const readback_buffer&) = delete;
+	readback_buffer& operator=(const readback_buffer&) = delete;
+	
+	/**
+	 * Begins reading back the depth attachment of a framebuffer, as 32-bit floats in rows from bottom to top, replacing the previous contents of the buffer.
+	 *
+	 * @param framebuffer Framebuffer with a depth attachment.
+	 */
+	void read_depth(const framebuffer& framebuffer);
+	
+	/**
+	 * Begins reading back the color attachment of a framebuffer, or the back buffer of the default framebuffer, as tightly-packed 8-bit RGB or RGBA in rows from bottom to top, replacing the previous contents of the buffer.
+	 *
+	 * @param framebuffer Framebuffer with a color attachment, or the default framebuffer.
+	 * @param alpha `true` to read RGBA rather than RGB.
+	 */
+	void read_color(const framebuffer& framebuffer, bool alpha = false);
+	
+	/// Returns `true` if a readback has begun and its pixels have not yet been mapped.
+	bool is_pending() const;
+	
+	/// Returns `true` if a pending readback has completed, such that it can be mapped without stalling.
+	bool is_ready() const;
+	
+	/**
+	 * Maps the pixels of the pending readback for reading, blocking until the readback is complete, and ends the readback.
+	 *
+	 * @return Pointer to the pixels, valid until unmap() is called.
+	 */
+	const void* map();
+	
+	/// Unmaps the pixels.
+	void unmap();
+	
+	/// Returns the dimensions of the most recent readback, in pixels.
+	const std::array<int, 2>& get_dimensions() const;
+
+private:
+	/// Allocates the buffer for a readback of the given number of bytes per pixel.
+	void reserve(const framebuffer& framebuffer, std::size_t pixel_size);
+	
+	/// Ends the readback issued since reserve() with a fence.
+	void fence();
+	
+	unsigned int gl_buffer_id;
+	void* gl_sync;
+	std::size_t size;
+	std::array<int, 2> dimensions;
+};
+
+inline bool readback_buffer::is_pending() const
+{
+	return (gl_sync != nullptr);
+}
+
+inline const std::array<int, 2>& readback_buffer::get_dimensions() const
+{
+	return dimensions;
+}
+
+} // namespace gl
+
+#endif // ANTKEEPER_GL_READBACK_BUFFER_HPP
@@ -0,0 +1,115 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ANTKEEPER_GL_RENDER_STATE_HPP
+#define ANTKEEPER_GL_RENDER_STATE_HPP
+
+#include "gl/blend-factor.hpp"
+#include "gl/comparison-function.hpp"
+#include "gl/cull-face.hpp"
+#include "gl/stencil-operation.hpp"
+
+namespace gl {
+
+/**
+ * Fixed-function rasterizer state, applied with gl::rasterizer::set_render_state().
+ *
+ * A default-constructed render state matches the initial state of an OpenGL context.
+ */
+struct render_state
+{
+	/// Creates a render state with the OpenGL default values.
+	render_state();
+	
+	/// Blending
+	/// @{
+	bool blend_enabled;
+	blend_factor blend_source;
+	blend_factor blend_destination;
+	
+	/// If `true`, alpha is blended with its own factors, rather than with the color blend factors.
+	bool blend_separate_alpha;
+	blend_factor blend_source_alpha;
+	blend_factor blend_destination_alpha;
+	/// @}
+	
+	/// Depth testing and writing
+	/// @{
+	bool depth_test_enabled;
+	comparison_function depth_function;
+	bool depth_write_enabled;
+	float depth_range_near;
+	float depth_range_far;
+	/// @}
+	
+	/// Face culling
+	/// @{
+	bool cull_enabled;
+	cull_face culled_face;
+	/// @}
+	
+	/// Stencil testing and writing
+	/// @{
+	bool stencil_test_enabled;
+	comparison_function stencil_function;
+	int stencil_reference;
+	unsigned int stencil_read_mask;
+	unsigned int stencil_write_mask;
+	stencil_operation stencil_fail;
+	stencil_operation stencil_depth_fail;
+	stencil_operation stencil_pass;
+	/// @}
+	
+	/// Color writing
+	bool color_write_enabled;
+	
+	/// Scissor testing
+	bool scissor_test_enabled;
+};
+
+inline render_state::render_state():
+	blend_enabled(false),
+	blend_source(blend_factor::one),
+	blend_destination(blend_factor::zero),
+	blend_separate_alpha(false),
+	blend_source_alpha(blend_factor::one),
+	blend_destination_alpha(blend_factor::zero),
+	depth_test_enabled(false),
+	depth_function(comparison_function::less),
+	depth_write_enabled(true),
+	depth_range_near(0.0f),
+	depth_range_far(1.0f),
+	cull_enabled(false),
+	culled_face(cull_face::back),
+	stencil_test_enabled(false),
+	stencil_function(comparison_function::always),
+	stencil_reference(0),
+	stencil_read_mask(~0u),
+	stencil_write_mask(~0u),
+	stencil_fail(stencil_operation::keep),
+	stencil_depth_fail(stencil_operation::keep),
+	stencil_pass(stencil_operation::keep),
+	color_write_enabled(true),
+	scissor_test_enabled(false)
+{}
+
+} // namespace gl
+
+#endif // ANTKEEPER_GL_RENDER_STATE_HPP
+
@@ -20,6 +20,8 @@
 #include "gl/shader-input.hpp"
 #include "gl/texture-2d.hpp"
 #include "gl/texture-cube.hpp"
+#include "gl/texture-2d-array.hpp"
+#include "gl/texture-3d.hpp"
 #include <glad/glad.h>
 
 namespace gl {
@@ -31,7 +33,8 @@ shader_input::shader_input(shader_program* program, std::size_t input_index, int
 	name(name),
 	data_type(data_type),
 	element_count(element_count),
-	texture_unit(texture_unit)
+	texture_unit(texture_unit),
+	upload_tag(0)
 {}
 
 shader_input::~shader_input()
@@ -42,6 +45,8 @@ bool shader_input::upload(const bool& value) const
 	if (gl_uniform_location == -1)
 		return false;
 	
+	upload_tag = 0;
+	
 	glUniform1i(gl_uniform_location, static_cast<GLint>(value));
 	return true;
 }
@@ -51,6 +56,8 @@ bool shader_input::upload(const bool2& value) const
 	if (gl_uniform_location == -1)
 		return false;
 	
+	upload_tag = 0;
+	
 	const GLint values[] = {value[0], value[1]};
 	glUniform2iv(gl_uniform_location, 1, values);
 	return true;
@@ -61,6 +68,8 @@ bool shader_input::upload(const bool3& value) const
 	if (gl_uniform_location == -1)
 		return false;
 	
+	upload_tag = 0;
+	
 	const GLint values[] = {value[0], value[1], value[2]};
 	glUniform3iv(gl_uniform_location, 1, values);
 	return true;
@@ -71,6 +80,8 @@ bool shader_input::upload(const bool4& value) const
 	if (gl_uniform_location == -1)
 		return false;
 	
+	upload_tag = 0;
+	
 	const GLint values[] = {value[0], value[1], value[2], value[3]};
 	glUniform4iv(gl_uniform_location, 1, values);
 	return true;
@@ -81,6 +92,8 @@ bool shader_input::upload(const int& value) const
 	if (gl_uniform_location == -1)
 		return false;
 	
+	upload_tag = 0;
+	
 	glUniform1i(gl_uniform_location, value);
 	return true;
 }
@@ -90,6 +103,8 @@ bool shader_input::upload(const int2& value) const
 	if (gl_uniform_location == -1)
 		return false;
 	
+	upload_tag = 0;
+	
 	glUniform2iv(gl_uniform_location, 1, value.data());
 	return true;
 }
@@ -99,6 +114,8 @@ bool shader_input::upload(const int3& value) const
 	if (gl_uniform_location == -1)
 		return false;
 	
+	upload_tag = 0;
+	
 	glUniform3iv(gl_uniform_location, 1, value.data());
 	return true;
 }
@@ -108,6 +125,8 @@ bool shader_input::upload(const int4& value) const
 	if (gl_uniform_location == -1)
 		return false;
 	
+	upload_tag = 0;
+	
 	glUniform4iv(gl_uniform_location, 1, value.data());
 	return true;
 }
@@ -117,6 +136,8 @@ bool shader_input::upload(const unsigned int& value) const
 	if (gl_uniform_location == -1)
 		return false;
 	
+	upload_tag = 0;
+	
 	glUniform1ui(gl_uniform_location, value);
 	return true;
 }
@@ -126,6 +147,8 @@ bool shader_input::upload(const uint2& value) const
 	if (gl_uniform_location == -1)
 		return false;
 	
+	upload_tag = 0;
+	
 	glUniform2uiv(gl_uniform_location, 1, value.data());
 	return true;
 }
@@ -135,6 +158,8 @@ bool shader_input::upload(const uint3& value) const
 	if (gl_uniform_location == -1)
 		return false;
 	
+	upload_tag = 0;
+	
 	glUniform3uiv(gl_uniform_location, 1, value.data());
 	return true;
 }
@@ -144,6 +169,8 @@ bool shader_input::upload(const uint4& value) const
 	if (gl_uniform_location == -1)
 		return false;
 	
+	upload_tag = 0;
+	
 	glUniform4uiv(gl_uniform_location, 1, value.data());
 	return true;
 }
@@ -153,6 +180,8 @@ bool shader_input::upload(const float& value) const
 	if (gl_uniform_location == -1)
 		return false;
 	
+	upload_tag = 0;
+	
 	glUniform1f(gl_uniform_location, value);
 	return true;
 }
@@ -162,6 +191,8 @@ bool shader_input::upload(const float2& value) const
 	if (gl_uniform_location == -1)
 		return false;
 	
+	upload_tag = 0;
+	
 	glUniform2fv(gl_uniform_location, 1, value.data());
 	return true;
 }
@@ -171,6 +202,8 @@ bool shader_input::upload(const float3& value) const
 	if (gl_uniform_location == -1)
 		return false;
 	
+	upload_tag = 0;
+	
 	glUniform3fv(gl_uniform_location, 1, value.data());
 	return true;
 }
@@ -180,6 +213,8 @@ bool shader_input::upload(const float4& value) const
 	if (gl_uniform_location == -1)
 		return false;
 	
+	upload_tag = 0;
+	
 	glUniform4fv(gl_uniform_location, 1, value.data());
 	return true;
 }
@@ -189,6 +224,8 @@ bool shader_input::upload(const float2x2& value) const
 	if (gl_uniform_location == -1)
 		return false;
 	
+	upload_tag = 0;
+	
 	glUniformMatrix2fv(gl_uniform_location, 1, GL_FALSE, value[0].data());
 	return true;
 }
@@ -198,6 +235,8 @@ bool shader_input::upload(const float3x3& value) const
 	if (gl_uniform_location == -1)
 		return false;
 	
+	upload_tag = 0;
+	
 	glUniformMatrix3fv(gl_uniform_location, 1, GL_FALSE, value[0].data());
 	return true;
 }
@@ -207,6 +246,8 @@ bool shader_input::upload(const float4x4& value) const
 	if (gl_uniform_location == -1)
 		return false;
 	
+	upload_tag = 0;
+	
 	glUniformMatrix4fv(gl_uniform_location, 1, GL_FALSE, value[0].data());
 	return true;
 }
@@ -216,6 +257,8 @@ bool shader_input::upload(const texture_2d* value) const
 	if (gl_uniform_location == -1)
 		return false;
 	
+	upload_tag = 0;
+	
 	// Bind texture to a texture unit reserved by this shader input
 	glActiveTexture(GL_TEXTURE0 + texture_unit);
 	glBindTexture(GL_TEXTURE_2D, value->gl_texture_id);
@@ -231,6 +274,8 @@ bool shader_input::upload(const texture_cube* value) const
 	if (gl_uniform_location == -1)
 		return false;
 	
+	upload_tag = 0;
+	
 	// Bind texture to a texture unit reserved by this shader input
 	glActiveTexture(GL_TEXTURE0 + texture_unit);
 	glBindTexture(GL_TEXTURE_CUBE_MAP, value->gl_texture_id);
@@ -241,11 +286,47 @@ bool shader_input::upload(const texture_cube* value) const
 	return true;
 }
 
+bool shader_input::upload(const texture_2d_array* value) const
+{
+	if (gl_uniform_location == -1)
+		return false;
+	
+	upload_tag = 0;
+	
+	// Bind texture to a texture unit reserved by this shader input
+	glActiveTexture(GL_TEXTURE0 + texture_unit);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, value->gl_texture_id);
+	
+	// Upload texture unit index to shader
+	glUniform1i(gl_uniform_location, texture_unit);
+	
+	return true;
+}
+
+bool shader_input::upload(const texture_3d* value) const
+{
+	if (gl_uniform_location == -1)
+		return false;
+	
+	upload_tag = 0;
+	
+	// Bind texture to a texture unit reserved by this shader input
+	glActiveTexture(GL_TEXTURE0 + texture_unit);
+	glBindTexture(GL_TEXTURE_3D, value->gl_texture_id);
+	
+	// Upload texture unit index to shader
+	glUniform1i(gl_uniform_location, texture_unit);
+	
+	return true;
+}
+
 bool shader_input::upload(std::size_t index, const bool& value) const
 {
 	if (gl_uniform_location == -1)
 		return false;
 	
+	upload_tag = 0;
+	
 	glUniform1i(gl_uniform_location + static_cast<int>(index), static_cast<GLint>(value));
 	return true;
 }
@@ -255,6 +336,8 @@ bool shader_input::upload(std::size_t index, const bool2& value) const
 	if (gl_uniform_location == -1)
 		return false;
 	
+	upload_tag = 0;
+	
 	const GLint values[] = {value[0], value[1]};
 	glUniform2iv(gl_uniform_location + static_cast<int>(index), 1, values);
 	return true;
@@ -265,6 +348,8 @@ bool shader_input::upload(std::size_t index, const bool3& value) const
 	if (gl_uniform_location == -1)
 		return false;
 	
+	upload_tag = 0;
+	
 	const GLint values[] = {value[0], value[1], value[3]};
 	glUniform3iv(gl_uniform_location + static_cast<int>(index), 1, values);
 	return true;
@@ -275,6 +360,8 @@ bool shader_input::upload(std::size_t index, const bool4& value) const
 	if (gl_uniform_location == -1)
 		return false;
 	
+	upload_tag = 0;
+	
 	const GLint values[] = {value[0], value[1], value[3], value[4]};
 	glUniform4iv(gl_uniform_location + static_cast<int>(index), 1, values);
 	return true;
@@ -285,6 +372,8 @@ bool shader_input::upload(std::size_t index, const int& value) const
 	if (gl_uniform_location == -1)
 		return false;
 	
+	upload_tag = 0;
+	
 	glUniform1i(gl_uniform_location + static_cast<int>(index), value);
 	return true;
 }
@@ -294,6 +383,8 @@ bool shader_input::upload(std::size_t index, const int2& value) const
 	if (gl_uniform_location == -1)
 		return false;
 	
+	upload_tag = 0;
+	
 	glUniform2iv(gl_uniform_location + static_cast<int>(index), 1, value.data());
 	return true;
 }
@@ -303,6 +394,8 @@ bool shader_input::upload(std::size_t index, const int3& value) const
 	if (gl_uniform_location == -1)
 		return false;
 	
+	upload_tag = 0;
+	
 	glUniform3iv(gl_uniform_location + static_cast<int>(index), 1, value.data());
 	return true;
 }
@@ -312,6 +405,8 @@ bool shader_input::upload(std::size_t index, const int4& value) const
 	if (gl_uniform_location == -1)
 		return false;
 	
+	upload_tag = 0;
+	
 	glUniform4iv(gl_uniform_location + static_cast<int>(index), 1, value.data());
 	return true;
 }
@@ -321,6 +416,8 @@ bool shader_input::upload(std::size_t index, const unsigned int& value) const
 	if (gl_uniform_location == -1)
 		return false;
 	
+	upload_tag = 0;
+	
 	glUniform1ui(gl_uniform_location + static_cast<int>(index), value);
 	return true;
 }
@@ -330,6 +427,8 @@ bool shader_input::upload(std::size_t index, const uint2& value) const
 	if (gl_uniform_location == -1)
 		return false;
 	
+	upload_tag = 0;
+	
 	glUniform2uiv(gl_uniform_location + static_cast<int>(index), 1, value.data());
 	return true;
 }
@@ -339,6 +438,8 @@ bool shader_input::upload(std::size_t index, const uint3& value) const
 	if (gl_uniform_location == -1)
 		return false;
 	
+	upload_tag = 0;
+	
 	glUniform3uiv(gl_uniform_location + static_cast<int>(index), 1, value.data());
 	return true;
 }
@@ -348,6 +449,8 @@ bool shader_input::upload(std::size_t index, const uint4& value) const
 	if (gl_uniform_location == -1)
 		return false;
 	
+	upload_tag = 0;
+	
 	glUniform4uiv(gl_uniform_location + static_cast<int>(index), 1, value.data());
 	return true;
 }
@@ -357,6 +460,8 @@ bool shader_input::upload(std::size_t index, const float& value) const
 	if (gl_uniform_location == -1)
 		return false;
 	
+	upload_tag = 0;
+	
 	glUniform1f(gl_uniform_location + static_cast<int>(index), value);
 	return true;
 }
@@ -366,6 +471,8 @@ bool shader_input::upload(std::size_t index, const float2& value) const
 	if (gl_uniform_location == -1)
 		return false;
 	
+	upload_tag = 0;
+	
 	glUniform2fv(gl_uniform_location + static_cast<int>(index), 1, value.data());
 	return true;
 }
@@ -375,6 +482,8 @@ bool shader_input::upload(std::size_t index, const float3& value) const
 	if (gl_uniform_location == -1)
 		return false;
 	
+	upload_tag = 0;
+	
 	glUniform3fv(gl_uniform_location + static_cast<int>(index), 1, value.data());
 	return true;
 }
@@ -384,6 +493,8 @@ bool shader_input::upload(std::size_t index, const float4& value) const
 	if (gl_uniform_location == -1)
 		return false;
 	
+	upload_tag = 0;
+	
 	glUniform4fv(gl_uniform_location + static_cast<int>(index), 1, value.data());
 	return true;
 }
@@ -393,6 +504,8 @@ bool shader_input::upload(std::size_t index, const float2x2& value) const
 	if (gl_uniform_location == -1)
 		return false;
 	
+	upload_tag = 0;
+	
 	glUniformMatrix2fv(gl_uniform_location + static_cast<int>(index) * 2, 1, GL_FALSE, value[0].data());
 	return true;
 }
@@ -402,6 +515,8 @@ bool shader_input::upload(std::size_t index, const float3x3& value) const
 	if (gl_uniform_location == -1)
 		return false;
 	
+	upload_tag = 0;
+	
 	glUniformMatrix3fv(gl_uniform_location + static_cast<int>(index) * 3, 1, GL_FALSE, value[0].data());
 	return true;
 }
@@ -411,6 +526,8 @@ bool shader_input::upload(std::size_t index, const float4x4& value) const
 	if (gl_uniform_location == -1)
 		return false;
 	
+	upload_tag = 0;
+	
 	glUniformMatrix4fv(gl_uniform_location + static_cast<int>(index) * 4, 1, GL_FALSE, value[0].data());
 	return true;
 }
@@ -420,6 +537,8 @@ bool shader_input::upload(std::size_t index, const texture_2d* value) const
 	if (gl_uniform_location == -1)
 		return false;
 	
+	upload_tag = 0;
+	
 	// Bind texture to a texture unit reserved by this shader input
 	glActiveTexture(GL_TEXTURE0 + texture_unit + static_cast<int>(index));
 	glBindTexture(GL_TEXTURE_2D, value->gl_texture_id);
@@ -435,6 +554,8 @@ bool shader_input::upload(std::size_t index, const texture_cube* value) const
 	if (gl_uniform_location == -1)
 		return false;
 	
+	upload_tag = 0;
+	
 	// Bind texture to a texture unit reserved by this shader input
 	glActiveTexture(GL_TEXTURE0 + texture_unit + static_cast<int>(index));
 	glBindTexture(GL_TEXTURE_CUBE_MAP, value->gl_texture_id);
@@ -445,11 +566,30 @@ bool shader_input::upload(std::size_t index, const texture_cube* value) const
 	return true;
 }
 
+bool shader_input::upload(std::size_t index, const texture_2d_array* value) const
+{
+	if (gl_uniform_location == -1)
+		return false;
+	
+	upload_tag = 0;
+	
+	// Bind texture to a texture unit reserved by this shader input
+	glActiveTexture(GL_TEXTURE0 + texture_unit + static_cast<int>(index));
+	glBindTexture(GL_TEXTURE_2D_ARRAY, value->gl_texture_id);
+	
+	// Upload texture unit index to shader
+	glUniform1i(gl_uniform_location + static_cast<int>(index), texture_unit + static_cast<int>(index));
+	
+	return true;
+}
+
 bool shader_input::upload(std::size_t index, const bool* values, std::size_t count) const
 {
 	if (gl_uniform_location == -1)
 		return false;
 	
+	upload_tag = 0;
+	
 	int* int_values = new int[count];
 	for (std::size_t i = 0; i < count; ++i)
 		int_values[i] = values[i];
@@ -463,7 +603,9 @@ bool shader_input::upload(std::size_t index, const bool2* values, std::size_t co
 {
 	if (gl_uniform_location == -1)
 		return false;
-
+	
+	upload_tag = 0;
+	
 	int2* int2_values = new int2[count];
 	for (std::size_t i = 0; i < count; ++i)
 		int2_values[i] = {values[i][0], values[i][1]};
@@ -477,7 +619,9 @@ bool shader_input::upload(std::size_t index, const bool3* values, std::size_t co
 {
 	if (gl_uniform_location == -1)
 		return false;
-
+	
+	upload_tag = 0;
+	
 	int3* int3_values = new int3[count];
 	for (std::size_t i = 0; i < count; ++i)
 		int3_values[i] = {values[i][0], values[i][1], values[i][2]};
@@ -491,7 +635,9 @@ bool shader_input::upload(std::size_t index, const bool4* values, std::size_t co
 {
 	if (gl_uniform_location == -1)
 		return false;
-
+	
+	upload_tag = 0;
+	
 	int4* int4_values = new int4[count];
 	for (std::size_t i = 0; i < count; ++i)
 		int4_values[i] = {values[i][0], values[i][1], values[i][2], values[i][3]};
@@ -506,6 +652,8 @@ bool shader_input::upload(std::size_t index, const int* values, std::size_t coun
 	if (gl_uniform_location == -1)
 		return false;
 	
+	upload_tag = 0;
+	
 	glUniform1iv(gl_uniform_location + static_cast<int>(index), static_cast<GLsizei>(count), &(*values));
 	return true;
 }
@@ -515,6 +663,8 @@ bool shader_input::upload(std::size_t index, const int2* values, std::size_t cou
 	if (gl_uniform_location == -1)
 		return false;
 	
+	upload_tag = 0;
+	
 	glUniform2iv(gl_uniform_location + static_cast<int>(index), static_cast<GLsizei>(count), (*values).data());
 	return true;
 }
@@ -524,6 +674,8 @@ bool shader_input::upload(std::size_t index, const int3* values, std::size_t cou
 	if (gl_uniform_location == -1)
 		return false;
 	
+	upload_tag = 0;
+	
 	glUniform3iv(gl_uniform_location + static_cast<int>(index), static_cast<GLsizei>(count), (*values).data());
 	return true;
 }
@@ -533,6 +685,8 @@ bool shader_input::upload(std::size_t index, const int4* values, std::size_t cou
 	if (gl_uniform_location == -1)
 		return false;
 	
+	upload_tag = 0;
+	
 	glUniform4iv(gl_uniform_location + static_cast<int>(index), static_cast<GLsizei>(count), (*values).data());
 	return true;
 }
@@ -542,6 +696,8 @@ bool shader_input::upload(std::size_t index, const unsigned int* values, std::si
 	if (gl_uniform_location == -1)
 		return false;
 	
+	upload_tag = 0;
+	
 	glUniform1uiv(gl_uniform_location + static_cast<int>(index), static_cast<GLsizei>(count), &(*values));
 	return true;
 }
@@ -551,6 +707,8 @@ bool shader_input::upload(std::size_t index, const uint2* values, std::size_t co
 	if (gl_uniform_location == -1)
 		return false;
 	
+	upload_tag = 0;
+	
 	glUniform2uiv(gl_uniform_location + static_cast<int>(index), static_cast<GLsizei>(count), (*values).data());
 	return true;
 }
@@ -560,6 +718,8 @@ bool shader_input::upload(std::size_t index, const uint3* values, std::size_t co
 	if (gl_uniform_location == -1)
 		return false;
 	
+	upload_tag = 0;
+	
 	glUniform3uiv(gl_uniform_location + static_cast<int>(index), static_cast<GLsizei>(count), (*values).data());
 	return true;
 }
@@ -569,6 +729,8 @@ bool shader_input::upload(std::size_t index, const uint4* values, std::size_t co
 	if (gl_uniform_location == -1)
 		return false;
 	
+	upload_tag = 0;
+	
 	glUniform4uiv(gl_uniform_location + static_cast<int>(index), static_cast<GLsizei>(count), (*values).data());
 	return true;
 }
@@ -578,6 +740,8 @@ bool shader_input::upload(std::size_t index, const float* values, std::size_t co
 	if (gl_uniform_location == -1)
 		return false;
 	
+	upload_tag = 0;
+	
 	glUniform1fv(gl_uniform_location + static_cast<int>(index), static_cast<GLsizei>(count), &(*values));
 	return true;
 }
@@ -587,6 +751,8 @@ bool shader_input::upload(std::size_t index, const float2* values, std::size_t c
 	if (gl_uniform_location == -1)
 		return false;
 	
+	upload_tag = 0;
+	
 	glUniform2fv(gl_uniform_location + static_cast<int>(index), static_cast<GLsizei>(count), (*values).data());
 	return true;
 }
@@ -596,6 +762,8 @@ bool shader_input::upload(std::size_t index, const float3* values, std::size_t c
 	if (gl_uniform_location == -1)
 		return false;
 	
+	upload_tag = 0;
+	
 	glUniform3fv(gl_uniform_location + static_cast<int>(index), static_cast<GLsizei>(count), (*values).data());
 	return true;
 }
@@ -605,6 +773,8 @@ bool shader_input::upload(std::size_t index, const float4* values, std::size_t c
 	if (gl_uniform_location == -1)
 		return false;
 	
+	upload_tag = 0;
+	
 	glUniform4fv(gl_uniform_location + static_cast<int>(index), static_cast<GLsizei>(count), (*values).data());
 	return true;
 }
@@ -614,6 +784,8 @@ bool shader_input::upload(std::size_t index, const float2x2* values, std::size_t
 	if (gl_uniform_location == -1)
 		return false;
 	
+	upload_tag = 0;
+	
 	glUniformMatrix2fv(gl_uniform_location + static_cast<int>(index) * 2, static_cast<GLsizei>(count), GL_FALSE, (*values)[0].data());
 	return true;
 }
@@ -623,6 +795,8 @@ bool shader_input::upload(std::size_t index, const float3x3* values, std::size_t
 	if (gl_uniform_location == -1)
 		return false;
 	
+	upload_tag = 0;
+	
 	glUniformMatrix3fv(gl_uniform_location + static_cast<int>(index) * 3, static_cast<GLsizei>(count), GL_FALSE, (*values)[0].data());
 	return true;
 }
@@ -632,6 +806,8 @@ bool shader_input::upload(std::size_t index, const float4x4* values, std::size_t
 	if (gl_uniform_location == -1)
 		return false;
 	
+	upload_tag = 0;
+	
 	glUniformMatrix4fv(gl_uniform_location + static_cast<int>(index) * 4, static_cast<GLsizei>(count), GL_FALSE, (*values)[0].data());
 	return true;
 }
@@ -641,6 +817,8 @@ bool shader_input::upload(std::size_t index, const texture_2d** values, std::siz
 	if (gl_uniform_location == -1)
 		return false;
 	
+	upload_tag = 0;
+	
 	for (std::size_t i = 0; i < count; ++i)
 	{
 		// Bind texture to a texture unit reserved by this shader input
@@ -659,6 +837,8 @@ bool shader_input::upload(std::size_t index, const texture_cube** values, std::s
 	if (gl_uniform_location == -1)
 		return false;
 	
+	upload_tag = 0;
+	
 	for (std::size_t i = 0; i < count; ++i)
 	{
 		// Bind texture to a texture unit reserved by this shader input
@@ -672,4 +852,24 @@ bool shader_input::upload(std::size_t index, const texture_cube** values, std::s
 	return true;
 }
 
+bool shader_input::upload(std::size_t index, const texture_2d_array** values, std::size_t count) const
+{
+	if (gl_uniform_location == -1)
+		return false;
+	
+	upload_tag = 0;
+	
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		// Bind texture to a texture unit reserved by this shader input
+		glActiveTexture(GL_TEXTURE0 + texture_unit + static_cast<int>(index + i));
+		glBindTexture(GL_TEXTURE_2D_ARRAY, values[i]->gl_texture_id);
+		
+		// Upload texture unit index to shader
+		glUniform1i(gl_uniform_location + static_cast<int>(index + i), texture_unit + static_cast<int>(index + i));
+	}
+	
+	return true;
+}
+
 } // namespace gl
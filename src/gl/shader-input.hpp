@@ -21,6 +21,7 @@
 #define ANTKEEPER_GL_SHADER_INPUT_HPP
 
 #include "utility/fundamental-types.hpp"
+#include <cstdint>
 #include <string>
 
 namespace gl {
@@ -28,6 +29,8 @@ namespace gl {
 class shader_program;
 class texture_2d;
 class texture_cube;
+class texture_2d_array;
+class texture_3d;
 enum class shader_variable_type;
 
 /**
@@ -51,6 +54,16 @@ public:
 	 */
 	std::size_t get_element_count() const;
 	
+	/**
+	 * Sets the tag of the value most recently uploaded through this input, by which callers which upload the same values repeatedly may skip redundant uploads. Every upload resets the tag to `0`, so the tag must be set after the upload it describes.
+	 *
+	 * @param tag Upload tag, or `0` if the uploaded value is unknown.
+	 */
+	void set_upload_tag(std::uint64_t tag) const;
+	
+	/// Returns the tag of the value most recently uploaded through this input.
+	std::uint64_t get_upload_tag() const;
+	
 	/**
 	 * Uploads a value to the shader.
 	 *
@@ -79,6 +92,8 @@ public:
 	bool upload(const float4x4& value) const;
 	bool upload(const texture_2d* value) const;
 	bool upload(const texture_cube* value) const;
+	bool upload(const texture_2d_array* value) const;
+	bool upload(const texture_3d* value) const;
 	///@}
 	
 	/**
@@ -110,6 +125,7 @@ public:
 	bool upload(std::size_t index, const float4x4& value) const;
 	bool upload(std::size_t index, const texture_2d* value) const;
 	bool upload(std::size_t index, const texture_cube* value) const;
+	bool upload(std::size_t index, const texture_2d_array* value) const;
 	///@}
 	
 	/**
@@ -142,6 +158,7 @@ public:
 	bool upload(std::size_t index, const float4x4* values, std::size_t count) const;
 	bool upload(std::size_t index, const texture_2d** values, std::size_t count) const;
 	bool upload(std::size_t index, const texture_cube** values, std::size_t count) const;
+	bool upload(std::size_t index, const texture_2d_array** values, std::size_t count) const;
 	///@}
 	
 private:
@@ -171,6 +188,7 @@ private:
 	shader_variable_type data_type;
 	std::size_t element_count;
 	int texture_unit;
+	mutable std::uint64_t upload_tag;
 };
 
 inline shader_variable_type shader_input::get_data_type() const
@@ -188,6 +206,16 @@ inline std::size_t shader_input::get_element_count() const
 	return element_count;
 }
 
+inline void shader_input::set_upload_tag(std::uint64_t tag) const
+{
+	upload_tag = tag;
+}
+
+inline std::uint64_t shader_input::get_upload_tag() const
+{
+	return upload_tag;
+}
+
 } // namespace gl
 
 #endif // ANTKEEPER_GL_SHADER_INPUT_HPP
@@ -33,7 +33,8 @@ static constexpr GLenum gl_shader_type_lut[] =
 shader_object::shader_object(shader_stage stage):
 	gl_shader_id(0),
 	stage(stage),
-	compiled(false)
+	compiled(false),
+	compile_pending(false)
 {
 	// Look up OpenGL shader type enumeration that corresponds to the given stage 
 	GLenum gl_shader_type = gl_shader_type_lut[static_cast<std::size_t>(stage)];
@@ -74,10 +75,11 @@ void shader_object::source(const std::string& source_code)
 	}
 }
 
-bool shader_object::compile()
+void shader_object::compile_async()
 {
 	// Compile OpenGL shader object
 	glCompileShader(gl_shader_id);
+	compile_pending = true;
 	
 	// Handle OpenGL errors
 	switch (glGetError())
@@ -90,8 +92,15 @@ bool shader_object::compile()
 			throw std::runtime_error("OpenGL shader object handle is not a shader object.");
 			break;
 	}
+}
+
+bool shader_object::compile()
+{
+	if (!compile_pending)
+		compile_async();
+	compile_pending = false;
 	
-	// Get OpenGL shader object compilation status
+	// Get OpenGL shader object compilation status, waiting for compilation to complete
 	GLint gl_compile_status;
 	glGetShaderiv(gl_shader_id, GL_COMPILE_STATUS, &gl_compile_status);
 	compiled = (gl_compile_status == GL_TRUE);
@@ -62,7 +62,15 @@ public:
 	void source(const std::string& source_code);
 	
 	/**
-	 * Compiles the shader object.
+	 * Starts compiling the shader object without waiting for the result, which is read by the next call to compile(). Drivers which compile on background threads, such as those supporting `GL_KHR_parallel_shader_compile`, can then compile several shader objects concurrently.
+	 *
+	 * @exception std::runtime_error Shader object handle is not a value generated by OpenGL.
+	 * @exception std::runtime_error Shader object handle is not a shader object.
+	 */
+	void compile_async();
+	
+	/**
+	 * Compiles the shader object, or finishes compiling it if compile_async() was called.
 	 *
 	 * @return `true` if the shader object was compiled successfully, `false` otherwise. If compilation fails, check the info log via shader_object::get_info_log() for more information.
 	 *
@@ -92,6 +100,7 @@ private:
 	shader_stage stage;
 	std::string info_log;
 	bool compiled;
+	bool compile_pending;
 };
 
 inline shader_stage shader_object::get_stage() const
@@ -42,6 +42,10 @@ shader_program::shader_program():
 
 shader_program::~shader_program()
 {
+	// Delete variants
+	for (auto it = variants.begin(); it != variants.end(); ++it)
+		delete it->second;
+	
 	// Delete shader inputs
 	free_inputs();
 	
@@ -124,6 +128,10 @@ bool shader_program::link()
 	if (glIsProgram(gl_program_id) != GL_TRUE)
 		throw std::runtime_error("OpenGL shader program is not a valid program object.");
 	
+	// Keep the linked binary retrievable, so it can be cached
+	if (is_binary_supported())
+		glProgramParameteri(gl_program_id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+	
 	// Link OpenGL shader program
 	glLinkProgram(gl_program_id);
 	
@@ -135,6 +143,63 @@ bool shader_program::link()
 			break;
 	}
 	
+	read_link_status();
+	
+	return linked;
+}
+
+bool shader_program::load_binary(const void* binary, std::size_t size, unsigned int format)
+{
+	// Check that the OpenGL shader program is valid
+	if (glIsProgram(gl_program_id) != GL_TRUE)
+		throw std::runtime_error("OpenGL shader program is not a valid program object.");
+	
+	// Load OpenGL shader program binary
+	glProgramBinary(gl_program_id, static_cast<GLenum>(format), binary, static_cast<GLsizei>(size));
+	
+	// Discard the error raised for unknown binary formats, rejected binaries are reported by the link status
+	glGetError();
+	
+	read_link_status();
+	
+	return linked;
+}
+
+bool shader_program::get_binary(std::vector<std::uint8_t>& binary, unsigned int& format) const
+{
+	if (!linked || !is_binary_supported())
+		return false;
+	
+	// Get OpenGL shader program binary length
+	GLint gl_binary_length = 0;
+	glGetProgramiv(gl_program_id, GL_PROGRAM_BINARY_LENGTH, &gl_binary_length);
+	if (gl_binary_length <= 0)
+		return false;
+	
+	// Read OpenGL shader program binary
+	binary.resize(static_cast<std::size_t>(gl_binary_length));
+	GLenum gl_binary_format = 0;
+	glGetProgramBinary(gl_program_id, gl_binary_length, &gl_binary_length, &gl_binary_format, binary.data());
+	binary.resize(static_cast<std::size_t>(gl_binary_length));
+	format = static_cast<unsigned int>(gl_binary_format);
+	
+	return !binary.empty();
+}
+
+bool shader_program::is_binary_supported()
+{
+	if (!glProgramBinary || !glGetProgramBinary || !glProgramParameteri)
+		return false;
+	
+	// Some drivers expose the functions without supporting any binary formats
+	GLint gl_binary_format_count = 0;
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &gl_binary_format_count);
+	
+	return (gl_binary_format_count > 0);
+}
+
+void shader_program::read_link_status()
+{
 	// Get OpenGL shader program linking status
 	GLint gl_link_status;
 	glGetProgramiv(gl_program_id, GL_LINK_STATUS, &gl_link_status);
@@ -164,7 +229,8 @@ bool shader_program::link()
 	// Find shader inputs
 	find_inputs();
 	
-	return linked;
+	// Find uniform blocks
+	find_uniform_blocks();
 }
 
 void shader_program::find_inputs()
@@ -281,6 +347,19 @@ void shader_program::find_inputs()
 				available_texture_unit += uniform_size;
 				break;
 			
+			case GL_SAMPLER_2D_ARRAY:
+			case GL_SAMPLER_2D_ARRAY_SHADOW:
+				variable_type = shader_variable_type::texture_2d_array;
+				texture_unit = available_texture_unit;
+				available_texture_unit += uniform_size;
+				break;
+			
+			case GL_SAMPLER_3D:
+				variable_type = shader_variable_type::texture_3d;
+				texture_unit = available_texture_unit;
+				available_texture_unit += uniform_size;
+				break;
+			
 			default:
 				unsupported = true;
 				break;
@@ -304,7 +383,7 @@ void shader_program::find_inputs()
 		{
 			// Create new shader input
 			shader_input* input = new shader_input(this, inputs.size(), uniform_location, input_name, variable_type, uniform_size, texture_unit);
-			input_map[input_name] = input;
+			input_map[intern_string(input_name)] = input;
 			inputs.push_back(input);
 		}
 	}
@@ -313,6 +392,42 @@ void shader_program::find_inputs()
 	delete[] uniform_name;
 }
 
+void shader_program::find_uniform_blocks()
+{
+	uniform_block_map.clear();
+	
+	// Get number of active uniform blocks in the shader
+	GLint active_block_count = 0;
+	glGetProgramiv(gl_program_id, GL_ACTIVE_UNIFORM_BLOCKS, &active_block_count);
+	if (active_block_count <= 0)
+		return;
+	
+	// Get maximum uniform block name length
+	GLint max_block_name_length = 0;
+	glGetProgramiv(gl_program_id, GL_ACTIVE_UNIFORM_BLOCK_MAX_NAME_LENGTH, &max_block_name_length);
+	
+	// Allocate uniform block name buffer
+	std::string block_name(static_cast<std::size_t>(max_block_name_length), '\0');
+	
+	for (GLuint block_index = 0; block_index < static_cast<GLuint>(active_block_count); ++block_index)
+	{
+		GLsizei block_name_length = 0;
+		glGetActiveUniformBlockName(gl_program_id, block_index, static_cast<GLsizei>(max_block_name_length), &block_name_length, block_name.data());
+		uniform_block_map[intern_string(std::string_view(block_name.data(), static_cast<std::size_t>(block_name_length)))] = block_index;
+	}
+}
+
+bool shader_program::bind_uniform_block(string_id name_id, unsigned int binding) const
+{
+	auto it = uniform_block_map.find(name_id);
+	if (it == uniform_block_map.end())
+		return false;
+	
+	glUniformBlockBinding(gl_program_id, static_cast<GLuint>(it->second), static_cast<GLuint>(binding));
+	
+	return true;
+}
+
 void shader_program::free_inputs()
 {
 	for (shader_input* input: inputs)
@@ -323,4 +438,26 @@ void shader_program::free_inputs()
 	inputs.clear();
 }
 
+void shader_program::set_variant(std::uint64_t key_hash, shader_program* variant)
+{
+	if (auto it = variants.find(key_hash); it != variants.end())
+	{
+		if (it->second == variant)
+			return;
+		
+		delete it->second;
+		variants.erase(it);
+	}
+	
+	if (variant)
+		variants[key_hash] = variant;
+}
+
+const shader_program* shader_program::get_variant(std::uint64_t key_hash) const
+{
+	if (auto it = variants.find(key_hash); it != variants.end())
+		return it->second;
+	return nullptr;
+}
+
 } // namespace gl
@@ -20,10 +20,16 @@
 #ifndef ANTKEEPER_GL_SHADER_PROGRAM_HPP
 #define ANTKEEPER_GL_SHADER_PROGRAM_HPP
 
+#include "utility/fnv1a.hpp"
+#include "utility/string-id.hpp"
+#include <cstddef>
+#include <cstdint>
 #include <list>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 namespace gl {
 
@@ -100,6 +106,30 @@ public:
 	 */
 	bool link();
 	
+	/**
+	 * Replaces the shader program with a program binary previously returned by shader_program::get_binary(), instead of linking attached shader objects.
+	 *
+	 * @param binary Program binary.
+	 * @param size Size of the program binary, in bytes.
+	 * @param format Driver-specific format of the program binary.
+	 * @return `true` if the driver accepted the binary, `false` otherwise. Binaries may be rejected at any time, e.g. after a driver update, in which case the program should be linked from its shader objects instead.
+	 *
+	 * @warning All existing pointers to a shader program's shader inputs will be invalidated.
+	 */
+	bool load_binary(const void* binary, std::size_t size, unsigned int format);
+	
+	/**
+	 * Retrieves the binary of a linked shader program.
+	 *
+	 * @param[out] binary Program binary.
+	 * @param[out] format Driver-specific format of the program binary.
+	 * @return `true` if the binary was retrieved, `false` otherwise.
+	 */
+	bool get_binary(std::vector<std::uint8_t>& binary, unsigned int& format) const;
+	
+	/// Returns `true` if the current OpenGL context supports program binaries.
+	static bool is_binary_supported();
+	
 	/// Returns the shader program info log, which is updated when the shader program is linked.
 	const std::string& get_info_log() const;
 	
@@ -110,7 +140,61 @@ public:
 	shader_program& operator=(const shader_program&) = delete;
 
 	const std::list<shader_input*>* get_inputs() const;
-	const shader_input* get_input(const std::string& name) const;
+	
+	/**
+	 * Returns the input with the specified name ID, or `nullptr` if the shader program has no such input.
+	 *
+	 * IDs of literal names should be computed at compile time, e.g. `get_input("model_view_projection"_sid)`, so that connecting inputs involves no string construction or hashing.
+	 *
+	 * @param name_id ID of the input name.
+	 */
+	const shader_input* get_input(string_id name_id) const;
+	
+	/**
+	 * Returns the input with the specified name, or `nullptr` if the shader program has no such input.
+	 *
+	 * @param name Name of the input.
+	 */
+	const shader_input* get_input(std::string_view name) const;
+	
+	/**
+	 * Returns `true` if the shader program contains an active uniform block with the specified name ID.
+	 *
+	 * @param name_id ID of the uniform block name.
+	 */
+	bool has_uniform_block(string_id name_id) const;
+	
+	/// @copydoc has_uniform_block(string_id) const
+	bool has_uniform_block(std::string_view name) const;
+	
+	/**
+	 * Assigns an active uniform block to a uniform buffer binding point.
+	 *
+	 * @param name_id ID of the uniform block name.
+	 * @param binding Index of the uniform buffer binding point.
+	 * @return `true` if the uniform block was found and assigned, `false` otherwise.
+	 *
+	 * @see gl::rasterizer::bind_uniform_buffer()
+	 */
+	bool bind_uniform_block(string_id name_id, unsigned int binding) const;
+	
+	/// @copydoc bind_uniform_block(string_id, unsigned int) const
+	bool bind_uniform_block(std::string_view name, unsigned int binding) const;
+	
+	/**
+	 * Sets a variant of the shader program, such as one built from the same source with additional definitions. The shader program takes ownership of the variant, which is destroyed along with it.
+	 *
+	 * @param key_hash 64-bit FNV-1a hash of the variant key.
+	 * @param variant Variant shader program, or `nullptr` to destroy the variant with the specified key.
+	 */
+	void set_variant(std::uint64_t key_hash, shader_program* variant);
+	
+	/**
+	 * Returns the variant with the specified key hash, or `nullptr` if the shader program has no such variant.
+	 *
+	 * @param key_hash 64-bit FNV-1a hash of the variant key.
+	 */
+	const shader_program* get_variant(std::uint64_t key_hash) const;
 
 private:
 	friend class rasterizer;
@@ -120,12 +204,21 @@ private:
 	bool linked;
 	std::unordered_set<const shader_object*> attached_objects;
 
+	void read_link_status();
 	void find_inputs();
 	void free_inputs();
+	void find_uniform_blocks();
 	
 	std::list<shader_input*> inputs;
-	std::unordered_map<std::string, shader_input*> input_map;
 	
+	/// Inputs, keyed by the interned IDs of their names.
+	std::unordered_map<string_id, shader_input*> input_map;
+	
+	/// Indices of active uniform blocks, keyed by the interned IDs of their names.
+	std::unordered_map<string_id, unsigned int> uniform_block_map;
+	
+	/// Variants, keyed by the 64-bit FNV-1a hashes of their keys.
+	std::unordered_map<std::uint64_t, shader_program*> variants;
 };
 
 inline const std::string& shader_program::get_info_log() const
@@ -143,9 +236,9 @@ inline const std::list<shader_input*>* shader_program::get_inputs() const
 	return &inputs;
 }
 
-inline const shader_input* shader_program::get_input(const std::string& name) const
+inline const shader_input* shader_program::get_input(string_id name_id) const
 {
-	auto it = input_map.find(name);
+	auto it = input_map.find(name_id);
 	if (it == input_map.end())
 	{
 		return nullptr;
@@ -154,6 +247,26 @@ inline const shader_input* shader_program::get_input(const std::string& name) co
 	return it->second;
 }
 
+inline const shader_input* shader_program::get_input(std::string_view name) const
+{
+	return get_input(make_string_id(name));
+}
+
+inline bool shader_program::has_uniform_block(string_id name_id) const
+{
+	return uniform_block_map.find(name_id) != uniform_block_map.end();
+}
+
+inline bool shader_program::has_uniform_block(std::string_view name) const
+{
+	return has_uniform_block(make_string_id(name));
+}
+
+inline bool shader_program::bind_uniform_block(std::string_view name, unsigned int binding) const
+{
+	return bind_uniform_block(make_string_id(name), binding);
+}
+
 } // namespace gl
 
 #endif // ANTKEEPER_GL_SHADER_PROGRAM_HPP
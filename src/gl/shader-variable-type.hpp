@@ -44,7 +44,9 @@ enum class shader_variable_type
 	float3x3,
 	float4x4,
 	texture_2d,
-	texture_cube
+	texture_cube,
+	texture_2d_array,
+	texture_3d
 };
 
 } // namespace gl
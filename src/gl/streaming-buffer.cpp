@@ -0,0 +1,89 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gl/streaming-buffer.hpp"
+#include "gl/vertex-buffer.hpp"
+#include "debug/gl-monitor.hpp"
+#include <glad/glad.h>
+#include <cstring>
+
+namespace gl {
+
+streaming_buffer::streaming_buffer(vertex_buffer* buffer, std::size_t region_size, std::size_t region_count):
+	buffer(buffer),
+	region_size(region_size),
+	region_index(0),
+	fences(region_count, nullptr)
+{
+	buffer->repurpose(region_size * region_count, nullptr, buffer_usage::stream_draw);
+}
+
+streaming_buffer::~streaming_buffer()
+{
+	for (void* fence: fences)
+		if (fence)
+			glDeleteSync(static_cast<GLsync>(fence));
+}
+
+std::size_t streaming_buffer::next_region()
+{
+	// Fence the draws which read the current region
+	if (fences[region_index])
+		glDeleteSync(static_cast<GLsync>(fences[region_index]));
+	fences[region_index] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	
+	region_index = (region_index + 1) % fences.size();
+	
+	// Wait for the GPU to finish reading the next region, which it usually has
+	if (GLsync fence = static_cast<GLsync>(fences[region_index]))
+	{
+		debug::gl_stall_scope stall("glClientWaitSync");
+		GLenum status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+		while (status == GL_TIMEOUT_EXPIRED)
+			status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+		
+		glDeleteSync(fence);
+		fences[region_index] = nullptr;
+	}
+	
+	return region_index;
+}
+
+void streaming_buffer::write(std::size_t offset, std::size_t size, const void* data)
+{
+	if (!size)
+		return;
+	
+	glBindBuffer(GL_ARRAY_BUFFER, buffer->gl_buffer_id);
+	
+	const GLintptr gl_offset = static_cast<GLintptr>(get_region_offset() + offset);
+	void* mapping = glMapBufferRange(GL_ARRAY_BUFFER, gl_offset, static_cast<GLsizeiptr>(size), GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+	if (mapping)
+	{
+		std::memcpy(mapping, data, size);
+		glUnmapBuffer(GL_ARRAY_BUFFER);
+	}
+	else
+	{
+		debug::gl_stall_scope stall("glBufferSubData");
+		glBufferSubData(GL_ARRAY_BUFFER, gl_offset, static_cast<GLsizeiptr>(size), data);
+	}
+}
+
+} // namespace gl
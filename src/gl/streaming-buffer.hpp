@@ -0,0 +1,112 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ANTKEEPER_GL_STREAMING_BUFFER_HPP
+#define ANTKEEPER_GL_STREAMING_BUFFER_HPP
+
+#include <cstdlib>
+#include <vector>
+
+namespace gl {
+
+class vertex_buffer;
+
+/**
+ * Ring of fence-guarded regions within a vertex buffer, for geometry which is rewritten while the GPU may still be drawing it.
+ *
+ * Each call to next_region() fences the region written since the previous call, after the draws which read it have been issued, then advances to the next region, waiting only if the GPU has yet to finish with that region. Writes are made through unsynchronized, range-invalidating mappings, so they neither copy data through the driver nor implicitly synchronize with the GPU. Draws should offset their first vertex by the offset of the current region.
+ *
+ * Persistent, coherent mapping with `glBufferStorage` would avoid remapping per write, but requires OpenGL 4.4, beyond the 3.3 core context targeted by the renderer.
+ */
+class streaming_buffer
+{
+public:
+	/**
+	 * Creates a streaming buffer, reallocating the storage of a vertex buffer to hold its regions.
+	 *
+	 * @param buffer Vertex buffer in which the regions will be stored.
+	 * @param region_size Size of each region, in bytes.
+	 * @param region_count Number of regions.
+	 */
+	streaming_buffer(vertex_buffer* buffer, std::size_t region_size, std::size_t region_count = 3);
+	
+	/// Destroys a streaming buffer. The vertex buffer is not destroyed.
+	~streaming_buffer();
+	
+	streaming_buffer(const streaming_buffer&) = delete;
+	streaming_buffer& operator=(const streaming_buffer&) = delete;
+	
+	/**
+	 * Fences the current region and advances to the next region, waiting until the GPU has finished reading it.
+	 *
+	 * @return Index of the new current region.
+	 */
+	std::size_t next_region();
+	
+	/**
+	 * Writes data into the current region.
+	 *
+	 * @param offset Offset into the region, in bytes.
+	 * @param size Number of bytes to write.
+	 * @param data Data to copy into the region.
+	 */
+	void write(std::size_t offset, std::size_t size, const void* data);
+	
+	/// Returns the index of the current region.
+	std::size_t get_region_index() const;
+	
+	/// Returns the offset of the current region into the vertex buffer, in bytes.
+	std::size_t get_region_offset() const;
+	
+	/// Returns the size of each region, in bytes.
+	std::size_t get_region_size() const;
+	
+	/// Returns the number of regions.
+	std::size_t get_region_count() const;
+
+private:
+	vertex_buffer* buffer;
+	std::size_t region_size;
+	std::size_t region_index;
+	std::vector<void*> fences;
+};
+
+inline std::size_t streaming_buffer::get_region_index() const
+{
+	return region_index;
+}
+
+inline std::size_t streaming_buffer::get_region_offset() const
+{
+	return region_index * region_size;
+}
+
+inline std::size_t streaming_buffer::get_region_size() const
+{
+	return region_size;
+}
+
+inline std::size_t streaming_buffer::get_region_count() const
+{
+	return fences.size();
+}
+
+} // namespace gl
+
+#endif // ANTKEEPER_GL_STREAMING_BUFFER_HPP
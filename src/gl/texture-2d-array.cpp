@@ -0,0 +1,116 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "gl/texture-2d-array.hpp"
+#include "gl/texture-format.hpp"
+#include "gl/texture-wrapping.hpp"
+#include "gl/texture-filter.hpp"
+#include <glad/glad.h>
+#include <algorithm>
+
+namespace gl {
+
+texture_2d_array::texture_2d_array(int width, int height, std::size_t layer_count, gl::pixel_type type, gl::pixel_format format, gl::color_space color_space):
+	gl_texture_id(0),
+	dimensions({width, height}),
+	layer_count(layer_count),
+	pixel_type(type),
+	pixel_format(format),
+	color_space(color_space),
+	size(0),
+	max_anisotropy(0.0f)
+{
+	const texture_format formats = get_texture_format(type, format, color_space);
+	
+	// Specify every level of every layer once, without data, so that updates never reallocate storage
+	glGenTextures(1, &gl_texture_id);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, gl_texture_id);
+	const std::size_t level_count = get_full_level_count(width, height);
+	for (std::size_t i = 0; i < level_count; ++i)
+	{
+		const GLsizei level_width = std::max<GLsizei>(1, width >> i);
+		const GLsizei level_height = std::max<GLsizei>(1, height >> i);
+		glTexImage3D(GL_TEXTURE_2D_ARRAY, static_cast<GLint>(i), formats.internal_format, level_width, level_height, static_cast<GLsizei>(layer_count), 0, formats.format, formats.type, nullptr);
+		size += static_cast<std::size_t>(level_width) * static_cast<std::size_t>(level_height) * layer_count * formats.pixel_size;
+	}
+	
+	glTexParameteriv(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_SWIZZLE_RGBA, formats.swizzle_mask);
+	
+	set_wrapping(texture_wrapping::repeat, texture_wrapping::repeat);
+	set_filters(texture_min_filter::linear_mipmap_linear, texture_mag_filter::linear);
+	set_max_anisotropy(max_anisotropy);
+}
+
+texture_2d_array::~texture_2d_array()
+{
+	glDeleteTextures(1, &gl_texture_id);
+}
+
+void texture_2d_array::update(std::size_t layer, const void* data)
+{
+	const texture_format formats = get_texture_format(pixel_type, pixel_format, color_space);
+	
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	
+	glBindTexture(GL_TEXTURE_2D_ARRAY, gl_texture_id);
+	glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, static_cast<GLint>(layer), dimensions[0], dimensions[1], 1, formats.format, formats.type, data);
+}
+
+void texture_2d_array::generate_mipmaps()
+{
+	glBindTexture(GL_TEXTURE_2D_ARRAY, gl_texture_id);
+	glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+}
+
+void texture_2d_array::set_wrapping(gl::texture_wrapping wrap_s, texture_wrapping wrap_t)
+{
+	glBindTexture(GL_TEXTURE_2D_ARRAY, gl_texture_id);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, get_texture_wrapping(wrap_s));
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, get_texture_wrapping(wrap_t));
+}
+
+void texture_2d_array::set_filters(texture_min_filter min_filter, texture_mag_filter mag_filter)
+{
+	glBindTexture(GL_TEXTURE_2D_ARRAY, gl_texture_id);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, get_texture_min_filter(min_filter));
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, get_texture_mag_filter(mag_filter));
+}
+
+void texture_2d_array::set_max_anisotropy(float anisotropy)
+{
+	this->max_anisotropy = std::max<float>(0.0f, std::min<float>(1.0f, anisotropy));
+	
+	// Lerp between 1.0f and GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT
+	float gl_max_texture_max_anisotropy;
+	glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &gl_max_texture_max_anisotropy);
+	float gl_max_anisotropy = 1.0f + this->max_anisotropy * (gl_max_texture_max_anisotropy - 1.0f);
+	
+	glBindTexture(GL_TEXTURE_2D_ARRAY, gl_texture_id);
+	glTexParameterf(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_ANISOTROPY_EXT, gl_max_anisotropy);
+}
+
+std::size_t texture_2d_array::get_max_layer_count()
+{
+	GLint max_layers = 0;
+	glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &max_layers);
+	return static_cast<std::size_t>(max_layers);
+}
+
+} // namespace gl
@@ -0,0 +1,166 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef ANTKEEPER_GL_TEXTURE_2D_ARRAY_HPP
+#define ANTKEEPER_GL_TEXTURE_2D_ARRAY_HPP
+
+#include <array>
+#include <cstddef>
+#include <tuple>
+#include "gl/color-space.hpp"
+#include "gl/pixel-format.hpp"
+#include "gl/pixel-type.hpp"
+
+namespace gl {
+
+class shader_input;
+enum class texture_mag_filter;
+enum class texture_min_filter;
+enum class texture_wrapping;
+
+/**
+ * An array of 2D textures of equal dimensions and format, which can be uploaded to shaders via a single `sampler2DArray` shader input.
+ *
+ * Materials which share a shader program can share a texture array, with each material selecting its layers by index, so that operations of different materials are drawn without switching textures. Bindless textures would lift the restriction on dimensions and format, but require the `GL_ARB_bindless_texture` extension, beyond the 3.3 core context targeted by the renderer.
+ */
+class texture_2d_array
+{
+public:
+	/**
+	 * Creates a 2D texture array, with storage for every layer but without pixel data.
+	 *
+	 * @param width Width of each layer, in pixels.
+	 * @param height Height of each layer, in pixels.
+	 * @param layer_count Number of layers.
+	 * @param type Pixel type of the layer data.
+	 * @param format Pixel format of the layer data.
+	 * @param color_space Color space of the layer data.
+	 */
+	texture_2d_array(int width, int height, std::size_t layer_count, gl::pixel_type type = gl::pixel_type::uint_8, gl::pixel_format format = gl::pixel_format::rgba, gl::color_space color_space = gl::color_space::linear);
+	
+	/// Destroys a 2D texture array.
+	~texture_2d_array();
+	
+	texture_2d_array(const texture_2d_array&) = delete;
+	texture_2d_array& operator=(const texture_2d_array&) = delete;
+	
+	/**
+	 * Uploads the base level of a layer. Mipmaps are not regenerated until generate_mipmaps() is called.
+	 *
+	 * @param layer Index of the layer.
+	 * @param data Pixel data of the layer, in the texture's pixel type and format.
+	 */
+	void update(std::size_t layer, const void* data);
+	
+	/// Generates the mip levels of every layer from their base levels on the GPU.
+	void generate_mipmaps();
+	
+	/**
+	 * Sets the texture wrapping modes.
+	 *
+	 * @param wrap_s Wrapping mode for s-coordinates.
+	 * @param wrap_t Wrapping mode for t-coordinates.
+	 */
+	void set_wrapping(gl::texture_wrapping wrap_s, texture_wrapping wrap_t);
+	
+	/**
+	 * Sets the texture filtering modes.
+	 *
+	 * @param min_filter Texture minification filter.
+	 * @param mag_filter Texture magnification filter.
+	 */
+	void set_filters(texture_min_filter min_filter, texture_mag_filter mag_filter);
+	
+	/**
+	 * Sets the maximum anisotropy.
+	 *
+	 * @param level Max anisotropy on `[0.0, 1.0]`, with `0.0` indicating normal filtering, and `1.0` indicating maximum anisotropic filtering.
+	 */
+	void set_max_anisotropy(float anisotropy);
+	
+	/// Returns the dimensions of each layer, in pixels.
+	const std::array<int, 2>& get_dimensions() const;
+	
+	/// Returns the number of layers.
+	std::size_t get_layer_count() const;
+	
+	/// Returns the pixel type enumeration.
+	const pixel_type& get_pixel_type() const;
+	
+	/// Returns the pixel format enumeration.
+	const pixel_format& get_pixel_format() const;
+	
+	/// Returns the color space enumeration.
+	const color_space& get_color_space() const;
+	
+	/// Returns the approximate size of the texture's storage, including mip levels, in bytes.
+	std::size_t get_size() const;
+	
+	/**
+	 * Returns the maximum number of layers of a texture array, which is at least 256.
+	 */
+	static std::size_t get_max_layer_count();
+
+private:
+	friend class shader_input;
+	
+	unsigned int gl_texture_id;
+	std::array<int, 2> dimensions;
+	std::size_t layer_count;
+	gl::pixel_type pixel_type;
+	gl::pixel_format pixel_format;
+	gl::color_space color_space;
+	std::size_t size;
+	float max_anisotropy;
+};
+
+inline const std::array<int, 2>& texture_2d_array::get_dimensions() const
+{
+	return dimensions;
+}
+
+inline std::size_t texture_2d_array::get_layer_count() const
+{
+	return layer_count;
+}
+
+inline const pixel_type& texture_2d_array::get_pixel_type() const
+{
+	return pixel_type;
+}
+
+inline const pixel_format& texture_2d_array::get_pixel_format() const
+{
+	return pixel_format;
+}
+
+inline const color_space& texture_2d_array::get_color_space() const
+{
+	return color_space;
+}
+
+inline std::size_t texture_2d_array::get_size() const
+{
+	return size;
+}
+
+} // namespace gl
+
+#endif // ANTKEEPER_GL_TEXTURE_2D_ARRAY_HPP
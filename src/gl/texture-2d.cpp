@@ -18,99 +18,128 @@
  */
 
 #include "gl/texture-2d.hpp"
+#include "gl/texture-format.hpp"
 #include "gl/texture-wrapping.hpp"
 #include "gl/texture-filter.hpp"
 #include <glad/glad.h>
 #include <algorithm>
+#include <cstring>
 
-namespace gl {
+// Compressed formats from extensions which may be absent from the loader's headers
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT1_EXT
+	#define GL_COMPRESSED_RGBA_S3TC_DXT1_EXT 0x83F1
+	#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+#ifndef GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT
+	#define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT 0x8C4D
+	#define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT 0x8C4F
+#endif
+#ifndef GL_COMPRESSED_RGBA_BPTC_UNORM
+	#define GL_COMPRESSED_RGBA_BPTC_UNORM 0x8E8C
+	#define GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM 0x8E8D
+	#define GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT 0x8E8F
+#endif
+#ifndef GL_COMPRESSED_RGBA_ASTC_4x4_KHR
+	#define GL_COMPRESSED_RGBA_ASTC_4x4_KHR 0x93B0
+	#define GL_COMPRESSED_RGBA_ASTC_5x5_KHR 0x93B2
+	#define GL_COMPRESSED_RGBA_ASTC_6x6_KHR 0x93B4
+	#define GL_COMPRESSED_RGBA_ASTC_8x8_KHR 0x93B7
+	#define GL_COMPRESSED_SRGB8_ALPHA8_ASTC_4x4_KHR 0x93D0
+	#define GL_COMPRESSED_SRGB8_ALPHA8_ASTC_5x5_KHR 0x93D2
+	#define GL_COMPRESSED_SRGB8_ALPHA8_ASTC_6x6_KHR 0x93D4
+	#define GL_COMPRESSED_SRGB8_ALPHA8_ASTC_8x8_KHR 0x93D7
+#endif
 
-static constexpr GLenum pixel_format_lut[] =
-{
-	GL_DEPTH_COMPONENT,
-	GL_DEPTH_STENCIL,
-	GL_RED,
-	GL_RG,
-	GL_RGB,
-	GL_BGR,
-	GL_RGBA,
-	GL_BGRA
-};
+namespace gl {
 
-static constexpr GLenum pixel_type_lut[] =
+static constexpr GLenum compressed_linear_internal_format_lut[] =
 {
-	GL_BYTE,
-	GL_UNSIGNED_BYTE,
-	GL_SHORT,
-	GL_UNSIGNED_SHORT,
-	GL_INT,
-	GL_UNSIGNED_INT,
-	GL_HALF_FLOAT,
-	GL_FLOAT
+	GL_COMPRESSED_RGBA_S3TC_DXT1_EXT,
+	GL_COMPRESSED_RGBA_S3TC_DXT5_EXT,
+	GL_COMPRESSED_RED_RGTC1,
+	GL_COMPRESSED_RG_RGTC2,
+	GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT,
+	GL_COMPRESSED_RGBA_BPTC_UNORM,
+	GL_COMPRESSED_RGBA_ASTC_4x4_KHR,
+	GL_COMPRESSED_RGBA_ASTC_5x5_KHR,
+	GL_COMPRESSED_RGBA_ASTC_6x6_KHR,
+	GL_COMPRESSED_RGBA_ASTC_8x8_KHR
 };
 
-static constexpr GLenum linear_internal_format_lut[][8] =
+static constexpr GLenum compressed_srgb_internal_format_lut[] =
 {
-	{GL_NONE, GL_NONE, GL_DEPTH_COMPONENT16, GL_DEPTH_COMPONENT16, GL_DEPTH_COMPONENT32, GL_DEPTH_COMPONENT32, GL_NONE, GL_DEPTH_COMPONENT32F},
-	
-	// Note: GL_DEPTH32F_STENCIL8 is actually a 64-bit format, 32 depth bits, 8 stencil bits, and 24 alignment bits.
-	{GL_NONE, GL_NONE, GL_NONE, GL_NONE, GL_DEPTH24_STENCIL8, GL_DEPTH24_STENCIL8, GL_NONE, GL_DEPTH32F_STENCIL8},
-	
-	{GL_R8, GL_R8, GL_R16, GL_R16, GL_R32F, GL_R32F, GL_R16F, GL_R32F},
-	{GL_RG8, GL_RG8, GL_RG16, GL_RG16, GL_RG32F, GL_RG32F, GL_RG16F, GL_RG32F},
-	{GL_RGB8, GL_RGB8, GL_RGB16, GL_RGB16, GL_RGB32F, GL_RGB32F, GL_RGB16F, GL_RGB32F},
-	{GL_RGB8, GL_RGB8, GL_RGB16, GL_RGB16, GL_RGB32F, GL_RGB32F, GL_RGB16F, GL_RGB32F},
-	{GL_RGBA8, GL_RGBA8, GL_RGBA16, GL_RGBA16, GL_RGBA32F, GL_RGBA32F, GL_RGBA16F, GL_RGBA32F},
-	{GL_RGBA8, GL_RGBA8, GL_RGBA16, GL_RGBA16, GL_RGBA32F, GL_RGBA32F, GL_RGBA16F, GL_RGBA32F}
+	GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT,
+	GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT,
+	GL_COMPRESSED_RED_RGTC1,
+	GL_COMPRESSED_RG_RGTC2,
+	GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT,
+	GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM,
+	GL_COMPRESSED_SRGB8_ALPHA8_ASTC_4x4_KHR,
+	GL_COMPRESSED_SRGB8_ALPHA8_ASTC_5x5_KHR,
+	GL_COMPRESSED_SRGB8_ALPHA8_ASTC_6x6_KHR,
+	GL_COMPRESSED_SRGB8_ALPHA8_ASTC_8x8_KHR
 };
 
-static constexpr GLenum srgb_internal_format_lut[][8] =
+// Equivalent uncompressed pixel formats, by which compressed textures are swizzled like the images they were compressed from
+static constexpr pixel_format compressed_pixel_format_lut[] =
 {
-	{GL_NONE, GL_NONE, GL_DEPTH_COMPONENT16, GL_DEPTH_COMPONENT16, GL_DEPTH_COMPONENT32, GL_DEPTH_COMPONENT32, GL_NONE, GL_DEPTH_COMPONENT32F},
-	{GL_NONE, GL_NONE, GL_NONE, GL_NONE, GL_DEPTH24_STENCIL8, GL_DEPTH24_STENCIL8, GL_NONE, GL_DEPTH32F_STENCIL8},
-	{GL_SRGB8, GL_SRGB8, GL_R16, GL_R16, GL_R32F, GL_R32F, GL_R16F, GL_R32F},
-	{GL_SRGB8, GL_SRGB8, GL_RG16, GL_RG16, GL_RG32F, GL_RG32F, GL_RG16F, GL_RG32F},
-	{GL_SRGB8, GL_SRGB8, GL_RGB16, GL_RGB16, GL_RGB32F, GL_RGB32F, GL_RGB16F, GL_RGB32F},
-	{GL_SRGB8, GL_SRGB8, GL_RGB16, GL_RGB16, GL_RGB32F, GL_RGB32F, GL_RGB16F, GL_RGB32F},
-	{GL_SRGB8_ALPHA8, GL_SRGB8_ALPHA8, GL_RGBA16, GL_RGBA16, GL_RGBA32F, GL_RGBA32F, GL_RGBA16F, GL_RGBA32F},
-	{GL_SRGB8_ALPHA8, GL_SRGB8_ALPHA8, GL_RGBA16, GL_RGBA16, GL_RGBA32F, GL_RGBA32F, GL_RGBA16F, GL_RGBA32F}
+	pixel_format::rgba,
+	pixel_format::rgba,
+	pixel_format::r,
+	pixel_format::rg,
+	pixel_format::rgb,
+	pixel_format::rgba,
+	pixel_format::rgba,
+	pixel_format::rgba,
+	pixel_format::rgba,
+	pixel_format::rgba
 };
 
-static constexpr GLint swizzle_mask_lut[][4] =
+static constexpr pixel_type compressed_pixel_type_lut[] =
 {
-	{GL_RED, GL_RED, GL_RED, GL_ONE},
-	{GL_RED, GL_GREEN, GL_ZERO, GL_ONE},
-	{GL_RED, GL_RED, GL_RED, GL_ONE},
-	{GL_RED, GL_RED, GL_RED, GL_GREEN},
-	{GL_RED, GL_GREEN, GL_BLUE, GL_ONE},
-	{GL_RED, GL_GREEN, GL_BLUE, GL_ONE},
-	{GL_RED, GL_GREEN, GL_BLUE, GL_ALPHA},
-	{GL_RED, GL_GREEN, GL_BLUE, GL_ALPHA}
+	pixel_type::uint_8,
+	pixel_type::uint_8,
+	pixel_type::uint_8,
+	pixel_type::uint_8,
+	pixel_type::float_16,
+	pixel_type::uint_8,
+	pixel_type::uint_8,
+	pixel_type::uint_8,
+	pixel_type::uint_8,
+	pixel_type::uint_8
 };
 
-static constexpr GLenum wrapping_lut[] =
+// Extensions required to sample compressed formats, or `nullptr` if supported by the core profile
+static constexpr const char* compressed_extension_lut[] =
 {
-	GL_CLAMP_TO_BORDER,
-	GL_CLAMP_TO_EDGE,
-	GL_REPEAT,
-	GL_MIRRORED_REPEAT
+	"GL_EXT_texture_compression_s3tc",
+	"GL_EXT_texture_compression_s3tc",
+	nullptr,
+	nullptr,
+	"GL_ARB_texture_compression_bptc",
+	"GL_ARB_texture_compression_bptc",
+	"GL_KHR_texture_compression_astc_ldr",
+	"GL_KHR_texture_compression_astc_ldr",
+	"GL_KHR_texture_compression_astc_ldr",
+	"GL_KHR_texture_compression_astc_ldr"
 };
 
-static constexpr GLenum min_filter_lut[] =
+/// Returns the size of the first levels of the mip chain of a texture, in bytes.
+static std::size_t get_storage_size(int width, int height, std::size_t level_count, std::size_t pixel_size)
 {
-	GL_NEAREST,
-	GL_LINEAR,
-	GL_NEAREST_MIPMAP_NEAREST,
-	GL_LINEAR_MIPMAP_NEAREST,
-	GL_NEAREST_MIPMAP_LINEAR,
-	GL_LINEAR_MIPMAP_LINEAR
-};
+	std::size_t size = 0;
+	for (std::size_t i = 0; i < level_count; ++i)
+		size += static_cast<std::size_t>(std::max(1, width >> i)) * static_cast<std::size_t>(std::max(1, height >> i)) * pixel_size;
+	return size;
+}
 
-static constexpr GLenum mag_filter_lut[] =
+/// Returns the internal format of a compressed format in a color space.
+static GLenum get_compressed_internal_format(gl::compressed_format format, gl::color_space color_space)
 {
-	GL_NEAREST,
-	GL_LINEAR
-};
+	if (color_space == gl::color_space::srgb)
+		return compressed_srgb_internal_format_lut[static_cast<std::size_t>(format)];
+	return compressed_linear_internal_format_lut[static_cast<std::size_t>(format)];
+}
 
 texture_2d::texture_2d(int width, int height, gl::pixel_type type, gl::pixel_format format, gl::color_space color_space, const void* data):
 	gl_texture_id(0),
@@ -126,6 +155,34 @@ texture_2d::texture_2d(int width, int height, gl::pixel_type type, gl::pixel_for
 	set_max_anisotropy(max_anisotropy);
 }
 
+texture_2d::texture_2d(int width, int height, std::size_t level_count, gl::pixel_type type, gl::pixel_format format, gl::color_space color_space):
+	gl_texture_id(0),
+	dimensions({0, 0}),
+	wrapping({texture_wrapping::repeat, texture_wrapping::repeat}),
+	filters({texture_min_filter::linear_mipmap_linear, texture_mag_filter::linear}),
+	max_anisotropy(0.0f)
+{
+	glGenTextures(1, &gl_texture_id);
+	allocate(width, height, level_count, type, format, color_space);
+	set_wrapping(std::get<0>(wrapping), std::get<1>(wrapping));
+	set_filters(std::get<0>(filters), std::get<1>(filters));
+	set_max_anisotropy(max_anisotropy);
+}
+
+texture_2d::texture_2d(int width, int height, gl::compressed_format format, gl::color_space color_space, std::size_t level_count, const void* const* level_data, const std::size_t* level_sizes, std::size_t base_level):
+	gl_texture_id(0),
+	dimensions({0, 0}),
+	wrapping({texture_wrapping::repeat, texture_wrapping::repeat}),
+	filters({texture_min_filter::linear_mipmap_linear, texture_mag_filter::linear}),
+	max_anisotropy(0.0f)
+{
+	glGenTextures(1, &gl_texture_id);
+	resize(width, height, format, color_space, level_count, level_data, level_sizes, base_level);
+	set_wrapping(std::get<0>(wrapping), std::get<1>(wrapping));
+	set_filters(std::get<0>(filters), std::get<1>(filters));
+	set_max_anisotropy(max_anisotropy);
+}
+
 texture_2d::~texture_2d()
 {
 	glDeleteTextures(1, &gl_texture_id);
@@ -133,39 +190,25 @@ texture_2d::~texture_2d()
 
 void texture_2d::resize(int width, int height, gl::pixel_type type, gl::pixel_format format, gl::color_space color_space, const void* data)
 {
-	dimensions = {width, height};
-	pixel_type = type;
-	pixel_format = format;
-	this->color_space = color_space;
-
-	GLenum gl_internal_format;
-	if (color_space == gl::color_space::srgb)
-	{
-		gl_internal_format = srgb_internal_format_lut[static_cast<std::size_t>(format)][static_cast<std::size_t>(type)];
-	}
-	else
-	{
-		gl_internal_format = linear_internal_format_lut[static_cast<std::size_t>(format)][static_cast<std::size_t>(type)];
-	}
-	
-	GLenum gl_format = pixel_format_lut[static_cast<std::size_t>(format)];
-	const GLint* gl_swizzle_mask = swizzle_mask_lut[static_cast<std::size_t>(format)];
-	
-	GLenum gl_type = pixel_type_lut[static_cast<std::size_t>(type)];
+	const texture_format formats = get_texture_format(type, format, color_space);
+	set_format(width, height, type, format, color_space);
 	
-	// Special cases for depth + stencil pixel formats
-	if (gl_internal_format == GL_DEPTH24_STENCIL8)
-		gl_type = GL_UNSIGNED_INT_24_8;
-	else if (gl_internal_format == GL_DEPTH32F_STENCIL8)
-		gl_type = GL_FLOAT_32_UNSIGNED_INT_24_8_REV;
+	// Sum the size of each level of the mip chain
+	level_count = get_full_level_count(width, height);
+	size = get_storage_size(width, height, level_count, formats.pixel_size);
 
 	glPixelStorei(GL_PACK_ALIGNMENT, 1);
 	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
 
 	glBindTexture(GL_TEXTURE_2D, gl_texture_id);
-	glTexImage2D(GL_TEXTURE_2D, 0, gl_internal_format, width, height, 0, gl_format, gl_type, data);
+	glTexImage2D(GL_TEXTURE_2D, 0, formats.internal_format, width, height, 0, formats.format, formats.type, data);
+	
+	// Restore the default base and max levels, which may have been clamped by a compressed upload
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 1000);
+	
 	glGenerateMipmap(GL_TEXTURE_2D);
-	glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, gl_swizzle_mask);
+	glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, formats.swizzle_mask);
 	
 	/// TODO: remove this
 	if (format == pixel_format::d)
@@ -175,12 +218,136 @@ void texture_2d::resize(int width, int height, gl::pixel_type type, gl::pixel_fo
 	}
 }
 
+void texture_2d::allocate(int width, int height, std::size_t level_count, gl::pixel_type type, gl::pixel_format format, gl::color_space color_space)
+{
+	const texture_format formats = get_texture_format(type, format, color_space);
+	set_format(width, height, type, format, color_space);
+	
+	const std::size_t full_level_count = get_full_level_count(width, height);
+	this->level_count = (level_count) ? std::min(level_count, full_level_count) : full_level_count;
+	size = get_storage_size(width, height, this->level_count, formats.pixel_size);
+	
+	// Specify every level once, without data, so that the texture is complete and its storage is never reallocated by updates
+	glBindTexture(GL_TEXTURE_2D, gl_texture_id);
+	for (std::size_t i = 0; i < this->level_count; ++i)
+	{
+		const GLsizei level_width = std::max<GLsizei>(1, width >> i);
+		const GLsizei level_height = std::max<GLsizei>(1, height >> i);
+		glTexImage2D(GL_TEXTURE_2D, static_cast<GLint>(i), formats.internal_format, level_width, level_height, 0, formats.format, formats.type, nullptr);
+	}
+	
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(this->level_count - 1));
+	glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, formats.swizzle_mask);
+}
+
+void texture_2d::resize(int width, int height, gl::compressed_format format, gl::color_space color_space, std::size_t level_count, const void* const* level_data, const std::size_t* level_sizes, std::size_t base_level)
+{
+	dimensions = {width, height};
+	pixel_type = compressed_pixel_type_lut[static_cast<std::size_t>(format)];
+	pixel_format = compressed_pixel_format_lut[static_cast<std::size_t>(format)];
+	this->color_space = color_space;
+	compressed = true;
+	compressed_format = format;
+	this->level_count = level_count;
+	this->base_level = std::min<std::size_t>(base_level, std::max<std::size_t>(1, level_count) - 1);
+	
+	const GLenum gl_internal_format = get_compressed_internal_format(format, color_space);
+	const GLint* gl_swizzle_mask = get_texture_format(pixel_type, pixel_format, color_space).swizzle_mask;
+	
+	size = 0;
+	for (std::size_t i = this->base_level; i < level_count; ++i)
+		size += level_sizes[i];
+	
+	glBindTexture(GL_TEXTURE_2D, gl_texture_id);
+	for (std::size_t i = this->base_level; i < level_count; ++i)
+	{
+		const GLsizei level_width = std::max<GLsizei>(1, width >> i);
+		const GLsizei level_height = std::max<GLsizei>(1, height >> i);
+		glCompressedTexImage2D(GL_TEXTURE_2D, static_cast<GLint>(i), gl_internal_format, level_width, level_height, 0, static_cast<GLsizei>(level_sizes[i]), level_data[i]);
+	}
+	
+	// Compressed formats aren't renderable, so mipmaps can't be generated. Clamp the mip chain to the given levels to keep the texture complete.
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, static_cast<GLint>(this->base_level));
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(std::max<std::size_t>(1, level_count) - 1));
+	glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, gl_swizzle_mask);
+}
+
+void texture_2d::set_base_level(std::size_t base_level, const void* const* level_data, const std::size_t* level_sizes)
+{
+	if (!compressed || !level_count)
+		return;
+	
+	base_level = std::min<std::size_t>(base_level, level_count - 1);
+	if (base_level == this->base_level)
+		return;
+	
+	const GLenum gl_internal_format = get_compressed_internal_format(compressed_format, color_space);
+	
+	glBindTexture(GL_TEXTURE_2D, gl_texture_id);
+	if (base_level < this->base_level)
+	{
+		// Upload the levels which become resident, coarsest first
+		for (std::size_t i = this->base_level; i-- > base_level;)
+		{
+			const GLsizei level_width = std::max<GLsizei>(1, dimensions[0] >> i);
+			const GLsizei level_height = std::max<GLsizei>(1, dimensions[1] >> i);
+			glCompressedTexImage2D(GL_TEXTURE_2D, static_cast<GLint>(i), gl_internal_format, level_width, level_height, 0, static_cast<GLsizei>(level_sizes[i]), level_data[i]);
+			size += level_sizes[i];
+		}
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, static_cast<GLint>(base_level));
+	}
+	else
+	{
+		// Stop sampling the evicted levels before releasing their storage by respecifying them as empty
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, static_cast<GLint>(base_level));
+		for (std::size_t i = this->base_level; i < base_level; ++i)
+		{
+			glCompressedTexImage2D(GL_TEXTURE_2D, static_cast<GLint>(i), gl_internal_format, 0, 0, 0, 0, nullptr);
+			size -= level_sizes[i];
+		}
+	}
+	
+	this->base_level = base_level;
+}
+
+void texture_2d::update(int x, int y, int width, int height, const void* data)
+{
+	update(0, x, y, width, height, data);
+}
+
+void texture_2d::update(std::size_t level, int x, int y, int width, int height, const void* data)
+{
+	const texture_format formats = get_texture_format(pixel_type, pixel_format, color_space);
+	
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	
+	glBindTexture(GL_TEXTURE_2D, gl_texture_id);
+	glTexSubImage2D(GL_TEXTURE_2D, static_cast<GLint>(level), x, y, width, height, formats.format, formats.type, data);
+}
+
+void texture_2d::generate_mipmaps()
+{
+	glBindTexture(GL_TEXTURE_2D, gl_texture_id);
+	glGenerateMipmap(GL_TEXTURE_2D);
+}
+
+void texture_2d::set_format(int width, int height, gl::pixel_type type, gl::pixel_format format, gl::color_space color_space)
+{
+	dimensions = {width, height};
+	pixel_type = type;
+	pixel_format = format;
+	this->color_space = color_space;
+	compressed = false;
+	base_level = 0;
+}
+
 void texture_2d::set_wrapping(gl::texture_wrapping wrap_s, texture_wrapping wrap_t)
 {
 	wrapping = {wrap_s, wrap_t};
 
-	GLenum gl_wrap_s = wrapping_lut[static_cast<std::size_t>(wrap_s)];
-	GLenum gl_wrap_t = wrapping_lut[static_cast<std::size_t>(wrap_t)];
+	GLenum gl_wrap_s = get_texture_wrapping(wrap_s);
+	GLenum gl_wrap_t = get_texture_wrapping(wrap_t);
 
 	glBindTexture(GL_TEXTURE_2D, gl_texture_id);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, gl_wrap_s);
@@ -191,8 +358,8 @@ void texture_2d::set_filters(texture_min_filter min_filter, texture_mag_filter m
 {
 	filters = {min_filter, mag_filter};
 
-	GLenum gl_min_filter = min_filter_lut[static_cast<std::size_t>(min_filter)];
-	GLenum gl_mag_filter = mag_filter_lut[static_cast<std::size_t>(mag_filter)];
+	GLenum gl_min_filter = get_texture_min_filter(min_filter);
+	GLenum gl_mag_filter = get_texture_mag_filter(mag_filter);
 
 	glBindTexture(GL_TEXTURE_2D, gl_texture_id);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, gl_min_filter);
@@ -212,4 +379,22 @@ void texture_2d::set_max_anisotropy(float anisotropy)
 	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, gl_max_anisotropy);
 }
 
+bool texture_2d::is_supported(gl::compressed_format format)
+{
+	const char* extension = compressed_extension_lut[static_cast<std::size_t>(format)];
+	if (!extension)
+		return true;
+	
+	GLint extension_count = 0;
+	glGetIntegerv(GL_NUM_EXTENSIONS, &extension_count);
+	for (GLint i = 0; i < extension_count; ++i)
+	{
+		const char* name = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, static_cast<GLuint>(i)));
+		if (name && !std::strcmp(name, extension))
+			return true;
+	}
+	
+	return false;
+}
+
 } // namespace gl
@@ -21,8 +21,10 @@
 #define ANTKEEPER_GL_TEXTURE_2D_HPP
 
 #include <array>
+#include <cstddef>
 #include <tuple>
 #include "gl/color-space.hpp"
+#include "gl/compressed-format.hpp"
 #include "gl/pixel-format.hpp"
 #include "gl/pixel-type.hpp"
 
@@ -49,6 +51,20 @@ public:
 	 */
 	texture_2d(int width, int height, gl::pixel_type type = gl::pixel_type::uint_8, gl::pixel_format format = gl::pixel_format::rgba, gl::color_space color_space = gl::color_space::linear, const void* data = nullptr);
 	
+	/**
+	 * Creates a 2D texture with storage for a number of mip levels, but without pixel data.
+	 *
+	 * @see texture_2d::allocate(int, int, std::size_t, gl::pixel_type, gl::pixel_format, gl::color_space)
+	 */
+	texture_2d(int width, int height, std::size_t level_count, gl::pixel_type type, gl::pixel_format format, gl::color_space color_space = gl::color_space::linear);
+	
+	/**
+	 * Creates a 2D texture from block-compressed mip levels.
+	 *
+	 * @see texture_2d::resize(int, int, gl::compressed_format, gl::color_space, std::size_t, const void* const*, const std::size_t*, std::size_t)
+	 */
+	texture_2d(int width, int height, gl::compressed_format format, gl::color_space color_space, std::size_t level_count, const void* const* level_data, const std::size_t* level_sizes, std::size_t base_level = 0);
+	
 	/**
 	 * Destroys a 2D texture.
 	 */
@@ -60,6 +76,79 @@ public:
 	 * @warning If the sRGB color space is specified, pixel data will be stored internally as 8 bits per channel, and automatically converted to linear space before reading.
 	 */
 	void resize(int width, int height, gl::pixel_type type, gl::pixel_format format, gl::color_space color_space, const void* data);
+	
+	/**
+	 * Allocates storage for a number of mip levels without uploading pixel data or generating mipmaps, so that levels can be filled by update() and generate_mipmaps() as their data becomes available, such as from worker threads, without the storage being reallocated.
+	 *
+	 * Storage is allocated once, level by level, and sampling is restricted to the allocated levels. Immutable storage with `glTexStorage2D` would be equivalent, but requires OpenGL 4.2, beyond the 3.3 core context targeted by the renderer.
+	 *
+	 * @param width Width of the base level, in pixels.
+	 * @param height Height of the base level, in pixels.
+	 * @param level_count Number of mip levels, or `0` for a full mip chain. Clamped to the length of a full mip chain.
+	 * @param type Pixel type of the level data.
+	 * @param format Pixel format of the level data.
+	 * @param color_space Color space of the level data.
+	 */
+	void allocate(int width, int height, std::size_t level_count, gl::pixel_type type, gl::pixel_format format, gl::color_space color_space);
+	
+	/**
+	 * Resizes the texture and uploads block-compressed mip levels, as they are, without decompressing them. Mipmaps are not generated for compressed textures; if fewer levels than a full mip chain are given, the texture's max level is clamped to the last given level.
+	 *
+	 * @param width Width of the base level, in pixels.
+	 * @param height Height of the base level, in pixels.
+	 * @param format Compressed format of the level data.
+	 * @param color_space Color space of the level data. sRGB is ignored for BC4, BC5 and BC6H.
+	 * @param level_count Number of mip levels, base level first.
+	 * @param level_data Compressed data of each mip level.
+	 * @param level_sizes Size of each mip level, in bytes.
+	 * @param base_level Index of the finest level to upload. Finer levels are left unspecified, and are not sampled until made resident by set_base_level().
+	 */
+	void resize(int width, int height, gl::compressed_format format, gl::color_space color_space, std::size_t level_count, const void* const* level_data, const std::size_t* level_sizes, std::size_t base_level = 0);
+	
+	/**
+	 * Changes the finest resident mip level of a compressed texture, for mip streaming. Levels which become resident are uploaded, and levels which are no longer resident are released. Sampling is restricted to the resident levels.
+	 *
+	 * @param base_level Index of the finest level to be resident.
+	 * @param level_data Compressed data of every mip level, base level first. Only the levels which become resident are read.
+	 * @param level_sizes Size of every mip level, in bytes.
+	 *
+	 * @warning Uncompressed textures cannot be streamed.
+	 */
+	void set_base_level(std::size_t base_level, const void* const* level_data, const std::size_t* level_sizes);
+	
+	/**
+	 * Updates a rectangular region of the base level of the texture without reallocating storage or regenerating mipmaps.
+	 *
+	 * @param x X-offset of the region, in pixels.
+	 * @param y Y-offset of the region, in pixels.
+	 * @param width Width of the region, in pixels.
+	 * @param height Height of the region, in pixels.
+	 * @param data Pixel data, in the texture's pixel type and format.
+	 *
+	 * @warning Compressed textures cannot be updated.
+	 */
+	void update(int x, int y, int width, int height, const void* data);
+	
+	/**
+	 * Updates a rectangular region of a mip level of the texture without reallocating storage or regenerating mipmaps.
+	 *
+	 * @param level Index of the mip level.
+	 * @param x X-offset of the region, in pixels.
+	 * @param y Y-offset of the region, in pixels.
+	 * @param width Width of the region, in pixels.
+	 * @param height Height of the region, in pixels.
+	 * @param data Pixel data, in the texture's pixel type and format.
+	 *
+	 * @warning Compressed textures cannot be updated.
+	 */
+	void update(std::size_t level, int x, int y, int width, int height, const void* data);
+	
+	/**
+	 * Generates the mip levels of the texture from its base level on the GPU.
+	 *
+	 * @warning Mipmaps cannot be generated for compressed textures.
+	 */
+	void generate_mipmaps();
 
 	/**
 	 * Sets the texture wrapping modes.
@@ -95,6 +184,21 @@ public:
 	
 	/// Returns the color space enumeration.
 	const color_space& get_color_space() const;
+	
+	/// Returns `true` if the texture was created from block-compressed data.
+	bool is_compressed() const;
+	
+	/// Returns the compressed format of the texture. Only meaningful if the texture is compressed.
+	const gl::compressed_format& get_compressed_format() const;
+	
+	/// Returns the approximate size of the texture's storage, including resident mip levels, in bytes.
+	std::size_t get_size() const;
+	
+	/// Returns the number of mip levels of the texture's storage.
+	std::size_t get_level_count() const;
+	
+	/// Returns the index of the finest resident mip level of a compressed texture.
+	std::size_t get_base_level() const;
 
 	/// Returns the wrapping modes of the texture.
 	const std::tuple<texture_wrapping, texture_wrapping> get_wrapping() const;
@@ -104,16 +208,31 @@ public:
 
 	/// Returns the maximum anisotropy.
 	float get_max_anisotropy() const;
+	
+	/**
+	 * Returns `true` if the current OpenGL context can sample textures of a compressed format.
+	 *
+	 * @param format Compressed format.
+	 */
+	static bool is_supported(gl::compressed_format format);
 
 private:
 	friend class framebuffer;
 	friend class shader_input;
+	
+	/// Sets the dimensions and pixel format of an uncompressed texture.
+	void set_format(int width, int height, gl::pixel_type type, gl::pixel_format format, gl::color_space color_space);
 
 	unsigned int gl_texture_id;
 	std::array<int, 2> dimensions;
 	gl::pixel_type pixel_type;
 	gl::pixel_format pixel_format;
 	gl::color_space color_space;
+	bool compressed;
+	gl::compressed_format compressed_format;
+	std::size_t level_count;
+	std::size_t base_level;
+	std::size_t size;
 	std::tuple<texture_wrapping, texture_wrapping> wrapping;
 	std::tuple<texture_min_filter, texture_mag_filter> filters;
 	float max_anisotropy;
@@ -139,6 +258,31 @@ inline const color_space& texture_2d::get_color_space() const
 	return color_space;
 }
 
+inline bool texture_2d::is_compressed() const
+{
+	return compressed;
+}
+
+inline const gl::compressed_format& texture_2d::get_compressed_format() const
+{
+	return compressed_format;
+}
+
+inline std::size_t texture_2d::get_level_count() const
+{
+	return level_count;
+}
+
+inline std::size_t texture_2d::get_base_level() const
+{
+	return base_level;
+}
+
+inline std::size_t texture_2d::get_size() const
+{
+	return size;
+}
+
 inline const std::tuple<texture_wrapping, texture_wrapping> texture_2d::get_wrapping() const
 {
 	return wrapping;
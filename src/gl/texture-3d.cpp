@@ -0,0 +1,80 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "gl/texture-3d.hpp"
+#include "gl/texture-format.hpp"
+#include "gl/texture-wrapping.hpp"
+#include "gl/texture-filter.hpp"
+#include <glad/glad.h>
+
+namespace gl {
+
+texture_3d::texture_3d(int width, int height, int depth, gl::pixel_type type, gl::pixel_format format, gl::color_space color_space, const void* data):
+	gl_texture_id(0),
+	dimensions({width, height, depth}),
+	pixel_type(type),
+	pixel_format(format),
+	color_space(color_space)
+{
+	const texture_format formats = get_texture_format(type, format, color_space);
+	
+	glGenTextures(1, &gl_texture_id);
+	glBindTexture(GL_TEXTURE_3D, gl_texture_id);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexImage3D(GL_TEXTURE_3D, 0, formats.internal_format, width, height, depth, 0, formats.format, formats.type, data);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_BASE_LEVEL, 0);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAX_LEVEL, 0);
+	glTexParameteriv(GL_TEXTURE_3D, GL_TEXTURE_SWIZZLE_RGBA, formats.swizzle_mask);
+	
+	set_wrapping(texture_wrapping::extend, texture_wrapping::extend, texture_wrapping::extend);
+	set_filters(texture_min_filter::linear, texture_mag_filter::linear);
+}
+
+texture_3d::~texture_3d()
+{
+	glDeleteTextures(1, &gl_texture_id);
+}
+
+void texture_3d::update(const void* data)
+{
+	const texture_format formats = get_texture_format(pixel_type, pixel_format, color_space);
+	
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	
+	glBindTexture(GL_TEXTURE_3D, gl_texture_id);
+	glTexSubImage3D(GL_TEXTURE_3D, 0, 0, 0, 0, dimensions[0], dimensions[1], dimensions[2], formats.format, formats.type, data);
+}
+
+void texture_3d::set_wrapping(gl::texture_wrapping wrap_s, texture_wrapping wrap_t, texture_wrapping wrap_r)
+{
+	glBindTexture(GL_TEXTURE_3D, gl_texture_id);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, get_texture_wrapping(wrap_s));
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, get_texture_wrapping(wrap_t));
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, get_texture_wrapping(wrap_r));
+}
+
+void texture_3d::set_filters(texture_min_filter min_filter, texture_mag_filter mag_filter)
+{
+	glBindTexture(GL_TEXTURE_3D, gl_texture_id);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, get_texture_min_filter(min_filter));
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, get_texture_mag_filter(mag_filter));
+}
+
+} // namespace gl
@@ -0,0 +1,130 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef ANTKEEPER_GL_TEXTURE_3D_HPP
+#define ANTKEEPER_GL_TEXTURE_3D_HPP
+
+#include <array>
+#include <cstddef>
+#include "gl/color-space.hpp"
+#include "gl/pixel-format.hpp"
+#include "gl/pixel-type.hpp"
+
+namespace gl {
+
+class shader_input;
+enum class texture_mag_filter;
+enum class texture_min_filter;
+enum class texture_wrapping;
+
+/**
+ * A 3D texture without mip levels, such as a color lookup table, which can be uploaded to shaders via a `sampler3D` shader input.
+ */
+class texture_3d
+{
+public:
+	/**
+	 * Creates a 3D texture.
+	 *
+	 * @param width Width of the texture, in pixels.
+	 * @param height Height of the texture, in pixels.
+	 * @param depth Depth of the texture, in pixels.
+	 * @param type Pixel type of the texture data.
+	 * @param format Pixel format of the texture data.
+	 * @param color_space Color space of the texture data.
+	 * @param data Pixel data, with x varying fastest and z slowest, or `nullptr` to leave the texture undefined.
+	 */
+	texture_3d(int width, int height, int depth, gl::pixel_type type = gl::pixel_type::uint_8, gl::pixel_format format = gl::pixel_format::rgba, gl::color_space color_space = gl::color_space::linear, const void* data = nullptr);
+	
+	/// Destroys a 3D texture.
+	~texture_3d();
+	
+	texture_3d(const texture_3d&) = delete;
+	texture_3d& operator=(const texture_3d&) = delete;
+	
+	/**
+	 * Replaces the pixel data of the texture.
+	 *
+	 * @param data Pixel data, in the texture's pixel type and format, with x varying fastest and z slowest.
+	 */
+	void update(const void* data);
+	
+	/**
+	 * Sets the texture wrapping modes.
+	 *
+	 * @param wrap_s Wrapping mode for s-coordinates.
+	 * @param wrap_t Wrapping mode for t-coordinates.
+	 * @param wrap_r Wrapping mode for r-coordinates.
+	 */
+	void set_wrapping(gl::texture_wrapping wrap_s, texture_wrapping wrap_t, texture_wrapping wrap_r);
+	
+	/**
+	 * Sets the texture filtering modes. As the texture has no mip levels, the minification filter should not use mipmaps.
+	 *
+	 * @param min_filter Texture minification filter.
+	 * @param mag_filter Texture magnification filter.
+	 */
+	void set_filters(texture_min_filter min_filter, texture_mag_filter mag_filter);
+	
+	/// Returns the dimensions of the texture, in pixels.
+	const std::array<int, 3>& get_dimensions() const;
+	
+	/// Returns the pixel type enumeration.
+	const pixel_type& get_pixel_type() const;
+	
+	/// Returns the pixel format enumeration.
+	const pixel_format& get_pixel_format() const;
+	
+	/// Returns the color space enumeration.
+	const color_space& get_color_space() const;
+
+private:
+	friend class shader_input;
+	
+	unsigned int gl_texture_id;
+	std::array<int, 3> dimensions;
+	gl::pixel_type pixel_type;
+	gl::pixel_format pixel_format;
+	gl::color_space color_space;
+};
+
+inline const std::array<int, 3>& texture_3d::get_dimensions() const
+{
+	return dimensions;
+}
+
+inline const pixel_type& texture_3d::get_pixel_type() const
+{
+	return pixel_type;
+}
+
+inline const pixel_format& texture_3d::get_pixel_format() const
+{
+	return pixel_format;
+}
+
+inline const color_space& texture_3d::get_color_space() const
+{
+	return color_space;
+}
+
+} // namespace gl
+
+#endif // ANTKEEPER_GL_TEXTURE_3D_HPP
@@ -0,0 +1,172 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "gl/texture-format.hpp"
+#include <glad/glad.h>
+
+namespace gl {
+
+static constexpr GLenum pixel_format_lut[] =
+{
+	GL_DEPTH_COMPONENT,
+	GL_DEPTH_STENCIL,
+	GL_RED,
+	GL_RG,
+	GL_RGB,
+	GL_BGR,
+	GL_RGBA,
+	GL_BGRA
+};
+
+static constexpr GLenum pixel_type_lut[] =
+{
+	GL_BYTE,
+	GL_UNSIGNED_BYTE,
+	GL_SHORT,
+	GL_UNSIGNED_SHORT,
+	GL_INT,
+	GL_UNSIGNED_INT,
+	GL_HALF_FLOAT,
+	GL_FLOAT,
+	GL_UNSIGNED_INT_10F_11F_11F_REV
+};
+
+static constexpr std::size_t pixel_format_channels_lut[] = {1, 2, 1, 2, 3, 3, 4, 4};
+
+static constexpr std::size_t pixel_type_size_lut[] = {1, 1, 2, 2, 4, 4, 2, 4, 4};
+
+static constexpr GLenum linear_internal_format_lut[][9] =
+{
+	{GL_NONE, GL_NONE, GL_DEPTH_COMPONENT16, GL_DEPTH_COMPONENT16, GL_DEPTH_COMPONENT32, GL_DEPTH_COMPONENT32, GL_NONE, GL_DEPTH_COMPONENT32F, GL_NONE},
+	
+	// Note: GL_DEPTH32F_STENCIL8 is actually a 64-bit format, 32 depth bits, 8 stencil bits, and 24 alignment bits.
+	{GL_NONE, GL_NONE, GL_NONE, GL_NONE, GL_DEPTH24_STENCIL8, GL_DEPTH24_STENCIL8, GL_NONE, GL_DEPTH32F_STENCIL8, GL_NONE},
+	
+	{GL_R8, GL_R8, GL_R16, GL_R16, GL_R32F, GL_R32F, GL_R16F, GL_R32F, GL_NONE},
+	{GL_RG8, GL_RG8, GL_RG16, GL_RG16, GL_RG32F, GL_RG32F, GL_RG16F, GL_RG32F, GL_NONE},
+	{GL_RGB8, GL_RGB8, GL_RGB16, GL_RGB16, GL_RGB32F, GL_RGB32F, GL_RGB16F, GL_RGB32F, GL_R11F_G11F_B10F},
+	{GL_RGB8, GL_RGB8, GL_RGB16, GL_RGB16, GL_RGB32F, GL_RGB32F, GL_RGB16F, GL_RGB32F, GL_NONE},
+	{GL_RGBA8, GL_RGBA8, GL_RGBA16, GL_RGBA16, GL_RGBA32F, GL_RGBA32F, GL_RGBA16F, GL_RGBA32F, GL_NONE},
+	{GL_RGBA8, GL_RGBA8, GL_RGBA16, GL_RGBA16, GL_RGBA32F, GL_RGBA32F, GL_RGBA16F, GL_RGBA32F, GL_NONE}
+};
+
+static constexpr GLenum srgb_internal_format_lut[][9] =
+{
+	{GL_NONE, GL_NONE, GL_DEPTH_COMPONENT16, GL_DEPTH_COMPONENT16, GL_DEPTH_COMPONENT32, GL_DEPTH_COMPONENT32, GL_NONE, GL_DEPTH_COMPONENT32F, GL_NONE},
+	{GL_NONE, GL_NONE, GL_NONE, GL_NONE, GL_DEPTH24_STENCIL8, GL_DEPTH24_STENCIL8, GL_NONE, GL_DEPTH32F_STENCIL8, GL_NONE},
+	{GL_SRGB8, GL_SRGB8, GL_R16, GL_R16, GL_R32F, GL_R32F, GL_R16F, GL_R32F, GL_NONE},
+	{GL_SRGB8, GL_SRGB8, GL_RG16, GL_RG16, GL_RG32F, GL_RG32F, GL_RG16F, GL_RG32F, GL_NONE},
+	{GL_SRGB8, GL_SRGB8, GL_RGB16, GL_RGB16, GL_RGB32F, GL_RGB32F, GL_RGB16F, GL_RGB32F, GL_R11F_G11F_B10F},
+	{GL_SRGB8, GL_SRGB8, GL_RGB16, GL_RGB16, GL_RGB32F, GL_RGB32F, GL_RGB16F, GL_RGB32F, GL_NONE},
+	{GL_SRGB8_ALPHA8, GL_SRGB8_ALPHA8, GL_RGBA16, GL_RGBA16, GL_RGBA32F, GL_RGBA32F, GL_RGBA16F, GL_RGBA32F, GL_NONE},
+	{GL_SRGB8_ALPHA8, GL_SRGB8_ALPHA8, GL_RGBA16, GL_RGBA16, GL_RGBA32F, GL_RGBA32F, GL_RGBA16F, GL_RGBA32F, GL_NONE}
+};
+
+static constexpr GLint swizzle_mask_lut[][4] =
+{
+	{GL_RED, GL_RED, GL_RED, GL_ONE},
+	{GL_RED, GL_GREEN, GL_ZERO, GL_ONE},
+	{GL_RED, GL_RED, GL_RED, GL_ONE},
+	{GL_RED, GL_RED, GL_RED, GL_GREEN},
+	{GL_RED, GL_GREEN, GL_BLUE, GL_ONE},
+	{GL_RED, GL_GREEN, GL_BLUE, GL_ONE},
+	{GL_RED, GL_GREEN, GL_BLUE, GL_ALPHA},
+	{GL_RED, GL_GREEN, GL_BLUE, GL_ALPHA}
+};
+
+static constexpr GLenum wrapping_lut[] =
+{
+	GL_CLAMP_TO_BORDER,
+	GL_CLAMP_TO_EDGE,
+	GL_REPEAT,
+	GL_MIRRORED_REPEAT
+};
+
+static constexpr GLenum min_filter_lut[] =
+{
+	GL_NEAREST,
+	GL_LINEAR,
+	GL_NEAREST_MIPMAP_NEAREST,
+	GL_LINEAR_MIPMAP_NEAREST,
+	GL_NEAREST_MIPMAP_LINEAR,
+	GL_LINEAR_MIPMAP_LINEAR
+};
+
+static constexpr GLenum mag_filter_lut[] =
+{
+	GL_NEAREST,
+	GL_LINEAR
+};
+
+texture_format get_texture_format(gl::pixel_type type, gl::pixel_format format, gl::color_space color_space)
+{
+	texture_format formats;
+	if (color_space == gl::color_space::srgb)
+		formats.internal_format = srgb_internal_format_lut[static_cast<std::size_t>(format)][static_cast<std::size_t>(type)];
+	else
+		formats.internal_format = linear_internal_format_lut[static_cast<std::size_t>(format)][static_cast<std::size_t>(type)];
+	formats.format = pixel_format_lut[static_cast<std::size_t>(format)];
+	formats.type = pixel_type_lut[static_cast<std::size_t>(type)];
+	formats.pixel_size = pixel_format_channels_lut[static_cast<std::size_t>(format)] * pixel_type_size_lut[static_cast<std::size_t>(type)];
+	formats.swizzle_mask = swizzle_mask_lut[static_cast<std::size_t>(format)];
+	
+	// Special cases for depth + stencil pixel formats and packed pixel types
+	if (formats.internal_format == GL_DEPTH24_STENCIL8)
+	{
+		formats.type = GL_UNSIGNED_INT_24_8;
+		formats.pixel_size = 4;
+	}
+	else if (formats.internal_format == GL_DEPTH32F_STENCIL8)
+	{
+		formats.type = GL_FLOAT_32_UNSIGNED_INT_24_8_REV;
+		formats.pixel_size = 8;
+	}
+	else if (type == gl::pixel_type::ufloat_11_11_10)
+	{
+		formats.pixel_size = 4;
+	}
+	
+	return formats;
+}
+
+unsigned int get_texture_wrapping(gl::texture_wrapping wrapping)
+{
+	return wrapping_lut[static_cast<std::size_t>(wrapping)];
+}
+
+unsigned int get_texture_min_filter(gl::texture_min_filter filter)
+{
+	return min_filter_lut[static_cast<std::size_t>(filter)];
+}
+
+unsigned int get_texture_mag_filter(gl::texture_mag_filter filter)
+{
+	return mag_filter_lut[static_cast<std::size_t>(filter)];
+}
+
+std::size_t get_full_level_count(int width, int height)
+{
+	std::size_t level_count = 1;
+	for (int level_width = width, level_height = height; level_width > 1 || level_height > 1; level_width >>= 1, level_height >>= 1)
+		++level_count;
+	return level_count;
+}
+
+} // namespace gl
@@ -0,0 +1,70 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef ANTKEEPER_GL_TEXTURE_FORMAT_HPP
+#define ANTKEEPER_GL_TEXTURE_FORMAT_HPP
+
+#include "gl/color-space.hpp"
+#include "gl/pixel-format.hpp"
+#include "gl/pixel-type.hpp"
+#include "gl/texture-filter.hpp"
+#include "gl/texture-wrapping.hpp"
+#include <cstddef>
+
+namespace gl {
+
+/// OpenGL enumerations with which the pixels of an uncompressed texture are specified.
+struct texture_format
+{
+	unsigned int internal_format;
+	unsigned int format;
+	unsigned int type;
+	
+	/// Size of a pixel, in bytes.
+	std::size_t pixel_size;
+	
+	/// Texture swizzle mask, by which the channels of the pixel format are read as RGBA.
+	const int* swizzle_mask;
+};
+
+/**
+ * Returns the OpenGL enumerations with which pixels of a pixel type and format are specified in a color space. Shared by the texture classes.
+ *
+ * @param type Pixel type.
+ * @param format Pixel format.
+ * @param color_space Color space.
+ */
+texture_format get_texture_format(gl::pixel_type type, gl::pixel_format format, gl::color_space color_space);
+
+/// Returns the OpenGL enumeration of a texture wrapping mode.
+unsigned int get_texture_wrapping(gl::texture_wrapping wrapping);
+
+/// Returns the OpenGL enumeration of a texture minification filter.
+unsigned int get_texture_min_filter(gl::texture_min_filter filter);
+
+/// Returns the OpenGL enumeration of a texture magnification filter.
+unsigned int get_texture_mag_filter(gl::texture_mag_filter filter);
+
+/// Returns the number of levels in the full mip chain of a texture.
+std::size_t get_full_level_count(int width, int height);
+
+} // namespace gl
+
+#endif // ANTKEEPER_GL_TEXTURE_FORMAT_HPP
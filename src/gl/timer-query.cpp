@@ -0,0 +1,67 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gl/timer-query.hpp"
+#include <glad/glad.h>
+
+namespace gl {
+
+timer_query::timer_query():
+	gl_query_id(0),
+	issued(false)
+{
+	glGenQueries(1, &gl_query_id);
+}
+
+timer_query::~timer_query()
+{
+	glDeleteQueries(1, &gl_query_id);
+}
+
+void timer_query::begin()
+{
+	glBeginQuery(GL_TIME_ELAPSED, gl_query_id);
+}
+
+void timer_query::end()
+{
+	glEndQuery(GL_TIME_ELAPSED);
+	issued = true;
+}
+
+bool timer_query::is_available() const
+{
+	if (!issued)
+		return false;
+	
+	GLint available = GL_FALSE;
+	glGetQueryObjectiv(gl_query_id, GL_QUERY_RESULT_AVAILABLE, &available);
+	
+	return (available == GL_TRUE);
+}
+
+double timer_query::get_elapsed_time() const
+{
+	GLuint64 nanoseconds = 0;
+	glGetQueryObjectui64v(gl_query_id, GL_QUERY_RESULT, &nanoseconds);
+	
+	return static_cast<double>(nanoseconds) * 1e-9;
+}
+
+} // namespace gl
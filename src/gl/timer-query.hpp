@@ -0,0 +1,62 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ANTKEEPER_GL_TIMER_QUERY_HPP
+#define ANTKEEPER_GL_TIMER_QUERY_HPP
+
+namespace gl {
+
+/**
+ * Query object which measures the GPU time elapsed between its beginning and end.
+ *
+ * Only one timer query can be active at a time.
+ */
+class timer_query
+{
+public:
+	/// Creates a timer query.
+	timer_query();
+	
+	/// Destroys a timer query.
+	~timer_query();
+	
+	timer_query(const timer_query&) = delete;
+	timer_query& operator=(const timer_query&) = delete;
+	
+	/// Begins timing subsequent GPU commands.
+	void begin();
+	
+	/// Ends timing.
+	void end();
+	
+	/// Returns `true` if the query has been issued and its result can be read without stalling.
+	bool is_available() const;
+	
+	/// Returns the elapsed GPU time, in seconds. Blocks until the result is available.
+	double get_elapsed_time() const;
+
+private:
+	unsigned int gl_query_id;
+	bool issued;
+};
+
+} // namespace gl
+
+#endif // ANTKEEPER_GL_TIMER_QUERY_HPP
+
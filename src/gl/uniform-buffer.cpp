@@ -0,0 +1,97 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gl/uniform-buffer.hpp"
+#include "debug/gl-monitor.hpp"
+#include <glad/glad.h>
+
+namespace gl {
+
+static constexpr GLenum buffer_usage_lut[] =
+{
+	GL_STREAM_DRAW,
+	GL_STREAM_READ,
+	GL_STREAM_COPY,
+	GL_STATIC_DRAW,
+	GL_STATIC_READ,
+	GL_STATIC_COPY,
+	GL_DYNAMIC_DRAW,
+	GL_DYNAMIC_READ,
+	GL_DYNAMIC_COPY
+};
+
+uniform_buffer::uniform_buffer(std::size_t size, const void* data, buffer_usage usage):
+	gl_buffer_id(0),
+	size(size),
+	usage(usage)
+{
+	GLenum gl_usage = buffer_usage_lut[static_cast<std::size_t>(usage)];
+
+	glGenBuffers(1, &gl_buffer_id);
+	glBindBuffer(GL_UNIFORM_BUFFER, gl_buffer_id);
+	glBufferData(GL_UNIFORM_BUFFER, size, data, gl_usage);
+}
+
+uniform_buffer::uniform_buffer():
+	uniform_buffer(0, nullptr, buffer_usage::dynamic_draw)
+{}
+
+uniform_buffer::~uniform_buffer()
+{
+	glDeleteBuffers(1, &gl_buffer_id);
+}
+
+void uniform_buffer::repurpose(std::size_t size, const void* data, buffer_usage usage)
+{
+	this->size = size;
+	this->usage = usage;
+
+	GLenum gl_usage = buffer_usage_lut[static_cast<std::size_t>(usage)];
+
+	glBindBuffer(GL_UNIFORM_BUFFER, gl_buffer_id);
+	glBufferData(GL_UNIFORM_BUFFER, size, data, gl_usage);
+}
+
+void uniform_buffer::resize(std::size_t size, const void* data)
+{
+	repurpose(size, data, usage);
+}
+
+void uniform_buffer::update(int offset, std::size_t size, const void* data)
+{
+	glBindBuffer(GL_UNIFORM_BUFFER, gl_buffer_id);
+	
+	// Stalls if the GPU is still reading the buffer
+	debug::gl_stall_scope stall("glBufferSubData");
+	glBufferSubData(GL_UNIFORM_BUFFER, offset, size, data);
+}
+
+std::size_t uniform_buffer::get_offset_alignment()
+{
+	static std::size_t alignment = 0;
+	if (!alignment)
+	{
+		GLint gl_alignment = 0;
+		glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &gl_alignment);
+		alignment = (gl_alignment > 0) ? static_cast<std::size_t>(gl_alignment) : 256;
+	}
+	return alignment;
+}
+
+} // namespace gl
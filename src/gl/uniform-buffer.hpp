@@ -0,0 +1,113 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ANTKEEPER_GL_UNIFORM_BUFFER_HPP
+#define ANTKEEPER_GL_UNIFORM_BUFFER_HPP
+
+#include <cstdlib>
+#include "gl/buffer-usage.hpp"
+
+namespace gl {
+
+class rasterizer;
+
+/**
+ * Buffer object which backs one or more shader uniform blocks.
+ *
+ * @see gl::shader_program::bind_uniform_block()
+ * @see gl::rasterizer::bind_uniform_buffer()
+ */
+class uniform_buffer
+{
+public:
+	/**
+	 * Creates a uniform buffer.
+	 *
+	 * @param size Size of the buffer, in bytes.
+	 * @param data Initial buffer data, or `nullptr` if the buffer should be uninitialized.
+	 * @param usage Buffer usage hint.
+	 */
+	explicit uniform_buffer(std::size_t size, const void* data = nullptr, buffer_usage usage = buffer_usage::dynamic_draw);
+	
+	/// Creates an empty uniform buffer.
+	uniform_buffer();
+	
+	/// Destroys a uniform buffer.
+	~uniform_buffer();
+
+	uniform_buffer(const uniform_buffer&) = delete;
+	uniform_buffer& operator=(const uniform_buffer&) = delete;
+
+	/**
+	 * Reallocates the buffer storage.
+	 *
+	 * @param size Size of the buffer, in bytes.
+	 * @param data Initial buffer data, or `nullptr` if the buffer should be uninitialized.
+	 * @param usage Buffer usage hint.
+	 */
+	void repurpose(std::size_t size, const void* data = nullptr, buffer_usage usage = buffer_usage::dynamic_draw);
+	
+	/**
+	 * Reallocates the buffer storage, retaining the current usage hint.
+	 *
+	 * @param size Size of the buffer, in bytes.
+	 * @param data Initial buffer data, or `nullptr` if the buffer should be uninitialized.
+	 */
+	void resize(std::size_t size, const void* data = nullptr);
+
+	/**
+	 * Updates a range of the buffer storage.
+	 *
+	 * @param offset Offset into the buffer, in bytes.
+	 * @param size Number of bytes to update.
+	 * @param data Data to copy into the buffer.
+	 */
+	void update(int offset, std::size_t size, const void* data);
+
+	/// Returns the size of the buffer, in bytes.
+	std::size_t get_size() const;
+	
+	/// Returns the buffer usage hint.
+	buffer_usage get_usage() const;
+	
+	/// Returns the alignment, in bytes, to which the offsets of bound uniform buffer ranges must be aligned.
+	static std::size_t get_offset_alignment();
+
+private:
+	friend class rasterizer;
+
+	unsigned int gl_buffer_id;
+	std::size_t size;
+	buffer_usage usage;
+};
+
+inline std::size_t uniform_buffer::get_size() const
+{
+	return size;
+}
+
+inline buffer_usage uniform_buffer::get_usage() const
+{
+	return usage;
+}
+
+} // namespace gl
+
+#endif // ANTKEEPER_GL_UNIFORM_BUFFER_HPP
+
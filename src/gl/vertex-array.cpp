@@ -33,11 +33,14 @@ static constexpr GLenum vertex_attribute_type_lut[] =
 	GL_UNSIGNED_INT,
 	GL_HALF_FLOAT,
 	GL_FLOAT,
-	GL_DOUBLE
+	GL_DOUBLE,
+	GL_INT_2_10_10_10_REV,
+	GL_UNSIGNED_INT_2_10_10_10_REV
 };
 
 vertex_array::vertex_array():
-	gl_array_id(0)
+	gl_array_id(0),
+	element_buffer(nullptr)
 {
 	glGenVertexArrays(1, &gl_array_id);
 }
@@ -47,20 +50,30 @@ vertex_array::~vertex_array()
 	glDeleteVertexArrays(1, &gl_array_id);
 }
 
-void vertex_array::bind_attribute(unsigned int index, const vertex_buffer& buffer, int size, vertex_attribute_type type, int stride, std::size_t offset)
+void vertex_array::bind_attribute(unsigned int index, const vertex_buffer& buffer, int size, vertex_attribute_type type, int stride, std::size_t offset, bool normalized)
 {
 	GLenum gl_type = vertex_attribute_type_lut[static_cast<std::size_t>(type)];
 
 	glBindVertexArray(gl_array_id);
 	glBindBuffer(GL_ARRAY_BUFFER, buffer.gl_buffer_id);
-	glVertexAttribPointer(index, size, gl_type, GL_FALSE, stride, (const GLvoid*)offset); 
+	glVertexAttribPointer(index, size, gl_type, (normalized) ? GL_TRUE : GL_FALSE, stride, (const GLvoid*)offset);
 	glEnableVertexAttribArray(index);
+	
+	attributes[index] = {&buffer, size, type, stride, offset, normalized};
 }
 
 void vertex_array::bind_elements(const vertex_buffer& buffer)
 {
 	glBindVertexArray(gl_array_id);
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer.gl_buffer_id);
+	
+	element_buffer = &buffer;
+}
+
+void vertex_array::set_attribute_divisor(unsigned int index, unsigned int divisor)
+{
+	glBindVertexArray(gl_array_id);
+	glVertexAttribDivisor(index, divisor);
 }
 
 } // namespace gl
@@ -21,6 +21,7 @@
 #define ANTKEEPER_GL_VERTEX_ARRAY_HPP
 
 #include <cstdlib>
+#include <unordered_map>
 
 namespace gl {
 
@@ -37,15 +38,63 @@ public:
 	vertex_array(const vertex_array&) = delete;
 	vertex_array& operator=(const vertex_array&) = delete;
 
-	void bind_attribute(unsigned int index, const vertex_buffer& buffer, int size, vertex_attribute_type type, int stride, std::size_t offset);
+	/// Source of a vertex attribute, as passed to bind_attribute().
+	struct attribute_binding
+	{
+		const vertex_buffer* buffer;
+		int size;
+		vertex_attribute_type type;
+		int stride;
+		std::size_t offset;
+		bool normalized;
+	};
+
+	/**
+	 * Binds a vertex attribute to a region of a vertex buffer.
+	 *
+	 * @param index Index of the vertex attribute.
+	 * @param buffer Vertex buffer from which the attribute is sourced.
+	 * @param size Number of components per vertex.
+	 * @param type Type of the components.
+	 * @param stride Distance between the attributes of consecutive vertices, in bytes.
+	 * @param offset Offset of the first vertex's attribute, in bytes.
+	 * @param normalized `true` if integer components should be mapped to `[0, 1]`, or `[-1, 1]` if signed, rather than converted directly to floats.
+	 */
+	void bind_attribute(unsigned int index, const vertex_buffer& buffer, int size, vertex_attribute_type type, int stride, std::size_t offset, bool normalized = false);
 	void bind_elements(const vertex_buffer& buffer);
+	
+	/**
+	 * Sets the rate at which a vertex attribute advances during instanced draws.
+	 *
+	 * @param index Index of a bound vertex attribute.
+	 * @param divisor Number of instances drawn per attribute value, or `0` to advance once per vertex.
+	 */
+	void set_attribute_divisor(unsigned int index, unsigned int divisor);
+	
+	/// Returns the bound vertex attributes, keyed by attribute index, so that their sources can be bound to another vertex array.
+	const std::unordered_map<unsigned int, attribute_binding>& get_attributes() const;
+	
+	/// Returns the bound element buffer, or `nullptr` if no element buffer has been bound.
+	const vertex_buffer* get_element_buffer() const;
 
 private:
 	friend class rasterizer;
 
 	unsigned int gl_array_id;
+	std::unordered_map<unsigned int, attribute_binding> attributes;
+	const vertex_buffer* element_buffer;
 };
 
+inline const std::unordered_map<unsigned int, vertex_array::attribute_binding>& vertex_array::get_attributes() const
+{
+	return attributes;
+}
+
+inline const vertex_buffer* vertex_array::get_element_buffer() const
+{
+	return element_buffer;
+}
+
 } // namespace gl
 
 #endif // ANTKEEPER_GL_VERTEX_ARRAY_HPP
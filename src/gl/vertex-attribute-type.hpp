@@ -32,7 +32,13 @@ enum class vertex_attribute_type
 	uint_32,
 	float_16,
 	float_32,
-	float_64
+	float_64,
+	
+	/// Signed 10-bit x, y and z components and a 2-bit w component, packed into 32 bits. Bound with a size of 4.
+	int_2_10_10_10_rev,
+	
+	/// Unsigned 10-bit x, y and z components and a 2-bit w component, packed into 32 bits. Bound with a size of 4.
+	uint_2_10_10_10_rev
 };
 
 } // namespace gl
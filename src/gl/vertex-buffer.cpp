@@ -18,6 +18,7 @@
  */
 
 #include "gl/vertex-buffer.hpp"
+#include "debug/gl-monitor.hpp"
 #include <glad/glad.h>
 
 namespace gl {
@@ -75,6 +76,9 @@ void vertex_buffer::resize(std::size_t size, const void* data)
 void vertex_buffer::update(int offset, std::size_t size, const void* data)
 {
 	glBindBuffer(GL_ARRAY_BUFFER, gl_buffer_id);
+	
+	// Stalls if the GPU is still reading the buffer
+	debug::gl_stall_scope stall("glBufferSubData");
 	glBufferSubData(GL_ARRAY_BUFFER, offset, size, data);
 }
 
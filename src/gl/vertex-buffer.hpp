@@ -47,6 +47,7 @@ public:
 
 private:
 	friend class vertex_array;
+	friend class streaming_buffer;
 
 	unsigned int gl_buffer_id;
 	std::size_t size;
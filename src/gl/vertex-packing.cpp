@@ -0,0 +1,48 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gl/vertex-packing.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace gl {
+
+namespace {
+
+/// Packs a value into a signed normalized integer of the given bit width, in the low bits of the result.
+inline std::uint32_t pack_snorm(float x, int bits)
+{
+	const float scale = static_cast<float>((1 << (bits - 1)) - 1);
+	const std::int32_t value = static_cast<std::int32_t>(std::lround(std::clamp(x, -1.0f, 1.0f) * scale));
+	return static_cast<std::uint32_t>(value) & ((1u << bits) - 1u);
+}
+
+} // namespace
+
+std::uint32_t pack_snorm_2_10_10_10(float x, float y, float z, float w)
+{
+	return pack_snorm(x, 10) | (pack_snorm(y, 10) << 10) | (pack_snorm(z, 10) << 20) | (pack_snorm(w, 2) << 30);
+}
+
+std::uint8_t pack_unorm_8(float x)
+{
+	return static_cast<std::uint8_t>(std::lround(std::clamp(x, 0.0f, 1.0f) * 255.0f));
+}
+
+} // namespace gl
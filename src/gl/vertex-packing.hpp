@@ -0,0 +1,48 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ANTKEEPER_GL_VERTEX_PACKING_HPP
+#define ANTKEEPER_GL_VERTEX_PACKING_HPP
+
+#include <cstdint>
+
+namespace gl {
+
+/**
+ * Packs a vector into signed normalized 10-bit x, y and z components and a 2-bit w component, for vertex attributes of type gl::vertex_attribute_type::int_2_10_10_10_rev bound as normalized. Suited to unit normals, and to tangents with the sign of their bitangent in @p w.
+ *
+ * @param x X-component, in `[-1, 1]`.
+ * @param y Y-component, in `[-1, 1]`.
+ * @param z Z-component, in `[-1, 1]`.
+ * @param w W-component, `-1`, `0`, or `1`.
+ * @return Packed vector.
+ */
+std::uint32_t pack_snorm_2_10_10_10(float x, float y, float z, float w);
+
+/**
+ * Packs a value into an unsigned normalized 8-bit integer, for vertex attributes of type gl::vertex_attribute_type::uint_8 bound as normalized.
+ *
+ * @param x Value, in `[0, 1]`.
+ * @return Packed value.
+ */
+std::uint8_t pack_unorm_8(float x);
+
+} // namespace gl
+
+#endif // ANTKEEPER_GL_VERTEX_PACKING_HPP
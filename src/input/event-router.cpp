@@ -22,9 +22,44 @@
 #include "mapping.hpp"
 #include "mouse.hpp"
 #include "event/event-dispatcher.hpp"
+#include <algorithm>
+#include <cmath>
+#include <utility>
 
 namespace input {
 
+namespace {
+
+/// Adds a mapping to the mappings of the input with the given index.
+template <class T>
+void insert_mapping(std::vector<std::vector<T*>>& table, std::size_t index, T* mapping)
+{
+	if (index >= table.size())
+		table.resize(index + 1);
+	table[index].push_back(mapping);
+}
+
+/// Removes a mapping from the mappings of the input with the given index.
+template <class T>
+void remove_mapping(std::vector<std::vector<T*>>& table, std::size_t index, T* mapping)
+{
+	if (index < table.size())
+	{
+		std::vector<T*>& mappings = table[index];
+		mappings.erase(std::remove(mappings.begin(), mappings.end(), mapping), mappings.end());
+	}
+}
+
+/// Returns the mappings of the input with the given index.
+template <class T>
+const std::vector<T*>& find_mappings(const std::vector<std::vector<T*>>& table, std::size_t index)
+{
+	static const std::vector<T*> none;
+	return (index < table.size()) ? table[index] : none;
+}
+
+} // namespace
+
 event_router::event_router():
 	event_dispatcher(nullptr)
 {}
@@ -44,7 +79,7 @@ void event_router::add_mapping(const mapping& mapping)
 		case mapping_type::key:
 		{
 			input::key_mapping* key_mapping = new input::key_mapping(static_cast<const input::key_mapping&>(mapping));
-			key_mappings.push_back(key_mapping);
+			insert_mapping(key_mappings, static_cast<std::size_t>(key_mapping->scancode), key_mapping);
 			controls[control].push_back(key_mapping);
 
 			break;
@@ -53,7 +88,7 @@ void event_router::add_mapping(const mapping& mapping)
 		case mapping_type::mouse_motion:
 		{
 			input::mouse_motion_mapping* mouse_motion_mapping = new input::mouse_motion_mapping(static_cast<const input::mouse_motion_mapping&>(mapping));
-			mouse_motion_mappings.push_back(mouse_motion_mapping);
+			insert_mapping(mouse_motion_mappings, static_cast<std::size_t>(mouse_motion_mapping->axis), mouse_motion_mapping);
 			controls[control].push_back(mouse_motion_mapping);
 
 			break;
@@ -62,7 +97,7 @@ void event_router::add_mapping(const mapping& mapping)
 		case mapping_type::mouse_wheel:
 		{
 			input::mouse_wheel_mapping* mouse_wheel_mapping = new input::mouse_wheel_mapping(static_cast<const input::mouse_wheel_mapping&>(mapping));
-			mouse_wheel_mappings.push_back(mouse_wheel_mapping);
+			insert_mapping(mouse_wheel_mappings, static_cast<std::size_t>(mouse_wheel_mapping->axis), mouse_wheel_mapping);
 			controls[control].push_back(mouse_wheel_mapping);
 
 			break;
@@ -71,7 +106,7 @@ void event_router::add_mapping(const mapping& mapping)
 		case mapping_type::mouse_button:
 		{
 			input::mouse_button_mapping* mouse_button_mapping = new input::mouse_button_mapping(static_cast<const input::mouse_button_mapping&>(mapping));
-			mouse_button_mappings.push_back(mouse_button_mapping);
+			insert_mapping(mouse_button_mappings, static_cast<std::size_t>(mouse_button_mapping->button), mouse_button_mapping);
 			controls[control].push_back(mouse_button_mapping);
 
 			break;
@@ -80,7 +115,7 @@ void event_router::add_mapping(const mapping& mapping)
 		case mapping_type::game_controller_axis:
 		{
 			input::game_controller_axis_mapping* game_controller_axis_mapping = new input::game_controller_axis_mapping(static_cast<const input::game_controller_axis_mapping&>(mapping));
-			game_controller_axis_mappings.push_back(game_controller_axis_mapping);
+			insert_mapping(game_controller_axis_mappings, static_cast<std::size_t>(game_controller_axis_mapping->axis), game_controller_axis_mapping);
 			controls[control].push_back(game_controller_axis_mapping);
 
 			break;
@@ -89,7 +124,7 @@ void event_router::add_mapping(const mapping& mapping)
 		case mapping_type::game_controller_button:
 		{
 			input::game_controller_button_mapping* game_controller_button_mapping = new input::game_controller_button_mapping(static_cast<const input::game_controller_button_mapping&>(mapping));
-			game_controller_button_mappings.push_back(game_controller_button_mapping);
+			insert_mapping(game_controller_button_mappings, static_cast<std::size_t>(game_controller_button_mapping->button), game_controller_button_mapping);
 			controls[control].push_back(game_controller_button_mapping);
 
 			break;
@@ -110,28 +145,46 @@ void event_router::remove_mappings(control* control)
 			switch (mapping->get_type())
 			{
 				case mapping_type::key:
-					key_mappings.remove(static_cast<key_mapping*>(mapping));
+				{
+					key_mapping* key_mapping = static_cast<input::key_mapping*>(mapping);
+					remove_mapping(key_mappings, static_cast<std::size_t>(key_mapping->scancode), key_mapping);
 					break;
+				}
 
 				case mapping_type::mouse_motion:
-					mouse_motion_mappings.remove(static_cast<mouse_motion_mapping*>(mapping));
+				{
+					mouse_motion_mapping* mouse_motion_mapping = static_cast<input::mouse_motion_mapping*>(mapping);
+					remove_mapping(mouse_motion_mappings, static_cast<std::size_t>(mouse_motion_mapping->axis), mouse_motion_mapping);
 					break;
+				}
 
 				case mapping_type::mouse_wheel:
-					mouse_wheel_mappings.remove(static_cast<mouse_wheel_mapping*>(mapping));
+				{
+					mouse_wheel_mapping* mouse_wheel_mapping = static_cast<input::mouse_wheel_mapping*>(mapping);
+					remove_mapping(mouse_wheel_mappings, static_cast<std::size_t>(mouse_wheel_mapping->axis), mouse_wheel_mapping);
 					break;
+				}
 
 				case mapping_type::mouse_button:
-					mouse_button_mappings.remove(static_cast<mouse_button_mapping*>(mapping));
+				{
+					mouse_button_mapping* mouse_button_mapping = static_cast<input::mouse_button_mapping*>(mapping);
+					remove_mapping(mouse_button_mappings, static_cast<std::size_t>(mouse_button_mapping->button), mouse_button_mapping);
 					break;
+				}
 
 				case mapping_type::game_controller_axis:
-					game_controller_axis_mappings.remove(static_cast<game_controller_axis_mapping*>(mapping));
+				{
+					game_controller_axis_mapping* game_controller_axis_mapping = static_cast<input::game_controller_axis_mapping*>(mapping);
+					remove_mapping(game_controller_axis_mappings, static_cast<std::size_t>(game_controller_axis_mapping->axis), game_controller_axis_mapping);
 					break;
+				}
 
 				case mapping_type::game_controller_button:
-					game_controller_button_mappings.remove(static_cast<game_controller_button_mapping*>(mapping));
+				{
+					game_controller_button_mapping* game_controller_button_mapping = static_cast<input::game_controller_button_mapping*>(mapping);
+					remove_mapping(game_controller_button_mappings, static_cast<std::size_t>(game_controller_button_mapping->button), game_controller_button_mapping);
 					break;
+				}
 
 				default:
 					break;
@@ -207,9 +260,9 @@ const std::list<mapping*>* event_router::get_mappings(control* control) const
 
 void event_router::handle_event(const key_pressed_event& event)
 {
-	for (const key_mapping* mapping: key_mappings)
+	for (const key_mapping* mapping: find_mappings(key_mappings, static_cast<std::size_t>(event.scancode)))
 	{
-		if ((!mapping->keyboard || mapping->keyboard == event.keyboard) && mapping->scancode == event.scancode)
+		if (!mapping->keyboard || mapping->keyboard == event.keyboard)
 		{
 			mapping->control->set_current_value(1.0f);
 		}
@@ -218,9 +271,9 @@ void event_router::handle_event(const key_pressed_event& event)
 
 void event_router::handle_event(const key_released_event& event)
 {
-	for (const key_mapping* mapping: key_mappings)
+	for (const key_mapping* mapping: find_mappings(key_mappings, static_cast<std::size_t>(event.scancode)))
 	{
-		if ((!mapping->keyboard || mapping->keyboard == event.keyboard) && mapping->scancode == event.scancode)
+		if (!mapping->keyboard || mapping->keyboard == event.keyboard)
 		{
 			mapping->control->set_current_value(0.0f);
 		}
@@ -229,25 +282,21 @@ void event_router::handle_event(const key_released_event& event)
 
 void event_router::handle_event(const mouse_moved_event& event)
 {
-	for (const mouse_motion_mapping* mapping: mouse_motion_mappings)
+	// Route motion along each axis to the mappings of its direction
+	const mouse_motion_axis x_axis = (event.dx < 0) ? mouse_motion_axis::negative_x : mouse_motion_axis::positive_x;
+	const mouse_motion_axis y_axis = (event.dy < 0) ? mouse_motion_axis::negative_y : mouse_motion_axis::positive_y;
+	const std::pair<mouse_motion_axis, float> motions[2] = {{x_axis, std::abs(event.dx)}, {y_axis, std::abs(event.dy)}};
+	
+	for (const auto& [axis, value]: motions)
 	{
-		if (!mapping->mouse || mapping->mouse == event.mouse)
+		if (value == 0.0f)
+			continue;
+		
+		for (const mouse_motion_mapping* mapping: find_mappings(mouse_motion_mappings, static_cast<std::size_t>(axis)))
 		{
-			if (mapping->axis == mouse_motion_axis::negative_x && event.dx < 0)
+			if (!mapping->mouse || mapping->mouse == event.mouse)
 			{
-				mapping->control->set_temporary_value(-event.dx);
-			}
-			else if (mapping->axis == mouse_motion_axis::positive_x && event.dx > 0)
-			{
-				mapping->control->set_temporary_value(event.dx);
-			}
-			else if (mapping->axis == mouse_motion_axis::negative_y && event.dy < 0)
-			{
-				mapping->control->set_temporary_value(-event.dy);
-			}
-			else if (mapping->axis == mouse_motion_axis::positive_y && event.dy > 0)
-			{
-				mapping->control->set_temporary_value(event.dy);
+				mapping->control->set_temporary_value(value);
 			}
 		}
 	}
@@ -255,25 +304,21 @@ void event_router::handle_event(const mouse_moved_event& event)
 
 void event_router::handle_event(const mouse_wheel_scrolled_event& event)
 {
-	for (const mouse_wheel_mapping* mapping: mouse_wheel_mappings)
+	// Route scrolling along each axis to the mappings of its direction
+	const mouse_wheel_axis x_axis = (event.x < 0) ? mouse_wheel_axis::negative_x : mouse_wheel_axis::positive_x;
+	const mouse_wheel_axis y_axis = (event.y < 0) ? mouse_wheel_axis::negative_y : mouse_wheel_axis::positive_y;
+	const std::pair<mouse_wheel_axis, float> scrolls[2] = {{x_axis, std::abs(static_cast<float>(event.x))}, {y_axis, std::abs(static_cast<float>(event.y))}};
+	
+	for (const auto& [axis, value]: scrolls)
 	{
-		if (!mapping->mouse || mapping->mouse == event.mouse)
+		if (value == 0.0f)
+			continue;
+		
+		for (const mouse_wheel_mapping* mapping: find_mappings(mouse_wheel_mappings, static_cast<std::size_t>(axis)))
 		{
-			if (mapping->axis == mouse_wheel_axis::negative_x && event.x < 0)
-			{
-				mapping->control->set_temporary_value(-event.x);
-			}
-			else if (mapping->axis == mouse_wheel_axis::positive_x && event.x > 0)
-			{
-				mapping->control->set_temporary_value(event.x);
-			}
-			else if (mapping->axis == mouse_wheel_axis::negative_y && event.y < 0)
+			if (!mapping->mouse || mapping->mouse == event.mouse)
 			{
-				mapping->control->set_temporary_value(-event.y);
-			}
-			else if (mapping->axis == mouse_wheel_axis::positive_y && event.y > 0)
-			{
-				mapping->control->set_temporary_value(event.y);
+				mapping->control->set_temporary_value(value);
 			}
 		}
 	}
@@ -281,9 +326,9 @@ void event_router::handle_event(const mouse_wheel_scrolled_event& event)
 
 void event_router::handle_event(const mouse_button_pressed_event& event)
 {
-	for (const mouse_button_mapping* mapping: mouse_button_mappings)
+	for (const mouse_button_mapping* mapping: find_mappings(mouse_button_mappings, static_cast<std::size_t>(event.button)))
 	{
-		if ((!mapping->mouse || mapping->mouse == event.mouse) && mapping->button == event.button)
+		if (!mapping->mouse || mapping->mouse == event.mouse)
 		{
 			mapping->control->set_current_value(1.0f);
 		}
@@ -292,9 +337,9 @@ void event_router::handle_event(const mouse_button_pressed_event& event)
 
 void event_router::handle_event(const mouse_button_released_event& event)
 {
-	for (const mouse_button_mapping* mapping: mouse_button_mappings)
+	for (const mouse_button_mapping* mapping: find_mappings(mouse_button_mappings, static_cast<std::size_t>(event.button)))
 	{
-		if ((!mapping->mouse || mapping->mouse == event.mouse) && mapping->button == event.button)
+		if (!mapping->mouse || mapping->mouse == event.mouse)
 		{
 			mapping->control->set_current_value(0.0f);
 		}
@@ -303,9 +348,9 @@ void event_router::handle_event(const mouse_button_released_event& event)
 
 void event_router::handle_event(const game_controller_axis_moved_event& event)
 {
-	for (const game_controller_axis_mapping* mapping: game_controller_axis_mappings)
+	for (const game_controller_axis_mapping* mapping: find_mappings(game_controller_axis_mappings, static_cast<std::size_t>(event.axis)))
 	{
-		if ((!mapping->controller || mapping->controller == event.controller) && mapping->axis == event.axis)
+		if (!mapping->controller || mapping->controller == event.controller)
 		{
 			if (mapping->negative && event.value >= 0.0f || !mapping->negative && event.value <= 0.0f)
 			{
@@ -321,9 +366,9 @@ void event_router::handle_event(const game_controller_axis_moved_event& event)
 
 void event_router::handle_event(const game_controller_button_pressed_event& event)
 {
-	for (const game_controller_button_mapping* mapping: game_controller_button_mappings)
+	for (const game_controller_button_mapping* mapping: find_mappings(game_controller_button_mappings, static_cast<std::size_t>(event.button)))
 	{
-		if ((!mapping->controller || mapping->controller == event.controller) && mapping->button == event.button)
+		if (!mapping->controller || mapping->controller == event.controller)
 		{
 			mapping->control->set_current_value(1.0f);
 		}
@@ -332,9 +377,9 @@ void event_router::handle_event(const game_controller_button_pressed_event& even
 
 void event_router::handle_event(const game_controller_button_released_event& event)
 {
-	for (const game_controller_button_mapping* mapping: game_controller_button_mappings)
+	for (const game_controller_button_mapping* mapping: find_mappings(game_controller_button_mappings, static_cast<std::size_t>(event.button)))
 	{
-		if ((!mapping->controller || mapping->controller == event.controller) && mapping->button == event.button)
+		if (!mapping->controller || mapping->controller == event.controller)
 		{
 			mapping->control->set_current_value(0.0f);
 		}
@@ -25,6 +25,7 @@
 #include "event/event-dispatcher.hpp"
 #include <list>
 #include <map>
+#include <vector>
 
 namespace input {
 
@@ -41,6 +42,8 @@ enum class mouse_wheel_axis;
 
 /**
  * Uses input mappings to route input events to controls.
+ *
+ * Mappings are indexed by the scancode, button, or axis which triggers them, so routing an event only visits the mappings of its input, rather than all mappings of its device type.
  */
 class event_router:
 	public event_handler<key_pressed_event>,
@@ -105,12 +108,24 @@ private:
 
 	event_dispatcher* event_dispatcher;
 	std::map<control*, std::list<mapping*>> controls;
-	std::list<key_mapping*> key_mappings;
-	std::list<mouse_motion_mapping*> mouse_motion_mappings;
-	std::list<mouse_wheel_mapping*> mouse_wheel_mappings;
-	std::list<mouse_button_mapping*> mouse_button_mappings;
-	std::list<game_controller_axis_mapping*> game_controller_axis_mappings;
-	std::list<game_controller_button_mapping*> game_controller_button_mappings;
+	
+	/// Key mappings, indexed by scancode.
+	std::vector<std::vector<key_mapping*>> key_mappings;
+	
+	/// Mouse motion mappings, indexed by mouse motion axis.
+	std::vector<std::vector<mouse_motion_mapping*>> mouse_motion_mappings;
+	
+	/// Mouse wheel mappings, indexed by mouse wheel axis.
+	std::vector<std::vector<mouse_wheel_mapping*>> mouse_wheel_mappings;
+	
+	/// Mouse button mappings, indexed by mouse button.
+	std::vector<std::vector<mouse_button_mapping*>> mouse_button_mappings;
+	
+	/// Game controller axis mappings, indexed by game controller axis.
+	std::vector<std::vector<game_controller_axis_mapping*>> game_controller_axis_mappings;
+	
+	/// Game controller button mappings, indexed by game controller button.
+	std::vector<std::vector<game_controller_button_mapping*>> game_controller_button_mappings;
 };
 
 } // namespace input
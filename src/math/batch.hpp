@@ -0,0 +1,744 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ANTKEEPER_MATH_BATCH_HPP
+#define ANTKEEPER_MATH_BATCH_HPP
+
+#include "math/matrix-type.hpp"
+#include "math/quaternion-type.hpp"
+#include "math/transform-type.hpp"
+#include "math/quaternion-functions.hpp"
+#include "math/simd.hpp"
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+namespace math {
+
+/**
+ * @file batch.hpp
+ *
+ * Batch kernels over structure-of-arrays (SoA) vectors, quaternions, and transforms. Each component is stored in its own contiguous array, so that `float` kernels process four elements at a time with SSE or NEON instructions, `double` kernels two at a time with SSE2 or 64-bit NEON instructions, and the remainder one at a time.
+ */
+
+/// View of an SoA array of 3-component vectors.
+template <class T>
+struct vector3_soa
+{
+	T* x;
+	T* y;
+	T* z;
+};
+
+/// View of an SoA array of quaternions.
+template <class T>
+struct quaternion_soa
+{
+	T* w;
+	T* x;
+	T* y;
+	T* z;
+};
+
+/// View of an SoA array of transforms.
+template <class T>
+struct transform_soa
+{
+	vector3_soa<T> translation;
+	quaternion_soa<T> rotation;
+	vector3_soa<T> scale;
+};
+
+/**
+ * Storage for an SoA array of transforms.
+ *
+ * @tparam T Scalar type.
+ */
+template <class T>
+class transform_soa_buffer
+{
+public:
+	/// Number of scalars in each transform.
+	static constexpr std::size_t component_count = 10;
+	
+	/**
+	 * Resizes the buffer. Invalidates all views and existing elements.
+	 *
+	 * @param n Number of transforms.
+	 */
+	void resize(std::size_t n);
+	
+	/// Returns the number of transforms in the buffer.
+	std::size_t size() const;
+	
+	/// Returns a view of the transforms in the buffer.
+	transform_soa<T> view();
+	
+	/**
+	 * Copies an array of transforms into the buffer.
+	 *
+	 * @param first Pointer to the first of `size()` transforms.
+	 */
+	void load(const transform<T>* first);
+	
+	/**
+	 * Copies the transforms in the buffer into an array of transforms.
+	 *
+	 * @param first Pointer to the first of `size()` transforms.
+	 */
+	void store(transform<T>* first) const;
+	
+	/**
+	 * Copies a single transform into the buffer.
+	 *
+	 * @param i Index of the element.
+	 * @param t Transform to copy.
+	 */
+	void set(std::size_t i, const transform<T>& t);
+	
+	/**
+	 * Returns a single transform in the buffer.
+	 *
+	 * @param i Index of the element.
+	 */
+	transform<T> get(std::size_t i) const;
+
+private:
+	std::vector<T> components;
+	std::size_t count = 0;
+};
+
+/**
+ * Linearly interpolates between two arrays of vectors, `r[i] = x[i] + (y[i] - x[i]) * a`.
+ *
+ * @param x First array of vectors.
+ * @param y Second array of vectors.
+ * @param a Interpolation factor.
+ * @param r Array of interpolated vectors. May alias @p x or @p y.
+ * @param n Number of vectors.
+ */
+template <class T>
+void lerp_n(const vector3_soa<T>& x, const vector3_soa<T>& y, T a, const vector3_soa<T>& r, std::size_t n);
+
+/**
+ * Performs normalized linear interpolation between two arrays of quaternions, along the shortest path, like math::nlerp().
+ *
+ * @param x First array of quaternions.
+ * @param y Second array of quaternions.
+ * @param a Interpolation factor.
+ * @param r Array of interpolated quaternions. May alias @p x or @p y.
+ * @param n Number of quaternions.
+ */
+template <class T>
+void nlerp_n(const quaternion_soa<T>& x, const quaternion_soa<T>& y, T a, const quaternion_soa<T>& r, std::size_t n);
+
+/**
+ * Performs spherical linear interpolation between two arrays of quaternions, like math::slerp().
+ *
+ * Evaluated one element at a time, as the inverse cosine has no SIMD instruction. Prefer nlerp_n() for small angles, such as between consecutive ticks.
+ *
+ * @param x First array of quaternions.
+ * @param y Second array of quaternions.
+ * @param a Interpolation factor.
+ * @param r Array of interpolated quaternions. May alias @p x or @p y.
+ * @param n Number of quaternions.
+ */
+template <class T>
+void slerp_n(const quaternion_soa<T>& x, const quaternion_soa<T>& y, T a, const quaternion_soa<T>& r, std::size_t n);
+
+/**
+ * Interpolates between two arrays of transforms, lerping translations and scales and nlerping rotations.
+ *
+ * @param x First array of transforms.
+ * @param y Second array of transforms.
+ * @param a Interpolation factor.
+ * @param r Array of interpolated transforms. May alias @p x or @p y.
+ * @param n Number of transforms.
+ */
+template <class T>
+void transform_lerp_n(const transform_soa<T>& x, const transform_soa<T>& y, T a, const transform_soa<T>& r, std::size_t n);
+
+/**
+ * Composes two arrays of transforms, `r[i] = x[i] * y[i]`, like math::mul(const transform<T>&, const transform<T>&).
+ *
+ * @param x Array of parent transforms.
+ * @param y Array of child transforms.
+ * @param r Array of composed transforms. May alias @p x or @p y.
+ * @param n Number of transforms.
+ */
+template <class T>
+void transform_compose_n(const transform_soa<T>& x, const transform_soa<T>& y, const transform_soa<T>& r, std::size_t n);
+
+/**
+ * Converts an array of transforms to transformation matrices, like math::matrix_cast(const transform<T>&).
+ *
+ * @param t Array of transforms.
+ * @param r Array of transformation matrices.
+ * @param n Number of transforms.
+ */
+template <class T>
+void matrix_cast_n(const transform_soa<T>& t, matrix<T, 4, 4>* r, std::size_t n);
+
+/// @private
+namespace simd {
+
+/// Single lane of a batch, for scalar types without SIMD instructions and batch remainders.
+template <class T>
+struct scalar_lanes
+{
+	typedef bool mask_type;
+	static constexpr std::size_t width = 1;
+	
+	static inline scalar_lanes load(const T* x) { return {*x}; }
+	static inline scalar_lanes broadcast(T x) { return {x}; }
+	static inline scalar_lanes select(mask_type mask, scalar_lanes a, scalar_lanes b) { return (mask) ? a : b; }
+	static inline scalar_lanes rsqrt(scalar_lanes x) { return {T(1) / std::sqrt(x.value)}; }
+	static inline scalar_lanes sqrt(scalar_lanes x) { return {std::sqrt(x.value)}; }
+	static inline scalar_lanes min(scalar_lanes a, scalar_lanes b) { return {(b.value < a.value) ? b.value : a.value}; }
+	static inline scalar_lanes max(scalar_lanes a, scalar_lanes b) { return {(a.value < b.value) ? b.value : a.value}; }
+	static inline unsigned bits(mask_type mask) { return (mask) ? 1u : 0u; }
+	inline void store(T* x) const { *x = value; }
+	
+	T value;
+};
+
+template <class T> inline scalar_lanes<T> operator+(scalar_lanes<T> a, scalar_lanes<T> b) { return {a.value + b.value}; }
+template <class T> inline scalar_lanes<T> operator-(scalar_lanes<T> a, scalar_lanes<T> b) { return {a.value - b.value}; }
+template <class T> inline scalar_lanes<T> operator-(scalar_lanes<T> a) { return {-a.value}; }
+template <class T> inline scalar_lanes<T> operator*(scalar_lanes<T> a, scalar_lanes<T> b) { return {a.value * b.value}; }
+template <class T> inline scalar_lanes<T> operator/(scalar_lanes<T> a, scalar_lanes<T> b) { return {a.value / b.value}; }
+template <class T> inline bool operator<(scalar_lanes<T> a, scalar_lanes<T> b) { return a.value < b.value; }
+
+#if defined(ANTKEEPER_MATH_SSE)
+/// Four lanes of a batch, processed with SSE instructions.
+struct sse_lanes
+{
+	typedef sse_lanes mask_type;
+	static constexpr std::size_t width = 4;
+	
+	static inline sse_lanes load(const float* x) { return {_mm_loadu_ps(x)}; }
+	static inline sse_lanes broadcast(float x) { return {_mm_set1_ps(x)}; }
+	static inline sse_lanes select(mask_type mask, sse_lanes a, sse_lanes b) { return {_mm_or_ps(_mm_and_ps(mask.value, a.value), _mm_andnot_ps(mask.value, b.value))}; }
+	static inline sse_lanes rsqrt(sse_lanes x) { return {_mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(x.value))}; }
+	static inline sse_lanes sqrt(sse_lanes x) { return {_mm_sqrt_ps(x.value)}; }
+	static inline sse_lanes min(sse_lanes a, sse_lanes b) { return {_mm_min_ps(a.value, b.value)}; }
+	static inline sse_lanes max(sse_lanes a, sse_lanes b) { return {_mm_max_ps(a.value, b.value)}; }
+	static inline unsigned bits(mask_type mask) { return static_cast<unsigned>(_mm_movemask_ps(mask.value)); }
+	inline void store(float* x) const { _mm_storeu_ps(x, value); }
+	
+	__m128 value;
+};
+
+inline sse_lanes operator+(sse_lanes a, sse_lanes b) { return {_mm_add_ps(a.value, b.value)}; }
+inline sse_lanes operator-(sse_lanes a, sse_lanes b) { return {_mm_sub_ps(a.value, b.value)}; }
+inline sse_lanes operator-(sse_lanes a) { return {_mm_xor_ps(a.value, _mm_set1_ps(-0.0f))}; }
+inline sse_lanes operator*(sse_lanes a, sse_lanes b) { return {_mm_mul_ps(a.value, b.value)}; }
+inline sse_lanes operator/(sse_lanes a, sse_lanes b) { return {_mm_div_ps(a.value, b.value)}; }
+inline sse_lanes operator<(sse_lanes a, sse_lanes b) { return {_mm_cmplt_ps(a.value, b.value)}; }
+
+typedef sse_lanes float_lanes;
+#elif defined(ANTKEEPER_MATH_NEON)
+/// Four lanes of a batch, processed with NEON instructions.
+struct neon_lanes
+{
+	typedef uint32x4_t mask_type;
+	static constexpr std::size_t width = 4;
+	
+	static inline neon_lanes load(const float* x) { return {vld1q_f32(x)}; }
+	static inline neon_lanes broadcast(float x) { return {vdupq_n_f32(x)}; }
+	static inline neon_lanes select(mask_type mask, neon_lanes a, neon_lanes b) { return {vbslq_f32(mask, a.value, b.value)}; }
+	static inline neon_lanes rsqrt(neon_lanes x)
+	{
+		// Refine the reciprocal square root estimate with two Newton-Raphson steps
+		float32x4_t e = vrsqrteq_f32(x.value);
+		e = vmulq_f32(e, vrsqrtsq_f32(vmulq_f32(x.value, e), e));
+		e = vmulq_f32(e, vrsqrtsq_f32(vmulq_f32(x.value, e), e));
+		return {e};
+	}
+	static inline neon_lanes sqrt(neon_lanes x)
+	{
+	#if defined(__aarch64__)
+		return {vsqrtq_f32(x.value)};
+	#else
+		// Multiply by the reciprocal square root, which is infinite at zero
+		return select(vceqq_f32(x.value, vdupq_n_f32(0.0f)), x, {vmulq_f32(x.value, rsqrt(x).value)});
+	#endif
+	}
+	static inline neon_lanes min(neon_lanes a, neon_lanes b) { return {vminq_f32(a.value, b.value)}; }
+	static inline neon_lanes max(neon_lanes a, neon_lanes b) { return {vmaxq_f32(a.value, b.value)}; }
+	static inline unsigned bits(mask_type mask)
+	{
+		const uint32x4_t b = vshrq_n_u32(mask, 31);
+		return vgetq_lane_u32(b, 0) | (vgetq_lane_u32(b, 1) << 1) | (vgetq_lane_u32(b, 2) << 2) | (vgetq_lane_u32(b, 3) << 3);
+	}
+	inline void store(float* x) const { vst1q_f32(x, value); }
+	
+	float32x4_t value;
+};
+
+inline neon_lanes operator+(neon_lanes a, neon_lanes b) { return {vaddq_f32(a.value, b.value)}; }
+inline neon_lanes operator-(neon_lanes a, neon_lanes b) { return {vsubq_f32(a.value, b.value)}; }
+inline neon_lanes operator-(neon_lanes a) { return {vnegq_f32(a.value)}; }
+inline neon_lanes operator*(neon_lanes a, neon_lanes b) { return {vmulq_f32(a.value, b.value)}; }
+inline neon_lanes operator/(neon_lanes a, neon_lanes b)
+{
+	// Refine the reciprocal estimate with two Newton-Raphson steps
+	float32x4_t e = vrecpeq_f32(b.value);
+	e = vmulq_f32(e, vrecpsq_f32(b.value, e));
+	e = vmulq_f32(e, vrecpsq_f32(b.value, e));
+	return {vmulq_f32(a.value, e)};
+}
+inline uint32x4_t operator<(neon_lanes a, neon_lanes b) { return vcltq_f32(a.value, b.value); }
+
+typedef neon_lanes float_lanes;
+#endif
+
+#if defined(ANTKEEPER_MATH_SSE2)
+/// Two lanes of a `double` batch, processed with SSE2 instructions.
+struct sse2_lanes
+{
+	typedef sse2_lanes mask_type;
+	static constexpr std::size_t width = 2;
+	
+	static inline sse2_lanes load(const double* x) { return {_mm_loadu_pd(x)}; }
+	static inline sse2_lanes broadcast(double x) { return {_mm_set1_pd(x)}; }
+	static inline sse2_lanes select(mask_type mask, sse2_lanes a, sse2_lanes b) { return {_mm_or_pd(_mm_and_pd(mask.value, a.value), _mm_andnot_pd(mask.value, b.value))}; }
+	static inline sse2_lanes rsqrt(sse2_lanes x) { return {_mm_div_pd(_mm_set1_pd(1.0), _mm_sqrt_pd(x.value))}; }
+	static inline sse2_lanes sqrt(sse2_lanes x) { return {_mm_sqrt_pd(x.value)}; }
+	static inline sse2_lanes min(sse2_lanes a, sse2_lanes b) { return {_mm_min_pd(a.value, b.value)}; }
+	static inline sse2_lanes max(sse2_lanes a, sse2_lanes b) { return {_mm_max_pd(a.value, b.value)}; }
+	static inline unsigned bits(mask_type mask) { return static_cast<unsigned>(_mm_movemask_pd(mask.value)); }
+	inline void store(double* x) const { _mm_storeu_pd(x, value); }
+	
+	__m128d value;
+};
+
+inline sse2_lanes operator+(sse2_lanes a, sse2_lanes b) { return {_mm_add_pd(a.value, b.value)}; }
+inline sse2_lanes operator-(sse2_lanes a, sse2_lanes b) { return {_mm_sub_pd(a.value, b.value)}; }
+inline sse2_lanes operator-(sse2_lanes a) { return {_mm_xor_pd(a.value, _mm_set1_pd(-0.0))}; }
+inline sse2_lanes operator*(sse2_lanes a, sse2_lanes b) { return {_mm_mul_pd(a.value, b.value)}; }
+inline sse2_lanes operator/(sse2_lanes a, sse2_lanes b) { return {_mm_div_pd(a.value, b.value)}; }
+inline sse2_lanes operator<(sse2_lanes a, sse2_lanes b) { return {_mm_cmplt_pd(a.value, b.value)}; }
+
+typedef sse2_lanes double_lanes;
+#elif defined(ANTKEEPER_MATH_NEON) && defined(__aarch64__)
+/// Two lanes of a `double` batch, processed with 64-bit NEON instructions.
+struct neon_double_lanes
+{
+	typedef uint64x2_t mask_type;
+	static constexpr std::size_t width = 2;
+	
+	static inline neon_double_lanes load(const double* x) { return {vld1q_f64(x)}; }
+	static inline neon_double_lanes broadcast(double x) { return {vdupq_n_f64(x)}; }
+	static inline neon_double_lanes select(mask_type mask, neon_double_lanes a, neon_double_lanes b) { return {vbslq_f64(mask, a.value, b.value)}; }
+	static inline neon_double_lanes rsqrt(neon_double_lanes x) { return {vdivq_f64(vdupq_n_f64(1.0), vsqrtq_f64(x.value))}; }
+	static inline neon_double_lanes sqrt(neon_double_lanes x) { return {vsqrtq_f64(x.value)}; }
+	static inline neon_double_lanes min(neon_double_lanes a, neon_double_lanes b) { return {vminq_f64(a.value, b.value)}; }
+	static inline neon_double_lanes max(neon_double_lanes a, neon_double_lanes b) { return {vmaxq_f64(a.value, b.value)}; }
+	static inline unsigned bits(mask_type mask) { return static_cast<unsigned>((vgetq_lane_u64(mask, 0) & 1) | ((vgetq_lane_u64(mask, 1) & 1) << 1)); }
+	inline void store(double* x) const { vst1q_f64(x, value); }
+	
+	float64x2_t value;
+};
+
+inline neon_double_lanes operator+(neon_double_lanes a, neon_double_lanes b) { return {vaddq_f64(a.value, b.value)}; }
+inline neon_double_lanes operator-(neon_double_lanes a, neon_double_lanes b) { return {vsubq_f64(a.value, b.value)}; }
+inline neon_double_lanes operator-(neon_double_lanes a) { return {vnegq_f64(a.value)}; }
+inline neon_double_lanes operator*(neon_double_lanes a, neon_double_lanes b) { return {vmulq_f64(a.value, b.value)}; }
+inline neon_double_lanes operator/(neon_double_lanes a, neon_double_lanes b) { return {vdivq_f64(a.value, b.value)}; }
+inline uint64x2_t operator<(neon_double_lanes a, neon_double_lanes b) { return vcltq_f64(a.value, b.value); }
+
+typedef neon_double_lanes double_lanes;
+#endif
+
+/// Widest lane type available for a scalar type.
+template <class T>
+struct widest_lanes
+{
+	typedef scalar_lanes<T> type;
+};
+
+#if defined(ANTKEEPER_MATH_SSE) || defined(ANTKEEPER_MATH_NEON)
+template <>
+struct widest_lanes<float>
+{
+	typedef float_lanes type;
+};
+#endif
+
+#if defined(ANTKEEPER_MATH_SSE2) || (defined(ANTKEEPER_MATH_NEON) && defined(__aarch64__))
+template <>
+struct widest_lanes<double>
+{
+	typedef double_lanes type;
+};
+#endif
+
+/**
+ * Invokes a batch kernel on consecutive groups of elements, using the widest lane type available for each group.
+ *
+ * @param n Number of elements.
+ * @param kernel Generic function object with the signature `void(L, std::size_t)`, where `L` is a lane type and the second argument is the index of the first element in the group.
+ */
+template <class T, class Kernel>
+inline void dispatch_lanes(std::size_t n, Kernel&& kernel)
+{
+	typedef typename widest_lanes<T>::type wide_type;
+	
+	std::size_t i = 0;
+	if constexpr (wide_type::width > 1)
+	{
+		for (; i + wide_type::width <= n; i += wide_type::width)
+			kernel(wide_type{}, i);
+	}
+	for (; i < n; ++i)
+		kernel(scalar_lanes<T>{}, i);
+}
+
+/// Loads lanes of the components of a vector array.
+template <class L, class T>
+inline void load(const vector3_soa<T>& v, std::size_t i, L* r)
+{
+	r[0] = L::load(v.x + i);
+	r[1] = L::load(v.y + i);
+	r[2] = L::load(v.z + i);
+}
+
+/// Stores lanes of the components of a vector array.
+template <class L, class T>
+inline void store(const vector3_soa<T>& v, std::size_t i, const L* x)
+{
+	x[0].store(v.x + i);
+	x[1].store(v.y + i);
+	x[2].store(v.z + i);
+}
+
+/// Loads lanes of the components of a quaternion array.
+template <class L, class T>
+inline void load(const quaternion_soa<T>& q, std::size_t i, L* r)
+{
+	r[0] = L::load(q.w + i);
+	r[1] = L::load(q.x + i);
+	r[2] = L::load(q.y + i);
+	r[3] = L::load(q.z + i);
+}
+
+/// Stores lanes of the components of a quaternion array.
+template <class L, class T>
+inline void store(const quaternion_soa<T>& q, std::size_t i, const L* x)
+{
+	x[0].store(q.w + i);
+	x[1].store(q.x + i);
+	x[2].store(q.y + i);
+	x[3].store(q.z + i);
+}
+
+/// Lerps lanes of vectors.
+template <class L>
+inline void lerp_lanes(const L* x, const L* y, L a, L* r)
+{
+	for (std::size_t c = 0; c < 3; ++c)
+		r[c] = x[c] + (y[c] - x[c]) * a;
+}
+
+/// Normalizes lanes of quaternions.
+template <class L>
+inline void normalize_lanes(L* q)
+{
+	const L s = L::rsqrt(q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3]);
+	for (std::size_t c = 0; c < 4; ++c)
+		q[c] = q[c] * s;
+}
+
+/// Nlerps lanes of quaternions along the shortest path.
+template <class L>
+inline void nlerp_lanes(const L* x, const L* y, L a, L* r)
+{
+	const L zero = L::broadcast(0);
+	const L d = x[0] * y[0] + x[1] * y[1] + x[2] * y[2] + x[3] * y[3];
+	const L b = L::select(d < zero, -a, a);
+	const L c = L::broadcast(1) - a;
+	
+	for (std::size_t i = 0; i < 4; ++i)
+		r[i] = x[i] * c + y[i] * b;
+	normalize_lanes(r);
+}
+
+/**
+ * Evaluates the sine and cosine of lanes on `[-1, 1]` with their Taylor polynomials of degrees 13 and 14, which are accurate to within 1e-12 on that interval.
+ *
+ * @param x Lanes of angles, in radians.
+ * @param[out] s Lanes of the sines of @p x.
+ * @param[out] c Lanes of the cosines of @p x.
+ */
+template <class L>
+inline void sin_cos_lanes(L x, L& s, L& c)
+{
+	const L one = L::broadcast(1);
+	const L xx = x * x;
+	
+	s = one - xx * L::broadcast(1.0 / 156.0);
+	s = one - xx * L::broadcast(1.0 / 110.0) * s;
+	s = one - xx * L::broadcast(1.0 / 72.0) * s;
+	s = one - xx * L::broadcast(1.0 / 42.0) * s;
+	s = one - xx * L::broadcast(1.0 / 20.0) * s;
+	s = one - xx * L::broadcast(1.0 / 6.0) * s;
+	s = x * s;
+	
+	c = one - xx * L::broadcast(1.0 / 182.0);
+	c = one - xx * L::broadcast(1.0 / 132.0) * c;
+	c = one - xx * L::broadcast(1.0 / 90.0) * c;
+	c = one - xx * L::broadcast(1.0 / 56.0) * c;
+	c = one - xx * L::broadcast(1.0 / 30.0) * c;
+	c = one - xx * L::broadcast(1.0 / 12.0) * c;
+	c = one - xx * L::broadcast(1.0 / 2.0) * c;
+}
+
+} // namespace simd
+
+template <class T>
+void transform_soa_buffer<T>::resize(std::size_t n)
+{
+	components.resize(n * component_count);
+	count = n;
+}
+
+template <class T>
+inline std::size_t transform_soa_buffer<T>::size() const
+{
+	return count;
+}
+
+template <class T>
+transform_soa<T> transform_soa_buffer<T>::view()
+{
+	T* p = components.data();
+	const std::size_t n = count;
+	return
+		{
+			{p, p + n, p + n * 2},
+			{p + n * 3, p + n * 4, p + n * 5, p + n * 6},
+			{p + n * 7, p + n * 8, p + n * 9}
+		};
+}
+
+template <class T>
+void transform_soa_buffer<T>::load(const transform<T>* first)
+{
+	for (std::size_t i = 0; i < count; ++i)
+		set(i, first[i]);
+}
+
+template <class T>
+void transform_soa_buffer<T>::store(transform<T>* first) const
+{
+	for (std::size_t i = 0; i < count; ++i)
+		first[i] = get(i);
+}
+
+template <class T>
+inline void transform_soa_buffer<T>::set(std::size_t i, const transform<T>& t)
+{
+	T* p = components.data() + i;
+	const std::size_t n = count;
+	p[0] = t.translation[0];
+	p[n] = t.translation[1];
+	p[n * 2] = t.translation[2];
+	p[n * 3] = t.rotation.w;
+	p[n * 4] = t.rotation.x;
+	p[n * 5] = t.rotation.y;
+	p[n * 6] = t.rotation.z;
+	p[n * 7] = t.scale[0];
+	p[n * 8] = t.scale[1];
+	p[n * 9] = t.scale[2];
+}
+
+template <class T>
+inline transform<T> transform_soa_buffer<T>::get(std::size_t i) const
+{
+	const T* p = components.data() + i;
+	const std::size_t n = count;
+	return
+		{
+			{p[0], p[n], p[n * 2]},
+			{p[n * 3], p[n * 4], p[n * 5], p[n * 6]},
+			{p[n * 7], p[n * 8], p[n * 9]}
+		};
+}
+
+template <class T>
+void lerp_n(const vector3_soa<T>& x, const vector3_soa<T>& y, T a, const vector3_soa<T>& r, std::size_t n)
+{
+	simd::dispatch_lanes<T>(n, [&](auto lanes, std::size_t i)
+	{
+		typedef decltype(lanes) L;
+		L vx[3], vy[3], vr[3];
+		simd::load(x, i, vx);
+		simd::load(y, i, vy);
+		simd::lerp_lanes(vx, vy, L::broadcast(a), vr);
+		simd::store(r, i, vr);
+	});
+}
+
+template <class T>
+void nlerp_n(const quaternion_soa<T>& x, const quaternion_soa<T>& y, T a, const quaternion_soa<T>& r, std::size_t n)
+{
+	simd::dispatch_lanes<T>(n, [&](auto lanes, std::size_t i)
+	{
+		typedef decltype(lanes) L;
+		L qx[4], qy[4], qr[4];
+		simd::load(x, i, qx);
+		simd::load(y, i, qy);
+		simd::nlerp_lanes(qx, qy, L::broadcast(a), qr);
+		simd::store(r, i, qr);
+	});
+}
+
+template <class T>
+void slerp_n(const quaternion_soa<T>& x, const quaternion_soa<T>& y, T a, const quaternion_soa<T>& r, std::size_t n)
+{
+	for (std::size_t i = 0; i < n; ++i)
+	{
+		const quaternion<T> q = slerp(quaternion<T>{x.w[i], x.x[i], x.y[i], x.z[i]}, quaternion<T>{y.w[i], y.x[i], y.y[i], y.z[i]}, a);
+		r.w[i] = q.w;
+		r.x[i] = q.x;
+		r.y[i] = q.y;
+		r.z[i] = q.z;
+	}
+}
+
+template <class T>
+void transform_lerp_n(const transform_soa<T>& x, const transform_soa<T>& y, T a, const transform_soa<T>& r, std::size_t n)
+{
+	simd::dispatch_lanes<T>(n, [&](auto lanes, std::size_t i)
+	{
+		typedef decltype(lanes) L;
+		const L b = L::broadcast(a);
+		L vx[4], vy[4], vr[4];
+		
+		simd::load(x.translation, i, vx);
+		simd::load(y.translation, i, vy);
+		simd::lerp_lanes(vx, vy, b, vr);
+		simd::store(r.translation, i, vr);
+		
+		simd::load(x.rotation, i, vx);
+		simd::load(y.rotation, i, vy);
+		simd::nlerp_lanes(vx, vy, b, vr);
+		simd::store(r.rotation, i, vr);
+		
+		simd::load(x.scale, i, vx);
+		simd::load(y.scale, i, vy);
+		simd::lerp_lanes(vx, vy, b, vr);
+		simd::store(r.scale, i, vr);
+	});
+}
+
+template <class T>
+void transform_compose_n(const transform_soa<T>& x, const transform_soa<T>& y, const transform_soa<T>& r, std::size_t n)
+{
+	simd::dispatch_lanes<T>(n, [&](auto lanes, std::size_t i)
+	{
+		typedef decltype(lanes) L;
+		const L two = L::broadcast(2);
+		L xt[3], xq[4], xs[3], yt[3], yq[4], ys[3];
+		simd::load(x.translation, i, xt);
+		simd::load(x.rotation, i, xq);
+		simd::load(x.scale, i, xs);
+		simd::load(y.translation, i, yt);
+		simd::load(y.rotation, i, yq);
+		simd::load(y.scale, i, ys);
+		
+		// Scale child translation by parent scale
+		const L v[3] = {yt[0] * xs[0], yt[1] * xs[1], yt[2] * xs[2]};
+		
+		// Rotate by parent rotation, v' = v + w * u + q.xyz x u, where u = 2 * (q.xyz x v)
+		const L u[3] =
+		{
+			(xq[2] * v[2] - xq[3] * v[1]) * two,
+			(xq[3] * v[0] - xq[1] * v[2]) * two,
+			(xq[1] * v[1] - xq[2] * v[0]) * two
+		};
+		const L rt[3] =
+		{
+			xt[0] + v[0] + xq[0] * u[0] + (xq[2] * u[2] - xq[3] * u[1]),
+			xt[1] + v[1] + xq[0] * u[1] + (xq[3] * u[0] - xq[1] * u[2]),
+			xt[2] + v[2] + xq[0] * u[2] + (xq[1] * u[1] - xq[2] * u[0])
+		};
+		
+		// Compose rotations
+		L rq[4] =
+		{
+			xq[0] * yq[0] - xq[1] * yq[1] - xq[2] * yq[2] - xq[3] * yq[3],
+			xq[0] * yq[1] + xq[1] * yq[0] + xq[2] * yq[3] - xq[3] * yq[2],
+			xq[0] * yq[2] - xq[1] * yq[3] + xq[2] * yq[0] + xq[3] * yq[1],
+			xq[0] * yq[3] + xq[1] * yq[2] - xq[2] * yq[1] + xq[3] * yq[0]
+		};
+		simd::normalize_lanes(rq);
+		
+		// Compose scales
+		const L rs[3] = {xs[0] * ys[0], xs[1] * ys[1], xs[2] * ys[2]};
+		
+		simd::store(r.translation, i, rt);
+		simd::store(r.rotation, i, rq);
+		simd::store(r.scale, i, rs);
+	});
+}
+
+template <class T>
+void matrix_cast_n(const transform_soa<T>& t, matrix<T, 4, 4>* r, std::size_t n)
+{
+	simd::dispatch_lanes<T>(n, [&](auto lanes, std::size_t i)
+	{
+		typedef decltype(lanes) L;
+		const L one = L::broadcast(1);
+		const L two = L::broadcast(2);
+		L tt[3], q[4], s[3];
+		simd::load(t.translation, i, tt);
+		simd::load(t.rotation, i, q);
+		simd::load(t.scale, i, s);
+		
+		const L wx = q[0] * q[1], wy = q[0] * q[2], wz = q[0] * q[3];
+		const L xx = q[1] * q[1], xy = q[1] * q[2], xz = q[1] * q[3];
+		const L yy = q[2] * q[2], yz = q[2] * q[3], zz = q[3] * q[3];
+		
+		// Columns of the rotation matrix scaled by the scale, then the translation
+		const L m[12] =
+		{
+			(one - (yy + zz) * two) * s[0], (xy + wz) * two * s[0], (xz - wy) * two * s[0],
+			(xy - wz) * two * s[1], (one - (xx + zz) * two) * s[1], (yz + wx) * two * s[1],
+			(xz + wy) * two * s[2], (yz - wx) * two * s[2], (one - (xx + yy) * two) * s[2],
+			tt[0], tt[1], tt[2]
+		};
+		
+		// Transpose lanes into matrices
+		T elements[12][L::width];
+		for (std::size_t e = 0; e < 12; ++e)
+			m[e].store(elements[e]);
+		for (std::size_t j = 0; j < L::width; ++j)
+		{
+			matrix<T, 4, 4>& result = r[i + j];
+			for (std::size_t c = 0; c < 4; ++c)
+				result[c] = {elements[c * 3][j], elements[c * 3 + 1][j], elements[c * 3 + 2][j], (c == 3) ? T(1) : T(0)};
+		}
+	});
+}
+
+} // namespace math
+
+#endif // ANTKEEPER_MATH_BATCH_HPP
@@ -933,6 +933,187 @@ matrix<T2, N, M> type_cast(const matrix<T1, N, M>& m)
 	return type_cast<T2>(m, std::make_index_sequence<N>{}); 
 }
 
+#if defined(ANTKEEPER_MATH_SSE) || defined(ANTKEEPER_MATH_NEON)
+
+/// @private
+namespace simd {
+
+/// Returns the linear combination of the columns of @p m weighted by the components of @p v.
+inline float4_type mul_columns(const float4_type* m, const vector<float, 4>& v)
+{
+	#if defined(ANTKEEPER_MATH_SSE)
+		const float4_type x = load(v);
+		float4_type result = _mm_mul_ps(m[0], _mm_shuffle_ps(x, x, _MM_SHUFFLE(0, 0, 0, 0)));
+		result = _mm_add_ps(result, _mm_mul_ps(m[1], _mm_shuffle_ps(x, x, _MM_SHUFFLE(1, 1, 1, 1))));
+		result = _mm_add_ps(result, _mm_mul_ps(m[2], _mm_shuffle_ps(x, x, _MM_SHUFFLE(2, 2, 2, 2))));
+		return _mm_add_ps(result, _mm_mul_ps(m[3], _mm_shuffle_ps(x, x, _MM_SHUFFLE(3, 3, 3, 3))));
+	#else
+		float4_type result = vmulq_n_f32(m[0], v[0]);
+		result = vmlaq_n_f32(result, m[1], v[1]);
+		result = vmlaq_n_f32(result, m[2], v[2]);
+		return vmlaq_n_f32(result, m[3], v[3]);
+	#endif
+}
+
+/// Loads the four columns of a matrix.
+inline void load_columns(const matrix<float, 4, 4>& m, float4_type* columns)
+{
+	columns[0] = load(m[0]);
+	columns[1] = load(m[1]);
+	columns[2] = load(m[2]);
+	columns[3] = load(m[3]);
+}
+
+} // namespace simd
+
+template <>
+inline matrix<float, 4, 4> mul<float>(const matrix<float, 4, 4>& x, const matrix<float, 4, 4>& y)
+{
+	simd::float4_type columns[4];
+	simd::load_columns(x, columns);
+	
+	matrix<float, 4, 4> result;
+	simd::store(result[0], simd::mul_columns(columns, y[0]));
+	simd::store(result[1], simd::mul_columns(columns, y[1]));
+	simd::store(result[2], simd::mul_columns(columns, y[2]));
+	simd::store(result[3], simd::mul_columns(columns, y[3]));
+	return result;
+}
+
+template <>
+inline vector<float, 4> mul<float>(const matrix<float, 4, 4>& m, const vector<float, 4>& v)
+{
+	simd::float4_type columns[4];
+	simd::load_columns(m, columns);
+	
+	vector<float, 4> result;
+	simd::store(result, simd::mul_columns(columns, v));
+	return result;
+}
+
+template <>
+inline matrix<float, 4, 4> transpose<float>(const matrix<float, 4, 4>& m)
+{
+	matrix<float, 4, 4> result;
+	
+	#if defined(ANTKEEPER_MATH_SSE)
+		simd::float4_type c0 = simd::load(m[0]);
+		simd::float4_type c1 = simd::load(m[1]);
+		simd::float4_type c2 = simd::load(m[2]);
+		simd::float4_type c3 = simd::load(m[3]);
+		_MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+		simd::store(result[0], c0);
+		simd::store(result[1], c1);
+		simd::store(result[2], c2);
+		simd::store(result[3], c3);
+	#else
+		// De-interleaving load of the column-major elements yields the rows
+		const float32x4x4_t rows = vld4q_f32(&m[0][0]);
+		simd::store(result[0], rows.val[0]);
+		simd::store(result[1], rows.val[1]);
+		simd::store(result[2], rows.val[2]);
+		simd::store(result[3], rows.val[3]);
+	#endif
+	
+	return result;
+}
+
+#if defined(ANTKEEPER_MATH_SSE)
+
+/// @private
+namespace simd {
+
+/// Shuffles the lanes of @p x.
+#define ANTKEEPER_MATH_SWIZZLE(x, a, b, c, d) _mm_shuffle_ps((x), (x), _MM_SHUFFLE(d, c, b, a))
+
+/// Multiplies two 2x2 matrices, each packed into a register as `(m00, m01, m10, m11)`.
+inline __m128 mul_2x2(__m128 x, __m128 y)
+{
+	return _mm_add_ps(_mm_mul_ps(x, ANTKEEPER_MATH_SWIZZLE(y, 0, 3, 0, 3)), _mm_mul_ps(ANTKEEPER_MATH_SWIZZLE(x, 1, 0, 3, 2), ANTKEEPER_MATH_SWIZZLE(y, 2, 1, 2, 1)));
+}
+
+/// Multiplies the adjugate of a packed 2x2 matrix @p x by a packed 2x2 matrix @p y.
+inline __m128 adj_mul_2x2(__m128 x, __m128 y)
+{
+	return _mm_sub_ps(_mm_mul_ps(ANTKEEPER_MATH_SWIZZLE(x, 3, 3, 0, 0), y), _mm_mul_ps(ANTKEEPER_MATH_SWIZZLE(x, 1, 1, 2, 2), ANTKEEPER_MATH_SWIZZLE(y, 2, 3, 0, 1)));
+}
+
+/// Multiplies a packed 2x2 matrix @p x by the adjugate of a packed 2x2 matrix @p y.
+inline __m128 mul_adj_2x2(__m128 x, __m128 y)
+{
+	return _mm_sub_ps(_mm_mul_ps(x, ANTKEEPER_MATH_SWIZZLE(y, 3, 0, 3, 0)), _mm_mul_ps(ANTKEEPER_MATH_SWIZZLE(x, 1, 0, 3, 2), ANTKEEPER_MATH_SWIZZLE(y, 2, 1, 2, 1)));
+}
+
+} // namespace simd
+
+/**
+ * Inverts a 4x4 matrix by blockwise inversion of its four 2x2 submatrices.
+ *
+ * The same expressions invert a row-major matrix, so they are applied to the columns as if they were rows.
+ */
+template <>
+inline matrix<float, 4, 4> inverse<float>(const matrix<float, 4, 4>& m)
+{
+	const __m128 c0 = simd::load(m[0]);
+	const __m128 c1 = simd::load(m[1]);
+	const __m128 c2 = simd::load(m[2]);
+	const __m128 c3 = simd::load(m[3]);
+	
+	// 2x2 submatrices
+	const __m128 a = _mm_movelh_ps(c0, c1);
+	const __m128 b = _mm_movehl_ps(c1, c0);
+	const __m128 c = _mm_movelh_ps(c2, c3);
+	const __m128 d = _mm_movehl_ps(c3, c2);
+	
+	// Determinants of the submatrices, as (|a|, |b|, |c|, |d|)
+	const __m128 det_sub = _mm_sub_ps
+	(
+		_mm_mul_ps(_mm_shuffle_ps(c0, c2, _MM_SHUFFLE(2, 0, 2, 0)), _mm_shuffle_ps(c1, c3, _MM_SHUFFLE(3, 1, 3, 1))),
+		_mm_mul_ps(_mm_shuffle_ps(c0, c2, _MM_SHUFFLE(3, 1, 3, 1)), _mm_shuffle_ps(c1, c3, _MM_SHUFFLE(2, 0, 2, 0)))
+	);
+	const __m128 det_a = ANTKEEPER_MATH_SWIZZLE(det_sub, 0, 0, 0, 0);
+	const __m128 det_b = ANTKEEPER_MATH_SWIZZLE(det_sub, 1, 1, 1, 1);
+	const __m128 det_c = ANTKEEPER_MATH_SWIZZLE(det_sub, 2, 2, 2, 2);
+	const __m128 det_d = ANTKEEPER_MATH_SWIZZLE(det_sub, 3, 3, 3, 3);
+	
+	const __m128 d_c = simd::adj_mul_2x2(d, c);
+	const __m128 a_b = simd::adj_mul_2x2(a, b);
+	
+	// Adjugates of the blocks of the inverse
+	__m128 x = _mm_sub_ps(_mm_mul_ps(det_d, a), simd::mul_2x2(b, d_c));
+	__m128 w = _mm_sub_ps(_mm_mul_ps(det_a, d), simd::mul_2x2(c, a_b));
+	__m128 y = _mm_sub_ps(_mm_mul_ps(det_b, c), simd::mul_adj_2x2(d, a_b));
+	__m128 z = _mm_sub_ps(_mm_mul_ps(det_c, b), simd::mul_adj_2x2(a, d_c));
+	
+	// Determinant of the matrix, |a||d| + |b||c| - tr(a_b * d_c)
+	__m128 trace = _mm_mul_ps(a_b, ANTKEEPER_MATH_SWIZZLE(d_c, 0, 2, 1, 3));
+	trace = _mm_add_ps(trace, _mm_movehl_ps(trace, trace));
+	trace = _mm_add_ps(trace, ANTKEEPER_MATH_SWIZZLE(trace, 1, 0, 1, 0));
+	trace = ANTKEEPER_MATH_SWIZZLE(trace, 0, 0, 0, 0);
+	const __m128 det = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(det_a, det_d), _mm_mul_ps(det_b, det_c)), trace);
+	
+	// Scale blocks by the reciprocal determinant, with the signs of the adjugate
+	const __m128 rd = _mm_div_ps(_mm_setr_ps(1.0f, -1.0f, -1.0f, 1.0f), det);
+	x = _mm_mul_ps(x, rd);
+	y = _mm_mul_ps(y, rd);
+	z = _mm_mul_ps(z, rd);
+	w = _mm_mul_ps(w, rd);
+	
+	// Transpose the blocks into their adjugates while storing
+	matrix<float, 4, 4> result;
+	simd::store(result[0], _mm_shuffle_ps(x, y, _MM_SHUFFLE(1, 3, 1, 3)));
+	simd::store(result[1], _mm_shuffle_ps(x, y, _MM_SHUFFLE(0, 2, 0, 2)));
+	simd::store(result[2], _mm_shuffle_ps(z, w, _MM_SHUFFLE(1, 3, 1, 3)));
+	simd::store(result[3], _mm_shuffle_ps(z, w, _MM_SHUFFLE(0, 2, 0, 2)));
+	return result;
+}
+
+#undef ANTKEEPER_MATH_SWIZZLE
+
+#endif // ANTKEEPER_MATH_SSE
+
+#endif // ANTKEEPER_MATH_SSE || ANTKEEPER_MATH_NEON
+
 } // namespace math
 
 #endif // ANTKEEPER_MATH_MATRIX_FUNCTIONS_HPP
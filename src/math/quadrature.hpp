@@ -20,6 +20,8 @@
 #ifndef ANTKEEPER_MATH_QUADRATURE_HPP
 #define ANTKEEPER_MATH_QUADRATURE_HPP
 
+#include <array>
+#include <cstddef>
 #include <iterator>
 #include <type_traits>
 
@@ -54,6 +56,127 @@ template<class UnaryOp, class InputIt>
 typename std::invoke_result<UnaryOp, typename std::iterator_traits<InputIt>::value_type>::type
 	trapezoid(UnaryOp f, InputIt first, InputIt last);
 
+/**
+ * Nodes and weights of an N-point Gauss-Legendre quadrature rule on `[-1, 1]`.
+ *
+ * Nodes are the roots of the Legendre polynomial of degree N, found at compile time by Newton's method, in ascending order. An N-point rule integrates polynomials of degree up to `2N - 1` exactly.
+ *
+ * @tparam N Number of nodes.
+ * @tparam T Scalar type.
+ *
+ * @see https://en.wikipedia.org/wiki/Gaussian_quadrature#Gauss%E2%80%93Legendre_quadrature
+ */
+template <std::size_t N, class T>
+struct gauss_legendre_rule
+{
+	static_assert(N > 0, "Gauss-Legendre rules require at least one node.");
+	
+	/// Nodes, on `(-1, 1)`.
+	std::array<T, N> nodes;
+	
+	/// Weights of the nodes, which sum to `2`.
+	std::array<T, N> weights;
+	
+	/// Constructs the rule.
+	static constexpr gauss_legendre_rule generate();
+};
+
+/// Compile-time table of the N-point Gauss-Legendre rule.
+template <std::size_t N, class T>
+constexpr gauss_legendre_rule<N, T> gauss_legendre_table = gauss_legendre_rule<N, T>::generate();
+
+/**
+ * Approximates the definite integral of a function using N-point Gauss-Legendre quadrature.
+ *
+ * @tparam N Number of function evaluations per interval.
+ * @param f Unary function object to integrate.
+ * @param a,b Limits of integration.
+ * @param intervals Number of equal intervals into which `[a, b]` is divided, each integrated with its own N-point rule.
+ * @return Approximated integral of @p f.
+ */
+template <std::size_t N, class UnaryOp, class T>
+typename std::invoke_result<UnaryOp, T>::type
+	gauss(UnaryOp f, T a, T b, std::size_t intervals = 1);
+
+template <std::size_t N, class T>
+constexpr gauss_legendre_rule<N, T> gauss_legendre_rule<N, T>::generate()
+{
+	typedef long double real_type;
+	constexpr real_type pi = 3.141592653589793238462643383279502884L;
+	
+	gauss_legendre_rule rule{};
+	
+	// Nodes are symmetric about zero, so only the positive half is solved for
+	for (std::size_t i = 0; i < (N + 1) / 2; ++i)
+	{
+		// Initial guess, cos(pi * (i + 0.75) / (N + 0.5)), by its Taylor series
+		const real_type theta = pi * (real_type(i) + real_type(0.75)) / (real_type(N) + real_type(0.5));
+		real_type x = 0;
+		real_type term = 1;
+		for (std::size_t k = 0; k < 40; ++k)
+		{
+			x += term;
+			term *= -theta * theta / real_type((2 * k + 1) * (2 * k + 2));
+		}
+		
+		// Refine the guess by Newton's method, evaluating P_N and its derivative with Bonnet's recursion
+		real_type dp = 1;
+		for (std::size_t iteration = 0; iteration < 100; ++iteration)
+		{
+			real_type p0 = 1;
+			real_type p1 = x;
+			for (std::size_t k = 2; k <= N; ++k)
+			{
+				const real_type p2 = (real_type(2 * k - 1) * x * p1 - real_type(k - 1) * p0) / real_type(k);
+				p0 = p1;
+				p1 = p2;
+			}
+			
+			dp = real_type(N) * (x * p1 - p0) / (x * x - real_type(1));
+			
+			const real_type dx = p1 / dp;
+			x -= dx;
+			
+			if ((dx < real_type(0) ? -dx : dx) < real_type(1e-19))
+				break;
+		}
+		
+		const real_type w = real_type(2) / ((real_type(1) - x * x) * dp * dp);
+		
+		rule.nodes[i] = static_cast<T>(-x);
+		rule.nodes[N - 1 - i] = static_cast<T>(x);
+		rule.weights[i] = static_cast<T>(w);
+		rule.weights[N - 1 - i] = static_cast<T>(w);
+	}
+	
+	return rule;
+}
+
+template <std::size_t N, class UnaryOp, class T>
+typename std::invoke_result<UnaryOp, T>::type
+	gauss(UnaryOp f, T a, T b, std::size_t intervals)
+{
+	typedef typename std::invoke_result<UnaryOp, T>::type output_type;
+	constexpr const gauss_legendre_rule<N, T>& rule = gauss_legendre_table<N, T>;
+	
+	const T h = (b - a) / T(intervals);
+	const T half_h = h / T(2);
+	
+	output_type sum = output_type{0};
+	for (std::size_t i = 0; i < intervals; ++i)
+	{
+		const T center = a + h * T(i) + half_h;
+		
+		output_type interval_sum = f(center + half_h * rule.nodes[0]) * rule.weights[0];
+		for (std::size_t j = 1; j < N; ++j)
+			interval_sum += f(center + half_h * rule.nodes[j]) * rule.weights[j];
+		
+		sum += interval_sum;
+	}
+	
+	return sum * half_h;
+}
+
 template<class UnaryOp, class InputIt>
 typename std::invoke_result<UnaryOp, typename std::iterator_traits<InputIt>::value_type>::type
 	simpson(UnaryOp f, InputIt first, InputIt last)
@@ -20,15 +20,103 @@
 #ifndef ANTKEEPER_MATH_RANDOM_HPP
 #define ANTKEEPER_MATH_RANDOM_HPP
 
-#include <cstdlib>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
 #include <type_traits>
 
 namespace math {
 
 /**
- * Generates a pseudo-random floating point number on `[start, end)` using std::rand().
+ * Small, fast pseudo-random number generator, implementing the xoshiro256** algorithm.
  *
- * @warning Don't forget to seed with std::srand() before using!
+ * Satisfies the requirements of a UniformRandomBitGenerator, so it may also be used with the distributions of the standard library. An engine is not thread-safe; give each thread or system its own engine, and use split() to derive non-overlapping streams for parallel jobs.
+ */
+class random_engine
+{
+public:
+	typedef std::uint64_t result_type;
+	
+	/// Seed of default-constructed engines.
+	static constexpr std::uint64_t default_seed = 0x853c49e6748fea9bull;
+	
+	/**
+	 * Creates a random engine.
+	 *
+	 * @param seed Seed of the engine.
+	 */
+	explicit random_engine(std::uint64_t seed = default_seed);
+	
+	/**
+	 * Reseeds the engine. Engines seeded with the same seed generate the same sequence.
+	 *
+	 * @param seed Seed of the engine.
+	 */
+	void seed(std::uint64_t seed);
+	
+	/// Generates 64 pseudo-random bits.
+	result_type operator()();
+	
+	/// Advances the engine by 2^128 steps, as if by 2^128 calls to operator().
+	void jump();
+	
+	/**
+	 * Splits off an independent stream. The returned engine continues the sequence of this engine, which then jumps ahead by 2^128 steps, so the two streams do not overlap.
+	 *
+	 * @return Engine which generates the split-off stream.
+	 */
+	random_engine split();
+	
+	/**
+	 * Generates a uniformly distributed floating point number on `[start, end)`.
+	 *
+	 * @param start Start of the range (inclusive).
+	 * @param end End of the range (exclusive).
+	 */
+	template <class T>
+	T uniform(T start, T end);
+	
+	/**
+	 * Fills an array with uniformly distributed floating point numbers on `[start, end)`. Single-precision fills take two numbers from each 64 generated bits.
+	 *
+	 * @param first Pointer to the first element of the array.
+	 * @param n Number of elements to fill.
+	 * @param start Start of the range (inclusive).
+	 * @param end End of the range (exclusive).
+	 */
+	template <class T>
+	void fill(T* first, std::size_t n, T start, T end);
+	
+	/// Returns the smallest value generated by operator().
+	static constexpr result_type min();
+	
+	/// Returns the largest value generated by operator().
+	static constexpr result_type max();
+
+private:
+	static constexpr std::uint64_t rotl(std::uint64_t x, int k);
+	
+	/// Converts the upper bits of a 64-bit value to a floating point number on `[0, 1)`.
+	template <class T>
+	static T to_unit(std::uint64_t x);
+	
+	std::uint64_t state[4];
+};
+
+/**
+ * Returns the random engine of the calling thread. Each thread's engine generates its own stream, derived from the seed set by seed_random().
+ */
+random_engine& thread_random_engine();
+
+/**
+ * Seeds the random engines of all threads. The calling thread's engine is seeded with @p seed itself, and the engines of other threads are reseeded before their next use, each with a different stream, so that sequences generated by the calling thread are reproducible.
+ *
+ * @param seed Seed of the random engines.
+ */
+void seed_random(std::uint64_t seed);
+
+/**
+ * Generates a pseudo-random floating point number on `[start, end)` using the random engine of the calling thread.
  *
  * @param start Start of the range (inclusive).
  * @param end End of the range (exclusive).
@@ -37,12 +125,181 @@ namespace math {
 template <typename T = float>
 T random(T start, T end);
 
+inline random_engine::random_engine(std::uint64_t seed)
+{
+	this->seed(seed);
+}
+
+inline void random_engine::seed(std::uint64_t seed)
+{
+	// Expand seed into the state with SplitMix64, which never yields an all-zero state
+	for (std::uint64_t& s: state)
+	{
+		std::uint64_t z = (seed += 0x9e3779b97f4a7c15ull);
+		z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+		z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+		s = z ^ (z >> 31);
+	}
+}
+
+inline typename random_engine::result_type random_engine::operator()()
+{
+	const std::uint64_t result = rotl(state[1] * 5, 7) * 9;
+	const std::uint64_t t = state[1] << 17;
+	
+	state[2] ^= state[0];
+	state[3] ^= state[1];
+	state[1] ^= state[2];
+	state[0] ^= state[3];
+	state[2] ^= t;
+	state[3] = rotl(state[3], 45);
+	
+	return result;
+}
+
+inline void random_engine::jump()
+{
+	static constexpr std::uint64_t jump_polynomial[4] = {0x180ec6d33cfd0abaull, 0xd5a61266f0c9392cull, 0xa9582618e03fc9aaull, 0x39abdc4529b1661cull};
+	
+	std::uint64_t jumped[4] = {0, 0, 0, 0};
+	for (std::uint64_t word: jump_polynomial)
+	{
+		for (int b = 0; b < 64; ++b)
+		{
+			if (word & (std::uint64_t(1) << b))
+			{
+				jumped[0] ^= state[0];
+				jumped[1] ^= state[1];
+				jumped[2] ^= state[2];
+				jumped[3] ^= state[3];
+			}
+			(*this)();
+		}
+	}
+	
+	state[0] = jumped[0];
+	state[1] = jumped[1];
+	state[2] = jumped[2];
+	state[3] = jumped[3];
+}
+
+inline random_engine random_engine::split()
+{
+	random_engine stream = *this;
+	jump();
+	return stream;
+}
+
+template <class T>
+inline T random_engine::uniform(T start, T end)
+{
+	return to_unit<T>((*this)()) * (end - start) + start;
+}
+
+template <class T>
+void random_engine::fill(T* first, std::size_t n, T start, T end)
+{
+	const T range = end - start;
+	
+	std::size_t i = 0;
+	if constexpr (std::is_same<T, float>::value)
+	{
+		// Take a float from each half of the generated bits
+		for (; i + 2 <= n; i += 2)
+		{
+			const std::uint64_t x = (*this)();
+			first[i] = to_unit<float>(x) * range + start;
+			first[i + 1] = to_unit<float>(x << 32) * range + start;
+		}
+	}
+	for (; i < n; ++i)
+		first[i] = uniform<T>(start, end);
+}
+
+constexpr typename random_engine::result_type random_engine::min()
+{
+	return 0;
+}
+
+constexpr typename random_engine::result_type random_engine::max()
+{
+	return ~result_type(0);
+}
+
+constexpr std::uint64_t random_engine::rotl(std::uint64_t x, int k)
+{
+	return (x << k) | (x >> (64 - k));
+}
+
+template <class T>
+inline T random_engine::to_unit(std::uint64_t x)
+{
+	static_assert(std::is_floating_point<T>::value);
+	
+	if constexpr (std::is_same<T, float>::value)
+		return static_cast<float>(x >> 40) * 0x1.0p-24f;
+	else
+		return static_cast<T>(x >> 11) * T(0x1.0p-53);
+}
+
+/// @private
+namespace random_detail {
+
+/// Seed from which thread engines are derived.
+inline std::atomic<std::uint64_t> seed{random_engine::default_seed};
+
+/// Number of calls to seed_random(), by which thread engines detect that they must be reseeded.
+inline std::atomic<std::uint32_t> epoch{0};
+
+/// Index of the stream of the next thread to use its engine.
+inline std::atomic<std::uint64_t> next_stream{1};
+
+/// State of the random engine of a thread.
+struct thread_engine
+{
+	random_engine engine;
+	std::uint64_t stream = next_stream.fetch_add(1, std::memory_order_relaxed);
+	std::uint32_t epoch = ~std::uint32_t(0);
+};
+
+inline thread_engine& get_thread_engine()
+{
+	thread_local thread_engine state;
+	return state;
+}
+
+} // namespace random_detail
+
+inline random_engine& thread_random_engine()
+{
+	random_detail::thread_engine& state = random_detail::get_thread_engine();
+	
+	// Reseed with this thread's stream after each call to seed_random()
+	const std::uint32_t epoch = random_detail::epoch.load(std::memory_order_acquire);
+	if (state.epoch != epoch)
+	{
+		state.engine.seed(random_detail::seed.load(std::memory_order_relaxed) ^ (state.stream * 0x9e3779b97f4a7c15ull));
+		state.epoch = epoch;
+	}
+	
+	return state.engine;
+}
+
+inline void seed_random(std::uint64_t seed)
+{
+	random_detail::seed.store(seed, std::memory_order_relaxed);
+	const std::uint32_t epoch = random_detail::epoch.fetch_add(1, std::memory_order_acq_rel) + 1;
+	
+	random_detail::thread_engine& state = random_detail::get_thread_engine();
+	state.engine.seed(seed);
+	state.epoch = epoch;
+}
+
 template <typename T>
 inline T random(T start, T end)
 {
 	static_assert(std::is_floating_point<T>::value);
-	constexpr T rand_max_inverse = T(1) / static_cast<T>(RAND_MAX);
-    return static_cast<T>(std::rand()) * rand_max_inverse * (end - start) + start;
+	return thread_random_engine().uniform<T>(start, end);
 }
 
 } // namespace math
@@ -0,0 +1,48 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ANTKEEPER_MATH_SIMD_HPP
+#define ANTKEEPER_MATH_SIMD_HPP
+
+/**
+ * @file simd.hpp
+ *
+ * Selects the SIMD instruction set used by the `float` specializations of the 4-component vector and 4x4 matrix functions, and by batch kernels. `double` batch kernels additionally require SSE2 or 64-bit NEON. Define `ANTKEEPER_MATH_NO_SIMD` to use the generic scalar functions instead.
+ */
+
+#if !defined(ANTKEEPER_MATH_NO_SIMD)
+	#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+		#define ANTKEEPER_MATH_SSE
+		#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+			#define ANTKEEPER_MATH_SSE2
+		#endif
+	#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+		#define ANTKEEPER_MATH_NEON
+	#endif
+#endif
+
+#if defined(ANTKEEPER_MATH_SSE2)
+	#include <emmintrin.h>
+#elif defined(ANTKEEPER_MATH_SSE)
+	#include <xmmintrin.h>
+#elif defined(ANTKEEPER_MATH_NEON)
+	#include <arm_neon.h>
+#endif
+
+#endif // ANTKEEPER_MATH_SIMD_HPP
@@ -44,6 +44,26 @@ transform<T> inverse(const transform<T>& t);
 template <class T>
 matrix<T, 4, 4> matrix_cast(const transform<T>& t);
 
+/**
+ * Calculates the inverse of the transformation matrix of a transform, without a general matrix inverse.
+ *
+ * Unlike converting the inverse transform, this is exact for non-uniform scales.
+ *
+ * @param t Transform.
+ * @return Inverse of `matrix_cast(t)`.
+ */
+template <class T>
+matrix<T, 4, 4> inverse_matrix_cast(const transform<T>& t);
+
+/**
+ * Calculates the normal matrix of a transform, the inverse transpose of the upper 3x3 of its transformation matrix, from its rotation and inverse scale.
+ *
+ * @param t Transform.
+ * @return Matrix which transforms normals by `t`.
+ */
+template <class T>
+matrix<T, 3, 3> normal_matrix(const transform<T>& t);
+
 /**
  * Multiplies two transforms.
  *
@@ -82,6 +102,40 @@ matrix<T, 4, 4> matrix_cast(const transform<T>& t)
 	return scale(transformation, t.scale);
 }
 
+template <class T>
+matrix<T, 4, 4> inverse_matrix_cast(const transform<T>& t)
+{
+	// Inverse of (T * R * S) is (S^-1 * R^T * T^-1)
+	const matrix<T, 3, 3> r = matrix_cast(t.rotation);
+	const vector<T, 3> inverse_scale = {T(1) / t.scale[0], T(1) / t.scale[1], T(1) / t.scale[2]};
+	
+	matrix<T, 4, 4> inverse_transformation;
+	for (std::size_t i = 0; i < 3; ++i)
+	{
+		inverse_transformation[i] = {r[0][i] * inverse_scale[0], r[1][i] * inverse_scale[1], r[2][i] * inverse_scale[2], T(0)};
+	}
+	inverse_transformation[3] =
+	{
+		-dot(r[0], t.translation) * inverse_scale[0],
+		-dot(r[1], t.translation) * inverse_scale[1],
+		-dot(r[2], t.translation) * inverse_scale[2],
+		T(1)
+	};
+	
+	return inverse_transformation;
+}
+
+template <class T>
+matrix<T, 3, 3> normal_matrix(const transform<T>& t)
+{
+	// Inverse transpose of (R * S) is (R * S^-1), as R is orthonormal and S is diagonal
+	matrix<T, 3, 3> normal = matrix_cast(t.rotation);
+	normal[0] = mul(normal[0], T(1) / t.scale[0]);
+	normal[1] = mul(normal[1], T(1) / t.scale[1]);
+	normal[2] = mul(normal[2], T(1) / t.scale[2]);
+	return normal;
+}
+
 template <class T>
 transform<T> mul(const transform<T>& x, const transform<T>& y)
 {
@@ -21,6 +21,7 @@
 #define ANTKEEPER_MATH_VECTOR_FUNCTIONS_HPP
 
 #include "math/vector-type.hpp"
+#include "math/simd.hpp"
 #include <algorithm>
 #include <cmath>
 #include <type_traits>
@@ -641,6 +642,88 @@ inline vector<T2, N> type_cast(const vector<T1, N>& v)
 	return type_cast<T2>(v, std::make_index_sequence<N>{}); 
 }
 
+#if defined(ANTKEEPER_MATH_SSE) || defined(ANTKEEPER_MATH_NEON)
+
+/// @private
+namespace simd {
+
+#if defined(ANTKEEPER_MATH_SSE)
+	typedef __m128 float4_type;
+	
+	inline float4_type load(const vector<float, 4>& v) { return _mm_loadu_ps(&v[0]); }
+	inline void store(vector<float, 4>& v, float4_type x) { _mm_storeu_ps(&v[0], x); }
+	inline float4_type broadcast(float s) { return _mm_set1_ps(s); }
+	inline float4_type add(float4_type x, float4_type y) { return _mm_add_ps(x, y); }
+	inline float4_type sub(float4_type x, float4_type y) { return _mm_sub_ps(x, y); }
+	inline float4_type mul(float4_type x, float4_type y) { return _mm_mul_ps(x, y); }
+	
+	/// Returns the sum of the four lanes of @p x.
+	inline float sum(float4_type x)
+	{
+		x = _mm_add_ps(x, _mm_movehl_ps(x, x));
+		x = _mm_add_ss(x, _mm_shuffle_ps(x, x, _MM_SHUFFLE(1, 1, 1, 1)));
+		return _mm_cvtss_f32(x);
+	}
+#else
+	typedef float32x4_t float4_type;
+	
+	inline float4_type load(const vector<float, 4>& v) { return vld1q_f32(&v[0]); }
+	inline void store(vector<float, 4>& v, float4_type x) { vst1q_f32(&v[0], x); }
+	inline float4_type broadcast(float s) { return vdupq_n_f32(s); }
+	inline float4_type add(float4_type x, float4_type y) { return vaddq_f32(x, y); }
+	inline float4_type sub(float4_type x, float4_type y) { return vsubq_f32(x, y); }
+	inline float4_type mul(float4_type x, float4_type y) { return vmulq_f32(x, y); }
+	
+	/// Returns the sum of the four lanes of @p x.
+	inline float sum(float4_type x)
+	{
+		const float32x2_t pair = vadd_f32(vget_low_f32(x), vget_high_f32(x));
+		return vget_lane_f32(vpadd_f32(pair, pair), 0);
+	}
+#endif
+
+} // namespace simd
+
+template <>
+inline vector<float, 4> add<float, 4>(const vector<float, 4>& x, const vector<float, 4>& y)
+{
+	vector<float, 4> result;
+	simd::store(result, simd::add(simd::load(x), simd::load(y)));
+	return result;
+}
+
+template <>
+inline float dot<float, 4>(const vector<float, 4>& x, const vector<float, 4>& y)
+{
+	return simd::sum(simd::mul(simd::load(x), simd::load(y)));
+}
+
+template <>
+inline vector<float, 4> mul<float, 4>(const vector<float, 4>& x, const vector<float, 4>& y)
+{
+	vector<float, 4> result;
+	simd::store(result, simd::mul(simd::load(x), simd::load(y)));
+	return result;
+}
+
+template <>
+inline vector<float, 4> mul<float, 4>(const vector<float, 4>& v, float s)
+{
+	vector<float, 4> result;
+	simd::store(result, simd::mul(simd::load(v), simd::broadcast(s)));
+	return result;
+}
+
+template <>
+inline vector<float, 4> sub<float, 4>(const vector<float, 4>& x, const vector<float, 4>& y)
+{
+	vector<float, 4> result;
+	simd::store(result, simd::sub(simd::load(x), simd::load(y)));
+	return result;
+}
+
+#endif // ANTKEEPER_MATH_SSE || ANTKEEPER_MATH_NEON
+
 } // namespace math
 
 #endif // ANTKEEPER_MATH_VECTOR_FUNCTIONS_HPP
@@ -91,3 +91,21 @@ float3 nest::get_shaft_position(const shaft& shaft, float depth) const
 
 }
 
+void nest::sample_shaft(const shaft& shaft, float spacing, std::vector<float3>& points) const
+{
+	// Approximate the length of the helix
+	const std::size_t resolution = 64;
+	float length = 0.0f;
+	float3 previous = get_shaft_position(shaft, shaft.depth[0]);
+	for (std::size_t i = 1; i <= resolution; ++i)
+	{
+		float3 position = get_shaft_position(shaft, math::lerp<float>(shaft.depth[0], shaft.depth[1], static_cast<float>(i) / static_cast<float>(resolution)));
+		length += math::length(position - previous);
+		previous = position;
+	}
+
+	// Sample the helix at evenly spaced depths
+	std::size_t count = std::max<std::size_t>(1, static_cast<std::size_t>(std::ceil(length / spacing)));
+	for (std::size_t i = 0; i <= count; ++i)
+		points.push_back(get_shaft_position(shaft, math::lerp<float>(shaft.depth[0], shaft.depth[1], static_cast<float>(i) / static_cast<float>(count))));
+}
@@ -63,8 +63,11 @@ public:
 	void regenerate();
 
 	void set_tunnel_radius(float radius);
+	
+	float get_tunnel_radius() const;
 
 	shaft* get_central_shaft();
+	const shaft* get_central_shaft() const;
 
 	/**
 	 * Calculates the position on a shaft at the specified depth.
@@ -75,6 +78,15 @@ public:
 	
 	float get_shaft_depth(const shaft& shaft, float turns) const;
 	
+	/**
+	 * Samples points along a shaft, from its start depth to its end depth, such that the shaft can be dug as a chain of capsules between consecutive points.
+	 *
+	 * @param shaft Shaft to sample.
+	 * @param spacing Approximate distance between consecutive points along the helix.
+	 * @param[out] points List of points to which the samples will be added.
+	 */
+	void sample_shaft(const shaft& shaft, float spacing, std::vector<float3>& points) const;
+	
 private:
 	float tunnel_radius;
 	shaft central_shaft;
@@ -86,4 +98,14 @@ inline nest::shaft* nest::get_central_shaft()
 	return &central_shaft;
 }
 
+inline const nest::shaft* nest::get_central_shaft() const
+{
+	return &central_shaft;
+}
+
+inline float nest::get_tunnel_radius() const
+{
+	return tunnel_radius;
+}
+
 #endif // ANTKEEPER_NEST_HPP
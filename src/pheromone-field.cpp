@@ -0,0 +1,381 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "pheromone-field.hpp"
+#include "math/batch.hpp"
+#include "math/math.hpp"
+#include "utility/job-system.hpp"
+#include <algorithm>
+#include <cmath>
+
+pheromone_field::pheromone_field(const float3& origin, float cell_size, const std::array<std::uint32_t, 3>& size, std::size_t channel_count):
+	origin(origin),
+	cell_size(cell_size),
+	channel_count(channel_count),
+	diffusion_rates(channel_count, 0.0f),
+	evaporation_rates(channel_count, 0.0f),
+	activation_threshold(1e-3f),
+	current(0),
+	jobs(nullptr)
+{
+	tile_volume = 1;
+	for (int i = 0; i < 3; ++i)
+	{
+		this->size[i] = std::max<std::uint32_t>(size[i], 1);
+		tile_extent[i] = std::min<std::uint32_t>(this->size[i], 8);
+		tile_counts[i] = (this->size[i] + tile_extent[i] - 1) / tile_extent[i];
+		tile_volume *= tile_extent[i];
+	}
+	
+	tiles.resize(static_cast<std::size_t>(tile_counts[0]) * tile_counts[1] * tile_counts[2]);
+}
+
+void pheromone_field::set_job_system(job_system* jobs)
+{
+	this->jobs = jobs;
+}
+
+void pheromone_field::set_diffusion_rate(std::size_t channel, float rate)
+{
+	diffusion_rates[channel] = rate;
+}
+
+void pheromone_field::set_evaporation_rate(std::size_t channel, float rate)
+{
+	evaporation_rates[channel] = rate;
+}
+
+void pheromone_field::set_activation_threshold(float threshold)
+{
+	activation_threshold = threshold;
+}
+
+void pheromone_field::deposit(std::size_t channel, const float3& position, float amount)
+{
+	deposit(channel, &position, 1, amount);
+}
+
+void pheromone_field::deposit(std::size_t channel, const float3* positions, std::size_t count, float amount)
+{
+	std::lock_guard<std::mutex> lock(deposition_mutex);
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		deposition deposition;
+		if (!find_cell(positions[i], deposition.cell))
+			continue;
+		deposition.channel = channel;
+		deposition.amount = amount;
+		depositions.push_back(deposition);
+	}
+}
+
+void pheromone_field::update(float dt)
+{
+	// Add pending deposits to the current concentrations
+	{
+		std::lock_guard<std::mutex> lock(deposition_mutex);
+		std::swap(depositions, pending_depositions);
+	}
+	for (const deposition& deposition: pending_depositions)
+	{
+		std::uint32_t tile_coordinates[3];
+		std::uint32_t local[3];
+		for (int i = 0; i < 3; ++i)
+		{
+			tile_coordinates[i] = deposition.cell[i] / tile_extent[i];
+			local[i] = deposition.cell[i] - tile_coordinates[i] * tile_extent[i];
+		}
+		
+		tile& tile = activate((static_cast<std::size_t>(tile_coordinates[2]) * tile_counts[1] + tile_coordinates[1]) * tile_counts[0] + tile_coordinates[0]);
+		float& concentration = tile.buffers[current][deposition.channel * tile_volume + (static_cast<std::size_t>(local[2]) * tile_extent[1] + local[1]) * tile_extent[0] + local[0]];
+		concentration += deposition.amount;
+		
+		// Track the concentrations of border cells, by which bordering tiles will be activated
+		for (int i = 0; i < 3; ++i)
+		{
+			if (local[i] == 0)
+				tile.face_peaks[i * 2] = std::max(tile.face_peaks[i * 2], concentration);
+			if (local[i] == tile_extent[i] - 1)
+				tile.face_peaks[i * 2 + 1] = std::max(tile.face_peaks[i * 2 + 1], concentration);
+		}
+		tile.peak = std::max(tile.peak, concentration);
+	}
+	pending_depositions.clear();
+	
+	if (active_tiles.empty() || dt <= 0.0f)
+		return;
+	
+	// Activate tiles into which pheromones will diffuse
+	const std::size_t active_count = active_tiles.size();
+	for (std::size_t i = 0; i < active_count; ++i)
+	{
+		const tile& tile = *tiles[active_tiles[i]];
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			const std::uint32_t coordinate = tile.min[axis] / tile_extent[axis];
+			for (int direction = 0; direction < 2; ++direction)
+			{
+				if (tile.face_peaks[axis * 2 + direction] < activation_threshold)
+					continue;
+				if ((direction == 0 && coordinate == 0) || (direction == 1 && coordinate + 1 == tile_counts[axis]))
+					continue;
+				
+				std::uint32_t neighbor[3] = {tile.min[0] / tile_extent[0], tile.min[1] / tile_extent[1], tile.min[2] / tile_extent[2]};
+				neighbor[axis] = (direction == 0) ? coordinate - 1 : coordinate + 1;
+				activate((static_cast<std::size_t>(neighbor[2]) * tile_counts[1] + neighbor[1]) * tile_counts[0] + neighbor[0]);
+			}
+		}
+	}
+	
+	// Diffuse and evaporate each tile into its other buffer
+	auto step_tiles = [this, dt](std::size_t first, std::size_t last)
+	{
+		std::vector<float> padded;
+		for (std::size_t i = first; i < last; ++i)
+			step(*tiles[active_tiles[i]], dt, padded);
+	};
+	if (jobs)
+		jobs->parallel_for(0, active_tiles.size(), 4, step_tiles);
+	else
+		step_tiles(0, active_tiles.size());
+	current ^= 1;
+	
+	// Release tiles whose pheromones have dissipated
+	active_tiles.erase(std::remove_if(active_tiles.begin(), active_tiles.end(),
+		[this](std::size_t tile_index)
+		{
+			if (tiles[tile_index]->peak >= activation_threshold)
+				return false;
+			tiles[tile_index].reset();
+			return true;
+		}),
+		active_tiles.end());
+}
+
+float pheromone_field::sample(std::size_t channel, const float3& position) const
+{
+	// Find the cell centers surrounding the position
+	std::int64_t cell[3];
+	float weights[3];
+	for (int i = 0; i < 3; ++i)
+	{
+		const float coordinate = (position[i] - origin[i]) / cell_size - 0.5f;
+		const float floor = std::floor(coordinate);
+		cell[i] = static_cast<std::int64_t>(floor);
+		weights[i] = coordinate - floor;
+	}
+	
+	float concentration = 0.0f;
+	for (int i = 0; i < 8; ++i)
+	{
+		const int dx = i & 1;
+		const int dy = (i >> 1) & 1;
+		const int dz = (i >> 2) & 1;
+		const float weight =
+			(dx ? weights[0] : 1.0f - weights[0]) *
+			(dy ? weights[1] : 1.0f - weights[1]) *
+			(dz ? weights[2] : 1.0f - weights[2]);
+		concentration += get(channel, cell[0] + dx, cell[1] + dy, cell[2] + dz) * weight;
+	}
+	
+	return concentration;
+}
+
+float3 pheromone_field::sample_gradient(std::size_t channel, const float3& position) const
+{
+	float3 gradient;
+	for (int i = 0; i < 3; ++i)
+	{
+		float3 offset = {0.0f, 0.0f, 0.0f};
+		offset[i] = cell_size;
+		gradient[i] = (sample(channel, position + offset) - sample(channel, position - offset)) / (cell_size * 2.0f);
+	}
+	
+	return gradient;
+}
+
+bool pheromone_field::find_cell(const float3& position, std::uint32_t cell[3]) const
+{
+	for (int i = 0; i < 3; ++i)
+	{
+		const float coordinate = std::floor((position[i] - origin[i]) / cell_size);
+		
+		// Positions above or below a 2D field are projected onto it
+		if (size[i] == 1)
+		{
+			cell[i] = 0;
+			continue;
+		}
+		
+		if (coordinate < 0.0f || coordinate >= static_cast<float>(size[i]))
+			return false;
+		cell[i] = static_cast<std::uint32_t>(coordinate);
+	}
+	
+	return true;
+}
+
+pheromone_field::tile& pheromone_field::activate(std::size_t tile_index)
+{
+	std::unique_ptr<tile>& tile = tiles[tile_index];
+	if (!tile)
+	{
+		tile = std::make_unique<pheromone_field::tile>();
+		for (int i = 0; i < 2; ++i)
+		{
+			tile->buffers[i].reset(new float[channel_count * tile_volume]);
+			std::fill_n(tile->buffers[i].get(), channel_count * tile_volume, 0.0f);
+		}
+		
+		const std::size_t row = tile_index / tile_counts[0];
+		tile->min[0] = static_cast<std::uint32_t>(tile_index % tile_counts[0]) * tile_extent[0];
+		tile->min[1] = static_cast<std::uint32_t>(row % tile_counts[1]) * tile_extent[1];
+		tile->min[2] = static_cast<std::uint32_t>(row / tile_counts[1]) * tile_extent[2];
+		std::fill_n(tile->face_peaks, 6, 0.0f);
+		tile->peak = 0.0f;
+		
+		active_tiles.push_back(tile_index);
+	}
+	
+	return *tile;
+}
+
+inline float pheromone_field::get(std::size_t channel, std::int64_t x, std::int64_t y, std::int64_t z) const
+{
+	// Clamp to the grid, such that pheromones don't diffuse out of it
+	const std::uint32_t cell[3] =
+	{
+		static_cast<std::uint32_t>(std::clamp<std::int64_t>(x, 0, size[0] - 1)),
+		static_cast<std::uint32_t>(std::clamp<std::int64_t>(y, 0, size[1] - 1)),
+		static_cast<std::uint32_t>(std::clamp<std::int64_t>(z, 0, size[2] - 1))
+	};
+	
+	std::uint32_t tile_coordinates[3];
+	std::uint32_t local[3];
+	for (int i = 0; i < 3; ++i)
+	{
+		tile_coordinates[i] = cell[i] / tile_extent[i];
+		local[i] = cell[i] - tile_coordinates[i] * tile_extent[i];
+	}
+	
+	const std::unique_ptr<tile>& tile = tiles[(static_cast<std::size_t>(tile_coordinates[2]) * tile_counts[1] + tile_coordinates[1]) * tile_counts[0] + tile_coordinates[0]];
+	if (!tile)
+		return 0.0f;
+	
+	return tile->buffers[current][channel * tile_volume + (static_cast<std::size_t>(local[2]) * tile_extent[1] + local[1]) * tile_extent[0] + local[0]];
+}
+
+void pheromone_field::step(tile& tile, float dt, std::vector<float>& padded) const
+{
+	const std::uint32_t ex = tile_extent[0];
+	const std::uint32_t ey = tile_extent[1];
+	const std::uint32_t ez = tile_extent[2];
+	
+	// Dimensions of the tile with a border of one cell, copied from bordering tiles
+	const std::size_t px = ex + 2;
+	const std::size_t py = ey + 2;
+	const std::size_t pz = ez + 2;
+	padded.resize(px * py * pz);
+	
+	// Cells clamped to the grid along axes with a single cell equal the cell itself, so only the other axes count towards the stencil
+	const int axis_count = std::max((size[0] > 1) + (size[1] > 1) + (size[2] > 1), 1);
+	
+	const float* front = tile.buffers[current].get();
+	float* back = tile.buffers[current ^ 1].get();
+	const std::int64_t min[3] = {tile.min[0], tile.min[1], tile.min[2]};
+	
+	std::fill_n(tile.face_peaks, 6, 0.0f);
+	tile.peak = 0.0f;
+	
+	for (std::size_t channel = 0; channel < channel_count; ++channel)
+	{
+		const float* source = front + channel * tile_volume;
+		float* destination = back + channel * tile_volume;
+		
+		// Gather the tile and its border, copying rows within the tile directly
+		for (std::size_t z = 0; z < pz; ++z)
+		{
+			const std::int64_t cz = min[2] + static_cast<std::int64_t>(z) - 1;
+			for (std::size_t y = 0; y < py; ++y)
+			{
+				const std::int64_t cy = min[1] + static_cast<std::int64_t>(y) - 1;
+				float* row = padded.data() + (z * py + y) * px;
+				
+				if (z > 0 && z <= ez && y > 0 && y <= ey)
+				{
+					std::copy_n(source + ((z - 1) * ey + (y - 1)) * ex, ex, row + 1);
+					row[0] = get(channel, min[0] - 1, cy, cz);
+					row[px - 1] = get(channel, min[0] + ex, cy, cz);
+				}
+				else
+				{
+					for (std::size_t x = 0; x < px; ++x)
+						row[x] = get(channel, min[0] + static_cast<std::int64_t>(x) - 1, cy, cz);
+				}
+			}
+		}
+		
+		// Explicit diffusion is stable while no cell gives away more than it holds
+		const float diffusion = std::min(diffusion_rates[channel] * dt, 1.0f) / static_cast<float>(axis_count * 2);
+		const float decay = std::exp(-evaporation_rates[channel] * dt);
+		
+		// Apply the stencil to rows of the tile
+		for (std::uint32_t z = 0; z < ez; ++z)
+		{
+			for (std::uint32_t y = 0; y < ey; ++y)
+			{
+				const float* center = padded.data() + ((z + 1) * py + (y + 1)) * px + 1;
+				float* output = destination + (static_cast<std::size_t>(z) * ey + y) * ex;
+				
+				math::simd::dispatch_lanes<float>(ex, [&](auto lanes, std::size_t i)
+				{
+					typedef decltype(lanes) L;
+					const L c = L::load(center + i);
+					const L neighbors =
+						L::load(center + i - 1) + L::load(center + i + 1) +
+						L::load(center + i - px) + L::load(center + i + px) +
+						L::load(center + i - px * py) + L::load(center + i + px * py);
+					
+					// Neighbors along single-cell axes equal the center, so subtracting six centers cancels them
+					const L laplacian = neighbors - c * L::broadcast(6.0f);
+					((c + laplacian * L::broadcast(diffusion)) * L::broadcast(decay)).store(output + i);
+				});
+				
+				// Track the peak concentrations of the tile and its faces
+				for (std::uint32_t x = 0; x < ex; ++x)
+				{
+					const float concentration = output[x];
+					tile.peak = std::max(tile.peak, concentration);
+					if (x == 0)
+						tile.face_peaks[0] = std::max(tile.face_peaks[0], concentration);
+					if (x == ex - 1)
+						tile.face_peaks[1] = std::max(tile.face_peaks[1], concentration);
+					if (y == 0)
+						tile.face_peaks[2] = std::max(tile.face_peaks[2], concentration);
+					if (y == ey - 1)
+						tile.face_peaks[3] = std::max(tile.face_peaks[3], concentration);
+					if (z == 0)
+						tile.face_peaks[4] = std::max(tile.face_peaks[4], concentration);
+					if (z == ez - 1)
+						tile.face_peaks[5] = std::max(tile.face_peaks[5], concentration);
+				}
+			}
+		}
+	}
+}
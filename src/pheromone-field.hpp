@@ -0,0 +1,214 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ANTKEEPER_PHEROMONE_FIELD_HPP
+#define ANTKEEPER_PHEROMONE_FIELD_HPP
+
+#include "utility/fundamental-types.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+class job_system;
+
+/**
+ * Multi-channel pheromone concentrations, sampled at the centers of the cells of a 2D or 3D grid.
+ *
+ * The grid is divided into tiles of up to 8^3 cells, and only tiles which hold pheromones are allocated. Each update diffuses and evaporates the concentrations of every allocated tile with SIMD stencil kernels, in parallel across tiles if a job system has been set. Tiles are allocated when pheromones are deposited into them or diffuse to their borders, and released once their concentrations fall below the activation threshold, so the cost of an update depends on the area covered by pheromone trails rather than the size of the grid.
+ *
+ * Pheromones may be deposited from any thread at any time, and are added to the field by the next update. Concentrations may be sampled concurrently while the field is not updating.
+ */
+class pheromone_field
+{
+public:
+	/**
+	 * Creates a pheromone field without pheromones.
+	 *
+	 * @param origin Position of the minimum corner of the grid.
+	 * @param cell_size Width of each cell.
+	 * @param size Number of cells along each axis of the grid. A single cell along the y-axis yields a 2D field over terrain.
+	 * @param channel_count Number of pheromone channels.
+	 */
+	pheromone_field(const float3& origin, float cell_size, const std::array<std::uint32_t, 3>& size, std::size_t channel_count);
+	
+	pheromone_field(const pheromone_field&) = delete;
+	pheromone_field& operator=(const pheromone_field&) = delete;
+	
+	/**
+	 * Sets the job system on which tiles are updated in parallel.
+	 *
+	 * @param jobs Job system, or `nullptr` to update all tiles on the calling thread.
+	 */
+	void set_job_system(job_system* jobs);
+	
+	/**
+	 * Sets the rate at which the pheromones of a channel diffuse between neighboring cells.
+	 *
+	 * @param channel Index of a channel.
+	 * @param rate Diffusion rate, in cells squared per second. Clamped per update to the stable range of the stencil.
+	 */
+	void set_diffusion_rate(std::size_t channel, float rate);
+	
+	/**
+	 * Sets the rate at which the pheromones of a channel evaporate.
+	 *
+	 * @param channel Index of a channel.
+	 * @param rate Fraction of the concentration which evaporates per second, as an exponential decay rate.
+	 */
+	void set_evaporation_rate(std::size_t channel, float rate);
+	
+	/**
+	 * Sets the concentration below which pheromones are disregarded, such that tiles are released once all of their concentrations fall below it.
+	 *
+	 * @param threshold Activation threshold.
+	 */
+	void set_activation_threshold(float threshold);
+	
+	/**
+	 * Deposits pheromones into the cell containing a position. Positions outside of the grid are ignored. Safe to call from any thread.
+	 *
+	 * @param channel Index of a channel.
+	 * @param position Position at which to deposit.
+	 * @param amount Concentration to add to the cell.
+	 */
+	void deposit(std::size_t channel, const float3& position, float amount);
+	
+	/**
+	 * Deposits an equal amount of pheromones at each of an array of positions, acquiring the deposition lock once. Safe to call from any thread.
+	 *
+	 * @param channel Index of a channel.
+	 * @param positions Array of positions at which to deposit.
+	 * @param count Number of positions.
+	 * @param amount Concentration to add to the cell containing each position.
+	 */
+	void deposit(std::size_t channel, const float3* positions, std::size_t count, float amount);
+	
+	/**
+	 * Adds pending deposits to the field, then diffuses and evaporates its pheromones.
+	 *
+	 * @param dt Delta time, in seconds.
+	 */
+	void update(float dt);
+	
+	/**
+	 * Samples the concentration of a channel at a position, by trilinear interpolation between cell centers.
+	 *
+	 * @param channel Index of a channel.
+	 * @param position Position at which to sample.
+	 * @return Concentration at the position.
+	 */
+	float sample(std::size_t channel, const float3& position) const;
+	
+	/**
+	 * Samples the gradient of the concentration of a channel at a position, which points up the pheromone trail.
+	 *
+	 * @param channel Index of a channel.
+	 * @param position Position at which to sample.
+	 * @return Gradient of the concentration, by central differences of one cell.
+	 */
+	float3 sample_gradient(std::size_t channel, const float3& position) const;
+	
+	/// Returns the number of pheromone channels.
+	std::size_t get_channel_count() const;
+	
+	/// Returns the number of allocated tiles.
+	std::size_t get_active_tile_count() const;
+	
+private:
+	/// Allocated tile of cells.
+	struct tile
+	{
+		/// Double-buffered concentrations of the tile's cells, stored channel by channel with x varying fastest.
+		std::unique_ptr<float[]> buffers[2];
+		
+		/// Coordinates of the tile's minimum cell.
+		std::uint32_t min[3];
+		
+		/// Maximum concentration of the cells on each face of the tile, ordered -x, +x, -y, +y, -z, +z, by which bordering tiles are activated.
+		float face_peaks[6];
+		
+		/// Maximum concentration of the tile's cells.
+		float peak;
+	};
+	
+	struct deposition
+	{
+		std::size_t channel;
+		std::uint32_t cell[3];
+		float amount;
+	};
+	
+	/// Finds the cell containing a position, returning `false` if it lies outside of the grid.
+	bool find_cell(const float3& position, std::uint32_t cell[3]) const;
+	
+	/// Returns the tile at an index in the tile table, allocating it if necessary.
+	tile& activate(std::size_t tile_index);
+	
+	/// Returns the current concentration of a cell, with coordinates clamped to the grid.
+	float get(std::size_t channel, std::int64_t x, std::int64_t y, std::int64_t z) const;
+	
+	/// Diffuses and evaporates the current concentrations of a tile into its other buffer. Safe to call concurrently for different tiles.
+	void step(tile& tile, float dt, std::vector<float>& padded) const;
+	
+	float3 origin;
+	float cell_size;
+	std::uint32_t size[3];
+	
+	/// Number of cells along each axis of a tile.
+	std::uint32_t tile_extent[3];
+	
+	/// Number of tiles along each axis of the grid.
+	std::uint32_t tile_counts[3];
+	
+	std::size_t tile_volume;
+	std::size_t channel_count;
+	std::vector<float> diffusion_rates;
+	std::vector<float> evaporation_rates;
+	float activation_threshold;
+	
+	/// Table of every tile of the grid, with x varying fastest, or `nullptr` for tiles which aren't allocated.
+	std::vector<std::unique_ptr<tile>> tiles;
+	
+	/// Indices of the allocated tiles.
+	std::vector<std::size_t> active_tiles;
+	
+	/// Index of the buffer which holds the current concentrations of every tile.
+	int current;
+	
+	job_system* jobs;
+	
+	std::mutex deposition_mutex;
+	std::vector<deposition> depositions;
+	std::vector<deposition> pending_depositions;
+};
+
+inline std::size_t pheromone_field::get_channel_count() const
+{
+	return channel_count;
+}
+
+inline std::size_t pheromone_field::get_active_tile_count() const
+{
+	return active_tiles.size();
+}
+
+#endif // ANTKEEPER_PHEROMONE_FIELD_HPP
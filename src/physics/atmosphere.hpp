@@ -22,7 +22,17 @@
 
 #include "physics/constants.hpp"
 #include "math/constants.hpp"
+#include "math/quadrature.hpp"
+#include "math/vector-type.hpp"
+#include "math/vector-functions.hpp"
+#include "math/vector-operators.hpp"
+#include "physics/light/phase.hpp"
+#include <algorithm>
+#include <array>
 #include <cmath>
+#include <cstddef>
+#include <limits>
+#include <vector>
 
 namespace physics {
 
@@ -162,6 +172,587 @@ T optical_depth(const math::vector3<T>& a, const math::vector3<T>& b, T r, T sh,
 	return sum / T(2) * h;
 }
 
+/**
+ * Approximates the optical depth of exponentially-distributed atmospheric particles between two points using N-point Gauss-Legendre quadrature.
+ *
+ * As the density of the particles is smooth along the path, this converges with far fewer samples than the trapezoidal rule; 16 nodes are typically within 1e-6 of the exact optical depth, even for rays grazing the horizon.
+ *
+ * @tparam N Number of samples.
+ * @param a Start point.
+ * @param b End point.
+ * @param r Radius of the planet.
+ * @param sh Scale height of the atmospheric particles.
+ * @return Optical depth between @p a and @p b.
+ */
+template <std::size_t N, class T>
+T optical_depth(const math::vector3<T>& a, const math::vector3<T>& b, T r, T sh)
+{
+	sh = T(-1) / sh;
+	
+	const math::vector3<T> ab = b - a;
+	auto density = [&a, &ab, r, sh](T t) -> T
+	{
+		return std::exp((math::length(a + ab * t) - r) * sh);
+	};
+	
+	return math::quadrature::gauss<N>(density, T(0), T(1)) * math::length(ab);
+}
+
+/**
+ * Bilinearly interpolates a table of interleaved samples.
+ *
+ * @param data Table samples, in rows of @p columns samples of @p N components.
+ * @param rows,columns Dimensions of the table.
+ * @param u,v Row and column coordinates, on `[0, 1]`.
+ * @param[out] result Interpolated components.
+ */
+template <std::size_t N, class T>
+void sample_table(const T* data, std::size_t rows, std::size_t columns, T u, T v, T* result)
+{
+	const T y = std::min<T>(T(1), std::max<T>(T(0), u)) * static_cast<T>(rows - 1);
+	const T x = std::min<T>(T(1), std::max<T>(T(0), v)) * static_cast<T>(columns - 1);
+	const std::size_t i0 = std::min<std::size_t>(static_cast<std::size_t>(y), rows - 2);
+	const std::size_t j0 = std::min<std::size_t>(static_cast<std::size_t>(x), columns - 2);
+	const T ty = y - static_cast<T>(i0);
+	const T tx = x - static_cast<T>(j0);
+	
+	const T* s00 = data + (i0 * columns + j0) * N;
+	const T* s10 = s00 + columns * N;
+	
+	for (std::size_t k = 0; k < N; ++k)
+	{
+		const T d0 = s00[k] + (s00[k + N] - s00[k]) * tx;
+		const T d1 = s10[k] + (s10[k + N] - s10[k]) * tx;
+		result[k] = d0 + (d1 - d0) * ty;
+	}
+}
+
+/**
+ * Table of the optical depths of Rayleigh and Mie particles between points in an atmosphere and the exosphere, by which atmospheric transmittance can be looked up rather than integrated.
+ *
+ * The table is parameterized by altitude and by the cosine of the zenith angle, `mu`. Rows are indexed by `u = sqrt(altitude / exosphere_altitude)` and columns by `v = (1 + sign(mu) * sqrt(abs(mu))) / 2`, each on `[0, 1]`, so that samples are densest near the ground and the horizon, where optical depth varies fastest. Sample `(i, j)` lies at `u = i / (rows - 1)`, `v = j / (columns - 1)`; a shader sampling the table as a texture with linear filtering should therefore remap each coordinate `x` of `n` texels to `(x * (n - 1) + 0.5) / n`.
+ *
+ * As with optical_depth(), rays which intersect the planet are integrated through it, where particle density increases exponentially with depth, so that transmittance falls smoothly to zero below the horizon. Optical depths are clamped to the largest finite value of @p T.
+ *
+ * @tparam T Scalar type of the table samples.
+ */
+template <class T>
+class optical_depth_table
+{
+public:
+	/// Constructs an empty table.
+	optical_depth_table();
+	
+	/**
+	 * Integrates the optical depths of the table samples.
+	 *
+	 * @param radius Radius of the planet.
+	 * @param exosphere_altitude Altitude of the exosphere.
+	 * @param rayleigh_scale_height Scale height of Rayleigh particles.
+	 * @param mie_scale_height Scale height of Mie particles.
+	 * @param rows Number of altitude samples.
+	 * @param columns Number of zenith angle samples.
+	 */
+	void generate(double radius, double exosphere_altitude, double rayleigh_scale_height, double mie_scale_height, std::size_t rows, std::size_t columns);
+	
+	/**
+	 * Bilinearly interpolates the optical depths of the table.
+	 *
+	 * @param altitude Altitude of the ray origin, clamped to `[0, exosphere_altitude]`.
+	 * @param cos_zenith Cosine of the angle between the ray direction and the zenith.
+	 * @return Rayleigh (x) and Mie (y) optical depths between the ray origin and the exosphere.
+	 */
+	math::vector2<T> lookup(T altitude, T cos_zenith) const;
+	
+	/// Returns the number of altitude samples.
+	std::size_t get_rows() const;
+	
+	/// Returns the number of zenith angle samples.
+	std::size_t get_columns() const;
+	
+	/// Returns the interleaved Rayleigh and Mie optical depths of the table samples, in rows of increasing altitude.
+	const std::vector<T>& get_data() const;
+	
+private:
+	/// Number of Gauss-Legendre nodes by which each sample is integrated.
+	static constexpr std::size_t sample_nodes = 16;
+	
+	double exosphere_altitude;
+	std::size_t rows;
+	std::size_t columns;
+	std::vector<T> data;
+};
+
+template <class T>
+optical_depth_table<T>::optical_depth_table():
+	exosphere_altitude(0),
+	rows(0),
+	columns(0)
+{}
+
+template <class T>
+void optical_depth_table<T>::generate(double radius, double exosphere_altitude, double rayleigh_scale_height, double mie_scale_height, std::size_t rows, std::size_t columns)
+{
+	this->exosphere_altitude = exosphere_altitude;
+	this->rows = std::max<std::size_t>(rows, 2);
+	this->columns = std::max<std::size_t>(columns, 2);
+	data.resize(this->rows * this->columns * 2);
+	
+	const double exosphere_radius = radius + exosphere_altitude;
+	const double max_depth = static_cast<double>(std::numeric_limits<T>::max());
+	
+	T* sample = data.data();
+	for (std::size_t i = 0; i < this->rows; ++i)
+	{
+		const double u = static_cast<double>(i) / static_cast<double>(this->rows - 1);
+		const double altitude = u * u * exosphere_altitude;
+		const math::vector3<double> origin = {0.0, radius + altitude, 0.0};
+		
+		for (std::size_t j = 0; j < this->columns; ++j)
+		{
+			const double v = static_cast<double>(j) / static_cast<double>(this->columns - 1) * 2.0 - 1.0;
+			const double mu = std::copysign(v * v, v);
+			const math::vector3<double> direction = {std::sqrt(std::max(0.0, 1.0 - mu * mu)), mu, 0.0};
+			
+			// Find the exit of the ray from the exosphere, within which the ray origin lies
+			const double b = origin.y * mu;
+			const double exit_distance = -b + std::sqrt(std::max(0.0, b * b - origin.y * origin.y + exosphere_radius * exosphere_radius));
+			const math::vector3<double> exit = origin + direction * exit_distance;
+			
+			// Optical depths of rays through the planet grow without bound, and are clamped so that they remain finite when interpolated
+			*(sample++) = static_cast<T>(std::min<double>(max_depth, optical_depth<sample_nodes>(origin, exit, radius, rayleigh_scale_height)));
+			*(sample++) = static_cast<T>(std::min<double>(max_depth, optical_depth<sample_nodes>(origin, exit, radius, mie_scale_height)));
+		}
+	}
+}
+
+template <class T>
+math::vector2<T> optical_depth_table<T>::lookup(T altitude, T cos_zenith) const
+{
+	if (data.empty())
+		return {T(0), T(0)};
+	
+	const T u = std::sqrt(std::min<T>(T(1), std::max<T>(T(0), altitude / static_cast<T>(exosphere_altitude))));
+	const T mu = std::min<T>(T(1), std::max<T>(T(-1), cos_zenith));
+	const T v = (T(1) + std::copysign(std::sqrt(std::abs(mu)), mu)) * T(0.5);
+	
+	math::vector2<T> depth;
+	sample_table<2>(data.data(), rows, columns, u, v, &depth[0]);
+	
+	return depth;
+}
+
+template <class T>
+inline std::size_t optical_depth_table<T>::get_rows() const
+{
+	return rows;
+}
+
+template <class T>
+inline std::size_t optical_depth_table<T>::get_columns() const
+{
+	return columns;
+}
+
+template <class T>
+inline const std::vector<T>& optical_depth_table<T>::get_data() const
+{
+	return data;
+}
+
+/// Ratio of the Mie extinction coefficient to the Mie scattering coefficient.
+template <class T>
+constexpr T mie_extinction_ratio = T(1.1);
+
+/// Scattering properties of an atmosphere, from which its scattering tables are integrated.
+struct scattering_parameters
+{
+	/// Radius of the planet, in meters.
+	double radius;
+	
+	/// Altitude of the exosphere, in meters.
+	double exosphere_altitude;
+	
+	/// Rayleigh scale height, in meters.
+	double rayleigh_scale_height;
+	
+	/// Mie scale height, in meters.
+	double mie_scale_height;
+	
+	/// Rayleigh scattering coefficients at sea level.
+	math::vector3<double> rayleigh_scattering;
+	
+	/// Mie scattering coefficients at sea level.
+	math::vector3<double> mie_scattering;
+	
+	/// Mie phase function anisotropy factor.
+	double mie_anisotropy;
+};
+
+/**
+ * Table of the isotropic multiple scattering contributions of an atmosphere, by altitude and by the cosine of the sun's zenith angle.
+ *
+ * Multiple scattering is approximated as in Hillaire's "A Scalable and Production Ready Sky and Atmosphere Rendering Technique": second-order scattering of unit illuminance, gathered isotropically over the sphere of directions around a point, is scaled by `1 / (1 - f)`, where `f` is the fraction of light transferred by each further order. Samples are multiplied by the scattering coefficients at a point to give the luminance scattered toward any direction from all orders beyond the first. Rows are indexed by `u = altitude / exosphere_altitude`, and columns by `v = (1 + cos_sun_zenith) / 2`, with sample `(i, j)` at `u = i / (rows - 1)`, `v = j / (columns - 1)`.
+ *
+ * @tparam T Scalar type of the table samples.
+ *
+ * @see https://sebh.github.io/publications/egsr2020.pdf
+ */
+template <class T>
+class multiple_scattering_table
+{
+public:
+	/// Constructs an empty table.
+	multiple_scattering_table();
+	
+	/**
+	 * Integrates the multiple scattering contributions of the table samples.
+	 *
+	 * @param parameters Scattering parameters of the atmosphere.
+	 * @param optical_depths Optical depth table of the atmosphere, by which sunlight is attenuated.
+	 * @param rows Number of altitude samples.
+	 * @param columns Number of sun zenith angle samples.
+	 */
+	void generate(const scattering_parameters& parameters, const optical_depth_table<T>& optical_depths, std::size_t rows, std::size_t columns);
+	
+	/**
+	 * Bilinearly interpolates the multiple scattering contributions of the table.
+	 *
+	 * @param altitude Altitude of the scattering point, clamped to `[0, exosphere_altitude]`.
+	 * @param cos_sun_zenith Cosine of the angle between the sun direction and the zenith at the scattering point.
+	 * @return Multiple scattering contribution, per unit of scattering coefficient and of sun illuminance.
+	 */
+	math::vector3<T> lookup(T altitude, T cos_sun_zenith) const;
+	
+	/// Returns the number of altitude samples.
+	std::size_t get_rows() const;
+	
+	/// Returns the number of sun zenith angle samples.
+	std::size_t get_columns() const;
+	
+	/// Returns the interleaved RGB multiple scattering contributions of the table samples, in rows of increasing altitude.
+	const std::vector<T>& get_data() const;
+	
+private:
+	/// Number of directions over which scattered light is gathered at each sample.
+	static constexpr std::size_t sample_directions = 64;
+	
+	/// Number of ray marching steps along each direction.
+	static constexpr std::size_t sample_steps = 16;
+	
+	double exosphere_altitude;
+	std::size_t rows;
+	std::size_t columns;
+	std::vector<T> data;
+};
+
+/**
+ * Table of the luminance of the sky around an observer, per unit of sun illuminance, including single and multiple scattering.
+ *
+ * The sky is parameterized relative to the sun, about which it is symmetric: columns are indexed by `u = sqrt(azimuth / pi)`, where `azimuth` is the angle between the view and sun directions projected onto the horizontal plane, and rows by `v = (1 + sign(elevation) * sqrt(abs(elevation) / (pi / 2))) / 2`, where `elevation` is the angle of the view direction above the horizontal plane. Both mappings concentrate samples where the sky varies fastest, around the sun and the horizon. Sample `(i, j)` lies at `v = i / (rows - 1)`, `u = j / (columns - 1)`. As the table depends only on the altitude of the observer and on the elevation of the sun, it need only be regenerated when either changes.
+ *
+ * @tparam T Scalar type of the table samples.
+ *
+ * @see https://sebh.github.io/publications/egsr2020.pdf
+ */
+template <class T>
+class sky_view_table
+{
+public:
+	/// Constructs an empty table.
+	sky_view_table();
+	
+	/**
+	 * Ray marches the sky luminance of the table samples.
+	 *
+	 * @param parameters Scattering parameters of the atmosphere.
+	 * @param optical_depths Optical depth table of the atmosphere.
+	 * @param multiple_scattering Multiple scattering table of the atmosphere.
+	 * @param altitude Altitude of the observer, clamped to `[0, exosphere_altitude]`.
+	 * @param cos_sun_zenith Cosine of the angle between the sun direction and the observer's zenith.
+	 * @param rows Number of elevation samples.
+	 * @param columns Number of azimuth samples.
+	 */
+	void generate(const scattering_parameters& parameters, const optical_depth_table<T>& optical_depths, const multiple_scattering_table<T>& multiple_scattering, double altitude, double cos_sun_zenith, std::size_t rows, std::size_t columns);
+	
+	/// Returns the altitude of the observer for which the table was generated.
+	double get_altitude() const;
+	
+	/// Returns the cosine of the sun zenith angle for which the table was generated.
+	double get_cos_sun_zenith() const;
+	
+	/// Returns the number of elevation samples.
+	std::size_t get_rows() const;
+	
+	/// Returns the number of azimuth samples.
+	std::size_t get_columns() const;
+	
+	/// Returns the interleaved RGB luminance of the table samples, in rows of increasing elevation.
+	const std::vector<T>& get_data() const;
+	
+private:
+	/// Number of ray marching steps along each view direction.
+	static constexpr std::size_t sample_steps = 24;
+	
+	double altitude;
+	double cos_sun_zenith;
+	std::size_t rows;
+	std::size_t columns;
+	std::vector<T> data;
+};
+
+/**
+ * Returns the distance from a point in an atmosphere along a ray to the planet, if the ray intersects it, or otherwise to the exosphere.
+ *
+ * @param radius Radius of the planet.
+ * @param exosphere_radius Radius of the exosphere.
+ * @param r Distance from the center of the planet to the ray origin, on `[radius, exosphere_radius]`.
+ * @param mu Cosine of the angle between the ray direction and the zenith at the ray origin.
+ */
+inline double ray_length(double radius, double exosphere_radius, double r, double mu)
+{
+	const double b = r * mu;
+	
+	const double planet_discriminant = b * b - r * r + radius * radius;
+	if (mu < 0.0 && planet_discriminant >= 0.0)
+		return std::max(0.0, -b - std::sqrt(planet_discriminant));
+	
+	return std::max(0.0, -b + std::sqrt(std::max(0.0, b * b - r * r + exosphere_radius * exosphere_radius)));
+}
+
+/**
+ * Returns the transmittance of sunlight from the exosphere to a point in an atmosphere.
+ *
+ * @param parameters Scattering parameters of the atmosphere.
+ * @param optical_depths Optical depth table of the atmosphere.
+ * @param altitude Altitude of the point.
+ * @param cos_sun_zenith Cosine of the angle between the sun direction and the zenith at the point.
+ */
+template <class T>
+math::vector3<double> sun_transmittance(const scattering_parameters& parameters, const optical_depth_table<T>& optical_depths, double altitude, double cos_sun_zenith)
+{
+	const math::vector2<T> depth = optical_depths.lookup(static_cast<T>(altitude), static_cast<T>(cos_sun_zenith));
+	const math::vector3<double> tau = parameters.rayleigh_scattering * static_cast<double>(depth.x) + parameters.mie_scattering * (mie_extinction_ratio<double> * static_cast<double>(depth.y));
+	return {std::exp(-tau.x), std::exp(-tau.y), std::exp(-tau.z)};
+}
+
+template <class T>
+multiple_scattering_table<T>::multiple_scattering_table():
+	exosphere_altitude(0),
+	rows(0),
+	columns(0)
+{}
+
+template <class T>
+void multiple_scattering_table<T>::generate(const scattering_parameters& parameters, const optical_depth_table<T>& optical_depths, std::size_t rows, std::size_t columns)
+{
+	exosphere_altitude = parameters.exosphere_altitude;
+	this->rows = std::max<std::size_t>(rows, 2);
+	this->columns = std::max<std::size_t>(columns, 2);
+	data.resize(this->rows * this->columns * 3);
+	
+	const double exosphere_radius = parameters.radius + parameters.exosphere_altitude;
+	const double isotropic_phase = 1.0 / (4.0 * math::pi<double>);
+	
+	// Distribute gathering directions uniformly over the sphere, on a Fibonacci lattice
+	std::array<math::vector3<double>, sample_directions> directions;
+	for (std::size_t k = 0; k < sample_directions; ++k)
+	{
+		const double z = 1.0 - (2.0 * static_cast<double>(k) + 1.0) / static_cast<double>(sample_directions);
+		const double r = std::sqrt(std::max(0.0, 1.0 - z * z));
+		const double phi = static_cast<double>(k) * math::pi<double> * (3.0 - std::sqrt(5.0));
+		directions[k] = {r * std::cos(phi), z, r * std::sin(phi)};
+	}
+	
+	T* sample = data.data();
+	for (std::size_t i = 0; i < this->rows; ++i)
+	{
+		const double altitude = static_cast<double>(i) / static_cast<double>(this->rows - 1) * parameters.exosphere_altitude;
+		const math::vector3<double> origin = {0.0, parameters.radius + altitude, 0.0};
+		
+		for (std::size_t j = 0; j < this->columns; ++j)
+		{
+			const double mu_s = static_cast<double>(j) / static_cast<double>(this->columns - 1) * 2.0 - 1.0;
+			const math::vector3<double> sun_direction = {std::sqrt(std::max(0.0, 1.0 - mu_s * mu_s)), mu_s, 0.0};
+			
+			math::vector3<double> second_order = {0.0, 0.0, 0.0};
+			math::vector3<double> transfer = {0.0, 0.0, 0.0};
+			
+			for (const math::vector3<double>& direction: directions)
+			{
+				const double dt = ray_length(parameters.radius, exosphere_radius, origin.y, direction.y) / static_cast<double>(sample_steps);
+				math::vector3<double> throughput = {1.0, 1.0, 1.0};
+				
+				for (std::size_t step = 0; step < sample_steps; ++step)
+				{
+					const math::vector3<double> position = origin + direction * ((static_cast<double>(step) + 0.5) * dt);
+					const double r = math::length(position);
+					const double h = r - parameters.radius;
+					
+					const math::vector3<double> scattering_r = parameters.rayleigh_scattering * std::exp(-h / parameters.rayleigh_scale_height);
+					const math::vector3<double> scattering_m = parameters.mie_scattering * std::exp(-h / parameters.mie_scale_height);
+					const math::vector3<double> scattering = scattering_r + scattering_m;
+					const math::vector3<double> extinction = scattering_r + scattering_m * mie_extinction_ratio<double>;
+					const math::vector3<double> step_transmittance = {std::exp(-extinction.x * dt), std::exp(-extinction.y * dt), std::exp(-extinction.z * dt)};
+					
+					// Integrate scattering over the step analytically, assuming constant extinction within it
+					math::vector3<double> step_integral;
+					for (std::size_t c = 0; c < 3; ++c)
+						step_integral[c] = (extinction[c] > 0.0) ? throughput[c] * (1.0 - step_transmittance[c]) / extinction[c] : throughput[c] * dt;
+					
+					const math::vector3<double> sunlight = sun_transmittance(parameters, optical_depths, h, math::dot(position, sun_direction) / r);
+					second_order += step_integral * scattering * sunlight * isotropic_phase;
+					transfer += step_integral * scattering;
+					
+					throughput *= step_transmittance;
+				}
+			}
+			
+			// Average the gathered light with the isotropic phase function, then sum the geometric series of further orders
+			second_order /= static_cast<double>(sample_directions);
+			transfer /= static_cast<double>(sample_directions);
+			for (std::size_t c = 0; c < 3; ++c)
+				*(sample++) = static_cast<T>(second_order[c] / std::max(1e-6, 1.0 - transfer[c]));
+		}
+	}
+}
+
+template <class T>
+math::vector3<T> multiple_scattering_table<T>::lookup(T altitude, T cos_sun_zenith) const
+{
+	if (data.empty())
+		return {T(0), T(0), T(0)};
+	
+	math::vector3<T> result;
+	sample_table<3>(data.data(), rows, columns, altitude / static_cast<T>(exosphere_altitude), (T(1) + cos_sun_zenith) * T(0.5), &result[0]);
+	return result;
+}
+
+template <class T>
+inline std::size_t multiple_scattering_table<T>::get_rows() const
+{
+	return rows;
+}
+
+template <class T>
+inline std::size_t multiple_scattering_table<T>::get_columns() const
+{
+	return columns;
+}
+
+template <class T>
+inline const std::vector<T>& multiple_scattering_table<T>::get_data() const
+{
+	return data;
+}
+
+template <class T>
+sky_view_table<T>::sky_view_table():
+	altitude(0),
+	cos_sun_zenith(0),
+	rows(0),
+	columns(0)
+{}
+
+template <class T>
+void sky_view_table<T>::generate(const scattering_parameters& parameters, const optical_depth_table<T>& optical_depths, const multiple_scattering_table<T>& multiple_scattering, double altitude, double cos_sun_zenith, std::size_t rows, std::size_t columns)
+{
+	this->altitude = altitude;
+	this->cos_sun_zenith = cos_sun_zenith;
+	this->rows = std::max<std::size_t>(rows, 2);
+	this->columns = std::max<std::size_t>(columns, 2);
+	data.resize(this->rows * this->columns * 3);
+	
+	const double exosphere_radius = parameters.radius + parameters.exosphere_altitude;
+	const math::vector3<double> origin = {0.0, parameters.radius + std::min(parameters.exosphere_altitude, std::max(0.0, altitude)), 0.0};
+	const double mu_s = std::min(1.0, std::max(-1.0, cos_sun_zenith));
+	const math::vector3<double> sun_direction = {std::sqrt(1.0 - mu_s * mu_s), mu_s, 0.0};
+	
+	T* sample = data.data();
+	for (std::size_t i = 0; i < this->rows; ++i)
+	{
+		const double v = static_cast<double>(i) / static_cast<double>(this->rows - 1) * 2.0 - 1.0;
+		const double elevation = std::copysign(v * v, v) * math::half_pi<double>;
+		const double cos_elevation = std::cos(elevation);
+		const double sin_elevation = std::sin(elevation);
+		
+		for (std::size_t j = 0; j < this->columns; ++j)
+		{
+			const double u = static_cast<double>(j) / static_cast<double>(this->columns - 1);
+			const double azimuth = u * u * math::pi<double>;
+			const math::vector3<double> direction = {cos_elevation * std::cos(azimuth), sin_elevation, cos_elevation * std::sin(azimuth)};
+			
+			// Evaluate phase functions, which are constant along the ray
+			const double nu = math::dot(direction, sun_direction);
+			const double phase_r = physics::light::phase::rayleigh<double>(nu);
+			const double phase_m = physics::light::phase::cornette_shanks<double>(nu, parameters.mie_anisotropy);
+			
+			const double dt = ray_length(parameters.radius, exosphere_radius, origin.y, direction.y) / static_cast<double>(sample_steps);
+			math::vector3<double> throughput = {1.0, 1.0, 1.0};
+			math::vector3<double> luminance = {0.0, 0.0, 0.0};
+			
+			for (std::size_t step = 0; step < sample_steps; ++step)
+			{
+				const math::vector3<double> position = origin + direction * ((static_cast<double>(step) + 0.5) * dt);
+				const double r = math::length(position);
+				const double h = r - parameters.radius;
+				const double mu_s_position = math::dot(position, sun_direction) / r;
+				
+				const math::vector3<double> scattering_r = parameters.rayleigh_scattering * std::exp(-h / parameters.rayleigh_scale_height);
+				const math::vector3<double> scattering_m = parameters.mie_scattering * std::exp(-h / parameters.mie_scale_height);
+				const math::vector3<double> extinction = scattering_r + scattering_m * mie_extinction_ratio<double>;
+				const math::vector3<double> step_transmittance = {std::exp(-extinction.x * dt), std::exp(-extinction.y * dt), std::exp(-extinction.z * dt)};
+				
+				const math::vector3<double> sunlight = sun_transmittance(parameters, optical_depths, h, mu_s_position);
+				const math::vector3<T> multiple = multiple_scattering.lookup(static_cast<T>(h), static_cast<T>(mu_s_position));
+				const math::vector3<double> multiple_scattered = {static_cast<double>(multiple.x), static_cast<double>(multiple.y), static_cast<double>(multiple.z)};
+				
+				const math::vector3<double> source = sunlight * (scattering_r * phase_r + scattering_m * phase_m) + (scattering_r + scattering_m) * multiple_scattered;
+				
+				// Integrate in-scattered light over the step analytically, assuming constant extinction within it
+				for (std::size_t c = 0; c < 3; ++c)
+					luminance[c] += (extinction[c] > 0.0) ? throughput[c] * source[c] * (1.0 - step_transmittance[c]) / extinction[c] : throughput[c] * source[c] * dt;
+				
+				throughput *= step_transmittance;
+			}
+			
+			*(sample++) = static_cast<T>(luminance.x);
+			*(sample++) = static_cast<T>(luminance.y);
+			*(sample++) = static_cast<T>(luminance.z);
+		}
+	}
+}
+
+template <class T>
+inline double sky_view_table<T>::get_altitude() const
+{
+	return altitude;
+}
+
+template <class T>
+inline double sky_view_table<T>::get_cos_sun_zenith() const
+{
+	return cos_sun_zenith;
+}
+
+template <class T>
+inline std::size_t sky_view_table<T>::get_rows() const
+{
+	return rows;
+}
+
+template <class T>
+inline std::size_t sky_view_table<T>::get_columns() const
+{
+	return columns;
+}
+
+template <class T>
+inline const std::vector<T>& sky_view_table<T>::get_data() const
+{
+	return data;
+}
+
 } // namespace atmosphere
 
 } // namespace physics
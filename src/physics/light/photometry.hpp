@@ -22,6 +22,7 @@
 
 #include "math/constants.hpp"
 #include "math/quadrature.hpp"
+#include <cstddef>
 
 namespace physics {
 namespace light {
@@ -55,6 +56,30 @@ T luminous_efficiency(UnaryOp1 spd, UnaryOp2 lef, InputIt first, InputIt last)
 	return num / den;
 }
 
+/**
+ * Calculates the luminous efficiency of a light source using N-point Gauss-Legendre quadrature.
+ *
+ * @tparam N Number of samples per interval.
+ * @param spd Unary function object that returns spectral radiance given a wavelength.
+ * @param lef Unary function object that returns luminous efficiency given a wavelength.
+ * @param a,b Range of wavelengths.
+ * @param intervals Number of equal intervals into which the range of wavelengths is divided.
+ * @return Luminous efficiency, on `[0, 1]`.
+ */
+template <std::size_t N, class T, class UnaryOp1, class UnaryOp2>
+T luminous_efficiency(UnaryOp1 spd, UnaryOp2 lef, T a, T b, std::size_t intervals = 1)
+{
+	auto spd_lef = [spd, lef](T x) -> T
+	{
+		return spd(x) * lef(x);
+	};
+	
+	const T num = math::quadrature::gauss<N>(spd_lef, a, b, intervals);
+	const T den = math::quadrature::gauss<N>(spd, a, b, intervals);
+	
+	return num / den;
+}
+
 /**
  * Calculates luminous efficacy given luminous efficiency.
  *
@@ -0,0 +1,215 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ANTKEEPER_PHYSICS_ORBIT_EPHEMERIS_HPP
+#define ANTKEEPER_PHYSICS_ORBIT_EPHEMERIS_HPP
+
+#include "physics/orbit/state.hpp"
+#include <cstddef>
+#include <vector>
+
+namespace physics {
+namespace orbit {
+
+/**
+ * Table of the orbital states of a number of bodies, sampled at uniformly-spaced times, between which states are interpolated by cubic Hermite polynomials.
+ *
+ * As each sample contains both the position and velocity of a body, interpolated positions and velocities are continuous across samples, and interpolation error falls with the fourth power of the sampling interval.
+ *
+ * @tparam T Scalar type.
+ */
+template <class T>
+class ephemeris
+{
+public:
+	/// Scalar type.
+	typedef T scalar_type;
+	
+	/// Orbital state type.
+	typedef physics::orbit::state<T> state_type;
+	
+	/// Creates an empty ephemeris, which contains no times.
+	ephemeris();
+	
+	/**
+	 * Resizes the ephemeris. The states of all samples are left unspecified.
+	 *
+	 * @param start Time of the first sample.
+	 * @param step Time between samples.
+	 * @param body_count Number of bodies.
+	 * @param sample_count Number of samples per body, at least two.
+	 */
+	void resize(scalar_type start, scalar_type step, std::size_t body_count, std::size_t sample_count);
+	
+	/// Removes all samples.
+	void clear();
+	
+	/// Returns `true` if the time @p t lies between the first and last samples.
+	bool contains(scalar_type t) const;
+	
+	/**
+	 * Interpolates the orbital state of a body.
+	 *
+	 * @param body Index of the body.
+	 * @param t Time, between the first and last samples.
+	 * @return Interpolated orbital state.
+	 */
+	state_type interpolate(std::size_t body, scalar_type t) const;
+	
+	/// Returns the time of the first sample.
+	scalar_type get_start() const;
+	
+	/// Returns the time of the last sample.
+	scalar_type get_end() const;
+	
+	/// Returns the time between samples.
+	scalar_type get_step() const;
+	
+	/// Returns the number of bodies.
+	std::size_t get_body_count() const;
+	
+	/// Returns the number of samples per body.
+	std::size_t get_sample_count() const;
+	
+	/// Returns the orbital states of all samples, in rows of samples per body.
+	state_type* get_states();
+	
+	/// @copydoc ephemeris::get_states()
+	const state_type* get_states() const;
+	
+private:
+	scalar_type start;
+	scalar_type step;
+	std::size_t body_count;
+	std::size_t sample_count;
+	std::vector<state_type> states;
+};
+
+template <class T>
+ephemeris<T>::ephemeris():
+	start(0),
+	step(0),
+	body_count(0),
+	sample_count(0)
+{}
+
+template <class T>
+void ephemeris<T>::resize(scalar_type start, scalar_type step, std::size_t body_count, std::size_t sample_count)
+{
+	this->start = start;
+	this->step = step;
+	this->body_count = body_count;
+	this->sample_count = sample_count;
+	states.resize(body_count * sample_count);
+}
+
+template <class T>
+void ephemeris<T>::clear()
+{
+	body_count = 0;
+	sample_count = 0;
+	states.clear();
+}
+
+template <class T>
+bool ephemeris<T>::contains(scalar_type t) const
+{
+	return sample_count > 1 && t >= start && t <= get_end();
+}
+
+template <class T>
+typename ephemeris<T>::state_type ephemeris<T>::interpolate(std::size_t body, scalar_type t) const
+{
+	// Find the interval which contains t, and the position of t within it
+	const scalar_type x = (t - start) / step;
+	std::size_t k = (x > scalar_type(0)) ? static_cast<std::size_t>(x) : 0;
+	k = (k < sample_count - 1) ? k : sample_count - 2;
+	const scalar_type s = x - static_cast<scalar_type>(k);
+	
+	const state_type& a = states[body * sample_count + k];
+	const state_type& b = states[body * sample_count + k + 1];
+	
+	const scalar_type s2 = s * s;
+	const scalar_type s3 = s2 * s;
+	
+	// Cubic Hermite basis functions
+	const scalar_type h00 = scalar_type(2) * s3 - scalar_type(3) * s2 + scalar_type(1);
+	const scalar_type h10 = (s3 - scalar_type(2) * s2 + s) * step;
+	const scalar_type h01 = scalar_type(3) * s2 - scalar_type(2) * s3;
+	const scalar_type h11 = (s3 - s2) * step;
+	
+	// Derivatives of the basis functions, with respect to t
+	const scalar_type dh00 = (scalar_type(6) * s2 - scalar_type(6) * s) / step;
+	const scalar_type dh10 = scalar_type(3) * s2 - scalar_type(4) * s + scalar_type(1);
+	const scalar_type dh01 = -dh00;
+	const scalar_type dh11 = scalar_type(3) * s2 - scalar_type(2) * s;
+	
+	return state_type
+	{
+		a.r * h00 + a.v * h10 + b.r * h01 + b.v * h11,
+		a.r * dh00 + a.v * dh10 + b.r * dh01 + b.v * dh11
+	};
+}
+
+template <class T>
+inline typename ephemeris<T>::scalar_type ephemeris<T>::get_start() const
+{
+	return start;
+}
+
+template <class T>
+inline typename ephemeris<T>::scalar_type ephemeris<T>::get_end() const
+{
+	return start + step * static_cast<scalar_type>(sample_count - 1);
+}
+
+template <class T>
+inline typename ephemeris<T>::scalar_type ephemeris<T>::get_step() const
+{
+	return step;
+}
+
+template <class T>
+inline std::size_t ephemeris<T>::get_body_count() const
+{
+	return body_count;
+}
+
+template <class T>
+inline std::size_t ephemeris<T>::get_sample_count() const
+{
+	return sample_count;
+}
+
+template <class T>
+inline typename ephemeris<T>::state_type* ephemeris<T>::get_states()
+{
+	return states.data();
+}
+
+template <class T>
+inline const typename ephemeris<T>::state_type* ephemeris<T>::get_states() const
+{
+	return states.data();
+}
+
+} // namespace orbit
+} // namespace physics
+
+#endif // ANTKEEPER_PHYSICS_ORBIT_EPHEMERIS_HPP
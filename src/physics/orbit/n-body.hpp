@@ -0,0 +1,510 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef ANTKEEPER_PHYSICS_ORBIT_N_BODY_HPP
+#define ANTKEEPER_PHYSICS_ORBIT_N_BODY_HPP
+
+#include "physics/orbit/state.hpp"
+#include "math/batch.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace physics {
+namespace orbit {
+
+/**
+ * Gravitational n-body system around a fixed central body, integrated with the symplectic leapfrog (kick-drift-kick) integrator, which conserves energy over long integrations and is reversible when time runs backward.
+ *
+ * Each body is attracted by the central body with its own central gravitational parameter, so that an unperturbed body follows the same Keplerian orbit as its orbital elements, and by every other body in proportion to that body's gravitational parameter. Bodies with zero gravitational parameters are test particles, such as the members of an asteroid swarm, which are perturbed by massive bodies but don't perturb one another.
+ *
+ * State vectors are stored as structures of arrays. Accelerations are summed directly, over lanes of bodies with SSE2 or 64-bit NEON instructions if @p T is `double`, unless the number of bodies reaches the Barnes-Hut threshold, beyond which they are approximated by the Barnes-Hut algorithm from an octree of the bodies rebuilt for each evaluation.
+ *
+ * @tparam T Scalar type.
+ */
+template <class T>
+class n_body
+{
+public:
+	typedef math::vector3<T> vector_type;
+	
+	/// Constructs an empty n-body system.
+	n_body();
+	
+	/**
+	 * Adds a body.
+	 *
+	 * @param state Initial state of the body, relative to the central body.
+	 * @param central_gm Gravitational parameter of the central body acting on this body.
+	 * @param gm Gravitational parameter of the body, or `0` for a test particle.
+	 * @return Index of the body.
+	 */
+	std::size_t add(const state<T>& state, T central_gm, T gm);
+	
+	/// Removes all bodies.
+	void clear();
+	
+	/**
+	 * Advances the system through time, in substeps no longer than a maximum step.
+	 *
+	 * @param dt Time by which to advance, which may be negative.
+	 * @param max_step Maximum duration of a substep.
+	 * @param max_substeps Maximum number of substeps, beyond which substeps lengthen, so that high time scales lose accuracy rather than stall.
+	 */
+	void integrate(T dt, T max_step, std::size_t max_substeps);
+	
+	/// Returns the state of a body.
+	state<T> get_state(std::size_t index) const;
+	
+	/// Returns the number of bodies.
+	std::size_t size() const;
+	
+	/**
+	 * Sets the softening length, which limits accelerations between close bodies.
+	 *
+	 * @param length Softening length.
+	 */
+	void set_softening(T length);
+	
+	/**
+	 * Sets the number of bodies at which accelerations are approximated by the Barnes-Hut algorithm.
+	 *
+	 * @param count Barnes-Hut threshold.
+	 */
+	void set_barnes_hut_threshold(std::size_t count);
+	
+	/**
+	 * Sets the Barnes-Hut opening angle, the ratio of node size to distance below which a node acts as a single body.
+	 *
+	 * @param angle Opening angle. Smaller angles are more accurate.
+	 */
+	void set_opening_angle(T angle);
+	
+private:
+	/// Octree node, with the total gravitational parameter and center of mass of its bodies.
+	struct node
+	{
+		T gm;
+		T x;
+		T y;
+		T z;
+		
+		/// Edge length of the node's cube.
+		T size;
+		
+		/// Range of the node's bodies in the body order.
+		std::uint32_t first;
+		std::uint32_t last;
+		
+		/// Index of the node's first child, or `0` if the node is a leaf. Children are consecutive.
+		std::uint32_t children;
+		std::uint32_t child_count;
+	};
+	
+	/// Calculates the accelerations of all bodies.
+	void accelerate();
+	
+	/// Sums the accelerations exerted on all bodies by the central body and every massive body.
+	void accelerate_direct();
+	
+	/// Sums the accelerations exerted on all bodies by the central body, and approximates those exerted by massive bodies with the Barnes-Hut algorithm.
+	void accelerate_barnes_hut();
+	
+	/// Builds an allocated octree node from a range of the body order, within a cube.
+	void build(std::uint32_t index, std::uint32_t first, std::uint32_t last, T cx, T cy, T cz, T half_size, std::size_t depth);
+	
+	std::vector<T> x, y, z;
+	std::vector<T> vx, vy, vz;
+	std::vector<T> ax, ay, az;
+	std::vector<T> gm;
+	std::vector<T> central_gm;
+	
+	/// `true` if the accelerations are those of the current positions.
+	bool accelerations_valid;
+	
+	T softening;
+	std::size_t barnes_hut_threshold;
+	T opening_angle;
+	
+	/// Indices of the massive bodies, in octree order.
+	std::vector<std::uint32_t> order;
+	std::vector<node> nodes;
+	std::vector<std::uint32_t> stack;
+	
+	/// Maximum number of bodies in an octree leaf.
+	static constexpr std::uint32_t leaf_size = 8;
+	
+	/// Maximum depth of the octree, beyond which coincident bodies share leaves.
+	static constexpr std::size_t max_depth = 32;
+};
+
+template <class T>
+n_body<T>::n_body():
+	accelerations_valid(false),
+	softening(T(0)),
+	barnes_hut_threshold(512),
+	opening_angle(T(0.5))
+{}
+
+template <class T>
+std::size_t n_body<T>::add(const state<T>& state, T central_gm, T gm)
+{
+	x.push_back(state.r.x);
+	y.push_back(state.r.y);
+	z.push_back(state.r.z);
+	vx.push_back(state.v.x);
+	vy.push_back(state.v.y);
+	vz.push_back(state.v.z);
+	this->gm.push_back(gm);
+	this->central_gm.push_back(central_gm);
+	
+	accelerations_valid = false;
+	return x.size() - 1;
+}
+
+template <class T>
+void n_body<T>::clear()
+{
+	for (std::vector<T>* array: {&x, &y, &z, &vx, &vy, &vz, &ax, &ay, &az, &gm, &central_gm})
+		array->clear();
+	accelerations_valid = false;
+}
+
+template <class T>
+void n_body<T>::integrate(T dt, T max_step, std::size_t max_substeps)
+{
+	const std::size_t n = x.size();
+	if (!n || dt == T(0))
+		return;
+	
+	std::size_t substeps = (max_step > T(0)) ? static_cast<std::size_t>(std::ceil(std::abs(dt) / max_step)) : 1;
+	substeps = std::clamp<std::size_t>(substeps, 1, std::max<std::size_t>(max_substeps, 1));
+	const T h = dt / static_cast<T>(substeps);
+	const T half_h = h * T(0.5);
+	
+	if (!accelerations_valid)
+		accelerate();
+	
+	for (std::size_t step = 0; step < substeps; ++step)
+	{
+		// Kick by half a step, then drift by a whole step
+		for (std::size_t i = 0; i < n; ++i)
+		{
+			vx[i] += ax[i] * half_h;
+			vy[i] += ay[i] * half_h;
+			vz[i] += az[i] * half_h;
+			x[i] += vx[i] * h;
+			y[i] += vy[i] * h;
+			z[i] += vz[i] * h;
+		}
+		
+		// Kick by the other half step, with the accelerations at the drifted positions, which are reused by the next step
+		accelerate();
+		for (std::size_t i = 0; i < n; ++i)
+		{
+			vx[i] += ax[i] * half_h;
+			vy[i] += ay[i] * half_h;
+			vz[i] += az[i] * half_h;
+		}
+	}
+}
+
+template <class T>
+inline state<T> n_body<T>::get_state(std::size_t index) const
+{
+	return {{x[index], y[index], z[index]}, {vx[index], vy[index], vz[index]}};
+}
+
+template <class T>
+inline std::size_t n_body<T>::size() const
+{
+	return x.size();
+}
+
+template <class T>
+void n_body<T>::set_softening(T length)
+{
+	softening = length;
+	accelerations_valid = false;
+}
+
+template <class T>
+void n_body<T>::set_barnes_hut_threshold(std::size_t count)
+{
+	barnes_hut_threshold = count;
+	accelerations_valid = false;
+}
+
+template <class T>
+void n_body<T>::set_opening_angle(T angle)
+{
+	opening_angle = angle;
+	accelerations_valid = false;
+}
+
+template <class T>
+void n_body<T>::accelerate()
+{
+	const std::size_t n = x.size();
+	ax.resize(n);
+	ay.resize(n);
+	az.resize(n);
+	
+	if (n >= barnes_hut_threshold)
+		accelerate_barnes_hut();
+	else
+		accelerate_direct();
+	
+	accelerations_valid = true;
+}
+
+template <class T>
+void n_body<T>::accelerate_direct()
+{
+	const std::size_t n = x.size();
+	const T softening_squared = softening * softening;
+	
+	// Gather the massive bodies, as test particles exert no accelerations
+	order.clear();
+	for (std::uint32_t j = 0; j < static_cast<std::uint32_t>(n); ++j)
+		if (gm[j] != T(0))
+			order.push_back(j);
+	
+	math::simd::dispatch_lanes<T>(n, [&](auto lanes, std::size_t i)
+	{
+		typedef decltype(lanes) L;
+		
+		const L px = L::load(x.data() + i);
+		const L py = L::load(y.data() + i);
+		const L pz = L::load(z.data() + i);
+		const L zero = L::broadcast(T(0));
+		
+		// Attraction of the central body
+		const L r2 = px * px + py * py + pz * pz;
+		const L inv_r = L::rsqrt(L::max(r2, L::broadcast(softening_squared)));
+		const L central = -L::load(central_gm.data() + i) * inv_r * inv_r * inv_r;
+		L sx = px * central;
+		L sy = py * central;
+		L sz = pz * central;
+		
+		// Attractions of the massive bodies, a body's attraction on itself vanishing with its separation
+		for (std::uint32_t j: order)
+		{
+			const L dx = L::broadcast(x[j]) - px;
+			const L dy = L::broadcast(y[j]) - py;
+			const L dz = L::broadcast(z[j]) - pz;
+			const L d2 = dx * dx + dy * dy + dz * dz;
+			const L inv_d = L::rsqrt(d2 + L::broadcast(softening_squared));
+			const L s = L::select(zero < d2, L::broadcast(gm[j]) * inv_d * inv_d * inv_d, zero);
+			sx = sx + dx * s;
+			sy = sy + dy * s;
+			sz = sz + dz * s;
+		}
+		
+		sx.store(ax.data() + i);
+		sy.store(ay.data() + i);
+		sz.store(az.data() + i);
+	});
+}
+
+template <class T>
+void n_body<T>::accelerate_barnes_hut()
+{
+	const std::size_t n = x.size();
+	const T softening_squared = softening * softening;
+	
+	// Build an octree of the massive bodies
+	order.clear();
+	T min[3] = {T(0), T(0), T(0)};
+	T max[3] = {T(0), T(0), T(0)};
+	for (std::uint32_t j = 0; j < static_cast<std::uint32_t>(n); ++j)
+	{
+		if (gm[j] == T(0))
+			continue;
+		
+		const T p[3] = {x[j], y[j], z[j]};
+		for (int c = 0; c < 3; ++c)
+		{
+			min[c] = (order.empty()) ? p[c] : std::min(min[c], p[c]);
+			max[c] = (order.empty()) ? p[c] : std::max(max[c], p[c]);
+		}
+		order.push_back(j);
+	}
+	
+	nodes.clear();
+	if (!order.empty())
+	{
+		const T half_size = std::max({max[0] - min[0], max[1] - min[1], max[2] - min[2]}) * T(0.5);
+		nodes.emplace_back();
+		build(0, 0, static_cast<std::uint32_t>(order.size()), (min[0] + max[0]) * T(0.5), (min[1] + max[1]) * T(0.5), (min[2] + max[2]) * T(0.5), half_size, 0);
+	}
+	
+	const T opening_angle_squared = opening_angle * opening_angle;
+	for (std::size_t i = 0; i < n; ++i)
+	{
+		const T px = x[i];
+		const T py = y[i];
+		const T pz = z[i];
+		
+		// Attraction of the central body
+		const T r2 = std::max(px * px + py * py + pz * pz, softening_squared);
+		const T central = -central_gm[i] / (r2 * std::sqrt(r2));
+		T sx = px * central;
+		T sy = py * central;
+		T sz = pz * central;
+		
+		// Attractions of the massive bodies, with distant nodes acting as single bodies
+		stack.clear();
+		if (!nodes.empty())
+			stack.push_back(0);
+		while (!stack.empty())
+		{
+			const node& node = nodes[stack.back()];
+			stack.pop_back();
+			
+			const T dx = node.x - px;
+			const T dy = node.y - py;
+			const T dz = node.z - pz;
+			const T d2 = dx * dx + dy * dy + dz * dz;
+			
+			if (node.children && node.size * node.size >= opening_angle_squared * d2)
+			{
+				for (std::uint32_t child = 0; child < node.child_count; ++child)
+					stack.push_back(node.children + child);
+				continue;
+			}
+			
+			if (!node.children)
+			{
+				// Sum the bodies of leaves directly
+				for (std::uint32_t k = node.first; k < node.last; ++k)
+				{
+					const std::uint32_t j = order[k];
+					const T bx = x[j] - px;
+					const T by = y[j] - py;
+					const T bz = z[j] - pz;
+					const T b2 = bx * bx + by * by + bz * bz;
+					if (b2 <= T(0))
+						continue;
+					
+					const T e2 = b2 + softening_squared;
+					const T s = gm[j] / (e2 * std::sqrt(e2));
+					sx += bx * s;
+					sy += by * s;
+					sz += bz * s;
+				}
+			}
+			else
+			{
+				const T e2 = d2 + softening_squared;
+				const T s = node.gm / (e2 * std::sqrt(e2));
+				sx += dx * s;
+				sy += dy * s;
+				sz += dz * s;
+			}
+		}
+		
+		ax[i] = sx;
+		ay[i] = sy;
+		az[i] = sz;
+	}
+}
+
+template <class T>
+void n_body<T>::build(std::uint32_t index, std::uint32_t first, std::uint32_t last, T cx, T cy, T cz, T half_size, std::size_t depth)
+{
+	nodes[index].first = first;
+	nodes[index].last = last;
+	nodes[index].size = half_size * T(2);
+	nodes[index].children = 0;
+	nodes[index].child_count = 0;
+	
+	if (last - first > leaf_size && depth < max_depth)
+	{
+		// Partition the bodies into octants, by x, then by y, then by z
+		auto begin = order.begin();
+		auto below = [&](const std::vector<T>& coordinates, T center)
+		{
+			return [&coordinates, center](std::uint32_t j){return coordinates[j] < center;};
+		};
+		std::uint32_t bounds[9];
+		bounds[0] = first;
+		bounds[8] = last;
+		bounds[4] = static_cast<std::uint32_t>(std::partition(begin + bounds[0], begin + bounds[8], below(x, cx)) - begin);
+		for (int i = 0; i < 2; ++i)
+			bounds[2 + i * 4] = static_cast<std::uint32_t>(std::partition(begin + bounds[i * 4], begin + bounds[i * 4 + 4], below(y, cy)) - begin);
+		for (int i = 0; i < 4; ++i)
+			bounds[1 + i * 2] = static_cast<std::uint32_t>(std::partition(begin + bounds[i * 2], begin + bounds[i * 2 + 2], below(z, cz)) - begin);
+		
+		// Allocate the nonempty children consecutively, then build them, their own children following them
+		std::uint32_t octants[8];
+		std::uint32_t child_count = 0;
+		for (std::uint32_t octant = 0; octant < 8; ++octant)
+			if (bounds[octant + 1] > bounds[octant])
+				octants[child_count++] = octant;
+		
+		const std::uint32_t children = static_cast<std::uint32_t>(nodes.size());
+		nodes.resize(nodes.size() + child_count);
+		nodes[index].children = children;
+		nodes[index].child_count = child_count;
+		
+		const T quarter_size = half_size * T(0.5);
+		for (std::uint32_t i = 0; i < child_count; ++i)
+		{
+			const std::uint32_t octant = octants[i];
+			build
+			(
+				children + i,
+				bounds[octant],
+				bounds[octant + 1],
+				cx + ((octant & 4) ? quarter_size : -quarter_size),
+				cy + ((octant & 2) ? quarter_size : -quarter_size),
+				cz + ((octant & 1) ? quarter_size : -quarter_size),
+				quarter_size,
+				depth + 1
+			);
+		}
+	}
+	
+	// Accumulate the total gravitational parameter and center of mass of the node's bodies
+	T total_gm = T(0);
+	T mx = T(0);
+	T my = T(0);
+	T mz = T(0);
+	for (std::uint32_t k = first; k < last; ++k)
+	{
+		const std::uint32_t j = order[k];
+		total_gm += gm[j];
+		mx += x[j] * gm[j];
+		my += y[j] * gm[j];
+		mz += z[j] * gm[j];
+	}
+	nodes[index].gm = total_gm;
+	nodes[index].x = mx / total_gm;
+	nodes[index].y = my / total_gm;
+	nodes[index].z = mz / total_gm;
+}
+
+} // namespace orbit
+} // namespace physics
+
+#endif // ANTKEEPER_PHYSICS_ORBIT_N_BODY_HPP
@@ -32,8 +32,10 @@ namespace orbit {}
 } // namespace physics
 
 #include "physics/orbit/elements.hpp"
+#include "physics/orbit/ephemeris.hpp"
 #include "physics/orbit/frames.hpp"
 #include "physics/orbit/kepler.hpp"
+#include "physics/orbit/n-body.hpp"
 #include "physics/orbit/state.hpp"
 
 #endif // ANTKEEPER_PHYSICS_ORBIT_HPP
@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "renderer/color-grading.hpp"
+#include "math/math.hpp"
+#include <algorithm>
+#include <cmath>
+
+/// Middle grey, around which contrast is applied.
+static constexpr float middle_grey = 0.18f;
+
+/// Fit of the ACES filmic tone mapping curve by Krzysztof Narkowicz.
+static float tone_map(float x)
+{
+	const float y = (x * (2.51f * x + 0.03f)) / (x * (2.43f * x + 0.59f) + 0.14f);
+	return std::min(std::max(y, 0.0f), 1.0f);
+}
+
+float3 grade_color(const color_grading& grading, const float3& color)
+{
+	// Expose and filter
+	float3 x = color * std::exp2(grading.exposure_bias) * grading.color_filter;
+	
+	// Contrast around middle grey in log space
+	for (int i = 0; i < 3; ++i)
+		x[i] = (x[i] > 0.0f) ? middle_grey * std::pow(x[i] / middle_grey, grading.contrast) : 0.0f;
+	
+	// Saturate relative to Rec. 709 luminance
+	const float luminance = math::dot(x, float3{0.2126f, 0.7152f, 0.0722f});
+	for (int i = 0; i < 3; ++i)
+		x[i] = std::max(0.0f, luminance + (x[i] - luminance) * grading.saturation);
+	
+	// Tone map, then lift, gamma correct, and gain
+	for (int i = 0; i < 3; ++i)
+	{
+		float y = tone_map(x[i]);
+		y = grading.gain[i] * (y + grading.lift[i] * (1.0f - y));
+		y = std::pow(std::max(y, 0.0f), 1.0f / std::max(grading.gamma[i], 1e-3f));
+		x[i] = std::min(y, 1.0f);
+	}
+	
+	return x;
+}
+
+void bake_color_grading_lut(const color_grading& grading, std::size_t size, float3* table)
+{
+	// Map the entries of each axis to scene-referred values, spaced evenly in log space
+	const float scale = (color_grading_lut_max_log2 - color_grading_lut_min_log2) / static_cast<float>(std::max<std::size_t>(size, 2) - 1);
+	for (std::size_t z = 0; z < size; ++z)
+	{
+		const float b = std::exp2(color_grading_lut_min_log2 + static_cast<float>(z) * scale);
+		for (std::size_t y = 0; y < size; ++y)
+		{
+			const float g = std::exp2(color_grading_lut_min_log2 + static_cast<float>(y) * scale);
+			for (std::size_t x = 0; x < size; ++x)
+			{
+				const float r = std::exp2(color_grading_lut_min_log2 + static_cast<float>(x) * scale);
+				*(table++) = grade_color(grading, {r, g, b});
+			}
+		}
+	}
+}
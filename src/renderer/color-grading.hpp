@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef ANTKEEPER_COLOR_GRADING_HPP
+#define ANTKEEPER_COLOR_GRADING_HPP
+
+#include "utility/fundamental-types.hpp"
+#include <cstddef>
+
+/**
+ * Parameters of the tone mapping and color grading of the final pass, which are baked into a 3D lookup table.
+ */
+struct color_grading
+{
+	/// Exposure compensation applied before tone mapping, in stops.
+	float exposure_bias{0.0f};
+	
+	/// Scene-referred color by which colors are multiplied before tone mapping.
+	float3 color_filter{1.0f, 1.0f, 1.0f};
+	
+	/// Contrast around middle grey in log space, where `1` leaves colors unchanged.
+	float contrast{1.0f};
+	
+	/// Saturation relative to luminance, where `0` is greyscale and `1` leaves colors unchanged.
+	float saturation{1.0f};
+	
+	/// Display-referred offsets, gammas, and multipliers of the shadows, midtones, and highlights, applied after tone mapping.
+	float3 lift{0.0f, 0.0f, 0.0f};
+	float3 gamma{1.0f, 1.0f, 1.0f};
+	float3 gain{1.0f, 1.0f, 1.0f};
+};
+
+/// Base-2 logarithm of the smallest scene-referred value covered by the color grading lookup table. Smaller values are graded as this value.
+constexpr float color_grading_lut_min_log2 = -10.0f;
+
+/// Base-2 logarithm of the largest scene-referred value covered by the color grading lookup table. Larger values are graded as this value.
+constexpr float color_grading_lut_max_log2 = 6.0f;
+
+/**
+ * Evaluates the tone mapping and color grading of a scene-referred linear color.
+ *
+ * Colors are exposed, filtered, contrasted and saturated in scene-referred space, tone mapped with a fit of the ACES filmic curve, then lifted, gamma corrected, and gained.
+ *
+ * @param grading Color grading parameters.
+ * @param color Scene-referred linear color.
+ * @return Display-referred linear color, on `[0, 1]`.
+ */
+float3 grade_color(const color_grading& grading, const float3& color);
+
+/**
+ * Bakes the tone mapping and color grading of scene-referred colors into a 3D lookup table.
+ *
+ * Each axis of the table spans the base-2 logarithms of scene-referred values from color_grading_lut_min_log2 to color_grading_lut_max_log2, so that a table of a few dozen entries per axis resolves both shadows and highlights.
+ *
+ * @param grading Color grading parameters.
+ * @param size Number of entries along each axis of the table.
+ * @param[out] table Array of `size * size * size` display-referred linear RGB colors, with red varying fastest and blue slowest.
+ */
+void bake_color_grading_lut(const color_grading& grading, std::size_t size, float3* table);
+
+#endif // ANTKEEPER_COLOR_GRADING_HPP
@@ -19,6 +19,10 @@
 
 #include "renderer/compositor.hpp"
 #include "renderer/render-pass.hpp"
+#include "renderer/pass-profiler.hpp"
+#include "debug/profiler.hpp"
+#include "gl/framebuffer.hpp"
+#include <algorithm>
 
 void compositor::add_pass(render_pass* pass)
 {
@@ -35,14 +39,86 @@ void compositor::remove_passes()
 	passes.clear();
 }
 
+void compositor::set_profiler(pass_profiler* profiler)
+{
+	this->profiler = profiler;
+}
+
 void compositor::composite(render_context* context) const
 {
-	for (const render_pass* pass: passes)
+	const bool profiling = (profiler && profiler->is_enabled());
+	
+	schedule();
+	
+	for (const render_pass* pass: scheduled_passes)
 	{
-		if (pass->is_enabled())
+		debug::profile_zone zone(pass->get_name().c_str());
+		
+		if (profiling)
+		{
+			profiler->begin(pass->get_name());
+			pass->render(context);
+			profiler->end();
+		}
+		else
 		{
 			pass->render(context);
 		}
 	}
 }
 
+void compositor::schedule() const
+{
+	scheduled_passes.clear();
+	read_textures.clear();
+	
+	// Walk passes from last to first, so that the readers of each output are known before its writers
+	for (auto it = passes.rbegin(); it != passes.rend(); ++it)
+	{
+		const render_pass* pass = *it;
+		if (!pass->is_enabled() || !is_used(*pass))
+			continue;
+		
+		scheduled_passes.push_back(pass);
+		for (const gl::texture_2d* input: pass->get_inputs())
+		{
+			if (input)
+				read_textures.insert(input);
+		}
+	}
+	
+	std::reverse(scheduled_passes.begin(), scheduled_passes.end());
+}
+
+bool compositor::is_used(const render_pass& pass) const
+{
+	if (pass.has_side_effects())
+		return true;
+	
+	// Passes which render into framebuffers of their own have outputs unknown to the compositor
+	const gl::framebuffer* framebuffer = pass.get_framebuffer();
+	if (!framebuffer)
+		return true;
+	
+	const gl::texture_2d* attachments[] =
+	{
+		framebuffer->get_color_attachment(),
+		framebuffer->get_depth_attachment(),
+		framebuffer->get_stencil_attachment()
+	};
+	
+	// Framebuffers without texture attachments, such as the default framebuffer, are presented
+	bool attached = false;
+	for (const gl::texture_2d* attachment: attachments)
+	{
+		if (!attachment)
+			continue;
+		
+		if (read_textures.count(attachment))
+			return true;
+		attached = true;
+	}
+	
+	return !attached;
+}
+
@@ -21,32 +21,75 @@
 #define ANTKEEPER_COMPOSITOR_HPP
 
 #include <list>
+#include <unordered_set>
+#include <vector>
 
 class render_pass;
+class pass_profiler;
 struct render_context;
 
+namespace gl
+{
+	class texture_2d;
+}
+
 /**
- * 
+ * Executes a sequence of render passes.
+ *
+ * Before compositing, passes are culled from last to first by the textures they read and write. A pass is executed only if it is enabled and has side effects, renders into the default framebuffer, or renders into a texture read by a later executed pass, so that passes whose outputs are unused, such as a bloom pass whose texture is not sampled by the final pass, cost nothing.
  */
 class compositor
 {
 public:
+	compositor();
+	
 	void add_pass(render_pass* pass);
 	void remove_pass(render_pass* pass);
 	void remove_passes();
+	
+	/**
+	 * Sets the profiler which measures the GPU time taken by each pass.
+	 *
+	 * @param profiler Pass profiler, or `nullptr` to disable profiling.
+	 */
+	void set_profiler(pass_profiler* profiler);
 
 	void composite(render_context* context) const;
 
 	const std::list<render_pass*>* get_passes() const;
+	
+	/// Returns the passes executed by the most recent composite, in order of execution.
+	const std::vector<const render_pass*>& get_scheduled_passes() const;
 
 private:
+	/// Culls the passes whose outputs are unused, and fills the schedule with the remaining passes.
+	void schedule() const;
+	
+	/// Returns `true` if the outputs of a pass are used by a later scheduled pass or by the caller of the compositor.
+	bool is_used(const render_pass& pass) const;
+	
 	std::list<render_pass*> passes;
+	pass_profiler* profiler;
+	
+	mutable std::vector<const render_pass*> scheduled_passes;
+	
+	/// Textures read by the scheduled passes, while scheduling.
+	mutable std::unordered_set<const gl::texture_2d*> read_textures;
 };
 
+inline compositor::compositor():
+	profiler(nullptr)
+{}
+
 inline const std::list<render_pass*>* compositor::get_passes() const
 {
 	return &passes;
 }
 
+inline const std::vector<const render_pass*>& compositor::get_scheduled_passes() const
+{
+	return scheduled_passes;
+}
+
 #endif // ANTKEEPER_COMPOSITOR_HPP
 
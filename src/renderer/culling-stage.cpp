@@ -0,0 +1,131 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "renderer/culling-stage.hpp"
+#include <cmath>
+#include <limits>
+
+void culling_stage::clear()
+{
+	center_x.clear();
+	center_y.clear();
+	center_z.clear();
+	extent_x.clear();
+	extent_y.clear();
+	extent_z.clear();
+	radii.clear();
+	planes.clear();
+	volume_offsets.resize(1);
+}
+
+std::size_t culling_stage::add_bounds(const geom::aabb<float>& aabb)
+{
+	return add_bounds((aabb.min_point + aabb.max_point) * 0.5f, (aabb.max_point - aabb.min_point) * 0.5f, 0.0f);
+}
+
+std::size_t culling_stage::add_bounds(const geom::sphere<float>& sphere)
+{
+	return add_bounds(sphere.center, {0.0f, 0.0f, 0.0f}, sphere.radius);
+}
+
+std::size_t culling_stage::add_unbounded()
+{
+	return add_bounds({0.0f, 0.0f, 0.0f}, {0.0f, 0.0f, 0.0f}, std::numeric_limits<float>::infinity());
+}
+
+std::size_t culling_stage::add_bounds(const float3& center, const float3& extents, float radius)
+{
+	center_x.push_back(center.x);
+	center_y.push_back(center.y);
+	center_z.push_back(center.z);
+	extent_x.push_back(extents.x);
+	extent_y.push_back(extents.y);
+	extent_z.push_back(extents.z);
+	radii.push_back(radius);
+	
+	return radii.size() - 1;
+}
+
+std::size_t culling_stage::add_volume(const geom::convex_hull<float>& hull)
+{
+	planes.insert(planes.end(), hull.planes.begin(), hull.planes.end());
+	volume_offsets.push_back(planes.size());
+	
+	return volume_offsets.size() - 2;
+}
+
+void culling_stage::cull()
+{
+	const std::size_t object_count = get_object_count();
+	const std::size_t volume_count = get_volume_count();
+	mask_stride = (object_count + block_size - 1) / block_size;
+	masks.assign(mask_stride * volume_count, 0);
+	
+	// Pad bounds to a whole number of blocks with objects which are never visible
+	const std::size_t padded_count = mask_stride * block_size;
+	for (std::vector<float>* lane: {&center_x, &center_y, &center_z, &extent_x, &extent_y, &extent_z})
+		lane->resize(padded_count, 0.0f);
+	radii.resize(padded_count, -std::numeric_limits<float>::infinity());
+	
+	for (std::size_t i = 0; i < mask_stride; ++i)
+	{
+		const std::size_t first = i * block_size;
+		const float* cx = center_x.data() + first;
+		const float* cy = center_y.data() + first;
+		const float* cz = center_z.data() + first;
+		const float* ex = extent_x.data() + first;
+		const float* ey = extent_y.data() + first;
+		const float* ez = extent_z.data() + first;
+		const float* r = radii.data() + first;
+		
+		// Test the block against every volume while its bounds are in cache
+		for (std::size_t j = 0; j < volume_count; ++j)
+		{
+			std::uint32_t inside[block_size];
+			for (std::size_t k = 0; k < block_size; ++k)
+				inside[k] = 1;
+			
+			for (std::size_t p = volume_offsets[j]; p < volume_offsets[j + 1]; ++p)
+			{
+				const float nx = planes[p].normal.x;
+				const float ny = planes[p].normal.y;
+				const float nz = planes[p].normal.z;
+				const float d = planes[p].distance;
+				const float ax = std::abs(nx);
+				const float ay = std::abs(ny);
+				const float az = std::abs(nz);
+				
+				// Signed distance of the box corner furthest along the plane normal, or of the sphere point furthest along it
+				for (std::size_t k = 0; k < block_size; ++k)
+				{
+					const float distance = nx * cx[k] + ny * cy[k] + nz * cz[k] + d + ax * ex[k] + ay * ey[k] + az * ez[k] + r[k];
+					inside[k] &= static_cast<std::uint32_t>(distance >= 0.0f);
+				}
+			}
+			
+			std::uint32_t word = 0;
+			for (std::size_t k = 0; k < block_size; ++k)
+				word |= inside[k] << k;
+			masks[j * mask_stride + i] = word;
+		}
+	}
+	
+	for (std::vector<float>* lane: {&center_x, &center_y, &center_z, &extent_x, &extent_y, &extent_z, &radii})
+		lane->resize(object_count);
+}
@@ -0,0 +1,144 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ANTKEEPER_CULLING_STAGE_HPP
+#define ANTKEEPER_CULLING_STAGE_HPP
+
+#include "geom/aabb.hpp"
+#include "geom/sphere.hpp"
+#include "geom/convex-hull.hpp"
+#include "utility/fundamental-types.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Tests the bounds of many objects against many convex culling volumes, such as the view frustums of several cameras or the cascades of a shadow map, in a single sweep.
+ *
+ * Bounds are stored as structure-of-arrays centers, extents, and radii, where boxes have zero radius and spheres have zero extents, and are tested against the planes of each volume in blocks of 32 objects with branch-free loops that compile to 4- or 8-wide SIMD. The result of each volume is a bit mask of the objects which intersect it.
+ */
+class culling_stage
+{
+public:
+	/// Number of objects covered by each word of a visibility mask.
+	static constexpr std::size_t block_size = 32;
+	
+	/// Removes all bounds and culling volumes.
+	void clear();
+	
+	/**
+	 * Adds the bounds of an object.
+	 *
+	 * @param aabb Axis-aligned bounding box of the object.
+	 * @return Index of the object.
+	 */
+	std::size_t add_bounds(const geom::aabb<float>& aabb);
+	
+	/**
+	 * Adds the bounds of an object.
+	 *
+	 * @param sphere Bounding sphere of the object.
+	 * @return Index of the object.
+	 */
+	std::size_t add_bounds(const geom::sphere<float>& sphere);
+	
+	/**
+	 * Adds an object which intersects every culling volume, for objects which must be culled by other means.
+	 *
+	 * @return Index of the object.
+	 */
+	std::size_t add_unbounded();
+	
+	/**
+	 * Adds a culling volume.
+	 *
+	 * @param hull Convex hull, inside of which objects are visible.
+	 * @return Index of the volume.
+	 */
+	std::size_t add_volume(const geom::convex_hull<float>& hull);
+	
+	/// Tests all bounds against all culling volumes.
+	void cull();
+	
+	/// Returns the number of objects.
+	std::size_t get_object_count() const;
+	
+	/// Returns the number of culling volumes.
+	std::size_t get_volume_count() const;
+	
+	/**
+	 * Returns the visibility mask of a culling volume, as of the last call to cull(). Bit `i % 32` of word `i / 32` is set if object `i` intersects the volume.
+	 *
+	 * @param volume Index of a culling volume.
+	 */
+	const std::uint32_t* get_visibility_mask(std::size_t volume) const;
+	
+	/**
+	 * Returns `true` if an object intersects a culling volume, as of the last call to cull().
+	 *
+	 * @param volume Index of a culling volume.
+	 * @param object Index of an object.
+	 */
+	bool is_visible(std::size_t volume, std::size_t object) const;
+	
+private:
+	std::size_t add_bounds(const float3& center, const float3& extents, float radius);
+	
+	std::vector<float> center_x;
+	std::vector<float> center_y;
+	std::vector<float> center_z;
+	std::vector<float> extent_x;
+	std::vector<float> extent_y;
+	std::vector<float> extent_z;
+	std::vector<float> radii;
+	
+	/// Planes of all culling volumes, concatenated.
+	std::vector<geom::plane<float>> planes;
+	
+	/// Offsets of the first plane of each culling volume, followed by the total number of planes.
+	std::vector<std::size_t> volume_offsets{0};
+	
+	/// Number of mask words per culling volume.
+	std::size_t mask_stride{0};
+	
+	/// Visibility masks of all culling volumes, concatenated.
+	std::vector<std::uint32_t> masks;
+};
+
+inline std::size_t culling_stage::get_object_count() const
+{
+	return radii.size();
+}
+
+inline std::size_t culling_stage::get_volume_count() const
+{
+	return volume_offsets.size() - 1;
+}
+
+inline const std::uint32_t* culling_stage::get_visibility_mask(std::size_t volume) const
+{
+	return masks.data() + volume * mask_stride;
+}
+
+inline bool culling_stage::is_visible(std::size_t volume, std::size_t object) const
+{
+	return (get_visibility_mask(volume)[object / block_size] >> (object % block_size)) & 1;
+}
+
+#endif // ANTKEEPER_CULLING_STAGE_HPP
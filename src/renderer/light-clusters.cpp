@@ -0,0 +1,191 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "renderer/light-clusters.hpp"
+#include "scene/light.hpp"
+#include "math/math.hpp"
+#include <algorithm>
+#include <cmath>
+
+light_clusters::light_clusters(int tiles_x, int tiles_y, int slices):
+	attenuation_threshold(1.0f / 256.0f),
+	slice_parameters{0.0f, 0.0f}
+{
+	set_resolution(tiles_x, tiles_y, slices);
+}
+
+void light_clusters::set_resolution(int tiles_x, int tiles_y, int slices)
+{
+	resolution = {std::max<int>(1, tiles_x), std::max<int>(1, tiles_y), std::max<int>(1, slices)};
+	cluster_counts.resize(get_cluster_count());
+	clusters.resize(get_cluster_count());
+}
+
+void light_clusters::set_attenuation_threshold(float threshold)
+{
+	attenuation_threshold = threshold;
+}
+
+void light_clusters::clear()
+{
+	lights.clear();
+}
+
+std::size_t light_clusters::add_light(const float3& position, const float3& attenuation)
+{
+	lights.push_back({position, scene::light::attenuation_range(attenuation, attenuation_threshold)});
+	
+	return lights.size() - 1;
+}
+
+void light_clusters::build(const float4x4& view, float fov, float aspect_ratio, float near, float far)
+{
+	const int tiles_x = resolution.x;
+	const int tiles_y = resolution.y;
+	const int slices = resolution.z;
+	const int tile_count = tiles_x * tiles_y;
+	
+	// Calculate depth slice parameters, such that slice = log(depth) * scale + bias
+	const float log_depth_ratio = std::log(far / near);
+	slice_parameters.x = static_cast<float>(slices) / log_depth_ratio;
+	slice_parameters.y = -static_cast<float>(slices) * std::log(near) / log_depth_ratio;
+	
+	// Tangents of the half-angles of the field of view
+	const float tan_y = std::tan(fov * 0.5f);
+	const float tan_x = tan_y * aspect_ratio;
+	
+	// Determine the range of clusters intersected by each light
+	std::fill(cluster_counts.begin(), cluster_counts.end(), 0);
+	light_ranges.resize(lights.size() * 6);
+	for (std::size_t i = 0; i < lights.size(); ++i)
+	{
+		int* range = &light_ranges[i * 6];
+		const light& light = lights[i];
+		
+		// Cull lights without influence
+		if (light.radius <= 0.0f)
+		{
+			range[0] = 0;
+			range[1] = -1;
+			continue;
+		}
+		
+		int x0 = 0;
+		int x1 = tiles_x - 1;
+		int y0 = 0;
+		int y1 = tiles_y - 1;
+		int z0 = 0;
+		int z1 = slices - 1;
+		
+		if (std::isfinite(light.radius))
+		{
+			// Transform light position into view space, where depth is along -z
+			const float3 center = math::resize<3>(view * float4{light.position.x, light.position.y, light.position.z, 1.0f});
+			const float r = light.radius;
+			
+			// Cull lights outside of the depth range
+			float depth_min = -center.z - r;
+			float depth_max = -center.z + r;
+			if (depth_max < near || depth_min > far)
+			{
+				range[0] = 0;
+				range[1] = -1;
+				continue;
+			}
+			depth_min = std::max<float>(depth_min, near);
+			depth_max = std::min<float>(depth_max, far);
+			
+			// Find depth slice range
+			z0 = static_cast<int>(std::log(depth_min) * slice_parameters.x + slice_parameters.y);
+			z1 = static_cast<int>(std::log(depth_max) * slice_parameters.x + slice_parameters.y);
+			
+			// Project the view-space bounding box of the light onto the screen. Maximum coordinates project furthest when nearest, if positive, and vice versa.
+			const float x_min = center.x - r;
+			const float x_max = center.x + r;
+			const float y_min = center.y - r;
+			const float y_max = center.y + r;
+			const float ndc_x_min = x_min / (((x_min < 0.0f) ? depth_min : depth_max) * tan_x);
+			const float ndc_x_max = x_max / (((x_max > 0.0f) ? depth_min : depth_max) * tan_x);
+			const float ndc_y_min = y_min / (((y_min < 0.0f) ? depth_min : depth_max) * tan_y);
+			const float ndc_y_max = y_max / (((y_max > 0.0f) ? depth_min : depth_max) * tan_y);
+			
+			if (ndc_x_max < -1.0f || ndc_x_min > 1.0f || ndc_y_max < -1.0f || ndc_y_min > 1.0f)
+			{
+				range[0] = 0;
+				range[1] = -1;
+				continue;
+			}
+			
+			x0 = static_cast<int>(std::floor((ndc_x_min * 0.5f + 0.5f) * static_cast<float>(tiles_x)));
+			x1 = static_cast<int>(std::floor((ndc_x_max * 0.5f + 0.5f) * static_cast<float>(tiles_x)));
+			y0 = static_cast<int>(std::floor((ndc_y_min * 0.5f + 0.5f) * static_cast<float>(tiles_y)));
+			y1 = static_cast<int>(std::floor((ndc_y_max * 0.5f + 0.5f) * static_cast<float>(tiles_y)));
+			
+			x0 = std::clamp(x0, 0, tiles_x - 1);
+			x1 = std::clamp(x1, 0, tiles_x - 1);
+			y0 = std::clamp(y0, 0, tiles_y - 1);
+			y1 = std::clamp(y1, 0, tiles_y - 1);
+			z0 = std::clamp(z0, 0, slices - 1);
+			z1 = std::clamp(z1, 0, slices - 1);
+		}
+		
+		range[0] = x0;
+		range[1] = x1;
+		range[2] = y0;
+		range[3] = y1;
+		range[4] = z0;
+		range[5] = z1;
+		
+		// Count lights per cluster
+		for (int z = z0; z <= z1; ++z)
+			for (int y = y0; y <= y1; ++y)
+				for (int x = x0; x <= x1; ++x)
+					++cluster_counts[z * tile_count + y * tiles_x + x];
+	}
+	
+	// Calculate offset of each cluster into the light index list
+	std::uint32_t offset = 0;
+	for (std::size_t i = 0; i < cluster_counts.size(); ++i)
+	{
+		clusters[i] = {static_cast<float>(offset), 0.0f};
+		offset += cluster_counts[i];
+	}
+	light_indices.resize(offset);
+	
+	// Fill light index list
+	for (std::size_t i = 0; i < lights.size(); ++i)
+	{
+		const int* range = &light_ranges[i * 6];
+		if (range[1] < range[0])
+			continue;
+		
+		for (int z = range[4]; z <= range[5]; ++z)
+		{
+			for (int y = range[2]; y <= range[3]; ++y)
+			{
+				for (int x = range[0]; x <= range[1]; ++x)
+				{
+					float2& cluster = clusters[z * tile_count + y * tiles_x + x];
+					light_indices[static_cast<std::size_t>(cluster.x + cluster.y)] = static_cast<float>(i);
+					cluster.y += 1.0f;
+				}
+			}
+		}
+	}
+}
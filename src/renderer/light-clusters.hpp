@@ -0,0 +1,162 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ANTKEEPER_LIGHT_CLUSTERS_HPP
+#define ANTKEEPER_LIGHT_CLUSTERS_HPP
+
+#include "utility/fundamental-types.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Assigns lights to a grid of view-space frustum clusters (froxels) for clustered forward shading.
+ *
+ * The view frustum is divided into a grid of screen-space tiles, and each tile is further divided into depth slices which are distributed exponentially between the near and far clipping planes. Each light is assigned to every cluster intersected by the view-space bounding box of its sphere of influence.
+ */
+class light_clusters
+{
+public:
+	/**
+	 * Creates a light cluster grid.
+	 *
+	 * @param tiles_x Number of tiles along the horizontal axis of the screen.
+	 * @param tiles_y Number of tiles along the vertical axis of the screen.
+	 * @param slices Number of depth slices.
+	 */
+	light_clusters(int tiles_x = 16, int tiles_y = 9, int slices = 24);
+	
+	/**
+	 * Sets the resolution of the cluster grid.
+	 *
+	 * @param tiles_x Number of tiles along the horizontal axis of the screen.
+	 * @param tiles_y Number of tiles along the vertical axis of the screen.
+	 * @param slices Number of depth slices.
+	 */
+	void set_resolution(int tiles_x, int tiles_y, int slices);
+	
+	/**
+	 * Sets the attenuation below which a light is considered to have no influence. Determines the radii of lights.
+	 *
+	 * @param threshold Attenuation threshold, on `(0, 1)`.
+	 */
+	void set_attenuation_threshold(float threshold);
+	
+	/// Removes all lights.
+	void clear();
+	
+	/**
+	 * Adds a light.
+	 *
+	 * @param position World-space position of the light.
+	 * @param attenuation Constant, linear, and quadratic attenuation factors of the light.
+	 * @return Index of the light.
+	 */
+	std::size_t add_light(const float3& position, const float3& attenuation);
+	
+	/**
+	 * Assigns all lights to clusters.
+	 *
+	 * @param view View matrix of the camera.
+	 * @param fov Vertical field of view of the camera, in radians.
+	 * @param aspect_ratio Aspect ratio of the camera.
+	 * @param near Distance to the near clipping plane.
+	 * @param far Distance to the far clipping plane.
+	 */
+	void build(const float4x4& view, float fov, float aspect_ratio, float near, float far);
+	
+	/// Returns the number of tiles along each screen axis and the number of depth slices.
+	const int3& get_resolution() const;
+	
+	/// Returns the number of clusters in the grid.
+	std::size_t get_cluster_count() const;
+	
+	/// Returns the number of lights.
+	std::size_t get_light_count() const;
+	
+	/// Returns the radius of influence of a light, or infinity if the light is never fully attenuated.
+	float get_light_radius(std::size_t index) const;
+	
+	/**
+	 * Returns the (offset, count) pair of each cluster into the light index list, ordered by tile x, then tile y, then depth slice. Values are stored as floats for upload to floating-point textures, and are exact up to 2^24.
+	 */
+	const std::vector<float2>& get_clusters() const;
+	
+	/// Returns the concatenated light indices of all clusters.
+	const std::vector<float>& get_light_indices() const;
+	
+	/**
+	 * Returns a scale and bias which map view-space depth to a depth slice index, where `slice = floor(log(depth) * scale + bias)`.
+	 */
+	const float2& get_slice_parameters() const;
+	
+private:
+	struct light
+	{
+		float3 position;
+		float radius;
+	};
+	
+	int3 resolution;
+	float attenuation_threshold;
+	float2 slice_parameters;
+	std::vector<light> lights;
+	std::vector<int> light_ranges;
+	std::vector<std::uint32_t> cluster_counts;
+	std::vector<float2> clusters;
+	std::vector<float> light_indices;
+};
+
+inline const int3& light_clusters::get_resolution() const
+{
+	return resolution;
+}
+
+inline std::size_t light_clusters::get_cluster_count() const
+{
+	return static_cast<std::size_t>(resolution.x * resolution.y * resolution.z);
+}
+
+inline std::size_t light_clusters::get_light_count() const
+{
+	return lights.size();
+}
+
+inline float light_clusters::get_light_radius(std::size_t index) const
+{
+	return lights[index].radius;
+}
+
+inline const std::vector<float2>& light_clusters::get_clusters() const
+{
+	return clusters;
+}
+
+inline const std::vector<float>& light_clusters::get_light_indices() const
+{
+	return light_indices;
+}
+
+inline const float2& light_clusters::get_slice_parameters() const
+{
+	return slice_parameters;
+}
+
+#endif // ANTKEEPER_LIGHT_CLUSTERS_HPP
+
@@ -33,6 +33,8 @@
 #define MATERIAL_FLAG_REFRACTIVE 0x80
 #define MATERIAL_FLAG_DECAL 0x100
 #define MATERIAL_FLAG_DECAL_SURFACE 0x200
+#define MATERIAL_FLAG_NO_DEPTH_PREPASS 0x400
+#define MATERIAL_FLAG_WEIGHTED_BLENDED 0x800
 #define MATERIAL_FLAG_WIREFRAME 0x80000000
 
 #endif // ANTKEEPER_MATERIAL_FLAGS_HPP
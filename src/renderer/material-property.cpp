@@ -19,6 +19,7 @@
 
 #include "renderer/material-property.hpp"
 #include "gl/shader-input.hpp"
+#include <atomic>
 
 material_property_base::material_property_base():
 	input(nullptr)
@@ -41,3 +42,10 @@ void material_property_base::disconnect()
 	this->input = nullptr;
 }
 
+std::uint64_t material_property_base::next_upload_tag()
+{
+	// Tags start at 1, as 0 denotes an unknown uploaded value
+	static std::atomic<std::uint64_t> tag(0);
+	return ++tag;
+}
+
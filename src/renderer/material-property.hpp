@@ -28,7 +28,10 @@
 #include "gl/shader-program.hpp"
 #include "gl/texture-2d.hpp"
 #include "gl/texture-cube.hpp"
+#include "gl/texture-2d-array.hpp"
+#include <cstdint>
 #include <cstdlib>
+#include <type_traits>
 
 class material;
 
@@ -81,6 +84,9 @@ public:
 
 protected:
 	material_property_base();
+	
+	/// Returns a new upload tag, unique across all material properties.
+	static std::uint64_t next_upload_tag();
 
 	const gl::shader_input* input;
 };
@@ -93,6 +99,8 @@ inline bool material_property_base::is_connected() const
 /**
  * A property of a material which can be uploaded to a shader program via a shader input.
  *
+ * Each settled value of the property is given a unique upload tag, which is stored in the shader input along with the uploaded value. The value is not uploaded again while the input's tag matches, so materials which share a shader program only upload the properties which differ between them, and unanimated materials upload nothing once they have been drawn. Properties are unsettled, and uploaded every time, from the moment their values are set until their tweens are next updated. Texture properties are always uploaded, as the texture units to which they are bound are shared between shader programs.
+ *
  * @tparam T Property data type.
  */
 template <class T>
@@ -167,6 +175,9 @@ public:
 	 * @return Value of the element at the specified index.
 	 */
 	const T& get_value(std::size_t index) const;
+	
+	/// Returns the number of elements in the property array.
+	std::size_t get_element_count() const;
 
 	/// @copydoc material_property_base::get_data_type() const
 	virtual gl::shader_variable_type get_data_type() const;
@@ -175,8 +186,17 @@ public:
 	virtual material_property_base* clone() const;
 
 private:
+	/// `true` if uploads of this property type may be skipped.
+	static constexpr bool cacheable = !std::is_pointer<T>::value;
+	
 	std::size_t element_count;
 	tween<T>* values;
+	
+	/// `true` if values have been set since the tweens were last updated, in which case the uploaded value depends on the interpolation factor.
+	bool unsettled;
+	
+	/// Upload tag of the settled values.
+	std::uint64_t upload_tag;
 };
 
 template <typename T>
@@ -212,7 +232,9 @@ inline float4 material_property<float4>::default_interpolator(const float4& x, c
 template <class T>
 material_property<T>::material_property(std::size_t element_count):
 	element_count(element_count),
-	values(nullptr)
+	values(nullptr),
+	unsettled(false),
+	upload_tag(next_upload_tag())
 {
 	values = new tween<T>[element_count];
 	set_tween_interpolator(default_interpolator);
@@ -231,6 +253,13 @@ void material_property<T>::update_tweens()
 	{
 		values[i].update();
 	}
+	
+	// Values are settled until set again, so uploads of the settled values may be skipped
+	if (unsettled)
+	{
+		unsettled = false;
+		upload_tag = next_upload_tag();
+	}
 }
 
 template <class T>
@@ -241,32 +270,43 @@ bool material_property<T>::upload(double a) const
 		return false;
 	}
 	
+	// Skip upload if the input already holds the settled values
+	const bool settled = cacheable && !unsettled;
+	if (settled && input->get_upload_tag() == upload_tag)
+	{
+		return true;
+	}
+	
+	bool uploaded = true;
 	if (element_count > 1)
 	{
-		for (std::size_t i = 0; i < element_count; ++i)
+		for (std::size_t i = 0; i < element_count && uploaded; ++i)
 		{
-			if (!input->upload(i, values[i].interpolate(a)))
-				return false;
+			uploaded = input->upload(i, values[i].interpolate(a));
 		}
-		
-		return true;
 	}
 	else
 	{
-		return input->upload(values[0].interpolate(a));
+		uploaded = input->upload(values[0].interpolate(a));
 	}
+	
+	input->set_upload_tag((settled && uploaded) ? upload_tag : 0);
+	
+	return uploaded;
 }
 
 template <class T>
 void material_property<T>::set_value(const T& value)
 {
 	values[0][1] = value;
+	unsettled = true;
 }
 
 template <class T>
 void material_property<T>::set_value(std::size_t index, const T& value)
 {
 	values[index][1] = value;
+	unsettled = true;
 }
 
 template <class T>
@@ -276,6 +316,7 @@ void material_property<T>::set_values(std::size_t index, const T* values, std::s
 	{
 		this->values[index + i][1] = values[i];
 	}
+	unsettled = true;
 }
 
 template <class T>
@@ -285,6 +326,7 @@ void material_property<T>::set_tween_interpolator(interpolator_type interpolator
 	{
 		this->values[i].set_interpolator(interpolator);
 	}
+	unsettled = true;
 }
 
 template <class T>
@@ -299,6 +341,12 @@ inline const T& material_property<T>::get_value(std::size_t index) const
 	return values[index][1];
 }
 
+template <class T>
+inline std::size_t material_property<T>::get_element_count() const
+{
+	return element_count;
+}
+
 template <>
 inline gl::shader_variable_type material_property<bool>::get_data_type() const
 {
@@ -425,6 +473,12 @@ inline gl::shader_variable_type material_property<const gl::texture_cube*>::get_
 	return gl::shader_variable_type::texture_cube;
 }
 
+template <>
+inline gl::shader_variable_type material_property<const gl::texture_2d_array*>::get_data_type() const
+{
+	return gl::shader_variable_type::texture_2d_array;
+}
+
 template <class T>
 material_property_base* material_property<T>::clone() const
 {
@@ -435,6 +489,7 @@ material_property_base* material_property<T>::clone() const
 		property->values[i][1] = values[i][1];
 	}
 	property->input = input;
+	property->unsettled = unsettled;
 
 	return property;
 }
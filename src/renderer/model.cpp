@@ -48,6 +48,8 @@ model_group* model::add_group(const std::string& name)
 	group->drawing_mode = gl::drawing_mode::triangles;
 	group->start_index = 0;
 	group->index_count = 0;
+	group->indexed = false;
+	group->element_type = gl::element_array_type::uint_32;
 
 	groups.push_back(group);
 
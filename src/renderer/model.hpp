@@ -23,6 +23,7 @@
 #include "gl/vertex-array.hpp"
 #include "gl/vertex-buffer.hpp"
 #include "gl/drawing-mode.hpp"
+#include "gl/element-array-type.hpp"
 #include "geom/aabb.hpp"
 #include <map>
 #include <string>
@@ -41,6 +42,13 @@ public:
 	void set_drawing_mode(gl::drawing_mode mode);
 	void set_start_index(std::size_t index);
 	void set_index_count(std::size_t count);
+	
+	/**
+	 * Draws the group with elements of the element buffer bound to the model's vertex array, in which case the start index and index count refer to elements rather than vertices.
+	 *
+	 * @param type Type of the elements.
+	 */
+	void set_element_type(gl::element_array_type type);
 
 	std::size_t get_index() const;
 	const std::string& get_name() const;
@@ -49,6 +57,8 @@ public:
 	gl::drawing_mode get_drawing_mode() const;
 	std::size_t get_start_index() const;
 	std::size_t get_index_count() const;
+	bool is_indexed() const;
+	gl::element_array_type get_element_type() const;
 
 private:
 	friend class model;
@@ -59,6 +69,8 @@ private:
 	gl::drawing_mode drawing_mode;
 	std::size_t start_index;
 	std::size_t index_count;
+	bool indexed;
+	gl::element_array_type element_type;
 };
 
 inline void model_group::set_material(::material* material)
@@ -116,6 +128,22 @@ inline std::size_t model_group::get_index_count() const
 	return index_count;
 }
 
+inline void model_group::set_element_type(gl::element_array_type type)
+{
+	indexed = true;
+	element_type = type;
+}
+
+inline bool model_group::is_indexed() const
+{
+	return indexed;
+}
+
+inline gl::element_array_type model_group::get_element_type() const
+{
+	return element_type;
+}
+
 /**
  *
  */
@@ -146,6 +174,10 @@ public:
 
 	const gl::vertex_buffer* get_vertex_buffer() const;
 	gl::vertex_buffer* get_vertex_buffer();
+	
+	/// Returns the element buffer of the model, which is bound to its vertex array only if the model is indexed.
+	const gl::vertex_buffer* get_element_buffer() const;
+	gl::vertex_buffer* get_element_buffer();
 
 private:
 	aabb_type bounds;
@@ -153,6 +185,7 @@ private:
 	std::map<std::string, model_group*> group_map;
 	gl::vertex_array vao;
 	gl::vertex_buffer vbo;
+	gl::vertex_buffer ibo;
 	skeleton* skeleton;
 };
 
@@ -191,5 +224,15 @@ inline gl::vertex_buffer* model::get_vertex_buffer()
 	return &vbo;
 }
 
+inline const gl::vertex_buffer* model::get_element_buffer() const
+{
+	return &ibo;
+}
+
+inline gl::vertex_buffer* model::get_element_buffer()
+{
+	return &ibo;
+}
+
 #endif // ANTKEEPER_MODEL_HPP
 
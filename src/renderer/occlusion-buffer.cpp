@@ -0,0 +1,191 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "renderer/occlusion-buffer.hpp"
+#include "math/math.hpp"
+#include "utility/job-system.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+occlusion_buffer::occlusion_buffer():
+	frame_width(0),
+	frame_height(0),
+	base_shift(0),
+	view_projection(math::identity4x4<float>)
+{}
+
+void occlusion_buffer::update(const float* depths, int width, int height, const float4x4& view_projection, job_system* jobs)
+{
+	if (!depths || width <= 0 || height <= 0)
+	{
+		clear();
+		return;
+	}
+	
+	this->view_projection = view_projection;
+	frame_width = width;
+	frame_height = height;
+	
+	// Select the power-of-two block size by which the frame is reduced to the base level
+	base_shift = 0;
+	while (((width - 1) >> base_shift) + 1 > max_base_size || ((height - 1) >> base_shift) + 1 > max_base_size)
+		++base_shift;
+	
+	// Allocate levels, reusing their storage if the frame dimensions are unchanged
+	int level_width = ((width - 1) >> base_shift) + 1;
+	int level_height = ((height - 1) >> base_shift) + 1;
+	std::size_t level_count = 0;
+	for (;;)
+	{
+		if (levels.size() <= level_count)
+			levels.emplace_back();
+		
+		level& level = levels[level_count++];
+		level.width = level_width;
+		level.height = level_height;
+		level.depths.resize(static_cast<std::size_t>(level_width) * static_cast<std::size_t>(level_height));
+		
+		if (level_width == 1 && level_height == 1)
+			break;
+		
+		level_width = (level_width + 1) >> 1;
+		level_height = (level_height + 1) >> 1;
+	}
+	levels.resize(level_count);
+	
+	// Reduce blocks of frame pixels to the farthest, least, depth of each base level texel
+	level& base = levels.front();
+	const int block_size = 1 << base_shift;
+	auto reduce_rows = [&](std::size_t first, std::size_t last)
+	{
+		for (std::size_t y = first; y < last; ++y)
+		{
+			float* row = base.depths.data() + y * base.width;
+			std::fill(row, row + base.width, 1.0f);
+			
+			const int y0 = static_cast<int>(y) << base_shift;
+			const int y1 = std::min(y0 + block_size, height);
+			for (int py = y0; py < y1; ++py)
+			{
+				const float* pixels = depths + static_cast<std::size_t>(py) * width;
+				for (int x = 0; x < base.width; ++x)
+				{
+					const int x0 = x << base_shift;
+					const int x1 = std::min(x0 + block_size, width);
+					row[x] = std::min(row[x], *std::min_element(pixels + x0, pixels + x1));
+				}
+			}
+		}
+	};
+	
+	if (jobs)
+		jobs->parallel_for(0, base.height, 8, reduce_rows);
+	else
+		reduce_rows(0, base.height);
+	
+	// Reduce blocks of 2x2 texels, clamped to the edges of odd levels
+	for (std::size_t i = 1; i < levels.size(); ++i)
+	{
+		const level& source = levels[i - 1];
+		level& destination = levels[i];
+		
+		for (int y = 0; y < destination.height; ++y)
+		{
+			const int y0 = y << 1;
+			const int y1 = std::min(y0 + 1, source.height - 1);
+			const float* row0 = source.depths.data() + static_cast<std::size_t>(y0) * source.width;
+			const float* row1 = source.depths.data() + static_cast<std::size_t>(y1) * source.width;
+			
+			for (int x = 0; x < destination.width; ++x)
+			{
+				const int x0 = x << 1;
+				const int x1 = std::min(x0 + 1, source.width - 1);
+				destination.depths[static_cast<std::size_t>(y) * destination.width + x] = std::min({row0[x0], row0[x1], row1[x0], row1[x1]});
+			}
+		}
+	}
+}
+
+void occlusion_buffer::clear()
+{
+	levels.clear();
+}
+
+bool occlusion_buffer::is_occluded(const geom::aabb<float>& bounds) const
+{
+	if (levels.empty())
+		return false;
+	
+	// Project the corners of the box, finding their screen-space bounds and nearest depth
+	float2 ndc_min = {std::numeric_limits<float>::infinity(), std::numeric_limits<float>::infinity()};
+	float2 ndc_max = {-std::numeric_limits<float>::infinity(), -std::numeric_limits<float>::infinity()};
+	float nearest_depth = 0.0f;
+	for (int i = 0; i < 8; ++i)
+	{
+		const float3 corner = bounds.corner(i);
+		const float4 clip = view_projection * float4{corner[0], corner[1], corner[2], 1.0f};
+		
+		// Boxes which cross the near plane are never occluded
+		if (clip[3] <= 0.0f)
+			return false;
+		
+		const float inverse_w = 1.0f / clip[3];
+		const float2 ndc = {clip[0] * inverse_w, clip[1] * inverse_w};
+		ndc_min = {std::min(ndc_min[0], ndc[0]), std::min(ndc_min[1], ndc[1])};
+		ndc_max = {std::max(ndc_max[0], ndc[0]), std::max(ndc_max[1], ndc[1])};
+		nearest_depth = std::max(nearest_depth, clip[2] * inverse_w * 0.5f + 0.5f);
+	}
+	
+	// Boxes which lie outside of the frame are left to frustum culling
+	if (ndc_max[0] < -1.0f || ndc_min[0] > 1.0f || ndc_max[1] < -1.0f || ndc_min[1] > 1.0f)
+		return false;
+	
+	// Find the frame pixels covered by the projected box
+	auto to_pixel = [](float ndc, int size)
+	{
+		const float window = (std::min(std::max(ndc, -1.0f), 1.0f) * 0.5f + 0.5f) * static_cast<float>(size);
+		return std::min(static_cast<int>(window), size - 1);
+	};
+	const int x0 = to_pixel(ndc_min[0], frame_width) >> base_shift;
+	const int x1 = to_pixel(ndc_max[0], frame_width) >> base_shift;
+	const int y0 = to_pixel(ndc_min[1], frame_height) >> base_shift;
+	const int y1 = to_pixel(ndc_max[1], frame_height) >> base_shift;
+	
+	// Select the smallest level at which the box covers at most 2x2 texels
+	std::size_t level_index = 0;
+	while (level_index + 1 < levels.size() && ((x1 >> level_index) - (x0 >> level_index) > 1 || (y1 >> level_index) - (y0 >> level_index) > 1))
+		++level_index;
+	
+	const level& level = levels[level_index];
+	const int shift = static_cast<int>(level_index);
+	
+	// Test the nearest depth of the box against the farthest depth of the covered texels
+	for (int y = y0 >> shift; y <= (y1 >> shift); ++y)
+	{
+		const float* row = level.depths.data() + static_cast<std::size_t>(y) * level.width;
+		for (int x = x0 >> shift; x <= (x1 >> shift); ++x)
+		{
+			if (nearest_depth >= row[x])
+				return false;
+		}
+	}
+	
+	return true;
+}
@@ -0,0 +1,94 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ANTKEEPER_OCCLUSION_BUFFER_HPP
+#define ANTKEEPER_OCCLUSION_BUFFER_HPP
+
+#include "geom/aabb.hpp"
+#include "utility/fundamental-types.hpp"
+#include <cstddef>
+#include <vector>
+
+class job_system;
+
+/**
+ * Hierarchical depth buffer against which the bounds of objects are tested for occlusion.
+ *
+ * The buffer is built from the reversed depth of a rendered frame, in which greater depths are nearer. The base level reduces blocks of pixels to their farthest depth, then each successive level reduces blocks of 2x2 texels of the previous level, so that every texel is a conservative bound on the depth of the pixels it covers. Bounds are projected with the view-projection matrix of the frame, and are occluded if their nearest depth is farther than the farthest depth of the texels of the smallest level covering their projection with at most 2x2 texels.
+ */
+class occlusion_buffer
+{
+public:
+	/// Maximum width and height of the base level, in texels.
+	static constexpr int max_base_size = 512;
+	
+	/// Creates an empty occlusion buffer, which occludes nothing.
+	occlusion_buffer();
+	
+	/**
+	 * Rebuilds the buffer from the depth of a frame.
+	 *
+	 * @param depths Window-space depths, in rows from bottom to top, with greater depths nearer.
+	 * @param width Width of the frame, in pixels.
+	 * @param height Height of the frame, in pixels.
+	 * @param view_projection View-projection matrix with which the frame was rendered, mapping depths on `[0, 1]` in NDC to `[0.5, 1]` in window space under the default depth range.
+	 * @param jobs Job system on which the base level is reduced in parallel, or `nullptr`.
+	 */
+	void update(const float* depths, int width, int height, const float4x4& view_projection, job_system* jobs = nullptr);
+	
+	/// Empties the buffer, so that it occludes nothing.
+	void clear();
+	
+	/**
+	 * Returns `true` if a box is entirely hidden behind the depth of the buffer. Boxes which cross the near plane or lie outside of the frame are never occluded.
+	 *
+	 * @param bounds World-space bounds.
+	 */
+	bool is_occluded(const geom::aabb<float>& bounds) const;
+	
+	/// Returns `true` if the buffer has been built from a frame.
+	bool is_valid() const;
+
+private:
+	struct level
+	{
+		int width;
+		int height;
+		std::vector<float> depths;
+	};
+	
+	/// Hierarchy levels, from the base level to a single texel.
+	std::vector<level> levels;
+	
+	/// Dimensions of the frame from which the buffer was built, in pixels.
+	int frame_width;
+	int frame_height;
+	
+	/// Number of bits by which frame pixel coordinates are shifted to base level texel coordinates.
+	int base_shift;
+	
+	float4x4 view_projection;
+};
+
+inline bool occlusion_buffer::is_valid() const
+{
+	return !levels.empty();
+}
+
+#endif // ANTKEEPER_OCCLUSION_BUFFER_HPP
@@ -0,0 +1,134 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "renderer/pass-profiler.hpp"
+#include "gl/timer-query.hpp"
+
+pass_profiler::pass_profiler():
+	enabled(false),
+	sample_size(15),
+	frame_index(0),
+	frame_duration(0.0),
+	measured_frame_count(0)
+{
+	for (query_set& set: query_sets)
+		set.count = 0;
+}
+
+pass_profiler::~pass_profiler()
+{
+	for (query_set& set: query_sets)
+		for (gl::timer_query* query: set.queries)
+			delete query;
+}
+
+void pass_profiler::set_enabled(bool enabled)
+{
+	if (enabled && !this->enabled)
+	{
+		// Discard stale queries and timings
+		for (query_set& set: query_sets)
+			set.count = 0;
+		timings.clear();
+		samplers.clear();
+		frame_duration = 0.0;
+		measured_frame_count = 0;
+	}
+	
+	this->enabled = enabled;
+}
+
+void pass_profiler::set_sample_size(std::size_t size)
+{
+	sample_size = size;
+	for (auto& sampler: samplers)
+		sampler.second.set_sample_size(size);
+}
+
+void pass_profiler::begin_frame()
+{
+	if (!enabled)
+		return;
+	
+	++frame_index;
+	query_set& set = query_sets[frame_index % 2];
+	
+	// Read back the queries issued two frames ago, if the GPU has finished with them
+	bool available = true;
+	for (std::size_t i = 0; i < set.count; ++i)
+	{
+		if (!set.queries[i]->is_available())
+		{
+			available = false;
+			break;
+		}
+	}
+	
+	if (available && set.count)
+	{
+		// Sum durations of passes with the same name
+		frame_durations.clear();
+		for (std::size_t i = 0; i < set.count; ++i)
+			frame_durations[set.names[i]] += set.queries[i]->get_elapsed_time();
+		
+		frame_duration = 0.0;
+		for (const auto& pass_duration: frame_durations)
+			frame_duration += pass_duration.second;
+		++measured_frame_count;
+		
+		for (const auto& frame_duration: frame_durations)
+		{
+			auto sampler = samplers.find(frame_duration.first);
+			if (sampler == samplers.end())
+			{
+				sampler = samplers.emplace(frame_duration.first, debug::performance_sampler()).first;
+				sampler->second.set_sample_size(sample_size);
+			}
+			sampler->second.sample(frame_duration.second);
+			
+			timing& pass_timing = timings[frame_duration.first];
+			pass_timing.duration = frame_duration.second;
+			pass_timing.mean_duration = sampler->second.mean_frame_duration();
+		}
+	}
+	
+	// Reuse the query set for this frame
+	set.count = 0;
+}
+
+void pass_profiler::begin(const std::string& name)
+{
+	query_set& set = query_sets[frame_index % 2];
+	
+	// Allocate a new query if all queries in the set are in use
+	if (set.count == set.queries.size())
+	{
+		set.queries.push_back(new gl::timer_query());
+		set.names.push_back(std::string());
+	}
+	
+	set.names[set.count] = name;
+	set.queries[set.count]->begin();
+}
+
+void pass_profiler::end()
+{
+	query_set& set = query_sets[frame_index % 2];
+	set.queries[set.count++]->end();
+}
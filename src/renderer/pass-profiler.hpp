@@ -0,0 +1,145 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ANTKEEPER_PASS_PROFILER_HPP
+#define ANTKEEPER_PASS_PROFILER_HPP
+
+#include "debug/performance-sampler.hpp"
+#include <cstdlib>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace gl { class timer_query; }
+
+/**
+ * Measures the GPU time taken by render passes, aggregated by pass name.
+ *
+ * Timer queries are double-buffered: the queries issued during a frame are read back two frames later, once the GPU has finished with them, so measuring never stalls the pipeline.
+ */
+class pass_profiler
+{
+public:
+	/// GPU time taken by all passes with the same name.
+	struct timing
+	{
+		/// Most recently measured GPU time per frame, in seconds.
+		double duration;
+		
+		/// Rolling mean GPU time per frame, in seconds.
+		double mean_duration;
+	};
+	
+	/// Creates a pass profiler.
+	pass_profiler();
+	
+	/// Destroys a pass profiler.
+	~pass_profiler();
+	
+	/**
+	 * Enables or disables profiling. Timings are reset when profiling is enabled.
+	 *
+	 * @param enabled `true` if profiling should be enabled, `false` otherwise.
+	 */
+	void set_enabled(bool enabled);
+	
+	/**
+	 * Sets the number of frames over which the rolling mean pass durations are measured.
+	 *
+	 * @param size Number of frames in a sample.
+	 */
+	void set_sample_size(std::size_t size);
+	
+	/**
+	 * Begins a new frame. Should be called once per frame, before any passes are measured. Reads back the queries issued two frames ago.
+	 */
+	void begin_frame();
+	
+	/**
+	 * Begins measuring a pass. Passes cannot be nested.
+	 *
+	 * @param name Name of the pass.
+	 */
+	void begin(const std::string& name);
+	
+	/// Ends measuring the current pass.
+	void end();
+	
+	/// Returns `true` if profiling is enabled.
+	bool is_enabled() const;
+	
+	/// Returns the GPU timings of each pass name.
+	const std::map<std::string, timing>& get_timings() const;
+	
+	/// Returns the samplers of the GPU time per frame of each pass name, with streaming statistics since profiling was last enabled.
+	const std::map<std::string, debug::performance_sampler>& get_samplers() const;
+	
+	/// Returns the GPU time taken by all passes of the most recently measured frame, in seconds.
+	double get_frame_duration() const;
+	
+	/// Returns the number of frames measured since profiling was last enabled, by which new frame durations can be detected.
+	std::size_t get_measured_frame_count() const;
+
+private:
+	/// Timer queries issued during a single frame.
+	struct query_set
+	{
+		std::vector<gl::timer_query*> queries;
+		std::vector<std::string> names;
+		std::size_t count;
+	};
+	
+	bool enabled;
+	std::size_t sample_size;
+	query_set query_sets[2];
+	std::size_t frame_index;
+	std::map<std::string, timing> timings;
+	std::map<std::string, double> frame_durations;
+	std::map<std::string, debug::performance_sampler> samplers;
+	double frame_duration;
+	std::size_t measured_frame_count;
+};
+
+inline bool pass_profiler::is_enabled() const
+{
+	return enabled;
+}
+
+inline const std::map<std::string, pass_profiler::timing>& pass_profiler::get_timings() const
+{
+	return timings;
+}
+
+inline const std::map<std::string, debug::performance_sampler>& pass_profiler::get_samplers() const
+{
+	return samplers;
+}
+
+inline double pass_profiler::get_frame_duration() const
+{
+	return frame_duration;
+}
+
+inline std::size_t pass_profiler::get_measured_frame_count() const
+{
+	return measured_frame_count;
+}
+
+#endif // ANTKEEPER_PASS_PROFILER_HPP
+
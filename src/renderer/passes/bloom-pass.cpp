@@ -34,13 +34,13 @@
 #include "renderer/render-context.hpp"
 #include "math/math.hpp"
 #include <cmath>
-#include <glad/glad.h>
 
 bloom_pass::bloom_pass(gl::rasterizer* rasterizer, const gl::framebuffer* framebuffer, resource_manager* resource_manager):
 	render_pass(rasterizer, framebuffer),
 	source_texture(nullptr),
 	brightness_threshold(1.0f),
-	blur_iterations(1)
+	blur_iterations(1),
+	mode(bloom_mode::dual_filter)
 {
 	// Create clone of framebuffer texture
 	const gl::texture_2d* framebuffer_texture = framebuffer->get_color_attachment();
@@ -67,15 +67,26 @@ bloom_pass::bloom_pass(gl::rasterizer* rasterizer, const gl::framebuffer* frameb
 	
 	// Load brightness threshold shader
 	threshold_shader = resource_manager->load<gl::shader_program>("brightness-threshold.glsl");
-	threshold_shader_image_input = threshold_shader->get_input("image");
-	threshold_shader_resolution_input = threshold_shader->get_input("resolution");
-	threshold_shader_threshold_input = threshold_shader->get_input("threshold");
+	threshold_shader_image_input = threshold_shader->get_input("image"_sid);
+	threshold_shader_resolution_input = threshold_shader->get_input("resolution"_sid);
+	threshold_shader_threshold_input = threshold_shader->get_input("threshold"_sid);
 	
 	// Load blur shader
 	blur_shader = resource_manager->load<gl::shader_program>("blur.glsl");
-	blur_shader_image_input = blur_shader->get_input("image");
-	blur_shader_resolution_input = blur_shader->get_input("resolution");
-	blur_shader_direction_input = blur_shader->get_input("direction");
+	blur_shader_image_input = blur_shader->get_input("image"_sid);
+	blur_shader_resolution_input = blur_shader->get_input("resolution"_sid);
+	blur_shader_direction_input = blur_shader->get_input("direction"_sid);
+	
+	// Load dual-filter shaders
+	downsample_shader = resource_manager->load<gl::shader_program>("bloom-downsample.glsl");
+	downsample_shader_image_input = downsample_shader->get_input("image"_sid);
+	downsample_shader_resolution_input = downsample_shader->get_input("resolution"_sid);
+	upsample_shader = resource_manager->load<gl::shader_program>("bloom-upsample.glsl");
+	upsample_shader_image_input = upsample_shader->get_input("image"_sid);
+	upsample_shader_resolution_input = upsample_shader->get_input("resolution"_sid);
+	
+	// Allocate default mip chain
+	set_mip_count(6);
 
 	const float vertex_data[] =
 	{
@@ -98,6 +109,7 @@ bloom_pass::bloom_pass(gl::rasterizer* rasterizer, const gl::framebuffer* frameb
 
 bloom_pass::~bloom_pass()
 {
+	set_mip_count(1);
 	delete cloned_framebuffer;
 	delete cloned_framebuffer_texture;
 	delete quad_vao;
@@ -106,11 +118,10 @@ bloom_pass::~bloom_pass()
 
 void bloom_pass::render(render_context* context) const
 {	
-	glDisable(GL_BLEND);
-	glDisable(GL_DEPTH_TEST);
-	glDepthMask(GL_FALSE);
-	glEnable(GL_CULL_FACE);
-	glCullFace(GL_BACK);
+	gl::render_state state;
+	state.depth_write_enabled = false;
+	state.cull_enabled = true;
+	rasterizer->set_render_state(state);
 
 	// Determine viewport based on framebuffer resolution
 	auto viewport = framebuffer->get_dimensions();
@@ -125,23 +136,58 @@ void bloom_pass::render(render_context* context) const
 	threshold_shader_threshold_input->upload(brightness_threshold);
 	rasterizer->draw_arrays(*quad_vao, gl::drawing_mode::triangles, 0, 6);
 	
-	// Perform iterative blur subpass
-	const float2 direction_horizontal = {1, 0};
-	const float2 direction_vertical = {0, 1};
-	rasterizer->use_program(*blur_shader);
-	blur_shader_resolution_input->upload(resolution);
-	for (int i = 0; i < blur_iterations; ++i)
+	if (mode == bloom_mode::blur)
 	{
-		// Perform horizontal blur
-		rasterizer->use_framebuffer(*pingpong_framebuffers[1]);
-		blur_shader_image_input->upload(pingpong_textures[0]);
-		blur_shader_direction_input->upload(direction_horizontal);
-		rasterizer->draw_arrays(*quad_vao, gl::drawing_mode::triangles, 0, 6);
+		// Perform iterative blur subpass
+		const float2 direction_horizontal = {1, 0};
+		const float2 direction_vertical = {0, 1};
+		rasterizer->use_program(*blur_shader);
+		blur_shader_resolution_input->upload(resolution);
+		for (int i = 0; i < blur_iterations; ++i)
+		{
+			// Perform horizontal blur
+			rasterizer->use_framebuffer(*pingpong_framebuffers[1]);
+			blur_shader_image_input->upload(pingpong_textures[0]);
+			blur_shader_direction_input->upload(direction_horizontal);
+			rasterizer->draw_arrays(*quad_vao, gl::drawing_mode::triangles, 0, 6);
+			
+			// Perform vertical blur
+			rasterizer->use_framebuffer(*pingpong_framebuffers[0]);
+			blur_shader_image_input->upload(pingpong_textures[1]);
+			blur_shader_direction_input->upload(direction_vertical);
+			rasterizer->draw_arrays(*quad_vao, gl::drawing_mode::triangles, 0, 6);
+		}
 		
-		// Perform vertical blur
-		rasterizer->use_framebuffer(*pingpong_framebuffers[0]);
-		blur_shader_image_input->upload(pingpong_textures[1]);
-		blur_shader_direction_input->upload(direction_vertical);
+		return;
+	}
+	
+	// Perform downsample subpasses, each sampling the next larger mip level
+	rasterizer->use_program(*downsample_shader);
+	for (std::size_t i = 1; i < mip_framebuffers.size(); ++i)
+	{
+		const auto& source_dimensions = mip_textures[i - 1]->get_dimensions();
+		const auto& target_dimensions = mip_framebuffers[i]->get_dimensions();
+		rasterizer->use_framebuffer(*mip_framebuffers[i]);
+		rasterizer->set_viewport(0, 0, target_dimensions[0], target_dimensions[1]);
+		downsample_shader_image_input->upload(mip_textures[i - 1]);
+		downsample_shader_resolution_input->upload(float2{static_cast<float>(source_dimensions[0]), static_cast<float>(source_dimensions[1])});
+		rasterizer->draw_arrays(*quad_vao, gl::drawing_mode::triangles, 0, 6);
+	}
+	
+	// Perform upsample subpasses, each additively blending the next smaller mip level into its own
+	state.blend_enabled = true;
+	state.blend_source = gl::blend_factor::one;
+	state.blend_destination = gl::blend_factor::one;
+	rasterizer->set_render_state(state);
+	rasterizer->use_program(*upsample_shader);
+	for (std::size_t i = mip_framebuffers.size() - 1; i > 0; --i)
+	{
+		const auto& source_dimensions = mip_textures[i]->get_dimensions();
+		const auto& target_dimensions = mip_framebuffers[i - 1]->get_dimensions();
+		rasterizer->use_framebuffer(*mip_framebuffers[i - 1]);
+		rasterizer->set_viewport(0, 0, target_dimensions[0], target_dimensions[1]);
+		upsample_shader_image_input->upload(mip_textures[i]);
+		upsample_shader_resolution_input->upload(float2{static_cast<float>(source_dimensions[0]), static_cast<float>(source_dimensions[1])});
 		rasterizer->draw_arrays(*quad_vao, gl::drawing_mode::triangles, 0, 6);
 	}
 }
@@ -149,6 +195,7 @@ void bloom_pass::render(render_context* context) const
 void bloom_pass::set_source_texture(const gl::texture_2d* texture)
 {
 	this->source_texture = texture;
+	set_input(0, texture);
 }
 
 void bloom_pass::set_brightness_threshold(float threshold)
@@ -161,3 +208,46 @@ void bloom_pass::set_blur_iterations(int iterations)
 	this->blur_iterations = iterations;
 }
 
+void bloom_pass::set_mode(bloom_mode mode)
+{
+	this->mode = mode;
+}
+
+void bloom_pass::set_mip_count(int count)
+{
+	// Free previously allocated mip levels
+	for (gl::framebuffer* mip_framebuffer: owned_mip_framebuffers)
+		delete mip_framebuffer;
+	for (gl::texture_2d* mip_texture: owned_mip_textures)
+		delete mip_texture;
+	owned_mip_framebuffers.clear();
+	owned_mip_textures.clear();
+	
+	// The first level is the pass framebuffer
+	const gl::texture_2d* framebuffer_texture = framebuffer->get_color_attachment();
+	mip_framebuffers.assign(1, framebuffer);
+	mip_textures.assign(1, framebuffer_texture);
+	
+	// Allocate successively halved levels with the format of the framebuffer texture
+	auto dimensions = framebuffer_texture->get_dimensions();
+	for (int i = 1; i < count; ++i)
+	{
+		dimensions[0] >>= 1;
+		dimensions[1] >>= 1;
+		if (dimensions[0] < 1 || dimensions[1] < 1)
+			break;
+		
+		gl::texture_2d* mip_texture = new gl::texture_2d(dimensions[0], dimensions[1], framebuffer_texture->get_pixel_type(), framebuffer_texture->get_pixel_format());
+		mip_texture->set_wrapping(gl::texture_wrapping::extend, gl::texture_wrapping::extend);
+		mip_texture->set_filters(gl::texture_min_filter::linear, gl::texture_mag_filter::linear);
+		mip_texture->set_max_anisotropy(0.0f);
+		
+		gl::framebuffer* mip_framebuffer = new gl::framebuffer(dimensions[0], dimensions[1]);
+		mip_framebuffer->attach(gl::framebuffer_attachment_type::color, mip_texture);
+		
+		owned_mip_textures.push_back(mip_texture);
+		owned_mip_framebuffers.push_back(mip_framebuffer);
+		mip_textures.push_back(mip_texture);
+		mip_framebuffers.push_back(mip_framebuffer);
+	}
+}
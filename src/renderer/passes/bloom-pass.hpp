@@ -27,11 +27,24 @@
 #include "gl/vertex-buffer.hpp"
 #include "gl/vertex-array.hpp"
 #include "gl/texture-2d.hpp"
+#include <vector>
 
 class resource_manager;
 
+/// Enumerates bloom filtering modes.
+enum class bloom_mode
+{
+	// Progressively downsamples into a mip chain, then upsamples and additively blends each level into the next larger level
+	dual_filter,
+	
+	// Iteratively blurs at the resolution of the framebuffer with a separable blur
+	blur
+};
+
 /**
+ * Extracts the bright regions of a source texture into the pass framebuffer and spreads them.
  *
+ * In dual-filter mode, bright regions are downsampled through a chain of successively halved textures with a 13-tap filter, then upsampled back up the chain with a 3x3 tent filter, each level additively blended into the next larger one. The width of the bloom grows with the number of levels, while the cost of each level falls by a factor of four. In blur mode, bright regions are blurred at the resolution of the framebuffer by a number of separable blur iterations.
  */
 class bloom_pass: public render_pass
 {
@@ -43,6 +56,20 @@ public:
 	void set_source_texture(const gl::texture_2d* texture);
 	void set_brightness_threshold(float threshold);
 	void set_blur_iterations(int iterations);
+	
+	/**
+	 * Sets the bloom filtering mode.
+	 *
+	 * @param mode Bloom mode.
+	 */
+	void set_mode(bloom_mode mode);
+	
+	/**
+	 * Sets the number of levels of the dual-filter mip chain, including the framebuffer itself. Levels are allocated until either dimension would fall below one pixel.
+	 *
+	 * @param count Number of mip levels.
+	 */
+	void set_mip_count(int count);
 
 private:
 	gl::vertex_buffer* quad_vbo;
@@ -63,9 +90,26 @@ private:
 	const gl::shader_input* blur_shader_resolution_input;
 	const gl::shader_input* blur_shader_direction_input;
 	
+	gl::shader_program* downsample_shader;
+	const gl::shader_input* downsample_shader_image_input;
+	const gl::shader_input* downsample_shader_resolution_input;
+	
+	gl::shader_program* upsample_shader;
+	const gl::shader_input* upsample_shader_image_input;
+	const gl::shader_input* upsample_shader_resolution_input;
+	
+	/// Framebuffers and color textures of the dual-filter mip chain, the first of which are the pass framebuffer and its color attachment.
+	std::vector<const gl::framebuffer*> mip_framebuffers;
+	std::vector<const gl::texture_2d*> mip_textures;
+	
+	/// Mip levels allocated by the pass, excluding the first.
+	std::vector<gl::framebuffer*> owned_mip_framebuffers;
+	std::vector<gl::texture_2d*> owned_mip_textures;
+	
 	const gl::texture_2d* source_texture;
 	float brightness_threshold;
 	int blur_iterations;
+	bloom_mode mode;
 };
 
 #endif // ANTKEEPER_BLOOM_PASS_HPP
@@ -20,7 +20,6 @@
 #include "renderer/passes/clear-pass.hpp"
 #include "gl/rasterizer.hpp"
 #include "gl/framebuffer.hpp"
-#include <glad/glad.h>
 
 clear_pass::clear_pass(gl::rasterizer* rasterizer, const gl::framebuffer* framebuffer):
 	render_pass(rasterizer, framebuffer),
@@ -37,12 +36,16 @@ clear_pass::~clear_pass()
 
 void clear_pass::render(render_context* context) const
 {
+	// Enable writing to the cleared buffers
+	gl::render_state state = rasterizer->get_render_state();
 	if (clear_color_buffer)
-		glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+		state.color_write_enabled = true;
 	if (clear_depth_buffer)
-		glDepthMask(GL_TRUE);
+		state.depth_write_enabled = true;
 	if (clear_stencil_buffer)
-		glStencilMask(0xFF);
+		state.stencil_write_mask = 0xFF;
+	state.scissor_test_enabled = false;
+	rasterizer->set_render_state(state);
 	
 	rasterizer->use_framebuffer(*framebuffer);
 
@@ -0,0 +1,199 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "renderer/passes/debug-draw-pass.hpp"
+#include "resources/resource-manager.hpp"
+#include "gl/rasterizer.hpp"
+#include "gl/framebuffer.hpp"
+#include "gl/shader-program.hpp"
+#include "gl/shader-input.hpp"
+#include "gl/vertex-buffer.hpp"
+#include "gl/vertex-array.hpp"
+#include "gl/vertex-attribute-type.hpp"
+#include "gl/drawing-mode.hpp"
+#include "gl/texture-2d.hpp"
+#include "renderer/vertex-attributes.hpp"
+#include "renderer/render-context.hpp"
+#include "scene/camera.hpp"
+#include "type/font.hpp"
+#include "debug/draw.hpp"
+#include "math/math.hpp"
+
+/// Number of floats per line vertex: position and color.
+static constexpr std::size_t line_vertex_size = 7;
+
+/// Number of floats per text vertex: normalized device coordinates, texture coordinates, and color.
+static constexpr std::size_t text_vertex_size = 8;
+
+debug_draw_pass::debug_draw_pass(gl::rasterizer* rasterizer, const gl::framebuffer* framebuffer, resource_manager* resource_manager):
+	render_pass(rasterizer, framebuffer),
+	line_shader(nullptr),
+	line_view_projection_input(nullptr),
+	text_shader(nullptr),
+	text_atlas_input(nullptr),
+	font(nullptr)
+{
+	line_shader = resource_manager->load<gl::shader_program>("debug-draw-lines.glsl");
+	if (line_shader)
+		line_view_projection_input = line_shader->get_input("view_projection"_sid);
+	
+	text_shader = resource_manager->load<gl::shader_program>("debug-draw-text.glsl");
+	if (text_shader)
+		text_atlas_input = text_shader->get_input("atlas"_sid);
+	
+	const std::size_t line_vertex_stride = sizeof(float) * line_vertex_size;
+	line_vbo = new gl::vertex_buffer(0, nullptr, gl::buffer_usage::stream_draw);
+	line_vao = new gl::vertex_array();
+	line_vao->bind_attribute(VERTEX_POSITION_LOCATION, *line_vbo, 3, gl::vertex_attribute_type::float_32, line_vertex_stride, 0);
+	line_vao->bind_attribute(VERTEX_COLOR_LOCATION, *line_vbo, 4, gl::vertex_attribute_type::float_32, line_vertex_stride, sizeof(float) * 3);
+	
+	const std::size_t text_vertex_stride = sizeof(float) * text_vertex_size;
+	text_vbo = new gl::vertex_buffer(0, nullptr, gl::buffer_usage::stream_draw);
+	text_vao = new gl::vertex_array();
+	text_vao->bind_attribute(VERTEX_POSITION_LOCATION, *text_vbo, 2, gl::vertex_attribute_type::float_32, text_vertex_stride, 0);
+	text_vao->bind_attribute(VERTEX_TEXCOORD_LOCATION, *text_vbo, 2, gl::vertex_attribute_type::float_32, text_vertex_stride, sizeof(float) * 2);
+	text_vao->bind_attribute(VERTEX_COLOR_LOCATION, *text_vbo, 4, gl::vertex_attribute_type::float_32, text_vertex_stride, sizeof(float) * 4);
+}
+
+debug_draw_pass::~debug_draw_pass()
+{
+	delete text_vao;
+	delete text_vbo;
+	delete line_vao;
+	delete line_vbo;
+}
+
+void debug_draw_pass::render(render_context* context) const
+{
+	const debug::draw::frame& frame = debug::draw::get_frame();
+	if (frame.lines.empty() && frame.labels.empty())
+		return;
+	
+	rasterizer->use_framebuffer(*framebuffer);
+	const std::array<int, 2>& dimensions = framebuffer->get_dimensions();
+	rasterizer->set_viewport(0, 0, dimensions[0], dimensions[1]);
+	
+	const float4x4 view_projection = context->camera->get_view_projection_tween().interpolate(context->alpha);
+	const float3 camera_origin = math::type_cast<float>(context->camera_origin);
+	
+	gl::render_state state;
+	state.blend_enabled = true;
+	state.blend_source = gl::blend_factor::src_alpha;
+	state.blend_destination = gl::blend_factor::one_minus_src_alpha;
+	state.depth_write_enabled = false;
+	state.cull_enabled = false;
+	
+	// Draw all lines, relative to the camera origin
+	if (!frame.lines.empty() && line_shader)
+	{
+		vertex_data.resize(frame.lines.size() * line_vertex_size);
+		float* v = vertex_data.data();
+		for (const debug::draw::line_vertex& vertex: frame.lines)
+		{
+			const float3 position = vertex.position - camera_origin;
+			*(v++) = position.x;
+			*(v++) = position.y;
+			*(v++) = position.z;
+			*(v++) = vertex.color.x;
+			*(v++) = vertex.color.y;
+			*(v++) = vertex.color.z;
+			*(v++) = vertex.color.w;
+		}
+		line_vbo->resize(vertex_data.size() * sizeof(float), vertex_data.data());
+		
+		rasterizer->set_render_state(state);
+		rasterizer->use_program(*line_shader);
+		if (line_view_projection_input)
+			line_view_projection_input->upload(view_projection);
+		rasterizer->draw_arrays(*line_vao, gl::drawing_mode::lines, 0, frame.lines.size());
+	}
+	
+	// Lay out the glyphs of all labels in front of the camera
+	if (frame.labels.empty() || !text_shader || !font)
+		return;
+	
+	const float2 pixel_scale = {2.0f / static_cast<float>(dimensions[0]), 2.0f / static_cast<float>(dimensions[1])};
+	vertex_data.clear();
+	for (const debug::draw::label& label: frame.labels)
+	{
+		const float3 position = label.position - camera_origin;
+		const float4 clip = view_projection * float4{position.x, position.y, position.z, 1.0f};
+		if (clip.w <= 0.0f)
+			continue;
+		
+		// Start the baseline at the pixel of the anchor
+		float2 pen =
+		{
+			(clip.x / clip.w * 0.5f + 0.5f) * static_cast<float>(dimensions[0]),
+			(clip.y / clip.w * 0.5f + 0.5f) * static_cast<float>(dimensions[1])
+		};
+		
+		for (char c: label.text)
+		{
+			const type::glyph& glyph = font->get_glyph(static_cast<char32_t>(static_cast<unsigned char>(c)));
+			if (glyph.size.x > 0.0f && glyph.size.y > 0.0f)
+			{
+				const float x0 = (pen.x + glyph.offset.x) * pixel_scale.x - 1.0f;
+				const float y0 = (pen.y + glyph.offset.y) * pixel_scale.y - 1.0f;
+				const float x1 = x0 + glyph.size.x * pixel_scale.x;
+				const float y1 = y0 + glyph.size.y * pixel_scale.y;
+				const float4& uv = glyph.texcoords;
+				
+				const float quad[6][4] =
+				{
+					{x0, y1, uv[0], uv[3]},
+					{x0, y0, uv[0], uv[1]},
+					{x1, y1, uv[2], uv[3]},
+					{x1, y1, uv[2], uv[3]},
+					{x0, y0, uv[0], uv[1]},
+					{x1, y0, uv[2], uv[1]}
+				};
+				for (const auto& corner: quad)
+				{
+					vertex_data.insert(vertex_data.end(), corner, corner + 4);
+					vertex_data.push_back(label.color.x);
+					vertex_data.push_back(label.color.y);
+					vertex_data.push_back(label.color.z);
+					vertex_data.push_back(label.color.w);
+				}
+			}
+			
+			pen.x += glyph.advance;
+		}
+	}
+	
+	if (vertex_data.empty())
+		return;
+	
+	// Upload glyphs rasterized by the layout, then draw all labels over the scene
+	font->upload();
+	text_vbo->resize(vertex_data.size() * sizeof(float), vertex_data.data());
+	
+	state.depth_test_enabled = false;
+	rasterizer->set_render_state(state);
+	rasterizer->use_program(*text_shader);
+	if (text_atlas_input)
+		text_atlas_input->upload(font->get_texture());
+	rasterizer->draw_arrays(*text_vao, gl::drawing_mode::triangles, 0, vertex_data.size() / text_vertex_size);
+}
+
+void debug_draw_pass::set_font(type::font* font)
+{
+	this->font = font;
+}
@@ -0,0 +1,73 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ANTKEEPER_DEBUG_DRAW_PASS_HPP
+#define ANTKEEPER_DEBUG_DRAW_PASS_HPP
+
+#include "renderer/render-pass.hpp"
+#include "gl/shader-program.hpp"
+#include "gl/shader-input.hpp"
+#include "gl/vertex-buffer.hpp"
+#include "gl/vertex-array.hpp"
+#include <vector>
+
+class resource_manager;
+
+namespace type
+{
+	class font;
+}
+
+/**
+ * Draws the primitives of the current debug::draw frame in at most two draw calls.
+ *
+ * Lines are drawn by a single draw, depth tested against the scene but not writing depth, by the `debug-draw-lines.glsl` shader program, which receives camera-relative positions at @ref VERTEX_POSITION_LOCATION, colors at @ref VERTEX_COLOR_LOCATION, and the `view_projection` matrix of the camera. Text labels are laid out on the CPU, at the projected positions of their anchors, and drawn by a single draw over the scene by the `debug-draw-text.glsl` shader program, which receives normalized device coordinates (vec2) at @ref VERTEX_POSITION_LOCATION, atlas texture coordinates at @ref VERTEX_TEXCOORD_LOCATION, colors at @ref VERTEX_COLOR_LOCATION, and the font `atlas`, whose distances it should threshold at `0.5`.
+ */
+class debug_draw_pass: public render_pass
+{
+public:
+	debug_draw_pass(gl::rasterizer* rasterizer, const gl::framebuffer* framebuffer, resource_manager* resource_manager);
+	virtual ~debug_draw_pass();
+	virtual void render(render_context* context) const final;
+	
+	/**
+	 * Sets the font of text labels.
+	 *
+	 * @param font Font of text labels, or `nullptr` to draw no labels.
+	 */
+	void set_font(type::font* font);
+
+private:
+	gl::shader_program* line_shader;
+	const gl::shader_input* line_view_projection_input;
+	
+	gl::shader_program* text_shader;
+	const gl::shader_input* text_atlas_input;
+	
+	gl::vertex_buffer* line_vbo;
+	gl::vertex_array* line_vao;
+	gl::vertex_buffer* text_vbo;
+	gl::vertex_array* text_vao;
+	
+	type::font* font;
+	
+	mutable std::vector<float> vertex_data;
+};
+
+#endif // ANTKEEPER_DEBUG_DRAW_PASS_HPP
@@ -28,13 +28,13 @@
 #include "gl/vertex-attribute-type.hpp"
 #include "gl/drawing-mode.hpp"
 #include "gl/texture-2d.hpp"
+#include "gl/texture-3d.hpp"
 #include "gl/texture-wrapping.hpp"
 #include "gl/texture-filter.hpp"
 #include "renderer/vertex-attributes.hpp"
 #include "renderer/render-context.hpp"
 #include "math/math.hpp"
 #include <cmath>
-#include <glad/glad.h>
 
 final_pass::final_pass(gl::rasterizer* rasterizer, const gl::framebuffer* framebuffer, resource_manager* resource_manager):
 	render_pass(rasterizer, framebuffer),
@@ -42,15 +42,26 @@ final_pass::final_pass(gl::rasterizer* rasterizer, const gl::framebuffer* frameb
 	bloom_texture(nullptr),
 	blue_noise_texture(nullptr),
 	blue_noise_scale(1.0),
-	time_tween(nullptr)
+	time_tween(nullptr),
+	color_grading_lut(nullptr),
+	color_grading_lut_dirty(true)
 {
 	shader_program = resource_manager->load<gl::shader_program>("final.glsl");
-	color_texture_input = shader_program->get_input("color_texture");
-	bloom_texture_input = shader_program->get_input("bloom_texture");
-	blue_noise_texture_input = shader_program->get_input("blue_noise_texture");
-	blue_noise_scale_input = shader_program->get_input("blue_noise_scale");
-	resolution_input = shader_program->get_input("resolution");
-	time_input = shader_program->get_input("time");
+	color_texture_input = shader_program->get_input("color_texture"_sid);
+	bloom_texture_input = shader_program->get_input("bloom_texture"_sid);
+	blue_noise_texture_input = shader_program->get_input("blue_noise_texture"_sid);
+	blue_noise_scale_input = shader_program->get_input("blue_noise_scale"_sid);
+	resolution_input = shader_program->get_input("resolution"_sid);
+	time_input = shader_program->get_input("time"_sid);
+	color_grading_lut_input = shader_program->get_input("color_grading_lut"_sid);
+	color_grading_lut_domain_input = shader_program->get_input("color_grading_lut_domain"_sid);
+	
+	// Allocate the color grading lookup table only if the final shader samples it
+	if (color_grading_lut_input)
+	{
+		const int size = static_cast<int>(color_grading_lut_size);
+		color_grading_lut = new gl::texture_3d(size, size, size, gl::pixel_type::float_32, gl::pixel_format::rgb);
+	}
 
 	const float vertex_data[] =
 	{
@@ -73,6 +84,7 @@ final_pass::final_pass(gl::rasterizer* rasterizer, const gl::framebuffer* frameb
 
 final_pass::~final_pass()
 {
+	delete color_grading_lut;
 	delete quad_vao;
 	delete quad_vbo;
 }
@@ -81,17 +93,25 @@ void final_pass::render(render_context* context) const
 {
 	rasterizer->use_framebuffer(*framebuffer);
 	
-	glDisable(GL_BLEND);
-	glDisable(GL_DEPTH_TEST);
-	glDepthMask(GL_FALSE);
-	glEnable(GL_CULL_FACE);
-	glCullFace(GL_BACK);
+	gl::render_state state;
+	state.depth_write_enabled = false;
+	state.cull_enabled = true;
+	rasterizer->set_render_state(state);
 
 	auto viewport = framebuffer->get_dimensions();
 	rasterizer->set_viewport(0, 0, std::get<0>(viewport), std::get<1>(viewport));
 	
 	float2 resolution = {std::get<0>(viewport), std::get<1>(viewport)};
 	float time = (time_tween) ? (*time_tween)[context->alpha] : 0.0f;
+	
+	// Rebake the color grading lookup table if the grading parameters have changed
+	if (color_grading_lut && color_grading_lut_dirty)
+	{
+		std::vector<float3> table(color_grading_lut_size * color_grading_lut_size * color_grading_lut_size);
+		bake_color_grading_lut(color_grading, color_grading_lut_size, table.data());
+		color_grading_lut->update(table.data());
+		color_grading_lut_dirty = false;
+	}
 
 	// Change shader program
 	rasterizer->use_program(*shader_program);
@@ -108,6 +128,10 @@ void final_pass::render(render_context* context) const
 		resolution_input->upload(resolution);
 	if (time_input)
 		time_input->upload(time);
+	if (color_grading_lut)
+		color_grading_lut_input->upload(color_grading_lut);
+	if (color_grading_lut_domain_input)
+		color_grading_lut_domain_input->upload(float3{color_grading_lut_min_log2, color_grading_lut_max_log2, static_cast<float>(color_grading_lut_size)});
 
 	// Draw quad
 	rasterizer->draw_arrays(*quad_vao, gl::drawing_mode::triangles, 0, 6);
@@ -116,11 +140,13 @@ void final_pass::render(render_context* context) const
 void final_pass::set_color_texture(const gl::texture_2d* texture)
 {
 	this->color_texture = texture;
+	set_input(0, texture);
 }
 
 void final_pass::set_bloom_texture(const gl::texture_2d* texture)
 {
 	this->bloom_texture = texture;
+	set_input(1, texture);
 }
 
 void final_pass::set_blue_noise_texture(const gl::texture_2d* texture)
@@ -133,3 +159,9 @@ void final_pass::set_time_tween(const tween<double>* time)
 {
 	this->time_tween = time;
 }
+
+void final_pass::set_color_grading(const ::color_grading& grading)
+{
+	color_grading = grading;
+	color_grading_lut_dirty = true;
+}
@@ -27,16 +27,24 @@
 #include "gl/vertex-buffer.hpp"
 #include "gl/vertex-array.hpp"
 #include "gl/texture-2d.hpp"
+#include "gl/texture-3d.hpp"
+#include "renderer/color-grading.hpp"
 #include "animation/tween.hpp"
+#include <vector>
 
 class resource_manager;
 
 /**
+ * Composites bloom over the color texture, then tone maps, grades, and dithers it into the framebuffer.
  *
+ * Tone mapping and color grading are baked into a 3D lookup table, which is uploaded to the `color_grading_lut` input of the final shader along with the `color_grading_lut_domain` input, containing color_grading_lut_min_log2, color_grading_lut_max_log2, and the number of entries along each axis. The shader should index the table by the base-2 logarithms of the composited color, offset to the centers of the entries at each end, so that each pixel performs a single texture fetch rather than evaluating the grading. The table is rebaked only when the grading parameters change.
  */
 class final_pass: public render_pass
 {
 public:
+	/// Number of entries along each axis of the color grading lookup table.
+	static constexpr std::size_t color_grading_lut_size = 32;
+	
 	final_pass(gl::rasterizer* rasterizer, const gl::framebuffer* framebuffer, resource_manager* resource_manager);
 	virtual ~final_pass();
 	virtual void render(render_context* context) const final;
@@ -45,6 +53,16 @@ public:
 	void set_bloom_texture(const gl::texture_2d* texture);
 	void set_blue_noise_texture(const gl::texture_2d* texture);
 	void set_time_tween(const tween<double>* time);
+	
+	/**
+	 * Sets the tone mapping and color grading parameters, which are baked into the color grading lookup table before the next render.
+	 *
+	 * @param grading Color grading parameters.
+	 */
+	void set_color_grading(const ::color_grading& grading);
+	
+	/// Returns the tone mapping and color grading parameters.
+	const ::color_grading& get_color_grading() const;
 
 private:
 	gl::shader_program* shader_program;
@@ -54,6 +72,8 @@ private:
 	const gl::shader_input* blue_noise_scale_input;
 	const gl::shader_input* resolution_input;
 	const gl::shader_input* time_input;
+	const gl::shader_input* color_grading_lut_input;
+	const gl::shader_input* color_grading_lut_domain_input;
 	gl::vertex_buffer* quad_vbo;
 	gl::vertex_array* quad_vao;
 	
@@ -63,7 +83,16 @@ private:
 	float blue_noise_scale;
 	
 	const tween<double>* time_tween;
+	
+	::color_grading color_grading;
+	gl::texture_3d* color_grading_lut;
+	mutable bool color_grading_lut_dirty;
 };
 
+inline const ::color_grading& final_pass::get_color_grading() const
+{
+	return color_grading;
+}
+
 #endif // ANTKEEPER_FINAL_PASS_HPP
 
@@ -19,6 +19,7 @@
 
 #include "renderer/passes/material-pass.hpp"
 #include "configuration.hpp"
+#include "debug/counters.hpp"
 #include "resources/resource-manager.hpp"
 #include "gl/rasterizer.hpp"
 #include "gl/framebuffer.hpp"
@@ -31,10 +32,14 @@
 #include "gl/texture-2d.hpp"
 #include "gl/texture-wrapping.hpp"
 #include "gl/texture-filter.hpp"
+#include "gl/uniform-buffer.hpp"
 #include "renderer/vertex-attributes.hpp"
 #include "renderer/material-flags.hpp"
 #include "renderer/model.hpp"
 #include "renderer/render-context.hpp"
+#include "renderer/light-clusters.hpp"
+#include "renderer/skinning-stage.hpp"
+#include "renderer/texture-streamer.hpp"
 #include "scene/camera.hpp"
 #include "scene/collection.hpp"
 #include "scene/ambient-light.hpp"
@@ -43,77 +48,147 @@
 #include "scene/spot-light.hpp"
 #include "configuration.hpp"
 #include "math/math.hpp"
+#include <algorithm>
 #include <cmath>
-#include <glad/glad.h>
+#include <cstring>
 
 #include "shadow-map-pass.hpp"
+#include "shadow-atlas-pass.hpp"
 
-static bool operation_compare(const render_operation& a, const render_operation& b);
+/**
+ * Returns the number of elements of a light array which can be uploaded to an array shader input.
+ *
+ * @param input Array shader input.
+ * @param count Number of elements in the light array.
+ */
+static int clamp_light_count(const gl::shader_input* input, std::size_t count);
+
+/**
+ * Returns `true` if a render operation can be merged with others into an instanced draw. Skinned, explicitly instanced, and occluded operations are not batched.
+ *
+ * @param operation Render operation.
+ */
+static bool is_batchable(const render_operation& operation);
+
+/**
+ * Returns `true` if the depth of a render operation is rendered by the depth pre-pass.
+ *
+ * @param operation Render operation.
+ * @param material Material of the operation, or the fallback material if it has none.
+ */
+static bool is_depth_prepassed(const render_operation& operation, const material* material);
+
+/**
+ * Returns `true` if a material is sorted and drawn as weighted blended.
+ *
+ * @param material Material, or `nullptr`.
+ */
+static bool is_weighted_blended(const material* material);
+
+/// Render state flag, beyond the range of material flags, of operations shaded against the depth pre-pass.
+static constexpr std::uint32_t depth_prepassed_state_flag = 0x40000000;
+
+/// Render state flag, beyond the range of material flags, of operations accumulated into the OIT framebuffer.
+static constexpr std::uint32_t weighted_blended_state_flag = 0x20000000;
+
+/**
+ * Generates the render state with which materials with the specified flags are rendered.
+ *
+ * @param flags Material flags, `depth_prepassed_state_flag` if the depth of the operations has been pre-passed, and `weighted_blended_state_flag` if the operations are accumulated into the OIT framebuffer.
+ */
+static gl::render_state generate_render_state(std::uint32_t flags);
 
 material_pass::material_pass(gl::rasterizer* rasterizer, const gl::framebuffer* framebuffer, resource_manager* resource_manager):
 	render_pass(rasterizer, framebuffer),
 	fallback_material(nullptr),
+	texture_streamer(nullptr),
 	time_tween(nullptr),
 	mouse_position({0.0f, 0.0f}),
 	focal_point_tween(nullptr),
 	shadow_map_pass(nullptr),
-	shadow_map(nullptr)
+	shadow_map(nullptr),
+	clustered_lighting(false),
+	clusters(nullptr),
+	light_cluster_texture(nullptr),
+	light_index_texture(nullptr),
+	light_texture(nullptr),
+	shadow_atlas_pass(nullptr),
+	shadow_atlas(nullptr),
+	light_shadow_texture(nullptr),
+	depth_prepass(false),
+	oit_accumulation_texture(nullptr),
+	oit_weight_texture(nullptr),
+	oit_framebuffer(nullptr),
+	quad_vbo(nullptr),
+	quad_vao(nullptr)
 {
-	max_ambient_light_count = MATERIAL_PASS_MAX_AMBIENT_LIGHT_COUNT;
-	max_point_light_count = MATERIAL_PASS_MAX_POINT_LIGHT_COUNT;
-	max_directional_light_count = MATERIAL_PASS_MAX_DIRECTIONAL_LIGHT_COUNT;
-	max_spot_light_count = MATERIAL_PASS_MAX_SPOTLIGHT_COUNT;
-	
-	ambient_light_colors = new float3[max_ambient_light_count];
-	point_light_colors = new float3[max_point_light_count];
-	point_light_positions = new float3[max_point_light_count];
-	point_light_attenuations = new float3[max_point_light_count];
-	directional_light_colors = new float3[max_directional_light_count];
-	directional_light_directions = new float3[max_directional_light_count];
-	directional_light_textures = new const gl::texture_2d*[max_directional_light_count];
-	directional_light_texture_matrices = new float4x4[max_directional_light_count];
-	directional_light_texture_opacities = new float[max_directional_light_count];
-	
-	spot_light_colors = new float3[max_spot_light_count];
-	spot_light_positions = new float3[max_spot_light_count];
-	spot_light_directions = new float3[max_spot_light_count];
-	spot_light_attenuations = new float3[max_spot_light_count];
-	spot_light_cutoffs = new float2[max_spot_light_count];
+	// Load the depth programs of the depth pre-pass, shared with the shadow map pass
+	depth_unskinned_program = resource_manager->load<gl::shader_program>("depth-unskinned.glsl");
+	depth_unskinned_model_view_projection_input = (depth_unskinned_program) ? depth_unskinned_program->get_input("model_view_projection"_sid) : nullptr;
+	depth_skinned_program = resource_manager->load<gl::shader_program>("depth-skinned.glsl");
+	depth_skinned_model_view_projection_input = (depth_skinned_program) ? depth_skinned_program->get_input("model_view_projection"_sid) : nullptr;
+	if (depth_skinned_program)
+		depth_skinned_program->bind_uniform_block("bone_palette_block"_sid, skinning_stage::bone_palette_binding);
+	
+	// Load the composite program of weighted blended order-independent transparency, and its fullscreen quad
+	oit_composite_program = resource_manager->load<gl::shader_program>("oit-composite.glsl");
+	oit_accumulation_texture_input = (oit_composite_program) ? oit_composite_program->get_input("accumulation_texture"_sid) : nullptr;
+	oit_weight_texture_input = (oit_composite_program) ? oit_composite_program->get_input("weight_texture"_sid) : nullptr;
+	if (oit_composite_program)
+	{
+		const float vertex_data[] =
+		{
+			-1.0f,  1.0f, 0.0f,
+			-1.0f, -1.0f, 0.0f,
+			 1.0f,  1.0f, 0.0f,
+			 1.0f,  1.0f, 0.0f,
+			-1.0f, -1.0f, 0.0f,
+			 1.0f, -1.0f, 0.0f
+		};
+		
+		std::size_t vertex_size = 3;
+		std::size_t vertex_stride = sizeof(float) * vertex_size;
+		std::size_t vertex_count = 6;
+		
+		quad_vbo = new gl::vertex_buffer(sizeof(float) * vertex_size * vertex_count, vertex_data);
+		quad_vao = new gl::vertex_array();
+		quad_vao->bind_attribute(VERTEX_POSITION_LOCATION, *quad_vbo, 3, gl::vertex_attribute_type::float_32, vertex_stride, 0);
+	}
+	
+
+	// Allocate uniform buffers. The light buffer is allocated at full capacity, as binding a buffer smaller than its uniform block is undefined.
+	frame_buffer = new gl::uniform_buffer(sizeof(frame_block), nullptr, gl::buffer_usage::dynamic_draw);
+	light_buffer = new gl::uniform_buffer(light_block_capacity * sizeof(float4), nullptr, gl::buffer_usage::dynamic_draw);
+	light_data.reserve(light_block_capacity);
+	
+	// Allocate instance buffer
+	instance_buffer = new gl::uniform_buffer(instance_block_capacity * sizeof(float4x4), nullptr, gl::buffer_usage::stream_draw);
+	instance_data = new float4x4[instance_block_capacity];
+	batching_stats = {};
 }
 
 material_pass::~material_pass()
 {
-	delete[] ambient_light_colors;
-	delete[] point_light_colors;
-	delete[] point_light_positions;
-	delete[] point_light_attenuations;
-	delete[] directional_light_colors;
-	delete[] directional_light_directions;
-	delete[] directional_light_textures;
-	delete[] directional_light_texture_matrices;
-	delete[] directional_light_texture_opacities;
-	delete[] spot_light_colors;
-	delete[] spot_light_positions;
-	delete[] spot_light_directions;
-	delete[] spot_light_attenuations;
-	delete[] spot_light_cutoffs;
+	delete frame_buffer;
+	delete light_buffer;
+	delete instance_buffer;
+	delete[] instance_data;
+	
+	set_clustered_lighting(false);
+	set_weighted_blended_oit(false);
+	set_shadow_atlas(nullptr, nullptr);
+	delete quad_vao;
+	delete quad_vbo;
+	
+	for (auto it = parameter_sets.begin(); it != parameter_sets.end(); ++it)
+		delete it->second;
 }
 
 void material_pass::render(render_context* context) const
 {
 	rasterizer->use_framebuffer(*framebuffer);
 	
-	glDisable(GL_BLEND);
-	glEnable(GL_DEPTH_TEST);
-	glDepthMask(GL_TRUE);
-	glDepthFunc(GL_GREATER);
-	glEnable(GL_CULL_FACE);
-	glCullFace(GL_BACK);
-	glDisable(GL_STENCIL_TEST);
-	glStencilMask(0x00);
-	
-	// For half-z buffer
-	glDepthRange(-1.0f, 1.0f);
+	rasterizer->set_render_state(generate_render_state(0));
 
 	auto viewport = framebuffer->get_dimensions();
 	rasterizer->set_viewport(0, 0, std::get<0>(viewport), std::get<1>(viewport));
@@ -126,6 +201,9 @@ void material_pass::render(render_context* context) const
 	float4x4 view = context->camera->get_view_tween().interpolate(context->alpha);
 	float4x4 projection = context->camera->get_projection_tween().interpolate(context->alpha);
 	float4x4 view_projection = projection * view;
+	
+	// The normal matrix of model_view is the product of the normal matrices of view and model, so only the view's is inverted per frame
+	const float3x3 normal_view = math::transpose(math::inverse(math::resize<3, 3>(view)));
 	float4x4 model_view_projection;
 	float4x4 model;
 	float4x4 model_view;
@@ -139,20 +217,50 @@ void material_pass::render(render_context* context) const
 	float camera_exposure = std::exp2(context->camera->get_exposure_tween().interpolate(context->alpha));
 
 
-	int active_material_flags = 0;
+	std::uint32_t active_material_flags = 0;
 	const gl::shader_program* active_shader_program = nullptr;
 	const ::material* active_material = nullptr;
 	const parameter_set* parameters = nullptr;
 	
-	// Reset light counts
-	ambient_light_count = 0;
-	point_light_count = 0;
-	directional_light_count = 0;
-	spot_light_count = 0;
+	// Reset lights
+	ambient_light_colors.clear();
+	point_light_colors.clear();
+	point_light_positions.clear();
+	point_light_attenuations.clear();
+	directional_light_colors.clear();
+	directional_light_directions.clear();
+	directional_light_textures.clear();
+	directional_light_texture_matrices.clear();
+	directional_light_texture_opacities.clear();
+	spot_light_colors.clear();
+	spot_light_positions.clear();
+	spot_light_directions.clear();
+	spot_light_attenuations.clear();
+	spot_light_cutoffs.clear();
+	point_lights.clear();
+	spot_lights.clear();
+	
+	// Collect lights. If the collection is spatially indexed, only lights whose spheres of influence may reach the camera culling volume are collected.
+	light_objects.clear();
+	if (context->collection->is_spatially_indexed() && context->camera_culling_volume->get_bounding_volume_type() == geom::bounding_volume_type::convex_hull)
+	{
+		context->collection->query
+		(
+			scene::light::object_type_id,
+			static_cast<const geom::convex_hull<float>&>(*context->camera_culling_volume),
+			[this](const scene::object_base* object)
+			{
+				light_objects.push_back(object);
+			}
+		);
+	}
+	else
+	{
+		const std::vector<scene::object_base*>* lights = context->collection->get_objects(scene::light::object_type_id);
+		light_objects.assign(lights->begin(), lights->end());
+	}
 	
-	// Collect lights
-	const std::list<scene::object_base*>* lights = context->collection->get_objects(scene::light::object_type_id);
-	for (const scene::object_base* object: *lights)
+	for (const scene::object_base* object: light_objects)
 	{
 		// Skip inactive lights
 		if (!object->is_active())
@@ -164,68 +272,56 @@ void material_pass::render(render_context* context) const
 			// Add ambient light
 			case scene::light_type::ambient:
 			{
-				if (ambient_light_count < max_ambient_light_count)
-				{
-					// Pre-expose light
-					ambient_light_colors[ambient_light_count] = light->get_scaled_color_tween().interpolate(context->alpha) * camera_exposure;
-					++ambient_light_count;
-				}
+				// Pre-expose light
+				ambient_light_colors.push_back(light->get_scaled_color_tween().interpolate(context->alpha) * camera_exposure);
 				break;
 			}
 			
 			// Add point light
 			case scene::light_type::point:
 			{
-				if (point_light_count < max_point_light_count)
-				{
-					// Pre-expose light
-					point_light_colors[point_light_count] = light->get_scaled_color_tween().interpolate(context->alpha) * camera_exposure;
-					
-					float3 position = light->get_transform_tween().interpolate(context->alpha).translation;
-					point_light_positions[point_light_count] = position;
-					
-					point_light_attenuations[point_light_count] = static_cast<const scene::point_light*>(light)->get_attenuation_tween().interpolate(context->alpha);
-					++point_light_count;
-				}
+				// Pre-expose light
+				point_light_colors.push_back(light->get_scaled_color_tween().interpolate(context->alpha) * camera_exposure);
+				
+				float3 position = get_relative_transform(*context, *light).translation;
+				point_light_positions.push_back(position);
+				
+				point_light_attenuations.push_back(static_cast<const scene::point_light*>(light)->get_attenuation_tween().interpolate(context->alpha));
+				point_lights.push_back(light);
 				break;
 			}
 			
 			// Add directional light
 			case scene::light_type::directional:
 			{
-				if (directional_light_count < max_directional_light_count)
-				{
-					const scene::directional_light* directional_light = static_cast<const scene::directional_light*>(light);
+				const scene::directional_light* directional_light = static_cast<const scene::directional_light*>(light);
 
-					// Pre-expose light
-					directional_light_colors[directional_light_count] = light->get_scaled_color_tween().interpolate(context->alpha) * camera_exposure;
-					
-					float3 direction = static_cast<const scene::directional_light*>(light)->get_direction_tween().interpolate(context->alpha);
-					directional_light_directions[directional_light_count] = direction;
+				// Pre-expose light
+				directional_light_colors.push_back(light->get_scaled_color_tween().interpolate(context->alpha) * camera_exposure);
+				
+				float3 direction = static_cast<const scene::directional_light*>(light)->get_direction_tween().interpolate(context->alpha);
+				directional_light_directions.push_back(direction);
+				
+				if (directional_light->get_light_texture())
+				{
+					directional_light_textures.push_back(directional_light->get_light_texture());
+					directional_light_texture_opacities.push_back(directional_light->get_light_texture_opacity_tween().interpolate(context->alpha));
 					
+					math::transform<float> light_transform = get_relative_transform(*context, *light);
+					float3 forward = light_transform.rotation * global_forward;
+					float3 up = light_transform.rotation * global_up;
+					float4x4 light_view = math::look_at(light_transform.translation, light_transform.translation + forward, up);
 					
-					if (directional_light->get_light_texture())
-					{
-						directional_light_textures[directional_light_count] = directional_light->get_light_texture();
-						directional_light_texture_opacities[directional_light_count] = directional_light->get_light_texture_opacity_tween().interpolate(context->alpha);
-						
-						math::transform<float> light_transform = light->get_transform_tween().interpolate(context->alpha);
-						float3 forward = light_transform.rotation * global_forward;
-						float3 up = light_transform.rotation * global_up;
-						float4x4 light_view = math::look_at(light_transform.translation, light_transform.translation + forward, up);
-						
-						float2 scale = directional_light->get_light_texture_scale_tween().interpolate(context->alpha);
-						float4x4 light_projection = math::ortho(-scale.x, scale.x, -scale.y, scale.y, -1.0f, 1.0f);
-						
-						directional_light_texture_matrices[directional_light_count] = light_projection * light_view;
-					}
-					else
-					{
-						directional_light_textures[directional_light_count] = nullptr;
-						directional_light_texture_opacities[directional_light_count] = 0.0f;
-					}
+					float2 scale = directional_light->get_light_texture_scale_tween().interpolate(context->alpha);
+					float4x4 light_projection = math::ortho(-scale.x, scale.x, -scale.y, scale.y, -1.0f, 1.0f);
 					
-					++directional_light_count;
+					directional_light_texture_matrices.push_back(light_projection * light_view);
+				}
+				else
+				{
+					directional_light_textures.push_back(nullptr);
+					directional_light_texture_opacities.push_back(0.0f);
+					directional_light_texture_matrices.push_back(math::identity4x4<float>);
 				}
 				break;
 			}
@@ -233,24 +329,20 @@ void material_pass::render(render_context* context) const
 			// Add spot_light
 			case scene::light_type::spot:
 			{
-				if (spot_light_count < max_spot_light_count)
-				{
-					const scene::spot_light* spot_light = static_cast<const scene::spot_light*>(light);
+				const scene::spot_light* spot_light = static_cast<const scene::spot_light*>(light);
 
-					// Pre-expose light
-					spot_light_colors[spot_light_count] = light->get_scaled_color_tween().interpolate(context->alpha) * camera_exposure;
-					
-					float3 position = light->get_transform_tween().interpolate(context->alpha).translation;
-					spot_light_positions[spot_light_count] = position;
-					
-					float3 direction = spot_light->get_direction_tween().interpolate(context->alpha);
-					spot_light_directions[spot_light_count] = direction;
-					
-					spot_light_attenuations[spot_light_count] = spot_light->get_attenuation_tween().interpolate(context->alpha);
-					spot_light_cutoffs[spot_light_count] = spot_light->get_cosine_cutoff_tween().interpolate(context->alpha);
-					
-					++spot_light_count;
-				}
+				// Pre-expose light
+				spot_light_colors.push_back(light->get_scaled_color_tween().interpolate(context->alpha) * camera_exposure);
+				
+				float3 position = get_relative_transform(*context, *light).translation;
+				spot_light_positions.push_back(position);
+				
+				float3 direction = spot_light->get_direction_tween().interpolate(context->alpha);
+				spot_light_directions.push_back(direction);
+				
+				spot_light_attenuations.push_back(spot_light->get_attenuation_tween().interpolate(context->alpha));
+				spot_light_cutoffs.push_back(spot_light->get_cosine_cutoff_tween().interpolate(context->alpha));
+				spot_lights.push_back(light);
 				break;
 			}
 
@@ -272,11 +364,129 @@ void material_pass::render(render_context* context) const
 			shadow_splits_directional[i] = shadow_map_pass->get_split_distances()[i + 1];
 	}
 	
-	// Sort render operations
-	context->operations.sort(operation_compare);
+	// Assign point and spot lights to clusters
+	if (clustered_lighting && !context->camera->is_orthographic())
+		build_light_clusters(context, view);
+	
+	// Pack the shadows of point and spot lights
+	if (shadow_atlas_pass)
+		build_light_shadows();
+	
+	// Fill frame block
+	frame_data.view = view;
+	frame_data.projection = projection;
+	frame_data.view_projection = view_projection;
+	for (int i = 0; i < 4; ++i)
+		frame_data.shadow_matrices_directional[i] = shadow_matrices_directional[i];
+	frame_data.shadow_splits_directional = shadow_splits_directional;
+	frame_data.camera = {camera_position.x, camera_position.y, camera_position.z, camera_exposure};
+	frame_data.resolution_mouse = {resolution.x, resolution.y, mouse_position.x, mouse_position.y};
+	frame_data.time_clip_depth = {time, clip_depth[0], clip_depth[1], log_depth_coef};
+	frame_data.focal_point = {focal_point.x, focal_point.y, focal_point.z, 0.0f};
+	
+	// Pack lights into light block, skipping those which do not fit
+	const std::size_t header_size = sizeof(light_block_header) / sizeof(float4);
+	light_data.resize(header_size);
+	light_block_header header;
+	
+	header.light_offsets[0] = static_cast<int>(light_data.size());
+	header.light_counts[0] = 0;
+	for (std::size_t i = 0; i < ambient_light_colors.size() && light_data.size() + 1 <= light_block_capacity; ++i)
+	{
+		light_data.push_back(float4{ambient_light_colors[i].x, ambient_light_colors[i].y, ambient_light_colors[i].z, 0.0f});
+		++header.light_counts[0];
+	}
+	
+	header.light_offsets[1] = static_cast<int>(light_data.size());
+	header.light_counts[1] = 0;
+	for (std::size_t i = 0; i < point_light_colors.size() && light_data.size() + 3 <= light_block_capacity; ++i)
+	{
+		light_data.push_back(math::resize<4>(point_light_colors[i]));
+		light_data.push_back(math::resize<4>(point_light_positions[i]));
+		light_data.push_back(math::resize<4>(point_light_attenuations[i]));
+		++header.light_counts[1];
+	}
+	
+	header.light_offsets[2] = static_cast<int>(light_data.size());
+	header.light_counts[2] = 0;
+	for (std::size_t i = 0; i < directional_light_colors.size() && light_data.size() + 6 <= light_block_capacity; ++i)
+	{
+		const float3& color = directional_light_colors[i];
+		light_data.push_back(float4{color.x, color.y, color.z, directional_light_texture_opacities[i]});
+		light_data.push_back(math::resize<4>(directional_light_directions[i]));
+		for (int j = 0; j < 4; ++j)
+			light_data.push_back(directional_light_texture_matrices[i][j]);
+		++header.light_counts[2];
+	}
+	
+	header.light_offsets[3] = static_cast<int>(light_data.size());
+	header.light_counts[3] = 0;
+	for (std::size_t i = 0; i < spot_light_colors.size() && light_data.size() + 5 <= light_block_capacity; ++i)
+	{
+		light_data.push_back(math::resize<4>(spot_light_colors[i]));
+		light_data.push_back(math::resize<4>(spot_light_positions[i]));
+		light_data.push_back(math::resize<4>(spot_light_directions[i]));
+		light_data.push_back(math::resize<4>(spot_light_attenuations[i]));
+		light_data.push_back(math::resize<4>(spot_light_cutoffs[i]));
+		++header.light_counts[3];
+	}
+	
+	std::memcpy(light_data.data(), &header, sizeof(light_block_header));
+	
+	// Upload and bind uniform buffers once for all shader programs
+	frame_buffer->update(0, sizeof(frame_block), &frame_data);
+	light_buffer->update(0, light_data.size() * sizeof(float4), light_data.data());
+	rasterizer->bind_uniform_buffer(*frame_buffer, frame_block_binding);
+	rasterizer->bind_uniform_buffer(*light_buffer, light_block_binding);
+	rasterizer->bind_uniform_buffer(*instance_buffer, instance_block_binding);
+	
+	// Sort render operations by their precomputed keys
+	context->operations->sort();
 
-	for (const render_operation& operation: context->operations)
+	// Render the depth of opaque operations, then restore the initial render state
+	if (depth_prepass)
 	{
+		render_depth_prepass(*context, view_projection);
+		rasterizer->set_render_state(generate_render_state(0));
+	}
+	
+	// Without an OIT framebuffer, draw the state-sorted weighted blended operations back to front, like other translucent operations
+	if (!oit_framebuffer)
+	{
+		render_operation* first = context->operations->begin();
+		render_operation* last = first + context->operations->size();
+		first = std::find_if(first, last, [](const render_operation& operation){return is_weighted_blended(operation.material);});
+		last = std::find_if_not(first, last, [](const render_operation& operation){return is_weighted_blended(operation.material);});
+		std::sort(first, last, [](const render_operation& a, const render_operation& b){return a.depth > b.depth;});
+	}
+	
+	// Match the OIT targets to the framebuffer, which may have been resized along with its attachments
+	if (oit_framebuffer && oit_framebuffer->get_dimensions() != viewport)
+	{
+		for (gl::texture_2d* texture: {oit_accumulation_texture, oit_weight_texture})
+			texture->resize(std::get<0>(viewport), std::get<1>(viewport), texture->get_pixel_type(), texture->get_pixel_format(), texture->get_color_space(), nullptr);
+		oit_framebuffer->resize(viewport);
+	}
+	
+	// Whether weighted blended operations are being accumulated into the OIT framebuffer, and whether any have been since it was last composited
+	bool oit_bound = false;
+	bool oit_accumulated = false;
+	
+	// Reset batching statistics
+	batching_stats = {};
+	
+	const render_operation* operations = context->operations->begin();
+	const std::size_t operation_count = context->operations->size();
+	static debug::counter operation_counter("render.material_pass.operations");
+	operation_counter.add(static_cast<std::int64_t>(operation_count));
+	for (std::size_t i = 0; i < operation_count; ++i)
+	{
+		const render_operation& operation = operations[i];
+		
+		// Skip operations hidden by the occlusion buffer
+		if (operation.occluded)
+			continue;
+		
 		// Get operation material
 		const ::material* material = operation.material;
 		if (!material)
@@ -293,131 +503,61 @@ void material_pass::render(render_context* context) const
 			}
 		}
 		
+		// Composite the accumulated weighted blended operations before the translucent operations which follow them
+		if (oit_accumulated && !is_weighted_blended(material))
+		{
+			composite_weighted_blended();
+			oit_bound = false;
+			oit_accumulated = false;
+			
+			// Restore the initial render state, and rebind the material and shader program
+			rasterizer->set_render_state(generate_render_state(0));
+			active_material_flags = 0;
+			active_material = nullptr;
+			active_shader_program = nullptr;
+		}
+		
+		// Report the projected diameter of the operation's bounds, from which the texture streamer selects the mip levels of the material's textures
+		if (texture_streamer)
+		{
+			const float diameter = math::length(operation.bounds.max_point - operation.bounds.min_point);
+			const float w = (context->camera->is_orthographic()) ? 1.0f : std::max(operation.depth, 0.0f) + clip_depth[0];
+			texture_streamer->add_usage(material, diameter * projection[1][1] * resolution.y * 0.5f / w);
+		}
+		
 		// Switch materials if necessary
 		if (active_material != material)
 		{
 			active_material = material;
 			
-			// Change rasterizer state according to material flags
-			std::uint32_t material_flags = active_material->get_flags();
-			if (active_material_flags != material_flags)
+			// Switch shaders if necessary
+			const gl::shader_program* shader_program = active_material->get_shader_program();
+			
+			// Accumulate weighted blended materials into the OIT framebuffer with the OIT variants of their shader programs
+			const gl::shader_program* oit_variant = (oit_framebuffer && shader_program && is_weighted_blended(active_material)) ? shader_program->get_variant("WEIGHTED_BLENDED_OIT"_fnv1a64) : nullptr;
+			if (oit_variant)
+				shader_program = oit_variant;
+			if (oit_bound != static_cast<bool>(oit_variant))
 			{
-				if ((material_flags & MATERIAL_FLAG_TRANSLUCENT) != (active_material_flags & MATERIAL_FLAG_TRANSLUCENT))
+				oit_bound = static_cast<bool>(oit_variant);
+				if (oit_bound)
 				{
-					if (material_flags & MATERIAL_FLAG_TRANSLUCENT)
-					{
-						glEnable(GL_BLEND);
-						glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-					}
-					else
-					{
-						glDisable(GL_BLEND);
-					}
-				}
-
-				if ((material_flags & MATERIAL_FLAG_BACK_FACES) != (active_material_flags & MATERIAL_FLAG_BACK_FACES))
-				{
-					if (material_flags & MATERIAL_FLAG_BACK_FACES)
-					{
-						glEnable(GL_CULL_FACE);
-						glCullFace(GL_FRONT);
-					}
-					else
-					{
-						glEnable(GL_CULL_FACE);
-						glCullFace(GL_BACK);
-					}
-				}
-				else if ((material_flags & MATERIAL_FLAG_FRONT_AND_BACK_FACES) != (active_material_flags & MATERIAL_FLAG_FRONT_AND_BACK_FACES))
-				{
-					if (material_flags & MATERIAL_FLAG_FRONT_AND_BACK_FACES)
-					{
-						glDisable(GL_CULL_FACE);
-					}
-					else
-					{
-						glEnable(GL_CULL_FACE);
-						glCullFace(GL_BACK);
-					}
-				}
-
-				if ((material_flags & MATERIAL_FLAG_X_RAY) != (active_material_flags & MATERIAL_FLAG_X_RAY))
-				{
-					if (material_flags & MATERIAL_FLAG_X_RAY)
-					{
-						glDisable(GL_DEPTH_TEST);
-
-					}
-					else
-					{
-						glEnable(GL_DEPTH_TEST);
-					}
-				}
-				
-				if ((material_flags & MATERIAL_FLAG_DECAL_SURFACE) != (active_material_flags & MATERIAL_FLAG_DECAL_SURFACE))
-				{
-					if (material_flags & MATERIAL_FLAG_DECAL_SURFACE)
-					{
-						glEnable(GL_STENCIL_TEST);
-						glStencilFunc(GL_ALWAYS, 1, ~0);
-						glStencilOp(GL_KEEP, GL_KEEP, GL_REPLACE);
-						glStencilMask(~0);
-					}
-					else
-					{
-						glDisable(GL_STENCIL_TEST);
-						glStencilMask(0);
-					}
-				}
-				
-				if ((material_flags & MATERIAL_FLAG_DECAL) != (active_material_flags & MATERIAL_FLAG_DECAL))
-				{
-					if (material_flags & MATERIAL_FLAG_DECAL)
-					{
-						glEnable(GL_DEPTH_TEST);
-						glDepthFunc(GL_GEQUAL);
-						glDepthMask(GL_FALSE);
-						
-						glEnable(GL_STENCIL_TEST);
-						glStencilFunc(GL_EQUAL, 1, ~0);
-						//glStencilOp(GL_KEEP, GL_KEEP, GL_ZERO);
-						//glStencilMask(~0);
-						glStencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
-						glStencilMask(0);
-					}
-					else
+					rasterizer->use_framebuffer(*oit_framebuffer);
+					
+					// Clear revealage to one, and accumulated colors and weights to zero
+					if (!oit_accumulated)
 					{
-						glEnable(GL_DEPTH_TEST);
-						glDepthFunc(GL_GREATER);
-						glDepthMask(GL_TRUE);
-						glDisable(GL_STENCIL_TEST);
-						glStencilMask(0);
+						rasterizer->set_clear_color(0.0f, 0.0f, 0.0f, 1.0f);
+						rasterizer->clear_framebuffer(true, false, false);
+						oit_accumulated = true;
 					}
 				}
-				
-				/*
-				if ((material_flags & MATERIAL_FLAG_OUTLINE) != (active_material_flags & MATERIAL_FLAG_OUTLINE))
+				else
 				{
-					if (material_flags & MATERIAL_FLAG_OUTLINE)
-					{
-						glEnable(GL_STENCIL_TEST);
-						glStencilOp(GL_KEEP, GL_KEEP, GL_REPLACE);  
-						glStencilFunc(GL_ALWAYS, 2, 0xFF);
-						glStencilMask(0xFF);
-					}
-					else
-					{
-						glDisable(GL_STENCIL_TEST);
-						glStencilMask(0x00);
-					}
+					rasterizer->use_framebuffer(*framebuffer);
 				}
-				*/
-
-				active_material_flags = material_flags;
 			}
 			
-			// Switch shaders if necessary
-			const gl::shader_program* shader_program = active_material->get_shader_program();
 			if (active_shader_program != shader_program)
 			{
 				active_shader_program = shader_program;
@@ -439,80 +579,189 @@ void material_pass::render(render_context* context) const
 					parameters = load_parameter_set(active_shader_program);
 				}
 
-				// Upload context-dependent shader parameters
-				if (parameters->time)
-					parameters->time->upload(time);
-				if (parameters->mouse)
-					parameters->mouse->upload(mouse_position);
-				if (parameters->resolution)
-					parameters->resolution->upload(resolution);
-				if (parameters->camera_position)
-					parameters->camera_position->upload(camera_position);
-				if (parameters->camera_exposure)
-					parameters->camera_exposure->upload(camera_exposure);
-				if (parameters->view)
-					parameters->view->upload(view);
-				if (parameters->view_projection)
-					parameters->view_projection->upload(view_projection);
-				if (parameters->ambient_light_count)
-					parameters->ambient_light_count->upload(ambient_light_count);
-				if (parameters->ambient_light_colors)
-					parameters->ambient_light_colors->upload(0, ambient_light_colors, ambient_light_count);
-				if (parameters->point_light_count)
-					parameters->point_light_count->upload(point_light_count);
-				if (parameters->point_light_colors)
-					parameters->point_light_colors->upload(0, point_light_colors, point_light_count);
-				if (parameters->point_light_positions)
-					parameters->point_light_positions->upload(0, point_light_positions, point_light_count);
-				if (parameters->point_light_attenuations)
-					parameters->point_light_attenuations->upload(0, point_light_attenuations, point_light_count);
-				if (parameters->directional_light_count)
-					parameters->directional_light_count->upload(directional_light_count);
-				if (parameters->directional_light_colors)
-					parameters->directional_light_colors->upload(0, directional_light_colors, directional_light_count);
-				if (parameters->directional_light_directions)
-					parameters->directional_light_directions->upload(0, directional_light_directions, directional_light_count);
-				
-				if (parameters->directional_light_textures)
-					parameters->directional_light_textures->upload(0, directional_light_textures, directional_light_count);
-				if (parameters->directional_light_texture_matrices)
-					parameters->directional_light_texture_matrices->upload(0, directional_light_texture_matrices, directional_light_count);
-				if (parameters->directional_light_texture_opacities)
-					parameters->directional_light_texture_opacities->upload(0, directional_light_texture_opacities, directional_light_count);
+				// Upload context-dependent shader parameters which are not provided by the frame block
+				if (!parameters->frame_block)
+				{
+					if (parameters->time)
+						parameters->time->upload(time);
+					if (parameters->mouse)
+						parameters->mouse->upload(mouse_position);
+					if (parameters->resolution)
+						parameters->resolution->upload(resolution);
+					if (parameters->camera_position)
+						parameters->camera_position->upload(camera_position);
+					if (parameters->camera_exposure)
+						parameters->camera_exposure->upload(camera_exposure);
+					if (parameters->view)
+						parameters->view->upload(view);
+					if (parameters->projection)
+						parameters->projection->upload(projection);
+					if (parameters->view_projection)
+						parameters->view_projection->upload(view_projection);
+					if (parameters->clip_depth)
+						parameters->clip_depth->upload(clip_depth);
+					if (parameters->log_depth_coef)
+						parameters->log_depth_coef->upload(log_depth_coef);
+					if (parameters->focal_point)
+						parameters->focal_point->upload(focal_point);
+					if (parameters->shadow_matrices_directional)
+						parameters->shadow_matrices_directional->upload(0, shadow_matrices_directional, 4);
+					if (parameters->shadow_splits_directional)
+						parameters->shadow_splits_directional->upload(shadow_splits_directional);
+				}
 				
-				if (parameters->spot_light_count)
-					parameters->spot_light_count->upload(spot_light_count);
-				if (parameters->spot_light_colors)
-					parameters->spot_light_colors->upload(0, spot_light_colors, spot_light_count);
-				if (parameters->spot_light_positions)
-					parameters->spot_light_positions->upload(0, spot_light_positions, spot_light_count);
-				if (parameters->spot_light_directions)
-					parameters->spot_light_directions->upload(0, spot_light_directions, spot_light_count);
-				if (parameters->spot_light_attenuations)
-					parameters->spot_light_attenuations->upload(0, spot_light_attenuations, spot_light_count);
-				if (parameters->spot_light_cutoffs)
-					parameters->spot_light_cutoffs->upload(0, spot_light_cutoffs, spot_light_count);
-				if (parameters->focal_point)
-					parameters->focal_point->upload(focal_point);
+				// Upload lights which are not provided by the light block
+				if (!parameters->light_block)
+				{
+					int count = clamp_light_count(parameters->ambient_light_colors, ambient_light_colors.size());
+					if (parameters->ambient_light_count)
+						parameters->ambient_light_count->upload(count);
+					if (parameters->ambient_light_colors)
+						parameters->ambient_light_colors->upload(0, ambient_light_colors.data(), count);
+					
+					count = clamp_light_count(parameters->point_light_colors, point_light_colors.size());
+					if (parameters->point_light_count)
+						parameters->point_light_count->upload(count);
+					if (parameters->point_light_colors)
+						parameters->point_light_colors->upload(0, point_light_colors.data(), count);
+					if (parameters->point_light_positions)
+						parameters->point_light_positions->upload(0, point_light_positions.data(), count);
+					if (parameters->point_light_attenuations)
+						parameters->point_light_attenuations->upload(0, point_light_attenuations.data(), count);
+					
+					count = clamp_light_count(parameters->directional_light_colors, directional_light_colors.size());
+					if (parameters->directional_light_count)
+						parameters->directional_light_count->upload(count);
+					if (parameters->directional_light_colors)
+						parameters->directional_light_colors->upload(0, directional_light_colors.data(), count);
+					if (parameters->directional_light_directions)
+						parameters->directional_light_directions->upload(0, directional_light_directions.data(), count);
+					if (parameters->directional_light_texture_matrices)
+						parameters->directional_light_texture_matrices->upload(0, directional_light_texture_matrices.data(), count);
+					if (parameters->directional_light_texture_opacities)
+						parameters->directional_light_texture_opacities->upload(0, directional_light_texture_opacities.data(), count);
+					
+					count = clamp_light_count(parameters->spot_light_colors, spot_light_colors.size());
+					if (parameters->spot_light_count)
+						parameters->spot_light_count->upload(count);
+					if (parameters->spot_light_colors)
+						parameters->spot_light_colors->upload(0, spot_light_colors.data(), count);
+					if (parameters->spot_light_positions)
+						parameters->spot_light_positions->upload(0, spot_light_positions.data(), count);
+					if (parameters->spot_light_directions)
+						parameters->spot_light_directions->upload(0, spot_light_directions.data(), count);
+					if (parameters->spot_light_attenuations)
+						parameters->spot_light_attenuations->upload(0, spot_light_attenuations.data(), count);
+					if (parameters->spot_light_cutoffs)
+						parameters->spot_light_cutoffs->upload(0, spot_light_cutoffs.data(), count);
+				}
 				
+				// Upload samplers, which cannot be stored in uniform blocks
+				if (parameters->directional_light_textures)
+				{
+					int count = clamp_light_count(parameters->directional_light_textures, directional_light_textures.size());
+					parameters->directional_light_textures->upload(0, directional_light_textures.data(), count);
+				}
 				if (parameters->shadow_map_directional && shadow_map)
 					parameters->shadow_map_directional->upload(shadow_map);
-				if (parameters->shadow_matrices_directional)
-					parameters->shadow_matrices_directional->upload(0, shadow_matrices_directional, 4);
-				if (parameters->shadow_splits_directional)
-					parameters->shadow_splits_directional->upload(shadow_splits_directional);
+				if (shadow_atlas_pass)
+				{
+					if (parameters->shadow_atlas)
+						parameters->shadow_atlas->upload(shadow_atlas);
+					if (parameters->light_shadow_texture)
+						parameters->light_shadow_texture->upload(light_shadow_texture);
+				}
+				
+				// Upload clustered lights
+				if (clustered_lighting)
+				{
+					if (parameters->light_cluster_texture)
+						parameters->light_cluster_texture->upload(light_cluster_texture);
+					if (parameters->light_index_texture)
+						parameters->light_index_texture->upload(light_index_texture);
+					if (parameters->light_texture)
+						parameters->light_texture->upload(light_texture);
+					if (parameters->light_cluster_resolution)
+						parameters->light_cluster_resolution->upload(clusters->get_resolution());
+					if (parameters->light_cluster_slicing)
+						parameters->light_cluster_slicing->upload(clusters->get_slice_parameters());
+				}
 			}
 			
 			// Upload material properties to shader
 			active_material->upload(context->alpha);
 		}
+		
+		// Change rasterizer state according to material flags, shading pre-passed operations against the pre-pass depth
+		std::uint32_t material_flags = active_material->get_flags();
+		if (depth_prepass && is_depth_prepassed(operation, active_material))
+			material_flags |= depth_prepassed_state_flag;
+		if (oit_bound)
+			material_flags |= weighted_blended_state_flag;
+		if (active_material_flags != material_flags)
+		{
+			rasterizer->set_render_state(generate_render_state(material_flags));
+			active_material_flags = material_flags;
+		}
 
+		// Merge subsequent operations with identical geometry and material into a single instanced draw
+		std::size_t batch_size = 1;
+		if (parameters->instance_block && is_batchable(operation))
+		{
+			while (i + batch_size < operation_count && batch_size < instance_block_capacity)
+			{
+				const render_operation& next = operations[i + batch_size];
+				const ::material* next_material = (next.material) ? next.material : fallback_material;
+				if (next_material != material ||
+					next.vertex_array != operation.vertex_array ||
+					next.drawing_mode != operation.drawing_mode ||
+					next.start_index != operation.start_index ||
+					next.index_count != operation.index_count ||
+					next.indexed != operation.indexed ||
+					!is_batchable(next))
+				{
+					break;
+				}
+				
+				++batch_size;
+			}
+		}
+		
+		// Upload per-instance transforms
+		if (parameters->instance_block)
+		{
+			for (std::size_t j = 0; j < batch_size; ++j)
+				instance_data[j] = operations[i + j].transform;
+			instance_buffer->update(0, batch_size * sizeof(float4x4), instance_data);
+		}
+		
+		++batching_stats.draw_count;
+		batching_stats.operation_count += batch_size;
+		
+		if (batch_size > 1)
+		{
+			++batching_stats.batch_count;
+			batching_stats.batched_operation_count += batch_size;
+			
+			// Draw batch
+			draw(operation, batch_size);
+			
+			// Skip batched operations
+			i += batch_size - 1;
+			continue;
+		}
+		
+		// Merge subsequent operations which draw other ranges of the same geometry with the same transform into a single multi-draw
+		std::size_t merge_count = 1;
+		while (i + merge_count < operation_count && !operations[i + merge_count].occluded && render_pass::is_mergeable(operation, operations[i + merge_count]))
+			++merge_count;
+		
 		// Calculate operation-dependent parameters
 		model = operation.transform;
 		model_view_projection = view_projection * model;
 		model_view = view * model;
-		normal_model = math::transpose(math::inverse(math::resize<3, 3>(model)));
-		normal_model_view = math::transpose(math::inverse(math::resize<3, 3>(model_view)));
+		normal_model = operation.normal_transform;
+		normal_model_view = normal_view * normal_model;
 
 		// Upload operation-dependent parameters
 		if (parameters->model)
@@ -525,17 +774,290 @@ void material_pass::render(render_context* context) const
 			parameters->normal_model->upload(normal_model);
 		if (parameters->normal_model_view)
 			parameters->normal_model_view->upload(normal_model_view);
-		if (parameters->clip_depth)
-			parameters->clip_depth->upload(clip_depth);
-		if (parameters->log_depth_coef)
-			parameters->log_depth_coef->upload(log_depth_coef);
+		
+		// Bind the bone palette of posed operations, which are never batched
+		if (parameters->bone_palette_block && operation.pose)
+			bind_bone_palette(*context, operation);
 
 		// Draw geometry
-		if (operation.instance_count)
-			rasterizer->draw_arrays_instanced(*operation.vertex_array, operation.drawing_mode, operation.start_index, operation.index_count, operation.instance_count);
+		if (merge_count > 1)
+		{
+			++batching_stats.multi_draw_count;
+			batching_stats.operation_count += merge_count - 1;
+			batching_stats.merged_operation_count += merge_count;
+			
+			multi_draw(&operation, merge_count);
+			
+			// Skip merged operations
+			i += merge_count - 1;
+		}
 		else
-			rasterizer->draw_arrays(*operation.vertex_array, operation.drawing_mode, operation.start_index, operation.index_count);
+		{
+			draw(operation, operation.instance_count);
+		}
+	}
+	
+	// Composite weighted blended operations which were not followed by other translucent operations
+	if (oit_accumulated)
+		composite_weighted_blended();
+}
+
+void material_pass::set_depth_prepass(bool enabled)
+{
+	depth_prepass = enabled && depth_unskinned_model_view_projection_input && depth_skinned_model_view_projection_input;
+}
+
+void material_pass::set_shadow_map(const gl::texture_2d* texture)
+{
+	shadow_map = texture;
+	set_input(0, texture);
+}
+
+void material_pass::set_shadow_atlas(const ::shadow_atlas_pass* pass, const gl::texture_2d* texture)
+{
+	shadow_atlas_pass = (texture) ? pass : nullptr;
+	shadow_atlas = (pass) ? texture : nullptr;
+	set_input(1, shadow_atlas);
+	
+	if (shadow_atlas_pass && !light_shadow_texture)
+	{
+		light_shadow_texture = new gl::texture_2d(1024, 1, gl::pixel_type::float_32, gl::pixel_format::rgba);
+		light_shadow_texture->set_wrapping(gl::texture_wrapping::extend, gl::texture_wrapping::extend);
+		light_shadow_texture->set_filters(gl::texture_min_filter::nearest, gl::texture_mag_filter::nearest);
+	}
+	else if (!shadow_atlas_pass && light_shadow_texture)
+	{
+		delete light_shadow_texture;
+		light_shadow_texture = nullptr;
+	}
+}
+
+void material_pass::set_texture_streamer(::texture_streamer* streamer)
+{
+	texture_streamer = streamer;
+}
+
+void material_pass::render_depth_prepass(const render_context& context, const float4x4& view_projection) const
+{
+	std::uint32_t active_cull_flags = ~std::uint32_t(0);
+	const gl::shader_program* active_program = nullptr;
+	
+	const render_operation* operations = context.operations->begin();
+	const std::size_t operation_count = context.operations->size();
+	for (std::size_t i = 0; i < operation_count; ++i)
+	{
+		const render_operation& operation = operations[i];
+		const ::material* material = (operation.material) ? operation.material : fallback_material;
+		if (!is_depth_prepassed(operation, material))
+			continue;
+		
+		// Cull the faces culled by the material, writing only depth
+		const std::uint32_t cull_flags = material->get_flags() & (MATERIAL_FLAG_BACK_FACES | MATERIAL_FLAG_FRONT_AND_BACK_FACES);
+		if (active_cull_flags != cull_flags)
+		{
+			gl::render_state state = generate_render_state(cull_flags);
+			state.color_write_enabled = false;
+			rasterizer->set_render_state(state);
+			active_cull_flags = cull_flags;
+		}
+		
+		const gl::shader_program* program = (operation.pose) ? depth_skinned_program : depth_unskinned_program;
+		const gl::shader_input* model_view_projection_input = (operation.pose) ? depth_skinned_model_view_projection_input : depth_unskinned_model_view_projection_input;
+		if (active_program != program)
+		{
+			rasterizer->use_program(*program);
+			active_program = program;
+		}
+		
+		model_view_projection_input->upload(view_projection * operation.transform);
+		if (operation.pose)
+			bind_bone_palette(context, operation);
+		
+		draw(operation);
+	}
+}
+
+void material_pass::set_weighted_blended_oit(bool enabled)
+{
+	if (enabled == static_cast<bool>(oit_framebuffer) || (enabled && !oit_composite_program))
+		return;
+	
+	if (enabled)
+	{
+		const std::array<int, 2>& dimensions = framebuffer->get_dimensions();
+		
+		oit_accumulation_texture = new gl::texture_2d(dimensions[0], dimensions[1], gl::pixel_type::float_16, gl::pixel_format::rgba);
+		oit_weight_texture = new gl::texture_2d(dimensions[0], dimensions[1], gl::pixel_type::float_16, gl::pixel_format::r);
+		for (gl::texture_2d* texture: {oit_accumulation_texture, oit_weight_texture})
+		{
+			texture->set_wrapping(gl::texture_wrapping::extend, gl::texture_wrapping::extend);
+			texture->set_filters(gl::texture_min_filter::nearest, gl::texture_mag_filter::nearest);
+		}
+		
+		// Share the depth of the framebuffer, which is only tested, as depth writes are disabled while accumulating
+		oit_framebuffer = new gl::framebuffer(dimensions[0], dimensions[1]);
+		oit_framebuffer->attach(gl::framebuffer_attachment_type::color, oit_accumulation_texture, 0);
+		oit_framebuffer->attach(gl::framebuffer_attachment_type::color, oit_weight_texture, 1);
+		oit_framebuffer->attach(gl::framebuffer_attachment_type::depth, const_cast<gl::texture_2d*>(framebuffer->get_depth_attachment()));
+	}
+	else
+	{
+		delete oit_framebuffer;
+		delete oit_accumulation_texture;
+		delete oit_weight_texture;
+		oit_framebuffer = nullptr;
+		oit_accumulation_texture = nullptr;
+		oit_weight_texture = nullptr;
+	}
+}
+
+void material_pass::composite_weighted_blended() const
+{
+	rasterizer->use_framebuffer(*framebuffer);
+	
+	// Blend the average color over the framebuffer by one minus revealage, which the composite program writes to alpha
+	gl::render_state state;
+	state.blend_enabled = true;
+	state.blend_source = gl::blend_factor::one_minus_src_alpha;
+	state.blend_destination = gl::blend_factor::src_alpha;
+	state.depth_write_enabled = false;
+	state.cull_enabled = true;
+	rasterizer->set_render_state(state);
+	
+	rasterizer->use_program(*oit_composite_program);
+	if (oit_accumulation_texture_input)
+		oit_accumulation_texture_input->upload(oit_accumulation_texture);
+	if (oit_weight_texture_input)
+		oit_weight_texture_input->upload(oit_weight_texture);
+	
+	rasterizer->draw_arrays(*quad_vao, gl::drawing_mode::triangles, 0, 6);
+}
+
+void material_pass::set_clustered_lighting(bool enabled)
+{
+	if (enabled == clustered_lighting)
+		return;
+	
+	clustered_lighting = enabled;
+	
+	if (enabled)
+	{
+		clusters = new light_clusters();
+		const int3& resolution = clusters->get_resolution();
+		
+		light_cluster_texture = new gl::texture_2d(resolution.x * resolution.y, resolution.z, gl::pixel_type::float_32, gl::pixel_format::rg);
+		light_index_texture = new gl::texture_2d(1024, 1, gl::pixel_type::float_32, gl::pixel_format::r);
+		light_texture = new gl::texture_2d(1024, 1, gl::pixel_type::float_32, gl::pixel_format::rgba);
+		
+		for (gl::texture_2d* texture: {light_cluster_texture, light_index_texture, light_texture})
+		{
+			texture->set_wrapping(gl::texture_wrapping::extend, gl::texture_wrapping::extend);
+			texture->set_filters(gl::texture_min_filter::nearest, gl::texture_mag_filter::nearest);
+		}
+	}
+	else
+	{
+		delete clusters;
+		delete light_cluster_texture;
+		delete light_index_texture;
+		delete light_texture;
+		clusters = nullptr;
+		light_cluster_texture = nullptr;
+		light_index_texture = nullptr;
+		light_texture = nullptr;
+	}
+}
+
+void material_pass::build_light_clusters(const render_context* context, const float4x4& view) const
+{
+	const scene::camera& camera = *context->camera;
+	
+	// Add point and spot lights to cluster grid, packing their data into light texels
+	clusters->clear();
+	light_texels.clear();
+	for (std::size_t i = 0; i < point_light_colors.size(); ++i)
+	{
+		clusters->add_light(point_light_positions[i], point_light_attenuations[i]);
+		
+		const float3& position = point_light_positions[i];
+		const float3& color = point_light_colors[i];
+		const float3& attenuation = point_light_attenuations[i];
+		light_texels.push_back({position.x, position.y, position.z, clusters->get_light_radius(clusters->get_light_count() - 1)});
+		light_texels.push_back({color.x, color.y, color.z, 0.0f});
+		light_texels.push_back({0.0f, 0.0f, 0.0f, -1.0f});
+		light_texels.push_back({attenuation.x, attenuation.y, attenuation.z, -1.0f});
+	}
+	for (std::size_t i = 0; i < spot_light_colors.size(); ++i)
+	{
+		clusters->add_light(spot_light_positions[i], spot_light_attenuations[i]);
+		
+		const float3& position = spot_light_positions[i];
+		const float3& color = spot_light_colors[i];
+		const float3& direction = spot_light_directions[i];
+		const float3& attenuation = spot_light_attenuations[i];
+		const float2& cutoffs = spot_light_cutoffs[i];
+		light_texels.push_back({position.x, position.y, position.z, clusters->get_light_radius(clusters->get_light_count() - 1)});
+		light_texels.push_back({color.x, color.y, color.z, 1.0f});
+		light_texels.push_back({direction.x, direction.y, direction.z, cutoffs.y});
+		light_texels.push_back({attenuation.x, attenuation.y, attenuation.z, cutoffs.x});
 	}
+	
+	clusters->build
+	(
+		view,
+		camera.get_fov_tween().interpolate(context->alpha),
+		camera.get_aspect_ratio_tween().interpolate(context->alpha),
+		camera.get_clip_near_tween().interpolate(context->alpha),
+		camera.get_clip_far_tween().interpolate(context->alpha)
+	);
+	
+	// Upload cluster texture
+	const int3& resolution = clusters->get_resolution();
+	light_cluster_texture->update(0, 0, resolution.x * resolution.y, resolution.z, clusters->get_clusters().data());
+	
+	// Pad light indices and light texels to whole rows
+	const std::vector<float>& light_indices = clusters->get_light_indices();
+	const int index_rows = std::max<int>(1, static_cast<int>((light_indices.size() + 1023) / 1024));
+	light_index_texels.assign(light_indices.begin(), light_indices.end());
+	light_index_texels.resize(static_cast<std::size_t>(index_rows) * 1024, 0.0f);
+	
+	const int light_rows = std::max<int>(1, static_cast<int>((light_texels.size() + 1023) / 1024));
+	light_texels.resize(static_cast<std::size_t>(light_rows) * 1024, float4{0.0f, 0.0f, 0.0f, 0.0f});
+	
+	// Grow textures as necessary, then upload
+	if (std::get<1>(light_index_texture->get_dimensions()) < index_rows)
+		light_index_texture->resize(1024, index_rows, gl::pixel_type::float_32, gl::pixel_format::r, gl::color_space::linear, nullptr);
+	light_index_texture->update(0, 0, 1024, index_rows, light_index_texels.data());
+	
+	if (std::get<1>(light_texture->get_dimensions()) < light_rows)
+		light_texture->resize(1024, light_rows, gl::pixel_type::float_32, gl::pixel_format::rgba, gl::color_space::linear, nullptr);
+	light_texture->update(0, 0, 1024, light_rows, light_texels.data());
+}
+
+void material_pass::build_light_shadows() const
+{
+	// One header texel per point and spot light, followed by the shadow matrices of shadowed lights
+	const std::size_t light_count = point_lights.size() + spot_lights.size();
+	light_shadow_texels.assign(light_count, float4{0.0f, 0.0f, 0.0f, 0.0f});
+	for (std::size_t i = 0; i < light_count; ++i)
+	{
+		const scene::light* light = (i < point_lights.size()) ? point_lights[i] : spot_lights[i - point_lights.size()];
+		const ::shadow_atlas_pass::shadow* shadow = shadow_atlas_pass->get_shadow(light);
+		if (!shadow)
+			continue;
+		
+		light_shadow_texels[i] = {static_cast<float>(light_shadow_texels.size()), static_cast<float>(shadow->face_count), shadow->tile_resolution, 0.0f};
+		for (unsigned int j = 0; j < shadow->face_count; ++j)
+			for (int k = 0; k < 4; ++k)
+				light_shadow_texels.push_back(shadow->matrices[j][k]);
+	}
+	
+	// Pad shadow texels to whole rows, then grow the texture as necessary and upload
+	const int rows = std::max<int>(1, static_cast<int>((light_shadow_texels.size() + 1023) / 1024));
+	light_shadow_texels.resize(static_cast<std::size_t>(rows) * 1024, float4{0.0f, 0.0f, 0.0f, 0.0f});
+	if (std::get<1>(light_shadow_texture->get_dimensions()) < rows)
+		light_shadow_texture->resize(1024, rows, gl::pixel_type::float_32, gl::pixel_format::rgba, gl::color_space::linear, nullptr);
+	light_shadow_texture->update(0, 0, 1024, rows, light_shadow_texels.data());
 }
 
 void material_pass::set_fallback_material(const material* fallback)
@@ -559,43 +1081,57 @@ const material_pass::parameter_set* material_pass::load_parameter_set(const gl::
 	parameter_set* parameters = new parameter_set();
 
 	// Connect inputs
-	parameters->time = program->get_input("time");
-	parameters->mouse = program->get_input("mouse");
-	parameters->resolution = program->get_input("resolution");
-	parameters->camera_position = program->get_input("camera.position");
-	parameters->camera_exposure = program->get_input("camera.exposure");
-	parameters->model = program->get_input("model");
-	parameters->view = program->get_input("view");
-	parameters->projection = program->get_input("projection");
-	parameters->model_view = program->get_input("model_view");
-	parameters->view_projection = program->get_input("view_projection");
-	parameters->model_view_projection = program->get_input("model_view_projection");
-	parameters->normal_model = program->get_input("normal_model");
-	parameters->normal_model_view = program->get_input("normal_model_view");
-	parameters->clip_depth = program->get_input("clip_depth");
-	parameters->log_depth_coef = program->get_input("log_depth_coef");
-	parameters->ambient_light_count = program->get_input("ambient_light_count");
-	parameters->ambient_light_colors = program->get_input("ambient_light_colors");
-	parameters->point_light_count = program->get_input("point_light_count");
-	parameters->point_light_colors = program->get_input("point_light_colors");
-	parameters->point_light_positions = program->get_input("point_light_positions");
-	parameters->point_light_attenuations = program->get_input("point_light_attenuations");
-	parameters->directional_light_count = program->get_input("directional_light_count");
-	parameters->directional_light_colors = program->get_input("directional_light_colors");
-	parameters->directional_light_directions = program->get_input("directional_light_directions");
-	parameters->directional_light_textures = program->get_input("directional_light_textures");
-	parameters->directional_light_texture_matrices = program->get_input("directional_light_texture_matrices");
-	parameters->directional_light_texture_opacities = program->get_input("directional_light_texture_opacities");
-	parameters->spot_light_count = program->get_input("spot_light_count");
-	parameters->spot_light_colors = program->get_input("spot_light_colors");
-	parameters->spot_light_positions = program->get_input("spot_light_positions");
-	parameters->spot_light_directions = program->get_input("spot_light_directions");
-	parameters->spot_light_attenuations = program->get_input("spot_light_attenuations");
-	parameters->spot_light_cutoffs = program->get_input("spot_light_cutoffs");
-	parameters->focal_point = program->get_input("focal_point");
-	parameters->shadow_map_directional = program->get_input("shadow_map_directional");
-	parameters->shadow_splits_directional = program->get_input("shadow_splits_directional");
-	parameters->shadow_matrices_directional = program->get_input("shadow_matrices_directional");
+	parameters->time = program->get_input("time"_sid);
+	parameters->mouse = program->get_input("mouse"_sid);
+	parameters->resolution = program->get_input("resolution"_sid);
+	parameters->camera_position = program->get_input("camera.position"_sid);
+	parameters->camera_exposure = program->get_input("camera.exposure"_sid);
+	parameters->model = program->get_input("model"_sid);
+	parameters->view = program->get_input("view"_sid);
+	parameters->projection = program->get_input("projection"_sid);
+	parameters->model_view = program->get_input("model_view"_sid);
+	parameters->view_projection = program->get_input("view_projection"_sid);
+	parameters->model_view_projection = program->get_input("model_view_projection"_sid);
+	parameters->normal_model = program->get_input("normal_model"_sid);
+	parameters->normal_model_view = program->get_input("normal_model_view"_sid);
+	parameters->clip_depth = program->get_input("clip_depth"_sid);
+	parameters->log_depth_coef = program->get_input("log_depth_coef"_sid);
+	parameters->ambient_light_count = program->get_input("ambient_light_count"_sid);
+	parameters->ambient_light_colors = program->get_input("ambient_light_colors"_sid);
+	parameters->point_light_count = program->get_input("point_light_count"_sid);
+	parameters->point_light_colors = program->get_input("point_light_colors"_sid);
+	parameters->point_light_positions = program->get_input("point_light_positions"_sid);
+	parameters->point_light_attenuations = program->get_input("point_light_attenuations"_sid);
+	parameters->directional_light_count = program->get_input("directional_light_count"_sid);
+	parameters->directional_light_colors = program->get_input("directional_light_colors"_sid);
+	parameters->directional_light_directions = program->get_input("directional_light_directions"_sid);
+	parameters->directional_light_textures = program->get_input("directional_light_textures"_sid);
+	parameters->directional_light_texture_matrices = program->get_input("directional_light_texture_matrices"_sid);
+	parameters->directional_light_texture_opacities = program->get_input("directional_light_texture_opacities"_sid);
+	parameters->spot_light_count = program->get_input("spot_light_count"_sid);
+	parameters->spot_light_colors = program->get_input("spot_light_colors"_sid);
+	parameters->spot_light_positions = program->get_input("spot_light_positions"_sid);
+	parameters->spot_light_directions = program->get_input("spot_light_directions"_sid);
+	parameters->spot_light_attenuations = program->get_input("spot_light_attenuations"_sid);
+	parameters->spot_light_cutoffs = program->get_input("spot_light_cutoffs"_sid);
+	parameters->focal_point = program->get_input("focal_point"_sid);
+	parameters->shadow_map_directional = program->get_input("shadow_map_directional"_sid);
+	parameters->shadow_splits_directional = program->get_input("shadow_splits_directional"_sid);
+	parameters->shadow_matrices_directional = program->get_input("shadow_matrices_directional"_sid);
+	parameters->shadow_atlas = program->get_input("shadow_atlas"_sid);
+	parameters->light_shadow_texture = program->get_input("light_shadow_texture"_sid);
+	
+	parameters->light_cluster_texture = program->get_input("light_cluster_texture"_sid);
+	parameters->light_index_texture = program->get_input("light_index_texture"_sid);
+	parameters->light_texture = program->get_input("light_texture"_sid);
+	parameters->light_cluster_resolution = program->get_input("light_cluster_resolution"_sid);
+	parameters->light_cluster_slicing = program->get_input("light_cluster_slicing"_sid);
+	
+	// Connect uniform blocks
+	parameters->frame_block = program->bind_uniform_block("frame_block"_sid, frame_block_binding);
+	parameters->light_block = program->bind_uniform_block("light_block"_sid, light_block_binding);
+	parameters->instance_block = program->bind_uniform_block("instance_block"_sid, instance_block_binding);
+	parameters->bone_palette_block = program->bind_uniform_block("bone_palette_block"_sid, skinning_stage::bone_palette_binding);
 
 	// Add parameter set to map of parameter sets
 	parameter_sets[program] = parameters;
@@ -608,115 +1144,103 @@ void material_pass::handle_event(const mouse_moved_event& event)
 	mouse_position = {static_cast<float>(event.x), static_cast<float>(event.y)};
 }
 
-bool operation_compare(const render_operation& a, const render_operation& b)
+int clamp_light_count(const gl::shader_input* input, std::size_t count)
 {
-	if (!a.material)
+	if (input)
+		count = std::min<std::size_t>(count, input->get_element_count());
+	
+	return static_cast<int>(count);
+}
+
+bool is_batchable(const render_operation& operation)
+{
+	return !operation.pose && !operation.instance_count && !operation.occluded;
+}
+
+bool is_depth_prepassed(const render_operation& operation, const material* material)
+{
+	static constexpr std::uint32_t excluded_flags = MATERIAL_FLAG_TRANSLUCENT | MATERIAL_FLAG_X_RAY | MATERIAL_FLAG_DECAL | MATERIAL_FLAG_VEGETATION | MATERIAL_FLAG_WIREFRAME | MATERIAL_FLAG_NO_DEPTH_PREPASS;
+	
+	return material && material->get_shader_program() && !(material->get_flags() & excluded_flags) && !operation.instance_count && !operation.occluded;
+}
+
+bool is_weighted_blended(const material* material)
+{
+	if (!material)
 		return false;
-	else if (!b.material)
-		return true;
 	
-	bool xray_a = a.material->get_flags() & MATERIAL_FLAG_X_RAY;
-	bool xray_b = b.material->get_flags() & MATERIAL_FLAG_X_RAY;
+	const std::uint32_t flags = material->get_flags();
+	return (flags & MATERIAL_FLAG_TRANSLUCENT) && (flags & MATERIAL_FLAG_WEIGHTED_BLENDED) && !(flags & (MATERIAL_FLAG_X_RAY | MATERIAL_FLAG_DECAL));
+}
+
+gl::render_state generate_render_state(std::uint32_t flags)
+{
+	// Opaque, back-face culled, reverse-z depth tested
+	gl::render_state state;
+	state.depth_test_enabled = true;
+	state.depth_function = gl::comparison_function::greater;
+	state.cull_enabled = true;
+	state.stencil_write_mask = 0;
 	
-	if (xray_a)
+	// For half-z buffer
+	state.depth_range_near = -1.0f;
+	state.depth_range_far = 1.0f;
+	
+	if (flags & MATERIAL_FLAG_TRANSLUCENT)
 	{
-		if (xray_b)
-		{
-			// A and B are both xray, render back to front
-			return (a.depth >= b.depth);
-		}
-		else
-		{
-			// A is xray, B is not. Render B first
-			return false;
-		}
+		state.blend_enabled = true;
+		state.blend_source = gl::blend_factor::src_alpha;
+		state.blend_destination = gl::blend_factor::one_minus_src_alpha;
 	}
-	else
+	
+	if (flags & weighted_blended_state_flag)
 	{
-		if (xray_b)
-		{
-			// A is opaque, B is xray. Render A first
-			return true;
-		}
-		else
-		{
-			// Determine transparency
-			bool transparent_a = a.material->get_flags() & MATERIAL_FLAG_TRANSLUCENT;
-			bool transparent_b = b.material->get_flags() & MATERIAL_FLAG_TRANSLUCENT;
-			
-			if (transparent_a)
-			{
-				if (transparent_b)
-				{
-					// Determine decal status
-					bool decal_a = a.material->get_flags() & MATERIAL_FLAG_DECAL;
-					bool decal_b = b.material->get_flags() & MATERIAL_FLAG_DECAL;
-					
-					if (decal_a)
-					{
-						if (decal_b)
-						{
-							// A and B are both transparent decals, render back to front
-							return (a.depth >= b.depth);
-						}
-						else
-						{
-							// A is a transparent decal, B is transparent but not a decal, render A first
-							return true;
-						}
-					}
-					else
-					{
-						if (decal_b)
-						{
-							// A is transparent but not a decal, B is a transparent decal, render B first
-							return false;
-						}
-						else
-						{
-							// A and B are both transparent, but not decals, render back to front
-							return (a.depth >= b.depth);
-						}
-					}
-				}
-				else
-				{
-					// A is transparent, B is opaque. Render B first
-					return false;
-				}
-			}
-			else
-			{
-				if (transparent_b)
-				{
-					// A is opaque, B is transparent. Render A first
-					return true;
-				}
-				else
-				{
-					// A and B are both opaque
-					if (a.material->get_shader_program() == b.material->get_shader_program())
-					{
-						// A and B have the same shader
-						if (a.vertex_array == b.vertex_array)
-						{
-							// A and B have the same VAO, render front to back
-							return (a.depth < b.depth);
-						}
-						else
-						{
-							// Sort by VAO
-							return (a.vertex_array < b.vertex_array);
-						}
-					}
-					else
-					{
-						// A and B are both opaque and have different shaders, sort by shader
-						return (a.material->get_shader_program() < b.material->get_shader_program());
-					}
-				}
-			}
-		}
+		// Sum colors and weights, and multiply the revealage in the alpha channel of the accumulation target by one minus each alpha
+		state.blend_source = gl::blend_factor::one;
+		state.blend_destination = gl::blend_factor::one;
+		state.blend_separate_alpha = true;
+		state.blend_source_alpha = gl::blend_factor::zero;
+		state.blend_destination_alpha = gl::blend_factor::one_minus_src_alpha;
+		state.depth_write_enabled = false;
+	}
+	
+	if (flags & MATERIAL_FLAG_BACK_FACES)
+		state.culled_face = gl::cull_face::front;
+	else if (flags & MATERIAL_FLAG_FRONT_AND_BACK_FACES)
+		state.cull_enabled = false;
+	
+	if (flags & MATERIAL_FLAG_X_RAY)
+		state.depth_test_enabled = false;
+	
+	if (flags & depth_prepassed_state_flag)
+	{
+		// Shade only the nearest fragments, whose depth has already been written by the pre-pass
+		state.depth_function = gl::comparison_function::greater_equal;
+		state.depth_write_enabled = false;
+	}
+	
+	if (flags & MATERIAL_FLAG_DECAL_SURFACE)
+	{
+		// Mark decal surfaces in the stencil buffer
+		state.stencil_test_enabled = true;
+		state.stencil_function = gl::comparison_function::always;
+		state.stencil_reference = 1;
+		state.stencil_pass = gl::stencil_operation::replace;
+		state.stencil_write_mask = ~0u;
 	}
+	
+	if (flags & MATERIAL_FLAG_DECAL)
+	{
+		// Draw decals only over marked decal surfaces
+		state.depth_test_enabled = true;
+		state.depth_function = gl::comparison_function::greater_equal;
+		state.depth_write_enabled = false;
+		state.stencil_test_enabled = true;
+		state.stencil_function = gl::comparison_function::equal;
+		state.stencil_reference = 1;
+		state.stencil_pass = gl::stencil_operation::keep;
+		state.stencil_write_mask = 0;
+	}
+	
+	return state;
 }
-
@@ -27,13 +27,31 @@
 #include "event/event-handler.hpp"
 #include "event/input-events.hpp"
 #include <unordered_map>
+#include <vector>
 #include "gl/shader-program.hpp"
 #include "gl/shader-input.hpp"
 #include "gl/texture-2d.hpp"
+#include "gl/uniform-buffer.hpp"
 
 class camera;
 class resource_manager;
 class shadow_map_pass;
+class shadow_atlas_pass;
+class light_clusters;
+class texture_streamer;
+
+namespace gl
+{
+	class framebuffer;
+	class vertex_array;
+	class vertex_buffer;
+}
+
+namespace scene
+{
+	class object_base;
+	class light;
+}
 
 /**
  * Renders scene objects using their material-specified shaders and properties.
@@ -46,6 +64,28 @@ public:
 	virtual ~material_pass();
 	virtual void render(render_context* context) const final;
 	
+	/// Draw call statistics of the most recent render.
+	struct batch_statistics
+	{
+		/// Number of render operations drawn.
+		std::size_t operation_count;
+		
+		/// Number of draw calls issued.
+		std::size_t draw_count;
+		
+		/// Number of instanced draw calls issued for merged operations.
+		std::size_t batch_count;
+		
+		/// Number of render operations drawn by merged instanced draw calls.
+		std::size_t batched_operation_count;
+		
+		/// Number of multi-draw calls issued for operations which draw different ranges of the same geometry.
+		std::size_t multi_draw_count;
+		
+		/// Number of render operations drawn by multi-draw calls.
+		std::size_t merged_operation_count;
+	};
+	
 	/// Sets the material to be used when a render operation is missing a material. If no fallback material is specified, render operations without materials will not be processed.
 	void set_fallback_material(const material* fallback);
 	
@@ -54,12 +94,172 @@ public:
 	
 	void set_focal_point_tween(const tween<float3>* focal_point);	
 	
+	/// Returns the draw call statistics of the most recent render.
+	const batch_statistics& get_batch_statistics() const;
+	
+	/**
+	 * Enables or disables clustered forward lighting.
+	 *
+	 * When enabled, point and spot lights are assigned to a grid of view-space clusters each render, and uploaded to shader programs through the following inputs:
+	 *
+	 * - `light_cluster_texture` (sampler2D, RG32F): (offset, count) into the light index texture of each cluster, with tile `x + y * tiles_x` along the s-axis and depth slice along the t-axis.
+	 * - `light_index_texture` (sampler2D, R32F): concatenated light indices of all clusters, in rows of 1024.
+	 * - `light_texture` (sampler2D, RGBA32F): four texels per light, in rows of 256 lights: position and radius; color and type (0 for point, 1 for spot); direction and cosine outer cutoff; attenuation and cosine inner cutoff.
+	 * - `light_cluster_resolution` (ivec3): number of tiles along each screen axis, and number of depth slices.
+	 * - `light_cluster_slicing` (vec2): scale and bias which map view-space depth to a depth slice, where `slice = floor(log(depth) * scale + bias)`.
+	 *
+	 * Clustering is only performed for perspective cameras.
+	 *
+	 * @param enabled `true` if clustered lighting should be enabled, `false` otherwise.
+	 */
+	void set_clustered_lighting(bool enabled);
+	
+	/**
+	 * Enables or disables the depth pre-pass.
+	 *
+	 * When enabled, the depth of opaque operations is first rendered with the `depth-unskinned.glsl` and `depth-skinned.glsl` shader programs of the shadow map pass. Those operations are then shaded against the pre-pass depth, with depth writes disabled, so that each pixel is ideally shaded only once. This trades an additional geometry pass for less overdraw, and is worthwhile where rendering is fragment-bound.
+	 *
+	 * Translucent, x-ray, decal, vegetation, and wireframe materials, materials with the `MATERIAL_FLAG_NO_DEPTH_PREPASS` flag, and explicitly instanced operations are not pre-passed, and are shaded with depth writes as usual. Materials whose shaders displace vertices or modify fragment depth must set `MATERIAL_FLAG_NO_DEPTH_PREPASS`, as their depth can't be reproduced by the pre-pass.
+	 *
+	 * @param enabled `true` if the depth pre-pass should be enabled, `false` otherwise.
+	 */
+	void set_depth_prepass(bool enabled);
+	
+	/**
+	 * Enables or disables weighted blended order-independent transparency.
+	 *
+	 * Translucent materials with the `MATERIAL_FLAG_WEIGHTED_BLENDED` flag are sorted by state rather than depth, after translucent decals and before other translucent materials. When enabled, their operations are drawn in any order, and batched like opaque operations, with the `WEIGHTED_BLENDED_OIT` variants of their shader programs, which are built when a shader template contains the `#pragma define WEIGHTED_BLENDED_OIT` directive. Each variant should weight the premultiplied color of its fragments by depth and write the following outputs:
+	 *
+	 * ```glsl
+	 * layout(location = 0) out vec4 accumulation; // rgb: color * alpha * weight, a: alpha
+	 * layout(location = 1) out float weight; // alpha * weight
+	 * ```
+	 *
+	 * Colors and weights are summed, and the product of one minus each alpha is accumulated as revealage, then the `oit-composite.glsl` shader program blends their weighted average color over the framebuffer. As OpenGL 3.3 can't blend each output with different functions, revealage is accumulated in the alpha channel of the accumulation target, with separate alpha blending, rather than in a target of its own.
+	 *
+	 * When disabled, or if a shader program has no such variant, weighted blended operations are drawn back to front with ordinary alpha blending.
+	 *
+	 * @param enabled `true` if weighted blended order-independent transparency should be enabled, `false` otherwise. It can't be enabled if `oit-composite.glsl` failed to load.
+	 */
+	void set_weighted_blended_oit(bool enabled);
+	
+	/**
+	 * Sets the shadow map sampled by directional lights.
+	 *
+	 * @param texture Shadow map depth texture, or `nullptr` to disable shadows.
+	 */
+	void set_shadow_map(const gl::texture_2d* texture);
+	
+	/**
+	 * Sets the shadow atlas sampled by point and spot lights.
+	 *
+	 * Shadows are uploaded to shader programs through the following inputs:
+	 *
+	 * - `shadow_atlas` (sampler2D): depth atlas of the shadow atlas pass.
+	 * - `light_shadow_texture` (sampler2D, RGBA32F): in rows of 1024 texels, one texel per point light followed by one texel per spot light, in the order of the point and spot lights of the `light_block` uniform block and of the clustered light texture. Each holds the index of the first texel of the light's shadow matrices, the number of shadow matrices, or `0` if the light isn't shadowed, and the resolution of the light's tiles. Shadow matrices follow as four column texels each, and map camera-relative positions to atlas texture coordinates and depth. Spot lights have one shadow matrix, and point lights have one per cube face, in the order +x, -x, +y, -y, +z, -z, selected by the major axis of the direction from the light.
+	 *
+	 * @param pass Shadow atlas pass, which must render before the material pass, or `nullptr` to disable point and spot light shadows.
+	 * @param texture Depth texture of the shadow atlas.
+	 */
+	void set_shadow_atlas(const ::shadow_atlas_pass* pass, const gl::texture_2d* texture);
+	
+	/**
+	 * Sets the texture streamer to which the screen-space footprints of drawn materials are reported.
+	 *
+	 * @param streamer Texture streamer, or `nullptr` to report nothing.
+	 */
+	void set_texture_streamer(::texture_streamer* streamer);
+	
 	const ::shadow_map_pass* shadow_map_pass;
 	const gl::texture_2d* shadow_map;
 	
+	/// Uniform buffer binding point of the `frame_block` uniform block.
+	static constexpr unsigned int frame_block_binding = 0;
+	
+	/// Uniform buffer binding point of the `light_block` uniform block.
+	static constexpr unsigned int light_block_binding = 1;
+	
+	/// Number of `vec4` elements in the `light_block` uniform block, including its two-element header. 1024 elements fill the 16 KiB minimum guaranteed by `GL_MAX_UNIFORM_BLOCK_SIZE`.
+	static constexpr std::size_t light_block_capacity = 1024;
+	
+	/// Uniform buffer binding point of the `instance_block` uniform block.
+	static constexpr unsigned int instance_block_binding = 2;
+	
+	/**
+	 * Maximum number of instances in a merged draw call.
+	 *
+	 * Consecutive render operations which share a material, VAO, and index range are drawn with a single instanced draw call if their shader program declares the following uniform block, from which it should read its model matrix with `gl_InstanceID`:
+	 *
+	 * ```glsl
+	 * layout(std140) uniform instance_block
+	 * {
+	 * 	mat4 instance_models[256];
+	 * };
+	 * ```
+	 */
+	static constexpr std::size_t instance_block_capacity = 256;
+	
 private:
 	virtual void handle_event(const mouse_moved_event& event);
 	
+	/**
+	 * Per-frame data shared by all shader programs which declare a `frame_block` uniform block with the std140 layout:
+	 *
+	 * ```glsl
+	 * layout(std140) uniform frame_block
+	 * {
+	 * 	mat4 view;
+	 * 	mat4 projection;
+	 * 	mat4 view_projection;
+	 * 	mat4 shadow_matrices_directional[4];
+	 * 	vec4 shadow_splits_directional;
+	 * 	vec4 camera; // xyz: position, w: exposure
+	 * 	vec4 resolution_mouse; // xy: resolution, zw: mouse position
+	 * 	vec4 time_clip_depth; // x: time, y: near clip depth, z: far clip depth, w: log depth coefficient
+	 * 	vec4 focal_point; // xyz: focal point
+	 * };
+	 * ```
+	 */
+	struct frame_block
+	{
+		float4x4 view;
+		float4x4 projection;
+		float4x4 view_projection;
+		float4x4 shadow_matrices_directional[4];
+		float4 shadow_splits_directional;
+		float4 camera;
+		float4 resolution_mouse;
+		float4 time_clip_depth;
+		float4 focal_point;
+	};
+	
+	/**
+	 * Per-frame light data shared by all shader programs which declare a `light_block` uniform block with the std140 layout:
+	 *
+	 * ```glsl
+	 * layout(std140) uniform light_block
+	 * {
+	 * 	ivec4 light_counts; // x: ambient, y: point, z: directional, w: spot
+	 * 	ivec4 light_offsets; // Index of the first light_data element of each light type
+	 * 	vec4 light_data[1022];
+	 * };
+	 * ```
+	 *
+	 * Light records are packed consecutively into `light_data`, with each light type using the following number of elements:
+	 *
+	 * - Ambient (1): color
+	 * - Point (3): color, position, attenuation
+	 * - Directional (6): color and light texture opacity, direction, light texture matrix
+	 * - Spot (5): color, position, direction, attenuation, cosine cutoffs
+	 *
+	 * Lights which do not fit in the block are not uploaded.
+	 */
+	struct light_block_header
+	{
+		int4 light_counts;
+		int4 light_offsets;
+	};
+	
 	/**
 	 * Sets of known shader input parameters. Each time a new shader is encountered, a parameter set will be created and its inputs connected to the shader program. A null input indiciates that the shader doesn't have that parameter.
 	 */
@@ -105,41 +305,114 @@ private:
 		const gl::shader_input* shadow_map_directional;
 		const gl::shader_input* shadow_splits_directional;
 		const gl::shader_input* shadow_matrices_directional;
+		
+		const gl::shader_input* shadow_atlas;
+		const gl::shader_input* light_shadow_texture;
+		
+		const gl::shader_input* light_cluster_texture;
+		const gl::shader_input* light_index_texture;
+		const gl::shader_input* light_texture;
+		const gl::shader_input* light_cluster_resolution;
+		const gl::shader_input* light_cluster_slicing;
+		
+		bool frame_block;
+		bool light_block;
+		bool instance_block;
+		bool bone_palette_block;
 	};
 
 	const parameter_set* load_parameter_set(const gl::shader_program* program) const;
+	
+	/**
+	 * Assigns the collected point and spot lights to clusters and uploads the clustered light textures.
+	 *
+	 * @param context Render context.
+	 * @param view View matrix of the camera.
+	 */
+	void build_light_clusters(const render_context* context, const float4x4& view) const;
+	
+	/// Packs the shadows of the collected point and spot lights into the light shadow texture and uploads it.
+	void build_light_shadows() const;
+	
+	/**
+	 * Renders the depth of the pre-passed operations of a render context, which must be sorted.
+	 *
+	 * @param context Render context.
+	 * @param view_projection View-projection matrix of the camera.
+	 */
+	void render_depth_prepass(const render_context& context, const float4x4& view_projection) const;
+	
+	/// Blends the weighted average color of the weighted blended operations accumulated in the OIT framebuffer over the framebuffer.
+	void composite_weighted_blended() const;
 
 	mutable std::unordered_map<const gl::shader_program*, parameter_set*> parameter_sets;
 	const material* fallback_material;
+	::texture_streamer* texture_streamer;
 	const tween<double>* time_tween;
 	float2 mouse_position;
 	const tween<float3>* focal_point_tween;
 	
-	int max_ambient_light_count;
-	int max_point_light_count;
-	int max_directional_light_count;
-	int max_spot_light_count;
+	gl::uniform_buffer* frame_buffer;
+	gl::uniform_buffer* light_buffer;
+	mutable frame_block frame_data;
+	mutable std::vector<float4> light_data;
+	gl::uniform_buffer* instance_buffer;
+	float4x4* instance_data;
+	mutable batch_statistics batching_stats;
 	
-	mutable int ambient_light_count;
-	mutable int point_light_count;
-	mutable int directional_light_count;
-	mutable int spot_light_count;
-
-	float3* ambient_light_colors;
-	float3* point_light_colors;
-	float3* point_light_positions;
-	float3* point_light_attenuations;
-	float3* directional_light_colors;
-	float3* directional_light_directions;
-	const gl::texture_2d** directional_light_textures;
-	float4x4* directional_light_texture_matrices;
-	float* directional_light_texture_opacities;
-	float3* spot_light_colors;
-	float3* spot_light_positions;
-	float3* spot_light_directions;
-	float3* spot_light_attenuations;
-	float2* spot_light_cutoffs;
+	bool depth_prepass;
+	gl::shader_program* depth_unskinned_program;
+	const gl::shader_input* depth_unskinned_model_view_projection_input;
+	gl::shader_program* depth_skinned_program;
+	const gl::shader_input* depth_skinned_model_view_projection_input;
+	
+	gl::shader_program* oit_composite_program;
+	const gl::shader_input* oit_accumulation_texture_input;
+	const gl::shader_input* oit_weight_texture_input;
+	gl::texture_2d* oit_accumulation_texture;
+	gl::texture_2d* oit_weight_texture;
+	gl::framebuffer* oit_framebuffer;
+	gl::vertex_buffer* quad_vbo;
+	gl::vertex_array* quad_vao;
+	
+	bool clustered_lighting;
+	light_clusters* clusters;
+	gl::texture_2d* light_cluster_texture;
+	gl::texture_2d* light_index_texture;
+	gl::texture_2d* light_texture;
+	mutable std::vector<float> light_index_texels;
+	mutable std::vector<float4> light_texels;
+	
+	const ::shadow_atlas_pass* shadow_atlas_pass;
+	const gl::texture_2d* shadow_atlas;
+	gl::texture_2d* light_shadow_texture;
+	mutable std::vector<float4> light_shadow_texels;
+	
+	/// Lights collected for the current camera.
+	mutable std::vector<const scene::object_base*> light_objects;
+	
+	mutable std::vector<float3> ambient_light_colors;
+	mutable std::vector<float3> point_light_colors;
+	mutable std::vector<float3> point_light_positions;
+	mutable std::vector<float3> point_light_attenuations;
+	mutable std::vector<float3> directional_light_colors;
+	mutable std::vector<float3> directional_light_directions;
+	mutable std::vector<const gl::texture_2d*> directional_light_textures;
+	mutable std::vector<float4x4> directional_light_texture_matrices;
+	mutable std::vector<float> directional_light_texture_opacities;
+	mutable std::vector<float3> spot_light_colors;
+	mutable std::vector<float3> spot_light_positions;
+	mutable std::vector<float3> spot_light_directions;
+	mutable std::vector<float3> spot_light_attenuations;
+	mutable std::vector<float2> spot_light_cutoffs;
+	mutable std::vector<const scene::light*> point_lights;
+	mutable std::vector<const scene::light*> spot_lights;
 };
 
+inline const material_pass::batch_statistics& material_pass::get_batch_statistics() const
+{
+	return batching_stats;
+}
+
 #endif // ANTKEEPER_MATERIAL_PASS_HPP
 
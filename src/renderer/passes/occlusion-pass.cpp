@@ -0,0 +1,75 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "renderer/passes/occlusion-pass.hpp"
+#include "renderer/render-context.hpp"
+#include "scene/camera.hpp"
+#include "math/math.hpp"
+
+occlusion_pass::occlusion_pass(gl::rasterizer* rasterizer, const gl::framebuffer* framebuffer):
+	render_pass(rasterizer, framebuffer),
+	readback_index(0),
+	jobs(nullptr)
+{
+	// Depth is read back to the CPU, so the pass is never culled
+	set_input(0, (framebuffer) ? framebuffer->get_depth_attachment() : nullptr);
+	set_side_effects(true);
+}
+
+occlusion_pass::~occlusion_pass()
+{}
+
+void occlusion_pass::render(render_context* context) const
+{
+	// Consume completed readbacks, oldest first, without waiting for those still in flight
+	for (std::size_t i = 0; i < readback_count; ++i)
+	{
+		const std::size_t index = (readback_index + i) % readback_count;
+		if (readbacks[index].is_ready())
+			consume(index);
+	}
+	
+	// Read back the depth of this frame, unless all readbacks are still in flight
+	gl::readback_buffer& readback = readbacks[readback_index];
+	if (readback.is_pending())
+		return;
+	
+	const float4x4 view = context->camera->get_view_tween().interpolate(context->alpha);
+	const float4x4 projection = context->camera->get_projection_tween().interpolate(context->alpha);
+	readback_view_projections[readback_index] = projection * view;
+	
+	readback.read_depth(*framebuffer);
+	readback_index = (readback_index + 1) % readback_count;
+}
+
+void occlusion_pass::set_job_system(job_system* jobs)
+{
+	this->jobs = jobs;
+}
+
+void occlusion_pass::consume(std::size_t index) const
+{
+	gl::readback_buffer& readback = readbacks[index];
+	const std::array<int, 2>& dimensions = readback.get_dimensions();
+	
+	const float* depths = static_cast<const float*>(readback.map());
+	buffer.update(depths, dimensions[0], dimensions[1], readback_view_projections[index], jobs);
+	if (depths)
+		readback.unmap();
+}
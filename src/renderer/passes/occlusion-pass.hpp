@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ANTKEEPER_OCCLUSION_PASS_HPP
+#define ANTKEEPER_OCCLUSION_PASS_HPP
+
+#include "renderer/render-pass.hpp"
+#include "renderer/occlusion-buffer.hpp"
+#include "gl/readback-buffer.hpp"
+#include "utility/fundamental-types.hpp"
+#include <cstddef>
+
+class job_system;
+
+/**
+ * Reads back the depth of a render target into an occlusion buffer, against which the renderer culls the objects of subsequent frames.
+ *
+ * The depth of each frame is read back asynchronously and consumed by a later frame, once the GPU has completed the readback, so the occlusion buffer lags the rendered frame by one or more frames. Objects revealed by camera or object motion during that time may therefore appear a frame late. Should follow the passes which render opaque geometry into the render target.
+ *
+ * @see renderer::set_occlusion_buffer()
+ */
+class occlusion_pass: public render_pass
+{
+public:
+	occlusion_pass(gl::rasterizer* rasterizer, const gl::framebuffer* framebuffer);
+	virtual ~occlusion_pass();
+	virtual void render(render_context* context) const final;
+	
+	/**
+	 * Sets the job system on which the occlusion buffer is built.
+	 *
+	 * @param jobs Job system, or `nullptr` to build the occlusion buffer on the rendering thread.
+	 */
+	void set_job_system(job_system* jobs);
+	
+	/// Returns the occlusion buffer built from the most recently completed readback.
+	const occlusion_buffer& get_occlusion_buffer() const;
+
+private:
+	/// Number of readbacks which may be in flight.
+	static constexpr std::size_t readback_count = 2;
+	
+	/// Builds the occlusion buffer from a completed readback.
+	void consume(std::size_t index) const;
+	
+	mutable gl::readback_buffer readbacks[readback_count];
+	
+	/// View-projection matrices with which the frames of the readbacks were rendered.
+	mutable float4x4 readback_view_projections[readback_count];
+	
+	/// Index of the readback which will be issued next, and which is the oldest if in flight.
+	mutable std::size_t readback_index;
+	
+	mutable occlusion_buffer buffer;
+	job_system* jobs;
+};
+
+inline const occlusion_buffer& occlusion_pass::get_occlusion_buffer() const
+{
+	return buffer;
+}
+
+#endif // ANTKEEPER_OCCLUSION_PASS_HPP
@@ -27,33 +27,87 @@
 #include "gl/vertex-array.hpp"
 #include "gl/vertex-attribute-type.hpp"
 #include "gl/drawing-mode.hpp"
+#include "gl/texture-2d.hpp"
+#include "gl/texture-wrapping.hpp"
+#include "gl/texture-filter.hpp"
 #include "renderer/vertex-attributes.hpp"
 #include "renderer/render-context.hpp"
 #include "renderer/material.hpp"
 #include "renderer/material-flags.hpp"
 #include "scene/camera.hpp"
 #include "math/math.hpp"
+#include <algorithm>
 #include <cmath>
-#include <glad/glad.h>
+
+/// Seed coordinates of texels which are not near any outlined pixel, far enough away that they are never within the outline width.
+static constexpr float no_seed = -65536.0f;
 
 outline_pass::outline_pass(gl::rasterizer* rasterizer, const gl::framebuffer* framebuffer, resource_manager* resource_manager):
 	render_pass(rasterizer, framebuffer),
 	fill_shader(nullptr),
-	stroke_shader(nullptr)
+	stroke_shader(nullptr),
+	jump_flood_textures{nullptr, nullptr},
+	jump_flood_framebuffers{nullptr, nullptr},
+	mode(outline_mode::stroke),
+	outline_width(0.0f),
+	outline_pixel_width(4.0f),
+	jump_flood_scale(0.5f),
+	outline_color{1.0f, 1.0f, 1.0f, 1.0f}
 {
 	// Load fill shader
 	fill_shader = resource_manager->load<gl::shader_program>("outline-fill-unskinned.glsl");
-	fill_model_view_projection_input = fill_shader->get_input("model_view_projection");
+	fill_model_view_projection_input = fill_shader->get_input("model_view_projection"_sid);
 	
 	// Load stroke shader
 	stroke_shader = resource_manager->load<gl::shader_program>("outline-stroke-unskinned.glsl");
-	stroke_model_view_projection_input = stroke_shader->get_input("model_view_projection");
-	stroke_width_input = stroke_shader->get_input("width");
-	stroke_color_input = stroke_shader->get_input("color");
+	stroke_model_view_projection_input = stroke_shader->get_input("model_view_projection"_sid);
+	stroke_width_input = stroke_shader->get_input("width"_sid);
+	stroke_color_input = stroke_shader->get_input("color"_sid);
+	
+	// Load jump flood shaders
+	seed_shader = resource_manager->load<gl::shader_program>("outline-seed-unskinned.glsl");
+	if (seed_shader)
+		seed_model_view_projection_input = seed_shader->get_input("model_view_projection"_sid);
+	jump_flood_shader = resource_manager->load<gl::shader_program>("jump-flood.glsl");
+	if (jump_flood_shader)
+	{
+		jump_flood_seed_texture_input = jump_flood_shader->get_input("seed_texture"_sid);
+		jump_flood_step_input = jump_flood_shader->get_input("step"_sid);
+	}
+	composite_shader = resource_manager->load<gl::shader_program>("outline-composite.glsl");
+	if (composite_shader)
+	{
+		composite_seed_texture_input = composite_shader->get_input("seed_texture"_sid);
+		composite_scale_input = composite_shader->get_input("scale"_sid);
+		composite_width_input = composite_shader->get_input("width"_sid);
+		composite_color_input = composite_shader->get_input("color"_sid);
+	}
+	
+	const float vertex_data[] =
+	{
+		-1.0f,  1.0f, 0.0f,
+		-1.0f, -1.0f, 0.0f,
+		 1.0f,  1.0f, 0.0f,
+		 1.0f,  1.0f, 0.0f,
+		-1.0f, -1.0f, 0.0f,
+		 1.0f, -1.0f, 0.0f
+	};
+
+	std::size_t vertex_size = 3;
+	std::size_t vertex_stride = sizeof(float) * vertex_size;
+	std::size_t vertex_count = 6;
+
+	quad_vbo = new gl::vertex_buffer(sizeof(float) * vertex_size * vertex_count, vertex_data);
+	quad_vao = new gl::vertex_array();
+	quad_vao->bind_attribute(VERTEX_POSITION_LOCATION, *quad_vbo, 3, gl::vertex_attribute_type::float_32, vertex_stride, 0);
 }
 
 outline_pass::~outline_pass()
-{}
+{
+	set_mode(outline_mode::stroke);
+	delete quad_vao;
+	delete quad_vbo;
+}
 
 void outline_pass::render(render_context* context) const
 {
@@ -67,26 +121,34 @@ void outline_pass::render(render_context* context) const
 	float4x4 view = context->camera->get_view_tween().interpolate(context->alpha);
 	float4x4 view_projection = context->camera->get_view_projection_tween().interpolate(context->alpha);
 	
+	if (mode == outline_mode::jump_flood)
+	{
+		render_jump_flood(*context, view_projection);
+		return;
+	}
+	
 	float4x4 model_view_projection;
 	
-	glEnable(GL_CULL_FACE);
-	glCullFace(GL_BACK);
-	glDisable(GL_DEPTH_TEST);
-	glEnable(GL_STENCIL_TEST);
+	gl::render_state state;
+	state.cull_enabled = true;
+	state.depth_write_enabled = false;
+	state.stencil_test_enabled = true;
 	
 	// Render fill
 	{
-		glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
-		glStencilOp(GL_KEEP, GL_KEEP, GL_REPLACE);  
-		glStencilFunc(GL_ALWAYS, 2, 0xFF);
-		glStencilMask(0xFF);
-		glDisable(GL_BLEND);
+		state.color_write_enabled = false;
+		state.stencil_pass = gl::stencil_operation::replace;
+		state.stencil_function = gl::comparison_function::always;
+		state.stencil_reference = 2;
+		state.stencil_read_mask = 0xFF;
+		state.stencil_write_mask = 0xFF;
+		rasterizer->set_render_state(state);
 		
 		// Setup fill shader
 		rasterizer->use_program(*fill_shader);
 		
 		// Render fills
-		for (const render_operation& operation: context->operations)
+		for (const render_operation& operation: *context->operations)
 		{
 			const ::material* material = operation.material;
 			if (!material || !(material->get_flags() & MATERIAL_FLAG_OUTLINE))
@@ -95,26 +157,22 @@ void outline_pass::render(render_context* context) const
 			model_view_projection = view_projection * operation.transform;
 			fill_model_view_projection_input->upload(model_view_projection);
 			
-			rasterizer->draw_arrays(*operation.vertex_array, operation.drawing_mode, operation.start_index, operation.index_count);
+			draw(operation);
 		}
 	}
 	
 	// Render stroke
 	{
-		glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
-
-		if (outline_color.w < 1.0f)
-		{
-			glEnable(GL_BLEND);
-			glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-		}
-		else
-		{
-			glDisable(GL_BLEND);
-		}
-
-		glStencilFunc(GL_NOTEQUAL, 2, 0xFF);
-		glStencilMask(0x00);
+		state.color_write_enabled = true;
+		
+		// Blend translucent outlines
+		state.blend_enabled = (outline_color.w < 1.0f);
+		state.blend_source = gl::blend_factor::src_alpha;
+		state.blend_destination = gl::blend_factor::one_minus_src_alpha;
+		
+		state.stencil_function = gl::comparison_function::not_equal;
+		state.stencil_write_mask = 0x00;
+		rasterizer->set_render_state(state);
 		
 		// Setup stroke shader
 		rasterizer->use_program(*stroke_shader);
@@ -122,7 +180,7 @@ void outline_pass::render(render_context* context) const
 		stroke_color_input->upload(outline_color);
 		
 		// Render strokes
-		for (const render_operation& operation: context->operations)
+		for (const render_operation& operation: *context->operations)
 		{
 			const ::material* material = operation.material;
 			if (!material || !(material->get_flags() & MATERIAL_FLAG_OUTLINE))
@@ -131,11 +189,9 @@ void outline_pass::render(render_context* context) const
 			model_view_projection = view_projection * operation.transform;
 			stroke_model_view_projection_input->upload(model_view_projection);
 			
-			rasterizer->draw_arrays(*operation.vertex_array, operation.drawing_mode, operation.start_index, operation.index_count);
+			draw(operation);
 		}
 	}
-	
-	glDisable(GL_STENCIL_TEST);
 }
 
 void outline_pass::set_outline_width(float width)
@@ -147,3 +203,139 @@ void outline_pass::set_outline_color(const float4& color)
 {
 	outline_color = color;
 }
+
+void outline_pass::set_mode(outline_mode mode)
+{
+	if (mode == outline_mode::jump_flood && (!seed_shader || !jump_flood_shader || !composite_shader))
+		return;
+	
+	this->mode = mode;
+	
+	if (mode == outline_mode::jump_flood && !jump_flood_framebuffers[0])
+	{
+		// Allocate jump flood targets, which are sized before each render
+		for (std::size_t i = 0; i < 2; ++i)
+		{
+			jump_flood_textures[i] = new gl::texture_2d(1, 1, gl::pixel_type::float_32, gl::pixel_format::rg);
+			jump_flood_textures[i]->set_wrapping(gl::texture_wrapping::extend, gl::texture_wrapping::extend);
+			jump_flood_textures[i]->set_filters(gl::texture_min_filter::nearest, gl::texture_mag_filter::nearest);
+			jump_flood_framebuffers[i] = new gl::framebuffer(1, 1);
+			jump_flood_framebuffers[i]->attach(gl::framebuffer_attachment_type::color, jump_flood_textures[i]);
+		}
+	}
+	else if (mode == outline_mode::stroke)
+	{
+		for (std::size_t i = 0; i < 2; ++i)
+		{
+			delete jump_flood_framebuffers[i];
+			delete jump_flood_textures[i];
+			jump_flood_framebuffers[i] = nullptr;
+			jump_flood_textures[i] = nullptr;
+		}
+	}
+}
+
+void outline_pass::set_outline_pixel_width(float width)
+{
+	outline_pixel_width = width;
+}
+
+void outline_pass::set_jump_flood_scale(float scale)
+{
+	jump_flood_scale = std::min(std::max(scale, 1.0f / 16.0f), 1.0f);
+}
+
+void outline_pass::resize_jump_flood_targets() const
+{
+	const std::array<int, 2>& dimensions = framebuffer->get_dimensions();
+	const std::array<int, 2> scaled_dimensions =
+	{
+		std::max(1, static_cast<int>(std::lround(dimensions[0] * jump_flood_scale))),
+		std::max(1, static_cast<int>(std::lround(dimensions[1] * jump_flood_scale)))
+	};
+	
+	for (std::size_t i = 0; i < 2; ++i)
+	{
+		if (jump_flood_framebuffers[i]->get_dimensions() == scaled_dimensions)
+			continue;
+		
+		gl::texture_2d* texture = jump_flood_textures[i];
+		texture->resize(scaled_dimensions[0], scaled_dimensions[1], texture->get_pixel_type(), texture->get_pixel_format(), texture->get_color_space(), nullptr);
+		jump_flood_framebuffers[i]->resize(scaled_dimensions);
+	}
+}
+
+void outline_pass::render_jump_flood(const render_context& context, const float4x4& view_projection) const
+{
+	resize_jump_flood_targets();
+	const std::array<int, 2>& dimensions = jump_flood_framebuffers[0]->get_dimensions();
+	const float2 scale =
+	{
+		static_cast<float>(dimensions[0]) / static_cast<float>(std::get<0>(framebuffer->get_dimensions())),
+		static_cast<float>(dimensions[1]) / static_cast<float>(std::get<1>(framebuffer->get_dimensions()))
+	};
+	
+	gl::render_state state;
+	state.cull_enabled = true;
+	state.depth_write_enabled = false;
+	rasterizer->set_render_state(state);
+	
+	// Seed the coordinates of outlined pixels
+	rasterizer->use_framebuffer(*jump_flood_framebuffers[0]);
+	rasterizer->set_viewport(0, 0, dimensions[0], dimensions[1]);
+	rasterizer->set_clear_color(no_seed, no_seed, 0.0f, 0.0f);
+	rasterizer->clear_framebuffer(true, false, false);
+	
+	rasterizer->use_program(*seed_shader);
+	
+	bool seeded = false;
+	for (const render_operation& operation: *context.operations)
+	{
+		const ::material* material = operation.material;
+		if (!material || !(material->get_flags() & MATERIAL_FLAG_OUTLINE))
+			continue;
+		
+		seed_model_view_projection_input->upload(view_projection * operation.transform);
+		draw(operation);
+		seeded = true;
+	}
+	
+	if (!seeded)
+		return;
+	
+	// Flood seeds over steps halving from the outline width, in texels of the jump flood targets, down to one texel
+	const float width = outline_pixel_width * std::max(scale.x, scale.y);
+	int step = 1;
+	while (static_cast<float>(step * 2) <= width)
+		step *= 2;
+	
+	rasterizer->use_program(*jump_flood_shader);
+	std::size_t source = 0;
+	for (; step >= 1; step /= 2)
+	{
+		rasterizer->use_framebuffer(*jump_flood_framebuffers[1 - source]);
+		jump_flood_seed_texture_input->upload(jump_flood_textures[source]);
+		if (jump_flood_step_input)
+			jump_flood_step_input->upload(static_cast<float>(step));
+		rasterizer->draw_arrays(*quad_vao, gl::drawing_mode::triangles, 0, 6);
+		source = 1 - source;
+	}
+	
+	// Blend outlines over the framebuffer
+	rasterizer->use_framebuffer(*framebuffer);
+	rasterizer->set_viewport(0, 0, std::get<0>(framebuffer->get_dimensions()), std::get<1>(framebuffer->get_dimensions()));
+	state.blend_enabled = true;
+	state.blend_source = gl::blend_factor::src_alpha;
+	state.blend_destination = gl::blend_factor::one_minus_src_alpha;
+	rasterizer->set_render_state(state);
+	
+	rasterizer->use_program(*composite_shader);
+	composite_seed_texture_input->upload(jump_flood_textures[source]);
+	if (composite_scale_input)
+		composite_scale_input->upload(scale);
+	if (composite_width_input)
+		composite_width_input->upload(width);
+	if (composite_color_input)
+		composite_color_input->upload(outline_color);
+	rasterizer->draw_arrays(*quad_vao, gl::drawing_mode::triangles, 0, 6);
+}
@@ -24,11 +24,28 @@
 #include "utility/fundamental-types.hpp"
 #include "gl/shader-program.hpp"
 #include "gl/shader-input.hpp"
+#include "gl/vertex-buffer.hpp"
+#include "gl/vertex-array.hpp"
+#include "gl/texture-2d.hpp"
 
 class resource_manager;
 
+/// Enumerates outline rendering modes.
+enum class outline_mode
+{
+	// Masks outlined operations in the stencil buffer, then draws them again expanded along their normals
+	stroke,
+	
+	// Floods the coordinates of outlined pixels across a reduced-resolution target, then composites pixels near them
+	jump_flood
+};
+
 /**
+ * Outlines the operations with outlined materials.
  *
+ * In stroke mode, outlined operations are drawn twice: once into the stencil buffer, and once expanded by the outline width, where the stencil buffer is not set.
+ *
+ * In jump flood mode, outlined operations are drawn once, by the `outline-seed-unskinned.glsl` shader program, which should write the window coordinates of each fragment into a seed target below the resolution of the framebuffer. The `jump-flood.glsl` shader program then propagates the nearest seed coordinates of each texel, sampling `seed_texture` at offsets of `step` texels, over steps halving from the outline width to one texel. Finally, the `outline-composite.glsl` shader program blends the outline color over pixels within the outline width of their nearest seed, but outside the outlined operations, given the `seed_texture`, `color`, `scale` (the resolution of the seed target relative to the framebuffer), and `width` (in texels of the seed target) inputs. The cost of the outline is a single draw of each outlined operation plus a logarithmic number of full-screen steps, independent of mesh complexity and nearly independent of outline width.
  */
 class outline_pass: public render_pass
 {
@@ -37,7 +54,34 @@ public:
 	virtual ~outline_pass();
 	virtual void render(render_context* context) const final;
 	
+	/**
+	 * Sets the outline rendering mode.
+	 *
+	 * @param mode Outline mode. Jump flood mode can't be set if its shader programs failed to load.
+	 */
+	void set_mode(outline_mode mode);
+	
+	/**
+	 * Sets the outline width in stroke mode.
+	 *
+	 * @param width Distance by which strokes are expanded along their normals.
+	 */
 	void set_outline_width(float width);
+	
+	/**
+	 * Sets the outline width in jump flood mode.
+	 *
+	 * @param width Outline width, in pixels of the framebuffer.
+	 */
+	void set_outline_pixel_width(float width);
+	
+	/**
+	 * Sets the resolution of the jump flood targets relative to the framebuffer.
+	 *
+	 * @param scale Resolution scale, on `(0, 1]`.
+	 */
+	void set_jump_flood_scale(float scale);
+	
 	void set_outline_color(const float4& color);
 
 private:
@@ -49,7 +93,36 @@ private:
 	const gl::shader_input* stroke_width_input;
 	const gl::shader_input* stroke_color_input;
 	
+	/// Matches the dimensions of the jump flood targets to the framebuffer, scaled by the jump flood scale.
+	void resize_jump_flood_targets() const;
+	
+	/// Floods and composites the outlines of the outlined operations.
+	void render_jump_flood(const render_context& context, const float4x4& view_projection) const;
+	
+	gl::shader_program* seed_shader;
+	const gl::shader_input* seed_model_view_projection_input;
+	
+	gl::shader_program* jump_flood_shader;
+	const gl::shader_input* jump_flood_seed_texture_input;
+	const gl::shader_input* jump_flood_step_input;
+	
+	gl::shader_program* composite_shader;
+	const gl::shader_input* composite_seed_texture_input;
+	const gl::shader_input* composite_scale_input;
+	const gl::shader_input* composite_width_input;
+	const gl::shader_input* composite_color_input;
+	
+	gl::vertex_buffer* quad_vbo;
+	gl::vertex_array* quad_vao;
+	
+	/// Ping-pong targets of nearest seed coordinates.
+	gl::texture_2d* jump_flood_textures[2];
+	gl::framebuffer* jump_flood_framebuffers[2];
+	
+	outline_mode mode;
 	float outline_width;
+	float outline_pixel_width;
+	float jump_flood_scale;
 	float4 outline_color;
 };
 
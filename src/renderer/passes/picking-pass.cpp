@@ -0,0 +1,181 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "renderer/passes/picking-pass.hpp"
+#include "resources/resource-manager.hpp"
+#include "gl/rasterizer.hpp"
+#include "gl/framebuffer.hpp"
+#include "gl/shader-program.hpp"
+#include "gl/shader-input.hpp"
+#include "gl/texture-2d.hpp"
+#include "renderer/render-context.hpp"
+#include "renderer/render-operation.hpp"
+#include "renderer/material.hpp"
+#include "renderer/material-flags.hpp"
+#include "scene/camera.hpp"
+#include "math/math.hpp"
+
+picking_pass::picking_pass(gl::rasterizer* rasterizer, resource_manager* resource_manager):
+	render_pass(rasterizer, nullptr),
+	shader(nullptr),
+	model_view_projection_input(nullptr),
+	id_input(nullptr),
+	pick_point{0.0f, 0.0f},
+	pick_viewport{0.0f, 0.0f, 0.0f, 0.0f},
+	pick_point_set(false),
+	next_readback(0),
+	result{0, {0.0f, 0.0f, 0.0f}, false},
+	result_available(false)
+{
+	// Picks are read back to the CPU, so the pass is never culled
+	set_side_effects(true);
+	
+	// Load picking shader
+	shader = resource_manager->load<gl::shader_program>("picking-unskinned.glsl");
+	model_view_projection_input = shader->get_input("model_view_projection"_sid);
+	id_input = shader->get_input("id"_sid);
+	
+	// Create single-pixel pick framebuffer (8-bit RGBA pick ID, 32F depth)
+	pick_color_texture = new gl::texture_2d(1, 1, gl::pixel_type::uint_8, gl::pixel_format::rgba);
+	pick_depth_texture = new gl::texture_2d(1, 1, gl::pixel_type::float_32, gl::pixel_format::d);
+	pick_framebuffer = new gl::framebuffer(1, 1);
+	pick_framebuffer->attach(gl::framebuffer_attachment_type::color, pick_color_texture);
+	pick_framebuffer->attach(gl::framebuffer_attachment_type::depth, pick_depth_texture);
+	framebuffer = pick_framebuffer;
+}
+
+picking_pass::~picking_pass()
+{
+	delete pick_framebuffer;
+	delete pick_depth_texture;
+	delete pick_color_texture;
+}
+
+void picking_pass::render(render_context* context) const
+{
+	poll();
+	
+	if (!pick_point_set || pick_viewport[2] <= 0.0f || pick_viewport[3] <= 0.0f)
+		return;
+	
+	// Skip the pick if all readbacks are still in flight
+	pick_readback& readback = readbacks[next_readback];
+	if (readback.color.is_pending())
+		return;
+	
+	rasterizer->use_framebuffer(*pick_framebuffer);
+	rasterizer->set_viewport(0, 0, 1, 1);
+	
+	// Clear pick ID to zero and reverse-z depth to the far plane
+	rasterizer->set_clear_color(0.0f, 0.0f, 0.0f, 0.0f);
+	rasterizer->set_clear_depth(0.0f);
+	rasterizer->clear_framebuffer(true, true, false);
+	
+	// Narrow the camera projection to the pixel under the pick point
+	const float2 ndc =
+	{
+		((pick_point[0] - pick_viewport[0]) / pick_viewport[2]) * 2.0f - 1.0f,
+		((pick_point[1] - pick_viewport[1]) / pick_viewport[3]) * 2.0f - 1.0f
+	};
+	float4x4 pick_matrix = math::identity4x4<float>;
+	pick_matrix[0][0] = pick_viewport[2];
+	pick_matrix[1][1] = pick_viewport[3];
+	pick_matrix[3][0] = -ndc[0] * pick_viewport[2];
+	pick_matrix[3][1] = -ndc[1] * pick_viewport[3];
+	
+	const float4x4 view_projection = context->camera->get_view_projection_tween().interpolate(context->alpha);
+	const float4x4 pick_view_projection = pick_matrix * view_projection;
+	
+	// Opaque, back-face culled, reverse-z depth tested, as in the material pass
+	gl::render_state state;
+	state.depth_test_enabled = true;
+	state.depth_function = gl::comparison_function::greater;
+	state.cull_enabled = true;
+	state.depth_range_near = -1.0f;
+	state.depth_range_far = 1.0f;
+	rasterizer->set_render_state(state);
+	
+	rasterizer->use_program(*shader);
+	
+	static constexpr std::uint32_t excluded_flags = MATERIAL_FLAG_TRANSLUCENT | MATERIAL_FLAG_X_RAY | MATERIAL_FLAG_DECAL;
+	for (const render_operation& operation: *context->operations)
+	{
+		// Skip geometry which is hidden, transparent to picks, or instanced without per-instance pick IDs
+		const ::material* material = operation.material;
+		if (!material || (material->get_flags() & excluded_flags) || operation.occluded || operation.instance_count)
+			continue;
+		
+		// Encode pick ID as 8-bit RGBA
+		const std::uint32_t id = operation.pick_id;
+		id_input->upload(float4
+		{
+			static_cast<float>(id & 0xff) / 255.0f,
+			static_cast<float>((id >> 8) & 0xff) / 255.0f,
+			static_cast<float>((id >> 16) & 0xff) / 255.0f,
+			static_cast<float>((id >> 24) & 0xff) / 255.0f
+		});
+		model_view_projection_input->upload(pick_view_projection * operation.transform);
+		
+		draw(operation);
+	}
+	
+	// Read back the picked pixel, to be mapped by a later frame
+	readback.color.read_color(*pick_framebuffer, true);
+	readback.depth.read_depth(*pick_framebuffer);
+	readback.inverse_view_projection = math::inverse(view_projection);
+	readback.ndc = ndc;
+	next_readback = (next_readback + 1) % readback_count;
+}
+
+void picking_pass::set_pick_point(const float2& position, const float4& viewport)
+{
+	pick_point = position;
+	pick_viewport = viewport;
+	pick_point_set = true;
+}
+
+void picking_pass::poll() const
+{
+	// Map completed readbacks from oldest to newest, stopping at the first incomplete readback
+	for (std::size_t i = 0; i < readback_count; ++i)
+	{
+		pick_readback& readback = readbacks[(next_readback + i) % readback_count];
+		if (!readback.color.is_pending())
+			continue;
+		if (!readback.color.is_ready() || !readback.depth.is_ready())
+			break;
+		
+		const std::uint8_t* color = static_cast<const std::uint8_t*>(readback.color.map());
+		result.id = static_cast<std::uint32_t>(color[0]) | (static_cast<std::uint32_t>(color[1]) << 8) | (static_cast<std::uint32_t>(color[2]) << 16) | (static_cast<std::uint32_t>(color[3]) << 24);
+		readback.color.unmap();
+		
+		const float depth = *static_cast<const float*>(readback.depth.map());
+		readback.depth.unmap();
+		
+		// Unproject the picked pixel, with reverse-z depth cleared to zero where nothing was drawn
+		result.hit = (depth > 0.0f);
+		if (result.hit)
+		{
+			const float4 position = readback.inverse_view_projection * float4{readback.ndc[0], readback.ndc[1], depth, 1.0f};
+			result.position = math::resize<3>(position) * (1.0f / position[3]);
+		}
+		
+		result_available = true;
+	}
+}
@@ -0,0 +1,118 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ANTKEEPER_PICKING_PASS_HPP
+#define ANTKEEPER_PICKING_PASS_HPP
+
+#include "renderer/render-pass.hpp"
+#include "utility/fundamental-types.hpp"
+#include "gl/shader-program.hpp"
+#include "gl/shader-input.hpp"
+#include "gl/texture-2d.hpp"
+#include "gl/readback-buffer.hpp"
+#include <cstdint>
+
+class resource_manager;
+
+/**
+ * Picks the geometry under a point on the screen by rendering pick IDs, rather than by casting rays against scene geometry on the CPU.
+ *
+ * Only the pixel under the pick point is rendered, into a single-pixel framebuffer owned by the pass, by narrowing the camera projection to that pixel. The pick ID of each opaque render operation is written as 8-bit RGBA, and its depth is kept, so that both the pick ID and the position of the picked surface can be recovered. Pixels are read back asynchronously and polled by later frames, so results lag the pick point by one or more frames, but never stall the pipeline. The cost of picking is that of drawing the scene once into a single pixel, regardless of the complexity of its meshes.
+ */
+class picking_pass: public render_pass
+{
+public:
+	/// Result of a pick.
+	struct pick_result
+	{
+		/// Pick ID of the picked geometry, or `0` if nothing pickable was picked.
+		std::uint32_t id;
+		
+		/// World-space position of the picked surface, if any surface was hit.
+		float3 position;
+		
+		/// `true` if any opaque surface was hit.
+		bool hit;
+	};
+	
+	picking_pass(gl::rasterizer* rasterizer, resource_manager* resource_manager);
+	virtual ~picking_pass();
+	virtual void render(render_context* context) const final;
+	
+	/**
+	 * Sets the point which is picked by subsequent frames.
+	 *
+	 * @param position Pick point, in window coordinates with the origin at the bottom left.
+	 * @param viewport Viewport of the camera, in window coordinates.
+	 */
+	void set_pick_point(const float2& position, const float4& viewport);
+	
+	/// Returns the most recent pick result to have been read back.
+	const pick_result& get_pick_result() const;
+	
+	/// Returns `true` if at least one pick result has been read back.
+	bool has_pick_result() const;
+
+private:
+	/// Pick readback in flight.
+	struct pick_readback
+	{
+		gl::readback_buffer color;
+		gl::readback_buffer depth;
+		
+		/// Inverse view-projection matrix and NDC coordinates of the pick point, by which the picked position is unprojected.
+		float4x4 inverse_view_projection;
+		float2 ndc;
+	};
+	
+	/// Maps the completed readbacks, in the order in which they were issued.
+	void poll() const;
+	
+	/// Number of readbacks which may be in flight.
+	static constexpr std::size_t readback_count = 3;
+	
+	gl::shader_program* shader;
+	const gl::shader_input* model_view_projection_input;
+	const gl::shader_input* id_input;
+	
+	gl::texture_2d* pick_color_texture;
+	gl::texture_2d* pick_depth_texture;
+	gl::framebuffer* pick_framebuffer;
+	
+	float2 pick_point;
+	float4 pick_viewport;
+	bool pick_point_set;
+	
+	mutable pick_readback readbacks[readback_count];
+	mutable std::size_t next_readback;
+	mutable pick_result result;
+	mutable bool result_available;
+};
+
+inline const picking_pass::pick_result& picking_pass::get_pick_result() const
+{
+	return result;
+}
+
+inline bool picking_pass::has_pick_result() const
+{
+	return result_available;
+}
+
+#endif // ANTKEEPER_PICKING_PASS_HPP
@@ -0,0 +1,607 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "renderer/passes/shadow-atlas-pass.hpp"
+#include "resources/resource-manager.hpp"
+#include "gl/rasterizer.hpp"
+#include "gl/framebuffer.hpp"
+#include "gl/shader-program.hpp"
+#include "gl/shader-input.hpp"
+#include "renderer/render-context.hpp"
+#include "renderer/skinning-stage.hpp"
+#include "renderer/material.hpp"
+#include "renderer/material-flags.hpp"
+#include "renderer/sort-key.hpp"
+#include "scene/camera.hpp"
+#include "scene/collection.hpp"
+#include "scene/point-light.hpp"
+#include "scene/spot-light.hpp"
+#include "configuration.hpp"
+#include "debug/draw.hpp"
+#include "math/math.hpp"
+#include <algorithm>
+#include <cmath>
+
+/// Generates the key by which the shadow atlas pass sorts a render operation.
+static std::uint64_t generate_sort_key(const render_operation& operation);
+
+/**
+ * Calculates the planes of a light clip volume, on `[-1, 1]` along x and y and `[0, 1]` along z.
+ *
+ * @param view_projection Half-z view-projection matrix of the light.
+ * @param[out] volume Convex hull with six planes.
+ */
+static void calculate_light_clip_volume(const float4x4& view_projection, geom::convex_hull<float>& volume);
+
+/// Forward and up directions of the cube faces of a point light, in the order +x, -x, +y, -y, +z, -z.
+static const float3 cube_face_directions[6][2] =
+{
+	{{ 1.0f,  0.0f,  0.0f}, {0.0f, -1.0f,  0.0f}},
+	{{-1.0f,  0.0f,  0.0f}, {0.0f, -1.0f,  0.0f}},
+	{{ 0.0f,  1.0f,  0.0f}, {0.0f,  0.0f,  1.0f}},
+	{{ 0.0f, -1.0f,  0.0f}, {0.0f,  0.0f, -1.0f}},
+	{{ 0.0f,  0.0f,  1.0f}, {0.0f, -1.0f,  0.0f}},
+	{{ 0.0f,  0.0f, -1.0f}, {0.0f, -1.0f,  0.0f}}
+};
+
+/// Attenuation threshold beyond which lights cast no shadows, matching that of light clusters.
+static constexpr float attenuation_threshold = 1.0f / 256.0f;
+
+/// Number of renders after which the tiles of a light which is no longer collected are freed.
+static constexpr unsigned int eviction_delay = 120;
+
+/// Smallest side of a tile, in texels.
+static constexpr unsigned int min_tile_resolution = 64;
+
+shadow_atlas_pass::shadow_atlas_pass(gl::rasterizer* rasterizer, const gl::framebuffer* framebuffer, resource_manager* resource_manager):
+	render_pass(rasterizer, framebuffer),
+	resolution(static_cast<unsigned int>(std::get<0>(framebuffer->get_dimensions()))),
+	min_level(1),
+	max_level(1),
+	update_budget(6),
+	max_distance(100.0f),
+	movement_threshold(0.001f),
+	direction_threshold(std::cos(0.005f)),
+	render_index(0)
+{
+	// Tiles range from a quarter of the atlas down to the minimum tile resolution
+	while ((resolution >> (max_level + 1)) >= min_tile_resolution)
+		++max_level;
+	
+	// Initially the whole atlas is a single free tile
+	free_tile_lists.resize(max_level + 1);
+	free_tile_lists[0].push_back({0, 0, 0});
+	
+	// Load unskinned shader program
+	unskinned_shader_program = resource_manager->load<gl::shader_program>("depth-unskinned.glsl");
+	unskinned_model_view_projection_input = unskinned_shader_program->get_input("model_view_projection"_sid);
+	
+	// Load skinned shader program
+	skinned_shader_program = resource_manager->load<gl::shader_program>("depth-skinned.glsl");
+	skinned_model_view_projection_input = skinned_shader_program->get_input("model_view_projection"_sid);
+	skinned_shader_program->bind_uniform_block("bone_palette_block"_sid, skinning_stage::bone_palette_binding);
+}
+
+shadow_atlas_pass::~shadow_atlas_pass()
+{}
+
+void shadow_atlas_pass::render(render_context* context) const
+{
+	++render_index;
+	
+	const scene::camera& camera = *context->camera;
+	const float tan_half_fov = std::tan(camera.get_fov_tween().interpolate(context->alpha) * 0.5f);
+	
+	// Collect lights, as the material pass does
+	light_objects.clear();
+	if (context->collection->is_spatially_indexed() && context->camera_culling_volume->get_bounding_volume_type() == geom::bounding_volume_type::convex_hull)
+	{
+		context->collection->query
+		(
+			scene::light::object_type_id,
+			static_cast<const geom::convex_hull<float>&>(*context->camera_culling_volume),
+			[this](const scene::object_base* object)
+			{
+				light_objects.push_back(object);
+			}
+		);
+	}
+	else
+	{
+		const std::vector<scene::object_base*>* lights = context->collection->get_objects(scene::light::object_type_id);
+		light_objects.assign(lights->begin(), lights->end());
+	}
+	
+	// Rank spot and point lights by importance
+	for (auto& entry: records)
+		entry.second.importance = 0.0f;
+	for (const scene::object_base* object: light_objects)
+	{
+		if (!object->is_active())
+			continue;
+		
+		const scene::light* light = static_cast<const scene::light*>(object);
+		const scene::light_type type = light->get_light_type();
+		if (type != scene::light_type::spot && type != scene::light_type::point)
+			continue;
+		
+		float priority = 1.0f;
+		if (auto it = settings.find(light); it != settings.end())
+			priority = it->second.priority;
+		if (priority <= 0.0f)
+			continue;
+		
+		float3 attenuation;
+		float3 direction = {0.0f, 0.0f, 0.0f};
+		float outer_cutoff = 0.0f;
+		if (type == scene::light_type::spot)
+		{
+			const scene::spot_light* spot_light = static_cast<const scene::spot_light*>(light);
+			attenuation = spot_light->get_attenuation_tween().interpolate(context->alpha);
+			direction = spot_light->get_direction_tween().interpolate(context->alpha);
+			outer_cutoff = spot_light->get_cutoff_tween().interpolate(context->alpha).y;
+		}
+		else
+		{
+			attenuation = static_cast<const scene::point_light*>(light)->get_attenuation_tween().interpolate(context->alpha);
+		}
+		
+		const float range = std::min<float>(scene::light::attenuation_range(attenuation, attenuation_threshold), max_distance);
+		if (!(range > 0.0f))
+			continue;
+		
+		// Estimate the fraction of the screen height covered by the sphere of influence of the light
+		const double3 position = light->get_interpolated_origin() + math::type_cast<double>(light->get_interpolated_transform().translation);
+		const float distance = math::length(math::type_cast<float>(position - context->camera_origin));
+		float coverage = 1.0f;
+		if (distance > range)
+			coverage = std::min<float>(1.0f, range / (std::sqrt(distance * distance - range * range) * tan_half_fov));
+		
+		auto [it, inserted] = records.try_emplace(light);
+		light_record& record = it->second;
+		if (inserted)
+		{
+			record.light = light;
+			record.face_count = (type == scene::light_type::spot) ? 1 : 6;
+			record.level = -1;
+		}
+		record.importance = priority * coverage;
+		record.last_seen = render_index;
+		record.current.face_count = 0;
+		
+		// Invalidate all faces if the light moved
+		const double3 delta = position - record.position;
+		if (record.level < 0 ||
+			math::dot(delta, delta) > static_cast<double>(movement_threshold * movement_threshold) ||
+			(type == scene::light_type::spot && math::dot(direction, record.direction) < direction_threshold) ||
+			outer_cutoff != record.outer_cutoff ||
+			range != record.range)
+		{
+			record.position = position;
+			record.direction = direction;
+			record.outer_cutoff = outer_cutoff;
+			record.range = range;
+			for (unsigned int i = 0; i < record.face_count; ++i)
+				record.face_valid[i] = false;
+		}
+		
+		// Larger tiles for more important lights, with point light faces one level smaller, and one level of hysteresis
+		const int face_level = (type == scene::light_type::point) ? 1 : 0;
+		const int desired_level = std::clamp<int>(static_cast<int>(min_level) + face_level + static_cast<int>(std::floor(-std::log2(std::max<float>(coverage, 1e-6f)))), static_cast<int>(min_level), static_cast<int>(max_level));
+		if (record.level < 0 || std::abs(desired_level - record.level) > 1)
+		{
+			free_tiles(record);
+			pending_records.emplace_back(&record, static_cast<unsigned int>(desired_level));
+		}
+	}
+	
+	// Free the tiles of lights which haven't been collected recently
+	for (auto it = records.begin(); it != records.end();)
+	{
+		if (render_index - it->second.last_seen > eviction_delay)
+		{
+			free_tiles(it->second);
+			it = records.erase(it);
+		}
+		else
+		{
+			++it;
+		}
+	}
+	
+	// Allocate tiles for the most important lights first, evicting less important lights or falling back to smaller tiles if the atlas is full
+	std::sort(pending_records.begin(), pending_records.end(), [](const auto& a, const auto& b) { return a.first->importance > b.first->importance; });
+	for (auto [record, level]: pending_records)
+	{
+		bool allocated = allocate_tiles(*record, level);
+		while (!allocated && evict_light(record->importance))
+			allocated = allocate_tiles(*record, level);
+		for (unsigned int i = level + 1; !allocated && i <= max_level; ++i)
+			allocated = allocate_tiles(*record, i);
+	}
+	pending_records.clear();
+	
+	// Select faces to update: invalid faces first, then the faces of dynamic lights, by importance and age
+	updates.clear();
+	for (auto& entry: records)
+	{
+		light_record& record = entry.second;
+		if (record.level < 0 || record.last_seen != render_index)
+			continue;
+		
+		bool is_static = false;
+		if (auto it = settings.find(record.light); it != settings.end())
+			is_static = it->second.is_static;
+		
+		for (unsigned int i = 0; i < record.face_count; ++i)
+		{
+			if (!record.face_valid[i])
+				updates.push_back({&record, i, false, record.importance});
+			else if (!is_static)
+				updates.push_back({&record, i, true, record.importance * static_cast<float>(render_index - record.face_render_indices[i])});
+		}
+	}
+	if (updates.size() > update_budget)
+	{
+		std::partial_sort(updates.begin(), updates.begin() + update_budget, updates.end(), [](const face_update& a, const face_update& b) { return (a.valid != b.valid) ? !a.valid : a.score > b.score; });
+		updates.resize(update_budget);
+	}
+	
+	if (!updates.empty())
+	{
+		// Sort render operations
+		context->operations->sort(generate_sort_key);
+		
+		// Collect shadow casters and their world-space bounds
+		casters.clear();
+		caster_culling.clear();
+		for (const render_operation& operation: *context->operations)
+		{
+			// Skip materials which don't cast shadows
+			const ::material* material = operation.material;
+			if (material && (material->get_flags() & MATERIAL_FLAG_NOT_SHADOW_CASTER))
+				continue;
+			
+			casters.push_back(&operation);
+			
+			// Instanced geometry extends beyond the bounds of its operation
+			if (operation.instance_count)
+				caster_culling.add_unbounded();
+			else
+				caster_culling.add_bounds(operation.bounds);
+		}
+		
+		// Add the light clip volume of each updated face to the culling stage
+		update_volumes.clear();
+		for (const face_update& update: updates)
+		{
+			light_record& record = *update.record;
+			record.face_view_projections[update.face] = calculate_face_view_projection(*context, record, update.face);
+			record.face_origins[update.face] = context->camera_origin;
+			record.face_render_indices[update.face] = render_index;
+			record.face_valid[update.face] = true;
+			record.face_rendered[update.face] = true;
+			
+			calculate_light_clip_volume(record.face_view_projections[update.face], face_volume);
+			update_volumes.push_back(caster_culling.add_volume(face_volume));
+		}
+		
+		// Cull casters against the light clip volumes of all updated faces at once
+		caster_culling.cull();
+		
+		rasterizer->use_framebuffer(*framebuffer);
+		
+		// Depth test and write, culling front faces, and clearing only the tiles of updated faces
+		gl::render_state state;
+		state.depth_test_enabled = true;
+		state.depth_function = gl::comparison_function::less;
+		state.cull_enabled = true;
+		state.culled_face = gl::cull_face::front;
+		state.scissor_test_enabled = true;
+		rasterizer->set_render_state(state);
+		rasterizer->set_clear_depth(1.0f);
+		
+		gl::shader_program* active_shader_program = nullptr;
+		float4x4 model_view_projection;
+		
+		for (std::size_t i = 0; i < updates.size(); ++i)
+		{
+			const light_record& record = *updates[i].record;
+			const tile& face_tile = record.tiles[updates[i].face];
+			const float4x4& view_projection = record.face_view_projections[updates[i].face];
+			
+			// Set viewport and clear the tile
+			const float tile_resolution = static_cast<float>(resolution >> face_tile.level);
+			const float x = static_cast<float>(face_tile.x) * tile_resolution;
+			const float y = static_cast<float>(face_tile.y) * tile_resolution;
+			rasterizer->set_viewport(x, y, tile_resolution, tile_resolution);
+			rasterizer->set_scissor(x, y, tile_resolution, tile_resolution);
+			rasterizer->clear_framebuffer(false, true, false);
+			
+			for (std::size_t j = 0; j < casters.size(); ++j)
+			{
+				if (!caster_culling.is_visible(update_volumes[i], j))
+					continue;
+				
+				const render_operation* operation = casters[j];
+				
+				// Switch shader programs if necessary
+				gl::shader_program* shader_program = (operation->pose != nullptr) ? skinned_shader_program : unskinned_shader_program;
+				if (active_shader_program != shader_program)
+				{
+					active_shader_program = shader_program;
+					rasterizer->use_program(*active_shader_program);
+				}
+				
+				// Calculate model-view-projection matrix
+				model_view_projection = view_projection * operation->transform;
+				
+				// Upload operation-dependent parameters to shader program
+				if (active_shader_program == unskinned_shader_program)
+				{
+					unskinned_model_view_projection_input->upload(model_view_projection);
+				}
+				else if (active_shader_program == skinned_shader_program)
+				{
+					skinned_model_view_projection_input->upload(model_view_projection);
+					bind_bone_palette(*context, *operation);
+				}
+				
+				// Draw geometry
+				draw(*operation);
+			}
+		}
+		
+		state.scissor_test_enabled = false;
+		rasterizer->set_render_state(state);
+	}
+	
+	// Calculate the shadow matrices of lights whose faces have all been rendered, moving cached faces into the frame of the current camera origin
+	const float4x4 bias_matrix = math::translate(math::identity4x4<float>, float3{0.5f, 0.5f, 0.5f}) * math::scale(math::identity4x4<float>, float3{0.5f, 0.5f, 0.5f});
+	for (auto& entry: records)
+	{
+		light_record& record = entry.second;
+		if (record.level < 0 || record.last_seen != render_index)
+			continue;
+		
+		bool complete = true;
+		for (unsigned int i = 0; i < record.face_count && complete; ++i)
+			complete = record.face_rendered[i];
+		if (!complete)
+			continue;
+		
+		const float tile_scale = 1.0f / static_cast<float>(1u << record.level);
+		for (unsigned int i = 0; i < record.face_count; ++i)
+		{
+			const tile& face_tile = record.tiles[i];
+			const float4x4 tile_matrix = math::translate(math::identity4x4<float>, float3{static_cast<float>(face_tile.x) * tile_scale, static_cast<float>(face_tile.y) * tile_scale, 0.0f}) * math::scale(math::identity4x4<float>, float3{tile_scale, tile_scale, 1.0f});
+			const float4x4 origin_matrix = math::translate(math::identity4x4<float>, math::type_cast<float>(context->camera_origin - record.face_origins[i]));
+			record.current.matrices[i] = tile_matrix * bias_matrix * record.face_view_projections[i] * origin_matrix;
+		}
+		record.current.face_count = record.face_count;
+		record.current.tile_resolution = static_cast<float>(resolution >> record.level);
+		
+		// Draw the light clip volumes of shadowed faces, which are relative to the camera origin
+		if (debug::draw::is_enabled(debug::draw::shadow_atlas))
+		{
+			const float4 color = (record.face_count == 1) ? float4{1.0f, 0.6f, 0.2f, 1.0f} : float4{0.2f, 0.8f, 1.0f, 1.0f};
+			for (unsigned int i = 0; i < record.face_count; ++i)
+				debug::draw::frustum(record.face_view_projections[i] * math::translate(math::identity4x4<float>, -math::type_cast<float>(record.face_origins[i])), color);
+		}
+	}
+}
+
+void shadow_atlas_pass::set_update_budget(std::size_t tile_count)
+{
+	update_budget = tile_count;
+}
+
+void shadow_atlas_pass::set_light_priority(const scene::light* light, float priority)
+{
+	auto [it, inserted] = settings.try_emplace(light, light_settings{1.0f, false});
+	it->second.priority = priority;
+}
+
+void shadow_atlas_pass::set_light_static(const scene::light* light, bool is_static)
+{
+	auto [it, inserted] = settings.try_emplace(light, light_settings{1.0f, false});
+	it->second.is_static = is_static;
+}
+
+void shadow_atlas_pass::set_max_distance(float distance)
+{
+	max_distance = distance;
+}
+
+void shadow_atlas_pass::invalidate_cache()
+{
+	for (auto& entry: records)
+	{
+		for (unsigned int i = 0; i < entry.second.face_count; ++i)
+			entry.second.face_valid[i] = false;
+	}
+}
+
+const shadow_atlas_pass::shadow* shadow_atlas_pass::get_shadow(const scene::light* light) const
+{
+	auto it = records.find(light);
+	if (it == records.end() || it->second.last_seen != render_index || !it->second.current.face_count)
+		return nullptr;
+	
+	return &it->second.current;
+}
+
+bool shadow_atlas_pass::allocate_tile(unsigned int level, tile& result) const
+{
+	// Find the smallest free tile at least as large as the requested level
+	unsigned int source = level;
+	while (free_tile_lists[source].empty())
+	{
+		if (source == 0)
+			return false;
+		--source;
+	}
+	
+	tile t = free_tile_lists[source].back();
+	free_tile_lists[source].pop_back();
+	
+	// Split the tile down to the requested level, freeing three of the four children at each level
+	while (t.level < level)
+	{
+		const unsigned int child_level = t.level + 1;
+		const unsigned int x = t.x * 2;
+		const unsigned int y = t.y * 2;
+		std::vector<tile>& children = free_tile_lists[child_level];
+		children.push_back({child_level, x + 1, y});
+		children.push_back({child_level, x, y + 1});
+		children.push_back({child_level, x + 1, y + 1});
+		t = {child_level, x, y};
+	}
+	
+	result = t;
+	return true;
+}
+
+void shadow_atlas_pass::free_tile(tile t) const
+{
+	while (t.level > 0)
+	{
+		// Find the three buddies of the tile among the free tiles of its level
+		std::vector<tile>& tiles = free_tile_lists[t.level];
+		std::size_t buddies[3];
+		std::size_t buddy_count = 0;
+		for (std::size_t i = 0; i < tiles.size() && buddy_count < 3; ++i)
+		{
+			if ((tiles[i].x >> 1) == (t.x >> 1) && (tiles[i].y >> 1) == (t.y >> 1))
+				buddies[buddy_count++] = i;
+		}
+		if (buddy_count < 3)
+			break;
+		
+		// Merge the tile with its buddies, removing them in descending order of index
+		std::sort(buddies, buddies + 3);
+		for (int i = 2; i >= 0; --i)
+		{
+			tiles[buddies[i]] = tiles.back();
+			tiles.pop_back();
+		}
+		t = {t.level - 1, t.x >> 1, t.y >> 1};
+	}
+	
+	free_tile_lists[t.level].push_back(t);
+}
+
+bool shadow_atlas_pass::allocate_tiles(light_record& record, unsigned int level) const
+{
+	for (unsigned int i = 0; i < record.face_count; ++i)
+	{
+		if (!allocate_tile(level, record.tiles[i]))
+		{
+			while (i)
+				free_tile(record.tiles[--i]);
+			return false;
+		}
+		record.face_valid[i] = false;
+		record.face_rendered[i] = false;
+	}
+	
+	record.level = static_cast<int>(level);
+	return true;
+}
+
+void shadow_atlas_pass::free_tiles(light_record& record) const
+{
+	if (record.level < 0)
+		return;
+	
+	for (unsigned int i = 0; i < record.face_count; ++i)
+	{
+		free_tile(record.tiles[i]);
+		record.face_valid[i] = false;
+	}
+	record.level = -1;
+}
+
+bool shadow_atlas_pass::evict_light(float importance) const
+{
+	light_record* victim = nullptr;
+	for (auto& entry: records)
+	{
+		light_record& record = entry.second;
+		if (record.level >= 0 && record.importance < importance && (!victim || record.importance < victim->importance))
+			victim = &record;
+	}
+	
+	if (!victim)
+		return false;
+	
+	free_tiles(*victim);
+	return true;
+}
+
+float4x4 shadow_atlas_pass::calculate_face_view_projection(const render_context& context, const light_record& record, unsigned int face) const
+{
+	const float3 position = math::type_cast<float>(record.position - context.camera_origin);
+	const float tile_resolution = static_cast<float>(resolution >> record.level);
+	const float clip_near = record.range / 256.0f;
+	
+	float3 forward;
+	float3 up;
+	float fov;
+	if (record.face_count == 1)
+	{
+		forward = record.direction;
+		up = (std::abs(forward.y) < 0.99f) ? global_up : float3{1.0f, 0.0f, 0.0f};
+		fov = std::min<float>(record.outer_cutoff * 2.0f, math::radians(170.0f));
+	}
+	else
+	{
+		forward = cube_face_directions[face][0];
+		up = cube_face_directions[face][1];
+		
+		// Widen the faces by a texel on each side, so that filtering across face edges samples rendered texels
+		fov = 2.0f * std::atan(1.0f + 2.0f / tile_resolution);
+	}
+	
+	const float4x4 view = math::look_at(position, position + forward, up);
+	const float4x4 projection = math::perspective_half_z(fov, 1.0f, clip_near, record.range);
+	return projection * view;
+}
+
+void calculate_light_clip_volume(const float4x4& view_projection, geom::convex_hull<float>& volume)
+{
+	const float4x4 transpose = math::transpose(view_projection);
+	volume.planes.resize(6);
+	volume.planes[0] = geom::plane<float>(transpose[3] + transpose[0]);
+	volume.planes[1] = geom::plane<float>(transpose[3] - transpose[0]);
+	volume.planes[2] = geom::plane<float>(transpose[3] + transpose[1]);
+	volume.planes[3] = geom::plane<float>(transpose[3] - transpose[1]);
+	volume.planes[4] = geom::plane<float>(transpose[2]);
+	volume.planes[5] = geom::plane<float>(transpose[3] - transpose[2]);
+}
+
+std::uint64_t generate_sort_key(const render_operation& operation)
+{
+	// Render unskinned operations first, grouped by VAO
+	std::uint64_t key = (operation.pose != nullptr) ? std::uint64_t(1) << 63 : 0;
+	key |= sort_key::hash_pointer(operation.vertex_array, 32);
+	
+	return key;
+}
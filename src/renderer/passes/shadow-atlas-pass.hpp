@@ -0,0 +1,225 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef ANTKEEPER_SHADOW_ATLAS_PASS_HPP
+#define ANTKEEPER_SHADOW_ATLAS_PASS_HPP
+
+#include "renderer/render-pass.hpp"
+#include "utility/fundamental-types.hpp"
+#include "scene/light.hpp"
+#include "gl/shader-program.hpp"
+#include "gl/shader-input.hpp"
+#include "renderer/culling-stage.hpp"
+#include "geom/convex-hull.hpp"
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+class resource_manager;
+struct render_operation;
+
+/**
+ * Renders the shadows of point and spot lights into tiles of a shared depth atlas.
+ *
+ * Each render, the collected spot and point lights are ranked by their priority and the fraction of the screen their spheres of influence cover. Spot lights occupy one perspective tile, and point lights occupy six cube face tiles. Tile sizes are powers of two allocated by a quadtree buddy allocator, larger for more important lights, and lights which don't fit evict less important lights or fall back to smaller tiles.
+ *
+ * Tiles are cached. Only a budgeted number of tiles are re-rendered per render: first those of lights which were reallocated or moved, then those of dynamic lights, least recently updated and most important first. Tiles of static lights are only re-rendered when invalidated.
+ */
+class shadow_atlas_pass: public render_pass
+{
+public:
+	/// Shadow of a light, as of the most recent render.
+	struct shadow
+	{
+		/// Shadow matrices which map camera-relative positions to atlas texture coordinates and depth: one for a spot light, and one per cube face, in the order +x, -x, +y, -y, +z, -z, for a point light.
+		float4x4 matrices[6];
+		
+		/// Number of shadow matrices.
+		unsigned int face_count;
+		
+		/// Resolution of each tile, in texels.
+		float tile_resolution;
+	};
+	
+	/**
+	 * Creates a shadow atlas pass.
+	 *
+	 * @param rasterizer Rasterizer.
+	 * @param framebuffer Square framebuffer with a depth attachment, the sides of which are a power of two.
+	 * @param resource_manager Resource manager from which the depth shader programs are loaded.
+	 */
+	shadow_atlas_pass(gl::rasterizer* rasterizer, const gl::framebuffer* framebuffer, resource_manager* resource_manager);
+	virtual ~shadow_atlas_pass();
+	virtual void render(render_context* context) const final;
+	
+	/**
+	 * Sets the maximum number of tiles rendered per render.
+	 *
+	 * @param tile_count Number of tiles. A point light needs six tiles to be shadowed.
+	 */
+	void set_update_budget(std::size_t tile_count);
+	
+	/**
+	 * Sets the priority of a light, which scales its importance when tiles are allocated and updated.
+	 *
+	 * @param light Spot or point light.
+	 * @param priority Priority of the light. Lights default to a priority of `1`, and lights with a priority of `0` cast no shadows.
+	 */
+	void set_light_priority(const scene::light* light, float priority);
+	
+	/**
+	 * Marks a light as static or dynamic.
+	 *
+	 * @param light Spot or point light.
+	 * @param is_static `true` if neither the light nor the shadow casters around it move, such that its tiles need only be rendered when invalidated, `false` if its tiles should be periodically re-rendered. Lights are dynamic by default.
+	 */
+	void set_light_static(const scene::light* light, bool is_static);
+	
+	/**
+	 * Sets the far clipping distance of lights whose attenuation never falls below the attenuation threshold of light clusters.
+	 *
+	 * @param distance Maximum shadow distance.
+	 */
+	void set_max_distance(float distance);
+	
+	/// Invalidates all cached tiles, causing them to be re-rendered as the update budget allows.
+	void invalidate_cache();
+	
+	/**
+	 * Returns the shadow of a light, as of the most recent render.
+	 *
+	 * @param light Spot or point light.
+	 * @return Shadow of the light, or `nullptr` if the light wasn't shadowed by the most recent render. A light is only shadowed once all its tiles have been rendered.
+	 */
+	const shadow* get_shadow(const scene::light* light) const;
+
+private:
+	/// Square tile of the atlas, with a side of `resolution >> level` texels and an origin at `(x, y)` multiples of its side.
+	struct tile
+	{
+		unsigned int level;
+		unsigned int x;
+		unsigned int y;
+	};
+	
+	/// User-specified settings of a light.
+	struct light_settings
+	{
+		float priority;
+		bool is_static;
+	};
+	
+	/// Tiles and cached state of a shadowed light.
+	struct light_record
+	{
+		const scene::light* light;
+		unsigned int face_count;
+		
+		/// Level of the tiles of the light, or `-1` if no tiles are allocated.
+		int level;
+		tile tiles[6];
+		
+		/// Whether each face was rendered since its tile was allocated.
+		bool face_rendered[6];
+		
+		/// Whether each face was rendered since its tile was allocated or its light moved.
+		bool face_valid[6];
+		
+		/// Render index of the most recent update of each face.
+		unsigned int face_render_indices[6];
+		
+		/// View-projection matrix with which each face was rendered, relative to the camera origin at that time.
+		float4x4 face_view_projections[6];
+		double3 face_origins[6];
+		
+		/// Pose of the light when its faces were invalidated.
+		double3 position;
+		float3 direction;
+		float outer_cutoff;
+		float range;
+		
+		float importance;
+		unsigned int last_seen;
+		shadow current;
+	};
+	
+	/// Face of a light selected for an update.
+	struct face_update
+	{
+		light_record* record;
+		unsigned int face;
+		
+		/// `false` if the face is outdated, such that it's updated before valid faces.
+		bool valid;
+		float score;
+	};
+	
+	/**
+	 * Allocates a tile of a level, splitting a larger free tile if necessary.
+	 *
+	 * @param level Level of the tile.
+	 * @param[out] result Allocated tile.
+	 * @return `true` if a tile was allocated, `false` if the atlas is full at that level.
+	 */
+	bool allocate_tile(unsigned int level, tile& result) const;
+	
+	/// Frees a tile, merging it with its buddies if they are also free.
+	void free_tile(tile t) const;
+	
+	/// Allocates the tiles of all faces of a light at a level, or none of them.
+	bool allocate_tiles(light_record& record, unsigned int level) const;
+	
+	/// Frees the tiles of a light.
+	void free_tiles(light_record& record) const;
+	
+	/// Frees the tiles of the least important light which is less important than a threshold, returning `false` if there is none.
+	bool evict_light(float importance) const;
+	
+	/// Calculates the camera-relative view-projection matrix of a face of a light.
+	float4x4 calculate_face_view_projection(const render_context& context, const light_record& record, unsigned int face) const;
+	
+	gl::shader_program* unskinned_shader_program;
+	const gl::shader_input* unskinned_model_view_projection_input;
+	
+	gl::shader_program* skinned_shader_program;
+	const gl::shader_input* skinned_model_view_projection_input;
+	
+	unsigned int resolution;
+	unsigned int min_level;
+	unsigned int max_level;
+	std::size_t update_budget;
+	float max_distance;
+	float movement_threshold;
+	float direction_threshold;
+	
+	std::unordered_map<const scene::light*, light_settings> settings;
+	mutable std::unordered_map<const scene::light*, light_record> records;
+	mutable std::vector<std::vector<tile>> free_tile_lists;
+	mutable std::vector<const scene::object_base*> light_objects;
+	mutable std::vector<std::pair<light_record*, unsigned int>> pending_records;
+	mutable std::vector<face_update> updates;
+	mutable std::vector<const render_operation*> casters;
+	mutable culling_stage caster_culling;
+	mutable geom::convex_hull<float> face_volume;
+	mutable std::vector<std::size_t> update_volumes;
+	mutable unsigned int render_index;
+};
+
+#endif // ANTKEEPER_SHADOW_ATLAS_PASS_HPP
@@ -25,18 +25,29 @@
 #include "gl/shader-input.hpp"
 #include "gl/drawing-mode.hpp"
 #include "renderer/render-context.hpp"
+#include "renderer/skinning-stage.hpp"
 #include "renderer/material.hpp"
 #include "renderer/material-flags.hpp"
+#include "renderer/sort-key.hpp"
 #include "scene/camera.hpp"
 #include "scene/light.hpp"
 #include "geom/view-frustum.hpp"
 #include "geom/aabb.hpp"
 #include "configuration.hpp"
+#include "debug/draw.hpp"
 #include "math/math.hpp"
 #include <cmath>
-#include <glad/glad.h>
 
-static bool operation_compare(const render_operation& a, const render_operation& b);
+/// Generates the key by which the shadow map pass sorts a render operation.
+static std::uint64_t generate_sort_key(const render_operation& operation);
+
+/**
+ * Calculates the planes of a light clip volume, on `[-1, 1]` along x and y and `[0, 1]` along z.
+ *
+ * @param view_projection Half-z view-projection matrix of the light.
+ * @param[out] volume Convex hull with six planes.
+ */
+static void calculate_light_clip_volume(const float4x4& view_projection, geom::convex_hull<float>& volume);
 
 void shadow_map_pass::distribute_frustum_splits(float* split_distances, std::size_t split_count, float split_scheme, float near, float far)
 {
@@ -59,15 +70,26 @@ void shadow_map_pass::distribute_frustum_splits(float* split_distances, std::siz
 shadow_map_pass::shadow_map_pass(gl::rasterizer* rasterizer, const gl::framebuffer* framebuffer, resource_manager* resource_manager):
 	render_pass(rasterizer, framebuffer),
 	split_scheme_weight(0.5f),
-	light(nullptr)
+	light(nullptr),
+	cache_direction_threshold(std::cos(0.005f)),
+	cache_crop_threshold(1.0f / 64.0f),
+	render_index(0)
 {
+	// Update all cascades every render by default
+	for (int i = 0; i < 4; ++i)
+	{
+		cascade_update_intervals[i] = 1;
+		cascade_caches[i].valid = false;
+	}
+	
 	// Load skinned shader program
 	unskinned_shader_program = resource_manager->load<gl::shader_program>("depth-unskinned.glsl");
-	unskinned_model_view_projection_input = unskinned_shader_program->get_input("model_view_projection");
+	unskinned_model_view_projection_input = unskinned_shader_program->get_input("model_view_projection"_sid);
 	
 	// Load unskinned shader program
 	skinned_shader_program = resource_manager->load<gl::shader_program>("depth-skinned.glsl");
-	skinned_model_view_projection_input = skinned_shader_program->get_input("model_view_projection");
+	skinned_model_view_projection_input = skinned_shader_program->get_input("model_view_projection"_sid);
+	skinned_shader_program->bind_uniform_block("bone_palette_block"_sid, skinning_stage::bone_palette_binding);
 	
 	// Calculate bias-tile matrices
 	float4x4 bias_matrix = math::translate(math::identity4x4<float>, float3{0.5f, 0.5f, 0.5f}) * math::scale(math::identity4x4<float>, float3{0.5f, 0.5f, 0.5f});
@@ -86,28 +108,33 @@ shadow_map_pass::~shadow_map_pass()
 
 void shadow_map_pass::render(render_context* context) const
 {
-	// Abort if no directional light was set
+	// Clear shadow map and abort if no directional light was set
 	if (!light)
 	{
+		for (int i = 0; i < 4; ++i)
+			cascade_caches[i].valid = false;
+		
+		gl::render_state state = rasterizer->get_render_state();
+		state.depth_write_enabled = true;
+		state.scissor_test_enabled = false;
+		rasterizer->set_render_state(state);
+		rasterizer->use_framebuffer(*framebuffer);
+		rasterizer->set_clear_depth(1.0f);
+		rasterizer->clear_framebuffer(false, true, false);
 		return;
 	}
 	
 	rasterizer->use_framebuffer(*framebuffer);
 	
-	// Disable blending
-	glDisable(GL_BLEND);
-	
-	// Enable depth testing
-	glEnable(GL_DEPTH_TEST);
-	glDepthFunc(GL_LESS);
-	glDepthMask(GL_TRUE);
-	
-	// Disable face culling
-	glEnable(GL_CULL_FACE);
-	glCullFace(GL_FRONT);
+	// Depth test and write, culling front faces
+	gl::render_state state;
+	state.depth_test_enabled = true;
+	state.depth_function = gl::comparison_function::less;
+	state.cull_enabled = true;
+	state.culled_face = gl::cull_face::front;
 	
 	// For half-z buffer
-	//glDepthRange(-1.0f, 1.0f);
+	//state.depth_range_near = -1.0f;
 	
 	// Get camera
 	const scene::camera& camera = *context->camera;
@@ -135,7 +162,7 @@ void shadow_map_pass::render(render_context* context) const
 	}
 	
 	// Calculate a view-projection matrix from the directional light's transform
-	math::transform<float> light_transform = light->get_transform_tween().interpolate(context->alpha);
+	math::transform<float> light_transform = get_relative_transform(*context, *light);
 	float3 forward = light_transform.rotation * global_forward;
 	float3 up = light_transform.rotation * global_up;
 	float4x4 light_view = math::look_at(light_transform.translation, light_transform.translation + forward, up);
@@ -146,20 +173,36 @@ void shadow_map_pass::render(render_context* context) const
 	float4x4 camera_view = camera.get_view_tween().interpolate(context->alpha);	
 	
 	float4x4 crop_matrix;
-	float4x4 cropped_view_projection;
 	float4x4 model_view_projection;
 	
 	// Sort render operations
-	context->operations.sort(operation_compare);
+	context->operations->sort(generate_sort_key);
 	
-	gl::shader_program* active_shader_program = nullptr;
+	// Collect shadow casters and their world-space bounds
+	casters.clear();
+	caster_culling.clear();
+	for (const render_operation& operation: *context->operations)
+	{
+		// Skip materials which don't cast shadows
+		const ::material* material = operation.material;
+		if (material && (material->get_flags() & MATERIAL_FLAG_NOT_SHADOW_CASTER))
+		{
+			continue;
+		}
+		
+		casters.push_back(&operation);
+		
+		// Instanced geometry extends beyond the bounds of its operation
+		if (operation.instance_count)
+			caster_culling.add_unbounded();
+		else
+			caster_culling.add_bounds(operation.bounds);
+	}
+	
+	std::size_t cascade_volumes[4];
 	
 	for (int i = 0; i < 4; ++i)
 	{
-		// Set viewport for this shadow map
-		const float4& viewport = shadow_map_viewports[i];
-		rasterizer->set_viewport(viewport[0], viewport[1], viewport[2], viewport[3]);
-		
 		// Calculate projection matrix for view camera subfrustum
 		const float subfrustum_near = split_distances[i];
 		const float subfrustum_far = split_distances[i + 1];
@@ -207,24 +250,126 @@ void shadow_map_pass::render(render_context* context) const
 		offset.x = std::ceil(offset.x * half_shadow_map_resolution) / half_shadow_map_resolution;
 		offset.y = std::ceil(offset.y * half_shadow_map_resolution) / half_shadow_map_resolution;
 		
+		// Determine whether the cascade should be updated or reused from its cache
+		cascade_cache& cache = cascade_caches[i];
+		const unsigned int interval = cascade_update_intervals[i];
+		bool update = !cache.valid || interval == 1 || (interval && (render_index + i) % interval == 0);
+		if (!update)
+		{
+			// Invalidate cache if the light direction has changed beyond the threshold
+			if (math::dot(forward, cache.light_direction) < cache_direction_threshold)
+			{
+				update = true;
+			}
+			else
+			{
+				// Invalidate cache if the crop has changed beyond the threshold
+				for (int k = 0; k < 3; ++k)
+				{
+					if (std::abs(scale[k] - cache.scale[k]) > cache_crop_threshold * cache.scale[k] ||
+						std::abs(offset[k] - cache.offset[k]) > cache_crop_threshold * 2.0f)
+					{
+						update = true;
+						break;
+					}
+				}
+			}
+		}
+		
+		cascade_updates[i] = update;
+		std::vector<const render_operation*>& cascade = cascade_casters[i];
+		cascade.clear();
+		if (!update)
+		{
+			continue;
+		}
+		
+		cache.valid = true;
+		cache.light_direction = forward;
+		cache.scale = scale;
+		cache.offset = offset;
+		
 		// Crop the light view-projection matrix
 		crop_matrix = math::translate(math::identity4x4<float>, offset) * math::scale(math::identity4x4<float>, scale);
-		cropped_view_projection = crop_matrix * light_view_projection;
+		cropped_view_projections[i] = crop_matrix * light_view_projection;
 		
 		// Calculate shadow matrix
-		shadow_matrices[i] = bias_tile_matrices[i] * cropped_view_projection;
+		shadow_matrices[i] = bias_tile_matrices[i] * cropped_view_projections[i];
+		
+		// Add the cropped light clip volume to the culling stage
+		calculate_light_clip_volume(cropped_view_projections[i], cascade_volume);
+		cascade_volumes[i] = caster_culling.add_volume(cascade_volume);
+	}
+	
+	// Draw the light clip volumes of all cascades, which are relative to the camera origin
+	if (debug::draw::is_enabled(debug::draw::shadow_cascades))
+	{
+		static const float4 cascade_colors[4] =
+		{
+			{1.0f, 0.2f, 0.2f, 1.0f},
+			{0.2f, 1.0f, 0.2f, 1.0f},
+			{0.2f, 0.4f, 1.0f, 1.0f},
+			{1.0f, 1.0f, 0.2f, 1.0f}
+		};
+		
+		const float4x4 relative_to_world = math::translate(math::identity4x4<float>, -math::type_cast<float>(context->camera_origin));
+		for (int i = 0; i < 4; ++i)
+		{
+			if (cascade_caches[i].valid)
+				debug::draw::frustum(cropped_view_projections[i] * relative_to_world, cascade_colors[i]);
+		}
+	}
+	
+	// Cull casters against the cropped light clip volumes of all updated cascades at once
+	caster_culling.cull();
+	for (int i = 0; i < 4; ++i)
+	{
+		if (!cascade_updates[i])
+		{
+			continue;
+		}
 		
-		for (const render_operation& operation: context->operations)
+		std::vector<const render_operation*>& cascade = cascade_casters[i];
+		for (std::size_t j = 0; j < casters.size(); ++j)
 		{
-			// Skip materials which don't cast shadows
-			const ::material* material = operation.material;
-			if (material && (material->get_flags() & MATERIAL_FLAG_NOT_SHADOW_CASTER))
+			if (caster_culling.is_visible(cascade_volumes[i], j))
 			{
-				continue;
+				cascade.push_back(casters[j]);
 			}
-			
+		}
+	}
+	
+	++render_index;
+	
+	gl::shader_program* active_shader_program = nullptr;
+	
+	// Clear only the tiles of updated cascades, preserving cached tiles
+	state.scissor_test_enabled = true;
+	rasterizer->set_render_state(state);
+	rasterizer->set_clear_depth(1.0f);
+	
+	for (int i = 0; i < 4; ++i)
+	{
+		// Skip cached cascades
+		if (!cascade_updates[i])
+		{
+			continue;
+		}
+		
+		// Set viewport for this shadow map
+		const float4& viewport = shadow_map_viewports[i];
+		rasterizer->set_viewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+		
+		// Clear this shadow map
+		rasterizer->set_scissor(viewport[0], viewport[1], viewport[2], viewport[3]);
+		rasterizer->clear_framebuffer(false, true, false);
+		
+		const float4x4& cropped_view_projection = cropped_view_projections[i];
+		
+		for (const render_operation* operation: cascade_casters[i])
+		{
 			// Switch shader programs if necessary
-			gl::shader_program* shader_program = (operation.pose != nullptr) ? skinned_shader_program : unskinned_shader_program;
+			gl::shader_program* shader_program = (operation->pose != nullptr) ? skinned_shader_program : unskinned_shader_program;
 			if (active_shader_program != shader_program)
 			{
 				active_shader_program = shader_program;
@@ -232,7 +377,7 @@ void shadow_map_pass::render(render_context* context) const
 			}
 			
 			// Calculate model-view-projection matrix
-			model_view_projection = cropped_view_projection * operation.transform;
+			model_view_projection = cropped_view_projection * operation->transform;
 			
 			// Upload operation-dependent parameters to shader program
 			if (active_shader_program == unskinned_shader_program)
@@ -242,12 +387,16 @@ void shadow_map_pass::render(render_context* context) const
 			else if (active_shader_program == skinned_shader_program)
 			{
 				skinned_model_view_projection_input->upload(model_view_projection);
+				bind_bone_palette(*context, *operation);
 			}
 
 			// Draw geometry
-			rasterizer->draw_arrays(*operation.vertex_array, operation.drawing_mode, operation.start_index, operation.index_count);
+			draw(*operation);
 		}
 	}
+	
+	state.scissor_test_enabled = false;
+	rasterizer->set_render_state(state);
 }
 
 void shadow_map_pass::set_split_scheme_weight(float weight)
@@ -257,39 +406,46 @@ void shadow_map_pass::set_split_scheme_weight(float weight)
 
 void shadow_map_pass::set_light(const scene::directional_light* light)
 {
+	if (light != this->light)
+		invalidate_cache();
+	
 	this->light = light;
 }
 
-bool operation_compare(const render_operation& a, const render_operation& b)
+void shadow_map_pass::set_cascade_update_interval(std::size_t cascade, unsigned int interval)
+{
+	cascade_update_intervals[cascade] = interval;
+}
+
+void shadow_map_pass::set_cache_thresholds(float direction_threshold, float crop_threshold)
 {
-	// Determine transparency
-	bool skinned_a = (a.pose != nullptr);
-	bool skinned_b = (b.pose != nullptr);
+	cache_direction_threshold = std::cos(direction_threshold);
+	cache_crop_threshold = crop_threshold;
+}
+
+void shadow_map_pass::invalidate_cache()
+{
+	for (int i = 0; i < 4; ++i)
+		cascade_caches[i].valid = false;
+}
+
+void calculate_light_clip_volume(const float4x4& view_projection, geom::convex_hull<float>& volume)
+{
+	const float4x4 transpose = math::transpose(view_projection);
+	volume.planes.resize(6);
+	volume.planes[0] = geom::plane<float>(transpose[3] + transpose[0]);
+	volume.planes[1] = geom::plane<float>(transpose[3] - transpose[0]);
+	volume.planes[2] = geom::plane<float>(transpose[3] + transpose[1]);
+	volume.planes[3] = geom::plane<float>(transpose[3] - transpose[1]);
+	volume.planes[4] = geom::plane<float>(transpose[2]);
+	volume.planes[5] = geom::plane<float>(transpose[3] - transpose[2]);
+}
+
+std::uint64_t generate_sort_key(const render_operation& operation)
+{
+	// Render unskinned operations first, grouped by VAO
+	std::uint64_t key = (operation.pose != nullptr) ? std::uint64_t(1) << 63 : 0;
+	key |= sort_key::hash_pointer(operation.vertex_array, 32);
 	
-	if (skinned_a)
-	{
-		if (skinned_b)
-		{
-			// A and B are both skinned, sort by VAO
-			return (a.vertex_array < b.vertex_array);
-		}
-		else
-		{
-			// A is skinned, B is unskinned. Render B first
-			return false;
-		}
-	}
-	else
-	{
-		if (skinned_b)
-		{
-			// A is unskinned, B is skinned. Render A first
-			return true;
-		}
-		else
-		{
-			// A and B are both unskinned, sort by VAO
-			return (a.vertex_array < b.vertex_array);
-		}
-	}
+	return key;
 }
@@ -25,8 +25,12 @@
 #include "scene/directional-light.hpp"
 #include "gl/shader-program.hpp"
 #include "gl/shader-input.hpp"
+#include "renderer/culling-stage.hpp"
+#include "geom/convex-hull.hpp"
+#include <vector>
 
 class resource_manager;
+struct render_operation;
 
 /**
  *
@@ -47,10 +51,38 @@ public:
 	
 	void set_light(const scene::directional_light* light);
 	
+	/**
+	 * Sets the number of renders between updates of a cascade. Between updates, the cascade's shadow map tile and shadow matrix are reused from its most recent update.
+	 *
+	 * @param cascade Index of a cascade, on `[0, 3]`.
+	 * @param interval Number of renders between updates of the cascade. A value of `1` updates the cascade every render, while a value of `0` updates the cascade only when its cache is invalidated.
+	 */
+	void set_cascade_update_interval(std::size_t cascade, unsigned int interval);
+	
+	/**
+	 * Sets the thresholds beyond which a cached cascade is invalidated and updated regardless of its update interval.
+	 *
+	 * @param direction_threshold Angle, in radians, by which the light direction must change to invalidate the cascade.
+	 * @param crop_threshold Change in the light clip-space scale or offset of the cascade's crop which invalidates the cascade, relative to the size of the cropped volume.
+	 */
+	void set_cache_thresholds(float direction_threshold, float crop_threshold);
+	
+	/// Invalidates all cached cascades, causing them to be updated on the next render.
+	void invalidate_cache();
+	
 	const float4x4* get_shadow_matrices() const;
 	const float* get_split_distances() const;
 
 private:
+	/// Light and crop parameters with which a cascade was most recently rendered.
+	struct cascade_cache
+	{
+		bool valid;
+		float3 light_direction;
+		float3 scale;
+		float3 offset;
+	};
+	
 	/**
 	 * Calculates the distances along the depth axis at which a view-frustum should be split, given a frustum-splitting scheme.
 	 *
@@ -70,9 +102,21 @@ private:
 	
 	mutable float split_distances[5];
 	mutable float4x4 shadow_matrices[4];
+	mutable float4x4 cropped_view_projections[4];
+	mutable std::vector<const render_operation*> casters;
+	mutable culling_stage caster_culling;
+	mutable geom::convex_hull<float> cascade_volume;
+	mutable std::vector<const render_operation*> cascade_casters[4];
 	float4x4 bias_tile_matrices[4];
 	float split_scheme_weight;
 	const scene::directional_light* light;
+	
+	unsigned int cascade_update_intervals[4];
+	float cache_direction_threshold;
+	float cache_crop_threshold;
+	mutable cascade_cache cascade_caches[4];
+	mutable bool cascade_updates[4];
+	mutable unsigned int render_index;
 };
 
 inline const float4x4* shadow_map_pass::get_shadow_matrices() const
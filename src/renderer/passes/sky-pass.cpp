@@ -35,6 +35,7 @@
 #include "renderer/render-context.hpp"
 #include "renderer/model.hpp"
 #include "renderer/material.hpp"
+#include "resources/star-catalog.hpp"
 #include "scene/camera.hpp"
 #include "utility/fundamental-types.hpp"
 #include "color/color.hpp"
@@ -42,13 +43,33 @@
 #include "math/interpolation.hpp"
 #include "geom/cartesian.hpp"
 #include "geom/spherical.hpp"
+#include "geom/view-frustum.hpp"
 #include "physics/orbit/orbit.hpp"
 #include "physics/light/photometry.hpp"
 #include <cmath>
 #include <stdexcept>
-#include <glad/glad.h>
 #include <iostream>
 
+/// Uploads a table of floating-point samples to a texture with linear filtering and clamped edges, creating the texture if necessary. Tables have a single level, which is updated in place if the table has not been resized.
+static void upload_table(gl::texture_2d*& texture, std::size_t columns, std::size_t rows, gl::pixel_format format, const float* data)
+{
+	const int width = static_cast<int>(columns);
+	const int height = static_cast<int>(rows);
+	
+	if (!texture)
+	{
+		texture = new gl::texture_2d(width, height, 1, gl::pixel_type::float_32, format);
+		texture->set_wrapping(gl::texture_wrapping::extend, gl::texture_wrapping::extend);
+		texture->set_filters(gl::texture_min_filter::linear, gl::texture_mag_filter::linear);
+	}
+	else if (texture->get_dimensions()[0] != width || texture->get_dimensions()[1] != height || texture->get_pixel_format() != format)
+	{
+		texture->allocate(width, height, 1, gl::pixel_type::float_32, format, gl::color_space::linear);
+	}
+	
+	texture->update(0, 0, 0, width, height, data);
+}
+
 sky_pass::sky_pass(gl::rasterizer* rasterizer, const gl::framebuffer* framebuffer, resource_manager* resource_manager):
 	render_pass(rasterizer, framebuffer),
 	mouse_position({0.0f, 0.0f}),
@@ -64,6 +85,7 @@ sky_pass::sky_pass(gl::rasterizer* rasterizer, const gl::framebuffer* framebuffe
 	stars_model_vao(nullptr),
 	star_material(nullptr),
 	star_shader_program(nullptr),
+	star_cutoff(1.0f / 1024.0f),
 	clouds_model(nullptr),
 	clouds_model_vao(nullptr),
 	cloud_material(nullptr),
@@ -74,21 +96,33 @@ sky_pass::sky_pass(gl::rasterizer* rasterizer, const gl::framebuffer* framebuffe
 	sun_color_outer_tween(float3{1.0f, 1.0f, 1.0f}, math::lerp<float3, float>),
 	sun_color_inner_tween(float3{1.0f, 1.0f, 1.0f}, math::lerp<float3, float>),
 	topocentric_frame_translation({0, 0, 0}, math::lerp<float3, float>),
-	topocentric_frame_rotation(math::quaternion<float>::identity(), math::nlerp<float>)
+	topocentric_frame_rotation(math::quaternion<float>::identity(), math::nlerp<float>),
+	optical_depth_lut_input(nullptr),
+	multiple_scattering_lut_input(nullptr),
+	sky_view_lut_input(nullptr),
+	optical_depth_table_changed(false),
+	optical_depth_texture(nullptr),
+	multiple_scattering_table_changed(false),
+	multiple_scattering_texture(nullptr),
+	sky_view_table_changed(false),
+	sky_view_texture(nullptr)
 {}
 
 sky_pass::~sky_pass()
-{}
+{
+	delete optical_depth_texture;
+	delete multiple_scattering_texture;
+	delete sky_view_texture;
+}
 
 void sky_pass::render(render_context* context) const
 {
 	rasterizer->use_framebuffer(*framebuffer);
 	
-	glDisable(GL_BLEND);
-	glDisable(GL_DEPTH_TEST);
-	glDepthMask(GL_FALSE);
-	glEnable(GL_CULL_FACE);
-	glCullFace(GL_BACK);
+	gl::render_state state;
+	state.depth_write_enabled = false;
+	state.cull_enabled = true;
+	rasterizer->set_render_state(state);
 
 	auto viewport = framebuffer->get_dimensions();
 	rasterizer->set_viewport(0, 0, std::get<0>(viewport), std::get<1>(viewport));
@@ -126,6 +160,23 @@ void sky_pass::render(render_context* context) const
 	float3 sun_color_outer = sun_color_outer_tween.interpolate(context->alpha);
 	float3 sun_color_inner = sun_color_inner_tween.interpolate(context->alpha);
 	
+	// Upload changed atmosphere tables
+	if (optical_depth_table_changed)
+	{
+		upload_table(optical_depth_texture, optical_depth_table->get_columns(), optical_depth_table->get_rows(), gl::pixel_format::rg, optical_depth_table->get_data().data());
+		optical_depth_table_changed = false;
+	}
+	if (multiple_scattering_table_changed)
+	{
+		upload_table(multiple_scattering_texture, multiple_scattering_table->get_columns(), multiple_scattering_table->get_rows(), gl::pixel_format::rgb, multiple_scattering_table->get_data().data());
+		multiple_scattering_table_changed = false;
+	}
+	if (sky_view_table_changed)
+	{
+		upload_table(sky_view_texture, sky_view_table->get_columns(), sky_view_table->get_rows(), gl::pixel_format::rgb, sky_view_table->get_data().data());
+		sky_view_table_changed = false;
+	}
+	
 	// Draw atmosphere
 	if (sky_model)
 	{
@@ -161,6 +212,12 @@ void sky_pass::render(render_context* context) const
 			mie_anisotropy_input->upload(mie_anisotropy);
 		if (atmosphere_radii_input)
 			atmosphere_radii_input->upload(atmosphere_radii);
+		if (optical_depth_lut_input && optical_depth_texture)
+			optical_depth_lut_input->upload(optical_depth_texture);
+		if (multiple_scattering_lut_input && multiple_scattering_texture)
+			multiple_scattering_lut_input->upload(multiple_scattering_texture);
+		if (sky_view_lut_input && sky_view_texture)
+			sky_view_lut_input->upload(sky_view_texture);
 		
 		sky_material->upload(context->alpha);
 
@@ -188,9 +245,12 @@ void sky_pass::render(render_context* context) const
 		rasterizer->draw_arrays(*clouds_model_vao, clouds_model_drawing_mode, clouds_model_start_index, clouds_model_index_count);
 	}
 	
-	glEnable(GL_BLEND);
-	//glBlendFunc(GL_SRC_ALPHA, GL_ONE);
-	glBlendFunc(GL_ONE, GL_ONE);
+	// Enable additive blending
+	state.blend_enabled = true;
+	//state.blend_source = gl::blend_factor::src_alpha;
+	state.blend_source = gl::blend_factor::one;
+	state.blend_destination = gl::blend_factor::one;
+	rasterizer->set_render_state(state);
 	
 	// Draw stars
 	if (stars_model)
@@ -214,7 +274,42 @@ void sky_pass::render(render_context* context) const
 		
 		star_material->upload(context->alpha);
 		
-		rasterizer->draw_arrays(*stars_model_vao, stars_model_drawing_mode, stars_model_start_index, stars_model_index_count);
+		if (!star_tiling)
+		{
+			rasterizer->draw_arrays(*stars_model_vao, stars_model_drawing_mode, stars_model_start_index, stars_model_index_count);
+		}
+		else
+		{
+			// Cull tiles against the view frustum in the frame of the stars model, in which stars lie on the unit sphere
+			const geom::view_frustum<float> frustum(projection * model_view);
+			const float min_illuminance = star_cutoff / exposure;
+			const float* illuminances = star_tiling->illuminances.data();
+			
+			// Draw the stars of each visible tile down to the minimum illuminance, merging the ranges of consecutive tiles
+			std::size_t range_start = 0;
+			std::size_t range_end = 0;
+			for (const star_tile& tile: star_tiling->tiles)
+			{
+				if (!tile.count || !frustum.get_bounds().intersects(geom::sphere<float>{tile.center, tile.radius}))
+					continue;
+				
+				// Stars are sorted by descending illuminance within each tile
+				const float* first = illuminances + tile.start;
+				const std::size_t count = std::partition_point(first, first + tile.count, [min_illuminance](float e){return e >= min_illuminance;}) - first;
+				if (!count)
+					continue;
+				
+				if (tile.start != range_end)
+				{
+					if (range_end > range_start)
+						rasterizer->draw_arrays(*stars_model_vao, stars_model_drawing_mode, stars_model_start_index + range_start, range_end - range_start);
+					range_start = tile.start;
+				}
+				range_end = tile.start + count;
+			}
+			if (range_end > range_start)
+				rasterizer->draw_arrays(*stars_model_vao, stars_model_drawing_mode, stars_model_start_index + range_start, range_end - range_start);
+		}
 	}
 	
 	// Draw moon model
@@ -235,7 +330,7 @@ void sky_pass::render(render_context* context) const
 		model = math::matrix_cast(moon_transform);		
 		model_view = view * model;
 		model_view_projection = projection * model_view;
-		float3x3 normal_model = math::transpose(math::inverse(math::resize<3, 3>(model)));
+		float3x3 normal_model = math::normal_matrix(moon_transform);
 		
 		rasterizer->use_program(*moon_shader_program);
 		if (moon_model_view_projection_input)
@@ -277,21 +372,24 @@ void sky_pass::set_sky_model(const model* model)
 			
 			if (sky_shader_program)
 			{
-				model_view_projection_input = sky_shader_program->get_input("model_view_projection");
-				mouse_input = sky_shader_program->get_input("mouse");
-				resolution_input = sky_shader_program->get_input("resolution");
-				time_input = sky_shader_program->get_input("time");
-				exposure_input = sky_shader_program->get_input("camera.exposure");
-
-				observer_altitude_input = sky_shader_program->get_input("observer_altitude");
-				sun_direction_input = sky_shader_program->get_input("sun_direction");
-				sun_color_input = sky_shader_program->get_input("sun_color");
-				sun_angular_radius_input = sky_shader_program->get_input("sun_angular_radius");
-				scale_height_rm_input = sky_shader_program->get_input("scale_height_rm");
-				rayleigh_scattering_input = sky_shader_program->get_input("rayleigh_scattering");
-				mie_scattering_input = sky_shader_program->get_input("mie_scattering");
-				mie_anisotropy_input = sky_shader_program->get_input("mie_anisotropy");
-				atmosphere_radii_input = sky_shader_program->get_input("atmosphere_radii");
+				model_view_projection_input = sky_shader_program->get_input("model_view_projection"_sid);
+				mouse_input = sky_shader_program->get_input("mouse"_sid);
+				resolution_input = sky_shader_program->get_input("resolution"_sid);
+				time_input = sky_shader_program->get_input("time"_sid);
+				exposure_input = sky_shader_program->get_input("camera.exposure"_sid);
+
+				observer_altitude_input = sky_shader_program->get_input("observer_altitude"_sid);
+				sun_direction_input = sky_shader_program->get_input("sun_direction"_sid);
+				sun_color_input = sky_shader_program->get_input("sun_color"_sid);
+				sun_angular_radius_input = sky_shader_program->get_input("sun_angular_radius"_sid);
+				scale_height_rm_input = sky_shader_program->get_input("scale_height_rm"_sid);
+				rayleigh_scattering_input = sky_shader_program->get_input("rayleigh_scattering"_sid);
+				mie_scattering_input = sky_shader_program->get_input("mie_scattering"_sid);
+				mie_anisotropy_input = sky_shader_program->get_input("mie_anisotropy"_sid);
+				atmosphere_radii_input = sky_shader_program->get_input("atmosphere_radii"_sid);
+				optical_depth_lut_input = sky_shader_program->get_input("optical_depth_lut"_sid);
+				multiple_scattering_lut_input = sky_shader_program->get_input("multiple_scattering_lut"_sid);
+				sky_view_lut_input = sky_shader_program->get_input("sky_view_lut"_sid);
 			}
 		}
 	}
@@ -324,10 +422,10 @@ void sky_pass::set_moon_model(const model* model)
 			
 			if (moon_shader_program)
 			{
-				moon_model_view_projection_input = moon_shader_program->get_input("model_view_projection");
-				moon_normal_model_input = moon_shader_program->get_input("normal_model");
-				moon_moon_position_input = moon_shader_program->get_input("moon_position");
-				moon_sun_position_input = moon_shader_program->get_input("sun_position");
+				moon_model_view_projection_input = moon_shader_program->get_input("model_view_projection"_sid);
+				moon_normal_model_input = moon_shader_program->get_input("normal_model"_sid);
+				moon_moon_position_input = moon_shader_program->get_input("moon_position"_sid);
+				moon_sun_position_input = moon_shader_program->get_input("sun_position"_sid);
 			}
 		}
 	}
@@ -360,10 +458,10 @@ void sky_pass::set_stars_model(const model* model)
 			
 			if (star_shader_program)
 			{
-				star_model_view_input = star_shader_program->get_input("model_view");
-				star_projection_input = star_shader_program->get_input("projection");
-				star_distance_input = star_shader_program->get_input("star_distance");
-				star_exposure_input = star_shader_program->get_input("camera.exposure");
+				star_model_view_input = star_shader_program->get_input("model_view"_sid);
+				star_projection_input = star_shader_program->get_input("projection"_sid);
+				star_distance_input = star_shader_program->get_input("star_distance"_sid);
+				star_exposure_input = star_shader_program->get_input("camera.exposure"_sid);
 			}
 		}
 	}
@@ -373,6 +471,16 @@ void sky_pass::set_stars_model(const model* model)
 	}
 }
 
+void sky_pass::set_star_tiling(std::shared_ptr<const ::star_tiling> tiling)
+{
+	star_tiling = std::move(tiling);
+}
+
+void sky_pass::set_star_cutoff(float cutoff)
+{
+	star_cutoff = cutoff;
+}
+
 void sky_pass::set_clouds_model(const model* model)
 {
 	clouds_model = model;
@@ -396,11 +504,11 @@ void sky_pass::set_clouds_model(const model* model)
 			
 			if (cloud_shader_program)
 			{
-				cloud_model_view_projection_input = cloud_shader_program->get_input("model_view_projection");
-				cloud_sun_direction_input = cloud_shader_program->get_input("sun_direction");
-				cloud_sun_color_input = cloud_shader_program->get_input("sun_color");
-				cloud_camera_position_input = cloud_shader_program->get_input("camera.position");
-				cloud_camera_exposure_input = cloud_shader_program->get_input("camera.exposure");
+				cloud_model_view_projection_input = cloud_shader_program->get_input("model_view_projection"_sid);
+				cloud_sun_direction_input = cloud_shader_program->get_input("sun_direction"_sid);
+				cloud_sun_color_input = cloud_shader_program->get_input("sun_color"_sid);
+				cloud_camera_position_input = cloud_shader_program->get_input("camera.position"_sid);
+				cloud_camera_exposure_input = cloud_shader_program->get_input("camera.exposure"_sid);
 			}
 		}
 	}
@@ -475,6 +583,33 @@ void sky_pass::set_atmosphere_radii(float inner, float outer)
 	atmosphere_radii.z = outer * outer;
 }
 
+void sky_pass::set_optical_depth_table(std::shared_ptr<const physics::atmosphere::optical_depth_table<float>> table)
+{
+	if (table && table != optical_depth_table)
+	{
+		optical_depth_table = std::move(table);
+		optical_depth_table_changed = true;
+	}
+}
+
+void sky_pass::set_multiple_scattering_table(std::shared_ptr<const physics::atmosphere::multiple_scattering_table<float>> table)
+{
+	if (table && table != multiple_scattering_table)
+	{
+		multiple_scattering_table = std::move(table);
+		multiple_scattering_table_changed = true;
+	}
+}
+
+void sky_pass::set_sky_view_table(std::shared_ptr<const physics::atmosphere::sky_view_table<float>> table)
+{
+	if (table && table != sky_view_table)
+	{
+		sky_view_table = std::move(table);
+		sky_view_table_changed = true;
+	}
+}
+
 void sky_pass::handle_event(const mouse_moved_event& event)
 {
 	mouse_position = {static_cast<float>(event.x), static_cast<float>(event.y)};
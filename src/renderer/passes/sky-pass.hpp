@@ -33,11 +33,14 @@
 #include "gl/texture-2d.hpp"
 #include "gl/drawing-mode.hpp"
 #include "physics/frame.hpp"
+#include "physics/atmosphere.hpp"
 #include "scene/object.hpp"
+#include <memory>
 
 class resource_manager;
 class model;
 class material;
+struct star_tiling;
 
 /**
  *
@@ -56,6 +59,20 @@ public:
 	void set_time_tween(const tween<double>* time);
 	void set_moon_model(const model* model);
 	void set_stars_model(const model* model);
+	
+	/**
+	 * Sets the tiles of the stars model, so that only the stars of tiles in view, which are brighter than the star cutoff, are drawn.
+	 *
+	 * @param tiling Tiling of the stars in the vertex order of the stars model, or `nullptr` to draw every star.
+	 */
+	void set_star_tiling(std::shared_ptr<const ::star_tiling> tiling);
+	
+	/**
+	 * Sets the exposed illuminance below which stars are not drawn, as they would not be visible.
+	 *
+	 * @param cutoff Exposed illuminance of the dimmest drawn stars.
+	 */
+	void set_star_cutoff(float cutoff);
 	void set_clouds_model(const model* model);
 	
 	void set_topocentric_frame(const physics::frame<float>& frame);
@@ -68,6 +85,33 @@ public:
 	void set_scattering_coefficients(const float3& r, const float3& m);
 	void set_mie_anisotropy(float g);
 	void set_atmosphere_radii(float inner, float outer);
+	
+	/**
+	 * Sets the table of atmospheric optical depths, which is uploaded to the `optical_depth_lut` texture of the sky shader as Rayleigh (red) and Mie (green) optical depths, by altitude (t) and zenith angle (s).
+	 *
+	 * @param table Optical depth table, or `nullptr` to keep the most recently uploaded table.
+	 *
+	 * @see physics::atmosphere::optical_depth_table
+	 */
+	void set_optical_depth_table(std::shared_ptr<const physics::atmosphere::optical_depth_table<float>> table);
+	
+	/**
+	 * Sets the table of multiple scattering contributions, which is uploaded to the `multiple_scattering_lut` texture of the sky shader, by altitude (t) and sun zenith angle (s).
+	 *
+	 * @param table Multiple scattering table, or `nullptr` to keep the most recently uploaded table.
+	 *
+	 * @see physics::atmosphere::multiple_scattering_table
+	 */
+	void set_multiple_scattering_table(std::shared_ptr<const physics::atmosphere::multiple_scattering_table<float>> table);
+	
+	/**
+	 * Sets the table of sky luminance around the observer, which is uploaded to the `sky_view_lut` texture of the sky shader, by elevation (t) and azimuth from the sun (s), so that the sky dome need only sample it rather than integrate scattering per pixel. Sky luminance is per unit of sun illuminance, and should be scaled by the outer sun color.
+	 *
+	 * @param table Sky view table, or `nullptr` to keep the most recently uploaded table.
+	 *
+	 * @see physics::atmosphere::sky_view_table
+	 */
+	void set_sky_view_table(std::shared_ptr<const physics::atmosphere::sky_view_table<float>> table);
 
 private:
 	virtual void handle_event(const mouse_moved_event& event);
@@ -87,6 +131,9 @@ private:
 	const gl::shader_input* mie_scattering_input;
 	const gl::shader_input* mie_anisotropy_input;
 	const gl::shader_input* atmosphere_radii_input;
+	const gl::shader_input* optical_depth_lut_input;
+	const gl::shader_input* multiple_scattering_lut_input;
+	const gl::shader_input* sky_view_lut_input;
 	
 	gl::shader_program* moon_shader_program;
 	const gl::shader_input* moon_model_view_projection_input;
@@ -119,6 +166,8 @@ private:
 	const gl::shader_input* star_projection_input;
 	const gl::shader_input* star_exposure_input;
 	const gl::shader_input* star_distance_input;
+	std::shared_ptr<const ::star_tiling> star_tiling;
+	float star_cutoff;
 	
 	const model* clouds_model;
 	const material* cloud_material;
@@ -153,6 +202,16 @@ private:
 	float3 mie_scattering;
 	float2 mie_anisotropy;
 	float3 atmosphere_radii;
+	
+	std::shared_ptr<const physics::atmosphere::optical_depth_table<float>> optical_depth_table;
+	mutable bool optical_depth_table_changed;
+	mutable gl::texture_2d* optical_depth_texture;
+	std::shared_ptr<const physics::atmosphere::multiple_scattering_table<float>> multiple_scattering_table;
+	mutable bool multiple_scattering_table_changed;
+	mutable gl::texture_2d* multiple_scattering_texture;
+	std::shared_ptr<const physics::atmosphere::sky_view_table<float>> sky_view_table;
+	mutable bool sky_view_table_changed;
+	mutable gl::texture_2d* sky_view_texture;
 };
 
 #endif // ANTKEEPER_SKY_PASS_HPP
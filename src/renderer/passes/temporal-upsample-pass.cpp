@@ -0,0 +1,343 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "renderer/passes/temporal-upsample-pass.hpp"
+#include "renderer/passes/final-pass.hpp"
+#include "resources/resource-manager.hpp"
+#include "gl/rasterizer.hpp"
+#include "gl/framebuffer.hpp"
+#include "gl/shader-program.hpp"
+#include "gl/shader-input.hpp"
+#include "gl/vertex-buffer.hpp"
+#include "gl/vertex-array.hpp"
+#include "gl/vertex-attribute-type.hpp"
+#include "gl/drawing-mode.hpp"
+#include "gl/texture-2d.hpp"
+#include "gl/texture-wrapping.hpp"
+#include "gl/texture-filter.hpp"
+#include "renderer/vertex-attributes.hpp"
+#include "renderer/render-context.hpp"
+#include "renderer/render-operation.hpp"
+#include "renderer/skinning-stage.hpp"
+#include "renderer/material.hpp"
+#include "renderer/material-flags.hpp"
+#include "scene/camera.hpp"
+#include "math/math.hpp"
+#include <cstring>
+
+/// Returns the element of the Halton sequence with the given base at an index, on `[0, 1)`.
+static float halton(std::size_t index, std::size_t base)
+{
+	float result = 0.0f;
+	float fraction = 1.0f;
+	while (index)
+	{
+		fraction /= static_cast<float>(base);
+		result += fraction * static_cast<float>(index % base);
+		index /= base;
+	}
+	return result;
+}
+
+/// Translates the clip space of a projection matrix by an offset in normalized device coordinates.
+static void offset_projection(float4x4& projection, const float2& offset)
+{
+	for (int i = 0; i < 4; ++i)
+	{
+		projection[i][0] += offset.x * projection[i][3];
+		projection[i][1] += offset.y * projection[i][3];
+	}
+}
+
+temporal_upsample_pass::temporal_upsample_pass(gl::rasterizer* rasterizer, const gl::framebuffer* framebuffer, resource_manager* resource_manager):
+	render_pass(rasterizer, framebuffer),
+	output_pass(nullptr),
+	history_weight(0.9f),
+	history_index(0),
+	history_valid(false),
+	jitter_index(0),
+	previous_camera(nullptr),
+	previous_view_projection(math::identity4x4<float>),
+	previous_camera_origin{0.0, 0.0, 0.0}
+{
+	resolve_program = resource_manager->load<gl::shader_program>("temporal-upsample.glsl");
+	if (resolve_program)
+	{
+		color_texture_input = resolve_program->get_input("color_texture"_sid);
+		depth_texture_input = resolve_program->get_input("depth_texture"_sid);
+		motion_texture_input = resolve_program->get_input("motion_texture"_sid);
+		history_texture_input = resolve_program->get_input("history_texture"_sid);
+		reprojection_input = resolve_program->get_input("reprojection"_sid);
+		jitter_input = resolve_program->get_input("jitter"_sid);
+		source_resolution_input = resolve_program->get_input("source_resolution"_sid);
+		resolution_input = resolve_program->get_input("resolution"_sid);
+		history_weight_input = resolve_program->get_input("history_weight"_sid);
+	}
+	
+	// Without motion vector programs, only camera motion is reprojected
+	unskinned_motion_program = resource_manager->load<gl::shader_program>("motion-vector-unskinned.glsl");
+	if (unskinned_motion_program)
+	{
+		unskinned_model_view_projection_input = unskinned_motion_program->get_input("model_view_projection"_sid);
+		unskinned_previous_model_view_projection_input = unskinned_motion_program->get_input("previous_model_view_projection"_sid);
+		unskinned_stationary_model_view_projection_input = unskinned_motion_program->get_input("stationary_model_view_projection"_sid);
+	}
+	
+	skinned_motion_program = resource_manager->load<gl::shader_program>("motion-vector-skinned.glsl");
+	if (skinned_motion_program)
+	{
+		skinned_model_view_projection_input = skinned_motion_program->get_input("model_view_projection"_sid);
+		skinned_previous_model_view_projection_input = skinned_motion_program->get_input("previous_model_view_projection"_sid);
+		skinned_stationary_model_view_projection_input = skinned_motion_program->get_input("stationary_model_view_projection"_sid);
+		skinned_motion_program->bind_uniform_block("bone_palette_block"_sid, skinning_stage::bone_palette_binding);
+	}
+	
+	const float vertex_data[] =
+	{
+		-1.0f,  1.0f, 0.0f,
+		-1.0f, -1.0f, 0.0f,
+		 1.0f,  1.0f, 0.0f,
+		 1.0f,  1.0f, 0.0f,
+		-1.0f, -1.0f, 0.0f,
+		 1.0f, -1.0f, 0.0f
+	};
+
+	std::size_t vertex_size = 3;
+	std::size_t vertex_stride = sizeof(float) * vertex_size;
+	std::size_t vertex_count = 6;
+
+	quad_vbo = new gl::vertex_buffer(sizeof(float) * vertex_size * vertex_count, vertex_data);
+	quad_vao = new gl::vertex_array();
+	quad_vao->bind_attribute(VERTEX_POSITION_LOCATION, *quad_vbo, 3, gl::vertex_attribute_type::float_32, vertex_stride, 0);
+	
+	// Allocate the history at the output resolution
+	const std::array<int, 2>& dimensions = rasterizer->get_default_framebuffer().get_dimensions();
+	for (std::size_t i = 0; i < 2; ++i)
+	{
+		history_textures[i] = new gl::texture_2d(dimensions[0], dimensions[1], gl::pixel_type::float_16, gl::pixel_format::rgba);
+		history_textures[i]->set_wrapping(gl::texture_wrapping::extend, gl::texture_wrapping::extend);
+		history_textures[i]->set_filters(gl::texture_min_filter::linear, gl::texture_mag_filter::linear);
+		history_textures[i]->set_max_anisotropy(0.0f);
+		history_framebuffers[i] = new gl::framebuffer(dimensions[0], dimensions[1]);
+		history_framebuffers[i]->attach(gl::framebuffer_attachment_type::color, history_textures[i]);
+	}
+	
+	// Share the depth of the render target, which is only tested while motion is drawn
+	const std::array<int, 2>& source_dimensions = framebuffer->get_dimensions();
+	motion_texture = new gl::texture_2d(source_dimensions[0], source_dimensions[1], gl::pixel_type::float_16, gl::pixel_format::rg);
+	motion_texture->set_wrapping(gl::texture_wrapping::extend, gl::texture_wrapping::extend);
+	motion_texture->set_filters(gl::texture_min_filter::nearest, gl::texture_mag_filter::nearest);
+	motion_framebuffer = new gl::framebuffer(source_dimensions[0], source_dimensions[1]);
+	motion_framebuffer->attach(gl::framebuffer_attachment_type::color, motion_texture);
+	motion_framebuffer->attach(gl::framebuffer_attachment_type::depth, const_cast<gl::texture_2d*>(framebuffer->get_depth_attachment()));
+}
+
+temporal_upsample_pass::~temporal_upsample_pass()
+{
+	delete motion_framebuffer;
+	delete motion_texture;
+	for (std::size_t i = 0; i < 2; ++i)
+	{
+		delete history_framebuffers[i];
+		delete history_textures[i];
+	}
+	delete quad_vao;
+	delete quad_vbo;
+}
+
+void temporal_upsample_pass::render(render_context* context) const
+{
+	if (!resolve_program || !output_pass)
+		return;
+	
+	const scene::camera& camera = *context->camera;
+	
+	// Match the history to the output resolution, and the motion target to the render target, which may have been rescaled
+	const std::array<int, 2>& source_dimensions = framebuffer->get_dimensions();
+	const std::array<int, 2>& dimensions = output_pass->get_framebuffer()->get_dimensions();
+	bool resized = false;
+	for (std::size_t i = 0; i < 2; ++i)
+		resized = match_dimensions(history_framebuffers[i], history_textures[i], dimensions) || resized;
+	match_dimensions(motion_framebuffer, motion_texture, source_dimensions);
+	
+	// Calculate the view-projection matrix of the camera with and without jitter
+	float4x4 projection = camera.get_projection_tween().interpolate(context->alpha);
+	const float4x4 view = camera.get_view_tween().interpolate(context->alpha);
+	const float4x4 jittered_view_projection = projection * view;
+	const float2& jitter = camera.get_jitter();
+	offset_projection(projection, -jitter);
+	const float4x4 view_projection = projection * view;
+	
+	// Move the previous view-projection matrix into the frame of the current camera origin
+	const float3 origin_offset = math::type_cast<float>(context->camera_origin - previous_camera_origin);
+	const float4x4 stationary_view_projection = previous_view_projection * math::translate(math::identity4x4<float>, origin_offset);
+	
+	// Discard a history which was resized, or accumulated by another camera
+	const bool valid = history_valid && !resized && previous_camera == &camera;
+	
+	render_motion(*context, jittered_view_projection, stationary_view_projection, valid);
+	
+	// Blend the current frame into the reprojected history of the previous frame
+	const std::size_t source_index = history_index;
+	const std::size_t target_index = (history_index + 1) % 2;
+	rasterizer->use_framebuffer(*history_framebuffers[target_index]);
+	rasterizer->set_viewport(0, 0, dimensions[0], dimensions[1]);
+	
+	gl::render_state state;
+	state.depth_write_enabled = false;
+	state.cull_enabled = true;
+	rasterizer->set_render_state(state);
+	
+	rasterizer->use_program(*resolve_program);
+	if (color_texture_input)
+		color_texture_input->upload(framebuffer->get_color_attachment());
+	if (depth_texture_input)
+		depth_texture_input->upload(framebuffer->get_depth_attachment());
+	if (motion_texture_input)
+		motion_texture_input->upload(motion_texture);
+	if (history_texture_input)
+		history_texture_input->upload(history_textures[source_index]);
+	if (reprojection_input)
+		reprojection_input->upload(stationary_view_projection * math::inverse(view_projection));
+	if (jitter_input)
+		jitter_input->upload(jitter * 0.5f);
+	if (source_resolution_input)
+		source_resolution_input->upload(float2{static_cast<float>(source_dimensions[0]), static_cast<float>(source_dimensions[1])});
+	if (resolution_input)
+		resolution_input->upload(float2{static_cast<float>(dimensions[0]), static_cast<float>(dimensions[1])});
+	if (history_weight_input)
+		history_weight_input->upload((valid) ? history_weight : 0.0f);
+	
+	rasterizer->draw_arrays(*quad_vao, gl::drawing_mode::triangles, 0, 6);
+	
+	// Present the history, and keep the camera state by which it will be reprojected
+	history_index = target_index;
+	output_pass->set_color_texture(history_textures[history_index]);
+	history_valid = true;
+	previous_camera = &camera;
+	previous_view_projection = view_projection;
+	previous_camera_origin = context->camera_origin;
+	++jitter_index;
+}
+
+void temporal_upsample_pass::set_final_pass(final_pass* pass)
+{
+	output_pass = pass;
+}
+
+void temporal_upsample_pass::set_history_weight(float weight)
+{
+	history_weight = weight;
+}
+
+void temporal_upsample_pass::jitter(scene::camera& camera) const
+{
+	if (!resolve_program)
+	{
+		camera.set_jitter({0.0f, 0.0f});
+		return;
+	}
+	
+	// Offset by up to half a pixel of the render target, following the Halton (2, 3) sequence
+	const std::size_t index = jitter_index % jitter_sample_count + 1;
+	const std::array<int, 2>& dimensions = framebuffer->get_dimensions();
+	camera.set_jitter
+	({
+		(halton(index, 2) - 0.5f) * 2.0f / static_cast<float>(dimensions[0]),
+		(halton(index, 3) - 0.5f) * 2.0f / static_cast<float>(dimensions[1])
+	});
+}
+
+void temporal_upsample_pass::reset_history()
+{
+	history_valid = false;
+}
+
+bool temporal_upsample_pass::match_dimensions(gl::framebuffer* framebuffer, gl::texture_2d* texture, const std::array<int, 2>& dimensions)
+{
+	if (framebuffer->get_dimensions() == dimensions)
+		return false;
+	
+	texture->resize(dimensions[0], dimensions[1], texture->get_pixel_type(), texture->get_pixel_format(), texture->get_color_space(), nullptr);
+	framebuffer->resize(dimensions);
+	return true;
+}
+
+void temporal_upsample_pass::render_motion(const render_context& context, const float4x4& view_projection, const float4x4& stationary_view_projection, bool valid) const
+{
+	rasterizer->use_framebuffer(*motion_framebuffer);
+	rasterizer->set_viewport(0, 0, std::get<0>(motion_framebuffer->get_dimensions()), std::get<1>(motion_framebuffer->get_dimensions()));
+	
+	// Clear to zero offset, so that pixels without moving operations are reprojected by camera motion alone
+	gl::render_state state;
+	state.depth_write_enabled = false;
+	rasterizer->set_render_state(state);
+	rasterizer->set_clear_color(0.0f, 0.0f, 0.0f, 0.0f);
+	rasterizer->clear_framebuffer(true, false, false);
+	
+	if (!valid || !unskinned_motion_program)
+		return;
+	
+	// Draw only the fragments of the moving operations which are visible in the render target
+	state.depth_test_enabled = true;
+	state.depth_function = gl::comparison_function::greater_equal;
+	state.cull_enabled = true;
+	rasterizer->set_render_state(state);
+	
+	const gl::shader_program* active_program = nullptr;
+	for (const render_operation& operation: *context.operations)
+	{
+		// Skip stationary, occluded, and translucent operations
+		if (!std::memcmp(&operation.transform, &operation.previous_transform, sizeof(float4x4)) || operation.occluded)
+			continue;
+		if (operation.material && (operation.material->get_flags() & (MATERIAL_FLAG_TRANSLUCENT | MATERIAL_FLAG_X_RAY)))
+			continue;
+		
+		// Skinned operations are skipped if there is no skinned program
+		const bool skinned = (operation.pose != nullptr);
+		const gl::shader_program* program = (skinned) ? skinned_motion_program : unskinned_motion_program;
+		if (!program)
+			continue;
+		if (program != active_program)
+		{
+			active_program = program;
+			rasterizer->use_program(*active_program);
+		}
+		
+		const float4x4 model_view_projection = view_projection * operation.transform;
+		const float4x4 previous_model_view_projection = previous_view_projection * operation.previous_transform;
+		const float4x4 stationary_model_view_projection = stationary_view_projection * operation.transform;
+		if (skinned)
+		{
+			skinned_model_view_projection_input->upload(model_view_projection);
+			skinned_previous_model_view_projection_input->upload(previous_model_view_projection);
+			skinned_stationary_model_view_projection_input->upload(stationary_model_view_projection);
+			bind_bone_palette(context, operation);
+		}
+		else
+		{
+			unskinned_model_view_projection_input->upload(model_view_projection);
+			unskinned_previous_model_view_projection_input->upload(previous_model_view_projection);
+			unskinned_stationary_model_view_projection_input->upload(stationary_model_view_projection);
+		}
+		
+		draw(operation);
+	}
+}
@@ -0,0 +1,169 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef ANTKEEPER_TEMPORAL_UPSAMPLE_PASS_HPP
+#define ANTKEEPER_TEMPORAL_UPSAMPLE_PASS_HPP
+
+#include "renderer/render-pass.hpp"
+#include "utility/fundamental-types.hpp"
+#include "gl/shader-program.hpp"
+#include "gl/shader-input.hpp"
+#include "gl/vertex-buffer.hpp"
+#include "gl/vertex-array.hpp"
+#include "gl/texture-2d.hpp"
+#include <array>
+#include <cstddef>
+
+class resource_manager;
+class final_pass;
+
+namespace scene
+{
+	class camera;
+}
+
+/**
+ * Accumulates the jittered frames of a render target, rendered below the output resolution, into a history at the output resolution, then passes the history to the final pass.
+ *
+ * Each output pixel reprojects the history of the previous frame by the depth of the render target and the previous and current view-projection matrices of the camera, which accounts for camera motion. The motion of moving objects is added to it from a motion target, into which the operations whose transforms differ from their previous transforms are drawn by the `motion-vector-unskinned.glsl` and `motion-vector-skinned.glsl` shader programs, with the following inputs:
+ *
+ * * `model_view_projection`: current model-view-projection matrix.
+ * * `previous_model_view_projection`: previous view-projection matrix multiplied by the previous transform.
+ * * `stationary_model_view_projection`: previous view-projection matrix multiplied by the current transform.
+ *
+ * Each should write half the difference between the normalized device coordinates projected by the previous and stationary matrices, which is the offset of the history in texture coordinates beyond the camera's reprojection. The motion of skinned vertices within their poses is not tracked. The `temporal-upsample.glsl` shader program then blends the current frame into the reprojected history, clamped to the neighborhood of the current frame, with the following inputs:
+ *
+ * * `color_texture`, `depth_texture`: color and depth attachments of the render target.
+ * * `motion_texture`: history offsets of moving objects.
+ * * `history_texture`: history of the previous frame.
+ * * `reprojection`: matrix which maps the normalized device coordinates of the current frame to the clip space of the previous frame.
+ * * `jitter`: jitter of the current frame, in texture coordinates.
+ * * `source_resolution`, `resolution`: dimensions of the render target and of the history.
+ * * `history_weight`: weight of the history, which is `0` when the history is invalid.
+ *
+ * Should follow the passes which render into the render target, and precede the final pass.
+ */
+class temporal_upsample_pass: public render_pass
+{
+public:
+	/// Number of subpixel offsets in the jitter sequence.
+	static constexpr std::size_t jitter_sample_count = 16;
+	
+	/**
+	 * Creates a temporal upsample pass.
+	 *
+	 * @param rasterizer Rasterizer.
+	 * @param framebuffer Render target to be upsampled, with color and depth attachments.
+	 * @param resource_manager Resource manager from which shader programs are loaded.
+	 */
+	temporal_upsample_pass(gl::rasterizer* rasterizer, const gl::framebuffer* framebuffer, resource_manager* resource_manager);
+	virtual ~temporal_upsample_pass();
+	virtual void render(render_context* context) const final;
+	
+	/**
+	 * Sets the final pass, whose color texture is set to the history after each render.
+	 *
+	 * @param pass Final pass.
+	 */
+	void set_final_pass(final_pass* pass);
+	
+	/**
+	 * Sets the weight of the history at which the current frame is blended, where the history is valid.
+	 *
+	 * @param weight History weight, on `[0, 1)`.
+	 */
+	void set_history_weight(float weight);
+	
+	/**
+	 * Offsets the projection of a camera by the next jitter of the sequence, scaled to the current resolution of the render target. Should be called once per frame, before the camera is rendered.
+	 *
+	 * @param camera Camera to be jittered.
+	 */
+	void jitter(scene::camera& camera) const;
+	
+	/// Discards the history, such as after a camera cut, so that the next render is not blended with it.
+	void reset_history();
+	
+	/// Returns `true` if the shader programs of the pass were loaded.
+	bool is_valid() const;
+
+private:
+	/// Matches the dimensions of a framebuffer and its color attachment to the given dimensions, returning `true` if they were resized.
+	static bool match_dimensions(gl::framebuffer* framebuffer, gl::texture_2d* texture, const std::array<int, 2>& dimensions);
+	
+	/**
+	 * Clears the motion target, then draws the history offsets of the moving operations into it.
+	 *
+	 * @param context Render context.
+	 * @param view_projection Jittered view-projection matrix of the current frame.
+	 * @param stationary_view_projection View-projection matrix of the previous frame, in the frame of the current camera origin.
+	 * @param valid `false` if the history is invalid, in which case operations are not drawn.
+	 */
+	void render_motion(const render_context& context, const float4x4& view_projection, const float4x4& stationary_view_projection, bool valid) const;
+	
+	gl::shader_program* resolve_program;
+	const gl::shader_input* color_texture_input;
+	const gl::shader_input* depth_texture_input;
+	const gl::shader_input* motion_texture_input;
+	const gl::shader_input* history_texture_input;
+	const gl::shader_input* reprojection_input;
+	const gl::shader_input* jitter_input;
+	const gl::shader_input* source_resolution_input;
+	const gl::shader_input* resolution_input;
+	const gl::shader_input* history_weight_input;
+	
+	gl::shader_program* unskinned_motion_program;
+	const gl::shader_input* unskinned_model_view_projection_input;
+	const gl::shader_input* unskinned_previous_model_view_projection_input;
+	const gl::shader_input* unskinned_stationary_model_view_projection_input;
+	
+	gl::shader_program* skinned_motion_program;
+	const gl::shader_input* skinned_model_view_projection_input;
+	const gl::shader_input* skinned_previous_model_view_projection_input;
+	const gl::shader_input* skinned_stationary_model_view_projection_input;
+	
+	gl::vertex_buffer* quad_vbo;
+	gl::vertex_array* quad_vao;
+	
+	gl::texture_2d* motion_texture;
+	gl::framebuffer* motion_framebuffer;
+	gl::texture_2d* history_textures[2];
+	gl::framebuffer* history_framebuffers[2];
+	
+	final_pass* output_pass;
+	float history_weight;
+	
+	/// Index of the history written by the most recent render.
+	mutable std::size_t history_index;
+	mutable bool history_valid;
+	mutable std::size_t jitter_index;
+	
+	/// Camera, view-projection matrix without jitter, and camera origin of the most recent render, by which the history is reprojected.
+	mutable const scene::camera* previous_camera;
+	mutable float4x4 previous_view_projection;
+	mutable double3 previous_camera_origin;
+};
+
+inline bool temporal_upsample_pass::is_valid() const
+{
+	return resolve_program != nullptr;
+}
+
+#endif // ANTKEEPER_TEMPORAL_UPSAMPLE_PASS_HPP
@@ -17,6 +17,7 @@
  * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+
 #include "renderer/passes/ui-pass.hpp"
 #include "resources/resource-manager.hpp"
 #include "gl/rasterizer.hpp"
@@ -33,49 +34,232 @@
 #include "renderer/vertex-attributes.hpp"
 #include "renderer/material-flags.hpp"
 #include "renderer/render-context.hpp"
+#include "renderer/texture-streamer.hpp"
 #include "scene/camera.hpp"
 #include "scene/collection.hpp"
-#include "scene/ambient-light.hpp"
-#include "scene/directional-light.hpp"
 #include "scene/billboard.hpp"
+#include "scene/text.hpp"
+#include "geom/projection.hpp"
 #include "math/math.hpp"
+#include <algorithm>
 #include <cmath>
-#include <glad/glad.h>
+
+/// Position, texture coordinates, and barycentric coordinates of the six vertices of a billboard quad, matching the billboard VAO.
+static constexpr float quad_vertex_data[] =
+{
+	-1.0f,  1.0f, 0.0f, 0.0f, 1.0f, 1.0f, 0.0f, 0.0f,
+	-1.0f, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f,
+	 1.0f,  1.0f, 0.0f, 1.0f, 1.0f, 0.0f, 0.0f, 1.0f,
+	 1.0f,  1.0f, 0.0f, 1.0f, 1.0f, 1.0f, 0.0f, 0.0f,
+	-1.0f, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f,
+	 1.0f, -1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f
+};
+
+/// Returns `true` if an active scene object intersects the view frustum of the camera.
+static bool is_visible(const render_context& context, const scene::object_base& object)
+{
+	if (!object.is_active())
+		return false;
+	
+	const geom::bounding_volume<float>* object_culling_volume = object.get_culling_mask();
+	if (!object_culling_volume)
+		object_culling_volume = &object.get_bounds();
+	
+	return context.camera_culling_volume->intersects(*object_culling_volume);
+}
 
 ui_pass::ui_pass(gl::rasterizer* rasterizer, const gl::framebuffer* framebuffer, resource_manager* resource_manager):
 	render_pass(rasterizer, framebuffer),
-	time(0.0f)
-{}
+	time_tween(nullptr),
+	texture_streamer(nullptr),
+	draw_count(0)
+{
+	const std::size_t vertex_stride = sizeof(float) * vertex_size;
+	
+	vbo = new gl::vertex_buffer(0, nullptr, gl::buffer_usage::stream_draw);
+	vao = new gl::vertex_array();
+	vao->bind_attribute(VERTEX_POSITION_LOCATION, *vbo, 3, gl::vertex_attribute_type::float_32, vertex_stride, 0);
+	vao->bind_attribute(VERTEX_TEXCOORD_LOCATION, *vbo, 2, gl::vertex_attribute_type::float_32, vertex_stride, sizeof(float) * 3);
+	vao->bind_attribute(VERTEX_BARYCENTRIC_LOCATION, *vbo, 3, gl::vertex_attribute_type::float_32, vertex_stride, sizeof(float) * 5);
+}
 
 ui_pass::~ui_pass()
-{}
+{
+	delete vao;
+	delete vbo;
+	
+	for (auto it = parameter_sets.begin(); it != parameter_sets.end(); ++it)
+		delete it->second;
+}
 
 void ui_pass::render(render_context* context) const
 {
-	glEnable(GL_BLEND);
-	glDisable(GL_DEPTH_TEST);
-	glDepthMask(GL_FALSE);
-	glCullFace(GL_BACK);
+	rasterizer->use_framebuffer(*framebuffer);
+	
+	gl::render_state state;
+	state.blend_enabled = true;
+	state.blend_source = gl::blend_factor::src_alpha;
+	state.blend_destination = gl::blend_factor::one_minus_src_alpha;
+	state.depth_write_enabled = false;
+	state.cull_enabled = true;
+	rasterizer->set_render_state(state);
 
 	auto viewport = framebuffer->get_dimensions();
 	rasterizer->set_viewport(0, 0, std::get<0>(viewport), std::get<1>(viewport));
-
+	
+	float time = (time_tween) ? time_tween->interpolate(context->alpha) : 0.0f;
 	float4x4 view = context->camera->get_view_tween().interpolate(context->alpha);
 	float4x4 projection = context->camera->get_projection_tween().interpolate(context->alpha);
 	float4x4 view_projection = projection * view;
-	float4x4 model_view_projection;
 	
-	// Collect billboards
-	std::list<scene::object_base*> billboards = *context->collection->get_objects(scene::billboard::object_type_id);
+	// Collect visible billboards
+	elements.clear();
+	const std::size_t quad_vertex_count = sizeof(quad_vertex_data) / (sizeof(float) * vertex_size);
+	for (const scene::object_base* object: *context->collection->get_objects(scene::billboard::object_type_id))
+	{
+		const scene::billboard* billboard = static_cast<const scene::billboard*>(object);
+		if (!billboard->get_material() || !is_visible(*context, *billboard))
+			continue;
+		
+		ui_element& element = elements.emplace_back();
+		element.material = billboard->get_material();
+		element.transform = get_relative_transform(*context, *billboard);
+		element.depth = context->clip_near.signed_distance(element.transform.translation);
+		element.vertices = quad_vertex_data;
+		element.vertex_count = quad_vertex_count;
+		
+		// Align billboard
+		if (billboard->get_billboard_type() == scene::billboard_type::spherical)
+		{
+			element.transform.rotation = math::normalize(context->billboard_rotation * element.transform.rotation);
+		}
+		else if (billboard->get_billboard_type() == scene::billboard_type::cylindrical)
+		{
+			const float3& alignment_axis = billboard->get_alignment_axis();
+			float3 look = math::normalize(geom::project_on_plane(element.transform.translation - context->camera_transform.translation, {0.0f, 0.0f, 0.0f}, alignment_axis));
+			float3 right = math::normalize(math::cross(alignment_axis, look));
+			look = math::cross(right, alignment_axis);
+			float3 up = math::cross(look, right);
+			element.transform.rotation = math::normalize(math::look_rotation(look, up) * element.transform.rotation);
+		}
+	}
+	
+	// Collect visible text, whose glyph quads were laid out when its layout was set
+	for (const scene::object_base* object: *context->collection->get_objects(scene::text::object_type_id))
+	{
+		const scene::text* text = static_cast<const scene::text*>(object);
+		const type::text_layout* layout = text->get_layout();
+		if (!text->get_material() || !layout || layout->vertices.empty() || !is_visible(*context, *text))
+			continue;
+		
+		ui_element& element = elements.emplace_back();
+		element.material = text->get_material();
+		element.transform = get_relative_transform(*context, *text);
+		element.depth = context->clip_near.signed_distance(element.transform.translation);
+		element.vertices = layout->vertices.data();
+		element.vertex_count = layout->vertices.size() / vertex_size;
+	}
 	
-	// Sort billboards
+	draw_count = 0;
+	if (elements.empty())
+		return;
 	
-	// Rebuild vertex buffer
+	// Sort elements back to front, grouping elements at equal depths by material. Stable sorting preserves the scene order of overlapping elements which share a material.
+	std::stable_sort(elements.begin(), elements.end(),
+		[](const ui_element& a, const ui_element& b)
+		{
+			if (a.depth != b.depth)
+				return a.depth > b.depth;
+			return a.material < b.material;
+		});
+	
+	// Transform the vertices of all elements into a single vertex stream
+	std::size_t vertex_count = 0;
+	for (const ui_element& element: elements)
+		vertex_count += element.vertex_count;
+	vertex_data.resize(vertex_count * vertex_size);
+	float* v = vertex_data.data();
+	for (const ui_element& element: elements)
+	{
+		for (std::size_t i = 0; i < element.vertex_count; ++i)
+		{
+			const float* vertex = element.vertices + i * vertex_size;
+			const float3 position = element.transform * float3{vertex[0], vertex[1], vertex[2]};
+			*(v++) = position.x;
+			*(v++) = position.y;
+			*(v++) = position.z;
+			v = std::copy(vertex + 3, vertex + vertex_size, v);
+		}
+	}
+	
+	// Orphan the previous frame's vertex data rather than waiting for it to be drawn
+	vbo->resize(vertex_data.size() * sizeof(float), vertex_data.data());
+	
+	// Draw each run of elements which share a material
+	const float pixel_scale = projection[1][1] * static_cast<float>(std::get<1>(viewport)) * 0.5f;
+	const gl::shader_program* active_shader_program = nullptr;
+	const parameter_set* parameters = nullptr;
+	std::size_t first_vertex = 0;
+	for (std::size_t i = 0; i < elements.size();)
+	{
+		const ::material* material = elements[i].material;
+		
+		// Find the end of the run, its number of vertices, and the largest size of its billboards
+		std::size_t run_end = i;
+		std::size_t run_vertex_count = 0;
+		float footprint = 0.0f;
+		for (; run_end < elements.size() && elements[run_end].material == material; ++run_end)
+		{
+			const ui_element& element = elements[run_end];
+			run_vertex_count += element.vertex_count;
+			if (element.vertices == quad_vertex_data)
+				footprint = std::max(footprint, 2.0f * std::max(std::abs(element.transform.scale.x), std::abs(element.transform.scale.y)));
+		}
+		
+		// Report the largest projected size of the run's billboards, assuming an orthographic UI camera
+		if (texture_streamer && footprint > 0.0f)
+			texture_streamer->add_usage(material, footprint * pixel_scale);
+		
+		// Switch shaders if necessary
+		const gl::shader_program* shader_program = material->get_shader_program();
+		if (shader_program)
+		{
+			if (active_shader_program != shader_program)
+			{
+				active_shader_program = shader_program;
+				rasterizer->use_program(*shader_program);
+				
+				// Load or create the set of shader parameters
+				if (auto it = parameter_sets.find(shader_program); it != parameter_sets.end())
+					parameters = it->second;
+				else
+					parameters = load_parameter_set(shader_program);
+				
+				if (parameters->time)
+					parameters->time->upload(time);
+				if (parameters->model_view_projection)
+					parameters->model_view_projection->upload(view_projection);
+			}
+			
+			material->upload(context->alpha);
+			
+			rasterizer->draw_arrays(*vao, gl::drawing_mode::triangles, first_vertex, run_vertex_count);
+			++draw_count;
+		}
+		
+		first_vertex += run_vertex_count;
+		i = run_end;
+	}
+}
+
+void ui_pass::set_time_tween(const tween<double>* time)
+{
+	this->time_tween = time;
 }
 
-void ui_pass::set_time(float time)
+void ui_pass::set_texture_streamer(::texture_streamer* streamer)
 {
-	this->time = time;
+	texture_streamer = streamer;
 }
 
 const ui_pass::parameter_set* ui_pass::load_parameter_set(const gl::shader_program* program) const
@@ -84,8 +268,8 @@ const ui_pass::parameter_set* ui_pass::load_parameter_set(const gl::shader_progr
 	parameter_set* parameters = new parameter_set();
 
 	// Connect inputs
-	parameters->time = program->get_input("time");
-	parameters->model_view_projection = program->get_input("model_view_projection");
+	parameters->time = program->get_input("time"_sid);
+	parameters->model_view_projection = program->get_input("model_view_projection"_sid);
 
 	// Add parameter set to map of parameter sets
 	parameter_sets[program] = parameters;
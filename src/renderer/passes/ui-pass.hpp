@@ -17,20 +17,38 @@
  * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+
 #ifndef ANTKEEPER_UI_PASS_HPP
 #define ANTKEEPER_UI_PASS_HPP
 
 #include "renderer/render-pass.hpp"
 #include "renderer/material.hpp"
+#include "animation/tween.hpp"
 #include "gl/shader-program.hpp"
 #include "gl/shader-input.hpp"
 #include "gl/texture-2d.hpp"
+#include "gl/vertex-buffer.hpp"
+#include "gl/vertex-array.hpp"
+#include "math/transform-type.hpp"
+#include "type/text-layout.hpp"
+#include "utility/fundamental-types.hpp"
 #include <unordered_map>
+#include <vector>
 
 class resource_manager;
+class texture_streamer;
+
+namespace scene
+{
+	class billboard;
+}
 
 /**
+ * Renders the billboards and text of a UI scene in a handful of draw calls.
+ *
+ * Each render, the quads of all visible billboards, and the cached glyph quads of all visible text, are transformed on the CPU and written into a single streaming vertex buffer, back to front, with elements at equal depths grouped by material. Each run of elements which share a material is then drawn by a single draw call, so the number of draw calls depends on the number of materials rather than the number of UI elements. UI elements which should be drawn together should therefore share a material, with their images packed into one texture, as the glyphs of a font are packed into its atlas.
  *
+ * Shader programs receive the view-projection matrix of the camera as `model_view_projection`, as quads are already in world space, along with `time`.
  */
 class ui_pass: public render_pass
 {
@@ -38,8 +56,21 @@ public:
 	ui_pass(gl::rasterizer* rasterizer, const gl::framebuffer* framebuffer, resource_manager* resource_manager);
 	virtual ~ui_pass();
 	virtual void render(render_context* context) const final;
-
-	void set_time(float time);
+	
+	void set_time_tween(const tween<double>* time);
+	
+	/**
+	 * Sets the texture streamer to which the screen-space footprints of drawn materials are reported.
+	 *
+	 * @param streamer Texture streamer, or `nullptr` to report nothing.
+	 */
+	void set_texture_streamer(::texture_streamer* streamer);
+	
+	/// Returns the number of billboards and text objects drawn by the most recent render.
+	std::size_t get_element_count() const;
+	
+	/// Returns the number of draw calls issued by the most recent render.
+	std::size_t get_draw_count() const;
 
 private:
 	/**
@@ -50,12 +81,45 @@ private:
 		const gl::shader_input* time;
 		const gl::shader_input* model_view_projection;
 	};
+	
+	/// Visible billboard or text, with its camera-aligned transform.
+	struct ui_element
+	{
+		const ::material* material;
+		float depth;
+		math::transform<float> transform;
+		
+		/// Untransformed vertices of the element.
+		const float* vertices;
+		std::size_t vertex_count;
+	};
 
 	const parameter_set* load_parameter_set(const gl::shader_program* program) const;
 
 	mutable std::unordered_map<const gl::shader_program*, parameter_set*> parameter_sets;
-	float time;
+	const tween<double>* time_tween;
+	::texture_streamer* texture_streamer;
+	
+	/// Number of floats per vertex: position, texture coordinates, and barycentric coordinates.
+	static constexpr std::size_t vertex_size = type::text_layout::vertex_size;
+	
+	gl::vertex_buffer* vbo;
+	gl::vertex_array* vao;
+	
+	/// Elements and vertex data of the most recent render, reused across renders.
+	mutable std::vector<ui_element> elements;
+	mutable std::vector<float> vertex_data;
+	mutable std::size_t draw_count;
 };
 
-#endif // ANTKEEPER_UI_PASS_HPP
+inline std::size_t ui_pass::get_element_count() const
+{
+	return elements.size();
+}
 
+inline std::size_t ui_pass::get_draw_count() const
+{
+	return draw_count;
+}
+
+#endif // ANTKEEPER_UI_PASS_HPP
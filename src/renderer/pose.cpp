@@ -0,0 +1,60 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "renderer/pose.hpp"
+#include "renderer/skeleton.hpp"
+#include "math/math.hpp"
+
+pose::pose(const ::skeleton* skeleton):
+	skeleton(skeleton)
+{
+	reset();
+}
+
+void pose::set_transform(std::size_t bone, const math::transform<float>& transform)
+{
+	transforms[bone] = transform;
+}
+
+void pose::reset()
+{
+	const std::size_t bone_count = skeleton->get_bone_count();
+	transforms.resize(bone_count);
+	for (std::size_t i = 0; i < bone_count; ++i)
+		transforms[i] = skeleton->get_bind_transform(i);
+}
+
+void pose::evaluate(float4x4* palette) const
+{
+	const std::size_t bone_count = transforms.size();
+	
+	// Accumulate model-space bone transforms, as parents precede their children
+	for (std::size_t i = 0; i < bone_count; ++i)
+	{
+		palette[i] = math::matrix_cast(transforms[i]);
+		
+		const std::uint16_t parent = skeleton->get_parent(i);
+		if (parent != skeleton::no_parent)
+			palette[i] = palette[parent] * palette[i];
+	}
+	
+	// Transform from the bind pose into bone space before transforming into the pose
+	for (std::size_t i = 0; i < bone_count; ++i)
+		palette[i] = palette[i] * skeleton->get_inverse_bind_matrix(i);
+}
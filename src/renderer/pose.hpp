@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ANTKEEPER_POSE_HPP
+#define ANTKEEPER_POSE_HPP
+
+#include "math/transform-type.hpp"
+#include "utility/fundamental-types.hpp"
+#include <cstddef>
+#include <vector>
+
+class skeleton;
+
+/**
+ * Transforms of the bones of a skeleton, from which the bone palette of skinned geometry is evaluated.
+ */
+class pose
+{
+public:
+	/**
+	 * Creates a pose in the bind pose of a skeleton.
+	 *
+	 * @param skeleton Skeleton of the pose, which must outlive the pose.
+	 */
+	explicit pose(const ::skeleton* skeleton);
+	
+	/**
+	 * Sets the transform of a bone, relative to its parent.
+	 *
+	 * @param bone Index of the bone.
+	 * @param transform Transform of the bone.
+	 */
+	void set_transform(std::size_t bone, const math::transform<float>& transform);
+	
+	/// Resets the transforms of all bones to those of the bind pose.
+	void reset();
+	
+	/**
+	 * Evaluates the bone palette of the pose: for each bone, the matrix which transforms vertices from the bind pose to the pose, in model space. Safe to call concurrently for different palettes.
+	 *
+	 * @param[out] palette Array of one matrix per bone of the skeleton.
+	 */
+	void evaluate(float4x4* palette) const;
+	
+	/// Returns the transform of a bone, relative to its parent.
+	const math::transform<float>& get_transform(std::size_t bone) const;
+	
+	/// Returns the skeleton of the pose.
+	const ::skeleton* get_skeleton() const;
+	
+	/// Returns the number of bones in the pose.
+	std::size_t get_bone_count() const;
+	
+private:
+	const ::skeleton* skeleton;
+	std::vector<math::transform<float>> transforms;
+};
+
+inline const math::transform<float>& pose::get_transform(std::size_t bone) const
+{
+	return transforms[bone];
+}
+
+inline const ::skeleton* pose::get_skeleton() const
+{
+	return skeleton;
+}
+
+inline std::size_t pose::get_bone_count() const
+{
+	return transforms.size();
+}
+
+#endif // ANTKEEPER_POSE_HPP
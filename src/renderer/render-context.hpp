@@ -21,26 +21,81 @@
 #define ANTKEEPER_RENDER_CONTEXT_HPP
 
 #include "renderer/render-operation.hpp"
+#include "renderer/render-queue.hpp"
 #include "geom/plane.hpp"
+#include "geom/aabb.hpp"
 #include "geom/bounding-volume.hpp"
+#include "geom/packed-hull.hpp"
 #include "utility/fundamental-types.hpp"
 #include "scene/camera.hpp"
 #include "scene/collection.hpp"
-#include <list>
+
+class occlusion_buffer;
+
+namespace gl
+{
+	class uniform_buffer;
+}
 
 struct render_context
 {
 	const scene::camera* camera;
 	math::transform<float> camera_transform;
+	
+	/// Interpolated origin of the camera. Render operations are generated relative to it, so camera transforms and render operation transforms need only single precision.
+	double3 camera_origin;
+	
 	float3 camera_forward;
 	float3 camera_up;
+	
+	/// Rotation which faces spherical billboards toward the camera, computed once per camera rather than once per billboard.
+	math::quaternion<float> billboard_rotation;
 	const geom::bounding_volume<float>* camera_culling_volume;
+	
+	/// Packed planes of the camera culling volume, or `nullptr` if it is not convex.
+	const geom::packed_hull<float>* camera_culling_planes;
 	geom::plane<float> clip_near;
 	
 	const scene::collection* collection;
-	std::list<render_operation> operations;
+	
+	/// Queue of render operations generated for the camera. Storage is owned by the renderer and reused across cameras and frames.
+	render_queue* operations;
+	
+	/// Uniform buffer containing the bone palettes of the posed operations, or `nullptr` if there are none.
+	const gl::uniform_buffer* bone_palettes;
+	
+	/// Occlusion buffer of the camera, or `nullptr` if the camera is not occlusion culled.
+	const occlusion_buffer* occlusion;
+	
 	float alpha;
 };
 
+/**
+ * Returns the interpolated transform of a scene object relative to the origin of the camera of a render context. The origins are subtracted in double precision.
+ *
+ * @param context Render context.
+ * @param object Scene object.
+ * @return Camera-relative transform of the object.
+ */
+inline math::transform<float> get_relative_transform(const render_context& context, const scene::object_base& object)
+{
+	math::transform<float> transform = object.get_interpolated_transform();
+	transform.translation += math::type_cast<float>(object.get_interpolated_origin() - context.camera_origin);
+	return transform;
+}
+
+/**
+ * Moves world-space bounds into the frame of the camera origin of a render context.
+ *
+ * @param context Render context.
+ * @param bounds World-space bounds.
+ * @return Camera-relative bounds.
+ */
+inline geom::aabb<float> get_relative_bounds(const render_context& context, const geom::aabb<float>& bounds)
+{
+	const float3 offset = math::type_cast<float>(context.camera_origin);
+	return {bounds.min_point - offset, bounds.max_point - offset};
+}
+
 #endif // ANTKEEPER_RENDER_CONTEXT_HPP
 
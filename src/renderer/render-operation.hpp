@@ -23,6 +23,9 @@
 #include "utility/fundamental-types.hpp"
 #include "gl/vertex-array.hpp"
 #include "gl/drawing-mode.hpp"
+#include "gl/element-array-type.hpp"
+#include "geom/aabb.hpp"
+#include <cstdint>
 #include <cstdlib>
 
 class pose;
@@ -34,14 +37,43 @@ class material;
 struct render_operation
 {
 	const pose* pose;
+	
+	/// Offset of the bone palette of the pose in the bone palette buffer of the render context, in bytes, if the operation has a pose.
+	std::size_t bone_palette_offset;
+	
 	const material* material;
 	const gl::vertex_array* vertex_array;
 	gl::drawing_mode drawing_mode;
 	std::size_t start_index;
 	std::size_t index_count;
 	float4x4 transform;
+	
+	/// Transform of the operation in the previous frame, relative to the camera origin of the previous frame, from which motion vectors are derived. Equal to the transform if the operation did not move, or was not rendered in the previous frame.
+	float4x4 previous_transform;
+	
+	/// Inverse transpose of the upper 3x3 of the transform, by which normals are transformed.
+	float3x3 normal_transform;
+	
 	float depth;
 	std::size_t instance_count;
+	
+	/// `true` if the start index and index count refer to elements of the element buffer bound to the vertex array, rather than to vertices.
+	bool indexed;
+	
+	/// Type of the elements, if the operation is indexed.
+	gl::element_array_type element_type;
+	
+	/// Bounds of the operation's geometry, relative to the camera origin, used for shadow caster culling.
+	geom::aabb<float> bounds;
+	
+	/// `true` if the operation's geometry is hidden from the camera by the occlusion buffer, in which case it is drawn only by passes which do not render from the camera's point of view, such as shadow map passes.
+	bool occluded;
+	
+	/// ID written by the picking pass, or `0` if the operation's geometry is not pickable.
+	std::uint32_t pick_id;
+	
+	/// Precomputed key by which the material pass sorts render operations.
+	std::uint64_t sort_key;
 };
 
 #endif // ANTKEEPER_RENDER_OPERATION_HPP
@@ -18,11 +18,17 @@
  */
 
 #include "renderer/render-pass.hpp"
+#include "renderer/render-operation.hpp"
+#include "renderer/render-context.hpp"
+#include "renderer/skinning-stage.hpp"
+#include "renderer/pose.hpp"
+#include <cstring>
 
 render_pass::render_pass(gl::rasterizer* rasterizer, const gl::framebuffer* framebuffer):
 	rasterizer(rasterizer),
 	framebuffer(framebuffer),
-	enabled(true)
+	enabled(true),
+	side_effects(false)
 {}
 
 render_pass::~render_pass()
@@ -33,3 +39,88 @@ void render_pass::set_enabled(bool enabled)
 	this->enabled = enabled;
 }
 
+void render_pass::set_name(const std::string& name)
+{
+	this->name = name;
+}
+
+void render_pass::set_input(std::size_t slot, const gl::texture_2d* texture)
+{
+	if (inputs.size() <= slot)
+		inputs.resize(slot + 1, nullptr);
+	inputs[slot] = texture;
+}
+
+void render_pass::set_side_effects(bool side_effects)
+{
+	this->side_effects = side_effects;
+}
+
+void render_pass::draw(const render_operation& operation, std::size_t instance_count) const
+{
+	if (operation.indexed)
+	{
+		// Convert start index to a byte offset into the element buffer
+		static constexpr std::size_t element_sizes[] = {1, 2, 4};
+		const std::size_t offset = operation.start_index * element_sizes[static_cast<std::size_t>(operation.element_type)];
+		
+		if (instance_count)
+			rasterizer->draw_elements_instanced(*operation.vertex_array, operation.drawing_mode, offset, operation.index_count, operation.element_type, instance_count);
+		else
+			rasterizer->draw_elements(*operation.vertex_array, operation.drawing_mode, offset, operation.index_count, operation.element_type);
+	}
+	else
+	{
+		if (instance_count)
+			rasterizer->draw_arrays_instanced(*operation.vertex_array, operation.drawing_mode, operation.start_index, operation.index_count, instance_count);
+		else
+			rasterizer->draw_arrays(*operation.vertex_array, operation.drawing_mode, operation.start_index, operation.index_count);
+	}
+}
+
+void render_pass::multi_draw(const render_operation* operations, std::size_t count) const
+{
+	const render_operation& first = operations[0];
+	
+	multi_draw_offsets.resize(count);
+	multi_draw_counts.resize(count);
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		multi_draw_offsets[i] = operations[i].start_index;
+		multi_draw_counts[i] = operations[i].index_count;
+	}
+	
+	if (first.indexed)
+	{
+		// Convert start indices to byte offsets into the element buffer
+		static constexpr std::size_t element_sizes[] = {1, 2, 4};
+		const std::size_t element_size = element_sizes[static_cast<std::size_t>(first.element_type)];
+		for (std::size_t& offset: multi_draw_offsets)
+			offset *= element_size;
+		
+		rasterizer->multi_draw_elements(*first.vertex_array, first.drawing_mode, multi_draw_offsets.data(), multi_draw_counts.data(), first.element_type, count);
+	}
+	else
+	{
+		rasterizer->multi_draw_arrays(*first.vertex_array, first.drawing_mode, multi_draw_offsets.data(), multi_draw_counts.data(), count);
+	}
+}
+
+bool render_pass::is_mergeable(const render_operation& a, const render_operation& b)
+{
+	return
+		!a.pose && !b.pose &&
+		!a.instance_count && !b.instance_count &&
+		a.material == b.material &&
+		a.vertex_array == b.vertex_array &&
+		a.drawing_mode == b.drawing_mode &&
+		a.indexed == b.indexed &&
+		(!a.indexed || a.element_type == b.element_type) &&
+		!std::memcmp(&a.transform, &b.transform, sizeof(a.transform));
+}
+
+void render_pass::bind_bone_palette(const render_context& context, const render_operation& operation) const
+{
+	if (context.bone_palettes && operation.pose)
+		rasterizer->bind_uniform_buffer_range(*context.bone_palettes, skinning_stage::bone_palette_binding, operation.bone_palette_offset, skinning_stage::get_palette_size(*operation.pose));
+}
@@ -22,11 +22,17 @@
 
 #include "gl/rasterizer.hpp"
 #include "gl/framebuffer.hpp"
+#include <cstdlib>
+#include <string>
+#include <vector>
 
 struct render_context;
+struct render_operation;
 
 /**
+ * Renders into a framebuffer.
  *
+ * Passes declare the textures they sample which may be written by other passes, and whether their results are consumed outside of the compositor, by which the compositor culls passes whose outputs are unused.
  */
 class render_pass
 {
@@ -38,13 +44,76 @@ public:
 
 	void set_enabled(bool enabled);
 	bool is_enabled() const;
+	
+	/// Sets the name by which the pass is identified in profiling results.
+	void set_name(const std::string& name);
+	
+	/// Returns the name of the pass.
+	const std::string& get_name() const;
+	
+	/// Returns the framebuffer into which the pass renders, or `nullptr` if the pass renders into a framebuffer of its own.
+	const gl::framebuffer* get_framebuffer() const;
+	
+	/// Returns the textures sampled by the pass which may be written by other passes. Unset inputs are `nullptr`.
+	const std::vector<const gl::texture_2d*>& get_inputs() const;
+	
+	/// Returns `true` if the results of the pass are consumed outside of the compositor, such as by CPU readbacks, so that the pass must not be culled.
+	bool has_side_effects() const;
 
 protected:
+	/**
+	 * Draws the geometry of a render operation, with indexed or non-indexed draw calls as required by the operation.
+	 *
+	 * @param operation Render operation to draw.
+	 * @param instance_count Number of instances to draw, or `0` for a non-instanced draw call.
+	 */
+	void draw(const render_operation& operation, std::size_t instance_count = 0) const;
+	
+	/**
+	 * Draws the geometry of consecutive render operations which share a vertex array, drawing mode, and element type with a single multi-draw call. The operation-dependent state of the first operation applies to all of them.
+	 *
+	 * @param operations Render operations to draw.
+	 * @param count Number of render operations.
+	 */
+	void multi_draw(const render_operation* operations, std::size_t count) const;
+	
+	/**
+	 * Returns `true` if two render operations draw ranges of the same geometry with the same material, transform, and draw state, differing at most in their ranges, such that they can be drawn with a single multi-draw call. Posed and explicitly instanced operations are never mergeable.
+	 */
+	static bool is_mergeable(const render_operation& a, const render_operation& b);
+	
+	/**
+	 * Binds the range of the bone palette buffer of a render context which contains the bone palette of a posed render operation to skinning_stage::bone_palette_binding.
+	 *
+	 * @param context Render context.
+	 * @param operation Posed render operation.
+	 */
+	void bind_bone_palette(const render_context& context, const render_operation& operation) const;
+	
+	/**
+	 * Declares a texture sampled by the pass.
+	 *
+	 * @param slot Index of the input, by which an input can be replaced.
+	 * @param texture Sampled texture, or `nullptr` if the input is unset.
+	 */
+	void set_input(std::size_t slot, const gl::texture_2d* texture);
+	
+	/// Declares whether the results of the pass are consumed outside of the compositor.
+	void set_side_effects(bool side_effects);
+	
 	gl::rasterizer* rasterizer;
 	const gl::framebuffer* framebuffer;
 
 private:
+	/// Ranges of the most recent multi-draw call.
+	mutable std::vector<std::size_t> multi_draw_offsets;
+	mutable std::vector<std::size_t> multi_draw_counts;
+	
+
 	bool enabled;
+	std::string name;
+	std::vector<const gl::texture_2d*> inputs;
+	bool side_effects;
 };
 
 inline bool render_pass::is_enabled() const
@@ -52,5 +121,25 @@ inline bool render_pass::is_enabled() const
 	return enabled;
 }
 
+inline const std::string& render_pass::get_name() const
+{
+	return name;
+}
+
+inline const gl::framebuffer* render_pass::get_framebuffer() const
+{
+	return framebuffer;
+}
+
+inline const std::vector<const gl::texture_2d*>& render_pass::get_inputs() const
+{
+	return inputs;
+}
+
+inline bool render_pass::has_side_effects() const
+{
+	return side_effects;
+}
+
 #endif // ANTKEEPER_RENDER_PASS_HPP
 
@@ -0,0 +1,109 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "renderer/render-queue.hpp"
+#include <algorithm>
+
+void render_queue::sort()
+{
+	if (count < 2)
+		return;
+	
+	keys.resize(count);
+	for (std::size_t i = 0; i < count; ++i)
+		keys[i] = storage[i].sort_key;
+	
+	radix_sort();
+}
+
+void render_queue::sort(std::uint64_t (*key)(const render_operation&))
+{
+	if (count < 2)
+		return;
+	
+	keys.resize(count);
+	for (std::size_t i = 0; i < count; ++i)
+		keys[i] = key(storage[i]);
+	
+	radix_sort();
+}
+
+void render_queue::radix_sort()
+{
+	static constexpr std::size_t radix_bits = 8;
+	static constexpr std::size_t radix_size = 1 << radix_bits;
+	static constexpr std::size_t digit_count = 64 / radix_bits;
+	
+	key_buffer.resize(count);
+	indices.resize(count);
+	index_buffer.resize(count);
+	for (std::size_t i = 0; i < count; ++i)
+		indices[i] = static_cast<std::uint32_t>(i);
+	
+	// Build histograms of all digits in a single pass
+	std::size_t histograms[digit_count][radix_size] = {};
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		std::uint64_t key = keys[i];
+		for (std::size_t d = 0; d < digit_count; ++d)
+			++histograms[d][(key >> (d * radix_bits)) & (radix_size - 1)];
+	}
+	
+	std::uint64_t* src_keys = keys.data();
+	std::uint64_t* dst_keys = key_buffer.data();
+	std::uint32_t* src_indices = indices.data();
+	std::uint32_t* dst_indices = index_buffer.data();
+	
+	for (std::size_t d = 0; d < digit_count; ++d)
+	{
+		std::size_t* histogram = histograms[d];
+		const std::size_t shift = d * radix_bits;
+		
+		// Skip digits which are identical across all keys
+		if (histogram[(src_keys[0] >> shift) & (radix_size - 1)] == count)
+			continue;
+		
+		// Convert digit counts to offsets
+		std::size_t offset = 0;
+		for (std::size_t j = 0; j < radix_size; ++j)
+		{
+			std::size_t bucket_size = histogram[j];
+			histogram[j] = offset;
+			offset += bucket_size;
+		}
+		
+		// Scatter keys and indices according to digit
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			std::size_t destination = histogram[(src_keys[i] >> shift) & (radix_size - 1)]++;
+			dst_keys[destination] = src_keys[i];
+			dst_indices[destination] = src_indices[i];
+		}
+		
+		std::swap(src_keys, dst_keys);
+		std::swap(src_indices, dst_indices);
+	}
+	
+	// Gather render operations into sorted order
+	if (sort_buffer.size() < storage.size())
+		sort_buffer.resize(storage.size());
+	for (std::size_t i = 0; i < count; ++i)
+		sort_buffer[i] = storage[src_indices[i]];
+	storage.swap(sort_buffer);
+}
@@ -0,0 +1,179 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ANTKEEPER_RENDER_QUEUE_HPP
+#define ANTKEEPER_RENDER_QUEUE_HPP
+
+#include "renderer/render-operation.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Contiguous, linear-arena queue of render operations.
+ *
+ * Clearing the queue resets its size without releasing storage, so a single queue can be reused across cameras and frames without allocating once its capacity has grown to fit the scene.
+ */
+class render_queue
+{
+public:
+	typedef render_operation* iterator;
+	typedef const render_operation* const_iterator;
+
+	/// Creates an empty render queue.
+	render_queue();
+
+	/**
+	 * Allocates a render operation at the end of the queue.
+	 *
+	 * @return Reference to the allocated render operation. References are invalidated by subsequent allocations.
+	 */
+	render_operation& allocate();
+
+	/**
+	 * Copies a render operation to the end of the queue.
+	 *
+	 * @param operation Render operation to copy.
+	 */
+	void push_back(const render_operation& operation);
+
+	/**
+	 * Reserves storage for at least @p capacity render operations.
+	 *
+	 * @param capacity Number of render operations for which storage should be reserved.
+	 */
+	void reserve(std::size_t capacity);
+
+	/// Removes all render operations from the queue while retaining its storage.
+	void clear();
+	
+	/**
+	 * Sorts the render operations in ascending order of their precomputed sort keys.
+	 *
+	 * @see render_operation::sort_key
+	 */
+	void sort();
+	
+	/**
+	 * Sorts the render operations in ascending order of keys generated by a function. The function is called exactly once per render operation, allowing each render pass to choose its own key layout.
+	 *
+	 * @param key Function which generates a 64-bit sort key for a render operation.
+	 */
+	void sort(std::uint64_t (*key)(const render_operation&));
+
+	/// Returns the number of render operations in the queue.
+	std::size_t size() const;
+
+	/// Returns the number of render operations the queue can hold before its storage must grow.
+	std::size_t capacity() const;
+
+	/// Returns `true` if the queue contains no render operations.
+	bool empty() const;
+
+	/// Returns a pointer to the first render operation in the queue.
+	/// @{
+	iterator begin();
+	const_iterator begin() const;
+	/// @}
+
+	/// Returns a pointer past the last render operation in the queue.
+	/// @{
+	iterator end();
+	const_iterator end() const;
+	/// @}
+
+private:
+	/// Sorts the key-index pairs with an LSD radix sort, then reorders the render operations accordingly.
+	void radix_sort();
+	
+	std::vector<render_operation> storage;
+	std::vector<render_operation> sort_buffer;
+	std::vector<std::uint64_t> keys;
+	std::vector<std::uint64_t> key_buffer;
+	std::vector<std::uint32_t> indices;
+	std::vector<std::uint32_t> index_buffer;
+	std::size_t count;
+};
+
+inline render_queue::render_queue():
+	count(0)
+{}
+
+inline render_operation& render_queue::allocate()
+{
+	// Grow storage geometrically when full
+	if (count == storage.size())
+		storage.resize((count) ? count * 2 : 256);
+
+	return storage[count++];
+}
+
+inline void render_queue::push_back(const render_operation& operation)
+{
+	allocate() = operation;
+}
+
+inline void render_queue::reserve(std::size_t capacity)
+{
+	if (capacity > storage.size())
+		storage.resize(capacity);
+}
+
+inline void render_queue::clear()
+{
+	count = 0;
+}
+
+inline std::size_t render_queue::size() const
+{
+	return count;
+}
+
+inline std::size_t render_queue::capacity() const
+{
+	return storage.size();
+}
+
+inline bool render_queue::empty() const
+{
+	return !count;
+}
+
+inline render_queue::iterator render_queue::begin()
+{
+	return storage.data();
+}
+
+inline render_queue::const_iterator render_queue::begin() const
+{
+	return storage.data();
+}
+
+inline render_queue::iterator render_queue::end()
+{
+	return storage.data() + count;
+}
+
+inline render_queue::const_iterator render_queue::end() const
+{
+	return storage.data() + count;
+}
+
+#endif // ANTKEEPER_RENDER_QUEUE_HPP
+
@@ -26,31 +26,67 @@
 #include "scene/billboard.hpp"
 #include "scene/lod-group.hpp"
 #include "renderer/model.hpp"
+#include "renderer/material.hpp"
+#include "renderer/material-flags.hpp"
+#include "renderer/sort-key.hpp"
+#include "renderer/occlusion-buffer.hpp"
 #include "gl/drawing-mode.hpp"
 #include "math/math.hpp"
 #include "geom/projection.hpp"
 #include "configuration.hpp"
+#include "debug/allocation-tracker.hpp"
+#include "debug/profiler.hpp"
+#include "utility/job-system.hpp"
+#include <cstring>
 #include <functional>
 #include <set>
 
-renderer::renderer()
+/**
+ * Generates the key by which the material pass sorts a render operation.
+ *
+ * From the most significant bit, keys contain a no-material bit, an x-ray bit, and a translucent bit, so that opaque operations are rendered first, followed by translucent operations, then x-ray operations, then operations without materials. Opaque keys then contain 12-bit shader program, material, and VAO identifiers followed by a 24-bit depth, sorting front to back. Translucent keys contain a not-decal bit followed by an inverted 32-bit depth, sorting decals first and then back to front. X-ray keys contain only an inverted 32-bit depth.
+ */
+static std::uint64_t generate_sort_key(const render_operation& operation);
+
+/**
+ * Returns `true` if a culling volume may intersect the culling volume of the camera. Spheres and boxes are tested against the packed planes of convex camera culling volumes, four planes at a time, and other volumes through the virtual intersection tests.
+ */
+static bool is_visible(const render_context& context, const geom::bounding_volume<float>& volume)
+{
+	if (context.camera_culling_planes && volume.get_bounding_volume_type() != geom::bounding_volume_type::convex_hull)
+		return geom::classify(*context.camera_culling_planes, volume) != geom::containment::outside;
+	return context.camera_culling_volume->intersects(volume);
+}
+
+renderer::renderer():
+	jobs(nullptr)
 {
 	// Setup billboard render operation
 	billboard_op.pose = nullptr;
+	billboard_op.bone_palette_offset = 0;
 	billboard_op.drawing_mode = gl::drawing_mode::triangles;
 	billboard_op.vertex_array = nullptr;
 	billboard_op.start_index = 0;
 	billboard_op.index_count = 6;
 	billboard_op.instance_count = 0;
+	billboard_op.indexed = false;
+	billboard_op.occluded = false;
+	billboard_op.pick_id = 0;
 }
 
 void renderer::render(float alpha, const scene::collection& collection) const
 {
+	debug::profile_zone zone("renderer::render");
+	debug::allocation_scope allocation_scope(debug::allocation_tag::renderer);
+	
+	// Bone palettes are evaluated at most once per frame, however many cameras render each pose
+	skinning.begin_frame();
+	
 	// Get list of all objects in the collection
-	const std::list<scene::object_base*>* objects = collection.get_objects();
+	const std::vector<scene::object_base*>* objects = collection.get_objects();
 	
 	// Build list of cameras to be sorted
-	const std::list<scene::object_base*>* cameras = collection.get_objects(scene::camera::object_type_id);
+	const std::vector<scene::object_base*>* cameras = collection.get_objects(scene::camera::object_type_id);
 	std::list<scene::camera*> sorted_cameras;
 	for (scene::object_base* object: *cameras)
 	{
@@ -66,50 +102,216 @@ void renderer::render(float alpha, const scene::collection& collection) const
 		}
 	);
 
-	// Process cameras in order
+	// Collect the culling volumes of all cameras to be rendered. Convex culling volumes, such as view frustums, are tested in a single sweep by the culling stage.
+	culling.clear();
+	culling_cameras.clear();
 	for (const scene::camera* camera: sorted_cameras)
 	{
-		// Skip inactive cameras
-		if (!camera->is_active())
+		// Skip inactive cameras and cameras with no compositors
+		if (!camera->is_active() || !camera->get_compositor())
 		{
 			continue;
 		}
 		
-		// Skip cameras with no compositors
-		const compositor* compositor = camera->get_compositor();
-		if (!compositor)
+		const geom::bounding_volume<float>* camera_culling_volume = camera->get_culling_mask();
+		if (!camera_culling_volume)
+			camera_culling_volume = &camera->get_bounds();
+		
+		culling_camera& entry = culling_cameras.emplace_back();
+		entry.camera = camera;
+		entry.culling_volume = camera_culling_volume;
+		entry.volume = culling_camera::no_volume;
+		if (camera_culling_volume->get_bounding_volume_type() == geom::bounding_volume_type::convex_hull)
 		{
-			continue;
+			const geom::convex_hull<float>& hull = static_cast<const geom::convex_hull<float>&>(*camera_culling_volume);
+			entry.volume = culling.add_volume(hull);
+			entry.planes.set_planes(hull.planes);
 		}
-		
-		// Setup render context
-		render_context context;
-		context.camera = camera;
-		context.camera_transform = camera->get_transform_tween().interpolate(alpha); 
-		context.camera_forward = context.camera_transform.rotation * global_forward;
-		context.camera_up = context.camera_transform.rotation * global_up;
-		context.clip_near = camera->get_view_frustum().get_near(); ///< TODO: tween this
-		context.collection = &collection;
-		context.alpha = alpha;
-		
-		// Get camera culling volume
-		context.camera_culling_volume = camera->get_culling_mask();
-		if (!context.camera_culling_volume)
-			context.camera_culling_volume = &camera->get_bounds();
-		
-		// Generate render operations for each visible scene object
+	}
+	
+	// Collect the culling volumes of active objects, unless objects can be queried from the spatial index of the collection. Objects with other culling volumes, and objects such as LOD groups which are culled per child, are not culled by the culling stage.
+	const bool indexed = collection.is_spatially_indexed();
+	culling_objects.clear();
+	if (!indexed)
+	{
 		for (const scene::object_base* object: *objects)
 		{
 			// Skip inactive objects
 			if (!object->is_active())
 				continue;
 			
-			// Process object
-			process_object(context, object);
+			bool culled = false;
+			const std::size_t type = object->get_object_type_id();
+			if (type == scene::model_instance::object_type_id || type == scene::billboard::object_type_id)
+			{
+				const geom::bounding_volume<float>* object_culling_volume = object->get_culling_mask();
+				if (!object_culling_volume)
+					object_culling_volume = &object->get_bounds();
+				
+				const geom::bounding_volume_type volume_type = object_culling_volume->get_bounding_volume_type();
+				if (volume_type == geom::bounding_volume_type::aabb)
+				{
+					culling.add_bounds(static_cast<const geom::aabb<float>&>(*object_culling_volume));
+					culled = true;
+				}
+				else if (volume_type == geom::bounding_volume_type::sphere)
+				{
+					culling.add_bounds(static_cast<const geom::sphere<float>&>(*object_culling_volume));
+					culled = true;
+				}
+			}
+			else if (type == scene::lod_group::object_type_id && static_cast<const scene::lod_group*>(object)->get_radius() > 0.0f)
+			{
+				// Cull LOD groups with bounding spheres as a whole, in the same sweep
+				const scene::lod_group* lod_group = static_cast<const scene::lod_group*>(object);
+				culling.add_bounds(geom::sphere<float>{lod_group->get_world_transform().translation, lod_group->get_radius()});
+				culled = true;
+			}
+			
+			if (!culled)
+				culling.add_unbounded();
+			
+			culling_objects.push_back({object, culled});
 		}
+	}
+	
+	// Cull objects against all cameras at once
+	culling.cull();
+	
+	// Prepare the views of all cameras, in parallel if a job system has been set
+	if (views.size() < culling_cameras.size())
+		views.resize(culling_cameras.size());
+	auto prepare_views = [&](std::size_t first, std::size_t last)
+	{
+		for (std::size_t i = first; i < last; ++i)
+			prepare_view(views[i], culling_cameras[i], collection, alpha);
+	};
+	if (jobs && culling_cameras.size() > 1)
+		jobs->parallel_for(0, culling_cameras.size(), 1, prepare_views);
+	else
+		prepare_views(0, culling_cameras.size());
+	
+	// Composite cameras in order
+	for (std::size_t i = 0; i < culling_cameras.size(); ++i)
+	{
+		camera_view& view = views[i];
+		
+		// Place the bone palettes of the posed operations, in the order in which they were generated
+		for (const auto& [index, distance]: view.posed_operations)
+		{
+			render_operation& operation = *(view.queue.begin() + index);
+			operation.bone_palette_offset = skinning.add_pose(operation.pose, distance);
+		}
+		
+		// Upload the bone palettes of poses first rendered by this camera
+		skinning.upload();
+		view.context.bone_palettes = skinning.get_buffer();
 		
 		// Pass render context to the camera's compositor
-		compositor->composite(&context);
+		view.context.camera->get_compositor()->composite(&view.context);
+	}
+}
+
+void renderer::prepare_view(camera_view& view, const culling_camera& entry, const scene::collection& collection, float alpha) const
+{
+	debug::profile_zone zone("renderer::prepare_view");
+	
+	const scene::camera* camera = entry.camera;
+	
+	// Setup render context
+	render_context& context = view.context;
+	context.camera = camera;
+	context.camera_transform = camera->get_interpolated_transform();
+	context.camera_origin = camera->get_interpolated_origin();
+	context.camera_forward = context.camera_transform.rotation * global_forward;
+	context.camera_up = context.camera_transform.rotation * global_up;
+	context.billboard_rotation = math::look_rotation(context.camera_forward, context.camera_up);
+	context.clip_near = camera->get_view_frustum().get_near(); ///< TODO: tween this
+	
+	// Move the world-space near clipping plane into the frame of the camera origin
+	context.clip_near.distance += math::dot(context.clip_near.normal, math::type_cast<float>(context.camera_origin));
+	context.collection = &collection;
+	context.alpha = alpha;
+	
+	// Reuse render queue storage from previous frames
+	view.queue.clear();
+	view.posed_operations.clear();
+	context.operations = &view.queue;
+	context.bone_palettes = nullptr;
+	
+	// Get camera occlusion buffer, if it has been built
+	auto occlusion_it = occlusion_buffers.find(camera);
+	context.occlusion = (occlusion_it != occlusion_buffers.end() && occlusion_it->second->is_valid()) ? occlusion_it->second : nullptr;
+	
+	// Begin a frame of retained operations
+	++view.frame;
+	view.retained_count = 0;
+	view.tracked_count = 0;
+	
+	// Get camera culling volume
+	context.camera_culling_volume = entry.culling_volume;
+	context.camera_culling_planes = (entry.volume != culling_camera::no_volume) ? &entry.planes : nullptr;
+	
+	// Generate render operations for each visible scene object
+	if (collection.is_spatially_indexed() && entry.volume != culling_camera::no_volume)
+	{
+		// Process only the objects which may intersect the camera culling volume
+		collection.query
+		(
+			entry.planes,
+			[&](const scene::object_base* object)
+			{
+				if (object->is_active())
+					process_object(view, object, false);
+			}
+		);
+	}
+	else if (entry.volume != culling_camera::no_volume)
+	{
+		const std::uint32_t* visibility_mask = culling.get_visibility_mask(entry.volume);
+		for (std::size_t i = 0; i < culling_objects.size(); ++i)
+		{
+			// Skip objects outside of the camera culling volume
+			if (!((visibility_mask[i / culling_stage::block_size] >> (i % culling_stage::block_size)) & 1))
+				continue;
+			
+			process_object(view, culling_objects[i].object, culling_objects[i].culled);
+		}
+	}
+	else
+	{
+		for (const scene::object_base* object: *collection.get_objects())
+		{
+			// Skip inactive objects
+			if (!object->is_active())
+				continue;
+			
+			process_object(view, object, false);
+		}
+	}
+	
+	// Discard the operations of static model instances which have not been visible recently, once they outnumber the visible ones
+	if (view.retained_instances.size() > view.retained_count * 2 + 64)
+	{
+		for (auto it = view.retained_instances.begin(); it != view.retained_instances.end();)
+		{
+			if (it->second.frame != view.frame)
+				it = view.retained_instances.erase(it);
+			else
+				++it;
+		}
+	}
+	
+	// Likewise discard the transforms of dynamic model instances which have not been visible recently
+	if (view.tracked_transforms.size() > view.tracked_count * 2 + 64)
+	{
+		for (auto it = view.tracked_transforms.begin(); it != view.tracked_transforms.end();)
+		{
+			if (it->second.frame != view.frame)
+				it = view.tracked_transforms.erase(it);
+			else
+				++it;
+		}
 	}
 }
 
@@ -118,39 +320,159 @@ void renderer::set_billboard_vao(gl::vertex_array* vao)
 	billboard_op.vertex_array = vao;
 }
 
-void renderer::process_object(render_context& context, const scene::object_base* object) const
+void renderer::set_job_system(job_system* jobs)
+{
+	this->jobs = jobs;
+	skinning.set_job_system(jobs);
+}
+
+void renderer::set_animation_lod_distances(float half_rate_distance, float quarter_rate_distance)
+{
+	skinning.set_lod_distances(half_rate_distance, quarter_rate_distance);
+}
+
+void renderer::set_occlusion_buffer(const scene::camera* camera, const occlusion_buffer* buffer)
+{
+	if (buffer)
+		occlusion_buffers[camera] = buffer;
+	else
+		occlusion_buffers.erase(camera);
+}
+
+void renderer::process_object(camera_view& view, const scene::object_base* object, bool culled) const
 {
 	std::size_t type = object->get_object_type_id();
 	
 	if (type == scene::model_instance::object_type_id)
-		process_model_instance(context, static_cast<const scene::model_instance*>(object));
+		process_model_instance(view, static_cast<const scene::model_instance*>(object), culled);
 	else if (type == scene::billboard::object_type_id)		
-		process_billboard(context, static_cast<const scene::billboard*>(object));
+		process_billboard(view, static_cast<const scene::billboard*>(object), culled);
 	else if (type == scene::lod_group::object_type_id)
-		process_lod_group(context, static_cast<const scene::lod_group*>(object));
+		process_lod_group(view, static_cast<const scene::lod_group*>(object), culled);
 }
 
-void renderer::process_model_instance(render_context& context, const scene::model_instance* model_instance) const
+void renderer::process_model_instance(camera_view& view, const scene::model_instance* model_instance, bool culled) const
 {
+	const render_context& context = view.context;
+	
 	const model* model = model_instance->get_model();
 	if (!model)
 		return;
 	
-	// Get object culling volume
-	const geom::bounding_volume<float>* object_culling_volume = model_instance->get_culling_mask();
-	if (!object_culling_volume)
-		object_culling_volume = &model_instance->get_bounds();
+	if (!culled)
+	{
+		// Get object culling volume
+		const geom::bounding_volume<float>* object_culling_volume = model_instance->get_culling_mask();
+		if (!object_culling_volume)
+			object_culling_volume = &model_instance->get_bounds();
+		
+		// Perform view-frustum culling
+		if (!is_visible(context, *object_culling_volume))
+			return;
+	}
+	
+	const std::vector<model_group*>* groups = model->get_groups();
+	const pose* pose = model_instance->get_pose();
 	
-	// Perform view-frustum culling
-	if (!context.camera_culling_volume->intersects(*object_culling_volume))
+	// Reuse the retained operations of static model instances, regenerating them only if the model instance or the camera origin has changed
+	if (model_instance->is_static() && !pose)
+	{
+		retained_instance& retained = view.retained_instances[model_instance];
+		if (retained.revision != model_instance->get_revision() ||
+			std::memcmp(&retained.camera_origin, &context.camera_origin, sizeof(double3)) ||
+			retained.operations.size() != groups->size())
+		{
+			retained.operations.resize(groups->size());
+			generate_model_instance_operations(context, model_instance, retained.operations.data());
+			retained.camera_origin = context.camera_origin;
+			
+			// Operations generated while the model instance is interpolated between transforms hold only for this frame
+			const bool settled = !std::memcmp(&model_instance->get_interpolated_transform(), &model_instance->get_transform(), sizeof(math::transform<float>)) &&
+				!std::memcmp(&model_instance->get_interpolated_origin(), &model_instance->get_origin(), sizeof(double3));
+			retained.revision = (settled) ? model_instance->get_revision() : 0;
+		}
+		retained.frame = view.frame;
+		++view.retained_count;
+		
+		if (retained.operations.empty())
+			return;
+		
+		// Update the depth and occlusion of the operations, which depend on the camera
+		const float depth = context.clip_near.signed_distance(math::resize<3>(retained.operations.front().transform[3]));
+		const bool occluded = context.occlusion && context.occlusion->is_occluded(retained.operations.front().bounds);
+		for (const render_operation& retained_operation: retained.operations)
+		{
+			render_operation& operation = view.queue.allocate();
+			operation = retained_operation;
+			operation.depth = depth;
+			operation.occluded = occluded;
+			operation.sort_key = generate_sort_key(operation);
+		}
+		
 		return;
+	}
+	
+	if (groups->empty())
+		return;
+	
+	// Generate the operations of dynamic model instances every frame
+	const std::size_t first_operation = view.queue.size();
+	for (std::size_t i = 0; i < groups->size(); ++i)
+		view.queue.allocate();
+	render_operation* operations = view.queue.begin() + first_operation;
+	generate_model_instance_operations(context, model_instance, operations);
+	
+	const float3 translation = math::resize<3>(operations[0].transform[3]);
+	const float depth = context.clip_near.signed_distance(translation);
+	
+	// Test the bounds against the occlusion buffer of the camera
+	const bool occluded = context.occlusion && context.occlusion->is_occluded(operations[0].bounds);
 	
+	// Take the previous transform from the previous frame, if the model instance was rendered in it
+	tracked_transform& tracked = view.tracked_transforms[model_instance];
+	if (tracked.frame && tracked.frame + 1 == view.frame)
+	{
+		for (std::size_t i = 0; i < groups->size(); ++i)
+			operations[i].previous_transform = tracked.transform;
+	}
+	tracked.transform = operations[0].transform;
+	tracked.frame = view.frame;
+	++view.tracked_count;
+	
+	// Place the bone palette of the instance's pose once for all groups, with an evaluation rate selected by its distance from the camera
+	const float pose_distance = (pose) ? math::length(translation - context.camera_transform.translation) : 0.0f;
+	
+	for (std::size_t i = 0; i < groups->size(); ++i)
+	{
+		// Defer the placement of bone palettes to the rendering thread, as the skinning stage is shared by all cameras
+		if (pose)
+			view.posed_operations.emplace_back(first_operation + i, pose_distance);
+		
+		render_operation& operation = operations[i];
+		operation.depth = depth;
+		operation.occluded = occluded;
+		operation.sort_key = generate_sort_key(operation);
+	}
+}
+
+void renderer::generate_model_instance_operations(const render_context& context, const scene::model_instance* model_instance, render_operation* operations)
+{
+	const model* model = model_instance->get_model();
 	const std::vector<material*>* instance_materials = model_instance->get_materials();
 	const std::vector<model_group*>* groups = model->get_groups();
-
-	for (model_group* group: *groups)
+	
+	// Interpolate model instance transform and derive its normal matrix once for all groups
+	const math::transform<float> interpolated_transform = get_relative_transform(context, *model_instance);
+	const float4x4 transform = math::matrix_cast(interpolated_transform);
+	const float3x3 normal_transform = math::normal_matrix(interpolated_transform);
+	
+	// Model instance bounds are always axis-aligned bounding boxes, and are moved from world space into the frame of the camera origin
+	const geom::aabb<float> bounds = get_relative_bounds(context, static_cast<const geom::aabb<float>&>(model_instance->get_bounds()));
+	
+	for (std::size_t i = 0; i < groups->size(); ++i)
 	{
-		render_operation operation;
+		const model_group* group = (*groups)[i];
+		render_operation& operation = operations[i];
 
 		// Determine operation material
 		operation.material = group->get_material();
@@ -161,37 +483,51 @@ void renderer::process_model_instance(render_context& context, const scene::mode
 		}
 
 		operation.pose = model_instance->get_pose();
+		operation.bone_palette_offset = 0;
 		operation.vertex_array = model->get_vertex_array();
 		operation.drawing_mode = group->get_drawing_mode();
 		operation.start_index = group->get_start_index();
 		operation.index_count = group->get_index_count();
-		operation.transform = math::matrix_cast(model_instance->get_transform_tween().interpolate(context.alpha));
-		operation.depth = context.clip_near.signed_distance(math::resize<3>(operation.transform[3]));
+		operation.transform = transform;
+		operation.previous_transform = transform;
+		operation.normal_transform = normal_transform;
+		operation.depth = 0.0f;
 		operation.instance_count = model_instance->get_instance_count();
-
-		context.operations.push_back(operation);
+		operation.indexed = group->is_indexed();
+		operation.element_type = group->get_element_type();
+		operation.bounds = bounds;
+		operation.occluded = false;
+		operation.pick_id = model_instance->get_pick_id();
+		operation.sort_key = 0;
 	}
 }
 
-void renderer::process_billboard(render_context& context, const scene::billboard* billboard) const
+void renderer::process_billboard(camera_view& view, const scene::billboard* billboard, bool culled) const
 {
-	// Get object culling volume
-	const geom::bounding_volume<float>* object_culling_volume = billboard->get_culling_mask();
-	if (!object_culling_volume)
-		object_culling_volume = &billboard->get_bounds();
+	const render_context& context = view.context;
 	
-	// Perform view-frustum culling
-	if (!context.camera_culling_volume->intersects(*object_culling_volume))
-		return;
+	if (!culled)
+	{
+		// Get object culling volume
+		const geom::bounding_volume<float>* object_culling_volume = billboard->get_culling_mask();
+		if (!object_culling_volume)
+			object_culling_volume = &billboard->get_bounds();
+		
+		// Perform view-frustum culling
+		if (!is_visible(context, *object_culling_volume))
+			return;
+	}
 	
-	math::transform<float> billboard_transform = billboard->get_transform_tween().interpolate(context.alpha);
-	billboard_op.material = billboard->get_material();
-	billboard_op.depth = context.clip_near.signed_distance(math::resize<3>(billboard_transform.translation));
+	math::transform<float> billboard_transform = get_relative_transform(context, *billboard);
+	render_operation& operation = view.queue.allocate();
+	operation = billboard_op;
+	operation.material = billboard->get_material();
+	operation.depth = context.clip_near.signed_distance(math::resize<3>(billboard_transform.translation));
 	
 	// Align billboard
 	if (billboard->get_billboard_type() == scene::billboard_type::spherical)
 	{
-		billboard_transform.rotation = math::normalize(math::look_rotation(context.camera_forward, context.camera_up) * billboard_transform.rotation);
+		billboard_transform.rotation = math::normalize(context.billboard_rotation * billboard_transform.rotation);
 	}
 	else if (billboard->get_billboard_type() == scene::billboard_type::cylindrical)
 	{
@@ -203,13 +539,21 @@ void renderer::process_billboard(render_context& context, const scene::billboard
 		billboard_transform.rotation = math::normalize(math::look_rotation(look, up) * billboard_transform.rotation);
 	}
 	
-	billboard_op.transform = math::matrix_cast(billboard_transform);
-	
-	context.operations.push_back(billboard_op);
+	operation.transform = math::matrix_cast(billboard_transform);
+	operation.previous_transform = operation.transform;
+	operation.normal_transform = math::normal_matrix(billboard_transform);
+	operation.bounds = get_relative_bounds(context, static_cast<const geom::aabb<float>&>(billboard->get_bounds()));
+	operation.sort_key = generate_sort_key(operation);
 }
 
-void renderer::process_lod_group(render_context& context, const scene::lod_group* lod_group) const
+void renderer::process_lod_group(camera_view& view, const scene::lod_group* lod_group, bool culled) const
 {
+	const render_context& context = view.context;
+	
+	// Perform view-frustum culling of groups with bounding spheres
+	if (!culled && lod_group->get_radius() > 0.0f && !is_visible(context, geom::sphere<float>{lod_group->get_world_transform().translation, lod_group->get_radius()}))
+		return;
+	
 	// Select level of detail
 	std::size_t level = lod_group->select_lod(*context.camera);
 	
@@ -217,6 +561,56 @@ void renderer::process_lod_group(render_context& context, const scene::lod_group
 	const std::list<scene::object_base*>& objects = lod_group->get_objects(level);
 	for (const scene::object_base* object: objects)
 	{
-		process_object(context, object);
+		process_object(view, object, false);
+	}
+}
+
+std::uint64_t generate_sort_key(const render_operation& operation)
+{
+	// Render operations without materials are sorted last
+	if (!operation.material)
+		return ~std::uint64_t(0);
+	
+	const std::uint32_t flags = operation.material->get_flags();
+	std::uint64_t key = 0;
+	
+	if (flags & MATERIAL_FLAG_X_RAY)
+	{
+		// X-ray, render back to front
+		key |= std::uint64_t(1) << 62;
+		key |= ~sort_key::quantize_depth(operation.depth, 32) & 0xffffffff;
 	}
+	else if (flags & MATERIAL_FLAG_TRANSLUCENT)
+	{
+		key |= std::uint64_t(1) << 61;
+		if (flags & MATERIAL_FLAG_DECAL)
+		{
+			// Translucent decals, render first, back to front
+			key |= ~sort_key::quantize_depth(operation.depth, 32) & 0xffffffff;
+		}
+		else if (flags & MATERIAL_FLAG_WEIGHTED_BLENDED)
+		{
+			// Weighted blended, render next, in any order, so group by shader program, material, and VAO
+			key |= std::uint64_t(1) << 59;
+			key |= sort_key::hash_pointer(operation.material->get_shader_program(), 12) << 24;
+			key |= sort_key::hash_pointer(operation.material, 12) << 12;
+			key |= sort_key::hash_pointer(operation.vertex_array, 12);
+		}
+		else
+		{
+			// Translucent, render last, back to front
+			key |= std::uint64_t(1) << 60;
+			key |= ~sort_key::quantize_depth(operation.depth, 32) & 0xffffffff;
+		}
+	}
+	else
+	{
+		// Opaque, group by shader program, material, and VAO, then render front to back
+		key |= sort_key::hash_pointer(operation.material->get_shader_program(), 12) << 48;
+		key |= sort_key::hash_pointer(operation.material, 12) << 36;
+		key |= sort_key::hash_pointer(operation.vertex_array, 12) << 24;
+		key |= sort_key::quantize_depth(operation.depth, 24);
+	}
+	
+	return key;
 }
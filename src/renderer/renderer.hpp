@@ -21,12 +21,22 @@
 #define ANTKEEPER_RENDERER_HPP
 
 #include "render-operation.hpp"
+#include "render-queue.hpp"
+#include "culling-stage.hpp"
+#include "render-context.hpp"
+#include "skinning-stage.hpp"
 #include "gl/vertex-array.hpp"
+#include <cstddef>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
-struct render_context;
+class job_system;
+class occlusion_buffer;
 
 namespace scene
 {
+	class camera;
 	class collection;
 	class object_base;
 	class model_instance;
@@ -43,6 +53,8 @@ namespace scene
 4. List of visible scene objects are passed to the camera's compositor.
 5. Compositor passes the visible scene objects to each render pass
 6. Render pass sorts scene objects according to its own rules, then rasterizes to its render target.
+
+Steps 3 and 4, culling and the generation of render operations, are prepared for every camera before any camera is composited, in parallel if a job system has been set. Only bone palette placement and compositing, which issue OpenGL calls, run on the rendering thread.
 */
 
 /**
@@ -56,6 +68,8 @@ public:
 	/**
 	 * Renders a collection of scene objects.
 	 *
+	 * Object transforms are read from the scene::transform_store, which should be interpolated with the same factor beforehand.
+	 *
 	 * @param alpha Subframe interpolation factor.
 	 * @parma collection Collection of scene objects to render.
 	 */
@@ -66,13 +80,153 @@ public:
 	 */
 	void set_billboard_vao(gl::vertex_array* vao);
 	
+	/**
+	 * Sets the job system on which the render operations of cameras are prepared, and the bone palettes of posed model instances are evaluated.
+	 *
+	 * @param jobs Job system, or `nullptr` to prepare cameras and evaluate bone palettes on the rendering thread.
+	 */
+	void set_job_system(job_system* jobs);
+	
+	/**
+	 * Sets the distances from the camera beyond which the poses of model instances are evaluated at reduced rates.
+	 *
+	 * @param half_rate_distance Distance beyond which poses are evaluated every second frame.
+	 * @param quarter_rate_distance Distance beyond which poses are evaluated every fourth frame.
+	 *
+	 * @see skinning_stage::set_lod_distances()
+	 */
+	void set_animation_lod_distances(float half_rate_distance, float quarter_rate_distance);
+	
+	/**
+	 * Sets the occlusion buffer against which the model instances seen by a camera are culled. Operations of occluded model instances are flagged as occluded rather than discarded, so that they may still cast shadows.
+	 *
+	 * @param camera Camera to be occlusion culled.
+	 * @param buffer Occlusion buffer built from the previous frames of the camera, or `nullptr` to disable occlusion culling of the camera.
+	 *
+	 * @see occlusion_pass
+	 */
+	void set_occlusion_buffer(const scene::camera* camera, const occlusion_buffer* buffer);
+	
 private:
-	void process_object(render_context& context, const scene::object_base* object) const;
-	void process_model_instance(render_context& context, const scene::model_instance* model_instance) const;
-	void process_billboard(render_context& context, const scene::billboard* billboard) const;
-	void process_lod_group(render_context& context, const scene::lod_group* lod_group) const;
+	/// Camera to be rendered, with the index of its volume in the culling stage.
+	struct culling_camera
+	{
+		static constexpr std::size_t no_volume = ~std::size_t(0);
+		
+		const scene::camera* camera;
+		const geom::bounding_volume<float>* culling_volume;
+		
+		/// Index of the camera culling volume in the culling stage, or `no_volume` if the culling volume is not convex.
+		std::size_t volume;
+		
+		/// Planes of the camera culling volume, packed for SIMD tests if the culling volume is convex.
+		geom::packed_hull<float> planes;
+	};
+	
+	/// Active scene object, in the order of its bounds in the culling stage.
+	struct culling_object
+	{
+		const scene::object_base* object;
+		
+		/// `true` if the culling stage tests the culling volume of the object.
+		bool culled;
+	};
+	
+	/// Render operations of a static model instance, generated once and reused while the model instance and the camera origin are unchanged. Only their depths, occlusion, and sort keys are updated each frame.
+	struct retained_instance
+	{
+		/// Revision of the model instance from which the operations were generated, or `0` if they must be regenerated.
+		std::uint64_t revision{0};
+		
+		/// Camera origin relative to which the operation transforms and bounds were generated.
+		double3 camera_origin;
+		
+		/// Last frame in which the model instance was visible.
+		std::size_t frame{0};
+		
+		std::vector<render_operation> operations;
+	};
+	
+	/// Transform with which a dynamic model instance was rendered, kept for the previous transforms of its operations in the following frame.
+	struct tracked_transform
+	{
+		float4x4 transform;
+		
+		/// Frame in which the model instance was rendered with the transform, or `0` if it has not been rendered.
+		std::size_t frame{0};
+	};
+	
+	/// Render context and render operations of a camera, prepared before any camera is composited.
+	struct camera_view
+	{
+		render_context context;
+		
+		/// Queue of the render operations of the camera. Storage is reused across frames.
+		render_queue queue;
+		
+		/// Indices of the posed operations in the queue, with the distances of their model instances from the camera, by which their bone palettes are placed on the rendering thread.
+		std::vector<std::pair<std::size_t, float>> posed_operations;
+		
+		/// Render operations retained for static model instances, keyed by model instance.
+		std::unordered_map<const scene::model_instance*, retained_instance> retained_instances;
+		
+		/// Number of retained model instances visible in the current frame.
+		std::size_t retained_count{0};
+		
+		/// Transforms of the dynamic model instances rendered in recent frames, keyed by model instance.
+		std::unordered_map<const scene::model_instance*, tracked_transform> tracked_transforms;
+		
+		/// Number of dynamic model instances visible in the current frame.
+		std::size_t tracked_count{0};
+		
+		/// Number of frames prepared for the view, by which unused retained model instances are identified.
+		std::size_t frame{0};
+	};
+	
+	/**
+	 * Culls the scene objects seen by a camera and generates their render operations. Makes no OpenGL calls and modifies no shared state, so it may be called concurrently for different cameras.
+	 *
+	 * @param view View to prepare.
+	 * @param entry Camera of the view.
+	 * @param collection Collection of scene objects to render.
+	 * @param alpha Subframe interpolation factor.
+	 */
+	void prepare_view(camera_view& view, const culling_camera& entry, const scene::collection& collection, float alpha) const;
+	
+	/**
+	 * Generates render operations for a scene object.
+	 *
+	 * @param culled `true` if the object has already been culled against the camera culling volume.
+	 */
+	void process_object(camera_view& view, const scene::object_base* object, bool culled) const;
+	void process_model_instance(camera_view& view, const scene::model_instance* model_instance, bool culled) const;
+	
+	/**
+	 * Generates the render operations of each group of a model instance, apart from their depths, occlusion, and sort keys, which are updated every frame.
+	 *
+	 * @param context Render context of the camera.
+	 * @param model_instance Model instance with a model.
+	 * @param[out] operations Array of one render operation per model group.
+	 */
+	static void generate_model_instance_operations(const render_context& context, const scene::model_instance* model_instance, render_operation* operations);
+	
+	/**
+	 * Generates the render operation of a billboard, aligned to the camera. As all billboards share the billboard VAO, subsequent billboards with the same material are merged by the material pass into a single instanced draw, with their aligned transforms as per-instance data.
+	 */
+	void process_billboard(camera_view& view, const scene::billboard* billboard, bool culled) const;
+	void process_lod_group(camera_view& view, const scene::lod_group* lod_group, bool culled) const;
 
-	mutable render_operation billboard_op;
+	/// Template of billboard render operations, copied for each billboard.
+	render_operation billboard_op;
+	job_system* jobs;
+	
+	/// Views of the cameras being rendered, in compositing order. Storage is reused across frames.
+	mutable std::vector<camera_view> views;
+	mutable culling_stage culling;
+	mutable skinning_stage skinning;
+	mutable std::vector<culling_camera> culling_cameras;
+	mutable std::vector<culling_object> culling_objects;
+	std::unordered_map<const scene::camera*, const occlusion_buffer*> occlusion_buffers;
 };
 
 #endif // ANTKEEPER_RENDERER_HPP
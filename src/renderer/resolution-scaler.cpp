@@ -0,0 +1,122 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "renderer/resolution-scaler.hpp"
+#include "gl/framebuffer.hpp"
+#include "gl/texture-2d.hpp"
+#include <algorithm>
+#include <cmath>
+
+resolution_scaler::resolution_scaler(gl::framebuffer* framebuffer):
+	framebuffer(framebuffer),
+	full_dimensions(framebuffer->get_dimensions()),
+	scale(1.0f),
+	min_scale(0.5f),
+	max_scale(1.0f),
+	target_duration(1.0 / 60.0),
+	headroom(0.15),
+	smoothed_duration(0.0),
+	frames_since_change(0)
+{}
+
+void resolution_scaler::set_scale_range(float min_scale, float max_scale)
+{
+	this->min_scale = std::min(std::max(min_scale, scale_step), 1.0f);
+	this->max_scale = std::min(std::max(max_scale, this->min_scale), 1.0f);
+	
+	const float clamped_scale = std::min(std::max(scale, this->min_scale), this->max_scale);
+	if (clamped_scale != scale)
+		apply(clamped_scale);
+}
+
+void resolution_scaler::set_target_frame_duration(double duration)
+{
+	target_duration = duration;
+}
+
+void resolution_scaler::set_headroom(double headroom)
+{
+	this->headroom = headroom;
+}
+
+void resolution_scaler::update(double duration)
+{
+	// Smooth measured durations, restarting once the previous change has settled
+	++frames_since_change;
+	if (frames_since_change <= 2)
+	{
+		// Discard measurements of frames rendered before the change
+		smoothed_duration = 0.0;
+		return;
+	}
+	smoothed_duration = (smoothed_duration > 0.0) ? smoothed_duration + (duration - smoothed_duration) * 0.25 : duration;
+	
+	if (frames_since_change < settle_frames || smoothed_duration <= 0.0)
+		return;
+	
+	float target_scale = scale;
+	if (smoothed_duration > target_duration)
+	{
+		// Over budget: reduce the pixel count in proportion to the excess
+		target_scale = scale * static_cast<float>(std::sqrt(target_duration / smoothed_duration));
+		target_scale = std::floor(target_scale / scale_step) * scale_step;
+	}
+	else if (smoothed_duration < target_duration * (1.0 - headroom))
+	{
+		// Under budget: raise the resolution by a single step
+		target_scale = scale + scale_step;
+	}
+	
+	target_scale = std::min(std::max(target_scale, min_scale), max_scale);
+	if (target_scale != scale)
+		apply(target_scale);
+}
+
+void resolution_scaler::set_full_resolution(const std::array<int, 2>& dimensions)
+{
+	full_dimensions = dimensions;
+	apply(scale);
+}
+
+void resolution_scaler::apply(float scale)
+{
+	this->scale = scale;
+	frames_since_change = 0;
+	smoothed_duration = 0.0;
+	
+	const std::array<int, 2> dimensions =
+	{
+		std::max(1, static_cast<int>(std::lround(full_dimensions[0] * scale))),
+		std::max(1, static_cast<int>(std::lround(full_dimensions[1] * scale)))
+	};
+	
+	// Reallocate the attachments, once each, as a single texture may be attached as both depth and stencil
+	gl::texture_2d* attachments[] = {framebuffer->get_color_attachment(), framebuffer->get_depth_attachment(), framebuffer->get_stencil_attachment()};
+	for (std::size_t i = 0; i < 3; ++i)
+	{
+		gl::texture_2d* texture = attachments[i];
+		if (!texture || std::find(attachments, attachments + i, texture) != attachments + i)
+			continue;
+		
+		if (texture->get_dimensions() != dimensions)
+			texture->resize(dimensions[0], dimensions[1], texture->get_pixel_type(), texture->get_pixel_format(), texture->get_color_space(), nullptr);
+	}
+	
+	framebuffer->resize(dimensions);
+}
@@ -0,0 +1,111 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ANTKEEPER_RESOLUTION_SCALER_HPP
+#define ANTKEEPER_RESOLUTION_SCALER_HPP
+
+#include <array>
+#include <cstddef>
+
+namespace gl
+{
+	class framebuffer;
+}
+
+/**
+ * Scales the resolution of a render target to hold a target GPU frame duration.
+ *
+ * Each measured GPU frame duration is smoothed, then compared to the target. Over budget, the resolution scale is reduced at once by the square root of the ratio of the target to the smoothed duration, as fragment cost is roughly proportional to pixel count. Under budget by more than the headroom, the scale is raised by at most one step per change. Scales are quantized to steps and changes are spaced by a settling period, so that the attachments of the render target are reallocated rarely. Passes which render to the target size their viewports by its dimensions, and passes which sample its attachments, such as the final pass, upsample them with their texture filters.
+ */
+class resolution_scaler
+{
+public:
+	/// Difference between successive resolution scales.
+	static constexpr float scale_step = 1.0f / 16.0f;
+	
+	/// Number of measured frames to wait after a change before changing the scale again. Exceeds the latency of GPU timer queries.
+	static constexpr std::size_t settle_frames = 8;
+	
+	/**
+	 * Creates a resolution scaler.
+	 *
+	 * @param framebuffer Render target, whose current dimensions are taken as its full resolution.
+	 */
+	explicit resolution_scaler(gl::framebuffer* framebuffer);
+	
+	/**
+	 * Sets the range of resolution scales.
+	 *
+	 * @param min_scale Minimum resolution scale, on `(0, 1]`.
+	 * @param max_scale Maximum resolution scale, on `[min_scale, 1]`.
+	 */
+	void set_scale_range(float min_scale, float max_scale);
+	
+	/**
+	 * Sets the target GPU frame duration.
+	 *
+	 * @param duration Target duration, in seconds.
+	 */
+	void set_target_frame_duration(double duration);
+	
+	/**
+	 * Sets the fraction of the target frame duration which must remain unused before the resolution is raised.
+	 *
+	 * @param headroom Fraction of the target duration, on `[0, 1)`.
+	 */
+	void set_headroom(double headroom);
+	
+	/**
+	 * Updates the resolution scale given a measured GPU frame duration. Must be called by the thread which owns the OpenGL context, between frames.
+	 *
+	 * @param duration Measured GPU frame duration, in seconds.
+	 */
+	void update(double duration);
+	
+	/**
+	 * Sets the full resolution of the render target, such as after the window has been resized, and reapplies the current scale.
+	 *
+	 * @param dimensions Full resolution, in pixels.
+	 */
+	void set_full_resolution(const std::array<int, 2>& dimensions);
+	
+	/// Returns the current resolution scale.
+	float get_scale() const;
+
+private:
+	/// Resizes the render target and its attachments to a resolution scale.
+	void apply(float scale);
+	
+	gl::framebuffer* framebuffer;
+	std::array<int, 2> full_dimensions;
+	float scale;
+	float min_scale;
+	float max_scale;
+	double target_duration;
+	double headroom;
+	double smoothed_duration;
+	std::size_t frames_since_change;
+};
+
+inline float resolution_scaler::get_scale() const
+{
+	return scale;
+}
+
+#endif // ANTKEEPER_RESOLUTION_SCALER_HPP
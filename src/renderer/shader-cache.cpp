@@ -0,0 +1,137 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "renderer/shader-cache.hpp"
+#include "utility/fnv1a.hpp"
+#include <glad/glad.h>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+namespace {
+
+/// Magic number identifying cached program binaries.
+constexpr char cache_magic[4] = {'A', 'K', 'S', 'B'};
+
+/// Cached program binary header.
+struct cache_header
+{
+	char magic[4];
+	std::uint32_t format;
+	std::uint64_t key;
+	std::uint64_t size;
+};
+
+} // namespace
+
+shader_cache::shader_cache(const std::string& path):
+	path(path)
+{
+	if (!this->path.empty() && this->path.back() != '/')
+		this->path += '/';
+}
+
+std::uint64_t shader_cache::key(const std::string& source)
+{
+	// Identify the driver once, binaries are only valid for the driver which produced them
+	if (driver.empty())
+	{
+		for (GLenum name: {GL_VENDOR, GL_RENDERER, GL_VERSION})
+		{
+			if (const GLubyte* value = glGetString(name))
+				driver += reinterpret_cast<const char*>(value);
+			driver += '\n';
+		}
+	}
+	
+	return fnv1a64(source, fnv1a64(driver));
+}
+
+gl::shader_program* shader_cache::load(std::uint64_t key) const
+{
+	std::ifstream file(get_path(key), std::ios::binary);
+	if (!file)
+		return nullptr;
+	
+	// Read and validate header
+	cache_header header;
+	if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+		std::memcmp(header.magic, cache_magic, sizeof(cache_magic)) ||
+		header.key != key)
+	{
+		return nullptr;
+	}
+	
+	// Read binary
+	std::vector<char> binary(static_cast<std::size_t>(header.size));
+	if (!file.read(binary.data(), binary.size()))
+		return nullptr;
+	
+	gl::shader_program* program = new gl::shader_program();
+	if (!program->load_binary(binary.data(), binary.size(), header.format))
+	{
+		delete program;
+		return nullptr;
+	}
+	
+	return program;
+}
+
+bool shader_cache::store(std::uint64_t key, const gl::shader_program& program) const
+{
+	std::vector<std::uint8_t> binary;
+	unsigned int format;
+	if (!program.get_binary(binary, format))
+		return false;
+	
+	cache_header header;
+	std::memcpy(header.magic, cache_magic, sizeof(cache_magic));
+	header.format = format;
+	header.key = key;
+	header.size = binary.size();
+	
+	// Write to a temporary file, then replace the cached binary, so that an interrupted write can't leave a truncated binary behind
+	const std::string binary_path = get_path(key);
+	const std::string temporary_path = binary_path + ".tmp";
+	{
+		std::ofstream file(temporary_path, std::ios::binary | std::ios::trunc);
+		if (!file)
+			return false;
+		
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file.write(reinterpret_cast<const char*>(binary.data()), binary.size());
+		if (!file)
+		{
+			file.close();
+			std::remove(temporary_path.c_str());
+			return false;
+		}
+	}
+	
+	std::remove(binary_path.c_str());
+	return (std::rename(temporary_path.c_str(), binary_path.c_str()) == 0);
+}
+
+std::string shader_cache::get_path(std::uint64_t key) const
+{
+	char name[17];
+	std::snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(key));
+	return path + name + ".bin";
+}
@@ -0,0 +1,75 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ANTKEEPER_SHADER_CACHE_HPP
+#define ANTKEEPER_SHADER_CACHE_HPP
+
+#include "gl/shader-program.hpp"
+#include <cstdint>
+#include <string>
+
+/**
+ * On-disk cache of linked shader program binaries.
+ *
+ * Binaries are keyed by a hash of the configured source of every shader stage together with the OpenGL vendor, renderer and version strings, so editing a template, changing its definitions, or updating the driver each produce a new key. Drivers may still reject a cached binary, in which case the program is linked from source and its binary replaced.
+ *
+ * @see shader_template::build()
+ */
+class shader_cache
+{
+public:
+	/**
+	 * Creates a shader cache.
+	 *
+	 * @param path Path to an existing directory in which to store program binaries.
+	 */
+	explicit shader_cache(const std::string& path);
+	
+	/**
+	 * Returns the cache key of a shader program, given its configured shader sources. Must be called with a current OpenGL context.
+	 *
+	 * @param source Concatenation of the configured sources of each shader stage.
+	 */
+	std::uint64_t key(const std::string& source);
+	
+	/**
+	 * Loads a cached shader program.
+	 *
+	 * @param key Cache key of the shader program.
+	 * @return Shader program, or `nullptr` if the program was not cached or its binary was rejected by the driver.
+	 */
+	gl::shader_program* load(std::uint64_t key) const;
+	
+	/**
+	 * Stores the binary of a linked shader program in the cache.
+	 *
+	 * @param key Cache key of the shader program.
+	 * @param program Linked shader program.
+	 * @return `true` if the binary was stored, `false` otherwise.
+	 */
+	bool store(std::uint64_t key, const gl::shader_program& program) const;
+	
+private:
+	std::string get_path(std::uint64_t key) const;
+	
+	std::string path;
+	std::string driver;
+};
+
+#endif // ANTKEEPER_SHADER_CACHE_HPP
@@ -18,7 +18,9 @@
  */
 
 #include "renderer/shader-template.hpp"
-#include <algorithm>
+#include "renderer/shader-cache.hpp"
+#include "debug/startup-profiler.hpp"
+#include <chrono>
 #include <sstream>
 
 shader_template::shader_template(const std::string& source_code)
@@ -26,16 +28,21 @@ shader_template::shader_template(const std::string& source_code)
 	source(source_code);
 }
 
-shader_template::shader_template()
+shader_template::shader_template():
+	text_size(0),
+	vertex_directive(false),
+	fragment_directive(false),
+	geometry_directive(false)
 {}
 
 void shader_template::source(const std::string& source)
 {
 	// Reset template
-	template_source.clear();
-	vertex_directives.clear();
-	fragment_directives.clear();
-	geometry_directives.clear();
+	segments.clear();
+	text_size = 0;
+	vertex_directive = false;
+	fragment_directive = false;
+	geometry_directive = false;
 	define_directives.clear();
 	
 	// Iterate through source line-by-line
@@ -46,40 +53,102 @@ void shader_template::source(const std::string& source)
 		std::string token;
 		std::istringstream line_stream(line);
 		
-		// Detect `#pragma` directives
-		if (line_stream >> token && token == "#pragma")
+		// Detect supported `#pragma` directives
+		if (line_stream >> token && token == "#pragma" && line_stream >> token)
 		{
-			if (line_stream >> token)
+			if (token == "define")
 			{
-				// Map line numbers of supported directives
-				if (token == "define")
+				if (line_stream >> token)
 				{
-					if (line_stream >> token)
-						define_directives.insert({token, template_source.size()});
+					segments.push_back({segment_type::define, token});
+					define_directives.insert(token);
+					continue;
 				}
-				else if (token == "vertex")
-					vertex_directives.insert(template_source.size());
-				else if (token == "fragment")
-					fragment_directives.insert(template_source.size());
-				else if (token == "geometry")
-					geometry_directives.insert(template_source.size());
+			}
+			else if (token == "vertex")
+			{
+				segments.push_back({segment_type::vertex, {}});
+				vertex_directive = true;
+				continue;
+			}
+			else if (token == "fragment")
+			{
+				segments.push_back({segment_type::fragment, {}});
+				fragment_directive = true;
+				continue;
+			}
+			else if (token == "geometry")
+			{
+				segments.push_back({segment_type::geometry, {}});
+				geometry_directive = true;
+				continue;
 			}
 		}
 		
-		// Append line to template source
-		template_source.push_back(line);
+		// Append line to the current text segment, starting a new one if necessary
+		if (segments.empty() || segments.back().type != segment_type::text)
+			segments.push_back({segment_type::text, {}});
+		segments.back().text += line;
+		segments.back().text += '\n';
+		text_size += line.size() + 1;
 	}
 }
 
 std::string shader_template::configure(gl::shader_stage stage, const dictionary_type& definitions) const
 {
-	replace_stage_directives(stage);
-	replace_define_directives(definitions);
+	std::string object_source;
+	object_source.reserve(text_size + segments.size() * 32);
+	
+	// Splice text segments with the replacement of each directive
+	for (const segment& segment: segments)
+	{
+		switch (segment.type)
+		{
+			case segment_type::text:
+				object_source += segment.text;
+				break;
+			
+			case segment_type::vertex:
+				object_source += (stage == gl::shader_stage::vertex) ? "#define __VERTEX__\n" : "/* #undef __VERTEX__ */\n";
+				break;
+			
+			case segment_type::fragment:
+				object_source += (stage == gl::shader_stage::fragment) ? "#define __FRAGMENT__\n" : "/* #undef __FRAGMENT__ */\n";
+				break;
+			
+			case segment_type::geometry:
+				object_source += (stage == gl::shader_stage::geometry) ? "#define __GEOMETRY__\n" : "/* #undef __GEOMETRY__ */\n";
+				break;
+			
+			case segment_type::define:
+			{
+				// Check if the corresponding definition was given by the configuration
+				auto definitions_it = definitions.find(segment.text);
+				if (definitions_it != definitions.end())
+				{
+					// Definition found, replace `#pragma define <key>` with `#define <key>` or `#define <key> <value>`
+					object_source += "#define ";
+					object_source += segment.text;
+					if (!definitions_it->second.empty())
+					{
+						object_source += ' ';
+						object_source += definitions_it->second;
+					}
+					object_source += '\n';
+				}
+				else
+				{
+					// Definition not found, replace `#pragma define <key>` with the comment `/* #undef <key> */`.
+					object_source += "/* #undef ";
+					object_source += segment.text;
+					object_source += " */\n";
+				}
+				break;
+			}
+		}
+	}
 	
-	// Join vector of source lines into single string
-	std::ostringstream stream;
-	std::copy(template_source.begin(), template_source.end(), std::ostream_iterator<std::string>(stream, "\n"));
-	return stream.str();
+	return object_source;
 }
 
 gl::shader_object* shader_template::compile(gl::shader_stage stage, const dictionary_type& definitions) const
@@ -99,117 +168,96 @@ gl::shader_object* shader_template::compile(gl::shader_stage stage, const dictio
 	return object;
 }
 
-gl::shader_program* shader_template::build(const dictionary_type& definitions) const
+gl::shader_program* shader_template::build(const dictionary_type& definitions, shader_cache* cache) const
 {
-	gl::shader_object* vertex_object = nullptr;
-	gl::shader_object* fragment_object = nullptr;
-	gl::shader_object* geometry_object = nullptr;
-	
-	// Create shader program
-	gl::shader_program* program = new gl::shader_program();
+	const auto start = std::chrono::steady_clock::now();
 	
-	if (has_vertex_directive())
+	// Configure the source of each stage once, for both the cache key and compilation
+	const gl::shader_stage stages[] = {gl::shader_stage::vertex, gl::shader_stage::fragment, gl::shader_stage::geometry};
+	const bool stage_directives[] = {vertex_directive, fragment_directive, geometry_directive};
+	std::string object_sources[3];
+	for (std::size_t i = 0; i < 3; ++i)
 	{
-		// Compile vertex shader object and attach to shader program
-		vertex_object = compile(gl::shader_stage::vertex, definitions);
-		program->attach(vertex_object);
+		if (stage_directives[i])
+			object_sources[i] = configure(stages[i], definitions);
 	}
 	
-	if (has_fragment_directive())
+	// Load cached program binary, keyed by the configured source of each stage
+	std::uint64_t cache_key = 0;
+	if (cache && gl::shader_program::is_binary_supported())
 	{
-		// Compile fragment shader object and attach to shader program
-		fragment_object = compile(gl::shader_stage::fragment, definitions);
-		program->attach(fragment_object);
+		cache_key = cache->key(object_sources[0] + object_sources[1] + object_sources[2]);
+		if (gl::shader_program* program = cache->load(cache_key))
+		{
+			debug::startup_profiler::record_shader_program(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(), true);
+			return program;
+		}
 	}
-	
-	if (has_geometry_directive())
+	else
 	{
-		// Compile fragment shader object and attach to shader program
-		geometry_object = compile(gl::shader_stage::geometry, definitions);
-		program->attach(geometry_object);
+		cache = nullptr;
 	}
 	
-	// Link attached shader objects into shader program
-	program->link();
-	
-	if (vertex_object)
+	// Start compiling every shader object before waiting on any, so drivers which compile in the background can compile them concurrently
+	gl::shader_object* objects[3] = {nullptr, nullptr, nullptr};
+	for (std::size_t i = 0; i < 3; ++i)
 	{
-		// Detach and delete vertex shader object
-		program->detach(vertex_object);
-		delete vertex_object;
+		if (stage_directives[i])
+		{
+			objects[i] = new gl::shader_object(stages[i]);
+			objects[i]->source(object_sources[i]);
+			objects[i]->compile_async();
+		}
 	}
 	
-	if (fragment_object)
-	{
-		// Detach and delete fragment shader object
-		program->detach(fragment_object);
-		delete fragment_object;
-	}
+	// Create shader program
+	gl::shader_program* program = new gl::shader_program();
 	
-	if (geometry_object)
+	// Finish compiling shader objects and attach them to the shader program
+	for (gl::shader_object* object: objects)
 	{
-		// Detach and delete geometry shader object
-		program->detach(geometry_object);
-		delete geometry_object;
+		if (object)
+		{
+			object->compile();
+			program->attach(object);
+		}
 	}
 	
-	return program;
-}
-
-void shader_template::replace_stage_directives(gl::shader_stage stage) const
-{
-	// Determine stage directives according to the shader stage being generated
-	const std::string vertex_directive = (stage == gl::shader_stage::vertex) ? "#define __VERTEX__" : "/* #undef __VERTEX__ */";
-	const std::string fragment_directive = (stage == gl::shader_stage::fragment) ? "#define __FRAGMENT__" : "/* #undef __FRAGMENT__ */";
-	const std::string geometry_directive = (stage == gl::shader_stage::geometry) ? "#define __GEOMETRY__" : "/* #undef __GEOMETRY__ */";
-	
-	// Handle `#pragma <stage>` directives
-	for (std::size_t i: vertex_directives)
-		template_source[i] = vertex_directive;
-	for (std::size_t i: fragment_directives)
-		template_source[i] = fragment_directive;
-	for (std::size_t i: geometry_directives)
-		template_source[i] = geometry_directive;
-}
-
-void shader_template::replace_define_directives(const dictionary_type& definitions) const
-{
-	// For each `#pragma define <key>` directive
-	for (const auto& define_directive: define_directives)
+	// Link attached shader objects into shader program
+	program->link();
+	
+	// Detach and delete shader objects
+	for (gl::shader_object* object: objects)
 	{
-		// Get a reference to the directive line
-		std::string& line = template_source[define_directive.second];
-		
-		// Check if the corresponding definition was given by the configuration
-		auto definitions_it = definitions.find(define_directive.first);
-		if (definitions_it != definitions.end())
+		if (object)
 		{
-			// Definition found, Replace `#pragma define <key>` with `#define <key>` or `#define <key> <value>`
-			line = "#define " + define_directive.first;
-			if (!definitions_it->second.empty())
-				line += " " + definitions_it->second;
-		}
-		else
-		{
-			// Definition not found, replace `#pragma define <key>` with the comment `/* #undef <key> */`.
-			line = "/* #undef " + define_directive.first + " */";
+			program->detach(object);
+			delete object;
 		}
 	}
+	
+	// Cache program binary
+	if (cache && program->was_linked())
+		cache->store(cache_key, *program);
+	
+	debug::startup_profiler::record_shader_program(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(), false);
+	
+	return program;
 }
 
 bool shader_template::has_vertex_directive() const
 {
-	return !vertex_directives.empty();
+	return vertex_directive;
 }
 
 bool shader_template::has_fragment_directive() const
 {
-	return !fragment_directives.empty();
+	return fragment_directive;
 }
 
 bool shader_template::has_geometry_directive() const
 {
-	return !geometry_directives.empty();
+	return geometry_directive;
 }
 
 bool shader_template::has_define_directive(const std::string& key) const
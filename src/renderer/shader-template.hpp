@@ -22,11 +22,14 @@
 
 #include "gl/shader-object.hpp"
 #include "gl/shader-program.hpp"
-#include <map>
+#include <cstddef>
 #include <string>
+#include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
+class shader_cache;
+
 /**
  * Shader templates can be used to generate multiple shader variants from a single source.
  *
@@ -37,6 +40,8 @@
  * * `#pragma geometry`: Replaced with `#define __GEOMETRY__` when generating geometry shader objects.
  * * `#pragma define <key> <value>`: Will be replaced with `#define <key> <value>` if its definition is passed to the shader template.
  *
+ * The source is parsed once into segments of verbatim text separated by directives, from which each variant is configured by splicing the segments together with the replacement of each directive.
+ *
  * @see gl::shader_stage
  * @see gl::shader_object
  * @see gl::shader_program
@@ -91,7 +96,10 @@ public:
 	/**
 	 * Configures and compiles shader objects, then links them into a shader program. Shader object stages are determined according to the presence of `#pragma <stage>` directives.
 	 *
+	 * If a shader cache is given, the program is loaded from its cached binary instead, when available, and the binary of a newly linked program is added to the cache.
+	 *
 	 * @param definitions Container of definitions used to replace `#pragma define <key> <value>` directives.
+	 * @param cache Shader cache, or `nullptr` to always compile and link.
 	 * @return Linked shader program.
 	 *
 	 * @exception std::runtime_error Any exceptions thrown by gl::shader_object or gl::shader_program.
@@ -100,7 +108,7 @@ public:
 	 * @see has_fragment_directive() const
 	 * @see has_geometry_directive() const
 	 */
-	gl::shader_program* build(const dictionary_type& definitions) const;
+	gl::shader_program* build(const dictionary_type& definitions, shader_cache* cache = nullptr) const;
 	
 	/// Returns `true` if the template source contains one or more `#pragma vertex` directive.
 	bool has_vertex_directive() const;
@@ -119,14 +127,40 @@ public:
 	bool has_define_directive(const std::string& key) const;
 	
 private:
-	void replace_stage_directives(gl::shader_stage stage) const;
-	void replace_define_directives(const dictionary_type& definitions) const;
+	/// Type of a template source segment.
+	enum class segment_type
+	{
+		/// Verbatim source text, consisting of one or more complete lines.
+		text,
+		
+		/// `#pragma vertex` directive.
+		vertex,
+		
+		/// `#pragma fragment` directive.
+		fragment,
+		
+		/// `#pragma geometry` directive.
+		geometry,
+		
+		/// `#pragma define <key>` directive.
+		define
+	};
+	
+	/// Template source segment.
+	struct segment
+	{
+		segment_type type;
+		
+		/// Source text of a text segment, or the key of a define directive.
+		std::string text;
+	};
 	
-	mutable std::vector<std::string> template_source;
-	std::unordered_set<std::size_t> vertex_directives;
-	std::unordered_set<std::size_t> fragment_directives;
-	std::unordered_set<std::size_t> geometry_directives;
-	std::multimap<std::string, std::size_t> define_directives;
+	std::vector<segment> segments;
+	std::size_t text_size;
+	bool vertex_directive;
+	bool fragment_directive;
+	bool geometry_directive;
+	std::unordered_set<std::string> define_directives;
 };
 
 #endif // ANTKEEPER_SHADER_TEMPLATE_HPP
@@ -34,7 +34,6 @@
 #include "renderer/material.hpp"
 #include "renderer/material-property.hpp"
 #include "math/math.hpp"
-#include <glad/glad.h>
 
 simple_render_pass::simple_render_pass(gl::rasterizer* rasterizer, const gl::framebuffer* framebuffer, gl::shader_program* shader_program):
 	render_pass(rasterizer, framebuffer),
@@ -80,11 +79,10 @@ void simple_render_pass::render(render_context* context) const
 	rasterizer->use_framebuffer(*framebuffer);
 	
 	// Setup graphics context
-	glDisable(GL_BLEND);
-	glDisable(GL_DEPTH_TEST);
-	glDepthMask(GL_FALSE);
-	glEnable(GL_CULL_FACE);
-	glCullFace(GL_BACK);
+	gl::render_state state;
+	state.depth_write_enabled = false;
+	state.cull_enabled = true;
+	rasterizer->set_render_state(state);
 
 	// Setup viewport
 	auto viewport = framebuffer->get_dimensions();
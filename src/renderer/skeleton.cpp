@@ -0,0 +1,42 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "renderer/skeleton.hpp"
+#include "math/math.hpp"
+#include <stdexcept>
+
+std::size_t skeleton::add_bone(std::uint16_t parent, const math::transform<float>& bind_transform)
+{
+	if (parents.size() >= max_bone_count)
+		throw std::length_error("Skeleton bone count exceeds the maximum bone count");
+	if (parent != no_parent && parent >= parents.size())
+		throw std::invalid_argument("Skeleton bone parent must precede its children");
+	
+	// Accumulate the model-space transform of the bone in the bind pose
+	float4x4 bind_matrix = math::matrix_cast(bind_transform);
+	if (parent != no_parent)
+		bind_matrix = bind_matrices[parent] * bind_matrix;
+	
+	parents.push_back(parent);
+	bind_transforms.push_back(bind_transform);
+	bind_matrices.push_back(bind_matrix);
+	inverse_bind_matrices.push_back(math::inverse(bind_matrix));
+	
+	return parents.size() - 1;
+}
@@ -0,0 +1,96 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ANTKEEPER_SKELETON_HPP
+#define ANTKEEPER_SKELETON_HPP
+
+#include "math/transform-type.hpp"
+#include "utility/fundamental-types.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Hierarchy of bones, with the bind pose in which skinned geometry was modeled.
+ *
+ * Bones are stored in an order in which each parent bone precedes its children, so that the transforms of a pose can be accumulated in a single sweep.
+ */
+class skeleton
+{
+public:
+	/// Parent index of root bones.
+	static constexpr std::uint16_t no_parent = 0xffff;
+	
+	/// Maximum number of bones, by which a bone palette fits within the minimum uniform block size of 16 KiB.
+	static constexpr std::size_t max_bone_count = 256;
+	
+	/**
+	 * Adds a bone to the skeleton.
+	 *
+	 * @param parent Index of the parent bone, which must have been added before the bone, or skeleton::no_parent if the bone is a root bone.
+	 * @param bind_transform Transform of the bone relative to its parent, in the bind pose.
+	 * @return Index of the added bone.
+	 *
+	 * @exception std::length_error The skeleton already contains skeleton::max_bone_count bones.
+	 * @exception std::invalid_argument The parent bone has not been added.
+	 */
+	std::size_t add_bone(std::uint16_t parent, const math::transform<float>& bind_transform);
+	
+	/// Returns the number of bones in the skeleton.
+	std::size_t get_bone_count() const;
+	
+	/// Returns the index of the parent of a bone, or skeleton::no_parent if the bone is a root bone.
+	std::uint16_t get_parent(std::size_t bone) const;
+	
+	/// Returns the transform of a bone relative to its parent, in the bind pose.
+	const math::transform<float>& get_bind_transform(std::size_t bone) const;
+	
+	/// Returns the matrix which transforms vertices from model space into the space of a bone in the bind pose.
+	const float4x4& get_inverse_bind_matrix(std::size_t bone) const;
+	
+private:
+	std::vector<std::uint16_t> parents;
+	std::vector<math::transform<float>> bind_transforms;
+	
+	/// Model-space transforms of bones in the bind pose.
+	std::vector<float4x4> bind_matrices;
+	std::vector<float4x4> inverse_bind_matrices;
+};
+
+inline std::size_t skeleton::get_bone_count() const
+{
+	return parents.size();
+}
+
+inline std::uint16_t skeleton::get_parent(std::size_t bone) const
+{
+	return parents[bone];
+}
+
+inline const math::transform<float>& skeleton::get_bind_transform(std::size_t bone) const
+{
+	return bind_transforms[bone];
+}
+
+inline const float4x4& skeleton::get_inverse_bind_matrix(std::size_t bone) const
+{
+	return inverse_bind_matrices[bone];
+}
+
+#endif // ANTKEEPER_SKELETON_HPP
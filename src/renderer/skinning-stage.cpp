@@ -0,0 +1,180 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "renderer/skinning-stage.hpp"
+#include "renderer/pose.hpp"
+#include "utility/job-system.hpp"
+#include "math/math.hpp"
+#include "debug/profiler.hpp"
+#include <algorithm>
+#include <limits>
+
+skinning_stage::skinning_stage():
+	jobs(nullptr),
+	half_rate_distance(std::numeric_limits<float>::infinity()),
+	quarter_rate_distance(std::numeric_limits<float>::infinity()),
+	frame(0),
+	alignment(0),
+	ring_index(0),
+	cache_count(0),
+	uploaded_size(0)
+{}
+
+skinning_stage::~skinning_stage()
+{}
+
+void skinning_stage::set_job_system(job_system* jobs)
+{
+	this->jobs = jobs;
+}
+
+void skinning_stage::set_lod_distances(float half_rate_distance, float quarter_rate_distance)
+{
+	this->half_rate_distance = half_rate_distance;
+	this->quarter_rate_distance = quarter_rate_distance;
+}
+
+void skinning_stage::begin_frame()
+{
+	++frame;
+	ring_index = (ring_index + 1) % ring_size;
+	pending_poses.clear();
+	palettes.clear();
+	uploaded_size = 0;
+	
+	// Evict the caches of poses which were not rendered in the previous frame
+	for (auto it = caches.begin(); it != caches.end();)
+	{
+		if (it->second.added_frame + 1 < frame)
+			it = caches.erase(it);
+		else
+			++it;
+	}
+}
+
+std::size_t skinning_stage::add_pose(const pose* pose, float distance)
+{
+	auto [it, inserted] = caches.try_emplace(pose);
+	pose_cache& cache = it->second;
+	if (!inserted && cache.added_frame == frame)
+		return cache.offset;
+	
+	// Query the range offset alignment before the first palette is placed
+	if (!alignment)
+		alignment = std::max<std::size_t>(sizeof(float4x4), gl::uniform_buffer::get_offset_alignment());
+	
+	// Select the evaluation interval of the pose by its distance
+	const std::size_t interval = (distance > quarter_rate_distance) ? 4 : (distance > half_rate_distance) ? 2 : 1;
+	
+	if (inserted)
+		cache.phase = cache_count++;
+	
+	// Evaluate poses which were not rendered in the previous frame, or whose bone count has changed, at once
+	const bool stale = inserted || cache.added_frame + 1 != frame || cache.current.size() != pose->get_bone_count();
+	cache.evaluate = stale || interval == 1 || (frame + cache.phase) % interval == 0;
+	if (stale)
+		cache.interval = 1;
+	else if (cache.evaluate)
+		cache.interval = interval;
+	cache.added_frame = frame;
+	
+	// Place the palette at the next aligned offset
+	cache.offset = (palettes.size() * sizeof(float4x4) + alignment - 1) / alignment * alignment;
+	palettes.resize((cache.offset + get_palette_size(*pose)) / sizeof(float4x4));
+	
+	pending_poses.emplace_back(pose, &cache);
+	
+	return cache.offset;
+}
+
+void skinning_stage::upload()
+{
+	if (pending_poses.empty())
+		return;
+	
+	debug::profile_zone zone("skinning_stage::upload");
+	
+	// Evaluate or interpolate the palettes of pending poses
+	auto evaluate = [this](std::size_t first, std::size_t last)
+	{
+		for (std::size_t i = first; i < last; ++i)
+		{
+			const pose* pose = pending_poses[i].first;
+			pose_cache& cache = *pending_poses[i].second;
+			float4x4* palette = palettes.data() + cache.offset / sizeof(float4x4);
+			const std::size_t bone_count = pose->get_bone_count();
+			
+			if (cache.evaluate)
+			{
+				cache.current.swap(cache.previous);
+				cache.current.resize(bone_count);
+				pose->evaluate(cache.current.data());
+				cache.evaluated_frame = frame;
+				
+				// Restart interpolation from the current palette if there is no previous evaluation to trail
+				if (cache.interval == 1 || cache.previous.size() != bone_count)
+				{
+					cache.previous = cache.current;
+					std::copy(cache.current.begin(), cache.current.end(), palette);
+					continue;
+				}
+			}
+			
+			// Trail the most recent evaluation by one interval
+			const float t = std::min(1.0f, static_cast<float>(frame - cache.evaluated_frame) / static_cast<float>(cache.interval));
+			for (std::size_t j = 0; j < bone_count; ++j)
+				palette[j] = cache.previous[j] + (cache.current[j] - cache.previous[j]) * t;
+		}
+	};
+	if (jobs)
+		jobs->parallel_for(0, pending_poses.size(), 8, evaluate);
+	else
+		evaluate(0, pending_poses.size());
+	
+	const std::size_t size = palettes.size() * sizeof(float4x4);
+	std::unique_ptr<gl::uniform_buffer>& buffer = buffers[ring_index];
+	if (!buffer || buffer->get_size() < size)
+	{
+		// Grow the buffer, with room for more poses in later frames, and upload all palettes of the current frame
+		const std::size_t capacity = std::max(size + size / 2, sizeof(float4x4) * 256);
+		if (!buffer)
+			buffer = std::make_unique<gl::uniform_buffer>(capacity, nullptr, gl::buffer_usage::stream_draw);
+		else
+			buffer->resize(capacity);
+		buffer->update(0, size, palettes.data());
+	}
+	else
+	{
+		// Upload only the palettes added since the previous upload
+		buffer->update(static_cast<int>(uploaded_size), size - uploaded_size, reinterpret_cast<const char*>(palettes.data()) + uploaded_size);
+	}
+	
+	uploaded_size = size;
+	pending_poses.clear();
+}
+
+const gl::uniform_buffer* skinning_stage::get_buffer() const
+{
+	return buffers[ring_index].get();
+}
+
+std::size_t skinning_stage::get_palette_size(const pose& pose)
+{
+	return pose.get_bone_count() * sizeof(float4x4);
+}
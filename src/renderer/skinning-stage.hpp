@@ -0,0 +1,148 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ANTKEEPER_SKINNING_STAGE_HPP
+#define ANTKEEPER_SKINNING_STAGE_HPP
+
+#include "gl/uniform-buffer.hpp"
+#include "utility/fundamental-types.hpp"
+#include <cstddef>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+class pose;
+class job_system;
+
+/**
+ * Evaluates the bone palettes of the poses rendered in a frame, and uploads them to a uniform buffer shared by all render passes.
+ *
+ * Each pose is evaluated at most once per frame, however many operations, passes, and cameras render it, and the palettes of poses added since the previous upload are evaluated in parallel if a job system has been set. Palettes are packed into one of a ring of uniform buffers, so that the buffer written in one frame is not one which the GPU may still be reading from the previous frames. Skinned shader programs declare the palette as a uniform block named `bone_palette_block`, containing an array of up to skeleton::max_bone_count `mat4` matrices, bound to skinning_stage::bone_palette_binding.
+ *
+ * Poses are only added by the operations of visible model instances, so culled poses are never evaluated. Distant poses are evaluated at reduced rates, every second or fourth frame, staggered so that they are not all evaluated on the same frames. Between evaluations, the palette of a distant pose is interpolated from its second most recent evaluation toward its most recent evaluation, trailing the pose by one evaluation interval so that its motion remains continuous. Poses which were not rendered in the previous frame are evaluated immediately when they are rendered again.
+ */
+class skinning_stage
+{
+public:
+	/// Index of the uniform buffer binding point of bone palettes.
+	static constexpr unsigned int bone_palette_binding = 3;
+	
+	/// Number of uniform buffers in the ring.
+	static constexpr std::size_t ring_size = 3;
+	
+	skinning_stage();
+	~skinning_stage();
+	
+	skinning_stage(const skinning_stage&) = delete;
+	skinning_stage& operator=(const skinning_stage&) = delete;
+	
+	/**
+	 * Sets the job system on which bone palettes are evaluated.
+	 *
+	 * @param jobs Job system, or `nullptr` to evaluate bone palettes on the rendering thread.
+	 */
+	void set_job_system(job_system* jobs);
+	
+	/// Begins a new frame, discarding the palettes of the previous frame and advancing to the next uniform buffer of the ring.
+	void begin_frame();
+	
+	/**
+	 * Adds a pose to the current frame, if it has not already been added.
+	 *
+	 * @param pose Pose to add.
+	 * @param distance Distance from the camera to the posed model instance, by which the evaluation rate of the pose is selected the first time it is added in a frame.
+	 * @return Offset of the bone palette of the pose in the uniform buffer of the current frame, in bytes.
+	 */
+	std::size_t add_pose(const pose* pose, float distance = 0.0f);
+	
+	/**
+	 * Sets the distances beyond which poses are evaluated at reduced rates.
+	 *
+	 * @param half_rate_distance Distance beyond which poses are evaluated every second frame.
+	 * @param quarter_rate_distance Distance beyond which poses are evaluated every fourth frame.
+	 */
+	void set_lod_distances(float half_rate_distance, float quarter_rate_distance);
+	
+	/// Evaluates the bone palettes of the poses added since the previous upload, and uploads them to the uniform buffer of the current frame. Must be called by the thread which owns the OpenGL context.
+	void upload();
+	
+	/// Returns the uniform buffer of the current frame, or `nullptr` if no palettes have been uploaded.
+	const gl::uniform_buffer* get_buffer() const;
+	
+	/// Returns the size of the bone palette of a pose, in bytes.
+	static std::size_t get_palette_size(const pose& pose);
+	
+private:
+	/// Bone palettes of a pose, retained across frames.
+	struct pose_cache
+	{
+		/// Most recent and second most recent evaluated palettes.
+		std::vector<float4x4> current;
+		std::vector<float4x4> previous;
+		
+		/// Frame on which the pose was most recently evaluated.
+		std::size_t evaluated_frame;
+		
+		/// Frame on which the pose was most recently added.
+		std::size_t added_frame;
+		
+		/// Number of frames between evaluations.
+		std::size_t interval;
+		
+		/// Offset of the evaluation frames of the pose, by which reduced-rate evaluations are staggered.
+		std::size_t phase;
+		
+		/// `true` if the pose must be evaluated in the current frame.
+		bool evaluate;
+		
+		/// Offset of the bone palette in the uniform buffer of the current frame, in bytes.
+		std::size_t offset;
+	};
+	
+	job_system* jobs;
+	float half_rate_distance;
+	float quarter_rate_distance;
+	
+	/// Index of the current frame.
+	std::size_t frame;
+	
+	/// Offset alignment of uniform buffer ranges, queried on the first upload.
+	std::size_t alignment;
+	
+	std::unique_ptr<gl::uniform_buffer> buffers[ring_size];
+	std::size_t ring_index;
+	
+	/// Caches of the poses rendered in the current or previous frame.
+	std::unordered_map<const pose*, pose_cache> caches;
+	
+	/// Number of poses cached so far, by which the phases of new caches are assigned.
+	std::size_t cache_count;
+	
+	/// Poses added since the previous upload.
+	std::vector<std::pair<const pose*, pose_cache*>> pending_poses;
+	
+	/// Bone palettes of the current frame, in the layout of the uniform buffer.
+	std::vector<float4x4> palettes;
+	
+	/// Number of bytes of the current frame which have been uploaded.
+	std::size_t uploaded_size;
+};
+
+#endif // ANTKEEPER_SKINNING_STAGE_HPP
@@ -0,0 +1,73 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ANTKEEPER_SORT_KEY_HPP
+#define ANTKEEPER_SORT_KEY_HPP
+
+#include <cstdint>
+#include <cstring>
+
+/// Functions for packing render state into 64-bit render operation sort keys.
+namespace sort_key {
+
+/**
+ * Maps a depth value to an unsigned integer which preserves the ordering of the depth values.
+ *
+ * @param depth Depth value.
+ * @param bits Number of bits in the quantized depth. Lower-order bits of the depth are discarded.
+ * @return Quantized depth, in the lower @p bits bits of the result.
+ */
+std::uint64_t quantize_depth(float depth, unsigned int bits) noexcept;
+
+/**
+ * Folds an object address into a small identifier which groups operations referencing the same object.
+ *
+ * @param object Object address.
+ * @param bits Number of bits in the identifier.
+ * @return Identifier, in the lower @p bits bits of the result. Distinct objects may share an identifier.
+ */
+std::uint64_t hash_pointer(const void* object, unsigned int bits) noexcept;
+
+inline std::uint64_t quantize_depth(float depth, unsigned int bits) noexcept
+{
+	std::uint32_t x;
+	std::memcpy(&x, &depth, sizeof(x));
+	
+	// Flip all bits of negative values and the sign bit of positive values
+	x ^= (x & 0x80000000) ? 0xffffffff : 0x80000000;
+	
+	return static_cast<std::uint64_t>(x >> (32 - bits));
+}
+
+inline std::uint64_t hash_pointer(const void* object, unsigned int bits) noexcept
+{
+	std::uint64_t x = static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(object));
+	
+	// Discard alignment bits, then fold the upper bits into the lower bits
+	x >>= 4;
+	for (unsigned int shift = bits; shift < 64; shift += bits)
+		x ^= x >> shift;
+	
+	return x & ((std::uint64_t(1) << bits) - 1);
+}
+
+} // namespace sort_key
+
+#endif // ANTKEEPER_SORT_KEY_HPP
+
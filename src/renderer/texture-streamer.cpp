@@ -0,0 +1,210 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "renderer/texture-streamer.hpp"
+#include "renderer/material.hpp"
+#include "renderer/material-property.hpp"
+#include "gl/texture-2d.hpp"
+#include <algorithm>
+#include <cmath>
+
+texture_streamer::texture_streamer():
+	memory_budget(256 * 1024 * 1024),
+	upload_budget(4 * 1024 * 1024),
+	eviction_delay(300),
+	resident_size(0),
+	frame(0)
+{}
+
+void texture_streamer::set_memory_budget(std::size_t budget)
+{
+	memory_budget = budget;
+}
+
+void texture_streamer::set_upload_budget(std::size_t budget)
+{
+	upload_budget = budget;
+}
+
+void texture_streamer::set_eviction_delay(std::size_t delay)
+{
+	eviction_delay = delay;
+}
+
+gl::texture_2d* texture_streamer::create_texture(resource_ptr<compressed_image> image)
+{
+	// Find the finest level which fits within the coarse level size
+	const std::size_t level_count = image->get_level_count();
+	std::size_t coarse_level = 0;
+	while (coarse_level + 1 < level_count && std::max(image->get_width() >> coarse_level, image->get_height() >> coarse_level) > coarse_level_size)
+		++coarse_level;
+	
+	gl::texture_2d* texture = new gl::texture_2d(image->get_width(), image->get_height(), image->get_format(), image->get_color_space(), level_count, image->get_level_data(), image->get_level_sizes(), coarse_level);
+	resident_size += texture->get_size();
+	
+	streamed_texture& entry = textures[texture];
+	entry.texture = texture;
+	entry.image = std::move(image);
+	entry.coarse_level = coarse_level;
+	entry.footprint = 0.0f;
+	entry.used_frame = frame;
+	
+	return texture;
+}
+
+void texture_streamer::remove_texture(const gl::texture_2d* texture)
+{
+	if (auto it = textures.find(texture); it != textures.end())
+	{
+		resident_size -= it->second.texture->get_size();
+		textures.erase(it);
+	}
+}
+
+void texture_streamer::clear()
+{
+	textures.clear();
+	material_footprints.clear();
+	resident_size = 0;
+}
+
+void texture_streamer::add_usage(const material* material, float footprint)
+{
+	float& material_footprint = material_footprints[material];
+	material_footprint = std::max(material_footprint, footprint);
+}
+
+void texture_streamer::update()
+{
+	// Find the largest footprint of each streamed texture among the materials drawn this frame
+	for (const auto& [material, footprint]: material_footprints)
+	{
+		for (const material_property_base* property: *material->get_properties())
+		{
+			if (property->get_data_type() != gl::shader_variable_type::texture_2d)
+				continue;
+			
+			const auto* texture_property = static_cast<const material_property<const gl::texture_2d*>*>(property);
+			for (std::size_t i = 0; i < texture_property->get_element_count(); ++i)
+			{
+				if (auto it = textures.find(texture_property->get_value(i)); it != textures.end())
+				{
+					it->second.footprint = std::max(it->second.footprint, footprint);
+					it->second.used_frame = frame;
+				}
+			}
+		}
+	}
+	material_footprints.clear();
+	
+	// Request the levels needed by used textures, and evict the fine levels of unused textures
+	requests.clear();
+	for (auto& [key, entry]: textures)
+	{
+		const std::size_t base_level = entry.texture->get_base_level();
+		
+		if (frame - entry.used_frame > eviction_delay)
+		{
+			if (base_level < entry.coarse_level)
+				set_base_level(entry, entry.coarse_level);
+		}
+		else if (entry.footprint > 0.0f)
+		{
+			// Select the level whose texels are closest to one per pixel of the footprint
+			const float texture_size = static_cast<float>(std::max(entry.image->get_width(), entry.image->get_height()));
+			const float level = std::floor(std::log2(texture_size / entry.footprint));
+			const std::size_t needed_level = (level > 0.0f) ? std::min(static_cast<std::size_t>(level), entry.coarse_level) : 0;
+			
+			if (needed_level < base_level)
+			{
+				requests.emplace_back(base_level - needed_level, &entry);
+			}
+			else if (needed_level > base_level + 1)
+			{
+				// Keep one level finer than needed, so textures near the boundary aren't repeatedly evicted and uploaded
+				set_base_level(entry, needed_level - 1);
+			}
+		}
+		
+		entry.footprint = 0.0f;
+	}
+	
+	// Upload one level per texture, starting with the textures which lack the most levels
+	std::sort(requests.begin(), requests.end(),
+		[](const auto& a, const auto& b)
+		{
+			return a.first > b.first;
+		});
+	
+	std::size_t uploaded_size = 0;
+	for (const auto& [missing_level_count, entry]: requests)
+	{
+		const std::size_t level = entry->texture->get_base_level() - 1;
+		const std::size_t level_size = entry->image->get_level_sizes()[level];
+		
+		// Always upload at least one level, so levels larger than the upload budget are eventually uploaded
+		if (uploaded_size && uploaded_size + level_size > upload_budget)
+			break;
+		
+		if (!reserve(level_size, entry))
+			continue;
+		
+		set_base_level(*entry, level);
+		uploaded_size += level_size;
+	}
+	
+	++frame;
+}
+
+void texture_streamer::set_base_level(streamed_texture& entry, std::size_t level)
+{
+	resident_size -= entry.texture->get_size();
+	entry.texture->set_base_level(level, entry.image->get_level_data(), entry.image->get_level_sizes());
+	resident_size += entry.texture->get_size();
+}
+
+bool texture_streamer::reserve(std::size_t size, const streamed_texture* keep)
+{
+	if (resident_size + size <= memory_budget)
+		return true;
+	
+	// Collect the textures with evictable levels which weren't used this frame
+	eviction_candidates.clear();
+	for (auto& [key, entry]: textures)
+	{
+		if (&entry != keep && entry.used_frame != frame && entry.texture->get_base_level() < entry.coarse_level)
+			eviction_candidates.push_back(&entry);
+	}
+	
+	std::sort(eviction_candidates.begin(), eviction_candidates.end(),
+		[](const streamed_texture* a, const streamed_texture* b)
+		{
+			return a->used_frame < b->used_frame;
+		});
+	
+	for (streamed_texture* candidate: eviction_candidates)
+	{
+		set_base_level(*candidate, candidate->coarse_level);
+		if (resident_size + size <= memory_budget)
+			return true;
+	}
+	
+	return false;
+}
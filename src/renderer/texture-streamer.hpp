@@ -0,0 +1,168 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ANTKEEPER_TEXTURE_STREAMER_HPP
+#define ANTKEEPER_TEXTURE_STREAMER_HPP
+
+#include "resources/compressed-image.hpp"
+#include "resources/resource-ptr.hpp"
+#include <cstddef>
+#include <unordered_map>
+#include <vector>
+
+class material;
+
+namespace gl
+{
+	class texture_2d;
+}
+
+/**
+ * Streams the mip levels of compressed textures within a GPU memory budget.
+ *
+ * Streamed textures are created with only their coarse levels resident, which are never evicted. Material passes report the screen-space footprint of each drawn material, from which update() selects the finest level each texture of the material needs, assuming its texture coordinates span the texture once across the bounds of the drawn object. Needed levels are uploaded one level per texture per update, most needed first, within a per-update upload budget. Levels finer than needed are evicted once their texture has gone unused for the eviction delay, or sooner if the memory budget would otherwise be exceeded, least recently used textures first.
+ *
+ * The compressed images of streamed textures are retained in CPU memory, from which levels are uploaded when they are needed again.
+ */
+class texture_streamer
+{
+public:
+	texture_streamer();
+	
+	texture_streamer(const texture_streamer&) = delete;
+	texture_streamer& operator=(const texture_streamer&) = delete;
+	
+	/**
+	 * Sets the GPU memory budget of the resident levels of all streamed textures.
+	 *
+	 * @param budget Budget, in bytes.
+	 */
+	void set_memory_budget(std::size_t budget);
+	
+	/**
+	 * Sets the maximum number of bytes uploaded by each update.
+	 *
+	 * @param budget Upload budget, in bytes.
+	 */
+	void set_upload_budget(std::size_t budget);
+	
+	/**
+	 * Sets the number of updates a texture must go unused before its fine levels are evicted.
+	 *
+	 * @param delay Eviction delay, in updates.
+	 */
+	void set_eviction_delay(std::size_t delay);
+	
+	/**
+	 * Creates a streamed texture from a compressed image. Must be called by the thread which owns the OpenGL context.
+	 *
+	 * @param image Compressed image with a mip chain, which is retained until the texture is removed.
+	 * @return Texture with only its coarse levels resident.
+	 */
+	gl::texture_2d* create_texture(resource_ptr<compressed_image> image);
+	
+	/**
+	 * Stops streaming a texture and releases its compressed image. Must be called before the texture is deleted.
+	 *
+	 * @param texture Streamed texture.
+	 */
+	void remove_texture(const gl::texture_2d* texture);
+	
+	/**
+	 * Stops streaming all textures, without deleting them, and releases their compressed images.
+	 */
+	void clear();
+	
+	/**
+	 * Records the screen-space footprint of a material drawn in the current frame.
+	 *
+	 * @param material Drawn material.
+	 * @param footprint Projected diameter of the drawn object, in pixels.
+	 */
+	void add_usage(const material* material, float footprint);
+	
+	/**
+	 * Uploads and evicts levels according to the usage of the current frame, then begins a new frame. Must be called by the thread which owns the OpenGL context, after the frame has been rendered.
+	 */
+	void update();
+	
+	/// Returns the number of bytes occupied by the resident levels of all streamed textures.
+	std::size_t get_resident_size() const;
+	
+	/// Returns the number of streamed textures.
+	std::size_t get_texture_count() const;
+	
+	/// Width or height, in pixels, of the largest level which remains resident while a texture is unused.
+	static constexpr unsigned int coarse_level_size = 64;
+	
+private:
+	struct streamed_texture
+	{
+		gl::texture_2d* texture;
+		resource_ptr<compressed_image> image;
+		
+		/// Index of the finest level which is never evicted.
+		std::size_t coarse_level;
+		
+		/// Largest footprint of the texture in the current frame, in pixels.
+		float footprint;
+		
+		/// Frame in which the texture was most recently used.
+		std::size_t used_frame;
+	};
+	
+	/// Makes a level of a streamed texture its finest resident level.
+	void set_base_level(streamed_texture& entry, std::size_t level);
+	
+	/**
+	 * Evicts levels from unused textures, least recently used first, until the resident levels and an allocation of @p size bytes fit the memory budget.
+	 *
+	 * @param size Size of the allocation, in bytes.
+	 * @param keep Texture whose levels must not be evicted.
+	 * @return `true` if the allocation fits the budget.
+	 */
+	bool reserve(std::size_t size, const streamed_texture* keep);
+	
+	std::size_t memory_budget;
+	std::size_t upload_budget;
+	std::size_t eviction_delay;
+	std::size_t resident_size;
+	std::size_t frame;
+	
+	std::unordered_map<const gl::texture_2d*, streamed_texture> textures;
+	
+	/// Largest footprint of each material drawn in the current frame.
+	std::unordered_map<const material*, float> material_footprints;
+	
+	/// Streamed textures which need finer levels, reused across updates.
+	std::vector<std::pair<std::size_t, streamed_texture*>> requests;
+	std::vector<streamed_texture*> eviction_candidates;
+};
+
+inline std::size_t texture_streamer::get_resident_size() const
+{
+	return resident_size;
+}
+
+inline std::size_t texture_streamer::get_texture_count() const
+{
+	return textures.size();
+}
+
+#endif // ANTKEEPER_TEXTURE_STREAMER_HPP
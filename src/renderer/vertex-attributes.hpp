@@ -47,5 +47,17 @@
 /// Vertex morph target (vec3)
 #define VERTEX_TARGET_LOCATION 8
 
+/// Instance position (vec3), advanced once per instance
+#define VERTEX_INSTANCE_POSITION_LOCATION 9
+
+/// Instance normal and scale (vec4), as signed bytes, advanced once per instance
+#define VERTEX_INSTANCE_NORMAL_LOCATION 10
+
+/// Instance rotation quaternion (vec4), advanced once per instance
+#define VERTEX_INSTANCE_ROTATION_LOCATION 11
+
+/// Instance color index (float), advanced once per instance
+#define VERTEX_INSTANCE_COLOR_LOCATION 12
+
 #endif // ANTKEEPER_VERTEX_ATTRIBUTES_HPP
 
@@ -27,7 +27,6 @@
 #include <iostream>
 #include <type_traits>
 #include <sstream>
-#include <physfs.h>
 
 template <class T>
 void parse_argument(T& value, const std::string& string)
@@ -62,7 +61,7 @@ std::function<entity::ebt::status(entity::ebt::context&)> pack_function(T (*func
 	return std::bind(
 		[function, arguments](entity::ebt::context& context) -> entity::ebt::status
 		{
-			return std::apply(function, std::tuple_cat(std::make_tuple(context), arguments));
+			return std::apply(function, std::tuple_cat(std::forward_as_tuple(context), arguments));
 		},
 		std::placeholders::_1);
 }
@@ -89,6 +88,9 @@ static entity::ebt::node* load_action_node(const nlohmann::json& json, resource_
 	if (function_name == "print") action_node->function = pack_function(entity::ebt::print, arguments);
 	else if (function_name == "print_eid") action_node->function = pack_function(entity::ebt::print_eid, arguments);
 	else if (function_name == "warp_to") action_node->function = pack_function(entity::ebt::warp_to, arguments);
+	else if (function_name == "deposit_pheromone") action_node->function = pack_function(entity::ebt::deposit_pheromone, arguments);
+	else if (function_name == "sense_pheromone") action_node->function = pack_function(entity::ebt::sense_pheromone, arguments);
+	else if (function_name == "follow_pheromone") action_node->function = pack_function(entity::ebt::follow_pheromone, arguments);
 	
 	return action_node;
 }
@@ -141,17 +143,23 @@ static void load_node_children(entity::ebt::composite_node* node, const nlohmann
 	}
 }
 
-template <>
-entity::ebt::node* resource_loader<entity::ebt::node>::load(resource_manager* resource_manager, PHYSFS_File* file)
+/// Destroys a node and all of its descendants.
+static void free_node(entity::ebt::node* node)
 {
-	// Read file into buffer
-	std::size_t size = static_cast<int>(PHYSFS_fileLength(file));
-	std::string buffer;
-	buffer.resize(size);
-	PHYSFS_readBytes(file, &buffer[0], size);
+	if (auto decorator = dynamic_cast<entity::ebt::decorator_node*>(node))
+		free_node(decorator->child);
+	else if (auto composite = dynamic_cast<entity::ebt::composite_node*>(node))
+		for (entity::ebt::node* child: composite->children)
+			free_node(child);
 	
-	// Parse json from file buffer
-	nlohmann::json json = nlohmann::json::parse(buffer);
+	delete node;
+}
+
+template <>
+entity::ebt::node* resource_loader<entity::ebt::node>::load(resource_manager* resource_manager, const std::uint8_t* data, std::size_t size)
+{
+	// Parse json from file data
+	nlohmann::json json = nlohmann::json::parse(data, data + size);
 
 	if (json.size() != 1)
 	{
@@ -161,3 +169,24 @@ entity::ebt::node* resource_loader<entity::ebt::node>::load(resource_manager* re
 	return load_node(json.cbegin(), resource_manager);
 }
 
+template <>
+entity::ebt::compiled_tree* resource_loader<entity::ebt::compiled_tree>::load(resource_manager* resource_manager, const std::uint8_t* data, std::size_t size)
+{
+	// Load node tree, then flatten it
+	entity::ebt::node* root = resource_loader<entity::ebt::node>::load(resource_manager, data, size);
+	
+	entity::ebt::compiled_tree* tree = nullptr;
+	try
+	{
+		tree = new entity::ebt::compiled_tree(*root);
+	}
+	catch (...)
+	{
+		free_node(root);
+		throw;
+	}
+	
+	free_node(root);
+	return tree;
+}
+
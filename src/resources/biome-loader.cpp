@@ -19,10 +19,11 @@
 
 #include "resource-loader.hpp"
 #include "resource-manager.hpp"
+#include "resources/image.hpp"
+#include "renderer/material.hpp"
 #include "game/biome.hpp"
 #include "math/angles.hpp"
 #include <nlohmann/json.hpp>
-#include <physfs.h>
 
 template <typename T>
 static bool load_value(T* value, const nlohmann::json& json, const std::string& name)
@@ -55,16 +56,10 @@ static bool load_array(T* value, std::size_t size, const nlohmann::json& json, c
 }
 
 template <>
-biome* resource_loader<biome>::load(resource_manager* resource_manager, PHYSFS_File* file)
+biome* resource_loader<biome>::load(resource_manager* resource_manager, const std::uint8_t* data, std::size_t size)
 {
-	// Read file into buffer
-	std::size_t size = static_cast<int>(PHYSFS_fileLength(file));
-	std::string buffer;
-	buffer.resize(size);
-	PHYSFS_readBytes(file, &buffer[0], size);
-	
-	// Parse json from file buffer
-	nlohmann::json json = nlohmann::json::parse(buffer);
+	// Parse json from file data
+	nlohmann::json json = nlohmann::json::parse(data, data + size);
 	
 	biome* biome = new ::biome();
 	
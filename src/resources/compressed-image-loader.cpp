@@ -0,0 +1,159 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "resources/resource-loader.hpp"
+#include "resources/compressed-image.hpp"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+/// KTX2 file identifier.
+constexpr std::uint8_t ktx2_identifier[12] = {0xab, 0x4b, 0x54, 0x58, 0x20, 0x32, 0x30, 0xbb, 0x0d, 0x0a, 0x1a, 0x0a};
+
+/// Size of the KTX2 identifier, header, and index, after which the level index begins.
+constexpr std::size_t ktx2_level_index_offset = 80;
+
+/// Compressed format and color space of a Vulkan format.
+struct ktx2_format
+{
+	std::uint32_t vk_format;
+	gl::compressed_format format;
+	gl::color_space color_space;
+};
+
+constexpr ktx2_format ktx2_formats[] =
+{
+	{131, gl::compressed_format::bc1, gl::color_space::linear}, // VK_FORMAT_BC1_RGB_UNORM_BLOCK
+	{132, gl::compressed_format::bc1, gl::color_space::srgb}, // VK_FORMAT_BC1_RGB_SRGB_BLOCK
+	{133, gl::compressed_format::bc1, gl::color_space::linear}, // VK_FORMAT_BC1_RGBA_UNORM_BLOCK
+	{134, gl::compressed_format::bc1, gl::color_space::srgb}, // VK_FORMAT_BC1_RGBA_SRGB_BLOCK
+	{137, gl::compressed_format::bc3, gl::color_space::linear}, // VK_FORMAT_BC3_UNORM_BLOCK
+	{138, gl::compressed_format::bc3, gl::color_space::srgb}, // VK_FORMAT_BC3_SRGB_BLOCK
+	{139, gl::compressed_format::bc4, gl::color_space::linear}, // VK_FORMAT_BC4_UNORM_BLOCK
+	{141, gl::compressed_format::bc5, gl::color_space::linear}, // VK_FORMAT_BC5_UNORM_BLOCK
+	{143, gl::compressed_format::bc6h, gl::color_space::linear}, // VK_FORMAT_BC6H_UFLOAT_BLOCK
+	{145, gl::compressed_format::bc7, gl::color_space::linear}, // VK_FORMAT_BC7_UNORM_BLOCK
+	{146, gl::compressed_format::bc7, gl::color_space::srgb}, // VK_FORMAT_BC7_SRGB_BLOCK
+	{157, gl::compressed_format::astc_4x4, gl::color_space::linear}, // VK_FORMAT_ASTC_4x4_UNORM_BLOCK
+	{158, gl::compressed_format::astc_4x4, gl::color_space::srgb}, // VK_FORMAT_ASTC_4x4_SRGB_BLOCK
+	{161, gl::compressed_format::astc_5x5, gl::color_space::linear}, // VK_FORMAT_ASTC_5x5_UNORM_BLOCK
+	{162, gl::compressed_format::astc_5x5, gl::color_space::srgb}, // VK_FORMAT_ASTC_5x5_SRGB_BLOCK
+	{165, gl::compressed_format::astc_6x6, gl::color_space::linear}, // VK_FORMAT_ASTC_6x6_UNORM_BLOCK
+	{166, gl::compressed_format::astc_6x6, gl::color_space::srgb}, // VK_FORMAT_ASTC_6x6_SRGB_BLOCK
+	{171, gl::compressed_format::astc_8x8, gl::color_space::linear}, // VK_FORMAT_ASTC_8x8_UNORM_BLOCK
+	{172, gl::compressed_format::astc_8x8, gl::color_space::srgb} // VK_FORMAT_ASTC_8x8_SRGB_BLOCK
+};
+
+/// Block width, block height, and block size in bytes of each compressed format.
+constexpr std::uint32_t block_dimensions[][3] =
+{
+	{4, 4, 8},
+	{4, 4, 16},
+	{4, 4, 8},
+	{4, 4, 16},
+	{4, 4, 16},
+	{4, 4, 16},
+	{4, 4, 16},
+	{5, 5, 16},
+	{6, 6, 16},
+	{8, 8, 16}
+};
+
+template <class T>
+T read_le(const std::uint8_t* data)
+{
+	T value = 0;
+	for (std::size_t i = 0; i < sizeof(T); ++i)
+		value |= static_cast<T>(data[i]) << (i * 8);
+	return value;
+}
+
+} // namespace
+
+template <>
+compressed_image* resource_loader<compressed_image>::load(resource_manager* resource_manager, const std::uint8_t* data, std::size_t size)
+{
+	if (size < ktx2_level_index_offset || std::memcmp(data, ktx2_identifier, sizeof(ktx2_identifier)))
+		throw std::runtime_error("Not a KTX2 file.");
+	
+	// Read header
+	const std::uint32_t vk_format = read_le<std::uint32_t>(data + 12);
+	const std::uint32_t width = read_le<std::uint32_t>(data + 20);
+	const std::uint32_t height = read_le<std::uint32_t>(data + 24);
+	const std::uint32_t depth = read_le<std::uint32_t>(data + 28);
+	const std::uint32_t layer_count = read_le<std::uint32_t>(data + 32);
+	const std::uint32_t face_count = read_le<std::uint32_t>(data + 36);
+	const std::uint32_t level_count = std::max<std::uint32_t>(1, read_le<std::uint32_t>(data + 40));
+	const std::uint32_t supercompression_scheme = read_le<std::uint32_t>(data + 44);
+	
+	if (!width || !height || depth > 1 || layer_count > 1 || face_count != 1)
+		throw std::runtime_error("KTX2 file is not a single 2D image.");
+	if (supercompression_scheme != 0)
+		throw std::runtime_error("KTX2 supercompression is not supported.");
+	
+	// Find compressed format
+	const ktx2_format* format = nullptr;
+	for (const ktx2_format& candidate: ktx2_formats)
+	{
+		if (candidate.vk_format == vk_format)
+		{
+			format = &candidate;
+			break;
+		}
+	}
+	if (!format)
+		throw std::runtime_error("Unsupported KTX2 format (" + std::to_string(vk_format) + ").");
+	
+	const std::uint32_t* block = block_dimensions[static_cast<std::size_t>(format->format)];
+	
+	// Read level index, validating level sizes against their dimensions
+	if (level_count > 32 || ktx2_level_index_offset + level_count * 24 > size)
+		throw std::runtime_error("Truncated KTX2 level index.");
+	std::vector<std::size_t> level_offsets(level_count);
+	std::vector<std::size_t> level_sizes(level_count);
+	for (std::uint32_t i = 0; i < level_count; ++i)
+	{
+		const std::uint8_t* entry = data + ktx2_level_index_offset + i * 24;
+		const std::uint64_t offset = read_le<std::uint64_t>(entry);
+		const std::uint64_t length = read_le<std::uint64_t>(entry + 8);
+		
+		const std::uint64_t level_width = std::max<std::uint32_t>(1, width >> i);
+		const std::uint64_t level_height = std::max<std::uint32_t>(1, height >> i);
+		const std::uint64_t expected_length = ((level_width + block[0] - 1) / block[0]) * ((level_height + block[1] - 1) / block[1]) * block[2];
+		
+		if (length != expected_length)
+			throw std::runtime_error("KTX2 mip level " + std::to_string(i) + " has an unexpected size.");
+		if (offset > size || length > size - offset)
+			throw std::runtime_error("KTX2 mip level " + std::to_string(i) + " is out of bounds.");
+		
+		level_offsets[i] = static_cast<std::size_t>(offset);
+		level_sizes[i] = static_cast<std::size_t>(length);
+	}
+	
+	compressed_image* image = new compressed_image();
+	image->resize(width, height, format->format, format->color_space, level_sizes);
+	for (std::uint32_t i = 0; i < level_count; ++i)
+		std::memcpy(image->get_level_data(i), data + level_offsets[i], level_sizes[i]);
+	
+	return image;
+}
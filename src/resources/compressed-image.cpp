@@ -0,0 +1,50 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "compressed-image.hpp"
+
+compressed_image::compressed_image():
+	width(0),
+	height(0),
+	format(gl::compressed_format::bc7),
+	color_space(gl::color_space::linear)
+{}
+
+void compressed_image::resize(unsigned int width, unsigned int height, gl::compressed_format format, gl::color_space color_space, const std::vector<std::size_t>& level_sizes)
+{
+	this->width = width;
+	this->height = height;
+	this->format = format;
+	this->color_space = color_space;
+	this->level_sizes = level_sizes;
+	
+	// Pack levels into a single allocation
+	level_offsets.resize(level_sizes.size());
+	std::size_t size = 0;
+	for (std::size_t i = 0; i < level_sizes.size(); ++i)
+	{
+		level_offsets[i] = size;
+		size += level_sizes[i];
+	}
+	storage.assign(size, 0);
+	
+	level_data.resize(level_sizes.size());
+	for (std::size_t i = 0; i < level_sizes.size(); ++i)
+		level_data[i] = storage.data() + level_offsets[i];
+}
@@ -0,0 +1,150 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ANTKEEPER_COMPRESSED_IMAGE_HPP
+#define ANTKEEPER_COMPRESSED_IMAGE_HPP
+
+#include "resources/resource-loader.hpp"
+#include "gl/color-space.hpp"
+#include "gl/compressed-format.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Stores block-compressed image data with a mip chain, as loaded from a KTX2 container.
+ *
+ * Levels are uploaded to the GPU as they are, so they should be authored with their first row at the bottom of the image, as expected by OpenGL (e.g. `toktx --lower_left_maps_to_s0t0`), rather than the KTX2 default of top-down.
+ */
+class compressed_image
+{
+public:
+	/// Creates a compressed image.
+	compressed_image();
+
+	/**
+	 * Changes the format and size of the image and allocates its mip levels. Existing level data will be erased.
+	 *
+	 * @param width Width of the base level, in pixels.
+	 * @param height Height of the base level, in pixels.
+	 * @param format Compressed format of the levels.
+	 * @param color_space Color space of the levels.
+	 * @param level_sizes Size of each mip level, in bytes, base level first.
+	 */
+	void resize(unsigned int width, unsigned int height, gl::compressed_format format, gl::color_space color_space, const std::vector<std::size_t>& level_sizes);
+
+	/// Returns the width of the base level, in pixels.
+	unsigned int get_width() const;
+
+	/// Returns the height of the base level, in pixels.
+	unsigned int get_height() const;
+
+	/// Returns the compressed format of the image.
+	gl::compressed_format get_format() const;
+
+	/// Returns the color space of the image.
+	gl::color_space get_color_space() const;
+
+	/// Returns the number of mip levels.
+	std::size_t get_level_count() const;
+
+	/// Returns the data of each mip level.
+	const void* const* get_level_data() const;
+
+	/// Returns the data of a mip level.
+	std::uint8_t* get_level_data(std::size_t level);
+
+	/// Returns the size of each mip level, in bytes.
+	const std::size_t* get_level_sizes() const;
+
+private:
+	unsigned int width;
+	unsigned int height;
+	gl::compressed_format format;
+	gl::color_space color_space;
+	std::vector<std::uint8_t> storage;
+	std::vector<std::size_t> level_offsets;
+	std::vector<const void*> level_data;
+	std::vector<std::size_t> level_sizes;
+};
+
+inline unsigned int compressed_image::get_width() const
+{
+	return width;
+}
+
+inline unsigned int compressed_image::get_height() const
+{
+	return height;
+}
+
+inline gl::compressed_format compressed_image::get_format() const
+{
+	return format;
+}
+
+inline gl::color_space compressed_image::get_color_space() const
+{
+	return color_space;
+}
+
+inline std::size_t compressed_image::get_level_count() const
+{
+	return level_sizes.size();
+}
+
+inline const void* const* compressed_image::get_level_data() const
+{
+	return level_data.data();
+}
+
+inline std::uint8_t* compressed_image::get_level_data(std::size_t level)
+{
+	return storage.data() + level_offsets[level];
+}
+
+inline const std::size_t* compressed_image::get_level_sizes() const
+{
+	return level_sizes.data();
+}
+
+template <>
+struct resource_loader_traits<compressed_image>
+{
+	static constexpr bool concurrent = true;
+};
+
+template <>
+struct resource_footprint<compressed_image>
+{
+	static std::size_t cpu_size(const compressed_image& resource)
+	{
+		std::size_t size = sizeof(compressed_image);
+		for (std::size_t i = 0; i < resource.get_level_count(); ++i)
+			size += resource.get_level_sizes()[i];
+		return size;
+	}
+	
+	static std::size_t gpu_size(const compressed_image& resource)
+	{
+		return 0;
+	}
+};
+
+#endif // ANTKEEPER_COMPRESSED_IMAGE_HPP
@@ -23,10 +23,10 @@
 #include "resources/text-file.hpp"
 
 template <>
-config_file* resource_loader<config_file>::load(resource_manager* resource_manager, PHYSFS_File* file)
+config_file* resource_loader<config_file>::load(resource_manager* resource_manager, const std::uint8_t* data, std::size_t size)
 {
 	// Load as text file
-	text_file* text = resource_loader<text_file>::load(resource_manager, file);
+	text_file* text = resource_loader<text_file>::load(resource_manager, data, size);
 	
 	config_file* config = new config_file();
 	for (const std::string& line: *text)
@@ -0,0 +1,102 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "resources/config-file.hpp"
+#include <cerrno>
+#include <cstdlib>
+
+namespace {
+
+/// Parses a complete token as a number, returning `false` if it contains anything else.
+bool parse_number(const std::string& token, long& integer, float& number, bool& integral)
+{
+	const char* begin = token.c_str();
+	char* end;
+	
+	errno = 0;
+	integer = std::strtol(begin, &end, 10);
+	if (end != begin && *end == '\0' && errno == 0)
+	{
+		number = static_cast<float>(integer);
+		integral = true;
+		return true;
+	}
+	
+	number = std::strtof(begin, &end);
+	integral = false;
+	return (end != begin && *end == '\0');
+}
+
+/// Parses the text of a variable into a value.
+config_file::value_type parse(const std::string& text)
+{
+	if (text == "true")
+		return true;
+	if (text == "false")
+		return false;
+	
+	// Split text into whitespace-separated tokens
+	std::vector<std::string> tokens;
+	std::istringstream stream(text);
+	for (std::string token; stream >> token;)
+		tokens.push_back(token);
+	
+	if (tokens.empty())
+		return std::monostate();
+	
+	long integer;
+	float number;
+	bool integral;
+	
+	// Parse a single token as an integer or floating-point number
+	if (tokens.size() == 1)
+	{
+		if (!parse_number(tokens.front(), integer, number, integral))
+			return std::monostate();
+		if (integral)
+			return static_cast<int>(integer);
+		return number;
+	}
+	
+	// Parse multiple tokens as a vector of numbers
+	std::vector<float> numbers;
+	numbers.reserve(tokens.size());
+	for (const std::string& token: tokens)
+	{
+		if (!parse_number(token, integer, number, integral))
+			return std::monostate();
+		numbers.push_back(number);
+	}
+	
+	return numbers;
+}
+
+} // namespace
+
+void config_file::assign(variable& variable, const std::string& text)
+{
+	const char* whitespace = " \t\r\n";
+	const std::size_t first = text.find_first_not_of(whitespace);
+	if (first == std::string::npos)
+		variable.text.clear();
+	else
+		variable.text = text.substr(first, text.find_last_not_of(whitespace) - first + 1);
+	
+	variable.value = parse(variable.text);
+}
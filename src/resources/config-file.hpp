@@ -20,45 +20,152 @@
 #ifndef CONFIG_FILE_HPP
 #define CONFIG_FILE_HPP
 
+#include "resources/resource-loader.hpp"
+#include "math/vector-type.hpp"
+#include "utility/string-id.hpp"
+#include <cstddef>
 #include <sstream>
 #include <string>
+#include <string_view>
+#include <type_traits>
 #include <unordered_map>
+#include <variant>
+#include <vector>
 
+/**
+ * Set of named configuration variables.
+ *
+ * The text of each variable is parsed once, when it's set, into a boolean, integer, floating-point number, vector of numbers, or string. Typed getters then convert the parsed value rather than parsing its text again.
+ *
+ * Variables are keyed by the interned IDs of their names, so that variables which are read often can be looked up by IDs computed at compile time, e.g. `get<int>("vsync"_sid)`.
+ */
 class config_file
 {
 public:
+	/// Parsed value of a variable, where `std::monostate` denotes a string.
+	typedef std::variant<std::monostate, bool, int, float, std::vector<float>> value_type;
+	
 	template <typename T>
-	void set(const std::string& name, const T& value);
+	void set(std::string_view name, const T& value);
 	
+	/// Returns the value of a variable, or a value-initialized `T` if the variable isn't set.
 	template <typename T>
-	T get(const std::string& name) const;
+	T get(string_id name_id) const;
 	
-	bool has(const std::string& name) const;
+	/// @copydoc get(string_id) const
+	template <typename T>
+	T get(std::string_view name) const;
+	
+	/// Returns `true` if a variable is set.
+	bool has(string_id name_id) const;
+	
+	/// @copydoc has(string_id) const
+	bool has(std::string_view name) const;
 	
 private:
-	std::unordered_map<std::string, std::string> variables;
+	struct variable
+	{
+		std::string text;
+		value_type value;
+	};
+	
+	template <typename T>
+	struct is_vector: std::false_type {};
+	
+	template <typename T, std::size_t N>
+	struct is_vector<math::vector<T, N>>: std::true_type {};
+	
+	/// Sets the text of a variable, trimmed of surrounding whitespace, and parses it into a value.
+	static void assign(variable& variable, const std::string& text);
+	
+	template <typename T>
+	static T convert(const variable& variable);
+	
+	std::unordered_map<string_id, variable> variables;
 };
 
 template <typename T>
-void config_file::set(const std::string& name, const T& value)
+void config_file::set(std::string_view name, const T& value)
 {
-	std::stringstream stream;
-	stream << value;
-	variables[name] = stream.str();
+	variable& variable = variables[intern_string(name)];
+	if constexpr (std::is_convertible<T, std::string>::value)
+	{
+		assign(variable, value);
+	}
+	else
+	{
+		std::ostringstream stream;
+		stream << value;
+		assign(variable, stream.str());
+	}
 }
 
 template <typename T>
-T config_file::get(const std::string& name) const
+T config_file::get(string_id name_id) const
 {
-	T value;
-	if (auto it = variables.find(name); it != variables.end())
-		std::stringstream(it->second) >> value;
-    return value;
+	if (auto it = variables.find(name_id); it != variables.end())
+		return convert<T>(it->second);
+	return T();
 }
 
-inline bool config_file::has(const std::string& name) const
+template <typename T>
+T config_file::get(std::string_view name) const
 {
-	return (variables.find(name) != variables.end());
+	return get<T>(make_string_id(name));
 }
 
+inline bool config_file::has(string_id name_id) const
+{
+	return (variables.find(name_id) != variables.end());
+}
+
+inline bool config_file::has(std::string_view name) const
+{
+	return has(make_string_id(name));
+}
+
+template <typename T>
+T config_file::convert(const variable& variable)
+{
+	const value_type& value = variable.value;
+	
+	if constexpr (std::is_same<T, std::string>::value)
+	{
+		return variable.text;
+	}
+	else if constexpr (std::is_arithmetic<T>::value)
+	{
+		if (auto x = std::get_if<int>(&value))
+			return static_cast<T>(*x);
+		if (auto x = std::get_if<float>(&value))
+			return static_cast<T>(*x);
+		if (auto x = std::get_if<bool>(&value))
+			return static_cast<T>(*x);
+		return T();
+	}
+	else if constexpr (is_vector<T>::value)
+	{
+		T result = {};
+		if (auto x = std::get_if<std::vector<float>>(&value))
+		{
+			for (std::size_t i = 0; i < result.size() && i < x->size(); ++i)
+				result[i] = static_cast<typename T::scalar_type>((*x)[i]);
+		}
+		return result;
+	}
+	else
+	{
+		// Fall back to parsing the text of unsupported types
+		T result;
+		std::istringstream(variable.text) >> result;
+		return result;
+	}
+}
+
+template <>
+struct resource_loader_traits<config_file>
+{
+	static constexpr bool concurrent = true;
+};
+
 #endif // CONFIG_FILE_HPP
@@ -32,19 +32,23 @@
 #include "entity/components/brush.hpp"
 #include "entity/archetype.hpp"
 #include "entity/ebt.hpp"
+#include "geom/mesh-functions.hpp"
 #include <sstream>
 #include <stdexcept>
 
-static bool load_component_behavior(entity::archetype& archetype, resource_manager& resource_manager, const std::vector<std::string>& parameters)
+static bool load_component_behavior(entity::archetype& archetype, resource_manager& resource_manager, const string_table_row& parameters)
 {
-	if (parameters.size() != 2)
+	if (parameters.size() != 2 && parameters.size() != 3)
 	{
 		throw std::runtime_error("load_component_behavior(): Invalid parameter count.");
 	}
 
-	std::string filename = parameters[1];
+	std::string filename(parameters[1]);
 	entity::component::behavior component;
-	component.behavior_tree = resource_manager.load<entity::ebt::node>(filename);
+	component.behavior_tree = resource_manager.load<entity::ebt::compiled_tree>(filename);
+	component.running_node = entity::ebt::compiled_tree::npos;
+	component.interval = (parameters.size() == 3) ? static_cast<std::uint32_t>(std::stoul(std::string(parameters[2]))) : 1;
+	component.elapsed_ticks = 0;
 	if (!component.behavior_tree)
 	{
 		std::string message = std::string("load_component_behavior(): Failed to load behavior tree \"") + filename + std::string("\"");
@@ -56,14 +60,14 @@ static bool load_component_behavior(entity::archetype& archetype, resource_manag
 	return true;
 }
 
-static bool load_component_collision(entity::archetype& archetype, resource_manager& resource_manager, const std::vector<std::string>& parameters)
+static bool load_component_collision(entity::archetype& archetype, resource_manager& resource_manager, const string_table_row& parameters)
 {
 	if (parameters.size() != 2)
 	{
 		throw std::runtime_error("load_component_collision(): Invalid parameter count.");
 	}
 
-	std::string filename = parameters[1];
+	std::string filename(parameters[1]);
 	entity::component::collision component;
 	component.mesh = resource_manager.load<geom::mesh>(filename);
 	if (!component.mesh)
@@ -71,20 +75,21 @@ static bool load_component_collision(entity::archetype& archetype, resource_mana
 		std::string message = std::string("load_component_collision(): Failed to load model \"") + filename + std::string("\"");
 		throw std::runtime_error(message);
 	}
+	component.bounds = geom::calculate_bounds(*component.mesh);
 
 	archetype.set<entity::component::collision>(component);
 
 	return true;
 }
 
-static bool load_component_model(entity::archetype& archetype, resource_manager& resource_manager, const std::vector<std::string>& parameters)
+static bool load_component_model(entity::archetype& archetype, resource_manager& resource_manager, const string_table_row& parameters)
 {
 	if (parameters.size() != 2)
 	{
 		throw std::runtime_error("load_component_model(): Invalid parameter count.");
 	}
 
-	std::string filename = parameters[1];
+	std::string filename(parameters[1]);
 	entity::component::model component;
 	component.render_model = resource_manager.load<model>(filename);
 	component.instance_count = 0;
@@ -100,15 +105,24 @@ static bool load_component_model(entity::archetype& archetype, resource_manager&
 	return true;
 }
 
-static bool load_component_nest(entity::archetype& archetype, const std::vector<std::string>& parameters)
+static bool load_component_nest(entity::archetype& archetype, const string_table_row& parameters)
 {
+	if (parameters.size() != 1 && parameters.size() != 5)
+	{
+		throw std::runtime_error("load_component_nest(): Invalid parameter count.");
+	}
+	
 	entity::component::nest component;
+	component.helix_radius = (parameters.size() == 5) ? std::stof(std::string(parameters[1])) : 5.0f;
+	component.helix_pitch = (parameters.size() == 5) ? std::stof(std::string(parameters[2])) : 8.0f;
+	component.helix_chirality = (parameters.size() == 5) ? std::stof(std::string(parameters[3])) : -1.0f;
+	component.helix_turns = (parameters.size() == 5) ? std::stof(std::string(parameters[4])) : 12.5f;
 	archetype.set<entity::component::nest>(component);
 
 	return true;
 }
 
-static bool load_component_marker(entity::archetype& archetype, const std::vector<std::string>& parameters)
+static bool load_component_marker(entity::archetype& archetype, const string_table_row& parameters)
 {
 	if (parameters.size() != 2)
 	{
@@ -116,13 +130,13 @@ static bool load_component_marker(entity::archetype& archetype, const std::vecto
 	}
 	
 	entity::component::marker component;
-	component.color = std::stoi(parameters[1]);
+	component.color = std::stoi(std::string(parameters[1]));
 	archetype.set<entity::component::marker>(component);
 	
 	return true;
 }
 
-static bool load_component_brush(entity::archetype& archetype, const std::vector<std::string>& parameters)
+static bool load_component_brush(entity::archetype& archetype, const string_table_row& parameters)
 {
 	if (parameters.size() != 2)
 	{
@@ -130,13 +144,13 @@ static bool load_component_brush(entity::archetype& archetype, const std::vector
 	}
 	
 	entity::component::brush component;
-	component.radius = std::stof(parameters[1]);
+	component.radius = std::stof(std::string(parameters[1]));
 	archetype.set<entity::component::brush>(component);
 	
 	return true;
 }
 
-static bool load_component_tool(entity::archetype& archetype, const std::vector<std::string>& parameters)
+static bool load_component_tool(entity::archetype& archetype, const string_table_row& parameters)
 {	
 	if (parameters.size() != 5)
 	{
@@ -144,16 +158,16 @@ static bool load_component_tool(entity::archetype& archetype, const std::vector<
 	}
 
 	entity::component::tool component;
-	component.active = static_cast<bool>(std::stoi(parameters[1]));
-	component.idle_distance = std::stof(parameters[2]);
-	component.active_distance = std::stof(parameters[3]);
-	component.heliotropic = static_cast<bool>(std::stoi(parameters[4]));
+	component.active = static_cast<bool>(std::stoi(std::string(parameters[1])));
+	component.idle_distance = std::stof(std::string(parameters[2]));
+	component.active_distance = std::stof(std::string(parameters[3]));
+	component.heliotropic = static_cast<bool>(std::stoi(std::string(parameters[4])));
 	archetype.set<entity::component::tool>(component);
 
 	return true;
 }
 
-static bool load_component_transform(entity::archetype& archetype, const std::vector<std::string>& parameters)
+static bool load_component_transform(entity::archetype& archetype, const string_table_row& parameters)
 {
 	if (parameters.size() != 11)
 	{
@@ -186,7 +200,7 @@ static bool load_component_transform(entity::archetype& archetype, const std::ve
 	return true;
 }
 
-static bool load_component(entity::archetype& archetype, resource_manager& resource_manager, const std::vector<std::string>& parameters)
+static bool load_component(entity::archetype& archetype, resource_manager& resource_manager, const string_table_row& parameters)
 {
 	if (parameters[0] == "behavior") return load_component_behavior(archetype, resource_manager, parameters);
 	if (parameters[0] == "collision") return load_component_collision(archetype, resource_manager, parameters);
@@ -197,36 +211,39 @@ static bool load_component(entity::archetype& archetype, resource_manager& resou
 	if (parameters[0] == "marker") return load_component_marker(archetype, parameters);
 	if (parameters[0] == "brush") return load_component_brush(archetype, parameters);
 
-	std::string message = std::string("load_component(): Unknown component type \"") + parameters[0] + std::string("\"");
+	std::string message = std::string("load_component(): Unknown component type \"") + std::string(parameters[0]) + std::string("\"");
 	throw std::runtime_error(message);
 }
 
 template <>
-entity::archetype* resource_loader<entity::archetype>::load(resource_manager* resource_manager, PHYSFS_File* file)
+entity::archetype* resource_loader<entity::archetype>::load(resource_manager* resource_manager, const std::uint8_t* data, std::size_t size)
 {
-	entity::archetype* archetype = new entity::archetype(resource_manager->get_archetype_registry());
-
-	// Load string table from input stream
-	string_table* table = resource_loader<string_table>::load(resource_manager, file);
-
-	// Ensure table is not empty.
-	if (!table || table->empty())
+	// Ensure archetype table is not empty
+	if (!size)
 	{
-		delete table;
 		return nullptr;
 	}
-
-	// Load components from table rows
-	for (const string_table_row& row: *table)
+	
+	entity::archetype* archetype = new entity::archetype(resource_manager->get_archetype_registry());
+	
+	// Load components from the rows of the archetype table, without building a string table
+	try
 	{
-		// Skip empty rows and comments
-		if (row.empty() || row[0].empty() || row[0][0] == '#')
+		parse_string_table(data, size, [archetype, resource_manager](const string_table_row& row)
 		{
-			continue;
-		}
-
-
-		load_component(*archetype, *resource_manager, row);
+			// Skip empty rows and comments
+			if (row.empty() || row[0].empty() || row[0][0] == '#')
+			{
+				return;
+			}
+			
+			load_component(*archetype, *resource_manager, row);
+		});
+	}
+	catch (...)
+	{
+		delete archetype;
+		throw;
 	}
 	
 	return archetype;
@@ -22,26 +22,18 @@
 #include "resources/image.hpp"
 #include <cstring>
 #include <stdexcept>
-#include <physfs.h>
 
 template <>
-image* resource_loader<image>::load(resource_manager* resource_manager, PHYSFS_File* file)
+image* resource_loader<image>::load(resource_manager* resource_manager, const std::uint8_t* data, std::size_t size)
 {
-	unsigned char* buffer;
-	int size;
 	int width;
 	int height;
 	int channels;
 	bool hdr;
 	void* pixels;
 
-	// Read input stream into buffer
-	size = static_cast<int>(PHYSFS_fileLength(file));
-	buffer = new unsigned char[size];
-	PHYSFS_readBytes(file, buffer, size);
-
 	// Determine if image is in an HDR format
-	hdr = (stbi_is_hdr_from_memory(buffer, size) != 0);
+	hdr = (stbi_is_hdr_from_memory(data, static_cast<int>(size)) != 0);
 	
 	// Set vertical flip on load in order to upload pixels correctly to OpenGL
 	stbi_set_flip_vertically_on_load(true);
@@ -49,15 +41,12 @@ image* resource_loader<image>::load(resource_manager* resource_manager, PHYSFS_F
 	// Load image data
 	if (hdr)
 	{
-		pixels = stbi_loadf_from_memory(buffer, size, &width, &height, &channels, 0);
+		pixels = stbi_loadf_from_memory(data, static_cast<int>(size), &width, &height, &channels, 0);
 	}
 	else
 	{
-		pixels = stbi_load_from_memory(buffer, size, &width, &height, &channels, 0);
+		pixels = stbi_load_from_memory(data, static_cast<int>(size), &width, &height, &channels, 0);
 	}
-
-	// Free file buffer
-	delete[] buffer;
 	
 	// Check if image was loaded
 	if (!pixels)
@@ -20,6 +20,7 @@
 #ifndef ANTKEEPER_IMAGE_HPP
 #define ANTKEEPER_IMAGE_HPP
 
+#include "resources/resource-loader.hpp"
 #include <cstdlib>
 
 /**
@@ -118,4 +119,24 @@ inline std::size_t image::get_size() const
 	return size;
 }
 
+template <>
+struct resource_loader_traits<image>
+{
+	static constexpr bool concurrent = true;
+};
+
+template <>
+struct resource_footprint<image>
+{
+	static std::size_t cpu_size(const image& resource)
+	{
+		return sizeof(image) + resource.get_size() * ((resource.is_hdr()) ? sizeof(float) : sizeof(unsigned char));
+	}
+	
+	static std::size_t gpu_size(const image& resource)
+	{
+		return 0;
+	}
+};
+
 #endif // ANTKEEPER_IMAGE_HPP
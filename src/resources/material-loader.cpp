@@ -22,7 +22,6 @@
 #include "renderer/material.hpp"
 #include "renderer/material-flags.hpp"
 #include <nlohmann/json.hpp>
-#include <physfs.h>
 #include <utility>
 #include <type_traits>
 #include <string>
@@ -73,6 +72,31 @@ static bool load_texture_2d_property(resource_manager* resource_manager, materia
 	return true;
 }
 
+static bool load_texture_2d_array_property(resource_manager* resource_manager, material* material, const std::string& name, const nlohmann::json& json)
+{
+	// If JSON element is an array
+	if (json.is_array())
+	{
+		// Create property
+		material_property<const gl::texture_2d_array*>* property = material->add_property<const gl::texture_2d_array*>(name, json.size());
+		
+		// Load texture arrays
+		std::size_t i = 0;
+		for (const auto& element: json)
+			property->set_value(i++, resource_manager->load<gl::texture_2d_array>(element.get<std::string>()));
+	}
+	else
+	{
+		// Create property
+		material_property<const gl::texture_2d_array*>* property = material->add_property<const gl::texture_2d_array*>(name);
+		
+		// Load texture array
+		property->set_value(resource_manager->load<gl::texture_2d_array>(json.get<std::string>()));
+	}
+	
+	return true;
+}
+
 static bool load_texture_cube_property(resource_manager* resource_manager, material* material, const std::string& name, const nlohmann::json& json)
 {
 	return false;
@@ -223,16 +247,10 @@ static bool load_matrix_property(material* material, const std::string& name, st
 }
 
 template <>
-material* resource_loader<material>::load(resource_manager* resource_manager, PHYSFS_File* file)
+material* resource_loader<material>::load(resource_manager* resource_manager, const std::uint8_t* data, std::size_t size)
 {
-	// Read file into buffer
-	std::size_t size = static_cast<int>(PHYSFS_fileLength(file));
-	std::string buffer;
-	buffer.resize(size);
-	PHYSFS_readBytes(file, &buffer[0], size);
-	
-	// Parse json from file buffer
-	nlohmann::json json = nlohmann::json::parse(buffer);
+	// Parse json from file data
+	nlohmann::json json = nlohmann::json::parse(data, data + size);
 	
 	// Allocate material
 	material* material = new ::material();
@@ -254,6 +272,8 @@ material* resource_loader<material>::load(resource_manager* resource_manager, PH
 	read_value(&blend_mode, json, "blend_mode");
 	if (blend_mode == "alpha_blend")
 		flags |= MATERIAL_FLAG_TRANSLUCENT;
+	else if (blend_mode == "weighted_blend")
+		flags |= MATERIAL_FLAG_TRANSLUCENT | MATERIAL_FLAG_WEIGHTED_BLENDED;
 	else
 		flags |= MATERIAL_FLAG_OPAQUE;
 	
@@ -289,6 +309,12 @@ material* resource_loader<material>::load(resource_manager* resource_manager, PH
 	else if (decal_mode == "surface")
 		flags |= MATERIAL_FLAG_DECAL_SURFACE;
 	
+	// Read depth pre-pass mode
+	std::string depth_prepass_mode;
+	read_value(&depth_prepass_mode, json, "depth_prepass_mode");
+	if (depth_prepass_mode == "none")
+		flags |= MATERIAL_FLAG_NO_DEPTH_PREPASS;
+	
 	// Set material flags
 	material->set_flags(flags);
 	
@@ -320,6 +346,11 @@ material* resource_loader<material>::load(resource_manager* resource_manager, PH
 			{
 				load_texture_2d_property(resource_manager, material, name, value_element.value());
 			}
+			// If property type is a 2D texture array, whose layers are selected by index in the shader
+			else if (type == "texture_2d_array")
+			{
+				load_texture_2d_array_property(resource_manager, material, name, value_element.value());
+			}
 			// If property type is a cubic texture
 			else if (type == "texture_cube")
 			{
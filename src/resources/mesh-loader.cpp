@@ -23,19 +23,18 @@
 #include "utility/fundamental-types.hpp"
 #include <sstream>
 #include <stdexcept>
-#include <physfs.h>
 
 template <>
-geom::mesh* resource_loader<geom::mesh>::load(resource_manager* resource_manager, PHYSFS_File* file)
+geom::mesh* resource_loader<geom::mesh>::load(resource_manager* resource_manager, const std::uint8_t* data, std::size_t size)
 {
 	std::string line;
 	std::vector<float3> vertices;
 	std::vector<std::array<std::uint_fast32_t, 3>> triangles;
 
-	while (!PHYSFS_eof(file))
+	std::size_t offset = 0;
+
+	while (resource_getline(data, size, offset, line))
 	{
-		// Read line
-		physfs_getline(file, line);
 		
 		// Tokenize line
 		std::vector<std::string> tokens;
@@ -89,3 +88,16 @@ geom::mesh* resource_loader<geom::mesh>::load(resource_manager* resource_manager
 	return mesh;
 }
 
+
+std::size_t resource_footprint<geom::mesh>::cpu_size(const geom::mesh& resource)
+{
+	return sizeof(geom::mesh) +
+		resource.get_vertices().size() * sizeof(geom::mesh::vertex) +
+		resource.get_edges().size() * sizeof(geom::mesh::edge) +
+		resource.get_faces().size() * sizeof(geom::mesh::face);
+}
+
+std::size_t resource_footprint<geom::mesh>::gpu_size(const geom::mesh& resource)
+{
+	return 0;
+}
@@ -0,0 +1,632 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "resources/model-file.hpp"
+#include "geom/vertex-cache.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <unordered_map>
+#include <nlohmann/json.hpp>
+
+namespace {
+
+/// Identifies binary model files.
+constexpr std::uint8_t binary_model_magic[4] = {'A', 'K', 'M', 'D'};
+
+/// Version of the binary model format.
+constexpr std::uint32_t binary_model_version = 1;
+
+/// Size of the header, in bytes.
+constexpr std::size_t header_size = 68;
+
+/// Size of the name field of an attribute record, in bytes.
+constexpr std::size_t attribute_name_size = 32;
+
+/// Size of an attribute record, in bytes.
+constexpr std::size_t attribute_record_size = attribute_name_size + 8;
+
+/// Size of the name field of a group record, in bytes.
+constexpr std::size_t group_name_size = 64;
+
+/// Size of a group record, in bytes.
+constexpr std::size_t group_record_size = group_name_size + 8;
+
+/// Alignment of the vertex and index data blobs, in bytes.
+constexpr std::size_t blob_alignment = 16;
+
+std::uint32_t read_u32(const std::uint8_t* data)
+{
+	return static_cast<std::uint32_t>(data[0]) |
+		(static_cast<std::uint32_t>(data[1]) << 8) |
+		(static_cast<std::uint32_t>(data[2]) << 16) |
+		(static_cast<std::uint32_t>(data[3]) << 24);
+}
+
+float read_f32(const std::uint8_t* data)
+{
+	const std::uint32_t bits = read_u32(data);
+	float value;
+	std::memcpy(&value, &bits, sizeof(float));
+	return value;
+}
+
+std::string read_name(const std::uint8_t* data, std::size_t size)
+{
+	const char* name = reinterpret_cast<const char*>(data);
+	return std::string(name, strnlen(name, size));
+}
+
+void write_u32(std::uint8_t* data, std::uint32_t value)
+{
+	data[0] = static_cast<std::uint8_t>(value);
+	data[1] = static_cast<std::uint8_t>(value >> 8);
+	data[2] = static_cast<std::uint8_t>(value >> 16);
+	data[3] = static_cast<std::uint8_t>(value >> 24);
+}
+
+void write_f32(std::uint8_t* data, float value)
+{
+	std::uint32_t bits;
+	std::memcpy(&bits, &value, sizeof(float));
+	write_u32(data, bits);
+}
+
+void write_name(std::uint8_t* data, std::size_t size, const std::string& name)
+{
+	if (name.size() >= size)
+		throw std::runtime_error("Name \"" + name + "\" exceeds " + std::to_string(size - 1) + " characters");
+	std::memset(data, 0, size);
+	std::memcpy(data, name.data(), name.size());
+}
+
+std::size_t align(std::size_t offset)
+{
+	return (offset + blob_alignment - 1) & ~(blob_alignment - 1);
+}
+
+/// Returns the attribute of a model with the given name, or `nullptr` if it has none.
+const model_file::attribute* find_attribute(const model_file& file, const std::string& name)
+{
+	for (const model_file::attribute& attribute: file.attributes)
+		if (attribute.name == name)
+			return &attribute;
+	return nullptr;
+}
+
+/// Reads the first `count` components of an attribute of a vertex.
+void read_attribute(const model_file& file, const model_file::attribute& attribute, std::size_t vertex, std::size_t count, float* values)
+{
+	std::memcpy(values, file.vertex_data + vertex * file.vertex_stride + attribute.offset, count * sizeof(float));
+}
+
+/// Returns the index of a vertex referenced by an element of a model, or the element itself if the model is not indexed.
+std::uint32_t read_index(const model_file& file, std::size_t element)
+{
+	if (!file.index_count)
+		return static_cast<std::uint32_t>(element);
+	
+	const std::uint8_t* index = file.index_data + element * file.index_size;
+	std::uint32_t value = 0;
+	for (std::size_t i = 0; i < file.index_size; ++i)
+		value |= static_cast<std::uint32_t>(index[i]) << (i * 8);
+	return value;
+}
+
+/// Writes the index of a vertex into an element of an indexed model.
+void write_index(model_file& file, std::size_t element, std::uint32_t value)
+{
+	std::uint8_t* index = file.storage.data() + (file.index_data - file.storage.data()) + element * file.index_size;
+	for (std::size_t i = 0; i < file.index_size; ++i)
+		index[i] = static_cast<std::uint8_t>(value >> (i * 8));
+}
+
+/**
+ * Appends an attribute to the vertices of a model, re-interleaving its vertex data into its storage.
+ *
+ * @param[in,out] file Model data.
+ * @param name Name of the attribute.
+ * @param size Number of components per vertex.
+ * @param values Components of the attribute, `size` per vertex.
+ */
+void append_attribute(model_file& file, const std::string& name, std::uint32_t size, const std::vector<float>& values)
+{
+	const std::size_t old_stride = file.vertex_stride;
+	const std::size_t new_stride = old_stride + size * sizeof(float);
+	const std::size_t vertex_data_size = static_cast<std::size_t>(file.vertex_count) * new_stride;
+	const std::size_t index_data_size = static_cast<std::size_t>(file.index_count) * file.index_size;
+	
+	std::vector<std::uint8_t> storage(vertex_data_size + index_data_size);
+	for (std::size_t i = 0; i < file.vertex_count; ++i)
+	{
+		std::uint8_t* vertex = storage.data() + i * new_stride;
+		std::memcpy(vertex, file.vertex_data + i * old_stride, old_stride);
+		std::memcpy(vertex + old_stride, &values[i * size], size * sizeof(float));
+	}
+	if (index_data_size)
+		std::memcpy(storage.data() + vertex_data_size, file.index_data, index_data_size);
+	
+	file.attributes.push_back({name, size, static_cast<std::uint32_t>(old_stride)});
+	file.vertex_stride = static_cast<std::uint32_t>(new_stride);
+	file.storage = std::move(storage);
+	file.vertex_data = file.storage.data();
+	file.index_data = (index_data_size) ? file.storage.data() + vertex_data_size : nullptr;
+}
+
+} // namespace
+
+bool is_binary_model_file(const std::uint8_t* data, std::size_t size)
+{
+	return size >= sizeof(binary_model_magic) && !std::memcmp(data, binary_model_magic, sizeof(binary_model_magic));
+}
+
+void read_binary_model_file(const std::uint8_t* data, std::size_t size, model_file& file)
+{
+	if (size < header_size || !is_binary_model_file(data, size))
+		throw std::runtime_error("Invalid binary model header");
+	if (read_u32(data + 4) != binary_model_version)
+		throw std::runtime_error("Unsupported binary model version " + std::to_string(read_u32(data + 4)));
+	
+	// Read header
+	for (int i = 0; i < 3; ++i)
+	{
+		file.bounds.min_point[i] = read_f32(data + 8 + i * 4);
+		file.bounds.max_point[i] = read_f32(data + 20 + i * 4);
+	}
+	const std::size_t attribute_count = read_u32(data + 32);
+	const std::size_t group_count = read_u32(data + 36);
+	const std::size_t bone_count = read_u32(data + 40);
+	file.vertex_count = read_u32(data + 44);
+	file.vertex_stride = read_u32(data + 48);
+	file.index_count = read_u32(data + 52);
+	file.index_size = read_u32(data + 56);
+	const std::size_t vertex_data_offset = read_u32(data + 60);
+	const std::size_t index_data_offset = read_u32(data + 64);
+	
+	// Skeletons are not yet supported by models
+	if (bone_count)
+		throw std::runtime_error("Binary model skeletons are not supported");
+	
+	// Validate record and blob ranges
+	const std::size_t records_end = header_size + attribute_count * attribute_record_size + group_count * group_record_size;
+	const std::size_t vertex_data_size = static_cast<std::size_t>(file.vertex_count) * file.vertex_stride;
+	const std::size_t index_data_size = static_cast<std::size_t>(file.index_count) * file.index_size;
+	if (records_end > size ||
+		vertex_data_offset < records_end || vertex_data_offset > size || vertex_data_size > size - vertex_data_offset ||
+		(file.index_count && (index_data_offset > size || index_data_size > size - index_data_offset)))
+		throw std::runtime_error("Truncated binary model");
+	if (file.index_count && file.index_size != 1 && file.index_size != 2 && file.index_size != 4)
+		throw std::runtime_error("Invalid binary model index size " + std::to_string(file.index_size));
+	
+	// Read attribute records
+	const std::uint8_t* record = data + header_size;
+	file.attributes.resize(attribute_count);
+	for (model_file::attribute& attribute: file.attributes)
+	{
+		attribute.name = read_name(record, attribute_name_size);
+		attribute.size = read_u32(record + attribute_name_size);
+		attribute.offset = read_u32(record + attribute_name_size + 4);
+		if (attribute.offset + attribute.size * sizeof(float) > file.vertex_stride)
+			throw std::runtime_error("Binary model attribute \"" + attribute.name + "\" exceeds vertex stride");
+		record += attribute_record_size;
+	}
+	
+	// Read group records
+	file.groups.resize(group_count);
+	for (model_file::group& group: file.groups)
+	{
+		group.name = read_name(record, group_name_size);
+		group.start_index = read_u32(record + group_name_size);
+		group.index_count = read_u32(record + group_name_size + 4);
+		record += group_record_size;
+	}
+	
+	// Point into vertex and index blobs
+	file.vertex_data = data + vertex_data_offset;
+	file.index_data = (file.index_count) ? data + index_data_offset : nullptr;
+	file.storage.clear();
+}
+
+void read_cbor_model_file(const std::uint8_t* data, std::size_t size, model_file& file)
+{
+	// Parse CBOR in file data
+	nlohmann::json json = nlohmann::json::from_cbor(data, data + size);
+	
+	// Load attributes
+	std::vector<std::vector<float>> attribute_data;
+	file.attributes.clear();
+	file.vertex_stride = 0;
+	if (auto attributes_node = json.find("attributes"); attributes_node != json.end())
+	{
+		for (const auto& attribute_node: attributes_node.value().items())
+		{
+			model_file::attribute attribute;
+			
+			// Look up attribute name
+			if (auto type_node = attribute_node.value().find("name"); type_node != attribute_node.value().end())
+				attribute.name = type_node.value().get<std::string>();
+			
+			// Look up attribute size (per vertex)
+			attribute.size = 0;
+			if (auto size_node = attribute_node.value().find("size"); size_node != attribute_node.value().end())
+				attribute.size = size_node.value().get<std::uint32_t>();
+			if (!attribute.size)
+				continue;
+			
+			// Look up attribute data
+			std::vector<float> data;
+			if (auto data_node = attribute_node.value().find("data"); data_node != attribute_node.value().end())
+			{
+				data.reserve(data_node.value().size());
+				for (const auto& element: data_node.value())
+					data.push_back(element.get<float>());
+			}
+			
+			attribute.offset = file.vertex_stride;
+			file.vertex_stride += attribute.size * sizeof(float);
+			file.attributes.push_back(attribute);
+			attribute_data.push_back(std::move(data));
+		}
+	}
+	
+	// Determine vertex count from the shortest attribute
+	file.vertex_count = (file.attributes.empty()) ? 0 : std::numeric_limits<std::uint32_t>::max();
+	for (std::size_t i = 0; i < file.attributes.size(); ++i)
+		file.vertex_count = std::min<std::uint32_t>(file.vertex_count, attribute_data[i].size() / file.attributes[i].size);
+	
+	// Build interleaved vertex data
+	file.storage.resize(static_cast<std::size_t>(file.vertex_count) * file.vertex_stride);
+	float* v = reinterpret_cast<float*>(file.storage.data());
+	for (std::size_t i = 0; i < file.vertex_count; ++i)
+	{
+		for (std::size_t j = 0; j < file.attributes.size(); ++j)
+		{
+			const std::size_t attribute_size = file.attributes[j].size;
+			const float* a = &attribute_data[j][i * attribute_size];
+			for (std::size_t k = 0; k < attribute_size; ++k)
+				*(v++) = *(a++);
+		}
+	}
+	file.vertex_data = file.storage.data();
+	
+	// CBOR models are not indexed
+	file.index_count = 0;
+	file.index_size = 4;
+	file.index_data = nullptr;
+	
+	// Load bounds
+	file.bounds =
+	{
+		{std::numeric_limits<float>::infinity(), std::numeric_limits<float>::infinity(), std::numeric_limits<float>::infinity()},
+		{-std::numeric_limits<float>::infinity(), -std::numeric_limits<float>::infinity(), -std::numeric_limits<float>::infinity()}
+	};
+	if (auto bounds_node = json.find("bounds"); bounds_node != json.end())
+	{
+		if (auto min_node = bounds_node.value().find("min"); min_node != bounds_node.value().end())
+		{
+			float* v = &file.bounds.min_point.x;
+			for (const auto& element: min_node.value())
+				*(v++) = element.get<float>();
+		}
+		
+		if (auto max_node = bounds_node.value().find("max"); max_node != bounds_node.value().end())
+		{
+			float* v = &file.bounds.max_point.x;
+			for (const auto& element: max_node.value())
+				*(v++) = element.get<float>();
+		}
+	}
+	
+	// Load material groups, whose offsets and sizes are given in triangles
+	file.groups.clear();
+	if (auto materials_node = json.find("materials"); materials_node != json.end())
+	{
+		for (const auto& material_node: materials_node.value().items())
+		{
+			model_file::group group;
+			group.start_index = 0;
+			group.index_count = 0;
+			
+			if (auto name_node = material_node.value().find("name"); name_node != material_node.value().end())
+				group.name = name_node.value().get<std::string>();
+			if (auto offset_node = material_node.value().find("offset"); offset_node != material_node.value().end())
+				group.start_index = offset_node.value().get<std::uint32_t>() * 3;
+			if (auto size_node = material_node.value().find("size"); size_node != material_node.value().end())
+				group.index_count = size_node.value().get<std::uint32_t>() * 3;
+			
+			file.groups.push_back(group);
+		}
+	}
+}
+
+bool bake_model_file_tangents(model_file& file)
+{
+	const model_file::attribute* position_attribute = find_attribute(file, "position");
+	const model_file::attribute* normal_attribute = find_attribute(file, "normal");
+	const model_file::attribute* texcoord_attribute = find_attribute(file, "texcoord");
+	if (find_attribute(file, "tangent") || !position_attribute || !normal_attribute || !texcoord_attribute ||
+		position_attribute->size < 3 || normal_attribute->size < 3 || texcoord_attribute->size < 2)
+		return false;
+	
+	// Map each vertex to the first vertex with the same position, so tangents are accumulated across the triangles which share a position rather than the triangles which share a vertex
+	std::vector<std::uint32_t> position_indices(file.vertex_count);
+	std::unordered_map<std::string, std::uint32_t> position_map;
+	position_map.reserve(file.vertex_count);
+	for (std::uint32_t i = 0; i < file.vertex_count; ++i)
+	{
+		const char* position = reinterpret_cast<const char*>(file.vertex_data + i * file.vertex_stride + position_attribute->offset);
+		position_indices[i] = position_map.emplace(std::string(position, 3 * sizeof(float)), i).first->second;
+	}
+	
+	// Accumulate the tangents and bitangents of each triangle
+	std::vector<float> tangents(static_cast<std::size_t>(file.vertex_count) * 3, 0.0f);
+	std::vector<float> bitangents(static_cast<std::size_t>(file.vertex_count) * 3, 0.0f);
+	const std::size_t element_count = (file.index_count) ? file.index_count : file.vertex_count;
+	for (std::size_t i = 0; i + 2 < element_count; i += 3)
+	{
+		std::uint32_t indices[3];
+		float positions[3][3];
+		float texcoords[3][2];
+		for (int j = 0; j < 3; ++j)
+		{
+			indices[j] = read_index(file, i + j);
+			read_attribute(file, *position_attribute, indices[j], 3, positions[j]);
+			read_attribute(file, *texcoord_attribute, indices[j], 2, texcoords[j]);
+		}
+		
+		float e1[3], e2[3];
+		for (int k = 0; k < 3; ++k)
+		{
+			e1[k] = positions[1][k] - positions[0][k];
+			e2[k] = positions[2][k] - positions[0][k];
+		}
+		const float du1 = texcoords[1][0] - texcoords[0][0];
+		const float dv1 = texcoords[1][1] - texcoords[0][1];
+		const float du2 = texcoords[2][0] - texcoords[0][0];
+		const float dv2 = texcoords[2][1] - texcoords[0][1];
+		const float determinant = du1 * dv2 - du2 * dv1;
+		if (determinant == 0.0f)
+			continue;
+		const float r = 1.0f / determinant;
+		
+		for (int j = 0; j < 3; ++j)
+		{
+			const std::size_t p = static_cast<std::size_t>(position_indices[indices[j]]) * 3;
+			for (int k = 0; k < 3; ++k)
+			{
+				tangents[p + k] += (e1[k] * dv2 - e2[k] * dv1) * r;
+				bitangents[p + k] += (e2[k] * du1 - e1[k] * du2) * r;
+			}
+		}
+	}
+	
+	// Orthogonalize tangents against vertex normals and determine bitangent handedness
+	std::vector<float> values(static_cast<std::size_t>(file.vertex_count) * 4);
+	for (std::size_t i = 0; i < file.vertex_count; ++i)
+	{
+		float n[3];
+		read_attribute(file, *normal_attribute, i, 3, n);
+		const std::size_t p = static_cast<std::size_t>(position_indices[i]) * 3;
+		const float* t = &tangents[p];
+		const float* b = &bitangents[p];
+		
+		const float n_dot_t = n[0] * t[0] + n[1] * t[1] + n[2] * t[2];
+		float tangent[3] = {t[0] - n[0] * n_dot_t, t[1] - n[1] * n_dot_t, t[2] - n[2] * n_dot_t};
+		const float length = std::sqrt(tangent[0] * tangent[0] + tangent[1] * tangent[1] + tangent[2] * tangent[2]);
+		if (length > 0.0f)
+		{
+			for (int k = 0; k < 3; ++k)
+				tangent[k] /= length;
+		}
+		
+		const float n_cross_t[3] =
+		{
+			n[1] * tangent[2] - n[2] * tangent[1],
+			n[2] * tangent[0] - n[0] * tangent[2],
+			n[0] * tangent[1] - n[1] * tangent[0]
+		};
+		const float handedness = (n_cross_t[0] * b[0] + n_cross_t[1] * b[1] + n_cross_t[2] * b[2] < 0.0f) ? -1.0f : 1.0f;
+		
+		values[i * 4] = tangent[0];
+		values[i * 4 + 1] = tangent[1];
+		values[i * 4 + 2] = tangent[2];
+		values[i * 4 + 3] = handedness;
+	}
+	
+	append_attribute(file, "tangent", 4, values);
+	return true;
+}
+
+bool bake_model_file_barycentric(model_file& file)
+{
+	if (find_attribute(file, "barycentric"))
+		return false;
+	if (file.index_count)
+		throw std::runtime_error("Barycentric coordinates can only be baked into unindexed models");
+	
+	std::vector<float> values(static_cast<std::size_t>(file.vertex_count) * 3, 0.0f);
+	for (std::size_t i = 0; i < file.vertex_count; ++i)
+		values[i * 3 + i % 3] = 1.0f;
+	
+	append_attribute(file, "barycentric", 3, values);
+	return true;
+}
+
+void index_model_file(model_file& file)
+{
+	if (file.index_count)
+		return;
+	
+	// Map vertex bytes to the indices of unique vertices
+	std::vector<std::uint8_t> vertices;
+	std::vector<std::uint32_t> indices(file.vertex_count);
+	std::unordered_map<std::string, std::uint32_t> vertex_map;
+	vertex_map.reserve(file.vertex_count);
+	std::uint32_t vertex_count = 0;
+	for (std::size_t i = 0; i < file.vertex_count; ++i)
+	{
+		const std::uint8_t* vertex = file.vertex_data + i * file.vertex_stride;
+		auto [it, inserted] = vertex_map.emplace(std::string(reinterpret_cast<const char*>(vertex), file.vertex_stride), vertex_count);
+		if (inserted)
+		{
+			vertices.insert(vertices.end(), vertex, vertex + file.vertex_stride);
+			++vertex_count;
+		}
+		indices[i] = it->second;
+	}
+	
+	// Choose the smallest index size
+	file.index_count = file.vertex_count;
+	file.index_size = (vertex_count <= 0x100) ? 1 : (vertex_count <= 0x10000) ? 2 : 4;
+	file.vertex_count = vertex_count;
+	
+	// Store unique vertices followed by indices
+	const std::size_t vertex_data_size = vertices.size();
+	vertices.resize(vertex_data_size + static_cast<std::size_t>(file.index_count) * file.index_size);
+	std::uint8_t* index = vertices.data() + vertex_data_size;
+	for (std::uint32_t i: indices)
+	{
+		for (std::size_t j = 0; j < file.index_size; ++j)
+			*(index++) = static_cast<std::uint8_t>(i >> (j * 8));
+	}
+	
+	file.storage = std::move(vertices);
+	file.vertex_data = file.storage.data();
+	file.index_data = file.storage.data() + vertex_data_size;
+}
+
+void optimize_model_file(model_file& file)
+{
+	if (!file.index_count)
+		return;
+	
+	// Copy the model's data into its storage, so its indices can be rewritten in place
+	const std::size_t vertex_data_size = static_cast<std::size_t>(file.vertex_count) * file.vertex_stride;
+	const std::size_t index_data_size = static_cast<std::size_t>(file.index_count) * file.index_size;
+	if (file.storage.empty() || file.vertex_data != file.storage.data())
+	{
+		std::vector<std::uint8_t> storage(vertex_data_size + index_data_size);
+		std::memcpy(storage.data(), file.vertex_data, vertex_data_size);
+		std::memcpy(storage.data() + vertex_data_size, file.index_data, index_data_size);
+		file.storage = std::move(storage);
+		file.vertex_data = file.storage.data();
+		file.index_data = file.storage.data() + vertex_data_size;
+	}
+	
+	std::vector<std::uint32_t> indices(file.index_count);
+	for (std::size_t i = 0; i < file.index_count; ++i)
+		indices[i] = read_index(file, i);
+	
+	// Reorder the triangles of each group, which must keep their ranges
+	if (file.groups.empty())
+	{
+		geom::optimize_vertex_cache(indices.data(), indices.size(), file.vertex_count);
+	}
+	else
+	{
+		for (const model_file::group& group: file.groups)
+		{
+			if (static_cast<std::size_t>(group.start_index) + group.index_count <= indices.size())
+				geom::optimize_vertex_cache(indices.data() + group.start_index, group.index_count, file.vertex_count);
+		}
+	}
+	
+	// Renumber vertices in order of first use, leaving unused vertices at the end
+	const std::uint32_t unused = std::numeric_limits<std::uint32_t>::max();
+	std::vector<std::uint32_t> remap(file.vertex_count, unused);
+	std::uint32_t next_vertex = 0;
+	for (std::uint32_t& index: indices)
+	{
+		if (remap[index] == unused)
+			remap[index] = next_vertex++;
+		index = remap[index];
+	}
+	for (std::uint32_t& vertex: remap)
+	{
+		if (vertex == unused)
+			vertex = next_vertex++;
+	}
+	
+	std::vector<std::uint8_t> vertices(vertex_data_size);
+	for (std::size_t i = 0; i < file.vertex_count; ++i)
+		std::memcpy(vertices.data() + static_cast<std::size_t>(remap[i]) * file.vertex_stride, file.vertex_data + i * file.vertex_stride, file.vertex_stride);
+	std::memcpy(file.storage.data(), vertices.data(), vertex_data_size);
+	for (std::size_t i = 0; i < file.index_count; ++i)
+		write_index(file, i, indices[i]);
+}
+
+void write_binary_model_file(const model_file& file, std::vector<std::uint8_t>& buffer)
+{
+	const std::size_t vertex_data_size = static_cast<std::size_t>(file.vertex_count) * file.vertex_stride;
+	const std::size_t index_data_size = static_cast<std::size_t>(file.index_count) * file.index_size;
+	const std::size_t records_end = header_size + file.attributes.size() * attribute_record_size + file.groups.size() * group_record_size;
+	const std::size_t vertex_data_offset = align(records_end);
+	const std::size_t index_data_offset = align(vertex_data_offset + vertex_data_size);
+	const std::size_t size = (file.index_count) ? index_data_offset + index_data_size : vertex_data_offset + vertex_data_size;
+	if (size > std::numeric_limits<std::uint32_t>::max())
+		throw std::runtime_error("Model exceeds the 4 GiB limit of the binary model format");
+	
+	buffer.assign(size, 0);
+	std::uint8_t* data = buffer.data();
+	
+	// Write header
+	std::memcpy(data, binary_model_magic, sizeof(binary_model_magic));
+	write_u32(data + 4, binary_model_version);
+	for (int i = 0; i < 3; ++i)
+	{
+		write_f32(data + 8 + i * 4, file.bounds.min_point[i]);
+		write_f32(data + 20 + i * 4, file.bounds.max_point[i]);
+	}
+	write_u32(data + 32, static_cast<std::uint32_t>(file.attributes.size()));
+	write_u32(data + 36, static_cast<std::uint32_t>(file.groups.size()));
+	write_u32(data + 40, 0);
+	write_u32(data + 44, file.vertex_count);
+	write_u32(data + 48, file.vertex_stride);
+	write_u32(data + 52, file.index_count);
+	write_u32(data + 56, file.index_size);
+	write_u32(data + 60, static_cast<std::uint32_t>(vertex_data_offset));
+	write_u32(data + 64, static_cast<std::uint32_t>((file.index_count) ? index_data_offset : 0));
+	
+	// Write attribute records
+	std::uint8_t* record = data + header_size;
+	for (const model_file::attribute& attribute: file.attributes)
+	{
+		write_name(record, attribute_name_size, attribute.name);
+		write_u32(record + attribute_name_size, attribute.size);
+		write_u32(record + attribute_name_size + 4, attribute.offset);
+		record += attribute_record_size;
+	}
+	
+	// Write group records
+	for (const model_file::group& group: file.groups)
+	{
+		write_name(record, group_name_size, group.name);
+		write_u32(record + group_name_size, group.start_index);
+		write_u32(record + group_name_size + 4, group.index_count);
+		record += group_record_size;
+	}
+	
+	// Write vertex and index blobs
+	if (vertex_data_size)
+		std::memcpy(data + vertex_data_offset, file.vertex_data, vertex_data_size);
+	if (index_data_size)
+		std::memcpy(data + index_data_offset, file.index_data, index_data_size);
+}
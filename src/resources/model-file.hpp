@@ -0,0 +1,163 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ANTKEEPER_MODEL_FILE_HPP
+#define ANTKEEPER_MODEL_FILE_HPP
+
+#include "geom/aabb.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Model data as stored in model files, independent of OpenGL.
+ *
+ * Models are stored either as CBOR, with one array per vertex attribute, or in a binary format which is read without parsing. Binary model files consist of a header, attribute records, material group records, and bone records, followed by a blob of interleaved vertex data and an optional blob of index data, each of which can be uploaded directly to a vertex buffer. All values are little-endian.
+ */
+struct model_file
+{
+	/// Vertex attribute, stored as 32-bit floats.
+	struct attribute
+	{
+		/// Name of the attribute, such as `position` or `normal`.
+		std::string name;
+		
+		/// Number of components per vertex.
+		std::uint32_t size;
+		
+		/// Offset of the attribute within a vertex, in bytes.
+		std::uint32_t offset;
+	};
+	
+	/// Range of indices drawn with a single material.
+	struct group
+	{
+		/// Name of the material group, from which the material filename is derived.
+		std::string name;
+		
+		/// Index of the first vertex or element of the group.
+		std::uint32_t start_index;
+		
+		/// Number of vertices or elements in the group.
+		std::uint32_t index_count;
+	};
+	
+	/// Bounds of the model.
+	geom::aabb<float> bounds;
+	
+	/// Vertex attributes, in the order in which they are interleaved.
+	std::vector<attribute> attributes;
+	
+	/// Material groups.
+	std::vector<group> groups;
+	
+	/// Number of vertices.
+	std::uint32_t vertex_count;
+	
+	/// Size of a vertex, in bytes.
+	std::uint32_t vertex_stride;
+	
+	/// Number of indices, or `0` if the model is not indexed.
+	std::uint32_t index_count;
+	
+	/// Size of an index, in bytes: `1`, `2`, or `4`.
+	std::uint32_t index_size;
+	
+	/// Interleaved vertex data, `vertex_count * vertex_stride` bytes.
+	const std::uint8_t* vertex_data;
+	
+	/// Index data, `index_count * index_size` bytes.
+	const std::uint8_t* index_data;
+	
+	/// Storage of the vertex and index data, if they do not point into the buffer from which the model was read.
+	std::vector<std::uint8_t> storage;
+};
+
+/**
+ * Returns `true` if a buffer contains a binary model file.
+ *
+ * @param data File data.
+ * @param size Size of the file data, in bytes.
+ */
+bool is_binary_model_file(const std::uint8_t* data, std::size_t size);
+
+/**
+ * Reads a binary model file. The vertex and index data of the model point into the file data, which must outlive the model.
+ *
+ * @param data File data.
+ * @param size Size of the file data, in bytes.
+ * @param[out] file Model data.
+ *
+ * @exception std::runtime_error Malformed binary model file.
+ */
+void read_binary_model_file(const std::uint8_t* data, std::size_t size, model_file& file);
+
+/**
+ * Reads a CBOR model file, interleaving its vertex attributes into the storage of the model.
+ *
+ * @param data File data.
+ * @param size Size of the file data, in bytes.
+ * @param[out] file Model data.
+ */
+void read_cbor_model_file(const std::uint8_t* data, std::size_t size, model_file& file);
+
+/**
+ * Bakes a tangent attribute into a model which has positions, normals, and texture coordinates but no tangents, so that they need not be derived when the model is loaded. Tangents are accumulated over the triangles sharing each position, orthogonalized against the normal of each vertex, and stored with the handedness of the bitangent in their fourth component.
+ *
+ * @param[in,out] file Model data.
+ * @return `true` if tangents were baked, `false` if the model already had tangents or lacked the attributes from which they are derived.
+ */
+bool bake_model_file_tangents(model_file& file);
+
+/**
+ * Bakes a barycentric attribute into an unindexed model, which assigns each corner of every triangle a distinct unit vector, for shaders which draw triangle edges.
+ *
+ * @param[in,out] file Model data.
+ * @return `true` if barycentric coordinates were baked, `false` if the model already had them.
+ *
+ * @exception std::runtime_error Model is indexed.
+ */
+bool bake_model_file_barycentric(model_file& file);
+
+/**
+ * Welds identical vertices of an unindexed model, replacing its vertex data with unique vertices referenced by an index buffer. The smallest index size able to address all unique vertices is chosen. Group ranges are preserved, as they then refer to elements rather than vertices.
+ *
+ * @param[in,out] file Model data.
+ */
+void index_model_file(model_file& file);
+
+/**
+ * Optimizes an indexed model for drawing. The triangles of each material group are reordered for the post-transform vertex cache, then vertices are reordered by their first use, so that they are fetched in order.
+ *
+ * @param[in,out] file Model data. Unindexed models are left unchanged.
+ *
+ * @see geom::optimize_vertex_cache()
+ */
+void optimize_model_file(model_file& file);
+
+/**
+ * Writes a binary model file.
+ *
+ * @param file Model data.
+ * @param[out] buffer Buffer to which the file data will be written.
+ */
+void write_binary_model_file(const model_file& file, std::vector<std::uint8_t>& buffer);
+
+#endif // ANTKEEPER_MODEL_FILE_HPP
+
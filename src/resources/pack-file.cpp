@@ -0,0 +1,321 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "resources/pack-file.hpp"
+#include "utility/fnv1a.hpp"
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <unordered_set>
+
+#if defined(_WIN32)
+	#include <windows.h>
+#else
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+namespace {
+
+/// Identifies pack files.
+constexpr std::uint8_t pack_magic[4] = {'A', 'K', 'P', 'K'};
+
+/// Version of the pack format.
+constexpr std::uint32_t pack_version = 1;
+
+/// Size of the header, in bytes.
+constexpr std::size_t header_size = 32;
+
+/// Size of a hash table bucket, in bytes.
+constexpr std::size_t bucket_size = 4;
+
+/// Size of an entry, in bytes.
+constexpr std::size_t entry_size = 32;
+
+/// Bucket value of empty buckets.
+constexpr std::uint32_t empty_bucket = 0xffffffff;
+
+/// Alignment of entry contents, in bytes.
+constexpr std::size_t data_alignment = 16;
+
+std::uint32_t read_u32(const std::uint8_t* data)
+{
+	std::uint32_t value = 0;
+	for (int i = 3; i >= 0; --i)
+		value = (value << 8) | data[i];
+	return value;
+}
+
+std::uint64_t read_u64(const std::uint8_t* data)
+{
+	return static_cast<std::uint64_t>(read_u32(data)) | (static_cast<std::uint64_t>(read_u32(data + 4)) << 32);
+}
+
+void write_u32(std::uint8_t* data, std::uint32_t value)
+{
+	for (int i = 0; i < 4; ++i)
+		data[i] = static_cast<std::uint8_t>(value >> (i * 8));
+}
+
+void write_u64(std::uint8_t* data, std::uint64_t value)
+{
+	write_u32(data, static_cast<std::uint32_t>(value));
+	write_u32(data + 4, static_cast<std::uint32_t>(value >> 32));
+}
+
+std::size_t align(std::size_t offset)
+{
+	return (offset + data_alignment - 1) & ~(data_alignment - 1);
+}
+
+#if defined(_WIN32)
+	std::wstring widen(const std::string& string)
+	{
+		std::wstring wstring(MultiByteToWideChar(CP_UTF8, 0, &string[0], static_cast<int>(string.size()), nullptr, 0), L'\0');
+		MultiByteToWideChar(CP_UTF8, 0, &string[0], static_cast<int>(string.size()), &wstring[0], static_cast<int>(wstring.size()));
+		return wstring;
+	}
+#endif
+
+} // namespace
+
+pack_file::pack_file(const std::string& path):
+	data(nullptr),
+	size(0)
+{
+	#if defined(_WIN32)
+		file_handle = CreateFileW(widen(path).c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file_handle == INVALID_HANDLE_VALUE)
+			throw std::runtime_error("Failed to open pack file \"" + path + "\"");
+		
+		LARGE_INTEGER file_size;
+		GetFileSizeEx(file_handle, &file_size);
+		size = static_cast<std::size_t>(file_size.QuadPart);
+		
+		mapping_handle = (size) ? CreateFileMappingW(file_handle, nullptr, PAGE_READONLY, 0, 0, nullptr) : nullptr;
+		if (mapping_handle)
+			data = static_cast<const std::uint8_t*>(MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0));
+		if (!data)
+		{
+			if (mapping_handle)
+				CloseHandle(mapping_handle);
+			CloseHandle(file_handle);
+			throw std::runtime_error("Failed to map pack file \"" + path + "\"");
+		}
+	#else
+		file_descriptor = open(path.c_str(), O_RDONLY);
+		if (file_descriptor == -1)
+			throw std::runtime_error("Failed to open pack file \"" + path + "\"");
+		
+		struct stat file_status;
+		if (fstat(file_descriptor, &file_status) == 0)
+			size = static_cast<std::size_t>(file_status.st_size);
+		
+		void* mapping = (size) ? mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file_descriptor, 0) : MAP_FAILED;
+		if (mapping == MAP_FAILED)
+		{
+			close(file_descriptor);
+			throw std::runtime_error("Failed to map pack file \"" + path + "\"");
+		}
+		data = static_cast<const std::uint8_t*>(mapping);
+	#endif
+	
+	// Validate header
+	std::string error;
+	if (size < header_size || std::memcmp(data, pack_magic, sizeof(pack_magic)))
+	{
+		error = "Invalid pack file header";
+	}
+	else if (read_u32(data + 4) != pack_version)
+	{
+		error = "Unsupported pack file version " + std::to_string(read_u32(data + 4));
+	}
+	else
+	{
+		entry_count = read_u32(data + 8);
+		const std::size_t bucket_count = read_u32(data + 12);
+		const std::uint64_t buckets_offset = read_u64(data + 16);
+		const std::uint64_t entries_offset = read_u64(data + 24);
+		bucket_mask = bucket_count - 1;
+		
+		if (!bucket_count || (bucket_count & bucket_mask) || bucket_count < entry_count ||
+			buckets_offset > size || bucket_count * bucket_size > size - buckets_offset ||
+			entries_offset > size || entry_count * entry_size > size - entries_offset)
+		{
+			error = "Malformed pack file table of contents";
+		}
+		else
+		{
+			buckets = data + buckets_offset;
+			entries = data + entries_offset;
+		}
+	}
+	
+	if (!error.empty())
+	{
+		unmap();
+		throw std::runtime_error(error + " in \"" + path + "\"");
+	}
+}
+
+pack_file::~pack_file()
+{
+	unmap();
+}
+
+void pack_file::unmap()
+{
+	#if defined(_WIN32)
+		UnmapViewOfFile(data);
+		CloseHandle(mapping_handle);
+		CloseHandle(file_handle);
+	#else
+		munmap(const_cast<std::uint8_t*>(data), size);
+		close(file_descriptor);
+	#endif
+}
+
+bool pack_file::find(const std::string& path, const std::uint8_t*& data, std::size_t& size) const
+{
+	const std::uint64_t path_hash = hash(path);
+	
+	std::size_t i = path_hash & bucket_mask;
+	for (std::size_t probe = 0; probe <= bucket_mask; ++probe, i = (i + 1) & bucket_mask)
+	{
+		const std::uint32_t index = read_u32(buckets + i * bucket_size);
+		if (index == empty_bucket || index >= entry_count)
+			return false;
+		
+		const std::uint8_t* entry = entries + index * entry_size;
+		if (read_u64(entry) != path_hash)
+			continue;
+		
+		// Compare paths to resolve hash collisions
+		const std::uint64_t data_offset = read_u64(entry + 8);
+		const std::uint64_t data_size = read_u64(entry + 16);
+		const std::size_t path_offset = read_u32(entry + 24);
+		const std::size_t path_length = read_u32(entry + 28);
+		if (path_length != path.length() || path_offset > this->size || path_length > this->size - path_offset ||
+			std::memcmp(this->data + path_offset, path.data(), path_length))
+			continue;
+		
+		if (data_offset > this->size || data_size > this->size - data_offset)
+			return false;
+		
+		data = this->data + data_offset;
+		size = static_cast<std::size_t>(data_size);
+		return true;
+	}
+	
+	return false;
+}
+
+bool pack_file::is_pack_file(const std::string& path)
+{
+	char magic[sizeof(pack_magic)];
+	std::ifstream stream(path, std::ios::binary);
+	return stream.read(magic, sizeof(magic)) && !std::memcmp(magic, pack_magic, sizeof(pack_magic));
+}
+
+void pack_file::write(const std::string& path, const std::vector<std::string>& entry_paths, const std::vector<std::string>& source_paths)
+{
+	if (entry_paths.size() != source_paths.size())
+		throw std::runtime_error("Pack entry path count does not match source path count");
+	
+	// Size the hash table to at most half full
+	const std::size_t entry_count = entry_paths.size();
+	std::size_t bucket_count = 1;
+	while (bucket_count < entry_count * 2)
+		bucket_count <<= 1;
+	
+	// Lay out the table of contents, followed by entry paths
+	const std::size_t buckets_offset = header_size;
+	const std::size_t entries_offset = buckets_offset + bucket_count * bucket_size;
+	std::size_t offset = entries_offset + entry_count * entry_size;
+	std::vector<std::uint8_t> toc(offset, 0);
+	std::unordered_set<std::string> unique_paths;
+	for (std::size_t i = 0; i < entry_count; ++i)
+	{
+		if (!unique_paths.insert(entry_paths[i]).second)
+			throw std::runtime_error("Duplicate pack entry path \"" + entry_paths[i] + "\"");
+		
+		write_u32(&toc[entries_offset + i * entry_size + 24], static_cast<std::uint32_t>(toc.size()));
+		write_u32(&toc[entries_offset + i * entry_size + 28], static_cast<std::uint32_t>(entry_paths[i].size()));
+		toc.insert(toc.end(), entry_paths[i].begin(), entry_paths[i].end());
+	}
+	
+	// Write header
+	std::memcpy(&toc[0], pack_magic, sizeof(pack_magic));
+	write_u32(&toc[4], pack_version);
+	write_u32(&toc[8], static_cast<std::uint32_t>(entry_count));
+	write_u32(&toc[12], static_cast<std::uint32_t>(bucket_count));
+	write_u64(&toc[16], buckets_offset);
+	write_u64(&toc[24], entries_offset);
+	
+	// Fill hash table
+	for (std::size_t i = 0; i < bucket_count; ++i)
+		write_u32(&toc[buckets_offset + i * bucket_size], empty_bucket);
+	for (std::size_t i = 0; i < entry_count; ++i)
+	{
+		const std::uint64_t path_hash = hash(entry_paths[i]);
+		write_u64(&toc[entries_offset + i * entry_size], path_hash);
+		
+		std::size_t bucket = path_hash & (bucket_count - 1);
+		while (read_u32(&toc[buckets_offset + bucket * bucket_size]) != empty_bucket)
+			bucket = (bucket + 1) & (bucket_count - 1);
+		write_u32(&toc[buckets_offset + bucket * bucket_size], static_cast<std::uint32_t>(i));
+	}
+	
+	std::ofstream output(path, std::ios::binary);
+	if (!output)
+		throw std::runtime_error("Failed to open \"" + path + "\" for writing");
+	
+	// Write entry contents after the table of contents, then patch their offsets and sizes into the table
+	offset = toc.size();
+	output.write(reinterpret_cast<const char*>(toc.data()), toc.size());
+	for (std::size_t i = 0; i < entry_count; ++i)
+	{
+		std::ifstream input(source_paths[i], std::ios::binary);
+		if (!input)
+			throw std::runtime_error("Failed to open \"" + source_paths[i] + "\"");
+		const std::vector<char> contents((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+		
+		const std::size_t padding = align(offset) - offset;
+		output.write("\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0", padding);
+		offset += padding;
+		
+		write_u64(&toc[entries_offset + i * entry_size + 8], offset);
+		write_u64(&toc[entries_offset + i * entry_size + 16], contents.size());
+		output.write(contents.data(), contents.size());
+		offset += contents.size();
+	}
+	
+	output.seekp(0);
+	output.write(reinterpret_cast<const char*>(toc.data()), toc.size());
+	if (!output)
+		throw std::runtime_error("Failed to write \"" + path + "\"");
+}
+
+std::uint64_t pack_file::hash(const std::string& path)
+{
+	return fnv1a64(path);
+}
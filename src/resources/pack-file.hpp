@@ -0,0 +1,110 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ANTKEEPER_PACK_FILE_HPP
+#define ANTKEEPER_PACK_FILE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Read-only, memory-mapped archive of resource files.
+ *
+ * A pack file consists of a header, a hash table of entry indices, a table of entries, a blob of entry paths, and the uncompressed contents of each entry, aligned to 16 bytes. Entries are located by the FNV-1a hash of their path with linear probing, so that finding a file does not depend on the number of files in the pack. All values are little-endian.
+ */
+class pack_file
+{
+public:
+	/**
+	 * Opens and memory-maps a pack file.
+	 *
+	 * @param path Path to the pack file, in the native file system.
+	 *
+	 * @exception std::runtime_error Failed to map the pack file, or the file is not a valid pack file.
+	 */
+	explicit pack_file(const std::string& path);
+	
+	/// Unmaps the pack file.
+	~pack_file();
+	
+	pack_file(const pack_file&) = delete;
+	pack_file& operator=(const pack_file&) = delete;
+	
+	/**
+	 * Finds the contents of a file in the pack. Safe to call concurrently.
+	 *
+	 * @param path Path of the file within the pack, such as `/shaders/ui-element-textured.glsl`.
+	 * @param[out] data Contents of the file, which remain mapped for the lifetime of the pack file.
+	 * @param[out] size Size of the file contents, in bytes.
+	 * @return `true` if the file was found, `false` otherwise.
+	 */
+	bool find(const std::string& path, const std::uint8_t*& data, std::size_t& size) const;
+	
+	/// Returns the number of files in the pack.
+	std::size_t get_entry_count() const;
+	
+	/**
+	 * Returns `true` if a file in the native file system begins with the pack file signature.
+	 *
+	 * @param path Path to the file.
+	 */
+	static bool is_pack_file(const std::string& path);
+	
+	/**
+	 * Writes a pack file.
+	 *
+	 * @param path Path to the pack file to write, in the native file system.
+	 * @param entry_paths Paths of the files within the pack.
+	 * @param source_paths Paths of the files to pack, in the native file system.
+	 *
+	 * @exception std::runtime_error Failed to read a source file or to write the pack file.
+	 */
+	static void write(const std::string& path, const std::vector<std::string>& entry_paths, const std::vector<std::string>& source_paths);
+
+private:
+	/// Unmaps and closes the pack file.
+	void unmap();
+	
+	/// Returns the FNV-1a hash of a path.
+	static std::uint64_t hash(const std::string& path);
+	
+	const std::uint8_t* data;
+	std::size_t size;
+	std::size_t entry_count;
+	std::size_t bucket_mask;
+	const std::uint8_t* buckets;
+	const std::uint8_t* entries;
+	
+	#if defined(_WIN32)
+		void* file_handle;
+		void* mapping_handle;
+	#else
+		int file_descriptor;
+	#endif
+};
+
+inline std::size_t pack_file::get_entry_count() const
+{
+	return entry_count;
+}
+
+#endif // ANTKEEPER_PACK_FILE_HPP
+
@@ -20,6 +20,9 @@
 #include "resources/resource-handle.hpp"
 
 resource_handle_base::resource_handle_base():
-	reference_count(0)
+	reference_count(0),
+	type(nullptr),
+	cpu_size(0),
+	gpu_size(0)
 {}
 
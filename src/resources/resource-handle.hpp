@@ -21,6 +21,8 @@
 #define ANTKEEPER_RESOURCE_HANDLE_HPP
 
 #include <cstdlib>
+#include <string>
+#include <typeinfo>
 
 /**
  * Base class for resource handles.
@@ -36,6 +38,18 @@ public:
 
 	/// Number of times the handle is referenced.
 	std::size_t reference_count;
+	
+	/// Name of the resource.
+	std::string name;
+	
+	/// Type of the resource data.
+	const std::type_info* type;
+	
+	/// Bytes of CPU memory occupied by the resource data.
+	std::size_t cpu_size;
+	
+	/// Bytes of GPU memory occupied by the resource data.
+	std::size_t gpu_size;
 };
 
 /**
@@ -18,26 +18,26 @@
  */
 
 #include "resource-loader.hpp"
-#include <physfs.h>
+#include <algorithm>
+#include <cstring>
 
-void physfs_getline(PHYSFS_File* file, std::string& line)
+bool resource_getline(const std::uint8_t* data, std::size_t size, std::size_t& offset, std::string& line)
 {
-	PHYSFS_sint64 bytes;
-	char c;
-	
-	line.clear();
-	
-	do
+	if (offset >= size)
 	{
-		bytes = PHYSFS_readBytes(file, &c, 1);
-		
-		if (bytes != 1 || c == '\n')
-			break;
-		
-		if (c == '\r')
-			continue;
-		
-		line.append(1, c);
+		line.clear();
+		return false;
 	}
-	while (!PHYSFS_eof(file));
+	
+	// Find line break
+	const char* begin = reinterpret_cast<const char*>(data + offset);
+	const char* end = static_cast<const char*>(std::memchr(begin, '\n', size - offset));
+	const std::size_t length = (end) ? end - begin : size - offset;
+	line.assign(begin, length);
+	offset += (end) ? length + 1 : length;
+	
+	// Strip carriage returns
+	line.erase(std::remove(line.begin(), line.end(), '\r'), line.end());
+	
+	return true;
 }
@@ -20,11 +20,17 @@
 #ifndef RESOURCE_LOADER_HPP
 #define RESOURCE_LOADER_HPP
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
 
 class resource_manager;
 struct PHYSFS_File;
 
+class model;
+namespace geom { class mesh; }
+namespace gl { class texture_2d; class texture_2d_array; }
+
 /**
  * Templated resource loader.
  *
@@ -38,10 +44,11 @@ public:
 	 * Loads resource data.
 	 *
 	 * @param resourceManager Pointer to a resource manager which will manage this resource.
-	 * @param file PhysicsFS file handle.
+	 * @param data Contents of the resource file, either mapped from a pack file or read from a PhysicsFS file. Valid only for the duration of the call.
+	 * @param size Size of the file contents, in bytes.
 	 * @return Pointer to the loaded resource.
 	 */
-	static T* load(resource_manager* resourceManager, PHYSFS_File* file);
+	static T* load(resource_manager* resourceManager, const std::uint8_t* data, std::size_t size);
 
 	/**
 	 * Saves resource data.
@@ -53,7 +60,82 @@ public:
 	static void save(resource_manager* resourceManager, PHYSFS_File* file, const T* resource);
 };
 
-/// getline function for PhysicsFS file handles
-void physfs_getline(PHYSFS_File* file, std::string& line);
+/**
+ * Describes how resources of a type may be loaded.
+ *
+ * @tparam T Type of resource.
+ */
+template <typename T>
+struct resource_loader_traits
+{
+	/// `true` if resources of the type may be loaded by worker threads. Loaders which create OpenGL objects or load other resources must run on the main thread.
+	static constexpr bool concurrent = false;
+};
+
+template <>
+struct resource_loader_traits<geom::mesh>
+{
+	static constexpr bool concurrent = true;
+};
+
+/**
+ * Estimates the memory occupied by resources of a type, for the memory accounting of the resource manager.
+ *
+ * @tparam T Type of resource.
+ */
+template <typename T>
+struct resource_footprint
+{
+	/// Returns the number of bytes of CPU memory occupied by a resource.
+	static std::size_t cpu_size(const T& resource)
+	{
+		return sizeof(T);
+	}
+	
+	/// Returns the number of bytes of GPU memory occupied by a resource.
+	static std::size_t gpu_size(const T& resource)
+	{
+		return 0;
+	}
+};
+
+template <>
+struct resource_footprint<geom::mesh>
+{
+	static std::size_t cpu_size(const geom::mesh& resource);
+	static std::size_t gpu_size(const geom::mesh& resource);
+};
+
+template <>
+struct resource_footprint<gl::texture_2d>
+{
+	static std::size_t cpu_size(const gl::texture_2d& resource);
+	static std::size_t gpu_size(const gl::texture_2d& resource);
+};
+
+template <>
+struct resource_footprint<gl::texture_2d_array>
+{
+	static std::size_t cpu_size(const gl::texture_2d_array& resource);
+	static std::size_t gpu_size(const gl::texture_2d_array& resource);
+};
+
+template <>
+struct resource_footprint<model>
+{
+	static std::size_t cpu_size(const model& resource);
+	static std::size_t gpu_size(const model& resource);
+};
+
+/**
+ * getline function for resource file contents.
+ *
+ * @param data Contents of the resource file.
+ * @param size Size of the file contents, in bytes.
+ * @param[in,out] offset Offset of the line, which will be advanced past the line and its line break.
+ * @param[out] line Line, without its line break.
+ * @return `false` if there are no more lines, `true` otherwise.
+ */
+bool resource_getline(const std::uint8_t* data, std::size_t size, std::size_t& offset, std::string& line);
 
 #endif // RESOURCE_LOADER_HPP
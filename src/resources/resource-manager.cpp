@@ -18,9 +18,22 @@
  */
 
 #include "resources/resource-manager.hpp"
+#include "resources/string-table.hpp"
+#include "debug/counters.hpp"
+#include "renderer/texture-streamer.hpp"
+#include "gl/texture-2d.hpp"
+#include <chrono>
+#include <iterator>
+#include <unordered_set>
+#if defined(__GNUG__)
+	#include <cxxabi.h>
+#endif
 
 resource_manager::resource_manager(debug::logger* logger):
-	logger(logger)
+	logger(logger),
+	jobs(nullptr),
+	shader_cache(nullptr),
+	texture_streamer(nullptr)
 {
 	// Init PhysicsFS
 	logger->push_task("Initializing PhysicsFS");
@@ -37,12 +50,38 @@ resource_manager::resource_manager(debug::logger* logger):
 
 resource_manager::~resource_manager()
 {
+	// Wait for worker threads to finish prefetching files
+	discard_prefetches();
+	
+	// Wait for worker threads to finish loading requested resources, which are freed along with their requests
+	for (const auto& request: request_queue)
+	{
+		if (request->concurrent)
+		{
+			jobs->wait(request->counter);
+		}
+	}
+	request_queue.clear();
+	pending_requests.clear();
+	
+	// Release the compressed images of streamed textures, which are deleted along with the other cached resources
+	if (texture_streamer)
+	{
+		texture_streamer->clear();
+	}
+	
 	// Delete cached resources
 	for (auto it = resource_cache.begin(); it != resource_cache.end(); ++it)
 	{
 		delete it->second;
 	}
 	
+	// Unmap pack files
+	for (pack_file* pack: packs)
+	{
+		delete pack;
+	}
+	
 	// Deinit PhysicsFS
 	logger->push_task("Deinitializing PhysicsFS");
 	if (!PHYSFS_deinit())
@@ -59,6 +98,25 @@ resource_manager::~resource_manager()
 bool resource_manager::mount(const std::string& path)
 {
 	logger->push_task("Mounting path \"" + path + "\"");
+	
+	// Memory-map pack files
+	if (pack_file::is_pack_file(path))
+	{
+		try
+		{
+			packs.push_back(new pack_file(path));
+		}
+		catch (const std::exception& e)
+		{
+			logger->error(e.what());
+			logger->pop_task(EXIT_FAILURE);
+			return false;
+		}
+		
+		logger->pop_task(EXIT_SUCCESS);
+		return true;
+	}
+	
 	if (!PHYSFS_mount(path.c_str(), nullptr, 1))
 	{
 		logger->error(std::string("PhysicsFS error: ") + PHYSFS_getErrorByCode(PHYSFS_getLastErrorCode()));
@@ -73,9 +131,14 @@ bool resource_manager::mount(const std::string& path)
 }
 
 void resource_manager::unload(const std::string& name)
+{
+	release(fnv1a64(name));
+}
+
+void resource_manager::release(std::uint64_t key)
 {
 	// Check if resource is in the cache
-	auto it = resource_cache.find(name);
+	auto it = resource_cache.find(key);
 	if (it != resource_cache.end())
 	{
 		// Decrement the resource handle reference count
@@ -86,7 +149,18 @@ void resource_manager::unload(const std::string& name)
 		{
 			if (logger)
 			{
-				logger->push_task("Unloading resource \"" + name + "\"");
+				logger->push_task("Unloading resource \"" + it->second->name + "\"");
+			}
+			
+			--usage.count;
+			usage.cpu_size -= it->second->cpu_size;
+			usage.gpu_size -= it->second->gpu_size;
+			update_usage_gauges();
+			
+			// Stop streaming textures before they're deleted, which releases their compressed images
+			if (texture_streamer && *it->second->type == typeid(gl::texture_2d))
+			{
+				texture_streamer->remove_texture(static_cast<resource_handle<gl::texture_2d>*>(it->second)->data);
 			}
 			
 			delete it->second;
@@ -95,10 +169,10 @@ void resource_manager::unload(const std::string& name)
 			{
 				logger->pop_task(EXIT_SUCCESS);
 			}
+			
+			// Remove resource from the cache
+			resource_cache.erase(it);
 		}
-
-		// Remove resource from the cache
-		resource_cache.erase(it);
 	}
 }
 
@@ -107,3 +181,409 @@ void resource_manager::include(const std::string& search_path)
 	search_paths.push_back(search_path);
 }
 
+bool resource_manager::exists(const std::string& name) const
+{
+	// Reuse one path buffer for all probes
+	std::string path;
+	for (const std::string& search_path: search_paths)
+	{
+		path.assign(search_path).append(name);
+		
+		for (const pack_file* pack: packs)
+		{
+			const std::uint8_t* data;
+			std::size_t size;
+			if (pack->find(path, data, size))
+				return true;
+		}
+		
+		if (PHYSFS_exists(path.c_str()))
+			return true;
+	}
+	
+	return false;
+}
+
+bool resource_manager::read_dependency_manifest(const std::string& path)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file)
+	{
+		return false;
+	}
+	std::vector<std::uint8_t> buffer((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	
+	// Each row lists a resource followed by its dependencies
+	parse_string_table(buffer.data(), buffer.size(), [this](const string_table_row& row)
+	{
+		if (row.size() < 2 || row[0].empty())
+		{
+			return;
+		}
+		
+		std::set<std::string>& resource_dependencies = dependencies[std::string(row[0])];
+		resource_dependencies.clear();
+		for (std::size_t i = 1; i < row.size(); ++i)
+		{
+			if (!row[i].empty())
+			{
+				resource_dependencies.emplace(row[i]);
+			}
+		}
+	});
+	
+	return true;
+}
+
+bool resource_manager::write_dependency_manifest(const std::string& path) const
+{
+	std::ofstream file(path, std::ios::binary);
+	if (!file)
+	{
+		return false;
+	}
+	
+	// Quote names and escape quotes and backslashes, as required by the string table parser
+	auto write_name = [&file](const std::string& name)
+	{
+		file.put('"');
+		for (char c: name)
+		{
+			if (c == '"' || c == '\\')
+			{
+				file.put('\\');
+			}
+			file.put(c);
+		}
+		file.put('"');
+	};
+	
+	for (const auto& [name, resource_dependencies]: dependencies)
+	{
+		if (resource_dependencies.empty())
+		{
+			continue;
+		}
+		
+		write_name(name);
+		for (const std::string& dependency: resource_dependencies)
+		{
+			file.put(',');
+			write_name(dependency);
+		}
+		file.put('\n');
+	}
+	
+	return static_cast<bool>(file);
+}
+
+void resource_manager::prefetch_dependencies(const std::string& name)
+{
+	if (!jobs || dependencies.find(name) == dependencies.end())
+	{
+		return;
+	}
+	
+	// Traverse the dependency graph, stopping at cached resources, whose dependencies have already been loaded
+	std::vector<const std::string*> stack = {&name};
+	std::unordered_set<std::uint64_t> visited = {fnv1a64(name)};
+	while (!stack.empty())
+	{
+		auto resource_dependencies = dependencies.find(*stack.back());
+		stack.pop_back();
+		if (resource_dependencies == dependencies.end())
+		{
+			continue;
+		}
+		
+		for (const std::string& dependency: resource_dependencies->second)
+		{
+			const std::uint64_t key = fnv1a64(dependency);
+			if (!visited.insert(key).second || resource_cache.count(key) || pending_requests.count(key))
+			{
+				continue;
+			}
+			stack.push_back(&dependency);
+			
+			// Read the file on a worker thread, searching the search paths in the same order as read()
+			std::unique_ptr<prefetch> request = std::make_unique<prefetch>();
+			request->name = dependency;
+			prefetch* pending = request.get();
+			jobs->submit
+			(
+				[this, pending]()
+				{
+					std::string path;
+					for (const std::string& search_path: search_paths)
+					{
+						path.assign(search_path).append(pending->name);
+						
+						// Files in pack files are already in memory
+						for (const pack_file* pack: packs)
+						{
+							const std::uint8_t* data;
+							std::size_t size;
+							if (pack->find(path, data, size))
+							{
+								return;
+							}
+						}
+						
+						if (PHYSFS_exists(path.c_str()))
+						{
+							std::string error;
+							pending->found = read_file(path, pending->buffer, error);
+							return;
+						}
+					}
+				},
+				&pending->counter
+			);
+			
+			// Publish the prefetch only once it has been submitted, so that its counter can be waited on
+			std::lock_guard<std::mutex> lock(prefetch_mutex);
+			prefetches[key] = std::move(request);
+		}
+	}
+}
+
+bool resource_manager::take_prefetch(const std::string& name, std::vector<std::uint8_t>& buffer)
+{
+	std::unique_ptr<prefetch> request;
+	{
+		std::lock_guard<std::mutex> lock(prefetch_mutex);
+		if (prefetches.empty())
+		{
+			return false;
+		}
+		
+		auto it = prefetches.find(fnv1a64(name));
+		if (it == prefetches.end() || it->second->name != name)
+		{
+			return false;
+		}
+		
+		request = std::move(it->second);
+		prefetches.erase(it);
+	}
+	
+	jobs->wait(request->counter);
+	if (!request->found)
+	{
+		return false;
+	}
+	
+	buffer = std::move(request->buffer);
+	return true;
+}
+
+void resource_manager::discard_prefetches()
+{
+	std::unordered_map<std::uint64_t, std::unique_ptr<prefetch>> discarded;
+	{
+		std::lock_guard<std::mutex> lock(prefetch_mutex);
+		discarded.swap(prefetches);
+	}
+	
+	for (auto& entry: discarded)
+	{
+		jobs->wait(entry.second->counter);
+	}
+}
+
+bool resource_manager::read_resource_file(const std::string& name, std::vector<std::uint8_t>& buffer, const std::uint8_t*& data, std::size_t& size, std::string& error)
+{
+	// Use prefetched file contents
+	if (take_prefetch(name, buffer))
+	{
+		data = buffer.data();
+		size = buffer.size();
+		return true;
+	}
+	
+	// Reuse one path buffer for all probes
+	std::string path;
+	for (const std::string& search_path: search_paths)
+	{
+		path.assign(search_path).append(name);
+		
+		// Look up file in mounted pack files, which are loaded in place
+		for (const pack_file* pack: packs)
+		{
+			if (pack->find(path, data, size))
+			{
+				return true;
+			}
+		}
+		
+		// Check if file exists
+		if (!PHYSFS_exists(path.c_str()))
+		{
+			continue;
+		}
+		
+		// File found, read it into a buffer
+		if (!read_file(path, buffer, error))
+		{
+			return false;
+		}
+		
+		data = buffer.data();
+		size = buffer.size();
+		return true;
+	}
+	
+	error = "File not found";
+	return false;
+}
+
+bool resource_manager::read_file(const std::string& path, std::vector<std::uint8_t>& buffer, std::string& error)
+{
+	// Open file for reading
+	PHYSFS_File* file = PHYSFS_openRead(path.c_str());
+	if (!file)
+	{
+		error = std::string("PhysicsFS error: ") + PHYSFS_getErrorByCode(PHYSFS_getLastErrorCode());
+		return false;
+	}
+	
+	// Read file into buffer
+	const PHYSFS_sint64 size = PHYSFS_fileLength(file);
+	buffer.resize((size > 0) ? static_cast<std::size_t>(size) : 0);
+	bool status = (size >= 0 && PHYSFS_readBytes(file, buffer.data(), buffer.size()) == size);
+	if (!status)
+	{
+		error = std::string("PhysicsFS error: ") + PHYSFS_getErrorByCode(PHYSFS_getLastErrorCode());
+	}
+	
+	// Close file
+	if (!PHYSFS_close(file) && status)
+	{
+		error = std::string("PhysicsFS error: ") + PHYSFS_getErrorByCode(PHYSFS_getLastErrorCode());
+		status = false;
+	}
+	
+	return status;
+}
+
+void resource_manager::set_job_system(job_system* jobs)
+{
+	this->jobs = jobs;
+}
+
+std::string resource_manager::get_type_name(const std::type_info& type)
+{
+	std::string name = type.name();
+	
+	// Demangle type name
+	#if defined(__GNUG__)
+		int status = 0;
+		if (char* demangled = abi::__cxa_demangle(name.c_str(), nullptr, nullptr, &status))
+		{
+			if (status == 0)
+				name = demangled;
+			std::free(demangled);
+		}
+	#endif
+	
+	// Shorten standard strings
+	const std::string string_name = "std::__cxx11::basic_string<char, std::char_traits<char>, std::allocator<char> >";
+	for (std::size_t i = name.find(string_name); i != std::string::npos; i = name.find(string_name, i))
+		name.replace(i, string_name.size(), "std::string");
+	
+	// Omit default allocator arguments
+	const std::string allocator_name = ", std::allocator<";
+	for (std::size_t i = name.find(allocator_name); i != std::string::npos; i = name.find(allocator_name, i))
+	{
+		std::size_t end = i + allocator_name.size();
+		for (int depth = 1; end < name.size() && depth; ++end)
+		{
+			if (name[end] == '<')
+				++depth;
+			else if (name[end] == '>')
+				--depth;
+		}
+		name.erase(i, end - i);
+	}
+	for (std::size_t i = name.find(" >"); i != std::string::npos; i = name.find(" >", i))
+		name.erase(i, 1);
+	
+	return name;
+}
+
+std::map<std::string, resource_usage> resource_manager::get_usage_by_type() const
+{
+	std::map<std::string, resource_usage> usage_by_type;
+	for (const auto& entry: resource_cache)
+	{
+		const resource_handle_base* resource = entry.second;
+		
+		resource_usage& type_usage = usage_by_type[get_type_name(*resource->type)];
+		++type_usage.count;
+		type_usage.cpu_size += resource->cpu_size;
+		type_usage.gpu_size += resource->gpu_size;
+	}
+	
+	return usage_by_type;
+}
+
+void resource_manager::set_shader_cache(::shader_cache* cache)
+{
+	shader_cache = cache;
+}
+
+void resource_manager::set_texture_streamer(::texture_streamer* streamer)
+{
+	texture_streamer = streamer;
+}
+
+void resource_manager::update(double budget)
+{
+	debug::allocation_scope allocation_scope(debug::allocation_tag::resources);
+	const auto start = std::chrono::steady_clock::now();
+	
+	for (auto it = request_queue.begin(); it != request_queue.end();)
+	{
+		std::shared_ptr<resource_request_base> request = *it;
+		
+		// Skip requests which are still being loaded by worker threads
+		if (!request->finalized && request->concurrent && !request->counter.is_done())
+		{
+			++it;
+			continue;
+		}
+		
+		it = request_queue.erase(it);
+		
+		// Requests may have already been finalized by synchronous loads
+		if (!request->finalized)
+		{
+			finalize_request(request);
+			
+			if (std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() >= budget)
+			{
+				break;
+			}
+		}
+	}
+}
+
+void resource_manager::finalize_request(std::shared_ptr<resource_request_base> request)
+{
+	if (request->concurrent)
+	{
+		jobs->wait(request->counter);
+	}
+	
+	pending_requests.erase(fnv1a64(request->name));
+	request->finalize(*this);
+	request->finalized = true;
+}
+
+void resource_manager::update_usage_gauges() const
+{
+	static debug::gauge cpu_bytes("resources.cpu_bytes");
+	static debug::gauge gpu_bytes("resources.gpu_bytes");
+	cpu_bytes.set(static_cast<std::int64_t>(usage.cpu_size));
+	gpu_bytes.set(static_cast<std::int64_t>(usage.gpu_size));
+}
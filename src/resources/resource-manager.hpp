@@ -22,17 +22,57 @@
 
 #include "resource-handle.hpp"
 #include "resource-loader.hpp"
+#include "resource-request.hpp"
+#include "resource-ptr.hpp"
+#include "resources/pack-file.hpp"
+#include "debug/allocation-tracker.hpp"
 #include "debug/logger.hpp"
+#include "debug/startup-profiler.hpp"
+#include "utility/fnv1a.hpp"
+#include "utility/job-system.hpp"
+#include <chrono>
 #include <fstream>
 #include <list>
 #include <map>
+#include <memory>
+#include <mutex>
+#include <set>
 #include <stdexcept>
 #include <string>
+#include <typeinfo>
+#include <unordered_map>
+#include <vector>
 #include <entt/entt.hpp>
 #include <physfs.h>
 
+class shader_cache;
+class texture_streamer;
+
+/**
+ * Memory occupied by a set of cached resources.
+ */
+struct resource_usage
+{
+	/// Number of resources.
+	std::size_t count{0};
+	
+	/// Bytes of CPU memory occupied by the resources.
+	std::size_t cpu_size{0};
+	
+	/// Bytes of GPU memory occupied by the resources.
+	std::size_t gpu_size{0};
+};
+
 /**
  * Loads resources.
+ *
+ * Resources are searched for in the search paths, first in mounted pack files, which are memory-mapped and loaded without copying, then by PhysicsFS.
+ *
+ * Cached resources are keyed by the FNV-1a hash of their names, and the memory they occupy is estimated by resource_footprint when they are loaded.
+ *
+ * Resources can be loaded synchronously, or requested asynchronously. If a job system has been set, resources whose loaders are marked as concurrent by resource_loader_traits are read and parsed by worker threads, while all other requested resources are loaded by update() on the main thread, within a time budget per call. Search paths must not be changed while asynchronous requests are pending.
+ *
+ * Resources loaded by the loader of another resource are recorded as its dependencies. Once the dependencies of a resource are known, from an earlier load or from a dependency manifest, loading the resource prefetches the files of all of its uncached dependencies in parallel on the job system, so that its loader finds them in memory.
  */
 class resource_manager
 {
@@ -47,6 +87,12 @@ public:
 	 */
 	~resource_manager();
 	
+	/**
+	 * Mounts a directory or archive. Pack files are memory-mapped, while all other paths are mounted by PhysicsFS.
+	 *
+	 * @param path Path to mount, in the native file system.
+	 * @return `true` if the path was mounted, `false` otherwise.
+	 */
 	bool mount(const std::string& path);
 
 	/**
@@ -55,7 +101,44 @@ public:
 	 * @param path Search path.
 	 */
 	void include(const std::string& path);
+	
+	/**
+	 * Sets the job system on which resources are loaded asynchronously.
+	 *
+	 * @param jobs Job system, or `nullptr` to load all requested resources on the main thread.
+	 */
+	void set_job_system(job_system* jobs);
+	
+	/// Returns the job system on which resources are loaded asynchronously, or `nullptr` if none has been set.
+	job_system* get_job_system() const;
+	
+	/**
+	 * Sets the cache of shader program binaries used by the shader program loader.
+	 *
+	 * @param cache Shader cache, or `nullptr` to compile and link every shader program.
+	 */
+	void set_shader_cache(::shader_cache* cache);
+	
+	/// Returns the cache of shader program binaries, or `nullptr` if none has been set.
+	::shader_cache* get_shader_cache() const;
+	
+	/**
+	 * Sets the texture streamer with which the texture loader creates textures from compressed images with mip chains.
+	 *
+	 * @param streamer Texture streamer, or `nullptr` to upload every level of every texture.
+	 */
+	void set_texture_streamer(::texture_streamer* streamer);
+	
+	/// Returns the texture streamer, or `nullptr` if none has been set.
+	::texture_streamer* get_texture_streamer() const;
 
+	/**
+	 * Returns `true` if a resource file exists in any of the search paths.
+	 *
+	 * @param name Path to the resource, relative to the search paths.
+	 */
+	bool exists(const std::string& name) const;
+	
 	/**
 	 * Loads the requested resource. If the resource has already been loaded it will be retrieved from the resource cache and its reference count incremented.
 	 *
@@ -65,6 +148,55 @@ public:
 	 */
 	template <typename T>
 	T* load(const std::string& name);
+	
+	/**
+	 * Loads the requested resource and returns a resource pointer which unloads it once destroyed.
+	 *
+	 * @tparam T Resource type.
+	 * @param path Path to the resource, relative to the search paths.
+	 * @return Resource pointer, which is empty if the resource could not be found nor loaded.
+	 */
+	template <typename T>
+	resource_ptr<T> acquire(const std::string& name);
+	
+	/**
+	 * Requests a resource to be loaded asynchronously. Each request increments the resource's reference count once the resource has been loaded. If the resource is loaded synchronously before the request has completed, the synchronous load waits for the request.
+	 *
+	 * @tparam T Resource type.
+	 * @param path Path to the resource, relative to the search paths.
+	 * @return Handle to the requested resource, which becomes ready once the resource has been added to the resource cache by update().
+	 */
+	template <typename T>
+	resource_future<T> load_async(const std::string& name);
+	
+	/**
+	 * Completes asynchronous requests in the order in which they were made. Must be called by the main thread, typically once per frame.
+	 *
+	 * @param budget Time budget, in seconds. Once exceeded, the remaining requests are deferred to the next call.
+	 */
+	void update(double budget);
+	
+	/// Returns the number of asynchronous requests which have not yet completed.
+	std::size_t get_pending_request_count() const;
+	
+	/**
+	 * Reads a dependency manifest written by write_dependency_manifest(), replacing the recorded dependencies of the resources it lists.
+	 *
+	 * @param path Path to the manifest, in the native file system.
+	 * @return `true` if the manifest was read, `false` otherwise.
+	 */
+	bool read_dependency_manifest(const std::string& path);
+	
+	/**
+	 * Writes the recorded dependencies of resources to a dependency manifest, a CSV file with one row per resource, listing the resource followed by its dependencies.
+	 *
+	 * @param path Path to the manifest, in the native file system.
+	 * @return `true` if the manifest was written, `false` otherwise.
+	 */
+	bool write_dependency_manifest(const std::string& path) const;
+	
+	/// Returns the recorded dependencies of resources, by resource name.
+	const std::map<std::string, std::set<std::string>>& get_dependencies() const;
 
 	/**
 	 * Decrements a resource's reference count and unloads the resource if it's unreferenced.
@@ -84,31 +216,162 @@ public:
 	void save(const T* resource, const std::string& path);
 
 	entt::registry& get_archetype_registry();
+	
+	/// Returns the memory occupied by all cached resources.
+	const resource_usage& get_usage() const;
+	
+	/// Returns the memory occupied by cached resources, by resource type name.
+	std::map<std::string, resource_usage> get_usage_by_type() const;
 
 private:
-	std::map<std::string, resource_handle_base*> resource_cache;
+	template <typename T>
+	friend class resource_request;
+	
+	template <typename T>
+	friend class resource_ptr;
+	
+	/**
+	 * Finds a cached resource.
+	 *
+	 * @return Resource handle, or `nullptr` if the resource is not cached. Throws if another resource with the same key, or the same resource with another type, is cached.
+	 */
+	template <typename T>
+	resource_handle<T>* find(const std::string& name, std::uint64_t key) const;
+	
+	/// Adds loaded resource data to the resource cache.
+	template <typename T>
+	resource_handle<T>* insert(const std::string& name, std::uint64_t key, T* data, std::size_t reference_count);
+	
+	/// Decrements the reference count of a cached resource, and unloads the resource if it's unreferenced.
+	void release(std::uint64_t key);
+	
+	/// Returns the readable name of a resource type.
+	static std::string get_type_name(const std::type_info& type);
+	
+	/**
+	 * Searches for and loads a resource, without accessing the resource cache. Safe to call from worker threads for resource types which are marked as concurrent.
+	 *
+	 * @param[out] error Description of the error which prevented the resource from loading.
+	 * @return Pointer to the loaded resource, or `nullptr` if the resource could not be found nor loaded.
+	 */
+	template <typename T>
+	T* read(const std::string& name, std::string& error);
+	
+	/**
+	 * Finds the file of a resource in the prefetched files, then in the search paths, and reads it if it is not in a pack file. Safe to call from worker threads.
+	 *
+	 * @param[out] buffer Buffer into which the file is read, unless it is in a pack file.
+	 * @param[out] data Contents of the file.
+	 * @param[out] size Size of the file, in bytes.
+	 * @param[out] error Description of the error which prevented the file from being read.
+	 * @return `true` if the file was found and read, `false` otherwise.
+	 */
+	bool read_resource_file(const std::string& name, std::vector<std::uint8_t>& buffer, const std::uint8_t*& data, std::size_t& size, std::string& error);
+	
+	/// Loads a resource from the contents of its file, catching loader exceptions.
+	template <typename T>
+	T* parse(const std::uint8_t* data, std::size_t size, std::string& error);
+	
+	/**
+	 * Reads a PhysicsFS file into a buffer.
+	 *
+	 * @return `true` if the file was read, `false` otherwise.
+	 */
+	static bool read_file(const std::string& path, std::vector<std::uint8_t>& buffer, std::string& error);
+	
+	/// Adds the resource of a completed request to the resource cache, or loads it if it must be loaded by the main thread.
+	template <typename T>
+	void finalize(resource_request<T>& request);
+	
+	/// Waits for the worker thread stage of a pending request, if any, then finalizes it.
+	void finalize_request(std::shared_ptr<resource_request_base> request);
+	
+	/// Contents of a resource file, read ahead of its load by a worker thread.
+	struct prefetch
+	{
+		std::string name;
+		job_system::counter counter;
+		std::vector<std::uint8_t> buffer;
+		
+		/// `true` if the file was read by PhysicsFS, `false` if it was not found or is in a pack file.
+		bool found{false};
+	};
+	
+	/// Prefetches the files of the recorded dependencies of a resource which are not cached, and recursively of their dependencies.
+	void prefetch_dependencies(const std::string& name);
+	
+	/**
+	 * Takes the prefetched contents of a resource file, waiting for the prefetch to complete. Safe to call from worker threads.
+	 *
+	 * @return `true` if the file was prefetched, `false` otherwise.
+	 */
+	bool take_prefetch(const std::string& name, std::vector<std::uint8_t>& buffer);
+	
+	/// Waits for all prefetches to complete and discards their contents.
+	void discard_prefetches();
+	
+	/// Publishes the memory occupied by cached resources to the `resources.cpu_bytes` and `resources.gpu_bytes` gauges.
+	void update_usage_gauges() const;
+	
+	std::unordered_map<std::uint64_t, resource_handle_base*> resource_cache;
+	resource_usage usage;
 	std::list<std::string> search_paths;
+	std::vector<pack_file*> packs;
 	entt::registry archetype_registry;
 	debug::logger* logger;
+	job_system* jobs;
+	::shader_cache* shader_cache;
+	::texture_streamer* texture_streamer;
+	
+	/// Pending asynchronous requests, keyed by the hash of their resource names.
+	std::unordered_map<std::uint64_t, std::shared_ptr<resource_request_base>> pending_requests;
+	
+	/// Pending asynchronous requests, in the order in which they were made.
+	std::list<std::shared_ptr<resource_request_base>> request_queue;
+	
+	/// Names of the resources being loaded synchronously, innermost last.
+	std::vector<std::string> load_stack;
+	
+	/// Recorded dependencies of resources, by resource name.
+	std::map<std::string, std::set<std::string>> dependencies;
+	
+	/// Prefetched resource files, keyed by the hash of their resource names.
+	std::unordered_map<std::uint64_t, std::unique_ptr<prefetch>> prefetches;
+	std::mutex prefetch_mutex;
 };
 
 template <typename T>
 T* resource_manager::load(const std::string& name)
 {
+	debug::allocation_scope allocation_scope(debug::allocation_tag::resources);
+	const std::uint64_t key = fnv1a64(name);
+	
+	// Record the resource as a dependency of the resource whose loader requested it
+	if (!load_stack.empty())
+	{
+		dependencies[load_stack.back()].insert(name);
+	}
+	
+	// Wait for any pending asynchronous request of the resource
+	if (auto pending = pending_requests.find(key); pending != pending_requests.end())
+	{
+		finalize_request(pending->second);
+	}
+	
 	// Check if resource is in the cache
-	auto it = resource_cache.find(name);
-	if (it != resource_cache.end())
+	resource_handle<T>* resource;
+	try
+	{
+		resource = find<T>(name, key);
+	}
+	catch (const std::exception& e)
+	{
+		logger->error(e.what());
+		return nullptr;
+	}
+	
+	if (resource)
 	{
-		/*
-		if (logger)
-		{
-			logger->log("Fetched resource \"" + name + "\"");
-		}
-		*/
-		
-		// Resource found
-		resource_handle<T>* resource = static_cast<resource_handle<T>*>(it->second);
-
 		// Increment resource handle reference count
 		++resource->reference_count;
 
@@ -121,74 +384,235 @@ T* resource_manager::load(const std::string& name)
 		logger->push_task("Loading resource \"" + name + "\"");
 	}
 
-	// Resource not cached, look for file in search paths
-	T* data = nullptr;
-	bool found = false;
-	for (const std::string& search_path: search_paths)
+	// Read the files of the known dependencies of the resource ahead of its loader
+	if (load_stack.empty())
 	{
-		std::string path = search_path + name;
-		
-		// Check if file exists
-		if (!PHYSFS_exists(path.c_str()))
-		{
-			continue;
-		}
-		
-		// File found
-		found = true;
-		
-		// Open file for reading
-		PHYSFS_File* file = PHYSFS_openRead(path.c_str());
-		if (!file)
-		{
-			logger->error(std::string("PhysicsFS error: ") + PHYSFS_getErrorByCode(PHYSFS_getLastErrorCode()));
-			break;
-		}
+		prefetch_dependencies(name);
+	}
+	
+	// Resource not cached, look for file in search paths, recording the dependencies loaded by its loader
+	dependencies.erase(name);
+	load_stack.push_back(name);
+	std::string error;
+	T* data = read<T>(name, error);
+	load_stack.pop_back();
+	
+	// Discard files which were prefetched for dependencies which are no longer loaded
+	if (load_stack.empty())
+	{
+		discard_prefetches();
+	}
+	
+	if (!data)
+	{
+		logger->error(error);
+		logger->pop_task(EXIT_FAILURE);
+		return nullptr;
+	}
 
-		// Load opened file
-		try
-		{
-			data = resource_loader<T>::load(this, file);
-		}
-		catch (const std::exception& e)
-		{
-			logger->error("Failed to load resource: \"" + std::string(e.what()) + "\"");
-		}
-		
-		// Close opened file
-		if (!PHYSFS_close(file))
-		{
-			logger->error(std::string("PhysicsFS error: ") + PHYSFS_getErrorByCode(PHYSFS_getLastErrorCode()));
-		}
+	// Add resource to the cache
+	resource = insert<T>(name, key, data, 1);
+	
+	if (logger)
+	{
+		logger->pop_task(EXIT_SUCCESS);
+	}
+
+	return resource->data;
+}
+
+template <typename T>
+resource_ptr<T> resource_manager::acquire(const std::string& name)
+{
+	T* data = load<T>(name);
+	return (data) ? resource_ptr<T>(this, fnv1a64(name), data) : resource_ptr<T>();
+}
+
+template <typename T>
+resource_future<T> resource_manager::load_async(const std::string& name)
+{
+	resource_future<T> future;
+	const std::uint64_t key = fnv1a64(name);
+	
+	// Check if resource is in the cache
+	resource_handle<T>* resource = nullptr;
+	try
+	{
+		resource = find<T>(name, key);
+	}
+	catch (const std::exception& e)
+	{
+		// Return a failed request
+		logger->error(e.what());
+		future.request = std::make_shared<resource_request<T>>();
+		future.request->name = name;
+		future.request->error = e.what();
+		future.request->finalized = true;
+		return future;
+	}
+	
+	if (resource)
+	{
+		++resource->reference_count;
 		
-		break;
+		// Return a completed request
+		future.request = std::make_shared<resource_request<T>>();
+		future.request->name = name;
+		future.request->data = resource->data;
+		future.request->finalized = true;
+		return future;
 	}
 	
-	if (!data)
+	// Check if resource has already been requested
+	if (auto it = pending_requests.find(key); it != pending_requests.end())
+	{
+		future.request = std::static_pointer_cast<resource_request<T>>(it->second);
+		++future.request->reference_count;
+		return future;
+	}
+	
+	std::shared_ptr<resource_request<T>> request = std::make_shared<resource_request<T>>();
+	request->name = name;
+	pending_requests[key] = request;
+	request_queue.push_back(request);
+	
+	// Read and parse the resource on a worker thread, if its loader allows it
+	if (jobs && resource_loader_traits<T>::concurrent)
+	{
+		request->concurrent = true;
+		resource_request<T>* pending = request.get();
+		jobs->submit
+		(
+			[this, pending]()
+			{
+				pending->data = read<T>(pending->name, pending->error);
+			},
+			&request->counter
+		);
+	}
+	
+	future.request = request;
+	return future;
+}
+
+template <typename T>
+T* resource_manager::read(const std::string& name, std::string& error)
+{
+	const auto start = std::chrono::steady_clock::now();
+	
+	std::vector<std::uint8_t> buffer;
+	const std::uint8_t* data;
+	std::size_t size;
+	if (!read_resource_file(name, buffer, data, size, error))
+	{
+		return nullptr;
+	}
+	
+	T* resource = parse<T>(data, size, error);
+	
+	// Time the resource, including the loads of its dependencies, for the startup report
+	if (resource && debug::startup_profiler::is_recording())
+	{
+		const double duration = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		debug::startup_profiler::record_resource(name, get_type_name(typeid(T)), duration, size);
+	}
+	
+	return resource;
+}
+
+template <typename T>
+T* resource_manager::parse(const std::uint8_t* data, std::size_t size, std::string& error)
+{
+	try
+	{
+		return resource_loader<T>::load(this, data, size);
+	}
+	catch (const std::exception& e)
+	{
+		error = "Failed to load resource: \"" + std::string(e.what()) + "\"";
+	}
+	
+	return nullptr;
+}
+
+template <typename T>
+void resource_manager::finalize(resource_request<T>& request)
+{
+	// Load resources which must be loaded by the main thread, adding a reference per request
+	if (!request.concurrent)
 	{
-		if (!found)
+		request.data = load<T>(request.name);
+		if (request.data)
 		{
-			logger->error("File not found");
+			resource_cache[fnv1a64(request.name)]->reference_count += request.reference_count - 1;
 		}
+		return;
+	}
+	
+	if (logger)
+	{
+		logger->push_task("Loading resource \"" + request.name + "\"");
+	}
 	
+	if (!request.data)
+	{
+		logger->error(request.error);
 		logger->pop_task(EXIT_FAILURE);
-		return nullptr;
+		return;
 	}
-
-	// Create a resource handle for the resource data
-	resource_handle<T>* resource = new resource_handle<T>();
-	resource->data = data;
-	resource->reference_count = 1;
 	
 	// Add resource to the cache
-	resource_cache[name] = resource;
+	insert<T>(request.name, fnv1a64(request.name), request.data, request.reference_count);
 	
 	if (logger)
 	{
 		logger->pop_task(EXIT_SUCCESS);
 	}
+}
 
-	return resource->data;
+template <typename T>
+resource_handle<T>* resource_manager::find(const std::string& name, std::uint64_t key) const
+{
+	auto it = resource_cache.find(key);
+	if (it == resource_cache.end())
+	{
+		return nullptr;
+	}
+	
+	// Names are only compared on hits, to detect hash collisions
+	if (it->second->name != name)
+	{
+		throw std::runtime_error("Resource \"" + name + "\" has the same key as resource \"" + it->second->name + "\"");
+	}
+	if (*it->second->type != typeid(T))
+	{
+		throw std::runtime_error("Resource \"" + name + "\" has already been loaded as another type");
+	}
+	
+	return static_cast<resource_handle<T>*>(it->second);
+}
+
+template <typename T>
+resource_handle<T>* resource_manager::insert(const std::string& name, std::uint64_t key, T* data, std::size_t reference_count)
+{
+	// Create a resource handle for the resource data
+	resource_handle<T>* resource = new resource_handle<T>();
+	resource->data = data;
+	resource->reference_count = reference_count;
+	resource->name = name;
+	resource->type = &typeid(T);
+	resource->cpu_size = resource_footprint<T>::cpu_size(*data);
+	resource->gpu_size = resource_footprint<T>::gpu_size(*data);
+	
+	// Account for the memory occupied by the resource
+	++usage.count;
+	usage.cpu_size += resource->cpu_size;
+	usage.gpu_size += resource->gpu_size;
+	update_usage_gauges();
+	
+	resource_cache[key] = resource;
+	
+	return resource;
 }
 
 template <typename T>
@@ -224,7 +648,12 @@ void resource_manager::save(const T* resource, const std::string& path)
 		status = EXIT_FAILURE;
 	}
 	
-	logger->pop_task(status)
+	logger->pop_task(status);
+}
+
+inline const std::map<std::string, std::set<std::string>>& resource_manager::get_dependencies() const
+{
+	return dependencies;
 }
 
 inline entt::registry& resource_manager::get_archetype_registry()
@@ -232,5 +661,46 @@ inline entt::registry& resource_manager::get_archetype_registry()
 	return archetype_registry;
 }
 
+inline const resource_usage& resource_manager::get_usage() const
+{
+	return usage;
+}
+
+inline shader_cache* resource_manager::get_shader_cache() const
+{
+	return shader_cache;
+}
+
+inline job_system* resource_manager::get_job_system() const
+{
+	return jobs;
+}
+
+inline texture_streamer* resource_manager::get_texture_streamer() const
+{
+	return texture_streamer;
+}
+
+inline std::size_t resource_manager::get_pending_request_count() const
+{
+	return pending_requests.size();
+}
+
+template <typename T>
+void resource_request<T>::finalize(resource_manager& resource_manager)
+{
+	resource_manager.finalize(*this);
+}
+
+template <typename T>
+void resource_ptr<T>::reset()
+{
+	if (data)
+	{
+		manager->release(key);
+		data = nullptr;
+	}
+}
+
 #endif // ANTKEEPER_RESOURCE_MANAGER_HPP
 
@@ -0,0 +1,142 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ANTKEEPER_RESOURCE_PTR_HPP
+#define ANTKEEPER_RESOURCE_PTR_HPP
+
+#include <cstdint>
+
+class resource_manager;
+
+/**
+ * Owning reference to a resource of a resource manager, which releases its reference when destroyed.
+ *
+ * @tparam T Resource type.
+ *
+ * @see resource_manager::acquire()
+ */
+template <typename T>
+class resource_ptr
+{
+public:
+	/// Creates an empty resource pointer.
+	resource_ptr();
+	
+	/// Takes the reference of another resource pointer.
+	resource_ptr(resource_ptr&& other);
+	
+	/// Releases the referenced resource.
+	~resource_ptr();
+	
+	/// Releases the referenced resource, then takes the reference of another resource pointer.
+	resource_ptr& operator=(resource_ptr&& other);
+	
+	resource_ptr(const resource_ptr&) = delete;
+	resource_ptr& operator=(const resource_ptr&) = delete;
+	
+	/// Releases the referenced resource, unloading it if it's no longer referenced.
+	void reset();
+	
+	/// Returns a pointer to the resource data, or `nullptr` if the resource pointer is empty.
+	T* get() const;
+	
+	T* operator->() const;
+	T& operator*() const;
+	
+	/// Returns `true` if the resource pointer references a resource.
+	explicit operator bool() const;
+
+private:
+	friend class resource_manager;
+	
+	resource_ptr(resource_manager* manager, std::uint64_t key, T* data);
+	
+	resource_manager* manager;
+	std::uint64_t key;
+	T* data;
+};
+
+template <typename T>
+resource_ptr<T>::resource_ptr():
+	manager(nullptr),
+	key(0),
+	data(nullptr)
+{}
+
+template <typename T>
+resource_ptr<T>::resource_ptr(resource_manager* manager, std::uint64_t key, T* data):
+	manager(manager),
+	key(key),
+	data(data)
+{}
+
+template <typename T>
+resource_ptr<T>::resource_ptr(resource_ptr&& other):
+	manager(other.manager),
+	key(other.key),
+	data(other.data)
+{
+	other.data = nullptr;
+}
+
+template <typename T>
+resource_ptr<T>::~resource_ptr()
+{
+	reset();
+}
+
+template <typename T>
+resource_ptr<T>& resource_ptr<T>::operator=(resource_ptr&& other)
+{
+	if (this != &other)
+	{
+		reset();
+		manager = other.manager;
+		key = other.key;
+		data = other.data;
+		other.data = nullptr;
+	}
+	return *this;
+}
+
+template <typename T>
+inline T* resource_ptr<T>::get() const
+{
+	return data;
+}
+
+template <typename T>
+inline T* resource_ptr<T>::operator->() const
+{
+	return data;
+}
+
+template <typename T>
+inline T& resource_ptr<T>::operator*() const
+{
+	return *data;
+}
+
+template <typename T>
+inline resource_ptr<T>::operator bool() const
+{
+	return data != nullptr;
+}
+
+#endif // ANTKEEPER_RESOURCE_PTR_HPP
@@ -0,0 +1,120 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ANTKEEPER_RESOURCE_REQUEST_HPP
+#define ANTKEEPER_RESOURCE_REQUEST_HPP
+
+#include "utility/job-system.hpp"
+#include <cstdlib>
+#include <memory>
+#include <string>
+
+class resource_manager;
+
+/**
+ * Base class for asynchronous resource requests.
+ */
+class resource_request_base
+{
+public:
+	/// Destroys a resource request.
+	virtual ~resource_request_base() = default;
+	
+	/// Adds the loaded resource to the cache of a resource manager, or loads it if it can only be loaded by the main thread.
+	virtual void finalize(resource_manager& resource_manager) = 0;
+	
+	/// Name of the requested resource.
+	std::string name;
+	
+	/// Number of times the resource has been requested.
+	std::size_t reference_count{1};
+	
+	/// `true` if the resource is being loaded by a worker thread.
+	bool concurrent{false};
+	
+	/// `true` once the resource has been added to the cache or has failed to load.
+	bool finalized{false};
+	
+	/// Description of the error which prevented the resource from loading.
+	std::string error;
+	
+	/// Tracks the completion of the worker thread's loading job.
+	job_system::counter counter;
+};
+
+/**
+ * Templated asynchronous resource request.
+ *
+ * @tparam T Resource type.
+ */
+template <typename T>
+class resource_request: public resource_request_base
+{
+public:
+	/// Destroys a resource request and deletes its data if it was never added to the cache.
+	virtual ~resource_request();
+	
+	virtual void finalize(resource_manager& resource_manager);
+	
+	/// Pointer to resource data
+	T* data{nullptr};
+};
+
+/**
+ * Handle to a resource which is loading asynchronously.
+ *
+ * @tparam T Resource type.
+ */
+template <typename T>
+class resource_future
+{
+public:
+	/// Returns `true` if the resource has finished loading, successfully or not.
+	bool is_ready() const;
+	
+	/// Returns a pointer to the resource, or `nullptr` if it has not finished loading or failed to load.
+	T* get() const;
+
+private:
+	friend class resource_manager;
+	
+	std::shared_ptr<resource_request<T>> request;
+};
+
+template <typename T>
+resource_request<T>::~resource_request()
+{
+	if (!finalized)
+		delete data;
+}
+
+template <typename T>
+inline bool resource_future<T>::is_ready() const
+{
+	return request && request->finalized;
+}
+
+template <typename T>
+inline T* resource_future<T>::get() const
+{
+	return (is_ready()) ? request->data : nullptr;
+}
+
+#endif // ANTKEEPER_RESOURCE_REQUEST_HPP
+
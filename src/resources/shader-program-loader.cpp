@@ -76,10 +76,10 @@ static void handle_includes(text_file* source, resource_manager* resource_manage
 }
 
 template <>
-gl::shader_program* resource_loader<gl::shader_program>::load(resource_manager* resource_manager, PHYSFS_File* file)
+gl::shader_program* resource_loader<gl::shader_program>::load(resource_manager* resource_manager, const std::uint8_t* data, std::size_t size)
 {
 	// Load shader template source
-	text_file source_lines = *resource_loader<text_file>::load(resource_manager, file);
+	text_file source_lines = *resource_loader<text_file>::load(resource_manager, data, size);
 	
 	// Handle `#pragma include` directives
 	handle_includes(&source_lines, resource_manager);
@@ -92,7 +92,7 @@ gl::shader_program* resource_loader<gl::shader_program>::load(resource_manager*
 	shader_template* shader = new shader_template(stream.str());
 	
 	// Build shader program
-	gl::shader_program* program = shader->build(shader_template::dictionary_type());
+	gl::shader_program* program = shader->build(shader_template::dictionary_type(), resource_manager->get_shader_cache());
 	
 	// Check if shader program was linked successfully
 	if (!program->was_linked())
@@ -100,6 +100,22 @@ gl::shader_program* resource_loader<gl::shader_program>::load(resource_manager*
 		throw std::runtime_error("Shader program linking failed: " + program->get_info_log());
 	}
 	
+	// Build the weighted blended order-independent transparency variant of templates which support it
+	if (shader->has_define_directive("WEIGHTED_BLENDED_OIT"))
+	{
+		gl::shader_program* variant = shader->build({{"WEIGHTED_BLENDED_OIT", std::string()}}, resource_manager->get_shader_cache());
+		if (!variant->was_linked())
+		{
+			const std::string info_log = variant->get_info_log();
+			delete variant;
+			delete program;
+			delete shader;
+			throw std::runtime_error("Shader program linking failed: " + info_log);
+		}
+		
+		program->set_variant("WEIGHTED_BLENDED_OIT"_fnv1a64, variant);
+	}
+	
 	// Destroy shader template
 	delete shader;
 
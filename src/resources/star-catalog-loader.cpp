@@ -0,0 +1,44 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "resources/resource-loader.hpp"
+#include "resources/star-catalog.hpp"
+
+template <>
+star_catalog* resource_loader<star_catalog>::load(resource_manager* resource_manager, const std::uint8_t* data, std::size_t size)
+{
+	star_catalog* catalog = new star_catalog();
+	
+	try
+	{
+		if (is_binary_star_catalog(data, size))
+			read_binary_star_catalog(data, size, *catalog);
+		else
+			read_csv_star_catalog(data, size, *catalog);
+		
+		tile_star_catalog(*catalog, star_catalog::tile_resolution);
+	}
+	catch (...)
+	{
+		delete catalog;
+		throw;
+	}
+	
+	return catalog;
+}
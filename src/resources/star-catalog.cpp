@@ -0,0 +1,350 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "resources/star-catalog.hpp"
+#include "color/batch.hpp"
+#include "geom/spherical.hpp"
+#include "math/angles.hpp"
+#include "physics/orbit/orbit.hpp"
+#include "math/math.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+/// Identifies binary star catalogs.
+constexpr std::uint8_t binary_star_catalog_magic[4] = {'A', 'K', 'S', 'C'};
+
+/// Version of the binary star catalog format.
+constexpr std::uint32_t binary_star_catalog_version = 1;
+
+/// Size of the header, in bytes.
+constexpr std::size_t header_size = 16;
+
+std::uint32_t read_u32(const std::uint8_t* data)
+{
+	return static_cast<std::uint32_t>(data[0]) |
+		(static_cast<std::uint32_t>(data[1]) << 8) |
+		(static_cast<std::uint32_t>(data[2]) << 16) |
+		(static_cast<std::uint32_t>(data[3]) << 24);
+}
+
+void write_u32(std::uint8_t* data, std::uint32_t value)
+{
+	data[0] = static_cast<std::uint8_t>(value);
+	data[1] = static_cast<std::uint8_t>(value >> 8);
+	data[2] = static_cast<std::uint8_t>(value >> 16);
+	data[3] = static_cast<std::uint8_t>(value >> 24);
+}
+
+/**
+ * Splits a CSV row into the offsets of its fields, ignoring delimiters within quotes.
+ *
+ * @param line CSV row.
+ * @param[out] fields Offsets of the first character of each field.
+ * @param max_fields Maximum number of fields to split.
+ * @return Number of fields in the row.
+ */
+std::size_t split_fields(const std::string& line, std::size_t* fields, std::size_t max_fields)
+{
+	std::size_t count = 0;
+	fields[count++] = 0;
+	
+	bool quoted = false;
+	for (std::size_t i = 0; i < line.size() && count < max_fields; ++i)
+	{
+		if (line[i] == '"')
+			quoted = !quoted;
+		else if (line[i] == ',' && !quoted)
+			fields[count++] = i + 1;
+	}
+	
+	return count;
+}
+
+/// Returns the point of a face of the tile cube, given the coordinates of the point on the face on `[-1, 1]`.
+float3 get_cube_point(std::size_t face, float u, float v)
+{
+	const std::size_t axis = face / 2;
+	float3 point;
+	point[axis] = (face % 2) ? -1.0f : 1.0f;
+	point[(axis + 1) % 3] = u;
+	point[(axis + 2) % 3] = v;
+	return point;
+}
+
+/// Returns the index of the tile which contains a direction.
+std::size_t get_tile_index(const float* direction, std::size_t resolution)
+{
+	// Find the face of the dominant axis
+	std::size_t axis = 0;
+	for (std::size_t i = 1; i < 3; ++i)
+		if (std::abs(direction[i]) > std::abs(direction[axis]))
+			axis = i;
+	const float magnitude = std::abs(direction[axis]);
+	if (magnitude == 0.0f)
+		return 0;
+	const std::size_t face = axis * 2 + (direction[axis] < 0.0f);
+	
+	// Project onto the face
+	const float u = direction[(axis + 1) % 3] / magnitude;
+	const float v = direction[(axis + 2) % 3] / magnitude;
+	const std::size_t i = std::min(static_cast<std::size_t>(std::max(0.0f, (u + 1.0f) * 0.5f * static_cast<float>(resolution))), resolution - 1);
+	const std::size_t j = std::min(static_cast<std::size_t>(std::max(0.0f, (v + 1.0f) * 0.5f * static_cast<float>(resolution))), resolution - 1);
+	
+	return (face * resolution + j) * resolution + i;
+}
+
+/// Parses a number at the start of a CSV field, returning `false` if the field does not start with a number.
+bool parse_field(const char* field, double& value)
+{
+	if (*field == '"')
+		++field;
+	
+	char* end;
+	value = std::strtod(field, &end);
+	return end != field;
+}
+
+} // namespace
+
+bool is_binary_star_catalog(const std::uint8_t* data, std::size_t size)
+{
+	return size >= header_size && !std::memcmp(data, binary_star_catalog_magic, sizeof(binary_star_catalog_magic));
+}
+
+void read_binary_star_catalog(const std::uint8_t* data, std::size_t size, star_catalog& catalog)
+{
+	if (!is_binary_star_catalog(data, size))
+		throw std::runtime_error("Not a binary star catalog");
+	
+	const std::uint32_t version = read_u32(data + 4);
+	if (version != binary_star_catalog_version)
+		throw std::runtime_error("Unsupported binary star catalog version " + std::to_string(version));
+	
+	const std::size_t star_count = read_u32(data + 8);
+	const std::uint32_t vertex_size = read_u32(data + 12);
+	if (vertex_size != star_catalog::vertex_size)
+		throw std::runtime_error("Unsupported binary star catalog vertex size " + std::to_string(vertex_size));
+	
+	const std::size_t float_count = star_count * star_catalog::vertex_size;
+	if (size - header_size < float_count * 4)
+		throw std::runtime_error("Binary star catalog truncated");
+	
+	catalog.vertex_data.resize(float_count);
+	const std::uint8_t* vertex = data + header_size;
+	for (std::size_t i = 0; i < float_count; ++i, vertex += 4)
+	{
+		const std::uint32_t bits = read_u32(vertex);
+		std::memcpy(&catalog.vertex_data[i], &bits, sizeof(float));
+	}
+}
+
+void read_csv_star_catalog(const std::uint8_t* data, std::size_t size, star_catalog& catalog)
+{
+	// Transformation from equatorial space to inertial space, shared by all stars
+	const physics::frame<double> bci_to_inertial = physics::orbit::inertial::to_bci({0, 0, 0}, 0.0, math::radians(23.4393)).inverse();
+	
+	catalog.vertex_data.clear();
+	
+	// Color indices and illuminances of the parsed stars, converted to colors in a batch once all rows are parsed
+	std::vector<double> bv_colors;
+	std::vector<double> illuminances;
+	
+	std::string line;
+	std::size_t offset = 0;
+	
+	// Skip header row
+	resource_getline(data, size, offset, line);
+	
+	constexpr std::size_t max_fields = 5;
+	std::size_t fields[max_fields];
+	
+	while (resource_getline(data, size, offset, line))
+	{
+		// Reserve vertex data for one star per line, estimated from the length of the first data row
+		if (catalog.vertex_data.capacity() == 0)
+			catalog.vertex_data.reserve(((size - offset) / (line.size() + 1) + 2) * star_catalog::vertex_size);
+		
+		// Parse star catalog entry, skipping malformed rows
+		if (split_fields(line, fields, max_fields) < max_fields)
+			continue;
+		
+		double ra;
+		double dec;
+		double vmag;
+		double bv_color;
+		if (!parse_field(line.c_str() + fields[1], ra) ||
+			!parse_field(line.c_str() + fields[2], dec) ||
+			!parse_field(line.c_str() + fields[3], vmag) ||
+			!parse_field(line.c_str() + fields[4], bv_color))
+			continue;
+		
+		// Convert right ascension and declination from degrees to radians
+		ra = math::wrap_radians(math::radians(ra));
+		dec = math::wrap_radians(math::radians(dec));
+		
+		// Transform spherical equatorial coordinates to rectangular equatorial coordinates
+		double3 position_bci = geom::spherical::to_cartesian(double3{1.0, dec, ra});
+		
+		// Transform coordinates from equatorial space to inertial space
+		double3 position_inertial = bci_to_inertial * position_bci;
+		
+		// Convert apparent magnitude to irradiance (W/m^2)
+		double vmag_irradiance = std::pow(10.0, 0.4 * (-vmag - 19.0 + 0.4));
+		
+		// Convert irradiance to illuminance
+		double vmag_illuminance = vmag_irradiance * (683.0 * 0.14);
+		
+		bv_colors.push_back(bv_color);
+		illuminances.push_back(vmag_illuminance);
+		
+		// Build vertex, leaving its color to the batch conversion
+		catalog.vertex_data.push_back(static_cast<float>(position_inertial.x));
+		catalog.vertex_data.push_back(static_cast<float>(position_inertial.y));
+		catalog.vertex_data.push_back(static_cast<float>(position_inertial.z));
+		catalog.vertex_data.push_back(0.0f);
+		catalog.vertex_data.push_back(0.0f);
+		catalog.vertex_data.push_back(0.0f);
+	}
+	
+	// Convert color indices to color temperatures in place, then to ACEScg colors
+	const std::size_t star_count = bv_colors.size();
+	double* temperatures = bv_colors.data();
+	color::index::bv_to_cct_n(temperatures, temperatures, star_count);
+	std::vector<double> color_components(star_count * 3);
+	const math::vector3_soa<double> colors = {color_components.data(), color_components.data() + star_count, color_components.data() + star_count * 2};
+	color::cct::to_xyz_n(temperatures, colors, star_count);
+	color::xyz::to_acescg_n(colors, colors, star_count);
+	
+	// Scale colors by illuminance
+	for (std::size_t i = 0; i < star_count; ++i)
+	{
+		float* vertex = catalog.vertex_data.data() + i * star_catalog::vertex_size;
+		vertex[3] = static_cast<float>(colors.x[i] * illuminances[i]);
+		vertex[4] = static_cast<float>(colors.y[i] * illuminances[i]);
+		vertex[5] = static_cast<float>(colors.z[i] * illuminances[i]);
+	}
+	
+	catalog.vertex_data.shrink_to_fit();
+}
+
+void write_binary_star_catalog(const star_catalog& catalog, std::vector<std::uint8_t>& buffer)
+{
+	const std::size_t float_count = catalog.size() * star_catalog::vertex_size;
+	buffer.assign(header_size + float_count * 4, 0);
+	std::uint8_t* data = buffer.data();
+	
+	// Write header
+	std::memcpy(data, binary_star_catalog_magic, sizeof(binary_star_catalog_magic));
+	write_u32(data + 4, binary_star_catalog_version);
+	write_u32(data + 8, static_cast<std::uint32_t>(catalog.size()));
+	write_u32(data + 12, static_cast<std::uint32_t>(star_catalog::vertex_size));
+	
+	// Write vertex data
+	std::uint8_t* vertex = data + header_size;
+	for (std::size_t i = 0; i < float_count; ++i, vertex += 4)
+	{
+		std::uint32_t bits;
+		std::memcpy(&bits, &catalog.vertex_data[i], sizeof(float));
+		write_u32(vertex, bits);
+	}
+}
+
+void tile_star_catalog(star_catalog& catalog, std::size_t resolution)
+{
+	const std::size_t star_count = catalog.size();
+	const std::size_t tile_count = 6 * resolution * resolution;
+	
+	// Determine the tile and illuminance of each star
+	std::vector<std::uint32_t> star_tiles(star_count);
+	std::vector<float> star_illuminances(star_count);
+	for (std::size_t i = 0; i < star_count; ++i)
+	{
+		const float* vertex = catalog.vertex_data.data() + i * star_catalog::vertex_size;
+		star_tiles[i] = static_cast<std::uint32_t>(get_tile_index(vertex, resolution));
+		star_illuminances[i] = std::max(vertex[3], std::max(vertex[4], vertex[5]));
+	}
+	
+	// Order stars by tile, then by descending illuminance
+	std::vector<std::uint32_t> order(star_count);
+	for (std::size_t i = 0; i < star_count; ++i)
+		order[i] = static_cast<std::uint32_t>(i);
+	std::sort
+	(
+		order.begin(),
+		order.end(),
+		[&](std::uint32_t a, std::uint32_t b)
+		{
+			if (star_tiles[a] != star_tiles[b])
+				return star_tiles[a] < star_tiles[b];
+			return star_illuminances[a] > star_illuminances[b];
+		}
+	);
+	
+	// Reorder vertex data
+	std::vector<float> vertex_data(catalog.vertex_data.size());
+	catalog.tiling.illuminances.resize(star_count);
+	for (std::size_t i = 0; i < star_count; ++i)
+	{
+		std::copy_n(catalog.vertex_data.data() + order[i] * star_catalog::vertex_size, star_catalog::vertex_size, vertex_data.data() + i * star_catalog::vertex_size);
+		catalog.tiling.illuminances[i] = star_illuminances[order[i]];
+	}
+	catalog.vertex_data.swap(vertex_data);
+	
+	// Build a bounding sphere and star range for each tile
+	catalog.tiling.tiles.resize(tile_count);
+	const float tile_size = 2.0f / static_cast<float>(resolution);
+	for (std::size_t t = 0; t < tile_count; ++t)
+	{
+		const std::size_t face = t / (resolution * resolution);
+		const std::size_t j = (t / resolution) % resolution;
+		const std::size_t i = t % resolution;
+		const float u0 = static_cast<float>(i) * tile_size - 1.0f;
+		const float v0 = static_cast<float>(j) * tile_size - 1.0f;
+		
+		// The tile is bounded by the cap around its center which reaches its farthest corner
+		const float3 direction = math::normalize(get_cube_point(face, u0 + tile_size * 0.5f, v0 + tile_size * 0.5f));
+		float cos_radius = 1.0f;
+		for (std::size_t k = 0; k < 4; ++k)
+		{
+			const float3 corner = math::normalize(get_cube_point(face, u0 + tile_size * static_cast<float>(k % 2), v0 + tile_size * static_cast<float>(k / 2)));
+			cos_radius = std::min(cos_radius, math::dot(direction, corner));
+		}
+		
+		star_tile& tile = catalog.tiling.tiles[t];
+		tile.center = direction * cos_radius;
+		tile.radius = std::sqrt(std::max(0.0f, 1.0f - cos_radius * cos_radius));
+		tile.start = 0;
+		tile.count = 0;
+	}
+	
+	for (std::size_t i = 0; i < star_count; ++i)
+	{
+		star_tile& tile = catalog.tiling.tiles[star_tiles[order[i]]];
+		if (!tile.count)
+			tile.start = static_cast<std::uint32_t>(i);
+		++tile.count;
+	}
+}
@@ -0,0 +1,151 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ANTKEEPER_STAR_CATALOG_HPP
+#define ANTKEEPER_STAR_CATALOG_HPP
+
+#include "resources/resource-loader.hpp"
+#include "utility/fundamental-types.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/// Range of the stars within a tile of the celestial sphere.
+struct star_tile
+{
+	/// Center of a sphere which bounds the tile on the unit sphere, in inertial space.
+	float3 center;
+	
+	/// Radius of the bounding sphere.
+	float radius;
+	
+	/// Index of the first star of the tile.
+	std::uint32_t start;
+	
+	/// Number of stars in the tile.
+	std::uint32_t count;
+};
+
+/**
+ * Stars binned into tiles of the celestial sphere, by which the stars in view and above a limiting illuminance can be drawn without testing each star.
+ *
+ * The celestial sphere is divided into the tiles of a cube projected onto it, with a square grid of tiles on each face. Stars are ordered by tile, then by descending illuminance within each tile, so that the stars of a tile above a limiting illuminance are a prefix of its range.
+ */
+struct star_tiling
+{
+	/// Tiles, in the order of their stars.
+	std::vector<star_tile> tiles;
+	
+	/// Greatest component of the scaled color of each star, in the order of the stars.
+	std::vector<float> illuminances;
+};
+
+/**
+ * Star catalog, converted to the vertex data of the stars model.
+ *
+ * Each vertex consists of the position of a star on the unit sphere, in inertial space, followed by its ACEScg color scaled by its illuminance.
+ */
+struct star_catalog
+{
+	/// Number of floats per star vertex.
+	static constexpr std::size_t vertex_size = 6;
+	
+	/// Number of tiles along each edge of each face of the tile cube.
+	static constexpr std::size_t tile_resolution = 8;
+	
+	/// Interleaved star vertices.
+	std::vector<float> vertex_data;
+	
+	/// Tiles of the stars, in the order of the vertex data.
+	star_tiling tiling;
+	
+	/// Returns the number of stars in the catalog.
+	std::size_t size() const;
+};
+
+inline std::size_t star_catalog::size() const
+{
+	return vertex_data.size() / vertex_size;
+}
+
+/**
+ * Returns `true` if a buffer contains a binary star catalog.
+ *
+ * @param data File data.
+ * @param size Size of the file data, in bytes.
+ */
+bool is_binary_star_catalog(const std::uint8_t* data, std::size_t size);
+
+/**
+ * Reads a binary star catalog.
+ *
+ * @param data File data.
+ * @param size Size of the file data, in bytes.
+ * @param[out] catalog Star catalog.
+ *
+ * @exception std::runtime_error Malformed binary star catalog.
+ */
+void read_binary_star_catalog(const std::uint8_t* data, std::size_t size, star_catalog& catalog);
+
+/**
+ * Reads a CSV star catalog, with a header row followed by rows of the form `name,ra,dec,vmag,b-v`, where right ascension and declination are in degrees. Rows which can't be parsed are skipped.
+ *
+ * @param data File data.
+ * @param size Size of the file data, in bytes.
+ * @param[out] catalog Star catalog.
+ */
+void read_csv_star_catalog(const std::uint8_t* data, std::size_t size, star_catalog& catalog);
+
+/**
+ * Writes a binary star catalog.
+ *
+ * @param catalog Star catalog.
+ * @param[out] buffer Buffer to which the file data will be written.
+ */
+void write_binary_star_catalog(const star_catalog& catalog, std::vector<std::uint8_t>& buffer);
+
+/**
+ * Bins the stars of a catalog into tiles, reordering its vertex data by tile and by descending illuminance within each tile.
+ *
+ * @param catalog Star catalog.
+ * @param resolution Number of tiles along each edge of each face of the tile cube.
+ */
+void tile_star_catalog(star_catalog& catalog, std::size_t resolution);
+
+template <>
+struct resource_loader_traits<star_catalog>
+{
+	static constexpr bool concurrent = true;
+};
+
+template <>
+struct resource_footprint<star_catalog>
+{
+	static std::size_t cpu_size(const star_catalog& resource)
+	{
+		return sizeof(star_catalog) + resource.vertex_data.capacity() * sizeof(float) + resource.tiling.tiles.capacity() * sizeof(star_tile) + resource.tiling.illuminances.capacity() * sizeof(float);
+	}
+	
+	static std::size_t gpu_size(const star_catalog& resource)
+	{
+		return 0;
+	}
+};
+
+#endif // ANTKEEPER_STAR_CATALOG_HPP
@@ -21,89 +21,12 @@
 #include "string-table.hpp"
 #include <physfs.h>
 
-static string_table_row parse_row(const std::string& line)
-{
-	std::vector<std::string> row;
-	std::string column;
-	bool quoted = false;
-	bool escape = false;
-
-	for (char c: line)
-	{
-		if (escape)
-		{
-			switch (c)
-			{
-				case 'n':
-					column.push_back('\n');
-					break;
-
-				case 't':
-					column.push_back('\t');
-					break;
-
-				default:
-					column.push_back(c);
-					break;
-			}
-
-			escape = false;
-		}
-		else
-		{
-			switch (c)
-			{
-				case '\\':
-					escape = true;
-					break;
-
-				case ',':
-					if (quoted)
-					{
-						column.push_back(c);
-					}
-					else
-					{
-						row.push_back(column);
-						column.clear();
-					}
-					break;
-
-				case '"':
-					if (!quoted)
-					{
-						quoted = true;
-					}
-					else
-					{
-						quoted = false;
-					}
-					break;
-
-				default:
-					column.push_back(c);
-					break;
-			}
-		}
-	}
-
-	row.push_back(column);
-
-	return row;
-}
-
 template <>
-string_table* resource_loader<string_table>::load(resource_manager* resource_manager, PHYSFS_File* file)
+string_table* resource_loader<string_table>::load(resource_manager* resource_manager, const std::uint8_t* data, std::size_t size)
 {
 	string_table* table = new string_table();
-	std::string line;
-
-	while (!PHYSFS_eof(file))
-	{
-		physfs_getline(file, line);
-		table->push_back(parse_row(line));
-	}
-
+	table->parse(data, size);
+	
 	return table;
 }
 
@@ -115,11 +38,11 @@ void resource_loader<string_table>::save(resource_manager* resource_manager, PHY
 	
 	for (std::size_t i = 0; i < table->size(); ++i)
 	{
-		const string_table_row& row = (*table)[i];
+		const string_table_row row = (*table)[i];
 
 		for (std::size_t j = 0; j < row.size(); ++j)
 		{
-			const std::string& column = row[j];
+			const std::string_view column = row[j];
 			
 			PHYSFS_writeBytes(file, column.data(), column.length());
 
@@ -18,17 +18,167 @@
  */
 
 #include "resources/string-table.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+/**
+ * Parses a single CSV line, appending the unescaped characters of its cells to a character buffer and the locations of its cells to a cell list.
+ *
+ * @param begin First character of the line.
+ * @param end One past the last character of the line, excluding the line break.
+ * @param[in,out] characters Character buffer.
+ * @param[in,out] cells Cell list.
+ */
+void parse_line(const char* begin, const char* end, std::string& characters, std::vector<string_table_cell>& cells)
+{
+	string_table_cell cell = {static_cast<std::uint32_t>(characters.size()), 0};
+	bool quoted = false;
+	bool escape = false;
+	
+	for (const char* c = begin; c != end; ++c)
+	{
+		if (*c == '\r')
+			continue;
+		
+		if (escape)
+		{
+			switch (*c)
+			{
+				case 'n':
+					characters.push_back('\n');
+					break;
+				
+				case 't':
+					characters.push_back('\t');
+					break;
+				
+				default:
+					characters.push_back(*c);
+					break;
+			}
+			
+			escape = false;
+		}
+		else
+		{
+			switch (*c)
+			{
+				case '\\':
+					escape = true;
+					break;
+				
+				case ',':
+					if (quoted)
+					{
+						characters.push_back(*c);
+					}
+					else
+					{
+						cell.length = static_cast<std::uint32_t>(characters.size()) - cell.offset;
+						cells.push_back(cell);
+						cell.offset = static_cast<std::uint32_t>(characters.size());
+					}
+					break;
+				
+				case '"':
+					quoted = !quoted;
+					break;
+				
+				default:
+					characters.push_back(*c);
+					break;
+			}
+		}
+	}
+	
+	cell.length = static_cast<std::uint32_t>(characters.size()) - cell.offset;
+	cells.push_back(cell);
+}
+
+/**
+ * Finds the next line of CSV data.
+ *
+ * @param data CSV data.
+ * @param size Size of the CSV data, in bytes.
+ * @param[in,out] offset Offset of the line, which is advanced past its line break.
+ * @param[out] begin First character of the line.
+ * @param[out] end One past the last character of the line.
+ * @return `false` if the end of the data has been reached, `true` otherwise.
+ */
+bool next_line(const std::uint8_t* data, std::size_t size, std::size_t& offset, const char*& begin, const char*& end)
+{
+	if (offset >= size)
+		return false;
+	
+	begin = reinterpret_cast<const char*>(data + offset);
+	const char* line_break = static_cast<const char*>(std::memchr(begin, '\n', size - offset));
+	end = (line_break) ? line_break : reinterpret_cast<const char*>(data + size);
+	offset = (end - reinterpret_cast<const char*>(data)) + ((line_break) ? 1 : 0);
+	
+	return true;
+}
+
+} // namespace
+
+void string_table::parse(const std::uint8_t* data, std::size_t size)
+{
+	characters.clear();
+	cells.clear();
+	rows.clear();
+	
+	// Reserve storage for the upper bounds of the number of characters, cells, and rows, as unescaped cells are never longer than their CSV text
+	const char* text = reinterpret_cast<const char*>(data);
+	const std::size_t line_count = std::count(text, text + size, '\n') + 1;
+	const std::size_t delimiter_count = std::count(text, text + size, ',');
+	characters.reserve(size);
+	cells.reserve(line_count + delimiter_count);
+	rows.reserve(line_count + 1);
+	
+	std::size_t offset = 0;
+	const char* begin;
+	const char* end;
+	while (next_line(data, size, offset, begin, end))
+	{
+		rows.push_back(static_cast<std::uint32_t>(cells.size()));
+		parse_line(begin, end, characters, cells);
+	}
+	rows.push_back(static_cast<std::uint32_t>(cells.size()));
+}
+
+void parse_string_table(const std::uint8_t* data, std::size_t size, const std::function<void(const string_table_row&)>& callback)
+{
+	std::string characters;
+	std::vector<string_table_cell> cells;
+	
+	std::size_t offset = 0;
+	const char* begin;
+	const char* end;
+	while (next_line(data, size, offset, begin, end))
+	{
+		characters.clear();
+		cells.clear();
+		parse_line(begin, end, characters, cells);
+		callback(string_table_row(characters.data(), cells.data(), cells.size()));
+	}
+}
 
 void build_string_table_map(string_table_map* map, const string_table& table)
 {
 	map->clear();
 	
+	if (table.empty())
+		return;
+	
+	const string_table_row header = table[0];
 	for (std::size_t i = 0; i < table.size(); ++i)
 	{
-		for (std::size_t j = 2; j < table[i].size(); ++j)
+		const string_table_row row = table[i];
+		for (std::size_t j = 2; j < row.size() && j < header.size(); ++j)
 		{
-			const std::string& string = table[i][j];
-			(*map)[table[0][j]][table[i][0]] = string.empty() ? "# MISSING STRING #" : string;
+			const std::string_view string = row[j];
+			(*map)[header[j]][row[0]] = string.empty() ? std::string_view("# MISSING STRING #") : string;
 		}
 	}
 }
@@ -36,7 +186,8 @@ void build_string_table_map(string_table_map* map, const string_table& table)
 string_table_index index_string_table(const string_table& table)
 {
 	string_table_index index;
-
+	index.reserve(table.size());
+	
 	for (std::size_t i = 0; i < table.size(); ++i)
 	{
 		index[table[i][0]] = i;
@@ -20,26 +20,148 @@
 #ifndef ANTKEEPER_STRING_TABLE_HPP
 #define ANTKEEPER_STRING_TABLE_HPP
 
+#include "resources/resource-loader.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
 
+/// Location of a single cell in the character buffer of a string table.
+struct string_table_cell
+{
+	/// Offset of the first character of the cell.
+	std::uint32_t offset;
+	
+	/// Number of characters in the cell.
+	std::uint32_t length;
+};
+
+/**
+ * A single row in a string table. Rows are views into the character buffer of the table or parser which produced them, and are invalidated along with it.
+ */
+class string_table_row
+{
+public:
+	/**
+	 * Creates a row view.
+	 *
+	 * @param characters Character buffer into which the cells point.
+	 * @param cells First cell of the row.
+	 * @param size Number of cells in the row.
+	 */
+	string_table_row(const char* characters, const string_table_cell* cells, std::size_t size);
+	
+	/// Returns the contents of a cell.
+	std::string_view operator[](std::size_t i) const;
+	
+	/// Returns the number of cells in the row.
+	std::size_t size() const;
+	
+	/// Returns `true` if the row has no cells.
+	bool empty() const;
+
+private:
+	const char* characters;
+	const string_table_cell* cells;
+	std::size_t count;
+};
+
+inline string_table_row::string_table_row(const char* characters, const string_table_cell* cells, std::size_t size):
+	characters(characters),
+	cells(cells),
+	count(size)
+{}
+
+inline std::string_view string_table_row::operator[](std::size_t i) const
+{
+	return std::string_view(characters + cells[i].offset, cells[i].length);
+}
+
+inline std::size_t string_table_row::size() const
+{
+	return count;
+}
+
+inline bool string_table_row::empty() const
+{
+	return !count;
+}
+
 /**
- * A single row in a string table.
+ * A table of strings, backed by a single character buffer.
  */
-typedef std::vector<std::string> string_table_row;
+class string_table
+{
+public:
+	/**
+	 * Parses a CSV table. Cells may be quoted, to contain delimiters, and may contain the escape sequences `\n` and `\t`.
+	 *
+	 * @param data CSV data.
+	 * @param size Size of the CSV data, in bytes.
+	 */
+	void parse(const std::uint8_t* data, std::size_t size);
+	
+	/// Returns a row of the table.
+	string_table_row operator[](std::size_t i) const;
+	
+	/// Returns the number of rows in the table.
+	std::size_t size() const;
+	
+	/// Returns `true` if the table has no rows.
+	bool empty() const;
+	
+	/// Returns the number of bytes allocated by the table.
+	std::size_t capacity() const;
+
+private:
+	std::string characters;
+	std::vector<string_table_cell> cells;
+	
+	/// Index of the first cell of each row, followed by the total number of cells, such that row `i` spans cells `[rows[i], rows[i + 1])`.
+	std::vector<std::uint32_t> rows;
+};
+
+inline string_table_row string_table::operator[](std::size_t i) const
+{
+	return string_table_row(characters.data(), cells.data() + rows[i], rows[i + 1] - rows[i]);
+}
+
+inline std::size_t string_table::size() const
+{
+	return (rows.empty()) ? 0 : rows.size() - 1;
+}
+
+inline bool string_table::empty() const
+{
+	return rows.size() <= 1;
+}
+
+inline std::size_t string_table::capacity() const
+{
+	return characters.capacity() + cells.capacity() * sizeof(string_table_cell) + rows.capacity() * sizeof(std::uint32_t);
+}
 
 /**
- * A table of strings.
+ * Parses CSV data one row at a time, without building a string table. The cells of each row are parsed into a buffer which is reused by the following row.
+ *
+ * @param data CSV data.
+ * @param size Size of the CSV data, in bytes.
+ * @param callback Function called with each row, which is valid only until the function returns.
  */
-typedef std::vector<string_table_row> string_table;
+void parse_string_table(const std::uint8_t* data, std::size_t size, const std::function<void(const string_table_row&)>& callback);
 
 /**
  * An index for finding elements in a string table.
  */
-typedef std::unordered_map<std::string, std::size_t> string_table_index;
+typedef std::unordered_map<std::string_view, std::size_t> string_table_index;
 
-typedef std::unordered_map<std::string, std::unordered_map<std::string, std::string>> string_table_map;
+/**
+ * Maps language codes to maps of string keys to strings. Keys and strings are views into the string table from which the map was built.
+ */
+typedef std::unordered_map<std::string_view, std::unordered_map<std::string_view, std::string_view>> string_table_map;
 
 void build_string_table_map(string_table_map* map, const string_table& table);
 
@@ -50,5 +172,24 @@ void build_string_table_map(string_table_map* map, const string_table& table);
  */
 string_table_index index_string_table(const string_table& table);
 
-#endif // ANTKEEPER_STRING_TABLE_HPP
+template <>
+struct resource_loader_traits<string_table>
+{
+	static constexpr bool concurrent = true;
+};
 
+template <>
+struct resource_footprint<string_table>
+{
+	static std::size_t cpu_size(const string_table& resource)
+	{
+		return sizeof(string_table) + resource.capacity();
+	}
+	
+	static std::size_t gpu_size(const string_table& resource)
+	{
+		return 0;
+	}
+};
+
+#endif // ANTKEEPER_STRING_TABLE_HPP
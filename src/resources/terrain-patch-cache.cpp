@@ -0,0 +1,208 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "resources/terrain-patch-cache.hpp"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <thread>
+
+#if defined(_WIN32)
+	#include <windows.h>
+#else
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+namespace {
+
+/// Magic number identifying cached terrain patches.
+constexpr char cache_magic[4] = {'A', 'K', 'T', 'P'};
+
+/// Version of the cached patch format.
+constexpr std::uint32_t cache_version = 1;
+
+/// Cached terrain patch header, followed by the patch vertex data.
+struct cache_header
+{
+	char magic[4];
+	std::uint32_t version;
+	std::uint64_t seed;
+	std::uint64_t node;
+	std::uint32_t face_index;
+	std::uint32_t subdivisions;
+	std::uint64_t vertex_size;
+	std::uint64_t vertex_count;
+	double origin[3];
+	float bounds_min[3];
+	float bounds_max[3];
+};
+
+#if defined(_WIN32)
+	std::wstring widen(const std::string& string)
+	{
+		std::wstring wstring(MultiByteToWideChar(CP_UTF8, 0, &string[0], static_cast<int>(string.size()), nullptr, 0), L'\0');
+		MultiByteToWideChar(CP_UTF8, 0, &string[0], static_cast<int>(string.size()), &wstring[0], static_cast<int>(wstring.size()));
+		return wstring;
+	}
+#endif
+
+} // namespace
+
+terrain_patch_cache::terrain_patch_cache(const std::string& path):
+	path(path)
+{
+	if (!this->path.empty() && this->path.back() != '/')
+		this->path += '/';
+}
+
+bool terrain_patch_cache::load(const key& key, float* vertex_data, std::size_t vertex_size, std::size_t vertex_count, geom::aabb<float>& bounds, double3& origin) const
+{
+	const std::string patch_path = get_path(key);
+	const std::size_t data_size = vertex_size * vertex_count * sizeof(float);
+	
+	// Map the cached file
+	const std::uint8_t* data = nullptr;
+	std::size_t size = 0;
+	#if defined(_WIN32)
+		HANDLE file_handle = CreateFileW(widen(patch_path).c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file_handle == INVALID_HANDLE_VALUE)
+			return false;
+		
+		LARGE_INTEGER file_size;
+		if (GetFileSizeEx(file_handle, &file_size))
+			size = static_cast<std::size_t>(file_size.QuadPart);
+		
+		HANDLE mapping_handle = (size) ? CreateFileMappingW(file_handle, nullptr, PAGE_READONLY, 0, 0, nullptr) : nullptr;
+		if (mapping_handle)
+			data = static_cast<const std::uint8_t*>(MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0));
+		if (!data)
+		{
+			if (mapping_handle)
+				CloseHandle(mapping_handle);
+			CloseHandle(file_handle);
+			return false;
+		}
+	#else
+		const int file_descriptor = open(patch_path.c_str(), O_RDONLY);
+		if (file_descriptor == -1)
+			return false;
+		
+		struct stat file_status;
+		if (fstat(file_descriptor, &file_status) == 0)
+			size = static_cast<std::size_t>(file_status.st_size);
+		
+		void* mapping = (size) ? mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file_descriptor, 0) : MAP_FAILED;
+		if (mapping == MAP_FAILED)
+		{
+			close(file_descriptor);
+			return false;
+		}
+		data = static_cast<const std::uint8_t*>(mapping);
+	#endif
+	
+	// Validate the header against the key and vertex layout, then copy the vertex data
+	cache_header header;
+	bool valid = (size == sizeof(header) + data_size);
+	if (valid)
+	{
+		std::memcpy(&header, data, sizeof(header));
+		valid = !std::memcmp(header.magic, cache_magic, sizeof(cache_magic)) &&
+			header.version == cache_version &&
+			header.seed == key.seed &&
+			header.node == key.node &&
+			header.face_index == key.face_index &&
+			header.subdivisions == key.subdivisions &&
+			header.vertex_size == vertex_size &&
+			header.vertex_count == vertex_count;
+	}
+	if (valid)
+	{
+		std::memcpy(vertex_data, data + sizeof(header), data_size);
+		origin = {header.origin[0], header.origin[1], header.origin[2]};
+		bounds.min_point = {header.bounds_min[0], header.bounds_min[1], header.bounds_min[2]};
+		bounds.max_point = {header.bounds_max[0], header.bounds_max[1], header.bounds_max[2]};
+	}
+	
+	#if defined(_WIN32)
+		UnmapViewOfFile(data);
+		CloseHandle(mapping_handle);
+		CloseHandle(file_handle);
+	#else
+		munmap(const_cast<std::uint8_t*>(data), size);
+		close(file_descriptor);
+	#endif
+	
+	return valid;
+}
+
+bool terrain_patch_cache::store(const key& key, const float* vertex_data, std::size_t vertex_size, std::size_t vertex_count, const geom::aabb<float>& bounds, const double3& origin) const
+{
+	cache_header header;
+	std::memcpy(header.magic, cache_magic, sizeof(cache_magic));
+	header.version = cache_version;
+	header.seed = key.seed;
+	header.node = key.node;
+	header.face_index = key.face_index;
+	header.subdivisions = key.subdivisions;
+	header.vertex_size = vertex_size;
+	header.vertex_count = vertex_count;
+	for (int i = 0; i < 3; ++i)
+	{
+		header.origin[i] = origin[i];
+		header.bounds_min[i] = bounds.min_point[i];
+		header.bounds_max[i] = bounds.max_point[i];
+	}
+	
+	// Write to a temporary file unique to the writing thread, then replace the cached patch, so that an interrupted write can't leave a truncated patch behind
+	const std::string patch_path = get_path(key);
+	const std::string temporary_path = patch_path + "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".tmp";
+	{
+		std::ofstream file(temporary_path, std::ios::binary | std::ios::trunc);
+		if (!file)
+			return false;
+		
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file.write(reinterpret_cast<const char*>(vertex_data), vertex_size * vertex_count * sizeof(float));
+		if (!file)
+		{
+			file.close();
+			std::remove(temporary_path.c_str());
+			return false;
+		}
+	}
+	
+	std::remove(patch_path.c_str());
+	return (std::rename(temporary_path.c_str(), patch_path.c_str()) == 0);
+}
+
+std::string terrain_patch_cache::get_path(const key& key) const
+{
+	char name[64];
+	std::snprintf(name, sizeof(name), "%016llx-%u-%016llx-%u.patch",
+		static_cast<unsigned long long>(key.seed),
+		static_cast<unsigned int>(key.face_index),
+		static_cast<unsigned long long>(key.node),
+		static_cast<unsigned int>(key.subdivisions));
+	return path + name;
+}
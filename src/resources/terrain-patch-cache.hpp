@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef ANTKEEPER_TERRAIN_PATCH_CACHE_HPP
+#define ANTKEEPER_TERRAIN_PATCH_CACHE_HPP
+
+#include "geom/aabb.hpp"
+#include "utility/fundamental-types.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * On-disk cache of generated terrain patch vertex data.
+ *
+ * Patches are keyed by the seed of their terrain, their quadsphere face, their quadtree node, and the number of patch subdivisions, and each is stored in its own file along with its bounds and origin. Cached files are memory-mapped when read. Files whose vertex layout doesn't match the requested layout are ignored, and replaced once the patch is generated again.
+ *
+ * Loading and storing different patches is safe from multiple threads at once, so patches may be cached by the jobs which generate them.
+ */
+class terrain_patch_cache
+{
+public:
+	/// Identifies a cached terrain patch.
+	struct key
+	{
+		/// Seed of the terrain, which must identify its elevation functions and body radius.
+		std::uint64_t seed;
+		
+		/// Index of the quadsphere face of the patch.
+		std::uint8_t face_index;
+		
+		/// Quadtree node of the patch.
+		std::uint64_t node;
+		
+		/// Number of patch subdivisions.
+		std::uint8_t subdivisions;
+	};
+	
+	/**
+	 * Creates a terrain patch cache.
+	 *
+	 * @param path Path to an existing directory in which to store patches.
+	 */
+	explicit terrain_patch_cache(const std::string& path);
+	
+	/**
+	 * Loads the vertex data of a cached patch.
+	 *
+	 * @param key Key of the patch.
+	 * @param[out] vertex_data Array of `vertex_size * vertex_count` floats into which the vertex data is copied.
+	 * @param vertex_size Number of floats per vertex.
+	 * @param vertex_count Number of vertices.
+	 * @param[out] bounds Bounds of the patch vertices, relative to the patch origin.
+	 * @param[out] origin Double-precision origin of the patch.
+	 * @return `true` if the patch was cached with a matching vertex layout, `false` otherwise.
+	 */
+	bool load(const key& key, float* vertex_data, std::size_t vertex_size, std::size_t vertex_count, geom::aabb<float>& bounds, double3& origin) const;
+	
+	/**
+	 * Stores the vertex data of a patch in the cache.
+	 *
+	 * @param key Key of the patch.
+	 * @param vertex_data Array of `vertex_size * vertex_count` floats.
+	 * @param vertex_size Number of floats per vertex.
+	 * @param vertex_count Number of vertices.
+	 * @param bounds Bounds of the patch vertices, relative to the patch origin.
+	 * @param origin Double-precision origin of the patch.
+	 * @return `true` if the patch was stored, `false` otherwise.
+	 */
+	bool store(const key& key, const float* vertex_data, std::size_t vertex_size, std::size_t vertex_count, const geom::aabb<float>& bounds, const double3& origin) const;
+	
+private:
+	std::string get_path(const key& key) const;
+	
+	std::string path;
+};
+
+#endif // ANTKEEPER_TERRAIN_PATCH_CACHE_HPP
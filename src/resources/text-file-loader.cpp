@@ -19,17 +19,16 @@
 
 #include "resources/resource-loader.hpp"
 #include "resources/text-file.hpp"
-#include <physfs.h>
 
 template <>
-text_file* resource_loader<text_file>::load(resource_manager* resource_manager, PHYSFS_File* file)
+text_file* resource_loader<text_file>::load(resource_manager* resource_manager, const std::uint8_t* data, std::size_t size)
 {
 	text_file* text = new text_file();
 	std::string line;
+	std::size_t offset = 0;
 	
-	while (!PHYSFS_eof(file))
+	while (resource_getline(data, size, offset, line))
 	{
-		physfs_getline(file, line);
 		text->push_back(line);
 	}
 
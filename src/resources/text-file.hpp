@@ -20,10 +20,34 @@
 #ifndef TEXT_FILE_HPP
 #define TEXT_FILE_HPP
 
+#include "resources/resource-loader.hpp"
 #include <string>
 #include <vector>
 
 typedef std::vector<std::string> text_file;
 
+template <>
+struct resource_loader_traits<text_file>
+{
+	static constexpr bool concurrent = true;
+};
+
+template <>
+struct resource_footprint<text_file>
+{
+	static std::size_t cpu_size(const text_file& resource)
+	{
+		std::size_t size = sizeof(text_file) + resource.capacity() * sizeof(std::string);
+		for (const std::string& line: resource)
+			size += line.capacity();
+		return size;
+	}
+	
+	static std::size_t gpu_size(const text_file& resource)
+	{
+		return 0;
+	}
+};
+
 #endif // TEXT_FILE_HPP
 
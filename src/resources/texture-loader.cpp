@@ -20,33 +20,48 @@
 #include "resources/resource-loader.hpp"
 #include "resources/resource-manager.hpp"
 #include "resources/image.hpp"
+#include "resources/compressed-image.hpp"
 #include "gl/pixel-type.hpp"
 #include "gl/pixel-format.hpp"
 #include "gl/color-space.hpp"
 #include "gl/texture-2d.hpp"
+#include "gl/texture-2d-array.hpp"
 #include "gl/texture-wrapping.hpp"
 #include "gl/texture-filter.hpp"
+#include "gl/pixel-conversion.hpp"
+#include "renderer/texture-streamer.hpp"
+#include "utility/job-system.hpp"
+#include <cstdint>
 #include <sstream>
+#include <vector>
 #include <nlohmann/json.hpp>
-#include <physfs.h>
 
-template <>
-gl::texture_2d* resource_loader<gl::texture_2d>::load(resource_manager* resource_manager, PHYSFS_File* file)
+/// Calls a pixel conversion function over subranges of pixels, in parallel if a job system has been set.
+template <class Function>
+static void convert_pixels(job_system* jobs, std::size_t pixel_count, const Function& function)
 {
-	// Read file into buffer
-	std::size_t size = static_cast<int>(PHYSFS_fileLength(file));
-	std::string buffer;
-	buffer.resize(size);
-	PHYSFS_readBytes(file, &buffer[0], size);
-	
-	// Parse json from file buffer
-	nlohmann::json json = nlohmann::json::parse(buffer);
-	
-	// Read image filename
-	std::string image_filename;
-	if (auto element = json.find("image"); element != json.end())
-		image_filename = element.value().get<std::string>();
+	// Number of pixels converted by each job
+	constexpr std::size_t grain = 1 << 16;
 	
+	if (jobs && pixel_count > grain)
+		jobs->parallel_for(0, pixel_count, grain, function);
+	else
+		function(0, pixel_count);
+}
+
+/// Sampling parameters of a texture, shared by the texture file formats.
+struct texture_sampling
+{
+	gl::color_space color_space;
+	gl::texture_wrapping wrapping;
+	gl::texture_min_filter min_filter;
+	gl::texture_mag_filter mag_filter;
+	float max_anisotropy;
+};
+
+/// Reads the color space, extension mode, interpolation mode and max anisotropy of a texture file.
+static texture_sampling read_texture_sampling(const nlohmann::json& json)
+{
 	// Read color space
 	gl::color_space color_space = gl::color_space::linear;
 	if (auto element = json.find("color_space"); element != json.end())
@@ -96,48 +111,244 @@ gl::texture_2d* resource_loader<gl::texture_2d>::load(resource_manager* resource
 	if (auto element = json.find("max_anisotropy"); element != json.end())
 		max_anisotropy = element.value().get<float>();
 	
-	// Load image
-	::image* image = resource_manager->load<::image>(image_filename);
-	
-	// Determine pixel type
-	gl::pixel_type type = (image->is_hdr()) ? gl::pixel_type::float_32 : gl::pixel_type::uint_8;
+	return {color_space, wrapping, min_filter, mag_filter, max_anisotropy};
+}
 
-	// Determine pixel format
-	gl::pixel_format format;
-	if (image->get_channels() == 1)
+/// Returns the pixel format of an image's channels.
+static gl::pixel_format get_image_pixel_format(const ::image& image)
+{
+	if (image.get_channels() == 1)
 	{
-		format = gl::pixel_format::r;
+		return gl::pixel_format::r;
 	}
-	else if (image->get_channels() == 2)
+	else if (image.get_channels() == 2)
 	{
-		format = gl::pixel_format::rg;
+		return gl::pixel_format::rg;
 	}
-	else if (image->get_channels() == 3)
+	else if (image.get_channels() == 3)
 	{
-		format = gl::pixel_format::rgb;
+		return gl::pixel_format::rgb;
 	}
-	else if (image->get_channels() == 4)
+	else if (image.get_channels() == 4)
 	{
-		format = gl::pixel_format::rgba;
+		return gl::pixel_format::rgba;
 	}
-	else
+	
+	std::stringstream stream;
+	stream << std::string("Texture cannot be created from an image with an unsupported number of color channels (") << image.get_channels() << std::string(").");
+	throw std::runtime_error(stream.str().c_str());
+}
+
+template <>
+gl::texture_2d* resource_loader<gl::texture_2d>::load(resource_manager* resource_manager, const std::uint8_t* data, std::size_t size)
+{
+	// Parse json from file data
+	nlohmann::json json = nlohmann::json::parse(data, data + size);
+	
+	// Read image filename
+	std::string image_filename;
+	if (auto element = json.find("image"); element != json.end())
+		image_filename = element.value().get<std::string>();
+	
+	// Read color space, extension mode, interpolation mode, and max anisotropy
+	const auto [color_space, wrapping, min_filter, mag_filter, max_anisotropy] = read_texture_sampling(json);
+	
+	// Read precision with which HDR images are stored
+	enum class hdr_precision {full, half, packed};
+	hdr_precision precision = hdr_precision::half;
+	if (auto element = json.find("precision"); element != json.end())
+	{
+		std::string value = element.value().get<std::string>();
+		if (value == "full")
+			precision = hdr_precision::full;
+		else if (value == "half")
+			precision = hdr_precision::half;
+		else if (value == "packed")
+			precision = hdr_precision::packed;
+	}
+	
+	// Read fallback image filename, used in place of a compressed image if its format is not supported
+	std::string fallback_image_filename;
+	if (auto element = json.find("fallback_image"); element != json.end())
+		fallback_image_filename = element.value().get<std::string>();
+	
+	// Upload KTX2 images as they are, with their own mip chains and color spaces, falling back to the fallback image if they can't be loaded or sampled
+	const std::string ktx2_extension = ".ktx2";
+	if (image_filename.size() >= ktx2_extension.size() && !image_filename.compare(image_filename.size() - ktx2_extension.size(), ktx2_extension.size(), ktx2_extension))
 	{
-		std::stringstream stream;
-		stream << std::string("Texture cannot be created from an image with an unsupported number of color channels (") << image->get_channels() << std::string(").");
-		delete image;
-		throw std::runtime_error(stream.str().c_str());
+		resource_ptr<::compressed_image> compressed_image = resource_manager->acquire<::compressed_image>(image_filename);
+		if (compressed_image && gl::texture_2d::is_supported(compressed_image->get_format()))
+		{
+			// Stream the fine levels of mip chains, retaining the compressed image from which they're uploaded
+			gl::texture_2d* texture;
+			if (::texture_streamer* streamer = resource_manager->get_texture_streamer(); streamer && compressed_image->get_level_count() > 1)
+				texture = streamer->create_texture(std::move(compressed_image));
+			else
+				texture = new gl::texture_2d(compressed_image->get_width(), compressed_image->get_height(), compressed_image->get_format(), compressed_image->get_color_space(), compressed_image->get_level_count(), compressed_image->get_level_data(), compressed_image->get_level_sizes());
+			
+			texture->set_wrapping(wrapping, wrapping);
+			texture->set_filters(min_filter, mag_filter);
+			texture->set_max_anisotropy(max_anisotropy);
+			return texture;
+		}
+		
+		if (fallback_image_filename.empty())
+			throw std::runtime_error("Compressed image \"" + image_filename + "\" could not be loaded or its format is not supported, and no fallback image was given.");
+		
+		image_filename = fallback_image_filename;
 	}
+	
+	// Load image, which is unloaded once the texture has been created
+	resource_ptr<::image> image = resource_manager->acquire<::image>(image_filename);
+	if (!image)
+		throw std::runtime_error("Image \"" + image_filename + "\" could not be loaded.");
+	
+	// Determine pixel type
+	gl::pixel_type type = (image->is_hdr()) ? gl::pixel_type::float_32 : gl::pixel_type::uint_8;
+
+	// Determine pixel format
+	const gl::pixel_format format = get_image_pixel_format(*image);
 
 	// Create texture
-	gl::texture_2d* texture = new gl::texture_2d(image->get_width(), image->get_height(), type, format, color_space, image->get_pixels());
+	gl::texture_2d* texture;
+	if (image->is_hdr() && precision != hdr_precision::full)
+	{
+		// Convert HDR pixels on the job system to a type which the driver can upload without converting them itself
+		const int width = static_cast<int>(image->get_width());
+		const int height = static_cast<int>(image->get_height());
+		const std::size_t pixel_count = static_cast<std::size_t>(width) * static_cast<std::size_t>(height);
+		const std::size_t channels = image->get_channels();
+		const float* source = static_cast<const float*>(image->get_pixels());
+		
+		std::vector<std::uint32_t> packed_pixels;
+		std::vector<std::uint16_t> half_pixels;
+		const void* pixels;
+		if (precision == hdr_precision::packed && format == gl::pixel_format::rgb)
+		{
+			// Unsigned 11-bit and 10-bit floats, in a third of the memory of full-precision floats
+			type = gl::pixel_type::ufloat_11_11_10;
+			packed_pixels.resize(pixel_count);
+			convert_pixels
+			(
+				resource_manager->get_job_system(),
+				pixel_count,
+				[&](std::size_t first, std::size_t last)
+				{
+					gl::float_to_ufloat_11_11_10(source + first * 3, packed_pixels.data() + first, last - first);
+				}
+			);
+			pixels = packed_pixels.data();
+		}
+		else
+		{
+			// Half-precision floats, in half the memory of full-precision floats
+			type = gl::pixel_type::float_16;
+			half_pixels.resize(pixel_count * channels);
+			convert_pixels
+			(
+				resource_manager->get_job_system(),
+				pixel_count,
+				[&](std::size_t first, std::size_t last)
+				{
+					gl::float_to_half(source + first * channels, half_pixels.data() + first * channels, (last - first) * channels);
+				}
+			);
+			pixels = half_pixels.data();
+		}
+		
+		// Upload the base level into storage allocated for a full mip chain, then generate the remaining levels on the GPU
+		texture = new gl::texture_2d(width, height, 0, type, format, color_space);
+		texture->update(0, 0, 0, width, height, pixels);
+		texture->generate_mipmaps();
+	}
+	else
+	{
+		texture = new gl::texture_2d(image->get_width(), image->get_height(), type, format, color_space, image->get_pixels());
+	}
 	
 	// Set wrapping and filtering
 	texture->set_wrapping(wrapping, wrapping);
 	texture->set_filters(min_filter, mag_filter);
 	texture->set_max_anisotropy(max_anisotropy);
-	
-	// Free loaded image
-	resource_manager->unload(image_filename);
 
 	return texture;
 }
+
+std::size_t resource_footprint<gl::texture_2d>::cpu_size(const gl::texture_2d& resource)
+{
+	return sizeof(gl::texture_2d);
+}
+
+std::size_t resource_footprint<gl::texture_2d>::gpu_size(const gl::texture_2d& resource)
+{
+	return resource.get_size();
+}
+
+template <>
+gl::texture_2d_array* resource_loader<gl::texture_2d_array>::load(resource_manager* resource_manager, const std::uint8_t* data, std::size_t size)
+{
+	// Parse json from file data
+	nlohmann::json json = nlohmann::json::parse(data, data + size);
+	
+	// Read image filenames, one for each layer
+	std::vector<std::string> image_filenames;
+	if (auto element = json.find("images"); element != json.end())
+		image_filenames = element.value().get<std::vector<std::string>>();
+	if (image_filenames.empty())
+		throw std::runtime_error("Texture array has no images.");
+	if (image_filenames.size() > gl::texture_2d_array::get_max_layer_count())
+		throw std::runtime_error("Texture array has more images than the maximum number of layers.");
+	
+	// Read color space, extension mode, interpolation mode, and max anisotropy
+	const auto [color_space, wrapping, min_filter, mag_filter, max_anisotropy] = read_texture_sampling(json);
+	
+	// Upload the base level of each layer, from images which are unloaded once uploaded
+	gl::texture_2d_array* texture = nullptr;
+	for (std::size_t i = 0; i < image_filenames.size(); ++i)
+	{
+		resource_ptr<::image> image = resource_manager->acquire<::image>(image_filenames[i]);
+		if (!image)
+		{
+			delete texture;
+			throw std::runtime_error("Image \"" + image_filenames[i] + "\" could not be loaded.");
+		}
+		
+		const gl::pixel_type type = (image->is_hdr()) ? gl::pixel_type::float_32 : gl::pixel_type::uint_8;
+		const gl::pixel_format format = get_image_pixel_format(*image);
+		const int width = static_cast<int>(image->get_width());
+		const int height = static_cast<int>(image->get_height());
+		
+		// Allocate every layer with the dimensions and format of the first image, which all others must match
+		if (!texture)
+		{
+			texture = new gl::texture_2d_array(width, height, image_filenames.size(), type, format, color_space);
+		}
+		else if (texture->get_dimensions()[0] != width || texture->get_dimensions()[1] != height || texture->get_pixel_type() != type || texture->get_pixel_format() != format)
+		{
+			delete texture;
+			throw std::runtime_error("Image \"" + image_filenames[i] + "\" does not match the dimensions and format of the first layer of the texture array.");
+		}
+		
+		texture->update(i, image->get_pixels());
+	}
+	
+	// Generate the remaining levels of every layer on the GPU
+	texture->generate_mipmaps();
+	
+	// Set wrapping and filtering
+	texture->set_wrapping(wrapping, wrapping);
+	texture->set_filters(min_filter, mag_filter);
+	texture->set_max_anisotropy(max_anisotropy);
+	
+	return texture;
+}
+
+std::size_t resource_footprint<gl::texture_2d_array>::cpu_size(const gl::texture_2d_array& resource)
+{
+	return sizeof(gl::texture_2d_array);
+}
+
+std::size_t resource_footprint<gl::texture_2d_array>::gpu_size(const gl::texture_2d_array& resource)
+{
+	return resource.get_size();
+}
@@ -63,7 +63,7 @@ void billboard::set_alignment_axis(const float3& axis)
 
 void billboard::transformed()
 {
-	bounds = aabb_type::transform(untransformed_bounds, get_transform());
+	bounds = aabb_type::transform(untransformed_bounds, get_world_transform());
 }
 
 void billboard::update_tweens()
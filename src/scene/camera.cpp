@@ -27,7 +27,7 @@ namespace scene {
 
 static float4x4 interpolate_view(const camera* camera, const float4x4& x, const float4x4& y, float a)
 {
-	math::transform<float> transform = camera->get_transform_tween().interpolate(a);
+	math::transform<float> transform = camera->interpolate_transform(a);
 	float3 forward = transform.rotation * global_forward;
 	float3 up = transform.rotation * global_up;
 	return math::look_at(transform.translation, transform.translation + forward, up);
@@ -35,9 +35,10 @@ static float4x4 interpolate_view(const camera* camera, const float4x4& x, const
 
 static float4x4 interpolate_projection(const camera* camera, const float4x4& x, const float4x4& y, float a)
 {
+	float4x4 projection;
 	if (camera->is_orthographic())
 	{
-		return math::ortho(
+		projection = math::ortho(
 			camera->get_clip_left_tween().interpolate(a),
 			camera->get_clip_right_tween().interpolate(a),
 			camera->get_clip_bottom_tween().interpolate(a),
@@ -47,12 +48,22 @@ static float4x4 interpolate_projection(const camera* camera, const float4x4& x,
 	}
 	else
 	{
-		return math::perspective(
+		projection = math::perspective(
 			camera->get_fov_tween().interpolate(a),
 			camera->get_aspect_ratio_tween().interpolate(a),
 			camera->get_clip_far_tween().interpolate(a),
 			camera->get_clip_near_tween().interpolate(a));
 	}
+	
+	// Translate clip space by the jitter, scaled by w so that it is constant in normalized device coordinates
+	const float2& jitter = camera->get_jitter();
+	for (int i = 0; i < 4; ++i)
+	{
+		projection[i][0] += jitter.x * projection[i][3];
+		projection[i][1] += jitter.y * projection[i][3];
+	}
+	
+	return projection;
 }
 
 static float4x4 interpolate_view_projection(const camera* camera, const float4x4& x, const float4x4& y, float a)
@@ -75,7 +86,8 @@ camera::camera():
 	view(math::identity4x4<float>, std::bind(&interpolate_view, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3)),
 	projection(math::identity4x4<float>, std::bind(&interpolate_projection, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3)),
 	view_projection(math::identity4x4<float>, std::bind(&interpolate_view_projection, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3)),
-	exposure(0.0f, math::lerp<float, float>)
+	exposure(0.0f, math::lerp<float, float>),
+	jitter{0.0f, 0.0f}
 {}
 
 float3 camera::project(const float3& object, const float4& viewport) const
@@ -121,7 +133,7 @@ void camera::set_perspective(float fov, float aspect_ratio, float clip_near, flo
 	view_projection[1] = projection[1] * view[1];
 	
 	// Recalculate view frustum
-	view_frustum.set_matrix(view_projection[1]);
+	update_view_frustum();
 }
 
 void camera::set_orthographic(float clip_left, float clip_right, float clip_bottom, float clip_top, float clip_near, float clip_far)
@@ -141,7 +153,7 @@ void camera::set_orthographic(float clip_left, float clip_right, float clip_bott
 	view_projection[1] = projection[1] * view[1];
 	
 	// Recalculate view frustum
-	view_frustum.set_matrix(view_projection[1]);
+	update_view_frustum();
 }
 
 void camera::set_exposure(float exposure)
@@ -149,6 +161,11 @@ void camera::set_exposure(float exposure)
 	this->exposure[1] = exposure;
 }
 
+void camera::set_jitter(const float2& jitter)
+{
+	this->jitter = jitter;
+}
+
 void camera::set_compositor(::compositor* compositor)
 {
 	this->compositor = compositor;
@@ -185,7 +202,23 @@ void camera::transformed()
 	view_projection[1] = projection[1] * view[1];
 	
 	// Recalculate view frustum
-	view_frustum.set_matrix(view_projection[1]);
+	update_view_frustum();
+}
+
+void camera::update_view_frustum()
+{
+	const origin_type& origin = get_origin();
+	if (origin.x == 0.0 && origin.y == 0.0 && origin.z == 0.0)
+	{
+		view_frustum.set_matrix(view_projection[1]);
+		return;
+	}
+	
+	// The view matrices are relative to the camera's origin, but the view frustum must be in world space for culling
+	const float3 translation = get_world_transform().translation;
+	const float3 forward = get_rotation() * global_forward;
+	const float3 up = get_rotation() * global_up;
+	view_frustum.set_matrix(projection[1] * math::look_at(translation, translation + forward, up));
 }
 
 } // namespace scene
@@ -21,6 +21,7 @@
 #define ANTKEEPER_SCENE_CAMERA_HPP
 
 #include "scene/object.hpp"
+#include "animation/tween.hpp"
 #include "geom/view-frustum.hpp"
 #include "utility/fundamental-types.hpp"
 
@@ -84,6 +85,13 @@ public:
 	 * @param exposure Exposure factor.
 	 */
 	void set_exposure(float exposure);
+	
+	/**
+	 * Offsets the projection by which the camera is rendered by a subpixel amount, so that successive frames sample different points of each pixel. The projection of the camera's view frustum, and of project() and unproject(), is not offset.
+	 *
+	 * @param jitter Offset of the projection, in normalized device coordinates.
+	 */
+	void set_jitter(const float2& jitter);
 
 	void set_compositor(compositor* compositor);
 	void set_composite_index(int index);
@@ -101,7 +109,7 @@ public:
 	float get_fov() const;
 	float get_aspect_ratio() const;
 
-	/// Returns the camera's view matrix.
+	/// Returns the camera's view matrix, relative to the camera's origin.
 	const float4x4& get_view() const;
 
 	/// Returns the camera's projection matrix.
@@ -110,11 +118,14 @@ public:
 	/// Returns the camera's view-projection matrix.
 	const float4x4& get_view_projection() const;
 	
-	/// Returns the camera's view frustum.
+	/// Returns the camera's view frustum, in world space.
 	const view_frustum_type& get_view_frustum() const;
 	
 	/// Returns the camera's exposure.
 	float get_exposure() const;
+	
+	/// Returns the offset of the camera's projection, in normalized device coordinates.
+	const float2& get_jitter() const;
 
 	const compositor* get_compositor() const;
 	compositor* get_compositor();
@@ -138,6 +149,9 @@ public:
 
 private:
 	virtual void transformed();
+	
+	/// Recalculates the world-space view frustum.
+	void update_view_frustum();
 
 	compositor* compositor;
 	int composite_index;
@@ -154,6 +168,7 @@ private:
 	tween<float4x4> projection;
 	tween<float4x4> view_projection;
 	tween<float> exposure;
+	float2 jitter;
 	view_frustum_type view_frustum;
 };
 
@@ -233,6 +248,11 @@ inline float camera::get_exposure() const
 }
 
 
+inline const float2& camera::get_jitter() const
+{
+	return jitter;
+}
+
 inline const compositor* camera::get_compositor() const
 {
 	return compositor;
@@ -19,25 +19,63 @@
 
 #include "scene/collection.hpp"
 #include "scene/object.hpp"
+#include "geom/sphere.hpp"
+#include <algorithm>
+#include <cmath>
 
 namespace scene {
 
+collection::~collection()
+{
+	remove_objects();
+}
+
 void collection::add_object(object_base* object)
 {
+	const std::size_t type_id = object->get_object_type_id();
+	std::vector<object_base*>& type_objects = object_map[type_id];
+	
+	object_entry entry;
+	entry.owner = this;
+	entry.type_id = type_id;
+	entry.index = objects.size();
+	entry.type_index = type_objects.size();
+	entry.proxy = tree_type::null_proxy;
+	
 	objects.push_back(object);
-	object_map[object->get_object_type_id()].push_back(object);
+	type_objects.push_back(object);
+	object->collection_entries.push_back(entry);
+	
+	if (spatially_indexed)
+		index_object(object, object->collection_entries.back());
 }
 
 void collection::remove_object(object_base* object)
 {
-	objects.remove(object);
-	object_map[object->get_object_type_id()].remove(object);
+	detach_object(object);
+}
+
+bool collection::contains(const object_base* object) const
+{
+	const std::vector<object_entry>& entries = object->collection_entries;
+	return std::find_if(entries.begin(), entries.end(), [this](const object_entry& entry){return entry.owner == this;}) != entries.end();
 }
 
 void collection::remove_objects()
 {
+	for (object_base* object: objects)
+	{
+		std::vector<object_entry>& entries = object->collection_entries;
+		entries.erase(std::find_if(entries.begin(), entries.end(), [this](const object_entry& entry){return entry.owner == this;}));
+	}
+	
 	objects.clear();
 	object_map.clear();
+	for (auto& index: spatial_indices)
+	{
+		index.second.tree.clear();
+		index.second.unbounded_objects.clear();
+	}
 }
 
 void collection::update_tweens()
@@ -48,4 +86,142 @@ void collection::update_tweens()
 	}
 }
 
+void collection::set_spatial_indexing(bool enabled)
+{
+	if (enabled == spatially_indexed)
+		return;
+	
+	spatially_indexed = enabled;
+	if (enabled)
+	{
+		for (object_base* object: objects)
+			index_object(object, *find_entry(object));
+	}
+	else
+	{
+		spatial_indices.clear();
+		for (object_base* object: objects)
+			find_entry(object)->proxy = tree_type::null_proxy;
+	}
+}
+
+bool collection::get_index_bounds(const object_base& object, geom::aabb<float>& bounds)
+{
+	const geom::bounding_volume<float>* volume = object.get_culling_mask();
+	if (!volume)
+		volume = &object.get_bounds();
+	
+	switch (volume->get_bounding_volume_type())
+	{
+		case geom::bounding_volume_type::aabb:
+			bounds = static_cast<const geom::aabb<float>&>(*volume);
+			break;
+		
+		case geom::bounding_volume_type::sphere:
+		{
+			const geom::sphere<float>& sphere = static_cast<const geom::sphere<float>&>(*volume);
+			const float3 radius = {sphere.radius, sphere.radius, sphere.radius};
+			bounds = {sphere.center - radius, sphere.center + radius};
+			break;
+		}
+		
+		default:
+			return false;
+	}
+	
+	for (int i = 0; i < 3; ++i)
+		if (!std::isfinite(bounds.min_point[i]) || !std::isfinite(bounds.max_point[i]))
+			return false;
+	
+	return true;
+}
+
+void collection::index_object(object_base* object, object_entry& entry)
+{
+	spatial_index& index = spatial_indices[entry.type_id];
+	
+	geom::aabb<float> bounds;
+	if (get_index_bounds(*object, bounds))
+		entry.proxy = index.tree.insert(bounds, object);
+	else
+		index.unbounded_objects.push_back(object);
+}
+
+void collection::unindex_object(object_base* object, object_entry& entry)
+{
+	spatial_index& index = spatial_indices[entry.type_id];
+	
+	if (entry.proxy != tree_type::null_proxy)
+	{
+		index.tree.remove(entry.proxy);
+		entry.proxy = tree_type::null_proxy;
+	}
+	else
+	{
+		std::vector<object_base*>& unbounded_objects = index.unbounded_objects;
+		if (auto it = std::find(unbounded_objects.begin(), unbounded_objects.end(), object); it != unbounded_objects.end())
+		{
+			*it = unbounded_objects.back();
+			unbounded_objects.pop_back();
+		}
+	}
+}
+
+void collection::update_object(object_base* object, object_entry& entry)
+{
+	if (!spatially_indexed)
+		return;
+	
+	geom::aabb<float> bounds;
+	const bool bounded = get_index_bounds(*object, bounds);
+	if (bounded && entry.proxy != tree_type::null_proxy)
+	{
+		spatial_indices[entry.type_id].tree.update(entry.proxy, bounds);
+	}
+	else if (bounded || entry.proxy != tree_type::null_proxy)
+	{
+		// Object gained or lost finite bounds
+		unindex_object(object, entry);
+		index_object(object, entry);
+	}
+}
+
+void collection::detach_object(object_base* object)
+{
+	object_entry* entry = find_entry(object);
+	if (!entry)
+		return;
+	
+	if (spatially_indexed)
+		unindex_object(object, *entry);
+	
+	// Move the last object into the place of the removed object
+	if (object_base* last = objects.back(); last != object)
+	{
+		objects[entry->index] = last;
+		find_entry(last)->index = entry->index;
+	}
+	objects.pop_back();
+	
+	std::vector<object_base*>& type_objects = object_map[entry->type_id];
+	if (object_base* last = type_objects.back(); last != object)
+	{
+		type_objects[entry->type_index] = last;
+		find_entry(last)->type_index = entry->type_index;
+	}
+	type_objects.pop_back();
+	
+	std::vector<object_entry>& entries = object->collection_entries;
+	*entry = entries.back();
+	entries.pop_back();
+}
+
+collection::object_entry* collection::find_entry(object_base* object) const
+{
+	for (object_entry& entry: object->collection_entries)
+		if (entry.owner == this)
+			return &entry;
+	return nullptr;
+}
+
 } // namespace scene
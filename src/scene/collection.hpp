@@ -20,63 +20,192 @@
 #ifndef ANTKEEPER_SCENE_COLLECTION_HPP
 #define ANTKEEPER_SCENE_COLLECTION_HPP
 
-#include <list>
+#include "geom/aabb-tree.hpp"
+#include "geom/convex-hull.hpp"
+#include "geom/packed-hull.hpp"
+#include "scene/object.hpp"
 #include <unordered_map>
+#include <vector>
 
 namespace scene {
 
-class object_base;
-
 /**
  * Collection of scene objects.
+ *
+ * Objects are stored densely, both in a list of all objects and in a list per object type. Each object records its position in the lists of the collections which contain it, so that it can be removed in constant time by moving the last object of each list into its place. Removal therefore does not preserve the order in which objects were added.
+ *
+ * A collection can optionally maintain a spatial index of its objects, which consists of a dynamic AABB tree per object type. The index is updated as objects are added, removed, transformed, or otherwise change their bounds, and allows objects to be queried by volume at a cost which scales with the number of objects found rather than the number of objects in the collection.
  */
 class collection
 {
 public:
+	/// Destroys a collection, removing all objects from it.
+	~collection();
+	
 	/**
-	 * Adds an object to the collection.
+	 * Adds an object to the collection. An object should be added to a collection at most once.
 	 *
 	 * @param object Object to add.
 	 */
 	void add_object(object_base* object);
 	
 	/**
-	 * Removes an object from the collection.
+	 * Removes an object from the collection. Does nothing if the collection does not contain the object.
 	 *
 	 * @param object Object to remove.
 	 */
 	void remove_object(object_base* object);
 	
+	/**
+	 * Returns `true` if the collection contains an object.
+	 *
+	 * @param object Scene object.
+	 */
+	bool contains(const object_base* object) const;
+	
 	/// Removes all objects from the collection.
 	void remove_objects();
 	
 	/// Updates the tweens of all objects in the collection.
 	void update_tweens();
+	
+	/**
+	 * Enables or disables the spatial index of the collection.
+	 *
+	 * @param enabled `true` if the collection should maintain a spatial index, `false` otherwise.
+	 */
+	void set_spatial_indexing(bool enabled);
+	
+	/// Returns `true` if the collection maintains a spatial index.
+	bool is_spatially_indexed() const;
+	
+	/**
+	 * Calls a function with each object whose bounds may intersect a convex volume. Objects without finite bounds, such as cameras and ambient lights, are always included. Requires the spatial index.
+	 *
+	 * @param volume Query volume.
+	 * @param function Function with the signature `void(object_base*)`.
+	 */
+	template <class Function>
+	void query(const geom::convex_hull<float>& volume, Function&& function) const;
+	
+	/**
+	 * Calls a function with each object of a type whose bounds may intersect a convex volume. Objects without finite bounds are always included. Requires the spatial index.
+	 *
+	 * @param type_id Scene object type ID.
+	 * @param volume Query volume.
+	 * @param function Function with the signature `void(object_base*)`.
+	 */
+	template <class Function>
+	void query(std::size_t type_id, const geom::convex_hull<float>& volume, Function&& function) const;
+	
+	/**
+	 * Calls a function with each object whose bounds may intersect a packed convex volume, as query(const geom::convex_hull<float>&, Function&&) but without repacking the planes of the volume.
+	 *
+	 * @param volume Query volume.
+	 * @param function Function with the signature `void(object_base*)`.
+	 */
+	template <class Function>
+	void query(const geom::packed_hull<float>& volume, Function&& function) const;
 
 	/// Returns a list of all objects in the collection.
-	const std::list<object_base*>* get_objects() const;
+	const std::vector<object_base*>* get_objects() const;
 	
 	/**
 	 * Returns a list of all objects in the collection with the specified type ID.
 	 *
 	 * @param type_id Scene object type ID.
-	 * @return List of scene objects with the specified type ID.
+	 * @return List of scene objects with the specified type ID, which is empty if the collection contains no objects of the type.
 	 */
-	const std::list<object_base*>* get_objects(std::size_t type_id) const;
+	const std::vector<object_base*>* get_objects(std::size_t type_id) const;
 
 private:
-	std::list<object_base*> objects;
-	mutable std::unordered_map<std::size_t, std::list<object_base*>> object_map;
+	friend class object_base;
+	
+	typedef geom::aabb_tree<object_base*> tree_type;
+	typedef object_base::collection_entry object_entry;
+	
+	/// Spatial index of the objects of a single type.
+	struct spatial_index
+	{
+		tree_type tree;
+		std::vector<object_base*> unbounded_objects;
+	};
+	
+	/**
+	 * Returns the bounds by which an object is indexed, given by its culling mask or its bounds.
+	 *
+	 * @param object Scene object.
+	 * @param[out] bounds Axis-aligned bounds of the object.
+	 * @return `true` if the object has finite bounds, `false` otherwise.
+	 */
+	static bool get_index_bounds(const object_base& object, geom::aabb<float>& bounds);
+	
+	/// Inserts an object into the spatial index.
+	void index_object(object_base* object, object_entry& entry);
+	
+	/// Removes an object from the spatial index.
+	void unindex_object(object_base* object, object_entry& entry);
+	
+	/// Updates the bounds of an object in the spatial index.
+	void update_object(object_base* object, object_entry& entry);
+	
+	/// Removes an object without calling its virtual functions, so that objects can remove themselves while being destroyed.
+	void detach_object(object_base* object);
+	
+	/// Returns the entry of an object for this collection, or `nullptr` if the collection does not contain the object.
+	object_entry* find_entry(object_base* object) const;
+	
+	std::vector<object_base*> objects;
+	std::unordered_map<std::size_t, std::vector<object_base*>> object_map;
+	std::unordered_map<std::size_t, spatial_index> spatial_indices;
+	bool spatially_indexed{false};
 };
 
-inline const std::list<object_base*>* collection::get_objects() const
+template <class Function>
+void collection::query(const geom::convex_hull<float>& volume, Function&& function) const
+{
+	query(geom::packed_hull<float>(volume), function);
+}
+
+template <class Function>
+void collection::query(const geom::packed_hull<float>& volume, Function&& function) const
+{
+	for (const auto& index: spatial_indices)
+	{
+		for (object_base* object: index.second.unbounded_objects)
+			function(object);
+		index.second.tree.query(volume, function);
+	}
+}
+
+template <class Function>
+void collection::query(std::size_t type_id, const geom::convex_hull<float>& volume, Function&& function) const
+{
+	if (auto it = spatial_indices.find(type_id); it != spatial_indices.end())
+	{
+		for (object_base* object: it->second.unbounded_objects)
+			function(object);
+		it->second.tree.query(volume, function);
+	}
+}
+
+inline bool collection::is_spatially_indexed() const
+{
+	return spatially_indexed;
+}
+
+inline const std::vector<object_base*>* collection::get_objects() const
 {
 	return &objects;
 }
 
-inline const std::list<object_base*>* collection::get_objects(std::size_t type_id) const
+inline const std::vector<object_base*>* collection::get_objects(std::size_t type_id) const
 {
-	return &object_map[type_id];
+	static const std::vector<object_base*> empty;
+	
+	if (auto it = object_map.find(type_id); it != object_map.end())
+		return &it->second;
+	return &empty;
 }
 
 } // namespace scene
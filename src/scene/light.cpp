@@ -19,11 +19,13 @@
 
 #include "scene/light.hpp"
 #include "math/interpolation.hpp"
+#include <cmath>
+#include <limits>
 
 namespace scene {
 
 light::light():
-	bounds(get_translation(), 0.0f),
+	bounds(get_translation(), std::numeric_limits<float>::infinity()),
 	color(float3{1.0f, 1.0f, 1.0f}, math::lerp<float3, float>),
 	intensity(1.0f, math::lerp<float, float>),
 	scaled_color(float3{1.0f, 1.0f, 1.0f}, math::lerp<float3, float>)
@@ -49,9 +51,40 @@ void light::update_tweens()
 	scaled_color.update();
 }
 
+float light::attenuation_range(const float3& attenuation, float threshold)
+{
+	// Find distance at which 1 / (c + l * d + q * d^2) falls to the attenuation threshold
+	const float c = attenuation[0] - 1.0f / threshold;
+	const float l = attenuation[1];
+	const float q = attenuation[2];
+	
+	if (c >= 0.0f)
+	{
+		// Light never reaches the threshold
+		return 0.0f;
+	}
+	else if (q > 0.0f)
+	{
+		return (-l + std::sqrt(l * l - 4.0f * q * c)) / (2.0f * q);
+	}
+	else if (l > 0.0f)
+	{
+		return -c / l;
+	}
+	
+	// Light is never attenuated
+	return std::numeric_limits<float>::infinity();
+}
+
+void light::set_bounds_radius(float radius)
+{
+	bounds.radius = radius;
+	bounds_changed();
+}
+
 void light::transformed()
 {
-	bounds = sphere_type(get_translation(), 0.0f);
+	bounds.center = get_world_transform().translation;
 }
 
 } // namespace scene
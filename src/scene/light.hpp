@@ -21,6 +21,7 @@
 #define ANTKEEPER_SCENE_LIGHT_HPP
 
 #include "scene/object.hpp"
+#include "animation/tween.hpp"
 #include "geom/sphere.hpp"
 #include "utility/fundamental-types.hpp"
 
@@ -70,7 +71,7 @@ public:
 	 */
 	void set_intensity(float intensity);
 	
-	/// Returns the bounding volume of the light.
+	/// Returns the bounding volume of the light, a sphere beyond which the light has no influence.
 	virtual const bounding_volume_type& get_bounds() const;
 	
 	/// Returns the light color.
@@ -88,10 +89,31 @@ public:
 
 	/// @copydoc object_base::update_tweens();
 	virtual void update_tweens();
+	
+	/// Attenuation below which lights are considered to have no influence, by which the bounds of attenuated lights are calculated.
+	static constexpr float attenuation_threshold = 1.0f / 256.0f;
+	
+	/**
+	 * Calculates the distance at which an attenuated light falls to an attenuation threshold.
+	 *
+	 * @param attenuation Constant, linear, and quadratic attenuation factors.
+	 * @param threshold Attenuation threshold, on `(0, 1)`.
+	 * @return Distance at which the light reaches the threshold, zero if the light never reaches it, or infinity if the light is never attenuated to it.
+	 */
+	static float attenuation_range(const float3& attenuation, float threshold);
 
-private:
-	virtual void transformed();
+protected:
+	/**
+	 * Sets the radius of the bounding sphere of the light. Lights have infinite radii by default.
+	 *
+	 * @param radius Distance beyond which the light has no influence.
+	 */
+	void set_bounds_radius(float radius);
 	
+	virtual void transformed();
+
+private:
+
 	tween<float3> color;
 	tween<float> intensity;
 	tween<float3> scaled_color;
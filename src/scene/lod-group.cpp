@@ -19,11 +19,17 @@
 
 #include "scene/lod-group.hpp"
 #include "scene/camera.hpp"
+#include "math/math.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
 
 namespace scene {
 
 lod_group::lod_group(std::size_t level_count):
-	bounds(get_translation(), get_translation())
+	bounds(get_translation(), get_translation()),
+	radius(0.0f),
+	hysteresis(0.1f)
 {
 	resize(level_count);
 }
@@ -37,18 +43,67 @@ void lod_group::resize(std::size_t level_count)
 	levels.resize(level_count);
 }
 
-std::size_t lod_group::select_lod(const camera& camera) const
+void lod_group::set_radius(float radius)
+{
+	this->radius = radius;
+	update_bounds();
+}
+
+void lod_group::set_thresholds(const std::vector<float>& thresholds)
+{
+	this->thresholds = thresholds;
+}
+
+void lod_group::set_hysteresis(float hysteresis)
+{
+	this->hysteresis = hysteresis;
+}
+
+float lod_group::projected_size(const camera& camera) const
 {
-	float distance = camera.get_view_frustum().get_near().signed_distance(get_translation());
+	if (camera.is_orthographic())
+		return (radius * 2.0f) / std::abs(camera.get_clip_top() - camera.get_clip_bottom());
+	
+	// Diameter relative to the height of the view frustum at the distance of the sphere
+	const float distance = static_cast<float>(math::length(get_world_translation() - camera.get_world_translation()));
+	if (distance <= radius)
+		return std::numeric_limits<float>::infinity();
 	
-	if (distance < 300.0f)
+	return radius / (distance * std::tan(camera.get_fov() * 0.5f));
+}
+
+std::size_t lod_group::select_lod(const camera& camera) const
+{
+	const std::size_t coarsest_level = (levels.empty()) ? 0 : levels.size() - 1;
+	if (thresholds.empty())
 		return 0;
-	else if (distance < 500.0f)
-		return 1;
-	else if (distance < 600.0f)
-		return 2;
 	
-	return 3;
+	// Find the level previously selected for the camera
+	std::lock_guard<std::mutex> lock(selection_mutex);
+	auto selection = std::find_if(selections.begin(), selections.end(), [&camera](const auto& entry){return entry.first == &camera;});
+	if (selection == selections.end())
+	{
+		selections.emplace_back(&camera, coarsest_level);
+		selection = selections.end() - 1;
+	}
+	const std::size_t previous_level = selection->second;
+	
+	// Select the finest level whose threshold is met, widening thresholds around the previous level
+	const float size = projected_size(camera);
+	const std::size_t threshold_count = std::min(thresholds.size(), coarsest_level);
+	std::size_t level = threshold_count;
+	for (std::size_t i = 0; i < threshold_count; ++i)
+	{
+		const float threshold = thresholds[i] * ((i < previous_level) ? 1.0f + hysteresis : 1.0f - hysteresis);
+		if (size >= threshold)
+		{
+			level = i;
+			break;
+		}
+	}
+	
+	selection->second = level;
+	return level;
 }
 
 void lod_group::add_object(std::size_t level, object_base* object)
@@ -68,7 +123,9 @@ void lod_group::remove_objects(std::size_t level)
 
 void lod_group::update_bounds()
 {
-	bounds = {get_translation(), get_translation()};
+	const float3 extents = {radius, radius, radius};
+	const float3 translation = get_world_transform().translation;
+	bounds = {translation - extents, translation + extents};
 }
 
 void lod_group::transformed()
@@ -22,13 +22,21 @@
 
 #include "scene/object.hpp"
 #include "geom/aabb.hpp"
+#include <cstddef>
 #include <list>
+#include <mutex>
+#include <utility>
 #include <vector>
 
 namespace scene {
 
 class camera;
 
+/**
+ * Group of objects with several levels of detail, of which one is rendered per camera.
+ *
+ * Levels are selected by the projected size of the group's bounding sphere, as a fraction of the viewport height, so that detail is independent of both distance and field of view. Each level but the coarsest has a threshold, at or above which it is selected. Thresholds are widened by a hysteresis band around the level last selected for each camera, so that groups near a threshold don't switch levels back and forth.
+ */
 class lod_group: public object<lod_group>
 {
 public:
@@ -52,7 +60,36 @@ public:
 	void resize(std::size_t level_count);
 	
 	/**
-	 * Selects the appropriate level of detail for a camera.
+	 * Sets the radius of the group's bounding sphere, centered on its translation, from which its projected size is calculated. The bounds of the group span the sphere.
+	 *
+	 * @param radius Bounding sphere radius.
+	 */
+	void set_radius(float radius);
+	
+	/**
+	 * Sets the projected size thresholds of the levels of detail.
+	 *
+	 * @param thresholds Minimum projected sizes of levels `0` to `n - 2`, as fractions of the viewport height, in descending order. Without thresholds, the finest level is always selected.
+	 */
+	void set_thresholds(const std::vector<float>& thresholds);
+	
+	/**
+	 * Sets the LOD hysteresis. A level finer than the level last selected for a camera must be exceeded by its threshold times `1 + hysteresis`, while a coarser level is selected only once the threshold of the current level is undercut by a factor of `1 - hysteresis`.
+	 *
+	 * @param hysteresis Fraction of each threshold, on `[0, 1)`.
+	 */
+	void set_hysteresis(float hysteresis);
+	
+	/**
+	 * Returns the projected size of the group's bounding sphere as seen by a camera.
+	 *
+	 * @param camera Camera from which the group is seen.
+	 * @return Projected diameter of the bounding sphere, as a fraction of the viewport height.
+	 */
+	float projected_size(const camera& camera) const;
+	
+	/**
+	 * Selects the level of detail for a camera, given the level previously selected for it, and records the selection.
 	 *
 	 * @param camera Camera for which the LOD should be selected.
 	 * @return Selected level of detail.
@@ -84,6 +121,9 @@ public:
 	
 	virtual const bounding_volume_type& get_bounds() const;
 	
+	/// Returns the radius of the group's bounding sphere.
+	float get_radius() const;
+	
 	/// Returns the number of detail levels in the group.
 	std::size_t get_level_count() const;
 	
@@ -100,7 +140,14 @@ private:
 	virtual void transformed();
 	
 	aabb_type bounds;
+	float radius;
+	std::vector<float> thresholds;
+	float hysteresis;
 	std::vector<std::list<object_base*>> levels;
+	
+	/// Level of detail last selected for each camera. Guarded by a mutex, as the renderer may select levels for different cameras concurrently.
+	mutable std::vector<std::pair<const camera*, std::size_t>> selections;
+	mutable std::mutex selection_mutex;
 };
 
 inline const typename object_base::bounding_volume_type& lod_group::get_bounds() const
@@ -108,6 +155,11 @@ inline const typename object_base::bounding_volume_type& lod_group::get_bounds()
 	return bounds;
 }
 
+inline float lod_group::get_radius() const
+{
+	return radius;
+}
+
 inline std::size_t lod_group::get_level_count() const
 {
 	return levels.size();
@@ -20,15 +20,22 @@
 #include "scene/model-instance.hpp"
 #include "renderer/model.hpp"
 #include "renderer/material.hpp"
+#include <atomic>
 
 namespace scene {
 
+/// Source of model instance revisions, which are unique so that a new model instance never matches operations retained for a destroyed one.
+static std::atomic<std::uint64_t> next_revision(1);
+
 model_instance::model_instance(::model* model):
 	model(nullptr),
 	pose(nullptr),
 	bounds(get_translation(), get_translation()),
 	instanced(false),
-	instance_count(0)
+	instance_count(0),
+	pick_id(0),
+	static_instance(false),
+	revision(0)
 {
 	set_model(model);
 	update_bounds();
@@ -51,6 +58,9 @@ model_instance& model_instance::operator=(const model_instance& other)
 	materials = other.materials;
 	instanced = other.instanced;
 	instance_count = other.instance_count;
+	pick_id = other.pick_id;
+	static_instance = other.static_instance;
+	revise();
 	return *this;
 }
 
@@ -71,30 +81,54 @@ void model_instance::set_model(::model* model)
 void model_instance::set_pose(::pose* pose)
 {
 	this->pose = pose;
+	revise();
 }
 
 void model_instance::set_material(std::size_t group_index, material* material)
 {
 	materials[group_index] = material;
+	revise();
 }
 
 void model_instance::set_instanced(bool instanced, std::size_t instance_count)
 {
 	this->instanced = instanced;
 	this->instance_count = (instanced) ? instance_count : 0;
+	revise();
+}
+
+void model_instance::set_pick_id(std::uint32_t id)
+{
+	pick_id = id;
+	revise();
 }
 
 void model_instance::reset_materials()
 {
 	std::fill(materials.begin(), materials.end(), nullptr);
+	revise();
+}
+
+void model_instance::set_static(bool value)
+{
+	static_instance = value;
+	revise();
 }
 
 void model_instance::update_bounds()
 {
 	if (model)
-		bounds = aabb_type::transform(model->get_bounds(), get_transform());
+	{
+		bounds = aabb_type::transform(model->get_bounds(), get_world_transform());
+	}
 	else
-		bounds = {get_translation(), get_translation()};
+	{
+		const vector_type translation = get_world_transform().translation;
+		bounds = {translation, translation};
+	}
+	
+	revise();
+	bounds_changed();
 }
 
 void model_instance::transformed()
@@ -102,6 +136,11 @@ void model_instance::transformed()
 	update_bounds();
 }
 
+void model_instance::revise()
+{
+	revision = next_revision.fetch_add(1, std::memory_order_relaxed);
+}
+
 void model_instance::update_tweens()
 {
 	object_base::update_tweens();
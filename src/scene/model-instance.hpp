@@ -22,6 +22,7 @@
 
 #include "scene/object.hpp"
 #include "geom/aabb.hpp"
+#include <cstdint>
 #include <vector>
 
 class material;
@@ -59,12 +60,28 @@ public:
 	void set_material(std::size_t group_index, material* material);
 	
 	void set_instanced(bool instanced, std::size_t instance_count = 1);
+	
+	/**
+	 * Sets the ID which the picking pass writes for this model instance.
+	 *
+	 * @param id Pick ID, or `0` if the model instance should not be pickable.
+	 */
+	void set_pick_id(std::uint32_t id);
 
 	/**
 	 * Resets all overwritten materials.
 	 */
 	void reset_materials();
 	
+	/**
+	 * Flags the model instance as static, in which case the renderer retains its render operations across frames and regenerates them only when the model instance changes. Posed model instances are never retained.
+	 *
+	 * Changes to the model instance, such as its transform, model, or materials, are detected by its revision. Changes made in place to the groups of its model are not, so the model of a static model instance should not be modified, or update_bounds() should be called after modifying it.
+	 *
+	 * @param value `true` if the model instance is static, `false` otherwise.
+	 */
+	void set_static(bool value);
+	
 	virtual const bounding_volume_type& get_bounds() const;
 
 	const model* get_model() const;
@@ -77,6 +94,11 @@ public:
 	
 	bool is_instanced() const;
 	std::size_t get_instance_count() const;
+	std::uint32_t get_pick_id() const;
+	bool is_static() const;
+	
+	/// Returns a number which changes whenever the model instance changes in a way that affects its render operations, and is unique among all model instances.
+	std::uint64_t get_revision() const;
 	
 	virtual void update_tweens();
 	
@@ -85,12 +107,18 @@ public:
 private:
 	virtual void transformed();
 	
+	/// Assigns the model instance a new revision.
+	void revise();
+	
 	model* model;
 	pose* pose;
 	std::vector<material*> materials;
 	aabb_type bounds;
 	bool instanced;
 	std::size_t instance_count;
+	std::uint32_t pick_id;
+	bool static_instance;
+	std::uint64_t revision;
 };
 
 inline const typename object_base::bounding_volume_type& model_instance::get_bounds() const
@@ -133,6 +161,21 @@ inline std::size_t model_instance::get_instance_count() const
 	return instance_count;
 }
 
+inline std::uint32_t model_instance::get_pick_id() const
+{
+	return pick_id;
+}
+
+inline bool model_instance::is_static() const
+{
+	return static_instance;
+}
+
+inline std::uint64_t model_instance::get_revision() const
+{
+	return revision;
+}
+
 } // namespace scene
 
 #endif // ANTKEEPER_SCENE_MODEL_INSTANCE_HPP
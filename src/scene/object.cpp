@@ -18,29 +18,36 @@
  */
 
 #include "scene/object.hpp"
+#include "scene/collection.hpp"
 #include "math/math.hpp"
 
 namespace scene {
 
-typename object_base::transform_type object_base::interpolate_transforms(const transform_type& x, const transform_type& y, float a)
-{
-	return
-		{
-			math::lerp(x.translation, y.translation, a),
-			math::nlerp(x.rotation, y.rotation, a),
-			math::lerp(x.scale, y.scale, a),
-		};
-}
-
 object_base::object_base():
 	active(true),
-	transform(math::identity_transform<float>, interpolate_transforms),
+	transform_index(get_transform_store().allocate(math::identity_transform<float>)),
 	culling_mask(nullptr)
 {}
 
+object_base::~object_base()
+{
+	// Remove the object from all collections which still contain it
+	while (!collection_entries.empty())
+		collection_entries.back().owner->detach_object(this);
+	
+	get_transform_store().release(transform_index);
+}
+
 void object_base::set_culling_mask(const bounding_volume_type* culling_mask)
 {
 	this->culling_mask = culling_mask;
+	bounds_changed();
+}
+
+void object_base::bounds_changed()
+{
+	for (collection_entry& entry: collection_entries)
+		entry.owner->update_object(this, entry);
 }
 
 std::size_t object_base::next_object_type_id()
@@ -49,16 +56,25 @@ std::size_t object_base::next_object_type_id()
 	return id++;
 }
 
+transform_store& object_base::get_transform_store()
+{
+	// Never destroyed, so that scene objects may outlive static destruction
+	static transform_store* store = new transform_store();
+	return *store;
+}
+
 void object_base::update_tweens()
 {
-	transform.update();
+	get_transform_store().snap(transform_index);
 }
 
 void object_base::look_at(const vector_type& position, const vector_type& target, const vector_type& up)
 {
-	transform[1].translation = position;
-	transform[1].rotation = math::look_rotation(math::normalize(math::sub(target, position)), up);
+	transform_type& transform = get_transform_store().modify(transform_index);
+	transform.translation = position;
+	transform.rotation = math::look_rotation(math::normalize(math::sub(target, position)), up);
 	transformed();
+	bounds_changed();
 }
 
 void object_base::transformed()
@@ -20,16 +20,21 @@
 #ifndef ANTKEEPER_SCENE_OBJECT_HPP
 #define ANTKEEPER_SCENE_OBJECT_HPP
 
-#include "animation/tween.hpp"
 #include "geom/bounding-volume.hpp"
+#include "scene/transform-store.hpp"
 #include "math/vector-type.hpp"
+#include "math/vector-operators.hpp"
 #include "math/quaternion-type.hpp"
 #include "math/transform-type.hpp"
 #include <atomic>
+#include <cstdint>
 #include <cstdlib>
+#include <vector>
 
 namespace scene {
 
+class collection;
+
 /**
  * Internal base class for scene objects.
  */
@@ -39,6 +44,7 @@ public:
 	typedef math::vector<float, 3> vector_type;
 	typedef math::quaternion<float> quaternion_type;
 	typedef math::transform<float> transform_type;
+	typedef math::vector<double, 3> origin_type;
 	typedef geom::bounding_volume<float> bounding_volume_type;
 	
 	/// Returns the type ID for this scene object type.
@@ -52,10 +58,13 @@ public:
 	/**
 	 * Destroys a scene object base.
 	 */
-	virtual ~object_base() = default;
+	virtual ~object_base();
+	
+	object_base(const object_base&) = delete;
+	object_base& operator=(const object_base&) = delete;
 
 	/**
-	 * Updates all tweens in the scene object.
+	 * Updates all tweens in the scene object, and snaps its transform so that it will not be interpolated until it is next changed.
 	 */
 	virtual void update_tweens();
 	
@@ -90,7 +99,16 @@ public:
 	void set_scale(const vector_type& scale);
 	
 	/**
-	 * Sets a culling mask for the object, which will be used for view-frustum culling instead of the object's bounds.
+	 * Sets the double-precision origin of the scene object, relative to which its transform is expressed.
+	 *
+	 * Objects far from the world origin, such as terrain patches, should be given an origin near them, so that their transforms and model geometry remain small enough to be represented precisely in single precision. Bounds are expressed in world space, and are only as precise as single precision allows. The renderer subtracts the origin of the camera from the origin of each object in double precision, so objects are drawn relative to the camera without moving them as the camera moves.
+	 *
+	 * @param origin World-space origin of the object.
+	 */
+	void set_origin(const origin_type& origin);
+	
+	/**
+	 * Sets a culling mask for the object, which will be used for view-frustum culling and spatial indexing instead of the object's bounds.
 	 */
 	void set_culling_mask(const bounding_volume_type* culling_mask);
 	
@@ -117,11 +135,36 @@ public:
 	 */
 	const vector_type& get_scale() const;
 
+	/// Returns the double-precision origin of the scene object.
+	const origin_type& get_origin() const;
+	
+	/// Returns the world-space translation of the scene object, in double precision.
+	origin_type get_world_translation() const;
+	
+	/// Returns the world-space transform of the scene object, in single precision.
+	transform_type get_world_transform() const;
+	
 	/**
-	 * Returns the transform tween.
+	 * Returns the transform interpolated between the previous and current ticks.
+	 *
+	 * @param a Interpolation factor.
 	 */
-	const tween<transform_type>& get_transform_tween() const;
-	tween<transform_type>& get_transform_tween();
+	transform_type interpolate_transform(float a) const;
+	
+	/**
+	 * Returns the interpolated transform as of the most recent call to transform_store::interpolate().
+	 */
+	const transform_type& get_interpolated_transform() const;
+	
+	/**
+	 * Returns the interpolated origin as of the most recent call to transform_store::interpolate().
+	 */
+	const origin_type& get_interpolated_origin() const;
+	
+	/**
+	 * Returns the store which holds the transforms of all scene objects.
+	 */
+	static transform_store& get_transform_store();
 
 	/**
 	 * Returns the bounds of the object.
@@ -135,10 +178,14 @@ public:
 
 protected:
 	static std::size_t next_object_type_id();
+	
+	/**
+	 * Notifies the collections which contain the object that its bounds have changed. Called after every transform change, and should be called by derived classes which change their bounds for other reasons.
+	 */
+	void bounds_changed();
 
 private:
-	/// Interpolates between two transforms.
-	static transform_type interpolate_transforms(const transform_type& x, const transform_type& y, float a);
+	friend class collection;
 	
 	/**
 	 * Called every time the scene object's tranform is changed.
@@ -146,8 +193,30 @@ private:
 	virtual void transformed();
 
 	bool active;
-	tween<transform_type> transform;
+	std::size_t transform_index;
 	const bounding_volume_type* culling_mask;
+	
+	/// Location of the object within a collection which contains it.
+	struct collection_entry
+	{
+		/// Collection which contains the object.
+		collection* owner;
+		
+		/// Type ID of the object, which must be known once the object is being destroyed.
+		std::size_t type_id;
+		
+		/// Index of the object in the collection's list of all objects.
+		std::size_t index;
+		
+		/// Index of the object in the collection's list of objects of its type.
+		std::size_t type_index;
+		
+		/// Proxy of the object in the collection's spatial index.
+		std::uint32_t proxy;
+	};
+	
+	/// Entries of the collections which contain the object.
+	std::vector<collection_entry> collection_entries;
 };
 
 inline void object_base::set_active(bool active)
@@ -157,26 +226,37 @@ inline void object_base::set_active(bool active)
 
 inline void object_base::set_transform(const transform_type& transform)
 {
-	this->transform[1] = transform;
+	get_transform_store().modify(transform_index) = transform;
 	transformed();
+	bounds_changed();
 }
 
 inline void object_base::set_translation(const vector_type& translation)
 {
-	transform[1].translation = translation;
+	get_transform_store().modify(transform_index).translation = translation;
 	transformed();
+	bounds_changed();
 }
 
 inline void object_base::set_rotation(const quaternion_type& rotation)
 {
-	transform[1].rotation = rotation;
+	get_transform_store().modify(transform_index).rotation = rotation;
 	transformed();
+	bounds_changed();
 }
 
 inline void object_base::set_scale(const vector_type& scale)
 {
-	transform[1].scale = scale;
+	get_transform_store().modify(transform_index).scale = scale;
 	transformed();
+	bounds_changed();
+}
+
+inline void object_base::set_origin(const origin_type& origin)
+{
+	get_transform_store().modify_origin(transform_index) = origin;
+	transformed();
+	bounds_changed();
 }
 
 inline bool object_base::is_active() const
@@ -186,7 +266,7 @@ inline bool object_base::is_active() const
 
 inline const typename object_base::transform_type& object_base::get_transform() const
 {
-	return transform[1];
+	return get_transform_store().get(transform_index);
 }
 
 inline const typename object_base::vector_type& object_base::get_translation() const
@@ -204,16 +284,42 @@ inline const typename object_base::vector_type& object_base::get_scale() const
 	return get_transform().scale;
 }
 
-inline const tween<typename object_base::transform_type>& object_base::get_transform_tween() const
+inline const typename object_base::origin_type& object_base::get_origin() const
 {
-	return transform;
+	return get_transform_store().get_origin(transform_index);
 }
 
-inline tween<typename object_base::transform_type>& object_base::get_transform_tween()
+inline typename object_base::origin_type object_base::get_world_translation() const
 {
+	const vector_type& translation = get_translation();
+	return get_origin() + origin_type{translation.x, translation.y, translation.z};
+}
+
+inline typename object_base::transform_type object_base::get_world_transform() const
+{
+	transform_type transform = get_transform();
+	const origin_type& origin = get_origin();
+	transform.translation.x += static_cast<float>(origin.x);
+	transform.translation.y += static_cast<float>(origin.y);
+	transform.translation.z += static_cast<float>(origin.z);
 	return transform;
 }
 
+inline typename object_base::transform_type object_base::interpolate_transform(float a) const
+{
+	return get_transform_store().interpolate(transform_index, a);
+}
+
+inline const typename object_base::transform_type& object_base::get_interpolated_transform() const
+{
+	return get_transform_store().get_interpolated(transform_index);
+}
+
+inline const typename object_base::origin_type& object_base::get_interpolated_origin() const
+{
+	return get_transform_store().get_interpolated_origin(transform_index);
+}
+
 inline const typename object_base::bounding_volume_type* object_base::get_culling_mask() const
 {
 	return culling_mask;
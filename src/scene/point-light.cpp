@@ -24,11 +24,14 @@ namespace scene {
 
 point_light::point_light():
 	attenuation(float3{1, 0, 0}, math::lerp<float3, float>)
-{}
+{
+	set_bounds_radius(attenuation_range(attenuation[1], attenuation_threshold));
+}
 
 void point_light::set_attenuation(const float3& attenuation)
 {
 	this->attenuation[1] = attenuation;
+	set_bounds_radius(attenuation_range(attenuation, attenuation_threshold));
 }
 
 void point_light::update_tweens()
@@ -34,5 +34,7 @@ namespace scene {}
 #include "object.hpp"
 #include "point-light.hpp"
 #include "spot-light.hpp"
+#include "text.hpp"
+#include "transform-store.hpp"
 
 #endif // ANTKEEPER_SCENE_HPP
@@ -36,11 +36,14 @@ spot_light::spot_light():
 	attenuation(float3{1, 0, 0}, math::lerp<float3, float>),
 	cutoff(float2{math::pi<float>, math::pi<float>}, math::lerp<float2, float>),
 	cosine_cutoff(float2{std::cos(math::pi<float>), std::cos(math::pi<float>)}, math::lerp<float2, float>)
-{}
+{
+	set_bounds_radius(attenuation_range(attenuation[1], attenuation_threshold));
+}
 
 void spot_light::set_attenuation(const float3& attenuation)
 {
 	this->attenuation[1] = attenuation;
+	set_bounds_radius(attenuation_range(attenuation, attenuation_threshold));
 }
 
 void spot_light::set_cutoff(const float2& cutoff)
@@ -60,6 +63,7 @@ void spot_light::update_tweens()
 
 void spot_light::transformed()
 {
+	light::transformed();
 	direction[1] = math::normalize(get_transform().rotation * global_forward);
 }
 
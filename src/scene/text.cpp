@@ -0,0 +1,59 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "scene/text.hpp"
+#include "renderer/material.hpp"
+
+namespace scene {
+
+text::text():
+	bounds({{0, 0, 0}, {0, 0, 0}}),
+	material(nullptr)
+{}
+
+void text::set_material(::material* material)
+{
+	this->material = material;
+}
+
+void text::set_layout(std::shared_ptr<const type::text_layout> layout)
+{
+	this->layout = std::move(layout);
+	transformed();
+}
+
+void text::transformed()
+{
+	if (layout)
+		bounds = aabb_type::transform(layout->bounds, get_world_transform());
+	else
+		bounds = aabb_type::transform({{0, 0, 0}, {0, 0, 0}}, get_world_transform());
+}
+
+void text::update_tweens()
+{
+	object_base::update_tweens();
+	if (material)
+	{
+		material->update_tweens();
+	}
+}
+
+} // namespace scene
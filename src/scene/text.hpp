@@ -0,0 +1,87 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef ANTKEEPER_SCENE_TEXT_HPP
+#define ANTKEEPER_SCENE_TEXT_HPP
+
+#include "scene/object.hpp"
+#include "geom/aabb.hpp"
+#include "type/text-layout.hpp"
+#include <memory>
+
+class material;
+
+namespace scene {
+
+/**
+ * Laid out text with one material, drawn by the UI pass.
+ *
+ * Text objects display layouts rather than strings, so unchanged labels are never laid out again, and labels which display the same string can share a layout from a type::text_cache.
+ */
+class text: public object<text>
+{
+public:
+	typedef geom::aabb<float> aabb_type;
+	
+	text();
+	
+	/// Sets the material of the text, which samples the atlas of the layout's font.
+	void set_material(material* material);
+	
+	/**
+	 * Sets the glyph quads of the text.
+	 *
+	 * @param layout Layout, which may be shared with other text objects, or `nullptr` to display nothing.
+	 */
+	void set_layout(std::shared_ptr<const type::text_layout> layout);
+	
+	virtual const bounding_volume_type& get_bounds() const;
+	
+	material* get_material() const;
+	const type::text_layout* get_layout() const;
+	
+	virtual void update_tweens();
+
+private:
+	virtual void transformed();
+	
+	aabb_type bounds;
+	material* material;
+	std::shared_ptr<const type::text_layout> layout;
+};
+
+inline const typename object_base::bounding_volume_type& text::get_bounds() const
+{
+	return bounds;
+}
+
+inline material* text::get_material() const
+{
+	return material;
+}
+
+inline const type::text_layout* text::get_layout() const
+{
+	return layout.get();
+}
+
+} // namespace scene
+
+#endif // ANTKEEPER_SCENE_TEXT_HPP
@@ -0,0 +1,139 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "scene/transform-store.hpp"
+#include "math/math.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+namespace scene {
+
+typename transform_store::transform_type transform_store::interpolate(const transform_type& x, const transform_type& y, float a)
+{
+	return
+		{
+			math::lerp(x.translation, y.translation, a),
+			math::nlerp(x.rotation, y.rotation, a),
+			math::lerp(x.scale, y.scale, a),
+		};
+}
+
+transform_store::transform_store():
+	slot_count(0),
+	tick(1)
+{
+	pages.fill(nullptr);
+}
+
+transform_store::~transform_store()
+{
+	for (page* p: pages)
+		delete p;
+}
+
+std::size_t transform_store::allocate(const transform_type& transform)
+{
+	std::size_t index;
+	{
+		std::lock_guard<std::mutex> lock(allocation_mutex);
+		
+		if (!free_slots.empty())
+		{
+			index = free_slots.back();
+			free_slots.pop_back();
+		}
+		else
+		{
+			if (slot_count == page_size * max_pages)
+				throw std::runtime_error("Transform store capacity exceeded");
+			
+			index = slot_count;
+			
+			// Allocate a new page when the last page is full
+			if (!(index % page_size))
+				pages[index / page_size] = new page();
+			
+			++slot_count;
+		}
+	}
+	
+	page& p = *pages[index / page_size];
+	const std::size_t i = index % page_size;
+	p.current[i] = transform;
+	p.previous[i] = transform;
+	p.interpolated[i] = transform;
+	p.current_origins[i] = {0.0, 0.0, 0.0};
+	p.previous_origins[i] = {0.0, 0.0, 0.0};
+	p.interpolated_origins[i] = {0.0, 0.0, 0.0};
+	p.ticks[i] = 0;
+	
+	return index;
+}
+
+void transform_store::release(std::size_t index)
+{
+	std::lock_guard<std::mutex> lock(allocation_mutex);
+	free_slots.push_back(index);
+}
+
+void transform_store::update()
+{
+	// Tick zero is reserved for snapped slots
+	if (!++tick)
+		tick = 1;
+}
+
+void transform_store::interpolate(float a)
+{
+	const double origin_a = static_cast<double>(a);
+	
+	const std::size_t page_count = (slot_count + page_size - 1) / page_size;
+	for (std::size_t i = 0; i < page_count; ++i)
+	{
+		page& p = *pages[i];
+		const std::size_t count = std::min(page_size, slot_count - i * page_size);
+		
+		for (std::size_t j = 0; j < count; ++j)
+		{
+			// Slots not written this tick are stationary
+			if (p.ticks[j] == tick)
+			{
+				p.interpolated[j] = interpolate(p.previous[j], p.current[j], a);
+				p.interpolated_origins[j] = p.previous_origins[j] + (p.current_origins[j] - p.previous_origins[j]) * origin_a;
+			}
+			else
+			{
+				p.interpolated[j] = p.current[j];
+				p.interpolated_origins[j] = p.current_origins[j];
+			}
+		}
+	}
+}
+
+typename transform_store::transform_type transform_store::interpolate(std::size_t index, float a) const
+{
+	const page& p = *pages[index / page_size];
+	const std::size_t i = index % page_size;
+	
+	if (p.ticks[i] == tick)
+		return interpolate(p.previous[i], p.current[i], a);
+	return p.current[i];
+}
+
+} // namespace scene
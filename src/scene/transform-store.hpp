@@ -0,0 +1,207 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ANTKEEPER_SCENE_TRANSFORM_STORE_HPP
+#define ANTKEEPER_SCENE_TRANSFORM_STORE_HPP
+
+#include "math/transform-type.hpp"
+#include "math/vector-type.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace scene {
+
+/**
+ * Double-buffered storage for the transforms of scene objects.
+ *
+ * Each slot holds a current and a previous transform in contiguous pages, along with a double-precision origin relative to which its transforms are expressed. Rather than copying the current transform into the previous transform of every object at the start of each tick, a slot records the tick in which it was last written, and its current transform is only copied into its previous transform the first time it is written in a new tick. Slots which were not written in the current tick are treated as stationary.
+ *
+ * Slots may be written concurrently from different threads, provided that each slot is only written by one thread at a time. Pages are never reallocated, so allocating a slot does not invalidate other slots.
+ */
+class transform_store
+{
+public:
+	typedef math::transform<float> transform_type;
+	typedef math::vector<double, 3> origin_type;
+	
+	/// Number of slots in each page.
+	static constexpr std::size_t page_size = 256;
+	
+	/// Maximum number of pages.
+	static constexpr std::size_t max_pages = 4096;
+	
+	/// Creates an empty transform store.
+	transform_store();
+	
+	/// Destroys a transform store.
+	~transform_store();
+	
+	transform_store(const transform_store&) = delete;
+	transform_store& operator=(const transform_store&) = delete;
+	
+	/**
+	 * Allocates a slot.
+	 *
+	 * @param transform Initial current and previous transform of the slot.
+	 * @return Index of the allocated slot.
+	 */
+	std::size_t allocate(const transform_type& transform);
+	
+	/**
+	 * Releases a slot, allowing it to be reused by subsequent allocations.
+	 *
+	 * @param index Index of the slot to release.
+	 */
+	void release(std::size_t index);
+	
+	/// Begins a new tick. Previous transforms of slots written in the new tick will be taken from their current transforms.
+	void update();
+	
+	/**
+	 * Discards the previous transform of a slot, so that it will no longer be interpolated until it is written in a subsequent tick.
+	 *
+	 * @param index Index of a slot.
+	 */
+	void snap(std::size_t index);
+	
+	/**
+	 * Interpolates the previous and current transforms and origins of all slots. The results can be retrieved with get_interpolated() and get_interpolated_origin().
+	 *
+	 * @param a Interpolation factor.
+	 */
+	void interpolate(float a);
+	
+	/**
+	 * Interpolates the previous and current transforms of a single slot.
+	 *
+	 * @param index Index of a slot.
+	 * @param a Interpolation factor.
+	 * @return Interpolated transform.
+	 */
+	transform_type interpolate(std::size_t index, float a) const;
+	
+	/**
+	 * Returns a reference to the current transform of a slot for writing.
+	 *
+	 * @param index Index of a slot.
+	 */
+	transform_type& modify(std::size_t index);
+	
+	/**
+	 * Returns a reference to the current origin of a slot for writing.
+	 *
+	 * @param index Index of a slot.
+	 */
+	origin_type& modify_origin(std::size_t index);
+	
+	/// Returns the current transform of a slot.
+	const transform_type& get(std::size_t index) const;
+	
+	/// Returns the transform of a slot as of the most recent call to interpolate().
+	const transform_type& get_interpolated(std::size_t index) const;
+	
+	/// Returns the current origin of a slot.
+	const origin_type& get_origin(std::size_t index) const;
+	
+	/// Returns the origin of a slot as of the most recent call to interpolate().
+	const origin_type& get_interpolated_origin(std::size_t index) const;
+	
+private:
+	struct page
+	{
+		std::array<transform_type, page_size> current;
+		std::array<transform_type, page_size> previous;
+		std::array<transform_type, page_size> interpolated;
+		std::array<origin_type, page_size> current_origins;
+		std::array<origin_type, page_size> previous_origins;
+		std::array<origin_type, page_size> interpolated_origins;
+		std::array<std::uint32_t, page_size> ticks;
+	};
+	
+	/// Preserves the transform and origin of the previous tick the first time a slot is written in the current tick.
+	void touch(page& p, std::size_t i);
+	
+	/// Interpolates between two transforms.
+	static transform_type interpolate(const transform_type& x, const transform_type& y, float a);
+	
+	std::array<page*, max_pages> pages;
+	std::size_t slot_count;
+	std::vector<std::size_t> free_slots;
+	std::mutex allocation_mutex;
+	std::uint32_t tick;
+};
+
+inline void transform_store::snap(std::size_t index)
+{
+	pages[index / page_size]->ticks[index % page_size] = 0;
+}
+
+inline void transform_store::touch(page& p, std::size_t i)
+{
+	if (p.ticks[i] != tick)
+	{
+		p.previous[i] = p.current[i];
+		p.previous_origins[i] = p.current_origins[i];
+		p.ticks[i] = tick;
+	}
+}
+
+inline typename transform_store::transform_type& transform_store::modify(std::size_t index)
+{
+	page& p = *pages[index / page_size];
+	const std::size_t i = index % page_size;
+	touch(p, i);
+	return p.current[i];
+}
+
+inline typename transform_store::origin_type& transform_store::modify_origin(std::size_t index)
+{
+	page& p = *pages[index / page_size];
+	const std::size_t i = index % page_size;
+	touch(p, i);
+	return p.current_origins[i];
+}
+
+inline const typename transform_store::transform_type& transform_store::get(std::size_t index) const
+{
+	return pages[index / page_size]->current[index % page_size];
+}
+
+inline const typename transform_store::transform_type& transform_store::get_interpolated(std::size_t index) const
+{
+	return pages[index / page_size]->interpolated[index % page_size];
+}
+
+inline const typename transform_store::origin_type& transform_store::get_origin(std::size_t index) const
+{
+	return pages[index / page_size]->current_origins[index % page_size];
+}
+
+inline const typename transform_store::origin_type& transform_store::get_interpolated_origin(std::size_t index) const
+{
+	return pages[index / page_size]->interpolated_origins[index % page_size];
+}
+
+} // namespace scene
+
+#endif // ANTKEEPER_SCENE_TRANSFORM_STORE_HPP
+
@@ -0,0 +1,372 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "genetics/sequence.hpp"
+#include "genetics/standard-code.hpp"
+#include "geom/intersection.hpp"
+#include "geom/marching-cubes.hpp"
+#include "geom/mesh-accelerator.hpp"
+#include "geom/mesh-functions.hpp"
+#include "geom/octree.hpp"
+#include "math/batch.hpp"
+#include "math/math.hpp"
+#include "physics/atmosphere.hpp"
+#include "physics/orbit/kepler.hpp"
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+/// Minimum measured duration of each benchmark, in seconds.
+double min_duration = 0.25;
+
+/// Substring which benchmark names must contain to be run.
+const char* filter = nullptr;
+
+/// Prevents the compiler from optimizing away the computation of a value.
+template <class T>
+inline void keep(const T& value)
+{
+	#if defined(__GNUC__)
+		asm volatile("" : : "g"(&value) : "memory");
+	#else
+		static volatile const void* sink;
+		sink = &value;
+	#endif
+}
+
+/**
+ * Measures a kernel and prints its time per operation and throughput.
+ *
+ * The kernel is called in batches of doubling size until a batch takes at least the minimum duration, so that timer resolution and loop overhead are negligible.
+ *
+ * @param name Name of the benchmark.
+ * @param ops Number of operations performed by each call of the kernel.
+ * @param kernel Function which performs the operations, given the index of the call.
+ */
+template <class Kernel>
+void run(const char* name, std::size_t ops, Kernel&& kernel)
+{
+	if (filter && !std::strstr(name, filter))
+		return;
+	
+	typedef std::chrono::high_resolution_clock clock;
+	
+	// Warm up caches and branch predictors
+	for (std::size_t i = 0; i < 16; ++i)
+		kernel(i);
+	
+	std::size_t calls = 1;
+	double duration = 0.0;
+	for (;;)
+	{
+		const auto start = clock::now();
+		for (std::size_t i = 0; i < calls; ++i)
+			kernel(i);
+		duration = std::chrono::duration<double>(clock::now() - start).count();
+		
+		if (duration >= min_duration)
+			break;
+		calls *= 2;
+	}
+	
+	const double total_ops = static_cast<double>(calls) * static_cast<double>(ops);
+	std::cout << std::left << std::setw(40) << name << std::right << std::fixed;
+	std::cout << std::setw(12) << std::setprecision(2) << duration * 1e9 / total_ops << " ns/op";
+	std::cout << std::setw(12) << std::setprecision(2) << total_ops / duration * 1e-6 << " Mop/s" << std::endl;
+}
+
+void bench_math(std::mt19937& rng)
+{
+	std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+	
+	// Generate well-conditioned matrices and unit quaternions
+	std::vector<math::matrix<float, 4, 4>> matrices(64);
+	for (auto& m: matrices)
+	{
+		for (std::size_t i = 0; i < 4; ++i)
+			for (std::size_t j = 0; j < 4; ++j)
+				m[i][j] = distribution(rng) * 0.25f + ((i == j) ? 1.0f : 0.0f);
+	}
+	std::vector<math::quaternion<float>> quaternions(64);
+	for (auto& q: quaternions)
+		q = math::normalize(math::quaternion<float>{distribution(rng), distribution(rng), distribution(rng), distribution(rng)});
+	
+	run("math::mul(mat4, mat4)", 1, [&](std::size_t i)
+	{
+		keep(math::mul(matrices[i % 64], matrices[(i + 1) % 64]));
+	});
+	
+	run("math::inverse(mat4)", 1, [&](std::size_t i)
+	{
+		keep(math::inverse(matrices[i % 64]));
+	});
+	
+	run("math::slerp(quat, quat)", 1, [&](std::size_t i)
+	{
+		keep(math::slerp(quaternions[i % 64], quaternions[(i + 1) % 64], static_cast<float>(i % 16) / 16.0f));
+	});
+	
+	// Batches of random transforms, both AoS and SoA
+	const std::size_t batch_size = 1024;
+	std::vector<math::transform<float>> transforms(batch_size * 2);
+	for (auto& t: transforms)
+	{
+		t.translation = {distribution(rng), distribution(rng), distribution(rng)};
+		t.rotation = math::normalize(math::quaternion<float>{distribution(rng), distribution(rng), distribution(rng), distribution(rng)});
+		t.scale = {distribution(rng) + 2.0f, distribution(rng) + 2.0f, distribution(rng) + 2.0f};
+	}
+	math::transform_soa_buffer<float> parents;
+	math::transform_soa_buffer<float> children;
+	parents.resize(batch_size);
+	children.resize(batch_size);
+	parents.load(transforms.data());
+	children.load(transforms.data() + batch_size);
+	math::transform_soa_buffer<float> results;
+	results.resize(batch_size);
+	std::vector<math::matrix<float, 4, 4>> batch_matrices(batch_size);
+	
+	run("math::mul(transform, transform)", batch_size, [&](std::size_t i)
+	{
+		for (std::size_t j = 0; j < batch_size; ++j)
+			keep(math::mul(transforms[j], transforms[batch_size + j]));
+	});
+	
+	run("math::transform_compose_n", batch_size, [&](std::size_t i)
+	{
+		math::transform_compose_n(parents.view(), children.view(), results.view(), batch_size);
+		keep(results);
+	});
+	
+	run("math::transform_lerp_n", batch_size, [&](std::size_t i)
+	{
+		math::transform_lerp_n(parents.view(), children.view(), 0.5f, results.view(), batch_size);
+		keep(results);
+	});
+	
+	run("math::matrix_cast(transform)", batch_size, [&](std::size_t i)
+	{
+		for (std::size_t j = 0; j < batch_size; ++j)
+			keep(math::matrix_cast(transforms[j]));
+	});
+	
+	run("math::matrix_cast_n", batch_size, [&](std::size_t i)
+	{
+		math::matrix_cast_n(parents.view(), batch_matrices.data(), batch_size);
+		keep(batch_matrices);
+	});
+}
+
+void bench_geom(std::mt19937& rng)
+{
+	std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+	
+	// Marching cubes over all 256 corner sign configurations
+	{
+		const float corners[8 * 3] =
+		{
+			0, 0, 0,  1, 0, 0,  1, 1, 0,  0, 1, 0,
+			0, 0, 1,  1, 0, 1,  1, 1, 1,  0, 1, 1
+		};
+		std::vector<std::array<float, 8>> distances(256);
+		for (std::size_t i = 0; i < 256; ++i)
+			for (std::size_t j = 0; j < 8; ++j)
+				distances[i][j] = ((i >> j) & 1) ? 0.25f + distribution(rng) * 0.2f : -0.25f + distribution(rng) * 0.2f;
+		
+		run("geom::mc::polygonize", 1, [&](std::size_t i)
+		{
+			float vertices[12 * 3];
+			std::uint_fast8_t vertex_count;
+			std::int_fast8_t triangles[5 * 3];
+			std::uint_fast8_t triangle_count;
+			geom::mc::polygonize(vertices, &vertex_count, triangles, &triangle_count, corners, distances[i % 256].data());
+			keep(vertices);
+			keep(triangle_count);
+		});
+	}
+	
+	// Rays cast down onto a bumpy grid, from random points above it
+	const std::size_t grid_size = 64;
+	std::vector<float3> vertices;
+	std::vector<std::array<std::uint_fast32_t, 3>> triangles;
+	for (std::size_t y = 0; y <= grid_size; ++y)
+		for (std::size_t x = 0; x <= grid_size; ++x)
+			vertices.push_back({static_cast<float>(x), distribution(rng) * 0.5f, static_cast<float>(y)});
+	for (std::size_t y = 0; y < grid_size; ++y)
+	{
+		for (std::size_t x = 0; x < grid_size; ++x)
+		{
+			const std::uint_fast32_t a = static_cast<std::uint_fast32_t>(y * (grid_size + 1) + x);
+			const std::uint_fast32_t b = a + 1;
+			const std::uint_fast32_t c = a + static_cast<std::uint_fast32_t>(grid_size + 1);
+			const std::uint_fast32_t d = c + 1;
+			triangles.push_back({a, c, b});
+			triangles.push_back({b, c, d});
+		}
+	}
+	std::vector<geom::ray<float>> rays(1024);
+	for (auto& ray: rays)
+	{
+		ray.origin = {(distribution(rng) * 0.5f + 0.5f) * grid_size, 10.0f, (distribution(rng) * 0.5f + 0.5f) * grid_size};
+		ray.direction = {0.0f, -1.0f, 0.0f};
+	}
+	
+	run("geom::ray_triangle_intersection", 1, [&](std::size_t i)
+	{
+		const auto& triangle = triangles[i % triangles.size()];
+		keep(geom::ray_triangle_intersection(rays[i % rays.size()], vertices[triangle[0]], vertices[triangle[1]], vertices[triangle[2]]));
+	});
+	
+	geom::mesh mesh;
+	geom::create_triangle_mesh(mesh, vertices, triangles);
+	geom::mesh_accelerator accelerator;
+	accelerator.build(mesh);
+	
+	run("geom::mesh_accelerator::query_nearest", 1, [&](std::size_t i)
+	{
+		keep(accelerator.query_nearest(rays[i % rays.size()]));
+	});
+	
+	// Octree of random leaves
+	std::uniform_int_distribution<std::uint32_t> location_distribution(0, (1u << (3 * geom::octree32::max_depth)) - 1);
+	std::vector<std::uint32_t> leaves(4096);
+	for (auto& leaf: leaves)
+		leaf = geom::octree32::node(geom::octree32::max_depth, location_distribution(rng));
+	
+	run("geom::octree32::insert", leaves.size(), [&](std::size_t i)
+	{
+		geom::octree32 octree;
+		for (std::uint32_t leaf: leaves)
+			octree.insert(leaf);
+		keep(octree.size());
+	});
+	
+	run("geom::linear_octree32::insert", leaves.size(), [&](std::size_t i)
+	{
+		geom::linear_octree32 octree;
+		octree.insert(leaves.begin(), leaves.end());
+		keep(octree.size());
+	});
+	
+	geom::octree32 octree;
+	for (std::uint32_t leaf: leaves)
+		octree.insert(leaf);
+	geom::linear_octree32 linear_octree;
+	linear_octree.insert(leaves.begin(), leaves.end());
+	
+	run("geom::octree32 iteration", octree.size(), [&](std::size_t i)
+	{
+		std::uint32_t sum = 0;
+		for (std::uint32_t node: octree)
+			sum += node;
+		keep(sum);
+	});
+	
+	run("geom::linear_octree32 iteration", linear_octree.size(), [&](std::size_t i)
+	{
+		std::uint32_t sum = 0;
+		for (std::uint32_t node: linear_octree)
+			sum += node;
+		keep(sum);
+	});
+}
+
+void bench_physics(std::mt19937& rng)
+{
+	std::uniform_real_distribution<double> distribution(0.0, math::two_pi<double>);
+	std::vector<double> mean_anomalies(256);
+	for (double& ma: mean_anomalies)
+		ma = distribution(rng);
+	
+	run("physics::orbit::kepler_ea", 1, [&](std::size_t i)
+	{
+		keep(physics::orbit::kepler_ea<double>(0.5, mean_anomalies[i % 256], 10, 1e-6));
+	});
+	
+	// Optical depth along rays from the ground to the top of an Earth-like atmosphere
+	const float radius = 6371000.0f;
+	const float height = 100000.0f;
+	std::vector<float3> ends(256);
+	for (auto& end: ends)
+	{
+		const float angle = static_cast<float>(distribution(rng)) * 0.25f;
+		end = float3{std::sin(angle), std::cos(angle), 0.0f} * (radius + height);
+	}
+	const float3 start = {0.0f, radius + 1.0f, 0.0f};
+	
+	run("physics::atmosphere::optical_depth (n=16)", 1, [&](std::size_t i)
+	{
+		keep(physics::atmosphere::optical_depth<float>(start, ends[i % 256], radius, 8000.0f, 16));
+	});
+	
+	run("physics::atmosphere::optical_depth<16> (gauss)", 1, [&](std::size_t i)
+	{
+		keep(physics::atmosphere::optical_depth<16>(start, ends[i % 256], radius, 8000.0f));
+	});
+}
+
+void bench_genetics(std::mt19937& rng)
+{
+	// Random open reading frame of 3000 bases
+	const char bases[] = "UCAG";
+	std::uniform_int_distribution<int> distribution(0, 3);
+	std::string rna(3000, 'A');
+	for (char& base: rna)
+		base = bases[distribution(rng)];
+	std::string protein(rna.size() / 3, '-');
+	
+	run("genetics::sequence::translate (per codon)", rna.size() / 3, [&](std::size_t i)
+	{
+		keep(genetics::sequence::translate(rna.begin(), rna.end(), protein.begin(), genetics::standard_code));
+		keep(protein);
+	});
+}
+
+} // namespace
+
+/**
+ * Micro-benchmarks of hot math, geometry, physics and genetics kernels, reporting the mean time per operation and throughput of each.
+ *
+ * Usage: `antkeeper-bench [filter] [min_duration]`, where only benchmarks whose names contain the filter substring are run, each for at least `min_duration` seconds (0.25 by default).
+ */
+int main(int argc, char* argv[])
+{
+	if (argc > 1)
+		filter = argv[1];
+	if (argc > 2)
+		min_duration = std::max(0.001, std::atof(argv[2]));
+	
+	// Seed the generator so that every run measures the same inputs
+	std::mt19937 rng(1);
+	
+	bench_math(rng);
+	bench_geom(rng);
+	bench_physics(rng);
+	bench_genetics(rng);
+	
+	return EXIT_SUCCESS;
+}
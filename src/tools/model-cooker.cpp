@@ -0,0 +1,101 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "resources/model-file.hpp"
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/**
+ * Cooks model files into the binary model format.
+ *
+ * Usage: `antkeeper-model-cooker [--no-tangents] [--barycentric] [--index] <input> <output>`, where the input is a CBOR or binary model file. Tangents are baked into models which have normals and texture coordinates but no tangents, unless `--no-tangents` is given. If `--barycentric` is given, barycentric coordinates are baked for shaders which draw triangle edges. If `--index` is given, identical vertices are then welded and drawn with an index buffer, with triangles and vertices reordered for the vertex cache. The model loader derives no attributes, so models are uploaded as cooked.
+ */
+int main(int argc, char* argv[])
+{
+	bool tangents = true;
+	bool barycentric = false;
+	bool index = false;
+	std::vector<std::string> paths;
+	for (int i = 1; i < argc; ++i)
+	{
+		const std::string argument = argv[i];
+		if (argument == "--no-tangents")
+			tangents = false;
+		else if (argument == "--barycentric")
+			barycentric = true;
+		else if (argument == "--index")
+			index = true;
+		else
+			paths.push_back(argument);
+	}
+	
+	if (paths.size() != 2)
+	{
+		std::cerr << "Usage: " << argv[0] << " [--no-tangents] [--barycentric] [--index] <input> <output>" << std::endl;
+		return EXIT_FAILURE;
+	}
+	
+	try
+	{
+		// Read input file
+		std::ifstream input(paths[0], std::ios::binary);
+		if (!input)
+			throw std::runtime_error("Failed to open \"" + paths[0] + "\"");
+		std::vector<std::uint8_t> buffer((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+		
+		// Read model with the same functions as the model loader
+		model_file file;
+		if (is_binary_model_file(buffer.data(), buffer.size()))
+			read_binary_model_file(buffer.data(), buffer.size(), file);
+		else
+			read_cbor_model_file(buffer.data(), buffer.size(), file);
+		
+		// Bake derived attributes before welding, as barycentric coordinates are distinct per corner
+		if (tangents)
+			bake_model_file_tangents(file);
+		if (barycentric)
+			bake_model_file_barycentric(file);
+		if (index)
+		{
+			index_model_file(file);
+			optimize_model_file(file);
+		}
+		
+		// Write output file
+		std::vector<std::uint8_t> output_buffer;
+		write_binary_model_file(file, output_buffer);
+		std::ofstream output(paths[1], std::ios::binary);
+		if (!output.write(reinterpret_cast<const char*>(output_buffer.data()), output_buffer.size()))
+			throw std::runtime_error("Failed to write \"" + paths[1] + "\"");
+		
+		std::cout << paths[0] << ": " << file.vertex_count << " vertices, " << file.index_count << " indices, " << file.groups.size() << " groups, " << output_buffer.size() << " bytes" << std::endl;
+	}
+	catch (const std::exception& e)
+	{
+		std::cerr << "Failed to cook model: \"" << e.what() << "\"" << std::endl;
+		return EXIT_FAILURE;
+	}
+	
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,68 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "resources/pack-file.hpp"
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/**
+ * Packs a directory into a pack file.
+ *
+ * Usage: `antkeeper-pack-builder <directory> <output>`. Each file in the directory is stored under its path relative to the directory, prefixed with a slash, such that the pack can replace the directory as a mount point of the resource manager.
+ */
+int main(int argc, char* argv[])
+{
+	if (argc != 3)
+	{
+		std::cerr << "Usage: " << argv[0] << " <directory> <output>" << std::endl;
+		return EXIT_FAILURE;
+	}
+	
+	try
+	{
+		const std::filesystem::path directory = argv[1];
+		
+		// Collect files in directory
+		std::vector<std::string> entry_paths;
+		std::vector<std::string> source_paths;
+		for (const auto& entry: std::filesystem::recursive_directory_iterator(directory))
+		{
+			if (!entry.is_regular_file())
+				continue;
+			
+			entry_paths.push_back("/" + std::filesystem::relative(entry.path(), directory).generic_string());
+			source_paths.push_back(entry.path().string());
+		}
+		
+		pack_file::write(argv[2], entry_paths, source_paths);
+		
+		std::cout << argv[2] << ": " << entry_paths.size() << " files" << std::endl;
+	}
+	catch (const std::exception& e)
+	{
+		std::cerr << "Failed to build pack: \"" << e.what() << "\"" << std::endl;
+		return EXIT_FAILURE;
+	}
+	
+	return EXIT_SUCCESS;
+}
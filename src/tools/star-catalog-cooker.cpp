@@ -0,0 +1,70 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "resources/star-catalog.hpp"
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/**
+ * Cooks star catalogs into the binary star catalog format, in which the positions and colors of stars are precomputed.
+ *
+ * Usage: `antkeeper-star-catalog-cooker <input> <output>`, where the input is a CSV star catalog.
+ */
+int main(int argc, char* argv[])
+{
+	if (argc != 3)
+	{
+		std::cerr << "Usage: " << argv[0] << " <input> <output>" << std::endl;
+		return EXIT_FAILURE;
+	}
+	
+	try
+	{
+		// Read input file
+		std::ifstream input(argv[1], std::ios::binary);
+		if (!input)
+			throw std::runtime_error(std::string("Failed to open \"") + argv[1] + "\"");
+		std::vector<std::uint8_t> buffer((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+		
+		// Convert star catalog with the same function as the star catalog loader
+		star_catalog catalog;
+		read_csv_star_catalog(buffer.data(), buffer.size(), catalog);
+		
+		// Write output file
+		std::vector<std::uint8_t> output_buffer;
+		write_binary_star_catalog(catalog, output_buffer);
+		std::ofstream output(argv[2], std::ios::binary);
+		if (!output.write(reinterpret_cast<const char*>(output_buffer.data()), output_buffer.size()))
+			throw std::runtime_error(std::string("Failed to write \"") + argv[2] + "\"");
+		
+		std::cout << argv[1] << ": " << catalog.size() << " stars, " << output_buffer.size() << " bytes" << std::endl;
+	}
+	catch (const std::exception& e)
+	{
+		std::cerr << "Failed to cook star catalog: \"" << e.what() << "\"" << std::endl;
+		return EXIT_FAILURE;
+	}
+	
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,133 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "type/font.hpp"
+#include "type/typeface.hpp"
+#include "gl/texture-2d.hpp"
+#include "gl/texture-wrapping.hpp"
+#include "gl/texture-filter.hpp"
+#include <algorithm>
+#include <limits>
+
+namespace type {
+
+font::font(const type::typeface& typeface, float size, int atlas_size):
+	typeface(typeface),
+	size(size),
+	scale(typeface.get_scale(size)),
+	atlas(static_cast<std::size_t>(atlas_size) * static_cast<std::size_t>(atlas_size), 0),
+	atlas_size(atlas_size),
+	shelf_x(0),
+	shelf_y(0),
+	shelf_height(0),
+	dirty_min_y(std::numeric_limits<int>::max()),
+	dirty_max_y(-1)
+{
+	float descent;
+	float line_gap;
+	typeface.get_vertical_metrics(scale, ascent, descent, line_gap);
+	line_height = ascent - descent + line_gap;
+	
+	// Sample the atlas without mipmaps, which would go stale as glyphs are added
+	texture = new gl::texture_2d(atlas_size, atlas_size, gl::pixel_type::uint_8, gl::pixel_format::r, gl::color_space::linear, atlas.data());
+	texture->set_wrapping(gl::texture_wrapping::extend, gl::texture_wrapping::extend);
+	texture->set_filters(gl::texture_min_filter::linear, gl::texture_mag_filter::linear);
+	texture->set_max_anisotropy(0.0f);
+}
+
+font::~font()
+{
+	delete texture;
+}
+
+const glyph& font::get_glyph(char32_t code)
+{
+	if (auto it = glyphs.find(code); it != glyphs.end())
+		return it->second;
+	
+	glyph& glyph = glyphs[code];
+	glyph.index = typeface.get_glyph_index(code);
+	glyph.advance = typeface.get_advance(glyph.index, scale);
+	glyph.offset = {0.0f, 0.0f};
+	glyph.size = {0.0f, 0.0f};
+	glyph.texcoords = {0.0f, 0.0f, 0.0f, 0.0f};
+	
+	int width;
+	int height;
+	int x_offset;
+	int y_offset;
+	typeface.rasterize_sdf(glyph.index, scale, sdf_padding, glyph_pixels, width, height, x_offset, y_offset);
+	if (glyph_pixels.empty())
+		return glyph;
+	
+	// Start a new shelf if the glyph doesn't fit on the current shelf, leaving a pixel between glyphs so they don't bleed into each other when filtered
+	if (shelf_x + width > atlas_size)
+	{
+		shelf_x = 0;
+		shelf_y += shelf_height + 1;
+		shelf_height = 0;
+	}
+	if (width > atlas_size || shelf_y + height > atlas_size)
+		return glyph;
+	
+	// Copy the distance field, flipping it so its bottom row is first
+	for (int y = 0; y < height; ++y)
+	{
+		const std::uint8_t* source = glyph_pixels.data() + static_cast<std::size_t>(height - 1 - y) * width;
+		std::copy(source, source + width, atlas.data() + static_cast<std::size_t>(shelf_y + y) * atlas_size + shelf_x);
+	}
+	dirty_min_y = std::min(dirty_min_y, shelf_y);
+	dirty_max_y = std::max(dirty_max_y, shelf_y + height - 1);
+	
+	const float atlas_scale = 1.0f / static_cast<float>(atlas_size);
+	glyph.offset = {static_cast<float>(x_offset), -static_cast<float>(y_offset + height)};
+	glyph.size = {static_cast<float>(width), static_cast<float>(height)};
+	glyph.texcoords =
+	{
+		static_cast<float>(shelf_x) * atlas_scale,
+		static_cast<float>(shelf_y) * atlas_scale,
+		static_cast<float>(shelf_x + width) * atlas_scale,
+		static_cast<float>(shelf_y + height) * atlas_scale
+	};
+	
+	shelf_x += width + 1;
+	shelf_height = std::max(shelf_height, height);
+	
+	return glyph;
+}
+
+float font::get_kerning(const glyph& first, const glyph& second) const
+{
+	return typeface.get_kerning(first.index, second.index, scale);
+}
+
+void font::upload()
+{
+	if (dirty_max_y < dirty_min_y)
+		return;
+	
+	// Upload whole rows, which are four-byte aligned as the atlas size is a multiple of four
+	texture->update(0, dirty_min_y, atlas_size, dirty_max_y - dirty_min_y + 1, atlas.data() + static_cast<std::size_t>(dirty_min_y) * atlas_size);
+	
+	dirty_min_y = std::numeric_limits<int>::max();
+	dirty_max_y = -1;
+}
+
+} // namespace type
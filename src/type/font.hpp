@@ -0,0 +1,158 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef ANTKEEPER_TYPE_FONT_HPP
+#define ANTKEEPER_TYPE_FONT_HPP
+
+#include "utility/fundamental-types.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace gl
+{
+	class texture_2d;
+}
+
+namespace type {
+
+class typeface;
+
+/// Glyph of a font, rasterized into the font's atlas.
+struct glyph
+{
+	/// Index of the glyph in its typeface.
+	int index;
+	
+	/// Offset from the pen position on the baseline to the bottom left corner of the glyph's quad, in pixels.
+	float2 offset;
+	
+	/// Width and height of the glyph's quad, in pixels, which is zero for glyphs without outlines.
+	float2 size;
+	
+	/// Texture coordinates of the bottom left and top right corners of the glyph's quad in the atlas.
+	float4 texcoords;
+	
+	/// Horizontal distance from the pen position of the glyph to that of the next glyph, in pixels.
+	float advance;
+};
+
+/**
+ * A typeface at a single size, whose glyphs are rasterized as signed distance fields into a single-channel atlas texture.
+ *
+ * Glyphs are rasterized the first time they're requested, and are never evicted, so each glyph of a font is rasterized only once. Because distance fields can be magnified without blurring, a font can be drawn at sizes well above its own, while smaller sizes are grown from the same atlas.
+ *
+ * The atlas stores distances as in typeface::rasterize_sdf(), with the outline at `0.5` and sdf_padding pixels of distance on either side, for shaders to threshold.
+ */
+class font
+{
+public:
+	/**
+	 * Creates a font. Must be called by the thread which owns the OpenGL context.
+	 *
+	 * @param typeface Typeface of the font, which must outlive the font.
+	 * @param size Distance from the ascender to the descender, in pixels.
+	 * @param atlas_size Width and height of the atlas texture, in pixels, which must be a multiple of four.
+	 */
+	font(const type::typeface& typeface, float size, int atlas_size = 1024);
+	
+	~font();
+	
+	font(const font&) = delete;
+	font& operator=(const font&) = delete;
+	
+	/**
+	 * Returns the glyph of a code point, rasterizing it into the atlas if necessary. Glyphs which don't fit in the atlas have no size.
+	 *
+	 * @param code Unicode code point.
+	 */
+	const glyph& get_glyph(char32_t code);
+	
+	/// Returns the kerning adjustment of the advance between two glyphs, in pixels.
+	float get_kerning(const glyph& first, const glyph& second) const;
+	
+	/**
+	 * Uploads the glyphs rasterized since the previous upload to the atlas texture. Must be called by the thread which owns the OpenGL context, before text is drawn.
+	 */
+	void upload();
+	
+	/// Returns the atlas texture.
+	const gl::texture_2d* get_texture() const;
+	
+	/// Returns the size of the font, in pixels.
+	float get_size() const;
+	
+	/// Returns the distance from the baseline to the ascender, in pixels.
+	float get_ascent() const;
+	
+	/// Returns the distance from one baseline to the next, in pixels.
+	float get_line_height() const;
+	
+	/// Number of pixels by which distance fields extend beyond glyph outlines.
+	static constexpr int sdf_padding = 4;
+	
+private:
+	const type::typeface& typeface;
+	float size;
+	float scale;
+	float ascent;
+	float line_height;
+	
+	std::unordered_map<char32_t, glyph> glyphs;
+	
+	/// Atlas pixels, bottom row first, which are packed in shelves from the bottom left.
+	std::vector<std::uint8_t> atlas;
+	int atlas_size;
+	int shelf_x;
+	int shelf_y;
+	int shelf_height;
+	
+	/// First and last rows of the atlas modified since the previous upload.
+	int dirty_min_y;
+	int dirty_max_y;
+	
+	std::vector<std::uint8_t> glyph_pixels;
+	gl::texture_2d* texture;
+};
+
+inline const gl::texture_2d* font::get_texture() const
+{
+	return texture;
+}
+
+inline float font::get_size() const
+{
+	return size;
+}
+
+inline float font::get_ascent() const
+{
+	return ascent;
+}
+
+inline float font::get_line_height() const
+{
+	return line_height;
+}
+
+} // namespace type
+
+#endif // ANTKEEPER_TYPE_FONT_HPP
@@ -0,0 +1,43 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "type/text-cache.hpp"
+
+namespace type {
+
+std::shared_ptr<const text_layout> text_cache::get(font& font, std::string_view key, std::string_view language, std::string_view text)
+{
+	auto id = std::make_tuple(static_cast<const type::font*>(&font), std::string(key), std::string(language));
+	if (auto it = layouts.find(id); it != layouts.end())
+		return it->second;
+	
+	std::shared_ptr<text_layout> layout = std::make_shared<text_layout>();
+	layout_text(font, text, *layout);
+	layouts.emplace(std::move(id), layout);
+	
+	return layout;
+}
+
+void text_cache::clear()
+{
+	layouts.clear();
+}
+
+} // namespace type
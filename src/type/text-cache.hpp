@@ -0,0 +1,71 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef ANTKEEPER_TYPE_TEXT_CACHE_HPP
+#define ANTKEEPER_TYPE_TEXT_CACHE_HPP
+
+#include "type/text-layout.hpp"
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <tuple>
+
+namespace type {
+
+class font;
+
+/**
+ * Caches the layouts of static strings, keyed by font, string key, and language, so labels are laid out once rather than every time they're shown.
+ *
+ * Layouts remain valid for the lifetime of their fonts, as glyphs are never evicted from font atlases.
+ */
+class text_cache
+{
+public:
+	/**
+	 * Returns the layout of a string, laying it out if it isn't cached.
+	 *
+	 * @param font Font of the string.
+	 * @param key Key of the string in the string table.
+	 * @param language Language code of the string.
+	 * @param text UTF-8 text of the string, which is laid out only if the string isn't cached.
+	 * @return Shared layout of the string.
+	 */
+	std::shared_ptr<const text_layout> get(font& font, std::string_view key, std::string_view language, std::string_view text);
+	
+	/// Removes all layouts from the cache. Layouts which are still referenced remain valid.
+	void clear();
+	
+	/// Returns the number of cached layouts.
+	std::size_t size() const;
+
+private:
+	std::map<std::tuple<const font*, std::string, std::string>, std::shared_ptr<const text_layout>> layouts;
+};
+
+inline std::size_t text_cache::size() const
+{
+	return layouts.size();
+}
+
+} // namespace type
+
+#endif // ANTKEEPER_TYPE_TEXT_CACHE_HPP
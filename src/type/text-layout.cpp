@@ -0,0 +1,133 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "type/text-layout.hpp"
+#include "type/font.hpp"
+#include <algorithm>
+#include <limits>
+
+namespace type {
+
+/**
+ * Decodes the next code point of UTF-8 text.
+ *
+ * @param text UTF-8 text.
+ * @param[in,out] i Index of the first byte of the code point, which is advanced past it.
+ * @return Decoded code point, or U+FFFD if the sequence is invalid.
+ */
+static char32_t decode_utf8(std::string_view text, std::size_t& i)
+{
+	static constexpr char32_t replacement = 0xFFFD;
+	
+	const unsigned char lead = static_cast<unsigned char>(text[i++]);
+	if (lead < 0x80)
+		return lead;
+	
+	std::size_t continuation_count;
+	char32_t code;
+	if ((lead & 0xE0) == 0xC0)
+	{
+		continuation_count = 1;
+		code = lead & 0x1F;
+	}
+	else if ((lead & 0xF0) == 0xE0)
+	{
+		continuation_count = 2;
+		code = lead & 0x0F;
+	}
+	else if ((lead & 0xF8) == 0xF0)
+	{
+		continuation_count = 3;
+		code = lead & 0x07;
+	}
+	else
+	{
+		return replacement;
+	}
+	
+	for (std::size_t j = 0; j < continuation_count; ++j, ++i)
+	{
+		if (i >= text.size() || (static_cast<unsigned char>(text[i]) & 0xC0) != 0x80)
+			return replacement;
+		code = (code << 6) | (static_cast<unsigned char>(text[i]) & 0x3F);
+	}
+	
+	return code;
+}
+
+void layout_text(font& font, std::string_view text, text_layout& layout)
+{
+	layout.vertices.clear();
+	layout.bounds =
+	{
+		{std::numeric_limits<float>::infinity(), std::numeric_limits<float>::infinity(), 0.0f},
+		{-std::numeric_limits<float>::infinity(), -std::numeric_limits<float>::infinity(), 0.0f}
+	};
+	
+	float2 pen = {0.0f, 0.0f};
+	const glyph* previous = nullptr;
+	for (std::size_t i = 0; i < text.size();)
+	{
+		const char32_t code = decode_utf8(text, i);
+		if (code == U'\n')
+		{
+			pen = {0.0f, pen.y - font.get_line_height()};
+			previous = nullptr;
+			continue;
+		}
+		
+		const glyph& glyph = font.get_glyph(code);
+		if (previous)
+			pen.x += font.get_kerning(*previous, glyph);
+		previous = &glyph;
+		
+		if (glyph.size.x > 0.0f)
+		{
+			const float x0 = pen.x + glyph.offset.x;
+			const float y0 = pen.y + glyph.offset.y;
+			const float x1 = x0 + glyph.size.x;
+			const float y1 = y0 + glyph.size.y;
+			const float4& uv = glyph.texcoords;
+			
+			const float quad[] =
+			{
+				x0, y1, 0.0f, uv[0], uv[3], 1.0f, 0.0f, 0.0f,
+				x0, y0, 0.0f, uv[0], uv[1], 0.0f, 1.0f, 0.0f,
+				x1, y1, 0.0f, uv[2], uv[3], 0.0f, 0.0f, 1.0f,
+				x1, y1, 0.0f, uv[2], uv[3], 1.0f, 0.0f, 0.0f,
+				x0, y0, 0.0f, uv[0], uv[1], 0.0f, 1.0f, 0.0f,
+				x1, y0, 0.0f, uv[2], uv[1], 0.0f, 0.0f, 1.0f
+			};
+			layout.vertices.insert(layout.vertices.end(), std::begin(quad), std::end(quad));
+			
+			layout.bounds.min_point.x = std::min(layout.bounds.min_point.x, x0);
+			layout.bounds.min_point.y = std::min(layout.bounds.min_point.y, y0);
+			layout.bounds.max_point.x = std::max(layout.bounds.max_point.x, x1);
+			layout.bounds.max_point.y = std::max(layout.bounds.max_point.y, y1);
+		}
+		
+		pen.x += glyph.advance;
+	}
+	
+	if (layout.vertices.empty())
+		layout.bounds = {{0.0f, 0.0f, 0.0f}, {0.0f, 0.0f, 0.0f}};
+}
+
+} // namespace type
@@ -0,0 +1,61 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef ANTKEEPER_TYPE_TEXT_LAYOUT_HPP
+#define ANTKEEPER_TYPE_TEXT_LAYOUT_HPP
+
+#include "geom/aabb.hpp"
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+namespace type {
+
+class font;
+
+/**
+ * Glyph quads of a laid out run of text, in the vertex format of billboards: position, texture coordinates, and barycentric coordinates.
+ *
+ * Positions are in pixels, with the baseline of the first line along the x-axis and lines advancing down the y-axis.
+ */
+struct text_layout
+{
+	/// Number of floats per vertex.
+	static constexpr std::size_t vertex_size = 8;
+	
+	/// Six vertices per glyph which has an outline.
+	std::vector<float> vertices;
+	
+	/// Bounds of the glyph quads.
+	geom::aabb<float> bounds;
+};
+
+/**
+ * Lays out UTF-8 text, rasterizing any glyphs it needs which are not yet in the font's atlas. Lines are separated by `\n`. Invalid UTF-8 sequences are replaced with U+FFFD.
+ *
+ * @param font Font of the text.
+ * @param text UTF-8 text.
+ * @param[out] layout Laid out glyph quads.
+ */
+void layout_text(font& font, std::string_view text, text_layout& layout);
+
+} // namespace type
+
+#endif // ANTKEEPER_TYPE_TEXT_LAYOUT_HPP
@@ -0,0 +1,105 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "type/typeface.hpp"
+#include <cstdlib>
+#include <stdexcept>
+
+// Compile the TrueType rasterizer into this translation unit only
+#define STB_TRUETYPE_IMPLEMENTATION
+#define STBTT_STATIC
+#include "stb/stb_truetype.h"
+
+namespace type {
+
+typeface::typeface(const std::uint8_t* data, std::size_t size):
+	data(data, data + size),
+	info(new stbtt_fontinfo())
+{
+	const int offset = stbtt_GetFontOffsetForIndex(this->data.data(), 0);
+	if (offset < 0 || !stbtt_InitFont(info, this->data.data(), offset))
+	{
+		delete info;
+		throw std::runtime_error("Font data is not a valid TrueType or OpenType font.");
+	}
+}
+
+typeface::~typeface()
+{
+	delete info;
+}
+
+float typeface::get_scale(float size) const
+{
+	return stbtt_ScaleForPixelHeight(info, size);
+}
+
+void typeface::get_vertical_metrics(float scale, float& ascent, float& descent, float& line_gap) const
+{
+	int font_ascent;
+	int font_descent;
+	int font_line_gap;
+	stbtt_GetFontVMetrics(info, &font_ascent, &font_descent, &font_line_gap);
+	
+	ascent = static_cast<float>(font_ascent) * scale;
+	descent = static_cast<float>(font_descent) * scale;
+	line_gap = static_cast<float>(font_line_gap) * scale;
+}
+
+int typeface::get_glyph_index(char32_t code) const
+{
+	return stbtt_FindGlyphIndex(info, static_cast<int>(code));
+}
+
+float typeface::get_advance(int glyph, float scale) const
+{
+	int advance;
+	int bearing;
+	stbtt_GetGlyphHMetrics(info, glyph, &advance, &bearing);
+	
+	return static_cast<float>(advance) * scale;
+}
+
+float typeface::get_kerning(int first, int second, float scale) const
+{
+	return static_cast<float>(stbtt_GetGlyphKernAdvance(info, first, second)) * scale;
+}
+
+void typeface::rasterize_sdf(int glyph, float scale, int padding, std::vector<std::uint8_t>& pixels, int& width, int& height, int& x_offset, int& y_offset) const
+{
+	width = 0;
+	height = 0;
+	x_offset = 0;
+	y_offset = 0;
+	pixels.clear();
+	
+	unsigned char* sdf = stbtt_GetGlyphSDF(info, scale, glyph, padding, 128, 128.0f / static_cast<float>(padding), &width, &height, &x_offset, &y_offset);
+	if (!sdf)
+	{
+		width = 0;
+		height = 0;
+		return;
+	}
+	
+	pixels.assign(sdf, sdf + static_cast<std::size_t>(width) * static_cast<std::size_t>(height));
+	stbtt_FreeSDF(sdf, nullptr);
+}
+
+} // namespace type
@@ -0,0 +1,132 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef ANTKEEPER_TYPE_TYPEFACE_HPP
+#define ANTKEEPER_TYPE_TYPEFACE_HPP
+
+#include "resources/resource-loader.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct stbtt_fontinfo;
+
+/// Text rendering.
+namespace type {
+
+/**
+ * A TrueType or OpenType typeface, from which glyphs of any size are rasterized.
+ */
+class typeface
+{
+public:
+	/**
+	 * Creates a typeface from font file data.
+	 *
+	 * @param data Contents of a TrueType or OpenType font file, which are copied.
+	 * @param size Size of the font file, in bytes.
+	 *
+	 * @exception std::runtime_error The data is not a valid font.
+	 */
+	typeface(const std::uint8_t* data, std::size_t size);
+	
+	~typeface();
+	
+	typeface(const typeface&) = delete;
+	typeface& operator=(const typeface&) = delete;
+	
+	/**
+	 * Returns the scale from font units to pixels at which the distance from the ascender to the descender spans a number of pixels.
+	 *
+	 * @param size Font size, in pixels.
+	 */
+	float get_scale(float size) const;
+	
+	/**
+	 * Gets the vertical metrics of the typeface, in pixels.
+	 *
+	 * @param scale Scale from font units to pixels.
+	 * @param[out] ascent Distance from the baseline to the ascender.
+	 * @param[out] descent Distance from the baseline to the descender, which is negative below the baseline.
+	 * @param[out] line_gap Spacing between the descender of one line and the ascender of the next.
+	 */
+	void get_vertical_metrics(float scale, float& ascent, float& descent, float& line_gap) const;
+	
+	/// Returns the index of the glyph of a code point, or `0` if the typeface lacks it.
+	int get_glyph_index(char32_t code) const;
+	
+	/// Returns the horizontal advance of a glyph, in pixels.
+	float get_advance(int glyph, float scale) const;
+	
+	/// Returns the kerning adjustment of the advance between two glyphs, in pixels.
+	float get_kerning(int first, int second, float scale) const;
+	
+	/**
+	 * Rasterizes the signed distance field of a glyph.
+	 *
+	 * Distances are encoded such that the outline maps to 128, increasing inwards by `128 / padding` per pixel and clamped at the padding.
+	 *
+	 * @param glyph Glyph index.
+	 * @param scale Scale from font units to pixels.
+	 * @param padding Number of pixels by which the field extends beyond the outline.
+	 * @param[out] pixels Distance field, top row first, which is empty if the glyph has no outline.
+	 * @param[out] width Width of the distance field, in pixels.
+	 * @param[out] height Height of the distance field, in pixels.
+	 * @param[out] x_offset Offset from the pen position to the left edge of the field, in pixels.
+	 * @param[out] y_offset Offset from the baseline down to the top row of the field, in pixels.
+	 */
+	void rasterize_sdf(int glyph, float scale, int padding, std::vector<std::uint8_t>& pixels, int& width, int& height, int& x_offset, int& y_offset) const;
+	
+	/// Returns the size of the font file data, in bytes.
+	std::size_t get_data_size() const;
+
+private:
+	std::vector<std::uint8_t> data;
+	stbtt_fontinfo* info;
+};
+
+inline std::size_t typeface::get_data_size() const
+{
+	return data.size();
+}
+
+} // namespace type
+
+template <>
+struct resource_loader_traits<type::typeface>
+{
+	static constexpr bool concurrent = true;
+};
+
+template <>
+struct resource_footprint<type::typeface>
+{
+	static std::size_t cpu_size(const type::typeface& resource)
+	{
+		return sizeof(type::typeface) + resource.get_data_size();
+	}
+	
+	static std::size_t gpu_size(const type::typeface& resource)
+	{
+		return 0;
+	}
+};
+
+#endif // ANTKEEPER_TYPE_TYPEFACE_HPP
@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ANTKEEPER_FNV1A_HPP
+#define ANTKEEPER_FNV1A_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+/// 32-bit FNV-1a offset basis.
+constexpr std::uint32_t fnv1a32_offset_basis = 0x811c9dc5;
+
+/// 64-bit FNV-1a offset basis.
+constexpr std::uint64_t fnv1a64_offset_basis = 0xcbf29ce484222325;
+
+/**
+ * Hashes a sequence of bytes using the 32-bit FNV-1a hash function.
+ *
+ * @param data Bytes to hash.
+ * @param size Number of bytes.
+ * @param hash Hash with which to continue, in order to hash multiple sequences as one.
+ * @return 32-bit hash.
+ */
+constexpr std::uint32_t fnv1a32(const char* data, std::size_t size, std::uint32_t hash = fnv1a32_offset_basis) noexcept
+{
+	for (std::size_t i = 0; i < size; ++i)
+	{
+		hash ^= static_cast<std::uint8_t>(data[i]);
+		hash *= 0x01000193;
+	}
+	return hash;
+}
+
+/// @copydoc fnv1a32(const char*, std::size_t, std::uint32_t)
+constexpr std::uint32_t fnv1a32(std::string_view string, std::uint32_t hash = fnv1a32_offset_basis) noexcept
+{
+	return fnv1a32(string.data(), string.size(), hash);
+}
+
+/**
+ * Hashes a sequence of bytes using the 64-bit FNV-1a hash function.
+ *
+ * @param data Bytes to hash.
+ * @param size Number of bytes.
+ * @param hash Hash with which to continue, in order to hash multiple sequences as one.
+ * @return 64-bit hash.
+ */
+constexpr std::uint64_t fnv1a64(const char* data, std::size_t size, std::uint64_t hash = fnv1a64_offset_basis) noexcept
+{
+	for (std::size_t i = 0; i < size; ++i)
+	{
+		hash ^= static_cast<std::uint8_t>(data[i]);
+		hash *= 0x100000001b3;
+	}
+	return hash;
+}
+
+/// @copydoc fnv1a64(const char*, std::size_t, std::uint64_t)
+constexpr std::uint64_t fnv1a64(std::string_view string, std::uint64_t hash = fnv1a64_offset_basis) noexcept
+{
+	return fnv1a64(string.data(), string.size(), hash);
+}
+
+/**
+ * Hashes a string literal using the 64-bit FNV-1a hash function, which compilers evaluate at compile time.
+ *
+ * @return 64-bit hash.
+ */
+constexpr std::uint64_t operator""_fnv1a64(const char* data, std::size_t size) noexcept
+{
+	return fnv1a64(data, size);
+}
+
+#endif // ANTKEEPER_FNV1A_HPP
@@ -0,0 +1,205 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "utility/job-system.hpp"
+
+namespace
+{
+	/// Job system of which the calling thread is a worker.
+	thread_local const job_system* worker_system = nullptr;
+	
+	/// Index of the calling worker thread in its job system.
+	thread_local std::size_t worker_index = 0;
+}
+
+job_system::job_system(std::size_t thread_count):
+	pending_count(0),
+	stopping(false)
+{
+	for (std::size_t i = 0; i <= thread_count; ++i)
+		queues.emplace_back(new queue());
+	
+	for (std::size_t i = 0; i < thread_count; ++i)
+		threads.emplace_back(&job_system::work, this, i);
+}
+
+job_system::job_system():
+	job_system(std::max<std::size_t>(std::thread::hardware_concurrency(), 1) - 1)
+{}
+
+job_system::~job_system()
+{
+	{
+		std::lock_guard<std::mutex> lock(sleep_mutex);
+		stopping = true;
+	}
+	sleep_condition.notify_all();
+	
+	for (std::thread& thread: threads)
+		thread.join();
+	
+	// Execute jobs left over without workers
+	job job;
+	while (pop(job))
+		execute(job);
+}
+
+void job_system::submit(const job_type& function, counter* counter)
+{
+	if (counter)
+		counter->count.fetch_add(1, std::memory_order_relaxed);
+	
+	// Count the job before it becomes visible, so the pending count never underflows
+	pending_count.fetch_add(1, std::memory_order_release);
+	
+	queue& queue = *queues[get_queue_index()];
+	{
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		queue.jobs.push_back({function, counter});
+	}
+	
+	// Lock before notifying, so a worker between checking for work and sleeping cannot miss the notification
+	{
+		std::lock_guard<std::mutex> lock(sleep_mutex);
+	}
+	sleep_condition.notify_one();
+}
+
+void job_system::wait(counter& counter)
+{
+	job job;
+	while (!counter.is_done())
+	{
+		if (pop(job))
+		{
+			execute(job);
+			continue;
+		}
+		
+		// Sleep until more work is submitted or the counter completes
+		std::unique_lock<std::mutex> lock(sleep_mutex);
+		sleep_condition.wait(lock, [&]{return counter.is_done() || pending_count.load(std::memory_order_acquire);});
+	}
+	
+	if (counter.exception)
+	{
+		std::exception_ptr exception = counter.exception;
+		counter.exception = nullptr;
+		std::rethrow_exception(exception);
+	}
+}
+
+std::size_t job_system::get_queue_index() const
+{
+	return (worker_system == this) ? worker_index : threads.size();
+}
+
+bool job_system::pop(job& job)
+{
+	if (!pending_count.load(std::memory_order_acquire))
+		return false;
+	
+	const std::size_t own_index = get_queue_index();
+	
+	// Pop the most recently submitted job from the calling thread's own queue
+	{
+		queue& own = *queues[own_index];
+		std::lock_guard<std::mutex> lock(own.mutex);
+		if (!own.jobs.empty())
+		{
+			job = std::move(own.jobs.back());
+			own.jobs.pop_back();
+			pending_count.fetch_sub(1, std::memory_order_relaxed);
+			return true;
+		}
+	}
+	
+	// Steal the oldest job from another queue, starting with the shared queue
+	const std::size_t queue_count = queues.size();
+	for (std::size_t i = 1; i < queue_count; ++i)
+	{
+		queue& victim = *queues[(own_index + i) % queue_count];
+		std::lock_guard<std::mutex> lock(victim.mutex);
+		if (!victim.jobs.empty())
+		{
+			job = std::move(victim.jobs.front());
+			victim.jobs.pop_front();
+			pending_count.fetch_sub(1, std::memory_order_relaxed);
+			return true;
+		}
+	}
+	
+	return false;
+}
+
+void job_system::execute(job& job)
+{
+	counter* counter = job.completion;
+	
+	if (!counter)
+	{
+		job.function();
+		job.function = nullptr;
+		return;
+	}
+	
+	try
+	{
+		job.function();
+	}
+	catch (...)
+	{
+		std::lock_guard<std::mutex> lock(sleep_mutex);
+		if (!counter->exception)
+			counter->exception = std::current_exception();
+	}
+	job.function = nullptr;
+	
+	// Wake waiting threads once the last job of the counter completes
+	if (counter->count.fetch_sub(1, std::memory_order_acq_rel) == 1)
+	{
+		{
+			std::lock_guard<std::mutex> lock(sleep_mutex);
+		}
+		sleep_condition.notify_all();
+	}
+}
+
+void job_system::work(std::size_t index)
+{
+	worker_system = this;
+	worker_index = index;
+	
+	job job;
+	for (;;)
+	{
+		if (pop(job))
+		{
+			execute(job);
+			continue;
+		}
+		
+		std::unique_lock<std::mutex> lock(sleep_mutex);
+		sleep_condition.wait(lock, [&]{return stopping || pending_count.load(std::memory_order_acquire);});
+		
+		if (stopping && !pending_count.load(std::memory_order_acquire))
+			break;
+	}
+}
@@ -0,0 +1,209 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef ANTKEEPER_JOB_SYSTEM_HPP
+#define ANTKEEPER_JOB_SYSTEM_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Pool of worker threads which execute jobs, shared by all engine subsystems.
+ *
+ * Each worker owns a deque of jobs. Jobs submitted by a worker are pushed to and popped from the back of its own deque, while idle workers steal from the front of the deques of other workers. Jobs submitted by other threads are placed in a shared queue. Threads waiting on a counter execute pending jobs rather than blocking.
+ */
+class job_system
+{
+public:
+	/// Job function type.
+	typedef std::function<void()> job_type;
+	
+	/**
+	 * Tracks the completion of a group of jobs.
+	 *
+	 * A counter must outlive the jobs submitted with it.
+	 */
+	class counter
+	{
+	public:
+		/// Creates a counter with no incomplete jobs.
+		counter();
+		
+		counter(const counter&) = delete;
+		counter& operator=(const counter&) = delete;
+		
+		/// Returns `true` if all jobs submitted with this counter have completed.
+		bool is_done() const;
+		
+	private:
+		friend class job_system;
+		
+		std::atomic<std::size_t> count;
+		std::exception_ptr exception;
+	};
+	
+	/**
+	 * Creates a job system.
+	 *
+	 * @param thread_count Number of worker threads. Waiting threads also execute jobs, so `0` executes all jobs on the threads which wait for them.
+	 */
+	explicit job_system(std::size_t thread_count);
+	
+	/// Creates a job system with one worker thread per hardware thread, less the calling thread.
+	job_system();
+	
+	/// Executes all pending jobs, then stops and joins the worker threads.
+	~job_system();
+	
+	job_system(const job_system&) = delete;
+	job_system& operator=(const job_system&) = delete;
+	
+	/**
+	 * Submits a job for execution.
+	 *
+	 * @param job Job function.
+	 * @param counter Counter which tracks the completion of the job, or `nullptr`. If the job throws an exception, it will be rethrown by job_system::wait(). Jobs without a counter must not throw.
+	 */
+	void submit(const job_type& job, counter* counter = nullptr);
+	
+	/**
+	 * Executes pending jobs until all jobs submitted with a counter have completed. Jobs may submit further jobs with the same counter.
+	 *
+	 * @param counter Counter to wait on.
+	 *
+	 * @exception Rethrows the first exception thrown by a job submitted with @p counter.
+	 */
+	void wait(counter& counter);
+	
+	/**
+	 * Calls a function over subranges of a range, in parallel, and waits for all calls to return.
+	 *
+	 * @param begin First index of the range.
+	 * @param end Index past the last index of the range.
+	 * @param grain Maximum number of indices in a subrange.
+	 * @param function Function which processes the indices `[first, last)`, with the signature `void(std::size_t first, std::size_t last)`.
+	 */
+	template <class Function>
+	void parallel_for(std::size_t begin, std::size_t end, std::size_t grain, const Function& function);
+	
+	/// Returns the number of worker threads.
+	std::size_t get_thread_count() const;
+
+private:
+	struct job
+	{
+		job_type function;
+		job_system::counter* completion;
+	};
+	
+	struct queue
+	{
+		std::mutex mutex;
+		std::deque<job> jobs;
+	};
+	
+	/// Returns the index of the queue owned by the calling thread, or the index of the shared queue.
+	std::size_t get_queue_index() const;
+	
+	/// Pops a job from the calling thread's own queue, or steals one from another queue.
+	bool pop(job& job);
+	
+	/// Executes a popped job and signals its counter.
+	void execute(job& job);
+	
+	/// Worker thread loop.
+	void work(std::size_t index);
+	
+	// Worker queues, followed by the shared queue
+	std::vector<std::unique_ptr<queue>> queues;
+	std::vector<std::thread> threads;
+	std::atomic<std::size_t> pending_count;
+	std::mutex sleep_mutex;
+	std::condition_variable sleep_condition;
+	bool stopping;
+};
+
+inline job_system::counter::counter():
+	count(0)
+{}
+
+inline bool job_system::counter::is_done() const
+{
+	return !count.load(std::memory_order_acquire);
+}
+
+template <class Function>
+void job_system::parallel_for(std::size_t begin, std::size_t end, std::size_t grain, const Function& function)
+{
+	if (begin >= end)
+		return;
+	
+	grain = std::max<std::size_t>(grain, 1);
+	
+	// Execute small ranges, or all ranges without workers, on the calling thread
+	if (end - begin <= grain || threads.empty())
+	{
+		function(begin, end);
+		return;
+	}
+	
+	counter counter;
+	
+	// Submit all but the first subrange, which is processed by the calling thread
+	for (std::size_t first = begin + grain; first < end; first += grain)
+	{
+		const std::size_t last = std::min(first + grain, end);
+		submit([&function, first, last]{function(first, last);}, &counter);
+	}
+	
+	try
+	{
+		function(begin, begin + grain);
+	}
+	catch (...)
+	{
+		// Subranges reference the function and counter, so they must complete before unwinding
+		try
+		{
+			wait(counter);
+		}
+		catch (...) {}
+		throw;
+	}
+	
+	wait(counter);
+}
+
+inline std::size_t job_system::get_thread_count() const
+{
+	return threads.size();
+}
+
+#endif // ANTKEEPER_JOB_SYSTEM_HPP
+
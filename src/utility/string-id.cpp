@@ -0,0 +1,76 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "utility/string-id.hpp"
+#include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+
+namespace {
+
+/// Text of interned strings, keyed by their IDs. Map nodes are never moved, so views of their text stay valid.
+std::unordered_map<string_id, std::string>& get_string_table()
+{
+	static std::unordered_map<string_id, std::string> table;
+	return table;
+}
+
+std::shared_mutex& get_string_table_mutex()
+{
+	static std::shared_mutex mutex;
+	return mutex;
+}
+
+} // namespace
+
+string_id intern_string(std::string_view string)
+{
+	const string_id id = make_string_id(string);
+	std::unordered_map<string_id, std::string>& table = get_string_table();
+	
+	// Most strings are interned repeatedly, so look up the string before locking the table for writing
+	{
+		std::shared_lock<std::shared_mutex> lock(get_string_table_mutex());
+		if (auto it = table.find(id); it != table.end())
+		{
+			if (it->second != string)
+				throw std::runtime_error("String \"" + std::string(string) + "\" has the same ID as string \"" + it->second + "\"");
+			return id;
+		}
+	}
+	
+	std::unique_lock<std::shared_mutex> lock(get_string_table_mutex());
+	auto [it, inserted] = table.try_emplace(id, string);
+	if (!inserted && it->second != string)
+		throw std::runtime_error("String \"" + std::string(string) + "\" has the same ID as string \"" + it->second + "\"");
+	
+	return id;
+}
+
+std::string_view get_interned_string(string_id id)
+{
+	std::shared_lock<std::shared_mutex> lock(get_string_table_mutex());
+	const std::unordered_map<string_id, std::string>& table = get_string_table();
+	if (auto it = table.find(id); it != table.end())
+		return it->second;
+	return {};
+}
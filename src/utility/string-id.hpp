@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2021  Christopher J. Howard
+ *
+ * This file is part of Antkeeper source code.
+ *
+ * Antkeeper source code is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Antkeeper source code is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Antkeeper source code.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef ANTKEEPER_STRING_ID_HPP
+#define ANTKEEPER_STRING_ID_HPP
+
+#include "utility/fnv1a.hpp"
+#include <cstdint>
+#include <string_view>
+
+/**
+ * Compact identifier of a string, which is the 32-bit FNV-1a hash of the string.
+ *
+ * As ids are hashes, the id of a string literal is computed at compile time with the `_sid` literal, and is equal to the id returned when the same string is interned at run time. Lookups keyed by string ids therefore neither construct nor hash strings. Interning a string records its text, so that ids can be turned back into text, and detects strings whose ids collide.
+ */
+typedef std::uint32_t string_id;
+
+/**
+ * Returns the id of a string, without interning it.
+ *
+ * @param string String.
+ * @return ID of the string.
+ */
+constexpr string_id make_string_id(std::string_view string) noexcept
+{
+	return fnv1a32(string);
+}
+
+/**
+ * Returns the id of a string literal, which compilers evaluate at compile time.
+ *
+ * @return ID of the string.
+ */
+constexpr string_id operator""_sid(const char* data, std::size_t size) noexcept
+{
+	return fnv1a32(data, size);
+}
+
+/**
+ * Interns a string into the global string table. Safe to call from any thread.
+ *
+ * @param string String to intern.
+ * @return ID of the string.
+ *
+ * @exception std::runtime_error A different string with the same ID has already been interned.
+ */
+string_id intern_string(std::string_view string);
+
+/**
+ * Returns the text of an interned string. Safe to call from any thread.
+ *
+ * @param id ID of an interned string.
+ * @return Text of the string, which remains valid for the lifetime of the program, or an empty view if no string with the ID has been interned.
+ */
+std::string_view get_interned_string(string_id id);
+
+#endif // ANTKEEPER_STRING_ID_HPP
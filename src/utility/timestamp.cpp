@@ -24,12 +24,16 @@
 #include <sstream>
 
 std::string timestamp()
+{
+	return timestamp(std::chrono::system_clock::now());
+}
+
+std::string timestamp(std::chrono::system_clock::time_point time)
 {
 	const char* time_format = "%y%m%d-%H%M%S-";
 	
-	auto now = std::chrono::system_clock::now();
-	std::time_t tt = std::chrono::system_clock::to_time_t(now);
-	std::size_t ms = (std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()) % 1000).count();
+	std::time_t tt = std::chrono::system_clock::to_time_t(time);
+	std::size_t ms = (std::chrono::duration_cast<std::chrono::milliseconds>(time.time_since_epoch()) % 1000).count();
 
 	#if defined(_WIN32)
 		struct std::tm timeinfo;
@@ -20,6 +20,7 @@
 #ifndef ANTKEEPER_TIMESTAMP_HPP
 #define ANTKEEPER_TIMESTAMP_HPP
 
+#include <chrono>
 #include <string>
 
 /**
@@ -27,4 +28,11 @@
  */
 std::string timestamp();
 
+/**
+ * Returns a string containing a point in time, formatted as "YYYYMMDD-HHMMSS-mmm".
+ *
+ * @param time Point in time to format.
+ */
+std::string timestamp(std::chrono::system_clock::time_point time);
+
 #endif // ANTKEEPER_TIMESTAMP_HPP